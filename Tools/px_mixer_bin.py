@@ -0,0 +1,161 @@
+#!/usr/bin/env python
+############################################################################
+#
+#   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in
+#    the documentation and/or other materials provided with the
+#    distribution.
+# 3. Neither the name PX4 nor the names of its contributors may be
+#    used to endorse or promote products derived from this software
+#    without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+# COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+# BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+# OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+# AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+# ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+############################################################################
+
+
+"""
+px_mixer_bin.py:
+Write a binary description next to every text mixer file, for loading
+without parsing. The records are described in src/drivers/drv_mixer.h.
+"""
+
+from __future__ import print_function
+import argparse
+import os
+import struct
+import sys
+
+MIXER_BIN_MAGIC = b"PXM1"
+
+MIXER_BIN_NULL = 0x01
+MIXER_BIN_SIMPLE = 0x02
+MIXER_BIN_MULTIROTOR = 0x03
+
+# in the order of MultirotorMixer::Geometry
+GEOMETRIES = ["4x", "4+", "4v", "4w", "6x", "6+", "6c", "8x", "8+", "8c"]
+
+# MultirotorMixer::MAX_DESATURATION
+MAX_DESATURATION = 3
+
+
+class MixerError(Exception):
+        pass
+
+
+def int16(value):
+        v = int(value)
+        if v < -32768 or v > 32767:
+                raise MixerError("value %d out of range" % v)
+        return v
+
+
+def values(line, tag, count, optional=0):
+        """the numbers of a definition line, as the text parser reads them"""
+        fields = line.split()
+        if fields[0] != tag + ":" or not (count <= len(fields) - 1 <= count + optional):
+                raise MixerError("expected %s: with %d values, got '%s'" % (tag, count, line))
+        return fields[1:]
+
+
+def scaler(fields):
+        return struct.pack("<5h", *[int16(v) for v in fields])
+
+
+def convert(lines):
+        """binary records for the mixer definition lines"""
+        records = b""
+        i = 0
+
+        while i < len(lines):
+                line = lines[i]
+                i += 1
+
+                if line.startswith("Z:"):
+                        records += struct.pack("<B", MIXER_BIN_NULL)
+
+                elif line.startswith("M:"):
+                        count = int(values(line, "M", 1)[0])
+                        if count > 255:
+                                raise MixerError("simple mixer with %d controls" % count)
+                        records += struct.pack("<BB", MIXER_BIN_SIMPLE, count)
+                        records += scaler(values(lines[i], "O", 5))
+                        i += 1
+                        for n in range(count):
+                                s = values(lines[i], "S", 7)
+                                records += struct.pack("<BB", int(s[0]), int(s[1])) + scaler(s[2:])
+                                i += 1
+
+                elif line.startswith("R:"):
+                        r = values(line, "R", 5, 1)
+                        if r[0] not in GEOMETRIES:
+                                raise MixerError("unknown geometry '%s'" % r[0])
+                        desaturation = int(r[5]) if len(r) > 5 else 0
+                        if desaturation >= MAX_DESATURATION:
+                                raise MixerError("unknown desaturation %d" % desaturation)
+                        records += struct.pack("<BBB4h", MIXER_BIN_MULTIROTOR, GEOMETRIES.index(r[0]),
+                                               desaturation, *[int16(v) for v in r[1:5]])
+
+                else:
+                        raise MixerError("unexpected line '%s'" % line)
+
+        return records
+
+
+def main():
+
+        # Parse commandline arguments
+        parser = argparse.ArgumentParser(description="Binary mixer generator.")
+        parser.add_argument('--folder', action="store", help="ROMFS scratch folder.")
+        args = parser.parse_args()
+
+        print("Generating binary mixers.")
+
+        for (root, dirs, files) in os.walk(args.folder):
+                for file in files:
+                        if not file.endswith(".mix"):
+                                continue
+
+                        file_path = os.path.join(root, file)
+
+                        # the lines load_mixer_file() would pass on
+                        lines = []
+                        with open(file_path, "r") as f:
+                                for line in f:
+                                        if len(line) >= 2 and line[0].isupper() and line[1] == ':':
+                                                lines.append(line.strip())
+
+                        try:
+                                records = convert(lines)
+                        except IndexError:
+                                print("%s: incomplete mixer" % file_path, file=sys.stderr)
+                                sys.exit(1)
+                        except (MixerError, ValueError, struct.error) as e:
+                                print("%s: %s" % (file_path, e), file=sys.stderr)
+                                sys.exit(1)
+
+                        with open(file_path + ".bin", "wb") as f:
+                                f.write(MIXER_BIN_MAGIC + records)
+
+
+if __name__ == '__main__':
+        main()
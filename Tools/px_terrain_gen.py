@@ -0,0 +1,154 @@
+#!/usr/bin/env python
+############################################################################
+#
+#   Copyright (C) 2015 PX4 Development Team. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in
+#    the documentation and/or other materials provided with the
+#    distribution.
+# 3. Neither the name PX4 nor the names of its contributors may be
+#    used to endorse or promote products derived from this software
+#    without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+# COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+# BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+# OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+# AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+# ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+############################################################################
+
+
+
+"""
+px_terrain_gen.py:
+Convert SRTM .hgt files into the tiled terrain file the navigator reads
+from the SD card. The format is described in src/lib/terrain/terrain.h.
+"""
+
+from __future__ import print_function
+import argparse
+import array
+import math
+import os
+import re
+import struct
+import sys
+
+TERRAIN_MAGIC = b"PXT1"
+TILE_CELLS = 16
+TILE_SAMPLES = TILE_CELLS + 1
+NO_DATA = -32768
+
+
+class TerrainError(Exception):
+        pass
+
+
+def hgt_corner(path):
+        """south west corner of a file named like N47E008.hgt"""
+        m = re.match(r"([NS])(\d{2})([EW])(\d{3})\.hgt$", os.path.basename(path), re.IGNORECASE)
+        if not m:
+                raise TerrainError("%s: not an SRTM file name" % path)
+        lat = int(m.group(2)) * (1 if m.group(1).upper() == "N" else -1)
+        lon = int(m.group(4)) * (1 if m.group(3).upper() == "E" else -1)
+        return lat, lon
+
+
+def load_hgt(path):
+        """samples of a file, north row first, and the samples per row"""
+        data = array.array("h")
+        with open(path, "rb") as f:
+                data.frombytes(f.read()) if hasattr(data, "frombytes") else data.fromstring(f.read())
+        if sys.byteorder == "little":
+                data.byteswap()
+        size = int(math.sqrt(len(data)))
+        if size * size != len(data) or size < 2:
+                raise TerrainError("%s: not a square grid" % path)
+        return data, size
+
+
+def main():
+
+        # Parse commandline arguments
+        parser = argparse.ArgumentParser(description="Terrain file generator.")
+        parser.add_argument('--output', action="store", default="terrain.dat", help="terrain file to write.")
+        parser.add_argument('hgt', nargs="+", help="SRTM .hgt files, all of the same resolution.")
+        args = parser.parse_args()
+
+        try:
+                files = {}
+                size = None
+                for path in args.hgt:
+                        data, n = load_hgt(path)
+                        if size is not None and n != size:
+                                raise TerrainError("%s: %u samples per row, expected %u" % (path, n, size))
+                        size = n
+                        files[hgt_corner(path)] = data
+        except (TerrainError, IOError) as e:
+                print(e, file=sys.stderr)
+                sys.exit(1)
+
+        # whole degrees covered, with the files sharing their edge samples
+        cells = size - 1
+        lat0 = min(lat for (lat, lon) in files)
+        lon0 = min(lon for (lat, lon) in files)
+        degrees_lat = max(lat for (lat, lon) in files) - lat0 + 1
+        degrees_lon = max(lon for (lat, lon) in files) - lon0 + 1
+        tiles_lat = (degrees_lat * cells + TILE_CELLS - 1) // TILE_CELLS
+        tiles_lon = (degrees_lon * cells + TILE_CELLS - 1) // TILE_CELLS
+        spacing = int(round(1e7 / cells))
+
+        # the rounded spacing drifts over the area, a fraction of a sample is fine
+        drift = abs(spacing * cells - 1e7) * max(degrees_lat, degrees_lon) / spacing
+        if drift > 0.5:
+                print("warning: samples drift by %.1f over the area" % drift, file=sys.stderr)
+
+        def sample(n, e):
+                """height n samples north and e samples east of the south west corner"""
+                lat, i = lat0 + n // cells, n % cells
+                lon, j = lon0 + e // cells, e % cells
+                data = files.get((lat, lon))
+                if data is None:
+                        # the top and right edges live in the files further south and west
+                        if i == 0 and (lat - 1, lon) in files:
+                                return files[(lat - 1, lon)][j]
+                        if j == 0 and (lat, lon - 1) in files:
+                                return files[(lat, lon - 1)][(cells - i) * size + cells]
+                        return NO_DATA
+                return data[(cells - i) * size + j]
+
+        print("Generating terrain file, %ux%u tiles." % (tiles_lat, tiles_lon))
+
+        with open(args.output, "wb") as f:
+                f.write(TERRAIN_MAGIC)
+                f.write(struct.pack("<iiIHHHH", lat0 * 10000000, lon0 * 10000000, spacing,
+                                    tiles_lat, tiles_lon, TILE_SAMPLES, 0))
+
+                for tn in range(tiles_lat):
+                        for te in range(tiles_lon):
+                                tile = array.array("h")
+                                for i in range(TILE_SAMPLES):
+                                        for j in range(TILE_SAMPLES):
+                                                tile.append(sample(tn * TILE_CELLS + i, te * TILE_CELLS + j))
+                                if sys.byteorder != "little":
+                                        tile.byteswap()
+                                f.write(tile.tobytes() if hasattr(tile, "tobytes") else tile.tostring())
+
+
+if __name__ == '__main__':
+        main()
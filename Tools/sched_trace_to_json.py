@@ -0,0 +1,134 @@
+#!/usr/bin/env python
+############################################################################
+#
+#   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in
+#    the documentation and/or other materials provided with the
+#    distribution.
+# 3. Neither the name PX4 nor the names of its contributors may be
+#    used to endorse or promote products derived from this software
+#    without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+# COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+# BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+# OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+# AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+# ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+############################################################################
+
+"""Convert a scheduler trace dumped by 'schedtrace dump' to the JSON
+trace event format, for viewing in chrome://tracing or Perfetto.
+
+Each task gets a row showing when it ran, interrupts traced with
+sched_trace_irq() get a row of their own.
+
+Usage: python sched_trace_to_json.py sched.trc [out.json]
+"""
+
+import json
+import struct
+import sys
+
+SWITCH, IRQ_ENTER, IRQ_EXIT, TASK_START, TASK_STOP = range(5)
+
+HEADER = struct.Struct('<4sHHII')
+TASK = struct.Struct('<h24s')
+EVENT = struct.Struct('<QhhB')
+
+# row used for interrupts, pids are never negative
+IRQ_TID = -1
+
+
+def read_trace(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    magic, version, task_count, event_count, event_size = HEADER.unpack_from(data, 0)
+
+    if magic != b'PXST' or version != 1:
+        sys.exit('%s: not a scheduler trace' % path)
+
+    offset = HEADER.size
+    names = {}
+
+    for i in range(task_count):
+        pid, name = TASK.unpack_from(data, offset)
+        names[pid] = name.split(b'\0')[0].decode('ascii', 'replace')
+        offset += TASK.size
+
+    events = []
+
+    for i in range(event_count):
+        events.append(EVENT.unpack_from(data, offset))
+        offset += event_size
+
+    return names, events
+
+
+def convert(names, events):
+    out = []
+    running = None
+    running_since = None
+    irq_since = {}
+
+    for timestamp, a, b, kind in events:
+        if kind == SWITCH:
+            if running_since is not None and running == a:
+                out.append({'name': names.get(a, 'pid %d' % a), 'ph': 'X', 'pid': 0, 'tid': a,
+                            'ts': running_since, 'dur': timestamp - running_since})
+            running = b
+            running_since = timestamp
+
+        elif kind == IRQ_ENTER:
+            irq_since[a] = timestamp
+
+        elif kind == IRQ_EXIT and a in irq_since:
+            since = irq_since.pop(a)
+            out.append({'name': 'irq %d' % a, 'ph': 'X', 'pid': 0, 'tid': IRQ_TID,
+                        'ts': since, 'dur': timestamp - since})
+
+        elif kind in (TASK_START, TASK_STOP):
+            out.append({'name': 'start' if kind == TASK_START else 'stop', 'ph': 'i', 's': 't',
+                        'pid': 0, 'tid': a, 'ts': timestamp})
+
+    for pid, name in names.items():
+        out.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': pid, 'args': {'name': name}})
+
+    out.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': IRQ_TID, 'args': {'name': 'interrupts'}})
+
+    return {'traceEvents': out, 'displayTimeUnit': 'ms'}
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+
+    names, events = read_trace(sys.argv[1])
+    trace = convert(names, events)
+
+    out_path = sys.argv[2] if len(sys.argv) > 2 else sys.argv[1] + '.json'
+
+    with open(out_path, 'w') as f:
+        json.dump(trace, f)
+
+    print('%d events, %d tasks -> %s' % (len(events), len(names), out_path))
+
+
+if __name__ == '__main__':
+    main()
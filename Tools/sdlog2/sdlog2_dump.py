@@ -4,7 +4,7 @@ from __future__ import print_function
 
 """Dump binary log generated by PX4's sdlog2 or APM as CSV
     
-Usage: python sdlog2_dump.py <log.bin> [-v] [-e] [-d delimiter] [-n null] [-m MSG[.field1,field2,...]]
+Usage: python sdlog2_dump.py <log.bin> [-v] [-e] [-d delimiter] [-n null] [-m MSG[.field1,field2,...]] [-w start:end]
     
     -v  Use plain debug output instead of CSV.
     
@@ -16,10 +16,15 @@ Usage: python sdlog2_dump.py <log.bin> [-v] [-e] [-d delimiter] [-n null] [-m MS
     
     -m MSG[.field1,field2,...]
         Dump only messages of specified type, and only specified fields.
-        Multiple -m options allowed."""
+        Multiple -m options allowed.
+
+    -w start:end
+        Dump only the time window between start and end, in seconds of
+        TIME message time. Uses the index of cleanly closed logs to skip
+        to the start, otherwise scans the log from the beginning."""
 
 __author__  = "Anton Babushkin"
-__version__ = "1.2"
+__version__ = "1.5"
 
 import struct, sys
 
@@ -40,6 +45,15 @@ class SDLog2Parser:
     MSG_FORMAT_PACKET_LEN = 89
     MSG_FORMAT_STRUCT = "BB4s16s64s"
     MSG_TYPE_FORMAT = 0x80
+    MSG_TYPE_BLOCK = 0xF0
+    MSG_BLOCK_HEADER_LEN = 7
+    MSG_TYPE_IDX = 133
+    MSG_IDX_LEN = 15
+    MSG_TYPE_IDXT = 135
+    MSG_IDXT_LEN = 15
+    MSG_TYPE_TOPIC_FORMAT = 0xF1
+    MSG_TOPIC_FORMAT_PACKET_LEN = 182
+    MSG_TOPIC_FORMAT_STRUCT = "<BH16s32s128s"
     FORMAT_TO_STRUCT = {
         "b": ("b", None),
         "B": ("B", None),
@@ -59,6 +73,7 @@ class SDLog2Parser:
         "M": ("b", None),
         "q": ("q", None),
         "Q": ("Q", None),
+        "x": ("x", None),
     }
     __csv_delim = ","
     __csv_null = ""
@@ -68,6 +83,7 @@ class SDLog2Parser:
     __correct_errors = False
     __file_name = None
     __file = None
+    __time_window = None
     
     def __init__(self):
         return
@@ -82,6 +98,8 @@ class SDLog2Parser:
         self.__csv_data = {}        # current values for all columns
         self.__csv_updated = False
         self.__msg_filter_map = {}  # filter in form of map, with '*" expanded to full list of fields
+        self.__window_time = None   # time of the last TIME message, when dumping a time window
+        self.__window_done = False
     
     def setCSVDelimiter(self, csv_delim):
         self.__csv_delim = csv_delim
@@ -98,6 +116,9 @@ class SDLog2Parser:
     def setDebugOut(self, debug_out):
         self.__debug_out = debug_out
 
+    def setTimeWindow(self, start, end):
+        self.__time_window = (start, end)
+
     def setCorrectErrors(self, correct_errors):
         self.__correct_errors = correct_errors
 
@@ -118,7 +139,15 @@ class SDLog2Parser:
         first_data_msg = True
         f = open(fn, "rb")
         bytes_read = 0
-        while True:
+        seek_offset = None
+        if self.__time_window != None:
+            index = self.__readIndex(f)
+            if index != None:
+                # start at the last sync marker before the window
+                for t, offset in index:
+                    if t <= self.__time_window[0]:
+                        seek_offset = offset
+        while not self.__window_done:
             chunk = f.read(self.BLOCK_SIZE)
             if len(chunk) == 0:
                 break
@@ -139,6 +168,19 @@ class SDLog2Parser:
                     if self.__bytesLeft() < self.MSG_FORMAT_PACKET_LEN:
                         break
                     self.__parseMsgDescr()
+                elif msg_type == self.MSG_TYPE_TOPIC_FORMAT:
+                    # parse raw topic layout
+                    if self.__bytesLeft() < self.MSG_TOPIC_FORMAT_PACKET_LEN:
+                        break
+                    self.__parseTopicDescr()
+                elif msg_type == self.MSG_TYPE_BLOCK:
+                    # expand compressed block in place, then parse its messages
+                    if self.__bytesLeft() < self.MSG_BLOCK_HEADER_LEN:
+                        break
+                    raw_len, data_len = struct.unpack("<HH", bytes(self.__buffer[self.__ptr + 3 : self.__ptr + self.MSG_BLOCK_HEADER_LEN]))
+                    if self.__bytesLeft() < self.MSG_BLOCK_HEADER_LEN + data_len:
+                        break
+                    self.__expandBlock(raw_len, data_len)
                 else:
                     # parse data message
                     msg_descr = self.__msg_descrs[msg_type]
@@ -147,17 +189,116 @@ class SDLog2Parser:
                     msg_length = msg_descr[0]
                     if self.__bytesLeft() < msg_length:
                         break
+                    if seek_offset != None:
+                        # formats are known now, skip to the time window
+                        if seek_offset > bytes_read + self.__ptr:
+                            f.seek(seek_offset)
+                            bytes_read = seek_offset
+                            self.__buffer = bytearray()
+                            self.__ptr = 0
+                            seek_offset = None
+                            break
+                        seek_offset = None
                     if first_data_msg:
                         # build CSV columns and init data map
                         if not self.__debug_out:
                             self.__initCSV()
                         first_data_msg = False
                     self.__parseMsg(msg_descr)
+                    if self.__window_done:
+                        break
             bytes_read += self.__ptr
             if not self.__debug_out and self.__time_msg != None and self.__csv_updated:
                 self.__printCSVRow()
         f.close()
     
+    def __readIndex(self, f):
+        """Read the index of a cleanly closed log, returns [(time, offset)] or None"""
+        f.seek(0, 2)
+        size = f.tell()
+        if size < self.MSG_IDXT_LEN:
+            return None
+        f.seek(size - self.MSG_IDXT_LEN)
+        tail = bytearray(f.read(self.MSG_IDXT_LEN))
+        f.seek(0)
+        if tail[0] != self.MSG_HEAD1 or tail[1] != self.MSG_HEAD2 or tail[2] != self.MSG_TYPE_IDXT or bytes(tail[3:7]) != b"IDXT":
+            return None
+        start, entries, types = struct.unpack("<IHH", bytes(tail[7:15]))
+        f.seek(start)
+        data = bytearray(f.read(entries * self.MSG_IDX_LEN))
+        f.seek(0)
+        if len(data) < entries * self.MSG_IDX_LEN:
+            return None
+        index = []
+        for i in range(entries):
+            p = i * self.MSG_IDX_LEN
+            if data[p + 2] != self.MSG_TYPE_IDX:
+                return None
+            index.append(struct.unpack("<QI", bytes(data[p + 3 : p + self.MSG_IDX_LEN])))
+        return index
+
+    def __expandBlock(self, raw_len, data_len):
+        start = self.__ptr + self.MSG_BLOCK_HEADER_LEN
+        data = self.__buffer[start : start + data_len]
+        if data_len == raw_len:
+            raw = bytearray(data)
+        else:
+            raw = self.__lzDecompress(data, raw_len)
+        self.__deltaDecode(raw)
+        self.__buffer = self.__buffer[:self.__ptr] + raw + self.__buffer[start + data_len:]
+
+    def __lzDecompress(self, data, raw_len):
+        out = bytearray()
+        ip = 0
+        while len(out) < raw_len:
+            token = data[ip]
+            ip += 1
+            lit_len = token >> 4
+            if lit_len == 15:
+                while True:
+                    b = data[ip]
+                    ip += 1
+                    lit_len += b
+                    if b != 255:
+                        break
+            out += data[ip : ip + lit_len]
+            ip += lit_len
+            if len(out) >= raw_len:
+                break
+            offset = data[ip] | (data[ip + 1] << 8)
+            ip += 2
+            match_len = (token & 0x0F) + 4
+            if (token & 0x0F) == 15:
+                while True:
+                    b = data[ip]
+                    ip += 1
+                    match_len += b
+                    if b != 255:
+                        break
+            pos = len(out) - offset
+            for i in range(match_len):
+                out.append(out[pos + i])
+        return out
+
+    def __deltaDecode(self, raw):
+        # bodies are XORed with the previous body of the same type within the block
+        prev = {}
+        pos = 0
+        while pos + self.MSG_HEADER_LEN <= len(raw):
+            msg_type = raw[pos + 2]
+            if raw[pos] != self.MSG_HEAD1 or raw[pos + 1] != self.MSG_HEAD2 or msg_type not in self.__msg_descrs:
+                break
+            msg_length = self.__msg_descrs[msg_type][0]
+            if pos + msg_length > len(raw):
+                break
+            body_start = pos + self.MSG_HEADER_LEN
+            p = prev.get(msg_type)
+            if p != None:
+                for i in range(msg_length - self.MSG_HEADER_LEN):
+                    raw[body_start + i] ^= p[i]
+            prev[msg_type] = raw[body_start : pos + msg_length]
+            pos += msg_length
+
     def __bytesLeft(self):
         return len(self.__buffer) - self.__ptr
     
@@ -210,28 +351,68 @@ class SDLog2Parser:
             msg_name = _parseCString(data[2])
             msg_format = _parseCString(data[3])
             msg_labels = _parseCString(data[4]).split(",")
-            # Convert msg_format to struct.unpack format string
-            msg_struct = ""
-            msg_mults = []
-            for c in msg_format:
-                try:
-                    f = self.FORMAT_TO_STRUCT[c]
-                    msg_struct += f[0]
-                    msg_mults.append(f[1])
-                except KeyError as e:
-                    raise Exception("Unsupported format char: %s in message %s (%i)" % (c, msg_name, msg_type))
-            msg_struct = "<" + msg_struct   # force little-endian
-            self.__msg_descrs[msg_type] = (msg_length, msg_name, msg_format, msg_labels, msg_struct, msg_mults)
-            self.__msg_labels[msg_name] = msg_labels
-            self.__msg_names.append(msg_name)
-            if self.__debug_out:
-                if self.__filterMsg(msg_name) != None:
-                    print("MSG FORMAT: type = %i, length = %i, name = %s, format = %s, labels = %s, struct = %s, mults = %s" % (
-                                msg_type, msg_length, msg_name, msg_format, str(msg_labels), msg_struct, msg_mults))
+            self.__addMsgDescr(msg_type, msg_length, msg_name, msg_format, msg_labels)
         self.__ptr += self.MSG_FORMAT_PACKET_LEN
+
+    def __parseTopicDescr(self):
+        data = struct.unpack(self.MSG_TOPIC_FORMAT_STRUCT, bytes(self.__buffer[self.__ptr + 3 : self.__ptr + self.MSG_TOPIC_FORMAT_PACKET_LEN]))
+        msg_type = data[0]
+        msg_length = data[1] + self.MSG_HEADER_LEN
+        msg_name = _parseCString(data[2])
+        labels = _parseCString(data[4]).split(",")
+        # expand repeat counts, a repeated field gets numbered labels
+        msg_format = ""
+        msg_labels = []
+        count = ""
+        for c in _parseCString(data[3]):
+            if c.isdigit():
+                count += c
+                continue
+            n = int(count) if count != "" else 1
+            msg_format += c * n
+            if c != "x":
+                if len(labels) == 0:
+                    raise Exception("Missing labels in message %s (%i)" % (msg_name, msg_type))
+                label = labels.pop(0)
+                if count != "":
+                    msg_labels += [label + str(i) for i in range(n)]
+                else:
+                    msg_labels.append(label)
+            count = ""
+        self.__addMsgDescr(msg_type, msg_length, msg_name, msg_format, msg_labels)
+        self.__ptr += self.MSG_TOPIC_FORMAT_PACKET_LEN
+
+    def __addMsgDescr(self, msg_type, msg_length, msg_name, msg_format, msg_labels):
+        # Convert msg_format to struct.unpack format string
+        msg_struct = ""
+        msg_mults = []
+        for c in msg_format:
+            try:
+                f = self.FORMAT_TO_STRUCT[c]
+                msg_struct += f[0]
+                if c != "x":
+                    msg_mults.append(f[1])
+            except KeyError as e:
+                raise Exception("Unsupported format char: %s in message %s (%i)" % (c, msg_name, msg_type))
+        msg_struct = "<" + msg_struct   # force little-endian
+        self.__msg_descrs[msg_type] = (msg_length, msg_name, msg_format, msg_labels, msg_struct, msg_mults)
+        self.__msg_labels[msg_name] = msg_labels
+        self.__msg_names.append(msg_name)
+        if self.__debug_out:
+            if self.__filterMsg(msg_name) != None:
+                print("MSG FORMAT: type = %i, length = %i, name = %s, format = %s, labels = %s, struct = %s, mults = %s" % (
+                            msg_type, msg_length, msg_name, msg_format, str(msg_labels), msg_struct, msg_mults))
     
     def __parseMsg(self, msg_descr):
         msg_length, msg_name, msg_format, msg_labels, msg_struct, msg_mults = msg_descr
+        if self.__time_window != None:
+            if msg_name == "TIME":
+                self.__window_time = struct.unpack("<Q", bytes(self.__buffer[self.__ptr+self.MSG_HEADER_LEN:self.__ptr+msg_length]))[0]
+            if self.__window_time != None and self.__window_time > self.__time_window[1]:
+                self.__window_done = True
+            if self.__window_time == None or self.__window_time < self.__time_window[0] or self.__window_done:
+                self.__ptr += msg_length
+                return
         if not self.__debug_out and self.__time_msg != None and msg_name == self.__time_msg and self.__csv_updated:
             self.__printCSVRow()
             self.__csv_updated = False
@@ -276,6 +457,7 @@ def _main():
         print("\t-m MSG[.field1,field2,...]\n\t\tDump only messages of specified type, and only specified fields.\n\t\tMultiple -m options allowed.")
         print("\t-t\tSpecify TIME message name to group data messages by time and significantly reduce duplicate output.\n")
         print("\t-fPrint to file instead of stdout")
+        print("\t-w start:end\n\t\tDump only the time window between start and end seconds, either may be empty.")
         return
     fn = sys.argv[1]
     debug_out = False
@@ -285,6 +467,7 @@ def _main():
     csv_delim = ","
     time_msg = "TIME"
     file_name = None
+    time_window = None
     opt = None
     for arg in sys.argv[2:]:
         if opt != None:
@@ -296,6 +479,11 @@ def _main():
                 time_msg = arg
             elif opt == "f":
             	file_name = arg
+            elif opt == "w":
+                a = arg.split(":")
+                start = float(a[0]) * 1e6 if a[0] != "" else 0
+                end = float(a[1]) * 1e6 if len(a) > 1 and a[1] != "" else float("inf")
+                time_window = (start, end)
             elif opt == "m":
                 show_fields = "*"
                 a = arg.split("_")
@@ -318,6 +506,8 @@ def _main():
                 opt = "t"
             elif arg == "-f":
                 opt = "f"
+            elif arg == "-w":
+                opt = "w"
 
     if csv_delim == "\\t":
         csv_delim = "\t"
@@ -329,6 +519,8 @@ def _main():
     parser.setFileName(file_name)
     parser.setDebugOut(debug_out)
     parser.setCorrectErrors(correct_errors)
+    if time_window != None:
+        parser.setTimeWindow(time_window[0], time_window[1])
     parser.process(fn)
 
 if __name__ == "__main__":
@@ -0,0 +1,268 @@
+/**
+ * @file attitude_ekf_test.cpp
+ *
+ * Checks attitudeKalmanfilter() of attitude_estimator_ekf against reference
+ * results and times it.
+ *
+ * Short runs of the filter are generated from a seeded pseudo random
+ * sequence, one for each combination of sensor updates the filter handles.
+ * The angles and states of every step and all outputs of the last step are
+ * compared with the reference file. The filter is expected to reproduce
+ * the reference exactly, so any difference fails the test. With -w the
+ * reference file is written from the current build instead. Afterwards the
+ * average run time of a step is reported for each update combination.
+ *
+ * usage: attitude_ekf_test [-w] reference.txt
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <systemlib/err.h>
+
+#include <attitude_estimator_ekf/codegen/attitudeKalmanfilter_initialize.h>
+#include <attitude_estimator_ekf/codegen/attitudeKalmanfilter.h>
+
+#define NUM_MODES		6
+#define NUM_STEPS		20
+#define NUM_TIMED_STEPS		20000
+#define NUM_STEP_OUTPUTS	(3 + 12)
+#define NUM_OUTPUTS		(NUM_STEP_OUTPUTS + 9 + 9 + 144)
+
+/* gyro, accel, mag updates; the last one runs the gyro+acc case into the large accel noise branch */
+static const uint8_T update_modes[NUM_MODES][3] = {
+	{1, 1, 1},
+	{1, 0, 0},
+	{1, 1, 0},
+	{1, 0, 1},
+	{0, 0, 0},
+	{1, 1, 0}
+};
+
+static const char *mode_names[NUM_MODES] = {
+	"gyro+acc+mag",
+	"gyro",
+	"gyro+acc",
+	"gyro+mag",
+	"prediction",
+	"gyro+acc(bad)"
+};
+
+static uint32_t rand_state;
+
+/* uniform in [-1, 1) */
+static float
+rand_unit()
+{
+	rand_state = rand_state * 1664525u + 1013904223u;
+	return (float)(rand_state >> 8) / (float)(1 << 23) - 1.0f;
+}
+
+static uint64_t
+timer_now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+struct filter_state {
+	real32_T x[12];
+	real32_T P[144];
+	real32_T q[12];
+	real32_T r[9];
+	real32_T dt;
+};
+
+static void
+setup_mode(struct filter_state *s, unsigned mode)
+{
+	rand_state = 4711u + mode;
+
+	/* rates, angular accelerations, gravity and field vectors */
+	for (unsigned i = 0; i < 3; i++) {
+		s->x[i] = 0.5f * rand_unit();
+		s->x[3 + i] = 0.1f * rand_unit();
+		s->x[6 + i] = 0.5f * rand_unit();
+		s->x[9 + i] = 0.2f * rand_unit();
+	}
+
+	s->x[8] -= 9.81f;
+	s->x[9] += 0.2f;
+	s->x[11] += 0.4f;
+
+	/* correlated start covariances */
+	for (unsigned i = 0; i < 12; i++) {
+		s->P[i + 12 * i] = 1.0f + 0.5f * rand_unit();
+
+		for (unsigned j = 0; j < i; j++) {
+			s->P[i + 12 * j] = 0.2f * rand_unit();
+			s->P[j + 12 * i] = s->P[i + 12 * j];
+		}
+	}
+
+	/* the defaults of the module parameters, slightly perturbed */
+	static const float q_default[4] = {1e-4f, 0.08f, 0.009f, 0.005f};
+	static const float r_default[3] = {0.0008f, 10000.0f, 100.0f};
+
+	for (unsigned i = 0; i < 12; i++) {
+		s->q[i] = q_default[i % 4] * (1.0f + 0.1f * rand_unit());
+	}
+
+	for (unsigned i = 0; i < 9; i++) {
+		s->r[i] = 0.0f;
+	}
+
+	s->r[0] = r_default[0] * (1.0f + 0.1f * rand_unit());
+	/* something the accel updates actually use, unless the bad accel branch raises it */
+	s->r[1] = 1.0f + 0.1f * rand_unit();
+	s->r[2] = r_default[2] * (1.0f + 0.1f * rand_unit());
+
+	s->dt = 0.004f + 0.002f * rand_unit();
+}
+
+static void
+step(struct filter_state *s, unsigned mode, real32_T out[NUM_OUTPUTS])
+{
+	/* noisy measurements around the current state */
+	real32_T z[9];
+
+	for (unsigned i = 0; i < 3; i++) {
+		z[i] = s->x[i] + 0.05f * rand_unit();
+		z[3 + i] = s->x[6 + i] + 0.3f * rand_unit();
+		z[6 + i] = s->x[9 + i] + 0.02f * rand_unit();
+	}
+
+	if (mode == 5) {
+		/* accel reading well off gravity */
+		z[4] = 20.0f;
+	}
+
+	/* what is checked on every step first */
+	real32_T *euler = &out[0];
+	real32_T *x = &out[3];
+	real32_T *r = &out[15];
+	real32_T *rot = &out[24];
+	real32_T *P = &out[33];
+
+	memcpy(r, s->r, sizeof(s->r));
+
+	attitudeKalmanfilter(update_modes[mode], s->dt, z, s->x, s->P, s->q, r, euler, rot, x, P);
+
+	memcpy(s->x, x, sizeof(s->x));
+	memcpy(s->P, P, sizeof(s->P));
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("attitude EKF test started");
+
+	bool write = false;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "w")) != EOF) {
+		switch (ch) {
+		case 'w':
+			write = true;
+			break;
+
+		default:
+			errx(1, "usage: attitude_ekf_test [-w] reference.txt");
+		}
+	}
+
+	if (optind >= argc) {
+		errx(1, "Need a reference file");
+	}
+
+	FILE *fp = fopen(argv[optind], write ? "w" : "r");
+
+	if (fp == NULL) {
+		err(1, "%s", argv[optind]);
+	}
+
+	attitudeKalmanfilter_initialize();
+
+	struct filter_state s;
+	real32_T out[NUM_OUTPUTS];
+	float max_error = 0.0f;
+	unsigned failed = 0;
+
+	for (unsigned mode = 0; mode < NUM_MODES; mode++) {
+		setup_mode(&s, mode);
+
+		for (unsigned n = 0; n < NUM_STEPS; n++) {
+			step(&s, mode, out);
+
+			/* any difference carries over into the following steps */
+			unsigned num_checked = (n == NUM_STEPS - 1) ? NUM_OUTPUTS : NUM_STEP_OUTPUTS;
+
+			for (unsigned i = 0; i < num_checked; i++) {
+				float ref;
+
+				if (write) {
+					fprintf(fp, "%.9g\n", (double)out[i]);
+					continue;
+
+				} else if (fscanf(fp, "%f", &ref) != 1) {
+					errx(1, "reference file too short, %s step %u", mode_names[mode], n);
+				}
+
+				float error = fabsf(out[i] - ref);
+
+				if (error > max_error) {
+					max_error = error;
+				}
+
+				/* exact, NaN included */
+				if (!(out[i] == ref) && !(isnan(out[i]) && isnan(ref))) {
+					if (failed < 10) {
+						warnx("%s step %u: output %u = %.9g, expected %.9g", mode_names[mode], n, i,
+						      (double)out[i], (double)ref);
+					}
+
+					failed++;
+				}
+			}
+		}
+	}
+
+	fclose(fp);
+
+	if (write) {
+		warnx("reference written");
+		return 0;
+	}
+
+	warnx("%u modes, %u steps, max error %.3g", NUM_MODES, NUM_STEPS, (double)max_error);
+
+	for (unsigned mode = 0; mode < NUM_MODES; mode++) {
+		setup_mode(&s, mode);
+
+		uint64_t start = timer_now();
+
+		for (unsigned n = 0; n < NUM_TIMED_STEPS; n++) {
+			step(&s, mode, out);
+
+			/* keep the run from diverging */
+			if (n % NUM_STEPS == NUM_STEPS - 1) {
+				setup_mode(&s, mode);
+			}
+		}
+
+		warnx("%-14s %7.2f us per step", mode_names[mode], (timer_now() - start) / 1e3 / NUM_TIMED_STEPS);
+	}
+
+	if (failed > 0) {
+		warnx("FAILED: %u outputs differ", failed);
+		return 1;
+	}
+
+	warnx("test finished");
+
+	return 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file containers_test.cpp
+ *
+ * Checks the containers in include/containers.
+ *
+ * Array has to keep its order through erase and remove and refuse to
+ * grow past its capacity, IntrusiveList has to unlink head, middle and
+ * tail elements in both directions, and FlatMap has to stay sorted
+ * through inserts, overwrites and erases in any order.
+ *
+ * usage: containers_test
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <systemlib/err.h>
+
+#include <containers/Array.hpp>
+#include <containers/IntrusiveList.hpp>
+#include <containers/FlatMap.hpp>
+
+#include "test_check.h"
+
+class Item : public IntrusiveListNode<Item>
+{
+public:
+	Item(int v) : value(v) {}
+	int value;
+};
+
+/** list contents forwards and backwards as a number, e.g. 123 */
+static bool
+list_is(IntrusiveList<Item> &list, int expect)
+{
+	int forward = 0, backward = 0, scale = 1;
+
+	for (Item *i = list.getHead(); i != nullptr; i = i->getNext())
+		forward = forward * 10 + i->value;
+
+	for (Item *i = list.getTail(); i != nullptr; i = i->getPrev()) {
+		backward += i->value * scale;
+		scale *= 10;
+	}
+
+	return forward == expect && backward == expect;
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("Containers test started");
+
+	/* Array */
+	Array<int, 4> a;
+	check(a.empty() && a.capacity() == 4, "array empty");
+
+	for (int i = 1; i <= 5; i++)
+		a.push_back(i * 10);
+
+	check(a.full() && a.size() == 4 && a[3] == 40, "array capacity");
+	a.erase(1);
+	check(a.size() == 3 && a[0] == 10 && a[1] == 30 && a[2] == 40, "array erase");
+	check(a.remove(40) && !a.remove(99) && a.size() == 2, "array remove");
+
+	int sum = 0;
+
+	for (int *p = a.begin(); p != a.end(); p++)
+		sum += *p;
+
+	check(sum == 40, "array iteration");
+
+	/* IntrusiveList */
+	IntrusiveList<Item> list;
+	Item i1(1), i2(2), i3(3), i4(4);
+	list.push_back(&i2);
+	list.push_back(&i3);
+	list.push_front(&i1);
+	list.push_back(&i4);
+	check(list.size() == 4 && list_is(list, 1234), "list order");
+
+	list.remove(&i2);
+	check(list_is(list, 134), "list remove middle");
+	list.remove(&i1);
+	check(list_is(list, 34), "list remove head");
+	list.remove(&i4);
+	check(list_is(list, 3), "list remove tail");
+	list.remove(&i3);
+	check(list.empty() && list.size() == 0 && list.getTail() == nullptr, "list empty");
+
+	/* FlatMap */
+	FlatMap<int, float, 8> map;
+	const int keys[] = {42, 7, 19, 3, 88, 7, 55};
+
+	for (unsigned i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+		map.insert(keys[i], keys[i] * 0.5f);
+
+	check(map.size() == 6, "map duplicate key");
+
+	bool sorted = true;
+
+	for (size_t i = 1; i < map.size(); i++)
+		sorted = sorted && map.keyAt(i - 1) < map.keyAt(i);
+
+	check(sorted, "map sorted");
+	check(map.find(19) != nullptr && *map.find(19) == 9.5f, "map find");
+	check(map.find(20) == nullptr && map.find(0) == nullptr && map.find(100) == nullptr, "map missing keys");
+
+	map.insert(19, 1.0f);
+	check(*map.find(19) == 1.0f && map.size() == 6, "map overwrite");
+
+	check(map.erase(3) && map.erase(88) && !map.erase(88), "map erase");
+	check(map.size() == 4 && map.keyAt(0) == 7 && map.keyAt(3) == 55, "map after erase");
+
+	for (int k = 100; map.insert(k, 0.0f); k++) {}
+
+	check(map.size() == map.capacity() && !map.insert(1, 0.0f), "map full");
+	check(map.insert(7, 2.0f) && *map.find(7) == 2.0f, "map overwrite when full");
+
+	return check_result();
+}
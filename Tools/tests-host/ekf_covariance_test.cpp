@@ -0,0 +1,209 @@
+/**
+ * @file ekf_covariance_test.cpp
+ *
+ * Checks AttPosEKF::CovariancePrediction() against reference results.
+ *
+ * A fixed set of states, covariances and summed IMU deltas is generated
+ * from a seeded pseudo random sequence, so every build predicts from the
+ * same inputs. The predicted covariances are compared element by element
+ * with the reference file, relative to the standard deviations of the
+ * two states involved. With -w the reference file is written from the
+ * current build instead.
+ *
+ * usage: ekf_covariance_test [-w] reference.txt
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <systemlib/err.h>
+
+#include <ekf_att_pos_estimator/estimator_23states.h>
+
+#define NUM_CASES		8
+#define MAX_REL_ERROR		1.0e-5f
+
+static uint32_t rand_state;
+
+/* the prediction does not depend on time */
+uint32_t millis()
+{
+	return 0;
+}
+
+uint64_t getMicros()
+{
+	return 0;
+}
+
+/* uniform in [-1, 1) */
+static float
+rand_unit()
+{
+	rand_state = rand_state * 1664525u + 1013904223u;
+	return (float)(rand_state >> 8) / (float)(1 << 23) - 1.0f;
+}
+
+static void
+setup_case(AttPosEKF *ekf, unsigned n)
+{
+	/* typical standard deviations of the states in flight */
+	static const float sigma[n_states] = {
+		1e-2f, 1e-2f, 1e-2f, 1e-2f,	/* quaternion */
+		0.3f, 0.3f, 0.4f,		/* velocity */
+		3.0f, 3.0f, 2.0f,		/* position */
+		1e-4f, 1e-4f, 1e-4f,		/* delta angle bias */
+		1e-3f,				/* z delta velocity bias */
+		0.5f, 0.5f,			/* wind */
+		1e-2f, 1e-2f, 1e-2f,		/* earth field */
+		1e-2f, 1e-2f, 1e-2f,		/* body field */
+		1.0f				/* terrain */
+	};
+
+	rand_state = 12345u + n;
+
+	/* some random attitude */
+	float q[4];
+	float norm = 0.0f;
+
+	for (unsigned i = 0; i < 4; i++) {
+		q[i] = rand_unit();
+		norm += q[i] * q[i];
+	}
+
+	norm = sqrtf(norm);
+
+	for (unsigned i = 0; i < 4; i++) {
+		ekf->states[i] = q[i] / norm;
+	}
+
+	for (unsigned i = 4; i < n_states; i++) {
+		ekf->states[i] = rand_unit() * sigma[i] * 10.0f;
+	}
+
+	/* correlated covariances, close to what fusion leaves behind */
+	for (unsigned i = 0; i < n_states; i++) {
+		float s = sigma[i];
+
+		/* one case without GPS for long, where the position variance is frozen */
+		if (n == 5 && (i == 7 || i == 8)) {
+			s *= 300.0f;
+		}
+
+		ekf->P[i][i] = s * s * (1.0f + 0.5f * rand_unit());
+
+		for (unsigned j = 0; j < i; j++) {
+			float rho = 0.3f * rand_unit();
+			ekf->P[i][j] = rho * sqrtf(ekf->P[i][i] * ekf->P[j][j]);
+			ekf->P[j][i] = ekf->P[i][j];
+		}
+	}
+
+	/* 5 to 20 ms worth of IMU deltas, with some rotation */
+	float dt = 0.005f + 0.015f * (0.5f * rand_unit() + 0.5f);
+	ekf->summedDelAng.x = 2.0f * dt * rand_unit();
+	ekf->summedDelAng.y = 2.0f * dt * rand_unit();
+	ekf->summedDelAng.z = 2.0f * dt * rand_unit();
+	ekf->summedDelVel.x = 5.0f * dt * rand_unit();
+	ekf->summedDelVel.y = 5.0f * dt * rand_unit();
+	ekf->summedDelVel.z = -9.81f * dt + dt * rand_unit();
+
+	ekf->onGround = (n % 4) == 3;
+	ekf->inhibitWindStates = (n % 3) == 2;
+	ekf->inhibitMagStates = (n % 5) == 4;
+	ekf->inhibitGndState = (n % 2) == 1;
+
+	ekf->CovariancePrediction(dt);
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("EKF covariance test started");
+
+	bool write = false;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "w")) != EOF) {
+		switch (ch) {
+		case 'w':
+			write = true;
+			break;
+
+		default:
+			errx(1, "usage: ekf_covariance_test [-w] reference.txt");
+		}
+	}
+
+	if (optind >= argc) {
+		errx(1, "Need a reference file");
+	}
+
+	FILE *fp = fopen(argv[optind], write ? "w" : "r");
+
+	if (fp == NULL) {
+		err(1, "%s", argv[optind]);
+	}
+
+	AttPosEKF *ekf = new AttPosEKF();
+	float max_error = 0.0f;
+	unsigned failed = 0;
+
+	for (unsigned n = 0; n < NUM_CASES; n++) {
+		setup_case(ekf, n);
+
+		float ref[n_states][n_states];
+
+		for (unsigned i = 0; i < n_states; i++) {
+			for (unsigned j = 0; j < n_states; j++) {
+				if (write) {
+					fprintf(fp, "%.9g\n", (double)ekf->P[i][j]);
+
+				} else if (fscanf(fp, "%f", &ref[i][j]) != 1) {
+					errx(1, "reference file too short, case %u", n);
+				}
+			}
+		}
+
+		if (write) {
+			continue;
+		}
+
+		for (unsigned i = 0; i < n_states; i++) {
+			for (unsigned j = 0; j < n_states; j++) {
+				float scale = sqrtf(fabsf(ref[i][i] * ref[j][j]));
+				float error = (scale > 0.0f) ? fabsf(ekf->P[i][j] - ref[i][j]) / scale : fabsf(ekf->P[i][j] - ref[i][j]);
+
+				if (error > max_error) {
+					max_error = error;
+				}
+
+				if (!(error <= MAX_REL_ERROR)) {
+					warnx("case %u: P[%u][%u] = %.9g, expected %.9g", n, i, j, (double)ekf->P[i][j], (double)ref[i][j]);
+					failed++;
+				}
+			}
+		}
+	}
+
+	fclose(fp);
+	delete ekf;
+
+	if (write) {
+		warnx("reference written");
+		return 0;
+	}
+
+	warnx("%u cases, max relative error %.3g", NUM_CASES, (double)max_error);
+
+	if (failed > 0) {
+		warnx("FAILED: %u elements out of tolerance", failed);
+		return 1;
+	}
+
+	warnx("test finished");
+
+	return 0;
+}
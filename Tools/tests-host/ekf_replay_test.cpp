@@ -0,0 +1,1135 @@
+/**
+ * @file ekf_replay_test.cpp
+ *
+ * Replays an sdlog2 log through the EKF as fast as possible and reports the
+ * run time of every filter step.
+ *
+ * The IMU, SENS, GPS and AIRS messages of the log are fed to AttPosEKF in the
+ * same sequence ekf_att_pos_estimator uses on the vehicle, with the parameter
+ * defaults of the module. Compressed logs are expanded on the fly. With -o
+ * the attitude, velocity and position are written as CSV after every IMU
+ * step. With -r such a file from another run is read back and the error of
+ * this run against it is reported, so two builds or the 23 and the 21 state
+ * filter (ekf_replay_test_21, built with EKF_21_STATES) can be compared on
+ * the same data. With -i the IMU samples are pre-integrated to the given
+ * rate in Hz before the filter runs, like PE_IMU_RATE does on the vehicle.
+ * With -a the attitude is output with every IMU sample from the fast
+ * attitude that follows the filter with the given time constant in seconds,
+ * like PE_FAST_ATT_TC.
+ *
+ * usage: ekf_replay_test [-i rate] [-a tc] [-o out.csv] [-r reference.csv] log.bin
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+#include <float.h>
+#include <systemlib/err.h>
+#include <drivers/drv_hrt.h>
+
+#include <geo_lookup/geo_mag_declination.h>
+#ifdef EKF_21_STATES
+#include <ekf_att_pos_estimator/estimator_21states.h>
+#else
+#include <ekf_att_pos_estimator/estimator_23states.h>
+#endif
+
+#define HEAD_BYTE1		0xA3
+#define HEAD_BYTE2		0x95
+#define LOG_FORMAT_MSG		0x80
+#define LOG_FORMAT_LEN		89
+#define LOG_TOPIC_FORMAT_MSG	0xF1
+#define LOG_TOPIC_FORMAT_LEN	182
+#define LOG_BLOCK_MSG		0xF0
+#define LOG_BLOCK_HEADER_LEN	7
+
+/* module parameter defaults, see ekf_att_pos_estimator_params.c */
+#define VEL_DELAY_MS		230
+#define POS_DELAY_MS		210
+#define HGT_DELAY_MS		350
+#define MAG_DELAY_MS		30
+#define TAS_DELAY_MS		210
+#define POS_STDDEV_THRESHOLD	5.0f
+
+#define MAX_FIELDS		32
+
+struct field_s {
+	char label[17];
+	char type;
+	unsigned offset;
+};
+
+struct msg_descr_s {
+	unsigned length;
+	char name[5];
+	unsigned num_fields;
+	struct field_s fields[MAX_FIELDS];
+	uint8_t prev[256];		///< previous body within the current block, for delta decoding
+	bool prev_valid;
+};
+
+enum timer_id {
+	TIMER_PREDICT = 0,
+	TIMER_COVARIANCE,
+	TIMER_FUSE_VELPOS,
+	TIMER_FUSE_HGT,
+	TIMER_FUSE_MAG,
+	TIMER_FUSE_AIRSPEED,
+	TIMER_NUM
+};
+
+static const char *const timer_names[TIMER_NUM] = {
+	"predict", "covariance", "fuse vel/pos", "fuse height", "fuse mag", "fuse airspeed"
+};
+
+/** a row of a reference CSV written with -o */
+struct ref_row_s {
+	uint64_t t;
+	float x[10];
+};
+
+struct ref_error_s {
+	unsigned count;
+	double att_sq;
+	double vel_sq;
+	double pos_sq;
+	float att_max;
+	float vel_max;
+	float pos_max;
+};
+
+struct timer_s {
+	unsigned count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+};
+
+static struct msg_descr_s *descrs[256];
+static struct timer_s timers[TIMER_NUM];
+
+static int type_time = -1;
+static int type_imu = -1;
+static int type_sens = -1;
+static int type_gps = -1;
+static int type_airs = -1;
+
+static unsigned resyncs = 0;
+static unsigned filter_resets = 0;
+
+static AttPosEKF *ekf;
+static FILE *out_fp = 0;
+static struct ref_row_s *ref_rows = 0;
+static unsigned ref_num = 0;
+static unsigned ref_next = 0;
+static struct ref_error_s ref_error;
+
+/* replay state, named after the members of FixedwingEstimator */
+static uint64_t now_us = 0;
+static uint64_t first_us = 0;
+static uint64_t last_imu_us = 0;
+static uint64_t last_gps_us = 0;
+static uint64_t last_baro_us = 0;
+static float cov_dt = 0.0f;
+static Vector3f last_ang_rate;
+static Vector3f last_accel;
+static Vector3f last_mag;
+static bool imu_valid = false;
+static bool mag_valid = false;
+static bool baro_init = false;
+static bool gps_initialized = false;
+static bool new_gps = false;
+static int imu_rate = 0;
+static ImuPreintegrator imu_preint;
+static float fast_att_tc = 0.0f;
+static FastAttitude fast_att;
+static bool fast_att_valid = false;
+static float filter_dt = 0.01f;
+
+/* the attitude the module would publish */
+static const float *
+output_attitude()
+{
+	return (fast_att_tc > 0.0f) ? fast_att.q : &ekf->states[0];
+}
+static bool new_hgt = false;
+static bool new_mag = false;
+static bool new_tas = false;
+static float baro_ref = 0.0f;
+static float gps_eph = 0.0f;
+static float gps_epv = 0.0f;
+
+/* the filter takes its time from the log, like it does from the sensors on the vehicle */
+uint32_t millis()
+{
+	return now_us / 1000;
+}
+
+uint64_t getMicros()
+{
+	return now_us;
+}
+
+static float
+constrain(float val, float min_val, float max_val)
+{
+	return (val < min_val) ? min_val : ((val > max_val) ? max_val : val);
+}
+
+static double
+radians(double degrees)
+{
+	return degrees * M_PI / 180.0;
+}
+
+static double
+degrees(double radians)
+{
+	return radians * 180.0 / M_PI;
+}
+
+static uint64_t
+timer_now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+timer_add(enum timer_id id, uint64_t start)
+{
+	uint64_t elapsed = timer_now() - start;
+	timers[id].count++;
+	timers[id].total_ns += elapsed;
+
+	if (elapsed > timers[id].max_ns) {
+		timers[id].max_ns = elapsed;
+	}
+}
+
+static unsigned
+format_char_size(char c)
+{
+	switch (c) {
+	case 'b': case 'B': case 'M': case 'x':
+		return 1;
+
+	case 'h': case 'H': case 'c': case 'C':
+		return 2;
+
+	case 'i': case 'I': case 'f': case 'e': case 'E': case 'L': case 'n':
+		return 4;
+
+	case 'q': case 'Q':
+		return 8;
+
+	case 'N':
+		return 16;
+
+	case 'Z':
+		return 64;
+
+	default:
+		return 0;
+	}
+}
+
+static void
+parse_format(const uint8_t *msg)
+{
+	uint8_t type = msg[3];
+	char format[17];
+	char labels[65];
+
+	memcpy(format, &msg[9], 16);
+	format[16] = '\0';
+	memcpy(labels, &msg[25], 64);
+	labels[64] = '\0';
+
+	if (descrs[type] == 0) {
+		descrs[type] = (struct msg_descr_s *)calloc(1, sizeof(struct msg_descr_s));
+	}
+
+	struct msg_descr_s *d = descrs[type];
+	d->length = msg[4];
+	memcpy(d->name, &msg[5], 4);
+	d->name[4] = '\0';
+	d->num_fields = 0;
+
+	unsigned offset = 3;
+	const char *label = labels;
+
+	for (const char *c = format; *c != '\0' && d->num_fields < MAX_FIELDS; c++) {
+		struct field_s *f = &d->fields[d->num_fields++];
+		const char *end = strchr(label, ',');
+		size_t len = end ? (size_t)(end - label) : strlen(label);
+
+		if (len >= sizeof(f->label)) {
+			len = sizeof(f->label) - 1;
+		}
+
+		memcpy(f->label, label, len);
+		f->label[len] = '\0';
+		f->type = *c;
+		f->offset = offset;
+		offset += format_char_size(*c);
+		label = end ? end + 1 : label + len;
+	}
+
+	if (strcmp(d->name, "TIME") == 0) {
+		type_time = type;
+
+	} else if (strcmp(d->name, "IMU") == 0) {
+		type_imu = type;
+
+	} else if (strcmp(d->name, "SENS") == 0) {
+		type_sens = type;
+
+	} else if (strcmp(d->name, "GPS") == 0) {
+		type_gps = type;
+
+	} else if (strcmp(d->name, "AIRS") == 0) {
+		type_airs = type;
+	}
+}
+
+static void
+parse_topic_format(const uint8_t *msg)
+{
+	/* raw topics are not replayed, only their length is needed to skip them */
+	uint8_t type = msg[3];
+	uint16_t size;
+	memcpy(&size, &msg[4], sizeof(size));
+
+	if (descrs[type] == 0) {
+		descrs[type] = (struct msg_descr_s *)calloc(1, sizeof(struct msg_descr_s));
+	}
+
+	descrs[type]->length = size + 3;
+	memcpy(descrs[type]->name, &msg[6], 4);
+	descrs[type]->name[4] = '\0';
+	descrs[type]->num_fields = 0;
+}
+
+static const struct field_s *
+find_field(int type, const char *label)
+{
+	if (type < 0 || descrs[type] == 0) {
+		return 0;
+	}
+
+	for (unsigned i = 0; i < descrs[type]->num_fields; i++) {
+		if (strcmp(descrs[type]->fields[i].label, label) == 0) {
+			return &descrs[type]->fields[i];
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Read a field by label, scaled like sdlog2_dump.py does. Missing fields read as 0.
+ */
+static double
+get_field(int type, const uint8_t *msg, const char *label)
+{
+	const struct field_s *f = find_field(type, label);
+
+	if (f == 0) {
+		return 0.0;
+	}
+
+	const uint8_t *p = &msg[f->offset];
+
+	switch (f->type) {
+	case 'b': case 'M': { int8_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+	case 'B': return *p;
+
+	case 'h': { int16_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+	case 'H': { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+	case 'c': { int16_t v; memcpy(&v, p, sizeof(v)); return v * 0.01; }
+
+	case 'C': { uint16_t v; memcpy(&v, p, sizeof(v)); return v * 0.01; }
+
+	case 'i': { int32_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+	case 'I': { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+	case 'e': { int32_t v; memcpy(&v, p, sizeof(v)); return v * 0.01; }
+
+	case 'E': { uint32_t v; memcpy(&v, p, sizeof(v)); return v * 0.01; }
+
+	case 'L': { int32_t v; memcpy(&v, p, sizeof(v)); return v * 1e-7; }
+
+	case 'f': { float v; memcpy(&v, p, sizeof(v)); return v; }
+
+	case 'q': { int64_t v; memcpy(&v, p, sizeof(v)); return (double)v; }
+
+	case 'Q': { uint64_t v; memcpy(&v, p, sizeof(v)); return (double)v; }
+
+	default: return 0.0;
+	}
+}
+
+static void
+handle_sens(const uint8_t *msg)
+{
+	float baro_elapsed = (now_us - last_baro_us) / 1e6f;
+	last_baro_us = now_us;
+
+#ifndef EKF_21_STATES
+	ekf->updateDtHgtFilt(constrain(baro_elapsed, 0.001f, 0.1f));
+#else
+	(void)baro_elapsed;
+#endif
+	ekf->baroHgt = get_field(type_sens, msg, "BaroAlt");
+
+	if (!baro_init) {
+		baro_ref = ekf->baroHgt;
+		baro_init = true;
+	}
+
+	new_hgt = true;
+}
+
+static void
+handle_gps(const uint8_t *msg)
+{
+	int fix_type = get_field(type_gps, msg, "Fix");
+
+	if (fix_type < 3) {
+		return;
+	}
+
+	const float pos_reset_threshold = 5.0f;
+	float gps_elapsed = (now_us - last_gps_us) / 1e6f;
+
+	if (last_gps_us != 0 && gps_elapsed > pos_reset_threshold) {
+		ekf->ResetPosition();
+		ekf->ResetVelocity();
+		ekf->ResetStoredStates();
+	}
+
+#ifndef EKF_21_STATES
+	ekf->updateDtGpsFilt(constrain(gps_elapsed, 0.01f, pos_reset_threshold));
+#endif
+
+	float vel_n = get_field(type_gps, msg, "VelN");
+	float vel_e = get_field(type_gps, msg, "VelE");
+	float vel_d = get_field(type_gps, msg, "VelD");
+#ifndef EKF_21_STATES
+	float gps_dt = gps_elapsed;
+
+	if (((fabsf(ekf->velNED[0] - vel_n) > FLT_EPSILON) ||
+	     (fabsf(ekf->velNED[1] - vel_e) > FLT_EPSILON) ||
+	     (fabsf(ekf->velNED[2] - vel_d) > FLT_EPSILON)) && (gps_dt > 0.00001f)) {
+		ekf->accelGPSNED[0] = (ekf->velNED[0] - vel_n) / gps_dt;
+		ekf->accelGPSNED[1] = (ekf->velNED[1] - vel_e) / gps_dt;
+		ekf->accelGPSNED[2] = (ekf->velNED[2] - vel_d) / gps_dt;
+	}
+
+#endif
+
+	ekf->GPSstatus = fix_type;
+	ekf->velNED[0] = vel_n;
+	ekf->velNED[1] = vel_e;
+	ekf->velNED[2] = vel_d;
+	ekf->gpsLat = radians(get_field(type_gps, msg, "Lat"));
+	ekf->gpsLon = radians(get_field(type_gps, msg, "Lon")) - M_PI;
+	ekf->gpsHgt = get_field(type_gps, msg, "Alt");
+	gps_eph = get_field(type_gps, msg, "EPH");
+	gps_epv = get_field(type_gps, msg, "EPV");
+
+	last_gps_us = now_us;
+	new_gps = true;
+}
+
+static void
+handle_airs(const uint8_t *msg)
+{
+	ekf->VtasMeas = get_field(type_airs, msg, "TrueSpeed");
+	new_tas = true;
+}
+
+/**
+ * Accumulate the error of the current states against the reference row
+ * with the same time stamp, if there is one.
+ */
+static void
+compare_reference()
+{
+	while (ref_next < ref_num && ref_rows[ref_next].t < now_us) {
+		ref_next++;
+	}
+
+	if (ref_next >= ref_num || ref_rows[ref_next].t != now_us) {
+		return;
+	}
+
+	const float *r = ref_rows[ref_next].x;
+
+	/* rotation angle of conj(q_ref) * q, from its vector part so it stays accurate near zero */
+	const float *q = output_attitude();
+	float ew = r[0] * q[0] + r[1] * q[1] + r[2] * q[2] + r[3] * q[3];
+	float ex = r[0] * q[1] - r[1] * q[0] - r[2] * q[3] + r[3] * q[2];
+	float ey = r[0] * q[2] + r[1] * q[3] - r[2] * q[0] - r[3] * q[1];
+	float ez = r[0] * q[3] - r[1] * q[2] + r[2] * q[1] - r[3] * q[0];
+	float att = 2.0f * atan2f(sqrtf(ex * ex + ey * ey + ez * ez), fabsf(ew));
+
+	/* NED velocity and position distance */
+	float vel = 0.0f;
+	float pos = 0.0f;
+
+	for (unsigned i = 0; i < 3; i++) {
+		vel += (ekf->states[4 + i] - r[4 + i]) * (ekf->states[4 + i] - r[4 + i]);
+		pos += (ekf->states[7 + i] - r[7 + i]) * (ekf->states[7 + i] - r[7 + i]);
+	}
+
+	vel = sqrtf(vel);
+	pos = sqrtf(pos);
+
+	if (!isfinite(att) || !isfinite(vel) || !isfinite(pos)) {
+		return;
+	}
+
+	ref_error.count++;
+	ref_error.att_sq += att * att;
+	ref_error.vel_sq += vel * vel;
+	ref_error.pos_sq += pos * pos;
+	ref_error.att_max = (att > ref_error.att_max) ? att : ref_error.att_max;
+	ref_error.vel_max = (vel > ref_error.vel_max) ? vel : ref_error.vel_max;
+	ref_error.pos_max = (pos > ref_error.pos_max) ? pos : ref_error.pos_max;
+}
+
+static void
+load_reference(const char *path)
+{
+	FILE *fp = fopen(path, "r");
+
+	if (fp == 0) {
+		err(1, "failed opening %s", path);
+	}
+
+	char line[256];
+	unsigned size = 0;
+
+	while (fgets(line, sizeof(line), fp) != 0) {
+		struct ref_row_s row;
+		unsigned long long t;
+
+		if (sscanf(line, "%llu,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f", &t,
+			   &row.x[0], &row.x[1], &row.x[2], &row.x[3], &row.x[4],
+			   &row.x[5], &row.x[6], &row.x[7], &row.x[8], &row.x[9]) != 11) {
+			/* header */
+			continue;
+		}
+
+		if (ref_num == size) {
+			size = size ? 2 * size : 4096;
+			ref_rows = (struct ref_row_s *)realloc(ref_rows, size * sizeof(struct ref_row_s));
+
+			if (ref_rows == 0) {
+				errx(1, "out of memory");
+			}
+		}
+
+		row.t = t;
+		ref_rows[ref_num++] = row;
+	}
+
+	fclose(fp);
+
+	if (ref_num == 0) {
+		errx(1, "no rows in %s", path);
+	}
+}
+
+static void
+write_output()
+{
+	if (out_fp == 0) {
+		return;
+	}
+
+	fprintf(out_fp, "%llu", (unsigned long long)now_us);
+
+	/* quaternion, NED velocity, NED position */
+	const float *q = output_attitude();
+
+	for (unsigned i = 0; i < 4; i++) {
+		fprintf(out_fp, ",%.6f", (double)q[i]);
+	}
+
+	for (unsigned i = 4; i < 10; i++) {
+		fprintf(out_fp, ",%.6f", (double)ekf->states[i]);
+	}
+
+	fprintf(out_fp, "\n");
+}
+
+static void
+output_step()
+{
+	write_output();
+
+	if (ref_rows) {
+		compare_reference();
+	}
+}
+
+static void
+handle_imu(const uint8_t *msg)
+{
+	float dt = (now_us - last_imu_us) / 1e6f;
+
+	if (!isfinite(dt) || dt > 1.0f || dt < 0.000001f) {
+		dt = 0.01f;
+	}
+
+	last_imu_us = now_us;
+
+	ekf->dtIMU = dt;
+	ekf->angRate.x = get_field(type_imu, msg, "GyroX");
+	ekf->angRate.y = get_field(type_imu, msg, "GyroY");
+	ekf->angRate.z = get_field(type_imu, msg, "GyroZ");
+	ekf->accel.x = get_field(type_imu, msg, "AccX");
+	ekf->accel.y = get_field(type_imu, msg, "AccY");
+	ekf->accel.z = get_field(type_imu, msg, "AccZ");
+
+	if (!imu_valid) {
+		last_ang_rate = ekf->angRate;
+		last_accel = ekf->accel;
+		imu_valid = true;
+	}
+
+	ekf->dAngIMU = 0.5f * (ekf->angRate + last_ang_rate) * ekf->dtIMU;
+	last_ang_rate = ekf->angRate;
+	ekf->dVelIMU = 0.5f * (ekf->accel + last_accel) * ekf->dtIMU;
+	last_accel = ekf->accel;
+
+	/* the IMU message repeats the last mag sample, a new one shows as a change */
+	Vector3f mag;
+	mag.x = get_field(type_imu, msg, "MagX");
+	mag.y = get_field(type_imu, msg, "MagY");
+	mag.z = get_field(type_imu, msg, "MagZ");
+
+	if (!mag_valid || mag.x != last_mag.x || mag.y != last_mag.y || mag.z != last_mag.z) {
+		ekf->magData = mag;
+		ekf->magBias.x = 0.000001f;
+		ekf->magBias.y = 0.000001f;
+		ekf->magBias.z = 0.000001f;
+		last_mag = mag;
+		mag_valid = true;
+		new_mag = true;
+	}
+
+	/* the fast attitude goes out with every sample, ahead of the filter */
+	if (fast_att_tc > 0.0f && fast_att_valid) {
+		float bias_scale = ekf->dtIMU / filter_dt;
+		fast_att.predict(ekf->dAngIMU - Vector3f(ekf->states[10], ekf->states[11], ekf->states[12]) * bias_scale);
+		output_step();
+	}
+
+	if (imu_rate > 0) {
+		if (!imu_preint.update(ekf->dAngIMU, ekf->dVelIMU, ekf->dtIMU, 1.0f / imu_rate)) {
+			return;
+		}
+
+		ekf->dAngIMU = imu_preint.delAng;
+		ekf->dVelIMU = imu_preint.delVel;
+		ekf->dtIMU = imu_preint.delT;
+	}
+
+	if (!baro_init || !mag_valid) {
+		return;
+	}
+
+	uint64_t imu_msec = now_us / 1000;
+	float init_vel_ned[3];
+
+	if (!gps_initialized && new_gps && gps_eph < POS_STDDEV_THRESHOLD && gps_epv < POS_STDDEV_THRESHOLD) {
+		init_vel_ned[0] = ekf->velNED[0];
+		init_vel_ned[1] = ekf->velNED[1];
+		init_vel_ned[2] = ekf->velNED[2];
+
+		double lat = ekf->gpsLat;
+		double lon = ekf->gpsLon + M_PI;
+		ekf->hgtMea = ekf->baroHgt - baro_ref;
+
+		float declination = radians(get_mag_declination(degrees(lat), degrees(lon)));
+		ekf->InitialiseFilter(init_vel_ned, lat, lon - M_PI, ekf->gpsHgt, declination);
+
+		gps_initialized = true;
+
+	} else if (!ekf->statesInitialised) {
+		init_vel_ned[0] = 0.0f;
+		init_vel_ned[1] = 0.0f;
+		init_vel_ned[2] = 0.0f;
+		ekf->posNE[0] = 0.0f;
+		ekf->posNE[1] = 0.0f;
+
+		ekf->InitialiseFilter(init_vel_ned, 0.0, 0.0, 0.0f, 0.0f);
+
+	} else {
+#ifdef EKF_21_STATES
+
+		if (ekf->CheckAndBound()) {
+#else
+		struct ekf_status_report ekf_report;
+
+		if (ekf->CheckAndBound(&ekf_report)) {
+#endif
+			filter_resets++;
+			fast_att_valid = false;
+			new_gps = new_hgt = new_mag = new_tas = false;
+			return;
+		}
+
+		uint64_t start = timer_now();
+		ekf->UpdateStrapdownEquationsNED();
+		ekf->StoreStates(imu_msec);
+		ekf->OnGroundCheck();
+		ekf->summedDelAng = ekf->summedDelAng + ekf->correctedDelAng;
+		ekf->summedDelVel = ekf->summedDelVel + ekf->dVelIMU;
+		cov_dt += ekf->dtIMU;
+		timer_add(TIMER_PREDICT, start);
+
+		if ((cov_dt >= (ekf->covTimeStepMax - ekf->dtIMU)) || (ekf->summedDelAng.length() > ekf->covDelAngMax)) {
+			start = timer_now();
+			ekf->CovariancePrediction(cov_dt);
+			ekf->summedDelAng.zero();
+			ekf->summedDelVel.zero();
+			cov_dt = 0.0f;
+			timer_add(TIMER_COVARIANCE, start);
+		}
+
+		if (new_gps && gps_initialized) {
+			float pos_ned[3];
+			start = timer_now();
+			ekf->calcposNED(pos_ned, ekf->gpsLat, ekf->gpsLon, ekf->gpsHgt, ekf->latRef, ekf->lonRef, ekf->hgtRef);
+			ekf->posNE[0] = pos_ned[0];
+			ekf->posNE[1] = pos_ned[1];
+			ekf->fuseVelData = true;
+			ekf->fusePosData = true;
+			ekf->RecallStates(ekf->statesAtVelTime, (imu_msec - VEL_DELAY_MS));
+			ekf->RecallStates(ekf->statesAtPosTime, (imu_msec - POS_DELAY_MS));
+			ekf->FuseVelposNED();
+			timer_add(TIMER_FUSE_VELPOS, start);
+
+		} else if (!gps_initialized) {
+			/* static mode, fuse zero velocity and position */
+			start = timer_now();
+			ekf->staticMode = true;
+			ekf->velNED[0] = 0.0f;
+			ekf->velNED[1] = 0.0f;
+			ekf->velNED[2] = 0.0f;
+			ekf->posNE[0] = 0.0f;
+			ekf->posNE[1] = 0.0f;
+			ekf->fuseVelData = true;
+			ekf->fusePosData = true;
+			ekf->RecallStates(ekf->statesAtVelTime, (imu_msec - VEL_DELAY_MS));
+			ekf->RecallStates(ekf->statesAtPosTime, (imu_msec - POS_DELAY_MS));
+			ekf->FuseVelposNED();
+			timer_add(TIMER_FUSE_VELPOS, start);
+
+		} else {
+			ekf->fuseVelData = false;
+			ekf->fusePosData = false;
+		}
+
+		if (new_hgt) {
+			start = timer_now();
+			ekf->hgtMea = ekf->baroHgt - baro_ref;
+			ekf->fuseHgtData = true;
+			ekf->RecallStates(ekf->statesAtHgtTime, (imu_msec - HGT_DELAY_MS));
+			ekf->FuseVelposNED();
+			timer_add(TIMER_FUSE_HGT, start);
+
+		} else {
+			ekf->fuseHgtData = false;
+		}
+
+		if (new_mag) {
+			start = timer_now();
+			ekf->fuseMagData = true;
+			ekf->RecallStates(ekf->statesAtMagMeasTime, (imu_msec - MAG_DELAY_MS));
+#ifdef EKF_21_STATES
+			/* the 21 state filter starts over at X while fuseMagData is set */
+			ekf->FuseMagnetometer();
+			ekf->fuseMagData = false;
+#else
+			ekf->magstate.obsIndex = 0;
+			ekf->FuseMagnetometer();
+#endif
+			ekf->FuseMagnetometer();
+			ekf->FuseMagnetometer();
+			timer_add(TIMER_FUSE_MAG, start);
+
+		} else {
+			ekf->fuseMagData = false;
+		}
+
+		if (new_tas && ekf->VtasMeas > 7.0f) {
+			start = timer_now();
+			ekf->fuseVtasData = true;
+			ekf->RecallStates(ekf->statesAtVtasMeasTime, (imu_msec - TAS_DELAY_MS));
+			ekf->FuseAirspeed();
+			timer_add(TIMER_FUSE_AIRSPEED, start);
+
+		} else {
+			ekf->fuseVtasData = false;
+		}
+
+		filter_dt = ekf->dtIMU;
+
+		if (fast_att_tc > 0.0f) {
+			if (fast_att_valid) {
+				float gain = ekf->dtIMU / fast_att_tc;
+				fast_att.correct(&ekf->states[0], (gain < 1.0f) ? gain : 1.0f);
+
+			} else {
+				fast_att.reset(&ekf->states[0]);
+				fast_att_valid = true;
+			}
+
+		} else {
+			output_step();
+		}
+	}
+
+	new_gps = false;
+	new_hgt = false;
+	new_mag = false;
+	new_tas = false;
+}
+
+static void
+handle_msg(uint8_t type, const uint8_t *msg)
+{
+	if (type == type_time) {
+		now_us = get_field(type_time, msg, "StartTime");
+
+		if (first_us == 0) {
+			first_us = now_us;
+		}
+
+	} else if (type == type_imu) {
+		handle_imu(msg);
+
+	} else if (type == type_sens) {
+		handle_sens(msg);
+
+	} else if (type == type_gps) {
+		handle_gps(msg);
+
+	} else if (type == type_airs) {
+		handle_airs(msg);
+	}
+}
+
+static int
+lz_decompress(const uint8_t *data, unsigned data_len, uint8_t *out, unsigned raw_len)
+{
+	unsigned ip = 0;
+	unsigned op = 0;
+
+	while (op < raw_len) {
+		if (ip >= data_len) {
+			return -1;
+		}
+
+		uint8_t token = data[ip++];
+		unsigned lit_len = token >> 4;
+
+		if (lit_len == 15) {
+			uint8_t b;
+
+			do {
+				if (ip >= data_len) {
+					return -1;
+				}
+
+				b = data[ip++];
+				lit_len += b;
+			} while (b == 255);
+		}
+
+		if (ip + lit_len > data_len || op + lit_len > raw_len) {
+			return -1;
+		}
+
+		memcpy(&out[op], &data[ip], lit_len);
+		ip += lit_len;
+		op += lit_len;
+
+		if (op >= raw_len) {
+			break;
+		}
+
+		if (ip + 2 > data_len) {
+			return -1;
+		}
+
+		unsigned offset = data[ip] | (data[ip + 1] << 8);
+		ip += 2;
+		unsigned match_len = (token & 0x0F) + 4;
+
+		if ((token & 0x0F) == 15) {
+			uint8_t b;
+
+			do {
+				if (ip >= data_len) {
+					return -1;
+				}
+
+				b = data[ip++];
+				match_len += b;
+			} while (b == 255);
+		}
+
+		if (offset == 0 || offset > op || op + match_len > raw_len) {
+			return -1;
+		}
+
+		/* byte by byte, matches may overlap */
+		for (unsigned i = 0; i < match_len; i++, op++) {
+			out[op] = out[op - offset];
+		}
+	}
+
+	return 0;
+}
+
+static void parse_stream(uint8_t *buf, size_t len, bool in_block);
+
+static void
+expand_block(const uint8_t *msg, unsigned raw_len, unsigned data_len)
+{
+	uint8_t *raw = (uint8_t *)malloc(raw_len);
+
+	if (raw == 0) {
+		errx(1, "out of memory");
+	}
+
+	if (data_len == raw_len) {
+		memcpy(raw, &msg[LOG_BLOCK_HEADER_LEN], raw_len);
+
+	} else if (lz_decompress(&msg[LOG_BLOCK_HEADER_LEN], data_len, raw, raw_len) != 0) {
+		warnx("corrupt block, skipped");
+		free(raw);
+		return;
+	}
+
+	for (unsigned i = 0; i < 256; i++) {
+		if (descrs[i] != 0) {
+			descrs[i]->prev_valid = false;
+		}
+	}
+
+	parse_stream(raw, raw_len, true);
+	free(raw);
+}
+
+static void
+parse_stream(uint8_t *buf, size_t len, bool in_block)
+{
+	size_t pos = 0;
+
+	while (pos + 3 <= len) {
+		if (buf[pos] != HEAD_BYTE1 || buf[pos + 1] != HEAD_BYTE2) {
+			pos++;
+			resyncs++;
+			continue;
+		}
+
+		uint8_t type = buf[pos + 2];
+
+		if (type == LOG_FORMAT_MSG) {
+			if (pos + LOG_FORMAT_LEN > len) {
+				break;
+			}
+
+			parse_format(&buf[pos]);
+			pos += LOG_FORMAT_LEN;
+
+		} else if (type == LOG_TOPIC_FORMAT_MSG) {
+			if (pos + LOG_TOPIC_FORMAT_LEN > len) {
+				break;
+			}
+
+			parse_topic_format(&buf[pos]);
+			pos += LOG_TOPIC_FORMAT_LEN;
+
+		} else if (type == LOG_BLOCK_MSG && !in_block) {
+			if (pos + LOG_BLOCK_HEADER_LEN > len) {
+				break;
+			}
+
+			uint16_t raw_len, data_len;
+			memcpy(&raw_len, &buf[pos + 3], sizeof(raw_len));
+			memcpy(&data_len, &buf[pos + 5], sizeof(data_len));
+
+			if (pos + LOG_BLOCK_HEADER_LEN + data_len > len) {
+				break;
+			}
+
+			expand_block(&buf[pos], raw_len, data_len);
+			pos += LOG_BLOCK_HEADER_LEN + data_len;
+
+		} else if (descrs[type] != 0 && descrs[type]->length >= 3) {
+			struct msg_descr_s *d = descrs[type];
+
+			if (pos + d->length > len) {
+				break;
+			}
+
+			if (in_block) {
+				/* bodies are XORed with the previous body of the same type */
+				unsigned body_len = d->length - 3;
+
+				if (d->prev_valid) {
+					for (unsigned i = 0; i < body_len && i < sizeof(d->prev); i++) {
+						buf[pos + 3 + i] ^= d->prev[i];
+					}
+				}
+
+				memcpy(d->prev, &buf[pos + 3], body_len < sizeof(d->prev) ? body_len : sizeof(d->prev));
+				d->prev_valid = true;
+			}
+
+			handle_msg(type, &buf[pos]);
+			pos += d->length;
+
+		} else {
+			pos++;
+			resyncs++;
+		}
+	}
+}
+
+static void
+print_report(uint64_t total_ns, uint64_t log_us)
+{
+	printf("%u state filter\n", n_states);
+	printf("%-14s %8s %10s %10s %12s\n", "step", "count", "mean [us]", "max [us]", "total [ms]");
+
+	uint64_t filter_ns = 0;
+
+	for (unsigned i = 0; i < TIMER_NUM; i++) {
+		struct timer_s *t = &timers[i];
+		printf("%-14s %8u %10.2f %10.2f %12.2f\n", timer_names[i], t->count,
+		       t->count ? t->total_ns / 1e3 / t->count : 0.0, t->max_ns / 1e3, t->total_ns / 1e6);
+		filter_ns += t->total_ns;
+	}
+
+	printf("\nfilter %.2f ms, replay %.2f ms for %.1f s of log", filter_ns / 1e6, total_ns / 1e6, log_us / 1e6);
+
+	if (total_ns > 0) {
+		printf(" (%.0fx real time)", log_us * 1e3 / total_ns);
+	}
+
+	printf("\nfilter resets: %u, resync bytes: %u, gps init: %s\n", filter_resets, resyncs, gps_initialized ? "yes" : "no");
+
+	if (ref_rows == 0) {
+		return;
+	}
+
+	struct ref_error_s *e = &ref_error;
+
+	printf("\nagainst reference, %u of %u steps matched\n", e->count, ref_num);
+
+	if (e->count > 0) {
+		printf("%-14s %12s %12s\n", "error", "rms", "max");
+		printf("%-14s %12.4f %12.4f\n", "attitude [deg]", degrees(sqrt(e->att_sq / e->count)), degrees(e->att_max));
+		printf("%-14s %12.4f %12.4f\n", "velocity [m/s]", sqrt(e->vel_sq / e->count), (double)e->vel_max);
+		printf("%-14s %12.4f %12.4f\n", "position [m]", sqrt(e->pos_sq / e->count), (double)e->pos_max);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("EKF replay test started");
+
+	int ch;
+
+	while ((ch = getopt(argc, argv, "i:a:o:r:")) != -1) {
+		switch (ch) {
+		case 'i':
+			imu_rate = atoi(optarg);
+			break;
+
+		case 'a':
+			fast_att_tc = atof(optarg);
+			break;
+
+		case 'o':
+			out_fp = fopen(optarg, "w");
+
+			if (out_fp == 0) {
+				err(1, "failed opening %s", optarg);
+			}
+
+			fprintf(out_fp, "t,q0,q1,q2,q3,vn,ve,vd,pn,pe,pd\n");
+			break;
+
+		case 'r':
+			load_reference(optarg);
+			break;
+
+		default:
+			errx(1, "usage: ekf_replay_test [-i rate] [-a tc] [-o out.csv] [-r reference.csv] log.bin");
+		}
+	}
+
+	if (optind >= argc) {
+		errx(1, "Need a log file");
+	}
+
+	FILE *fp = fopen(argv[optind], "rb");
+
+	if (!fp) {
+		err(1, "failed opening %s", argv[optind]);
+	}
+
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	uint8_t *buf = (uint8_t *)malloc(size > 0 ? size : 1);
+
+	if (buf == 0 || fread(buf, 1, size, fp) != (size_t)size) {
+		errx(1, "failed reading %s", argv[optind]);
+	}
+
+	fclose(fp);
+
+	ekf = new AttPosEKF();
+
+	uint64_t start = timer_now();
+	parse_stream(buf, size, false);
+
+	uint64_t total_ns = timer_now() - start;
+
+	if (type_imu < 0) {
+		errx(1, "no IMU messages in log");
+	}
+
+	print_report(total_ns, now_us - first_us);
+
+	if (out_fp) {
+		fclose(out_fp);
+	}
+
+	delete ekf;
+	free(buf);
+	free(ref_rows);
+
+	return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file est_buffer_test.cpp
+ *
+ * Checks the estimate history of position_estimator_inav.
+ *
+ * Estimates of a vehicle flying north at constant speed while yawing are
+ * pushed at 250 Hz. The buffer has to keep only one entry per interval,
+ * return the interpolated position and the attitude of any time inside the
+ * history, and clamp to its ends outside of it. The attitude has to survive
+ * the quaternion storage for rotations that take each branch of the
+ * conversion.
+ *
+ * usage: est_buffer_test
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <systemlib/err.h>
+
+#include <position_estimator_inav/est_buffer.h>
+
+#include "test_check.h"
+
+#define DT		4000
+#define SPEED		5.0f
+#define YAW_RATE	0.5f
+
+static void
+rotation(float roll, float pitch, float yaw, float R[3][3])
+{
+	float cp = cosf(pitch), sp = sinf(pitch);
+	float sr = sinf(roll), cr = cosf(roll);
+	float sy = sinf(yaw), cy = cosf(yaw);
+
+	R[0][0] = cp * cy;
+	R[0][1] = (sr * sp * cy) - (cr * sy);
+	R[0][2] = (cr * sp * cy) + (sr * sy);
+	R[1][0] = cp * sy;
+	R[1][1] = (sr * sp * sy) + (cr * cy);
+	R[1][2] = (cr * sp * sy) - (sr * cy);
+	R[2][0] = -sp;
+	R[2][1] = sr * cp;
+	R[2][2] = cr * cp;
+}
+
+static float
+max_diff(float a[3][3], float b[3][3])
+{
+	float d = 0.0f;
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			d = fmaxf(d, fabsf(a[i][j] - b[i][j]));
+		}
+	}
+
+	return d;
+}
+
+/* the estimate at time t */
+static void
+state(uint64_t t, float s_est[3][2], float R[3][3])
+{
+	float s = t * 1e-6f;
+
+	s_est[0][0] = SPEED * s;
+	s_est[0][1] = SPEED;
+	s_est[1][0] = 0.0f;
+	s_est[1][1] = 0.0f;
+	s_est[2][0] = -10.0f;
+	s_est[2][1] = 0.0f;
+	rotation(0.1f, -0.2f, YAW_RATE * s, R);
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("estimate buffer test started");
+
+	static struct est_buffer_s buf;
+	est_buffer_init(&buf);
+
+	float est[3][2];
+	float R[3][3];
+	float R_ref[3][3];
+
+	check(!est_buffer_get(&buf, 0, est, R), "lookup in empty history");
+
+	/* fill more than the history holds */
+	const uint64_t start = 1000000;
+	uint64_t t = start;
+	unsigned stored = 0;
+
+	for (unsigned n = 0; n < 1000; n++) {
+		float s_est[3][2];
+		state(t, s_est, R_ref);
+
+		if (est_buffer_push(&buf, t, s_est, R_ref)) {
+			stored++;
+		}
+
+		t += DT;
+	}
+
+	/* samples fall onto the interval, so every fifth one is kept */
+	uint64_t newest = start + (stored - 1) * EST_BUF_INTERVAL;
+
+	check(stored == 1000 * DT / EST_BUF_INTERVAL, "decimation to the buffer interval");
+	check(buf.count == EST_BUF_SIZE, "history full");
+
+	/* inside the history, between entries */
+	uint64_t t_fix = newest - 210000;
+	check(est_buffer_get(&buf, t_fix, est, R), "lookup");
+	check(fabsf(est[0][0] - SPEED * t_fix * 1e-6f) < 0.001f, "interpolated position");
+	check(fabsf(est[0][1] - SPEED) < 0.001f, "velocity");
+	check(fabsf(est[2][0] + 10.0f) < 0.001f, "altitude");
+
+	/* the attitude is the one of the closer entry, at most half an interval away */
+	float s_est[3][2];
+	state(t_fix, s_est, R_ref);
+	check(max_diff(R, R_ref) < YAW_RATE * EST_BUF_INTERVAL * 1e-6f, "attitude at fix time");
+
+	/* outside the history */
+	est_buffer_get(&buf, newest + 100000, est, R);
+	check(fabsf(est[0][0] - SPEED * newest * 1e-6f) < 0.001f, "clamp to the newest entry");
+	est_buffer_get(&buf, 0, est, R);
+	uint64_t oldest = newest - (EST_BUF_SIZE - 1) * EST_BUF_INTERVAL;
+	check(fabsf(est[0][0] - SPEED * oldest * 1e-6f) < 0.001f, "clamp to the oldest entry");
+
+	/* quaternion round trip for each branch of the conversion */
+	const float angles[][3] = {
+		{0.1f, 0.2f, 0.3f},
+		{3.0f, 0.1f, 0.2f},
+		{0.1f, 3.0f, 0.2f},
+		{0.1f, 0.2f, 3.0f},
+		{-1.5f, 1.2f, -2.8f},
+	};
+
+	for (unsigned i = 0; i < sizeof(angles) / sizeof(angles[0]); i++) {
+		est_buffer_init(&buf);
+		rotation(angles[i][0], angles[i][1], angles[i][2], R_ref);
+		est_buffer_push(&buf, 1000, s_est, R_ref);
+		est_buffer_get(&buf, 1000, est, R);
+
+		char what[40];
+		snprintf(what, sizeof(what), "attitude round trip %u", i);
+		check(max_diff(R, R_ref) < 1e-5f, what);
+	}
+
+	return check_result();
+}
@@ -0,0 +1,86 @@
+/**
+ * @file gain_schedule_test.cpp
+ *
+ * Checks the airspeed gain schedule of the fixed wing rate controllers.
+ *
+ * A table with the roll controller gain laws is built for a wide speed
+ * range airframe. The interpolated gains have to follow the exact scaling
+ * closely over the whole range, be clamped to its ends and fall back to
+ * the trim gains without an airspeed.
+ *
+ * usage: gain_schedule_test
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <systemlib/err.h>
+
+#include <ecl/attitude_fw/ecl_gain_schedule.h>
+
+#include "test_check.h"
+
+#define AIRSPEED_MIN	10.0f
+#define AIRSPEED_TRIM	15.0f
+#define AIRSPEED_MAX	40.0f
+#define K_P		0.08f
+#define K_FF		0.4f
+
+static void
+build(ECL_GainSchedule<2> &schedule, float min, float trim, float max)
+{
+	schedule.set_airspeeds(min, trim, max);
+
+	for (unsigned i = 0; i < ECL_GAIN_SCHEDULE_BINS; i++) {
+		float scaler = schedule.scaler(i);
+		float gains[2] = { K_P * scaler * scaler, K_FF * scaler };
+		schedule.set_gains(i, gains);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	ECL_GainSchedule<2> schedule;
+	float gains[2];
+
+	build(schedule, AIRSPEED_MIN, AIRSPEED_TRIM, AIRSPEED_MAX);
+
+	/* the interpolation error is largest at the low speed end of the table */
+	float max_err = 0.0f;
+
+	for (float v = AIRSPEED_MIN; v <= AIRSPEED_MAX; v += 0.1f) {
+		float scaler = AIRSPEED_TRIM / v;
+		schedule.get_gains(v, gains);
+		max_err = fmaxf(max_err, fabsf(gains[0] / (K_P * scaler * scaler) - 1.0f));
+		max_err = fmaxf(max_err, fabsf(gains[1] / (K_FF * scaler) - 1.0f));
+	}
+
+	printf("largest relative gain error: %.4f\n", (double)max_err);
+	check(max_err < 0.015f, "gains follow the airspeed scaling");
+
+	schedule.get_gains(AIRSPEED_TRIM, gains);
+	check(fabsf(gains[0] - K_P) < 0.002f && fabsf(gains[1] - K_FF) < 0.004f, "trim gains at trim airspeed");
+
+	schedule.get_gains(2.0f, gains);
+	float limit = AIRSPEED_TRIM / AIRSPEED_MIN;
+	check(fabsf(gains[0] - K_P * limit * limit) < 1e-6f, "clamped below minimum airspeed");
+
+	schedule.get_gains(100.0f, gains);
+	limit = AIRSPEED_TRIM / AIRSPEED_MAX;
+	check(fabsf(gains[0] - K_P * limit * limit) < 1e-6f, "clamped above maximum airspeed");
+
+	schedule.get_gains(NAN, gains);
+	check(fabsf(gains[0] - K_P) < 0.002f, "trim gains without an airspeed");
+
+	/* a broken range must not produce non finite gains */
+	build(schedule, AIRSPEED_MIN, AIRSPEED_TRIM, AIRSPEED_MIN);
+	schedule.get_gains(20.0f, gains);
+	limit = AIRSPEED_TRIM / AIRSPEED_MIN;
+	check(fabsf(gains[0] - K_P * limit * limit) < 1e-6f, "empty range uses the minimum airspeed gains");
+
+	build(schedule, 0.0f, 0.0f, 0.0f);
+	schedule.get_gains(20.0f, gains);
+	check(isfinite(gains[0]) && fabsf(gains[0] - K_P) < 1e-6f, "unset airspeeds give unscaled gains");
+
+	return check_result();
+}
@@ -0,0 +1,91 @@
+/**
+ * @file gps_blend_test.cpp
+ *
+ * Checks the blending of two GPS receivers in the gps driver.
+ *
+ * Reports of two receivers with different accuracies are fed to the blend
+ * stage. A receiver without a fix or with an old fix must not change the
+ * output, two good fixes have to be weighted by their accuracy, and a fix
+ * from an earlier epoch has to be moved along with its velocity first.
+ *
+ * usage: gps_blend_test
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <systemlib/err.h>
+#include <drivers/drv_hrt.h>
+
+#include <drivers/gps/gps_blend.h>
+
+#include "test_check.h"
+
+#define LAT		473977420
+#define LON		85455940
+#define ALT		488000
+
+static void
+fix(struct vehicle_gps_position_s &r, hrt_abstime t, int32_t lat, float eph)
+{
+	memset(&r, 0, sizeof(r));
+	r.timestamp_position = t;
+	r.timestamp_velocity = t;
+	r.lat = lat;
+	r.lon = LON;
+	r.alt = ALT;
+	r.fix_type = 3;
+	r.eph = eph;
+	r.epv = 2.0f * eph;
+	r.s_variance_m_s = 0.5f;
+	r.satellites_used = 8;
+	r.vel_ned_valid = true;
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("GPS blend test started");
+
+	GPS_Blend blend;
+	struct vehicle_gps_position_s r0, r1, out;
+	hrt_abstime now = hrt_absolute_time();
+
+	/* one receiver is passed on as it is */
+	fix(r0, now, LAT, 1.0f);
+	check(blend.update(0, r0, out) && out.lat == LAT && out.eph == 1.0f, "single receiver");
+
+	/* a second one without a fix is left out, and doesn't publish */
+	fix(r1, now, LAT + 1000, 1.0f);
+	r1.fix_type = 1;
+	check(!blend.update(1, r1, out), "receiver without fix publishes");
+	check(blend.update(0, r0, out) && out.lat == LAT, "receiver without fix blended");
+
+	/* two good fixes, the more accurate one weighs four times as much */
+	fix(r1, now, LAT + 100, 2.0f);
+	r1.satellites_used = 12;
+	check(blend.update(1, r1, out), "second fix published");
+	check(abs(out.lat - (LAT + 20)) <= 1, "weighted position");
+	check(fabsf(out.eph - 1.0f / sqrtf(1.25f)) < 1e-4f, "combined accuracy");
+	check(out.satellites_used == 12, "satellites");
+
+	/* a fix 100ms older, going north at 10m/s, is a meter behind */
+	fix(r0, now - 100000, LAT, 1.0f);
+	r0.vel_n_m_s = 10.0f;
+	r1.vel_n_m_s = 10.0f;
+	r1.lat = LAT + 90;
+	r1.eph = 1.0f;
+	blend.update(0, r0, out);
+	blend.update(1, r1, out);
+	check(abs(out.lat - (LAT + 90)) <= 1, "older fix moved with its velocity");
+	check(fabsf(out.vel_n_m_s - 10.0f) < 1e-4f, "blended velocity");
+
+	/* a fix older than the timeout is left out */
+	fix(r0, now - 2 * GPS_BLEND_TIMEOUT, LAT - 1000, 0.5f);
+	check(!blend.update(0, r0, out), "old fix publishes");
+	check(blend.update(1, r1, out) && out.lat == r1.lat, "old fix blended");
+
+	return check_result();
+}
@@ -1,16 +1,147 @@
-#include <sys/time.h>
+#include <time.h>
 #include <inttypes.h>
 #include <drivers/drv_hrt.h>
 #include <stdio.h>
 
+#include "hrt_host.h"
+
+static bool sim_clock;
+static hrt_abstime sim_time;
+
+/* pending callouts, not ordered */
+static struct hrt_call *call_list;
+
 hrt_abstime hrt_absolute_time() {
-    struct timeval te; 
-    gettimeofday(&te, NULL); // get current time
-    hrt_abstime us = static_cast<uint64_t>(te.tv_sec) * 1e6 + te.tv_usec; // caculate us
-    return us;
+	if (sim_clock)
+		return sim_time;
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts_to_abstime(&ts);
+}
+
+hrt_abstime ts_to_abstime(struct timespec *ts) {
+	return (hrt_abstime)ts->tv_sec * 1000000 + ts->tv_nsec / 1000;
+}
+
+void abstime_to_ts(struct timespec *ts, hrt_abstime abstime) {
+	ts->tv_sec = abstime / 1000000;
+	ts->tv_nsec = (abstime % 1000000) * 1000;
 }
 
 hrt_abstime hrt_elapsed_time(const volatile hrt_abstime *then) {
 	// not thread safe
-    return hrt_absolute_time() - *then;
+	return hrt_absolute_time() - *then;
+}
+
+hrt_abstime hrt_store_absolute_time(volatile hrt_abstime *now) {
+	hrt_abstime ts = hrt_absolute_time();
+	*now = ts;
+	return ts;
+}
+
+void hrt_host_set_time(hrt_abstime now) {
+	sim_clock = true;
+	sim_time = now;
+}
+
+static void unlink_call(struct hrt_call *entry) {
+	for (struct hrt_call **p = &call_list; *p != NULL; p = (struct hrt_call **)&(*p)->link.flink) {
+		if (*p == entry) {
+			*p = (struct hrt_call *)entry->link.flink;
+			break;
+		}
+	}
+
+	entry->link.flink = NULL;
+}
+
+static void schedule_call(struct hrt_call *entry, hrt_abstime deadline, hrt_abstime interval, hrt_callout callout, void *arg) {
+	unlink_call(entry);
+
+	entry->deadline = deadline;
+	entry->period = interval;
+	entry->callout = callout;
+	entry->arg = arg;
+
+	entry->link.flink = (struct sq_entry_s *)call_list;
+	call_list = entry;
+}
+
+void hrt_call_after(struct hrt_call *entry, hrt_abstime delay, hrt_callout callout, void *arg) {
+	schedule_call(entry, hrt_absolute_time() + delay, 0, callout, arg);
+}
+
+void hrt_call_at(struct hrt_call *entry, hrt_abstime calltime, hrt_callout callout, void *arg) {
+	schedule_call(entry, calltime, 0, callout, arg);
+}
+
+void hrt_call_every(struct hrt_call *entry, hrt_abstime delay, hrt_abstime interval, hrt_callout callout, void *arg) {
+	schedule_call(entry, hrt_absolute_time() + delay, interval, callout, arg);
+}
+
+bool hrt_called(struct hrt_call *entry) {
+	/* the deadline is cleared when a one-shot callout has run, as on the target */
+	return entry->deadline == 0;
+}
+
+void hrt_cancel(struct hrt_call *entry) {
+	unlink_call(entry);
+	entry->deadline = 0;
+	entry->period = 0;
+}
+
+void hrt_call_init(struct hrt_call *entry) {
+	entry->link.flink = NULL;
+	entry->deadline = 0;
+	entry->period = 0;
+	entry->callout = NULL;
+	entry->arg = NULL;
+}
+
+void hrt_call_delay(struct hrt_call *entry, hrt_abstime delay) {
+	entry->deadline = hrt_absolute_time() + delay;
+}
+
+void hrt_init() {
+	call_list = NULL;
+}
+
+unsigned hrt_host_run_calls() {
+	hrt_abstime now = hrt_absolute_time();
+	unsigned count = 0;
+	bool ran;
+
+	/* a callout may schedule or cancel others, so rescan after each one */
+	do {
+		ran = false;
+
+		for (struct hrt_call *call = call_list; call != NULL; call = (struct hrt_call *)call->link.flink) {
+			if (call->deadline > now)
+				continue;
+
+			hrt_callout callout = call->callout;
+			void *arg = call->arg;
+
+			if (call->period != 0) {
+				/* skip the periods that passed while nobody ran the calls */
+				do {
+					call->deadline += call->period;
+				} while (call->deadline <= now);
+
+			} else {
+				unlink_call(call);
+				call->deadline = 0;
+			}
+
+			if (callout != NULL)
+				callout(arg);
+
+			count++;
+			ran = true;
+			break;
+		}
+	} while (ran);
+
+	return count;
 }
@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * @file hrt_host.h
+ *
+ * Host additions to the drv_hrt API of hrt.cpp.
+ *
+ * By default time comes from CLOCK_MONOTONIC. After hrt_host_set_time()
+ * the clock is simulated and only moves when it is set again, which lets
+ * a test run flight code faster than real time. Callouts never run from
+ * an interrupt on the host; hrt_host_run_calls() runs the ones that are
+ * due from the caller's context.
+ */
+
+#include <drivers/drv_hrt.h>
+
+/**
+ * Switch to the simulated clock and set it.
+ *
+ * @param now		New time in microseconds, not before the current one.
+ */
+void	hrt_host_set_time(hrt_abstime now);
+
+/**
+ * Run the callouts whose deadline has passed, periodic ones are rescheduled.
+ *
+ * @return		Number of callouts run.
+ */
+unsigned hrt_host_run_calls(void);
@@ -0,0 +1,87 @@
+/**
+ * @file hrt_test.cpp
+ *
+ * Checks the host hrt used by the other tests.
+ *
+ * The monotonic clock has to move forward, the conversions to and from
+ * timespec have to round trip, and on the simulated clock one-shot and
+ * periodic callouts have to run exactly when they are due, including a
+ * periodic call that falls behind and one that is cancelled.
+ *
+ * usage: hrt_test
+ */
+
+#include <unistd.h>
+#include <stdio.h>
+#include <systemlib/err.h>
+
+#include "hrt_host.h"
+#include "test_check.h"
+
+static void
+count_call(void *arg)
+{
+	(*(unsigned *)arg)++;
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("Host hrt test started");
+
+	hrt_init();
+
+	/* real clock */
+	hrt_abstime start = hrt_absolute_time();
+	usleep(2000);
+	check(hrt_elapsed_time(&start) >= 2000, "monotonic clock");
+
+	struct timespec ts;
+	abstime_to_ts(&ts, 1234567890123ULL);
+	check(ts.tv_sec == 1234567 && ts.tv_nsec == 890123000, "abstime to timespec");
+	check(ts_to_abstime(&ts) == 1234567890123ULL, "timespec round trip");
+
+	/* simulated clock */
+	hrt_host_set_time(1000000);
+	check(hrt_absolute_time() == 1000000, "simulated clock");
+
+	struct hrt_call once, every, cancelled;
+	unsigned once_count = 0, every_count = 0, cancelled_count = 0;
+	hrt_call_init(&once);
+	hrt_call_init(&every);
+	hrt_call_init(&cancelled);
+
+	hrt_call_after(&once, 500, count_call, &once_count);
+	hrt_call_every(&every, 0, 1000, count_call, &every_count);
+	hrt_call_after(&cancelled, 100, count_call, &cancelled_count);
+	check(!hrt_called(&once), "one-shot pending");
+
+	hrt_cancel(&cancelled);
+
+	hrt_host_run_calls();
+	check(every_count == 1 && once_count == 0, "periodic call due at once");
+
+	hrt_host_set_time(1000499);
+	hrt_host_run_calls();
+	check(once_count == 0, "one-shot not early");
+
+	hrt_host_set_time(1000500);
+	hrt_host_run_calls();
+	check(once_count == 1 && hrt_called(&once), "one-shot on time");
+
+	for (hrt_abstime t = 1000500; t <= 1010000; t += 500) {
+		hrt_host_set_time(t);
+		hrt_host_run_calls();
+	}
+
+	check(every_count == 11, "periodic call rate");
+	check(once_count == 1, "one-shot runs once");
+
+	/* falling behind runs the periodic call once, not for every missed period */
+	hrt_host_set_time(1020000);
+	check(hrt_host_run_calls() == 1, "missed periods skipped");
+	check(every.deadline == 1021000, "periodic call rescheduled");
+
+	check(cancelled_count == 0, "cancelled call");
+
+	return check_result();
+}
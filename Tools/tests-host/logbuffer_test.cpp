@@ -0,0 +1,142 @@
+/**
+ * @file logbuffer_test.cpp
+ *
+ * Checks the mavlink text message queue.
+ *
+ * Filled from a single thread, info messages have to stop at three
+ * quarters of the buffer while critical ones still get in, and messages
+ * have to come out in order. Then several writer threads race a reader;
+ * every message has to arrive intact and exactly once, or be counted as
+ * dropped.
+ *
+ * usage: logbuffer_test
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <systemlib/err.h>
+
+#include <mavlink/mavlink_log.h>
+
+#include "test_check.h"
+
+#define SEVERITY_CRITICAL	2
+#define SEVERITY_INFO		6
+
+#define WRITERS			4
+#define MESSAGES		20000
+
+static struct mavlink_logbuffer lb;
+static volatile bool writers_done;
+
+static void *
+writer(void *arg)
+{
+	unsigned id = (unsigned)(unsigned long)arg;
+
+	for (unsigned i = 0; i < MESSAGES; i++) {
+		struct mavlink_logmessage msg;
+		snprintf(msg.text, sizeof(msg.text), "w%u m%u", id, i);
+		msg.severity = (i % 8 == 0) ? SEVERITY_CRITICAL : SEVERITY_INFO;
+
+		while (mavlink_logbuffer_write(&lb, &msg) != 0) {
+			/* count the drop, retry so that every message is checked eventually */
+			usleep(0);
+		}
+	}
+
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("MAVLink log buffer test started");
+
+	struct mavlink_logmessage msg;
+
+	/* severity reserve and order */
+	mavlink_logbuffer_init(&lb, 5);
+	check(lb.size == 8, "size rounded to a power of two");
+	check(mavlink_logbuffer_is_empty(&lb), "empty after init");
+
+	unsigned info_queued = 0;
+
+	for (unsigned i = 0; i < 8; i++) {
+		snprintf(msg.text, sizeof(msg.text), "info %u", i);
+		msg.severity = SEVERITY_INFO;
+		info_queued += (mavlink_logbuffer_write(&lb, &msg) == 0);
+	}
+
+	check(info_queued == 6, "info stops at three quarters");
+
+	msg.severity = SEVERITY_CRITICAL;
+	strcpy(msg.text, "critical");
+	check(mavlink_logbuffer_write(&lb, &msg) == 0, "critical uses the reserve");
+	check(mavlink_logbuffer_write(&lb, &msg) == 0, "critical fills the buffer");
+	check(mavlink_logbuffer_write(&lb, &msg) != 0, "full buffer drops");
+	check(mavlink_logbuffer_is_full(&lb), "full");
+	check(lb.dropped == 3, "drops counted");
+
+	bool in_order = true;
+
+	for (unsigned i = 0; i < 6; i++) {
+		char text[MAVLINK_LOG_MAXLEN + 1];
+		snprintf(text, sizeof(text), "info %u", i);
+		in_order = in_order && (mavlink_logbuffer_read(&lb, &msg) == 0) && !strcmp(msg.text, text);
+	}
+
+	check(in_order, "info messages in order");
+	check(mavlink_logbuffer_read(&lb, &msg) == 0 && msg.severity == SEVERITY_CRITICAL, "critical after info");
+	check(mavlink_logbuffer_read(&lb, &msg) == 0, "second critical");
+	check(mavlink_logbuffer_read(&lb, &msg) != 0 && mavlink_logbuffer_is_empty(&lb), "empty after reading all");
+
+	mavlink_logbuffer_destroy(&lb);
+
+	/* racing writers */
+	mavlink_logbuffer_init(&lb, 16);
+
+	pthread_t threads[WRITERS];
+
+	for (unsigned w = 0; w < WRITERS; w++) {
+		pthread_create(&threads[w], NULL, writer, (void *)(unsigned long)w);
+	}
+
+	unsigned next[WRITERS] = {};
+	unsigned received = 0;
+	bool intact = true;
+
+	while (received < WRITERS * MESSAGES) {
+		if (mavlink_logbuffer_read(&lb, &msg) != 0) {
+			continue;
+		}
+
+		unsigned w, i;
+
+		/* each writer's messages have to arrive in its order, none twice */
+		if (sscanf(msg.text, "w%u m%u", &w, &i) != 2 || w >= WRITERS || i != next[w] ||
+		    msg.severity != ((i % 8 == 0) ? SEVERITY_CRITICAL : SEVERITY_INFO)) {
+			intact = false;
+			break;
+		}
+
+		next[w]++;
+		received++;
+	}
+
+	for (unsigned w = 0; w < WRITERS; w++) {
+		pthread_join(threads[w], NULL);
+	}
+
+	check(intact, "concurrent messages intact and in order");
+	check(received == WRITERS * MESSAGES, "every message received");
+	check(mavlink_logbuffer_is_empty(&lb), "empty after the race");
+
+	warnx("%u messages, %u drops retried", received, lb.dropped);
+
+	mavlink_logbuffer_destroy(&lb);
+
+	return check_result();
+}
@@ -0,0 +1,105 @@
+/**
+ * @file mem_pool_test.cpp
+ *
+ * Checks the fixed-block memory pools.
+ *
+ * Blocks have to come from the pool's chunk until it is exhausted, then
+ * from the heap, and both have to be released to where they came from.
+ * The statistics have to follow, and size classes have to pick the
+ * smallest pool that fits.
+ *
+ * usage: mem_pool_test
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <systemlib/err.h>
+
+#include <systemlib/mem_pool.h>
+
+#include "test_check.h"
+
+#define BLOCKS		8
+
+static bool
+in_pool(const struct mem_pool_s *pool, const void *p)
+{
+	return (const uint8_t *)p >= pool->blocks &&
+	       (const uint8_t *)p < pool->blocks + pool->block_size * pool->block_count;
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("Memory pool test started");
+
+	static struct mem_pool_s pool = MEM_POOL_INITIALIZER("test", 13, BLOCKS);
+	void *blocks[BLOCKS + 2];
+
+	for (unsigned i = 0; i < BLOCKS + 2; i++) {
+		blocks[i] = mem_pool_alloc(&pool);
+		memset(blocks[i], i, 13);
+	}
+
+	check(pool.block_size == 16, "block size aligned");
+
+	bool pooled = true;
+	bool distinct = true;
+
+	for (unsigned i = 0; i < BLOCKS; i++) {
+		pooled = pooled && in_pool(&pool, blocks[i]);
+
+		for (unsigned j = 0; j < i; j++)
+			distinct = distinct && (blocks[i] != blocks[j]);
+	}
+
+	check(pooled, "blocks from the chunk");
+	check(distinct, "blocks distinct");
+	check(!in_pool(&pool, blocks[BLOCKS]) && !in_pool(&pool, blocks[BLOCKS + 1]), "heap when exhausted");
+	check(pool.in_use == BLOCKS && pool.max_in_use == BLOCKS && pool.fallbacks == 2, "statistics when full");
+
+	bool intact = true;
+
+	for (unsigned i = 0; i < BLOCKS + 2; i++) {
+		for (unsigned k = 0; k < 13; k++)
+			intact = intact && (((uint8_t *)blocks[i])[k] == i);
+	}
+
+	check(intact, "blocks do not overlap");
+
+	for (unsigned i = 0; i < BLOCKS + 2; i++)
+		mem_pool_free(&pool, blocks[i]);
+
+	check(pool.in_use == 0 && pool.max_in_use == BLOCKS, "statistics after release");
+
+	/* released blocks are reused */
+	void *again = mem_pool_alloc(&pool);
+	check(in_pool(&pool, again) && pool.fallbacks == 2, "block reused");
+	mem_pool_free(&pool, again);
+	mem_pool_free(&pool, NULL);
+
+	/* size classes */
+	static struct mem_pool_s classes[] = {
+		MEM_POOL_INITIALIZER("small", 32, 4),
+		MEM_POOL_INITIALIZER("large", 128, 4),
+	};
+
+	void *small = mem_pool_alloc_sized(classes, 2, 20);
+	void *large = mem_pool_alloc_sized(classes, 2, 33);
+	void *huge = mem_pool_alloc_sized(classes, 2, 500);
+
+	check(in_pool(&classes[0], small), "small class");
+	check(in_pool(&classes[1], large), "large class");
+	check(!in_pool(&classes[0], huge) && !in_pool(&classes[1], huge), "larger than all classes");
+
+	mem_pool_free_sized(classes, 2, small);
+	mem_pool_free_sized(classes, 2, large);
+	mem_pool_free_sized(classes, 2, huge);
+	check(classes[0].in_use == 0 && classes[1].in_use == 0, "size classes released");
+
+	mem_pool_print_all(1);
+
+	return check_result();
+}
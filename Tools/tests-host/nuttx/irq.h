@@ -0,0 +1,7 @@
+#pragma once
+
+/* the host tests run single threaded where interrupts are masked on the target */
+typedef unsigned irqstate_t;
+
+static inline irqstate_t irqsave(void) { return 0; }
+static inline void irqrestore(irqstate_t flags) { (void)flags; }
@@ -0,0 +1,237 @@
+/**
+ * @file rc_decode_test.cpp
+ *
+ * Checks and times the shared RC channel decoding in lib/rc.
+ *
+ * Random S.BUS and ST24 channel data is decoded with the table-driven
+ * unpacking and integer scaling, and compared against the per-channel
+ * bit picking and floating point scaling the decoders used before.
+ * Both are then timed over many frames, so the decode cost can be
+ * followed from change to change.
+ *
+ * usage: rc_decode_test [frames]
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <systemlib/err.h>
+#include <rc/rc_decode.h>
+
+#define SBUS_CHANNELS		16
+#define ST24_CHANNELS		24
+
+/* the scaling of px4iofirmware/sbus.c and lib/rc/st24.c */
+#define SBUS_SCALE_FACTOR	((2000.0f - 1000.0f) / (1800.0f - 200.0f))
+#define SBUS_SCALE_OFFSET	(int)(1000.0f - (SBUS_SCALE_FACTOR * 200.0f + 0.5f))
+#define ST24_SCALE_FACTOR	((2000.0f - 1000.0f) / (4096.0f - 0.0f))
+#define ST24_SCALE_OFFSET	(int)(1000.0f - (ST24_SCALE_FACTOR * 0.0f + 0.5f))
+
+/* the previous S.BUS decoder matrix: byte, right shift, mask, left shift */
+struct sbus_bit_pick {
+	uint8_t byte;
+	uint8_t rshift;
+	uint8_t mask;
+	uint8_t lshift;
+};
+
+static const struct sbus_bit_pick sbus_decoder[SBUS_CHANNELS][3] = {
+	/*  0 */ { { 0, 0, 0xff, 0}, { 1, 0, 0x07, 8}, { 0, 0, 0x00,  0} },
+	/*  1 */ { { 1, 3, 0x1f, 0}, { 2, 0, 0x3f, 5}, { 0, 0, 0x00,  0} },
+	/*  2 */ { { 2, 6, 0x03, 0}, { 3, 0, 0xff, 2}, { 4, 0, 0x01, 10} },
+	/*  3 */ { { 4, 1, 0x7f, 0}, { 5, 0, 0x0f, 7}, { 0, 0, 0x00,  0} },
+	/*  4 */ { { 5, 4, 0x0f, 0}, { 6, 0, 0x7f, 4}, { 0, 0, 0x00,  0} },
+	/*  5 */ { { 6, 7, 0x01, 0}, { 7, 0, 0xff, 1}, { 8, 0, 0x03,  9} },
+	/*  6 */ { { 8, 2, 0x3f, 0}, { 9, 0, 0x1f, 6}, { 0, 0, 0x00,  0} },
+	/*  7 */ { { 9, 5, 0x07, 0}, {10, 0, 0xff, 3}, { 0, 0, 0x00,  0} },
+	/*  8 */ { {11, 0, 0xff, 0}, {12, 0, 0x07, 8}, { 0, 0, 0x00,  0} },
+	/*  9 */ { {12, 3, 0x1f, 0}, {13, 0, 0x3f, 5}, { 0, 0, 0x00,  0} },
+	/* 10 */ { {13, 6, 0x03, 0}, {14, 0, 0xff, 2}, {15, 0, 0x01, 10} },
+	/* 11 */ { {15, 1, 0x7f, 0}, {16, 0, 0x0f, 7}, { 0, 0, 0x00,  0} },
+	/* 12 */ { {16, 4, 0x0f, 0}, {17, 0, 0x7f, 4}, { 0, 0, 0x00,  0} },
+	/* 13 */ { {17, 7, 0x01, 0}, {18, 0, 0xff, 1}, {19, 0, 0x03,  9} },
+	/* 14 */ { {19, 2, 0x3f, 0}, {20, 0, 0x1f, 6}, { 0, 0, 0x00,  0} },
+	/* 15 */ { {20, 5, 0x07, 0}, {21, 0, 0xff, 3}, { 0, 0, 0x00,  0} }
+};
+
+static void
+sbus_reference(const uint8_t *data, uint16_t *values)
+{
+	for (unsigned channel = 0; channel < SBUS_CHANNELS; channel++) {
+		unsigned value = 0;
+
+		for (unsigned pick = 0; pick < 3; pick++) {
+			const struct sbus_bit_pick *decode = &sbus_decoder[channel][pick];
+
+			if (decode->mask != 0) {
+				unsigned piece = data[decode->byte];
+				piece >>= decode->rshift;
+				piece &= decode->mask;
+				piece <<= decode->lshift;
+
+				value |= piece;
+			}
+		}
+
+		values[channel] = (uint16_t)(value * SBUS_SCALE_FACTOR + .5f) + SBUS_SCALE_OFFSET;
+	}
+}
+
+static void
+sbus_table(const uint8_t *data, uint16_t *values)
+{
+	rc_unpack_sbus(data, values, SBUS_CHANNELS);
+	rc_scale_channels(values, SBUS_CHANNELS, 5, 3, SBUS_SCALE_OFFSET);
+}
+
+static void
+st24_reference(const uint8_t *data, uint16_t *values)
+{
+	unsigned chan_index = 0;
+
+	for (unsigned i = 0; i < (ST24_CHANNELS * 3) / 2; i += 3) {
+		values[chan_index] = ((uint16_t)data[i] << 4);
+		values[chan_index] |= ((uint16_t)(0xF0 & data[i + 1]) >> 4);
+		values[chan_index] = (uint16_t)(values[chan_index] * ST24_SCALE_FACTOR + .5f) + ST24_SCALE_OFFSET;
+		chan_index++;
+
+		values[chan_index] = ((uint16_t)data[i + 2]);
+		values[chan_index] |= (((uint16_t)(0x0F & data[i + 1])) << 8);
+		values[chan_index] = (uint16_t)(values[chan_index] * ST24_SCALE_FACTOR + .5f) + ST24_SCALE_OFFSET;
+		chan_index++;
+	}
+}
+
+static void
+st24_table(const uint8_t *data, uint16_t *values)
+{
+	rc_unpack_12bit(data, values, ST24_CHANNELS);
+	rc_scale_channels(values, ST24_CHANNELS, 125, 9, ST24_SCALE_OFFSET);
+}
+
+static double
+now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+typedef void (*decoder_t)(const uint8_t *data, uint16_t *values);
+
+/** decode time per frame in ns, over a set of frames */
+static double
+bench(decoder_t decode, const uint8_t *frames, unsigned frame_len, unsigned count, unsigned &check)
+{
+	uint16_t values[ST24_CHANNELS];
+	double start = now_ns();
+
+	for (unsigned i = 0; i < count; i++) {
+		decode(&frames[(i % 256) * frame_len], values);
+		/* keep the results alive */
+		check += values[i % 8];
+	}
+
+	return (now_ns() - start) / count;
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("RC decode test started");
+
+	unsigned count = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 1000000;
+	unsigned failed = 0;
+
+	/* S.BUS: 22 data bytes plus the flags byte the last channel may touch */
+	static uint8_t sbus_frames[256][23];
+	static uint8_t st24_frames[256][36];
+
+	srand(1);
+
+	for (unsigned i = 0; i < 256; i++) {
+		for (unsigned j = 0; j < sizeof(sbus_frames[i]); j++)
+			sbus_frames[i][j] = rand();
+
+		for (unsigned j = 0; j < sizeof(st24_frames[i]); j++)
+			st24_frames[i][j] = rand();
+	}
+
+	/* all ones and all zeros hit the ends of the ranges */
+	memset(sbus_frames[0], 0xff, sizeof(sbus_frames[0]));
+	memset(sbus_frames[1], 0x00, sizeof(sbus_frames[1]));
+	memset(st24_frames[0], 0xff, sizeof(st24_frames[0]));
+	memset(st24_frames[1], 0x00, sizeof(st24_frames[1]));
+
+	for (unsigned i = 0; i < 256; i++) {
+		uint16_t expect[ST24_CHANNELS], got[ST24_CHANNELS];
+
+		sbus_reference(sbus_frames[i], expect);
+		sbus_table(sbus_frames[i], got);
+
+		if (memcmp(expect, got, SBUS_CHANNELS * sizeof(got[0])) != 0) {
+			warnx("FAILED: S.BUS frame %u", i);
+			failed++;
+		}
+
+		st24_reference(st24_frames[i], expect);
+		st24_table(st24_frames[i], got);
+
+		if (memcmp(expect, got, ST24_CHANNELS * sizeof(got[0])) != 0) {
+			warnx("FAILED: ST24 frame %u", i);
+			failed++;
+		}
+	}
+
+	/* every raw value scales like the floating point version */
+	for (unsigned raw = 0; raw < 4096; raw++) {
+		uint16_t v = raw;
+
+		rc_scale_channels(&v, 1, 5, 3, SBUS_SCALE_OFFSET);
+
+		if (raw < 2048 && v != (uint16_t)((uint16_t)(raw * SBUS_SCALE_FACTOR + .5f) + SBUS_SCALE_OFFSET)) {
+			warnx("FAILED: S.BUS scaling of %u", raw);
+			failed++;
+		}
+
+		v = raw;
+		rc_scale_channels(&v, 1, 125, 9, ST24_SCALE_OFFSET);
+
+		if (v != (uint16_t)((uint16_t)(raw * ST24_SCALE_FACTOR + .5f) + ST24_SCALE_OFFSET)) {
+			warnx("FAILED: ST24 scaling of %u", raw);
+			failed++;
+		}
+	}
+
+	/* odd channel counts only touch their own values */
+	uint16_t odd[4] = { 0, 0, 0, 0xbeef };
+	rc_unpack_12bit(st24_frames[0], odd, 3);
+
+	if (odd[2] != 0xfff || odd[3] != 0xbeef) {
+		warnx("FAILED: odd channel count");
+		failed++;
+	}
+
+	if (failed > 0) {
+		warnx("FAILED: %u checks", failed);
+		return 1;
+	}
+
+	unsigned check = 0;
+
+	double sbus_ref = bench(sbus_reference, &sbus_frames[0][0], sizeof(sbus_frames[0]), count, check);
+	double sbus_tab = bench(sbus_table, &sbus_frames[0][0], sizeof(sbus_frames[0]), count, check);
+	double st24_ref = bench(st24_reference, &st24_frames[0][0], sizeof(st24_frames[0]), count, check);
+	double st24_tab = bench(st24_table, &st24_frames[0][0], sizeof(st24_frames[0]), count, check);
+
+	warnx("S.BUS frame: %.1f ns bit picking, float scaling; %.1f ns table, integer scaling",
+	      sbus_ref, sbus_tab);
+	warnx("ST24 frame:  %.1f ns stride loop, float scaling; %.1f ns table, integer scaling",
+	      st24_ref, st24_tab);
+	warnx("(checksum %u)", check);
+
+	warnx("test finished");
+
+	return 0;
+}
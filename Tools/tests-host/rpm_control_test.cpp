@@ -0,0 +1,82 @@
+/**
+ * @file rpm_control_test.cpp
+ *
+ * Runs the motor speed loop against a simple motor model.
+ *
+ * The modelled motor reaches a speed proportional to its throttle and the
+ * battery voltage, with a first order lag. The loop has to hold the speed
+ * that linearizes the demanded thrust through a voltage drop, leave the
+ * outputs that are not motors alone, and fall back to the feed-forward
+ * when the telemetry stops.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <systemlib/err.h>
+
+#include <systemlib/rpm_control/rpm_control.h>
+
+#define RPM_MAX			10000.0f
+#define OUTPUT_INTERVAL_US	2500
+#define NUM_STEPS		2000
+
+int main(int argc, char *argv[])
+{
+	warnx("rpm control test started");
+
+	rpm_control_t rc;
+	rpm_control_init(&rc, 0x1, RPM_MAX, 0.5f, 5.0f);
+
+	float speed = 0.0f;
+	uint64_t now = 0;
+	float out[2];
+
+	/* half thrust on the motor, the second output is a servo */
+	for (unsigned n = 0; n < NUM_STEPS; n++) {
+		now += OUTPUT_INTERVAL_US;
+		out[0] = 0.0f;
+		out[1] = 0.3f;
+
+		int32_t rpm[2] = {(int32_t)speed, 1234};
+		rpm_control_update(&rc, out, 2, rpm, 2, now - 1000, now);
+
+		if (out[1] != 0.3f) {
+			errx(1, "FAILED: servo output changed to %.3f", (double)out[1]);
+		}
+
+		/* the battery sags by 15% half way through */
+		float voltage = (n < NUM_STEPS / 2) ? 1.0f : 0.85f;
+		speed += (RPM_MAX * (out[0] + 1.0f) * 0.5f * voltage - speed) * 0.1f;
+	}
+
+	float target = RPM_MAX * sqrtf(0.5f);
+
+	if (fabsf(speed - target) > 0.005f * RPM_MAX) {
+		errx(1, "FAILED: speed %.0f after a voltage drop, expected %.0f", (double)speed, (double)target);
+	}
+
+	warnx("speed %.0f for a target of %.0f", (double)speed, (double)target);
+
+	/* stale telemetry: just the feed-forward */
+	out[0] = 0.0f;
+	int32_t rpm[1] = {(int32_t)speed};
+	rpm_control_update(&rc, out, 1, rpm, 1, now - RPM_CONTROL_TIMEOUT_US, now + 1);
+
+	if (fabsf(out[0] - (2.0f * sqrtf(0.5f) - 1.0f)) > 1e-6f || rc.integral[0] != 0.0f) {
+		errx(1, "FAILED: output %.3f without telemetry", (double)out[0]);
+	}
+
+	/* idle stays idle */
+	out[0] = -1.0f;
+	rpm_control_update(&rc, out, 1, rpm, 1, now, now);
+
+	if (out[0] != -1.0f) {
+		errx(1, "FAILED: idle output %.3f", (double)out[0]);
+	}
+
+	warnx("test finished");
+
+	return 0;
+}
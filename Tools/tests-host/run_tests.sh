@@ -3,4 +3,17 @@
 make clean
 make all
 ./mixer_test
-./sbus2_test ../../../../data/sbus2/sbus2_r7008SB_gps_baro_tx_off.txt
\ No newline at end of file
+./sbus2_test ../../../../data/sbus2/sbus2_r7008SB_gps_baro_tx_off.txt
+./ekf_covariance_test data/ekf_covariance_prediction.txt
+./attitude_ekf_test data/attitude_ekf_reference.txt
+./rpm_control_test
+./terrain_test
+./sensor_voter_test
+./gps_blend_test
+./est_buffer_test
+./gain_schedule_test
+./hrt_test
+./logbuffer_test
+./mem_pool_test
+./containers_test
+./rc_decode_test
@@ -0,0 +1,156 @@
+/**
+ * @file sensor_voter_test.cpp
+ *
+ * Checks the IMU instance selection of the sensors app.
+ *
+ * Three simulated gyros at 250 Hz with different noise levels are fed to
+ * the voter. The quietest one has to be used, and the selection has to move
+ * on when it times out, repeats its value or drifts away from the other two,
+ * without switching back and forth between two similar sensors.
+ *
+ * usage: sensor_voter_test
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <systemlib/err.h>
+
+#include <sensors/sensor_voter.h>
+
+#include "test_check.h"
+
+#define DT		4000
+#define TIMEOUT		20000
+#define MAX_DEVIATION	0.3f
+
+static uint32_t rand_state = 4711u;
+
+/* uniform in [-1, 1) */
+static float
+rand_unit()
+{
+	rand_state = rand_state * 1664525u + 1013904223u;
+	return (float)(rand_state >> 8) / (float)(1 << 23) - 1.0f;
+}
+
+struct gyro {
+	float noise;
+	float bias;
+	bool running;
+	bool stuck;
+	uint64_t errors;
+	float value[3];
+};
+
+static uint64_t now;
+
+static void
+run(SensorVoter &voter, struct gyro g[3], unsigned steps)
+{
+	for (unsigned n = 0; n < steps; n++) {
+		now += DT;
+
+		for (unsigned i = 0; i < 3; i++) {
+			if (!g[i].running) {
+				continue;
+			}
+
+			if (!g[i].stuck) {
+				for (unsigned j = 0; j < 3; j++) {
+					g[i].value[j] = 0.1f * sinf(now * 1e-6f) + g[i].bias + g[i].noise * rand_unit();
+				}
+			}
+
+			voter.put(i, now, g[i].value, g[i].errors);
+		}
+
+		voter.update(now);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("sensor voter test started");
+
+	SensorVoter voter(TIMEOUT, MAX_DEVIATION);
+	struct gyro g[3];
+	memset(g, 0, sizeof(g));
+
+	check(voter.update(0) == -1, "selection without samples");
+
+	g[0].noise = 0.01f;
+	g[1].noise = 0.05f;
+	g[2].noise = 0.03f;
+
+	/* the first to report is used right away, the quietest once the scores settle */
+	g[1].running = true;
+	run(voter, g, 1);
+	check(voter.selected() == 1, "first instance to report");
+
+	g[0].running = g[2].running = true;
+	run(voter, g, 500);
+	check(voter.selected() == 0, "quietest instance");
+	check(voter.healthy() == 7, "all healthy");
+
+	/* a sensor that stops */
+	g[0].running = false;
+	run(voter, g, 10);
+	check(voter.selected() == 2, "failover on timeout");
+	check(!(voter.healthy() & 1), "timed out instance healthy");
+
+	/* and comes back, the remaining one is still fine */
+	g[0].running = true;
+	run(voter, g, 500);
+	check(voter.healthy() == 7, "recovered instance healthy");
+
+	/* a sensor that repeats its last value */
+	unsigned before = voter.failovers();
+	g[voter.selected()].stuck = true;
+	run(voter, g, 100);
+	check(voter.failovers() == before + 1 && !g[voter.selected()].stuck, "failover on stuck value");
+
+	for (unsigned i = 0; i < 3; i++) {
+		g[i].stuck = false;
+	}
+
+	run(voter, g, 500);
+	check(voter.healthy() == 7, "unstuck instance healthy");
+
+	/* a sensor that drifts off, but stays quiet */
+	g[0].bias = 1.0f;
+	run(voter, g, 500);
+	check(!(voter.healthy() & 1) && voter.selected() != 0, "outlier excluded");
+
+	g[0].bias = 0.0f;
+	run(voter, g, 500);
+	check(voter.healthy() == 7, "outlier back");
+
+	/* driver errors on the best sensor */
+	g[0].noise = g[2].noise = 0.02f;
+	run(voter, g, 500);
+	int clean = voter.selected();
+	g[clean].errors = 0;
+
+	for (unsigned n = 0; n < 500; n++) {
+		g[clean].errors++;
+		run(voter, g, 1);
+	}
+
+	check(voter.selected() != clean, "failover on driver errors");
+
+	/* two equal sensors must not make it switch around */
+	g[0].errors = g[1].errors = g[2].errors = 0;
+	g[1].running = false;
+	run(voter, g, 500);
+	before = voter.failovers();
+	run(voter, g, 5000);
+	check(voter.failovers() <= before + 1, "switching between equal instances");
+
+	voter.print_status("gyro");
+
+	return check_result();
+}
@@ -0,0 +1,210 @@
+/**
+ * @file terrain_test.cpp
+ *
+ * Checks the terrain tile cache against a generated terrain file.
+ *
+ * The file holds a plane sloping north and east, so the interpolated height
+ * of any point is known exactly, with one sample left without data. Queries
+ * must miss until terrain_update() has read the tile, then match the plane,
+ * across tile edges as well. Reading more tiles than the cache holds must
+ * drop the least recently used one.
+ *
+ * usage: terrain_test
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <systemlib/err.h>
+
+#include <terrain/terrain.h>
+
+#define TEST_FILENAME	"terrain_test.dat"
+#define TILES_LAT	3
+#define TILES_LON	4
+#define SAMPLES_LAT	(TILES_LAT * TERRAIN_TILE_CELLS + 1)
+#define SAMPLES_LON	(TILES_LON * TERRAIN_TILE_CELLS + 1)
+
+static const int32_t lat_origin = 473000000;
+static const int32_t lon_origin = 85000000;
+static const uint32_t spacing = 8333;		/* 3 arc seconds */
+
+/* the generated plane, in samples from the south west corner */
+static float
+plane(double n, double e)
+{
+	return 400.0 + 2.0 * n + 3.0 * e;
+}
+
+static double
+lat_of(double n)
+{
+	return (lat_origin + n * spacing) * 1e-7;
+}
+
+static double
+lon_of(double e)
+{
+	return (lon_origin + e * spacing) * 1e-7;
+}
+
+static void
+write_file()
+{
+	FILE *fp = fopen(TEST_FILENAME, "wb");
+
+	if (fp == NULL) {
+		err(1, "%s", TEST_FILENAME);
+	}
+
+	struct terrain_file_header header;
+	memcpy(header.magic, TERRAIN_MAGIC, sizeof(header.magic));
+	header.lat_origin = lat_origin;
+	header.lon_origin = lon_origin;
+	header.spacing = spacing;
+	header.tiles_lat = TILES_LAT;
+	header.tiles_lon = TILES_LON;
+	header.tile_samples = TERRAIN_TILE_SAMPLES;
+	header.reserved = 0;
+	fwrite(&header, sizeof(header), 1, fp);
+
+	for (unsigned tn = 0; tn < TILES_LAT; tn++) {
+		for (unsigned te = 0; te < TILES_LON; te++) {
+			int16_t tile[TERRAIN_TILE_SAMPLES][TERRAIN_TILE_SAMPLES];
+
+			for (unsigned i = 0; i < TERRAIN_TILE_SAMPLES; i++) {
+				for (unsigned j = 0; j < TERRAIN_TILE_SAMPLES; j++) {
+					unsigned n = tn * TERRAIN_TILE_CELLS + i;
+					unsigned e = te * TERRAIN_TILE_CELLS + j;
+					tile[i][j] = (n == 40 && e == 40) ? TERRAIN_NO_DATA : (int16_t)plane(n, e);
+				}
+			}
+
+			fwrite(tile, sizeof(tile), 1, fp);
+		}
+	}
+
+	fclose(fp);
+}
+
+/* height after reading whatever the query queued */
+static bool
+height(struct terrain_s *t, double n, double e, float *h)
+{
+	if (terrain_height(t, lat_of(n), lon_of(e), h)) {
+		return true;
+	}
+
+	while (terrain_update(t)) {
+	}
+
+	return terrain_height(t, lat_of(n), lon_of(e), h);
+}
+
+int main(int argc, char *argv[])
+{
+	warnx("terrain test started");
+
+	write_file();
+
+	struct terrain_s *t = (struct terrain_s *)malloc(sizeof(struct terrain_s));
+	unsigned failed = 0;
+	float h;
+
+	if (terrain_open(t, "terrain_test_missing.dat") == 0 || terrain_valid(t)) {
+		warnx("opened a missing file");
+		failed++;
+	}
+
+	if (terrain_open(t, TEST_FILENAME) != 0) {
+		errx(1, "could not open %s", TEST_FILENAME);
+	}
+
+	/* nothing cached yet, the query only queues the tile */
+	if (terrain_height(t, lat_of(5.5), lon_of(5.5), &h) || t->loads != 0 || t->queued != 1) {
+		warnx("first query did not miss");
+		failed++;
+	}
+
+	/* a grid over the whole file, tile edges included */
+	float max_error = 0.0f;
+
+	for (double n = 0.25; n < SAMPLES_LAT - 1; n += 1.5) {
+		for (double e = 0.25; e < SAMPLES_LON - 1; e += 1.5) {
+			if (fabs(n - 40) < 1 && fabs(e - 40) < 1) {
+				continue;
+			}
+
+			if (!height(t, n, e, &h)) {
+				warnx("no height at %.2f %.2f", n, e);
+				failed++;
+				continue;
+			}
+
+			float error = fabsf(h - plane(n, e));
+
+			if (error > max_error) {
+				max_error = error;
+			}
+
+			if (error > 0.01f) {
+				warnx("height at %.2f %.2f: %.3f, expected %.3f", n, e, (double)h, (double)plane(n, e));
+				failed++;
+			}
+		}
+	}
+
+	/* the sample without data must not be interpolated */
+	if (height(t, 39.5, 39.5, &h) || height(t, 40.5, 40.5, &h)) {
+		warnx("height next to a void");
+		failed++;
+	}
+
+	/* outside the file */
+	if (terrain_height(t, lat_of(-1), lon_of(5), &h) || terrain_height(t, lat_of(5), lon_of(SAMPLES_LON + 1), &h)) {
+		warnx("height outside the file");
+		failed++;
+	}
+
+	/* all 12 tiles went through the cache of 8, the oldest are gone */
+	if (t->loads <= TERRAIN_CACHE_TILES) {
+		warnx("only %u tiles read", t->loads);
+		failed++;
+	}
+
+	/* the leg prefetch queues, the update reads one tile per call */
+	terrain_close(t);
+	terrain_open(t, TEST_FILENAME);
+	terrain_prefetch_leg(t, lat_of(1), lon_of(1), lat_of(1), lon_of(SAMPLES_LON - 2));
+
+	if (t->queued != TILES_LON || !terrain_update(t) || t->loads != 1) {
+		warnx("leg prefetch queued %u tiles", t->queued);
+		failed++;
+	}
+
+	while (terrain_update(t)) {
+	}
+
+	if (!terrain_height(t, lat_of(1), lon_of(SAMPLES_LON - 2), &h) || t->misses != 0) {
+		warnx("prefetched tile not cached");
+		failed++;
+	}
+
+	terrain_close(t);
+	free(t);
+	unlink(TEST_FILENAME);
+
+	warnx("max error %.3g m", (double)max_error);
+
+	if (failed > 0) {
+		warnx("FAILED: %u checks", failed);
+		return 1;
+	}
+
+	warnx("test finished");
+
+	return 0;
+}
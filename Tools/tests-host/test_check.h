@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+ * @file test_check.h
+ *
+ * Checks for the host tests. A failed check is reported and counted, so a
+ * test runs all of its checks and fails at the end.
+ */
+
+#include <systemlib/err.h>
+
+static unsigned check_failed;
+
+static inline void
+check(bool ok, const char *what)
+{
+	if (!ok) {
+		warnx("FAILED: %s", what);
+		check_failed++;
+	}
+}
+
+/**
+ * Report the outcome of the checks.
+ *
+ * @return		Exit code for main, 1 if any check failed.
+ */
+static inline int
+check_result(void)
+{
+	if (check_failed > 0) {
+		warnx("FAILED: %u checks", check_failed);
+		return 1;
+	}
+
+	warnx("test finished");
+
+	return 0;
+}
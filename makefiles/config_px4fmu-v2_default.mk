@@ -26,6 +26,7 @@ MODULES		+= drivers/lsm303d
 MODULES		+= drivers/l3gd20
 MODULES		+= drivers/hmc5883
 MODULES		+= drivers/ms5611
+MODULES		+= drivers/rangefinder
 MODULES		+= drivers/mb12xx
 MODULES		+= drivers/sf0x
 MODULES		+= drivers/ll40ls
@@ -56,12 +57,16 @@ MODULES		+= systemcmds/boardinfo
 MODULES		+= systemcmds/mixer
 MODULES		+= systemcmds/param
 MODULES		+= systemcmds/perf
+MODULES		+= systemcmds/work_queue
 MODULES		+= systemcmds/preflight_check
 MODULES		+= systemcmds/pwm
 MODULES		+= systemcmds/esc_calib
 MODULES		+= systemcmds/reboot
 MODULES		+= systemcmds/top
+MODULES		+= systemcmds/sysperf
+MODULES		+= systemcmds/schedtrace
 MODULES		+= systemcmds/tests
+MODULES		+= systemcmds/bench
 MODULES		+= systemcmds/config
 MODULES		+= systemcmds/nshterm
 MODULES		+= systemcmds/mtd
@@ -76,6 +81,8 @@ MODULES		+= modules/navigator
 MODULES		+= modules/mavlink
 MODULES		+= modules/gpio_led
 MODULES		+= modules/uavcan
+# uORB topic mirror for a companion computer, uses a serial port
+#MODULES		+= modules/uorb_bridge
 
 #
 # Estimation modules (EKF/ SO3 / other filters)
@@ -125,6 +132,7 @@ MODULES		+= lib/ecl
 MODULES		+= lib/external_lgpl
 MODULES		+= lib/geo
 MODULES		+= lib/geo_lookup
+MODULES		+= lib/terrain
 MODULES		+= lib/conversion
 MODULES		+= lib/launchdetection
 
@@ -26,6 +26,7 @@ MODULES		+= drivers/lsm303d
 MODULES		+= drivers/l3gd20
 MODULES		+= drivers/hmc5883
 MODULES		+= drivers/ms5611
+MODULES		+= drivers/rangefinder
 MODULES		+= drivers/mb12xx
 MODULES		+= drivers/sf0x
 MODULES		+= drivers/ll40ls
@@ -61,6 +62,7 @@ MODULES		+= systemcmds/pwm
 MODULES		+= systemcmds/esc_calib
 MODULES		+= systemcmds/reboot
 MODULES		+= systemcmds/top
+MODULES		+= systemcmds/sysperf
 MODULES		+= systemcmds/tests
 MODULES		+= systemcmds/config
 MODULES		+= systemcmds/nshterm
@@ -130,6 +132,7 @@ MODULES		+= lib/ecl
 MODULES		+= lib/external_lgpl
 MODULES		+= lib/geo
 MODULES		+= lib/geo_lookup
+MODULES		+= lib/terrain
 MODULES		+= lib/conversion
 MODULES		+= lib/launchdetection
 
@@ -37,6 +37,8 @@ MODULES		+= systemcmds/ver
 # Testing modules
 #
 MODULES		+= examples/matlab_csv_serial
+# uORB topic mirror for a companion computer, start it by hand on a free serial port
+MODULES		+= modules/uorb_bridge
 
 #
 # Library modules
@@ -358,6 +358,9 @@ LINK_DEPS		+= $(ROMFS_OBJ)
 # Remove all comments from startup and mixer files
 ROMFS_PRUNER	 = $(PX4_BASE)/Tools/px_romfs_pruner.py
 
+# Generate binary mixers next to the text ones
+ROMFS_MIXER_BIN	 = $(PX4_BASE)/Tools/px_mixer_bin.py
+
 # Turn the ROMFS image into an object file
 $(ROMFS_OBJ): $(ROMFS_IMG) $(GLOBAL_DEPS)
 	$(call BIN_TO_OBJ,$<,$@,romfs_img)
@@ -378,6 +381,7 @@ ifneq ($(ROMFS_EXTRA_FILES),)
 	$(Q) $(COPY) $(ROMFS_EXTRA_FILES) $(ROMFS_SCRATCH)/extras
 endif
 	$(Q) $(PYTHON) -u $(ROMFS_PRUNER) --folder $(ROMFS_SCRATCH)
+	$(Q) $(PYTHON) -u $(ROMFS_MIXER_BIN) --folder $(ROMFS_SCRATCH)
 
 EXTRA_CLEANS		+= $(ROMGS_OBJ) $(ROMFS_IMG)
 
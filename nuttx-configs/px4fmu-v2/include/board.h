@@ -188,11 +188,15 @@
  * is we set aside more DMA channels/streams.
  *
  * SDIO DMA
- *   DMAMAP_SDIO_1 = Channel 4, Stream 3 <- may later be used by SPI DMA
+ *   DMAMAP_SDIO_1 = Channel 4, Stream 3 <- used by SPI1 TX DMA
  *   DMAMAP_SDIO_2 = Channel 4, Stream 6
+ *
+ * SPI1 DMA (asynchronous sensor transfers)
+ *   DMAMAP_SPI1_RX_1 = Channel 3, Stream 0
+ *   DMAMAP_SPI1_TX_1 = Channel 3, Stream 3
  */
 
-#define DMAMAP_SDIO DMAMAP_SDIO_1
+#define DMAMAP_SDIO DMAMAP_SDIO_2
 
 /* Alternate function pin selections ************************************************/
 
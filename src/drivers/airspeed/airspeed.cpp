@@ -61,6 +61,7 @@
 
 #include <arch/board/board.h>
 
+#include <systemlib/work_profile.h>
 #include <systemlib/airspeed.h>
 #include <systemlib/err.h>
 #include <systemlib/param/param.h>
@@ -344,7 +345,7 @@ Airspeed::start()
 	_reports->flush();
 
 	/* schedule a cycle to start things */
-	work_queue(HPWORK, &_work, (worker_t)&Airspeed::cycle_trampoline, this, 1);
+	work_queue_profiled(HPWORK, &_work, (worker_t)&Airspeed::cycle_trampoline, this, 1, "airspeed");
 }
 
 void
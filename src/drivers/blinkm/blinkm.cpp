@@ -108,6 +108,7 @@
 
 #include <nuttx/wqueue.h>
 
+#include <systemlib/work_profile.h>
 #include <systemlib/perf_counter.h>
 #include <systemlib/err.h>
 #include <systemlib/systemlib.h>
@@ -334,7 +335,7 @@ BlinkM::setMode(int mode)
 			stop_script();
 			set_rgb(0,0,0);
 			systemstate_run = true;
-			work_queue(LPWORK, &_work, (worker_t)&BlinkM::led_trampoline, this, 1);
+			work_queue_profiled(LPWORK, &_work, (worker_t)&BlinkM::led_trampoline, this, 1, "blinkm");
 		}
 	} else {
 		systemstate_run = false;
@@ -728,7 +729,7 @@ BlinkM::led()
 
 	if(systemstate_run == true) {
 		/* re-queue ourselves to run again later */
-		work_queue(LPWORK, &_work, (worker_t)&BlinkM::led_trampoline, this, led_interval);
+		work_queue_profiled(LPWORK, &_work, (worker_t)&BlinkM::led_trampoline, this, led_interval, "blinkm");
 	} else {
 		stop_script();
 		set_rgb(0,0,0);
@@ -329,7 +329,7 @@ BMA180::init()
 		_reports->get(&arp);
 
 		/* measurement will have generated a report, publish */
-		_accel_topic = orb_advertise(ORB_ID(sensor_accel), &arp);
+		_accel_topic = orb_advertise_multi(ORB_ID(sensor_accel), &arp, nullptr);
 	}
 
 out:
@@ -363,16 +363,11 @@ BMA180::read(struct file *filp, char *buffer, size_t buflen)
 	if (_call_interval > 0) {
 
 		/*
-		 * While there is space in the caller's buffer, and reports, copy them.
+		 * Copy as many reports as fit in the caller's buffer.
 		 * Note that we may be pre-empted by the measurement code while we are doing this;
-		 * we are careful to avoid racing with it.
+		 * the ring buffer retries the copy if it races with it.
 		 */
-		while (count--) {
-			if (_reports->get(arp)) {
-				ret += sizeof(*arp);
-				arp++;
-			}
-		}
+		ret = _reports->get_multiple(arp, count) * sizeof(*arp);
 
 		/* if there was no data, warn the caller */
 		return ret ? ret : -EAGAIN;
@@ -701,6 +696,7 @@ BMA180::measure()
 	 */
 	report.timestamp = hrt_absolute_time();
         report.error_count = 0;
+	report.integral_dt = 0;	// no integration
 	/*
 	 * y of board is x of sensor and x of board is -y of sensor
 	 * perform only the axis assignment here.
@@ -62,6 +62,9 @@ __BEGIN_DECLS
 #define PX4IO_SERIAL_DEVICE	"/dev/ttyS2"
 #define UDID_START		0x1FFF7A10
 
+/* ADC1 scans continuously into memory, see drivers/stm32/adc */
+#define ADC_DMAMAP		DMAMAP_ADC1_2		/* DMA2 stream 4 */
+
 //#ifdef CONFIG_STM32_SPI2
 //#  error "SPI2 is not supported on this board"
 //#endif
@@ -71,6 +71,9 @@ __BEGIN_DECLS
 #define PX4IO_SERIAL_CLOCK	STM32_PCLK2_FREQUENCY
 #define PX4IO_SERIAL_BITRATE	1500000			/* 1.5Mbps -> max rate for IO */
 
+/* ADC1 scans continuously into memory, see drivers/stm32/adc */
+#define ADC_DMAMAP		DMAMAP_ADC1_2		/* DMA2 stream 4 */
+
 
 /* PX4FMU GPIOs ***********************************************************************************/
 /* LEDs */
@@ -114,6 +117,11 @@ __BEGIN_DECLS
 #define PX4_SPI_BUS_SENSORS	1
 #define PX4_SPI_BUS_EXT		4
 
+/* DMA for asynchronous transfers on the sensor bus, see device::SPI::transfer_async() */
+#define PX4_SPI_BUS_SENSORS_BASE	STM32_SPI1_BASE
+#define PX4_SPI_BUS_SENSORS_RX_DMAMAP	DMAMAP_SPI1_RX_1
+#define PX4_SPI_BUS_SENSORS_TX_DMAMAP	DMAMAP_SPI1_TX_1
+
 /* Use these in place of the spi_dev_e enumeration to select a specific SPI device on SPI1 */
 #define PX4_SPIDEV_GYRO		1
 #define PX4_SPIDEV_ACCEL_MAG	2
@@ -44,24 +44,36 @@
 #include <stm32.h>
 #include <stm32_gpio.h>
 #include <stm32_tim.h>
+#include <stm32_dma.h>
 
 #include <drivers/stm32/drv_pwm_servo.h>
 #include <drivers/drv_pwm_output.h>
 
 #include "board_config.h"
 
+/*
+ * The update DMA streams of both timers are taken by UART RX DMA
+ * (TIM1_UP: USART1 RX on DMA2 stream 5, TIM4_UP: UART8 RX on DMA1
+ * stream 6), so the timers use channel requests on free streams, which
+ * are raised at the update event as well. DMA2 stream 4 (TIM1_CH4) is
+ * left to the ADC scan.
+ */
 __EXPORT const struct pwm_servo_timer pwm_timers[PWM_SERVO_MAX_TIMERS] = {
 	{
 		.base = STM32_TIM1_BASE,
 		.clock_register = STM32_RCC_APB2ENR,
 		.clock_bit = RCC_APB2ENR_TIM1EN,
-		.clock_freq = STM32_APB2_TIM1_CLKIN
+		.clock_freq = STM32_APB2_TIM1_CLKIN,
+		.dma_map = DMAMAP_TIM1_CH1_1,		/* DMA2 stream 1 */
+		.dma_request = GTIM_DIER_CC1DE
 	},
 	{
 		.base = STM32_TIM4_BASE,
 		.clock_register = STM32_RCC_APB1ENR,
 		.clock_bit = RCC_APB1ENR_TIM4EN,
-		.clock_freq = STM32_APB1_TIM4_CLKIN
+		.clock_freq = STM32_APB1_TIM4_CLKIN,
+		.dma_map = DMAMAP_TIM4_CH3,		/* DMA1 stream 7 */
+		.dma_request = GTIM_DIER_CC3DE
 	}
 };
 
@@ -55,6 +55,10 @@
  * Definitions
  ************************************************************************************/
 
+/* transfer counters of the circular RX DMA the serial driver receives RC input with */
+#define PX4IO_DSM_RX_DMA_COUNT	STM32_DMA1_CNDTR5	/* USART1 */
+#define PX4IO_SBUS_RX_DMA_COUNT	STM32_DMA1_CNDTR3	/* USART3 */
+
 /* PX4IO GPIOs **********************************************************************/
 /* LEDs */
 
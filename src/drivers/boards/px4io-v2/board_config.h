@@ -68,6 +68,10 @@
 #define PX4FMU_SERIAL_CLOCK	STM32_PCLK1_FREQUENCY
 #define PX4FMU_SERIAL_BITRATE	1500000
 
+/* transfer counters of the circular RX DMA the serial driver receives RC input with */
+#define PX4IO_DSM_RX_DMA_COUNT	STM32_DMA1_CNDTR5	/* USART1 */
+#define PX4IO_SBUS_RX_DMA_COUNT	STM32_DMA1_CNDTR3	/* USART3 */
+
 /******************************************************************************
  * GPIOS
  ******************************************************************************/
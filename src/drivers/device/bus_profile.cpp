@@ -0,0 +1,174 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file bus_profile.cpp
+ *
+ * Transfer statistics of the SPI and I2C buses.
+ */
+
+#include <nuttx/arch.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <systemlib/work_profile.h>
+
+#include "bus_profile.h"
+
+namespace device
+{
+
+BusProfile	*BusProfile::_profiles[BUS_STATS_MAX];
+unsigned	BusProfile::_count = 0;
+work_s		BusProfile::_work;
+orb_advert_t	BusProfile::_pub = -1;
+
+BusProfile::BusProfile(Device::DeviceBusType type, int bus) :
+	_type(type),
+	_bus(bus),
+	_busy_perf(nullptr),
+	_wait_perf(nullptr),
+	_bytes_perf(nullptr),
+	_transfers(0),
+	_waits(0),
+	_bytes(0),
+	_busy_us(0),
+	_wait_us(0)
+{
+	snprintf(_name, sizeof(_name), "%s%d", (type == Device::DeviceBusType_SPI) ? "spi" : "i2c", bus);
+	snprintf(_busy_name, sizeof(_busy_name), "%s_busy", _name);
+	snprintf(_wait_name, sizeof(_wait_name), "%s_wait", _name);
+	snprintf(_bytes_name, sizeof(_bytes_name), "%s_bytes", _name);
+
+	_busy_perf = perf_alloc(PC_ELAPSED, _busy_name);
+	_wait_perf = perf_alloc(PC_HISTOGRAM, _wait_name);
+	_bytes_perf = perf_alloc(PC_COUNT, _bytes_name);
+}
+
+BusProfile *
+BusProfile::get(Device::DeviceBusType type, int bus)
+{
+	BusProfile *profile = nullptr;
+
+	sched_lock();
+
+	for (unsigned i = 0; i < _count; i++) {
+		if ((_profiles[i]->_type == type) && (_profiles[i]->_bus == bus)) {
+			profile = _profiles[i];
+			break;
+		}
+	}
+
+	if ((profile == nullptr) && (_count < BUS_STATS_MAX)) {
+		profile = new BusProfile(type, bus);
+
+		if (profile != nullptr) {
+			_profiles[_count++] = profile;
+
+			/* the first bus starts the publication */
+			if (_count == 1) {
+				memset(&_work, 0, sizeof(_work));
+				work_queue_profiled(LPWORK, &_work, (worker_t)&BusProfile::publish, nullptr,
+					            USEC2TICK(BUS_PROFILE_PUBLISH_INTERVAL),
+					            "bus_profile");
+			}
+		}
+	}
+
+	sched_unlock();
+
+	return profile;
+}
+
+void
+BusProfile::record(unsigned bytes, hrt_abstime wait, hrt_abstime busy, perf_counter_t latency)
+{
+	irqstate_t state = irqsave();
+
+	_transfers++;
+	_bytes += bytes;
+	_busy_us += busy;
+	_wait_us += wait;
+
+	if (wait >= BUS_PROFILE_WAIT_MIN)
+		_waits++;
+
+	perf_set_elapsed(_busy_perf, busy);
+	perf_set_elapsed(_wait_perf, wait);
+	perf_add_count(_bytes_perf, bytes);
+	perf_set_elapsed(latency, wait + busy);
+
+	irqrestore(state);
+}
+
+void
+BusProfile::publish(void *arg)
+{
+	struct bus_stats_s stats;
+
+	memset(&stats, 0, sizeof(stats));
+	stats.timestamp = hrt_absolute_time();
+
+	irqstate_t state = irqsave();
+
+	for (unsigned i = 0; i < _count; i++) {
+		BusProfile *profile = _profiles[i];
+
+		stats.bus_type[i] = profile->_type;
+		stats.bus[i] = profile->_bus;
+		stats.transfers[i] = profile->_transfers;
+		stats.waits[i] = profile->_waits;
+		stats.bytes[i] = profile->_bytes;
+		stats.busy_us[i] = profile->_busy_us;
+		stats.wait_us[i] = profile->_wait_us;
+	}
+
+	stats.count = _count;
+
+	irqrestore(state);
+
+	if (_pub < 0) {
+		_pub = orb_advertise(ORB_ID(bus_stats), &stats);
+
+	} else {
+		orb_publish(ORB_ID(bus_stats), _pub, &stats);
+	}
+
+	work_queue_profiled(LPWORK, &_work, (worker_t)&BusProfile::publish, nullptr,
+		            USEC2TICK(BUS_PROFILE_PUBLISH_INTERVAL),
+		            "bus_profile");
+}
+
+} // namespace device
@@ -0,0 +1,136 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file bus_profile.h
+ *
+ * Transfer statistics of the SPI and I2C buses.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <nuttx/wqueue.h>
+#include <drivers/drv_hrt.h>
+#include <systemlib/perf_counter.h>
+#include <uORB/uORB.h>
+#include <uORB/topics/bus_stats.h>
+
+#include "device.h"
+
+/** a transfer waiting at least this long counts as having waited for the bus */
+#define BUS_PROFILE_WAIT_MIN		5	/* microseconds */
+
+/** interval of the bus_stats publication */
+#define BUS_PROFILE_PUBLISH_INTERVAL	1000000	/* microseconds */
+
+namespace device __EXPORT
+{
+
+/**
+ * Transfer statistics of one bus.
+ *
+ * The SPI and I2C base classes record every transfer. The totals show
+ * up in the perf command as <bus>_busy, <bus>_wait and <bus>_bytes,
+ * next to a <driver>_<bus> transfer latency histogram per device, and
+ * are published as bus_stats once per second.
+ */
+class __EXPORT BusProfile
+{
+public:
+	/**
+	 * Get the profile of a bus, creating it if needed.
+	 *
+	 * Must be called from thread context, e.g. from init().
+	 *
+	 * @param type		The bus type.
+	 * @param bus		The bus number.
+	 * @return		The profile, or nullptr if it could not be
+	 *			allocated.
+	 */
+	static BusProfile	*get(Device::DeviceBusType type, int bus);
+
+	/**
+	 * Bus name used for the counters, e.g. spi1.
+	 */
+	const char		*name() { return _name; }
+
+	/**
+	 * Record a transfer. Safe to call from interrupt context.
+	 *
+	 * @param bytes		Bytes moved.
+	 * @param wait		Time spent waiting for the bus.
+	 * @param busy		Time the transfer occupied the bus.
+	 * @param latency	Transfer time counter of the device, or nullptr.
+	 */
+	void			record(unsigned bytes, hrt_abstime wait, hrt_abstime busy, perf_counter_t latency);
+
+private:
+	BusProfile(Device::DeviceBusType type, int bus);
+
+	Device::DeviceBusType	_type;
+	int			_bus;
+
+	/* the perf counters keep pointers to their names */
+	char			_name[8];
+	char			_busy_name[16];
+	char			_wait_name[16];
+	char			_bytes_name[16];
+
+	perf_counter_t		_busy_perf;
+	perf_counter_t		_wait_perf;
+	perf_counter_t		_bytes_perf;
+
+	uint32_t		_transfers;
+	uint32_t		_waits;
+	uint64_t		_bytes;
+	uint64_t		_busy_us;
+	uint64_t		_wait_us;
+
+	static BusProfile	*_profiles[BUS_STATS_MAX];
+	static unsigned		_count;
+	static work_s		_work;
+	static orb_advert_t	_pub;
+
+	/**
+	 * Publish the statistics of all buses from the work queue.
+	 */
+	static void		publish(void *arg);
+
+	/* this class does not allow copying */
+	BusProfile(const BusProfile&);
+	BusProfile operator=(const BusProfile&);
+};
+
+} // namespace device
@@ -53,9 +53,6 @@
 namespace device
 {
 
-/* how much to grow the poll waiter set each time it has to be increased */
-static const unsigned pollset_increment = 0;
-
 /*
  * The standard NuttX operation dispatch table can't call C++ member functions
  * directly, so we have to bounce them through this dispatch table.
@@ -98,7 +95,8 @@ CDev::CDev(const char *name,
 	// private
 	_devname(devname),
 	_registered(false),
-	_open_count(0)
+	_open_count(0),
+	_pollwaiters(0)
 {
 	for (unsigned i = 0; i < _max_pollwaiters; i++)
 		_pollset[i] = nullptr;
@@ -331,9 +329,9 @@ CDev::poll_notify(pollevent_t events)
 	/* lock against poll() as well as other wakeups */
 	irqstate_t state = irqsave();
 
-	for (unsigned i = 0; i < _max_pollwaiters; i++)
-		if (nullptr != _pollset[i])
-			poll_notify_one(_pollset[i], events);
+	/* the waiters are packed at the front of the set */
+	for (unsigned i = 0; i < _pollwaiters; i++)
+		poll_notify_one(_pollset[i], events);
 
 	irqrestore(state);
 }
@@ -360,29 +358,30 @@ CDev::poll_state(struct file *filp)
 int
 CDev::store_poll_waiter(struct pollfd *fds)
 {
-	/*
-	 * Look for a free slot.
-	 */
-	for (unsigned i = 0; i < _max_pollwaiters; i++) {
-		if (nullptr == _pollset[i]) {
-
-			/* save the pollfd */
-			_pollset[i] = fds;
+	if (_pollwaiters >= _max_pollwaiters)
+		return ENOMEM;
 
-			return OK;
-		}
-	}
+	/* append the pollfd; poll_notify() may walk the set from interrupt context */
+	irqstate_t state = irqsave();
+	_pollset[_pollwaiters++] = fds;
+	irqrestore(state);
 
-	return ENOMEM;
+	return OK;
 }
 
 int
 CDev::remove_poll_waiter(struct pollfd *fds)
 {
-	for (unsigned i = 0; i < _max_pollwaiters; i++) {
+	for (unsigned i = 0; i < _pollwaiters; i++) {
 		if (fds == _pollset[i]) {
 
-			_pollset[i] = nullptr;
+			/* move the last waiter into the slot to keep the set packed */
+			irqstate_t state = irqsave();
+			_pollwaiters--;
+			_pollset[i] = _pollset[_pollwaiters];
+			_pollset[_pollwaiters] = nullptr;
+			irqrestore(state);
+
 			return OK;
 
 		}
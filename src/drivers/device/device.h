@@ -453,12 +453,13 @@ private:
 	bool		_registered;		/**< true if device name was registered */
 	unsigned	_open_count;		/**< number of successful opens */
 
-	struct pollfd	*_pollset[_max_pollwaiters];
+	struct pollfd	*_pollset[_max_pollwaiters];	/**< active poll waiters, packed at the front */
+	unsigned	_pollwaiters;		/**< number of entries in _pollset */
 
 	/**
 	 * Store a pollwaiter in a slot where we can find it later.
 	 *
-	 * Expands the pollset as required.  Must be called with the driver locked.
+	 * Must be called with the driver locked.
 	 *
 	 * @return		OK, or -errno on error.
 	 */
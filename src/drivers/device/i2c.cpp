@@ -40,11 +40,263 @@
  *       that is supplied.  Should we just depend on the bus knowing?
  */
 
+#include <nuttx/arch.h>
+#include <semaphore.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <systemlib/systemlib.h>
+
 #include "i2c.h"
+#include "bus_profile.h"
+
+/** highest bus number with a scheduler */
+#define I2C_SCHEDULER_BUS_MAX	3
+
+/** just below the work queue, so bus setup never delays work items */
+#define I2C_SCHEDULER_PRIORITY	(CONFIG_SCHED_WORKPRIORITY - 1)
+#define I2C_SCHEDULER_STACK	1500
 
 namespace device
 {
 
+/**
+ * Runs the scheduled transfers of all devices on one bus.
+ *
+ * The NuttX I2C driver is interrupt driven and sleeps while the bus
+ * clocks, so only this thread waits for the bus.
+ */
+class I2CBusScheduler
+{
+public:
+	I2CBusScheduler(int bus);
+
+	/**
+	 * Start the scheduler thread. Must be called from thread context.
+	 */
+	int		start();
+
+	int		enqueue(I2C::Transaction *txn);
+	bool		cancel(I2C::Transaction *txn);
+
+	/**
+	 * Get the scheduler of a bus, creating it if needed.
+	 */
+	static I2CBusScheduler *instance(int bus);
+
+private:
+	int		_bus;
+	int		_task;
+	sem_t		_wakeup;
+	I2C::Transaction *_queue;	/**< unordered, usually short */
+
+	/**
+	 * Take the ready transfer with the earliest deadline off the queue.
+	 *
+	 * @param next_start	Set to the earliest start of the transfers
+	 *			that are not ready yet, or 0.
+	 */
+	I2C::Transaction *take_next(hrt_abstime now, hrt_abstime &next_start);
+
+	void		run();
+	static int	task_main(int argc, char *argv[]);
+
+	static I2CBusScheduler *_instances[I2C_SCHEDULER_BUS_MAX + 1];
+};
+
+I2CBusScheduler *I2CBusScheduler::_instances[I2C_SCHEDULER_BUS_MAX + 1];
+
+I2CBusScheduler::I2CBusScheduler(int bus) :
+	_bus(bus),
+	_task(-1),
+	_queue(nullptr)
+{
+	sem_init(&_wakeup, 0, 0);
+}
+
+I2CBusScheduler *
+I2CBusScheduler::instance(int bus)
+{
+	if ((bus < 0) || (bus > I2C_SCHEDULER_BUS_MAX))
+		return nullptr;
+
+	if (_instances[bus] == nullptr) {
+		I2CBusScheduler *scheduler = new I2CBusScheduler(bus);
+
+		if (scheduler == nullptr)
+			return nullptr;
+
+		sched_lock();
+
+		if (_instances[bus] == nullptr) {
+			_instances[bus] = scheduler;
+
+		} else {
+			delete scheduler;
+		}
+
+		sched_unlock();
+
+		if (_instances[bus]->start() != OK)
+			return nullptr;
+	}
+
+	return _instances[bus];
+}
+
+int
+I2CBusScheduler::start()
+{
+	sched_lock();
+
+	if (_task < 0) {
+		char name[8];
+		char bus[4];
+		const char *argv[2] = { bus, nullptr };
+
+		snprintf(name, sizeof(name), "i2c%d", _bus);
+		snprintf(bus, sizeof(bus), "%d", _bus);
+		_task = task_spawn_cmd(name, SCHED_DEFAULT, I2C_SCHEDULER_PRIORITY, I2C_SCHEDULER_STACK,
+				       (main_t)&I2CBusScheduler::task_main, argv);
+	}
+
+	sched_unlock();
+
+	return (_task < 0) ? -ENOMEM : OK;
+}
+
+int
+I2CBusScheduler::enqueue(I2C::Transaction *txn)
+{
+	irqstate_t state = irqsave();
+
+	if (txn->queued) {
+		irqrestore(state);
+		return -EBUSY;
+	}
+
+	txn->queued = true;
+	txn->next = _queue;
+	_queue = txn;
+
+	irqrestore(state);
+
+	/* wake the scheduler, it re-evaluates what to run next */
+	sem_post(&_wakeup);
+	return OK;
+}
+
+bool
+I2CBusScheduler::cancel(I2C::Transaction *txn)
+{
+	bool removed = false;
+
+	irqstate_t state = irqsave();
+
+	for (I2C::Transaction **t = &_queue; *t != nullptr; t = &(*t)->next) {
+		if (*t == txn) {
+			*t = txn->next;
+			txn->next = nullptr;
+			txn->queued = false;
+			removed = true;
+			break;
+		}
+	}
+
+	irqrestore(state);
+	return removed;
+}
+
+I2C::Transaction *
+I2CBusScheduler::take_next(hrt_abstime now, hrt_abstime &next_start)
+{
+	I2C::Transaction **best = nullptr;
+
+	next_start = 0;
+
+	irqstate_t state = irqsave();
+
+	for (I2C::Transaction **txn = &_queue; *txn != nullptr; txn = &(*txn)->next) {
+		if ((*txn)->start > now) {
+			if ((next_start == 0) || ((*txn)->start < next_start))
+				next_start = (*txn)->start;
+
+		} else if ((best == nullptr) || ((*txn)->deadline < (*best)->deadline)) {
+			best = txn;
+		}
+	}
+
+	I2C::Transaction *result = nullptr;
+
+	if (best != nullptr) {
+		result = *best;
+		*best = result->next;
+		result->next = nullptr;
+	}
+
+	irqrestore(state);
+	return result;
+}
+
+void
+I2CBusScheduler::run()
+{
+	for (;;) {
+		hrt_abstime next_start;
+		I2C::Transaction *txn = take_next(hrt_absolute_time(), next_start);
+
+		if (txn != nullptr) {
+			/* waiting counts from when the transfer could first have run */
+			hrt_abstime ready = (txn->start > txn->queued_time) ? txn->start : txn->queued_time;
+			hrt_abstime started = hrt_absolute_time();
+			int ret = txn->dev->_transfer(txn->send, txn->send_len, txn->recv, txn->recv_len);
+
+			txn->dev->_record(txn->send_len + txn->recv_len,
+					  (started > ready) ? (started - ready) : 0,
+					  hrt_absolute_time() - started);
+
+			/* the callback may queue txn again */
+			txn->queued = false;
+			txn->callback(txn->arg, ret);
+			continue;
+		}
+
+		if (next_start == 0) {
+			sem_wait(&_wakeup);
+			continue;
+		}
+
+		/* sleep until the next transfer is due, or a new one is queued */
+		hrt_abstime now = hrt_absolute_time();
+
+		if (next_start <= now)
+			continue;
+
+		hrt_abstime delay = next_start - now;
+		struct timespec abstime;
+		clock_gettime(CLOCK_REALTIME, &abstime);
+		abstime.tv_sec += delay / 1000000;
+		abstime.tv_nsec += (delay % 1000000) * 1000;
+
+		if (abstime.tv_nsec >= 1000 * 1000 * 1000) {
+			abstime.tv_sec++;
+			abstime.tv_nsec -= 1000 * 1000 * 1000;
+		}
+
+		sem_timedwait(&_wakeup, &abstime);
+	}
+}
+
+int
+I2CBusScheduler::task_main(int argc, char *argv[])
+{
+	int bus = atoi(argv[1]);
+
+	_instances[bus]->run();
+	return 0;
+}
+
 I2C::I2C(const char *name,
 	 const char *devname,
 	 int bus,
@@ -60,7 +312,10 @@ I2C::I2C(const char *name,
 	_bus(bus),
 	_address(address),
 	_frequency(frequency),
-	_dev(nullptr)
+	_dev(nullptr),
+	_scheduler(nullptr),
+	_profile(nullptr),
+	_transfer_perf(nullptr)
 {
 	// fill in _device_id fields for a I2C device
 	_device_id.devid_s.bus_type = DeviceBusType_I2C;
@@ -74,6 +329,8 @@ I2C::~I2C()
 {
 	if (_dev)
 		up_i2cuninitialize(_dev);
+
+	perf_free(_transfer_perf);
 }
 
 int
@@ -106,6 +363,16 @@ I2C::init()
 		goto out;
 	}
 
+	// account the transfers to the bus
+	if (_profile == nullptr) {
+		_profile = BusProfile::get(DeviceBusType_I2C, _bus);
+
+		if (_profile != nullptr) {
+			snprintf(_transfer_perf_name, sizeof(_transfer_perf_name), "%s_%s", _name, _profile->name());
+			_transfer_perf = perf_alloc(PC_HISTOGRAM, _transfer_perf_name);
+		}
+	}
+
 	// tell the world where we are
 	log("on I2C bus %d at 0x%02x", _bus, _address);
 
@@ -122,6 +389,20 @@ I2C::probe()
 
 int
 I2C::transfer(const uint8_t *send, unsigned send_len, uint8_t *recv, unsigned recv_len)
+{
+	/*
+	 * The NuttX driver serialises the bus internally, so the wait for
+	 * the bus cannot be told apart and is part of the busy time.
+	 */
+	hrt_abstime started = hrt_absolute_time();
+	int ret = _transfer(send, send_len, recv, recv_len);
+
+	_record(send_len + recv_len, 0, hrt_absolute_time() - started);
+	return ret;
+}
+
+int
+I2C::_transfer(const uint8_t *send, unsigned send_len, uint8_t *recv, unsigned recv_len)
 {
 	struct i2c_msg_s msgv[2];
 	unsigned msgs;
@@ -176,14 +457,32 @@ I2C::transfer(const uint8_t *send, unsigned send_len, uint8_t *recv, unsigned re
 
 int
 I2C::transfer(i2c_msg_s *msgv, unsigned msgs)
+{
+	/* force the device address into the message vector */
+	for (unsigned i = 0; i < msgs; i++)
+		msgv[i].addr = _address;
+
+	return _transfer_msgv(msgv, msgs);
+}
+
+int
+I2C::transfer_batch(i2c_msg_s *msgv, unsigned msgs)
+{
+	return _transfer_msgv(msgv, msgs);
+}
+
+int
+I2C::_transfer_msgv(i2c_msg_s *msgv, unsigned msgs)
 {
 	int ret;
 	unsigned retry_count = 0;
 
-	/* force the device address into the message vector */
+	unsigned len = 0;
+
 	for (unsigned i = 0; i < msgs; i++)
-		msgv[i].addr = _address;
+		len += msgv[i].length;
 
+	hrt_abstime started = hrt_absolute_time();
 
 	do {
 		/*
@@ -204,7 +503,56 @@ I2C::transfer(i2c_msg_s *msgv, unsigned msgs)
 
 	} while (retry_count++ < _retries);
 
+	_record(len, 0, hrt_absolute_time() - started);
 	return ret;
 }
 
+int
+I2C::transfer_async(Transaction *txn, const uint8_t *send, unsigned send_len,
+		    uint8_t *recv, unsigned recv_len, hrt_abstime start, hrt_abstime deadline,
+		    transfer_callback_t callback, void *arg)
+{
+	if (((send_len == 0) && (recv_len == 0)) || (callback == nullptr))
+		return -EINVAL;
+
+	/* started on first use, from the thread context of the caller */
+	if (_scheduler == nullptr)
+		_scheduler = I2CBusScheduler::instance(_bus);
+
+	if (_scheduler == nullptr)
+		return -ENOTSUP;
+
+	if (txn->queued)
+		return -EBUSY;
+
+	txn->dev = this;
+	txn->send = send;
+	txn->send_len = send_len;
+	txn->recv = recv;
+	txn->recv_len = recv_len;
+	txn->start = start;
+	txn->deadline = deadline;
+	txn->callback = callback;
+	txn->arg = arg;
+	txn->queued_time = hrt_absolute_time();
+
+	return _scheduler->enqueue(txn);
+}
+
+bool
+I2C::transfer_cancel(Transaction *txn)
+{
+	if (_scheduler == nullptr)
+		return false;
+
+	return _scheduler->cancel(txn);
+}
+
+void
+I2C::_record(unsigned len, hrt_abstime wait, hrt_abstime busy)
+{
+	if (_profile != nullptr)
+		_profile->record(len, wait, busy, _transfer_perf);
+}
+
 } // namespace device
@@ -43,10 +43,15 @@
 #include "device.h"
 
 #include <nuttx/i2c.h>
+#include <drivers/drv_hrt.h>
+#include <systemlib/perf_counter.h>
 
 namespace device __EXPORT
 {
 
+class I2CBusScheduler;
+class BusProfile;
+
 /**
  * Abstract class for character device on I2C
  */
@@ -122,6 +127,105 @@ protected:
 	 */
 	int		transfer(i2c_msg_s *msgv, unsigned msgs);
 
+	/**
+	 * Perform a combined I2C transaction to several devices.
+	 *
+	 * The messages keep their own addresses and go out back to back,
+	 * separated by repeated starts, so a set of devices sharing a
+	 * driver can be updated with one bus transaction.
+	 *
+	 * @param msgv		An I2C message vector, addresses filled in.
+	 * @param msgs		The number of entries in the message vector.
+	 * @return		OK if the transfer was successful, -errno
+	 *			otherwise.
+	 */
+	int		transfer_batch(i2c_msg_s *msgv, unsigned msgs);
+
+	/**
+	 * Completion callback for a scheduled transfer.
+	 *
+	 * Called from the bus scheduler thread once the transfer has
+	 * finished, so it may queue the next transfer or do blocking
+	 * transfers of its own.
+	 *
+	 * @param arg		The argument passed to transfer_async().
+	 * @param result	OK if the transfer was successful, -errno
+	 *			otherwise.
+	 */
+	typedef void	(*transfer_callback_t)(void *arg, int result);
+
+	/**
+	 * State of one scheduled transfer, owned by the caller.
+	 */
+	struct Transaction {
+		I2C			*dev;
+		const uint8_t		*send;
+		unsigned		send_len;
+		uint8_t			*recv;
+		unsigned		recv_len;
+		hrt_abstime		start;		/**< not run before this time */
+		hrt_abstime		deadline;	/**< wanted completion, orders the ready transfers */
+		transfer_callback_t	callback;
+		void			*arg;
+		Transaction		*next;
+		volatile bool		queued;
+		hrt_abstime		queued_time;	/**< when it was queued, for the bus profile */
+
+		Transaction() :
+			dev(nullptr),
+			send(nullptr),
+			send_len(0),
+			recv(nullptr),
+			recv_len(0),
+			start(0),
+			deadline(0),
+			callback(nullptr),
+			arg(nullptr),
+			next(nullptr),
+			queued(false),
+			queued_time(0)
+		{}
+	};
+
+	/**
+	 * Queue a transfer with the scheduler of the bus.
+	 *
+	 * One thread per bus runs the queued transfers of all devices on
+	 * it, ready transfers with the earliest deadline first, so waiting
+	 * for the bus no longer blocks the work queue. Retries are as for
+	 * transfer().
+	 *
+	 * The buffers and txn must stay valid until the callback has run.
+	 * The first call must be made from thread context, as it may start
+	 * the scheduler.
+	 *
+	 * @param txn		Transfer state, must not be queued already.
+	 * @param send		Pointer to bytes to send.
+	 * @param send_len	Number of bytes to send.
+	 * @param recv		Pointer to buffer for bytes received.
+	 * @param recv_len	Number of bytes to receive.
+	 * @param start		Earliest time to run the transfer, 0 for now.
+	 * @param deadline	Time the transfer should be done by.
+	 * @param callback	Called from the scheduler thread on completion.
+	 * @param arg		Passed to the callback.
+	 * @return		OK if the transfer was queued, -ENOTSUP if
+	 *			the bus has no scheduler, -EBUSY if txn is
+	 *			still queued, -errno otherwise.
+	 */
+	int		transfer_async(Transaction *txn, const uint8_t *send, unsigned send_len,
+				       uint8_t *recv, unsigned recv_len, hrt_abstime start, hrt_abstime deadline,
+				       transfer_callback_t callback, void *arg);
+
+	/**
+	 * Take a scheduled transfer off the queue before it runs.
+	 *
+	 * @param txn		The transfer to cancel.
+	 * @return		true if the transfer was removed and its
+	 *			callback will not run, false if it is not
+	 *			queued or already running.
+	 */
+	bool		transfer_cancel(Transaction *txn);
+
 	/**
 	 * Change the bus address.
 	 *
@@ -138,6 +242,32 @@ private:
 	uint16_t		_address;
 	uint32_t		_frequency;
 	struct i2c_dev_s	*_dev;
+	I2CBusScheduler		*_scheduler;
+	BusProfile		*_profile;	/**< statistics of the bus */
+	perf_counter_t		_transfer_perf;	/**< transfer latency of this device */
+	char			_transfer_perf_name[24];
+
+	friend class I2CBusScheduler;
+
+	/**
+	 * Transfer with retries, without updating the bus statistics.
+	 */
+	int		_transfer(const uint8_t *send, unsigned send_len,
+				  uint8_t *recv, unsigned recv_len);
+
+	/**
+	 * Transfer a message vector with retries, addresses as given.
+	 */
+	int		_transfer_msgv(i2c_msg_s *msgv, unsigned msgs);
+
+	/**
+	 * Add a transfer to the bus statistics.
+	 *
+	 * @param len		Bytes moved.
+	 * @param wait		Time spent waiting for the bus.
+	 * @param busy		Time the transfer occupied the bus.
+	 */
+	void		_record(unsigned len, hrt_abstime wait, hrt_abstime busy);
 
 	I2C(const device::I2C&);
 	I2C operator=(const device::I2C&);
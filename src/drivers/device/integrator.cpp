@@ -0,0 +1,127 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file integrator.cpp
+ *
+ * Integrates sensor samples to delta angles and delta velocities.
+ */
+
+#include "integrator.h"
+
+/* samples further apart than this are not integrated, e.g. after a stop */
+#define INTEGRATOR_MAX_GAP	100000
+
+Integrator::Integrator(uint64_t auto_reset_interval, bool coning_compensation) :
+	_auto_reset_interval(auto_reset_interval),
+	_last_integration(0),
+	_last_reset(0),
+	_alpha(0.0f, 0.0f, 0.0f),
+	_beta(0.0f, 0.0f, 0.0f),
+	_last_val(0.0f, 0.0f, 0.0f),
+	_last_delta(0.0f, 0.0f, 0.0f),
+	_coning_comp_on(coning_compensation)
+{
+
+}
+
+Integrator::~Integrator()
+{
+
+}
+
+bool
+Integrator::put(uint64_t timestamp, const math::Vector<3> &val, math::Vector<3> &integral, uint64_t &integral_dt)
+{
+	if (_last_integration == 0 ||
+	    timestamp <= _last_integration ||
+	    timestamp - _last_integration > INTEGRATOR_MAX_GAP) {
+		/* nothing to integrate from, start with this sample */
+		reset();
+		_last_integration = timestamp;
+		_last_reset = timestamp;
+		_last_val = val;
+		return false;
+	}
+
+	float dt = (float)(timestamp - _last_integration) * 1.0e-6f;
+	math::Vector<3> delta = (val + _last_val) * (0.5f * dt);
+
+	if (_coning_comp_on) {
+		/*
+		 * Second order coning correction from the rotation so far
+		 * and the previous interval, see Savage, "Strapdown Inertial
+		 * Navigation Integration Algorithm Design".
+		 */
+		_beta += ((_alpha + _last_delta * (1.0f / 6.0f)) % delta) * 0.5f;
+		_last_delta = delta;
+	}
+
+	_alpha += delta;
+	_last_val = val;
+	_last_integration = timestamp;
+
+	if (_auto_reset_interval == 0 || timestamp - _last_reset < _auto_reset_interval)
+		return false;
+
+	integral = get(true, integral_dt);
+	return true;
+}
+
+math::Vector<3>
+Integrator::get(bool reset, uint64_t &integral_dt)
+{
+	math::Vector<3> val = _alpha + _beta;
+
+	integral_dt = _last_integration - _last_reset;
+
+	if (reset) {
+		_alpha.zero();
+		_beta.zero();
+		_last_delta.zero();
+		_last_reset = _last_integration;
+	}
+
+	return val;
+}
+
+void
+Integrator::reset()
+{
+	_alpha.zero();
+	_beta.zero();
+	_last_delta.zero();
+	_last_integration = 0;
+	_last_reset = 0;
+}
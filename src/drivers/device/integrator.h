@@ -0,0 +1,105 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file integrator.h
+ *
+ * Integrates sensor samples to delta angles and delta velocities.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <mathlib/mathlib.h>
+
+class Integrator {
+public:
+	/**
+	 * @param auto_reset_interval	Integration time in microseconds after which
+	 *				put() closes the integral, 0 to only close
+	 *				it with get().
+	 * @param coning_compensation	Correct the integral of angular rates for coning.
+	 */
+	Integrator(uint64_t auto_reset_interval = 0, bool coning_compensation = false);
+	virtual ~Integrator();
+
+	/**
+	 * Add a sample, integrated trapezoidally from the previous one.
+	 *
+	 * @param timestamp		Time of the sample in microseconds.
+	 * @param val			The sample.
+	 * @param integral		Set to the closed integral if one was closed.
+	 * @param integral_dt		Set to the integration time in microseconds
+	 *				if an integral was closed.
+	 * @return			true if the auto reset interval elapsed and an
+	 *				integral was closed.
+	 */
+	bool			put(uint64_t timestamp, const math::Vector<3> &val,
+				    math::Vector<3> &integral, uint64_t &integral_dt);
+
+	/**
+	 * Get the integral since it was last closed.
+	 *
+	 * @param reset			Close the integral and start a new one.
+	 * @param integral_dt		Set to the integration time in microseconds.
+	 * @return			The integral.
+	 */
+	math::Vector<3>		get(bool reset, uint64_t &integral_dt);
+
+	/**
+	 * Set the auto reset interval in microseconds, 0 to disable it.
+	 */
+	void			set_autoreset_interval(uint64_t interval) { _auto_reset_interval = interval; }
+	uint64_t		get_autoreset_interval() const { return _auto_reset_interval; }
+
+	/**
+	 * Discard the integral and the previous sample, e.g. after a gap
+	 * in the samples.
+	 */
+	void			reset();
+
+private:
+	uint64_t		_auto_reset_interval;	/**< integration time after which put() closes the integral */
+	uint64_t		_last_integration;	/**< time of the previous sample, 0 if there is none */
+	uint64_t		_last_reset;		/**< time the integral was started */
+	math::Vector<3>		_alpha;			/**< integral of the samples */
+	math::Vector<3>		_beta;			/**< coning correction */
+	math::Vector<3>		_last_val;		/**< previous sample */
+	math::Vector<3>		_last_delta;		/**< integral over the previous sample interval */
+	bool			_coning_comp_on;
+
+	/* do not allow copying */
+	Integrator(const Integrator &);
+	Integrator operator=(const Integrator &);
+};
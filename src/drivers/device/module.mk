@@ -37,6 +37,8 @@
 
 SRCS		= cdev.cpp \
 		  device.cpp \
+		  bus_profile.cpp \
 		  i2c.cpp \
+		  integrator.cpp \
 		  pio.cpp \
 		  spi.cpp
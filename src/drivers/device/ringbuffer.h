@@ -63,6 +63,18 @@ public:
 	bool			put(float val);
 	bool			put(double val);
 
+	/**
+	 * Put up to count items into the buffer in one pass.
+	 *
+	 * The items are copied with at most two memcpy calls. Items that
+	 * don't fit are not put, nothing in the buffer is overwritten.
+	 *
+	 * @param buf		count items of the entry size
+	 * @param count		Number of items to put
+	 * @return		The number of items that were put.
+	 */
+	unsigned		put_multiple(const void *buf, unsigned count);
+
 	/**
 	 * Force an item into the buffer, discarding an older item if there is not space.
 	 *
@@ -101,6 +113,18 @@ public:
 	bool			get(float &val);
 	bool			get(double &val);
 
+	/**
+	 * Get up to max_count items from the buffer in one pass.
+	 *
+	 * The items are copied oldest first with at most two memcpy calls.
+	 *
+	 * @param buf		Space for max_count items of the entry size
+	 * @param max_count	Maximum number of items to get
+	 * @return		The number of items that were got, zero if the
+	 *			buffer was empty.
+	 */
+	unsigned		get_multiple(void *buf, unsigned max_count);
+
 	/*
 	 * Get the number of slots free in the buffer.
 	 *
@@ -185,7 +209,7 @@ RingBuffer::~RingBuffer()
 unsigned
 RingBuffer::_next(unsigned index)
 {
-	return (0 == index) ? _num_items : (index - 1); 
+	return (_num_items == index) ? 0 : (index + 1);
 }
 
 bool
@@ -392,6 +416,73 @@ RingBuffer::get(void *val, size_t val_size)
 	}
 }
 
+unsigned
+RingBuffer::put_multiple(const void *buf, unsigned count)
+{
+	unsigned head = _head;
+	unsigned space = (_tail + _num_items - head) % (_num_items + 1);
+
+	if (count > space)
+		count = space;
+
+	if (count == 0)
+		return 0;
+
+	/* write up to the end of the storage, then from the start */
+	unsigned first = _num_items + 1 - head;
+
+	if (first > count)
+		first = count;
+
+	memcpy(&_buf[head * _item_size], buf, first * _item_size);
+
+	if (count > first)
+		memcpy(&_buf[0], (const char *)buf + first * _item_size, (count - first) * _item_size);
+
+	_head = (head + count) % (_num_items + 1);
+
+	return count;
+}
+
+unsigned
+RingBuffer::get_multiple(void *buf, unsigned max_count)
+{
+	unsigned candidate;
+	unsigned next;
+	unsigned count;
+
+	do {
+		/* decide which elements we think we're going to read */
+		unsigned head = _head;
+		candidate = _tail;
+
+		count = (head >= candidate) ? (head - candidate) : (_num_items + 1 - candidate + head);
+
+		if (count > max_count)
+			count = max_count;
+
+		if (count == 0)
+			return 0;
+
+		/* read up to the end of the storage, then from the start */
+		unsigned first = _num_items + 1 - candidate;
+
+		if (first > count)
+			first = count;
+
+		memcpy(buf, &_buf[candidate * _item_size], first * _item_size);
+
+		if (count > first)
+			memcpy((char *)buf + first * _item_size, &_buf[0], (count - first) * _item_size);
+
+		next = (candidate + count) % (_num_items + 1);
+
+		/* if the tail pointer didn't change, we got our items */
+	} while (!__sync_bool_compare_and_swap(&_tail, candidate, next));
+
+	return count;
+}
+
 bool
 RingBuffer::get(int8_t &val)
 {
@@ -470,7 +561,7 @@ RingBuffer::space(void)
 		tail = _tail;
 	} while (head != _head);
 
-	return (tail >= head) ? (_num_items - (tail - head)) : (head - tail - 1);
+	return (head >= tail) ? (_num_items - (head - tail)) : (tail - head - 1);
 }
 
 unsigned
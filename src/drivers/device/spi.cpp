@@ -46,16 +46,300 @@
  */
 
 #include <nuttx/arch.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <board_config.h>
+#include <drivers/drv_hrt.h>
 
 #include "spi.h"
+#include "bus_profile.h"
 
 #ifndef CONFIG_SPI_EXCHANGE
 # error This driver requires CONFIG_SPI_EXCHANGE
 #endif
 
+/** time to give an asynchronous transfer to finish before it is aborted */
+#define SPI_ASYNC_TIMEOUT	1000
+
 namespace device
 {
 
+/**
+ * Queue of asynchronous transfers on one SPI bus.
+ *
+ * Transfers run one at a time through a bounce buffer in SRAM, as
+ * driver buffers may live in CCM which the DMA cannot reach.
+ * Synchronous transfers wait for the queue to drain and hold it
+ * off while they run.
+ */
+class SPIBusQueue
+{
+public:
+	SPIBusQueue(int bus, uint32_t base, uint32_t rx_map, uint32_t tx_map);
+
+	/**
+	 * Allocate the DMA streams. Must be called from thread context.
+	 */
+	int		init();
+
+	int		enqueue(SPI::Transaction *txn);
+
+	/**
+	 * Finish any asynchronous transfers and keep new ones from
+	 * starting until sync_end().
+	 */
+	void		sync_begin();
+	void		sync_end();
+
+	int		bus() { return _bus; }
+
+private:
+	int		_bus;
+	uint32_t	_base;
+	uint32_t	_rx_map;
+	uint32_t	_tx_map;
+	DMA_HANDLE	_rx_dma;
+	DMA_HANDLE	_tx_dma;
+
+	SPI::Transaction *_head;	/**< transfer in progress, or next to start */
+	SPI::Transaction *_tail;
+	bool		_active;	/**< _head is being transferred */
+	hrt_abstime	_started;	/**< when _head started */
+	unsigned	_sync;		/**< synchronous transfers in progress */
+
+	uint8_t		_buffer[SPI_ASYNC_MAX_TRANSFER];
+
+	void		start_next();
+	void		complete(int result);
+
+	static void	dma_callback(DMA_HANDLE handle, uint8_t status, void *arg);
+};
+
+#ifdef PX4_SPI_BUS_SENSORS_RX_DMAMAP
+/* static, so that the bounce buffer is in SRAM */
+static SPIBusQueue spi_sensors_queue(PX4_SPI_BUS_SENSORS, PX4_SPI_BUS_SENSORS_BASE,
+				     PX4_SPI_BUS_SENSORS_RX_DMAMAP, PX4_SPI_BUS_SENSORS_TX_DMAMAP);
+#endif
+
+static SPIBusQueue *
+spi_bus_queue(int bus)
+{
+#ifdef PX4_SPI_BUS_SENSORS_RX_DMAMAP
+	if (bus == spi_sensors_queue.bus())
+		return &spi_sensors_queue;
+#endif
+	return nullptr;
+}
+
+#define SPI_REG(_base, _x)	(*(volatile uint32_t *)((_base) + (_x)))
+
+SPIBusQueue::SPIBusQueue(int bus, uint32_t base, uint32_t rx_map, uint32_t tx_map) :
+	_bus(bus),
+	_base(base),
+	_rx_map(rx_map),
+	_tx_map(tx_map),
+	_rx_dma(nullptr),
+	_tx_dma(nullptr),
+	_head(nullptr),
+	_tail(nullptr),
+	_active(false),
+	_started(0),
+	_sync(0)
+{
+}
+
+int
+SPIBusQueue::init()
+{
+	if (_rx_dma == nullptr)
+		_rx_dma = stm32_dmachannel(_rx_map);
+
+	if (_tx_dma == nullptr)
+		_tx_dma = stm32_dmachannel(_tx_map);
+
+	return ((_rx_dma != nullptr) && (_tx_dma != nullptr)) ? OK : -ENOMEM;
+}
+
+int
+SPIBusQueue::enqueue(SPI::Transaction *txn)
+{
+	if ((_rx_dma == nullptr) || (_tx_dma == nullptr))
+		return -ENOTSUP;
+
+	irqstate_t state = irqsave();
+
+	if (txn->queued) {
+		irqrestore(state);
+		return -EBUSY;
+	}
+
+	txn->queued = true;
+	txn->next = nullptr;
+
+	if (_tail != nullptr) {
+		_tail->next = txn;
+
+	} else {
+		_head = txn;
+	}
+
+	_tail = txn;
+
+	if (!_active && (_sync == 0))
+		start_next();
+
+	irqrestore(state);
+	return OK;
+}
+
+void
+SPIBusQueue::sync_begin()
+{
+	irqstate_t state = irqsave();
+
+	if (up_interrupt_context()) {
+		/*
+		 * Finish the queued transfers first. The DMA interrupt can't
+		 * preempt us, so poll for completion.
+		 */
+		hrt_abstime deadline = hrt_absolute_time() + SPI_ASYNC_TIMEOUT;
+
+		while (_active) {
+			if (stm32_dmaresidual(_rx_dma) == 0) {
+				complete(OK);
+				deadline = hrt_absolute_time() + SPI_ASYNC_TIMEOUT;
+
+			} else if (hrt_absolute_time() > deadline) {
+				complete(-ETIMEDOUT);
+				deadline = hrt_absolute_time() + SPI_ASYNC_TIMEOUT;
+			}
+		}
+
+	} else {
+		/* let the DMA interrupt finish the transfer in progress */
+		while (_active) {
+			irqrestore(state);
+			state = irqsave();
+		}
+	}
+
+	_sync++;
+	irqrestore(state);
+}
+
+void
+SPIBusQueue::sync_end()
+{
+	irqstate_t state = irqsave();
+
+	_sync--;
+
+	if (!_active && (_sync == 0) && (_head != nullptr))
+		start_next();
+
+	irqrestore(state);
+}
+
+void
+SPIBusQueue::start_next()
+{
+	SPI::Transaction *txn = _head;
+
+	if (txn == nullptr)
+		return;
+
+	_active = true;
+	_started = hrt_absolute_time();
+
+	if (txn->send != nullptr) {
+		memcpy(_buffer, txn->send, txn->len);
+
+	} else {
+		memset(_buffer, 0, txn->len);
+	}
+
+	txn->dev->_select(true);
+
+	/* drop any stale received byte */
+	(void)SPI_REG(_base, STM32_SPI_DR_OFFSET);
+
+	/* the same buffer is sent from and received into, RX trails TX */
+	stm32_dmasetup(
+		_rx_dma,
+		_base + STM32_SPI_DR_OFFSET,
+		reinterpret_cast<uint32_t>(&_buffer[0]),
+		txn->len,
+		DMA_SCR_DIR_P2M		|
+		DMA_SCR_MINC		|
+		DMA_SCR_PSIZE_8BITS	|
+		DMA_SCR_MSIZE_8BITS	|
+		DMA_SCR_PBURST_SINGLE	|
+		DMA_SCR_MBURST_SINGLE);
+	stm32_dmastart(_rx_dma, dma_callback, this, false);
+
+	stm32_dmasetup(
+		_tx_dma,
+		_base + STM32_SPI_DR_OFFSET,
+		reinterpret_cast<uint32_t>(&_buffer[0]),
+		txn->len,
+		DMA_SCR_DIR_M2P		|
+		DMA_SCR_MINC		|
+		DMA_SCR_PSIZE_8BITS	|
+		DMA_SCR_MSIZE_8BITS	|
+		DMA_SCR_PBURST_SINGLE	|
+		DMA_SCR_MBURST_SINGLE);
+	stm32_dmastart(_tx_dma, nullptr, nullptr, false);
+
+	/* enable RX before TX as the reference manual asks */
+	SPI_REG(_base, STM32_SPI_CR2_OFFSET) |= SPI_CR2_RXDMAEN;
+	SPI_REG(_base, STM32_SPI_CR2_OFFSET) |= SPI_CR2_TXDMAEN;
+}
+
+void
+SPIBusQueue::complete(int result)
+{
+	SPI::Transaction *txn = _head;
+
+	SPI_REG(_base, STM32_SPI_CR2_OFFSET) &= ~(SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+	stm32_dmastop(_rx_dma);
+	stm32_dmastop(_tx_dma);
+
+	txn->dev->_select(false);
+
+	if ((result == OK) && (txn->recv != nullptr))
+		memcpy(txn->recv, _buffer, txn->len);
+
+	_head = txn->next;
+
+	if (_head == nullptr)
+		_tail = nullptr;
+
+	_active = false;
+	txn->queued = false;
+
+	hrt_abstime now = hrt_absolute_time();
+	txn->dev->_record(txn->len, _started - txn->queued_time, now - _started);
+
+	/* the callback may queue the next transfer of its driver */
+	txn->callback(txn->arg, result);
+
+	if (!_active && (_sync == 0))
+		start_next();
+}
+
+void
+SPIBusQueue::dma_callback(DMA_HANDLE handle, uint8_t status, void *arg)
+{
+	SPIBusQueue *queue = reinterpret_cast<SPIBusQueue *>(arg);
+
+	/* may be a leftover of a transfer completed by sync_begin() */
+	if (!queue->_active || !(status & (DMA_STATUS_TCIF | DMA_STATUS_TEIF)))
+		return;
+
+	queue->complete((status & DMA_STATUS_TEIF) ? -EIO : OK);
+}
+
 SPI::SPI(const char *name,
 	 const char *devname,
 	 int bus,
@@ -73,6 +357,9 @@ SPI::SPI(const char *name,
 	_mode(mode),
 	_frequency(frequency),
 	_dev(nullptr),
+	_queue(nullptr),
+	_profile(nullptr),
+	_transfer_perf(nullptr),
 	_bus(bus)
 {
 	// fill in _device_id fields for a SPI device
@@ -86,6 +373,7 @@ SPI::SPI(const char *name,
 SPI::~SPI()
 {
 	// XXX no way to let go of the bus...
+	perf_free(_transfer_perf);
 }
 
 int
@@ -106,6 +394,22 @@ SPI::init()
 	/* deselect device to ensure high to low transition of pin select */
 	SPI_SELECT(_dev, _device, false);
 
+	/* asynchronous transfers are optional, they fall back to transfer() */
+	_queue = spi_bus_queue(_bus);
+
+	if ((_queue != nullptr) && (_queue->init() != OK))
+		_queue = nullptr;
+
+	/* account the transfers to the bus */
+	if (_profile == nullptr) {
+		_profile = BusProfile::get(DeviceBusType_SPI, _bus);
+
+		if (_profile != nullptr) {
+			snprintf(_transfer_perf_name, sizeof(_transfer_perf_name), "%s_%s", _name, _profile->name());
+			_transfer_perf = perf_alloc(PC_HISTOGRAM, _transfer_perf_name);
+		}
+	}
+
 	/* call the probe function to check whether the device is present */
 	ret = probe();
 
@@ -145,6 +449,13 @@ SPI::transfer(uint8_t *send, uint8_t *recv, unsigned len)
 		return -EINVAL;
 
 	LockMode mode = up_interrupt_context() ? LOCK_NONE : locking_mode;
+	hrt_abstime requested = hrt_absolute_time();
+	hrt_abstime locked;
+	hrt_abstime done;
+
+	/* keep asynchronous transfers off the bus */
+	if (_queue != nullptr)
+		_queue->sync_begin();
 
 	/* lock the bus as required */
 	switch (mode) {
@@ -152,22 +463,58 @@ SPI::transfer(uint8_t *send, uint8_t *recv, unsigned len)
 	case LOCK_PREEMPTION:
 		{
 			irqstate_t state = irqsave();
+			locked = hrt_absolute_time();
 			result = _transfer(send, recv, len);
+			done = hrt_absolute_time();
 			irqrestore(state);
 		}
 		break;
 	case LOCK_THREADS:
 		SPI_LOCK(_dev, true);
+		locked = hrt_absolute_time();
 		result = _transfer(send, recv, len);
+		done = hrt_absolute_time();
 		SPI_LOCK(_dev, false);
 		break;
 	case LOCK_NONE:
+		locked = hrt_absolute_time();
 		result = _transfer(send, recv, len);
+		done = hrt_absolute_time();
 		break;
 	}
+
+	if (_queue != nullptr)
+		_queue->sync_end();
+
+	_record(len, locked - requested, done - locked);
+
 	return result;
 }
 
+int
+SPI::transfer_async(Transaction *txn, uint8_t *send, uint8_t *recv, unsigned len,
+		    transfer_callback_t callback, void *arg)
+{
+	if (_queue == nullptr)
+		return -ENOTSUP;
+
+	if ((len == 0) || (len > SPI_ASYNC_MAX_TRANSFER) || (callback == nullptr))
+		return -EINVAL;
+
+	if (txn->queued)
+		return -EBUSY;
+
+	txn->dev = this;
+	txn->send = send;
+	txn->recv = recv;
+	txn->len = len;
+	txn->callback = callback;
+	txn->arg = arg;
+	txn->queued_time = hrt_absolute_time();
+
+	return _queue->enqueue(txn);
+}
+
 void 
 SPI::set_frequency(uint32_t frequency)
 {
@@ -177,18 +524,34 @@ SPI::set_frequency(uint32_t frequency)
 int
 SPI::_transfer(uint8_t *send, uint8_t *recv, unsigned len)
 {
-	SPI_SETFREQUENCY(_dev, _frequency);
-	SPI_SETMODE(_dev, _mode);
-	SPI_SETBITS(_dev, 8);
-	SPI_SELECT(_dev, _device, true);
+	_select(true);
 
 	/* do the transfer */
 	SPI_EXCHANGE(_dev, send, recv, len);
 
 	/* and clean up */
-	SPI_SELECT(_dev, _device, false);
+	_select(false);
 
 	return OK;
 }
 
+void
+SPI::_record(unsigned len, hrt_abstime wait, hrt_abstime busy)
+{
+	if (_profile != nullptr)
+		_profile->record(len, wait, busy, _transfer_perf);
+}
+
+void
+SPI::_select(bool selected)
+{
+	if (selected) {
+		SPI_SETFREQUENCY(_dev, _frequency);
+		SPI_SETMODE(_dev, _mode);
+		SPI_SETBITS(_dev, 8);
+	}
+
+	SPI_SELECT(_dev, _device, selected);
+}
+
 } // namespace device
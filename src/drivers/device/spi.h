@@ -43,10 +43,18 @@
 #include "device.h"
 
 #include <nuttx/spi.h>
+#include <drivers/drv_hrt.h>
+#include <systemlib/perf_counter.h>
+
+/** largest asynchronous transfer, the bytes go through a bounce buffer */
+#define SPI_ASYNC_MAX_TRANSFER	64
 
 namespace device __EXPORT
 {
 
+class SPIBusQueue;
+class BusProfile;
+
 /**
  * Abstract class for character device on SPI
  */
@@ -101,6 +109,72 @@ protected:
 	 */
 	int		transfer(uint8_t *send, uint8_t *recv, unsigned len);
 
+	/**
+	 * Completion callback for an asynchronous transfer.
+	 *
+	 * Called from interrupt context once the transfer has finished.
+	 *
+	 * @param arg		The argument passed to transfer_async().
+	 * @param result	OK if the exchange was successful, -errno
+	 *			otherwise.
+	 */
+	typedef void	(*transfer_callback_t)(void *arg, int result);
+
+	/**
+	 * State of one asynchronous transfer, owned by the caller.
+	 */
+	struct Transaction {
+		SPI			*dev;
+		uint8_t			*send;
+		uint8_t			*recv;
+		unsigned		len;
+		transfer_callback_t	callback;
+		void			*arg;
+		Transaction		*next;
+		volatile bool		queued;
+		hrt_abstime		queued_time;	/**< when it was queued, for the bus profile */
+
+		Transaction() :
+			dev(nullptr),
+			send(nullptr),
+			recv(nullptr),
+			len(0),
+			callback(nullptr),
+			arg(nullptr),
+			next(nullptr),
+			queued(false),
+			queued_time(0)
+		{}
+	};
+
+	/**
+	 * Queue a SPI transfer that is run by DMA.
+	 *
+	 * The transfers on a bus run in the order they were queued. The bus
+	 * is only locked against preemption while a transfer is set up and
+	 * completed, not while the bytes are exchanged. Safe to call from
+	 * interrupt context, e.g. from a hrt_call.
+	 *
+	 * The frequency set with set_frequency() when the transfer is queued
+	 * is used. The buffers and txn must stay valid until the callback
+	 * has run.
+	 *
+	 * @param txn		Transfer state, must not be queued already.
+	 * @param send		Bytes to send to the device, or nullptr if
+	 *			no data is to be sent.
+	 * @param recv		Buffer for receiving bytes from the device,
+	 *			or nullptr if no bytes are to be received.
+	 * @param len		Number of bytes to transfer, at most
+	 *			SPI_ASYNC_MAX_TRANSFER.
+	 * @param callback	Called from interrupt context on completion.
+	 * @param arg		Passed to the callback.
+	 * @return		OK if the transfer was queued, -ENOTSUP if
+	 *			the bus has no DMA, -EBUSY if txn is still
+	 *			queued, -errno otherwise.
+	 */
+	int		transfer_async(Transaction *txn, uint8_t *send, uint8_t *recv, unsigned len,
+				       transfer_callback_t callback, void *arg);
+
 	/**
 	 * Set the SPI bus frequency
 	 * This is used to change frequency on the fly. Some sensors
@@ -128,6 +202,12 @@ private:
 	enum spi_mode_e		_mode;
 	uint32_t		_frequency;
 	struct spi_dev_s	*_dev;
+	SPIBusQueue		*_queue;	/**< DMA transfer queue of the bus, if any */
+	BusProfile		*_profile;	/**< statistics of the bus */
+	perf_counter_t		_transfer_perf;	/**< transfer latency of this device */
+	char			_transfer_perf_name[24];
+
+	friend class SPIBusQueue;
 
 	/* this class does not allow copying */
 	SPI(const SPI&);
@@ -138,6 +218,20 @@ protected:
 
 	int	_transfer(uint8_t *send, uint8_t *recv, unsigned len);
 
+	/**
+	 * Add a transfer to the bus statistics.
+	 *
+	 * @param len		Bytes moved.
+	 * @param wait		Time spent waiting for the bus.
+	 * @param busy		Time the transfer occupied the bus.
+	 */
+	void	_record(unsigned len, hrt_abstime wait, hrt_abstime busy);
+
+	/**
+	 * Configure the bus for this device and select it, or deselect it.
+	 */
+	void	_select(bool selected);
+
 };
 
 } // namespace device
@@ -66,6 +66,11 @@ struct accel_report {
 	int16_t y_raw;
 	int16_t z_raw;
 	int16_t temperature_raw;
+
+	float x_integral;	/**< delta velocity in the NED X board axis in m/s over integral_dt */
+	float y_integral;	/**< delta velocity in the NED Y board axis in m/s over integral_dt */
+	float z_integral;	/**< delta velocity in the NED Z board axis in m/s over integral_dt */
+	uint64_t integral_dt;	/**< integration time in us, 0 if the report closes no integral */
 };
 
 /** accel scaling factors; Vout = Vscale * (Vin + Voffset) */
@@ -79,11 +84,9 @@ struct accel_scale {
 };
 
 /*
- * ObjDev tag for raw accelerometer data.
+ * ObjDev tag for raw accelerometer data, one instance per accelerometer.
  */
-ORB_DECLARE(sensor_accel0);
-ORB_DECLARE(sensor_accel1);
-ORB_DECLARE(sensor_accel2);
+ORB_DECLARE(sensor_accel);
 
 /*
  * ioctl() definitions
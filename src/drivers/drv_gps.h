@@ -53,6 +53,7 @@
 #endif
 
 #define GPS_DEVICE_PATH	"/dev/gps"
+#define GPS_SECONDARY_DEVICE_PATH	"/dev/gps1"
 
 typedef enum {
 	GPS_DRIVER_MODE_NONE = 0,
@@ -66,6 +66,11 @@ struct gyro_report {
 	int16_t y_raw;
 	int16_t z_raw;
 	int16_t temperature_raw;
+
+	float x_integral;	/**< coning corrected delta angle about the NED X board axis in rad over integral_dt */
+	float y_integral;	/**< coning corrected delta angle about the NED Y board axis in rad over integral_dt */
+	float z_integral;	/**< coning corrected delta angle about the NED Z board axis in rad over integral_dt */
+	uint64_t integral_dt;	/**< integration time in us, 0 if the report closes no integral */
 };
 
 /** gyro scaling factors; Vout = (Vin * Vscale) + Voffset */
@@ -79,11 +84,9 @@ struct gyro_scale {
 };
 
 /*
- * ObjDev tag for raw gyro data.
+ * ObjDev tag for raw gyro data, one instance per gyro.
  */
-ORB_DECLARE(sensor_gyro0);
-ORB_DECLARE(sensor_gyro1);
-ORB_DECLARE(sensor_gyro2);
+ORB_DECLARE(sensor_gyro);
 
 /*
  * ioctl() definitions
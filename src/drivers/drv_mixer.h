@@ -108,6 +108,71 @@ struct mixer_simple_s {
  */
 #define MIXERIOCLOADBUF		_MIXERIOC(5)
 
+/*
+ * Binary mixer descriptions.
+ *
+ * Generated from the text format by Tools/px_mixer_bin.py, these load
+ * without any parsing. A description is a sequence of records, each
+ * starting with its type; zero bytes between records are padding. Values
+ * are little-endian and encoded as in the text format, scaled by 10000.
+ *
+ * Binary mixer files start with MIXER_BIN_MAGIC, followed by the records.
+ */
+#define MIXER_BIN_MAGIC		"PXM1"
+#define MIXER_BIN_MAGIC_LEN	4
+
+#define MIXER_BIN_PAD		0x00	/**< padding, skipped */
+#define MIXER_BIN_NULL		0x01	/**< null mixer, the type byte only */
+#define MIXER_BIN_SIMPLE	0x02	/**< mixer_bin_simple_s, then control_count mixer_bin_control_s */
+#define MIXER_BIN_MULTIROTOR	0x03	/**< mixer_bin_multirotor_s */
+
+#pragma pack(push, 1)
+/** binary channel scaler */
+struct mixer_bin_scaler_s {
+	int16_t			negative_scale;
+	int16_t			positive_scale;
+	int16_t			offset;
+	int16_t			min_output;
+	int16_t			max_output;
+};
+
+/** binary simple mixer */
+struct mixer_bin_simple_s {
+	uint8_t			type;		/**< MIXER_BIN_SIMPLE */
+	uint8_t			control_count;	/**< number of mixer_bin_control_s following */
+	struct mixer_bin_scaler_s output_scaler;
+};
+
+/** binary simple mixer input */
+struct mixer_bin_control_s {
+	uint8_t			control_group;
+	uint8_t			control_index;
+	struct mixer_bin_scaler_s scaler;
+};
+
+/** binary multirotor mixer */
+struct mixer_bin_multirotor_s {
+	uint8_t			type;		/**< MIXER_BIN_MULTIROTOR */
+	uint8_t			geometry;	/**< MultirotorMixer::Geometry */
+	uint8_t			desaturation;	/**< MultirotorMixer::Desaturation */
+	int16_t			roll_scale;
+	int16_t			pitch_scale;
+	int16_t			yaw_scale;
+	int16_t			idle_speed;
+};
+#pragma pack(pop)
+
+/** a binary mixer description in memory, without the file magic */
+struct mixer_bin_buf_s {
+	const void		*data;
+	unsigned		length;
+};
+
+/**
+ * Add mixer(s) from the binary description in (const struct mixer_bin_buf_s *)arg
+ */
+#define MIXERIOCLOADBIN		_MIXERIOC(6)
+
 /*
  * XXX Thoughts for additional operations:
  *
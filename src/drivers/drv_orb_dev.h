@@ -84,4 +84,41 @@
 /** Get the global advertiser handle for the topic */
 #define ORBIOCGADVERTISER	_ORBIOC(13)
 
+/** Get the in-place reader handle for the subscription */
+#define ORBIOCGREADER		_ORBIOC(14)
+
+/** Set the queue depth of the topic to (unsigned)arg, only possible before the first publication */
+#define ORBIOCSETQUEUESIZE	_ORBIOC(15)
+
+/** Become the first advertiser of a multi-instance topic node, fails with EBUSY if already advertised */
+#define ORBIOCCLAIM		_ORBIOC(17)
+
+/** Set the work queue callback of the subscription, arg is (struct orb_callback_reg *) */
+#define ORBIOCSETCALLBACK	_ORBIOC(18)
+
+/** argument for ORBIOCSETCALLBACK */
+struct orb_callback_reg {
+	orb_callback_t	callback;	/**< function to run on HPWORK, or NULL to remove */
+	void		*arg;		/**< argument passed to callback */
+};
+
+/** Copy the oldest unread publication, arg is (struct orb_queued_copy *) */
+#define ORBIOCCOPYQUEUED	_ORBIOC(16)
+
+/** argument for ORBIOCCOPYQUEUED */
+struct orb_queued_copy {
+	void		*buffer;	/**< destination, or NULL to skip one publication */
+	unsigned	dropped;	/**< returns the number of publications lost since the last copy */
+};
+
+/** Copy the retained publication nearest to a time, arg is (struct orb_nearest_copy *) */
+#define ORBIOCCOPYNEAREST	_ORBIOC(19)
+
+/** argument for ORBIOCCOPYNEAREST */
+struct orb_nearest_copy {
+	void		*buffer;	/**< destination */
+	uint64_t	time;		/**< time to look up */
+	uint64_t	sample_time;	/**< returns the time the copied publication was made */
+};
+
 #endif /* _DRV_UORB_H */
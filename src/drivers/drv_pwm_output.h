@@ -99,6 +99,28 @@ __BEGIN_DECLS
  */
 #define PWM_IGNORE_THIS_CHANNEL UINT16_MAX
 
+/**
+ * Update rate selecting OneShot125 output: one pulse of an eighth of
+ * the set width per up_pwm_servo_trigger(), rather than a fixed rate.
+ */
+#define PWM_RATE_ONESHOT	0
+
+/**
+ * Update rates selecting DShot digital ESC frames at 150, 300 or 600
+ * kbit/s: one frame throttling from the set pulse width per
+ * up_pwm_servo_trigger(). Only for rate groups the board updates by DMA.
+ */
+#define PWM_RATE_DSHOT150	150000
+#define PWM_RATE_DSHOT300	300000
+#define PWM_RATE_DSHOT600	600000
+
+#define PWM_RATE_IS_DSHOT(_rate)	(((_rate) == PWM_RATE_DSHOT150) || \
+					 ((_rate) == PWM_RATE_DSHOT300) || \
+					 ((_rate) == PWM_RATE_DSHOT600))
+
+/** rates sending outputs on up_pwm_servo_trigger() rather than at a fixed rate */
+#define PWM_RATE_IS_TRIGGERED(_rate)	(((_rate) == PWM_RATE_ONESHOT) || PWM_RATE_IS_DSHOT(_rate))
+
 /**
  * Servo output signal type, value is actual servo output pulse
  * width in microseconds.
@@ -117,6 +139,19 @@ struct pwm_output_values {
 	unsigned			channel_count;
 };
 
+/**
+ * Speed loop on the motor outputs, see PWM_SERVO_SET_RPM_CONTROL.
+ */
+struct pwm_rpm_control {
+	/** outputs driving motors, one bit per output; zero disables the loop */
+	uint32_t	motors;
+	/** motor speed at full throttle */
+	float		rpm_max;
+	/** proportional and integral gain, on the speed relative to rpm_max */
+	float		p;
+	float		i;
+};
+
 /*
  * ORB tag for PWM outputs.
  */
@@ -216,6 +251,15 @@ ORB_DECLARE(output_pwm);
 /** force safety switch on (to enable use of safety switch) */
 #define PWM_SERVO_SET_FORCE_SAFETY_ON  _IOC(_PWM_SERVO_BASE, 26)
 
+/** mix and send outputs at a fixed rate in Hz instead of on every control update, 0 to go back */
+#define PWM_SERVO_SET_OUTPUT_RATE	_IOC(_PWM_SERVO_BASE, 27)
+
+/** at a fixed output rate, extrapolate the attitude controls to the output time (arg 1) or hold them (arg 0) */
+#define PWM_SERVO_SET_EXTRAPOLATION	_IOC(_PWM_SERVO_BASE, 28)
+
+/** close a speed loop on the motor outputs from the esc_status telemetry, see struct pwm_rpm_control */
+#define PWM_SERVO_SET_RPM_CONTROL	_IOC(_PWM_SERVO_BASE, 29)
+
 /*
  *
  *
@@ -291,11 +335,22 @@ __EXPORT extern uint32_t up_pwm_servo_get_rate_group(unsigned group);
  * Set the update rate for a given rate group.
  *
  * @param group		The rate group whose update rate will be changed.
- * @param rate		The update rate in Hz.
+ * @param rate		The update rate in Hz, PWM_RATE_ONESHOT or a PWM_RATE_DSHOT rate.
  * @return		OK if the group was adjusted, -ERANGE if an unsupported update rate is set.
  */
 __EXPORT extern int	up_pwm_servo_set_rate_group_update(unsigned group, unsigned rate);
 
+/**
+ * Send the values set since the previous trigger.
+ *
+ * Starts a pulse on all armed OneShot rate groups; without triggers they
+ * repeat the last pulse every few milliseconds. Sends a frame on DShot
+ * rate groups. Rate groups at a fixed rate the board updates by DMA load
+ * all their channels together at their next period, until triggered they
+ * keep the previous values. Other fixed rate groups are not affected.
+ */
+__EXPORT extern void	up_pwm_servo_trigger(void);
+
 /**
  * Set the current output value for a channel.
  *
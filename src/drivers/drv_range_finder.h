@@ -48,6 +48,7 @@
 
 enum RANGE_FINDER_TYPE {
 	RANGE_FINDER_TYPE_LASER = 0,
+	RANGE_FINDER_TYPE_ULTRASOUND = 1,
 };
 
 /**
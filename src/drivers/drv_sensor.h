@@ -86,4 +86,16 @@
  */
 #define SENSORIOCRESET		_SENSORIOC(4)
 
+/**
+ * Set the integration interval to (arg) microseconds.
+ *
+ * Reports are then published once per interval, carrying the integral
+ * over it. With 0 every published report carries the integral since
+ * the previous one.
+ */
+#define SENSORIOCSINTEGRATION	_SENSORIOC(5)
+
+/** return the integration interval in microseconds */
+#define SENSORIOCGINTEGRATION	_SENSORIOC(6)
+
 #endif /* _DRV_SENSOR_H */
\ No newline at end of file
@@ -61,6 +61,7 @@
 
 #include <board_config.h>
 
+#include <systemlib/work_profile.h>
 #include <systemlib/airspeed.h>
 #include <systemlib/err.h>
 #include <systemlib/param/param.h>
@@ -227,11 +228,12 @@ ETSAirspeed::cycle()
 		if (_measure_ticks > USEC2TICK(CONVERSION_INTERVAL)) {
 
 			/* schedule a fresh cycle call when we are ready to measure again */
-			work_queue(HPWORK,
-				   &_work,
-				   (worker_t)&Airspeed::cycle_trampoline,
-				   this,
-				   _measure_ticks - USEC2TICK(CONVERSION_INTERVAL));
+			work_queue_profiled(HPWORK,
+				            &_work,
+				            (worker_t)&Airspeed::cycle_trampoline,
+				            this,
+				            _measure_ticks - USEC2TICK(CONVERSION_INTERVAL),
+				            "ets_airspeed");
 
 			return;
 		}
@@ -249,11 +251,12 @@ ETSAirspeed::cycle()
 	_collect_phase = true;
 
 	/* schedule a fresh cycle call when the measurement is done */
-	work_queue(HPWORK,
-		   &_work,
-		   (worker_t)&Airspeed::cycle_trampoline,
-		   this,
-		   USEC2TICK(CONVERSION_INTERVAL));
+	work_queue_profiled(HPWORK,
+		            &_work,
+		            (worker_t)&Airspeed::cycle_trampoline,
+		            this,
+		            USEC2TICK(CONVERSION_INTERVAL),
+		            "ets_airspeed");
 }
 
 /**
@@ -42,6 +42,7 @@
 
 #include "frsky_data.h"
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -90,11 +91,33 @@
 
 #define frac(f) (f - (int)f)
 
+/* largest frame: 14 values of a start byte and three bytes, all stuffed, plus the stop byte */
+#define FRSKY_FRAME_MAX		(14 * 7 + 1)
+
+/**
+ * A frame encoded ahead, sent with a single write.
+ */
+struct frsky_frame {
+	uint8_t data[FRSKY_FRAME_MAX];
+	unsigned len;
+	bool valid;
+};
+
+static struct frsky_frame frame1;
+static struct frsky_frame frame2;
+static struct frsky_frame frame3;
+
+/* time at which the position in frame 2 goes stale */
+static hrt_abstime frame2_valid_until;
+
 static int battery_sub = -1;
 static int sensor_sub = -1;
 static int global_position_sub = -1;
 static int vehicle_status_sub = -1;
 
+/* frame 3 has its own, so that frame 2 does not clear its updates */
+static int gps_time_sub = -1;
+
 /**
  * Initializes the uORB subscriptions.
  */
@@ -104,53 +127,84 @@ void frsky_init()
 	global_position_sub = orb_subscribe(ORB_ID(vehicle_global_position));
 	sensor_sub = orb_subscribe(ORB_ID(sensor_combined));
 	vehicle_status_sub = orb_subscribe(ORB_ID(vehicle_status));
+	gps_time_sub = orb_subscribe(ORB_ID(vehicle_global_position));
+}
+
+static bool frsky_updated(int sub)
+{
+	bool updated = false;
+	orb_check(sub, &updated);
+	return updated;
 }
 
 /**
- * Sends a 0x5E start/stop byte.
+ * Appends a 0x5E start/stop byte.
  */
-static void frsky_send_startstop(int uart)
+static void frsky_send_startstop(struct frsky_frame *frame)
 {
-	static const uint8_t c = 0x5E;
-	write(uart, &c, sizeof(c));
+	frame->data[frame->len++] = 0x5E;
 }
 
 /**
- * Sends one byte, performing byte-stuffing if necessary.
+ * Appends one byte, performing byte-stuffing if necessary.
  */
-static void frsky_send_byte(int uart, uint8_t value)
+static void frsky_send_byte(struct frsky_frame *frame, uint8_t value)
 {
-	const uint8_t x5E[] = { 0x5D, 0x3E };
-	const uint8_t x5D[] = { 0x5D, 0x3D };
-
 	switch (value) {
 	case 0x5E:
-		write(uart, x5E, sizeof(x5E));
+		frame->data[frame->len++] = 0x5D;
+		frame->data[frame->len++] = 0x3E;
 		break;
 
 	case 0x5D:
-		write(uart, x5D, sizeof(x5D));
+		frame->data[frame->len++] = 0x5D;
+		frame->data[frame->len++] = 0x3D;
 		break;
 
 	default:
-		write(uart, &value, sizeof(value));
+		frame->data[frame->len++] = value;
 		break;
 	}
 }
 
 /**
- * Sends one data id/value pair.
+ * Appends one data id/value pair.
  */
-static void frsky_send_data(int uart, uint8_t id, int16_t data)
+static void frsky_send_data(struct frsky_frame *frame, uint8_t id, int16_t data)
 {
 	/* Cast data to unsigned, because signed shift might behave incorrectly */
 	uint16_t udata = data;
 
-	frsky_send_startstop(uart);
+	frsky_send_startstop(frame);
 
-	frsky_send_byte(uart, id);
-	frsky_send_byte(uart, udata);      /* LSB */
-	frsky_send_byte(uart, udata >> 8); /* MSB */
+	frsky_send_byte(frame, id);
+	frsky_send_byte(frame, udata);      /* LSB */
+	frsky_send_byte(frame, udata >> 8); /* MSB */
+}
+
+/**
+ * Starts encoding a frame.
+ */
+static void frsky_frame_begin(struct frsky_frame *frame)
+{
+	frame->len = 0;
+}
+
+/**
+ * Finishes a frame and marks it ready to send.
+ */
+static void frsky_frame_end(struct frsky_frame *frame)
+{
+	frsky_send_startstop(frame);
+	frame->valid = true;
+}
+
+/**
+ * Writes out a ready frame.
+ */
+static void frsky_frame_send(int uart, const struct frsky_frame *frame)
+{
+	write(uart, frame->data, frame->len);
 }
 
 /**
@@ -159,6 +213,12 @@ static void frsky_send_data(int uart, uint8_t id, int16_t data)
  */
 void frsky_send_frame1(int uart)
 {
+	/* the frame only changes with its topics, resend it else */
+	if (frame1.valid && !frsky_updated(sensor_sub) && !frsky_updated(battery_sub)) {
+		frsky_frame_send(uart, &frame1);
+		return;
+	}
+
 	/* get a local copy of the current sensor values */
 	struct sensor_combined_s raw;
 	memset(&raw, 0, sizeof(raw));
@@ -169,28 +229,30 @@ void frsky_send_frame1(int uart)
 	memset(&battery, 0, sizeof(battery));
 	orb_copy(ORB_ID(battery_status), battery_sub, &battery);
 
-	/* send formatted frame */
-	frsky_send_data(uart, FRSKY_ID_ACCEL_X,
+	/* encode and send the frame */
+	frsky_frame_begin(&frame1);
+	frsky_send_data(&frame1, FRSKY_ID_ACCEL_X,
 			roundf(raw.accelerometer_m_s2[0] * 1000.0f));
-	frsky_send_data(uart, FRSKY_ID_ACCEL_Y,
+	frsky_send_data(&frame1, FRSKY_ID_ACCEL_Y,
 			roundf(raw.accelerometer_m_s2[1] * 1000.0f));
-	frsky_send_data(uart, FRSKY_ID_ACCEL_Z,
+	frsky_send_data(&frame1, FRSKY_ID_ACCEL_Z,
 			roundf(raw.accelerometer_m_s2[2] * 1000.0f));
 
-	frsky_send_data(uart, FRSKY_ID_BARO_ALT_BP,
+	frsky_send_data(&frame1, FRSKY_ID_BARO_ALT_BP,
 			raw.baro_alt_meter);
-	frsky_send_data(uart, FRSKY_ID_BARO_ALT_AP,
+	frsky_send_data(&frame1, FRSKY_ID_BARO_ALT_AP,
 			roundf(frac(raw.baro_alt_meter) * 100.0f));
 
-	frsky_send_data(uart, FRSKY_ID_TEMP1,
+	frsky_send_data(&frame1, FRSKY_ID_TEMP1,
 			roundf(raw.baro_temp_celcius));
 
-	frsky_send_data(uart, FRSKY_ID_VFAS,
+	frsky_send_data(&frame1, FRSKY_ID_VFAS,
 			roundf(battery.voltage_v * 10.0f));
-	frsky_send_data(uart, FRSKY_ID_CURRENT,
+	frsky_send_data(&frame1, FRSKY_ID_CURRENT,
 			(battery.current_a < 0) ? 0 : roundf(battery.current_a * 10.0f));
 
-	frsky_send_startstop(uart);
+	frsky_frame_end(&frame1);
+	frsky_frame_send(uart, &frame1);
 }
 
 /**
@@ -208,6 +270,13 @@ static float frsky_format_gps(float dec)
  */
 void frsky_send_frame2(int uart)
 {
+	/* the frame only changes with its topics or once the position goes stale, resend it else */
+	if (frame2.valid && !frsky_updated(global_position_sub) && !frsky_updated(vehicle_status_sub) &&
+	    (frame2_valid_until == 0 || hrt_absolute_time() < frame2_valid_until)) {
+		frsky_frame_send(uart, &frame2);
+		return;
+	}
+
 	/* get a local copy of the global position data */
 	struct vehicle_global_position_s global_pos;
 	memset(&global_pos, 0, sizeof(global_pos));
@@ -218,7 +287,8 @@ void frsky_send_frame2(int uart)
 	memset(&vehicle_status, 0, sizeof(vehicle_status));
 	orb_copy(ORB_ID(vehicle_status), vehicle_status_sub, &vehicle_status);
 
-	/* send formatted frame */
+	/* encode and send the frame */
+	frsky_frame_begin(&frame2);
 	float course = 0, lat = 0, lon = 0, speed = 0, alt = 0;
 	char lat_ns = 0, lon_ew = 0;
 	int sec = 0;
@@ -235,31 +305,37 @@ void frsky_send_frame2(int uart)
 				* 25.0f / 46.0f;
 		alt    = global_pos.alt;
 		sec    = tm_gps->tm_sec;
+
+		frame2_valid_until = global_pos.timestamp + 20000;
+
+	} else {
+		frame2_valid_until = 0;
 	}
 
-	frsky_send_data(uart, FRSKY_ID_GPS_COURS_BP, course);
-	frsky_send_data(uart, FRSKY_ID_GPS_COURS_AP, frac(course) * 1000.0f);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_COURS_BP, course);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_COURS_AP, frac(course) * 1000.0f);
 
-	frsky_send_data(uart, FRSKY_ID_GPS_LAT_BP, lat);
-	frsky_send_data(uart, FRSKY_ID_GPS_LAT_AP, frac(lat) * 10000.0f);
-	frsky_send_data(uart, FRSKY_ID_GPS_LAT_NS, lat_ns);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_LAT_BP, lat);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_LAT_AP, frac(lat) * 10000.0f);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_LAT_NS, lat_ns);
 
-	frsky_send_data(uart, FRSKY_ID_GPS_LONG_BP, lon);
-	frsky_send_data(uart, FRSKY_ID_GPS_LONG_AP, frac(lon) * 10000.0f);
-	frsky_send_data(uart, FRSKY_ID_GPS_LONG_EW, lon_ew);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_LONG_BP, lon);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_LONG_AP, frac(lon) * 10000.0f);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_LONG_EW, lon_ew);
 
-	frsky_send_data(uart, FRSKY_ID_GPS_SPEED_BP, speed);
-	frsky_send_data(uart, FRSKY_ID_GPS_SPEED_AP, frac(speed) * 100.0f);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_SPEED_BP, speed);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_SPEED_AP, frac(speed) * 100.0f);
 
-	frsky_send_data(uart, FRSKY_ID_GPS_ALT_BP, alt);
-	frsky_send_data(uart, FRSKY_ID_GPS_ALT_AP, frac(alt) * 100.0f);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_ALT_BP, alt);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_ALT_AP, frac(alt) * 100.0f);
 
-	frsky_send_data(uart, FRSKY_ID_FUEL,
+	frsky_send_data(&frame2, FRSKY_ID_FUEL,
 			roundf(vehicle_status.battery_remaining * 100.0f));
 
-	frsky_send_data(uart, FRSKY_ID_GPS_SEC, sec);
+	frsky_send_data(&frame2, FRSKY_ID_GPS_SEC, sec);
 
-	frsky_send_startstop(uart);
+	frsky_frame_end(&frame2);
+	frsky_frame_send(uart, &frame2);
 }
 
 /**
@@ -268,19 +344,27 @@ void frsky_send_frame2(int uart)
  */
 void frsky_send_frame3(int uart)
 {
-	/* get a local copy of the battery data */
+	/* the frame only changes with its topic, resend it else */
+	if (frame3.valid && !frsky_updated(gps_time_sub)) {
+		frsky_frame_send(uart, &frame3);
+		return;
+	}
+
+	/* get a local copy of the global position data */
 	struct vehicle_global_position_s global_pos;
 	memset(&global_pos, 0, sizeof(global_pos));
-	orb_copy(ORB_ID(vehicle_global_position), global_position_sub, &global_pos);
+	orb_copy(ORB_ID(vehicle_global_position), gps_time_sub, &global_pos);
 
-	/* send formatted frame */
+	/* encode and send the frame */
+	frsky_frame_begin(&frame3);
 	time_t time_gps = global_pos.time_gps_usec / 1000000;
 	struct tm *tm_gps = gmtime(&time_gps);
 	uint16_t hour_min = (tm_gps->tm_min << 8) | (tm_gps->tm_hour & 0xff);
-	frsky_send_data(uart, FRSKY_ID_GPS_DAY_MONTH, tm_gps->tm_mday);
-	frsky_send_data(uart, FRSKY_ID_GPS_YEAR, tm_gps->tm_year);
-	frsky_send_data(uart, FRSKY_ID_GPS_HOUR_MIN, hour_min);
-	frsky_send_data(uart, FRSKY_ID_GPS_SEC, tm_gps->tm_sec);
+	frsky_send_data(&frame3, FRSKY_ID_GPS_DAY_MONTH, tm_gps->tm_mday);
+	frsky_send_data(&frame3, FRSKY_ID_GPS_YEAR, tm_gps->tm_year);
+	frsky_send_data(&frame3, FRSKY_ID_GPS_HOUR_MIN, hour_min);
+	frsky_send_data(&frame3, FRSKY_ID_GPS_SEC, tm_gps->tm_sec);
 
-	frsky_send_startstop(uart);
+	frsky_frame_end(&frame3);
+	frsky_frame_send(uart, &frame3);
 }
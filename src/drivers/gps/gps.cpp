@@ -56,6 +56,7 @@
 #include <arch/board/board.h>
 #include <drivers/drv_hrt.h>
 #include <drivers/device/i2c.h>
+#include <drivers/device/ringbuffer.h>
 #include <systemlib/systemlib.h>
 #include <systemlib/perf_counter.h>
 #include <systemlib/scheduling_priorities.h>
@@ -70,9 +71,12 @@
 #include "ubx.h"
 #include "mtk.h"
 #include "ashtech.h"
+#include "gps_blend.h"
 
 
 #define TIMEOUT_5HZ 500
+#define INJECT_BUFFER_SIZE 1024		/* a second of multi constellation RTCM3 corrections */
+#define RAW_BUFFER_SIZE 4096		/* a few epochs of raw measurements, for a reader that falls behind */
 #define RATE_MEASUREMENT_PERIOD 5000000
 
 /* oddly, ERROR is not defined for c++ */
@@ -92,13 +96,24 @@ public:
 class GPS : public device::CDev
 {
 public:
-	GPS(const char *uart_path, bool fake_gps, bool enable_sat_info);
+	GPS(const char *uart_path, bool fake_gps, bool enable_sat_info, unsigned ubx_rate, bool enable_raw,
+	    unsigned instance);
 	virtual ~GPS();
 
 	virtual int			init();
 
 	virtual int			ioctl(struct file *filp, int cmd, unsigned long arg);
 
+	/**
+	 * Read the unparsed receiver data, with raw measurements if the receiver has them.
+	 */
+	virtual ssize_t			read(struct file *filp, char *buffer, size_t buflen);
+
+	/**
+	 * Queue correction data (e.g. RTCM) to be sent to the receiver.
+	 */
+	virtual ssize_t			write(struct file *filp, const char *buffer, size_t buflen);
+
 	/**
 	 * Diagnostics - print some basic information about the driver.
 	 */
@@ -106,6 +121,7 @@ public:
 
 private:
 
+	unsigned			_instance;					///< receiver number, 0 for the primary
 	bool				_task_should_exit;				///< flag to make the main worker task exit
 	int				_serial_fd;					///< serial interface to GPS
 	unsigned			_baudrate;					///< current baudrate
@@ -119,10 +135,15 @@ private:
 	GPS_Sat_Info			*_Sat_Info;					///< instance of GPS sat info data object
 	struct vehicle_gps_position_s	_report_gps_pos;				///< uORB topic for gps position
 	orb_advert_t			_report_gps_pos_pub;				///< uORB pub for gps position
+	orb_advert_t			_report_sensor_gps_pub;				///< uORB pub for this receiver's own position
 	struct satellite_info_s		*_p_report_sat_info;				///< pointer to uORB topic for satellite info
 	orb_advert_t			_report_sat_info_pub;				///< uORB pub for satellite info
 	float				_rate;						///< position update rate
 	bool				_fake_gps;					///< fake gps output
+	unsigned			_ubx_rate;					///< requested UBX measurement rate in Hz
+	RingBuffer			*_inject_buf;					///< corrections to be sent to the GPS
+	RingBuffer			*_raw_buf;					///< data read from the GPS, for read()
+	unsigned			_raw_dropped;					///< raw bytes lost to a full _raw_buf
 
 
 	/**
@@ -133,7 +154,7 @@ private:
 	/**
 	 * Trampoline to the worker task
 	 */
-	static void			task_main_trampoline(void *arg);
+	static int			task_main_trampoline(int argc, char *argv[]);
 
 
 	/**
@@ -146,6 +167,27 @@ private:
 	 */
 	int				set_baudrate(unsigned baud);
 
+	/**
+	 * Publish the position of this receiver, and the blend of all
+	 */
+	void				publish();
+
+	/**
+	 * Send the queued corrections to the GPS
+	 */
+	void				inject();
+
+	/**
+	 * Store the data read by the GPS helper for read()
+	 */
+	static void			raw_output_trampoline(void *ctx, const uint8_t *buf, unsigned len);
+	void				raw_output(const uint8_t *buf, unsigned len);
+
+	/**
+	 * Report POLLIN while there is raw data to read
+	 */
+	virtual pollevent_t		poll_state(struct file *filp);
+
 	/**
 	 * Send a reset command to the GPS
 	 */
@@ -162,13 +204,19 @@ extern "C" __EXPORT int gps_main(int argc, char *argv[]);
 namespace
 {
 
-GPS	*g_dev;
+GPS	*g_dev[GPS_BLEND_MAX_INSTANCES];
+GPS_Blend *g_blend;	///< only with more than one receiver
+
+const char *const gps_device_path[GPS_BLEND_MAX_INSTANCES] = {GPS_DEVICE_PATH, GPS_SECONDARY_DEVICE_PATH};
+const char *const gps_task_name[GPS_BLEND_MAX_INSTANCES] = {"gps", "gps1"};
 
 }
 
 
-GPS::GPS(const char *uart_path, bool fake_gps, bool enable_sat_info) :
-	CDev("gps", GPS_DEVICE_PATH),
+GPS::GPS(const char *uart_path, bool fake_gps, bool enable_sat_info, unsigned ubx_rate, bool enable_raw,
+	 unsigned instance) :
+	CDev("gps", gps_device_path[instance]),
+	_instance(instance),
 	_task_should_exit(false),
 	_healthy(false),
 	_mode_changed(false),
@@ -176,10 +224,15 @@ GPS::GPS(const char *uart_path, bool fake_gps, bool enable_sat_info) :
 	_Helper(nullptr),
 	_Sat_Info(nullptr),
 	_report_gps_pos_pub(-1),
+	_report_sensor_gps_pub(-1),
 	_p_report_sat_info(nullptr),
 	_report_sat_info_pub(-1),
 	_rate(0.0f),
-	_fake_gps(fake_gps)
+	_fake_gps(fake_gps),
+	_ubx_rate(ubx_rate),
+	_inject_buf(nullptr),
+	_raw_buf(nullptr),
+	_raw_dropped(0)
 {
 	/* store port name */
 	strncpy(_port, uart_path, sizeof(_port));
@@ -187,7 +240,7 @@ GPS::GPS(const char *uart_path, bool fake_gps, bool enable_sat_info) :
 	_port[sizeof(_port) - 1] = '\0';
 
 	/* we need this potentially before it could be set in task_main */
-	g_dev = this;
+	g_dev[_instance] = this;
 	memset(&_report_gps_pos, 0, sizeof(_report_gps_pos));
 
 	/* create satellite info data object if requested */
@@ -197,6 +250,12 @@ GPS::GPS(const char *uart_path, bool fake_gps, bool enable_sat_info) :
 		memset(_p_report_sat_info, 0, sizeof(*_p_report_sat_info));
 	}
 
+	/* create the buffers for correction injection and raw data if requested */
+	if (enable_raw) {
+		_inject_buf = new RingBuffer(INJECT_BUFFER_SIZE, 1);
+		_raw_buf = new RingBuffer(RAW_BUFFER_SIZE, 1);
+	}
+
 	_debug_enabled = true;
 }
 
@@ -215,7 +274,13 @@ GPS::~GPS()
 	if (_task != -1)
 		task_delete(_task);
 
-	g_dev = nullptr;
+	if (_inject_buf != nullptr)
+		delete _inject_buf;
+
+	if (_raw_buf != nullptr)
+		delete _raw_buf;
+
+	g_dev[_instance] = nullptr;
 
 }
 
@@ -229,8 +294,14 @@ GPS::init()
 		goto out;
 
 	/* start the GPS driver worker task */
-	_task = task_spawn_cmd("gps", SCHED_DEFAULT,
-				SCHED_PRIORITY_SLOW_DRIVER, 1500, (main_t)&GPS::task_main_trampoline, nullptr);
+	{
+		/* the task finds its instance from the argument */
+		char instance_arg[2] = {(char)('0' + _instance), '\0'};
+		const char *task_args[] = {instance_arg, nullptr};
+
+		_task = task_spawn_cmd(gps_task_name[_instance], SCHED_DEFAULT,
+					SCHED_PRIORITY_SLOW_DRIVER, 1500, (main_t)&GPS::task_main_trampoline, task_args);
+	}
 
 	if (_task < 0) {
 		warnx("task start failed: %d", errno);
@@ -265,10 +336,117 @@ GPS::ioctl(struct file *filp, int cmd, unsigned long arg)
 	return ret;
 }
 
+ssize_t
+GPS::read(struct file *filp, char *buffer, size_t buflen)
+{
+	if (_raw_buf == nullptr)
+		return -ENOSYS;
+
+	unsigned count = _raw_buf->get_multiple(buffer, buflen);
+
+	/* don't block, the data comes in bursts once per epoch */
+	if (count == 0)
+		return -EAGAIN;
+
+	return count;
+}
+
+ssize_t
+GPS::write(struct file *filp, const char *buffer, size_t buflen)
+{
+	if (_inject_buf == nullptr)
+		return -ENOSYS;
+
+	/* one writer at a time */
+	lock();
+	unsigned count = _inject_buf->put_multiple(buffer, buflen);
+	unlock();
+
+	if (count == 0 && buflen > 0)
+		return -EAGAIN;
+
+	return count;
+}
+
+pollevent_t
+GPS::poll_state(struct file *filp)
+{
+	if (_raw_buf != nullptr && !_raw_buf->empty())
+		return POLLIN;
+
+	return 0;
+}
+
+void
+GPS::inject()
+{
+	uint8_t buf[64];
+	unsigned count;
+
+	while ((count = _inject_buf->get_multiple(buf, sizeof(buf))) > 0) {
+		::write(_serial_fd, buf, count);
+	}
+}
+
 void
-GPS::task_main_trampoline(void *arg)
+GPS::raw_output_trampoline(void *ctx, const uint8_t *buf, unsigned len)
 {
-	g_dev->task_main();
+	((GPS *)ctx)->raw_output(buf, len);
+}
+
+void
+GPS::raw_output(const uint8_t *buf, unsigned len)
+{
+	unsigned count = _raw_buf->put_multiple(buf, len);
+
+	/* a reader that can't keep up loses the newest data, what it has stays consistent */
+	_raw_dropped += len - count;
+
+	if (count > 0)
+		poll_notify(POLLIN);
+}
+
+int
+GPS::task_main_trampoline(int argc, char *argv[])
+{
+	unsigned instance = (argc > 1) ? (unsigned)atoi(argv[1]) : 0;
+
+	if (instance < GPS_BLEND_MAX_INSTANCES && g_dev[instance] != nullptr) {
+		g_dev[instance]->task_main();
+	}
+
+	return 0;
+}
+
+void
+GPS::publish()
+{
+	/* this receiver on its own */
+	if (_report_sensor_gps_pub > 0) {
+		orb_publish(ORB_ID(sensor_gps), _report_sensor_gps_pub, &_report_gps_pos);
+
+	} else {
+		_report_sensor_gps_pub = orb_advertise_multi(ORB_ID(sensor_gps), &_report_gps_pos, nullptr);
+	}
+
+	/* the estimators get the blend of all receivers */
+	struct vehicle_gps_position_s blended;
+	const struct vehicle_gps_position_s *report = &_report_gps_pos;
+
+	if (g_blend != nullptr) {
+		if (!g_blend->update(_instance, _report_gps_pos, blended)) {
+			return;
+		}
+
+		report = &blended;
+	}
+
+	if (_report_gps_pos_pub > 0) {
+		orb_publish(ORB_ID(vehicle_gps_position), _report_gps_pos_pub, report);
+
+	} else {
+		_report_gps_pos_pub = orb_advertise(ORB_ID(vehicle_gps_position), report);
+	}
 }
 
 void
@@ -315,12 +493,7 @@ GPS::task_main()
 			//no time and satellite information simulated
 
 			if (!(_pub_blocked)) {
-				if (_report_gps_pos_pub > 0) {
-					orb_publish(ORB_ID(vehicle_gps_position), _report_gps_pos_pub, &_report_gps_pos);
-
-				} else {
-					_report_gps_pos_pub = orb_advertise(ORB_ID(vehicle_gps_position), &_report_gps_pos);
-				}
+				publish();
 			}
 
 			usleep(2e5);
@@ -335,7 +508,7 @@ GPS::task_main()
 
 			switch (_mode) {
 			case GPS_DRIVER_MODE_UBX:
-				_Helper = new UBX(_serial_fd, &_report_gps_pos, _p_report_sat_info);
+				_Helper = new UBX(_serial_fd, &_report_gps_pos, _p_report_sat_info, _ubx_rate);
 				break;
 
 			case GPS_DRIVER_MODE_MTK:
@@ -350,6 +523,10 @@ GPS::task_main()
 				break;
 			}
 
+			if (_raw_buf != nullptr) {
+				_Helper->set_raw_output(&GPS::raw_output_trampoline, this);
+			}
+
 			unlock();
 
 			if (_Helper->configure(_baudrate) == 0) {
@@ -361,16 +538,16 @@ GPS::task_main()
 				int helper_ret;
 				while ((helper_ret = _Helper->receive(TIMEOUT_5HZ)) > 0 && !_task_should_exit) {
 	//				lock();
+					/* corrections go out between two epochs, while the link to the receiver is quiet */
+					if (_inject_buf != nullptr) {
+						inject();
+					}
+
 					/* opportunistic publishing - else invalid data would end up on the bus */
 
 					if (!(_pub_blocked)) {
 						if (helper_ret & 1) {
-							if (_report_gps_pos_pub > 0) {
-								orb_publish(ORB_ID(vehicle_gps_position), _report_gps_pos_pub, &_report_gps_pos);
-
-							} else {
-								_report_gps_pos_pub = orb_advertise(ORB_ID(vehicle_gps_position), &_report_gps_pos);
-							}
+							publish();
 						}
 						if (_p_report_sat_info && (helper_ret & 2)) {
 							if (_report_sat_info_pub > 0) {
@@ -499,6 +676,11 @@ GPS::print_info()
 	warnx("port: %s, baudrate: %d, status: %s", _port, _baudrate, (_healthy) ? "OK" : "NOT OK");
 	warnx("sat info: %s", (_p_report_sat_info != nullptr) ? "enabled" : "disabled");
 
+	if (_raw_buf != nullptr) {
+		warnx("raw data: %u bytes queued, %u dropped; corrections: %u bytes queued",
+		      _raw_buf->count(), _raw_dropped, _inject_buf->count());
+	}
+
 	if (_report_gps_pos.timestamp_position != 0) {
 		warnx("position lock: %dD, satellites: %d, last update: %8.4fms ago", (int)_report_gps_pos.fix_type,
 				_report_gps_pos.satellites_used, (double)(hrt_absolute_time() - _report_gps_pos.timestamp_position) / 1000.0);
@@ -521,49 +703,69 @@ GPS::print_info()
 namespace gps
 {
 
-GPS	*g_dev;
-
-void	start(const char *uart_path, bool fake_gps, bool enable_sat_info);
+void	start(const char *uart_path, const char *secondary_uart_path, bool fake_gps, bool enable_sat_info,
+	      unsigned ubx_rate, bool enable_raw);
 void	stop();
 void	test();
 void	reset();
 void	info();
 
 /**
- * Start the driver.
+ * Start the driver, one instance per receiver.
  */
 void
-start(const char *uart_path, bool fake_gps, bool enable_sat_info)
+start(const char *uart_path, const char *secondary_uart_path, bool fake_gps, bool enable_sat_info,
+      unsigned ubx_rate, bool enable_raw)
 {
-	int fd;
+	const char *uart_paths[GPS_BLEND_MAX_INSTANCES] = {uart_path, secondary_uart_path};
+	const unsigned num_instances = (secondary_uart_path != nullptr) ? 2 : 1;
 
-	if (g_dev != nullptr)
+	if (g_dev[0] != nullptr)
 		errx(1, "already started");
 
-	/* create the driver */
-	g_dev = new GPS(uart_path, fake_gps, enable_sat_info);
+	/* the position of several receivers is blended */
+	if (num_instances > 1) {
+		g_blend = new GPS_Blend();
+
+		if (g_blend == nullptr)
+			goto fail;
+	}
+
+	for (unsigned i = 0; i < num_instances; i++) {
+		/* create the driver, fake position and satellite info only come from the primary */
+		g_dev[i] = new GPS(uart_paths[i], fake_gps && i == 0, enable_sat_info && i == 0, ubx_rate, enable_raw, i);
 
-	if (g_dev == nullptr)
-		goto fail;
+		if (g_dev[i] == nullptr)
+			goto fail;
 
-	if (OK != g_dev->init())
-		goto fail;
+		if (OK != g_dev[i]->init())
+			goto fail;
 
-	/* set the poll rate to default, starts automatic data collection */
-	fd = open(GPS_DEVICE_PATH, O_RDONLY);
+		/* set the poll rate to default, starts automatic data collection */
+		int fd = open(gps_device_path[i], O_RDONLY);
 
-	if (fd < 0) {
-		errx(1, "Could not open device path: %s\n", GPS_DEVICE_PATH);
-		goto fail;
+		if (fd < 0) {
+			warnx("Could not open device path: %s", gps_device_path[i]);
+			goto fail;
+		}
+
+		close(fd);
 	}
 
 	exit(0);
 
 fail:
 
-	if (g_dev != nullptr) {
-		delete g_dev;
-		g_dev = nullptr;
+	for (unsigned i = 0; i < GPS_BLEND_MAX_INSTANCES; i++) {
+		if (g_dev[i] != nullptr) {
+			delete g_dev[i];
+			g_dev[i] = nullptr;
+		}
+	}
+
+	if (g_blend != nullptr) {
+		delete g_blend;
+		g_blend = nullptr;
 	}
 
 	errx(1, "driver start failed");
@@ -575,8 +777,13 @@ fail:
 void
 stop()
 {
-	delete g_dev;
-	g_dev = nullptr;
+	for (unsigned i = 0; i < GPS_BLEND_MAX_INSTANCES; i++) {
+		delete g_dev[i];
+		g_dev[i] = nullptr;
+	}
+
+	delete g_blend;
+	g_blend = nullptr;
 
 	exit(0);
 }
@@ -599,13 +806,20 @@ test()
 void
 reset()
 {
-	int fd = open(GPS_DEVICE_PATH, O_RDONLY);
+	for (unsigned i = 0; i < GPS_BLEND_MAX_INSTANCES; i++) {
+		if (g_dev[i] == nullptr)
+			continue;
 
-	if (fd < 0)
-		err(1, "failed ");
+		int fd = open(gps_device_path[i], O_RDONLY);
 
-	if (ioctl(fd, SENSORIOCRESET, 0) < 0)
-		err(1, "driver reset failed");
+		if (fd < 0)
+			err(1, "failed ");
+
+		if (ioctl(fd, SENSORIOCRESET, 0) < 0)
+			err(1, "driver reset failed");
+
+		close(fd);
+	}
 
 	exit(0);
 }
@@ -616,10 +830,18 @@ reset()
 void
 info()
 {
-	if (g_dev == nullptr)
+	if (g_dev[0] == nullptr)
 		errx(1, "driver not running");
 
-	g_dev->print_info();
+	for (unsigned i = 0; i < GPS_BLEND_MAX_INSTANCES; i++) {
+		if (g_dev[i] != nullptr) {
+			warnx("%s:", gps_device_path[i]);
+			g_dev[i]->print_info();
+		}
+	}
+
+	if (g_blend != nullptr)
+		warnx("blending %u receivers", (unsigned)GPS_BLEND_MAX_INSTANCES);
 
 	exit(0);
 }
@@ -633,8 +855,11 @@ gps_main(int argc, char *argv[])
 
 	/* set to default */
 	const char *device_name = GPS_DEFAULT_UART_PORT;
+	const char *secondary_device_name = nullptr;
 	bool fake_gps = false;
 	bool enable_sat_info = false;
+	unsigned ubx_rate = 5;
+	bool enable_raw = false;
 
 	/*
 	 * Start/load the driver.
@@ -662,7 +887,25 @@ gps_main(int argc, char *argv[])
 				enable_sat_info = true;
 		}
 
-		gps::start(device_name, fake_gps, enable_sat_info);
+		/* Detect UBX measurement rate option */
+		for (int i = 2; i < argc - 1; i++) {
+			if (!strcmp(argv[i], "-r"))
+				ubx_rate = strtoul(argv[i + 1], NULL, 10);
+		}
+
+		/* Detect secondary receiver option */
+		for (int i = 2; i < argc - 1; i++) {
+			if (!strcmp(argv[i], "-e"))
+				secondary_device_name = argv[i + 1];
+		}
+
+		/* Detect raw data / correction injection option */
+		for (int i = 2; i < argc; i++) {
+			if (!strcmp(argv[i], "-R"))
+				enable_raw = true;
+		}
+
+		gps::start(device_name, secondary_device_name, fake_gps, enable_sat_info, ubx_rate, enable_raw);
 	}
 
 	if (!strcmp(argv[1], "stop"))
@@ -687,5 +930,5 @@ gps_main(int argc, char *argv[])
 		gps::info();
 
 out:
-	errx(1, "unrecognized command, try 'start', 'stop', 'test', 'reset' or 'status' [-d /dev/ttyS0-n][-f][-s]");
+	errx(1, "unrecognized command, try 'start', 'stop', 'test', 'reset' or 'status' [-d /dev/ttyS0-n][-e /dev/ttyS0-n][-f][-s][-r 1-20 Hz][-R]");
 }
@@ -0,0 +1,175 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file gps_blend.cpp
+ *
+ * Blending of the fixes of several GPS receivers into one.
+ */
+
+#include <string.h>
+#include <math.h>
+#include <drivers/drv_hrt.h>
+#include <geo/geo.h>
+
+#include "gps_blend.h"
+
+GPS_Blend::GPS_Blend()
+{
+	memset(_reports, 0, sizeof(_reports));
+	sem_init(&_lock, 0, 1);
+}
+
+GPS_Blend::~GPS_Blend()
+{
+	sem_destroy(&_lock);
+}
+
+bool
+GPS_Blend::valid(const struct vehicle_gps_position_s &report, hrt_abstime now)
+{
+	return report.fix_type >= 3 && report.eph > 0.0f && report.timestamp_position + GPS_BLEND_TIMEOUT > now;
+}
+
+bool
+GPS_Blend::update(unsigned instance, const struct vehicle_gps_position_s &report,
+		  struct vehicle_gps_position_s &out)
+{
+	if (instance >= GPS_BLEND_MAX_INSTANCES) {
+		out = report;
+		return true;
+	}
+
+	sem_wait(&_lock);
+
+	_reports[instance] = report;
+
+	hrt_abstime now = hrt_absolute_time();
+	unsigned num_valid = 0;
+
+	for (unsigned i = 0; i < GPS_BLEND_MAX_INSTANCES; i++) {
+		if (valid(_reports[i], now)) {
+			num_valid++;
+		}
+	}
+
+	out = report;
+
+	if (num_valid == 0 || (num_valid == 1 && valid(report, now))) {
+		/* nothing to blend, pass on what this receiver has */
+		sem_post(&_lock);
+		return true;
+
+	} else if (!valid(report, now)) {
+		/* the receivers with a fix publish */
+		sem_post(&_lock);
+		return false;
+	}
+
+	/* offsets to this fix, in 1e-7 deg and mm */
+	const float lat_per_m = 1e7f * M_RAD_TO_DEG_F / CONSTANTS_RADIUS_OF_EARTH;
+	const float lon_per_m = lat_per_m / cosf((float)report.lat * 1e-7f * M_DEG_TO_RAD_F);
+
+	float w_pos = 0.0f, w_alt = 0.0f, w_vel = 0.0f;
+	float lat = 0.0f, lon = 0.0f, alt = 0.0f;
+	float vel_n = 0.0f, vel_e = 0.0f, vel_d = 0.0f, vel = 0.0f;
+
+	for (unsigned i = 0; i < GPS_BLEND_MAX_INSTANCES; i++) {
+		const struct vehicle_gps_position_s &r = _reports[i];
+
+		if (!valid(r, now)) {
+			continue;
+		}
+
+		/* move the fix to the time of this one, they are at most a measurement interval apart */
+		float dt = (float)((int64_t)report.timestamp_position - (int64_t)r.timestamp_position) * 1e-6f;
+		float d_lat = (float)(r.lat - report.lat);
+		float d_lon = (float)(r.lon - report.lon);
+		float d_alt = (float)(r.alt - report.alt);
+
+		if (r.vel_ned_valid) {
+			d_lat += r.vel_n_m_s * dt * lat_per_m;
+			d_lon += r.vel_e_m_s * dt * lon_per_m;
+			d_alt -= r.vel_d_m_s * dt * 1e3f;
+		}
+
+		float w = 1.0f / (r.eph * r.eph);
+		w_pos += w;
+		lat += w * d_lat;
+		lon += w * d_lon;
+
+		w = (r.epv > 0.0f) ? 1.0f / (r.epv * r.epv) : 1.0f / (r.eph * r.eph);
+		w_alt += w;
+		alt += w * d_alt;
+
+		if (r.vel_ned_valid) {
+			w = (r.s_variance_m_s > 0.0f) ? 1.0f / (r.s_variance_m_s * r.s_variance_m_s) : 1.0f / (r.eph * r.eph);
+			w_vel += w;
+			vel_n += w * r.vel_n_m_s;
+			vel_e += w * r.vel_e_m_s;
+			vel_d += w * r.vel_d_m_s;
+			vel += w * r.vel_m_s;
+		}
+
+		if (r.fix_type > out.fix_type) {
+			out.fix_type = r.fix_type;
+		}
+
+		if (r.satellites_used > out.satellites_used) {
+			out.satellites_used = r.satellites_used;
+		}
+	}
+
+	sem_post(&_lock);
+
+	out.lat = report.lat + (int32_t)(lat / w_pos);
+	out.lon = report.lon + (int32_t)(lon / w_pos);
+	out.alt = report.alt + (int32_t)(alt / w_alt);
+
+	/* the combined accuracy of independent receivers */
+	out.eph = 1.0f / sqrtf(w_pos);
+	out.epv = 1.0f / sqrtf(w_alt);
+
+	if (w_vel > 0.0f) {
+		out.vel_n_m_s = vel_n / w_vel;
+		out.vel_e_m_s = vel_e / w_vel;
+		out.vel_d_m_s = vel_d / w_vel;
+		out.vel_m_s = vel / w_vel;
+		out.cog_rad = atan2f(out.vel_e_m_s, out.vel_n_m_s);
+		out.s_variance_m_s = 1.0f / sqrtf(w_vel);
+		out.vel_ned_valid = true;
+	}
+
+	return true;
+}
@@ -0,0 +1,81 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file gps_blend.h
+ *
+ * Blending of the fixes of several GPS receivers into one.
+ */
+
+#ifndef GPS_BLEND_H
+#define GPS_BLEND_H
+
+#include <semaphore.h>
+#include <uORB/topics/vehicle_gps_position.h>
+
+#define GPS_BLEND_MAX_INSTANCES	2
+#define GPS_BLEND_TIMEOUT	1000000		/**< us, fixes older than this are not blended */
+
+class GPS_Blend
+{
+public:
+	GPS_Blend();
+	~GPS_Blend();
+
+	/**
+	 * Store the latest report of one receiver and blend it with the others
+	 *
+	 * Called by the driver task of every receiver after each update, so the
+	 * blended output comes at the combined rate of all receivers. The other
+	 * fixes are moved to the time of this one with their velocity, and
+	 * position, altitude and velocity are weighted by the inverse of the
+	 * reported variances.
+	 *
+	 * @param instance	receiver the report is from
+	 * @param report	latest report of the receiver
+	 * @param out		report to publish as vehicle_gps_position
+	 * @return		true if out should be published, false if this
+	 *			receiver has no fix while another one has
+	 */
+	bool			update(unsigned instance, const struct vehicle_gps_position_s &report,
+				       struct vehicle_gps_position_s &out);
+
+private:
+	struct vehicle_gps_position_s	_reports[GPS_BLEND_MAX_INSTANCES];
+	sem_t				_lock;		/**< the receivers update from their own tasks */
+
+	bool			valid(const struct vehicle_gps_position_s &report, hrt_abstime now);
+};
+
+#endif /* GPS_BLEND_H */
@@ -43,11 +43,16 @@
 #include <uORB/uORB.h>
 #include <uORB/topics/vehicle_gps_position.h>
 
+/**
+ * Receiver of the unparsed byte stream from the GPS
+ */
+typedef void (*gps_raw_output_t)(void *ctx, const uint8_t *buf, unsigned len);
+
 class GPS_Helper
 {
 public:
 
-	GPS_Helper() {};
+	GPS_Helper() : _raw_output(nullptr), _raw_output_ctx(nullptr) {};
 	virtual ~GPS_Helper() {};
 
 	virtual int			configure(unsigned &baud) = 0;
@@ -58,6 +63,14 @@ public:
 	void				reset_update_rates();
 	void				store_update_rates();
 
+	/**
+	 * Pass everything read from the receiver on, as it was read
+	 *
+	 * Also tells the helper to enable the raw measurement messages, if the
+	 * protocol has them.
+	 */
+	void				set_raw_output(gps_raw_output_t output, void *ctx) { _raw_output = output; _raw_output_ctx = ctx; }
+
 protected:
 	uint8_t _rate_count_lat_lon;
 	uint8_t _rate_count_vel;
@@ -66,6 +79,9 @@ protected:
 	float _rate_vel = 0.0f;
 
 	uint64_t _interval_rate_start;
+
+	gps_raw_output_t _raw_output;
+	void *_raw_output_ctx;
 };
 
 #endif /* GPS_HELPER_H */
@@ -66,7 +66,9 @@
 
 #define UBX_CONFIG_TIMEOUT	200		// ms, timeout for waiting ACK
 #define UBX_PACKET_TIMEOUT	2		// ms, if now data during this delay assume that full update received
-#define UBX_WAIT_BEFORE_READ	20		// ms, wait before reading to save read() calls
+#define UBX_WAIT_FRAME_MAX	20		// ms, longest wait for the rest of a partially received frame
+#define UBX_TIME_OFFSET_CREEP	20		// us per epoch, lets the fix time offset follow a clock drift
+#define UBX_TIME_OFFSET_RESET	1000000		// us, restart the fix time offset after a jump (receiver reset, week rollover)
 #define DISABLE_MSG_INTERVAL	1000000		// us, try to disable message with this interval
 
 #define MIN(X,Y)	((X) < (Y) ? (X) : (Y))
@@ -77,7 +79,7 @@
 
 
 /**** Trace macros, disable for production builds */
-#define UBX_TRACE_PARSER(s, ...)	{/*printf(s, ## __VA_ARGS__);*/}	/* decoding progress in parse_char() */
+#define UBX_TRACE_PARSER(s, ...)	{/*printf(s, ## __VA_ARGS__);*/}	/* decoding progress in parse_buffer() */
 #define UBX_TRACE_RXMSG(s, ...)		{/*printf(s, ## __VA_ARGS__);*/}	/* Rx msgs in payload_rx_done() */
 #define UBX_TRACE_SVINFO(s, ...)	{/*printf(s, ## __VA_ARGS__);*/}	/* NAV-SVINFO processing (debug use only, will cause rx buffer overflows) */
 
@@ -85,7 +87,8 @@
 #define UBX_WARN(s, ...)		{warnx(s, ## __VA_ARGS__);}
 
 
-UBX::UBX(const int &fd, struct vehicle_gps_position_s *gps_position, struct satellite_info_s *satellite_info) :
+UBX::UBX(const int &fd, struct vehicle_gps_position_s *gps_position, struct satellite_info_s *satellite_info,
+	 unsigned rate) :
 	_fd(fd),
 	_gps_position(gps_position),
 	_satellite_info(satellite_info),
@@ -96,8 +99,23 @@ UBX::UBX(const int &fd, struct vehicle_gps_position_s *gps_position, struct sate
 	_disable_cmd_last(0),
 	_ack_waiting_msg(0),
 	_ubx_version(0),
-	_use_nav_pvt(false)
+	_use_nav_pvt(false),
+	_baudrate(0),
+	_measure_interval(UBX_TX_CFG_RATE_MEASINTERVAL),
+	_rx_burst_time(0),
+	_rx_last_time(0),
+	_time_offset(0),
+	_time_offset_valid(false),
+	_time_offset_iTOW(0)
 {
+	if (rate > 0) {
+		_measure_interval = 1000 / rate;
+	}
+
+	if (_measure_interval < UBX_TX_CFG_RATE_MIN_MEASINTERVAL) {
+		_measure_interval = UBX_TX_CFG_RATE_MIN_MEASINTERVAL;
+	}
+
 	decode_init();
 }
 
@@ -109,6 +127,9 @@ int
 UBX::configure(unsigned &baudrate)
 {
 	_configured = false;
+	/* faster rates don't fit into 38400 baud */
+	const unsigned target_baudrate = (_measure_interval < UBX_TX_CFG_RATE_MEASINTERVAL) ?
+					 UBX_TX_CFG_PRT_BAUDRATE_FAST : UBX_TX_CFG_PRT_BAUDRATE;
 	/* try different baudrates */
 	const unsigned baudrates[] = {9600, 38400, 19200, 57600, 115200};
 
@@ -117,6 +138,7 @@ UBX::configure(unsigned &baudrate)
 	for (baud_i = 0; baud_i < sizeof(baudrates) / sizeof(baudrates[0]); baud_i++) {
 		baudrate = baudrates[baud_i];
 		set_baudrate(_fd, baudrate);
+		_baudrate = baudrate;
 
 		/* flush input and wait for at least 20 ms silence */
 		decode_init();
@@ -143,7 +165,7 @@ UBX::configure(unsigned &baudrate)
 		memset(&_buf.payload_tx_cfg_prt, 0, sizeof(_buf.payload_tx_cfg_prt));
 		_buf.payload_tx_cfg_prt.portID		= UBX_TX_CFG_PRT_PORTID;
 		_buf.payload_tx_cfg_prt.mode		= UBX_TX_CFG_PRT_MODE;
-		_buf.payload_tx_cfg_prt.baudRate	= UBX_TX_CFG_PRT_BAUDRATE;
+		_buf.payload_tx_cfg_prt.baudRate	= target_baudrate;
 		_buf.payload_tx_cfg_prt.inProtoMask	= UBX_TX_CFG_PRT_INPROTOMASK;
 		_buf.payload_tx_cfg_prt.outProtoMask	= UBX_TX_CFG_PRT_OUTPROTOMASK;
 
@@ -152,9 +174,10 @@ UBX::configure(unsigned &baudrate)
 		/* no ACK is expected here, but read the buffer anyway in case we actually get an ACK */
 		wait_for_ack(UBX_MSG_CFG_PRT, UBX_CONFIG_TIMEOUT, false);
 
-		if (UBX_TX_CFG_PRT_BAUDRATE != baudrate) {
-			set_baudrate(_fd, UBX_TX_CFG_PRT_BAUDRATE);
-			baudrate = UBX_TX_CFG_PRT_BAUDRATE;
+		if (target_baudrate != baudrate) {
+			set_baudrate(_fd, target_baudrate);
+			baudrate = target_baudrate;
+			_baudrate = baudrate;
 		}
 
 		/* at this point we have correct baudrate on both ends */
@@ -167,14 +190,27 @@ UBX::configure(unsigned &baudrate)
 
 	/* Send a CFG-RATE message to define update rate */
 	memset(&_buf.payload_tx_cfg_rate, 0, sizeof(_buf.payload_tx_cfg_rate));
-	_buf.payload_tx_cfg_rate.measRate	= UBX_TX_CFG_RATE_MEASINTERVAL;
+	_buf.payload_tx_cfg_rate.measRate	= _measure_interval;
 	_buf.payload_tx_cfg_rate.navRate	= UBX_TX_CFG_RATE_NAVRATE;
 	_buf.payload_tx_cfg_rate.timeRef	= UBX_TX_CFG_RATE_TIMEREF;
 
 	send_message(UBX_MSG_CFG_RATE, _buf.raw, sizeof(_buf.payload_tx_cfg_rate));
 
-	if (wait_for_ack(UBX_MSG_CFG_RATE, UBX_CONFIG_TIMEOUT, true) < 0) {
-		return 1;
+	if (wait_for_ack(UBX_MSG_CFG_RATE, UBX_CONFIG_TIMEOUT, _measure_interval == UBX_TX_CFG_RATE_MEASINTERVAL) < 0) {
+		if (_measure_interval == UBX_TX_CFG_RATE_MEASINTERVAL) {
+			return 1;
+		}
+
+		/* older receivers don't go that fast, but the default rate on the fast baudrate is fine */
+		UBX_WARN("%uHz rejected, using %uHz", 1000 / _measure_interval, 1000 / UBX_TX_CFG_RATE_MEASINTERVAL);
+		_measure_interval = UBX_TX_CFG_RATE_MEASINTERVAL;
+		_buf.payload_tx_cfg_rate.measRate = _measure_interval;
+
+		send_message(UBX_MSG_CFG_RATE, _buf.raw, sizeof(_buf.payload_tx_cfg_rate));
+
+		if (wait_for_ack(UBX_MSG_CFG_RATE, UBX_CONFIG_TIMEOUT, true) < 0) {
+			return 1;
+		}
 	}
 
 	/* send a NAV5 message to set the options for the internal filter */
@@ -202,7 +238,10 @@ UBX::configure(unsigned &baudrate)
 #endif
 
 	/* configure message rates */
-	/* the last argument is divisor for measurement rate (set by CFG RATE), i.e. 1 means 5Hz */
+	/* the last argument is divisor for measurement rate (set by CFG RATE), i.e. 1 means 5Hz at the default rate */
+	/* the slow messages keep their 5Hz based rates at faster measurement rates */
+	const uint8_t slow_msg_div = (_measure_interval < UBX_TX_CFG_RATE_MEASINTERVAL) ?
+				     UBX_TX_CFG_RATE_MEASINTERVAL / _measure_interval : 1;
 
 	/* try to set rate for NAV-PVT */
 	/* (implemented for ubx7+ modules only, use NAV-SOL, NAV-POSLLH, NAV-VELNED and NAV-TIMEUTC for ubx6) */
@@ -215,7 +254,7 @@ UBX::configure(unsigned &baudrate)
 	UBX_WARN("%susing NAV-PVT", _use_nav_pvt ? "" : "not ");
 
 	if (!_use_nav_pvt) {
-		configure_message_rate(UBX_MSG_NAV_TIMEUTC, 5);
+		configure_message_rate(UBX_MSG_NAV_TIMEUTC, 5 * slow_msg_div);
 		if (wait_for_ack(UBX_MSG_CFG_MSG, UBX_CONFIG_TIMEOUT, true) < 0) {
 			return 1;
 		}
@@ -236,16 +275,27 @@ UBX::configure(unsigned &baudrate)
 		}
 	}
 
-	configure_message_rate(UBX_MSG_NAV_SVINFO, (_satellite_info != nullptr) ? 5 : 0);
+	configure_message_rate(UBX_MSG_NAV_SVINFO, (_satellite_info != nullptr) ? 5 * slow_msg_div : 0);
 	if (wait_for_ack(UBX_MSG_CFG_MSG, UBX_CONFIG_TIMEOUT, true) < 0) {
 		return 1;
 	}
 
-	configure_message_rate(UBX_MSG_MON_HW, 1);
+	configure_message_rate(UBX_MSG_MON_HW, slow_msg_div);
 	if (wait_for_ack(UBX_MSG_CFG_MSG, UBX_CONFIG_TIMEOUT, true) < 0) {
 		return 1;
 	}
 
+	/* raw measurements for post processing, only timing and RTK receivers have them */
+	if (_raw_output != nullptr) {
+		configure_message_rate(UBX_MSG_RXM_RAWX, 1);
+		if (wait_for_ack(UBX_MSG_CFG_MSG, UBX_CONFIG_TIMEOUT, false) < 0) {
+			UBX_WARN("no raw measurements");
+		}
+
+		configure_message_rate(UBX_MSG_RXM_SFRBX, 1);
+		wait_for_ack(UBX_MSG_CFG_MSG, UBX_CONFIG_TIMEOUT, false);
+	}
+
 	/* request module version information by sending an empty MON-VER message */
 	send_message(UBX_MSG_MON_VER, nullptr, 0);
 
@@ -289,8 +339,6 @@ UBX::receive(const unsigned timeout)
 	fds[0].fd = _fd;
 	fds[0].events = POLLIN;
 
-	uint8_t buf[128];
-
 	/* timeout additional to poll */
 	uint64_t time_started = hrt_absolute_time();
 
@@ -325,16 +373,37 @@ UBX::receive(const unsigned timeout)
 			if (fds[0].revents & POLLIN) {
 				/*
 				 * We are here because poll says there is some data, so this
-				 * won't block even on a blocking device. But don't read immediately
-				 * by 1-2 bytes, wait for some more data to save expensive read() calls.
-				 * If more bytes are available, we'll go back to poll() again.
+				 * won't block even on a blocking device.
 				 */
-				usleep(UBX_WAIT_BEFORE_READ * 1000);
-				count = read(_fd, buf, sizeof(buf));
+				hrt_abstime t = hrt_absolute_time();
+
+				/* the first data after a quiet line is the start of a new epoch */
+				if (t > _rx_last_time + _measure_interval * 1000 / 2) {
+					_rx_burst_time = t;
+				}
+
+				count = read(_fd, &_rx_buf[_rx_buf_count], sizeof(_rx_buf) - _rx_buf_count);
+
+				if (count > 0) {
+					_rx_last_time = hrt_absolute_time();
+
+					/* the raw stream goes out untouched, before any decoding */
+					if (_raw_output != nullptr && _configured) {
+						_raw_output(_raw_output_ctx, &_rx_buf[_rx_buf_count], count);
+					}
 
-				/* pass received bytes to the packet decoder */
-				for (int i = 0; i < count; i++) {
-					handled |= parse_char(buf[i]);
+					/* decode the complete frames */
+					_rx_buf_count += count;
+					handled |= parse_buffer();
+				}
+
+				/*
+				 * Instead of coming back for every few bytes, sleep until the rest
+				 * of a partial frame is on the line, 10 bits per byte. A complete
+				 * frame is handled right away.
+				 */
+				if (_rx_missing > 0 && _baudrate > 0) {
+					usleep(MIN(_rx_missing * 10000 / (_baudrate / 100), UBX_WAIT_FRAME_MAX * 1000));
 				}
 			}
 		}
@@ -346,120 +415,92 @@ UBX::receive(const unsigned timeout)
 	}
 }
 
-int	// 0 = decoding, 1 = message handled, 2 = sat info message handled
-UBX::parse_char(const uint8_t b)
+int	// 0 = no message handled, 1 = message handled, 2 = sat info message handled
+UBX::parse_buffer(void)
 {
 	int ret = 0;
+	unsigned pos = 0;
 
-	switch (_decode_state) {
+	_rx_missing = 0;
 
-	/* Expecting Sync1 */
-	case UBX_DECODE_SYNC1:
-		if (b == UBX_SYNC1) {	// Sync1 found --> expecting Sync2
-			UBX_TRACE_PARSER("\nA");
-			_decode_state = UBX_DECODE_SYNC2;
-		}
-		break;
+	/* drop the remainder of a frame too long for the buffer */
+	if (_rx_skip > 0) {
+		pos = MIN(_rx_skip, _rx_buf_count);
+		_rx_skip -= pos;
+	}
 
-	/* Expecting Sync2 */
-	case UBX_DECODE_SYNC2:
-		if (b == UBX_SYNC2) {	// Sync2 found --> expecting Class
-			UBX_TRACE_PARSER("B");
-			_decode_state = UBX_DECODE_CLASS;
+	while (_rx_buf_count - pos >= sizeof(ubx_header_t)) {
+		uint8_t *frame = &_rx_buf[pos];
 
-		} else {		// Sync1 not followed by Sync2: reset parser
-			decode_init();
+		if (frame[0] != UBX_SYNC1 || frame[1] != UBX_SYNC2) {
+			/* resync on the next Sync1 */
+			const uint8_t *sync = (const uint8_t *)memchr(frame + 1, UBX_SYNC1, _rx_buf_count - pos - 1);
+			pos = (sync != nullptr) ? sync - _rx_buf : _rx_buf_count;
+			continue;
 		}
-		break;
 
-	/* Expecting Class */
-	case UBX_DECODE_CLASS:
-		UBX_TRACE_PARSER("C");
-		add_byte_to_checksum(b);  // checksum is calculated for everything except Sync and Checksum bytes
-		_rx_msg = b;
-		_decode_state = UBX_DECODE_ID;
-		break;
+		const ubx_header_t *header = (const ubx_header_t *)frame;
+		_rx_msg = header->msg;
+		_rx_payload_length = header->length;
+		const unsigned frame_length = sizeof(ubx_header_t) + _rx_payload_length + sizeof(ubx_checksum_t);
 
-	/* Expecting ID */
-	case UBX_DECODE_ID:
-		UBX_TRACE_PARSER("D");
-		add_byte_to_checksum(b);
-		_rx_msg |= b << 8;
-		_decode_state = UBX_DECODE_LENGTH1;
-		break;
+		if (frame_length > sizeof(_rx_buf)) {
+			if (payload_rx_init() == 0) {
+				/* a message we know, just longer than we can hold */
+				if (_rx_state == UBX_RXMSG_HANDLE) {
+					UBX_WARN("ubx msg 0x%04x len %u too long", SWAP16((unsigned)_rx_msg), (unsigned)_rx_payload_length);
+				}
 
-	/* Expecting first length byte */
-	case UBX_DECODE_LENGTH1:
-		UBX_TRACE_PARSER("E");
-		add_byte_to_checksum(b);
-		_rx_payload_length = b;
-		_decode_state = UBX_DECODE_LENGTH2;
-		break;
+				_rx_skip = frame_length - (_rx_buf_count - pos);
+				pos = _rx_buf_count;
 
-	/* Expecting second length byte */
-	case UBX_DECODE_LENGTH2:
-		UBX_TRACE_PARSER("F");
-		add_byte_to_checksum(b);
-		_rx_payload_length |= b << 8;	// calculate payload size
-		if (payload_rx_init() != 0) {	// start payload reception
-			// payload will not be handled, discard message
-			decode_init();
-		} else {
-			_decode_state = (_rx_payload_length > 0) ? UBX_DECODE_PAYLOAD : UBX_DECODE_CHKSUM1;
+			} else {
+				/* most likely a corrupt header */
+				pos += 2;
+			}
+
+			continue;
 		}
-		break;
 
-	/* Expecting payload */
-	case UBX_DECODE_PAYLOAD:
-		UBX_TRACE_PARSER(".");
-		add_byte_to_checksum(b);
-		switch (_rx_msg) {
-		case UBX_MSG_NAV_SVINFO:
-			ret = payload_rx_add_nav_svinfo(b);	// add a NAV-SVINFO payload byte
-			break;
-		case UBX_MSG_MON_VER:
-			ret = payload_rx_add_mon_ver(b);	// add a MON-VER payload byte
-			break;
-		default:
-			ret = payload_rx_add(b);		// add a payload byte
+		if (_rx_buf_count - pos < frame_length) {
+			/* wait for the rest of the frame */
+			_rx_missing = frame_length - (_rx_buf_count - pos);
 			break;
 		}
-		if (ret < 0) {
-			// payload not handled, discard message
-			decode_init();
-		} else if (ret > 0) {
-			// payload complete, expecting checksum
-			_decode_state = UBX_DECODE_CHKSUM1;
-		} else {
-			// expecting more payload, stay in state UBX_DECODE_PAYLOAD
-		}
-		ret = 0;
-		break;
 
-	/* Expecting first checksum byte */
-	case UBX_DECODE_CHKSUM1:
-		if (_rx_ck_a != b) {
+		UBX_TRACE_PARSER("frame 0x%04x len %u\n", SWAP16((unsigned)_rx_msg), (unsigned)_rx_payload_length);
+
+		/* checksum is calculated for everything except Sync and Checksum bytes */
+		ubx_checksum_t checksum = {0, 0};
+		calc_checksum(&frame[2], sizeof(ubx_header_t) - 2 + _rx_payload_length, &checksum);
+		const ubx_checksum_t *rx_checksum = (const ubx_checksum_t *)&frame[sizeof(ubx_header_t) + _rx_payload_length];
+
+		if (checksum.ck_a != rx_checksum->ck_a || checksum.ck_b != rx_checksum->ck_b) {
 			UBX_WARN("ubx checksum err");
-			decode_init();
-		} else {
-			_decode_state = UBX_DECODE_CHKSUM2;
+			pos += 2;
+			continue;
 		}
-		break;
 
-	/* Expecting second checksum byte */
-	case UBX_DECODE_CHKSUM2:
-		if (_rx_ck_b != b) {
-			UBX_WARN("ubx checksum err");
-		} else {
-			ret = payload_rx_done();	// finish payload processing
+		/* the payload structs are packed, so they are decoded right from the buffer */
+		if (payload_rx_init() == 0) {
+			ret |= payload_rx_done(*(ubx_buf_t *)&frame[sizeof(ubx_header_t)]);
 		}
-		decode_init();
-		break;
 
-	default:
-		break;
+		pos += frame_length;
+	}
+
+	if (_rx_skip > 0) {
+		_rx_missing = MIN(_rx_skip, sizeof(_rx_buf));
+
+	} else if (_rx_missing == 0 && pos < _rx_buf_count) {
+		/* partial header, at least a frame without payload is missing */
+		_rx_missing = sizeof(ubx_header_t) + sizeof(ubx_checksum_t) - (_rx_buf_count - pos);
 	}
 
+	/* keep the start of an incomplete frame for the next read */
+	_rx_buf_count -= pos;
+	memmove(_rx_buf, &_rx_buf[pos], _rx_buf_count);
+
 	return ret;
 }
 
@@ -512,7 +553,9 @@ UBX::payload_rx_init()
 		break;
 
 	case UBX_MSG_NAV_SVINFO:
-		if (_satellite_info == nullptr)
+		if (_rx_payload_length < sizeof(ubx_payload_rx_nav_svinfo_part1_t))
+			_rx_state = UBX_RXMSG_ERROR_LENGTH;
+		else if (_satellite_info == nullptr)
 			_rx_state = UBX_RXMSG_DISABLE;	// disable if sat info not requested
 		else if (!_configured)
 			_rx_state = UBX_RXMSG_IGNORE;	// ignore if not _configured
@@ -529,8 +572,18 @@ UBX::payload_rx_init()
 			_rx_state = UBX_RXMSG_DISABLE;	// disable if using NAV-PVT instead
 		break;
 
+	case UBX_MSG_RXM_RAWX:
+	case UBX_MSG_RXM_SFRBX:
+		if (_raw_output == nullptr)
+			_rx_state = UBX_RXMSG_DISABLE;	// disable if raw output not requested
+		else
+			_rx_state = UBX_RXMSG_IGNORE;	// passed on with the raw stream, nothing to decode
+		break;
+
 	case UBX_MSG_MON_VER:
-		break;		// unconditionally handle this message
+		if (_rx_payload_length < sizeof(ubx_payload_rx_mon_ver_part1_t))
+			_rx_state = UBX_RXMSG_ERROR_LENGTH;
+		break;		// otherwise unconditionally handle this message
 
 	case UBX_MSG_MON_HW:
 		if (   (_rx_payload_length != sizeof(ubx_payload_rx_mon_hw_ubx6_t))	/* u-blox 6 msg format */
@@ -597,111 +650,62 @@ UBX::payload_rx_init()
 }
 
 /**
- * Add payload rx byte
+ * Decode NAV-SVINFO payload
  */
-int	// -1 = error, 0 = ok, 1 = payload completed
-UBX::payload_rx_add(const uint8_t b)
+void
+UBX::payload_rx_nav_svinfo(ubx_buf_t &payload)
 {
-	int ret = 0;
-
-	_buf.raw[_rx_payload_index] = b;
-
-	if (++_rx_payload_index >= _rx_payload_length) {
-		ret = 1;	// payload received completely
+	const unsigned num_ch = (_rx_payload_length - sizeof(ubx_payload_rx_nav_svinfo_part1_t)) / sizeof(ubx_payload_rx_nav_svinfo_part2_t);
+
+	_satellite_info->count = MIN(MIN(payload.payload_rx_nav_svinfo_part1.numCh, num_ch), SAT_INFO_MAX_SATELLITES);
+	UBX_TRACE_SVINFO("SVINFO len %u  numCh %u\n", (unsigned)_rx_payload_length, (unsigned)payload.payload_rx_nav_svinfo_part1.numCh);
+
+	for (unsigned sat_index = 0; sat_index < _satellite_info->count; sat_index++) {
+		const ubx_payload_rx_nav_svinfo_part2_t *sv = (const ubx_payload_rx_nav_svinfo_part2_t *)
+				&payload.raw[sizeof(ubx_payload_rx_nav_svinfo_part1_t) + sat_index * sizeof(ubx_payload_rx_nav_svinfo_part2_t)];
+
+		_satellite_info->used[sat_index]	= (uint8_t)(sv->flags & 0x01);
+		_satellite_info->snr[sat_index]		= (uint8_t)(sv->cno);
+		_satellite_info->elevation[sat_index]	= (uint8_t)(sv->elev);
+		_satellite_info->azimuth[sat_index]	= (uint8_t)((float)sv->azim * 255.0f / 360.0f);
+		_satellite_info->svid[sat_index]	= (uint8_t)(sv->svid);
+		UBX_TRACE_SVINFO("SVINFO #%02u  used %u  snr %3u  elevation %3u  azimuth %3u  svid %3u\n",
+				(unsigned)sat_index + 1,
+				(unsigned)_satellite_info->used[sat_index],
+				(unsigned)_satellite_info->snr[sat_index],
+				(unsigned)_satellite_info->elevation[sat_index],
+				(unsigned)_satellite_info->azimuth[sat_index],
+				(unsigned)_satellite_info->svid[sat_index]
+		);
 	}
-
-	return ret;
 }
 
 /**
- * Add NAV-SVINFO payload rx byte
+ * Decode MON-VER payload
  */
-int	// -1 = error, 0 = ok, 1 = payload completed
-UBX::payload_rx_add_nav_svinfo(const uint8_t b)
-{
-	int ret = 0;
-
-	if (_rx_payload_index < sizeof(ubx_payload_rx_nav_svinfo_part1_t)) {
-		// Fill Part 1 buffer
-		_buf.raw[_rx_payload_index] = b;
-	} else {
-		if (_rx_payload_index == sizeof(ubx_payload_rx_nav_svinfo_part1_t)) {
-			// Part 1 complete: decode Part 1 buffer
-			_satellite_info->count = MIN(_buf.payload_rx_nav_svinfo_part1.numCh, SAT_INFO_MAX_SATELLITES);
-			UBX_TRACE_SVINFO("SVINFO len %u  numCh %u\n", (unsigned)_rx_payload_length, (unsigned)_buf.payload_rx_nav_svinfo_part1.numCh);
-		}
-		if (_rx_payload_index < sizeof(ubx_payload_rx_nav_svinfo_part1_t) + _satellite_info->count * sizeof(ubx_payload_rx_nav_svinfo_part2_t)) {
-			// Still room in _satellite_info: fill Part 2 buffer
-			unsigned buf_index = (_rx_payload_index - sizeof(ubx_payload_rx_nav_svinfo_part1_t)) % sizeof(ubx_payload_rx_nav_svinfo_part2_t);
-			_buf.raw[buf_index] = b;
-			if (buf_index == sizeof(ubx_payload_rx_nav_svinfo_part2_t) - 1) {
-				// Part 2 complete: decode Part 2 buffer
-				unsigned sat_index = (_rx_payload_index - sizeof(ubx_payload_rx_nav_svinfo_part1_t)) / sizeof(ubx_payload_rx_nav_svinfo_part2_t);
-				_satellite_info->used[sat_index]	= (uint8_t)(_buf.payload_rx_nav_svinfo_part2.flags & 0x01);
-				_satellite_info->snr[sat_index]		= (uint8_t)(_buf.payload_rx_nav_svinfo_part2.cno);
-				_satellite_info->elevation[sat_index]	= (uint8_t)(_buf.payload_rx_nav_svinfo_part2.elev);
-				_satellite_info->azimuth[sat_index]	= (uint8_t)((float)_buf.payload_rx_nav_svinfo_part2.azim * 255.0f / 360.0f);
-				_satellite_info->svid[sat_index]	= (uint8_t)(_buf.payload_rx_nav_svinfo_part2.svid);
-				UBX_TRACE_SVINFO("SVINFO #%02u  used %u  snr %3u  elevation %3u  azimuth %3u  svid %3u\n",
-						(unsigned)sat_index + 1,
-						(unsigned)_satellite_info->used[sat_index],
-						(unsigned)_satellite_info->snr[sat_index],
-						(unsigned)_satellite_info->elevation[sat_index],
-						(unsigned)_satellite_info->azimuth[sat_index],
-						(unsigned)_satellite_info->svid[sat_index]
-				);
-			}
-		}
-	}
-
-	if (++_rx_payload_index >= _rx_payload_length) {
-		ret = 1;	// payload received completely
-	}
-
-	return ret;
-}
-
-/**
- * Add MON-VER payload rx byte
- */
-int	// -1 = error, 0 = ok, 1 = payload completed
-UBX::payload_rx_add_mon_ver(const uint8_t b)
+void
+UBX::payload_rx_mon_ver(ubx_buf_t &payload)
 {
-	int ret = 0;
-
-	if (_rx_payload_index < sizeof(ubx_payload_rx_mon_ver_part1_t)) {
-		// Fill Part 1 buffer
-		_buf.raw[_rx_payload_index] = b;
-	} else {
-		if (_rx_payload_index == sizeof(ubx_payload_rx_mon_ver_part1_t)) {
-			// Part 1 complete: decode Part 1 buffer and calculate hash for SW&HW version strings
-			_ubx_version = fnv1_32_str(_buf.payload_rx_mon_ver_part1.swVersion, FNV1_32_INIT);
-			_ubx_version = fnv1_32_str(_buf.payload_rx_mon_ver_part1.hwVersion, _ubx_version);
-			UBX_WARN("VER hash 0x%08x", _ubx_version);
-			UBX_WARN("VER hw  \"%10s\"", _buf.payload_rx_mon_ver_part1.hwVersion);
-			UBX_WARN("VER sw  \"%30s\"", _buf.payload_rx_mon_ver_part1.swVersion);
-		}
-		// fill Part 2 buffer
-		unsigned buf_index = (_rx_payload_index - sizeof(ubx_payload_rx_mon_ver_part1_t)) % sizeof(ubx_payload_rx_mon_ver_part2_t);
-		_buf.raw[buf_index] = b;
-		if (buf_index == sizeof(ubx_payload_rx_mon_ver_part2_t) - 1) {
-			// Part 2 complete: decode Part 2 buffer
-			UBX_WARN("VER ext \" %30s\"", _buf.payload_rx_mon_ver_part2.extension);
-		}
+	// calculate hash for SW&HW version strings
+	_ubx_version = fnv1_32_str(payload.payload_rx_mon_ver_part1.swVersion, FNV1_32_INIT);
+	_ubx_version = fnv1_32_str(payload.payload_rx_mon_ver_part1.hwVersion, _ubx_version);
+	UBX_WARN("VER hash 0x%08x", _ubx_version);
+	UBX_WARN("VER hw  \"%10s\"", payload.payload_rx_mon_ver_part1.hwVersion);
+	UBX_WARN("VER sw  \"%30s\"", payload.payload_rx_mon_ver_part1.swVersion);
+
+	for (unsigned i = sizeof(ubx_payload_rx_mon_ver_part1_t);
+	     i + sizeof(ubx_payload_rx_mon_ver_part2_t) <= _rx_payload_length;
+	     i += sizeof(ubx_payload_rx_mon_ver_part2_t)) {
+		const ubx_payload_rx_mon_ver_part2_t *ext = (const ubx_payload_rx_mon_ver_part2_t *)&payload.raw[i];
+		UBX_WARN("VER ext \" %30s\"", ext->extension);
 	}
-
-	if (++_rx_payload_index >= _rx_payload_length) {
-		ret = 1;	// payload received completely
-	}
-
-	return ret;
 }
 
 /**
  * Finish payload rx
  */
 int	// 0 = no message handled, 1 = message handled, 2 = sat info message handled
-UBX::payload_rx_done(void)
+UBX::payload_rx_done(ubx_buf_t &payload)
 {
 	int ret = 0;
 
@@ -716,36 +720,36 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_NAV_PVT:
 		UBX_TRACE_RXMSG("Rx NAV-PVT\n");
 
-		_gps_position->fix_type		= _buf.payload_rx_nav_pvt.fixType;
-		_gps_position->satellites_used	= _buf.payload_rx_nav_pvt.numSV;
+		_gps_position->fix_type		= payload.payload_rx_nav_pvt.fixType;
+		_gps_position->satellites_used	= payload.payload_rx_nav_pvt.numSV;
 
-		_gps_position->lat		= _buf.payload_rx_nav_pvt.lat;
-		_gps_position->lon		= _buf.payload_rx_nav_pvt.lon;
-		_gps_position->alt		= _buf.payload_rx_nav_pvt.hMSL;
+		_gps_position->lat		= payload.payload_rx_nav_pvt.lat;
+		_gps_position->lon		= payload.payload_rx_nav_pvt.lon;
+		_gps_position->alt		= payload.payload_rx_nav_pvt.hMSL;
 
-		_gps_position->eph		= (float)_buf.payload_rx_nav_pvt.hAcc * 1e-3f;
-		_gps_position->epv		= (float)_buf.payload_rx_nav_pvt.vAcc * 1e-3f;
-		_gps_position->s_variance_m_s	= (float)_buf.payload_rx_nav_pvt.sAcc * 1e-3f;
+		_gps_position->eph		= (float)payload.payload_rx_nav_pvt.hAcc * 1e-3f;
+		_gps_position->epv		= (float)payload.payload_rx_nav_pvt.vAcc * 1e-3f;
+		_gps_position->s_variance_m_s	= (float)payload.payload_rx_nav_pvt.sAcc * 1e-3f;
 
-		_gps_position->vel_m_s		= (float)_buf.payload_rx_nav_pvt.gSpeed * 1e-3f;
+		_gps_position->vel_m_s		= (float)payload.payload_rx_nav_pvt.gSpeed * 1e-3f;
 
-		_gps_position->vel_n_m_s	= (float)_buf.payload_rx_nav_pvt.velN * 1e-3f;
-		_gps_position->vel_e_m_s	= (float)_buf.payload_rx_nav_pvt.velE * 1e-3f;
-		_gps_position->vel_d_m_s	= (float)_buf.payload_rx_nav_pvt.velD * 1e-3f;
+		_gps_position->vel_n_m_s	= (float)payload.payload_rx_nav_pvt.velN * 1e-3f;
+		_gps_position->vel_e_m_s	= (float)payload.payload_rx_nav_pvt.velE * 1e-3f;
+		_gps_position->vel_d_m_s	= (float)payload.payload_rx_nav_pvt.velD * 1e-3f;
 		_gps_position->vel_ned_valid	= true;
 
-		_gps_position->cog_rad		= (float)_buf.payload_rx_nav_pvt.headMot * M_DEG_TO_RAD_F * 1e-5f;
-		_gps_position->c_variance_rad	= (float)_buf.payload_rx_nav_pvt.headAcc * M_DEG_TO_RAD_F * 1e-5f;
+		_gps_position->cog_rad		= (float)payload.payload_rx_nav_pvt.headMot * M_DEG_TO_RAD_F * 1e-5f;
+		_gps_position->c_variance_rad	= (float)payload.payload_rx_nav_pvt.headAcc * M_DEG_TO_RAD_F * 1e-5f;
 
 		{
 			/* convert to unix timestamp */
 			struct tm timeinfo;
-			timeinfo.tm_year	= _buf.payload_rx_nav_pvt.year - 1900;
-			timeinfo.tm_mon		= _buf.payload_rx_nav_pvt.month - 1;
-			timeinfo.tm_mday	= _buf.payload_rx_nav_pvt.day;
-			timeinfo.tm_hour	= _buf.payload_rx_nav_pvt.hour;
-			timeinfo.tm_min		= _buf.payload_rx_nav_pvt.min;
-			timeinfo.tm_sec		= _buf.payload_rx_nav_pvt.sec;
+			timeinfo.tm_year	= payload.payload_rx_nav_pvt.year - 1900;
+			timeinfo.tm_mon		= payload.payload_rx_nav_pvt.month - 1;
+			timeinfo.tm_mday	= payload.payload_rx_nav_pvt.day;
+			timeinfo.tm_hour	= payload.payload_rx_nav_pvt.hour;
+			timeinfo.tm_min		= payload.payload_rx_nav_pvt.min;
+			timeinfo.tm_sec		= payload.payload_rx_nav_pvt.sec;
 			time_t epoch = mktime(&timeinfo);
 
 #ifndef CONFIG_RTC
@@ -753,18 +757,18 @@ UBX::payload_rx_done(void)
 			//TODO generalize this by moving into gps.cpp?
 			timespec ts;
 			ts.tv_sec = epoch;
-			ts.tv_nsec = _buf.payload_rx_nav_pvt.nano;
+			ts.tv_nsec = payload.payload_rx_nav_pvt.nano;
 			clock_settime(CLOCK_REALTIME, &ts);
 #endif
 
 			_gps_position->time_gps_usec = (uint64_t)epoch * 1000000; //TODO: test this
-			_gps_position->time_gps_usec += (uint64_t)(_buf.payload_rx_nav_pvt.nano * 1e-3f);
+			_gps_position->time_gps_usec += (uint64_t)(payload.payload_rx_nav_pvt.nano * 1e-3f);
 		}
 
-		_gps_position->timestamp_time		= hrt_absolute_time();
-		_gps_position->timestamp_velocity 	= hrt_absolute_time();
-		_gps_position->timestamp_variance 	= hrt_absolute_time();
-		_gps_position->timestamp_position	= hrt_absolute_time();
+		_gps_position->timestamp_time		= fix_time(payload.payload_rx_nav_pvt.iTOW);
+		_gps_position->timestamp_velocity 	= _gps_position->timestamp_time;
+		_gps_position->timestamp_variance 	= _gps_position->timestamp_time;
+		_gps_position->timestamp_position	= _gps_position->timestamp_time;
 
 		_rate_count_vel++;
 		_rate_count_lat_lon++;
@@ -778,13 +782,13 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_NAV_POSLLH:
 		UBX_TRACE_RXMSG("Rx NAV-POSLLH\n");
 
-		_gps_position->lat	= _buf.payload_rx_nav_posllh.lat;
-		_gps_position->lon	= _buf.payload_rx_nav_posllh.lon;
-		_gps_position->alt	= _buf.payload_rx_nav_posllh.hMSL;
-		_gps_position->eph	= (float)_buf.payload_rx_nav_posllh.hAcc * 1e-3f; // from mm to m
-		_gps_position->epv	= (float)_buf.payload_rx_nav_posllh.vAcc * 1e-3f; // from mm to m
+		_gps_position->lat	= payload.payload_rx_nav_posllh.lat;
+		_gps_position->lon	= payload.payload_rx_nav_posllh.lon;
+		_gps_position->alt	= payload.payload_rx_nav_posllh.hMSL;
+		_gps_position->eph	= (float)payload.payload_rx_nav_posllh.hAcc * 1e-3f; // from mm to m
+		_gps_position->epv	= (float)payload.payload_rx_nav_posllh.vAcc * 1e-3f; // from mm to m
 
-		_gps_position->timestamp_position = hrt_absolute_time();
+		_gps_position->timestamp_position = fix_time(payload.payload_rx_nav_posllh.iTOW);
 
 		_rate_count_lat_lon++;
 		_got_posllh = true;
@@ -795,11 +799,11 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_NAV_SOL:
 		UBX_TRACE_RXMSG("Rx NAV-SOL\n");
 
-		_gps_position->fix_type		= _buf.payload_rx_nav_sol.gpsFix;
-		_gps_position->s_variance_m_s	= (float)_buf.payload_rx_nav_sol.sAcc * 1e-2f;	// from cm to m
-		_gps_position->satellites_used	= _buf.payload_rx_nav_sol.numSV;
+		_gps_position->fix_type		= payload.payload_rx_nav_sol.gpsFix;
+		_gps_position->s_variance_m_s	= (float)payload.payload_rx_nav_sol.sAcc * 1e-2f;	// from cm to m
+		_gps_position->satellites_used	= payload.payload_rx_nav_sol.numSV;
 
-		_gps_position->timestamp_variance = hrt_absolute_time();
+		_gps_position->timestamp_variance = fix_time(payload.payload_rx_nav_sol.iTOW);
 
 		ret = 1;
 		break;
@@ -810,12 +814,12 @@ UBX::payload_rx_done(void)
 		{
 			/* convert to unix timestamp */
 			struct tm timeinfo;
-			timeinfo.tm_year	= _buf.payload_rx_nav_timeutc.year - 1900;
-			timeinfo.tm_mon		= _buf.payload_rx_nav_timeutc.month - 1;
-			timeinfo.tm_mday	= _buf.payload_rx_nav_timeutc.day;
-			timeinfo.tm_hour	= _buf.payload_rx_nav_timeutc.hour;
-			timeinfo.tm_min		= _buf.payload_rx_nav_timeutc.min;
-			timeinfo.tm_sec		= _buf.payload_rx_nav_timeutc.sec;
+			timeinfo.tm_year	= payload.payload_rx_nav_timeutc.year - 1900;
+			timeinfo.tm_mon		= payload.payload_rx_nav_timeutc.month - 1;
+			timeinfo.tm_mday	= payload.payload_rx_nav_timeutc.day;
+			timeinfo.tm_hour	= payload.payload_rx_nav_timeutc.hour;
+			timeinfo.tm_min		= payload.payload_rx_nav_timeutc.min;
+			timeinfo.tm_sec		= payload.payload_rx_nav_timeutc.sec;
 			time_t epoch = mktime(&timeinfo);
 
 #ifndef CONFIG_RTC
@@ -823,15 +827,15 @@ UBX::payload_rx_done(void)
 			//TODO generalize this by moving into gps.cpp?
 			timespec ts;
 			ts.tv_sec = epoch;
-			ts.tv_nsec = _buf.payload_rx_nav_timeutc.nano;
+			ts.tv_nsec = payload.payload_rx_nav_timeutc.nano;
 			clock_settime(CLOCK_REALTIME, &ts);
 #endif
 
 			_gps_position->time_gps_usec = (uint64_t)epoch * 1000000; //TODO: test this
-			_gps_position->time_gps_usec += (uint64_t)(_buf.payload_rx_nav_timeutc.nano * 1e-3f);
+			_gps_position->time_gps_usec += (uint64_t)(payload.payload_rx_nav_timeutc.nano * 1e-3f);
 		}
 
-		_gps_position->timestamp_time = hrt_absolute_time();
+		_gps_position->timestamp_time = fix_time(payload.payload_rx_nav_timeutc.iTOW);
 
 		ret = 1;
 		break;
@@ -839,7 +843,7 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_NAV_SVINFO:
 		UBX_TRACE_RXMSG("Rx NAV-SVINFO\n");
 
-		// _satellite_info already populated by payload_rx_add_svinfo(), just add a timestamp
+		payload_rx_nav_svinfo(payload);
 		_satellite_info->timestamp = hrt_absolute_time();
 
 		ret = 2;
@@ -848,15 +852,15 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_NAV_VELNED:
 		UBX_TRACE_RXMSG("Rx NAV-VELNED\n");
 
-		_gps_position->vel_m_s		= (float)_buf.payload_rx_nav_velned.speed * 1e-2f;
-		_gps_position->vel_n_m_s	= (float)_buf.payload_rx_nav_velned.velN * 1e-2f; /* NED NORTH velocity */
-		_gps_position->vel_e_m_s	= (float)_buf.payload_rx_nav_velned.velE * 1e-2f; /* NED EAST velocity */
-		_gps_position->vel_d_m_s	= (float)_buf.payload_rx_nav_velned.velD * 1e-2f; /* NED DOWN velocity */
-		_gps_position->cog_rad		= (float)_buf.payload_rx_nav_velned.heading * M_DEG_TO_RAD_F * 1e-5f;
-		_gps_position->c_variance_rad	= (float)_buf.payload_rx_nav_velned.cAcc * M_DEG_TO_RAD_F * 1e-5f;
+		_gps_position->vel_m_s		= (float)payload.payload_rx_nav_velned.speed * 1e-2f;
+		_gps_position->vel_n_m_s	= (float)payload.payload_rx_nav_velned.velN * 1e-2f; /* NED NORTH velocity */
+		_gps_position->vel_e_m_s	= (float)payload.payload_rx_nav_velned.velE * 1e-2f; /* NED EAST velocity */
+		_gps_position->vel_d_m_s	= (float)payload.payload_rx_nav_velned.velD * 1e-2f; /* NED DOWN velocity */
+		_gps_position->cog_rad		= (float)payload.payload_rx_nav_velned.heading * M_DEG_TO_RAD_F * 1e-5f;
+		_gps_position->c_variance_rad	= (float)payload.payload_rx_nav_velned.cAcc * M_DEG_TO_RAD_F * 1e-5f;
 		_gps_position->vel_ned_valid	= true;
 
-		_gps_position->timestamp_velocity = hrt_absolute_time();
+		_gps_position->timestamp_velocity = fix_time(payload.payload_rx_nav_velned.iTOW);
 
 		_rate_count_vel++;
 		_got_velned = true;
@@ -867,6 +871,8 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_MON_VER:
 		UBX_TRACE_RXMSG("Rx MON-VER\n");
 
+		payload_rx_mon_ver(payload);
+
 		ret = 1;
 		break;
 
@@ -876,15 +882,15 @@ UBX::payload_rx_done(void)
 		switch (_rx_payload_length) {
 
 		case sizeof(ubx_payload_rx_mon_hw_ubx6_t):	/* u-blox 6 msg format */
-			_gps_position->noise_per_ms		= _buf.payload_rx_mon_hw_ubx6.noisePerMS;
-			_gps_position->jamming_indicator	= _buf.payload_rx_mon_hw_ubx6.jamInd;
+			_gps_position->noise_per_ms		= payload.payload_rx_mon_hw_ubx6.noisePerMS;
+			_gps_position->jamming_indicator	= payload.payload_rx_mon_hw_ubx6.jamInd;
 
 			ret = 1;
 			break;
 
 		case sizeof(ubx_payload_rx_mon_hw_ubx7_t):	/* u-blox 7+ msg format */
-			_gps_position->noise_per_ms		= _buf.payload_rx_mon_hw_ubx7.noisePerMS;
-			_gps_position->jamming_indicator	= _buf.payload_rx_mon_hw_ubx7.jamInd;
+			_gps_position->noise_per_ms		= payload.payload_rx_mon_hw_ubx7.noisePerMS;
+			_gps_position->jamming_indicator	= payload.payload_rx_mon_hw_ubx7.jamInd;
 
 			ret = 1;
 			break;
@@ -898,7 +904,7 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_ACK_ACK:
 		UBX_TRACE_RXMSG("Rx ACK-ACK\n");
 
-		if ((_ack_state == UBX_ACK_WAITING) && (_buf.payload_rx_ack_ack.msg == _ack_waiting_msg)) {
+		if ((_ack_state == UBX_ACK_WAITING) && (payload.payload_rx_ack_ack.msg == _ack_waiting_msg)) {
 			_ack_state = UBX_ACK_GOT_ACK;
 		}
 
@@ -908,7 +914,7 @@ UBX::payload_rx_done(void)
 	case UBX_MSG_ACK_NAK:
 		UBX_TRACE_RXMSG("Rx ACK-NAK\n");
 
-		if ((_ack_state == UBX_ACK_WAITING) && (_buf.payload_rx_ack_ack.msg == _ack_waiting_msg)) {
+		if ((_ack_state == UBX_ACK_WAITING) && (payload.payload_rx_ack_ack.msg == _ack_waiting_msg)) {
 			_ack_state = UBX_ACK_GOT_NAK;
 		}
 
@@ -925,18 +931,10 @@ UBX::payload_rx_done(void)
 void
 UBX::decode_init(void)
 {
-	_decode_state = UBX_DECODE_SYNC1;
-	_rx_ck_a = 0;
-	_rx_ck_b = 0;
+	_rx_buf_count = 0;
+	_rx_skip = 0;
+	_rx_missing = 0;
 	_rx_payload_length = 0;
-	_rx_payload_index = 0;
-}
-
-void
-UBX::add_byte_to_checksum(const uint8_t b)
-{
-	_rx_ck_a = _rx_ck_a + b;
-	_rx_ck_b = _rx_ck_b + _rx_ck_a;
 }
 
 void
@@ -981,6 +979,26 @@ UBX::send_message(const uint16_t msg, const uint8_t *payload, const uint16_t len
 	write(_fd, (const void *)&checksum, sizeof(checksum));
 }
 
+hrt_abstime
+UBX::fix_time(const uint32_t iTOW)
+{
+	int64_t offset = (int64_t)_rx_burst_time - (int64_t)iTOW * 1000;
+
+	if (!_time_offset_valid || offset < _time_offset || offset > _time_offset + UBX_TIME_OFFSET_RESET) {
+		/* earliest arrival so far */
+		_time_offset = offset;
+		_time_offset_valid = true;
+
+	} else if (iTOW != _time_offset_iTOW) {
+		/* a later arrival is either jitter or the clocks drifting apart, follow slowly */
+		_time_offset += UBX_TIME_OFFSET_CREEP;
+	}
+
+	_time_offset_iTOW = iTOW;
+
+	return (hrt_abstime)((int64_t)iTOW * 1000 + _time_offset);
+}
+
 uint32_t
 UBX::fnv1_32_str(uint8_t *str, uint32_t hval)
 {
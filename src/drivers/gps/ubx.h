@@ -54,8 +54,12 @@
 #define UBX_SYNC1 0xB5
 #define UBX_SYNC2 0x62
 
+/* holds a NAV-SVINFO frame of 64 channels, the largest frame we decode */
+#define UBX_RX_BUFFER_SIZE	800
+
 /* Message Classes */
 #define UBX_CLASS_NAV		0x01
+#define UBX_CLASS_RXM		0x02
 #define UBX_CLASS_ACK		0x05
 #define UBX_CLASS_CFG		0x06
 #define UBX_CLASS_MON		0x0A
@@ -67,6 +71,8 @@
 #define UBX_ID_NAV_VELNED	0x12
 #define UBX_ID_NAV_TIMEUTC	0x21
 #define UBX_ID_NAV_SVINFO	0x30
+#define UBX_ID_RXM_SFRBX	0x13
+#define UBX_ID_RXM_RAWX		0x15
 #define UBX_ID_ACK_NAK		0x00
 #define UBX_ID_ACK_ACK		0x01
 #define UBX_ID_CFG_PRT		0x00
@@ -84,6 +90,8 @@
 #define UBX_MSG_NAV_VELNED	((UBX_CLASS_NAV) | UBX_ID_NAV_VELNED << 8)
 #define UBX_MSG_NAV_TIMEUTC	((UBX_CLASS_NAV) | UBX_ID_NAV_TIMEUTC << 8)
 #define UBX_MSG_NAV_SVINFO	((UBX_CLASS_NAV) | UBX_ID_NAV_SVINFO << 8)
+#define UBX_MSG_RXM_SFRBX	((UBX_CLASS_RXM) | UBX_ID_RXM_SFRBX << 8)
+#define UBX_MSG_RXM_RAWX	((UBX_CLASS_RXM) | UBX_ID_RXM_RAWX << 8)
 #define UBX_MSG_ACK_NAK		((UBX_CLASS_ACK) | UBX_ID_ACK_NAK << 8)
 #define UBX_MSG_ACK_ACK		((UBX_CLASS_ACK) | UBX_ID_ACK_ACK << 8)
 #define UBX_MSG_CFG_PRT		((UBX_CLASS_CFG) | UBX_ID_CFG_PRT << 8)
@@ -117,11 +125,13 @@
 #define UBX_TX_CFG_PRT_PORTID		0x01		/**< UART1 */
 #define UBX_TX_CFG_PRT_MODE		0x000008D0	/**< 0b0000100011010000: 8N1 */
 #define UBX_TX_CFG_PRT_BAUDRATE		38400		/**< choose 38400 as GPS baudrate */
+#define UBX_TX_CFG_PRT_BAUDRATE_FAST	115200		/**< baudrate for measurement rates above 5Hz */
 #define UBX_TX_CFG_PRT_INPROTOMASK	0x01		/**< UBX in */
 #define UBX_TX_CFG_PRT_OUTPROTOMASK	0x01		/**< UBX out */
 
 /* TX CFG-RATE message contents */
 #define UBX_TX_CFG_RATE_MEASINTERVAL	200		/**< 200ms for 5Hz */
+#define UBX_TX_CFG_RATE_MIN_MEASINTERVAL	50		/**< 50ms for 20Hz, the fastest M8 rate with a single GNSS */
 #define UBX_TX_CFG_RATE_NAVRATE		1		/**< cannot be changed */
 #define UBX_TX_CFG_RATE_TIMEREF		0		/**< 0: UTC, 1: GPS time */
 
@@ -437,19 +447,6 @@ typedef union {
 #pragma pack(pop)
 /*** END OF u-blox protocol binary message and payload definitions ***/
 
-/* Decoder state */
-typedef enum {
-	UBX_DECODE_SYNC1 = 0,
-	UBX_DECODE_SYNC2,
-	UBX_DECODE_CLASS,
-	UBX_DECODE_ID,
-	UBX_DECODE_LENGTH1,
-	UBX_DECODE_LENGTH2,
-	UBX_DECODE_PAYLOAD,
-	UBX_DECODE_CHKSUM1,
-	UBX_DECODE_CHKSUM2
-} ubx_decode_state_t;
-
 /* Rx message state */
 typedef enum {
 	UBX_RXMSG_IGNORE = 0,
@@ -470,7 +467,12 @@ typedef enum {
 class UBX : public GPS_Helper
 {
 public:
-	UBX(const int &fd, struct vehicle_gps_position_s *gps_position, struct satellite_info_s *satellite_info);
+	/**
+	 * @param rate	measurement rate in Hz, limited to 20Hz. Receivers which
+	 * 		reject it run at the default 5Hz.
+	 */
+	UBX(const int &fd, struct vehicle_gps_position_s *gps_position, struct satellite_info_s *satellite_info,
+	    unsigned rate = 1000 / UBX_TX_CFG_RATE_MEASINTERVAL);
 	~UBX();
 	int			receive(const unsigned timeout);
 	int			configure(unsigned &baudrate);
@@ -478,9 +480,13 @@ public:
 private:
 
 	/**
-	 * Parse the binary UBX packet
+	 * Decode all complete UBX frames in the receive buffer
+	 *
+	 * Frames are checked and decoded in place. An incomplete frame at the
+	 * end is moved to the start of the buffer to be completed by the next read,
+	 * _rx_missing tells how much of it is still to come.
 	 */
-	int			parse_char(const uint8_t b);
+	int			parse_buffer(void);
 
 	/**
 	 * Start payload rx
@@ -488,27 +494,21 @@ private:
 	int			payload_rx_init(void);
 
 	/**
-	 * Add payload rx byte
+	 * Decode the repeated parts of variable length payloads
 	 */
-	int			payload_rx_add(const uint8_t b);
-	int			payload_rx_add_nav_svinfo(const uint8_t b);
-	int			payload_rx_add_mon_ver(const uint8_t b);
+	void			payload_rx_nav_svinfo(ubx_buf_t &payload);
+	void			payload_rx_mon_ver(ubx_buf_t &payload);
 
 	/**
 	 * Finish payload rx
 	 */
-	int			payload_rx_done(void);
+	int			payload_rx_done(ubx_buf_t &payload);
 
 	/**
-	 * Reset the parse state machine for a fresh start
+	 * Drop any partially received data for a fresh start
 	 */
 	void			decode_init(void);
 
-	/**
-	 * While parsing add every byte (except the sync bytes) to the checksum
-	 */
-	void			add_byte_to_checksum(const uint8_t);
-
 	/**
 	 * Send a message
 	 */
@@ -534,6 +534,18 @@ private:
 	 */
 	uint32_t		fnv1_32_str(uint8_t *str, uint32_t hval);
 
+	/**
+	 * Time of the fix of a navigation epoch
+	 *
+	 * The epoch cannot arrive before it was measured, so the earliest arrival
+	 * relative to the GPS time of week is the closest to the fix time. Every
+	 * epoch is stamped with its time of week shifted by that offset, which
+	 * removes the jitter of the serial line and the read delay.
+	 *
+	 * @param iTOW	GPS time of week of the epoch in ms
+	 */
+	hrt_abstime		fix_time(const uint32_t iTOW);
+
 	int			_fd;
 	struct vehicle_gps_position_s *_gps_position;
 	struct satellite_info_s *_satellite_info;
@@ -542,18 +554,25 @@ private:
 	ubx_ack_state_t		_ack_state;
 	bool			_got_posllh;
 	bool			_got_velned;
-	ubx_decode_state_t	_decode_state;
+	uint8_t			_rx_buf[UBX_RX_BUFFER_SIZE];
+	unsigned		_rx_buf_count;		/**< bytes in _rx_buf */
+	unsigned		_rx_skip;		/**< bytes left of a frame too long for _rx_buf */
+	unsigned		_rx_missing;		/**< bytes still to come for the frame at the end of _rx_buf */
 	uint16_t		_rx_msg;
 	ubx_rxmsg_state_t	_rx_state;
 	uint16_t		_rx_payload_length;
-	uint16_t		_rx_payload_index;
-	uint8_t			_rx_ck_a;
-	uint8_t			_rx_ck_b;
 	hrt_abstime		_disable_cmd_last;
 	uint16_t		_ack_waiting_msg;
 	ubx_buf_t		_buf;
 	uint32_t		_ubx_version;
 	bool			_use_nav_pvt;
+	unsigned		_baudrate;
+	unsigned		_measure_interval;	/**< ms between navigation epochs */
+	hrt_abstime		_rx_burst_time;		/**< arrival of the first byte of the current epoch */
+	hrt_abstime		_rx_last_time;		/**< last read with data */
+	int64_t			_time_offset;		/**< hrt time minus GPS time of week, us */
+	bool			_time_offset_valid;
+	uint32_t		_time_offset_iTOW;	/**< epoch the offset was last updated for */
 };
 
 #endif /* UBX_H_ */
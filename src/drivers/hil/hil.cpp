@@ -605,10 +605,8 @@ HIL::pwm_ioctl(file *filp, int cmd, unsigned long arg)
 			break;
 		}
 
-	case MIXERIOCLOADBUF: {
-			const char *buf = (const char *)arg;
-			unsigned buflen = strnlen(buf, 1024);
-
+	case MIXERIOCLOADBUF:
+	case MIXERIOCLOADBIN: {
 			if (_mixers == nullptr)
 				_mixers = new MixerGroup(control_callback, (uintptr_t)&_controls);
 
@@ -617,7 +615,16 @@ HIL::pwm_ioctl(file *filp, int cmd, unsigned long arg)
 
 			} else {
 
-				ret = _mixers->load_from_buf(buf, buflen);
+				if (cmd == MIXERIOCLOADBIN) {
+					const mixer_bin_buf_s *bin = (const mixer_bin_buf_s *)arg;
+					unsigned buflen = bin->length;
+					ret = _mixers->load_from_bin(bin->data, buflen);
+
+				} else {
+					const char *buf = (const char *)arg;
+					unsigned buflen = strnlen(buf, 1024);
+					ret = _mixers->load_from_buf(buf, buflen);
+				}
 
 				if (ret != 0) {
 					debug("mixer load failed with %d", ret);
@@ -60,6 +60,7 @@
 
 #include <board_config.h>
 
+#include <systemlib/work_profile.h>
 #include <systemlib/perf_counter.h>
 #include <systemlib/err.h>
 
@@ -85,6 +86,18 @@
 /* Max measurement rate is 160Hz, however with 160 it will be set to 166 Hz, therefore workaround using 150 */
 #define HMC5883_CONVERSION_INTERVAL	(1000000 / 150)	/* microseconds */
 
+/* highest output rate of the continuous measurement mode */
+#define HMC5883_CONTINUOUS_INTERVAL	(1000000 / 75)	/* microseconds */
+
+/* with DRDY interrupts the scheduled collection only watches for a stuck line */
+#define HMC5883_DRDY_WATCHDOG_FACTOR	4
+
+#if defined(GPIO_EXTI_COMPASS) && defined(PX4_I2C_BUS_ONBOARD)
+# define HMC5883_USE_DRDY 1
+#else
+# define HMC5883_USE_DRDY 0
+#endif
+
 #define ADDR_CONF_A			0x00
 #define ADDR_CONF_B			0x01
 #define ADDR_MODE			0x02
@@ -109,6 +122,8 @@
 #define HMC5883L_AVERAGING_4		(2 << 5)
 #define HMC5883L_AVERAGING_8		(3 << 5)
 
+#define HMC5883L_RATE_75HZ		(6 << 2) /* conf a register, continuous mode output rate */
+
 #define MODE_REG_CONTINOUS_MODE		(0 << 0)
 #define MODE_REG_SINGLE_MODE		(1 << 0) /* default */
 
@@ -146,6 +161,12 @@ public:
 	 */
 	void			print_info();
 
+	/**
+	 * Keep the sensor in continuous measurement mode instead of
+	 * triggering every conversion. Must be called before init().
+	 */
+	int			enable_continuous();
+
 protected:
 	virtual int		probe();
 
@@ -169,6 +190,8 @@ private:
 	perf_counter_t		_buffer_overflows;
 	perf_counter_t		_range_errors;
 	perf_counter_t		_conf_errors;
+	perf_counter_t		_drdy_skipped;
+	perf_counter_t		_drdy_timeouts;
 
 	/* status reporting */
 	bool			_sensor_ok;		/**< sensor was found and reports ok */
@@ -182,6 +205,21 @@ private:
 	uint8_t			_range_bits;
 	uint8_t			_conf_reg;
 
+	/* measurement cycle run by the bus scheduler, see start_async() */
+	Transaction		_async_txn;
+	volatile bool		_async_active;		/**< a transfer of the cycle is queued or completing */
+	volatile bool		_async_stop;		/**< end the cycle at the next completion */
+	hrt_abstime		_async_measure_time;	/**< start of the current measurement */
+	uint8_t			_async_cmd[2];
+	uint8_t			_async_data[6];
+
+	bool			_continuous;		/**< the sensor converts continuously at 75 Hz */
+	bool			_drdy_active;		/**< collections are started by the DRDY interrupt */
+	volatile bool		_drdy_watchdog;		/**< the queued collection is the DRDY watchdog */
+	hrt_abstime		_drdy_last_read;
+
+	static HMC5883		*_drdy_dev;		/**< instance serviced by the DRDY interrupt */
+
 	/**
 	 * Test whether the device supported by the driver is present at a
 	 * specific address.
@@ -209,6 +247,11 @@ private:
 	 */
 	int			reset();
 
+	/**
+	 * Time between two conversions in the current measurement mode.
+	 */
+	unsigned		conversion_interval() { return _continuous ? HMC5883_CONTINUOUS_INTERVAL : HMC5883_CONVERSION_INTERVAL; }
+
 	/**
 	 * Perform the on-sensor scale calibration routine.
 	 *
@@ -279,6 +322,49 @@ private:
 	 */
 	static void		cycle_trampoline(void *arg);
 
+	/**
+	 * Run the measure/collect cycle as scheduled bus transfers instead
+	 * of work queue items, so that waiting for the bus does not block
+	 * the work queue.
+	 *
+	 * @return		OK if the cycle was started, -errno if the
+	 *			work queue has to be used.
+	 */
+	int			start_async();
+
+	/**
+	 * Queue the measurement command of the scheduled cycle.
+	 *
+	 * @param start		When to send it, 0 for now.
+	 */
+	int			queue_measure(hrt_abstime start);
+
+	/**
+	 * Queue the read of the data registers of the scheduled cycle.
+	 *
+	 * @param start		When to read, 0 for now.
+	 */
+	int			queue_collect(hrt_abstime start);
+
+	/**
+	 * Start and stop collecting on the DRDY interrupt.
+	 *
+	 * @return		True if the interrupt is in use.
+	 */
+	bool			drdy_start();
+	void			drdy_stop();
+
+	/**
+	 * DRDY interrupt handler, starts a collection.
+	 */
+	static int		drdy_interrupt(int irq, void *context);
+
+	/**
+	 * Completion callbacks of the scheduled cycle.
+	 */
+	static void		measure_done(void *arg, int result);
+	static void		collect_done(void *arg, int result);
+
 	/**
 	 * Write a register.
 	 *
@@ -309,6 +395,14 @@ private:
 	 */
 	int			collect();
 
+	/**
+	 * Scale and publish the data registers read by a collection.
+	 *
+	 * @param data		The X, Z and Y output registers.
+	 * @param timestamp	Time of the measurement.
+	 */
+	int			process(uint8_t data[6], hrt_abstime timestamp);
+
 	/**
 	 * Convert a big-endian signed 16-bit value to a float.
 	 *
@@ -367,13 +461,23 @@ HMC5883::HMC5883(int bus, const char *path, enum Rotation rotation) :
 	_buffer_overflows(perf_alloc(PC_COUNT, "hmc5883_buffer_overflows")),
 	_range_errors(perf_alloc(PC_COUNT, "hmc5883_range_errors")),
 	_conf_errors(perf_alloc(PC_COUNT, "hmc5883_conf_errors")),
+	_drdy_skipped(perf_alloc(PC_COUNT, "hmc5883_drdy_skipped")),
+	_drdy_timeouts(perf_alloc(PC_COUNT, "hmc5883_drdy_timeouts")),
 	_sensor_ok(false),
 	_calibrated(false),
 	_bus(bus),
 	_rotation(rotation),
 	_last_report{0},
 	_range_bits(0),
-	_conf_reg(0)
+	_conf_reg(0),
+	_async_txn(),
+	_async_active(false),
+	_async_stop(false),
+	_async_measure_time(0),
+	_continuous(false),
+	_drdy_active(false),
+	_drdy_watchdog(false),
+	_drdy_last_read(0)
 {
 	_device_id.devid_s.devtype = DRV_MAG_DEVTYPE_HMC5883;
 
@@ -409,6 +513,15 @@ HMC5883::~HMC5883()
 	perf_free(_buffer_overflows);
 	perf_free(_range_errors);
 	perf_free(_conf_errors);
+	perf_free(_drdy_skipped);
+	perf_free(_drdy_timeouts);
+}
+
+int
+HMC5883::enable_continuous()
+{
+	_continuous = true;
+	return OK;
 }
 
 int
@@ -597,16 +710,11 @@ HMC5883::read(struct file *filp, char *buffer, size_t buflen)
 	/* if automatic measurement is enabled */
 	if (_measure_ticks > 0) {
 		/*
-		 * While there is space in the caller's buffer, and reports, copy them.
+		 * Copy as many reports as fit in the caller's buffer.
 		 * Note that we may be pre-empted by the workq thread while we are doing this;
-		 * we are careful to avoid racing with them.
+		 * the ring buffer retries the copy if it races with it.
 		 */
-		while (count--) {
-			if (_reports->get(mag_buf)) {
-				ret += sizeof(struct mag_report);
-				mag_buf++;
-			}
-		}
+		ret = _reports->get_multiple(mag_buf, count) * sizeof(struct mag_report);
 
 		/* if there was no data, warn the caller */
 		return ret ? ret : -EAGAIN;
@@ -617,14 +725,14 @@ HMC5883::read(struct file *filp, char *buffer, size_t buflen)
 	do {
 		_reports->flush();
 
-		/* trigger a measurement */
-		if (OK != measure()) {
+		/* trigger a measurement, in continuous mode the next one is coming anyway */
+		if (!_continuous && OK != measure()) {
 			ret = -EIO;
 			break;
 		}
 
 		/* wait for it to complete */
-		usleep(HMC5883_CONVERSION_INTERVAL);
+		usleep(conversion_interval());
 
 		/* run the collection phase */
 		if (OK != collect()) {
@@ -667,7 +775,7 @@ HMC5883::ioctl(struct file *filp, int cmd, unsigned long arg)
 				bool want_start = (_measure_ticks == 0);
 
 				/* set interval for next measurement to minimum legal value */
-				_measure_ticks = USEC2TICK(HMC5883_CONVERSION_INTERVAL);
+				_measure_ticks = USEC2TICK(conversion_interval());
 
 				/* if we need to start the poll state machine, do it */
 				if (want_start)
@@ -685,7 +793,7 @@ HMC5883::ioctl(struct file *filp, int cmd, unsigned long arg)
 				unsigned ticks = USEC2TICK(1000000 / arg);
 
 				/* check against maximum rate */
-				if (ticks < USEC2TICK(HMC5883_CONVERSION_INTERVAL))
+				if (ticks < USEC2TICK(conversion_interval()))
 					return -EINVAL;
 
 				/* update interval for next measurement */
@@ -732,6 +840,9 @@ HMC5883::ioctl(struct file *filp, int cmd, unsigned long arg)
 		return ioctl(filp, SENSORIOCSPOLLRATE, arg);
 
 	case MAGIOCGSAMPLERATE:
+		if (_continuous)
+			return 1000000 / HMC5883_CONTINUOUS_INTERVAL;
+
 		/* same as pollrate because device is in single measurement mode*/
 		return 1000000/TICK2USEC(_measure_ticks);
 
@@ -786,19 +897,223 @@ HMC5883::start()
 	_collect_phase = false;
 	_reports->flush();
 
+	/* prefer the bus scheduler, DRDY needs it running */
+	if (start_async() == OK) {
+		drdy_start();
+		return;
+	}
+
 	/* schedule a cycle to start things */
-	work_queue(HPWORK, &_work, (worker_t)&HMC5883::cycle_trampoline, this, 1);
+	work_queue_profiled(HPWORK, &_work, (worker_t)&HMC5883::cycle_trampoline, this, 1, "hmc5883");
 }
 
 void
 HMC5883::stop()
 {
 	work_cancel(HPWORK, &_work);
+
+	/* end the scheduled cycle */
+	_async_stop = true;
+	drdy_stop();
+
+	if (transfer_cancel(&_async_txn))
+		_async_active = false;
+
+	/* a transfer is running, its completion sees _async_stop */
+	while (_async_active)
+		usleep(1000);
+}
+
+int
+HMC5883::start_async()
+{
+	if (_async_active)
+		return -EBUSY;
+
+	_async_stop = false;
+	_async_active = true;
+	_drdy_watchdog = false;
+
+	int ret = _continuous ? queue_collect(0) : queue_measure(0);
+
+	if (ret != OK)
+		_async_active = false;
+
+	return ret;
+}
+
+int
+HMC5883::queue_measure(hrt_abstime start)
+{
+	_async_measure_time = (start != 0) ? start : hrt_absolute_time();
+	_async_cmd[0] = ADDR_MODE;
+	_async_cmd[1] = MODE_REG_SINGLE_MODE;
+
+	/* due before the conversion would have to start */
+	return transfer_async(&_async_txn, &_async_cmd[0], 2, nullptr, 0,
+			      start, _async_measure_time + HMC5883_CONVERSION_INTERVAL / 2,
+			      &HMC5883::measure_done, this);
+}
+
+void
+HMC5883::measure_done(void *arg, int result)
+{
+	HMC5883 *dev = (HMC5883 *)arg;
+
+	if (result != OK)
+		perf_count(dev->_comms_errors);
+
+	if (dev->_async_stop) {
+		dev->_async_active = false;
+		return;
+	}
+
+	/* collect once the conversion is done */
+	if (dev->queue_collect(hrt_absolute_time() + HMC5883_CONVERSION_INTERVAL) != OK)
+		dev->_async_active = false;
+}
+
+int
+HMC5883::queue_collect(hrt_abstime start)
+{
+	hrt_abstime due = (start != 0) ? start : hrt_absolute_time();
+
+	/* continuous conversions are timed by their reads, triggered ones by the command */
+	if (_continuous)
+		_async_measure_time = due;
+
+	_async_cmd[0] = ADDR_DATA_OUT_X_MSB;
+
+	return transfer_async(&_async_txn, &_async_cmd[0], 1,
+			      &_async_data[0], sizeof(_async_data),
+			      start, due + conversion_interval() / 2,
+			      &HMC5883::collect_done, this);
+}
+
+void
+HMC5883::collect_done(void *arg, int result)
+{
+	HMC5883 *dev = (HMC5883 *)arg;
+	hrt_abstime now = hrt_absolute_time();
+
+	if (result == OK) {
+		/* a continuous conversion is best stamped by when it was read or signalled */
+		dev->process(dev->_async_data, dev->_continuous ? dev->_async_measure_time : now);
+
+	} else {
+		perf_count(dev->_comms_errors);
+	}
+
+	if (dev->_async_stop) {
+		dev->_async_active = false;
+		return;
+	}
+
+	/* the watchdog ran out, DRDY is not arriving: go back to timed reads */
+	if (dev->_drdy_watchdog && dev->_drdy_active) {
+		perf_count(dev->_drdy_timeouts);
+		dev->drdy_stop();
+	}
+
+	/* next measurement one poll interval after this one, or now if late */
+	unsigned interval = TICK2USEC(dev->_measure_ticks);
+
+	if (dev->_drdy_active)
+		interval *= HMC5883_DRDY_WATCHDOG_FACTOR;
+
+	hrt_abstime next = dev->_async_measure_time + interval;
+
+	if (next <= now)
+		next = 0;
+
+	/* the interrupt may replace the queued collection, it must not see a stale flag */
+	irqstate_t flags = irqsave();
+	dev->_drdy_watchdog = dev->_drdy_active;
+	int ret = dev->_continuous ? dev->queue_collect(next) : dev->queue_measure(next);
+	irqrestore(flags);
+
+	if (ret != OK)
+		dev->_async_active = false;
+}
+
+HMC5883 *HMC5883::_drdy_dev = nullptr;
+
+bool
+HMC5883::drdy_start()
+{
+#if HMC5883_USE_DRDY
+	/* only continuous conversions signal DRDY on their own */
+	if (!_continuous || _bus != PX4_I2C_BUS_ONBOARD)
+		return false;
+
+	_drdy_last_read = 0;
+	_drdy_dev = this;
+	_drdy_active = true;
+
+	stm32_gpiosetevent(GPIO_EXTI_COMPASS, true, false, true, &HMC5883::drdy_interrupt);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void
+HMC5883::drdy_stop()
+{
+#if HMC5883_USE_DRDY
+
+	if (_drdy_active) {
+		stm32_gpiosetevent(GPIO_EXTI_COMPASS, false, false, false, nullptr);
+		_drdy_active = false;
+		_drdy_dev = nullptr;
+	}
+
+#endif
+}
+
+int
+HMC5883::drdy_interrupt(int irq, void *context)
+{
+	/* stamp first, this is the time the sample was taken */
+	hrt_abstime now = hrt_absolute_time();
+	HMC5883 *dev = _drdy_dev;
+
+	if (dev == nullptr || dev->_async_stop)
+		return OK;
+
+	/* decimate the sensor rate to the poll rate, within half a sample */
+	if (now - dev->_drdy_last_read + HMC5883_CONTINUOUS_INTERVAL / 2 < TICK2USEC(dev->_measure_ticks))
+		return OK;
+
+	/* replace the queued watchdog; if a transfer is in flight, skip this sample */
+	if (!dev->transfer_cancel(&dev->_async_txn)) {
+		perf_count(dev->_drdy_skipped);
+		return OK;
+	}
+
+	dev->_drdy_last_read = now;
+	dev->_drdy_watchdog = false;
+
+	if (dev->queue_collect(0) != OK)
+		dev->_async_active = false;
+
+	return OK;
 }
 
 int
 HMC5883::reset()
 {
+	if (_continuous) {
+		/* single averaged conversions at the highest continuous rate */
+		_conf_reg = HMC5883L_AVERAGING_1 | HMC5883L_RATE_75HZ;
+
+		if (OK != write_reg(ADDR_CONF_A, _conf_reg) ||
+		    OK != write_reg(ADDR_MODE, MODE_REG_CONTINOUS_MODE)) {
+			perf_count(_comms_errors);
+			return -EIO;
+		}
+	}
+
 	/* set range */
 	return set_range(_range_ga);
 }
@@ -814,6 +1129,20 @@ HMC5883::cycle_trampoline(void *arg)
 void
 HMC5883::cycle()
 {
+	/* in continuous mode there is nothing to trigger, just read the latest conversion */
+	if (_continuous) {
+		if (OK != collect())
+			debug("collection error");
+
+		work_queue_profiled(HPWORK,
+			            &_work,
+			            (worker_t)&HMC5883::cycle_trampoline,
+			            this,
+			            _measure_ticks,
+			            "hmc5883");
+		return;
+	}
+
 	/* collection phase? */
 	if (_collect_phase) {
 
@@ -834,11 +1163,12 @@ HMC5883::cycle()
 		if (_measure_ticks > USEC2TICK(HMC5883_CONVERSION_INTERVAL)) {
 
 			/* schedule a fresh cycle call when we are ready to measure again */
-			work_queue(HPWORK,
-				   &_work,
-				   (worker_t)&HMC5883::cycle_trampoline,
-				   this,
-				   _measure_ticks - USEC2TICK(HMC5883_CONVERSION_INTERVAL));
+			work_queue_profiled(HPWORK,
+				            &_work,
+				            (worker_t)&HMC5883::cycle_trampoline,
+				            this,
+				            _measure_ticks - USEC2TICK(HMC5883_CONVERSION_INTERVAL),
+				            "hmc5883");
 
 			return;
 		}
@@ -852,11 +1182,12 @@ HMC5883::cycle()
 	_collect_phase = true;
 
 	/* schedule a fresh cycle call when the measurement is done */
-	work_queue(HPWORK,
-		   &_work,
-		   (worker_t)&HMC5883::cycle_trampoline,
-		   this,
-		   USEC2TICK(HMC5883_CONVERSION_INTERVAL));
+	work_queue_profiled(HPWORK,
+		            &_work,
+		            (worker_t)&HMC5883::cycle_trampoline,
+		            this,
+		            USEC2TICK(HMC5883_CONVERSION_INTERVAL),
+		            "hmc5883");
 }
 
 int
@@ -877,6 +1208,36 @@ HMC5883::measure()
 
 int
 HMC5883::collect()
+{
+	uint8_t data[6];
+	uint8_t	cmd;
+	int	ret;
+
+	/* this should be fairly close to the end of the measurement, so the best approximation of the time */
+	hrt_abstime timestamp = hrt_absolute_time();
+
+	/*
+	 * @note  We could read the status register here, which could tell us that
+	 *        we were too early and that the output registers are still being
+	 *        written.  In the common case that would just slow us down, and
+	 *        we're better off just never being early.
+	 */
+
+	/* get measurements from the device */
+	cmd = ADDR_DATA_OUT_X_MSB;
+	ret = transfer(&cmd, 1, &data[0], sizeof(data));
+
+	if (ret != OK) {
+		perf_count(_comms_errors);
+		debug("data/status read error");
+		return ret;
+	}
+
+	return process(data, timestamp);
+}
+
+int
+HMC5883::process(uint8_t data[6], hrt_abstime timestamp)
 {
 #pragma pack(push, 1)
 	struct { /* status register and data as read back from the device */
@@ -890,32 +1251,15 @@ HMC5883::collect()
 	} report;
 
 	int	ret;
-	uint8_t	cmd;
 	uint8_t check_counter;
 
 	perf_begin(_sample_perf);
 	struct mag_report new_report;
 
-	/* this should be fairly close to the end of the measurement, so the best approximation of the time */
-	new_report.timestamp = hrt_absolute_time();
+	new_report.timestamp = timestamp;
         new_report.error_count = perf_event_count(_comms_errors);
 
-	/*
-	 * @note  We could read the status register here, which could tell us that
-	 *        we were too early and that the output registers are still being
-	 *        written.  In the common case that would just slow us down, and
-	 *        we're better off just never being early.
-	 */
-
-	/* get measurements from the device */
-	cmd = ADDR_DATA_OUT_X_MSB;
-	ret = transfer(&cmd, 1, (uint8_t *)&hmc_report, sizeof(hmc_report));
-
-	if (ret != OK) {
-		perf_count(_comms_errors);
-		debug("data/status read error");
-		goto out;
-	}
+	memcpy(&hmc_report, data, sizeof(hmc_report));
 
 	/* swap the data we just received */
 	report.x = (((int16_t)hmc_report.x[0]) << 8) + hmc_report.x[1];
@@ -1322,7 +1666,10 @@ HMC5883::print_info()
 	perf_print_counter(_sample_perf);
 	perf_print_counter(_comms_errors);
 	perf_print_counter(_buffer_overflows);
+	perf_print_counter(_drdy_skipped);
+	perf_print_counter(_drdy_timeouts);
 	printf("poll interval:  %u ticks\n", _measure_ticks);
+	printf("mode:           %s\n", _continuous ? (_drdy_active ? "continuous, DRDY" : "continuous") : "single");
 	printf("output  (%.2f %.2f %.2f)\n", (double)_last_report.x, (double)_last_report.y, (double)_last_report.z);
 	printf("offsets (%.2f %.2f %.2f)\n", (double)_scale.x_offset, (double)_scale.y_offset, (double)_scale.z_offset);
 	printf("scaling (%.2f %.2f %.2f) 1/range_scale %.2f range_ga %.2f\n", 
@@ -1346,7 +1693,7 @@ const int ERROR = -1;
 HMC5883	*g_dev_int = nullptr;
 HMC5883	*g_dev_ext = nullptr;
 
-void	start(int bus, enum Rotation rotation);
+void	start(int bus, enum Rotation rotation, bool continuous);
 void	test(int bus);
 void	reset(int bus);
 void	info(int bus);
@@ -1360,7 +1707,7 @@ void	usage();
  * is either successfully up and running or failed to start.
  */
 void
-start(int bus, enum Rotation rotation)
+start(int bus, enum Rotation rotation, bool continuous)
 {
 	int fd;
 
@@ -1369,6 +1716,8 @@ start(int bus, enum Rotation rotation)
 		if (g_dev_ext != nullptr)
 			errx(0, "already started external");
 		g_dev_ext = new HMC5883(PX4_I2C_BUS_EXPANSION, HMC5883L_DEVICE_PATH_EXT, rotation);
+		if (g_dev_ext != nullptr && continuous)
+			g_dev_ext->enable_continuous();
 		if (g_dev_ext != nullptr && OK != g_dev_ext->init()) {
 			delete g_dev_ext;
 			g_dev_ext = nullptr;
@@ -1382,6 +1731,8 @@ start(int bus, enum Rotation rotation)
 		if (g_dev_int != nullptr)
 			errx(0, "already started internal");
 		g_dev_int = new HMC5883(PX4_I2C_BUS_ONBOARD, HMC5883L_DEVICE_PATH_INT, rotation);
+		if (g_dev_int != nullptr && continuous)
+			g_dev_int->enable_continuous();
 		if (g_dev_int != nullptr && OK != g_dev_int->init()) {
 
 			/* tear down the failing onboard instance */
@@ -1615,6 +1966,7 @@ usage()
 	warnx("options:");
 	warnx("    -R rotation");
 	warnx("    -C calibrate on start");
+	warnx("    -M continuous measurement mode (75 Hz, DRDY where wired)");
 	warnx("    -X only external bus");
 #ifdef PX4_I2C_BUS_ONBOARD
 	warnx("    -I only internal bus");
@@ -1630,8 +1982,9 @@ hmc5883_main(int argc, char *argv[])
 	int bus = -1;
 	enum Rotation rotation = ROTATION_NONE;
         bool calibrate = false;
+	bool continuous = false;
 
-	while ((ch = getopt(argc, argv, "XIR:C")) != EOF) {
+	while ((ch = getopt(argc, argv, "XIR:CM")) != EOF) {
 		switch (ch) {
 		case 'R':
 			rotation = (enum Rotation)atoi(optarg);
@@ -1647,6 +2000,9 @@ hmc5883_main(int argc, char *argv[])
 		case 'C':
 			calibrate = true;
 			break;
+		case 'M':
+			continuous = true;
+			break;
 		default:
 			hmc5883::usage();
 			exit(0);
@@ -1659,7 +2015,7 @@ hmc5883_main(int argc, char *argv[])
 	 * Start/load the driver.
 	 */
 	if (!strcmp(verb, "start")) {
-		hmc5883::start(bus, rotation);
+		hmc5883::start(bus, rotation, continuous);
 		if (calibrate) {
 			if (hmc5883::calibrate(bus) == 0) {
 				errx(0, "calibration successful");
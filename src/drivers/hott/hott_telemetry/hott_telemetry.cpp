@@ -82,12 +82,13 @@ extern "C" __EXPORT int hott_telemetry_main(int argc, char *argv[]);
 int hott_telemetry_thread_main(int argc, char *argv[]);
 
 static int recv_req_id(int uart, uint8_t *id);
-static int send_data(int uart, uint8_t *buffer, size_t size);
+static int send_data(int uart, const uint8_t *buffer, size_t size);
 
 int
 recv_req_id(int uart, uint8_t *id)
 {
 	static const int timeout_ms = 1000;  // TODO make it a define
+	static const int update_ms = 50;
 
 	uint8_t mode;
 	
@@ -95,7 +96,14 @@ recv_req_id(int uart, uint8_t *id)
 	fds.fd = uart;
 	fds.events = POLLIN;
 
-	if (poll(&fds, 1, timeout_ms) > 0) {
+	int ret;
+
+	/* keep the frames current while waiting, a request is answered with what is ready */
+	for (int waited = 0; (ret = poll(&fds, 1, update_ms)) == 0 && waited < timeout_ms; waited += update_ms) {
+		update_messages();
+	}
+
+	if (ret > 0) {
 		/* Get the mode: binary or text  */
 		read(uart, &mode, sizeof(mode));
 
@@ -115,20 +123,12 @@ recv_req_id(int uart, uint8_t *id)
 }
 
 int
-send_data(int uart, uint8_t *buffer, size_t size)
+send_data(int uart, const uint8_t *buffer, size_t size)
 {
 	usleep(POST_READ_DELAY_IN_USECS);
 
-	uint16_t checksum = 0;
+	/* the checksum is in the frame already */
 	for (size_t i = 0; i < size; i++) {
-		if (i == size - 1) {
-			/* Set the checksum: the first uint8_t is taken as the checksum. */
-			buffer[i] = checksum & 0xff;
-
-		} else {
-			checksum += buffer[i];
-		}
-
 		write(uart, &buffer[i], sizeof(buffer[i]));
 
 		/* Sleep before sending the next byte. */
@@ -173,8 +173,9 @@ hott_telemetry_thread_main(int argc, char *argv[])
 	}
 
 	init_sub_messages();
+	update_messages();
 
-	uint8_t buffer[MAX_MESSAGE_BUFFER_SIZE];
+	const uint8_t *buffer = nullptr;
 	size_t size = 0;
 	uint8_t id = 0;
 	bool connected = true;
@@ -186,22 +187,14 @@ hott_telemetry_thread_main(int argc, char *argv[])
 				warnx("OK");
 			}
 
-			switch (id) {
-			case EAM_SENSOR_ID:
-				build_eam_response(buffer, &size);
-				break;
-			case GAM_SENSOR_ID:
-				build_gam_response(buffer, &size);
-				break;
-			case GPS_SENSOR_ID:
-				build_gps_response(buffer, &size);
-				break;
-
-			default:
+			if (!get_response(id, &buffer, &size)) {
 				continue;	// Not a module we support.
 			}
 
 			send_data(uart, buffer, size);
+
+			/* the receiver polls the next sensor only after a pause */
+			update_messages();
 		} else {
 			connected = false;
 			warnx("syncing");
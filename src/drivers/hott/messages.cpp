@@ -69,6 +69,17 @@ static bool _home_position_set = false;
 static double _home_lat = 0.0d;
 static double _home_lon = 0.0d;
 
+/* the response frames, encoded ahead of the requests */
+struct response_frame {
+	uint8_t data[MAX_MESSAGE_BUFFER_SIZE];
+	size_t size;
+	bool valid;
+};
+
+static struct response_frame _eam_frame;
+static struct response_frame _gam_frame;
+static struct response_frame _gps_frame;
+
 void 
 init_sub_messages(void)
 {
@@ -208,12 +219,7 @@ build_gam_response(uint8_t *buffer, size_t *size)
 void 
 build_gps_response(uint8_t *buffer, size_t *size)
 {
-	/* get a local copy of the current sensor values */
-	struct sensor_combined_s raw;
-	memset(&raw, 0, sizeof(raw));
-	orb_copy(ORB_ID(sensor_combined), _sensor_sub, &raw);
-
- 	/* get a local copy of the battery data */
+	/* get a local copy of the gps data */
 	struct vehicle_gps_position_s gps;
 	memset(&gps, 0, sizeof(gps));
 	orb_copy(ORB_ID(vehicle_gps_position), _gps_sub, &gps);
@@ -319,6 +325,78 @@ build_gps_response(uint8_t *buffer, size_t *size)
 	memcpy(buffer, &msg, *size);
 }
 
+static bool
+topic_updated(int sub)
+{
+	bool updated = false;
+	orb_check(sub, &updated);
+	return updated;
+}
+
+static void
+build_frame(struct response_frame *frame, void (*build)(uint8_t *buffer, size_t *size))
+{
+	build(frame->data, &frame->size);
+
+	/* the last byte is the checksum over all the others */
+	uint16_t checksum = 0;
+
+	for (size_t i = 0; i < frame->size - 1; i++)
+		checksum += frame->data[i];
+
+	frame->data[frame->size - 1] = checksum & 0xff;
+	frame->valid = true;
+}
+
+void
+update_messages(void)
+{
+	/* each builder copies all of its topics, which clears their updated flags */
+	if (!_eam_frame.valid || topic_updated(_sensor_sub) || topic_updated(_battery_sub) ||
+	    topic_updated(_airspeed_sub)) {
+		build_frame(&_eam_frame, build_eam_response);
+	}
+
+	if (!_gam_frame.valid || topic_updated(_esc_sub)) {
+		build_frame(&_gam_frame, build_gam_response);
+	}
+
+	/* the home position only matters together with a new fix */
+	if (!_gps_frame.valid || topic_updated(_gps_sub)) {
+		build_frame(&_gps_frame, build_gps_response);
+	}
+}
+
+bool
+get_response(uint8_t id, const uint8_t **buffer, size_t *size)
+{
+	struct response_frame *frame;
+
+	switch (id) {
+	case EAM_SENSOR_ID:
+		frame = &_eam_frame;
+		break;
+
+	case GAM_SENSOR_ID:
+		frame = &_gam_frame;
+		break;
+
+	case GPS_SENSOR_ID:
+		frame = &_gps_frame;
+		break;
+
+	default:
+		return false;
+	}
+
+	if (!frame->valid)
+		return false;
+
+	*buffer = frame->data;
+	*size = frame->size;
+	return true;
+}
+
 void
 convert_to_degrees_minutes_seconds(double val, int *deg, int *min, int *sec)
 {
@@ -45,8 +45,8 @@
 #include <stdlib.h>
 
 /* The HoTT receiver demands a minimum 5ms period of silence after delivering its request.
- * Note that the value specified here is lower than 5000 (5ms) as time is lost constucting
- * the message after the read which takes some milliseconds.
+ * Note that the value specified here is lower than 5000 (5ms) as time is lost looking up
+ * the response and waking up after the read.
  */
 #define POST_READ_DELAY_IN_USECS	4000
 /* A pause of 3ms is required between each uint8_t sent back to the HoTT receiver. Much lower
@@ -242,6 +242,24 @@ void publish_gam_message(const uint8_t *buffer);
 void build_eam_response(uint8_t *buffer, size_t *size);
 void build_gam_response(uint8_t *buffer, size_t *size);
 void build_gps_response(uint8_t *buffer, size_t *size);
+
+/**
+ * Rebuild the response frames whose topics have changed.
+ *
+ * Called between requests, so that a request is answered with a frame
+ * that is ready to go, checksum included.
+ */
+void update_messages(void);
+
+/**
+ * Get the ready response frame of a sensor.
+ *
+ * @param id		The sensor ID polled by the receiver.
+ * @param buffer	Set to the frame.
+ * @param size		Set to the length of the frame.
+ * @return		false if the sensor is not one we emulate.
+ */
+bool get_response(uint8_t id, const uint8_t **buffer, size_t *size);
 float _get_distance_to_next_waypoint(double lat_now, double lon_now, double lat_next, double lon_next);
 void convert_to_degrees_minutes_seconds(double lat, int *deg, int *min, int *sec);
 
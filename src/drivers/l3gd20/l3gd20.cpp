@@ -66,6 +66,7 @@
 #include <drivers/device/spi.h>
 #include <drivers/drv_gyro.h>
 #include <drivers/device/ringbuffer.h>
+#include <drivers/device/integrator.h>
 
 #include <board_config.h>
 #include <mathlib/math/filter/LowPassFilter2p.hpp>
@@ -172,12 +173,42 @@ static const int ERROR = -1;
 #define FIFO_CTRL_STREAM_TO_FIFO_MODE		(3<<5)
 #define FIFO_CTRL_BYPASS_TO_STREAM_MODE		(1<<7)
 
+#define FIFO_SRC_WTM				(1<<7)
+#define FIFO_SRC_OVRN				(1<<6)
+#define FIFO_SRC_EMPTY				(1<<5)
+#define FIFO_SRC_FSS_MASK			0x1F
+
 #define L3GD20_DEFAULT_RATE			760
 #define L3G4200D_DEFAULT_RATE			800
 #define L3GD20_DEFAULT_RANGE_DPS		2000
 #define L3GD20_DEFAULT_FILTER_FREQ		30
+
+/* driver filter at the default rate, computed at build time */
+static constexpr math::LowPassFilter2pCoefficients l3gd20_default_filter =
+	math::lowpass_2p_coefficients(L3GD20_DEFAULT_RATE, L3GD20_DEFAULT_FILTER_FREQ);
 #define L3GD20_TEMP_OFFSET_CELSIUS		40
 
+#ifdef GPIO_EXTI_GYRO_DRDY
+# define L3GD20_USE_DRDY 1
+#else
+# define L3GD20_USE_DRDY 0
+#endif
+
+/* with DRDY interrupts the hrt_call only watches for a stuck line */
+#define L3GD20_DRDY_WATCHDOG_FACTOR		4
+
+/*
+  FIFO mode: in stream mode the sensor queues up to 32 samples of the
+  three axes, 6 bytes each, which are drained in one burst per poll.
+  The default poll collects L3GD20_FIFO_BURST samples per burst, at
+  most L3GD20_FIFO_MAX_INTERVAL may pass between bursts so the FIFO
+  never fills beyond half at the highest rate.
+ */
+#define L3GD20_FIFO_DEPTH			32
+#define L3GD20_FIFO_SAMPLE_SIZE			6
+#define L3GD20_FIFO_BURST			8
+#define L3GD20_FIFO_MAX_INTERVAL		20000
+
 #ifndef SENSOR_BOARD_ROTATION_DEFAULT
 #define SENSOR_BOARD_ROTATION_DEFAULT		SENSOR_BOARD_ROTATION_270_DEG
 #endif
@@ -200,6 +231,12 @@ public:
 	 */
 	void			print_info();
 
+	/**
+	 * Drain the sensor FIFO in bursts instead of reading every
+	 * sample on its own. Must be called before init().
+	 */
+	int			enable_fifo();
+
 protected:
 	virtual int		probe();
 
@@ -226,6 +263,21 @@ private:
 	perf_counter_t		_reschedules;
 	perf_counter_t		_errors;
 
+	/* data ready interrupt state */
+	bool			_drdy_active;
+	volatile bool		_drdy_seen;
+	hrt_abstime		_drdy_last_read;
+	perf_counter_t		_drdy_timeouts;
+
+	/* FIFO mode state */
+	bool			_use_fifo;
+	uint8_t			*_fifo_buffer;
+	hrt_abstime		_fifo_last_read;
+	perf_counter_t		_fifo_overruns;
+
+	/* the instance on the sensor bus owns the DRDY line */
+	static L3GD20		*_drdy_dev;
+
 	math::LowPassFilter2p	_gyro_filter_x;
 	math::LowPassFilter2p	_gyro_filter_y;
 	math::LowPassFilter2p	_gyro_filter_z;
@@ -235,6 +287,8 @@ private:
 
 	enum Rotation		_rotation;
 
+	Integrator		_gyro_int;
+
 	/**
 	 * Start automatic measurement.
 	 */
@@ -266,10 +320,55 @@ private:
 	 */
 	static void		measure_trampoline(void *arg);
 
+	/**
+	 * Data ready interrupt handler, triggers a read stamped with the
+	 * time of the interrupt.
+	 */
+	static int		drdy_interrupt(int irq, void *context);
+
+	/**
+	 * Attach the data ready interrupt if the board has one.
+	 *
+	 * @return		true if reads are driven by the interrupt.
+	 */
+	bool			drdy_start();
+	void			drdy_stop();
+
 	/**
 	 * Fetch measurements from the sensor and update the report ring.
+	 *
+	 * @param timestamp	Time of the sample, 0 to stamp it when read.
+	 */
+	void			measure(hrt_abstime timestamp = 0);
+
+	/**
+	 * Drain the FIFO in one burst and queue every sample.
+	 */
+	void			measure_fifo();
+
+	/**
+	 * Discard the FIFO content and restart queueing.
+	 */
+	void			fifo_reset();
+
+	/**
+	 * Scale, filter and integrate one sample and queue the report.
+	 *
+	 * @param x, y, z	Raw sensor axes.
+	 * @param temp		Raw temperature.
+	 * @param timestamp	Time of the sample.
+	 * @param close		Close the integral if no integration interval
+	 *			is set, false for all but the newest sample of
+	 *			a FIFO burst.
+	 */
+	void			process_sample(int16_t x, int16_t y, int16_t z, int8_t temp,
+					       hrt_abstime timestamp, bool close);
+
+	/**
+	 * Rate the driver filters run at: the poll rate, or the sensor
+	 * rate in FIFO mode where every sample is filtered.
 	 */
-	void			measure();
+	float			filter_rate() { return _use_fifo ? _current_rate : 1.0e6f / _call_interval; }
 
 	/**
 	 * Read a register from the L3GD20
@@ -347,7 +446,7 @@ L3GD20::L3GD20(int bus, const char* path, spi_dev_e device, enum Rotation rotati
 	_gyro_range_scale(0.0f),
 	_gyro_range_rad_s(0.0f),
 	_gyro_topic(-1),
-	_orb_id(nullptr),
+	_orb_id(ORB_ID(sensor_gyro)),
 	_class_instance(-1),
 	_current_rate(0),
 	_orientation(SENSOR_BOARD_ROTATION_DEFAULT),
@@ -355,11 +454,20 @@ L3GD20::L3GD20(int bus, const char* path, spi_dev_e device, enum Rotation rotati
 	_sample_perf(perf_alloc(PC_ELAPSED, "l3gd20_read")),
 	_reschedules(perf_alloc(PC_COUNT, "l3gd20_reschedules")),
 	_errors(perf_alloc(PC_COUNT, "l3gd20_errors")),
-	_gyro_filter_x(L3GD20_DEFAULT_RATE, L3GD20_DEFAULT_FILTER_FREQ),
-	_gyro_filter_y(L3GD20_DEFAULT_RATE, L3GD20_DEFAULT_FILTER_FREQ),
-	_gyro_filter_z(L3GD20_DEFAULT_RATE, L3GD20_DEFAULT_FILTER_FREQ),
+	_drdy_active(false),
+	_drdy_seen(false),
+	_drdy_last_read(0),
+	_drdy_timeouts(perf_alloc(PC_COUNT, "l3gd20_drdy_timeouts")),
+	_use_fifo(false),
+	_fifo_buffer(nullptr),
+	_fifo_last_read(0),
+	_fifo_overruns(perf_alloc(PC_COUNT, "l3gd20_fifo_overruns")),
+	_gyro_filter_x(l3gd20_default_filter),
+	_gyro_filter_y(l3gd20_default_filter),
+	_gyro_filter_z(l3gd20_default_filter),
 	_is_l3g4200d(false),
-        _rotation(rotation)                                            
+        _rotation(rotation),
+	_gyro_int(0, true)
 {
 	// enable debug() calls
 	_debug_enabled = true;
@@ -389,6 +497,17 @@ L3GD20::~L3GD20()
 	perf_free(_sample_perf);
 	perf_free(_reschedules);
 	perf_free(_errors);
+	perf_free(_drdy_timeouts);
+	perf_free(_fifo_overruns);
+
+	delete[] _fifo_buffer;
+}
+
+int
+L3GD20::enable_fifo()
+{
+	_use_fifo = true;
+	return OK;
 }
 
 int
@@ -400,37 +519,41 @@ L3GD20::init()
 	if (SPI::init() != OK)
 		goto out;
 
-	/* allocate basic report buffers */
-	_reports = new RingBuffer(2, sizeof(gyro_report));
+	{
+		/* in FIFO mode the buffer holds all samples of a burst */
+		unsigned depth = 2;
 
-	if (_reports == nullptr)
-		goto out;
+		if (_use_fifo) {
+			_fifo_buffer = new uint8_t[1 + L3GD20_FIFO_DEPTH * L3GD20_FIFO_SAMPLE_SIZE];
 
-	_class_instance = register_class_devname(GYRO_DEVICE_PATH);
+			if (_fifo_buffer == nullptr)
+				goto out;
 
-	switch (_class_instance) {
-		case CLASS_DEVICE_PRIMARY:
-			_orb_id = ORB_ID(sensor_gyro0);
-			break;
+			depth = L3GD20_FIFO_DEPTH;
+		}
 
-		case CLASS_DEVICE_SECONDARY:
-			_orb_id = ORB_ID(sensor_gyro1);
-			break;
+		/* allocate basic report buffers */
+		_reports = new RingBuffer(depth, sizeof(gyro_report));
 
-		case CLASS_DEVICE_TERTIARY:
-			_orb_id = ORB_ID(sensor_gyro2);
-			break;
+		if (_reports == nullptr)
+			goto out;
 	}
 
+	_class_instance = register_class_devname(GYRO_DEVICE_PATH);
+
 	reset();
 
+	/* let the FIFO queue a couple of samples for the first report */
+	if (_use_fifo)
+		usleep(2 * 1000000 / _current_rate);
+
 	measure();
 
 	/* advertise sensor topic, measure manually to initialize valid report */
 	struct gyro_report grp;
 	_reports->get(&grp);
 
-	_gyro_topic = orb_advertise(_orb_id, &grp);
+	_gyro_topic = orb_advertise_multi(_orb_id, &grp, nullptr);
 
 	if (_gyro_topic < 0) {
 		debug("failed to create sensor_gyro publication");
@@ -490,16 +613,11 @@ L3GD20::read(struct file *filp, char *buffer, size_t buflen)
 	if (_call_interval > 0) {
 
 		/*
-		 * While there is space in the caller's buffer, and reports, copy them.
+		 * Copy as many reports as fit in the caller's buffer.
 		 * Note that we may be pre-empted by the measurement code while we are doing this;
-		 * we are careful to avoid racing with it.
+		 * the ring buffer retries the copy if it races with it.
 		 */
-		while (count--) {
-			if (_reports->get(gbuf)) {
-				ret += sizeof(*gbuf);
-				gbuf++;
-			}
-		}
+		ret = _reports->get_multiple(gbuf, count) * sizeof(*gbuf);
 
 		/* if there was no data, warn the caller */
 		return ret ? ret : -EAGAIN;
@@ -541,6 +659,10 @@ L3GD20::ioctl(struct file *filp, int cmd, unsigned long arg)
 				/* set default/max polling rate */
 			case SENSOR_POLLRATE_MAX:
 			case SENSOR_POLLRATE_DEFAULT:
+				/* collect a burst of samples per poll */
+				if (_use_fifo) {
+					return ioctl(filp, SENSORIOCSPOLLRATE, _current_rate / L3GD20_FIFO_BURST);
+				}
 				if (_is_l3g4200d) {
 					return ioctl(filp, SENSORIOCSPOLLRATE, L3G4200D_DEFAULT_RATE);
 				}
@@ -558,14 +680,18 @@ L3GD20::ioctl(struct file *filp, int cmd, unsigned long arg)
 					if (ticks < 1000)
 						return -EINVAL;
 
+					/* drain the FIFO before it can overflow */
+					if (_use_fifo && ticks > L3GD20_FIFO_MAX_INTERVAL)
+						ticks = L3GD20_FIFO_MAX_INTERVAL;
+
 					/* update interval for next measurement */
 					/* XXX this is a bit shady, but no other way to adjust... */
-					_call.period = _call_interval = ticks;
+					_call_interval = ticks;
+					_call.period = _drdy_active ? ticks * L3GD20_DRDY_WATCHDOG_FACTOR : ticks;
 
 					/* adjust filters */
 					float cutoff_freq_hz = _gyro_filter_x.get_cutoff_freq();
-					float sample_rate = 1.0e6f/ticks;
-					set_driver_lowpass_filter(sample_rate, cutoff_freq_hz);
+					set_driver_lowpass_filter(filter_rate(), cutoff_freq_hz);
 
 					/* if we need to start the poll state machine, do it */
 					if (want_start)
@@ -610,10 +736,16 @@ L3GD20::ioctl(struct file *filp, int cmd, unsigned long arg)
 	case GYROIOCGSAMPLERATE:
 		return _current_rate;
 
+	case SENSORIOCSINTEGRATION:
+		_gyro_int.set_autoreset_interval(arg);
+		return OK;
+
+	case SENSORIOCGINTEGRATION:
+		return _gyro_int.get_autoreset_interval();
+
 	case GYROIOCSLOWPASS: {
 		float cutoff_freq_hz = arg;
-		float sample_rate = 1.0e6f / _call_interval;
-		set_driver_lowpass_filter(sample_rate, cutoff_freq_hz);
+		set_driver_lowpass_filter(filter_rate(), cutoff_freq_hz);
 
 		return OK;
 	}
@@ -771,15 +903,85 @@ L3GD20::start()
 
 	/* reset the report ring */
 	_reports->flush();
+	_gyro_int.reset();
+
+	/* start from a fresh FIFO, the queued samples are stale */
+	if (_use_fifo)
+		fifo_reset();
+
+	/* with data ready interrupts the hrt_call is only a watchdog */
+	unsigned interval = _call_interval;
+
+	/* the FIFO has its own sample timing */
+	if (!_use_fifo && drdy_start())
+		interval *= L3GD20_DRDY_WATCHDOG_FACTOR;
 
 	/* start polling at the specified rate */
-	hrt_call_every(&_call, 1000, _call_interval, (hrt_callout)&L3GD20::measure_trampoline, this);
+	hrt_call_every(&_call, 1000, interval, (hrt_callout)&L3GD20::measure_trampoline, this);
 }
 
 void
 L3GD20::stop()
 {
 	hrt_cancel(&_call);
+	drdy_stop();
+}
+
+L3GD20 *L3GD20::_drdy_dev = nullptr;
+
+bool
+L3GD20::drdy_start()
+{
+#if L3GD20_USE_DRDY
+	if (_bus != PX4_SPI_BUS_SENSORS)
+		return false;
+
+	_drdy_seen = false;
+	_drdy_last_read = 0;
+	_drdy_dev = this;
+	_drdy_active = true;
+
+	stm32_gpiosetevent(GPIO_EXTI_GYRO_DRDY, true, false, true, &L3GD20::drdy_interrupt);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void
+L3GD20::drdy_stop()
+{
+#if L3GD20_USE_DRDY
+
+	if (_drdy_active) {
+		stm32_gpiosetevent(GPIO_EXTI_GYRO_DRDY, false, false, false, nullptr);
+		_drdy_active = false;
+		_drdy_dev = nullptr;
+	}
+
+#endif
+}
+
+int
+L3GD20::drdy_interrupt(int irq, void *context)
+{
+	/* stamp first, this is the time the sample was taken */
+	hrt_abstime now = hrt_absolute_time();
+	L3GD20 *dev = _drdy_dev;
+
+	if (dev == nullptr)
+		return OK;
+
+	dev->_drdy_seen = true;
+
+	/* decimate the sensor rate to the poll rate, within half a sample */
+	if (now - dev->_drdy_last_read + 500000 / dev->_current_rate < dev->_call_interval)
+		return OK;
+
+	dev->_drdy_last_read = now;
+	dev->measure(now);
+
+	return OK;
 }
 
 void
@@ -812,36 +1014,64 @@ L3GD20::reset()
 
 	write_reg(ADDR_CTRL_REG5, REG5_FIFO_ENABLE);		/* disable wake-on-interrupt */
 
-	/* disable FIFO. This makes things simpler and ensures we
-	 * aren't getting stale data. It means we must run the hrt
-	 * callback fast enough to not miss data. */
-	write_reg(ADDR_FIFO_CTRL_REG, FIFO_CTRL_BYPASS_MODE);
+	/* without FIFO mode bypass the FIFO. This makes things simpler
+	 * and ensures we aren't getting stale data. It means we must run
+	 * the hrt callback fast enough to not miss data. */
+	if (_use_fifo) {
+		fifo_reset();
+
+	} else {
+		write_reg(ADDR_FIFO_CTRL_REG, FIFO_CTRL_BYPASS_MODE);
+	}
 
 	set_samplerate(0); // 760Hz or 800Hz
 	set_range(L3GD20_DEFAULT_RANGE_DPS);
-	set_driver_lowpass_filter(L3GD20_DEFAULT_RATE, L3GD20_DEFAULT_FILTER_FREQ);
+	_gyro_filter_x.set_coefficients(l3gd20_default_filter);
+	_gyro_filter_y.set_coefficients(l3gd20_default_filter);
+	_gyro_filter_z.set_coefficients(l3gd20_default_filter);
 
 	_read = 0;
 }
 
+void
+L3GD20::fifo_reset()
+{
+	/* passing through bypass mode empties the FIFO */
+	write_reg(ADDR_FIFO_CTRL_REG, FIFO_CTRL_BYPASS_MODE);
+	write_reg(ADDR_FIFO_CTRL_REG, FIFO_CTRL_STREAM_MODE);
+	_fifo_last_read = 0;
+}
+
 void
 L3GD20::measure_trampoline(void *arg)
 {
 	L3GD20 *dev = (L3GD20 *)arg;
 
+	if (dev->_drdy_active) {
+		/* the interrupt is alive, nothing to do */
+		if (dev->_drdy_seen) {
+			dev->_drdy_seen = false;
+			return;
+		}
+
+		/* the line is stuck, go back to polling at the full rate */
+		perf_count(dev->_drdy_timeouts);
+		dev->drdy_stop();
+		dev->_call.period = dev->_call_interval;
+	}
+
 	/* make another measurement */
 	dev->measure();
 }
 
-#ifdef GPIO_EXTI_GYRO_DRDY
-# define L3GD20_USE_DRDY 1
-#else
-# define L3GD20_USE_DRDY 0
-#endif
-
 void
-L3GD20::measure()
+L3GD20::measure(hrt_abstime timestamp)
 {
+	if (_use_fifo) {
+		measure_fifo();
+		return;
+	}
+
 #if L3GD20_USE_DRDY
 	// if the gyro doesn't have any data ready then re-schedule
 	// for 100 microseconds later. This ensures we don't double
@@ -865,8 +1095,6 @@ L3GD20::measure()
 	} raw_report;
 #pragma pack(pop)
 
-	gyro_report report;
-
 	/* start the performance counter */
 	perf_begin(_sample_perf);
 
@@ -882,9 +1110,91 @@ L3GD20::measure()
               when we captured. That means a transfer error of some sort
              */
             perf_count(_errors);            
+            perf_end(_sample_perf);
             return;
         }
 #endif
+
+	process_sample(raw_report.x, raw_report.y, raw_report.z, raw_report.temp,
+		       (timestamp != 0) ? timestamp : hrt_absolute_time(), true);
+
+	/* stop the perf counter */
+	perf_end(_sample_perf);
+}
+
+void
+L3GD20::measure_fifo()
+{
+	/* start the performance counter */
+	perf_begin(_sample_perf);
+
+	hrt_abstime now = hrt_absolute_time();
+	uint8_t fifo_src = read_reg(ADDR_FIFO_SRC_REG);
+
+	/* an overrun drops the oldest samples, the queued ones are still whole */
+	unsigned samples = fifo_src & FIFO_SRC_FSS_MASK;
+
+	if (fifo_src & FIFO_SRC_OVRN) {
+		perf_count(_fifo_overruns);
+		samples = L3GD20_FIFO_DEPTH;
+	}
+
+	if ((fifo_src & FIFO_SRC_EMPTY) || samples == 0) {
+		perf_end(_sample_perf);
+		return;
+	}
+
+	/* the temperature is not queued, one reading serves the whole burst */
+	int8_t temp = read_reg(ADDR_OUT_TEMP);
+
+	/* with the FIFO enabled the address increment wraps from OUT_Z_H back to OUT_X_L */
+	_fifo_buffer[0] = ADDR_OUT_X_L | DIR_READ | ADDR_INCREMENT;
+
+	if (OK != transfer(_fifo_buffer, _fifo_buffer, 1 + samples * L3GD20_FIFO_SAMPLE_SIZE)) {
+		perf_count(_errors);
+		perf_end(_sample_perf);
+		return;
+	}
+
+	/*
+	 * The newest sample was taken about now, spread the others over
+	 * the time since the previous burst. Fall back to the nominal
+	 * sample interval after a reset or when the spacing is implausible.
+	 */
+	float interval = 1.0e6f / _current_rate;
+
+	if (_fifo_last_read != 0) {
+		float measured = (float)(now - _fifo_last_read) / samples;
+
+		if (measured > 0.5f * interval && measured < 2.0f * interval)
+			interval = measured;
+	}
+
+	_fifo_last_read = now;
+
+	for (unsigned i = 0; i < samples; i++) {
+		uint8_t *sample = &_fifo_buffer[1 + i * L3GD20_FIFO_SAMPLE_SIZE];
+
+		/* little endian, low byte first */
+		int16_t x = (int16_t)(sample[0] | (sample[1] << 8));
+		int16_t y = (int16_t)(sample[2] | (sample[3] << 8));
+		int16_t z = (int16_t)(sample[4] | (sample[5] << 8));
+
+		hrt_abstime timestamp = now - (hrt_abstime)((samples - 1 - i) * interval);
+
+		/* without an integration interval the newest sample is published */
+		process_sample(x, y, z, temp, timestamp, i == samples - 1);
+	}
+
+	/* stop the perf counter */
+	perf_end(_sample_perf);
+}
+
+void
+L3GD20::process_sample(int16_t x, int16_t y, int16_t z, int8_t temp, hrt_abstime timestamp, bool close)
+{
+	gyro_report report;
+
 	/*
 	 * 1) Scale raw value to SI units using scaling from datasheet.
 	 * 2) Subtract static offset (in SI units)
@@ -899,49 +1209,71 @@ L3GD20::measure()
 	 *	 	  the offset is 74 from the origin and subtracting
 	 *		  74 from all measurements centers them around zero.
 	 */
-	report.timestamp = hrt_absolute_time();
+	report.timestamp = timestamp;
         report.error_count = 0; // not recorded
 	
 	switch (_orientation) {
 
 		case SENSOR_BOARD_ROTATION_000_DEG:
 			/* keep axes in place */
-			report.x_raw = raw_report.x;
-			report.y_raw = raw_report.y;
+			report.x_raw = x;
+			report.y_raw = y;
 			break;
 
 		case SENSOR_BOARD_ROTATION_090_DEG:
 			/* swap x and y */
-			report.x_raw = raw_report.y;
-			report.y_raw = raw_report.x;
+			report.x_raw = y;
+			report.y_raw = x;
 			break;
 
 		case SENSOR_BOARD_ROTATION_180_DEG:
 			/* swap x and y and negate both */
-			report.x_raw = ((raw_report.x == -32768) ? 32767 : -raw_report.x);
-			report.y_raw = ((raw_report.y == -32768) ? 32767 : -raw_report.y);
+			report.x_raw = ((x == -32768) ? 32767 : -x);
+			report.y_raw = ((y == -32768) ? 32767 : -y);
 			break;
 
 		case SENSOR_BOARD_ROTATION_270_DEG:
 			/* swap x and y and negate y */
-			report.x_raw = raw_report.y;
-			report.y_raw = ((raw_report.x == -32768) ? 32767 : -raw_report.x);
+			report.x_raw = y;
+			report.y_raw = ((x == -32768) ? 32767 : -x);
 			break;
 	}
 
-	report.z_raw = raw_report.z;
+	report.z_raw = z;
 
-	report.temperature_raw = raw_report.temp;
+	report.temperature_raw = temp;
 
 	report.x = ((report.x_raw * _gyro_range_scale) - _gyro_scale.x_offset) * _gyro_scale.x_scale;
 	report.y = ((report.y_raw * _gyro_range_scale) - _gyro_scale.y_offset) * _gyro_scale.y_scale;
 	report.z = ((report.z_raw * _gyro_range_scale) - _gyro_scale.z_offset) * _gyro_scale.z_scale;
 
+	/* integrate the unfiltered rates, the filters only add delay */
+	math::Vector<3> gval(report.x, report.y, report.z);
+	math::Vector<3> gval_integrated;
+	rotate_3f(_rotation, gval(0), gval(1), gval(2));
+
+	bool gyro_notify = _gyro_int.put(report.timestamp, gval, gval_integrated, report.integral_dt);
+
+	/* without an integration interval every sample is published */
+	if (!gyro_notify && close && _gyro_int.get_autoreset_interval() == 0) {
+		gval_integrated = _gyro_int.get(true, report.integral_dt);
+		gyro_notify = (report.integral_dt != 0);
+	}
+
+	if (!gyro_notify) {
+		report.integral_dt = 0;
+		gval_integrated.zero();
+	}
+
+	report.x_integral = gval_integrated(0);
+	report.y_integral = gval_integrated(1);
+	report.z_integral = gval_integrated(2);
+
 	report.x = _gyro_filter_x.apply(report.x);
 	report.y = _gyro_filter_y.apply(report.y);
 	report.z = _gyro_filter_z.apply(report.z);
 
-	report.temperature = L3GD20_TEMP_OFFSET_CELSIUS - raw_report.temp;
+	report.temperature = L3GD20_TEMP_OFFSET_CELSIUS - temp;
 
 	// apply user specified rotation
 	rotate_3f(_rotation, report.x, report.y, report.z);
@@ -951,19 +1283,18 @@ L3GD20::measure()
 
 	_reports->force(&report);
 
-	/* notify anyone waiting for data */
-	poll_notify(POLLIN);
+	if (gyro_notify) {
+		/* notify anyone waiting for data */
+		poll_notify(POLLIN);
 
-	/* publish for subscribers */
-	if (!(_pub_blocked)) {
-		/* publish it */
-		orb_publish(_orb_id, _gyro_topic, &report);
+		/* publish for subscribers */
+		if (!(_pub_blocked)) {
+			/* publish it */
+			orb_publish(_orb_id, _gyro_topic, &report);
+		}
 	}
 
 	_read++;
-
-	/* stop the perf counter */
-	perf_end(_sample_perf);
 }
 
 void
@@ -973,6 +1304,12 @@ L3GD20::print_info()
 	perf_print_counter(_sample_perf);
 	perf_print_counter(_reschedules);
 	perf_print_counter(_errors);
+	perf_print_counter(_drdy_timeouts);
+	perf_print_counter(_fifo_overruns);
+	if (_use_fifo)
+		printf("FIFO mode\n");
+	if (_drdy_active)
+		printf("data ready interrupt\n");
 	_reports->print_info("report queue");
 }
 
@@ -1007,7 +1344,7 @@ namespace l3gd20
 L3GD20	*g_dev;
 
 void	usage();
-void	start(bool external_bus, enum Rotation rotation);
+void	start(bool external_bus, enum Rotation rotation, bool fifo);
 void	test();
 void	reset();
 void	info();
@@ -1019,7 +1356,7 @@ void	info();
  * started or failed to detect the sensor.
  */
 void
-start(bool external_bus, enum Rotation rotation)
+start(bool external_bus, enum Rotation rotation, bool fifo)
 {
 	int fd;
 
@@ -1040,6 +1377,9 @@ start(bool external_bus, enum Rotation rotation)
 	if (g_dev == nullptr)
 		goto fail;
 
+	if (fifo && OK != g_dev->enable_fifo())
+		goto fail;
+
 	if (OK != g_dev->init())
 		goto fail;
 
@@ -1156,6 +1496,7 @@ usage()
 	warnx("options:");
 	warnx("    -X    (external bus)");
 	warnx("    -R rotation");
+	warnx("    -F    (drain the sensor FIFO in bursts)");
 }
 
 } // namespace
@@ -1166,9 +1507,10 @@ l3gd20_main(int argc, char *argv[])
 	bool external_bus = false;
 	int ch;
 	enum Rotation rotation = ROTATION_NONE;
+	bool fifo = false;
 
 	/* jump over start/off/etc and look at options first */
-	while ((ch = getopt(argc, argv, "XR:")) != EOF) {
+	while ((ch = getopt(argc, argv, "XR:F")) != EOF) {
 		switch (ch) {
 		case 'X':
 			external_bus = true;
@@ -1176,6 +1518,9 @@ l3gd20_main(int argc, char *argv[])
 		case 'R':
 			rotation = (enum Rotation)atoi(optarg);
 			break;
+		case 'F':
+			fifo = true;
+			break;
 		default:
 			l3gd20::usage();
 			exit(0);
@@ -1189,7 +1534,7 @@ l3gd20_main(int argc, char *argv[])
 
 	 */
 	if (!strcmp(verb, "start"))
-		l3gd20::start(external_bus, rotation);
+		l3gd20::start(external_bus, rotation, fifo);
 
 	/*
 	 * Test the driver/device.
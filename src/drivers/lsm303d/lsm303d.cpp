@@ -65,6 +65,7 @@
 #include <drivers/drv_accel.h>
 #include <drivers/drv_mag.h>
 #include <drivers/device/ringbuffer.h>
+#include <drivers/device/integrator.h>
 #include <drivers/drv_tone_alarm.h>
 
 #include <board_config.h>
@@ -147,6 +148,8 @@ static const int ERROR = -1;
 #define ADDR_ACT_THS			0x3e
 #define ADDR_ACT_DUR			0x3f
 
+#define REG0_FIFO_ENABLE_A		(1<<6)
+
 #define REG1_RATE_BITS_A		((1<<7) | (1<<6) | (1<<5) | (1<<4))
 #define REG1_POWERDOWN_A		((0<<7) | (0<<6) | (0<<5) | (0<<4))
 #define REG1_RATE_3_125HZ_A		((0<<7) | (0<<6) | (0<<5) | (1<<4))
@@ -200,6 +203,15 @@ static const int ERROR = -1;
 
 #define REG7_CONT_MODE_M		((0<<1) | (0<<0))
 
+#define FIFO_CTRL_BYPASS_MODE		(0<<5)
+#define FIFO_CTRL_FIFO_MODE		(1<<5)
+#define FIFO_CTRL_STREAM_MODE		(2<<5)
+
+#define FIFO_SRC_FTH			(1<<7)
+#define FIFO_SRC_OVRN			(1<<6)
+#define FIFO_SRC_EMPTY			(1<<5)
+#define FIFO_SRC_FSS_MASK		0x1F
+
 
 #define INT_CTRL_M              0x12
 #define INT_SRC_M               0x13
@@ -210,11 +222,36 @@ static const int ERROR = -1;
 #define LSM303D_ACCEL_DEFAULT_ONCHIP_FILTER_FREQ	50
 #define LSM303D_ACCEL_DEFAULT_DRIVER_FILTER_FREQ	30
 
+/* driver filter at the default rate, computed at build time */
+static constexpr math::LowPassFilter2pCoefficients lsm303d_accel_default_filter =
+	math::lowpass_2p_coefficients(LSM303D_ACCEL_DEFAULT_RATE, LSM303D_ACCEL_DEFAULT_DRIVER_FILTER_FREQ);
+
 #define LSM303D_MAG_DEFAULT_RANGE_GA			2
 #define LSM303D_MAG_DEFAULT_RATE			100
 
 #define LSM303D_ONE_G					9.80665f
 
+#ifdef GPIO_EXTI_ACCEL_DRDY
+# define LSM303D_USE_DRDY 1
+#else
+# define LSM303D_USE_DRDY 0
+#endif
+
+/* with DRDY interrupts the accel hrt_call only watches for a stuck line */
+#define LSM303D_DRDY_WATCHDOG_FACTOR			4
+
+/*
+  accel FIFO mode: in stream mode the sensor queues up to 32 accel
+  samples, 6 bytes each, which are drained in one burst per poll. The
+  default poll collects LSM303D_FIFO_BURST samples per burst, at most
+  LSM303D_FIFO_MAX_INTERVAL may pass between bursts so the FIFO never
+  fills beyond half at the highest rate. The mag is not queued.
+ */
+#define LSM303D_FIFO_DEPTH				32
+#define LSM303D_FIFO_SAMPLE_SIZE			6
+#define LSM303D_FIFO_BURST				8
+#define LSM303D_FIFO_MAX_INTERVAL			10000
+
 extern "C" { __EXPORT int lsm303d_main(int argc, char *argv[]); }
 
 
@@ -251,6 +288,12 @@ public:
 	 */
 	void			check_extremes(const accel_report *arb);
 
+	/**
+	 * Drain the accel FIFO in bursts instead of reading every
+	 * sample on its own. Must be called before init().
+	 */
+	int			enable_fifo();
+
 protected:
 	virtual int		probe();
 
@@ -297,6 +340,21 @@ private:
 	perf_counter_t		_extreme_values;
 	perf_counter_t		_accel_reschedules;
 
+	/* accel data ready interrupt state */
+	bool			_drdy_active;
+	volatile bool		_drdy_seen;
+	hrt_abstime		_drdy_last_read;
+	perf_counter_t		_drdy_timeouts;
+
+	/* accel FIFO mode state */
+	bool			_use_fifo;
+	uint8_t			*_fifo_buffer;
+	hrt_abstime		_fifo_last_read;
+	perf_counter_t		_fifo_overruns;
+
+	/* the instance on the sensor bus owns the DRDY line */
+	static LSM303D		*_drdy_dev;
+
 	math::LowPassFilter2p	_accel_filter_x;
 	math::LowPassFilter2p	_accel_filter_y;
 	math::LowPassFilter2p	_accel_filter_z;
@@ -316,6 +374,8 @@ private:
 	uint64_t		_last_log_alarm_us;
 	enum Rotation		_rotation;
 
+	Integrator		_accel_int;
+
 	/**
 	 * Start automatic measurement.
 	 */
@@ -356,10 +416,53 @@ private:
 	 */
 	static void		mag_measure_trampoline(void *arg);
 
+	/**
+	 * Accel data ready interrupt handler, triggers a read stamped with
+	 * the time of the interrupt.
+	 */
+	static int		drdy_interrupt(int irq, void *context);
+
+	/**
+	 * Attach the accel data ready interrupt if the board has one.
+	 *
+	 * @return		true if accel reads are driven by the interrupt.
+	 */
+	bool			drdy_start();
+	void			drdy_stop();
+
 	/**
 	 * Fetch accel measurements from the sensor and update the report ring.
+	 *
+	 * @param timestamp	Time of the sample, 0 to stamp it when read.
+	 */
+	void			measure(hrt_abstime timestamp = 0);
+
+	/**
+	 * Drain the accel FIFO in one burst and queue every sample.
+	 */
+	void			measure_fifo();
+
+	/**
+	 * Discard the accel FIFO content and restart queueing.
+	 */
+	void			fifo_reset();
+
+	/**
+	 * Scale, filter and integrate one accel sample and queue the report.
+	 *
+	 * @param x, y, z	Raw sensor axes.
+	 * @param timestamp	Time of the sample.
+	 * @param close		Close the integral if no integration interval
+	 *			is set, false for all but the newest sample of
+	 *			a FIFO burst.
 	 */
-	void			measure();
+	void			process_accel(int16_t x, int16_t y, int16_t z, hrt_abstime timestamp, bool close);
+
+	/**
+	 * Rate the accel filters run at: the poll rate, or the sensor
+	 * rate in FIFO mode where every sample is filtered.
+	 */
+	float			accel_filter_rate(unsigned poll_rate) { return _use_fifo ? _accel_samplerate : poll_rate; }
 
 	/**
 	 * Fetch mag measurements from the sensor and update the report ring.
@@ -522,7 +625,7 @@ LSM303D::LSM303D(int bus, const char* path, spi_dev_e device, enum Rotation rota
 	_mag_range_scale(0.0f),
 	_mag_samplerate(0),
 	_accel_topic(-1),
-	_accel_orb_id(nullptr),
+	_accel_orb_id(ORB_ID(sensor_accel)),
 	_accel_class_instance(-1),
 	_accel_read(0),
 	_mag_read(0),
@@ -532,9 +635,17 @@ LSM303D::LSM303D(int bus, const char* path, spi_dev_e device, enum Rotation rota
 	_reg7_resets(perf_alloc(PC_COUNT, "lsm303d_reg7_resets")),
 	_extreme_values(perf_alloc(PC_COUNT, "lsm303d_extremes")),
 	_accel_reschedules(perf_alloc(PC_COUNT, "lsm303d_accel_resched")),
-	_accel_filter_x(LSM303D_ACCEL_DEFAULT_RATE, LSM303D_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_accel_filter_y(LSM303D_ACCEL_DEFAULT_RATE, LSM303D_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_accel_filter_z(LSM303D_ACCEL_DEFAULT_RATE, LSM303D_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
+	_drdy_active(false),
+	_drdy_seen(false),
+	_drdy_last_read(0),
+	_drdy_timeouts(perf_alloc(PC_COUNT, "lsm303d_drdy_timeouts")),
+	_use_fifo(false),
+	_fifo_buffer(nullptr),
+	_fifo_last_read(0),
+	_fifo_overruns(perf_alloc(PC_COUNT, "lsm303d_fifo_overruns")),
+	_accel_filter_x(lsm303d_accel_default_filter),
+	_accel_filter_y(lsm303d_accel_default_filter),
+	_accel_filter_z(lsm303d_accel_default_filter),
 	_reg1_expected(0),
 	_reg7_expected(0),
 	_accel_log_fd(-1),
@@ -544,7 +655,8 @@ LSM303D::LSM303D(int bus, const char* path, spi_dev_e device, enum Rotation rota
 	_last_log_sync_us(0),
 	_last_log_reg_us(0),
 	_last_log_alarm_us(0),
-	_rotation(rotation)
+	_rotation(rotation),
+	_accel_int(0, false)
 {
 	_device_id.devid_s.devtype = DRV_MAG_DEVTYPE_LSM303D;
 
@@ -590,6 +702,17 @@ LSM303D::~LSM303D()
 	perf_free(_reg7_resets);
 	perf_free(_extreme_values);
 	perf_free(_accel_reschedules);
+	perf_free(_drdy_timeouts);
+	perf_free(_fifo_overruns);
+
+	delete[] _fifo_buffer;
+}
+
+int
+LSM303D::enable_fifo()
+{
+	_use_fifo = true;
+	return OK;
 }
 
 int
@@ -603,11 +726,25 @@ LSM303D::init()
 		goto out;
 	}
 
-	/* allocate basic report buffers */
-	_accel_reports = new RingBuffer(2, sizeof(accel_report));
+	{
+		/* in FIFO mode the buffer holds all samples of a burst */
+		unsigned depth = 2;
 
-	if (_accel_reports == nullptr)
-		goto out;
+		if (_use_fifo) {
+			_fifo_buffer = new uint8_t[1 + LSM303D_FIFO_DEPTH * LSM303D_FIFO_SAMPLE_SIZE];
+
+			if (_fifo_buffer == nullptr)
+				goto out;
+
+			depth = LSM303D_FIFO_DEPTH;
+		}
+
+		/* allocate basic report buffers */
+		_accel_reports = new RingBuffer(depth, sizeof(accel_report));
+
+		if (_accel_reports == nullptr)
+			goto out;
+	}
 
 	/* advertise accel topic */
 	_mag_reports = new RingBuffer(2, sizeof(mag_report));
@@ -624,6 +761,10 @@ LSM303D::init()
 		goto out;
 	}
 
+	/* let the FIFO queue a couple of samples for the first report */
+	if (_use_fifo)
+		usleep(2 * 1000000 / _accel_samplerate);
+
 	/* fill report structures */
 	measure();
 
@@ -658,22 +799,7 @@ LSM303D::init()
 	struct accel_report arp;
 	_accel_reports->get(&arp);
 
-	/* measurement will have generated a report, publish */
-	switch (_accel_class_instance) {
-		case CLASS_DEVICE_PRIMARY:
-			_accel_orb_id = ORB_ID(sensor_accel0);
-			break;
-
-		case CLASS_DEVICE_SECONDARY:
-			_accel_orb_id = ORB_ID(sensor_accel1);
-			break;
-
-		case CLASS_DEVICE_TERTIARY:
-			_accel_orb_id = ORB_ID(sensor_accel2);
-			break;
-	}
-
-	_accel_topic = orb_advertise(_accel_orb_id, &arp);
+	_accel_topic = orb_advertise_multi(_accel_orb_id, &arp, nullptr);
 
 	if (_accel_topic < 0) {
 		warnx("ADVERT ERR");
@@ -713,9 +839,20 @@ LSM303D::reset()
 	write_reg(ADDR_CTRL_REG3, 0x04); // DRDY on ACCEL on INT1
 	write_reg(ADDR_CTRL_REG4, 0x04); // DRDY on MAG on INT2
 
+	/* queue accel samples in stream mode, or bypass the FIFO */
+	if (_use_fifo) {
+		write_reg(ADDR_CTRL_REG0, REG0_FIFO_ENABLE_A);
+		fifo_reset();
+
+	} else {
+		write_reg(ADDR_FIFO_CTRL, FIFO_CTRL_BYPASS_MODE);
+	}
+
 	accel_set_range(LSM303D_ACCEL_DEFAULT_RANGE_G);
 	accel_set_samplerate(LSM303D_ACCEL_DEFAULT_RATE);
-	accel_set_driver_lowpass_filter((float)LSM303D_ACCEL_DEFAULT_RATE, (float)LSM303D_ACCEL_DEFAULT_DRIVER_FILTER_FREQ);
+	_accel_filter_x.set_coefficients(lsm303d_accel_default_filter);
+	_accel_filter_y.set_coefficients(lsm303d_accel_default_filter);
+	_accel_filter_z.set_coefficients(lsm303d_accel_default_filter);
 
 	// we setup the anti-alias on-chip filter as 50Hz. We believe
 	// this operates in the analog domain, and is critical for
@@ -730,6 +867,15 @@ LSM303D::reset()
 	_mag_read = 0;
 }
 
+void
+LSM303D::fifo_reset()
+{
+	/* passing through bypass mode empties the FIFO */
+	write_reg(ADDR_FIFO_CTRL, FIFO_CTRL_BYPASS_MODE);
+	write_reg(ADDR_FIFO_CTRL, FIFO_CTRL_STREAM_MODE);
+	_fifo_last_read = 0;
+}
+
 int
 LSM303D::probe()
 {
@@ -875,17 +1021,15 @@ LSM303D::read(struct file *filp, char *buffer, size_t buflen)
 	/* if automatic measurement is enabled */
 	if (_call_accel_interval > 0) {
 		/*
-		 * While there is space in the caller's buffer, and reports, copy them.
+		 * Copy as many reports as fit in the caller's buffer.
 		 */
-		while (count--) {
-			if (_accel_reports->get(arb)) {
+		unsigned n = _accel_reports->get_multiple(arb, count);
 #if CHECK_EXTREMES
-				check_extremes(arb);
-#endif
-				ret += sizeof(*arb);
-				arb++;
-			}
+		for (unsigned i = 0; i < n; i++) {
+			check_extremes(&arb[i]);
 		}
+#endif
+		ret = n * sizeof(*arb);
 
 		/* if there was no data, warn the caller */
 		return ret ? ret : -EAGAIN;
@@ -916,14 +1060,9 @@ LSM303D::mag_read(struct file *filp, char *buffer, size_t buflen)
 	if (_call_mag_interval > 0) {
 
 		/*
-		 * While there is space in the caller's buffer, and reports, copy them.
+		 * Copy as many reports as fit in the caller's buffer.
 		 */
-		while (count--) {
-			if (_mag_reports->get(mrb)) {
-				ret += sizeof(*mrb);
-				mrb++;
-			}
-		}
+		ret = _mag_reports->get_multiple(mrb, count) * sizeof(*mrb);
 
 		/* if there was no data, warn the caller */
 		return ret ? ret : -EAGAIN;
@@ -966,6 +1105,10 @@ LSM303D::ioctl(struct file *filp, int cmd, unsigned long arg)
 				return ioctl(filp, SENSORIOCSPOLLRATE, 1600);
 
 			case SENSOR_POLLRATE_DEFAULT:
+				/* collect a burst of samples per poll */
+				if (_use_fifo)
+					return ioctl(filp, SENSORIOCSPOLLRATE, _accel_samplerate / LSM303D_FIFO_BURST);
+
 				return ioctl(filp, SENSORIOCSPOLLRATE, LSM303D_ACCEL_DEFAULT_RATE);
 
 				/* adjust to a legal polling interval in Hz */
@@ -980,12 +1123,17 @@ LSM303D::ioctl(struct file *filp, int cmd, unsigned long arg)
 				if (ticks < 500)
 					return -EINVAL;
 
+				/* drain the FIFO before it can overflow */
+				if (_use_fifo && ticks > LSM303D_FIFO_MAX_INTERVAL)
+					ticks = LSM303D_FIFO_MAX_INTERVAL;
+
 				/* adjust filters */
-				accel_set_driver_lowpass_filter((float)arg, _accel_filter_x.get_cutoff_freq());
+				accel_set_driver_lowpass_filter(accel_filter_rate(arg), _accel_filter_x.get_cutoff_freq());
 
 				/* update interval for next measurement */
 				/* XXX this is a bit shady, but no other way to adjust... */
-				_accel_call.period = _call_accel_interval = ticks;
+				_call_accel_interval = ticks;
+				_accel_call.period = _drdy_active ? ticks * LSM303D_DRDY_WATCHDOG_FACTOR : ticks;
 
 				/* if we need to start the poll state machine, do it */
 				if (want_start)
@@ -1030,6 +1178,13 @@ LSM303D::ioctl(struct file *filp, int cmd, unsigned long arg)
 	case ACCELIOCGSAMPLERATE:
 		return _accel_samplerate;
 
+	case SENSORIOCSINTEGRATION:
+		_accel_int.set_autoreset_interval(arg);
+		return OK;
+
+	case SENSORIOCGINTEGRATION:
+		return _accel_int.get_autoreset_interval();
+
 	case ACCELIOCSLOWPASS: {
 		return accel_set_driver_lowpass_filter((float)_accel_samplerate, (float)arg);
 	}
@@ -1483,9 +1638,21 @@ LSM303D::start()
 	/* reset the report ring */
 	_accel_reports->flush();
 	_mag_reports->flush();
+	_accel_int.reset();
+
+	/* start from a fresh FIFO, the queued samples are stale */
+	if (_use_fifo)
+		fifo_reset();
+
+	/* with data ready interrupts the accel hrt_call is only a watchdog */
+	unsigned accel_interval = _call_accel_interval;
+
+	/* the FIFO has its own sample timing */
+	if (!_use_fifo && drdy_start())
+		accel_interval *= LSM303D_DRDY_WATCHDOG_FACTOR;
 
 	/* start polling at the specified rate */
-	hrt_call_every(&_accel_call, 1000, _call_accel_interval, (hrt_callout)&LSM303D::measure_trampoline, this);
+	hrt_call_every(&_accel_call, 1000, accel_interval, (hrt_callout)&LSM303D::measure_trampoline, this);
 	hrt_call_every(&_mag_call, 1000, _call_mag_interval, (hrt_callout)&LSM303D::mag_measure_trampoline, this);
 }
 
@@ -1494,6 +1661,64 @@ LSM303D::stop()
 {
 	hrt_cancel(&_accel_call);
 	hrt_cancel(&_mag_call);
+	drdy_stop();
+}
+
+LSM303D *LSM303D::_drdy_dev = nullptr;
+
+bool
+LSM303D::drdy_start()
+{
+#if LSM303D_USE_DRDY
+	if (_bus != PX4_SPI_BUS_SENSORS)
+		return false;
+
+	_drdy_seen = false;
+	_drdy_last_read = 0;
+	_drdy_dev = this;
+	_drdy_active = true;
+
+	stm32_gpiosetevent(GPIO_EXTI_ACCEL_DRDY, true, false, true, &LSM303D::drdy_interrupt);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void
+LSM303D::drdy_stop()
+{
+#if LSM303D_USE_DRDY
+
+	if (_drdy_active) {
+		stm32_gpiosetevent(GPIO_EXTI_ACCEL_DRDY, false, false, false, nullptr);
+		_drdy_active = false;
+		_drdy_dev = nullptr;
+	}
+
+#endif
+}
+
+int
+LSM303D::drdy_interrupt(int irq, void *context)
+{
+	/* stamp first, this is the time the sample was taken */
+	hrt_abstime now = hrt_absolute_time();
+	LSM303D *dev = _drdy_dev;
+
+	if (dev == nullptr)
+		return OK;
+
+	dev->_drdy_seen = true;
+
+	/* decimate the sensor rate to the poll rate, within half a sample */
+	if (now - dev->_drdy_last_read + 500000 / dev->_accel_samplerate < dev->_call_accel_interval)
+		return OK;
+
+	dev->_drdy_last_read = now;
+	dev->measure(now);
+
+	return OK;
 }
 
 void
@@ -1501,6 +1726,19 @@ LSM303D::measure_trampoline(void *arg)
 {
 	LSM303D *dev = (LSM303D *)arg;
 
+	if (dev->_drdy_active) {
+		/* the interrupt is alive, nothing to do */
+		if (dev->_drdy_seen) {
+			dev->_drdy_seen = false;
+			return;
+		}
+
+		/* the line is stuck, go back to polling at the full rate */
+		perf_count(dev->_drdy_timeouts);
+		dev->drdy_stop();
+		dev->_accel_call.period = dev->_call_accel_interval;
+	}
+
 	/* make another measurement */
 	dev->measure();
 }
@@ -1515,8 +1753,13 @@ LSM303D::mag_measure_trampoline(void *arg)
 }
 
 void
-LSM303D::measure()
+LSM303D::measure(hrt_abstime timestamp)
 {
+	if (_use_fifo) {
+		measure_fifo();
+		return;
+	}
+
 	// if the accel doesn't have any data ready then re-schedule
 	// for 100 microseconds later. This ensures we don't double
 	// read a value and then miss the next value.
@@ -1545,8 +1788,6 @@ LSM303D::measure()
 	} raw_accel_report;
 #pragma pack(pop)
 
-	accel_report accel_report;
-
 	/* start the performance counter */
 	perf_begin(_accel_sample_perf);
 
@@ -1555,6 +1796,88 @@ LSM303D::measure()
 	raw_accel_report.cmd = ADDR_STATUS_A | DIR_READ | ADDR_INCREMENT;
 	transfer((uint8_t *)&raw_accel_report, (uint8_t *)&raw_accel_report, sizeof(raw_accel_report));
 
+	process_accel(raw_accel_report.x, raw_accel_report.y, raw_accel_report.z,
+		      (timestamp != 0) ? timestamp : hrt_absolute_time(), true);
+
+	/* stop the perf counter */
+	perf_end(_accel_sample_perf);
+}
+
+void
+LSM303D::measure_fifo()
+{
+	if (read_reg(ADDR_CTRL_REG1) != _reg1_expected) {
+		perf_count(_reg1_resets);
+		reset();
+		return;
+	}
+
+	/* start the performance counter */
+	perf_begin(_accel_sample_perf);
+
+	hrt_abstime now = hrt_absolute_time();
+	uint8_t fifo_src = read_reg(ADDR_FIFO_SRC);
+
+	/* an overrun drops the oldest samples, the queued ones are still whole */
+	unsigned samples = fifo_src & FIFO_SRC_FSS_MASK;
+
+	if (fifo_src & FIFO_SRC_OVRN) {
+		perf_count(_fifo_overruns);
+		samples = LSM303D_FIFO_DEPTH;
+	}
+
+	if ((fifo_src & FIFO_SRC_EMPTY) || samples == 0) {
+		perf_end(_accel_sample_perf);
+		return;
+	}
+
+	/* with the FIFO enabled the address increment wraps from OUT_Z_H_A back to OUT_X_L_A */
+	_fifo_buffer[0] = ADDR_OUT_X_L_A | DIR_READ | ADDR_INCREMENT;
+
+	if (OK != transfer(_fifo_buffer, _fifo_buffer, 1 + samples * LSM303D_FIFO_SAMPLE_SIZE)) {
+		perf_end(_accel_sample_perf);
+		return;
+	}
+
+	/*
+	 * The newest sample was taken about now, spread the others over
+	 * the time since the previous burst. Fall back to the nominal
+	 * sample interval after a reset or when the spacing is implausible.
+	 */
+	float interval = 1.0e6f / _accel_samplerate;
+
+	if (_fifo_last_read != 0) {
+		float measured = (float)(now - _fifo_last_read) / samples;
+
+		if (measured > 0.5f * interval && measured < 2.0f * interval)
+			interval = measured;
+	}
+
+	_fifo_last_read = now;
+
+	for (unsigned i = 0; i < samples; i++) {
+		uint8_t *sample = &_fifo_buffer[1 + i * LSM303D_FIFO_SAMPLE_SIZE];
+
+		/* little endian, low byte first */
+		int16_t x = (int16_t)(sample[0] | (sample[1] << 8));
+		int16_t y = (int16_t)(sample[2] | (sample[3] << 8));
+		int16_t z = (int16_t)(sample[4] | (sample[5] << 8));
+
+		hrt_abstime timestamp = now - (hrt_abstime)((samples - 1 - i) * interval);
+
+		/* without an integration interval the newest sample is published */
+		process_accel(x, y, z, timestamp, i == samples - 1);
+	}
+
+	/* stop the perf counter */
+	perf_end(_accel_sample_perf);
+}
+
+void
+LSM303D::process_accel(int16_t x, int16_t y, int16_t z, hrt_abstime timestamp, bool close)
+{
+	accel_report accel_report;
+
 	/*
 	 * 1) Scale raw value to SI units using scaling from datasheet.
 	 * 2) Subtract static offset (in SI units)
@@ -1571,17 +1894,39 @@ LSM303D::measure()
 	 */
 
 
-	accel_report.timestamp = hrt_absolute_time();
+	accel_report.timestamp = timestamp;
         accel_report.error_count = 0; // not reported
 
-	accel_report.x_raw = raw_accel_report.x;
-	accel_report.y_raw = raw_accel_report.y;
-	accel_report.z_raw = raw_accel_report.z;
+	accel_report.x_raw = x;
+	accel_report.y_raw = y;
+	accel_report.z_raw = z;
 
 	float x_in_new = ((accel_report.x_raw * _accel_range_scale) - _accel_scale.x_offset) * _accel_scale.x_scale;
 	float y_in_new = ((accel_report.y_raw * _accel_range_scale) - _accel_scale.y_offset) * _accel_scale.y_scale;
 	float z_in_new = ((accel_report.z_raw * _accel_range_scale) - _accel_scale.z_offset) * _accel_scale.z_scale;
 
+	/* integrate the unfiltered values, the filters only add delay */
+	math::Vector<3> aval(x_in_new, y_in_new, z_in_new);
+	math::Vector<3> aval_integrated;
+	rotate_3f(_rotation, aval(0), aval(1), aval(2));
+
+	bool accel_notify = _accel_int.put(accel_report.timestamp, aval, aval_integrated, accel_report.integral_dt);
+
+	/* without an integration interval every sample is published */
+	if (!accel_notify && close && _accel_int.get_autoreset_interval() == 0) {
+		aval_integrated = _accel_int.get(true, accel_report.integral_dt);
+		accel_notify = (accel_report.integral_dt != 0);
+	}
+
+	if (!accel_notify) {
+		accel_report.integral_dt = 0;
+		aval_integrated.zero();
+	}
+
+	accel_report.x_integral = aval_integrated(0);
+	accel_report.y_integral = aval_integrated(1);
+	accel_report.z_integral = aval_integrated(2);
+
 	accel_report.x = _accel_filter_x.apply(x_in_new);
 	accel_report.y = _accel_filter_y.apply(y_in_new);
 	accel_report.z = _accel_filter_z.apply(z_in_new);
@@ -1594,18 +1939,17 @@ LSM303D::measure()
 
 	_accel_reports->force(&accel_report);
 
-	/* notify anyone waiting for data */
-	poll_notify(POLLIN);
+	if (accel_notify) {
+		/* notify anyone waiting for data */
+		poll_notify(POLLIN);
 
-	if (!(_pub_blocked)) {
-		/* publish it */
-		orb_publish(_accel_orb_id, _accel_topic, &accel_report);
+		if (!(_pub_blocked)) {
+			/* publish it */
+			orb_publish(_accel_orb_id, _accel_topic, &accel_report);
+		}
 	}
 
 	_accel_read++;
-
-	/* stop the perf counter */
-	perf_end(_accel_sample_perf);
 }
 
 void
@@ -1691,6 +2035,12 @@ LSM303D::print_info()
 	printf("accel reads:          %u\n", _accel_read);
 	printf("mag reads:            %u\n", _mag_read);
 	perf_print_counter(_accel_sample_perf);
+	perf_print_counter(_drdy_timeouts);
+	perf_print_counter(_fifo_overruns);
+	if (_use_fifo)
+		printf("accel FIFO mode\n");
+	if (_drdy_active)
+		printf("accel data ready interrupt\n");
 	_accel_reports->print_info("accel reports");
 	_mag_reports->print_info("mag reports");
 }
@@ -1834,7 +2184,7 @@ namespace lsm303d
 
 LSM303D	*g_dev;
 
-void	start(bool external_bus, enum Rotation rotation);
+void	start(bool external_bus, enum Rotation rotation, bool fifo);
 void	test();
 void	reset();
 void	info();
@@ -1849,7 +2199,7 @@ void	usage();
  * up and running or failed to detect the sensor.
  */
 void
-start(bool external_bus, enum Rotation rotation)
+start(bool external_bus, enum Rotation rotation, bool fifo)
 {
 	int fd, fd_mag;
 	if (g_dev != nullptr)
@@ -1871,6 +2221,9 @@ start(bool external_bus, enum Rotation rotation)
 		goto fail;
 	}
 
+	if (fifo && OK != g_dev->enable_fifo())
+		goto fail;
+
 	if (OK != g_dev->init())
 		goto fail;
 
@@ -2067,6 +2420,7 @@ usage()
 	warnx("options:");
 	warnx("    -X    (external bus)");
 	warnx("    -R rotation");
+	warnx("    -F    (drain the accel FIFO in bursts)");
 }
 
 } // namespace
@@ -2077,9 +2431,10 @@ lsm303d_main(int argc, char *argv[])
 	bool external_bus = false;
 	int ch;
 	enum Rotation rotation = ROTATION_NONE;
+	bool fifo = false;
 
 	/* jump over start/off/etc and look at options first */
-	while ((ch = getopt(argc, argv, "XR:")) != EOF) {
+	while ((ch = getopt(argc, argv, "XR:F")) != EOF) {
 		switch (ch) {
 		case 'X':
 			external_bus = true;
@@ -2087,6 +2442,9 @@ lsm303d_main(int argc, char *argv[])
 		case 'R':
 			rotation = (enum Rotation)atoi(optarg);
 			break;
+		case 'F':
+			fifo = true;
+			break;
 		default:
 			lsm303d::usage();
 			exit(0);
@@ -2100,7 +2458,7 @@ lsm303d_main(int argc, char *argv[])
 
 	 */
 	if (!strcmp(verb, "start"))
-		lsm303d::start(external_bus, rotation);
+		lsm303d::start(external_bus, rotation, fifo);
 
 	/*
 	 * Test the driver/device.
@@ -31,43 +31,35 @@
  *
  ****************************************************************************/
 
+
 /**
  * @file mb12xx.cpp
  * @author Greg Hulands
  *
  * Driver for the Maxbotix sonar range finders connected via I2C.
+ *
+ * Several sonars can be started at different addresses; the rangefinder
+ * base triggers them in turn so they do not hear each other's pings.
  */
 
 #include <nuttx/config.h>
 
-#include <drivers/device/i2c.h>
-
 #include <sys/types.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
-#include <semaphore.h>
 #include <string.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <errno.h>
 #include <stdio.h>
-#include <math.h>
 #include <unistd.h>
 
-#include <nuttx/arch.h>
-#include <nuttx/wqueue.h>
-#include <nuttx/clock.h>
-
-#include <systemlib/perf_counter.h>
 #include <systemlib/err.h>
 
 #include <drivers/drv_hrt.h>
 #include <drivers/drv_range_finder.h>
-#include <drivers/device/ringbuffer.h>
-
-#include <uORB/uORB.h>
-#include <uORB/topics/subsystem_info.h>
+#include <drivers/rangefinder/rangefinder.h>
 
 #include <board_config.h>
 
@@ -75,6 +67,7 @@
 #define MB12XX_BUS 			PX4_I2C_BUS_EXPANSION
 #define MB12XX_BASEADDR 	0x70 /* 7-bit address. 8-bit address is 0xE0 */
 #define MB12XX_DEVICE_PATH	"/dev/mb12xx"
+#define MB12XX_MAX_SENSORS	4
 
 /* MB12xx Registers addresses */
 
@@ -94,93 +87,15 @@
 #endif
 static const int ERROR = -1;
 
-#ifndef CONFIG_SCHED_WORKQUEUE
-# error This requires CONFIG_SCHED_WORKQUEUE.
-#endif
-
-class MB12XX : public device::I2C
+class MB12XX : public RangeFinder
 {
 public:
-	MB12XX(int bus = MB12XX_BUS, int address = MB12XX_BASEADDR);
-	virtual ~MB12XX();
-
-	virtual int 		init();
-
-	virtual ssize_t		read(struct file *filp, char *buffer, size_t buflen);
-	virtual int			ioctl(struct file *filp, int cmd, unsigned long arg);
-
-	/**
-	* Diagnostics - print some basic information about the driver.
-	*/
-	void				print_info();
-
+	MB12XX(int bus = MB12XX_BUS, int address = MB12XX_BASEADDR, const char *path = MB12XX_DEVICE_PATH);
 protected:
 	virtual int			probe();
 
-private:
-	float				_min_distance;
-	float				_max_distance;
-	work_s				_work;
-	RingBuffer		*_reports;
-	bool				_sensor_ok;
-	int					_measure_ticks;
-	bool				_collect_phase;
-	int					_class_instance;
-
-	orb_advert_t		_range_finder_topic;
-
-	perf_counter_t		_sample_perf;
-	perf_counter_t		_comms_errors;
-	perf_counter_t		_buffer_overflows;
-
-	/**
-	* Test whether the device supported by the driver is present at a
-	* specific address.
-	*
-	* @param address	The I2C bus address to probe.
-	* @return		True if the device is present.
-	*/
-	int					probe_address(uint8_t address);
-
-	/**
-	* Initialise the automatic measurement state machine and start it.
-	*
-	* @note This function is called at open and error time.  It might make sense
-	*       to make it more aggressive about resetting the bus in case of errors.
-	*/
-	void				start();
-
-	/**
-	* Stop the automatic measurement state machine.
-	*/
-	void				stop();
-
-	/**
-	* Set the min and max distance thresholds if you want the end points of the sensors
-	* range to be brought in at all, otherwise it will use the defaults MB12XX_MIN_DISTANCE
-	* and MB12XX_MAX_DISTANCE
-	*/
-	void				set_minimum_distance(float min);
-	void				set_maximum_distance(float max);
-	float				get_minimum_distance();
-	float				get_maximum_distance();
-
-	/**
-	* Perform a poll cycle; collect from the previous measurement
-	* and start a new one.
-	*/
-	void				cycle();
-	int					measure();
-	int					collect();
-	/**
-	* Static trampoline from the workq context; because we don't have a
-	* generic workq wrapper yet.
-	*
-	* @param arg		Instance pointer for the driver that is polling.
-	*/
-	static void		cycle_trampoline(void *arg);
-
-
+	virtual int			measure();
+	virtual int			collect(float &distance);
 };
 
 /*
@@ -188,83 +103,12 @@ private:
  */
 extern "C" __EXPORT int mb12xx_main(int argc, char *argv[]);
 
-MB12XX::MB12XX(int bus, int address) :
-	I2C("MB12xx", MB12XX_DEVICE_PATH, bus, address, 100000),
-	_min_distance(MB12XX_MIN_DISTANCE),
-	_max_distance(MB12XX_MAX_DISTANCE),
-	_reports(nullptr),
-	_sensor_ok(false),
-	_measure_ticks(0),
-	_collect_phase(false),
-	_class_instance(-1),
-	_range_finder_topic(-1),
-	_sample_perf(perf_alloc(PC_ELAPSED, "mb12xx_read")),
-	_comms_errors(perf_alloc(PC_COUNT, "mb12xx_comms_errors")),
-	_buffer_overflows(perf_alloc(PC_COUNT, "mb12xx_buffer_overflows"))
+MB12XX::MB12XX(int bus, int address, const char *path) :
+	RangeFinder("mb12xx", path, bus, address, 100000, RANGE_FINDER_TYPE_ULTRASOUND,
+		    MB12XX_CONVERSION_INTERVAL, MB12XX_MIN_DISTANCE, MB12XX_MAX_DISTANCE)
 {
 	// enable debug() calls
 	_debug_enabled = false;
-
-	// work_cancel in the dtor will explode if we don't do this...
-	memset(&_work, 0, sizeof(_work));
-}
-
-MB12XX::~MB12XX()
-{
-	/* make sure we are truly inactive */
-	stop();
-
-	/* free any existing reports */
-	if (_reports != nullptr) {
-		delete _reports;
-	}
-
-	if (_class_instance != -1) {
-		unregister_class_devname(RANGE_FINDER_DEVICE_PATH, _class_instance);
-	}
-
-	// free perf counters
-	perf_free(_sample_perf);
-	perf_free(_comms_errors);
-	perf_free(_buffer_overflows);
-}
-
-int
-MB12XX::init()
-{
-	int ret = ERROR;
-
-	/* do I2C init (and probe) first */
-	if (I2C::init() != OK) {
-		goto out;
-	}
-
-	/* allocate basic report buffers */
-	_reports = new RingBuffer(2, sizeof(range_finder_report));
-
-	if (_reports == nullptr) {
-		goto out;
-	}
-
-	_class_instance = register_class_devname(RANGE_FINDER_DEVICE_PATH);
-
-	if (_class_instance == CLASS_DEVICE_PRIMARY) {
-		/* get a publish handle on the range finder topic */
-		struct range_finder_report rf_report;
-		measure();
-		_reports->get(&rf_report);
-		_range_finder_topic = orb_advertise(ORB_ID(sensor_range_finder), &rf_report);
-
-		if (_range_finder_topic < 0) {
-			debug("failed to create sensor_range_finder object. Did you start uOrb?");
-		}
-	}
-
-	ret = OK;
-	/* sensor is ok, but we don't really know if it is within range */
-	_sensor_ok = true;
-out:
-	return ret;
 }
 
 int
@@ -273,204 +117,6 @@ MB12XX::probe()
 	return measure();
 }
 
-void
-MB12XX::set_minimum_distance(float min)
-{
-	_min_distance = min;
-}
-
-void
-MB12XX::set_maximum_distance(float max)
-{
-	_max_distance = max;
-}
-
-float
-MB12XX::get_minimum_distance()
-{
-	return _min_distance;
-}
-
-float
-MB12XX::get_maximum_distance()
-{
-	return _max_distance;
-}
-
-int
-MB12XX::ioctl(struct file *filp, int cmd, unsigned long arg)
-{
-	switch (cmd) {
-
-	case SENSORIOCSPOLLRATE: {
-			switch (arg) {
-
-			/* switching to manual polling */
-			case SENSOR_POLLRATE_MANUAL:
-				stop();
-				_measure_ticks = 0;
-				return OK;
-
-			/* external signalling (DRDY) not supported */
-			case SENSOR_POLLRATE_EXTERNAL:
-
-			/* zero would be bad */
-			case 0:
-				return -EINVAL;
-
-			/* set default/max polling rate */
-			case SENSOR_POLLRATE_MAX:
-			case SENSOR_POLLRATE_DEFAULT: {
-					/* do we need to start internal polling? */
-					bool want_start = (_measure_ticks == 0);
-
-					/* set interval for next measurement to minimum legal value */
-					_measure_ticks = USEC2TICK(MB12XX_CONVERSION_INTERVAL);
-
-					/* if we need to start the poll state machine, do it */
-					if (want_start) {
-						start();
-					}
-
-					return OK;
-				}
-
-			/* adjust to a legal polling interval in Hz */
-			default: {
-					/* do we need to start internal polling? */
-					bool want_start = (_measure_ticks == 0);
-
-					/* convert hz to tick interval via microseconds */
-					unsigned ticks = USEC2TICK(1000000 / arg);
-
-					/* check against maximum rate */
-					if (ticks < USEC2TICK(MB12XX_CONVERSION_INTERVAL)) {
-						return -EINVAL;
-					}
-
-					/* update interval for next measurement */
-					_measure_ticks = ticks;
-
-					/* if we need to start the poll state machine, do it */
-					if (want_start) {
-						start();
-					}
-
-					return OK;
-				}
-			}
-		}
-
-	case SENSORIOCGPOLLRATE:
-		if (_measure_ticks == 0) {
-			return SENSOR_POLLRATE_MANUAL;
-		}
-
-		return (1000 / _measure_ticks);
-
-	case SENSORIOCSQUEUEDEPTH: {
-			/* lower bound is mandatory, upper bound is a sanity check */
-			if ((arg < 1) || (arg > 100)) {
-				return -EINVAL;
-			}
-
-			irqstate_t flags = irqsave();
-
-			if (!_reports->resize(arg)) {
-				irqrestore(flags);
-				return -ENOMEM;
-			}
-
-			irqrestore(flags);
-
-			return OK;
-		}
-
-	case SENSORIOCGQUEUEDEPTH:
-		return _reports->size();
-
-	case SENSORIOCRESET:
-		/* XXX implement this */
-		return -EINVAL;
-
-	case RANGEFINDERIOCSETMINIUMDISTANCE: {
-			set_minimum_distance(*(float *)arg);
-			return 0;
-		}
-		break;
-
-	case RANGEFINDERIOCSETMAXIUMDISTANCE: {
-			set_maximum_distance(*(float *)arg);
-			return 0;
-		}
-		break;
-
-	default:
-		/* give it to the superclass */
-		return I2C::ioctl(filp, cmd, arg);
-	}
-}
-
-ssize_t
-MB12XX::read(struct file *filp, char *buffer, size_t buflen)
-{
-	unsigned count = buflen / sizeof(struct range_finder_report);
-	struct range_finder_report *rbuf = reinterpret_cast<struct range_finder_report *>(buffer);
-	int ret = 0;
-
-	/* buffer must be large enough */
-	if (count < 1) {
-		return -ENOSPC;
-	}
-
-	/* if automatic measurement is enabled */
-	if (_measure_ticks > 0) {
-
-		/*
-		 * While there is space in the caller's buffer, and reports, copy them.
-		 * Note that we may be pre-empted by the workq thread while we are doing this;
-		 * we are careful to avoid racing with them.
-		 */
-		while (count--) {
-			if (_reports->get(rbuf)) {
-				ret += sizeof(*rbuf);
-				rbuf++;
-			}
-		}
-
-		/* if there was no data, warn the caller */
-		return ret ? ret : -EAGAIN;
-	}
-
-	/* manual measurement - run one conversion */
-	do {
-		_reports->flush();
-
-		/* trigger a measurement */
-		if (OK != measure()) {
-			ret = -EIO;
-			break;
-		}
-
-		/* wait for it to complete */
-		usleep(MB12XX_CONVERSION_INTERVAL);
-
-		/* run the collection phase */
-		if (OK != collect()) {
-			ret = -EIO;
-			break;
-		}
-
-		/* state machine will have generated a report, copy it out */
-		if (_reports->get(rbuf)) {
-			ret = sizeof(*rbuf);
-		}
-
-	} while (0);
-
-	return ret;
-}
-
 int
 MB12XX::measure()
 {
@@ -494,150 +140,23 @@ MB12XX::measure()
 }
 
 int
-MB12XX::collect()
+MB12XX::collect(float &distance)
 {
 	int	ret = -EIO;
 
 	/* read from the sensor */
 	uint8_t val[2] = {0, 0};
 
-	perf_begin(_sample_perf);
-
 	ret = transfer(nullptr, 0, &val[0], 2);
 
 	if (ret < 0) {
 		log("error reading from sensor: %d", ret);
-		perf_count(_comms_errors);
-		perf_end(_sample_perf);
 		return ret;
 	}
 
-	uint16_t distance = val[0] << 8 | val[1];
-	float si_units = (distance * 1.0f) / 100.0f; /* cm to m */
-	struct range_finder_report report;
-
-	/* this should be fairly close to the end of the measurement, so the best approximation of the time */
-	report.timestamp = hrt_absolute_time();
-	report.error_count = perf_event_count(_comms_errors);
-	report.distance = si_units;
-	report.valid = si_units > get_minimum_distance() && si_units < get_maximum_distance() ? 1 : 0;
-
-	/* publish it, if we are the primary */
-	if (_range_finder_topic >= 0) {
-		orb_publish(ORB_ID(sensor_range_finder), _range_finder_topic, &report);
-	}
-
-	if (_reports->force(&report)) {
-		perf_count(_buffer_overflows);
-	}
-
-	/* notify anyone waiting for data */
-	poll_notify(POLLIN);
-
-	ret = OK;
-
-	perf_end(_sample_perf);
-	return ret;
-}
-
-void
-MB12XX::start()
-{
-	/* reset the report ring and state machine */
-	_collect_phase = false;
-	_reports->flush();
-
-	/* schedule a cycle to start things */
-	work_queue(HPWORK, &_work, (worker_t)&MB12XX::cycle_trampoline, this, 1);
-
-	/* notify about state change */
-	struct subsystem_info_s info = {
-		true,
-		true,
-		true,
-		SUBSYSTEM_TYPE_RANGEFINDER
-	};
-	static orb_advert_t pub = -1;
-
-	if (pub > 0) {
-		orb_publish(ORB_ID(subsystem_info), pub, &info);
-
-	} else {
-		pub = orb_advertise(ORB_ID(subsystem_info), &info);
-	}
-}
-
-void
-MB12XX::stop()
-{
-	work_cancel(HPWORK, &_work);
-}
-
-void
-MB12XX::cycle_trampoline(void *arg)
-{
-	MB12XX *dev = (MB12XX *)arg;
-
-	dev->cycle();
-}
-
-void
-MB12XX::cycle()
-{
-	/* collection phase? */
-	if (_collect_phase) {
-
-		/* perform collection */
-		if (OK != collect()) {
-			log("collection error");
-			/* restart the measurement state machine */
-			start();
-			return;
-		}
-
-		/* next phase is measurement */
-		_collect_phase = false;
-
-		/*
-		 * Is there a collect->measure gap?
-		 */
-		if (_measure_ticks > USEC2TICK(MB12XX_CONVERSION_INTERVAL)) {
-
-			/* schedule a fresh cycle call when we are ready to measure again */
-			work_queue(HPWORK,
-				   &_work,
-				   (worker_t)&MB12XX::cycle_trampoline,
-				   this,
-				   _measure_ticks - USEC2TICK(MB12XX_CONVERSION_INTERVAL));
-
-			return;
-		}
-	}
-
-	/* measurement phase */
-	if (OK != measure()) {
-		log("measure error");
-	}
-
-	/* next phase is collection */
-	_collect_phase = true;
-
-	/* schedule a fresh cycle call when the measurement is done */
-	work_queue(HPWORK,
-		   &_work,
-		   (worker_t)&MB12XX::cycle_trampoline,
-		   this,
-		   USEC2TICK(MB12XX_CONVERSION_INTERVAL));
-}
+	distance = ((val[0] << 8) | val[1]) / 100.0f; /* cm to m */
 
-void
-MB12XX::print_info()
-{
-	perf_print_counter(_sample_perf);
-	perf_print_counter(_comms_errors);
-	perf_print_counter(_buffer_overflows);
-	printf("poll interval:  %u ticks\n", _measure_ticks);
-	_reports->print_info("report queue");
+	return OK;
 }
 
 /**
@@ -652,55 +171,76 @@ namespace mb12xx
 #endif
 const int ERROR = -1;
 
-MB12XX	*g_dev;
+const char *const device_path[MB12XX_MAX_SENSORS] = {
+	MB12XX_DEVICE_PATH,
+	MB12XX_DEVICE_PATH "1",
+	MB12XX_DEVICE_PATH "2",
+	MB12XX_DEVICE_PATH "3"
+};
+
+MB12XX	*g_dev[MB12XX_MAX_SENSORS];
 
-void	start();
+void	start(int address);
 void	stop();
 void	test();
 void	reset();
 void	info();
+void	usage();
 
 /**
- * Start the driver.
+ * Start the driver for one more sonar.
  */
 void
-start()
+start(int address)
 {
 	int fd;
+	unsigned i;
+
+	for (i = 0; i < MB12XX_MAX_SENSORS; i++) {
+		if (g_dev[i] != nullptr && g_dev[i]->get_address() == address) {
+			errx(1, "already started at 0x%02x", address);
+		}
+	}
 
-	if (g_dev != nullptr) {
-		errx(1, "already started");
+	/* the first free slot */
+	for (i = 0; i < MB12XX_MAX_SENSORS && g_dev[i] != nullptr; i++) {
+	}
+
+	if (i == MB12XX_MAX_SENSORS) {
+		errx(1, "too many sonars");
 	}
 
 	/* create the driver */
-	g_dev = new MB12XX(MB12XX_BUS);
+	g_dev[i] = new MB12XX(MB12XX_BUS, address, device_path[i]);
 
-	if (g_dev == nullptr) {
+	if (g_dev[i] == nullptr) {
 		goto fail;
 	}
 
-	if (OK != g_dev->init()) {
+	if (OK != g_dev[i]->init()) {
 		goto fail;
 	}
 
 	/* set the poll rate to default, starts automatic data collection */
-	fd = open(MB12XX_DEVICE_PATH, O_RDONLY);
+	fd = open(device_path[i], O_RDONLY);
 
 	if (fd < 0) {
 		goto fail;
 	}
 
 	if (ioctl(fd, SENSORIOCSPOLLRATE, SENSOR_POLLRATE_DEFAULT) < 0) {
+		close(fd);
 		goto fail;
 	}
 
+	close(fd);
 	exit(0);
 
 fail:
 
-	if (g_dev != nullptr) {
-		delete g_dev;
-		g_dev = nullptr;
+	if (g_dev[i] != nullptr) {
+		delete g_dev[i];
+		g_dev[i] = nullptr;
 	}
 
 	errx(1, "driver start failed");
@@ -711,11 +251,17 @@ fail:
  */
 void stop()
 {
-	if (g_dev != nullptr) {
-		delete g_dev;
-		g_dev = nullptr;
+	bool running = false;
+
+	for (unsigned i = 0; i < MB12XX_MAX_SENSORS; i++) {
+		if (g_dev[i] != nullptr) {
+			delete g_dev[i];
+			g_dev[i] = nullptr;
+			running = true;
+		}
+	}
 
-	} else {
+	if (!running) {
 		errx(1, "driver not running");
 	}
 
@@ -818,53 +364,90 @@ reset()
 void
 info()
 {
-	if (g_dev == nullptr) {
-		errx(1, "driver not running");
+	bool running = false;
+
+	for (unsigned i = 0; i < MB12XX_MAX_SENSORS; i++) {
+		if (g_dev[i] != nullptr) {
+			printf("%s at 0x%02x, state @ %p\n", device_path[i], g_dev[i]->get_address(), g_dev[i]);
+			g_dev[i]->print_info();
+			running = true;
+		}
 	}
 
-	printf("state @ %p\n", g_dev);
-	g_dev->print_info();
+	if (!running) {
+		errx(1, "driver not running");
+	}
 
 	exit(0);
 }
 
+void
+usage()
+{
+	warnx("missing command: try 'start', 'stop', 'info', 'test', 'reset'");
+	warnx("options:");
+	warnx("    -a <address> start a sonar at this 7-bit address (default 0x%02x)", MB12XX_BASEADDR);
+}
+
 } // namespace
 
 int
 mb12xx_main(int argc, char *argv[])
 {
+	int ch;
+	int address = MB12XX_BASEADDR;
+
+	while ((ch = getopt(argc, argv, "a:")) != EOF) {
+		switch (ch) {
+		case 'a':
+			address = strtoul(optarg, nullptr, 0);
+			break;
+
+		default:
+			mb12xx::usage();
+			exit(0);
+		}
+	}
+
+	if (optind >= argc) {
+		mb12xx::usage();
+		exit(1);
+	}
+
+	const char *verb = argv[optind];
+
 	/*
 	 * Start/load the driver.
 	 */
-	if (!strcmp(argv[1], "start")) {
-		mb12xx::start();
+	if (!strcmp(verb, "start")) {
+		mb12xx::start(address);
 	}
 
 	/*
 	 * Stop the driver
 	 */
-	if (!strcmp(argv[1], "stop")) {
+	if (!strcmp(verb, "stop")) {
 		mb12xx::stop();
 	}
 
 	/*
 	 * Test the driver/device.
 	 */
-	if (!strcmp(argv[1], "test")) {
+	if (!strcmp(verb, "test")) {
 		mb12xx::test();
 	}
 
 	/*
 	 * Reset the driver.
 	 */
-	if (!strcmp(argv[1], "reset")) {
+	if (!strcmp(verb, "reset")) {
 		mb12xx::reset();
 	}
 
 	/*
 	 * Print driver information.
 	 */
-	if (!strcmp(argv[1], "info") || !strcmp(argv[1], "status")) {
+	if (!strcmp(verb, "info") || !strcmp(verb, "status")) {
 		mb12xx::info();
 	}
 
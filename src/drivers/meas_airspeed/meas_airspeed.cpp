@@ -74,6 +74,7 @@
 
 #include <board_config.h>
 
+#include <systemlib/work_profile.h>
 #include <systemlib/airspeed.h>
 #include <systemlib/err.h>
 #include <systemlib/param/param.h>
@@ -106,6 +107,9 @@
 #define MEAS_DRIVER_FILTER_FREQ 1.2f
 #define CONVERSION_INTERVAL	(1000000 / MEAS_RATE)	/* microseconds */
 
+/* stale reads in a row after which a sensor is taken to need a trigger */
+#define MEAS_STALE_MAX		3
+
 class MEASAirspeed : public Airspeed
 {
 public:
@@ -130,6 +134,14 @@ protected:
 
 	int _t_system_power;
 	struct system_power_s system_power;
+
+	/*
+	 * Sensors that are not in sleep mode convert on their own, so a
+	 * single read gets fresh pressure and temperature without a trigger.
+	 */
+	bool _burst;			/**< reading without triggering */
+	bool _burst_probed;		/**< checked whether the sensor converts on its own */
+	unsigned _stale_reads;		/**< reads in a row without a new conversion */
 };
 
 /*
@@ -141,7 +153,10 @@ MEASAirspeed::MEASAirspeed(int bus, int address, const char *path) : Airspeed(bu
 	CONVERSION_INTERVAL, path),
 	_filter(MEAS_RATE, MEAS_DRIVER_FILTER_FREQ),
 	_t_system_power(-1),
-	system_power{}
+	system_power{},
+	_burst(false),
+	_burst_probed(false),
+	_stale_reads(0)
 {
 }
 
@@ -188,14 +203,20 @@ MEASAirspeed::collect()
 	case 0:
 		break;
 
-	case 1:
-		/* fallthrough */
 	case 2:
+		/* stale data, no conversion since the last read; expected now and then in burst mode */
+		if (!_burst)
+			perf_count(_comms_errors);
+
+		perf_end(_sample_perf);
+		return -EAGAIN;
+
+	case 1:
 		/* fallthrough */
 	case 3:
 		perf_count(_comms_errors);
 		perf_end(_sample_perf);
-		return -EAGAIN;
+		return -EIO;
 	}
 
 	int16_t dp_raw = 0, dT_raw = 0;
@@ -271,6 +292,39 @@ MEASAirspeed::cycle()
 {
 	int ret;
 
+	/* burst mode: one read per cycle, nothing to trigger */
+	if (_burst) {
+		ret = collect();
+
+		if (ret == -EAGAIN) {
+			if (++_stale_reads >= MEAS_STALE_MAX) {
+				/* the sensor only converts when told to */
+				_burst = false;
+				start();
+				return;
+			}
+
+		} else if (OK != ret) {
+			/* restart the measurement state machine */
+			start();
+			_sensor_ok = false;
+			return;
+
+		} else {
+			_stale_reads = 0;
+		}
+
+		_sensor_ok = true;
+
+		work_queue_profiled(HPWORK,
+			            &_work,
+			            (worker_t)&Airspeed::cycle_trampoline,
+			            this,
+			            (_measure_ticks > USEC2TICK(CONVERSION_INTERVAL)) ? _measure_ticks : USEC2TICK(CONVERSION_INTERVAL),
+			            "meas_airspeed");
+		return;
+	}
+
 	/* collection phase? */
 	if (_collect_phase) {
 
@@ -286,17 +340,38 @@ MEASAirspeed::cycle()
 		/* next phase is measurement */
 		_collect_phase = false;
 
+		/*
+		 * Once, after the first good measurement, read again without a
+		 * trigger. A sensor converting on its own has fresh data by then
+		 * and is read in bursts from now on, else stale reads fall back
+		 * to triggering.
+		 */
+		if (!_burst_probed) {
+			_burst_probed = true;
+			_burst = true;
+			_stale_reads = 0;
+
+			work_queue_profiled(HPWORK,
+				            &_work,
+				            (worker_t)&Airspeed::cycle_trampoline,
+				            this,
+				            USEC2TICK(CONVERSION_INTERVAL),
+				            "meas_airspeed");
+			return;
+		}
+
 		/*
 		 * Is there a collect->measure gap?
 		 */
 		if (_measure_ticks > USEC2TICK(CONVERSION_INTERVAL)) {
 
 			/* schedule a fresh cycle call when we are ready to measure again */
-			work_queue(HPWORK,
-				   &_work,
-				   (worker_t)&Airspeed::cycle_trampoline,
-				   this,
-				   _measure_ticks - USEC2TICK(CONVERSION_INTERVAL));
+			work_queue_profiled(HPWORK,
+				            &_work,
+				            (worker_t)&Airspeed::cycle_trampoline,
+				            this,
+				            _measure_ticks - USEC2TICK(CONVERSION_INTERVAL),
+				            "meas_airspeed");
 
 			return;
 		}
@@ -314,11 +389,12 @@ MEASAirspeed::cycle()
 	_collect_phase = true;
 
 	/* schedule a fresh cycle call when the measurement is done */
-	work_queue(HPWORK,
-		   &_work,
-		   (worker_t)&Airspeed::cycle_trampoline,
-		   this,
-		   USEC2TICK(CONVERSION_INTERVAL));
+	work_queue_profiled(HPWORK,
+		            &_work,
+		            (worker_t)&Airspeed::cycle_trampoline,
+		            this,
+		            USEC2TICK(CONVERSION_INTERVAL),
+		            "meas_airspeed");
 }
 
 /**
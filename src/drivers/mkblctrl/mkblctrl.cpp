@@ -104,7 +104,6 @@ struct MotorData_t {
 	unsigned int Current;                        // in 0.1 A steps, read back from BL
 	unsigned int MaxPWM;                         // read back from BL is less than 255 if BL is in current limit
 	unsigned int Temperature;            // old BL-Ctrl will return a 255 here, the new version the temp. in
-	unsigned int RoundCount;
 };
 
 class MK : public device::I2C
@@ -145,6 +144,7 @@ private:
 	int		_t_actuators;
 	int		_t_actuator_armed;
 	unsigned int		_motor;
+	unsigned int		_telemetry_motor;		///< BL-Ctrl to read the status of next
 	int    _px4mode;
 	int    _frametype;
 	char				_device[20];					///< device
@@ -189,6 +189,7 @@ private:
 
 	int			mk_servo_arm(bool status);
 	int 		mk_servo_set(unsigned int chan, short val);
+	int 		mk_servo_update();
 	int 		mk_servo_set_value(unsigned int chan, short val);
 	int 		mk_servo_test(unsigned int chan);
 	short		scaling(float val, float inMin, float inMax, float outMin, float outMax);
@@ -223,6 +224,7 @@ MK::MK(int bus, const char *_device_path) :
 	_t_actuators(-1),
 	_t_actuator_armed(-1),
 	_motor(-1),
+	_telemetry_motor(0),
 	_px4mode(MAPPING_MK),
 	_frametype(FRAME_PLUS),
 	_t_outputs(0),
@@ -463,6 +465,7 @@ MK::task_main()
 	esc_status_s esc;
 	memset(&esc, 0, sizeof(esc));
 	_t_esc_status = orb_advertise(ORB_ID(esc_status), &esc);
+	hrt_abstime motortest_time = 0;
 
 
 
@@ -567,6 +570,11 @@ MK::task_main()
 
 				}
 
+				/* send all setpoints at once */
+				if (_motortest != true) {
+					mk_servo_update();
+				}
+
 			}
 
 
@@ -587,46 +595,59 @@ MK::task_main()
 
 
 		/*
-		 * Only update esc topic every half second.
+		 * Update the esc topic with what the BL-Ctrls returned for every set of
+		 * outputs, at least every half second. It is filled in place, the
+		 * readers get the telemetry without another copy.
 		 */
+		hrt_abstime now = hrt_absolute_time();
 
-		if (hrt_absolute_time() - esc.timestamp > ESC_UORB_PUBLISH_DELAY) {
+		if ((fds[0].revents & POLLIN) || (now - esc.timestamp > ESC_UORB_PUBLISH_DELAY)) {
 			esc.counter++;
-			esc.timestamp = hrt_absolute_time();
-			esc.esc_count = (uint8_t) _num_outputs;
-			esc.esc_connectiontype = ESC_CONNECTION_TYPE_I2C;
+			esc.timestamp = now;
 
-			for (unsigned int i = 0; i < _num_outputs; i++) {
-				esc.esc[i].esc_address = (uint8_t) BLCTRL_BASE_ADDR + i;
-				esc.esc[i].esc_vendor = ESC_VENDOR_MIKROKOPTER;
-				esc.esc[i].esc_version = (uint16_t) Motor[i].Version;
-				esc.esc[i].esc_voltage = 0.0F;
-				esc.esc[i].esc_current = static_cast<float>(Motor[i].Current) * 0.1F;
-				esc.esc[i].esc_rpm = (uint16_t) 0;
-				esc.esc[i].esc_setpoint = (float) Motor[i].SetPoint_PX4;
-
-				if (Motor[i].Version == 1) {
-					// BLCtrl 2.0 (11Bit)
-					esc.esc[i].esc_setpoint_raw = (uint16_t)(Motor[i].SetPoint << 3) | Motor[i].SetPointLowerBits;
+			esc_status_s *report = (esc_status_s *)orb_loan(ORB_ID(esc_status), _t_esc_status);
 
-				} else {
-					// BLCtrl < 2.0 (8Bit)
-					esc.esc[i].esc_setpoint_raw = (uint16_t) Motor[i].SetPoint;
-				}
+			if (report != nullptr) {
+				memset(report, 0, sizeof(*report));
+				report->counter = esc.counter;
+				report->timestamp = now;
+				report->esc_count = (uint8_t) _num_outputs;
+				report->esc_connectiontype = ESC_CONNECTION_TYPE_I2C;
 
-				esc.esc[i].esc_temperature = static_cast<float>(Motor[i].Temperature);
-				esc.esc[i].esc_state = (uint16_t) Motor[i].State;
-				esc.esc[i].esc_errorcount = (uint16_t) 0;
+				for (unsigned int i = 0; i < _num_outputs; i++) {
+					report->esc[i].esc_address = (uint8_t) BLCTRL_BASE_ADDR + i;
+					report->esc[i].esc_vendor = ESC_VENDOR_MIKROKOPTER;
+					report->esc[i].esc_version = (uint16_t) Motor[i].Version;
+					report->esc[i].esc_voltage = 0.0F;
+					report->esc[i].esc_current = static_cast<float>(Motor[i].Current) * 0.1F;
+					report->esc[i].esc_rpm = (uint16_t) 0;
+					report->esc[i].esc_setpoint = (float) Motor[i].SetPoint_PX4;
+
+					if (Motor[i].Version == 1) {
+						// BLCtrl 2.0 (11Bit)
+						report->esc[i].esc_setpoint_raw = (uint16_t)(Motor[i].SetPoint << 3) | Motor[i].SetPointLowerBits;
 
-				// if motortest is requested - do it...
-				if (_motortest == true) {
-					mk_servo_test(i);
+					} else {
+						// BLCtrl < 2.0 (8Bit)
+						report->esc[i].esc_setpoint_raw = (uint16_t) Motor[i].SetPoint;
+					}
+
+					report->esc[i].esc_temperature = static_cast<float>(Motor[i].Temperature);
+					report->esc[i].esc_state = (uint16_t) Motor[i].State;
+					report->esc[i].esc_errorcount = (uint16_t) 0;
 				}
 
+				orb_commit(ORB_ID(esc_status), _t_esc_status);
 			}
+		}
 
-			orb_publish(ORB_ID(esc_status), _t_esc_status, &esc);
+		// if motortest is requested - do it, every half second
+		if ((_motortest == true) && (now - motortest_time > ESC_UORB_PUBLISH_DELAY)) {
+			motortest_time = now;
 
+			for (unsigned int i = 0; i < _num_outputs; i++) {
+				mk_servo_test(i);
+			}
 		}
 
 	}
@@ -677,7 +698,6 @@ MK::mk_check_for_blctrl(unsigned int count, bool showOutput, bool initI2C)
 		Motor[i].Current = 0;
 		Motor[i].MaxPWM = 0;
 		Motor[i].Temperature = 0;
-		Motor[i].RoundCount = 0;
 	}
 
 	uint8_t msg = 0;
@@ -728,10 +748,6 @@ int
 MK::mk_servo_set(unsigned int chan, short val)
 {
 	short tmpVal = 0;
-	_retries = 0;
-	uint8_t result[3] = { 0, 0, 0 };
-	uint8_t msg[2] = { 0, 0 };
-	uint8_t bytesToSendBL2 = 2;
 
 	tmpVal = val;
 
@@ -750,68 +766,85 @@ MK::mk_servo_set(unsigned int chan, short val)
 		Motor[chan].SetPointLowerBits = 0;
 	}
 
-	//if(Motor[chan].State & MOTOR_STATE_PRESENT_MASK) {
-	set_address(BLCTRL_BASE_ADDR + (chan + addrTranslator[chan]));
-
-	if (Motor[chan].Version == BLCTRL_OLD) {
-		/*
-		*	Old BL-Ctrl 8Bit served. Version < 2.0
-		*/
-		msg[0] = Motor[chan].SetPoint;
+	return 0;
+}
 
-		if (Motor[chan].RoundCount >= 16) {
-			// on each 16th cyle we read out the status messages from the blctrl
-			if (OK == transfer(&msg[0], 1, &result[0], 2)) {
-				Motor[chan].Current = result[0];
-				Motor[chan].MaxPWM = result[1];
-				Motor[chan].Temperature = 255;;
+int
+MK::mk_servo_update()
+{
+	_retries = 0;
+	i2c_msg_s msgv[MAX_MOTORS];
+	uint8_t msg[MAX_MOTORS][2];
+	uint8_t result[3] = { 0, 0, 0 };
 
-			} else {
-				if ((Motor[chan].State & MOTOR_STATE_ERROR_MASK) < MOTOR_STATE_ERROR_MASK) Motor[chan].State++;	// error
-			}
+	if (_num_outputs == 0)
+		return 0;
 
-			Motor[chan].RoundCount = 0;
+	/*
+	 * The setpoints of all motors go out as one combined transaction,
+	 * so the last motor is no longer a whole round of telemetry reads
+	 * behind the first.
+	 */
+	for (unsigned int chan = 0; chan < _num_outputs; chan++) {
+		msg[chan][0] = Motor[chan].SetPoint;
+		msg[chan][1] = Motor[chan].SetPointLowerBits;
 
-		} else {
-			if (OK != transfer(&msg[0], 1, nullptr, 0)) {
-				if ((Motor[chan].State & MOTOR_STATE_ERROR_MASK) < MOTOR_STATE_ERROR_MASK) Motor[chan].State++;	// error
-			}
-		}
+		msgv[chan].addr = BLCTRL_BASE_ADDR + (chan + addrTranslator[chan]);
+		msgv[chan].flags = 0;
+		msgv[chan].buffer = &msg[chan][0];
 
-	} else {
 		/*
-		*	New BL-Ctrl 11Bit served. Version >= 2.0
-		*/
-		msg[0] = Motor[chan].SetPoint;
-		msg[1] = Motor[chan].SetPointLowerBits;
+		 * Old BL-Ctrl (< 2.0) take 8 bits. The new ones take 11, but if
+		 * the lower bits are zero we send only the higher bits - this
+		 * saves time.
+		 */
+		if (Motor[chan].Version == BLCTRL_OLD || Motor[chan].SetPointLowerBits == 0) {
+			msgv[chan].length = 1;
 
-		if (Motor[chan].SetPointLowerBits == 0) {
-			bytesToSendBL2 = 1;	// if setpoint lower bits are zero, we send only the higher bits - this saves time
+		} else {
+			msgv[chan].length = 2;
 		}
+	}
 
-		if (Motor[chan].RoundCount >= 16) {
-			// on each 16th cyle we read out the status messages from the blctrl
-			if (OK == transfer(&msg[0], bytesToSendBL2, &result[0], 3)) {
-				Motor[chan].Current = result[0];
-				Motor[chan].MaxPWM = result[1];
-				Motor[chan].Temperature = result[2];
+	if (OK != transfer_batch(&msgv[0], _num_outputs)) {
+		/* a missing BL-Ctrl fails the whole batch, find it and still update the others */
+		for (unsigned int chan = 0; chan < _num_outputs; chan++) {
+			set_address(msgv[chan].addr);
 
-			} else {
+			if (OK != transfer(msgv[chan].buffer, msgv[chan].length, nullptr, 0)) {
 				if ((Motor[chan].State & MOTOR_STATE_ERROR_MASK) < MOTOR_STATE_ERROR_MASK) Motor[chan].State++;	// error
 			}
+		}
+	}
+
+	/* read the status of one BL-Ctrl per cycle, in turn */
+	if (_telemetry_motor >= _num_outputs)
+		_telemetry_motor = 0;
 
-			Motor[chan].RoundCount = 0;
+	unsigned int chan = _telemetry_motor++;
+
+	set_address(msgv[chan].addr);
+
+	if (Motor[chan].Version == BLCTRL_OLD) {
+		if (OK == transfer(nullptr, 0, &result[0], 2)) {
+			Motor[chan].Current = result[0];
+			Motor[chan].MaxPWM = result[1];
+			Motor[chan].Temperature = 255;
 
 		} else {
-			if (OK != transfer(&msg[0], bytesToSendBL2, nullptr, 0)) {
-				if ((Motor[chan].State & MOTOR_STATE_ERROR_MASK) < MOTOR_STATE_ERROR_MASK) Motor[chan].State++;	// error
-			}
+			if ((Motor[chan].State & MOTOR_STATE_ERROR_MASK) < MOTOR_STATE_ERROR_MASK) Motor[chan].State++;	// error
 		}
 
-	}
+	} else {
+		if (OK == transfer(nullptr, 0, &result[0], 3)) {
+			Motor[chan].Current = result[0];
+			Motor[chan].MaxPWM = result[1];
+			Motor[chan].Temperature = result[2];
 
-	Motor[chan].RoundCount++;
-	//}
+		} else {
+			if ((Motor[chan].State & MOTOR_STATE_ERROR_MASK) < MOTOR_STATE_ERROR_MASK) Motor[chan].State++;	// error
+		}
+	}
 
 	if (showDebug == true) {
 		debugCounter++;
@@ -997,6 +1030,7 @@ MK::pwm_ioctl(file *filp, int cmd, unsigned long arg)
 		if (arg < 2150) {
 			Motor[cmd - PWM_SERVO_SET(0)].RawPwmValue = (unsigned short)arg;
 			mk_servo_set(cmd - PWM_SERVO_SET(0), scaling(arg, 1010, 2100, 0, 2047));
+			mk_servo_update();
 
 		} else {
 			ret = -EINVAL;
@@ -1051,10 +1085,8 @@ MK::pwm_ioctl(file *filp, int cmd, unsigned long arg)
 			break;
 		}
 
-	case MIXERIOCLOADBUF: {
-			const char *buf = (const char *)arg;
-			unsigned buflen = strnlen(buf, 1024);
-
+	case MIXERIOCLOADBUF:
+	case MIXERIOCLOADBIN: {
 			if (_mixers == nullptr)
 				_mixers = new MixerGroup(control_callback, (uintptr_t)&_controls);
 
@@ -1063,7 +1095,16 @@ MK::pwm_ioctl(file *filp, int cmd, unsigned long arg)
 
 			} else {
 
-				ret = _mixers->load_from_buf(buf, buflen);
+				if (cmd == MIXERIOCLOADBIN) {
+					const mixer_bin_buf_s *bin = (const mixer_bin_buf_s *)arg;
+					unsigned buflen = bin->length;
+					ret = _mixers->load_from_bin(bin->data, buflen);
+
+				} else {
+					const char *buf = (const char *)arg;
+					unsigned buflen = strnlen(buf, 1024);
+					ret = _mixers->load_from_buf(buf, buflen);
+				}
 
 				if (ret != 0) {
 					debug("mixer load failed with %d", ret);
@@ -1109,6 +1150,8 @@ MK::write(file *filp, const char *buffer, size_t len)
 		mk_servo_set(i, scaling(values[i], 1010, 2100, 0, 2047));
 	}
 
+	mk_servo_update();
+
 	return count * 2;
 }
 
@@ -69,6 +69,7 @@
 
 #include <drivers/device/spi.h>
 #include <drivers/device/ringbuffer.h>
+#include <drivers/device/integrator.h>
 #include <drivers/drv_accel.h>
 #include <drivers/drv_gyro.h>
 #include <mathlib/math/filter/LowPassFilter2p.hpp>
@@ -139,6 +140,11 @@
 #define BIT_RAW_RDY_EN			0x01
 #define BIT_I2C_IF_DIS			0x10
 #define BIT_INT_STATUS_DATA		0x01
+#define BIT_USER_CTRL_FIFO_EN		0x40
+#define BIT_USER_CTRL_FIFO_RESET	0x04
+#define BITS_FIFO_EN_TEMP		0x80
+#define BITS_FIFO_EN_GYRO		0x70
+#define BITS_FIFO_EN_ACCEL		0x08
 
 // Product ID Description for MPU6000
 // high 4 bits 	low 4 bits
@@ -166,6 +172,12 @@
 
 #define MPU6000_DEFAULT_ONCHIP_FILTER_FREQ		42
 
+/* driver filters at the default rates, computed at build time */
+static constexpr math::LowPassFilter2pCoefficients mpu6000_accel_default_filter =
+	math::lowpass_2p_coefficients(MPU6000_ACCEL_DEFAULT_RATE, MPU6000_ACCEL_DEFAULT_DRIVER_FILTER_FREQ);
+static constexpr math::LowPassFilter2pCoefficients mpu6000_gyro_default_filter =
+	math::lowpass_2p_coefficients(MPU6000_GYRO_DEFAULT_RATE, MPU6000_GYRO_DEFAULT_DRIVER_FILTER_FREQ);
+
 #define MPU6000_ONE_G					9.80665f
 
 /*
@@ -173,6 +185,30 @@
   interrupt status registers. All other registers have a maximum 1MHz
   SPI speed
  */
+/*
+  FIFO mode: accel, temperature and gyro are queued in register order,
+  14 bytes per sample, and drained in one burst per poll. At most
+  MPU6000_FIFO_MAX_INTERVAL may pass between bursts so 8 kHz of samples
+  fit well within the 1024 byte FIFO.
+ */
+#define MPU6000_FIFO_SIZE				1024
+#define MPU6000_FIFO_SAMPLE_SIZE			14
+#define MPU6000_FIFO_MAX_SAMPLES			(MPU6000_FIFO_SIZE / MPU6000_FIFO_SAMPLE_SIZE)
+#define MPU6000_FIFO_MAX_INTERVAL			4000
+#define MPU6000_FIFO_MAX_RATE				8000
+
+/*
+  data ready mode: reads are triggered by the DRDY interrupt and the
+  hrt_call only watches for a stuck interrupt line, running at
+  MPU6000_DRDY_WATCHDOG_FACTOR times the poll interval
+ */
+#ifdef GPIO_EXTI_MPU_DRDY
+# define MPU6000_USE_DRDY 1
+#else
+# define MPU6000_USE_DRDY 0
+#endif
+#define MPU6000_DRDY_WATCHDOG_FACTOR			4
+
 #define MPU6000_LOW_BUS_SPEED				1000*1000
 #define MPU6000_HIGH_BUS_SPEED				11*1000*1000 /* will be rounded to 10.4 MHz, within margins for MPU6K */
 
@@ -194,6 +230,15 @@ public:
 	 */
 	void			print_info();
 
+	/**
+	 * Sample through the FIFO instead of reading the latest sample
+	 * on every poll. Must be called before init().
+	 *
+	 * @param rate		Sensor sample rate in Hz, up to 8 kHz.
+	 * @return		OK, or -EINVAL if the rate is not supported.
+	 */
+	int			enable_fifo(unsigned rate);
+
 protected:
 	virtual int		probe();
 
@@ -231,15 +276,65 @@ private:
 	perf_counter_t		_bad_transfers;
 	perf_counter_t		_good_transfers;
 
-	math::LowPassFilter2p	_accel_filter_x;
-	math::LowPassFilter2p	_accel_filter_y;
-	math::LowPassFilter2p	_accel_filter_z;
-	math::LowPassFilter2p	_gyro_filter_x;
-	math::LowPassFilter2p	_gyro_filter_y;
-	math::LowPassFilter2p	_gyro_filter_z;
+	math::LowPassFilter2pN<3>	_accel_filter;
+	math::LowPassFilter2pN<3>	_gyro_filter;
 
 	enum Rotation		_rotation;
 
+	Integrator		_accel_int;
+	Integrator		_gyro_int;
+
+	bool			_use_fifo;
+	uint8_t			*_fifo_buffer;
+	hrt_abstime		_fifo_last_read;
+	perf_counter_t		_fifo_resets;
+
+#pragma pack(push, 1)
+	/**
+	 * Report conversation within the MPU6000, including command byte and
+	 * interrupt status.
+	 */
+	struct MPUReport {
+		uint8_t		cmd;
+		uint8_t		status;
+		uint8_t		accel_x[2];
+		uint8_t		accel_y[2];
+		uint8_t		accel_z[2];
+		uint8_t		temp[2];
+		uint8_t		gyro_x[2];
+		uint8_t		gyro_y[2];
+		uint8_t		gyro_z[2];
+	};
+#pragma pack(pop)
+
+	/** asynchronous read queued from the hrt_call */
+	Transaction		_measure_txn;
+	MPUReport		_measure_report;
+	hrt_abstime		_measure_time;
+	perf_counter_t		_measure_busy;
+
+	/** data ready interrupt state */
+	bool			_drdy_active;
+	volatile bool		_drdy_seen;
+	hrt_abstime		_drdy_last_read;
+	perf_counter_t		_drdy_timeouts;
+
+	/** the instance on the sensor bus owns the DRDY line */
+	static MPU6000		*_drdy_dev;
+
+	/**
+	 * One set of measurements in native byte order.
+	 */
+	struct Report {
+		int16_t		accel_x;
+		int16_t		accel_y;
+		int16_t		accel_z;
+		int16_t		temp;
+		int16_t		gyro_x;
+		int16_t		gyro_y;
+		int16_t		gyro_z;
+	};
+
 	/**
 	 * Start automatic measurement.
 	 */
@@ -268,10 +363,91 @@ private:
 	 */
 	static void		measure_trampoline(void *arg);
 
+	/**
+	 * Data ready interrupt handler, triggers a read stamped with the
+	 * time of the interrupt.
+	 */
+	static int		drdy_interrupt(int irq, void *context);
+
+	/**
+	 * Attach the data ready interrupt if the board has one.
+	 *
+	 * @return		true if reads are driven by the interrupt.
+	 */
+	bool			drdy_start();
+	void			drdy_stop();
+
+	/**
+	 * Take a sample, asynchronously if possible, from interrupt context.
+	 *
+	 * @param timestamp	Time of the sample, 0 to stamp it when read.
+	 */
+	void			sample(hrt_abstime timestamp);
+
 	/**
 	 * Fetch measurements from the sensor and update the report buffers.
+	 *
+	 * @param timestamp	Time of the sample, 0 to stamp it when read.
+	 */
+	void			measure(hrt_abstime timestamp = 0);
+
+	/**
+	 * Queue the measurement read as an asynchronous transfer.
+	 *
+	 * @param timestamp	Time of the sample, 0 to stamp it when read.
+	 * @return		OK if queued, -errno if measure() has to be
+	 *			used instead.
+	 */
+	int			measure_async(hrt_abstime timestamp);
+
+	/**
+	 * Completion of the transfer queued by measure_async().
+	 */
+	static void		measure_async_complete(void *arg, int result);
+
+	/**
+	 * Update the report buffers from a measurement read.
+	 */
+	void			process_report(MPUReport &mpu_report, hrt_abstime timestamp);
+
+	/**
+	 * Drain the FIFO in one burst and queue every sample.
+	 */
+	void			measure_fifo();
+
+	/**
+	 * Discard the FIFO content and restart queueing.
+	 */
+	void			fifo_reset();
+
+	/**
+	 * Rotate, scale, filter and integrate one set of measurements.
+	 *
+	 * @param close		Close the integrals with this set if there is
+	 *			no integration interval.
+	 * @return		false if the data was all zero (bus error).
+	 */
+	bool			convert_report(Report &report, hrt_abstime timestamp,
+					       accel_report &arb, gyro_report &grb, bool close);
+
+	/**
+	 * Fill in the integral of a report.
+	 *
+	 * @return		true if the report closes an integral.
+	 */
+	template <typename R>
+	bool			integrate(Integrator &integrator, R &r, math::Vector<3> &val, bool close);
+
+	/**
+	 * Notify pollers and publish the reports that close an integral.
+	 */
+	void			publish_reports(accel_report &arb, gyro_report &grb);
+
+	/**
+	 * Rate the software filters run at: once per poll, or once
+	 * per sample in FIFO mode.
 	 */
-	void			measure();
+	float			filter_rate() { return _use_fifo ? _sample_rate : 1.0e6f / _call_interval; }
 
 	/**
 	 * Read a register from the MPU6000
@@ -394,7 +570,7 @@ MPU6000::MPU6000(int bus, const char *path_accel, const char *path_gyro, spi_dev
 	_accel_range_scale(0.0f),
 	_accel_range_m_s2(0.0f),
 	_accel_topic(-1),
-	_accel_orb_id(nullptr),
+	_accel_orb_id(ORB_ID(sensor_accel)),
 	_accel_class_instance(-1),
 	_gyro_reports(nullptr),
 	_gyro_scale{},
@@ -406,13 +582,23 @@ MPU6000::MPU6000(int bus, const char *path_accel, const char *path_gyro, spi_dev
 	_sample_perf(perf_alloc(PC_ELAPSED, "mpu6000_read")),
 	_bad_transfers(perf_alloc(PC_COUNT, "mpu6000_bad_transfers")),
 	_good_transfers(perf_alloc(PC_COUNT, "mpu6000_good_transfers")),
-	_accel_filter_x(MPU6000_ACCEL_DEFAULT_RATE, MPU6000_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_accel_filter_y(MPU6000_ACCEL_DEFAULT_RATE, MPU6000_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_accel_filter_z(MPU6000_ACCEL_DEFAULT_RATE, MPU6000_ACCEL_DEFAULT_DRIVER_FILTER_FREQ),
-	_gyro_filter_x(MPU6000_GYRO_DEFAULT_RATE, MPU6000_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
-	_gyro_filter_y(MPU6000_GYRO_DEFAULT_RATE, MPU6000_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
-	_gyro_filter_z(MPU6000_GYRO_DEFAULT_RATE, MPU6000_GYRO_DEFAULT_DRIVER_FILTER_FREQ),
-	_rotation(rotation)
+	_accel_filter(mpu6000_accel_default_filter),
+	_gyro_filter(mpu6000_gyro_default_filter),
+	_rotation(rotation),
+	_accel_int(0, false),
+	_gyro_int(0, true),
+	_use_fifo(false),
+	_fifo_buffer(nullptr),
+	_fifo_last_read(0),
+	_fifo_resets(perf_alloc(PC_COUNT, "mpu6000_fifo_resets")),
+	_measure_txn(),
+	_measure_report{},
+	_measure_time(0),
+	_measure_busy(perf_alloc(PC_COUNT, "mpu6000_async_busy")),
+	_drdy_active(false),
+	_drdy_seen(false),
+	_drdy_last_read(0),
+	_drdy_timeouts(perf_alloc(PC_COUNT, "mpu6000_drdy_timeouts"))
 {
 	// disable debug() calls
 	_debug_enabled = false;
@@ -441,6 +627,10 @@ MPU6000::~MPU6000()
 	/* make sure we are truly inactive */
 	stop();
 
+	/* let a queued read complete, it refers to us */
+	while (_measure_txn.queued)
+		usleep(100);
+
 	/* delete the gyro subdriver */
 	delete _gyro;
 
@@ -459,6 +649,22 @@ MPU6000::~MPU6000()
 	perf_free(_gyro_reads);
 	perf_free(_bad_transfers);
 	perf_free(_good_transfers);
+	perf_free(_fifo_resets);
+	perf_free(_measure_busy);
+	perf_free(_drdy_timeouts);
+
+	delete[] _fifo_buffer;
+}
+
+int
+MPU6000::enable_fifo(unsigned rate)
+{
+	if (rate < 1 || rate > MPU6000_FIFO_MAX_RATE)
+		return -EINVAL;
+
+	_use_fifo = true;
+	_sample_rate = rate;
+	return OK;
 }
 
 int
@@ -475,14 +681,29 @@ MPU6000::init()
 		return ret;
 	}
 
-	/* allocate basic report buffers */
-	_accel_reports = new RingBuffer(2, sizeof(accel_report));
-	if (_accel_reports == nullptr)
-		goto out;
+	{
+		/* in FIFO mode the buffers hold all samples of a burst */
+		unsigned depth = 2;
+
+		if (_use_fifo) {
+			_fifo_buffer = new uint8_t[1 + MPU6000_FIFO_MAX_SAMPLES * MPU6000_FIFO_SAMPLE_SIZE];
+			if (_fifo_buffer == nullptr)
+				goto out;
+
+			depth = _sample_rate * MPU6000_FIFO_MAX_INTERVAL / 1000000 + 1;
+			if (depth < 2)
+				depth = 2;
+		}
+
+		/* allocate basic report buffers */
+		_accel_reports = new RingBuffer(depth, sizeof(accel_report));
+		if (_accel_reports == nullptr)
+			goto out;
 
-	_gyro_reports = new RingBuffer(2, sizeof(gyro_report));
-	if (_gyro_reports == nullptr)
-		goto out;
+		_gyro_reports = new RingBuffer(depth, sizeof(gyro_report));
+		if (_gyro_reports == nullptr)
+			goto out;
+	}
 
 	reset();
 
@@ -517,23 +738,8 @@ MPU6000::init()
 	struct accel_report arp;
 	_accel_reports->get(&arp);
 
-	/* measurement will have generated a report, publish */
-	switch (_accel_class_instance) {
-		case CLASS_DEVICE_PRIMARY:
-			_accel_orb_id = ORB_ID(sensor_accel0);
-			break;
-		
-		case CLASS_DEVICE_SECONDARY:
-			_accel_orb_id = ORB_ID(sensor_accel1);
-			break;
-
-		case CLASS_DEVICE_TERTIARY:
-			_accel_orb_id = ORB_ID(sensor_accel2);
-			break;
-
-	}
-
-	_accel_topic = orb_advertise(_accel_orb_id, &arp);
+	/* queued, so loggers can pick up every sample at the full rate */
+	_accel_topic = orb_advertise_multi_queue(_accel_orb_id, &arp, nullptr, ORB_MAX_QUEUE_SIZE);
 
 	if (_accel_topic < 0) {
 		warnx("ADVERT FAIL");
@@ -544,22 +750,7 @@ MPU6000::init()
 	struct gyro_report grp;
 	_gyro_reports->get(&grp);
 
-	switch (_gyro->_gyro_class_instance) {
-		case CLASS_DEVICE_PRIMARY:
-			_gyro->_gyro_orb_id = ORB_ID(sensor_gyro0);
-			break;
-
-		case CLASS_DEVICE_SECONDARY:
-			_gyro->_gyro_orb_id = ORB_ID(sensor_gyro1);
-			break;
-
-		case CLASS_DEVICE_TERTIARY:
-			_gyro->_gyro_orb_id = ORB_ID(sensor_gyro2);
-			break;
-
-	}
-
-	_gyro->_gyro_topic = orb_advertise(_gyro->_gyro_orb_id, &grp);
+	_gyro->_gyro_topic = orb_advertise_multi_queue(_gyro->_gyro_orb_id, &grp, nullptr, ORB_MAX_QUEUE_SIZE);
 
 	if (_gyro->_gyro_topic < 0) {
 		warnx("ADVERT FAIL");
@@ -658,6 +849,18 @@ void MPU6000::reset()
 	// write_reg(MPUREG_PWR_MGMT_1,MPU_CLK_SEL_PLLGYROZ);
 	usleep(1000);
 
+	if (_use_fifo) {
+		write_reg(MPUREG_FIFO_EN, BITS_FIFO_EN_ACCEL | BITS_FIFO_EN_TEMP | BITS_FIFO_EN_GYRO);
+		fifo_reset();
+	}
+}
+
+void
+MPU6000::fifo_reset()
+{
+	write_reg(MPUREG_USER_CTRL, BIT_I2C_IF_DIS | BIT_USER_CTRL_FIFO_RESET);
+	write_reg(MPUREG_USER_CTRL, BIT_I2C_IF_DIS | BIT_USER_CTRL_FIFO_EN);
+	_fifo_last_read = 0;
 }
 
 int
@@ -695,11 +898,18 @@ MPU6000::probe()
 void
 MPU6000::_set_sample_rate(uint16_t desired_sample_rate_hz)
 {
-  uint8_t div = 1000 / desired_sample_rate_hz;
+  // without the DLPF the gyro outputs 8 kHz, only useful through the FIFO
+  uint16_t base = (_use_fifo && desired_sample_rate_hz > 1000) ? 8000 : 1000;
+  uint8_t div = base / desired_sample_rate_hz;
   if(div>200) div=200;
   if(div<1) div=1;
   write_reg(MPUREG_SMPLRT_DIV, div-1);
-  _sample_rate = 1000 / div;
+  _sample_rate = base / div;
+
+  if (_use_fifo) {
+	  // the DLPF setting selects between the two gyro output rates
+	  _set_dlpf_filter(_accel_filter.get_cutoff_freq());
+  }
 }
 
 /*
@@ -732,6 +942,12 @@ MPU6000::_set_dlpf_filter(uint16_t frequency_hz)
 	} else {
 		filter = BITS_DLPF_CFG_2100HZ_NOLPF;
 	}
+
+	/* sampling above 1 kHz needs the 8 kHz gyro output */
+	if (_use_fifo && _sample_rate > 1000) {
+		filter = BITS_DLPF_CFG_256HZ_NOLPF2;
+	}
+
 	write_reg(MPUREG_CONFIG, filter);
 }
 
@@ -757,14 +973,7 @@ MPU6000::read(struct file *filp, char *buffer, size_t buflen)
 	perf_count(_accel_reads);
 
 	/* copy reports out of our buffer to the caller */
-	accel_report *arp = reinterpret_cast<accel_report *>(buffer);
-	int transferred = 0;
-	while (count--) {
-		if (!_accel_reports->get(arp))
-			break;
-		transferred++;
-		arp++;
-	}
+	unsigned transferred = _accel_reports->get_multiple(buffer, count);
 
 	/* return the number of bytes transferred */
 	return (transferred * sizeof(accel_report));
@@ -853,14 +1062,7 @@ MPU6000::gyro_read(struct file *filp, char *buffer, size_t buflen)
 	perf_count(_gyro_reads);
 
 	/* copy reports out of our buffer to the caller */
-	gyro_report *grp = reinterpret_cast<gyro_report *>(buffer);
-	int transferred = 0;
-	while (count--) {
-		if (!_gyro_reports->get(grp))
-			break;
-		transferred++;
-		grp++;
-	}
+	unsigned transferred = _gyro_reports->get_multiple(buffer, count);
 
 	/* return the number of bytes transferred */
 	return (transferred * sizeof(gyro_report));
@@ -910,24 +1112,25 @@ MPU6000::ioctl(struct file *filp, int cmd, unsigned long arg)
 					if (ticks < 1000)
 						return -EINVAL;
 
+					/* drain the FIFO before it can overflow */
+					if (_use_fifo && ticks > MPU6000_FIFO_MAX_INTERVAL)
+						ticks = MPU6000_FIFO_MAX_INTERVAL;
+
 					// adjust filters
-					float cutoff_freq_hz = _accel_filter_x.get_cutoff_freq();
-					float sample_rate = 1.0e6f/ticks;
+					float cutoff_freq_hz = _accel_filter.get_cutoff_freq();
+					float sample_rate = _use_fifo ? _sample_rate : 1.0e6f/ticks;
 					_set_dlpf_filter(cutoff_freq_hz);
-					_accel_filter_x.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
-					_accel_filter_y.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
-					_accel_filter_z.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
+					_accel_filter.set_cutoff_frequency(sample_rate, cutoff_freq_hz);
 
 
-					float cutoff_freq_hz_gyro = _gyro_filter_x.get_cutoff_freq();
+					float cutoff_freq_hz_gyro = _gyro_filter.get_cutoff_freq();
 					_set_dlpf_filter(cutoff_freq_hz_gyro);
-					_gyro_filter_x.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
-					_gyro_filter_y.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
-					_gyro_filter_z.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
+					_gyro_filter.set_cutoff_frequency(sample_rate, cutoff_freq_hz_gyro);
 
 					/* update interval for next measurement */
 					/* XXX this is a bit shady, but no other way to adjust... */
-					_call.period = _call_interval = ticks;
+					_call_interval = ticks;
+					_call.period = _drdy_active ? ticks * MPU6000_DRDY_WATCHDOG_FACTOR : ticks;
 
 					/* if we need to start the poll state machine, do it */
 					if (want_start)
@@ -970,15 +1173,13 @@ MPU6000::ioctl(struct file *filp, int cmd, unsigned long arg)
 		return OK;
 
 	case ACCELIOCGLOWPASS:
-		return _accel_filter_x.get_cutoff_freq();
+		return _accel_filter.get_cutoff_freq();
 
 	case ACCELIOCSLOWPASS:
 		// set hardware filtering
 		_set_dlpf_filter(arg);
 		// set software filtering
-		_accel_filter_x.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_accel_filter_y.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_accel_filter_z.set_cutoff_frequency(1.0e6f / _call_interval, arg);
+		_accel_filter.set_cutoff_frequency(filter_rate(), arg);
 		return OK;
 
 	case ACCELIOCSSCALE:
@@ -1011,6 +1212,13 @@ MPU6000::ioctl(struct file *filp, int cmd, unsigned long arg)
 	case ACCELIOCSELFTEST:
 		return accel_self_test();
 
+	case SENSORIOCSINTEGRATION:
+		_accel_int.set_autoreset_interval(arg);
+		return OK;
+
+	case SENSORIOCGINTEGRATION:
+		return _accel_int.get_autoreset_interval();
+
 	default:
 		/* give it to the superclass */
 		return SPI::ioctl(filp, cmd, arg);
@@ -1053,14 +1261,19 @@ MPU6000::gyro_ioctl(struct file *filp, int cmd, unsigned long arg)
 		_set_sample_rate(arg);
 		return OK;
 
+	case SENSORIOCSINTEGRATION:
+		_gyro_int.set_autoreset_interval(arg);
+		return OK;
+
+	case SENSORIOCGINTEGRATION:
+		return _gyro_int.get_autoreset_interval();
+
 	case GYROIOCGLOWPASS:
-		return _gyro_filter_x.get_cutoff_freq();
+		return _gyro_filter.get_cutoff_freq();
 	case GYROIOCSLOWPASS:
 		// set hardware filtering
 		_set_dlpf_filter(arg);
-		_gyro_filter_x.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_gyro_filter_y.set_cutoff_frequency(1.0e6f / _call_interval, arg);
-		_gyro_filter_z.set_cutoff_frequency(1.0e6f / _call_interval, arg);
+		_gyro_filter.set_cutoff_frequency(filter_rate(), arg);
 		return OK;
 
 	case GYROIOCSSCALE:
@@ -1193,15 +1406,82 @@ MPU6000::start()
 	/* discard any stale data in the buffers */
 	_accel_reports->flush();
 	_gyro_reports->flush();
+	_accel_int.reset();
+	_gyro_int.reset();
+
+	/* with data ready interrupts the hrt_call is only a watchdog */
+	unsigned interval = _call_interval;
+
+	if (drdy_start())
+		interval *= MPU6000_DRDY_WATCHDOG_FACTOR;
 
 	/* start polling at the specified rate */
-	hrt_call_every(&_call, 1000, _call_interval, (hrt_callout)&MPU6000::measure_trampoline, this);
+	hrt_call_every(&_call, 1000, interval, (hrt_callout)&MPU6000::measure_trampoline, this);
 }
 
 void
 MPU6000::stop()
 {
 	hrt_cancel(&_call);
+	drdy_stop();
+}
+
+MPU6000 *MPU6000::_drdy_dev = nullptr;
+
+bool
+MPU6000::drdy_start()
+{
+#if MPU6000_USE_DRDY
+	/* the FIFO has its own sample timing */
+	if (_bus != PX4_SPI_BUS_SENSORS || _use_fifo)
+		return false;
+
+	_drdy_seen = false;
+	_drdy_last_read = 0;
+	_drdy_dev = this;
+	_drdy_active = true;
+
+	stm32_gpiosetevent(GPIO_EXTI_MPU_DRDY, true, false, true, &MPU6000::drdy_interrupt);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void
+MPU6000::drdy_stop()
+{
+#if MPU6000_USE_DRDY
+
+	if (_drdy_active) {
+		stm32_gpiosetevent(GPIO_EXTI_MPU_DRDY, false, false, false, nullptr);
+		_drdy_active = false;
+		_drdy_dev = nullptr;
+	}
+
+#endif
+}
+
+int
+MPU6000::drdy_interrupt(int irq, void *context)
+{
+	/* stamp first, this is the time the sample was taken */
+	hrt_abstime now = hrt_absolute_time();
+	MPU6000 *dev = _drdy_dev;
+
+	if (dev == nullptr)
+		return OK;
+
+	dev->_drdy_seen = true;
+
+	/* decimate the sensor rate to the poll rate, within half a sample */
+	if (now - dev->_drdy_last_read + 500000 / dev->_sample_rate < dev->_call_interval)
+		return OK;
+
+	dev->_drdy_last_read = now;
+	dev->sample(now);
+
+	return OK;
 }
 
 void
@@ -1209,40 +1489,85 @@ MPU6000::measure_trampoline(void *arg)
 {
 	MPU6000 *dev = reinterpret_cast<MPU6000 *>(arg);
 
-	/* make another measurement */
-	dev->measure();
+	if (dev->_drdy_active) {
+		/* the interrupt is alive, nothing to do */
+		if (dev->_drdy_seen) {
+			dev->_drdy_seen = false;
+			return;
+		}
+
+		/* the line is stuck, go back to polling at the full rate */
+		perf_count(dev->_drdy_timeouts);
+		dev->drdy_stop();
+		dev->_call.period = dev->_call_interval;
+	}
+
+	dev->sample(0);
 }
 
 void
-MPU6000::measure()
+MPU6000::sample(hrt_abstime timestamp)
 {
-#pragma pack(push, 1)
-	/**
-	 * Report conversation within the MPU6000, including command byte and
-	 * interrupt status.
-	 */
-	struct MPUReport {
-		uint8_t		cmd;
-		uint8_t		status;
-		uint8_t		accel_x[2];
-		uint8_t		accel_y[2];
-		uint8_t		accel_z[2];
-		uint8_t		temp[2];
-		uint8_t		gyro_x[2];
-		uint8_t		gyro_y[2];
-		uint8_t		gyro_z[2];
-	} mpu_report;
-#pragma pack(pop)
+	/* make another measurement, without holding the bus if we can */
+	int ret = measure_async(timestamp);
 
-	struct Report {
-		int16_t		accel_x;
-		int16_t		accel_y;
-		int16_t		accel_z;
-		int16_t		temp;
-		int16_t		gyro_x;
-		int16_t		gyro_y;
-		int16_t		gyro_z;
-	} report;
+	if (ret == -EBUSY) {
+		/* the previous read is still queued, skip this one */
+		perf_count(_measure_busy);
+
+	} else if (ret != OK) {
+		measure(timestamp);
+	}
+}
+
+int
+MPU6000::measure_async(hrt_abstime timestamp)
+{
+	/* the FIFO is read in two steps */
+	if (_use_fifo)
+		return -ENOTSUP;
+
+	/* start measuring, ends on completion */
+	perf_begin(_sample_perf);
+
+	_measure_report.cmd = DIR_READ | MPUREG_INT_STATUS;
+	_measure_time = timestamp;
+
+        // sensor transfer at high clock speed
+        set_frequency(MPU6000_HIGH_BUS_SPEED);
+
+	int ret = transfer_async(&_measure_txn, (uint8_t *)&_measure_report, (uint8_t *)&_measure_report,
+				 sizeof(_measure_report), &MPU6000::measure_async_complete, this);
+
+	if (ret != OK)
+		perf_cancel(_sample_perf);
+
+	return ret;
+}
+
+void
+MPU6000::measure_async_complete(void *arg, int result)
+{
+	MPU6000 *dev = reinterpret_cast<MPU6000 *>(arg);
+
+	if (result != OK) {
+		perf_count(dev->_bad_transfers);
+		perf_cancel(dev->_sample_perf);
+		return;
+	}
+
+	dev->process_report(dev->_measure_report, dev->_measure_time);
+}
+
+void
+MPU6000::measure(hrt_abstime timestamp)
+{
+	MPUReport mpu_report;
+
+	if (_use_fifo) {
+		measure_fifo();
+		return;
+	}
 
 	/* start measuring */
 	perf_begin(_sample_perf);
@@ -1258,6 +1583,14 @@ MPU6000::measure()
 	if (OK != transfer((uint8_t *)&mpu_report, ((uint8_t *)&mpu_report), sizeof(mpu_report)))
 		return;
 
+	process_report(mpu_report, timestamp);
+}
+
+void
+MPU6000::process_report(MPUReport &mpu_report, hrt_abstime timestamp)
+{
+	Report report;
+
 	/*
 	 * Convert from big to little endian
 	 */
@@ -1272,6 +1605,135 @@ MPU6000::measure()
 	report.gyro_y = int16_t_from_bytes(mpu_report.gyro_y);
 	report.gyro_z = int16_t_from_bytes(mpu_report.gyro_z);
 
+	/*
+	 * Report buffers.
+	 */
+	accel_report		arb;
+	gyro_report		grb;
+
+	/* without a data ready time the best guess is now */
+	if (timestamp == 0)
+		timestamp = hrt_absolute_time();
+
+	if (!convert_report(report, timestamp, arb, grb, true)) {
+		perf_end(_sample_perf);
+                // note that we don't call reset() here as a reset()
+                // costs 20ms with interrupts disabled. That means if
+                // the mpu6k does go bad it would cause a FMU failure,
+                // regardless of whether another sensor is available,
+		return;
+	}
+
+	_accel_reports->force(&arb);
+	_gyro_reports->force(&grb);
+
+	publish_reports(arb, grb);
+
+	/* stop measuring */
+	perf_end(_sample_perf);
+}
+
+void
+MPU6000::measure_fifo()
+{
+#pragma pack(push, 1)
+	/**
+	 * One sample as queued in the FIFO.
+	 */
+	struct MPUFIFOSample {
+		uint8_t		accel_x[2];
+		uint8_t		accel_y[2];
+		uint8_t		accel_z[2];
+		uint8_t		temp[2];
+		uint8_t		gyro_x[2];
+		uint8_t		gyro_y[2];
+		uint8_t		gyro_z[2];
+	};
+#pragma pack(pop)
+
+	/* start measuring */
+	perf_begin(_sample_perf);
+
+	hrt_abstime now = hrt_absolute_time();
+	unsigned bytes = read_reg16(MPUREG_FIFO_COUNTH);
+
+	/* the FIFO overflowed, sample boundaries are lost */
+	if (bytes >= MPU6000_FIFO_SIZE) {
+		perf_count(_fifo_resets);
+		fifo_reset();
+		perf_end(_sample_perf);
+		return;
+	}
+
+	/* only read complete samples, the rest is picked up next time */
+	unsigned samples = bytes / MPU6000_FIFO_SAMPLE_SIZE;
+
+	if (samples == 0) {
+		perf_end(_sample_perf);
+		return;
+	}
+
+	_fifo_buffer[0] = DIR_READ | MPUREG_FIFO_R_W;
+
+        // sensor transfer at high clock speed
+        set_frequency(MPU6000_HIGH_BUS_SPEED);
+
+	if (OK != transfer(_fifo_buffer, _fifo_buffer, 1 + samples * MPU6000_FIFO_SAMPLE_SIZE)) {
+		perf_end(_sample_perf);
+		return;
+	}
+
+	/*
+	 * The newest sample was taken about now, spread the others over
+	 * the time since the previous burst. Fall back to the nominal
+	 * sample interval after a reset or when the spacing is implausible.
+	 */
+	float interval = 1.0e6f / _sample_rate;
+
+	if (_fifo_last_read != 0) {
+		float measured = (float)(now - _fifo_last_read) / samples;
+
+		if (measured > 0.5f * interval && measured < 2.0f * interval)
+			interval = measured;
+	}
+
+	_fifo_last_read = now;
+
+	accel_report		arb;
+	gyro_report		grb;
+
+	for (unsigned i = 0; i < samples; i++) {
+		MPUFIFOSample *sample = (MPUFIFOSample *)&_fifo_buffer[1 + i * MPU6000_FIFO_SAMPLE_SIZE];
+		Report report;
+
+		report.accel_x = int16_t_from_bytes(sample->accel_x);
+		report.accel_y = int16_t_from_bytes(sample->accel_y);
+		report.accel_z = int16_t_from_bytes(sample->accel_z);
+		report.temp = int16_t_from_bytes(sample->temp);
+		report.gyro_x = int16_t_from_bytes(sample->gyro_x);
+		report.gyro_y = int16_t_from_bytes(sample->gyro_y);
+		report.gyro_z = int16_t_from_bytes(sample->gyro_z);
+
+		hrt_abstime timestamp = now - (hrt_abstime)((samples - 1 - i) * interval);
+
+		/* without an integration interval the newest sample is published */
+		if (!convert_report(report, timestamp, arb, grb, i == samples - 1))
+			continue;
+
+		_accel_reports->force(&arb);
+		_gyro_reports->force(&grb);
+
+		/* readers get every sample from the buffers, the topics the integrals */
+		publish_reports(arb, grb);
+	}
+
+	/* stop measuring */
+	perf_end(_sample_perf);
+}
+
+bool
+MPU6000::convert_report(Report &report, hrt_abstime timestamp, accel_report &arb, gyro_report &grb, bool close)
+{
 	if (report.accel_x == 0 &&
 	    report.accel_y == 0 &&
 	    report.accel_z == 0 &&
@@ -1281,12 +1743,7 @@ MPU6000::measure()
 	    report.gyro_z == 0) {
 		// all zero data - probably a SPI bus error
 		perf_count(_bad_transfers);
-		perf_end(_sample_perf);
-                // note that we don't call reset() here as a reset()
-                // costs 20ms with interrupts disabled. That means if
-                // the mpu6k does go bad it would cause a FMU failure,
-                // regardless of whether another sensor is available,
-		return;
+		return false;
 	}
 
 	perf_count(_good_transfers);
@@ -1309,16 +1766,10 @@ MPU6000::measure()
 	report.gyro_x = gyro_xt;
 	report.gyro_y = gyro_yt;
 
-	/*
-	 * Report buffers.
-	 */
-	accel_report		arb;
-	gyro_report		grb;
-
 	/*
 	 * Adjust and scale results to m/s^2.
 	 */
-	grb.timestamp = arb.timestamp = hrt_absolute_time();
+	grb.timestamp = arb.timestamp = timestamp;
         grb.error_count = arb.error_count = 0; // not reported
 
 	/*
@@ -1346,10 +1797,13 @@ MPU6000::measure()
 	float x_in_new = ((report.accel_x * _accel_range_scale) - _accel_scale.x_offset) * _accel_scale.x_scale;
 	float y_in_new = ((report.accel_y * _accel_range_scale) - _accel_scale.y_offset) * _accel_scale.y_scale;
 	float z_in_new = ((report.accel_z * _accel_range_scale) - _accel_scale.z_offset) * _accel_scale.z_scale;
-	
-	arb.x = _accel_filter_x.apply(x_in_new);
-	arb.y = _accel_filter_y.apply(y_in_new);
-	arb.z = _accel_filter_z.apply(z_in_new);
+
+	float accel_in[3] = { x_in_new, y_in_new, z_in_new };
+	float accel_out[3];
+	_accel_filter.apply(accel_in, accel_out);
+	arb.x = accel_out[0];
+	arb.y = accel_out[1];
+	arb.z = accel_out[2];
 
 	// apply user specified rotation
 	rotate_3f(_rotation, arb.x, arb.y, arb.z);
@@ -1360,6 +1814,11 @@ MPU6000::measure()
 	arb.temperature_raw = report.temp;
 	arb.temperature = (report.temp) / 361.0f + 35.0f;
 
+	/* integrate the unfiltered values, the filters only add delay */
+	math::Vector<3> aval(x_in_new, y_in_new, z_in_new);
+	rotate_3f(_rotation, aval(0), aval(1), aval(2));
+	integrate(_accel_int, arb, aval, close);
+
 	grb.x_raw = report.gyro_x;
 	grb.y_raw = report.gyro_y;
 	grb.z_raw = report.gyro_z;
@@ -1367,10 +1826,13 @@ MPU6000::measure()
 	float x_gyro_in_new = ((report.gyro_x * _gyro_range_scale) - _gyro_scale.x_offset) * _gyro_scale.x_scale;
 	float y_gyro_in_new = ((report.gyro_y * _gyro_range_scale) - _gyro_scale.y_offset) * _gyro_scale.y_scale;
 	float z_gyro_in_new = ((report.gyro_z * _gyro_range_scale) - _gyro_scale.z_offset) * _gyro_scale.z_scale;
-	
-	grb.x = _gyro_filter_x.apply(x_gyro_in_new);
-	grb.y = _gyro_filter_y.apply(y_gyro_in_new);
-	grb.z = _gyro_filter_z.apply(z_gyro_in_new);
+
+	float gyro_in[3] = { x_gyro_in_new, y_gyro_in_new, z_gyro_in_new };
+	float gyro_out[3];
+	_gyro_filter.apply(gyro_in, gyro_out);
+	grb.x = gyro_out[0];
+	grb.y = gyro_out[1];
+	grb.z = gyro_out[2];
 
 	// apply user specified rotation
 	rotate_3f(_rotation, grb.x, grb.y, grb.z);
@@ -1381,25 +1843,61 @@ MPU6000::measure()
 	grb.temperature_raw = report.temp;
 	grb.temperature = (report.temp) / 361.0f + 35.0f;
 
-	_accel_reports->force(&arb);
-	_gyro_reports->force(&grb);
+	math::Vector<3> gval(x_gyro_in_new, y_gyro_in_new, z_gyro_in_new);
+	rotate_3f(_rotation, gval(0), gval(1), gval(2));
+	integrate(_gyro_int, grb, gval, close);
 
-	/* notify anyone waiting for data */
-	poll_notify(POLLIN);
-	_gyro->parent_poll_notify();
+	return true;
+}
+
+template <typename R>
+bool
+MPU6000::integrate(Integrator &integrator, R &r, math::Vector<3> &val, bool close)
+{
+	math::Vector<3> integral;
 
-	if (!(_pub_blocked)) {
-		/* publish it */
-		orb_publish(_accel_orb_id, _accel_topic, &arb);
+	r.integral_dt = 0;
+
+	bool closed = integrator.put(r.timestamp, val, integral, r.integral_dt);
+
+	if (!closed && close && integrator.get_autoreset_interval() == 0) {
+		integral = integrator.get(true, r.integral_dt);
+		closed = (r.integral_dt != 0);
 	}
 
-	if (!(_pub_blocked)) {
-		/* publish it */
-		orb_publish(_gyro->_gyro_orb_id, _gyro->_gyro_topic, &grb);
+	if (!closed) {
+		r.integral_dt = 0;
+		integral.zero();
 	}
 
-	/* stop measuring */
-	perf_end(_sample_perf);
+	r.x_integral = integral(0);
+	r.y_integral = integral(1);
+	r.z_integral = integral(2);
+
+	return closed;
+}
+
+void
+MPU6000::publish_reports(accel_report &arb, gyro_report &grb)
+{
+	if (arb.integral_dt != 0) {
+		/* notify anyone waiting for data */
+		poll_notify(POLLIN);
+
+		if (!(_pub_blocked)) {
+			/* publish it */
+			orb_publish(_accel_orb_id, _accel_topic, &arb);
+		}
+	}
+
+	if (grb.integral_dt != 0) {
+		_gyro->parent_poll_notify();
+
+		if (!(_pub_blocked)) {
+			/* publish it */
+			orb_publish(_gyro->_gyro_orb_id, _gyro->_gyro_topic, &grb);
+		}
+	}
 }
 
 void
@@ -1410,6 +1908,12 @@ MPU6000::print_info()
 	perf_print_counter(_gyro_reads);
 	perf_print_counter(_bad_transfers);
 	perf_print_counter(_good_transfers);
+	perf_print_counter(_fifo_resets);
+	perf_print_counter(_drdy_timeouts);
+	if (_drdy_active)
+		printf("data ready interrupt\n");
+	if (_use_fifo)
+		printf("fifo mode, %u Hz\n", _sample_rate);
 	_accel_reports->print_info("accel queue");
 	_gyro_reports->print_info("gyro queue");
 }
@@ -1418,7 +1922,7 @@ MPU6000_gyro::MPU6000_gyro(MPU6000 *parent, const char *path) :
 	CDev("MPU6000_gyro", path),
 	_parent(parent),
 	_gyro_topic(-1),
-	_gyro_orb_id(nullptr),
+	_gyro_orb_id(ORB_ID(sensor_gyro)),
 	_gyro_class_instance(-1)
 {
 }
@@ -1475,7 +1979,7 @@ namespace mpu6000
 MPU6000	*g_dev_int; // on internal bus
 MPU6000	*g_dev_ext; // on external bus
 
-void	start(bool, enum Rotation);
+void	start(bool, enum Rotation, unsigned);
 void	test(bool);
 void	reset(bool);
 void	info(bool);
@@ -1488,7 +1992,7 @@ void	usage();
  * or failed to detect the sensor.
  */
 void
-start(bool external_bus, enum Rotation rotation)
+start(bool external_bus, enum Rotation rotation, unsigned fifo_rate)
 {
 	int fd;
         MPU6000 **g_dev_ptr = external_bus?&g_dev_ext:&g_dev_int;
@@ -1513,6 +2017,9 @@ start(bool external_bus, enum Rotation rotation)
 	if (*g_dev_ptr == nullptr)
 		goto fail;
 
+	if (fifo_rate != 0 && OK != (*g_dev_ptr)->enable_fifo(fifo_rate))
+		goto fail;
+
 	if (OK != (*g_dev_ptr)->init())
 		goto fail;
 
@@ -1661,6 +2168,7 @@ usage()
 	warnx("options:");
 	warnx("    -X    (external bus)");
 	warnx("    -R rotation");
+	warnx("    -F rate (sample through the FIFO at up to 8000 Hz)");
 }
 
 } // namespace
@@ -1671,9 +2179,10 @@ mpu6000_main(int argc, char *argv[])
 	bool external_bus = false;
 	int ch;
 	enum Rotation rotation = ROTATION_NONE;
+	unsigned fifo_rate = 0;
 
 	/* jump over start/off/etc and look at options first */
-	while ((ch = getopt(argc, argv, "XR:")) != EOF) {
+	while ((ch = getopt(argc, argv, "XR:F:")) != EOF) {
 		switch (ch) {
 		case 'X':
 			external_bus = true;
@@ -1681,6 +2190,9 @@ mpu6000_main(int argc, char *argv[])
 		case 'R':
 			rotation = (enum Rotation)atoi(optarg);
 			break;
+		case 'F':
+			fifo_rate = atoi(optarg);
+			break;
 		default:
 			mpu6000::usage();
 			exit(0);
@@ -1694,7 +2206,7 @@ mpu6000_main(int argc, char *argv[])
 
 	 */
 	if (!strcmp(verb, "start"))
-		mpu6000::start(external_bus, rotation);
+		mpu6000::start(external_bus, rotation, fifo_rate);
 
 	/*
 	 * Test the driver/device.
@@ -63,6 +63,7 @@
 #include <drivers/drv_hrt.h>
 #include <drivers/device/ringbuffer.h>
 
+#include <systemlib/work_profile.h>
 #include <systemlib/perf_counter.h>
 #include <systemlib/err.h>
 
@@ -91,6 +92,7 @@ static const int ERROR = -1;
 /* internal conversion time: 9.17 ms, so should not be read at rates higher than 100 Hz */
 #define MS5611_CONVERSION_INTERVAL	10000	/* microseconds */
 #define MS5611_MEASUREMENT_RATIO	3	/* pressure measurements per temperature measurement */
+#define MS5611_MEASUREMENT_RATIO_MAX	50	/* temperature must not get too stale */
 #define MS5611_BARO_DEVICE_PATH		"/dev/ms5611"
 
 class MS5611 : public device::CDev
@@ -109,6 +111,16 @@ public:
 	 */
 	void			print_info();
 
+	/**
+	 * Start the next conversion right after each collection, regardless
+	 * of the poll rate, and measure temperature only every ratio
+	 * pressure samples. Must be called before init().
+	 *
+	 * @param ratio		Pressure measurements per temperature measurement.
+	 * @return		OK, or -EINVAL if the ratio is not supported.
+	 */
+	int			enable_pipeline(unsigned ratio);
+
 protected:
 	Device			*_interface;
 
@@ -121,6 +133,8 @@ protected:
 
 	bool			_collect_phase;
 	unsigned		_measure_phase;
+	unsigned		_measure_ratio;
+	bool			_pipelined;
 
 	/* intermediate temperature values per MS5611 datasheet */
 	int32_t			_TEMP;
@@ -203,6 +217,8 @@ MS5611::MS5611(device::Device *interface, ms5611::prom_u &prom_buf) :
 	_reports(nullptr),
 	_collect_phase(false),
 	_measure_phase(0),
+	_measure_ratio(MS5611_MEASUREMENT_RATIO),
+	_pipelined(false),
 	_TEMP(0),
 	_OFF(0),
 	_SENS(0),
@@ -501,6 +517,17 @@ MS5611::ioctl(struct file *filp, int cmd, unsigned long arg)
 	return CDev::ioctl(filp, cmd, arg);
 }
 
+int
+MS5611::enable_pipeline(unsigned ratio)
+{
+	if (ratio < 1 || ratio > MS5611_MEASUREMENT_RATIO_MAX)
+		return -EINVAL;
+
+	_pipelined = true;
+	_measure_ratio = ratio;
+	return OK;
+}
+
 void
 MS5611::start_cycle()
 {
@@ -511,7 +538,7 @@ MS5611::start_cycle()
 	_reports->flush();
 
 	/* schedule a cycle to start things */
-	work_queue(HPWORK, &_work, (worker_t)&MS5611::cycle_trampoline, this, 1);
+	work_queue_profiled(HPWORK, &_work, (worker_t)&MS5611::cycle_trampoline, this, 1, "ms5611");
 }
 
 void
@@ -563,16 +590,18 @@ MS5611::cycle()
 		 * Is there a collect->measure gap?
 		 * Don't inject one after temperature measurements, so we can keep
 		 * doing pressure measurements at something close to the desired rate.
+		 * Pipelined, the sensor is always converting.
 		 */
-		if ((_measure_phase != 0) &&
+		if (!_pipelined && (_measure_phase != 0) &&
 		    (_measure_ticks > USEC2TICK(MS5611_CONVERSION_INTERVAL))) {
 
 			/* schedule a fresh cycle call when we are ready to measure again */
-			work_queue(HPWORK,
-				   &_work,
-				   (worker_t)&MS5611::cycle_trampoline,
-				   this,
-				   _measure_ticks - USEC2TICK(MS5611_CONVERSION_INTERVAL));
+			work_queue_profiled(HPWORK,
+				            &_work,
+				            (worker_t)&MS5611::cycle_trampoline,
+				            this,
+				            _measure_ticks - USEC2TICK(MS5611_CONVERSION_INTERVAL),
+				            "ms5611");
 
 			return;
 		}
@@ -593,11 +622,12 @@ MS5611::cycle()
 	_collect_phase = true;
 
 	/* schedule a fresh cycle call when the measurement is done */
-	work_queue(HPWORK,
-		   &_work,
-		   (worker_t)&MS5611::cycle_trampoline,
-		   this,
-		   USEC2TICK(MS5611_CONVERSION_INTERVAL));
+	work_queue_profiled(HPWORK,
+		            &_work,
+		            (worker_t)&MS5611::cycle_trampoline,
+		            this,
+		            USEC2TICK(MS5611_CONVERSION_INTERVAL),
+		            "ms5611");
 }
 
 int
@@ -749,7 +779,7 @@ MS5611::collect()
 	}
 
 	/* update the measurement state machine */
-	INCREMENT(_measure_phase, MS5611_MEASUREMENT_RATIO + 1);
+	INCREMENT(_measure_phase, _measure_ratio + 1);
 
 	perf_end(_sample_perf);
 
@@ -763,6 +793,8 @@ MS5611::print_info()
 	perf_print_counter(_comms_errors);
 	perf_print_counter(_buffer_overflows);
 	printf("poll interval:  %u ticks\n", _measure_ticks);
+	if (_pipelined)
+		printf("pipelined, %u pressure per temperature\n", _measure_ratio);
 	_reports->print_info("report queue");
 	printf("TEMP:           %d\n", _TEMP);
 	printf("SENS:           %lld\n", _SENS);
@@ -789,7 +821,7 @@ namespace ms5611
 
 MS5611	*g_dev;
 
-void	start(bool external_bus);
+void	start(bool external_bus, unsigned pipeline_ratio);
 void	test();
 void	reset();
 void	info();
@@ -847,7 +879,7 @@ crc4(uint16_t *n_prom)
  * Start the driver.
  */
 void
-start(bool external_bus)
+start(bool external_bus, unsigned pipeline_ratio)
 {
 	int fd;
 	prom_u prom_buf;
@@ -877,6 +909,10 @@ start(bool external_bus)
 		delete interface;
 		errx(1, "failed to allocate driver");
 	}
+	if (pipeline_ratio != 0 && g_dev->enable_pipeline(pipeline_ratio) != OK) {
+		warnx("unsupported pipeline ratio %u", pipeline_ratio);
+		goto fail;
+	}
 	if (g_dev->init() != OK)
 		goto fail;
 
@@ -1077,6 +1113,7 @@ usage()
 	warnx("missing command: try 'start', 'info', 'test', 'test2', 'reset', 'calibrate'");
 	warnx("options:");
 	warnx("    -X    (external bus)");
+	warnx("    -P ratio  (pipelined, pressure measurements per temperature)");
 }
 
 } // namespace
@@ -1085,14 +1122,18 @@ int
 ms5611_main(int argc, char *argv[])
 {
 	bool external_bus = false;
+	unsigned pipeline_ratio = 0;
 	int ch;
 
 	/* jump over start/off/etc and look at options first */
-	while ((ch = getopt(argc, argv, "X")) != EOF) {
+	while ((ch = getopt(argc, argv, "XP:")) != EOF) {
 		switch (ch) {
 		case 'X':
 			external_bus = true;
 			break;
+		case 'P':
+			pipeline_ratio = strtoul(optarg, nullptr, 10);
+			break;
 		default:
 			ms5611::usage();
 			exit(0);
@@ -1105,7 +1146,7 @@ ms5611_main(int argc, char *argv[])
 	 * Start/load the driver.
 	 */
 	if (!strcmp(verb, "start"))
-		ms5611::start(external_bus);
+		ms5611::start(external_bus, pipeline_ratio);
 
 	/*
 	 * Test the driver/device.
@@ -57,6 +57,7 @@
 
 #include <nuttx/wqueue.h>
 
+#include <systemlib/work_profile.h>
 #include <systemlib/perf_counter.h>
 #include <systemlib/err.h>
 #include <systemlib/systemlib.h>
@@ -323,7 +324,7 @@ PCA8574::led()
 
 	// re-queue ourselves to run again later
 	_running = true;
-	work_queue(LPWORK, &_work, (worker_t)&PCA8574::led_trampoline, this, _led_interval);
+	work_queue_profiled(LPWORK, &_work, (worker_t)&PCA8574::led_trampoline, this, _led_interval, "pca8574");
 }
 
 /**
@@ -349,7 +350,7 @@ PCA8574::send_led_values()
 	// if not active, kick it
 	if (!_running) {
 		_running = true;
-		work_queue(LPWORK, &_work, (worker_t)&PCA8574::led_trampoline, this, 1);
+		work_queue_profiled(LPWORK, &_work, (worker_t)&PCA8574::led_trampoline, this, 1, "pca8574");
 	}
 
 	return 0;
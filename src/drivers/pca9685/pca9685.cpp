@@ -64,6 +64,7 @@
 #include <nuttx/wqueue.h>
 #include <nuttx/clock.h>
 
+#include <systemlib/work_profile.h>
 #include <systemlib/perf_counter.h>
 #include <systemlib/err.h>
 #include <systemlib/systemlib.h>
@@ -258,7 +259,7 @@ PCA9685::ioctl(struct file *filp, int cmd, unsigned long arg)
 		// if not active, kick it
 		if (!_running) {
 			_running = true;
-			work_queue(LPWORK, &_work, (worker_t)&PCA9685::i2cpwm_trampoline, this, 1);
+			work_queue_profiled(LPWORK, &_work, (worker_t)&PCA9685::i2cpwm_trampoline, this, 1, "pca9685");
 		}
 
 
@@ -349,7 +350,7 @@ PCA9685::i2cpwm()
 
 	// re-queue ourselves to run again later
 	_running = true;
-	work_queue(LPWORK, &_work, (worker_t)&PCA9685::i2cpwm_trampoline, this, _i2cpwm_interval);
+	work_queue_profiled(LPWORK, &_work, (worker_t)&PCA9685::i2cpwm_trampoline, this, _i2cpwm_interval, "pca9685");
 }
 
 int
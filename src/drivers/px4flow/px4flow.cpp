@@ -59,10 +59,12 @@
 #include <nuttx/wqueue.h>
 #include <nuttx/clock.h>
 
+#include <systemlib/work_profile.h>
 #include <systemlib/perf_counter.h>
 #include <systemlib/err.h>
 
 #include <drivers/drv_hrt.h>
+#include <drivers/drv_gyro.h>
 #include <drivers/drv_px4flow.h>
 #include <drivers/device/ringbuffer.h>
 
@@ -139,6 +141,10 @@ private:
 
 	orb_advert_t		_px4flow_topic;
 
+	int			_gyro_sub;		///< queued gyro samples, integrated over each flow frame
+	hrt_abstime		_frame_time;		///< time the last flow frame was read
+	hrt_abstime		_gyro_time;		///< time of the last gyro sample consumed
+
 	perf_counter_t		_sample_perf;
 	perf_counter_t		_comms_errors;
 	perf_counter_t		_buffer_overflows;
@@ -172,6 +178,18 @@ private:
 	void				cycle();
 	int					measure();
 	int					collect();
+
+	/**
+	* Integrate the gyro samples since the previous flow frame into the report.
+	*
+	* The window of a frame runs from the previous read to this one, the
+	* window the raw flow is accumulated over, so the body rotation can be
+	* taken out of the flow with no attitude estimate involved.
+	*
+	* @param frame_time	Time the frame was read.
+	* @param report		Report to fill the integration fields of.
+	*/
+	void				integrate_gyro(hrt_abstime frame_time, struct optical_flow_s &report);
 	/**
 	* Static trampoline from the workq context; because we don't have a
 	* generic workq wrapper yet.
@@ -195,6 +213,9 @@ PX4FLOW::PX4FLOW(int bus, int address) :
 	_measure_ticks(0),
 	_collect_phase(false),
 	_px4flow_topic(-1),
+	_gyro_sub(-1),
+	_frame_time(0),
+	_gyro_time(0),
 	_sample_perf(perf_alloc(PC_ELAPSED, "px4flow_read")),
 	_comms_errors(perf_alloc(PC_COUNT, "px4flow_comms_errors")),
 	_buffer_overflows(perf_alloc(PC_COUNT, "px4flow_buffer_overflows"))
@@ -211,6 +232,10 @@ PX4FLOW::~PX4FLOW()
 	/* make sure we are truly inactive */
 	stop();
 
+	if (_gyro_sub >= 0) {
+		::close(_gyro_sub);
+	}
+
 	/* free any existing reports */
 	if (_reports != nullptr) {
 		delete _reports;
@@ -243,6 +268,8 @@ PX4FLOW::init()
 		debug("failed to create px4flow object. Did you start uOrb?");
 	}
 
+	_gyro_sub = orb_subscribe(ORB_ID(sensor_gyro));
+
 	ret = OK;
 	/* sensor is ok, but we don't really know if it is within range */
 	_sensor_ok = true;
@@ -497,6 +524,9 @@ PX4FLOW::collect()
 	report.quality =  val[10];
 	report.sensor_id = 0;
 	report.timestamp = hrt_absolute_time();
+	report.flow_timestamp = report.timestamp;
+
+	integrate_gyro(report.timestamp, report);
 
 
 	/* publish it */
@@ -516,6 +546,65 @@ PX4FLOW::collect()
 	return ret;
 }
 
+void
+PX4FLOW::integrate_gyro(hrt_abstime frame_time, struct optical_flow_s &report)
+{
+	const hrt_abstime window_start = _frame_time;
+	float integral[3] = {0.0f, 0.0f, 0.0f};
+	float rate[3] = {0.0f, 0.0f, 0.0f};
+	bool have_gyro = false;
+	bool updated;
+	struct gyro_report gyro;
+
+	_frame_time = frame_time;
+
+	while (orb_check(_gyro_sub, &updated) == OK && updated &&
+	       orb_copy_queued(ORB_ID(sensor_gyro), _gyro_sub, &gyro, nullptr) == OK) {
+
+		/* a sample holds the rate since the previous one, counted from the start of the window */
+		hrt_abstime from = (_gyro_time > window_start) ? _gyro_time : window_start;
+
+		if (gyro.timestamp > from && gyro.timestamp <= frame_time) {
+			float dt = (gyro.timestamp - from) * 1e-6f;
+
+			integral[0] += gyro.x * dt;
+			integral[1] += gyro.y * dt;
+			integral[2] += gyro.z * dt;
+		}
+
+		rate[0] = gyro.x;
+		rate[1] = gyro.y;
+		rate[2] = gyro.z;
+		_gyro_time = gyro.timestamp;
+		have_gyro = true;
+	}
+
+	/* no window on the first frame, nor without gyro */
+	if (window_start == 0 || !have_gyro) {
+		report.integration_timespan = 0;
+		report.gyro_x_rate_integral = 0.0f;
+		report.gyro_y_rate_integral = 0.0f;
+		report.gyro_z_rate_integral = 0.0f;
+		return;
+	}
+
+	/* hold the last rate up to the frame; the next window starts there */
+	hrt_abstime held = (_gyro_time > window_start) ? _gyro_time : window_start;
+
+	if (frame_time > held) {
+		float dt = (frame_time - held) * 1e-6f;
+
+		integral[0] += rate[0] * dt;
+		integral[1] += rate[1] * dt;
+		integral[2] += rate[2] * dt;
+	}
+
+	report.integration_timespan = frame_time - window_start;
+	report.gyro_x_rate_integral = integral[0];
+	report.gyro_y_rate_integral = integral[1];
+	report.gyro_z_rate_integral = integral[2];
+}
+
 void
 PX4FLOW::start()
 {
@@ -524,7 +613,7 @@ PX4FLOW::start()
 	_reports->flush();
 
 	/* schedule a cycle to start things */
-	work_queue(HPWORK, &_work, (worker_t)&PX4FLOW::cycle_trampoline, this, 1);
+	work_queue_profiled(HPWORK, &_work, (worker_t)&PX4FLOW::cycle_trampoline, this, 1, "px4flow");
 
 	/* notify about state change */
 	struct subsystem_info_s info = {
@@ -580,11 +669,12 @@ PX4FLOW::cycle()
 		if (_measure_ticks > USEC2TICK(PX4FLOW_CONVERSION_INTERVAL)) {
 
 			/* schedule a fresh cycle call when we are ready to measure again */
-			work_queue(HPWORK,
-				   &_work,
-				   (worker_t)&PX4FLOW::cycle_trampoline,
-				   this,
-				   _measure_ticks - USEC2TICK(PX4FLOW_CONVERSION_INTERVAL));
+			work_queue_profiled(HPWORK,
+				            &_work,
+				            (worker_t)&PX4FLOW::cycle_trampoline,
+				            this,
+				            _measure_ticks - USEC2TICK(PX4FLOW_CONVERSION_INTERVAL),
+				            "px4flow");
 
 			return;
 		}
@@ -599,11 +689,12 @@ PX4FLOW::cycle()
 	_collect_phase = true;
 
 	/* schedule a fresh cycle call when the measurement is done */
-	work_queue(HPWORK,
-		   &_work,
-		   (worker_t)&PX4FLOW::cycle_trampoline,
-		   this,
-		   USEC2TICK(PX4FLOW_CONVERSION_INTERVAL));
+	work_queue_profiled(HPWORK,
+		            &_work,
+		            (worker_t)&PX4FLOW::cycle_trampoline,
+		            this,
+		            USEC2TICK(PX4FLOW_CONVERSION_INTERVAL),
+		            "px4flow");
 }
 
 void
@@ -65,13 +65,19 @@
 #include <systemlib/err.h>
 #include <systemlib/mixer/mixer.h>
 #include <systemlib/pwm_limit/pwm_limit.h>
+#include <systemlib/rpm_control/rpm_control.h>
 #include <systemlib/board_serial.h>
+#include <systemlib/perf_counter.h>
+#include <systemlib/control_latency.h>
+#include <systemlib/scheduling_priorities.h>
 #include <drivers/drv_mixer.h>
 #include <drivers/drv_rc_input.h>
 
 #include <uORB/topics/actuator_controls.h>
 #include <uORB/topics/actuator_outputs.h>
 #include <uORB/topics/actuator_armed.h>
+#include <uORB/topics/control_latency.h>
+#include <uORB/topics/esc_status.h>
 
 
 #ifdef HRT_PPM_CHANNEL
@@ -84,6 +90,35 @@
 
 #define CONTROL_INPUT_DROP_LIMIT_MS		20
 
+/*
+ * Actuator update rate standing in when OneShot or DShot outputs are
+ * configured: they send on every mix, so every control update is taken.
+ */
+#define ONESHOT_UPDATE_RATE			UINT32_MAX
+
+/*
+ * Limits of the fixed output rate, see PWM_SERVO_SET_OUTPUT_RATE.
+ */
+#define OUTPUT_RATE_MIN				50
+#define OUTPUT_RATE_MAX				2000
+
+/*
+ * Extrapolated controls are ignored if the last two samples are further
+ * apart than this; the controller is not running steadily then.
+ */
+#define EXTRAPOLATION_MAX_INTERVAL_US		50000
+
+/*
+ * Room for the mixers of one group, in the group's own arena. The largest
+ * ROMFS mixer needs about 700 bytes.
+ */
+#define MIXER_ARENA_SIZE			2048
+
+/*
+ * How long a mixer load waits for the task to pick up the previous one.
+ */
+#define MIXER_SWAP_TIMEOUT_MS			200
+
 class PX4FMU : public device::CDev
 {
 public:
@@ -123,6 +158,15 @@ private:
 	unsigned	_pwm_alt_rate;
 	uint32_t	_pwm_alt_rate_channels;
 	unsigned	_current_update_rate;
+	unsigned	_output_rate;
+	unsigned	_current_output_rate;
+	bool		_extrapolate;
+	struct hrt_call	_output_call;
+	sem_t		_output_sem;
+	volatile bool	_output_pending;
+	volatile hrt_abstime _output_time;
+	hrt_abstime	_controls_time;
+	actuator_controls_s _control_samples[2];
 	int		_task;
 	int		_armed_sub;
 	orb_advert_t	_outputs_pub;
@@ -134,7 +178,10 @@ private:
 	bool		_servo_armed;
 	bool		_pwm_on;
 
-	MixerGroup	*_mixers;
+	MixerGroup	*_mixer_groups[2];	/**< the running mixers and the ones being loaded */
+	MixerGroup	*_mixers;		/**< the group the task mixes with, task only */
+	MixerGroup	*volatile _mixers_next;	/**< the group the task switches to at its next cycle */
+	MixerGroup	*_mixers_build;		/**< the group the current mixer load goes to */
 
 	uint32_t	_groups_required;
 	uint32_t	_groups_subscribed;
@@ -142,6 +189,8 @@ private:
 	actuator_controls_s _controls[NUM_ACTUATOR_CONTROL_GROUPS];
 	orb_id_t	_control_topics[NUM_ACTUATOR_CONTROL_GROUPS];
 	pollfd	_poll_fds[NUM_ACTUATOR_CONTROL_GROUPS];
+	orb_batch_entry	_control_batch[NUM_ACTUATOR_CONTROL_GROUPS];	/**< subscribed groups, in the order of _poll_fds */
+	uint8_t		_control_batch_group[NUM_ACTUATOR_CONTROL_GROUPS];	/**< control group of each batch entry */
 	unsigned	_poll_fds_num;
 
 	pwm_limit_t	_pwm_limit;
@@ -152,9 +201,56 @@ private:
 	unsigned	_num_failsafe_set;
 	unsigned	_num_disarmed_set;
 
+	rpm_control_t	_rpm_control;
+	int		_esc_sub;
+	orb_reader_t	_esc_reader;
+	hrt_abstime	_esc_subscribe_time;	/**< last attempt to subscribe to the ESC telemetry */
+
+	orb_advert_t	_latency_pub;
+	perf_counter_t	_latency_perf;
+	perf_counter_t	_latency_est_perf;
+	perf_counter_t	_latency_ctrl_perf;
+	perf_counter_t	_latency_out_perf;
+
+	/**
+	 * Account the sensor to output latency of outputs set from the
+	 * attitude controls.
+	 */
+	void		publish_latency(const actuator_controls_s &controls, hrt_abstime now);
+
 	static void	task_main_trampoline(int argc, char *argv[]);
 	void		task_main();
 
+	/**
+	 * Send the outputs mixed last at a fixed rate, from the HRT callout.
+	 */
+	static void	output_trampoline(void *arg);
+	void		output();
+
+	/**
+	 * Move the attitude controls from the last two samples to the time
+	 * of the next output.
+	 */
+	void		extrapolate_controls(hrt_abstime time);
+
+	/**
+	 * Start loading mixers into the group the task is not using.
+	 *
+	 * @return		OK, or -EBUSY if the task has not taken over the
+	 *			last loaded group yet.
+	 */
+	int		begin_mixer_build();
+
+	/**
+	 * Hand the loaded mixers to the task.
+	 */
+	void		publish_mixer_build();
+
+	/**
+	 * Run the speed loop on the mixed outputs, from the ESC telemetry.
+	 */
+	void		rpm_feedback(float *outputs, unsigned num_outputs, hrt_abstime now);
+
 	static int	control_callback(uintptr_t handle,
 					 uint8_t control_group,
 					 uint8_t control_index,
@@ -242,6 +338,13 @@ PX4FMU::PX4FMU() :
 	_pwm_alt_rate(50),
 	_pwm_alt_rate_channels(0),
 	_current_update_rate(0),
+	_output_rate(0),
+	_current_output_rate(0),
+	_extrapolate(false),
+	_output_call{},
+	_output_pending(false),
+	_output_time(0),
+	_controls_time(0),
 	_task(-1),
 	_armed_sub(-1),
 	_outputs_pub(-1),
@@ -251,7 +354,10 @@ PX4FMU::PX4FMU() :
 	_task_should_exit(false),
 	_servo_armed(false),
 	_pwm_on(false),
+	_mixer_groups{nullptr},
 	_mixers(nullptr),
+	_mixers_next(nullptr),
+	_mixers_build(nullptr),
 	_groups_required(0),
 	_groups_subscribed(0),
 	_control_subs{-1},
@@ -260,7 +366,16 @@ PX4FMU::PX4FMU() :
 	_failsafe_pwm{0},
 	_disarmed_pwm{0},
 	_num_failsafe_set(0),
-	_num_disarmed_set(0)
+	_num_disarmed_set(0),
+	_rpm_control{},
+	_esc_sub(-1),
+	_esc_reader(0),
+	_esc_subscribe_time(0),
+	_latency_pub(-1),
+	_latency_perf(perf_alloc(PC_HISTOGRAM, "fmu latency")),
+	_latency_est_perf(perf_alloc(PC_HISTOGRAM, "fmu latency est")),
+	_latency_ctrl_perf(perf_alloc(PC_HISTOGRAM, "fmu latency ctrl")),
+	_latency_out_perf(perf_alloc(PC_HISTOGRAM, "fmu latency out"))
 {
 	for (unsigned i = 0; i < _max_actuators; i++) {
 		_min_pwm[i] = PWM_DEFAULT_MIN;
@@ -273,7 +388,16 @@ PX4FMU::PX4FMU() :
 	_control_topics[3] = ORB_ID(actuator_controls_3);
 
 	memset(_controls, 0, sizeof(_controls));
+	memset(_control_samples, 0, sizeof(_control_samples));
+	sem_init(&_output_sem, 0, 0);
 	memset(_poll_fds, 0, sizeof(_poll_fds));
+	memset(_control_batch, 0, sizeof(_control_batch));
+	memset(_control_batch_group, 0, sizeof(_control_batch_group));
+
+	/* allocated once; a mixer reload only resets their arenas */
+	for (unsigned i = 0; i < 2; i++) {
+		_mixer_groups[i] = new MixerGroup(control_callback, (uintptr_t)_controls, MIXER_ARENA_SIZE);
+	}
 
 	_debug_enabled = true;
 }
@@ -303,6 +427,18 @@ PX4FMU::~PX4FMU()
 	if (_primary_pwm_device)
 		unregister_driver(PWM_OUTPUT_DEVICE_PATH);
 
+	perf_free(_latency_perf);
+	perf_free(_latency_est_perf);
+	perf_free(_latency_ctrl_perf);
+	perf_free(_latency_out_perf);
+
+	sem_destroy(&_output_sem);
+
+	for (unsigned i = 0; i < 2; i++) {
+		if (_mixer_groups[i] != nullptr)
+			delete _mixer_groups[i];
+	}
+
 	g_fmu = nullptr;
 }
 
@@ -330,10 +466,10 @@ PX4FMU::init()
 	/* reset GPIOs */
 	gpio_reset();
 
-	/* start the IO interface task */
+	/* start the IO interface task; at the priority px4io uses, so controls are mixed as soon as the controller yields */
 	_task = task_spawn_cmd("fmuservo",
 			       SCHED_DEFAULT,
-			       SCHED_PRIORITY_DEFAULT,
+			       SCHED_PRIORITY_ACTUATOR_OUTPUTS,
 			       1600,
 			       (main_t)&PX4FMU::task_main_trampoline,
 			       nullptr);
@@ -467,13 +603,13 @@ PX4FMU::set_pwm_rate(uint32_t rate_map, unsigned default_rate, unsigned alt_rate
 			} else {
 				// set it - errors here are unexpected
 				if (alt != 0) {
-					if (up_pwm_servo_set_rate_group_update(group, _pwm_alt_rate) != OK) {
+					if (up_pwm_servo_set_rate_group_update(group, alt_rate) != OK) {
 						warn("rate group set alt failed");
 						return -EINVAL;
 					}
 
 				} else {
-					if (up_pwm_servo_set_rate_group_update(group, _pwm_default_rate) != OK) {
+					if (up_pwm_servo_set_rate_group_update(group, default_rate) != OK) {
 						warn("rate group set default failed");
 						return -EINVAL;
 					}
@@ -522,6 +658,8 @@ PX4FMU::subscribe()
 		if (_control_subs[i] > 0) {
 			_poll_fds[_poll_fds_num].fd = _control_subs[i];
 			_poll_fds[_poll_fds_num].events = POLLIN;
+			orb_batch_init(&_control_batch[_poll_fds_num], _control_topics[i], _control_subs[i], &_controls[i]);
+			_control_batch_group[_poll_fds_num] = i;
 			_poll_fds_num++;
 		}
 	}
@@ -555,6 +693,11 @@ PX4FMU::task_main()
 
 	/* loop until killed */
 	while (!_task_should_exit) {
+		/* take over newly loaded mixers, the old group is only reused after this */
+		if (_mixers != _mixers_next) {
+			_mixers = _mixers_next;
+		}
+
 		if (_groups_subscribed != _groups_required) {
 			subscribe();
 			_groups_subscribed = _groups_required;
@@ -570,12 +713,16 @@ PX4FMU::task_main()
 		 */
 		unsigned max_rate = (_pwm_default_rate > _pwm_alt_rate) ? _pwm_default_rate : _pwm_alt_rate;
 
+		if (PWM_RATE_IS_TRIGGERED(_pwm_default_rate) || PWM_RATE_IS_TRIGGERED(_pwm_alt_rate)) {
+			max_rate = ONESHOT_UPDATE_RATE;
+		}
+
 		if (_current_update_rate != max_rate) {
 			_current_update_rate = max_rate;
 			int update_rate_in_ms = int(1000 / _current_update_rate);
 
-			/* reject faster than 500 Hz updates */
-			if (update_rate_in_ms < 2) {
+			/* reject faster than 500 Hz updates, other than for OneShot and DShot */
+			if ((update_rate_in_ms < 2) && (max_rate != ONESHOT_UPDATE_RATE)) {
 				update_rate_in_ms = 2;
 			}
 
@@ -595,9 +742,43 @@ PX4FMU::task_main()
 			_current_update_rate = max_rate;
 		}
 
-		/* sleep waiting for data, stopping to check for PPM
-		 * input at 50Hz */
-		int ret = ::poll(_poll_fds, _poll_fds_num, CONTROL_INPUT_DROP_LIMIT_MS);
+		/* start, change or stop sending at a fixed rate */
+		if (_current_output_rate != _output_rate) {
+			_current_output_rate = _output_rate;
+			hrt_cancel(&_output_call);
+
+			if (_current_output_rate > 0) {
+				hrt_abstime interval = 1000000 / _current_output_rate;
+				hrt_call_every(&_output_call, interval, interval, (hrt_callout)&PX4FMU::output_trampoline, this);
+			}
+		}
+
+		int ret;
+		uint32_t controls_updated = 0;
+
+		if (_current_output_rate > 0) {
+			/* woken by the output callout, the controls are taken as they are */
+			while (sem_wait(&_output_sem) != 0) {}
+
+			controls_updated = orb_copy_batch(_control_batch, _poll_fds_num);
+
+			if (controls_updated) {
+				_controls_time = hrt_absolute_time();
+			}
+
+			/* stop sending exactly when poll() would have timed out */
+			ret = (hrt_elapsed_time(&_controls_time) < CONTROL_INPUT_DROP_LIMIT_MS * 1000) ? 1 : 0;
+
+		} else {
+			/* sleep waiting for data, stopping to check for PPM
+			 * input at 50Hz */
+			ret = ::poll(_poll_fds, _poll_fds_num, CONTROL_INPUT_DROP_LIMIT_MS);
+
+			if (ret > 0) {
+				/* get controls for required topics, all groups in one pass */
+				controls_updated = orb_copy_batch(_control_batch, _poll_fds_num);
+			}
+		}
 
 		/* this would be bad... */
 		if (ret < 0) {
@@ -610,14 +791,27 @@ PX4FMU::task_main()
 
 		} else {
 
-			/* get controls for required topics */
-			unsigned poll_id = 0;
-			for (unsigned i = 0; i < NUM_ACTUATOR_CONTROL_GROUPS; i++) {
-				if (_control_subs[i] > 0) {
-					if (_poll_fds[poll_id].revents & POLLIN) {
-						orb_copy(_control_topics[i], _control_subs[i], &_controls[i]);
-					}
-					poll_id++;
+			bool attitude_controls_updated = false;
+
+			for (unsigned n = 0; n < _poll_fds_num; n++) {
+				if ((controls_updated & (1 << n)) && (_control_batch_group[n] == 0)) {
+					attitude_controls_updated = true;
+				}
+			}
+
+			/* the callout sends what is mixed now one interval later */
+			hrt_abstime output_time = hrt_absolute_time();
+
+			if (_current_output_rate > 0) {
+				output_time = _output_time + 1000000 / _current_output_rate;
+
+				if (attitude_controls_updated) {
+					_control_samples[0] = _control_samples[1];
+					_control_samples[1] = _controls[0];
+				}
+
+				if (_extrapolate) {
+					extrapolate_controls(output_time);
 				}
 			}
 
@@ -665,16 +859,43 @@ PX4FMU::task_main()
 					}
 				}
 
+				if (_rpm_control.motors != 0) {
+					if (_servo_armed) {
+						rpm_feedback(&outputs.output[0], num_outputs, outputs.timestamp);
+
+					} else {
+						rpm_control_reset(&_rpm_control);
+					}
+				}
+
 				uint16_t pwm_limited[num_outputs];
 
 				/* the PWM limit call takes care of out of band errors and constrains */
 				pwm_limit_calc(_servo_armed, num_outputs, _disarmed_pwm, _min_pwm, _max_pwm, outputs.output, pwm_limited, &_pwm_limit);
 
+				/* keep the callout from sending a half written set */
+				_output_pending = false;
+
 				/* output to the servos */
 				for (unsigned i = 0; i < num_outputs; i++) {
 					up_pwm_servo_set(i, pwm_limited[i]);
 				}
 
+				if (_current_output_rate > 0) {
+					/* the callout sends them */
+					_output_pending = true;
+
+				} else {
+					/*
+					 * OneShot and DShot outputs send these right now, DMA updated
+					 * outputs load them together at the next timer period.
+					 */
+					up_pwm_servo_trigger();
+				}
+
+				if (attitude_controls_updated && _primary_pwm_device)
+					publish_latency(_controls[0], (_current_output_rate > 0) ? output_time : hrt_absolute_time());
+
 				/* publish mixed control outputs */
 				if (_outputs_pub < 0) {
 					_outputs_pub = orb_advertise(_primary_pwm_device ? ORB_ID_VEHICLE_CONTROLS : ORB_ID(actuator_outputs_1), &outputs);
@@ -753,6 +974,13 @@ PX4FMU::task_main()
 	}
 	::close(_armed_sub);
 
+	if (_esc_sub >= 0) {
+		::close(_esc_sub);
+		_esc_sub = -1;
+	}
+
+	hrt_cancel(&_output_call);
+
 	/* make sure servos are off */
 	up_pwm_servo_deinit();
 
@@ -765,6 +993,172 @@ PX4FMU::task_main()
 	_exit(0);
 }
 
+void
+PX4FMU::output_trampoline(void *arg)
+{
+	PX4FMU *dev = reinterpret_cast<PX4FMU *>(arg);
+
+	dev->output();
+}
+
+void
+PX4FMU::output()
+{
+	/* a set mixed too late or still being written is skipped, not sent twice or torn */
+	if (_output_pending) {
+		_output_pending = false;
+		up_pwm_servo_trigger();
+	}
+
+	_output_time = hrt_absolute_time();
+
+	/* wake the task to mix the next set, without piling up wakeups if it is behind */
+	int value;
+
+	if ((sem_getvalue(&_output_sem, &value) == 0) && (value <= 0)) {
+		sem_post(&_output_sem);
+	}
+}
+
+void
+PX4FMU::extrapolate_controls(hrt_abstime time)
+{
+	const actuator_controls_s &previous = _control_samples[0];
+	const actuator_controls_s &latest = _control_samples[1];
+
+	if (latest.timestamp == 0) {
+		return;
+	}
+
+	/* hold the latest sample unless there are two recent ones to go on */
+	if ((previous.timestamp == 0) || (latest.timestamp <= previous.timestamp) ||
+	    (latest.timestamp - previous.timestamp > EXTRAPOLATION_MAX_INTERVAL_US) ||
+	    (time <= latest.timestamp)) {
+		memcpy(_controls[0].control, latest.control, sizeof(_controls[0].control));
+		return;
+	}
+
+	/* never further ahead than one control interval */
+	float interval = latest.timestamp - previous.timestamp;
+	float k = (time - latest.timestamp) / interval;
+
+	if (k > 1.0f) {
+		k = 1.0f;
+	}
+
+	for (unsigned i = 0; i < NUM_ACTUATOR_CONTROLS; i++) {
+		float control = latest.control[i] + k * (latest.control[i] - previous.control[i]);
+
+		/* the controls have to stay in range, thrust included */
+		if (control > 1.0f) {
+			control = 1.0f;
+
+		} else if (control < -1.0f) {
+			control = -1.0f;
+		}
+
+		_controls[0].control[i] = isfinite(control) ? control : latest.control[i];
+	}
+}
+
+void
+PX4FMU::rpm_feedback(float *outputs, unsigned num_outputs, hrt_abstime now)
+{
+	/* the topic only exists once an ESC driver publishes it */
+	if ((_esc_sub < 0) && (now - _esc_subscribe_time > 1000000)) {
+		_esc_subscribe_time = now;
+		_esc_sub = orb_subscribe(ORB_ID(esc_status));
+
+		if (_esc_sub >= 0) {
+			_esc_reader = orb_reader(ORB_ID(esc_status), _esc_sub);
+		}
+	}
+
+	int32_t rpm[RPM_CONTROL_MAX_MOTORS];
+	unsigned num_rpm = 0;
+	hrt_abstime sample_time = 0;
+
+	/* take the few fields needed straight from the topic, again if the driver published meanwhile */
+	for (unsigned attempt = 0; (_esc_sub >= 0) && (_esc_reader > 0) && (attempt < 2); attempt++) {
+		const void *data;
+		unsigned generation;
+
+		if (orb_peek(ORB_ID(esc_status), _esc_reader, &data, &generation) != OK) {
+			break;
+		}
+
+		const esc_status_s *esc = (const esc_status_s *)data;
+
+		num_rpm = (esc->esc_count < RPM_CONTROL_MAX_MOTORS) ? esc->esc_count : RPM_CONTROL_MAX_MOTORS;
+		sample_time = esc->timestamp;
+
+		for (unsigned i = 0; i < num_rpm; i++) {
+			rpm[i] = esc->esc[i].esc_rpm;
+		}
+
+		if (orb_peek_valid(_esc_reader, generation)) {
+			break;
+		}
+
+		num_rpm = 0;
+		sample_time = 0;
+	}
+
+	rpm_control_update(&_rpm_control, outputs, num_outputs, rpm, num_rpm, sample_time, now);
+}
+
+int
+PX4FMU::begin_mixer_build()
+{
+	/* the group before the last one may still be mixed with until the task cycles */
+	for (unsigned waited = 0; _mixers != _mixers_next; waited += 10) {
+		if (waited >= MIXER_SWAP_TIMEOUT_MS) {
+			return -EBUSY;
+		}
+
+		usleep(10000);
+	}
+
+	_mixers_build = (_mixer_groups[0] != _mixers) ? _mixer_groups[0] : _mixer_groups[1];
+
+	if (_mixers_build != nullptr) {
+		_mixers_build->reset();
+	}
+
+	return OK;
+}
+
+void
+PX4FMU::publish_mixer_build()
+{
+	uint32_t groups = 0;
+	_mixers_build->groups_required(groups);
+
+	_groups_required = groups;
+	_mixers_next = _mixers_build;
+}
+
+void
+PX4FMU::publish_latency(const actuator_controls_s &controls, hrt_abstime now)
+{
+	control_latency_s latency;
+
+	if (!control_latency_update(&controls, now, &latency))
+		return;
+
+	perf_set_elapsed(_latency_perf, latency.total);
+	perf_set_elapsed(_latency_est_perf, latency.estimator);
+	perf_set_elapsed(_latency_ctrl_perf, latency.controller);
+	perf_set_elapsed(_latency_out_perf, latency.output);
+
+	if (_latency_pub < 0) {
+		_latency_pub = orb_advertise(ORB_ID(control_latency), &latency);
+
+	} else {
+		orb_publish(ORB_ID(control_latency), _latency_pub, &latency);
+	}
+}
+
 int
 PX4FMU::control_callback(uintptr_t handle,
 			 uint8_t control_group,
@@ -849,6 +1243,32 @@ PX4FMU::pwm_ioctl(file *filp, int cmd, unsigned long arg)
 		*(uint32_t *)arg = _pwm_alt_rate;
 		break;
 
+	case PWM_SERVO_SET_OUTPUT_RATE:
+		if ((arg != 0) && ((arg < OUTPUT_RATE_MIN) || (arg > OUTPUT_RATE_MAX))) {
+			ret = -EINVAL;
+			break;
+		}
+
+		/* picked up by the task */
+		_output_rate = arg;
+		break;
+
+	case PWM_SERVO_SET_EXTRAPOLATION:
+		_extrapolate = (arg != 0);
+		break;
+
+	case PWM_SERVO_SET_RPM_CONTROL: {
+			const struct pwm_rpm_control *config = (const struct pwm_rpm_control *)arg;
+
+			if ((config->motors != 0) && !(config->rpm_max > 0.0f)) {
+				ret = -EINVAL;
+				break;
+			}
+
+			rpm_control_init(&_rpm_control, config->motors, config->rpm_max, config->p, config->i);
+			break;
+		}
+
 	case PWM_SERVO_SET_SELECT_UPDATE_RATE:
 		ret = set_pwm_rate(arg, _pwm_default_rate, _pwm_alt_rate);
 		break;
@@ -1058,6 +1478,7 @@ PX4FMU::pwm_ioctl(file *filp, int cmd, unsigned long arg)
 	case PWM_SERVO_SET(0):
 		if (arg <= 2100) {
 			up_pwm_servo_set(cmd - PWM_SERVO_SET(0), arg);
+			up_pwm_servo_trigger();
 
 		} else {
 			ret = -EINVAL;
@@ -1176,62 +1597,66 @@ PX4FMU::pwm_ioctl(file *filp, int cmd, unsigned long arg)
 	}
 
 	case MIXERIOCRESET:
-		if (_mixers != nullptr) {
-			delete _mixers;
-			_mixers = nullptr;
-			_groups_required = 0;
-		}
-
+		/* the running mixers stay in use until the new ones are loaded */
+		ret = begin_mixer_build();
 		break;
 
-	case MIXERIOCADDSIMPLE: {
-			mixer_simple_s *mixinfo = (mixer_simple_s *)arg;
-
-			SimpleMixer *mixer = new SimpleMixer(control_callback,
-							     (uintptr_t)_controls, mixinfo);
+	case MIXERIOCADDSIMPLE:
+	case MIXERIOCLOADBUF:
+	case MIXERIOCLOADBIN: {
+			if (_mixers_build == nullptr) {
+				ret = begin_mixer_build();
 
-			if (mixer->check()) {
-				delete mixer;
-				_groups_required = 0;
-				ret = -EINVAL;
-
-			} else {
-				if (_mixers == nullptr)
-					_mixers = new MixerGroup(control_callback,
-								 (uintptr_t)_controls);
+				if (ret != OK)
+					break;
+			}
 
-				_mixers->add_mixer(mixer);
-				_mixers->groups_required(_groups_required);
+			if (_mixers_build == nullptr) {
+				ret = -ENOMEM;
+				break;
 			}
 
-			break;
-		}
+			if (cmd == MIXERIOCADDSIMPLE) {
+				const mixer_simple_s *mixinfo = (const mixer_simple_s *)arg;
 
-	case MIXERIOCLOADBUF: {
-			const char *buf = (const char *)arg;
-			unsigned buflen = strnlen(buf, 1024);
+				SimpleMixer *mixer = SimpleMixer::from_info(control_callback, (uintptr_t)_controls,
+						     mixinfo, _mixers_build->arena());
 
-			if (_mixers == nullptr)
-				_mixers = new MixerGroup(control_callback, (uintptr_t)_controls);
+				if (mixer == nullptr) {
+					ret = -1;
 
-			if (_mixers == nullptr) {
-				_groups_required = 0;
-				ret = -ENOMEM;
+				} else {
+					_mixers_build->add_mixer(mixer);
+				}
+
+			} else if (cmd == MIXERIOCLOADBIN) {
+				const mixer_bin_buf_s *bin = (const mixer_bin_buf_s *)arg;
+				unsigned buflen = bin->length;
+				ret = _mixers_build->load_from_bin(bin->data, buflen);
 
 			} else {
+				const char *buf = (const char *)arg;
+				unsigned buflen = strnlen(buf, 1024);
+				ret = _mixers_build->load_from_buf(buf, buflen);
+			}
 
-				ret = _mixers->load_from_buf(buf, buflen);
+			if (ret != 0) {
+				debug("mixer load failed with %d", ret);
 
-				if (ret != 0) {
-					debug("mixer load failed with %d", ret);
-					delete _mixers;
-					_mixers = nullptr;
-					_groups_required = 0;
-					ret = -EINVAL;
-				} else {
+				/* drop a group the task never saw, the previous mixers keep running */
+				if (_mixers_build != _mixers_next) {
+					_mixers_build->reset();
+					_mixers_build = nullptr;
 
-					_mixers->groups_required(_groups_required);
+				} else {
+					/* appended to the running group, keep what was loaded */
+					publish_mixer_build();
 				}
+
+				ret = -EINVAL;
+
+			} else {
+				publish_mixer_build();
 			}
 
 			break;
@@ -1278,6 +1703,8 @@ PX4FMU::write(file *filp, const char *buffer, size_t len)
 		}
 	}
 
+	up_pwm_servo_trigger();
+
 	return count * 2;
 }
 
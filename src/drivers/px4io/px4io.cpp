@@ -73,6 +73,7 @@
 #include <systemlib/scheduling_priorities.h>
 #include <systemlib/param/param.h>
 #include <systemlib/circuit_breaker.h>
+#include <systemlib/control_latency.h>
 
 #include <uORB/topics/actuator_controls.h>
 #include <uORB/topics/actuator_outputs.h>
@@ -84,6 +85,8 @@
 #include <uORB/topics/battery_status.h>
 #include <uORB/topics/servorail_status.h>
 #include <uORB/topics/parameter_update.h>
+#include <uORB/topics/control_latency.h>
+#include <uORB/topics/io_link_status.h>
 
 #include <debug.h>
 
@@ -91,6 +94,7 @@
 #include <modules/px4iofirmware/protocol.h>
 
 #include "uploader.h"
+#include "px4io_interface.h"
 
 #include "modules/dataman/dataman.h"
 
@@ -105,6 +109,7 @@ extern device::Device *PX4IO_serial_interface() weak_function;
 #define UPDATE_INTERVAL_MIN		2			// 2 ms	-> 500 Hz
 #define ORB_CHECK_INTERVAL		200000		// 200 ms -> 5 Hz
 #define IO_POLL_INTERVAL		20000		// 20 ms -> 50 Hz
+#define LINK_STATUS_INTERVAL		1000000		// 1 s
 
 /**
  * The PX4IO class.
@@ -254,6 +259,24 @@ private:
 	bool			_rc_handling_disabled;	///< If set, IO does not evaluate, but only forward the RC values
 	unsigned		_rc_chan_count;		///< Internal copy of the last seen number of RC channels
 	uint64_t		_rc_last_valid;		///< last valid timestamp
+	uint16_t		_rc_frames;		///< R/C frame counter of IO, from the last status
+	hrt_abstime		_rc_frame_time;		///< when IO decoded the last R/C frame
+	uint16_t		_rc_frames_published;	///< R/C frame counter at the last input_rc publication
+	uint16_t		_rc_status_published;	///< R/C status flags at the last input_rc publication
+
+	uint16_t		_rc_config[RC_INPUT_MAX_CHANNELS * PX4IO_P_RC_CONFIG_STRIDE];	///< RC channel configuration IO has
+	uint32_t		_rc_config_valid;	///< bitmask of the channels in _rc_config IO is known to have
+	bool			_rc_config_pending;	///< RC configuration waiting for the safety to come on
+
+	/** configuration page contents IO is known to have */
+	struct page_cache {
+		uint16_t	values[PWM_OUTPUT_MAX_CHANNELS];
+		unsigned	count;			///< number of known values from offset 0
+	};
+
+	page_cache		_failsafe_pwm;
+	page_cache		_min_pwm;
+	page_cache		_max_pwm;
 
 	volatile int		_task;			///< worker task id
 	volatile bool		_task_should_exit;	///< worker terminate flag
@@ -263,16 +286,28 @@ private:
 	perf_counter_t		_perf_update;		///<local performance counter for status updates
 	perf_counter_t		_perf_write;		///<local performance counter for PWM control writes
 	perf_counter_t		_perf_chan_count;	///<local performance counter for channel number changes
+	perf_counter_t		_perf_latency;		///< sensor sample to controls written to IO
+	perf_counter_t		_perf_latency_est;	///< sensor sample to attitude received by the controller
+	perf_counter_t		_perf_latency_ctrl;	///< attitude received to controls published
+	perf_counter_t		_perf_latency_out;	///< controls published to controls written to IO
 
 	/* cached IO state */
 	uint16_t		_status;		///< Various IO status flags
 	uint16_t		_alarms;		///< Various IO alarms
 
+	bool			_cycle_supported;	///< the interface returns the cycle registers with the controls
+	uint16_t		_cycle_regs[PKT_MAX_REGS];	///< reply to the last cycle transaction
+	hrt_abstime		_cycle_time;		///< time of the last cycle transaction
+	bool			_cycle_async;		///< the interface runs cycle exchanges in the background
+	hrt_abstime		_cycle_sent;		///< start of the last cycle exchange
+
 	/* subscribed topics */
 	int			_t_actuator_controls_0;	///< actuator controls group 0 topic
 	int			_t_actuator_controls_1;	///< actuator controls group 1 topic
 	int			_t_actuator_controls_2;	///< actuator controls group 2 topic
 	int			_t_actuator_controls_3;	///< actuator controls group 3 topic
+	actuator_controls_s	_controls[NUM_ACTUATOR_CONTROL_GROUPS];	///< latest controls of each group
+	orb_batch_entry		_control_batch[NUM_ACTUATOR_CONTROL_GROUPS]; ///< all control groups, fetched together
 	int			_t_actuator_armed;	///< system armed control topic
 	int 			_t_vehicle_control_mode;///< vehicle control mode topic
 	int			_t_param;		///< parameter update topic
@@ -284,6 +319,11 @@ private:
 	orb_advert_t		_to_battery;		///< battery status / voltage
 	orb_advert_t		_to_servorail;		///< servorail status
 	orb_advert_t		_to_safety;		///< status of safety
+	orb_advert_t		_to_latency;		///< sensor to output latency
+	orb_advert_t		_to_link_status;	///< serial link statistics
+
+	hrt_abstime		_link_status_time;	///< time of the last link statistics publication
+	uint64_t		_link_busy_us;		///< link busy time at the last publication
 
 	actuator_outputs_s	_outputs;		///< mixed outputs
 	servorail_status_s	_servorail_status;	///< servorail status
@@ -312,15 +352,30 @@ private:
 	void			task_main();
 
 	/**
-	 * Send controls for one group to IO
+	 * Send the fetched controls of one group to IO
 	 */
 	int			io_set_control_state(unsigned group);
 
 	/**
-	 * Send all controls to IO
+	 * Account the sensor to output latency of attitude controls sent to IO
+	 */
+	void			publish_latency(const actuator_controls_s &controls, hrt_abstime now);
+
+	/**
+	 * Fetch the updated control groups and send them to IO
 	 */
 	int			io_set_control_groups();
 
+	/**
+	 * Send the fetched controls from group 0 on in one cycle transaction,
+	 * keeping the status, R/C input and servo registers IO returns.
+	 *
+	 * @param groups	Number of control groups to send.
+	 * @return		OK if the controls were written, -ENOTTY if the
+	 *			interface does not support cycle transactions.
+	 */
+	int			io_cycle(unsigned groups);
+
 	/**
 	 * Update IO's arming-related state
 	 */
@@ -328,15 +383,42 @@ private:
 
 	/**
 	 * Push RC channel configuration to IO.
+	 *
+	 * Only channels that differ from what IO has are sent, as few
+	 * transfers as possible. With the safety off IO ignores the
+	 * configuration, it is then sent once it is back on.
 	 */
 	int			io_set_rc_config();
 
+	/**
+	 * Check whether the configuration of an RC channel has to be sent.
+	 *
+	 * @param channel	RC channel
+	 * @param config	Configuration of all channels
+	 */
+	bool			rc_config_changed(unsigned channel, const uint16_t *config);
+
+	/**
+	 * Set the registers of a configuration page that differ from what
+	 * was last set through this, in one transfer of the changed span.
+	 *
+	 * @param page		Register page
+	 * @param cache		Values IO is known to have, updated
+	 * @param values	Values to set from offset 0
+	 * @param num_values	Number of values
+	 * @return		OK if IO has the values
+	 */
+	int			io_reg_set_changed(uint8_t page, page_cache &cache, const uint16_t *values, unsigned num_values);
+
 	/**
 	 * Fetch status and alarms from IO
 	 *
 	 * Also publishes battery voltage/current.
+	 *
+	 * @param regs		Status registers of a cycle reply, or nullptr
+	 *			to read them from IO.
 	 */
-	int			io_get_status();
+	int			io_get_status(const uint16_t *regs = nullptr);
 
 	/**
 	 * Disable RC input handling
@@ -347,19 +429,27 @@ private:
 	 * Fetch RC inputs from IO.
 	 *
 	 * @param input_rc	Input structure to populate.
+	 * @param regs		Raw R/C registers of a cycle reply, or nullptr
+	 *			to read them from IO.
 	 * @return		OK if data was returned.
 	 */
-	int			io_get_raw_rc_input(rc_input_values &input_rc);
+	int			io_get_raw_rc_input(rc_input_values &input_rc, const uint16_t *regs = nullptr);
 
 	/**
-	 * Fetch and publish raw RC input data.
+	 * Fetch and publish raw RC input data, if the last status reported
+	 * a new frame or a change of the R/C state.
+	 *
+	 * @param regs		As for io_get_raw_rc_input.
 	 */
-	int			io_publish_raw_rc();
+	int			io_publish_raw_rc(const uint16_t *regs = nullptr);
 
 	/**
 	 * Fetch and publish the PWM servo outputs.
+	 *
+	 * @param regs		Servo registers of a cycle reply, or nullptr
+	 *			to read them from IO.
 	 */
-	int			io_publish_pwm_outputs();
+	int			io_publish_pwm_outputs(const uint16_t *regs = nullptr);
 
 	/**
 	 * write register(s)
@@ -414,9 +504,9 @@ private:
 	int			io_reg_modify(uint8_t page, uint8_t offset, uint16_t clearbits, uint16_t setbits);
 
 	/**
-	 * Send mixer definition text to IO
+	 * Send mixer definition text or binary mixer records to IO
 	 */
-	int			mixer_send(const char *buf, unsigned buflen, unsigned retries = 3);
+	int			mixer_send(const char *buf, unsigned buflen, unsigned retries = 3, bool binary = false);
 
 	/**
 	 * Handle a status update from IO.
@@ -463,6 +553,11 @@ private:
 	 */
 	void			io_handle_vservo(uint16_t vservo, uint16_t vrssi);
 
+	/**
+	 * Publish the statistics of the interface link, if it keeps any.
+	 */
+	void			io_publish_link_status();
+
 	/* do not allow to copy this class due to ptr data members */
 	PX4IO(const PX4IO&);
 	PX4IO operator=(const PX4IO&);
@@ -488,18 +583,39 @@ PX4IO::PX4IO(device::Device *interface) :
 	_rc_handling_disabled(false),
 	_rc_chan_count(0),
 	_rc_last_valid(0),
+	_rc_frames(0),
+	_rc_frame_time(0),
+	_rc_frames_published(0),
+	_rc_status_published(0),
+	_rc_config{},
+	_rc_config_valid(0),
+	_rc_config_pending(false),
+	_failsafe_pwm{},
+	_min_pwm{},
+	_max_pwm{},
 	_task(-1),
 	_task_should_exit(false),
 	_mavlink_fd(-1),
 	_perf_update(perf_alloc(PC_ELAPSED, "io update")),
 	_perf_write(perf_alloc(PC_ELAPSED, "io write")),
 	_perf_chan_count(perf_alloc(PC_COUNT, "io rc #")),
+	_perf_latency(perf_alloc(PC_HISTOGRAM, "io latency")),
+	_perf_latency_est(perf_alloc(PC_HISTOGRAM, "io latency est")),
+	_perf_latency_ctrl(perf_alloc(PC_HISTOGRAM, "io latency ctrl")),
+	_perf_latency_out(perf_alloc(PC_HISTOGRAM, "io latency out")),
 	_status(0),
 	_alarms(0),
+	_cycle_supported(true),
+	_cycle_regs{},
+	_cycle_time(0),
+	_cycle_async(false),
+	_cycle_sent(0),
 	_t_actuator_controls_0(-1),
 	_t_actuator_controls_1(-1),
 	_t_actuator_controls_2(-1),
 	_t_actuator_controls_3(-1),
+	_controls{},
+	_control_batch{},
 	_t_actuator_armed(-1),
 	_t_vehicle_control_mode(-1),
 	_t_param(-1),
@@ -509,6 +625,10 @@ PX4IO::PX4IO(device::Device *interface) :
 	_to_battery(0),
 	_to_servorail(0),
 	_to_safety(0),
+	_to_latency(0),
+	_to_link_status(0),
+	_link_status_time(0),
+	_link_busy_us(0),
 	_outputs{},
 	_servorail_status{},
 	_primary_pwm_device(false),
@@ -552,6 +672,10 @@ PX4IO::~PX4IO()
 	perf_free(_perf_update);
 	perf_free(_perf_write);
 	perf_free(_perf_chan_count);
+	perf_free(_perf_latency);
+	perf_free(_perf_latency_est);
+	perf_free(_perf_latency_ctrl);
+	perf_free(_perf_latency_out);
 
 	g_dev = nullptr;
 }
@@ -652,6 +776,10 @@ PX4IO::init()
 	if (_max_rc_input > RC_INPUT_MAX_CHANNELS)
 		_max_rc_input = RC_INPUT_MAX_CHANNELS;
 
+	/* let cycle exchanges complete while the driver goes on, where the interface can */
+	unsigned cycle_async = 1;
+	_cycle_async = (_interface->ioctl(PX4IO_INTERFACE_CYCLE_ASYNC, cycle_async) == OK);
+
 	/*
 	 * Check for IO flight state - if FMU was flagged to be in
 	 * armed state, FMU is recovering from an in-air reset.
@@ -748,7 +876,7 @@ PX4IO::init()
 		cmd.confirmation =  1;
 
 		/* send command once */
-		orb_advert_t pub = orb_advertise(ORB_ID(vehicle_command), &cmd);
+		orb_advert_t pub = orb_advertise_queue(ORB_ID(vehicle_command), &cmd, VEHICLE_COMMAND_QUEUE_LENGTH);
 
 		/* spin here until IO's state has propagated into the system */
 		do {
@@ -853,7 +981,8 @@ void
 PX4IO::task_main()
 {
 	hrt_abstime poll_last = 0;
-	hrt_abstime orb_check_last = 0;
+	hrt_abstime poll_next = 0;
+	hrt_abstime orb_check_next = 0;
 
 	_mavlink_fd = ::open(MAVLINK_LOG_DEVICE, 0);
 
@@ -869,6 +998,11 @@ PX4IO::task_main()
 	orb_set_interval(_t_actuator_controls_2, 33);		/* default to 30Hz */
 	_t_actuator_controls_3 = orb_subscribe(ORB_ID(actuator_controls_3));
 	orb_set_interval(_t_actuator_controls_3, 33);		/* default to 30Hz */
+
+	orb_batch_init(&_control_batch[0], ORB_ID(actuator_controls_0), _t_actuator_controls_0, &_controls[0]);
+	orb_batch_init(&_control_batch[1], ORB_ID(actuator_controls_1), _t_actuator_controls_1, &_controls[1]);
+	orb_batch_init(&_control_batch[2], ORB_ID(actuator_controls_2), _t_actuator_controls_2, &_controls[2]);
+	orb_batch_init(&_control_batch[3], ORB_ID(actuator_controls_3), _t_actuator_controls_3, &_controls[3]);
 	_t_actuator_armed = orb_subscribe(ORB_ID(actuator_armed));
 	_t_vehicle_control_mode = orb_subscribe(ORB_ID(vehicle_control_mode));
 	_t_param = orb_subscribe(ORB_ID(parameter_update));
@@ -910,9 +1044,17 @@ PX4IO::task_main()
 			_update_interval = 0;
 		}
 
-		/* sleep waiting for topic updates, but no more than 20ms */
+		/*
+		 * Sleep waiting for control updates, but only until the next of the
+		 * periodic jobs below is due. Controls are sent as they come in,
+		 * the jobs keep their own rate however many controls there are.
+		 */
+		hrt_abstime before = hrt_absolute_time();
+		hrt_abstime due = (poll_next < orb_check_next) ? poll_next : orb_check_next;
+		int timeout = (due > before) ? (due - before + 999) / 1000 : 0;
+
 		unlock();
-		int ret = ::poll(fds, 1, 20);
+		int ret = ::poll(fds, 1, timeout);
 		lock();
 
 		/* this would be bad... */
@@ -932,28 +1074,41 @@ PX4IO::task_main()
 			(void)io_set_control_groups();
 		}
 
-		if (now >= poll_last + IO_POLL_INTERVAL) {
+		if (now >= poll_next) {
 			/* run at 50Hz */
+
+			/* a cycle since the last poll already brought the IO state along */
+			const uint16_t *cycle = (_cycle_time > poll_last) ? _cycle_regs : nullptr;
+
 			poll_last = now;
 
+			/* keep the rate, unless we fell behind by more than a period */
+			poll_next += IO_POLL_INTERVAL;
+
+			if (poll_next <= now)
+				poll_next = now + IO_POLL_INTERVAL;
+
 			/* pull status and alarms from IO */
-			io_get_status();
+			io_get_status(cycle ? &cycle[PX4IO_P_CYCLE_STATUS] : nullptr);
 
 			/* get raw R/C input from IO */
-			io_publish_raw_rc();
+			io_publish_raw_rc(cycle ? &cycle[PX4IO_P_CYCLE_RAW_RC] : nullptr);
 
 			/* fetch PWM outputs from IO */
-			io_publish_pwm_outputs();
+			io_publish_pwm_outputs(cycle ? &cycle[PX4IO_P_CYCLE_SERVOS] : nullptr);
 		}
 
-		if (now >= orb_check_last + ORB_CHECK_INTERVAL) {
+		if (now >= orb_check_next) {
 			/* run at 5Hz */
-			orb_check_last = now;
+			orb_check_next = now + ORB_CHECK_INTERVAL;
 
 			/* try to claim the MAVLink log FD */
 			if (_mavlink_fd < 0)
 				_mavlink_fd = ::open(MAVLINK_LOG_DEVICE, 0);
 
+			if (now >= _link_status_time + LINK_STATUS_INTERVAL)
+				io_publish_link_status();
+
 			/* check updates on uORB topics and handle it */
 			bool updated = false;
 
@@ -968,6 +1123,12 @@ PX4IO::task_main()
 				io_set_arming_state();
 			}
 
+			/* RC config held back while the safety was off */
+			if (_rc_config_pending &&
+			    !(_status & (PX4IO_P_STATUS_FLAGS_SAFETY_OFF | PX4IO_P_STATUS_FLAGS_OUTPUTS_ARMED))) {
+				io_set_rc_config();
+			}
+
 			/* vehicle command */
 			orb_check(_t_vehicle_command, &updated);
 
@@ -1080,72 +1241,133 @@ out:
 int
 PX4IO::io_set_control_groups()
 {
-	int ret = io_set_control_state(0);
+	/* one pass over all groups, without going through the file layer for each */
+	uint32_t updated = orb_copy_batch(_control_batch, NUM_ACTUATOR_CONTROL_GROUPS);
+
+	if (!(updated & 1))
+		return -1;
+
+	int ret = -1;
+	unsigned cycle_groups = 0;
 
-	/* send auxiliary control groups */
-	(void)io_set_control_state(1);
-	(void)io_set_control_state(2);
-	(void)io_set_control_state(3);
+	if (_cycle_supported) {
+		/* everything up to the highest updated group that fits into one packet */
+		unsigned max_regs = _max_transfer / 2;
+
+		if (max_regs > PKT_MAX_REGS)
+			max_regs = PKT_MAX_REGS;
+
+		for (unsigned group = 0; group < NUM_ACTUATOR_CONTROL_GROUPS; group++) {
+			if ((group + 1) * PX4IO_PROTOCOL_MAX_CONTROL_COUNT > max_regs)
+				break;
+
+			if (updated & (1 << group))
+				cycle_groups = group + 1;
+		}
+
+		ret = io_cycle(cycle_groups);
+
+		if (ret == -ENOTTY) {
+			_cycle_supported = false;
+			cycle_groups = 0;
+		}
+	}
+
+	if (cycle_groups == 0)
+		ret = io_set_control_state(0);
+
+	/* send the auxiliary control groups the cycle did not carry */
+	for (unsigned group = (cycle_groups > 0) ? cycle_groups : 1; group < NUM_ACTUATOR_CONTROL_GROUPS; group++) {
+		if (updated & (1 << group))
+			(void)io_set_control_state(group);
+	}
 
 	return ret;
 }
 
 int
-PX4IO::io_set_control_state(unsigned group)
+PX4IO::io_cycle(unsigned groups)
 {
-	actuator_controls_s	controls;	///< actuator outputs
-	uint16_t 		regs[_max_actuators];
+	/* the reply comes back in the same buffer */
+	uint16_t regs[PKT_MAX_REGS] = {};
+	unsigned count = groups * PX4IO_PROTOCOL_MAX_CONTROL_COUNT;
+	unsigned controls = (_max_controls < PX4IO_PROTOCOL_MAX_CONTROL_COUNT) ? _max_controls : PX4IO_PROTOCOL_MAX_CONTROL_COUNT;
 
-	/* get controls */
-	bool changed;
+	for (unsigned group = 0; group < groups; group++) {
+		for (unsigned i = 0; i < controls; i++)
+			regs[group * PX4IO_PROTOCOL_MAX_CONTROL_COUNT + i] = FLOAT_TO_REG(_controls[group].control[i]);
+	}
 
-	switch (group) {
-		case 0:
-		{
-			orb_check(_t_actuator_controls_0, &changed);
+	hrt_abstime sent = hrt_absolute_time();
+	int ret = _interface->write(PX4IO_PAGE_CYCLE << 8, regs, count);
 
-			if (changed) {
-				orb_copy(ORB_ID(actuator_controls_0), _t_actuator_controls_0, &controls);
-			}
-		}
-		break;
-		case 1:
-		{
-			orb_check(_t_actuator_controls_1, &changed);
+	if (ret == -ENOTTY)
+		return ret;
 
-			if (changed) {
-				orb_copy(ORB_ID(actuator_controls_1), _t_actuator_controls_1, &controls);
-			}
-		}
-		break;
-		case 2:
-		{
-			orb_check(_t_actuator_controls_2, &changed);
+	/*
+	 * In the background the controls always go out, and what comes
+	 * back is the reply to the previous exchange, if there was one.
+	 */
+	hrt_abstime replied = _cycle_async ? _cycle_sent : sent;
+	_cycle_sent = sent;
 
-			if (changed) {
-				orb_copy(ORB_ID(actuator_controls_2), _t_actuator_controls_2, &controls);
-			}
-		}
-		break;
-		case 3:
-		{
-			orb_check(_t_actuator_controls_3, &changed);
+	/* IO mixes in its own loop, that delay is not visible from here */
+	if ((_cycle_async || (ret == (int)count)) && _primary_pwm_device)
+		publish_latency(_controls[0], sent);
 
-			if (changed) {
-				orb_copy(ORB_ID(actuator_controls_3), _t_actuator_controls_3, &controls);
-			}
-		}
-		break;
-	}
+	if (_cycle_async && (ret == -EAGAIN))
+		return OK;
 
-	if (!changed)
+	if (ret != (int)count) {
+		debug("io_cycle(%u): error %d", groups, ret);
 		return -1;
+	}
+
+	memcpy(_cycle_regs, regs, sizeof(_cycle_regs));
+	_cycle_time = replied;
+
+	return OK;
+}
+
+int
+PX4IO::io_set_control_state(unsigned group)
+{
+	const actuator_controls_s &controls = _controls[group];
+	uint16_t 		regs[_max_actuators];
 
 	for (unsigned i = 0; i < _max_controls; i++)
 		regs[i] = FLOAT_TO_REG(controls.control[i]);
 
 	/* copy values to registers in IO */
-	return io_reg_set(PX4IO_PAGE_CONTROLS, group * PX4IO_PROTOCOL_MAX_CONTROL_COUNT, regs, _max_controls);
+	int ret = io_reg_set(PX4IO_PAGE_CONTROLS, group * PX4IO_PROTOCOL_MAX_CONTROL_COUNT, regs, _max_controls);
+
+	/* IO mixes in its own loop, that delay is not visible from here */
+	if ((ret == OK) && (group == 0) && _primary_pwm_device)
+		publish_latency(controls, hrt_absolute_time());
+
+	return ret;
+}
+
+void
+PX4IO::publish_latency(const actuator_controls_s &controls, hrt_abstime now)
+{
+	control_latency_s latency;
+
+	if (!control_latency_update(&controls, now, &latency))
+		return;
+
+	perf_set_elapsed(_perf_latency, latency.total);
+	perf_set_elapsed(_perf_latency_est, latency.estimator);
+	perf_set_elapsed(_perf_latency_ctrl, latency.controller);
+	perf_set_elapsed(_perf_latency_out, latency.output);
+
+	/* lazily advertise on first publication */
+	if (_to_latency == 0) {
+		_to_latency = orb_advertise(ORB_ID(control_latency), &latency);
+
+	} else {
+		orb_publish(ORB_ID(control_latency), _to_latency, &latency);
+	}
 }
 
 
@@ -1225,7 +1447,7 @@ PX4IO::io_disable_rc_handling()
 int
 PX4IO::io_set_rc_config()
 {
-	unsigned offset = 0;
+	uint16_t config[RC_INPUT_MAX_CHANNELS * PX4IO_P_RC_CONFIG_STRIDE];
 	int input_map[_max_rc_input];
 	int32_t ichan;
 	int ret = OK;
@@ -1287,7 +1509,7 @@ PX4IO::io_set_rc_config()
 	 * Iterate all possible RC inputs.
 	 */
 	for (unsigned i = 0; i < _max_rc_input; i++) {
-		uint16_t regs[PX4IO_P_RC_CONFIG_STRIDE];
+		uint16_t *regs = &config[i * PX4IO_P_RC_CONFIG_STRIDE];
 		char pname[16];
 		float fval;
 
@@ -1330,31 +1552,101 @@ PX4IO::io_set_rc_config()
 		if (fval < 0) {
 			regs[PX4IO_P_RC_CONFIG_OPTIONS] |= PX4IO_P_RC_CONFIG_OPTIONS_REVERSE;
 		}
+	}
 
-		/* send channel config to IO */
-		ret = io_reg_set(PX4IO_PAGE_RC_CONFIG, offset, regs, PX4IO_P_RC_CONFIG_STRIDE);
+	/* IO ignores the config with the safety off, send it once it is back on */
+	_rc_config_pending = false;
+
+	if (_status & (PX4IO_P_STATUS_FLAGS_SAFETY_OFF | PX4IO_P_STATUS_FLAGS_OUTPUTS_ARMED)) {
+		for (unsigned i = 0; i < _max_rc_input; i++) {
+			if (rc_config_changed(i, config)) {
+				_rc_config_pending = true;
+				break;
+			}
+		}
+
+		return ret;
+	}
+
+	/* send runs of changed channels, as many as fit a transfer at a time */
+	const unsigned max_run = (_max_transfer / sizeof(uint16_t)) / PX4IO_P_RC_CONFIG_STRIDE;
+	unsigned i = 0;
+
+	while (i < _max_rc_input) {
+		if (!rc_config_changed(i, config)) {
+			i++;
+			continue;
+		}
+
+		unsigned count = 1;
+
+		while ((count < max_run) && (i + count < _max_rc_input) && rc_config_changed(i + count, config))
+			count++;
+
+		const unsigned offset = i * PX4IO_P_RC_CONFIG_STRIDE;
+		const uint32_t channels = ((1 << count) - 1) << i;
+
+		/* IO only has part of the channels if the transfer failed */
+		_rc_config_valid &= ~channels;
+
+		ret = io_reg_set(PX4IO_PAGE_RC_CONFIG, offset, &config[offset], count * PX4IO_P_RC_CONFIG_STRIDE);
 
 		if (ret != OK) {
 			log("rc config upload failed");
 			break;
 		}
 
-		/* check the IO initialisation flag */
-		if (!(io_reg_get(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_FLAGS) & PX4IO_P_STATUS_FLAGS_INIT_OK)) {
-			log("config for RC%d rejected by IO", i + 1);
+		/* check the IO initialisation flag, cleared if any of the channels failed */
+		uint32_t status = io_reg_get(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_FLAGS);
+
+		if ((status != _io_reg_get_error) &&
+		    (status & (PX4IO_P_STATUS_FLAGS_SAFETY_OFF | PX4IO_P_STATUS_FLAGS_OUTPUTS_ARMED))) {
+			/* safety went off before the write */
+			_rc_config_pending = true;
+			break;
+		}
+
+		if ((status == _io_reg_get_error) || !(status & PX4IO_P_STATUS_FLAGS_INIT_OK)) {
+			if (count > 1) {
+				log("config for RC%u..RC%u rejected by IO", i + 1, i + count);
+
+			} else {
+				log("config for RC%u rejected by IO", i + 1);
+			}
+
 			break;
 		}
 
-		offset += PX4IO_P_RC_CONFIG_STRIDE;
+		memcpy(&_rc_config[offset], &config[offset], count * PX4IO_P_RC_CONFIG_STRIDE * sizeof(config[0]));
+		_rc_config_valid |= channels;
+		i += count;
 	}
 
 	return ret;
 }
 
+bool
+PX4IO::rc_config_changed(unsigned channel, const uint16_t *config)
+{
+	const unsigned offset = channel * PX4IO_P_RC_CONFIG_STRIDE;
+
+	return !(_rc_config_valid & (1 << channel)) ||
+	       memcmp(&_rc_config[offset], &config[offset], PX4IO_P_RC_CONFIG_STRIDE * sizeof(config[0]));
+}
+
 int
 PX4IO::io_handle_status(uint16_t status)
 {
 	int ret = 1;
+
+	/* a restarted IO has none of the configuration */
+	if (!(status & PX4IO_P_STATUS_FLAGS_ARM_SYNC)) {
+		_rc_config_valid = 0;
+		_failsafe_pwm.count = 0;
+		_min_pwm.count = 0;
+		_max_pwm.count = 0;
+	}
+
 	/**
 	 * WARNING: This section handles in-air resets.
 	 */
@@ -1501,20 +1793,67 @@ PX4IO::io_handle_vservo(uint16_t vservo, uint16_t vrssi)
 	}
 }
 
+void
+PX4IO::io_publish_link_status()
+{
+	io_link_status_s status;
+	unsigned arg = reinterpret_cast<unsigned>(&status);
+	hrt_abstime now = hrt_absolute_time();
+
+	/* only the serial interface keeps statistics */
+	if (_interface->ioctl(PX4IO_INTERFACE_LINK_STATUS, arg) != OK) {
+		_link_status_time = now;
+		return;
+	}
+
+	/* the first publication has no interval to average over */
+	if ((_to_link_status > 0) && (now > _link_status_time)) {
+		status.utilization = 100.0f * (status.busy_us - _link_busy_us) / (now - _link_status_time);
+
+	} else {
+		status.utilization = 0.0f;
+	}
+
+	_link_status_time = now;
+	_link_busy_us = status.busy_us;
+	status.timestamp = now;
+
+	if (_to_link_status > 0) {
+		orb_publish(ORB_ID(io_link_status), _to_link_status, &status);
+
+	} else {
+		_to_link_status = orb_advertise(ORB_ID(io_link_status), &status);
+	}
+}
+
 int
-PX4IO::io_get_status()
+PX4IO::io_get_status(const uint16_t *cycle_regs)
 {
-	uint16_t	regs[6];
-	int		ret;
+	uint16_t	status_regs[PX4IO_CYCLE_STATUS_COUNT];
+	const uint16_t	*regs = cycle_regs;
+	int		ret = OK;
+
+	if (regs == nullptr) {
+		/* get
+		 * STATUS_FLAGS, STATUS_ALARMS, STATUS_VBATT, STATUS_IBATT,
+		 * STATUS_VSERVO, STATUS_VRSSI, STATUS_PRSSI,
+		 * STATUS_RC_FRAMES, STATUS_RC_AGE
+		 * in that order */
+		ret = io_reg_get(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_FLAGS, &status_regs[0], PX4IO_CYCLE_STATUS_COUNT);
 
-	/* get
-	 * STATUS_FLAGS, STATUS_ALARMS, STATUS_VBATT, STATUS_IBATT,
-	 * STATUS_VSERVO, STATUS_VRSSI, STATUS_PRSSI
-	 * in that order */
-	ret = io_reg_get(PX4IO_PAGE_STATUS, PX4IO_P_STATUS_FLAGS, &regs[0], sizeof(regs) / sizeof(regs[0]));
+		if (ret != OK)
+			return ret;
 
-	if (ret != OK)
-		return ret;
+		regs = status_regs;
+	}
+
+	/* a new R/C frame, dated back to when IO decoded it */
+	if (regs[7] != _rc_frames) {
+		hrt_abstime fetched = (cycle_regs != nullptr) ? _cycle_time : hrt_absolute_time();
+
+		_rc_frames = regs[7];
+		_rc_frame_time = fetched - ((regs[8] < fetched) ? regs[8] : 0);
+	}
 
 	io_handle_status(regs[0]);
 	io_handle_alarms(regs[1]);
@@ -1531,7 +1870,7 @@ PX4IO::io_get_status()
 }
 
 int
-PX4IO::io_get_raw_rc_input(rc_input_values &input_rc)
+PX4IO::io_get_raw_rc_input(rc_input_values &input_rc, const uint16_t *cycle_regs)
 {
 	uint32_t channel_count;
 	int	ret;
@@ -1546,11 +1885,21 @@ PX4IO::io_get_raw_rc_input(rc_input_values &input_rc)
 	 * Read the channel count and the first 9 channels.
 	 *
 	 * This should be the common case (9 channel R/C control being a reasonable upper bound).
+	 * A cycle reply carries all channels.
 	 */
-	ret = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_COUNT, &regs[0], prolog + 9);
+	unsigned fetched = 9;
 
-	if (ret != OK)
-		return ret;
+	if (cycle_regs != nullptr) {
+		fetched = PX4IO_CYCLE_RC_CHANNELS;
+		memcpy(&regs[0], cycle_regs, (prolog + fetched) * sizeof(regs[0]));
+		ret = OK;
+
+	} else {
+		ret = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_COUNT, &regs[0], prolog + fetched);
+
+		if (ret != OK)
+			return ret;
+	}
 
 	/*
 	 * Get the channel count any any extra channels. This is no more expensive than reading the
@@ -1582,7 +1931,7 @@ PX4IO::io_get_raw_rc_input(rc_input_values &input_rc)
 
 	/* rc_lost has to be set before the call to this function */
 	if (!input_rc.rc_lost && !input_rc.rc_failsafe) {
-		_rc_last_valid = input_rc.timestamp_publication;
+		_rc_last_valid = (_rc_frame_time != 0) ? _rc_frame_time : input_rc.timestamp_publication;
 	}
 
 	input_rc.timestamp_last_signal = _rc_last_valid;
@@ -1590,8 +1939,9 @@ PX4IO::io_get_raw_rc_input(rc_input_values &input_rc)
 	/* FIELDS NOT SET HERE */
 	/* input_rc.input_source is set after this call XXX we might want to mirror the flags in the RC struct */
 
-	if (channel_count > 9) {
-		ret = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_BASE + 9, &regs[prolog + 9], channel_count - 9);
+	if (channel_count > fetched) {
+		ret = io_reg_get(PX4IO_PAGE_RAW_RC_INPUT, PX4IO_P_RAW_RC_BASE + fetched, &regs[prolog + fetched],
+				 channel_count - fetched);
 
 		if (ret != OK)
 			return ret;
@@ -1606,8 +1956,15 @@ PX4IO::io_get_raw_rc_input(rc_input_values &input_rc)
 }
 
 int
-PX4IO::io_publish_raw_rc()
+PX4IO::io_publish_raw_rc(const uint16_t *cycle_regs)
 {
+	const uint16_t rc_status = _status & (PX4IO_P_STATUS_FLAGS_RC_OK | PX4IO_P_STATUS_FLAGS_RC_PPM |
+					      PX4IO_P_STATUS_FLAGS_RC_DSM | PX4IO_P_STATUS_FLAGS_RC_SBUS |
+					      PX4IO_P_STATUS_FLAGS_RC_ST24);
+
+	/* no new frame and no change in the R/C state, nothing to fetch */
+	if ((_rc_frames == _rc_frames_published) && (rc_status == _rc_status_published))
+		return OK;
 
 	/* fetch values from IO */
 	rc_input_values	rc_val;
@@ -1615,11 +1972,14 @@ PX4IO::io_publish_raw_rc()
 	/* set the RC status flag ORDER MATTERS! */
 	rc_val.rc_lost = !(_status & PX4IO_P_STATUS_FLAGS_RC_OK);
 
-	int ret = io_get_raw_rc_input(rc_val);
+	int ret = io_get_raw_rc_input(rc_val, cycle_regs);
 
 	if (ret != OK)
 		return ret;
 
+	_rc_frames_published = _rc_frames;
+	_rc_status_published = rc_status;
+
 	/* sort out the source of the values */
 	if (_status & PX4IO_P_STATUS_FLAGS_RC_PPM) {
 		rc_val.input_source = RC_INPUT_SOURCE_PX4IO_PPM;
@@ -1655,7 +2015,7 @@ PX4IO::io_publish_raw_rc()
 }
 
 int
-PX4IO::io_publish_pwm_outputs()
+PX4IO::io_publish_pwm_outputs(const uint16_t *cycle_regs)
 {
 	/* if no FMU comms(!) just don't publish */
 	if (!(_status & PX4IO_P_STATUS_FLAGS_FMU_OK))
@@ -1667,10 +2027,19 @@ PX4IO::io_publish_pwm_outputs()
 
 	/* get servo values from IO */
 	uint16_t ctl[_max_actuators];
-	int ret = io_reg_get(PX4IO_PAGE_SERVOS, 0, ctl, _max_actuators);
+	unsigned cached = 0;
 
-	if (ret != OK)
-		return ret;
+	if (cycle_regs != nullptr) {
+		cached = (_max_actuators < PX4IO_CYCLE_SERVO_COUNT) ? _max_actuators : PX4IO_CYCLE_SERVO_COUNT;
+		memcpy(ctl, cycle_regs, cached * sizeof(ctl[0]));
+	}
+
+	if (cached < _max_actuators) {
+		int ret = io_reg_get(PX4IO_PAGE_SERVOS, cached, &ctl[cached], _max_actuators - cached);
+
+		if (ret != OK)
+			return ret;
+	}
 
 	/* convert from register format to float */
 	for (unsigned i = 0; i < _max_actuators; i++)
@@ -1715,6 +2084,45 @@ PX4IO::io_reg_set(uint8_t page, uint8_t offset, const uint16_t *values, unsigned
 	return OK;
 }
 
+int
+PX4IO::io_reg_set_changed(uint8_t page, page_cache &cache, const uint16_t *values, unsigned num_values)
+{
+	if (num_values > (sizeof(cache.values) / sizeof(cache.values[0])))
+		return -EINVAL;
+
+	/* the span of values that differ from what IO is known to have */
+	unsigned first = num_values;
+	unsigned last = 0;
+
+	for (unsigned i = 0; i < num_values; i++) {
+		if ((i >= cache.count) || (cache.values[i] != values[i])) {
+			if (first == num_values)
+				first = i;
+
+			last = i;
+		}
+	}
+
+	if (first == num_values)
+		return OK;
+
+	int ret = io_reg_set(page, first, &values[first], last - first + 1);
+
+	if (ret != OK) {
+		/* unknown what IO took */
+		cache.count = 0;
+		return ret;
+	}
+
+	memcpy(&cache.values[first], &values[first], (last - first + 1) * sizeof(values[0]));
+
+	/* values past the known ones count as changed, so there is no gap */
+	if (cache.count < last + 1)
+		cache.count = last + 1;
+
+	return OK;
+}
+
 int
 PX4IO::io_reg_set(uint8_t page, uint8_t offset, uint16_t value)
 {
@@ -1813,20 +2221,24 @@ PX4IO::print_debug()
 }
 
 int
-PX4IO::mixer_send(const char *buf, unsigned buflen, unsigned retries)
+PX4IO::mixer_send(const char *buf, unsigned buflen, unsigned retries, bool binary)
 {
+	const uint8_t binary_flag = binary ? F2I_MIXER_ACTION_BINARY : 0;
+
 	/* get debug level */
 	int debuglevel = io_reg_get(PX4IO_PAGE_SETUP, PX4IO_P_SETUP_SET_DEBUG);
 
-	uint8_t	frame[_max_transfer];
+	/* larger packets would not fit next to a partial mixer in the IO buffer */
+	const unsigned frame_size = (_max_transfer < F2I_MIXER_MAX_FRAME) ? _max_transfer : F2I_MIXER_MAX_FRAME;
+	uint8_t	frame[frame_size];
 
 	do {
 
 		px4io_mixdata *msg = (px4io_mixdata *)&frame[0];
-		unsigned max_len = _max_transfer - sizeof(px4io_mixdata);
+		unsigned max_len = frame_size - sizeof(px4io_mixdata);
 
 		msg->f2i_mixer_magic = F2I_MIXER_MAGIC;
-		msg->action = F2I_MIXER_ACTION_RESET;
+		msg->action = F2I_MIXER_ACTION_RESET | binary_flag;
 
 		do {
 			unsigned count = buflen;
@@ -1848,7 +2260,7 @@ PX4IO::mixer_send(const char *buf, unsigned buflen, unsigned retries)
 			 * will only happen on the very last transfer of a
 			 * mixer, and we are guaranteed that there will be
 			 * space left to round up as _max_transfer will be
-			 * even.
+			 * even. A zero byte is padding in binary records too.
 			 */
 			unsigned total_len = sizeof(px4io_mixdata) + count;
 
@@ -1873,7 +2285,12 @@ PX4IO::mixer_send(const char *buf, unsigned buflen, unsigned retries)
 			/* print mixer chunk */
 			if (debuglevel > 5 || ret) {
 
-				warnx("fmu sent: \"%s\"", msg->text);
+				if (binary) {
+					warnx("fmu sent %u bytes of binary mixer", count);
+
+				} else {
+					warnx("fmu sent: \"%s\"", msg->text);
+				}
 
 				/* read IO's output */
 				print_debug();
@@ -1884,29 +2301,31 @@ PX4IO::mixer_send(const char *buf, unsigned buflen, unsigned retries)
 				return ret;
 			}
 
-			msg->action = F2I_MIXER_ACTION_APPEND;
+			msg->action = F2I_MIXER_ACTION_APPEND | binary_flag;
 
 		} while (buflen > 0);
 
-		/* ensure a closing newline */
-		msg->text[0] = '\n';
-		msg->text[1] = '\0';
+		/* ensure a closing newline, binary records are complete without */
+		if (!binary) {
+			msg->text[0] = '\n';
+			msg->text[1] = '\0';
 
-		int ret;
+			int ret;
 
-		for (int i = 0; i < 30; i++) {
-			/* failed, but give it a 2nd shot */
-			ret = io_reg_set(PX4IO_PAGE_MIXERLOAD, 0, (uint16_t *)frame, (sizeof(px4io_mixdata) + 2) / 2);
+			for (int i = 0; i < 30; i++) {
+				/* failed, but give it a 2nd shot */
+				ret = io_reg_set(PX4IO_PAGE_MIXERLOAD, 0, (uint16_t *)frame, (sizeof(px4io_mixdata) + 2) / 2);
 
-			if (ret) {
-				usleep(333);
-			} else {
-				break;
+				if (ret) {
+					usleep(333);
+				} else {
+					break;
+				}
 			}
-		}
 
-		if (ret)
-			return ret;
+			if (ret)
+				return ret;
+		}
 
 		retries--;
 
@@ -2199,7 +2618,7 @@ PX4IO::ioctl(file * filep, int cmd, unsigned long arg)
 			return E2BIG;
 
 		/* copy values to registers in IO */
-		ret = io_reg_set(PX4IO_PAGE_FAILSAFE_PWM, 0, pwm->values, pwm->channel_count);
+		ret = io_reg_set_changed(PX4IO_PAGE_FAILSAFE_PWM, _failsafe_pwm, pwm->values, pwm->channel_count);
 		break;
 	}
 
@@ -2237,7 +2656,7 @@ PX4IO::ioctl(file * filep, int cmd, unsigned long arg)
 			return E2BIG;
 
 		/* copy values to registers in IO */
-		ret = io_reg_set(PX4IO_PAGE_CONTROL_MIN_PWM, 0, pwm->values, pwm->channel_count);
+		ret = io_reg_set_changed(PX4IO_PAGE_CONTROL_MIN_PWM, _min_pwm, pwm->values, pwm->channel_count);
 		break;
 	}
 
@@ -2256,7 +2675,7 @@ PX4IO::ioctl(file * filep, int cmd, unsigned long arg)
 			return E2BIG;
 
 		/* copy values to registers in IO */
-		ret = io_reg_set(PX4IO_PAGE_CONTROL_MAX_PWM, 0, pwm->values, pwm->channel_count);
+		ret = io_reg_set_changed(PX4IO_PAGE_CONTROL_MAX_PWM, _max_pwm, pwm->values, pwm->channel_count);
 		break;
 	}
 
@@ -2463,6 +2882,12 @@ PX4IO::ioctl(file * filep, int cmd, unsigned long arg)
 			break;
 		}
 
+	case MIXERIOCLOADBIN: {
+			const mixer_bin_buf_s *bin = (const mixer_bin_buf_s *)arg;
+			ret = mixer_send((const char *)bin->data, bin->length, 3, true);
+			break;
+		}
+
 	case RC_INPUT_GET: {
 			uint16_t status;
 			rc_input_values *rc_val = (rc_input_values *)arg;
@@ -2986,7 +3411,7 @@ if_test(unsigned mode)
 	int result;
 
 	if (interface) {
-		result = interface->ioctl(1, mode); /* XXX magic numbers */
+		result = interface->ioctl(PX4IO_INTERFACE_TEST, mode);
 		delete interface;
 	} else {
 		errx(1, "interface not loaded, exiting");
@@ -53,6 +53,10 @@
 
 #include <drivers/device/i2c.h>
 
+#include <modules/px4iofirmware/protocol.h>
+
+#include "px4io_interface.h"
+
 #ifdef PX4_I2C_OBDEV_PX4IO
 
 device::Device	*PX4IO_i2c_interface();
@@ -106,6 +110,10 @@ out:
 int
 PX4IO_I2C::ioctl(unsigned operation, unsigned &arg)
 {
+	/* only the test operation, no link statistics or background cycles over I2C */
+	if (operation != PX4IO_INTERFACE_TEST)
+		return -ENOTTY;
+
 	return 0;
 }
 
@@ -116,6 +124,10 @@ PX4IO_I2C::write(unsigned address, void *data, unsigned count)
 	uint8_t offset = address & 0xff;
 	const uint16_t *values = reinterpret_cast<const uint16_t *>(data);
 
+	/* a write cannot return the cycle registers over I2C */
+	if (page == PX4IO_PAGE_CYCLE)
+		return -ENOTTY;
+
 	/* set up the transfer */
 	uint8_t 	addr[2] = {
 		page,
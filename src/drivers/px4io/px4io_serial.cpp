@@ -66,7 +66,12 @@
 
 #include <systemlib/perf_counter.h>
 
+#include <uORB/topics/io_link_status.h>
+
 #include <modules/px4iofirmware/protocol.h>
+#include <modules/px4iofirmware/protocol_crc.h>
+
+#include "px4io_interface.h"
 
 #ifdef PX4IO_SERIAL_BASE
 
@@ -121,11 +126,58 @@ private:
 	/** client-waiting lock/signal */
 	sem_t			_completion_semaphore;
 
+	/** check packets with the CRC unit, until IO turns out not to support it */
+	bool			_crc_hw;
+
+	/**
+	 * Check byte of the packet in the DMA buffer.
+	 */
+	uint8_t			_packet_crc() { return _crc_hw ? crc_packet_hw(&_dma_buffer) : crc_packet(&_dma_buffer); }
+
+	/** the cycle exchange runs in the background, see write() */
+	bool			_cycle_async;
+
+	/** a background exchange was started and is not finished yet */
+	bool			_cycle_pending;
+
+	/** result of the last background exchange, -EAGAIN once handed out */
+	int			_cycle_result;
+
+	/** reply of the last background exchange, kept while the DMA buffer is reused */
+	uint16_t		_cycle_reply[PX4IO_CYCLE_COUNT];
+
+	/** start of the transaction in progress and arrival of its reply */
+	hrt_abstime		_txn_start;
+	volatile hrt_abstime	_txn_reply;
+
+	/** timeout of the transaction in progress */
+	struct timespec		_txn_deadline;
+
 	/**
 	 * Start the transaction with IO and wait for it to complete.
 	 */
 	int			_wait_complete();
 
+	/**
+	 * Start the transaction in the DMA buffer.
+	 */
+	void			_start_transaction();
+
+	/**
+	 * Wait for the transaction started last to complete.
+	 */
+	int			_finish_transaction();
+
+	/**
+	 * Check the reply to a cycle exchange and copy out its registers.
+	 */
+	int			_cycle_reply_get(uint16_t *regs);
+
+	/**
+	 * Finish a background exchange, before anything else uses the link.
+	 */
+	void			_cycle_finish();
+
 	/**
 	 * DMA completion handler.
 	 */
@@ -157,6 +209,19 @@ private:
 	perf_counter_t		_pc_idle;
 	perf_counter_t		_pc_badidle;
 
+	/**
+	 * Link statistics, timestamp and utilization are left to the reader.
+	 */
+	io_link_status_s	_link_status;
+
+	/** upper bounds of the latency buckets */
+	static const uint16_t	_latency_bounds[IO_LINK_LATENCY_BUCKETS - 1];
+
+	/**
+	 * Account a completed transaction in the latency histogram.
+	 */
+	void			_count_latency(hrt_abstime elapsed);
+
 	/* do not allow top copying this class */
 	PX4IO_serial(PX4IO_serial &);
 	PX4IO_serial& operator = (const PX4IO_serial &);
@@ -164,6 +229,7 @@ private:
 };
 
 IOPacket PX4IO_serial::_dma_buffer;
+const uint16_t PX4IO_serial::_latency_bounds[IO_LINK_LATENCY_BUCKETS - 1] = {250, 500, 750, 1000, 1500, 2000, 5000};
 static PX4IO_serial *g_interface;
 
 device::Device
@@ -179,6 +245,14 @@ PX4IO_serial::PX4IO_serial() :
 	_rx_dma_status(_dma_status_inactive),
 	_bus_semaphore(SEM_INITIALIZER(0)),
 	_completion_semaphore(SEM_INITIALIZER(0)),
+	_crc_hw(true),
+	_cycle_async(false),
+	_cycle_pending(false),
+	_cycle_result(-EAGAIN),
+	_cycle_reply{},
+	_txn_start(0),
+	_txn_reply(0),
+	_txn_deadline{},
 	_pc_txns(perf_alloc(PC_ELAPSED, "io_txns     ")),
 	_pc_dmasetup(perf_alloc(PC_ELAPSED,	"io_dmasetup ")),
 	_pc_retries(perf_alloc(PC_COUNT,	"io_retries  ")),
@@ -188,7 +262,8 @@ PX4IO_serial::PX4IO_serial() :
 	_pc_protoerrs(perf_alloc(PC_COUNT,	"io_protoerrs")),
 	_pc_uerrs(perf_alloc(PC_COUNT,		"io_uarterrs ")),
 	_pc_idle(perf_alloc(PC_COUNT,		"io_idle     ")),
-	_pc_badidle(perf_alloc(PC_COUNT,	"io_badidle  "))
+	_pc_badidle(perf_alloc(PC_COUNT,	"io_badidle  ")),
+	_link_status{}
 {
 	g_interface = this;
 }
@@ -249,6 +324,9 @@ PX4IO_serial::init()
 	stm32_configgpio(PX4IO_SERIAL_TX_GPIO);
 	stm32_configgpio(PX4IO_SERIAL_RX_GPIO);
 
+	/* clock the CRC unit */
+	crc_packet_hw_init();
+
 	/* reset & configure the UART */
 	rCR1 = 0;
 	rCR2 = 0;
@@ -289,7 +367,7 @@ PX4IO_serial::ioctl(unsigned operation, unsigned &arg)
 
 	switch (operation) {
 
-	case 1:		/* XXX magic number - test operation */
+	case PX4IO_INTERFACE_TEST:
 		switch (arg) {
 		case 0:
 			lowsyslog("test 0\n");
@@ -336,6 +414,20 @@ PX4IO_serial::ioctl(unsigned operation, unsigned &arg)
 			lowsyslog("test 2\n");
 			return 0;
 		}
+		break;
+
+	case PX4IO_INTERFACE_LINK_STATUS:
+		memcpy(reinterpret_cast<void *>(arg), &_link_status, sizeof(_link_status));
+		return 0;
+
+	case PX4IO_INTERFACE_CYCLE_ASYNC:
+		sem_wait(&_bus_semaphore);
+		_cycle_finish();
+		_cycle_async = (arg != 0);
+		_cycle_result = -EAGAIN;
+		sem_post(&_bus_semaphore);
+		return 0;
+
 	default:
 		break;
 	}
@@ -355,6 +447,36 @@ PX4IO_serial::write(unsigned address, void *data, unsigned count)
 
 	sem_wait(&_bus_semaphore);
 
+	_cycle_finish();
+
+	if (_cycle_async && (page == PX4IO_PAGE_CYCLE)) {
+		/*
+		 * Hand out the reply to the previous exchange, start this one and
+		 * leave it running. It is finished by whatever uses the link next,
+		 * usually the next cycle, long after the reply has arrived.
+		 */
+		int result = _cycle_result;
+
+		if (result == OK)
+			memcpy(data, _cycle_reply, sizeof(_cycle_reply));
+
+		_cycle_result = -EAGAIN;
+
+		_dma_buffer.count_code = count | PKT_CODE_WRITE;
+		_dma_buffer.page = page;
+		_dma_buffer.offset = offset;
+		memcpy((void *)&_dma_buffer.regs[0], (void *)values, (2 * count));
+
+		_start_transaction();
+		_cycle_pending = true;
+
+		sem_post(&_bus_semaphore);
+
+		if (result == OK)
+			result = count;
+		return result;
+	}
+
 	int result;
 	for (unsigned retries = 0; retries < 3; retries++) {
 
@@ -379,11 +501,18 @@ PX4IO_serial::write(unsigned address, void *data, unsigned count)
 				/* IO didn't like it - no point retrying */
 				result = -EINVAL;
 				perf_count(_pc_protoerrs);
+				_link_status.protocol_errors++;
+
+			} else if (page == PX4IO_PAGE_CYCLE) {
+
+				/* the reply carries the cycle registers, the caller's buffer takes PKT_MAX_REGS */
+				result = _cycle_reply_get(reinterpret_cast<uint16_t *>(data));
 			}
 
 			break;
 		}
 		perf_count(_pc_retries);
+		_link_status.retries++;
 	}
 
 	sem_post(&_bus_semaphore);
@@ -405,6 +534,8 @@ PX4IO_serial::read(unsigned address, void *data, unsigned count)
 
 	sem_wait(&_bus_semaphore);
 
+	_cycle_finish();
+
 	int result;
 	for (unsigned retries = 0; retries < 3; retries++) {
 
@@ -424,6 +555,7 @@ PX4IO_serial::read(unsigned address, void *data, unsigned count)
 				/* IO didn't like it - no point retrying */
 				result = -EINVAL;
 				perf_count(_pc_protoerrs);
+				_link_status.protocol_errors++;
 
 			/* compare the received count with the expected count */
 			} else if (PKT_COUNT(_dma_buffer) != count) {
@@ -431,6 +563,7 @@ PX4IO_serial::read(unsigned address, void *data, unsigned count)
 				/* IO returned the wrong number of registers - no point retrying */
 				result = -EIO;
 				perf_count(_pc_protoerrs);
+				_link_status.protocol_errors++;
 
 			/* successful read */				
 			} else {
@@ -442,6 +575,7 @@ PX4IO_serial::read(unsigned address, void *data, unsigned count)
 			break;
 		}
 		perf_count(_pc_retries);
+		_link_status.retries++;
 	}
 
 	sem_post(&_bus_semaphore);
@@ -453,13 +587,22 @@ PX4IO_serial::read(unsigned address, void *data, unsigned count)
 
 int
 PX4IO_serial::_wait_complete()
+{
+	_start_transaction();
+
+	return _finish_transaction();
+}
+
+void
+PX4IO_serial::_start_transaction()
 {
 	/* clear any lingering error status */
 	(void)rSR;
 	(void)rDR;
 
 	/* start RX DMA */
-	perf_begin(_pc_txns);
+	_txn_start = hrt_absolute_time();
+	_txn_reply = 0;
 	perf_begin(_pc_dmasetup);
 
 	/* DMA setup time ~3µs */
@@ -492,7 +635,7 @@ PX4IO_serial::_wait_complete()
 	/* start TX DMA - no callback if we also expect a reply */
 	/* DMA setup time ~3µs */
 	_dma_buffer.crc = 0;
-	_dma_buffer.crc = crc_packet(&_dma_buffer);
+	_dma_buffer.crc = _packet_crc();
 	stm32_dmasetup(
 		_tx_dma,
 		PX4IO_SERIAL_BASE + STM32_USART_DR_OFFSET,
@@ -512,23 +655,28 @@ PX4IO_serial::_wait_complete()
 	perf_end(_pc_dmasetup);
 
 	/* compute the deadline for a 10ms timeout */
-	struct timespec abstime;
-	clock_gettime(CLOCK_REALTIME, &abstime);
-	abstime.tv_nsec += 10*1000*1000;
-	if (abstime.tv_nsec >= 1000*1000*1000) {
-		abstime.tv_sec++;
-		abstime.tv_nsec -= 1000*1000*1000;
+	clock_gettime(CLOCK_REALTIME, &_txn_deadline);
+	_txn_deadline.tv_nsec += 10*1000*1000;
+	if (_txn_deadline.tv_nsec >= 1000*1000*1000) {
+		_txn_deadline.tv_sec++;
+		_txn_deadline.tv_nsec -= 1000*1000*1000;
 	}
+}
 
-	/* wait for the transaction to complete - 64 bytes @ 1.5Mbps ~426µs */
+int
+PX4IO_serial::_finish_transaction()
+{
+	/* wait for the transaction to complete - a full 130 byte packet @ 1.5Mbps ~870µs each way */
 	int ret;
+	bool timed_out = false;
 	for (;;) {
-		ret = sem_timedwait(&_completion_semaphore, &abstime);
+		ret = sem_timedwait(&_completion_semaphore, &_txn_deadline);
 
 		if (ret == OK) {
 			/* check for DMA errors */
 			if (_rx_dma_status & DMA_STATUS_TEIF) {
 				perf_count(_pc_dmaerrs);
+				_link_status.dma_errors++;
 				ret = -EIO;
 				break;
 			}
@@ -536,8 +684,21 @@ PX4IO_serial::_wait_complete()
 			/* check packet CRC - corrupt packet errors mean IO receive CRC error */
 			uint8_t crc = _dma_buffer.crc;
 			_dma_buffer.crc = 0;
-			if ((crc != crc_packet(&_dma_buffer)) | (PKT_CODE(_dma_buffer) == PKT_CODE_CORRUPT)) {
+			if ((crc != _packet_crc()) | (PKT_CODE(_dma_buffer) == PKT_CODE_CORRUPT)) {
+
+				/*
+				 * IO firmware without the CRC unit rejects every packet, with a
+				 * reply in CRC8. IO that has it answers in the kind of the last
+				 * packet it accepted, so once it took one of ours a transmission
+				 * error does not end up here.
+				 */
+				if (_crc_hw && (PKT_CODE(_dma_buffer) == PKT_CODE_CORRUPT) && (crc == crc_packet(&_dma_buffer))) {
+					_crc_hw = false;
+					debug("IO without CRC unit support, using CRC8");
+				}
+
 				perf_count(_pc_crcerrs);
+				_link_status.crc_errors++;
 				ret = -EIO;
 				break;
 			}
@@ -550,7 +711,8 @@ PX4IO_serial::_wait_complete()
 			/* something has broken - clear out any partial DMA state and reconfigure */
 			_abort_dma();
 			perf_count(_pc_timeouts);
-			perf_cancel(_pc_txns);		/* don't count this as a transaction */
+			_link_status.timeouts++;
+			timed_out = true;
 			break;
 		}
 
@@ -561,12 +723,71 @@ PX4IO_serial::_wait_complete()
 	/* reset DMA status */
 	_rx_dma_status = _dma_status_inactive;
 
-	/* update counters */
-	perf_end(_pc_txns);
+	/* update counters, a background exchange may be finished long after its reply arrived */
+	hrt_abstime elapsed = ((_txn_reply != 0) ? _txn_reply : hrt_absolute_time()) - _txn_start;
+
+	if (timed_out) {
+		/* the link was given up on at the deadline, not counted as a transaction */
+		_link_status.busy_us += (elapsed < 10000) ? elapsed : 10000;
+
+	} else {
+		_link_status.busy_us += elapsed;
+		perf_set_elapsed(_pc_txns, elapsed);
+		_count_latency(elapsed);
+	}
 
 	return ret;
 }
 
+int
+PX4IO_serial::_cycle_reply_get(uint16_t *regs)
+{
+	if (PKT_CODE(_dma_buffer) == PKT_CODE_ERROR) {
+		perf_count(_pc_protoerrs);
+		_link_status.protocol_errors++;
+		return -EINVAL;
+	}
+
+	if (PKT_COUNT(_dma_buffer) != PX4IO_CYCLE_COUNT) {
+		perf_count(_pc_protoerrs);
+		_link_status.protocol_errors++;
+		return -EIO;
+	}
+
+	memcpy(regs, &_dma_buffer.regs[0], 2 * PX4IO_CYCLE_COUNT);
+	return OK;
+}
+
+void
+PX4IO_serial::_cycle_finish()
+{
+	if (!_cycle_pending)
+		return;
+
+	_cycle_pending = false;
+
+	/* not repeated on error, the next cycle carries newer controls anyway */
+	_cycle_result = _finish_transaction();
+
+	if (_cycle_result == OK)
+		_cycle_result = _cycle_reply_get(_cycle_reply);
+}
+
+void
+PX4IO_serial::_count_latency(hrt_abstime elapsed)
+{
+	unsigned bucket = 0;
+
+	while ((bucket < IO_LINK_LATENCY_BUCKETS - 1) && (elapsed > _latency_bounds[bucket]))
+		bucket++;
+
+	_link_status.transactions++;
+	_link_status.latency[bucket]++;
+
+	if (elapsed > _link_status.latency_max_us)
+		_link_status.latency_max_us = (elapsed < UINT16_MAX) ? elapsed : UINT16_MAX;
+}
+
 void
 PX4IO_serial::_dma_callback(DMA_HANDLE handle, uint8_t status, void *arg)
 {
@@ -597,6 +818,7 @@ PX4IO_serial::_do_rx_dma_callback(unsigned status)
 		rCR3 &= ~(USART_CR3_DMAT | USART_CR3_DMAR);
 
 		/* complete now */
+		_txn_reply = hrt_absolute_time();
 		sem_post(&_completion_semaphore);
 	}
 }
@@ -627,6 +849,7 @@ PX4IO_serial::_do_interrupt()
 			_abort_dma();
 
 			perf_count(_pc_uerrs);
+			_link_status.uart_errors++;
 			/* complete DMA as though in error */
 			_do_rx_dma_callback(DMA_STATUS_TEIF);
 
@@ -648,6 +871,7 @@ PX4IO_serial::_do_interrupt()
 			size_t length = sizeof(_dma_buffer) - stm32_dmaresidual(_rx_dma);
 			if ((length < 1) || (length < PKT_SIZE(_dma_buffer))) {
 				perf_count(_pc_badidle);
+				_link_status.short_packets++;
 
 				/* stop the receive DMA */
 				stm32_dmastop(_rx_dma);
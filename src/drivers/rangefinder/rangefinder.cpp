@@ -0,0 +1,608 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014, 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file rangefinder.cpp
+ *
+ * Common base of the I2C rangefinder drivers and their per bus scheduling.
+ */
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <systemlib/err.h>
+#include <systemlib/work_profile.h>
+
+#include <uORB/uORB.h>
+#include <uORB/topics/subsystem_info.h>
+
+#include "rangefinder.h"
+
+/* oddly, ERROR is not defined for c++ */
+#ifdef ERROR
+# undef ERROR
+#endif
+static const int ERROR = -1;
+
+/** Number of I2C buses that can carry rangefinders */
+#define RANGEFINDER_MAX_BUSES	4
+
+/**
+ * The sensors on one I2C bus and the work item that cycles through them.
+ *
+ * Each cycle collects the sensor triggered by the previous one, then
+ * triggers the next sensor that is due, starting after the one triggered
+ * last so every sensor gets its turn. The next cycle runs when that
+ * measurement is done, or when the next sensor becomes due.
+ */
+class RangeFinderBus
+{
+public:
+	RangeFinderBus(int bus);
+
+	/**
+	 * The scheduler of a bus, created on first use.
+	 */
+	static RangeFinderBus	*get(int bus);
+
+	void		add(RangeFinder *dev);
+	void		remove(RangeFinder *dev);
+
+	/**
+	 * Make sure the sensors are being cycled through, after one was started.
+	 */
+	void		kick();
+
+	void		print_info();
+
+private:
+	const int	_bus;
+	work_s		_work;
+	RangeFinder	*_head;
+	RangeFinder	*_active;		///< triggered, waiting to be collected
+	RangeFinder	*_last;			///< triggered last, the round robin continues after it
+	bool		_running;		///< a cycle is scheduled
+
+	static RangeFinderBus	*_buses[RANGEFINDER_MAX_BUSES];
+
+	static void	cycle_trampoline(void *arg);
+	void		cycle();
+	void		schedule(unsigned delay_us);
+};
+
+RangeFinderBus *RangeFinderBus::_buses[RANGEFINDER_MAX_BUSES];
+
+RangeFinderBus::RangeFinderBus(int bus) :
+	_bus(bus),
+	_head(nullptr),
+	_active(nullptr),
+	_last(nullptr),
+	_running(false)
+{
+	// work_cancel will explode if we don't do this...
+	memset(&_work, 0, sizeof(_work));
+}
+
+RangeFinderBus *
+RangeFinderBus::get(int bus)
+{
+	if (bus < 0 || bus >= RANGEFINDER_MAX_BUSES) {
+		return nullptr;
+	}
+
+	/* buses are created from the shell only, and never go away */
+	if (_buses[bus] == nullptr) {
+		_buses[bus] = new RangeFinderBus(bus);
+	}
+
+	return _buses[bus];
+}
+
+void
+RangeFinderBus::add(RangeFinder *dev)
+{
+	irqstate_t flags = irqsave();
+	dev->_bus_next = _head;
+	_head = dev;
+	irqrestore(flags);
+}
+
+void
+RangeFinderBus::remove(RangeFinder *dev)
+{
+	irqstate_t flags = irqsave();
+
+	for (RangeFinder **p = &_head; *p != nullptr; p = &(*p)->_bus_next) {
+		if (*p == dev) {
+			*p = dev->_bus_next;
+			break;
+		}
+	}
+
+	if (_active == dev) {
+		_active = nullptr;
+	}
+
+	if (_last == dev) {
+		_last = nullptr;
+	}
+
+	irqrestore(flags);
+}
+
+void
+RangeFinderBus::kick()
+{
+	irqstate_t flags = irqsave();
+	bool start = !_running;
+	_running = true;
+	irqrestore(flags);
+
+	if (start) {
+		schedule(0);
+	}
+}
+
+void
+RangeFinderBus::schedule(unsigned delay_us)
+{
+	/* at least one tick, so that a cycle never runs from the caller's context */
+	unsigned ticks = USEC2TICK(delay_us);
+
+	work_queue_profiled(HPWORK, &_work, (worker_t)&RangeFinderBus::cycle_trampoline, this,
+			    (ticks > 0) ? ticks : 1, "rangefinder");
+}
+
+void
+RangeFinderBus::cycle_trampoline(void *arg)
+{
+	RangeFinderBus *bus = (RangeFinderBus *)arg;
+
+	bus->cycle();
+}
+
+void
+RangeFinderBus::cycle()
+{
+	/* collect the measurement in flight */
+	irqstate_t flags = irqsave();
+	RangeFinder *done = _active;
+	_active = nullptr;
+	irqrestore(flags);
+
+	if (done != nullptr && OK != done->collect_report()) {
+		done->log("collection error");
+	}
+
+	/* trigger the next sensor that is due, or find out when one will be */
+	hrt_abstime now = hrt_absolute_time();
+	RangeFinder *next = nullptr;
+	hrt_abstime earliest = 0;
+
+	flags = irqsave();
+
+	RangeFinder *start = (_last != nullptr && _last->_bus_next != nullptr) ? _last->_bus_next : _head;
+	RangeFinder *dev = start;
+
+	while (dev != nullptr) {
+		if (dev->_measure_interval > 0) {
+			if (dev->_next_measure <= now) {
+				next = dev;
+				break;
+			}
+
+			if (earliest == 0 || dev->_next_measure < earliest) {
+				earliest = dev->_next_measure;
+			}
+		}
+
+		dev = (dev->_bus_next != nullptr) ? dev->_bus_next : _head;
+
+		if (dev == start) {
+			break;
+		}
+	}
+
+	if (next != nullptr) {
+		_active = next;
+		_last = next;
+		next->_next_measure = now + next->_measure_interval;
+
+	} else if (earliest == 0) {
+		/* nothing is polled any more, go idle until a sensor is started */
+		_running = false;
+	}
+
+	irqrestore(flags);
+
+	if (next != nullptr) {
+		if (OK != next->measure()) {
+			next->log("measure error");
+			_active = nullptr;
+		}
+
+		/* the bus belongs to this sensor until its measurement is done */
+		schedule(next->_conversion_interval);
+
+	} else if (earliest != 0) {
+		schedule(earliest - now);
+	}
+}
+
+void
+RangeFinderBus::print_info()
+{
+	printf("bus %d:", _bus);
+
+	for (RangeFinder *dev = _head; dev != nullptr; dev = dev->_bus_next) {
+		printf(" %s%s", dev->_path, (dev->_measure_interval > 0) ? "" : " (manual)");
+	}
+
+	printf("\n");
+}
+
+RangeFinder::RangeFinder(const char *name, const char *devname, int bus, uint16_t address, uint32_t frequency,
+			 unsigned type, unsigned conversion_interval, float min_distance, float max_distance) :
+	I2C(name, devname, bus, address, frequency),
+	_sample_perf(nullptr),
+	_comms_errors(nullptr),
+	_path(devname),
+	_type(type),
+	_conversion_interval(conversion_interval),
+	_min_distance(min_distance),
+	_max_distance(max_distance),
+	_reports(nullptr),
+	_buffer_overflows(nullptr),
+	_class_instance(-1),
+	_orb_instance(-1),
+	_range_finder_topic(-1),
+	_measure_interval(0),
+	_next_measure(0),
+	_scheduler(nullptr),
+	_bus_next(nullptr)
+{
+	snprintf(_perf_names[0], sizeof(_perf_names[0]), "%s_read", name);
+	snprintf(_perf_names[1], sizeof(_perf_names[1]), "%s_comms_errors", name);
+	snprintf(_perf_names[2], sizeof(_perf_names[2]), "%s_buffer_overflows", name);
+
+	_sample_perf = perf_alloc(PC_ELAPSED, _perf_names[0]);
+	_comms_errors = perf_alloc(PC_COUNT, _perf_names[1]);
+	_buffer_overflows = perf_alloc(PC_COUNT, _perf_names[2]);
+}
+
+RangeFinder::~RangeFinder()
+{
+	/* make sure we are truly inactive */
+	if (_scheduler != nullptr) {
+		_scheduler->remove(this);
+	}
+
+	/* free any existing reports */
+	if (_reports != nullptr) {
+		delete _reports;
+	}
+
+	if (_class_instance != -1) {
+		unregister_class_devname(RANGE_FINDER_DEVICE_PATH, _class_instance);
+	}
+
+	// free perf counters
+	perf_free(_sample_perf);
+	perf_free(_comms_errors);
+	perf_free(_buffer_overflows);
+}
+
+int
+RangeFinder::init()
+{
+	/* do I2C init (and probe) first */
+	if (I2C::init() != OK) {
+		return ERROR;
+	}
+
+	/* allocate basic report buffers */
+	_reports = new RingBuffer(2, sizeof(range_finder_report));
+
+	if (_reports == nullptr) {
+		return ERROR;
+	}
+
+	_scheduler = RangeFinderBus::get(_bus);
+
+	if (_scheduler == nullptr) {
+		log("no scheduler for bus %d", _bus);
+		return ERROR;
+	}
+
+	_class_instance = register_class_devname(RANGE_FINDER_DEVICE_PATH);
+
+	/* every sensor gets its own instance, the first one started is instance 0 */
+	struct range_finder_report zero_report;
+	memset(&zero_report, 0, sizeof(zero_report));
+	zero_report.type = _type;
+	zero_report.minimum_distance = _min_distance;
+	zero_report.maximum_distance = _max_distance;
+
+	_range_finder_topic = orb_advertise_multi(ORB_ID(sensor_range_finder), &zero_report, &_orb_instance);
+
+	if (_range_finder_topic < 0) {
+		debug("failed to create sensor_range_finder object. Did you start uOrb?");
+	}
+
+	_scheduler->add(this);
+
+	return OK;
+}
+
+int
+RangeFinder::ioctl(struct file *filp, int cmd, unsigned long arg)
+{
+	switch (cmd) {
+
+	case SENSORIOCSPOLLRATE: {
+			switch (arg) {
+
+			/* switching to manual polling */
+			case SENSOR_POLLRATE_MANUAL:
+				stop();
+				return OK;
+
+			/* external signalling (DRDY) not supported */
+			case SENSOR_POLLRATE_EXTERNAL:
+
+			/* zero would be bad */
+			case 0:
+				return -EINVAL;
+
+			/* set default/max polling rate */
+			case SENSOR_POLLRATE_MAX:
+			case SENSOR_POLLRATE_DEFAULT:
+				/* set interval for next measurement to minimum legal value */
+				_measure_interval = _conversion_interval;
+				start();
+				return OK;
+
+			/* adjust to a legal polling interval in Hz */
+			default: {
+					unsigned interval = 1000000 / arg;
+
+					/* check against maximum rate */
+					if (interval < _conversion_interval) {
+						return -EINVAL;
+					}
+
+					_measure_interval = interval;
+					start();
+					return OK;
+				}
+			}
+		}
+
+	case SENSORIOCGPOLLRATE:
+		if (_measure_interval == 0) {
+			return SENSOR_POLLRATE_MANUAL;
+		}
+
+		return (1000000 / _measure_interval);
+
+	case SENSORIOCSQUEUEDEPTH: {
+			/* lower bound is mandatory, upper bound is a sanity check */
+			if ((arg < 1) || (arg > 100)) {
+				return -EINVAL;
+			}
+
+			irqstate_t flags = irqsave();
+
+			if (!_reports->resize(arg)) {
+				irqrestore(flags);
+				return -ENOMEM;
+			}
+
+			irqrestore(flags);
+
+			return OK;
+		}
+
+	case SENSORIOCGQUEUEDEPTH:
+		return _reports->size();
+
+	case SENSORIOCRESET:
+		/* XXX implement this */
+		return -EINVAL;
+
+	case RANGEFINDERIOCSETMINIUMDISTANCE:
+		_min_distance = *(float *)arg;
+		return OK;
+
+	case RANGEFINDERIOCSETMAXIUMDISTANCE:
+		_max_distance = *(float *)arg;
+		return OK;
+
+	default:
+		/* give it to the superclass */
+		return I2C::ioctl(filp, cmd, arg);
+	}
+}
+
+ssize_t
+RangeFinder::read(struct file *filp, char *buffer, size_t buflen)
+{
+	unsigned count = buflen / sizeof(struct range_finder_report);
+	struct range_finder_report *rbuf = reinterpret_cast<struct range_finder_report *>(buffer);
+	int ret = 0;
+
+	/* buffer must be large enough */
+	if (count < 1) {
+		return -ENOSPC;
+	}
+
+	/* if automatic measurement is enabled */
+	if (_measure_interval > 0) {
+
+		/*
+		 * While there is space in the caller's buffer, and reports, copy them.
+		 * Note that we may be pre-empted by the workq thread while we are doing this;
+		 * we are careful to avoid racing with them.
+		 */
+		while (count--) {
+			if (_reports->get(rbuf)) {
+				ret += sizeof(*rbuf);
+				rbuf++;
+			}
+		}
+
+		/* if there was no data, warn the caller */
+		return ret ? ret : -EAGAIN;
+	}
+
+	/* manual measurement - run one conversion */
+	do {
+		_reports->flush();
+
+		/* trigger a measurement */
+		if (OK != measure()) {
+			ret = -EIO;
+			break;
+		}
+
+		/* wait for it to complete */
+		usleep(_conversion_interval);
+
+		/* run the collection phase */
+		if (OK != collect_report()) {
+			ret = -EIO;
+			break;
+		}
+
+		/* state machine will have generated a report, copy it out */
+		if (_reports->get(rbuf)) {
+			ret = sizeof(*rbuf);
+		}
+
+	} while (0);
+
+	return ret;
+}
+
+int
+RangeFinder::collect_report()
+{
+	float distance;
+
+	perf_begin(_sample_perf);
+
+	int ret = collect(distance);
+
+	if (ret != OK) {
+		perf_count(_comms_errors);
+		perf_end(_sample_perf);
+		return ret;
+	}
+
+	struct range_finder_report report;
+
+	/* this should be fairly close to the end of the measurement, so the best approximation of the time */
+	report.timestamp = hrt_absolute_time();
+	report.error_count = perf_event_count(_comms_errors);
+	report.type = _type;
+	report.distance = distance;
+	report.minimum_distance = _min_distance;
+	report.maximum_distance = _max_distance;
+	report.valid = (distance > _min_distance && distance < _max_distance) ? 1 : 0;
+
+	if (_range_finder_topic >= 0) {
+		orb_publish(ORB_ID(sensor_range_finder), _range_finder_topic, &report);
+	}
+
+	if (_reports->force(&report)) {
+		perf_count(_buffer_overflows);
+	}
+
+	/* notify anyone waiting for data */
+	poll_notify(POLLIN);
+
+	perf_end(_sample_perf);
+	return OK;
+}
+
+void
+RangeFinder::start()
+{
+	/* reset the report ring, measure as soon as it is our turn */
+	_reports->flush();
+	_next_measure = hrt_absolute_time();
+
+	_scheduler->kick();
+
+	/* notify about state change */
+	struct subsystem_info_s info = {
+		true,
+		true,
+		true,
+		SUBSYSTEM_TYPE_RANGEFINDER
+	};
+	static orb_advert_t pub = -1;
+
+	if (pub > 0) {
+		orb_publish(ORB_ID(subsystem_info), pub, &info);
+
+	} else {
+		pub = orb_advertise(ORB_ID(subsystem_info), &info);
+	}
+}
+
+void
+RangeFinder::stop()
+{
+	/* the scheduler skips sensors without an interval, and goes idle without any */
+	_measure_interval = 0;
+}
+
+void
+RangeFinder::print_info()
+{
+	perf_print_counter(_sample_perf);
+	perf_print_counter(_comms_errors);
+	perf_print_counter(_buffer_overflows);
+	printf("poll interval:  %u us\n", _measure_interval);
+	printf("topic instance: %d\n", _orb_instance);
+	_reports->print_info("report queue");
+	_scheduler->print_info();
+}
@@ -0,0 +1,155 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file rangefinder.h
+ *
+ * Common base of the I2C rangefinder drivers.
+ *
+ * All rangefinders on one I2C bus share a single work item that triggers
+ * them one at a time, round robin: a sensor is only triggered once the
+ * measurement of the previous one has been collected. Sonars on the same
+ * bus thus never ping at the same time, and adding sensors adds bus
+ * time but no further scheduling.
+ *
+ * Every sensor publishes its own instance of sensor_range_finder.
+ */
+
+#pragma once
+
+#include <nuttx/config.h>
+#include <nuttx/wqueue.h>
+
+#include <drivers/device/i2c.h>
+#include <drivers/device/ringbuffer.h>
+#include <drivers/drv_hrt.h>
+#include <drivers/drv_range_finder.h>
+
+#include <systemlib/perf_counter.h>
+
+#ifndef CONFIG_SCHED_WORKQUEUE
+# error This requires CONFIG_SCHED_WORKQUEUE.
+#endif
+
+class RangeFinderBus;
+
+class __EXPORT RangeFinder : public device::I2C
+{
+public:
+	/**
+	 * @param name			Driver name, also the prefix of its perf counters (lower case)
+	 * @param devname		Device node name
+	 * @param bus			I2C bus the sensor is on
+	 * @param address		I2C address of the sensor
+	 * @param frequency		I2C bus frequency
+	 * @param type			One of RANGE_FINDER_TYPE
+	 * @param conversion_interval	Time in microseconds from triggering a measurement to its result
+	 * @param min_distance		Default lower end of the valid range in meters
+	 * @param max_distance		Default upper end of the valid range in meters
+	 */
+	RangeFinder(const char *name, const char *devname, int bus, uint16_t address, uint32_t frequency,
+		    unsigned type, unsigned conversion_interval, float min_distance, float max_distance);
+	virtual ~RangeFinder();
+
+	virtual int	init();
+
+	virtual ssize_t	read(struct file *filp, char *buffer, size_t buflen);
+	virtual int	ioctl(struct file *filp, int cmd, unsigned long arg);
+
+	/**
+	 * Diagnostics - print some basic information about the driver.
+	 */
+	virtual void	print_info();
+
+protected:
+	/**
+	 * Trigger a measurement.
+	 *
+	 * @return		OK if the measurement was started.
+	 */
+	virtual int	measure() = 0;
+
+	/**
+	 * Read the result of the measurement triggered last.
+	 *
+	 * @param distance	Set to the measured distance in meters.
+	 * @return		OK if a distance was read.
+	 */
+	virtual int	collect(float &distance) = 0;
+
+	perf_counter_t	_sample_perf;
+	perf_counter_t	_comms_errors;
+
+private:
+	friend class RangeFinderBus;
+
+	const char	*const _path;
+	const unsigned	_type;
+	const unsigned	_conversion_interval;
+	float		_min_distance;
+	float		_max_distance;
+
+	RingBuffer	*_reports;
+	perf_counter_t	_buffer_overflows;
+
+	int		_class_instance;
+	int		_orb_instance;
+	orb_advert_t	_range_finder_topic;
+
+	unsigned	_measure_interval;	///< time between measurements in microseconds, 0 if polled manually
+	hrt_abstime	_next_measure;		///< time the next measurement is due
+	RangeFinderBus	*_scheduler;
+	RangeFinder	*_bus_next;		///< next sensor on the same bus
+
+	char		_perf_names[3][24];	///< the perf counters only keep a pointer to their name
+
+	/* this class has pointer data members and should not be copied */
+	RangeFinder(const RangeFinder &);
+	RangeFinder &operator=(const RangeFinder &);
+
+	/**
+	 * Start automatic measurements at _measure_interval.
+	 */
+	void		start();
+
+	/**
+	 * Stop automatic measurements.
+	 */
+	void		stop();
+
+	/**
+	 * Collect the measurement triggered last and publish it.
+	 */
+	int		collect_report();
+};
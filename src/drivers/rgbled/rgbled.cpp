@@ -56,6 +56,7 @@
 
 #include <nuttx/wqueue.h>
 
+#include <systemlib/work_profile.h>
 #include <systemlib/perf_counter.h>
 #include <systemlib/err.h>
 #include <systemlib/systemlib.h>
@@ -317,7 +318,7 @@ RGBLED::led()
 	_counter++;
 
 	/* re-queue ourselves to run again later */
-	work_queue(LPWORK, &_work, (worker_t)&RGBLED::led_trampoline, this, _led_interval);
+	work_queue_profiled(LPWORK, &_work, (worker_t)&RGBLED::led_trampoline, this, _led_interval, "rgbled");
 }
 
 /**
@@ -490,7 +491,7 @@ RGBLED::set_mode(rgbled_mode_t mode)
 		/* if it should run now, start the workq */
 		if (_should_run && !_running) {
 			_running = true;
-			work_queue(LPWORK, &_work, (worker_t)&RGBLED::led_trampoline, this, 1);
+			work_queue_profiled(LPWORK, &_work, (worker_t)&RGBLED::led_trampoline, this, 1, "rgbled");
 		}
 
 	}
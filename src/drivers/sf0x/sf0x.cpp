@@ -59,6 +59,7 @@
 #include <nuttx/wqueue.h>
 #include <nuttx/clock.h>
 
+#include <systemlib/work_profile.h>
 #include <systemlib/perf_counter.h>
 #include <systemlib/err.h>
 
@@ -265,10 +266,10 @@ SF0X::init()
 		goto out;
 	}
 
-	/* get a publish handle on the range finder topic */
+	/* get a publish handle on our own instance of the range finder topic */
 	struct range_finder_report zero_report;
 	memset(&zero_report, 0, sizeof(zero_report));
-	_range_finder_topic = orb_advertise(ORB_ID(sensor_range_finder), &zero_report);
+	_range_finder_topic = orb_advertise_multi(ORB_ID(sensor_range_finder), &zero_report, nullptr);
 
 	if (_range_finder_topic < 0) {
 		warnx("advert err");
@@ -563,7 +564,10 @@ SF0X::collect()
 	/* this should be fairly close to the end of the measurement, so the best approximation of the time */
 	report.timestamp = hrt_absolute_time();
 	report.error_count = perf_event_count(_comms_errors);
+	report.type = RANGE_FINDER_TYPE_LASER;
 	report.distance = si_units;
+	report.minimum_distance = get_minimum_distance();
+	report.maximum_distance = get_maximum_distance();
 	report.valid = valid && (si_units > get_minimum_distance() && si_units < get_maximum_distance() ? 1 : 0);
 
 	/* publish it */
@@ -590,7 +594,7 @@ SF0X::start()
 	_reports->flush();
 
 	/* schedule a cycle to start things */
-	work_queue(HPWORK, &_work, (worker_t)&SF0X::cycle_trampoline, this, 1);
+	work_queue_profiled(HPWORK, &_work, (worker_t)&SF0X::cycle_trampoline, this, 1, "sf0x");
 
 	// /* notify about state change */
 	// struct subsystem_info_s info = {
@@ -640,11 +644,12 @@ SF0X::cycle()
 
 		if (collect_ret == -EAGAIN) {
 			/* reschedule to grab the missing bits, time to transmit 8 bytes @ 9600 bps */
-			work_queue(HPWORK,
-				   &_work,
-				   (worker_t)&SF0X::cycle_trampoline,
-				   this,
-				   USEC2TICK(1042 * 8));
+			work_queue_profiled(HPWORK,
+				            &_work,
+				            (worker_t)&SF0X::cycle_trampoline,
+				            this,
+				            USEC2TICK(1042 * 8),
+				            "sf0x");
 			return;
 		}
 
@@ -673,11 +678,12 @@ SF0X::cycle()
 		if (_measure_ticks > USEC2TICK(SF0X_CONVERSION_INTERVAL)) {
 
 			/* schedule a fresh cycle call when we are ready to measure again */
-			work_queue(HPWORK,
-				   &_work,
-				   (worker_t)&SF0X::cycle_trampoline,
-				   this,
-				   _measure_ticks - USEC2TICK(SF0X_CONVERSION_INTERVAL));
+			work_queue_profiled(HPWORK,
+				            &_work,
+				            (worker_t)&SF0X::cycle_trampoline,
+				            this,
+				            _measure_ticks - USEC2TICK(SF0X_CONVERSION_INTERVAL),
+				            "sf0x");
 
 			return;
 		}
@@ -692,11 +698,12 @@ SF0X::cycle()
 	_collect_phase = true;
 
 	/* schedule a fresh cycle call when the measurement is done */
-	work_queue(HPWORK,
-		   &_work,
-		   (worker_t)&SF0X::cycle_trampoline,
-		   this,
-		   USEC2TICK(SF0X_CONVERSION_INTERVAL));
+	work_queue_profiled(HPWORK,
+		            &_work,
+		            (worker_t)&SF0X::cycle_trampoline,
+		            this,
+		            USEC2TICK(SF0X_CONVERSION_INTERVAL),
+		            "sf0x");
 }
 
 void
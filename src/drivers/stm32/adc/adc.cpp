@@ -38,6 +38,12 @@
  *
  * This is a low-rate driver, designed for sampling things like voltages
  * and so forth. It avoids the gross complexity of the NuttX ADC driver.
+ *
+ * Boards that define ADC_DMAMAP run the ADC in continuous scan mode, with
+ * DMA writing the channel set round a buffer of ADC_DMA_SCANS scans. Each
+ * tick averages the buffer, so the published values cover the last few
+ * milliseconds rather than a single conversion, and nothing busy-waits.
+ * Other boards convert the channels one by one on each tick.
  */
 
 #include <nuttx/config.h>
@@ -61,6 +67,9 @@
 #include <arch/stm32/chip.h>
 #include <stm32.h>
 #include <stm32_gpio.h>
+#ifdef ADC_DMAMAP
+# include <stm32_dma.h>
+#endif
 
 #include <systemlib/err.h>
 #include <systemlib/perf_counter.h>
@@ -98,6 +107,15 @@
 # define rCCR		REG(STM32_ADC_CCR_OFFSET)
 #endif
 
+/* length of the regular sequence */
+#define ADC_SEQUENCE_MAX	16
+
+/*
+ * Scans averaged per tick. With 480 cycle sampling at 42MHz a scan of the
+ * FMUv2 channel set takes about 120us, so the buffer covers about 4ms.
+ */
+#define ADC_DMA_SCANS		32
+
 class ADC : public device::CDev
 {
 public:
@@ -122,6 +140,22 @@ private:
 	unsigned		_channel_count;
 	adc_msg_s		*_samples;		/**< sample buffer */
 
+#ifdef ADC_DMAMAP
+	DMA_HANDLE		_dma;
+	uint16_t		*_dma_buffer;		/**< ADC_DMA_SCANS scans of the channel set */
+	perf_counter_t		_overruns;
+
+	/**
+	 * (Re)start the DMA stream and the continuous scan.
+	 */
+	void			_scan_start();
+
+	/**
+	 * Average the scan buffer into the sample array.
+	 */
+	void			_scan_average();
+#endif
+
 	orb_advert_t		_to_system_power;
 
 	/** work trampoline */
@@ -148,6 +182,11 @@ ADC::ADC(uint32_t channels) :
 	_sample_perf(perf_alloc(PC_ELAPSED, "adc_samples")),
 	_channel_count(0),
 	_samples(nullptr),
+#ifdef ADC_DMAMAP
+	_dma(nullptr),
+	_dma_buffer(nullptr),
+	_overruns(perf_alloc(PC_COUNT, "adc_overruns")),
+#endif
 	_to_system_power(0)
 {
 	_debug_enabled = true;
@@ -161,6 +200,16 @@ ADC::ADC(uint32_t channels) :
 			_channel_count++;
 		}
 	}
+
+#ifdef ADC_DMAMAP
+	/* the scan has to fit the regular sequence */
+	if (_channel_count > ADC_SEQUENCE_MAX) {
+		_channel_count = 0;
+		return;
+	}
+
+	_dma_buffer = new uint16_t[_channel_count * ADC_DMA_SCANS];
+#endif
 	_samples = new adc_msg_s[_channel_count];
 
 	/* prefill the channel numbers in the sample array */
@@ -178,13 +227,43 @@ ADC::ADC(uint32_t channels) :
 
 ADC::~ADC()
 {
+#ifdef ADC_DMAMAP
+	if (_dma != nullptr) {
+		rCR2 &= ~(ADC_CR2_CONT | ADC_CR2_DMA);
+		stm32_dmastop(_dma);
+		stm32_dmafree(_dma);
+	}
+
+	if (_dma_buffer != nullptr)
+		delete[] _dma_buffer;
+
+	perf_free(_overruns);
+#endif
+
 	if (_samples != nullptr)
-		delete _samples;
+		delete[] _samples;
+
+	perf_free(_sample_perf);
 }
 
 int
 ADC::init()
 {
+	if (_samples == nullptr)
+		return -ENOMEM;
+
+#ifdef ADC_DMAMAP
+	if (_dma_buffer == nullptr)
+		return -ENOMEM;
+
+	_dma = stm32_dmachannel(ADC_DMAMAP);
+
+	if (_dma == nullptr) {
+		log("no DMA stream");
+		return -1;
+	}
+#endif
+
 	/* do calibration if supported */
 #ifdef ADC_CR2_CAL
 	rCR2 |= ADC_CR2_CAL;
@@ -193,9 +272,18 @@ ADC::init()
 		return -1;
 #endif
 
+#ifdef ADC_DMAMAP
+	/*
+	 * Scanning continuously there is time to spare, so use the longest
+	 * sample time, which settles best on the high impedance dividers.
+	 */
+	rSMPR1 = 0b00000111111111111111111111111111;
+	rSMPR2 = 0b00111111111111111111111111111111;
+#else
 	/* arbitrarily configure all channels for 55 cycle sample time */
 	rSMPR1 = 0b00000011011011011011011011011011;
 	rSMPR2 = 0b00011011011011011011011011011011;
+#endif
 
 	/* XXX for F2/4, might want to select 12-bit mode? */
 	rCR1 = 0;
@@ -239,6 +327,25 @@ ADC::init()
 	}
 
 
+#ifdef ADC_DMAMAP
+	/* scan the channel set in order */
+	uint32_t sqr[3] = { 0, 0, 0 };
+
+	for (unsigned i = 0; i < _channel_count; i++)
+		sqr[i / 6] |= _samples[i].am_channel << ((i % 6) * 5);
+
+	rSQR3 = sqr[0];
+	rSQR2 = sqr[1];
+	rSQR1 = sqr[2] | ((_channel_count - 1) << ADC_SQR1_L_SHIFT);
+	rCR1 = ADC_CR1_SCAN;
+
+	memset(_dma_buffer, 0, _channel_count * ADC_DMA_SCANS * sizeof(_dma_buffer[0]));
+	_scan_start();
+
+	/* let the buffer fill before anyone averages it */
+	usleep(10000);
+#endif
+
 	debug("init done");
 
 	/* create the device node */
@@ -295,12 +402,68 @@ ADC::_tick_trampoline(void *arg)
 void
 ADC::_tick()
 {
+#ifdef ADC_DMAMAP
+	/* a missed DMA request stops the ADC until it is restarted */
+	if (rSR & ADC_SR_OVR) {
+		perf_count(_overruns);
+		_scan_start();
+	}
+
+	_scan_average();
+#else
 	/* scan the channel set and sample each */
 	for (unsigned i = 0; i < _channel_count; i++)
 		_samples[i].am_data = _sample(_samples[i].am_channel);
+#endif
 	update_system_power();
 }
 
+#ifdef ADC_DMAMAP
+void
+ADC::_scan_start()
+{
+	rCR2 &= ~(ADC_CR2_CONT | ADC_CR2_DMA | ADC_CR2_DDS);
+	stm32_dmastop(_dma);
+	rSR = 0;
+
+	/* the stream wraps, so conversion n always lands in scan slot n % channels */
+	stm32_dmasetup(_dma,
+		       STM32_ADC1_BASE + STM32_ADC_DR_OFFSET,
+		       (uint32_t)_dma_buffer,
+		       _channel_count * ADC_DMA_SCANS,
+		       DMA_SCR_DIR_P2M		|
+		       DMA_SCR_MINC		|
+		       DMA_SCR_CIRC		|
+		       DMA_SCR_PSIZE_16BITS	|
+		       DMA_SCR_MSIZE_16BITS	|
+		       DMA_SCR_PBURST_SINGLE	|
+		       DMA_SCR_MBURST_SINGLE	|
+		       DMA_SCR_PRILO);
+	stm32_dmastart(_dma, NULL, NULL, false);
+
+	rCR2 |= ADC_CR2_CONT | ADC_CR2_DMA | ADC_CR2_DDS;
+	rCR2 |= ADC_CR2_SWSTART;
+}
+
+void
+ADC::_scan_average()
+{
+	perf_begin(_sample_perf);
+
+	/* DMA keeps writing meanwhile, a slot holds either its old or its new value */
+	for (unsigned i = 0; i < _channel_count; i++) {
+		uint32_t sum = 0;
+
+		for (unsigned scan = 0; scan < ADC_DMA_SCANS; scan++)
+			sum += _dma_buffer[scan * _channel_count + i];
+
+		_samples[i].am_data = (sum + ADC_DMA_SCANS / 2) / ADC_DMA_SCANS;
+	}
+
+	perf_end(_sample_perf);
+}
+#endif
+
 void
 ADC::update_system_power(void)
 {
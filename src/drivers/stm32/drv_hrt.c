@@ -61,6 +61,11 @@
 
 #include <board_config.h>
 #include <drivers/drv_hrt.h>
+#include <systemlib/perf_counter.h>
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION
+# include <systemlib/cpuload.h>
+#endif
 
 #include "chip.h"
 #include "up_internal.h"
@@ -257,6 +262,17 @@ static uint16_t			latency_actual;
 static const uint16_t		latency_buckets[LATENCY_BUCKET_COUNT] = { 1, 2, 5, 10, 20, 50, 100, 1000 };
 static uint32_t			latency_counters[LATENCY_BUCKET_COUNT + 1];
 
+/*
+ * Lateness of callouts, from their deadline to the time they are invoked.
+ * The IO coprocessor cannot spare the RAM for the histogram buckets.
+ */
+#ifdef CONFIG_STM32_STM32F10XX
+# define CALLOUT_LATE_PERF_TYPE	PC_ELAPSED
+#else
+# define CALLOUT_LATE_PERF_TYPE	PC_HISTOGRAM
+#endif
+static perf_counter_t		callout_late_perf;
+
 /* timer-specific functions */
 static void		hrt_tim_init(void);
 static int		hrt_tim_isr(int irq, void *context);
@@ -597,6 +613,10 @@ hrt_tim_isr(int irq, void *context)
 	/* grab the timer for latency tracking purposes */
 	latency_actual = rCNT;
 
+#ifdef CONFIG_SCHED_INSTRUMENTATION
+	sched_trace_irq(irq, true);
+#endif
+
 	/* copy interrupt status */
 	status = rSR;
 
@@ -630,6 +650,10 @@ hrt_tim_isr(int irq, void *context)
 		hrt_call_reschedule();
 	}
 
+#ifdef CONFIG_SCHED_INSTRUMENTATION
+	sched_trace_irq(irq, false);
+#endif
+
 	return OK;
 }
 
@@ -742,6 +766,7 @@ void
 hrt_init(void)
 {
 	sq_init(&callout_queue);
+	callout_late_perf = perf_alloc(CALLOUT_LATE_PERF_TYPE, "hrt callout late");
 	hrt_tim_init();
 
 #ifdef HRT_PPM_CHANNEL
@@ -896,6 +921,9 @@ hrt_call_invoke(void)
 		/* zero the deadline, as the call has occurred */
 		call->deadline = 0;
 
+		/* includes the callouts that ran before this one in the same interrupt */
+		perf_set_elapsed(callout_late_perf, now - deadline);
+
 		/* invoke the callout (if there is one) */
 		if (call->callout) {
 			//lldbg("call %p: %p(%p)\n", call, call->callout, call->arg);
@@ -38,6 +38,18 @@
  *
  * Works with any of the 'generic' or 'advanced' STM32 timers that
  * have output pins, does not require an interrupt.
+ *
+ * Rate groups set to PWM_RATE_ONESHOT count at close to 8MHz instead of
+ * 1MHz, so the pulses are OneShot125 width, and their counter is
+ * restarted by up_pwm_servo_trigger() to start a pulse right away.
+ *
+ * On the F4, timers the board gives a DMA stream are not written channel
+ * by channel. up_pwm_servo_set() only fills a buffer, and
+ * up_pwm_servo_trigger() has the update event start a DMA burst through
+ * DMAR into CCR1..CCR4, so all channels of the timer change within the
+ * same period. The same engine sends DShot frames for the PWM_RATE_DSHOT
+ * rates: the timer runs at the bit rate, and each update event bursts the
+ * pulse widths of the next bit of every channel, without the CPU.
  */
 
 #include <nuttx/config.h>
@@ -68,6 +80,11 @@
 #include <stm32_gpio.h>
 #include <stm32_tim.h>
 
+#ifdef CONFIG_STM32_STM32F40XX
+#  include <stm32_dma.h>
+#  define PWM_SERVO_DMA
+#endif
+
 #define REG(_tmr, _reg)	(*(volatile uint32_t *)(pwm_timers[_tmr].base + _reg))
 
 #define rCR1(_tmr)    	REG(_tmr, STM32_GTIM_CR1_OFFSET)
@@ -90,9 +107,67 @@
 #define rDMAR(_tmr)   	REG(_tmr, STM32_GTIM_DMAR_OFFSET)
 #define rBDTR(_tmr)	REG(_tmr, STM32_ATIM_BDTR_OFFSET)
 
+/* OneShot125 counts eight times faster than PWM */
+#define ONESHOT_CLOCK_FREQ	8000000
+
+/* counter clock of the timers in OneShot mode, zero for PWM at a fixed rate */
+static uint32_t		oneshot_clock[PWM_SERVO_MAX_TIMERS];
+
+#ifdef PWM_SERVO_DMA
+
+/* DShot frames: 16 bits MSB first, then low periods separating the frames */
+#define DSHOT_FRAME_BITS	16
+#define DSHOT_GAP_SLOTS		2
+#define DSHOT_SLOTS		(DSHOT_FRAME_BITS + DSHOT_GAP_SLOTS)
+
+/* throttle range of the frames, lower values are commands; 0 stops the motor */
+#define DSHOT_THROTTLE_MIN	48
+#define DSHOT_THROTTLE_MAX	2047
+
+/* pulse widths mapped onto the throttle range, below it the motor is stopped */
+#define DSHOT_PWM_MIN		1000
+#define DSHOT_PWM_MAX		2000
+
+/* the burst covers CCR1..CCR4 */
+#define DMA_BURST_LEN		4
+
+/* DMA stream of the timers updated by DMA, NULL for direct register writes */
+static DMA_HANDLE	timer_dma[PWM_SERVO_MAX_TIMERS];
+
+/* bit rate of timers sending DShot, zero for pulses */
+static uint32_t		dshot_rate[PWM_SERVO_MAX_TIMERS];
+
+/* CCR1..CCR4 for each update; only the first is used for PWM */
+static uint32_t		dma_buffer[PWM_SERVO_MAX_TIMERS][DSHOT_SLOTS][DMA_BURST_LEN];
+
+/* CCR1..CCR4 as set for PWM, copied to dma_buffer once the stream is stopped */
+static uint32_t		dma_ccr[PWM_SERVO_MAX_TIMERS][DMA_BURST_LEN];
+
+/* the values set on DShot channels, encoded when triggered */
+static servo_position_t	dshot_value[PWM_SERVO_MAX_CHANNELS];
+
+static void		pwm_timer_dma_init(unsigned timer);
+static void		pwm_timer_dma_load(unsigned timer);
+static void		pwm_timer_dma_start(unsigned timer);
+static void		dshot_encode(unsigned timer, unsigned timer_channel, servo_position_t value);
+
+static bool
+pwm_timer_is_dshot(unsigned timer)
+{
+	return dshot_rate[timer] != 0;
+}
+
+#endif
+
+static bool		pwm_timer_has_dma(unsigned timer);
+
 static void		pwm_timer_init(unsigned timer);
 static void		pwm_timer_set_rate(unsigned timer, unsigned rate);
 static void		pwm_channel_init(unsigned channel);
+static uint32_t		pwm_to_ticks(unsigned timer, servo_position_t value);
+static servo_position_t	pwm_from_ticks(unsigned timer, uint32_t ticks);
+static void		pwm_ccr_write(unsigned timer, unsigned timer_channel, uint32_t ticks);
+static uint32_t		pwm_ccr_read(unsigned timer, unsigned timer_channel);
 
 static void
 pwm_timer_init(unsigned timer)
@@ -116,10 +191,11 @@ pwm_timer_init(unsigned timer)
 		rBDTR(timer) = ATIM_BDTR_MOE;
 	}
 
-	/* configure the timer to free-run at 1MHz */
-	rPSC(timer) = (pwm_timers[timer].clock_freq / 1000000) - 1;
+#ifdef PWM_SERVO_DMA
+	pwm_timer_dma_init(timer);
+#endif
 
-	/* default to updating at 50Hz */
+	/* default to free-running at 1MHz, updating at 50Hz */
 	pwm_timer_set_rate(timer, 50);
 
 	/* note that the timer is left disabled - arming is performed separately */
@@ -128,13 +204,266 @@ pwm_timer_init(unsigned timer)
 static void
 pwm_timer_set_rate(unsigned timer, unsigned rate)
 {
-	/* configure the timer to update at the desired rate */
-	rARR(timer) = 1000000 / rate;
+	servo_position_t values[4] = {0, 0, 0, 0};
+
+	/* the pulse widths are kept in counts, so they change scale with the clock */
+	for (unsigned i = 0; i < PWM_SERVO_MAX_CHANNELS; i++) {
+		if ((pwm_channels[i].timer_index == timer) && (pwm_channels[i].timer_channel != 0))
+			values[pwm_channels[i].timer_channel - 1] = up_pwm_servo_get(i);
+	}
+
+	oneshot_clock[timer] = 0;
+
+#ifdef PWM_SERVO_DMA
+	dshot_rate[timer] = 0;
+
+	if (PWM_RATE_IS_DSHOT(rate)) {
+		/* count at the timer clock, one period per bit */
+		rPSC(timer) = 0;
+		rARR(timer) = (pwm_timers[timer].clock_freq / rate) - 1;
+		dshot_rate[timer] = rate;
+
+		/* the old values are pulse widths, stop the motors instead */
+		memset(values, 0, sizeof(values));
+
+	} else
+#endif
+	if (rate == PWM_RATE_ONESHOT) {
+		/*
+		 * Count as close to 8MHz as the timer clock divides to, the
+		 * pulse widths are scaled to the actual clock. The counter
+		 * runs as long as it can, the mixer restarts it.
+		 */
+		unsigned prescale = pwm_timers[timer].clock_freq / ONESHOT_CLOCK_FREQ;
+
+		rPSC(timer) = prescale - 1;
+		rARR(timer) = 0xffff;
+		oneshot_clock[timer] = pwm_timers[timer].clock_freq / prescale;
+
+	} else {
+		/* configure the timer to free-run at 1MHz and update at the desired rate */
+		rPSC(timer) = (pwm_timers[timer].clock_freq / 1000000) - 1;
+		rARR(timer) = 1000000 / rate;
+	}
+
+	for (unsigned i = 0; i < PWM_SERVO_MAX_CHANNELS; i++) {
+		if ((pwm_channels[i].timer_index == timer) && (pwm_channels[i].timer_channel != 0))
+			up_pwm_servo_set(i, values[pwm_channels[i].timer_channel - 1]);
+	}
+
+#ifdef PWM_SERVO_DMA
+	/* not waiting for a trigger, the timer restarts anyway */
+	pwm_timer_dma_load(timer);
+#endif
 
 	/* generate an update event; reloads the counter and all registers */
 	rEGR(timer) = GTIM_EGR_UG;
 }
 
+static uint32_t
+pwm_to_ticks(unsigned timer, servo_position_t value)
+{
+	if (oneshot_clock[timer] == 0)
+		return value;
+
+	/* an eighth of the width in microseconds, at the counter clock */
+	return ((uint32_t)value * (oneshot_clock[timer] / 1000)) / (ONESHOT_CLOCK_FREQ / 1000);
+}
+
+static servo_position_t
+pwm_from_ticks(unsigned timer, uint32_t ticks)
+{
+	if (oneshot_clock[timer] == 0)
+		return ticks;
+
+	return (ticks * (ONESHOT_CLOCK_FREQ / 1000) + oneshot_clock[timer] / 2000) / (oneshot_clock[timer] / 1000);
+}
+
+static bool
+pwm_timer_has_dma(unsigned timer)
+{
+#ifdef PWM_SERVO_DMA
+	return timer_dma[timer] != NULL;
+#else
+	return false;
+#endif
+}
+
+
+static void
+pwm_ccr_write(unsigned timer, unsigned timer_channel, uint32_t ticks)
+{
+#ifdef PWM_SERVO_DMA
+	/* loaded together with the other channels on the next trigger, OneShot restarts with the registers */
+	if (pwm_timer_has_dma(timer) && (oneshot_clock[timer] == 0)) {
+		dma_ccr[timer][timer_channel - 1] = ticks;
+		return;
+	}
+#endif
+
+	switch (timer_channel) {
+	case 1:
+		rCCR1(timer) = ticks;
+		break;
+
+	case 2:
+		rCCR2(timer) = ticks;
+		break;
+
+	case 3:
+		rCCR3(timer) = ticks;
+		break;
+
+	case 4:
+		rCCR4(timer) = ticks;
+		break;
+	}
+}
+
+static uint32_t
+pwm_ccr_read(unsigned timer, unsigned timer_channel)
+{
+#ifdef PWM_SERVO_DMA
+	if (pwm_timer_has_dma(timer) && (oneshot_clock[timer] == 0))
+		return dma_ccr[timer][timer_channel - 1];
+#endif
+
+	switch (timer_channel) {
+	case 1:
+		return rCCR1(timer);
+
+	case 2:
+		return rCCR2(timer);
+
+	case 3:
+		return rCCR3(timer);
+
+	case 4:
+		return rCCR4(timer);
+	}
+
+	return 0;
+}
+
+#ifdef PWM_SERVO_DMA
+
+static void
+pwm_timer_dma_init(unsigned timer)
+{
+	if (pwm_timers[timer].dma_map == 0)
+		return;
+
+	/* the stream stays ours across re-initialisation */
+	if (timer_dma[timer] == NULL)
+		timer_dma[timer] = stm32_dmachannel(pwm_timers[timer].dma_map);
+
+	if (timer_dma[timer] == NULL)
+		return;
+
+	/* bursts go through DMAR to CCR1..CCR4 */
+	rDCR(timer) = ((STM32_GTIM_CCR1_OFFSET / 4) << GTIM_DCR_DBA_SHIFT) |
+		      ((DMA_BURST_LEN - 1) << GTIM_DCR_DBL_SHIFT);
+
+	/* channel DMA requests come with the update event too, so any of them will do */
+	rCR2(timer) |= GTIM_CR2_CCDS;
+	rDIER(timer) |= pwm_timers[timer].dma_request;
+}
+
+static void
+pwm_timer_dma_load(unsigned timer)
+{
+	if (!pwm_timer_has_dma(timer))
+		return;
+
+	stm32_dmastop(timer_dma[timer]);
+
+	/* OneShot widths are in the registers already */
+	if (oneshot_clock[timer] != 0)
+		return;
+
+	/* DShot outputs idle low between frames */
+	bool dshot = pwm_timer_is_dshot(timer);
+
+	rCCR1(timer) = dshot ? 0 : dma_ccr[timer][0];
+	rCCR2(timer) = dshot ? 0 : dma_ccr[timer][1];
+	rCCR3(timer) = dshot ? 0 : dma_ccr[timer][2];
+	rCCR4(timer) = dshot ? 0 : dma_ccr[timer][3];
+}
+
+static void
+pwm_timer_dma_start(unsigned timer)
+{
+	unsigned slots = 1;
+
+	/*
+	 * Stop the stream before touching its buffer. A DShot frame still
+	 * going out is cut short and dropped by the ESC on its checksum; it
+	 * only happens when triggering faster than the frames take.
+	 */
+	stm32_dmastop(timer_dma[timer]);
+
+	if (pwm_timer_is_dshot(timer)) {
+		for (unsigned i = 0; i < PWM_SERVO_MAX_CHANNELS; i++) {
+			if ((pwm_channels[i].timer_index == timer) && (pwm_channels[i].timer_channel != 0))
+				dshot_encode(timer, pwm_channels[i].timer_channel, dshot_value[i]);
+		}
+
+		slots = DSHOT_SLOTS;
+
+	} else {
+		memcpy(&dma_buffer[timer][0][0], &dma_ccr[timer][0], sizeof(dma_ccr[timer]));
+	}
+
+	/*
+	 * Each DMA request of the timer, at its update event, bursts one
+	 * slot into the preload registers, which take effect at the next
+	 * update event.
+	 */
+	stm32_dmasetup(timer_dma[timer],
+		       pwm_timers[timer].base + STM32_GTIM_DMAR_OFFSET,
+		       (uint32_t)&dma_buffer[timer][0][0],
+		       slots * DMA_BURST_LEN,
+		       DMA_SCR_DIR_M2P		|
+		       DMA_SCR_MINC		|
+		       DMA_SCR_PSIZE_32BITS	|
+		       DMA_SCR_MSIZE_32BITS	|
+		       DMA_SCR_PBURST_SINGLE	|
+		       DMA_SCR_MBURST_SINGLE	|
+		       DMA_SCR_PRIHI);
+	stm32_dmastart(timer_dma[timer], NULL, NULL, false);
+}
+
+static void
+dshot_encode(unsigned timer, unsigned timer_channel, servo_position_t value)
+{
+	unsigned throttle = 0;
+
+	if (value >= DSHOT_PWM_MIN) {
+		throttle = DSHOT_THROTTLE_MIN + ((value - DSHOT_PWM_MIN) * (DSHOT_THROTTLE_MAX - DSHOT_THROTTLE_MIN)) /
+			   (DSHOT_PWM_MAX - DSHOT_PWM_MIN);
+
+		if (throttle > DSHOT_THROTTLE_MAX)
+			throttle = DSHOT_THROTTLE_MAX;
+	}
+
+	/* throttle, no telemetry request, checksum over the nibbles */
+	unsigned packet = throttle << 1;
+	packet = (packet << 4) | ((packet ^ (packet >> 4) ^ (packet >> 8)) & 0xf);
+
+	/* a one is high for three quarters of the bit, a zero for three eighths */
+	uint32_t period = rARR(timer) + 1;
+	uint32_t one = (period * 3) / 4;
+	uint32_t zero = (period * 3) / 8;
+
+	for (unsigned bit = 0; bit < DSHOT_FRAME_BITS; bit++)
+		dma_buffer[timer][bit][timer_channel - 1] = (packet & (0x8000 >> bit)) ? one : zero;
+
+	for (unsigned slot = DSHOT_FRAME_BITS; slot < DSHOT_SLOTS; slot++)
+		dma_buffer[timer][slot][timer_channel - 1] = 0;
+}
+
+#endif /* PWM_SERVO_DMA */
+
 static void
 pwm_channel_init(unsigned channel)
 {
@@ -169,6 +498,11 @@ pwm_channel_init(unsigned channel)
 		rCCER(timer) |= GTIM_CCER_CC4E;
 		break;
 	}
+
+#ifdef PWM_SERVO_DMA
+	if ((pwm_channels[channel].timer_channel >= 1) && (pwm_channels[channel].timer_channel <= 4))
+		dma_ccr[timer][pwm_channels[channel].timer_channel - 1] = pwm_channels[channel].default_value;
+#endif
 }
 
 int
@@ -181,33 +515,26 @@ up_pwm_servo_set(unsigned channel, servo_position_t value)
 
 	/* test timer for validity */
 	if ((pwm_timers[timer].base == 0) ||
-	    (pwm_channels[channel].gpio == 0))
+	    (pwm_channels[channel].gpio == 0) ||
+	    (pwm_channels[channel].timer_channel < 1) ||
+	    (pwm_channels[channel].timer_channel > 4))
 		return -1;
 
-	/* configure the channel */
-	if (value > 0)
-		value--;
-
-	switch (pwm_channels[channel].timer_channel) {
-	case 1:
-		rCCR1(timer) = value;
-		break;
-
-	case 2:
-		rCCR2(timer) = value;
-		break;
+#ifdef PWM_SERVO_DMA
+	/* encoded into the frame when triggered */
+	if (pwm_timer_is_dshot(timer)) {
+		dshot_value[channel] = value;
+		return 0;
+	}
+#endif
 
-	case 3:
-		rCCR3(timer) = value;
-		break;
+	/* configure the channel */
+	uint32_t ticks = pwm_to_ticks(timer, value);
 
-	case 4:
-		rCCR4(timer) = value;
-		break;
+	if (ticks > 0)
+		ticks--;
 
-	default:
-		return -1;
-	}
+	pwm_ccr_write(timer, pwm_channels[channel].timer_channel, ticks);
 
 	return 0;
 }
@@ -219,33 +546,22 @@ up_pwm_servo_get(unsigned channel)
 		return 0;
 
 	unsigned timer = pwm_channels[channel].timer_index;
-	servo_position_t value = 0;
+	uint32_t ticks = 0;
 
 	/* test timer for validity */
 	if ((pwm_timers[timer].base == 0) ||
-	    (pwm_channels[channel].timer_channel == 0))
+	    (pwm_channels[channel].timer_channel < 1) ||
+	    (pwm_channels[channel].timer_channel > 4))
 		return 0;
 
-	/* configure the channel */
-	switch (pwm_channels[channel].timer_channel) {
-	case 1:
-		value = rCCR1(timer);
-		break;
-
-	case 2:
-		value = rCCR2(timer);
-		break;
+#ifdef PWM_SERVO_DMA
+	if (pwm_timer_is_dshot(timer))
+		return dshot_value[channel];
+#endif
 
-	case 3:
-		value = rCCR3(timer);
-		break;
+	ticks = pwm_ccr_read(timer, pwm_channels[channel].timer_channel);
 
-	case 4:
-		value = rCCR4(timer);
-		break;
-	}
-
-	return value + 1;
+	return pwm_from_ticks(timer, ticks + 1);
 }
 
 int
@@ -277,15 +593,17 @@ up_pwm_servo_deinit(void)
 int
 up_pwm_servo_set_rate_group_update(unsigned group, unsigned rate)
 {
-	/* limit update rate to 1..10000Hz; somewhat arbitrary but safe */
-	if (rate < 1)
-		return -ERANGE;
-	if (rate > 10000)
+	/* limit update rate to 1..10000Hz; somewhat arbitrary but safe. 0 is PWM_RATE_ONESHOT */
+	if ((rate > 10000) && !PWM_RATE_IS_DSHOT(rate))
 		return -ERANGE;
 
 	if ((group >= PWM_SERVO_MAX_TIMERS) || (pwm_timers[group].base == 0))
 		return ERROR;
 
+	/* DShot frames are only sent by DMA */
+	if (PWM_RATE_IS_DSHOT(rate) && !pwm_timer_has_dma(group))
+		return -ERANGE;
+
 	pwm_timer_set_rate(group, rate);
 
 	return OK;
@@ -312,6 +630,27 @@ up_pwm_servo_get_rate_group(unsigned group)
 	return channels;
 }
 
+void
+up_pwm_servo_trigger(void)
+{
+	for (unsigned i = 0; i < PWM_SERVO_MAX_TIMERS; i++) {
+		if ((pwm_timers[i].base == 0) || !(rCR1(i) & GTIM_CR1_CEN))
+			continue;
+
+		if (oneshot_clock[i] != 0) {
+			/* restarting the counter loads the new widths and starts the pulses */
+			rEGR(i) = GTIM_EGR_UG;
+
+#ifdef PWM_SERVO_DMA
+
+		} else if (pwm_timer_has_dma(i)) {
+			/* all channels at the next update, or the next DShot frame */
+			pwm_timer_dma_start(i);
+#endif
+		}
+	}
+}
+
 void
 up_pwm_servo_arm(bool armed)
 {
@@ -319,6 +658,11 @@ up_pwm_servo_arm(bool armed)
 	for (unsigned i = 0; i < PWM_SERVO_MAX_TIMERS; i++) {
 		if (pwm_timers[i].base != 0) {
 			if (armed) {
+#ifdef PWM_SERVO_DMA
+				/* start out with what was set so far */
+				pwm_timer_dma_load(i);
+#endif
+
 				/* force an update to preload all registers */
 				rEGR(i) = GTIM_EGR_UG;
 
@@ -332,6 +676,11 @@ up_pwm_servo_arm(bool armed)
 				///* on disarm, just stop auto-reload so we don't generate runts */
 				//rCR1(i) &= ~GTIM_CR1_ARPE;
 				rCR1(i) = 0;
+
+#ifdef PWM_SERVO_DMA
+				if (pwm_timer_has_dma(i))
+					stm32_dmastop(timer_dma[i]);
+#endif
 			}
 		}
 	}
@@ -51,6 +51,8 @@ struct pwm_servo_timer {
 	uint32_t	clock_register;
 	uint32_t	clock_bit;
 	uint32_t	clock_freq;
+	uint32_t	dma_map;	/**< DMA stream for burst updates and DShot (F4 only), 0 for none */
+	uint32_t	dma_request;	/**< DIER bit requesting it, GTIM_DIER_UDE or a GTIM_DIER_CCxDE */
 };
 
 /* array of channels in logical order */
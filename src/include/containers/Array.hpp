@@ -0,0 +1,113 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file Array.hpp
+ *
+ * A vector with a fixed capacity, stored inline.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+template<class T, size_t N>
+class __EXPORT Array
+{
+public:
+	Array() : _size(0) {
+	}
+
+	/**
+	 * Append an element.
+	 *
+	 * @return false if the array is full
+	 */
+	bool push_back(const T &t) {
+		if (_size >= N) {
+			return false;
+		}
+
+		_items[_size++] = t;
+		return true;
+	}
+
+	/**
+	 * Remove the element at an index, the ones behind it move up.
+	 */
+	void erase(size_t index) {
+		if (index >= _size) {
+			return;
+		}
+
+		for (size_t i = index + 1; i < _size; i++) {
+			_items[i - 1] = _items[i];
+		}
+
+		_size--;
+	}
+
+	/**
+	 * Remove the first element equal to t.
+	 *
+	 * @return false if there was none
+	 */
+	bool remove(const T &t) {
+		for (size_t i = 0; i < _size; i++) {
+			if (_items[i] == t) {
+				erase(i);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void clear() { _size = 0; }
+
+	T &operator[](size_t index) { return _items[index]; }
+	const T &operator[](size_t index) const { return _items[index]; }
+
+	size_t size() const { return _size; }
+	static size_t capacity() { return N; }
+	bool empty() const { return _size == 0; }
+	bool full() const { return _size >= N; }
+
+	T *begin() { return &_items[0]; }
+	T *end() { return &_items[_size]; }
+
+private:
+	T _items[N];
+	size_t _size;
+};
@@ -0,0 +1,147 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file FlatMap.hpp
+ *
+ * A small map with a fixed capacity, kept as sorted arrays.
+ *
+ * Lookups are binary searches over contiguous keys, inserts and removals
+ * move the entries behind them, which is cheap for the few dozen entries
+ * it is meant for.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+template<class K, class V, size_t N>
+class __EXPORT FlatMap
+{
+public:
+	FlatMap() : _size(0) {
+	}
+
+	/**
+	 * Look up a key.
+	 *
+	 * @return the value, or nullptr if the key is not in the map
+	 */
+	V *find(const K &key) {
+		size_t i = lower_bound(key);
+		return (i < _size && !(key < _keys[i])) ? &_values[i] : nullptr;
+	}
+
+	/**
+	 * Set the value of a key, adding it if needed.
+	 *
+	 * @return false if the key is new and the map is full
+	 */
+	bool insert(const K &key, const V &value) {
+		size_t i = lower_bound(key);
+
+		if (i < _size && !(key < _keys[i])) {
+			_values[i] = value;
+			return true;
+		}
+
+		if (_size >= N) {
+			return false;
+		}
+
+		for (size_t j = _size; j > i; j--) {
+			_keys[j] = _keys[j - 1];
+			_values[j] = _values[j - 1];
+		}
+
+		_keys[i] = key;
+		_values[i] = value;
+		_size++;
+		return true;
+	}
+
+	/**
+	 * Remove a key.
+	 *
+	 * @return false if the key was not in the map
+	 */
+	bool erase(const K &key) {
+		size_t i = lower_bound(key);
+
+		if (i >= _size || key < _keys[i]) {
+			return false;
+		}
+
+		for (size_t j = i + 1; j < _size; j++) {
+			_keys[j - 1] = _keys[j];
+			_values[j - 1] = _values[j];
+		}
+
+		_size--;
+		return true;
+	}
+
+	void clear() { _size = 0; }
+
+	/** keys and values in key order */
+	const K &keyAt(size_t index) const { return _keys[index]; }
+	V &valueAt(size_t index) { return _values[index]; }
+
+	size_t size() const { return _size; }
+	static size_t capacity() { return N; }
+
+private:
+	/** index of the first key not less than key */
+	size_t lower_bound(const K &key) const {
+		size_t lo = 0;
+		size_t hi = _size;
+
+		while (lo < hi) {
+			size_t mid = (lo + hi) / 2;
+
+			if (_keys[mid] < key) {
+				lo = mid + 1;
+
+			} else {
+				hi = mid;
+			}
+		}
+
+		return lo;
+	}
+
+	K _keys[N];
+	V _values[N];
+	size_t _size;
+};
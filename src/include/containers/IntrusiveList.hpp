@@ -0,0 +1,141 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file IntrusiveList.hpp
+ *
+ * A doubly linked list through links embedded in the elements.
+ *
+ * Unlike List, an element can be removed in constant time, without
+ * walking the list to find its predecessor.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+template<class T>
+class IntrusiveList;
+
+/**
+ * Base for list elements, T is the element class.
+ */
+template<class T>
+class __EXPORT IntrusiveListNode
+{
+public:
+	IntrusiveListNode() : _list_prev(nullptr), _list_next(nullptr) {
+	}
+	T *getNext() { return _list_next; }
+	T *getPrev() { return _list_prev; }
+private:
+	friend class IntrusiveList<T>;
+	T *_list_prev;
+	T *_list_next;
+};
+
+template<class T>
+class __EXPORT IntrusiveList
+{
+public:
+	IntrusiveList() : _head(nullptr), _tail(nullptr), _size(0) {
+	}
+
+	void push_front(T *node) {
+		node->_list_prev = nullptr;
+		node->_list_next = _head;
+
+		if (_head != nullptr) {
+			_head->_list_prev = node;
+
+		} else {
+			_tail = node;
+		}
+
+		_head = node;
+		_size++;
+	}
+
+	void push_back(T *node) {
+		node->_list_prev = _tail;
+		node->_list_next = nullptr;
+
+		if (_tail != nullptr) {
+			_tail->_list_next = node;
+
+		} else {
+			_head = node;
+		}
+
+		_tail = node;
+		_size++;
+	}
+
+	/**
+	 * Remove an element, which must be in this list.
+	 */
+	void remove(T *node) {
+		if (node->_list_prev != nullptr) {
+			node->_list_prev->_list_next = node->_list_next;
+
+		} else {
+			_head = node->_list_next;
+		}
+
+		if (node->_list_next != nullptr) {
+			node->_list_next->_list_prev = node->_list_prev;
+
+		} else {
+			_tail = node->_list_prev;
+		}
+
+		node->_list_prev = nullptr;
+		node->_list_next = nullptr;
+		_size--;
+	}
+
+	T *getHead() { return _head; }
+	T *getTail() { return _tail; }
+	size_t size() const { return _size; }
+	bool empty() const { return _head == nullptr; }
+
+private:
+	T *_head;
+	T *_tail;
+	size_t _size;
+
+	/* the elements point at the list through each other, do not copy */
+	IntrusiveList(const IntrusiveList &);
+	IntrusiveList operator=(const IntrusiveList &);
+};
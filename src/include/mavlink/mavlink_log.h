@@ -100,19 +100,46 @@ __EXPORT void mavlink_vasprintf(int _fd, int severity, const char *fmt, ...);
 #define mavlink_log_info(_fd, _text, ...)		mavlink_vasprintf(_fd, MAVLINK_IOC_SEND_TEXT_INFO, _text, ##__VA_ARGS__);
 
 
+/**
+ * Least severe MAV_SEVERITY that may use the last quarter of a log buffer.
+ *
+ * Less severe messages are dropped once the buffer is three quarters full,
+ * so that a burst of info text cannot crowd out critical messages.
+ */
+#define MAVLINK_LOG_RESERVED_SEVERITY		2	/* MAV_SEVERITY_CRITICAL */
+
 struct mavlink_logmessage {
 	char text[MAVLINK_LOG_MAXLEN + 1];
 	unsigned char severity;
 };
 
+struct mavlink_logslot {
+	volatile unsigned int seq;		/**< position the slot is ready for, see mavlink_log.c */
+	struct mavlink_logmessage msg;
+};
+
+/**
+ * Bounded queue of log messages.
+ *
+ * Any number of threads may write without taking a lock. A single reader
+ * (the mavlink task that owns the buffer) may read concurrently. When the
+ * buffer is full, new messages are dropped and counted.
+ */
 struct mavlink_logbuffer {
-	unsigned int start;
-	unsigned int size;
-	int count;
-	struct mavlink_logmessage *elems;
+	unsigned int size;			/**< number of slots, a power of two */
+	volatile unsigned int head;		/**< next position to write */
+	volatile unsigned int tail;		/**< next position to read */
+	volatile unsigned int dropped;		/**< messages dropped because the buffer was full */
+	struct mavlink_logslot *elems;
 };
 
 __BEGIN_DECLS
+/**
+ * Allocate a log buffer.
+ *
+ * @param lb		The buffer.
+ * @param size		Minimum number of messages held, rounded up to a power of two.
+ */
 void mavlink_logbuffer_init(struct mavlink_logbuffer *lb, int size);
 
 void mavlink_logbuffer_destroy(struct mavlink_logbuffer *lb);
@@ -121,8 +148,18 @@ int mavlink_logbuffer_is_full(struct mavlink_logbuffer *lb);
 
 int mavlink_logbuffer_is_empty(struct mavlink_logbuffer *lb);
 
-void mavlink_logbuffer_write(struct mavlink_logbuffer *lb, const struct mavlink_logmessage *elem);
+/**
+ * Queue a message, from any thread.
+ *
+ * @return		0 if queued, 1 if dropped.
+ */
+int mavlink_logbuffer_write(struct mavlink_logbuffer *lb, const struct mavlink_logmessage *elem);
 
+/**
+ * Take the oldest message, from the reader only.
+ *
+ * @return		0 if a message was read, 1 if the buffer was empty.
+ */
 int mavlink_logbuffer_read(struct mavlink_logbuffer *lb, struct mavlink_logmessage *elem);
 
 void mavlink_logbuffer_vasprintf(struct mavlink_logbuffer *lb, int severity, const char *fmt, ...);
@@ -0,0 +1,151 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2013 Estimation and Control Library (ECL). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name ECL nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ecl_gain_schedule.h
+ * Airspeed gain schedule of the fixed wing rate controllers.
+ *
+ * The rate loop gains scale with powers of trim airspeed / airspeed. The
+ * table holds the scaled gains at evenly spaced airspeeds between the
+ * minimum and maximum airspeed, is rebuilt by the controllers when a gain
+ * or airspeed parameter changes and is interpolated at run time, so the
+ * control loop does no divisions.
+ */
+
+#ifndef ECL_GAIN_SCHEDULE_H
+#define ECL_GAIN_SCHEDULE_H
+
+#include <math.h>
+
+#define ECL_GAIN_SCHEDULE_BINS		24
+#define ECL_GAIN_SCHEDULE_MIN_AIRSPEED	0.5f	/**< lower limit of the scaling airspeed in m/s */
+
+template<unsigned N>
+class ECL_GainSchedule
+{
+public:
+	ECL_GainSchedule() :
+		_airspeed_min(0.0f),
+		_airspeed_trim(0.0f),
+		_inv_bin_width(0.0f)
+	{
+		set_airspeeds(0.0f, 0.0f, 0.0f);
+
+		for (unsigned i = 0; i < ECL_GAIN_SCHEDULE_BINS; i++) {
+			for (unsigned n = 0; n < N; n++) {
+				_gains[i][n] = 0.0f;
+			}
+		}
+	}
+
+	/**
+	 * Set the airspeed range of the table.
+	 *
+	 * The gains have to be set again for all bins afterwards.
+	 * Without a usable range all bins are at the minimum airspeed.
+	 */
+	void set_airspeeds(float airspeed_min, float airspeed_trim, float airspeed_max) {
+		_airspeed_min = airspeed_min;
+		_airspeed_trim = airspeed_trim;
+
+		float width = (airspeed_max - airspeed_min) / (ECL_GAIN_SCHEDULE_BINS - 1);
+		_inv_bin_width = (width > 0.0f) ? 1.0f / width : 0.0f;
+
+		for (unsigned i = 0; i < ECL_GAIN_SCHEDULE_BINS; i++) {
+			float airspeed = airspeed_min + ((width > 0.0f) ? i * width : 0.0f);
+
+			if (!(airspeed > ECL_GAIN_SCHEDULE_MIN_AIRSPEED)) {
+				airspeed = ECL_GAIN_SCHEDULE_MIN_AIRSPEED;
+			}
+
+			_scaler[i] = (airspeed_trim > 0.0f) ? airspeed_trim / airspeed : 1.0f;
+		}
+	}
+
+	/**
+	 * Airspeed scaler (trim airspeed / airspeed) of a bin.
+	 */
+	float scaler(unsigned bin) const {
+		return _scaler[bin];
+	}
+
+	/**
+	 * Set the gains of a bin.
+	 */
+	void set_gains(unsigned bin, const float gains[N]) {
+		for (unsigned n = 0; n < N; n++) {
+			_gains[bin][n] = gains[n];
+		}
+	}
+
+	/**
+	 * Gains at an airspeed, clamped to the table range.
+	 *
+	 * A non finite airspeed gets the gains at trim airspeed.
+	 */
+	void get_gains(float airspeed, float gains[N]) const {
+		if (!isfinite(airspeed)) {
+			airspeed = _airspeed_trim;
+		}
+
+		float x = (airspeed - _airspeed_min) * _inv_bin_width;
+		unsigned bin;
+		float frac;
+
+		if (!(x > 0.0f)) {
+			bin = 0;
+			frac = 0.0f;
+
+		} else if (x >= ECL_GAIN_SCHEDULE_BINS - 1) {
+			bin = ECL_GAIN_SCHEDULE_BINS - 2;
+			frac = 1.0f;
+
+		} else {
+			bin = (unsigned)x;
+			frac = x - bin;
+		}
+
+		for (unsigned n = 0; n < N; n++) {
+			gains[n] = _gains[bin][n] + frac * (_gains[bin + 1][n] - _gains[bin][n]);
+		}
+	}
+
+private:
+	float _airspeed_min;
+	float _airspeed_trim;
+	float _inv_bin_width;
+	float _scaler[ECL_GAIN_SCHEDULE_BINS];
+	float _gains[ECL_GAIN_SCHEDULE_BINS][N];
+};
+
+#endif // ECL_GAIN_SCHEDULE_H
@@ -132,12 +132,11 @@ float ECL_PitchController::control_attitude(float pitch_setpoint, float roll, fl
 float ECL_PitchController::control_bodyrate(float roll, float pitch,
 		float pitch_rate, float yaw_rate,
 		float yaw_rate_setpoint,
-		float airspeed_min, float airspeed_max, float airspeed, float scaler, bool lock_integrator)
+		float airspeed, bool lock_integrator)
 {
 	/* Do not calculate control signal with bad inputs */
 	if (!(isfinite(roll) && isfinite(pitch) && isfinite(pitch_rate) && isfinite(yaw_rate) &&
-				isfinite(yaw_rate_setpoint) && isfinite(airspeed_min) &&
-				isfinite(airspeed_max) && isfinite(scaler))) {
+				isfinite(yaw_rate_setpoint))) {
 		perf_count(_nonfinite_input_perf);
 		return math::constrain(_last_output, -1.0f, 1.0f);
 	}
@@ -151,13 +150,9 @@ float ECL_PitchController::control_bodyrate(float roll, float pitch,
 	if (dt_micros > 500000)
 		lock_integrator = true;
 
-	/* input conditioning */
-	if (!isfinite(airspeed)) {
-		/* airspeed is NaN, +- INF or not available, pick center of band */
-		airspeed = 0.5f * (airspeed_min + airspeed_max);
-	} else if (airspeed < airspeed_min) {
-		airspeed = airspeed_min;
-	}
+	/* gains at this airspeed, trim gains if it is not available */
+	float gains[GAIN_COUNT];
+	_gain_schedule.get_gains(airspeed, gains);
 
 	/* Transform setpoint to body angular rates */
 	_bodyrate_setpoint = cosf(roll) * _rate_setpoint + cosf(pitch) * sinf(roll) * yaw_rate_setpoint; //jacobian
@@ -167,9 +162,9 @@ float ECL_PitchController::control_bodyrate(float roll, float pitch,
 
 	_rate_error = _bodyrate_setpoint - pitch_bodyrate;
 
-	if (!lock_integrator && _k_i > 0.0f && airspeed > 0.5f * airspeed_min) {
+	if (!lock_integrator && _k_i > 0.0f) {
 
-		float id = _rate_error * dt * scaler;
+		float id = _rate_error * dt * gains[GAIN_I];
 
 		/*
 		 * anti-windup: do not allow integrator to increase if actuator is at limit
@@ -190,9 +185,9 @@ float ECL_PitchController::control_bodyrate(float roll, float pitch,
 	float integrator_constrained = math::constrain(_integrator * _k_i, -_integrator_max, _integrator_max);
 
 	/* Apply PI rate controller and store non-limited output */
-	_last_output = _bodyrate_setpoint * _k_ff * scaler +
-		_rate_error * _k_p * scaler * scaler
-		+ integrator_constrained;  //scaler is proportional to 1/airspeed
+	_last_output = _bodyrate_setpoint * gains[GAIN_FF] +
+		_rate_error * gains[GAIN_P]
+		+ integrator_constrained;
 //	warnx("pitch: _integrator: %.4f, _integrator_max: %.4f, airspeed %.4f, _k_i %.4f, _k_p: %.4f", (double)_integrator, (double)_integrator_max, (double)airspeed, (double)_k_i, (double)_k_p);
 //	warnx("roll: _last_output %.4f", (double)_last_output);
 	return math::constrain(_last_output, -1.0f, 1.0f);
@@ -202,3 +197,17 @@ void ECL_PitchController::reset_integrator()
 {
 	_integrator = 0.0f;
 }
+
+void ECL_PitchController::update_gain_schedule()
+{
+	for (unsigned i = 0; i < ECL_GAIN_SCHEDULE_BINS; i++) {
+		float scaler = _gain_schedule.scaler(i);
+		float gains[GAIN_COUNT];
+
+		gains[GAIN_P] = _k_p * scaler * scaler;
+		gains[GAIN_FF] = _k_ff * scaler;
+		gains[GAIN_I] = scaler;
+
+		_gain_schedule.set_gains(i, gains);
+	}
+}
@@ -95,12 +95,10 @@ float ECL_RollController::control_attitude(float roll_setpoint, float roll)
 float ECL_RollController::control_bodyrate(float pitch,
 		float roll_rate, float yaw_rate,
 		float yaw_rate_setpoint,
-		float airspeed_min, float airspeed_max, float airspeed, float scaler, bool lock_integrator)
+		float airspeed, bool lock_integrator)
 {
 	/* Do not calculate control signal with bad inputs */
-	if (!(isfinite(pitch) && isfinite(roll_rate) && isfinite(yaw_rate) && isfinite(yaw_rate_setpoint) &&
-			isfinite(airspeed_min) && isfinite(airspeed_max) &&
-			isfinite(scaler))) {
+	if (!(isfinite(pitch) && isfinite(roll_rate) && isfinite(yaw_rate) && isfinite(yaw_rate_setpoint))) {
 		perf_count(_nonfinite_input_perf);
 		return math::constrain(_last_output, -1.0f, 1.0f);
 	}
@@ -114,14 +112,9 @@ float ECL_RollController::control_bodyrate(float pitch,
 	if (dt_micros > 500000)
 		lock_integrator = true;
 
-	/* input conditioning */
-//	warnx("airspeed pre %.4f", (double)airspeed);
-	if (!isfinite(airspeed)) {
-		/* airspeed is NaN, +- INF or not available, pick center of band */
-		airspeed = 0.5f * (airspeed_min + airspeed_max);
-	} else if (airspeed < airspeed_min) {
-		airspeed = airspeed_min;
-	}
+	/* gains at this airspeed, trim gains if it is not available */
+	float gains[GAIN_COUNT];
+	_gain_schedule.get_gains(airspeed, gains);
 
 
 	/* Transform setpoint to body angular rates */
@@ -133,9 +126,9 @@ float ECL_RollController::control_bodyrate(float pitch,
 	/* Calculate body angular rate error */
 	_rate_error = _bodyrate_setpoint - roll_bodyrate; //body angular rate error
 
-	if (!lock_integrator && _k_i > 0.0f && airspeed > 0.5f * airspeed_min) {
+	if (!lock_integrator && _k_i > 0.0f) {
 
-		float id = _rate_error * dt * scaler;
+		float id = _rate_error * dt * gains[GAIN_I];
 
 		/*
 		* anti-windup: do not allow integrator to increase if actuator is at limit
@@ -157,9 +150,9 @@ float ECL_RollController::control_bodyrate(float pitch,
 	//warnx("roll: _integrator: %.4f, _integrator_max: %.4f", (double)_integrator, (double)_integrator_max);
 
 	/* Apply PI rate controller and store non-limited output */
-	_last_output = _bodyrate_setpoint * _k_ff * scaler +
-		_rate_error * _k_p * scaler * scaler
-		+ integrator_constrained;  //scaler is proportional to 1/airspeed
+	_last_output = _bodyrate_setpoint * gains[GAIN_FF] +
+		_rate_error * gains[GAIN_P]
+		+ integrator_constrained;
 
 	return math::constrain(_last_output, -1.0f, 1.0f);
 }
@@ -169,3 +162,17 @@ void ECL_RollController::reset_integrator()
 	_integrator = 0.0f;
 }
 
+void ECL_RollController::update_gain_schedule()
+{
+	for (unsigned i = 0; i < ECL_GAIN_SCHEDULE_BINS; i++) {
+		float scaler = _gain_schedule.scaler(i);
+		float gains[GAIN_COUNT];
+
+		gains[GAIN_P] = _k_p * scaler * scaler;
+		gains[GAIN_FF] = _k_ff * scaler;
+		gains[GAIN_I] = scaler;
+
+		_gain_schedule.set_gains(i, gains);
+	}
+}
+
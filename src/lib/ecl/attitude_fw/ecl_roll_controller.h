@@ -53,6 +53,8 @@
 #include <stdint.h>
 #include <systemlib/perf_counter.h>
 
+#include "ecl_gain_schedule.h"
+
 class __EXPORT ECL_RollController //XXX: create controller superclass
 {
 public:
@@ -65,7 +67,7 @@ public:
 	float control_bodyrate(float pitch,
 			float roll_rate, float yaw_rate,
 			float yaw_rate_setpoint,
-			float airspeed_min = 0.0f, float airspeed_max = 0.0f, float airspeed = (0.0f / 0.0f), float scaler = 1.0f, bool lock_integrator = false);
+			float airspeed = (0.0f / 0.0f), bool lock_integrator = false);
 
 	void reset_integrator();
 
@@ -77,6 +79,7 @@ public:
 
 	void set_k_p(float k_p) {
 		_k_p = k_p;
+		update_gain_schedule();
 	}
 
 	void set_k_i(float k_i) {
@@ -85,6 +88,15 @@ public:
 
 	void set_k_ff(float k_ff) {
 		_k_ff = k_ff;
+		update_gain_schedule();
+	}
+
+	/**
+	 * Set the airspeed range the gains are scheduled over.
+	 */
+	void set_airspeeds(float airspeed_min, float airspeed_trim, float airspeed_max) {
+		_gain_schedule.set_airspeeds(airspeed_min, airspeed_trim, airspeed_max);
+		update_gain_schedule();
 	}
 
 	void set_integrator_max(float max) {
@@ -121,6 +133,21 @@ private:
 	float _rate_setpoint;
 	float _bodyrate_setpoint;
 	perf_counter_t _nonfinite_input_perf;
+
+	/* scheduled gains: P and feed forward scaled by scaler^2 and scaler, integrator input scale */
+	enum {
+		GAIN_P = 0,
+		GAIN_FF,
+		GAIN_I,
+		GAIN_COUNT
+	};
+
+	ECL_GainSchedule<GAIN_COUNT> _gain_schedule;
+
+	/**
+	 * Rebuild the gain table after a gain or airspeed change.
+	 */
+	void update_gain_schedule();
 };
 
 #endif // ECL_ROLL_CONTROLLER_H
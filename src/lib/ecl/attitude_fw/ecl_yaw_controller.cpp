@@ -114,12 +114,11 @@ float ECL_YawController::control_attitude(float roll, float pitch,
 float ECL_YawController::control_bodyrate(float roll, float pitch,
 		float pitch_rate, float yaw_rate,
 		float pitch_rate_setpoint,
-		float airspeed_min, float airspeed_max, float airspeed, float scaler, bool lock_integrator)
+		float airspeed, bool lock_integrator)
 {
 	/* Do not calculate control signal with bad inputs */
 	if (!(isfinite(roll) && isfinite(pitch) && isfinite(pitch_rate) && isfinite(yaw_rate) &&
-				isfinite(pitch_rate_setpoint) && isfinite(airspeed_min) &&
-				isfinite(airspeed_max) && isfinite(scaler))) {
+				isfinite(pitch_rate_setpoint))) {
 		perf_count(_nonfinite_input_perf);
 		return math::constrain(_last_output, -1.0f, 1.0f);
 	}
@@ -132,13 +131,9 @@ float ECL_YawController::control_bodyrate(float roll, float pitch,
 	if (dt_micros > 500000)
 		lock_integrator = true;
 
-	/* input conditioning */
-	if (!isfinite(airspeed)) {
-	/* airspeed is NaN, +- INF or not available, pick center of band */
-	airspeed = 0.5f * (airspeed_min + airspeed_max);
-	} else if (airspeed < airspeed_min) {
-	airspeed = airspeed_min;
-	}
+	/* gains at this airspeed, trim gains if it is not available */
+	float gains[GAIN_COUNT];
+	_gain_schedule.get_gains(airspeed, gains);
 
 
 	/* Transform setpoint to body angular rates */
@@ -150,7 +145,7 @@ float ECL_YawController::control_bodyrate(float roll, float pitch,
 	/* Calculate body angular rate error */
 	_rate_error = _bodyrate_setpoint - yaw_bodyrate; //body angular rate error
 
-	if (!lock_integrator && _k_i > 0.0f && airspeed > 0.5f * airspeed_min) {
+	if (!lock_integrator && _k_i > 0.0f) {
 
 	float id = _rate_error * dt;
 
@@ -173,7 +168,8 @@ float ECL_YawController::control_bodyrate(float roll, float pitch,
 	float integrator_constrained = math::constrain(_integrator * _k_i, -_integrator_max, _integrator_max);
 
 	/* Apply PI rate controller and store non-limited output */
-	_last_output = (_bodyrate_setpoint * _k_ff + _rate_error * _k_p + integrator_constrained) * scaler * scaler;  //scaler is proportional to 1/airspeed
+	_last_output = _bodyrate_setpoint * gains[GAIN_FF] + _rate_error * gains[GAIN_P] +
+		integrator_constrained * gains[GAIN_I];
 	//warnx("yaw:_last_output: %.4f, _integrator: %.4f, _integrator_max: %.4f, airspeed %.4f, _k_i %.4f, _k_p: %.4f", (double)_last_output, (double)_integrator, (double)_integrator_max, (double)airspeed, (double)_k_i, (double)_k_p);
 
 
@@ -184,3 +180,17 @@ void ECL_YawController::reset_integrator()
 {
 	_integrator = 0.0f;
 }
+
+void ECL_YawController::update_gain_schedule()
+{
+	for (unsigned i = 0; i < ECL_GAIN_SCHEDULE_BINS; i++) {
+		float scaler = _gain_schedule.scaler(i);
+		float gains[GAIN_COUNT];
+
+		gains[GAIN_P] = _k_p * scaler * scaler;
+		gains[GAIN_FF] = _k_ff * scaler * scaler;
+		gains[GAIN_I] = scaler * scaler;
+
+		_gain_schedule.set_gains(i, gains);
+	}
+}
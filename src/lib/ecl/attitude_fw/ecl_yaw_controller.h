@@ -52,6 +52,8 @@
 #include <stdint.h>
 #include <systemlib/perf_counter.h>
 
+#include "ecl_gain_schedule.h"
+
 class __EXPORT ECL_YawController //XXX: create controller superclass
 {
 public:
@@ -66,12 +68,13 @@ public:
 	float control_bodyrate(	float roll, float pitch,
 			float pitch_rate, float yaw_rate,
 			float pitch_rate_setpoint,
-			float airspeed_min, float airspeed_max, float airspeed, float scaler, bool lock_integrator);
+			float airspeed = (0.0f / 0.0f), bool lock_integrator = false);
 
 	void reset_integrator();
 
 	void set_k_p(float k_p) {
-			_k_p = k_p;
+		_k_p = k_p;
+		update_gain_schedule();
 	}
 
 	void set_k_i(float k_i) {
@@ -80,6 +83,15 @@ public:
 
 	void set_k_ff(float k_ff) {
 		_k_ff = k_ff;
+		update_gain_schedule();
+	}
+
+	/**
+	 * Set the airspeed range the gains are scheduled over.
+	 */
+	void set_airspeeds(float airspeed_min, float airspeed_trim, float airspeed_max) {
+		_gain_schedule.set_airspeeds(airspeed_min, airspeed_trim, airspeed_max);
+		update_gain_schedule();
 	}
 
 	void set_integrator_max(float max) {
@@ -123,6 +135,20 @@ private:
 	float _coordinated_min_speed;
 	perf_counter_t _nonfinite_input_perf;
 
+	/* scheduled gains: P and feed forward scaled by scaler^2, integrator output scale */
+	enum {
+		GAIN_P = 0,
+		GAIN_FF,
+		GAIN_I,
+		GAIN_COUNT
+	};
+
+	ECL_GainSchedule<GAIN_COUNT> _gain_schedule;
+
+	/**
+	 * Rebuild the gain table after a gain or airspeed change.
+	 */
+	void update_gain_schedule();
 };
 
 #endif // ECL_YAW_CONTROLLER_H
@@ -95,8 +95,8 @@ void ECL_L1_Pos_Controller::navigate_waypoints(const math::Vector<2> &vector_A,
 	float xtrack_vel;
 	float ltrack_vel;
 
-	/* get the direction between the last (visited) and next waypoint */
-	_target_bearing = get_bearing_to_next_waypoint(vector_curr_position(0), vector_curr_position(1), vector_B(0), vector_B(1));
+	/* the geometry of the leg only changes with the waypoints */
+	update_leg(vector_A, vector_B);
 
 	/* enforce a minimum ground speed of 0.1 m/s to avoid singularities */
 	float ground_speed = math::max(ground_speed_vector.length(), 0.1f);
@@ -104,21 +104,22 @@ void ECL_L1_Pos_Controller::navigate_waypoints(const math::Vector<2> &vector_A,
 	/* calculate the L1 length required for the desired period */
 	_L1_distance = _L1_ratio * ground_speed;
 
-	/* calculate vector from A to B */
-	math::Vector<2> vector_AB = get_local_planar_vector(vector_A, vector_B);
+	/* unit vector from A to B */
+	math::Vector<2> vector_AB = _leg_unit;
+	float AB_bearing = _leg_bearing;
 
 	/*
 	 * check if waypoints are on top of each other. If yes,
 	 * skip A and directly continue to B
 	 */
-	if (vector_AB.length() < 1.0e-6f) {
+	if (_leg_length < 1.0e-6f) {
 		vector_AB = get_local_planar_vector(vector_curr_position, vector_B);
+		vector_AB.normalize();
+		AB_bearing = fast_atan2f(vector_AB(1), vector_AB(0));
 	}
 
-	vector_AB.normalize();
-
 	/* calculate the vector from waypoint A to the aircraft */
-	math::Vector<2> vector_A_to_airplane = get_local_planar_vector(vector_A, vector_curr_position);
+	math::Vector<2> vector_A_to_airplane = get_local_planar_vector(vector_A, vector_curr_position, _leg_cos_A);
 
 	/* calculate crosstrack error (output only) */
 	_crosstrack_error = vector_AB % vector_A_to_airplane;
@@ -132,12 +133,15 @@ void ECL_L1_Pos_Controller::navigate_waypoints(const math::Vector<2> &vector_A,
 	float alongTrackDist = vector_A_to_airplane * vector_AB;
 
 	/* estimate airplane position WRT to B */
-	math::Vector<2> vector_B_to_P_unit = get_local_planar_vector(vector_B, vector_curr_position).normalized();
-	
+	math::Vector<2> vector_B_to_P_unit = get_local_planar_vector(vector_B, vector_curr_position, _leg_cos_B).normalized();
+
+	/* get the direction from the aircraft to the next waypoint, in the same planar approximation */
+	_target_bearing = atan2f(-vector_B_to_P_unit(1), -vector_B_to_P_unit(0));
+
 	/* calculate angle of airplane position vector relative to line) */
 
 	// XXX this could probably also be based solely on the dot product
-	float AB_to_BP_bearing = atan2f(vector_B_to_P_unit % vector_AB, vector_B_to_P_unit * vector_AB);
+	float AB_to_BP_bearing = fast_atan2f(vector_B_to_P_unit % vector_AB, vector_B_to_P_unit * vector_AB);
 
 	/* extension from [2], fly directly to A */
 	if (distance_A_to_airplane > _L1_distance && alongTrackDist / math::max(distance_A_to_airplane , 1.0f) < -0.7071f) {
@@ -150,9 +154,9 @@ void ECL_L1_Pos_Controller::navigate_waypoints(const math::Vector<2> &vector_A,
 		xtrack_vel = ground_speed_vector % (-vector_A_to_airplane_unit);
 		/* velocity along line */
 		ltrack_vel = ground_speed_vector * (-vector_A_to_airplane_unit);
-		eta = atan2f(xtrack_vel, ltrack_vel);
+		eta = fast_atan2f(xtrack_vel, ltrack_vel);
 		/* bearing from current position to L1 point */
-		_nav_bearing = atan2f(-vector_A_to_airplane_unit(1) , -vector_A_to_airplane_unit(0));
+		_nav_bearing = fast_atan2f(-vector_A_to_airplane_unit(1) , -vector_A_to_airplane_unit(0));
 
 	/*
 	 * If the AB vector and the vector from B to airplane point in the same
@@ -174,9 +178,9 @@ void ECL_L1_Pos_Controller::navigate_waypoints(const math::Vector<2> &vector_A,
 		xtrack_vel = ground_speed_vector % (-vector_B_to_P_unit);
 		/* velocity along line */
 		ltrack_vel = ground_speed_vector * (-vector_B_to_P_unit);
-		eta = atan2f(xtrack_vel, ltrack_vel);
+		eta = fast_atan2f(xtrack_vel, ltrack_vel);
 		/* bearing from current position to L1 point */
-		_nav_bearing = atan2f(-vector_B_to_P_unit(1) , -vector_B_to_P_unit(0));
+		_nav_bearing = fast_atan2f(-vector_B_to_P_unit(1) , -vector_B_to_P_unit(0));
 
 	} else {
 
@@ -187,16 +191,16 @@ void ECL_L1_Pos_Controller::navigate_waypoints(const math::Vector<2> &vector_A,
 		/* velocity along line */
 		ltrack_vel = ground_speed_vector * vector_AB;
 		/* calculate eta2 (angle of velocity vector relative to line) */
-		float eta2 = atan2f(xtrack_vel, ltrack_vel);
+		float eta2 = fast_atan2f(xtrack_vel, ltrack_vel);
 		/* calculate eta1 (angle to L1 point) */
 		float xtrackErr = vector_A_to_airplane % vector_AB;
 		float sine_eta1 = xtrackErr / math::max(_L1_distance , 0.1f);
 		/* limit output to 45 degrees */
 		sine_eta1 = math::constrain(sine_eta1, -0.7071f, 0.7071f); //sin(pi/4) = 0.7071
-		float eta1 = asinf(sine_eta1);
+		float eta1 = fast_asinf(sine_eta1);
 		eta = eta1 + eta2;
 		/* bearing from current position to L1 point */
-		_nav_bearing = atan2f(vector_AB(1), vector_AB(0)) + eta1;
+		_nav_bearing = AB_bearing + eta1;
 
 	}
 
@@ -249,7 +253,7 @@ void ECL_L1_Pos_Controller::navigate_loiter(const math::Vector<2> &vector_A, con
 	float xtrack_vel_center = vector_A_to_airplane_unit % ground_speed_vector;
 	/* velocity along line from waypoint to current position */
 	float ltrack_vel_center = - (ground_speed_vector * vector_A_to_airplane_unit);
-	float eta = atan2f(xtrack_vel_center, ltrack_vel_center);
+	float eta = fast_atan2f(xtrack_vel_center, ltrack_vel_center);
 	/* limit eta to 90 degrees */
 	eta = math::constrain(eta, -M_PI_F / 2.0f, +M_PI_F / 2.0f);
 
@@ -296,14 +300,14 @@ void ECL_L1_Pos_Controller::navigate_loiter(const math::Vector<2> &vector_A, con
 		/* angle between requested and current velocity vector */
 		_bearing_error = eta;
 		/* bearing from current position to L1 point */
-		_nav_bearing = atan2f(-vector_A_to_airplane_unit(1) , -vector_A_to_airplane_unit(0));
+		_nav_bearing = fast_atan2f(-vector_A_to_airplane_unit(1) , -vector_A_to_airplane_unit(0));
 
 	} else {
 		_lateral_accel = lateral_accel_sp_circle;
 		_circle_mode = true;
 		_bearing_error = 0.0f;
 		/* bearing from current position to L1 point */
-		_nav_bearing = atan2f(-vector_A_to_airplane_unit(1) , -vector_A_to_airplane_unit(0));
+		_nav_bearing = fast_atan2f(-vector_A_to_airplane_unit(1) , -vector_A_to_airplane_unit(0));
 	}
 }
 
@@ -361,6 +365,43 @@ void ECL_L1_Pos_Controller::navigate_level_flight(float current_heading)
 }
 
 
+void ECL_L1_Pos_Controller::update_leg(const math::Vector<2> &vector_A, const math::Vector<2> &vector_B)
+{
+	if (_leg_valid && _leg_A(0) == vector_A(0) && _leg_A(1) == vector_A(1) &&
+	    _leg_B(0) == vector_B(0) && _leg_B(1) == vector_B(1)) {
+		return;
+	}
+
+	_leg_A = vector_A;
+	_leg_B = vector_B;
+	_leg_cos_A = cosf(math::radians(vector_A(0)));
+	_leg_cos_B = cosf(math::radians(vector_B(0)));
+
+	/* calculate vector from A to B */
+	math::Vector<2> vector_AB = get_local_planar_vector(vector_A, vector_B, _leg_cos_A);
+	_leg_length = vector_AB.length();
+
+	if (_leg_length >= 1.0e-6f) {
+		_leg_unit = vector_AB / _leg_length;
+		_leg_bearing = fast_atan2f(_leg_unit(1), _leg_unit(0));
+
+	} else {
+		_leg_unit.zero();
+		_leg_bearing = 0.0f;
+	}
+
+	_leg_valid = true;
+}
+
+math::Vector<2> ECL_L1_Pos_Controller::get_local_planar_vector(const math::Vector<2> &origin, const math::Vector<2> &target, float cos_origin) const
+{
+	/* this is an approximation for small angles, proposed by [2] */
+
+	math::Vector<2> out(math::radians((target(0) - origin(0))), math::radians((target(1) - origin(1))*cos_origin));
+
+	return out * static_cast<float>(CONSTANTS_RADIUS_OF_EARTH);
+}
+
 math::Vector<2> ECL_L1_Pos_Controller::get_local_planar_vector(const math::Vector<2> &origin, const math::Vector<2> &target) const
 {
 	/* this is an approximation for small angles, proposed by [2] */
@@ -73,6 +73,7 @@ public:
 	ECL_L1_Pos_Controller() {
 		_L1_period = 25;
 		_L1_damping = 0.75f;
+		_leg_valid = false;
 	}
 
 	/**
@@ -249,6 +250,21 @@ private:
 
 	float _roll_lim_rad;  ///<maximum roll angle
 
+	/* geometry of the leg between the waypoints, kept while they do not change */
+	bool _leg_valid;			///< the leg below is for _leg_A and _leg_B
+	math::Vector<2> _leg_A;			///< waypoint A of the leg, WGS84
+	math::Vector<2> _leg_B;			///< waypoint B of the leg, WGS84
+	float _leg_cos_A;			///< cosine of the latitude of A
+	float _leg_cos_B;			///< cosine of the latitude of B
+	math::Vector<2> _leg_unit;		///< unit vector from A to B, in meters north and east
+	float _leg_length;			///< distance from A to B in meters
+	float _leg_bearing;			///< bearing from A to B (-pi..pi, in NED frame)
+
+	/**
+	 * Update the leg geometry if the waypoints changed.
+	 */
+	void update_leg(const math::Vector<2> &vector_A, const math::Vector<2> &vector_B);
+
 	/**
 	 * Convert a 2D vector from WGS84 to planar coordinates.
 	 *
@@ -262,6 +278,15 @@ private:
 	 */
 	math::Vector<2> get_local_planar_vector(const math::Vector<2> &origin, const math::Vector<2> &target) const;
 
+	/**
+	 * Convert a 2D vector from WGS84 to planar coordinates.
+	 *
+	 * Same as above, for an origin whose latitude cosine is known already.
+	 *
+	 * @param cos_origin The cosine of the latitude of origin
+	 */
+	math::Vector<2> get_local_planar_vector(const math::Vector<2> &origin, const math::Vector<2> &target, float cos_origin) const;
+
 };
 
 
@@ -27,7 +27,7 @@ using namespace math;
  *
  */
 
-void TECS::update_50hz(float baro_altitude, float airspeed, const math::Matrix<3,3> &rotMat, const math::Vector<3> &accel_body, const math::Vector<3> &accel_earth)
+void TECS::update_50hz(float baro_altitude, float airspeed, const struct flight_state &state)
 {
 	// Implement third order complementary filter for height and height rate
 	// estimted height rate = _integ2_state
@@ -42,8 +42,8 @@ void TECS::update_50hz(float baro_altitude, float airspeed, const math::Matrix<3
 	float DT = max((now - _update_50hz_last_usec), 0ULL) * 1.0e-6f;
 
 	// printf("dt: %10.6f baro alt: %6.2f eas: %6.2f R(0,0): %6.2f, R(1,1): %6.2f\naccel body: %6.2f %6.2f %6.2f\naccel earth: %6.2f %6.2f %6.2f\n",
-	// 	DT, baro_altitude, airspeed, rotMat(0, 0), rotMat(1, 1), accel_body(0), accel_body(1), accel_body(2),
-	// 	accel_earth(0), accel_earth(1), accel_earth(2));
+	// 	DT, baro_altitude, airspeed, state.R(0, 0), state.R(1, 1), state.accel_body(0), state.accel_body(1), state.accel_body(2),
+	// 	state.accel_earth(0), state.accel_earth(1), state.accel_earth(2));
 
 	if (DT > 1.0f) {
 		_integ3_state = baro_altitude;
@@ -57,7 +57,7 @@ void TECS::update_50hz(float baro_altitude, float airspeed, const math::Matrix<3
 	_EAS = airspeed;
 
 	// Get height acceleration
-	float hgt_ddot_mea = -(accel_earth(2) + CONSTANTS_ONE_G);
+	float hgt_ddot_mea = -(state.accel_earth(2) + CONSTANTS_ONE_G);
 	// Perform filter calculation using backwards Euler integration
 	// Coefficients selected to place all three filter poles at omega
 	float omega2 = _hgtCompFiltOmega * _hgtCompFiltOmega;
@@ -82,10 +82,9 @@ void TECS::update_50hz(float baro_altitude, float airspeed, const math::Matrix<3
 	float temp = 0;
 
 	if (isfinite(airspeed) && airspeed_sensor_enabled()) {
-		// Get DCM
 		// Calculate speed rate of change
 		// XXX check
-		temp = rotMat(2, 0) * CONSTANTS_ONE_G + accel_body(0);
+		temp = state.accel_body(0) - state.sin_pitch * CONSTANTS_ONE_G;
 		// take 5 point moving average
 		//_vel_dot = _vdot_filter.apply(temp);
 		// XXX resolve this properly
@@ -284,7 +283,7 @@ void TECS::_update_energies(void)
 	_SKEdot = _integ5_state * _vel_dot;
 }
 
-void TECS::_update_throttle(float throttle_cruise, const math::Matrix<3,3> &rotMat)
+void TECS::_update_throttle(float throttle_cruise, float cos_phi)
 {
 	// Calculate total energy values
 	_STE_error = _SPE_dem - _SPE_est + _SKE_dem - _SKE_est;
@@ -311,8 +310,7 @@ void TECS::_update_throttle(float throttle_cruise, const math::Matrix<3,3> &rotM
 		// Use the demanded rate of change of total energy as the feed-forward demand, but add
 		// additional component which scales with (1/cos(bank angle) - 1) to compensate for induced
 		// drag increase during turns.
-		float cosPhi = sqrtf((rotMat(0, 1) * rotMat(0, 1)) + (rotMat(1, 1) * rotMat(1, 1)));
-		STEdot_dem = STEdot_dem + _rollComp * (1.0f / constrain(cosPhi , 0.1f, 1.0f) - 1.0f);
+		STEdot_dem = STEdot_dem + _rollComp * (1.0f / constrain(cos_phi, 0.1f, 1.0f) - 1.0f);
 
 		if (STEdot_dem >= 0) {
 			ff_throttle = nomThr + STEdot_dem / _STEdot_max * (_THRmaxf - nomThr);
@@ -508,7 +506,7 @@ void TECS::_update_STE_rate_lim(void)
 	_STEdot_min = - _minSinkRate * CONSTANTS_ONE_G;
 }
 
-void TECS::update_pitch_throttle(const math::Matrix<3,3> &rotMat, float pitch, float baro_altitude, float hgt_dem, float EAS_dem, float indicated_airspeed, float EAS2TAS, bool climbOutDem, float ptchMinCO,
+void TECS::update_pitch_throttle(const struct flight_state &state, float baro_altitude, float hgt_dem, float EAS_dem, float indicated_airspeed, bool climbOutDem, float ptchMinCO,
 				 float throttle_min, float throttle_max, float throttle_cruise,
 				 float pitch_limit_min, float pitch_limit_max)
 {
@@ -518,10 +516,10 @@ void TECS::update_pitch_throttle(const math::Matrix<3,3> &rotMat, float pitch, f
 	_update_pitch_throttle_last_usec = now;
 
 	// printf("tecs in: dt:%10.6f pitch: %6.2f baro_alt: %6.2f alt sp: %6.2f\neas sp: %6.2f eas: %6.2f, eas2tas: %6.2f\n %s pitch min C0: %6.2f thr min: %6.2f, thr max: %6.2f thr cruis: %6.2f pt min: %6.2f, pt max: %6.2f\n",
-	// 	_DT, pitch, baro_altitude, hgt_dem, EAS_dem, indicated_airspeed, EAS2TAS, (climbOutDem) ? "climb" : "level", ptchMinCO, throttle_min, throttle_max, throttle_cruise, pitch_limit_min, pitch_limit_max);
+	// 	_DT, state.pitch, baro_altitude, hgt_dem, EAS_dem, indicated_airspeed, state.EAS2TAS, (climbOutDem) ? "climb" : "level", ptchMinCO, throttle_min, throttle_max, throttle_cruise, pitch_limit_min, pitch_limit_max);
 
 	// Update the speed estimate using a 2nd order complementary filter
-	_update_speed(EAS_dem, indicated_airspeed, _indicated_airspeed_min, _indicated_airspeed_max, EAS2TAS);
+	_update_speed(EAS_dem, indicated_airspeed, _indicated_airspeed_min, _indicated_airspeed_max, state.EAS2TAS);
 
 	// Convert inputs
 	_THRmaxf  = throttle_max;
@@ -531,7 +529,7 @@ void TECS::update_pitch_throttle(const math::Matrix<3,3> &rotMat, float pitch, f
 	_climbOutDem = climbOutDem;
 
 	// initialise selected states and variables if DT > 1 second or in climbout
-	_initialise_states(pitch, throttle_cruise, baro_altitude, ptchMinCO);
+	_initialise_states(state.pitch, throttle_cruise, baro_altitude, ptchMinCO);
 
 	// Calculate Specific Total Energy Rate Limits
 	_update_STE_rate_lim();
@@ -549,7 +547,7 @@ void TECS::update_pitch_throttle(const math::Matrix<3,3> &rotMat, float pitch, f
 	_update_energies();
 
 	// Calculate throttle demand
-	_update_throttle(throttle_cruise, rotMat);
+	_update_throttle(throttle_cruise, state.cos_phi);
 
 	// Detect bad descent due to demanded airspeed being too high
 	_detect_bad_descent();
@@ -92,13 +92,25 @@ public:
 		_airspeed_enabled = enabled;
 	}
 
+	// Attitude and acceleration data of one control cycle, computed once by
+	// the caller and shared by both updates of the cycle
+	struct flight_state {
+		math::Matrix<3, 3> R;		// body to earth rotation
+		float pitch;
+		float sin_pitch;		// -R(2, 0)
+		float cos_phi;			// cosine of the bank angle, sqrt(R(0, 1)^2 + R(1, 1)^2)
+		float EAS2TAS;
+		math::Vector<3> accel_body;
+		math::Vector<3> accel_earth;
+	};
+
 	// Update of the estimated height and height rate internal state
 	// Update of the inertial speed rate internal state
 	// Should be called at 50Hz or greater
-	void update_50hz(float baro_altitude, float airspeed, const math::Matrix<3,3> &rotMat, const math::Vector<3> &accel_body, const math::Vector<3> &accel_earth);
+	void update_50hz(float baro_altitude, float airspeed, const struct flight_state &state);
 
 	// Update the control loop calculations
-	void update_pitch_throttle(const math::Matrix<3,3> &rotMat, float pitch, float baro_altitude, float hgt_dem, float EAS_dem, float indicated_airspeed, float EAS2TAS, bool climbOutDem, float ptchMinCO,
+	void update_pitch_throttle(const struct flight_state &state, float baro_altitude, float hgt_dem, float EAS_dem, float indicated_airspeed, bool climbOutDem, float ptchMinCO,
 				   float throttle_min, float throttle_max, float throttle_cruise,
 				   float pitch_limit_min, float pitch_limit_max);
 	// demanded throttle in percentage
@@ -398,7 +410,7 @@ private:
 	void _update_energies(void);
 
 	// Update Demanded Throttle
-	void _update_throttle(float throttle_cruise, const math::Matrix<3,3> &rotMat);
+	void _update_throttle(float throttle_cruise, float cos_phi);
 
 	// Detect Bad Descent
 	void _detect_bad_descent(void);
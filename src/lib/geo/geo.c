@@ -51,6 +51,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include <float.h>
+#include <mathlib/math/fast_math.h>
 
 #include <systemlib/err.h>
 #include <drivers/drv_hrt.h>
@@ -60,7 +61,14 @@
  * formulas according to: http://mathworld.wolfram.com/AzimuthalEquidistantProjection.html
  */
 
-static struct map_projection_reference_s mp_ref = {0.0, 0.0, 0.0, 0.0, false, 0};
+/*
+ * Offsets from the reference up to this many radians (about 300 km) are
+ * projected in single precision. Only the subtraction of the absolute
+ * coordinates needs double, the M4 FPU has no double support.
+ */
+#define GEO_FLOAT_OFFSET_MAX				0.05
+
+static struct map_projection_reference_s mp_ref = {0.0, 0.0, 0.0, 0.0, 0.0f, 0.0f, false, 0};
 static struct globallocal_converter_reference_s gl_ref = {0.0f, false};
 
 __EXPORT bool map_projection_global_initialized()
@@ -99,6 +107,8 @@ __EXPORT int map_projection_init_timestamped(struct map_projection_reference_s *
 	ref->lon_rad = lon_0 * M_DEG_TO_RAD;
 	ref->sin_lat = sin(ref->lat_rad);
 	ref->cos_lat = cos(ref->lat_rad);
+	ref->sin_lat_f = ref->sin_lat;
+	ref->cos_lat_f = ref->cos_lat;
 
 	ref->timestamp = timestamp;
 	ref->init_done = true;
@@ -143,6 +153,48 @@ __EXPORT int map_projection_project(const struct map_projection_reference_s *ref
 	double lat_rad = lat * M_DEG_TO_RAD;
 	double lon_rad = lon * M_DEG_TO_RAD;
 
+	double d_lat = lat_rad - ref->lat_rad;
+	double d_lon = lon_rad - ref->lon_rad;
+
+	if (d_lon > M_PI) {
+		d_lon -= 2.0 * M_PI;
+
+	} else if (d_lon < -M_PI) {
+		d_lon += 2.0 * M_PI;
+	}
+
+	if (fabs(d_lat) < GEO_FLOAT_OFFSET_MAX && fabs(d_lon) < GEO_FLOAT_OFFSET_MAX) {
+		/*
+		 * Same formulas as below, rewritten around the reference so that
+		 * nothing cancels in float: with lat = lat_0 + dlat and
+		 * h = 1 - cos(dlon) = 2 sin^2(dlon / 2)
+		 *
+		 *   cos_0 sin_lat - sin_0 cos_lat cos_dlon
+		 *     = sin(dlat) (1 - sin_0^2 h) + sin_0 cos_0 cos(dlat) h
+		 *
+		 * and sin(c) is the length of the unscaled (x, y).
+		 */
+		float s_dlat, c_dlat, s_dlon, c_dlon, s_hlon, c_hlon;
+		fast_sincosf((float)d_lat, &s_dlat, &c_dlat);
+		fast_sincosf((float)d_lon, &s_dlon, &c_dlon);
+		fast_sincosf(0.5f * (float)d_lon, &s_hlon, &c_hlon);
+
+		float h = 2.0f * s_hlon * s_hlon;
+		float cos_lat_f = ref->cos_lat_f * c_dlat - ref->sin_lat_f * s_dlat;
+
+		float xu = s_dlat * (1.0f - ref->sin_lat_f * ref->sin_lat_f * h) + ref->sin_lat_f * ref->cos_lat_f * c_dlat * h;
+		float yu = cos_lat_f * s_dlon;
+
+		/* k = c / sin(c) = asin(s) / s, series is exact to float for s < 0.1 */
+		float s2 = xu * xu + yu * yu;
+		float k = 1.0f + s2 * (1.0f / 6.0f + s2 * (3.0f / 40.0f));
+
+		*x = k * xu * CONSTANTS_RADIUS_OF_EARTH;
+		*y = k * yu * CONSTANTS_RADIUS_OF_EARTH;
+
+		return 0;
+	}
+
 	double sin_lat = sin(lat_rad);
 	double cos_lat = cos(lat_rad);
 	double cos_d_lon = cos(lon_rad - ref->lon_rad);
@@ -169,7 +221,7 @@ __EXPORT int map_projection_reproject(const struct map_projection_reference_s *r
 
 	double x_rad = x / CONSTANTS_RADIUS_OF_EARTH;
 	double y_rad = y / CONSTANTS_RADIUS_OF_EARTH;
-	double c = sqrtf(x_rad * x_rad + y_rad * y_rad);
+	double c = fast_sqrtf(x_rad * x_rad + y_rad * y_rad);
 	double sin_c = sin(c);
 	double cos_c = cos(c);
 
@@ -283,8 +335,25 @@ __EXPORT float get_distance_to_next_waypoint(double lat_now, double lon_now, dou
 	double d_lat = lat_next_rad - lat_now_rad;
 	double d_lon = lon_next_rad - lon_now_rad;
 
-	double a = sin(d_lat / 2.0d) * sin(d_lat / 2.0d) + sin(d_lon / 2.0d) * sin(d_lon / 2.0d) * cos(lat_now_rad) * cos(lat_next_rad);
-	double c = 2.0d * atan2(sqrt(a), sqrt(1.0d - a));
+	if (d_lon > M_PI) {
+		d_lon -= 2.0 * M_PI;
+
+	} else if (d_lon < -M_PI) {
+		d_lon += 2.0 * M_PI;
+	}
+
+	/*
+	 * Haversine in float: only the small differences need the double
+	 * subtraction above, the absolute latitudes only scale the result.
+	 */
+	float s_hlat, c_hlat, s_hlon, c_hlon, s_lat, c_lat_now, c_lat_next;
+	fast_sincosf(0.5f * (float)d_lat, &s_hlat, &c_hlat);
+	fast_sincosf(0.5f * (float)d_lon, &s_hlon, &c_hlon);
+	fast_sincosf((float)lat_now_rad, &s_lat, &c_lat_now);
+	fast_sincosf((float)lat_next_rad, &s_lat, &c_lat_next);
+
+	float a = s_hlat * s_hlat + s_hlon * s_hlon * c_lat_now * c_lat_next;
+	float c = 2.0f * asinf(fast_sqrtf(fminf(a, 1.0f)));
 
 	return CONSTANTS_RADIUS_OF_EARTH * c;
 }
@@ -299,7 +368,7 @@ __EXPORT float get_bearing_to_next_waypoint(double lat_now, double lon_now, doub
 	double d_lon = lon_next_rad - lon_now_rad;
 
 	/* conscious mix of double and float trig function to maximize speed and efficiency */
-	float theta = atan2f(sin(d_lon) * cos(lat_next_rad) , cos(lat_now_rad) * sin(lat_next_rad) - sin(lat_now_rad) * cos(lat_next_rad) * cos(d_lon));
+	float theta = fast_atan2f(sin(d_lon) * cos(lat_next_rad) , cos(lat_now_rad) * sin(lat_next_rad) - sin(lat_now_rad) * cos(lat_next_rad) * cos(d_lon));
 
 	theta = _wrap_pi(theta);
 
@@ -513,7 +582,7 @@ __EXPORT float get_distance_to_point_global_wgs84(double lat_now, double lon_now
 	*dist_xy = fabsf(dxy);
 	*dist_z = fabsf(dz);
 
-	return sqrtf(dxy * dxy + dz * dz);
+	return fast_sqrtf(dxy * dxy + dz * dz);
 }
 
 
@@ -525,10 +594,10 @@ __EXPORT float mavlink_wpm_distance_to_point_local(float x_now, float y_now, flo
 	float dy = y_now - y_next;
 	float dz = z_now - z_next;
 
-	*dist_xy = sqrtf(dx * dx + dy * dy);
+	*dist_xy = fast_sqrtf(dx * dx + dy * dy);
 	*dist_z = fabsf(dz);
 
-	return sqrtf(dx * dx + dy * dy + dz * dz);
+	return fast_sqrtf(dx * dx + dy * dy + dz * dz);
 }
 
 __EXPORT float _wrap_pi(float bearing)
@@ -73,6 +73,8 @@ struct map_projection_reference_s {
 	double lon_rad;
 	double sin_lat;
 	double cos_lat;
+	float sin_lat_f;	/**< sin_lat for the single precision path */
+	float cos_lat_f;	/**< cos_lat for the single precision path */
 	bool init_done;
 	uint64_t timestamp;
 };
@@ -44,7 +44,16 @@
 #define MATRIX_HPP
 
 #include <stdio.h>
+#include <float.h>
 #include "../CMSIS/Include/arm_math.h"
+#include "fast_math.h"
+
+/*
+ * Matrices with no dimension larger than this are multiplied and
+ * transposed inline, the loop bounds are known and the compiler can
+ * unroll and schedule them. Larger ones go through CMSIS.
+ */
+#define MATRIX_INLINE_MAX	4
 
 namespace math
 {
@@ -62,42 +71,32 @@ public:
 	 */
 	float data[M][N];
 
-	/**
-	 * struct for using arm_math functions
-	 */
-	arm_matrix_instance_f32 arm_mat;
-
 	/**
 	 * trivial ctor
 	 * Initializes the elements to zero.
 	 */
-	MatrixBase() : 
-		data{},
-		arm_mat{M, N, &data[0][0]}
+	MatrixBase() :
+		data{}
 	{
 	}
 
-	virtual ~MatrixBase() {};
-
-	/**
-	 * copyt ctor
-	 */
-	MatrixBase(const MatrixBase<M, N> &m) :
-		arm_mat{M, N, &data[0][0]}
-	{
-		memcpy(data, m.data, sizeof(data));
+	MatrixBase(const float *d) {
+		memcpy(data, d, sizeof(data));
 	}
 
-	MatrixBase(const float *d) :
-		arm_mat{M, N, &data[0][0]}
-	{
+	MatrixBase(const float d[M][N]) {
 		memcpy(data, d, sizeof(data));
 	}
 
-	MatrixBase(const float d[M][N]) : 
-		arm_mat{M, N, &data[0][0]}
-	{
-		memcpy(data, d, sizeof(data));
+	/**
+	 * descriptor for using arm_math functions on this matrix
+	 *
+	 * Not stored in the object, so that matrices stay plain data and are
+	 * trivially copyable. Build it on the stack right before the CMSIS call.
+	 */
+	arm_matrix_instance_f32 arm_mat(void) const {
+		arm_matrix_instance_f32 inst = {M, N, const_cast<float *>(&data[0][0])};
+		return inst;
 	}
 
 	/**
@@ -166,14 +165,6 @@ public:
 		return false;
 	}
 
-	/**
-	 * set to value
-	 */
-	const Matrix<M, N> &operator =(const Matrix<M, N> &m) {
-		memcpy(data, m.data, sizeof(data));
-		return *static_cast<Matrix<M, N>*>(this);
-	}
-
 	/**
 	 * negation
 	 */
@@ -274,7 +265,26 @@ public:
 	template <unsigned int P>
 	Matrix<M, P> operator *(const Matrix<N, P> &m) const {
 		Matrix<M, P> res;
-		arm_mat_mult_f32(&arm_mat, &m.arm_mat, &res.arm_mat);
+
+		if (M <= MATRIX_INLINE_MAX && N <= MATRIX_INLINE_MAX && P <= MATRIX_INLINE_MAX) {
+			for (unsigned int i = 0; i < M; i++) {
+				for (unsigned int j = 0; j < P; j++) {
+					float sum = 0.0f;
+
+					for (unsigned int k = 0; k < N; k++)
+						sum += data[i][k] * m.data[k][j];
+
+					res.data[i][j] = sum;
+				}
+			}
+
+		} else {
+			arm_matrix_instance_f32 a = arm_mat();
+			arm_matrix_instance_f32 b = m.arm_mat();
+			arm_matrix_instance_f32 r = res.arm_mat();
+			arm_mat_mult_f32(&a, &b, &r);
+		}
+
 		return res;
 	}
 
@@ -283,7 +293,18 @@ public:
 	 */
 	Matrix<N, M> transposed(void) const {
 		Matrix<N, M> res;
-		arm_mat_trans_f32(&this->arm_mat, &res.arm_mat);
+
+		if (M <= MATRIX_INLINE_MAX && N <= MATRIX_INLINE_MAX) {
+			for (unsigned int i = 0; i < M; i++)
+				for (unsigned int j = 0; j < N; j++)
+					res.data[j][i] = data[i][j];
+
+		} else {
+			arm_matrix_instance_f32 a = arm_mat();
+			arm_matrix_instance_f32 r = res.arm_mat();
+			arm_mat_trans_f32(&a, &r);
+		}
+
 		return res;
 	}
 
@@ -292,10 +313,140 @@ public:
 	 */
 	Matrix<M, N> inversed(void) const {
 		Matrix<M, N> res;
-		arm_mat_inverse_f32(&this->arm_mat, &res.arm_mat);
+		/* CMSIS works in place on the source */
+		Matrix<M, N> src(data);
+		arm_matrix_instance_f32 a = src.arm_mat();
+		arm_matrix_instance_f32 r = res.arm_mat();
+		arm_mat_inverse_f32(&a, &r);
 		return res;
 	}
 
+	/**
+	 * Cholesky decomposition of a symmetric positive definite matrix,
+	 * this = L * L'. Only the lower triangle of this matrix is used.
+	 *
+	 * @param L	lower triangular factor, zero above the diagonal
+	 * @return	false if the matrix is not square or not positive definite
+	 */
+	bool cholesky(Matrix<M, N> &L) const {
+		if (M != N)
+			return false;
+
+		L.zero();
+
+		for (unsigned int j = 0; j < N; j++) {
+			float d = data[j][j];
+
+			for (unsigned int k = 0; k < j; k++)
+				d -= L.data[j][k] * L.data[j][k];
+
+			/* also rejects NaN */
+			if (!(d > 0.0f))
+				return false;
+
+			float ljj = fast_sqrtf(d);
+			float inv = 1.0f / ljj;
+			L.data[j][j] = ljj;
+
+			for (unsigned int i = j + 1; i < M; i++) {
+				float s = data[i][j];
+
+				for (unsigned int k = 0; k < j; k++)
+					s -= L.data[i][k] * L.data[j][k];
+
+				L.data[i][j] = s * inv;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * LDL' decomposition of a symmetric matrix, this = L * diag(d) * L',
+	 * needs no square roots. Only the lower triangle of this matrix is used.
+	 *
+	 * @param L	unit lower triangular factor, zero above the diagonal
+	 * @param d	diagonal of D
+	 * @return	false if the matrix is not square or a pivot vanishes against
+	 *		the largest entry, i.e. the matrix is numerically singular
+	 */
+	bool ldlt(Matrix<M, N> &L, Vector<N> &d) const {
+		if (M != N)
+			return false;
+
+		L.identity();
+
+		/* pivots that cancel down to rounding noise of the entries are zero */
+		float scale = 0.0f;
+
+		for (unsigned int i = 0; i < M; i++)
+			for (unsigned int j = 0; j <= i; j++)
+				scale = fmaxf(scale, fabsf(data[i][j]));
+
+		const float pivot_min = N * FLT_EPSILON * scale;
+
+		for (unsigned int j = 0; j < N; j++) {
+			float dj = data[j][j];
+
+			for (unsigned int k = 0; k < j; k++)
+				dj -= L.data[j][k] * L.data[j][k] * d.data[k];
+
+			/* also rejects NaN */
+			if (!(fabsf(dj) > pivot_min))
+				return false;
+
+			d.data[j] = dj;
+			float inv = 1.0f / dj;
+
+			for (unsigned int i = j + 1; i < M; i++) {
+				float s = data[i][j];
+
+				for (unsigned int k = 0; k < j; k++)
+					s -= L.data[i][k] * L.data[j][k] * d.data[k];
+
+				L.data[i][j] = s * inv;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * solve this * x = b for a symmetric positive definite matrix, e.g. an
+	 * innovation covariance, through the Cholesky decomposition
+	 *
+	 * @return	false if the matrix is not positive definite, x is not changed then
+	 */
+	bool solve(const Vector<M> &b, Vector<N> &x) const {
+		Matrix<M, N> L;
+
+		if (!cholesky(L))
+			return false;
+
+		/* L y = b, then L' x = y */
+		float y[N];
+
+		for (unsigned int i = 0; i < N; i++) {
+			float s = b.data[i];
+
+			for (unsigned int k = 0; k < i; k++)
+				s -= L.data[i][k] * y[k];
+
+			y[i] = s / L.data[i][i];
+		}
+
+		for (unsigned int i = N; i-- > 0;) {
+			float s = y[i];
+
+			for (unsigned int k = i + 1; k < N; k++)
+				s -= L.data[k][i] * x.data[k];
+
+			x.data[i] = s / L.data[i][i];
+		}
+
+		return true;
+	}
+
 	/**
 	 * set zero matrix
 	 */
@@ -334,26 +485,33 @@ public:
 
 	Matrix() : MatrixBase<M, N>() {}
 
-	Matrix(const Matrix<M, N> &m) : MatrixBase<M, N>(m) {}
-
 	Matrix(const float *d) : MatrixBase<M, N>(d) {}
 
 	Matrix(const float d[M][N]) : MatrixBase<M, N>(d) {}
 
-	/**
-	 * set to value
-	 */
-	const Matrix<M, N> &operator =(const Matrix<M, N> &m) {
-		memcpy(this->data, m.data, sizeof(this->data));
-		return *this;
-	}
-
 	/**
 	 * multiplication by a vector
 	 */
 	Vector<M> operator *(const Vector<N> &v) const {
 		Vector<M> res;
-		arm_mat_mult_f32(&this->arm_mat, &v.arm_col, &res.arm_col);
+
+		if (M <= MATRIX_INLINE_MAX && N <= MATRIX_INLINE_MAX) {
+			for (unsigned int i = 0; i < M; i++) {
+				float sum = 0.0f;
+
+				for (unsigned int k = 0; k < N; k++)
+					sum += this->data[i][k] * v.data[k];
+
+				res.data[i] = sum;
+			}
+
+		} else {
+			arm_matrix_instance_f32 a = this->arm_mat();
+			arm_matrix_instance_f32 b = v.arm_col();
+			arm_matrix_instance_f32 r = res.arm_col();
+			arm_mat_mult_f32(&a, &b, &r);
+		}
+
 		return res;
 	}
 };
@@ -366,20 +524,10 @@ public:
 
 	Matrix() : MatrixBase<3, 3>() {}
 
-	Matrix(const Matrix<3, 3> &m) : MatrixBase<3, 3>(m) {}
-
 	Matrix(const float *d) : MatrixBase<3, 3>(d) {}
 
 	Matrix(const float d[3][3]) : MatrixBase<3, 3>(d) {}
 
-	/**
-	 * set to value
-	 */
-	const Matrix<3, 3> &operator =(const Matrix<3, 3> &m) {
-		memcpy(this->data, m.data, sizeof(this->data));
-		return *this;
-	}
-
 	/**
 	 * multiplication by a vector
 	 */
@@ -390,17 +538,86 @@ public:
 		return res;
 	}
 
+	/**
+	 * multiplication by another matrix, unrolled
+	 */
+	Matrix<3, 3> operator *(const Matrix<3, 3> &m) const {
+		Matrix<3, 3> res;
+
+		for (unsigned int i = 0; i < 3; i++) {
+			res.data[i][0] = data[i][0] * m.data[0][0] + data[i][1] * m.data[1][0] + data[i][2] * m.data[2][0];
+			res.data[i][1] = data[i][0] * m.data[0][1] + data[i][1] * m.data[1][1] + data[i][2] * m.data[2][1];
+			res.data[i][2] = data[i][0] * m.data[0][2] + data[i][1] * m.data[1][2] + data[i][2] * m.data[2][2];
+		}
+
+		return res;
+	}
+
+	/**
+	 * transpose the matrix, unrolled
+	 */
+	Matrix<3, 3> transposed(void) const {
+		Matrix<3, 3> res;
+
+		res.data[0][0] = data[0][0];
+		res.data[0][1] = data[1][0];
+		res.data[0][2] = data[2][0];
+		res.data[1][0] = data[0][1];
+		res.data[1][1] = data[1][1];
+		res.data[1][2] = data[2][1];
+		res.data[2][0] = data[0][2];
+		res.data[2][1] = data[1][2];
+		res.data[2][2] = data[2][2];
+
+		return res;
+	}
+
+	/**
+	 * invert the matrix by its adjugate, zero if it is numerically singular:
+	 * |det| is at most the product of the row norms, a determinant within
+	 * FLT_EPSILON of that bound leaves nothing but rounding noise, and a
+	 * denormal one cannot be inverted accurately
+	 */
+	Matrix<3, 3> inversed(void) const {
+		Matrix<3, 3> res;
+
+		float c00 = data[1][1] * data[2][2] - data[1][2] * data[2][1];
+		float c01 = data[1][2] * data[2][0] - data[1][0] * data[2][2];
+		float c02 = data[1][0] * data[2][1] - data[1][1] * data[2][0];
+		float det = data[0][0] * c00 + data[0][1] * c01 + data[0][2] * c02;
+
+		float row_norms = fast_sqrtf(data[0][0] * data[0][0] + data[0][1] * data[0][1] + data[0][2] * data[0][2]) *
+				  fast_sqrtf(data[1][0] * data[1][0] + data[1][1] * data[1][1] + data[1][2] * data[1][2]) *
+				  fast_sqrtf(data[2][0] * data[2][0] + data[2][1] * data[2][1] + data[2][2] * data[2][2]);
+
+		/* also rejects NaN */
+		if (!(fabsf(det) > fmaxf(FLT_EPSILON * row_norms, FLT_MIN)))
+			return res;
+
+		float inv = 1.0f / det;
+
+		res.data[0][0] = c00 * inv;
+		res.data[1][0] = c01 * inv;
+		res.data[2][0] = c02 * inv;
+		res.data[0][1] = (data[0][2] * data[2][1] - data[0][1] * data[2][2]) * inv;
+		res.data[1][1] = (data[0][0] * data[2][2] - data[0][2] * data[2][0]) * inv;
+		res.data[2][1] = (data[0][1] * data[2][0] - data[0][0] * data[2][1]) * inv;
+		res.data[0][2] = (data[0][1] * data[1][2] - data[0][2] * data[1][1]) * inv;
+		res.data[1][2] = (data[0][2] * data[1][0] - data[0][0] * data[1][2]) * inv;
+		res.data[2][2] = (data[0][0] * data[1][1] - data[0][1] * data[1][0]) * inv;
+
+		return res;
+	}
+
 	/**
 	 * create a rotation matrix from given euler angles
 	 * based on http://gentlenav.googlecode.com/files/EulerAngles.pdf
 	 */
 	void from_euler(float roll, float pitch, float yaw) {
-		float cp = cosf(pitch);
-		float sp = sinf(pitch);
-		float sr = sinf(roll);
-		float cr = cosf(roll);
-		float sy = sinf(yaw);
-		float cy = cosf(yaw);
+		float cp, sp, sr, cr, sy, cy;
+		fast_sincosf(pitch, &sp, &cp);
+		fast_sincosf(roll, &sr, &cr);
+		fast_sincosf(yaw, &sy, &cy);
 
 		data[0][0] = cp * cy;
 		data[0][1] = (sr * sp * cy) - (cr * sy);
@@ -418,19 +635,19 @@ public:
 	 */
 	Vector<3> to_euler(void) const {
 		Vector<3> euler;
-		euler.data[1] = asinf(-data[2][0]);
+		euler.data[1] = fast_asinf(-data[2][0]);
 
 		if (fabsf(euler.data[1] - M_PI_2_F) < 1.0e-3f) {
 			euler.data[0] = 0.0f;
-			euler.data[2] = atan2f(data[1][2] - data[0][1], data[0][2] + data[1][1]) + euler.data[0];
+			euler.data[2] = fast_atan2f(data[1][2] - data[0][1], data[0][2] + data[1][1]) + euler.data[0];
 
 		} else if (fabsf(euler.data[1] + M_PI_2_F) < 1.0e-3f) {
 			euler.data[0] = 0.0f;
-			euler.data[2] = atan2f(data[1][2] - data[0][1], data[0][2] + data[1][1]) - euler.data[0];
+			euler.data[2] = fast_atan2f(data[1][2] - data[0][1], data[0][2] + data[1][1]) - euler.data[0];
 
 		} else {
-			euler.data[0] = atan2f(data[2][1], data[2][2]);
-			euler.data[2] = atan2f(data[1][0], data[0][0]);
+			euler.data[0] = fast_atan2f(data[2][1], data[2][2]);
+			euler.data[2] = fast_atan2f(data[1][0], data[0][0]);
 		}
 
 		return euler;
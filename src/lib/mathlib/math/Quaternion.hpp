@@ -59,11 +59,6 @@ public:
 	 */
 	Quaternion() : Vector<4>() {}
 
-	/**
-	 * copy ctor
-	 */
-	Quaternion(const Quaternion &q) : Vector<4>(q) {}
-
 	/**
 	 * casting from vector
 	 */
@@ -92,6 +87,86 @@ public:
 			       data[0] * q.data[3] + data[1] * q.data[2] - data[2] * q.data[1] + data[3] * q.data[0]);
 	}
 
+	/**
+	 * conjugate, for a unit quaternion this is the inverse rotation
+	 */
+	const Quaternion conjugated(void) const {
+		return Quaternion(data[0], -data[1], -data[2], -data[3]);
+	}
+
+	/**
+	 * rotate a vector by this unit quaternion, same as to_dcm() * v
+	 * but without building the matrix
+	 */
+	Vector<3> rotate(const Vector<3> &v) const {
+		/* v + 2 q0 (q x v) + 2 q x (q x v) */
+		float tx = 2.0f * (data[2] * v.data[2] - data[3] * v.data[1]);
+		float ty = 2.0f * (data[3] * v.data[0] - data[1] * v.data[2]);
+		float tz = 2.0f * (data[1] * v.data[1] - data[2] * v.data[0]);
+		return Vector<3>(
+			       v.data[0] + data[0] * tx + data[2] * tz - data[3] * ty,
+			       v.data[1] + data[0] * ty + data[3] * tx - data[1] * tz,
+			       v.data[2] + data[0] * tz + data[1] * ty - data[2] * tx);
+	}
+
+	/**
+	 * rotate a vector by the inverse of this unit quaternion, same as
+	 * to_dcm().transposed() * v
+	 */
+	Vector<3> conjugate_rotate(const Vector<3> &v) const {
+		return conjugated().rotate(v);
+	}
+
+	/**
+	 * normalized linear interpolation towards q along the shorter arc
+	 *
+	 * @param t	0 gives this, 1 gives q
+	 */
+	const Quaternion nlerp(const Quaternion &q, float t) const {
+		/* q and -q are the same rotation, take the one closer to this */
+		float dot = data[0] * q.data[0] + data[1] * q.data[1] + data[2] * q.data[2] + data[3] * q.data[3];
+		float tq = (dot < 0.0f) ? -t : t;
+		float tp = 1.0f - t;
+		Quaternion res(tp * data[0] + tq * q.data[0],
+			       tp * data[1] + tq * q.data[1],
+			       tp * data[2] + tq * q.data[2],
+			       tp * data[3] + tq * q.data[3]);
+		return res / fast_sqrtf(res.length_squared());
+	}
+
+	/**
+	 * spherical linear interpolation towards q along the shorter arc,
+	 * constant angular rate in t
+	 *
+	 * @param t	0 gives this, 1 gives q
+	 */
+	const Quaternion slerp(const Quaternion &q, float t) const {
+		float dot = data[0] * q.data[0] + data[1] * q.data[1] + data[2] * q.data[2] + data[3] * q.data[3];
+		float sign = 1.0f;
+
+		if (dot < 0.0f) {
+			dot = -dot;
+			sign = -1.0f;
+		}
+
+		/* the weights below lose precision for small angles, where nlerp is as good */
+		if (dot > 0.9995f)
+			return nlerp(q, t);
+
+		float theta = fast_atan2f(fast_sqrtf(1.0f - dot * dot), dot);
+		/* take sin(theta) from the same approximation, so t = 0 and t = 1 are exact */
+		float sin_theta, cos_theta, s0, c0, s1, c1;
+		fast_sincosf(theta, &sin_theta, &cos_theta);
+		fast_sincosf((1.0f - t) * theta, &s0, &c0);
+		fast_sincosf(t * theta, &s1, &c1);
+		float w0 = s0 / sin_theta;
+		float w1 = sign * s1 / sin_theta;
+		return Quaternion(w0 * data[0] + w1 * q.data[0],
+				  w0 * data[1] + w1 * q.data[1],
+				  w0 * data[2] + w1 * q.data[2],
+				  w0 * data[3] + w1 * q.data[3]);
+	}
+
 	/**
 	 * derivative
 	 */
@@ -132,10 +207,10 @@ public:
 
 	void from_dcm(const Matrix<3, 3> &m) {
 		// avoiding singularities by not using division equations
-		data[0] = 0.5f * sqrtf(1.0f + m.data[0][0] + m.data[1][1] + m.data[2][2]);
-		data[1] = 0.5f * sqrtf(1.0f + m.data[0][0] - m.data[1][1] - m.data[2][2]);
-		data[2] = 0.5f * sqrtf(1.0f - m.data[0][0] + m.data[1][1] - m.data[2][2]);
-		data[3] = 0.5f * sqrtf(1.0f - m.data[0][0] - m.data[1][1] + m.data[2][2]);
+		data[0] = 0.5f * fast_sqrtf(1.0f + m.data[0][0] + m.data[1][1] + m.data[2][2]);
+		data[1] = 0.5f * fast_sqrtf(1.0f + m.data[0][0] - m.data[1][1] - m.data[2][2]);
+		data[2] = 0.5f * fast_sqrtf(1.0f - m.data[0][0] + m.data[1][1] - m.data[2][2]);
+		data[3] = 0.5f * fast_sqrtf(1.0f - m.data[0][0] - m.data[1][1] + m.data[2][2]);
 	}
 
 	/**
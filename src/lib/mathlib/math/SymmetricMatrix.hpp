@@ -0,0 +1,237 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file SymmetricMatrix.hpp
+ *
+ * Packed symmetric matrix, e.g. for covariances
+ */
+
+#ifndef SYMMETRIC_MATRIX_HPP
+#define SYMMETRIC_MATRIX_HPP
+
+#include <stdio.h>
+#include <string.h>
+#include "Vector.hpp"
+#include "Matrix.hpp"
+
+namespace math
+{
+
+/**
+ * NxN symmetric matrix storing only the upper triangle.
+ *
+ * Needs about half the memory of Matrix<N, N> and cannot become
+ * asymmetric, so there is nothing to force symmetric after an update.
+ */
+template <unsigned int N>
+class __EXPORT SymmetricMatrix
+{
+public:
+	/**
+	 * number of stored elements
+	 */
+	static const unsigned int SIZE = N * (N + 1) / 2;
+
+	/**
+	 * upper triangle, row by row: (0, 0) .. (0, N-1), (1, 1) .. (1, N-1), ..
+	 */
+	float data[SIZE];
+
+	/**
+	 * trivial ctor
+	 * Initializes the elements to zero.
+	 */
+	SymmetricMatrix() :
+		data{}
+	{
+	}
+
+	/**
+	 * index into data of element (row, col), in either triangle
+	 */
+	static unsigned int index(unsigned int row, unsigned int col) {
+		if (row > col) {
+			unsigned int t = row;
+			row = col;
+			col = t;
+		}
+
+		return row * N - (row * (row - 1)) / 2 + (col - row);
+	}
+
+	/**
+	 * access by index
+	 */
+	float &operator()(const unsigned int row, const unsigned int col) {
+		return data[index(row, col)];
+	}
+
+	/**
+	 * access by index
+	 */
+	float operator()(const unsigned int row, const unsigned int col) const {
+		return data[index(row, col)];
+	}
+
+	/**
+	 * set from the upper triangle of a full matrix
+	 */
+	void set(const float m[N][N]) {
+		unsigned int k = 0;
+
+		for (unsigned int i = 0; i < N; i++)
+			for (unsigned int j = i; j < N; j++)
+				data[k++] = m[i][j];
+	}
+
+	/**
+	 * expand into a full matrix
+	 */
+	void get(float m[N][N]) const {
+		unsigned int k = 0;
+
+		for (unsigned int i = 0; i < N; i++) {
+			m[i][i] = data[k++];
+
+			for (unsigned int j = i + 1; j < N; j++) {
+				m[i][j] = data[k];
+				m[j][i] = data[k];
+				k++;
+			}
+		}
+	}
+
+	/**
+	 * multiplication by a vector, P * h (e.g. P * H' for a single row H)
+	 */
+	Vector<N> operator *(const Vector<N> &v) const {
+		Vector<N> res;
+		unsigned int k = 0;
+
+		/* each stored off-diagonal element contributes to two rows */
+		for (unsigned int i = 0; i < N; i++) {
+			float sum = data[k++] * v.data[i];
+
+			for (unsigned int j = i + 1; j < N; j++) {
+				sum += data[k] * v.data[j];
+				res.data[j] += data[k] * v.data[i];
+				k++;
+			}
+
+			res.data[i] += sum;
+		}
+
+		return res;
+	}
+
+	/**
+	 * column (= row) col, P * e_col, for measurements of a single state
+	 */
+	Vector<N> column(const unsigned int col) const {
+		Vector<N> res;
+
+		for (unsigned int i = 0; i < N; i++)
+			res.data[i] = data[index(i, col)];
+
+		return res;
+	}
+
+	/**
+	 * quadratic form h' * P * h, e.g. the innovation variance H P H'
+	 */
+	float quadratic(const Vector<N> &v) const {
+		float res = 0.0f;
+		unsigned int k = 0;
+
+		for (unsigned int i = 0; i < N; i++) {
+			float sum = 0.5f * data[k++] * v.data[i];
+
+			for (unsigned int j = i + 1; j < N; j++)
+				sum += data[k++] * v.data[j];
+
+			res += sum * v.data[i];
+		}
+
+		return 2.0f * res;
+	}
+
+	/**
+	 * symmetric rank-1 update, P += s * a * a'
+	 *
+	 * With a = P * H' and s = -1 / (H P H' + R) this is the covariance
+	 * update of a scalar Kalman measurement, P - K H P.
+	 */
+	void rank1_update(const Vector<N> &a, const float s) {
+		unsigned int k = 0;
+
+		for (unsigned int i = 0; i < N; i++) {
+			float sa = s * a.data[i];
+
+			for (unsigned int j = i; j < N; j++)
+				data[k++] += sa * a.data[j];
+		}
+	}
+
+	/**
+	 * set zero matrix
+	 */
+	void zero(void) {
+		memset(data, 0, sizeof(data));
+	}
+
+	/**
+	 * set identity matrix
+	 */
+	void identity(void) {
+		memset(data, 0, sizeof(data));
+
+		for (unsigned int i = 0; i < N; i++)
+			data[index(i, i)] = 1.0f;
+	}
+
+	void print(void) {
+		for (unsigned int i = 0; i < N; i++) {
+			printf("[ ");
+
+			for (unsigned int j = 0; j < N; j++)
+				printf("%.3f\t", (double)(*this)(i, j));
+
+			printf(" ]\n");
+		}
+	}
+};
+
+}
+
+#endif // SYMMETRIC_MATRIX_HPP
@@ -46,6 +46,7 @@
 #include <stdio.h>
 #include <math.h>
 #include "../CMSIS/Include/arm_math.h"
+#include "fast_math.h"
 
 namespace math
 {
@@ -62,40 +63,31 @@ public:
 	 */
 	float data[N];
 
-	/**
-	 * struct for using arm_math functions, represents column vector
-	 */
-	arm_matrix_instance_f32 arm_col;
-
 	/**
 	 * trivial ctor
 	 * initializes elements to zero
 	 */
 	VectorBase() :
-		data{},
-		arm_col{N, 1, &data[0]}
+		data{}
 	{
 
 	}
 
-	virtual ~VectorBase() {};
-
 	/**
-	 * copy ctor
+	 * setting ctor
 	 */
-	VectorBase(const VectorBase<N> &v) :
-		arm_col{N, 1, &data[0]}
-	{
-		memcpy(data, v.data, sizeof(data));
+	VectorBase(const float d[N]) {
+		memcpy(data, d, sizeof(data));
 	}
 
 	/**
-	 * setting ctor
+	 * descriptor for using arm_math functions, represents column vector
+	 *
+	 * Built on demand like MatrixBase::arm_mat().
 	 */
-	VectorBase(const float d[N]) :
-		arm_col{N, 1, &data[0]}
-	{
-		memcpy(data, d, sizeof(data));
+	arm_matrix_instance_f32 arm_col(void) const {
+		arm_matrix_instance_f32 inst = {N, 1, const_cast<float *>(&data[0])};
+		return inst;
 	}
 
 	/**
@@ -148,14 +140,6 @@ public:
 		return false;
 	}
 
-	/**
-	 * set to value
-	 */
-	const Vector<N> &operator =(const Vector<N> &v) {
-		memcpy(data, v.data, sizeof(data));
-		return *static_cast<const Vector<N>*>(this);
-	}
-
 	/**
 	 * negation
 	 */
@@ -280,6 +264,19 @@ public:
 		return res;
 	}
 
+	/**
+	 * element by element multiplication and addition: this .* v + a
+	 * Evaluates in a single pass, without the temporary of emult(v) + a.
+	 */
+	const Vector<N> emult_add(const Vector<N> &v, const Vector<N> &a) const {
+		Vector<N> res;
+
+		for (unsigned int i = 0; i < N; i++)
+			res.data[i] = data[i] * v.data[i] + a.data[i];
+
+		return res;
+	}
+
 	/**
 	 * element by element division
 	 */
@@ -313,7 +310,7 @@ public:
 		for (unsigned int i = 0; i < N; i++)
 			res += data[i] * data[i];
 
-		return sqrtf(res);
+		return fast_sqrtf(res);
 	}
 
 	/**
@@ -353,17 +350,7 @@ class __EXPORT Vector : public VectorBase<N>
 public:
 	Vector() : VectorBase<N>() {}
 
-	Vector(const Vector<N> &v) : VectorBase<N>(v) {}
-
 	Vector(const float d[N]) : VectorBase<N>(d) {}
-
-	/**
-	 * set to value
-	 */
-	const Vector<N> &operator =(const Vector<N> &v) {
-		memcpy(this->data, v.data, sizeof(this->data));
-		return *this;
-	}
 };
 
 template <>
@@ -372,12 +359,6 @@ class __EXPORT Vector<2> : public VectorBase<2>
 public:
 	Vector() : VectorBase<2>() {}
 
-	// simple copy is 1.6 times faster than memcpy
-	Vector(const Vector<2> &v) : VectorBase<2>() {
-		data[0] = v.data[0];
-		data[1] = v.data[1];
-	}
-
 	Vector(const float d[2]) : VectorBase<2>() {
 		data[0] = d[0];
 		data[1] = d[1];
@@ -396,15 +377,6 @@ public:
 		data[1] = d[1];
 	}
 
-	/**
-	 * set to value
-	 */
-	const Vector<2> &operator =(const Vector<2> &v) {
-		data[0] = v.data[0];
-		data[1] = v.data[1];
-		return *this;
-	}
-
 	float operator %(const Vector<2> &v) const {
 		return data[0] * v.data[1] - data[1] * v.data[0];
 	}
@@ -416,12 +388,6 @@ class __EXPORT Vector<3> : public VectorBase<3>
 public:
 	Vector() : VectorBase<3>() {}
 
-	// simple copy is 1.6 times faster than memcpy
-	Vector(const Vector<3> &v) : VectorBase<3>() {
-		for (unsigned int i = 0; i < 3; i++)
-			data[i] = v.data[i];
-	}
-
 	Vector(const float d[3]) : VectorBase<3>() {
 		for (unsigned int i = 0; i < 3; i++)
 			data[i] = d[i];
@@ -441,16 +407,6 @@ public:
 			data[i] = d[i];
 	}
 
-	/**
-	 * set to value
-	 */
-	const Vector<3> &operator =(const Vector<3> &v) {
-		for (unsigned int i = 0; i < 3; i++)
-			data[i] = v.data[i];
-
-		return *this;
-	}
-
 	Vector<3> operator %(const Vector<3> &v) const {
 		return Vector<3>(
 			       data[1] * v.data[2] - data[2] * v.data[1],
@@ -466,11 +422,6 @@ class __EXPORT Vector<4> : public VectorBase<4>
 public:
 	Vector() : VectorBase() {}
 
-	Vector(const Vector<4> &v) : VectorBase<4>() {
-		for (unsigned int i = 0; i < 4; i++)
-			data[i] = v.data[i];
-	}
-
 	Vector(const float d[4]) : VectorBase<4>() {
 		for (unsigned int i = 0; i < 4; i++)
 			data[i] = d[i];
@@ -490,16 +441,6 @@ public:
 		for (unsigned int i = 0; i < 4; i++)
 			data[i] = d[i];
 	}
-
-	/**
-	 * set to value
-	 */
-	const Vector<4> &operator =(const Vector<4> &v) {
-		for (unsigned int i = 0; i < 4; i++)
-			data[i] = v.data[i];
-
-		return *this;
-	}
 };
 
 }
@@ -0,0 +1,164 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file fast_math.h
+ *
+ * Bounded error approximations of libm functions for control loops.
+ *
+ * Plain static inline functions so they can be used from C and C++.
+ * None of them set errno. The error bounds are checked by test_mathlib.
+ */
+
+#pragma once
+
+#include <math.h>
+
+/** max absolute error of fast_atan2f() and fast_asinf(), rad, measured 1.17e-5 */
+#define FAST_ATAN2F_MAX_ERROR	1.2e-5f
+
+/** max absolute error of fast_sincosf() for |x| < FAST_SINCOSF_MAX_ARG, measured 1.06e-7 */
+#define FAST_SINCOSF_MAX_ERROR	1.1e-7f
+#define FAST_SINCOSF_MAX_ARG	100.0f
+
+/**
+ * Square root, a single vsqrt.f32 on an FPU.
+ *
+ * With math errno semantics sqrtf() compiles to a check and a library
+ * call for negative input. Here negative input just returns NaN.
+ */
+static inline float fast_sqrtf(float x)
+{
+#if defined(__VFP_FP__) && !defined(__SOFTFP__)
+	float r;
+	__asm__("vsqrt.f32 %0, %1" : "=t"(r) : "t"(x));
+	return r;
+#else
+	return sqrtf(x);
+#endif
+}
+
+/**
+ * Four quadrant arc tangent.
+ *
+ * Reduces to atan(a), 0 <= a <= 1, which is approximated by the
+ * polynomial of Abramowitz and Stegun 4.4.47. Returns 0 for (0, 0).
+ */
+static inline float fast_atan2f(float y, float x)
+{
+	float ax = fabsf(x);
+	float ay = fabsf(y);
+	float mx = (ax > ay) ? ax : ay;
+	float mn = (ax > ay) ? ay : ax;
+
+	if (!(mx > 0.0f)) {
+		/* (0, 0), or NaN input: leave propagating NaN to the caller */
+		return (mx == 0.0f) ? 0.0f : x + y;
+	}
+
+	float a = mn / mx;
+	float s = a * a;
+	float r = a * (0.9998660f + s * (-0.3302995f + s * (0.1801410f + s * (-0.0851330f + s * 0.0208351f))));
+
+	if (ay > ax)
+		r = 1.57079637f - r;
+
+	if (x < 0.0f)
+		r = 3.14159274f - r;
+
+	if (y < 0.0f)
+		r = -r;
+
+	return r;
+}
+
+/**
+ * Arc sine, x is constrained to [-1, 1].
+ *
+ * Unlike asinf() a value slightly out of range from rounding gives
+ * +-pi/2 and not NaN.
+ */
+static inline float fast_asinf(float x)
+{
+	if (x > 1.0f)
+		x = 1.0f;
+
+	if (x < -1.0f)
+		x = -1.0f;
+
+	/* (1 - x)(1 + x) keeps the precision of 1 - x^2 close to +-1 */
+	return fast_atan2f(x, fast_sqrtf((1.0f - x) * (1.0f + x)));
+}
+
+/**
+ * Sine and cosine of the same angle.
+ *
+ * Reduces x to [-pi/4, pi/4] around the nearest multiple of pi/2 and
+ * evaluates both Taylor polynomials on the remainder.
+ */
+static inline void fast_sincosf(float x, float *s, float *c)
+{
+	float kf = x * 0.636619772f;
+	int k = (int)(kf + ((kf >= 0.0f) ? 0.5f : -0.5f));
+
+	/* pi/2 split in three parts, the first two multiply exactly by k */
+	float r = x - (float)k * 1.5703125f;
+	r -= (float)k * 4.837512969970703125e-4f;
+	r -= (float)k * 7.54978995489188216e-8f;
+
+	float r2 = r * r;
+	float sn = r + r * r2 * (-1.66666667e-1f + r2 * (8.33333333e-3f + r2 * (-1.98412698e-4f + r2 * 2.75573192e-6f)));
+	float cs = 1.0f + r2 * (-0.5f + r2 * (4.16666667e-2f + r2 * (-1.38888889e-3f + r2 * 2.48015873e-5f)));
+
+	switch (k & 3) {
+	case 0:
+		*s = sn;
+		*c = cs;
+		break;
+
+	case 1:
+		*s = cs;
+		*c = -sn;
+		break;
+
+	case 2:
+		*s = -sn;
+		*c = -cs;
+		break;
+
+	default:
+		*s = -cs;
+		*c = sn;
+		break;
+	}
+}
@@ -40,8 +40,73 @@
 
 #pragma once
 
+#include <math.h>
+
 namespace math
 {
+
+/**
+ * Second order Butterworth coefficients for one cutoff frequency
+ */
+struct LowPassFilter2pCoefficients {
+    float cutoff_freq;
+    float b0;
+    float b1;
+    float b2;
+    float a1;
+    float a2;
+};
+
+namespace detail
+{
+// Taylor series of sin (term = x, n = 1) or cos (term = 1, n = 0), exact to
+// double precision for the |x| < pi/2 a filter below Nyquist needs
+constexpr double lowpass_2p_series(double x2, double term, unsigned n)
+{
+    return (n > 24) ? 0.0 : term + lowpass_2p_series(x2, -term * x2 / ((n + 1) * (n + 2)), n + 2);
+}
+
+constexpr double lowpass_2p_tan(double x)
+{
+    return lowpass_2p_series(x * x, x, 1) / lowpass_2p_series(x * x, 1.0, 0);
+}
+
+// 1 + 2 cos(pi/4) ohm + ohm^2
+constexpr double lowpass_2p_c(double ohm)
+{
+    return 1.0 + 1.4142135623730951 * ohm + ohm * ohm;
+}
+
+constexpr LowPassFilter2pCoefficients lowpass_2p_from_ohm(float cutoff_freq, double ohm, double c)
+{
+    return LowPassFilter2pCoefficients {
+        cutoff_freq,
+        static_cast<float>(ohm * ohm / c),
+        static_cast<float>(2.0 * ohm * ohm / c),
+        static_cast<float>(ohm * ohm / c),
+        static_cast<float>(2.0 * (ohm * ohm - 1.0) / c),
+        static_cast<float>((1.0 - 1.4142135623730951 * ohm + ohm * ohm) / c)
+    };
+}
+
+constexpr LowPassFilter2pCoefficients lowpass_2p_from_ohm(float cutoff_freq, double ohm)
+{
+    return lowpass_2p_from_ohm(cutoff_freq, ohm, lowpass_2p_c(ohm));
+}
+} // namespace detail
+
+/**
+ * The coefficients LowPassFilter2p::coefficients() computes, evaluated by
+ * the compiler when the frequencies are constants. A cutoff of zero or
+ * less gives a filter that passes samples through.
+ */
+constexpr LowPassFilter2pCoefficients lowpass_2p_coefficients(float sample_freq, float cutoff_freq)
+{
+    return (cutoff_freq <= 0.0f) ? LowPassFilter2pCoefficients { cutoff_freq, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f } :
+           detail::lowpass_2p_from_ohm(cutoff_freq,
+                                       detail::lowpass_2p_tan(3.14159265358979323846 * cutoff_freq / sample_freq));
+}
+
 class __EXPORT LowPassFilter2p
 {
 public:
@@ -60,11 +125,42 @@ public:
         set_cutoff_frequency(sample_freq, cutoff_freq);
     }
 
+    // constructor for coefficients fixed at build time, see lowpass_2p_coefficients()
+    explicit LowPassFilter2p(const LowPassFilter2pCoefficients &coeff) :
+        _cutoff_freq(coeff.cutoff_freq),
+        _a1(coeff.a1),
+        _a2(coeff.a2),
+        _b0(coeff.b0),
+        _b1(coeff.b1),
+        _b2(coeff.b2),
+        _delay_element_1(0.0f),
+        _delay_element_2(0.0f)
+    {
+    }
+
     /**
      * Change filter parameters
      */
     void set_cutoff_frequency(float sample_freq, float cutoff_freq);
 
+    /**
+     * Change filter parameters to precomputed ones
+     */
+    void set_coefficients(const LowPassFilter2pCoefficients &coeff) {
+        _cutoff_freq = coeff.cutoff_freq;
+        _b0 = coeff.b0;
+        _b1 = coeff.b1;
+        _b2 = coeff.b2;
+        _a1 = coeff.a1;
+        _a2 = coeff.a2;
+    }
+
+    /**
+     * Compute the second order Butterworth coefficients, cutoff_freq must be > 0
+     */
+    static void coefficients(float sample_freq, float cutoff_freq,
+                             float &b0, float &b1, float &b2, float &a1, float &a2);
+
     /**
      * Add a new raw value to the filter
      *
@@ -95,4 +191,148 @@ private:
     float           _delay_element_2;        // buffered sample -2
 };
 
+/**
+ * Bank of N second order low pass filters sharing one set of coefficients,
+ * e.g. the three axes of a gyro. Samples are interleaved by channel,
+ * in[i * N + channel], as they come out of a sensor FIFO.
+ */
+template <unsigned N>
+class __EXPORT LowPassFilter2pN
+{
+public:
+    // constructor
+    LowPassFilter2pN(float sample_freq, float cutoff_freq) :
+        _cutoff_freq(cutoff_freq),
+        _a1(0.0f),
+        _a2(0.0f),
+        _b0(0.0f),
+        _b1(0.0f),
+        _b2(0.0f),
+        _delay_element_1{},
+        _delay_element_2{}
+    {
+        // set initial parameters
+        set_cutoff_frequency(sample_freq, cutoff_freq);
+    }
+
+    // constructor for coefficients fixed at build time, see lowpass_2p_coefficients()
+    explicit LowPassFilter2pN(const LowPassFilter2pCoefficients &coeff) :
+        _cutoff_freq(coeff.cutoff_freq),
+        _a1(coeff.a1),
+        _a2(coeff.a2),
+        _b0(coeff.b0),
+        _b1(coeff.b1),
+        _b2(coeff.b2),
+        _delay_element_1{},
+        _delay_element_2{}
+    {
+    }
+
+    /**
+     * Change filter parameters to precomputed ones
+     */
+    void set_coefficients(const LowPassFilter2pCoefficients &coeff) {
+        _cutoff_freq = coeff.cutoff_freq;
+        _b0 = coeff.b0;
+        _b1 = coeff.b1;
+        _b2 = coeff.b2;
+        _a1 = coeff.a1;
+        _a2 = coeff.a2;
+    }
+
+    /**
+     * Change filter parameters
+     */
+    void set_cutoff_frequency(float sample_freq, float cutoff_freq) {
+        _cutoff_freq = cutoff_freq;
+        if (_cutoff_freq <= 0.0f) {
+            // no filtering
+            return;
+        }
+        LowPassFilter2p::coefficients(sample_freq, cutoff_freq, _b0, _b1, _b2, _a1, _a2);
+    }
+
+    /**
+     * Add one new raw value per channel to the filters
+     *
+     * @param sample    N raw values
+     * @param output    N filtered values, may be the same as sample
+     */
+    void apply(const float sample[N], float output[N]) {
+        apply(sample, output, 1);
+    }
+
+    /**
+     * Filter a block of interleaved samples
+     *
+     * @param in        nsamples * N raw values
+     * @param out       nsamples * N filtered values, may be the same as in
+     * @param nsamples  number of samples per channel
+     */
+    void apply(const float *in, float *out, unsigned nsamples) {
+        if (_cutoff_freq <= 0.0f) {
+            // no filtering
+            for (unsigned i = 0; i < nsamples * N; i++) {
+                out[i] = in[i];
+            }
+            return;
+        }
+
+        // work on local copies so the state can stay in registers for the block
+        float d1[N];
+        float d2[N];
+        for (unsigned c = 0; c < N; c++) {
+            d1[c] = _delay_element_1[c];
+            d2[c] = _delay_element_2[c];
+        }
+
+        for (unsigned s = 0; s < nsamples; s++) {
+            for (unsigned c = 0; c < N; c++) {
+                float sample = in[s * N + c];
+                float delay_element_0 = sample - d1[c] * _a1 - d2[c] * _a2;
+                if (isnan(delay_element_0) || isinf(delay_element_0)) {
+                    // don't allow bad values to propagate via the filter
+                    delay_element_0 = sample;
+                }
+                out[s * N + c] = delay_element_0 * _b0 + d1[c] * _b1 + d2[c] * _b2;
+
+                d2[c] = d1[c];
+                d1[c] = delay_element_0;
+            }
+        }
+
+        for (unsigned c = 0; c < N; c++) {
+            _delay_element_1[c] = d1[c];
+            _delay_element_2[c] = d2[c];
+        }
+    }
+
+    /**
+     * Return the cutoff frequency
+     */
+    float get_cutoff_freq(void) const {
+        return _cutoff_freq;
+    }
+
+    /**
+     * Reset the filter state to these values
+     */
+    void reset(const float sample[N], float output[N]) {
+        for (unsigned c = 0; c < N; c++) {
+            _delay_element_1[c] = _delay_element_2[c] = sample[c];
+        }
+        apply(sample, output);
+    }
+
+private:
+    float           _cutoff_freq;
+    float           _a1;
+    float           _a2;
+    float           _b0;
+    float           _b1;
+    float           _b2;
+    float           _delay_element_1[N];     // buffered sample -1 per channel
+    float           _delay_element_2[N];     // buffered sample -2 per channel
+};
+
 } // namespace math
@@ -44,6 +44,7 @@
 #include "math/Vector.hpp"
 #include "math/Matrix.hpp"
 #include "math/Quaternion.hpp"
+#include "math/SymmetricMatrix.hpp"
 #include "math/Limits.hpp"
 
 #endif
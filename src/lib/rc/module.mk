@@ -32,9 +32,10 @@
 ############################################################################
 
 #
-# Yuntec ST24 transmitter protocol decoder
+# Yuntec ST24 transmitter protocol decoder and shared RC channel decoding
 #
 
-SRCS		 =	st24.c
+SRCS		 =	st24.c \
+			rc_decode.c
 
 MAXOPTIMIZATION	 = -Os
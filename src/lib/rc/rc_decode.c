@@ -0,0 +1,99 @@
+/****************************************************************************
+ *
+ *	Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *	notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *	notice, this list of conditions and the following disclaimer in
+ *	the documentation and/or other materials provided with the
+ *	distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *	used to endorse or promote products derived from this software
+ *	without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file rc_decode.c
+ *
+ * Channel unpacking and scaling shared by the RC protocol decoders.
+ */
+
+#include <stdbool.h>
+#include "rc_decode.h"
+
+#define SBUS_DATA_CHANNELS	16
+
+/*
+ * Bit position of each S.BUS channel in the data bytes, as the byte the
+ * channel starts in and the right shift within the three bytes from
+ * there. The channels are 11 bits, least significant bit first.
+ */
+struct sbus_channel_pos {
+	uint8_t byte;
+	uint8_t shift;
+};
+
+static const struct sbus_channel_pos sbus_channel_pos[SBUS_DATA_CHANNELS] = {
+	{ 0, 0}, { 1, 3}, { 2, 6}, { 4, 1}, { 5, 4}, { 6, 7}, { 8, 2}, { 9, 5},
+	{11, 0}, {12, 3}, {13, 6}, {15, 1}, {16, 4}, {17, 7}, {19, 2}, {20, 5}
+};
+
+void
+rc_scale_channels(uint16_t *values, unsigned count, uint16_t mul, uint8_t shift, int16_t offset)
+{
+	const uint32_t round = 1 << (shift - 1);
+
+	for (unsigned i = 0; i < count; i++)
+		values[i] = (uint16_t)(((values[i] * (uint32_t)mul + round) >> shift) + offset);
+}
+
+void
+rc_unpack_sbus(const uint8_t *data, uint16_t *values, unsigned count)
+{
+	if (count > SBUS_DATA_CHANNELS)
+		count = SBUS_DATA_CHANNELS;
+
+	for (unsigned i = 0; i < count; i++) {
+		const uint8_t *p = &data[sbus_channel_pos[i].byte];
+
+		/* the last channel ends in the last data byte, so the third byte may be the flags */
+		uint32_t bits = p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16);
+
+		values[i] = (bits >> sbus_channel_pos[i].shift) & 0x7ff;
+	}
+}
+
+void
+rc_unpack_12bit(const uint8_t *data, uint16_t *values, unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i + 1 < count; i += 2, data += 3) {
+		values[i] = (data[0] << 4) | (data[1] >> 4);
+		values[i + 1] = ((data[1] & 0x0f) << 8) | data[2];
+	}
+
+	/* an odd count ends on the first channel of a pair */
+	if (i < count)
+		values[i] = (data[0] << 4) | (data[1] >> 4);
+}
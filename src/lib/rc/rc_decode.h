@@ -0,0 +1,87 @@
+/****************************************************************************
+ *
+ *	Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *	notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *	notice, this list of conditions and the following disclaimer in
+ *	the documentation and/or other materials provided with the
+ *	distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *	used to endorse or promote products derived from this software
+ *	without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file rc_decode.h
+ *
+ * Channel unpacking and scaling shared by the RC protocol decoders.
+ *
+ * Channel values are unpacked with precomputed bit positions and scaled
+ * with integer arithmetic, which matters on the IO processor without an
+ * FPU.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+__BEGIN_DECLS
+
+/**
+ * Scale raw channel values in place.
+ *
+ * Computes (value * mul) / 2^shift, rounded to nearest, plus offset, for
+ * each channel. The factor is a fraction with a power of two denominator,
+ * 5 / 2^3 for the 1000 / 1600 of S.BUS and 125 / 2^9 for the 1000 / 4096
+ * of ST24, so the results match the floating point scaling exactly.
+ *
+ * @param values	Channel values to scale.
+ * @param count		Number of channels.
+ * @param mul		Numerator of the scale factor.
+ * @param shift		log2 of the denominator of the scale factor, at least 1.
+ * @param offset	Offset added after scaling.
+ */
+__EXPORT void rc_scale_channels(uint16_t *values, unsigned count, uint16_t mul, uint8_t shift, int16_t offset);
+
+/**
+ * Unpack the 11 bit channels of an S.BUS frame.
+ *
+ * @param data		The 22 data bytes, following the start byte.
+ * @param values	Raw channel values.
+ * @param count		Number of channels to unpack, at most 16.
+ */
+__EXPORT void rc_unpack_sbus(const uint8_t *data, uint16_t *values, unsigned count);
+
+/**
+ * Unpack 12 bit channels, two packed in three bytes, high nibble first.
+ *
+ * This is the ST24 channel data layout.
+ *
+ * @param data		The packed channel data.
+ * @param values	Raw channel values.
+ * @param count		Number of channels to unpack.
+ */
+__EXPORT void rc_unpack_12bit(const uint8_t *data, uint16_t *values, unsigned count);
+
+__END_DECLS
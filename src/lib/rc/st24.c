@@ -42,6 +42,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include "st24.h"
+#include "rc_decode.h"
 
 enum ST24_DECODE_STATE {
 	ST24_DECODE_STATE_UNSYNCED = 0,
@@ -71,6 +72,10 @@ const char *decode_states[] = {"UNSYNCED",
 #define ST24_SCALE_FACTOR ((ST24_TARGET_MAX - ST24_TARGET_MIN) / (ST24_RANGE_MAX - ST24_RANGE_MIN))
 #define ST24_SCALE_OFFSET (int)(ST24_TARGET_MIN - (ST24_SCALE_FACTOR * ST24_RANGE_MIN + 0.5f))
 
+/* ST24_SCALE_FACTOR as a fixed point fraction, for decoding without floating point */
+#define ST24_SCALE_MUL		125
+#define ST24_SCALE_SHIFT	9
+
 static enum ST24_DECODE_STATE _decode_state = ST24_DECODE_STATE_UNSYNCED;
 static unsigned _rxlen;
 
@@ -177,25 +182,12 @@ int st24_decode(uint8_t byte, uint8_t *rssi, uint8_t *rx_count, uint16_t *channe
 					*rssi = d->rssi;
 					*rx_count = d->packet_count;
 
-					/* this can lead to rounding of the strides */
 					*channel_count = (max_chan_count < 12) ? max_chan_count : 12;
 
-					unsigned stride_count = (*channel_count * 3) / 2;
-					unsigned chan_index = 0;
-
-					for (unsigned i = 0; i < stride_count; i += 3) {
-						channels[chan_index] = ((uint16_t)d->channel[i] << 4);
-						channels[chan_index] |= ((uint16_t)(0xF0 & d->channel[i + 1]) >> 4);
-						/* convert values to 1000-2000 ppm encoding in a not too sloppy fashion */
-						channels[chan_index] = (uint16_t)(channels[chan_index] * ST24_SCALE_FACTOR + .5f) + ST24_SCALE_OFFSET;
-						chan_index++;
-
-						channels[chan_index] = ((uint16_t)d->channel[i + 2]);
-						channels[chan_index] |= (((uint16_t)(0x0F & d->channel[i + 1])) << 8);
-						/* convert values to 1000-2000 ppm encoding in a not too sloppy fashion */
-						channels[chan_index] = (uint16_t)(channels[chan_index] * ST24_SCALE_FACTOR + .5f) + ST24_SCALE_OFFSET;
-						chan_index++;
-					}
+					rc_unpack_12bit(d->channel, channels, *channel_count);
+
+					/* convert values to 1000-2000 ppm encoding in a not too sloppy fashion */
+					rc_scale_channels(channels, *channel_count, ST24_SCALE_MUL, ST24_SCALE_SHIFT, ST24_SCALE_OFFSET);
 				}
 				break;
 
@@ -205,25 +197,12 @@ int st24_decode(uint8_t byte, uint8_t *rssi, uint8_t *rx_count, uint16_t *channe
 					*rssi = d->rssi;
 					*rx_count = d->packet_count;
 
-					/* this can lead to rounding of the strides */
 					*channel_count = (max_chan_count < 24) ? max_chan_count : 24;
 
-					unsigned stride_count = (*channel_count * 3) / 2;
-					unsigned chan_index = 0;
-
-					for (unsigned i = 0; i < stride_count; i += 3) {
-						channels[chan_index] = ((uint16_t)d->channel[i] << 4);
-						channels[chan_index] |= ((uint16_t)(0xF0 & d->channel[i + 1]) >> 4);
-						/* convert values to 1000-2000 ppm encoding in a not too sloppy fashion */
-						channels[chan_index] = (uint16_t)(channels[chan_index] * ST24_SCALE_FACTOR + .5f) + ST24_SCALE_OFFSET;
-						chan_index++;
-
-						channels[chan_index] = ((uint16_t)d->channel[i + 2]);
-						channels[chan_index] |= (((uint16_t)(0x0F & d->channel[i + 1])) << 8);
-						/* convert values to 1000-2000 ppm encoding in a not too sloppy fashion */
-						channels[chan_index] = (uint16_t)(channels[chan_index] * ST24_SCALE_FACTOR + .5f) + ST24_SCALE_OFFSET;
-						chan_index++;
-					}
+					rc_unpack_12bit(d->channel, channels, *channel_count);
+
+					/* convert values to 1000-2000 ppm encoding in a not too sloppy fashion */
+					rc_scale_channels(channels, *channel_count, ST24_SCALE_MUL, ST24_SCALE_SHIFT, ST24_SCALE_OFFSET);
 				}
 				break;
 
@@ -0,0 +1,266 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2015 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file terrain.c
+ *
+ * Terrain tile cache, see terrain.h.
+ */
+
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "terrain.h"
+
+#define TILE_BYTES	(sizeof(int16_t) * TERRAIN_TILE_SAMPLES * TERRAIN_TILE_SAMPLES)
+
+/* position in tile and cell of the tile */
+struct terrain_pos {
+	uint32_t	tile;
+	float		n;	/**< samples north of the tile corner, [0, TERRAIN_TILE_CELLS) */
+	float		e;	/**< samples east of the tile corner */
+};
+
+static bool
+locate(const struct terrain_s *t, double lat, double lon, struct terrain_pos *pos)
+{
+	double n = (lat * 1e7 - t->header.lat_origin) / t->header.spacing;
+	double e = (lon * 1e7 - t->header.lon_origin) / t->header.spacing;
+
+	if (!(n >= 0.0 && n < (double)t->header.tiles_lat * TERRAIN_TILE_CELLS &&
+	      e >= 0.0 && e < (double)t->header.tiles_lon * TERRAIN_TILE_CELLS)) {
+		return false;
+	}
+
+	unsigned tile_n = (unsigned)n / TERRAIN_TILE_CELLS;
+	unsigned tile_e = (unsigned)e / TERRAIN_TILE_CELLS;
+
+	pos->tile = tile_n * t->header.tiles_lon + tile_e;
+	pos->n = (float)(n - tile_n * TERRAIN_TILE_CELLS);
+	pos->e = (float)(e - tile_e * TERRAIN_TILE_CELLS);
+
+	return true;
+}
+
+static struct terrain_tile *
+find_tile(struct terrain_s *t, uint32_t tile)
+{
+	for (unsigned i = 0; i < TERRAIN_CACHE_TILES; i++) {
+		if (t->tiles[i].valid && t->tiles[i].tile == tile) {
+			return &t->tiles[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void
+queue_tile(struct terrain_s *t, uint32_t tile)
+{
+	for (unsigned i = 0; i < t->queued; i++) {
+		if (t->queue[i] == tile) {
+			return;
+		}
+	}
+
+	/* a full queue drops the request, it is made again while still needed */
+	if (t->queued < TERRAIN_QUEUE_LEN) {
+		t->queue[t->queued++] = tile;
+	}
+}
+
+int
+terrain_open(struct terrain_s *t, const char *path)
+{
+	memset(t, 0, sizeof(*t));
+	t->fd = open(path, O_RDONLY);
+
+	if (t->fd < 0) {
+		return -1;
+	}
+
+	if (read(t->fd, &t->header, sizeof(t->header)) != sizeof(t->header) ||
+	    memcmp(t->header.magic, TERRAIN_MAGIC, sizeof(t->header.magic)) != 0 ||
+	    t->header.tile_samples != TERRAIN_TILE_SAMPLES ||
+	    t->header.spacing == 0) {
+		terrain_close(t);
+		return -1;
+	}
+
+	return 0;
+}
+
+void
+terrain_close(struct terrain_s *t)
+{
+	if (t->fd >= 0) {
+		close(t->fd);
+	}
+
+	memset(t, 0, sizeof(*t));
+	t->fd = -1;
+}
+
+bool
+terrain_valid(const struct terrain_s *t)
+{
+	return t->fd >= 0;
+}
+
+bool
+terrain_height(struct terrain_s *t, double lat, double lon, float *height)
+{
+	struct terrain_pos pos;
+
+	if (!terrain_valid(t) || !locate(t, lat, lon, &pos)) {
+		return false;
+	}
+
+	struct terrain_tile *tile = find_tile(t, pos.tile);
+
+	if (tile == NULL) {
+		t->misses++;
+		queue_tile(t, pos.tile);
+		return false;
+	}
+
+	t->hits++;
+	tile->age = ++t->clock;
+
+	/* bilinear between the four samples around the position */
+	unsigned i = (unsigned)pos.n;
+	unsigned j = (unsigned)pos.e;
+	float fn = pos.n - i;
+	float fe = pos.e - j;
+
+	int16_t h00 = tile->height[i][j];
+	int16_t h01 = tile->height[i][j + 1];
+	int16_t h10 = tile->height[i + 1][j];
+	int16_t h11 = tile->height[i + 1][j + 1];
+
+	if (h00 == TERRAIN_NO_DATA || h01 == TERRAIN_NO_DATA ||
+	    h10 == TERRAIN_NO_DATA || h11 == TERRAIN_NO_DATA) {
+		return false;
+	}
+
+	float south = h00 + (h01 - h00) * fe;
+	float north = h10 + (h11 - h10) * fe;
+
+	*height = south + (north - south) * fn;
+
+	return true;
+}
+
+void
+terrain_prefetch(struct terrain_s *t, double lat, double lon)
+{
+	struct terrain_pos pos;
+
+	if (terrain_valid(t) && locate(t, lat, lon, &pos) && find_tile(t, pos.tile) == NULL) {
+		queue_tile(t, pos.tile);
+	}
+}
+
+void
+terrain_prefetch_leg(struct terrain_s *t, double lat_start, double lon_start,
+		     double lat_end, double lon_end)
+{
+	if (!terrain_valid(t)) {
+		return;
+	}
+
+	/* half a tile per step does not skip any tile on the way */
+	double step = 0.5e-7 * TERRAIN_TILE_CELLS * t->header.spacing;
+	double d = fmax(fabs(lat_end - lat_start), fabs(lon_end - lon_start));
+	unsigned steps = (unsigned)(d / step) + 1;
+
+	/* long legs only get their first tiles, the rest follows as the leg is flown */
+	if (steps > TERRAIN_QUEUE_LEN) {
+		steps = TERRAIN_QUEUE_LEN;
+	}
+
+	for (unsigned i = 0; i <= steps; i++) {
+		double f = (d > 0.0) ? fmin(i * step / d, 1.0) : 1.0;
+		terrain_prefetch(t, lat_start + f * (lat_end - lat_start), lon_start + f * (lon_end - lon_start));
+	}
+}
+
+bool
+terrain_update(struct terrain_s *t)
+{
+	if (!terrain_valid(t) || t->queued == 0) {
+		return false;
+	}
+
+	uint32_t tile = t->queue[0];
+	t->queued--;
+	memmove(&t->queue[0], &t->queue[1], t->queued * sizeof(t->queue[0]));
+
+	if (find_tile(t, tile) != NULL) {
+		return false;
+	}
+
+	/* free slot or the least recently used tile */
+	struct terrain_tile *slot = &t->tiles[0];
+
+	for (unsigned i = 0; i < TERRAIN_CACHE_TILES; i++) {
+		if (!t->tiles[i].valid) {
+			slot = &t->tiles[i];
+			break;
+		}
+
+		if (t->tiles[i].age < slot->age) {
+			slot = &t->tiles[i];
+		}
+	}
+
+	slot->valid = false;
+
+	off_t offset = sizeof(t->header) + (off_t)tile * TILE_BYTES;
+
+	if (lseek(t->fd, offset, SEEK_SET) != offset ||
+	    read(t->fd, slot->height, TILE_BYTES) != (ssize_t)TILE_BYTES) {
+		return false;
+	}
+
+	slot->tile = tile;
+	slot->age = ++t->clock;
+	slot->valid = true;
+	t->loads++;
+
+	return true;
+}
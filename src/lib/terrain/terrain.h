@@ -0,0 +1,141 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2015 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file terrain.h
+ *
+ * Ground height lookup from a tiled terrain file on the SD card.
+ *
+ * The file starts with a terrain_file_header followed by the tiles, row by
+ * row from the south west corner. A tile is TERRAIN_TILE_SAMPLES x
+ * TERRAIN_TILE_SAMPLES heights in meters above MSL, int16 little endian,
+ * south to north and west to east within the tile. Neighbouring tiles share
+ * their edge samples, so any point can be interpolated from a single tile.
+ * Tools/px_terrain_gen.py writes the file from SRTM data.
+ *
+ * A few tiles are kept in RAM. terrain_height() only looks at the cached
+ * tiles and never touches the file, a missing tile is queued instead and
+ * read by the next terrain_update(). The owner calls terrain_update() from
+ * its loop, so the SD card is read at most one tile per call and never
+ * from the code that asks for a height.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+__BEGIN_DECLS
+
+#define TERRAIN_FILENAME	"/fs/microsd/terrain.dat"
+
+#define TERRAIN_MAGIC		"PXT1"
+#define TERRAIN_TILE_CELLS	16
+#define TERRAIN_TILE_SAMPLES	(TERRAIN_TILE_CELLS + 1)
+#define TERRAIN_NO_DATA		(-32768)	/**< sample without height, as in SRTM voids */
+
+#define TERRAIN_CACHE_TILES	8
+#define TERRAIN_QUEUE_LEN	8
+
+struct terrain_file_header {
+	char		magic[4];
+	int32_t		lat_origin;	/**< south west corner, 1e-7 degrees */
+	int32_t		lon_origin;	/**< south west corner, 1e-7 degrees */
+	uint32_t	spacing;	/**< distance between samples, 1e-7 degrees */
+	uint16_t	tiles_lat;	/**< number of tile rows */
+	uint16_t	tiles_lon;	/**< number of tiles per row */
+	uint16_t	tile_samples;	/**< TERRAIN_TILE_SAMPLES */
+	uint16_t	reserved;
+} __attribute__((packed));
+
+struct terrain_tile {
+	int16_t		height[TERRAIN_TILE_SAMPLES][TERRAIN_TILE_SAMPLES];	/**< [north][east] */
+	uint32_t	tile;		/**< index in the file */
+	uint32_t	age;		/**< cache clock of the last use */
+	bool		valid;
+};
+
+struct terrain_s {
+	int			fd;
+	struct terrain_file_header header;
+	struct terrain_tile	tiles[TERRAIN_CACHE_TILES];
+	uint32_t		clock;
+	uint32_t		queue[TERRAIN_QUEUE_LEN];	/**< tiles to read, oldest first */
+	unsigned		queued;
+	unsigned		hits;
+	unsigned		misses;
+	unsigned		loads;
+};
+
+/**
+ * Open a terrain file.
+ *
+ * @return 0, or -1 if the file is missing or not a terrain file.
+ * A terrain_s that failed to open answers no queries.
+ */
+__EXPORT int terrain_open(struct terrain_s *t, const char *path);
+
+__EXPORT void terrain_close(struct terrain_s *t);
+
+__EXPORT bool terrain_valid(const struct terrain_s *t);
+
+/**
+ * Ground height at a position, from the cached tiles only.
+ *
+ * @param lat latitude in degrees
+ * @param lon longitude in degrees
+ * @param height ground height above MSL in meters
+ * @return true if the position is covered by a cached tile with data.
+ * If the tile is not cached yet it is queued and false is returned.
+ */
+__EXPORT bool terrain_height(struct terrain_s *t, double lat, double lon, float *height);
+
+/**
+ * Queue the tile of a position, without waiting for it.
+ */
+__EXPORT void terrain_prefetch(struct terrain_s *t, double lat, double lon);
+
+/**
+ * Queue the tiles along a straight leg, start first.
+ */
+__EXPORT void terrain_prefetch_leg(struct terrain_s *t, double lat_start, double lon_start,
+				   double lat_end, double lon_end);
+
+/**
+ * Read the oldest queued tile from the file.
+ *
+ * @return true if a tile was read.
+ */
+__EXPORT bool terrain_update(struct terrain_s *t);
+
+__END_DECLS
@@ -67,11 +67,13 @@
 #include <math.h>
 #include <uORB/uORB.h>
 #include <uORB/topics/debug_key_value.h>
-#include <uORB/topics/sensor_combined.h>
+#include <uORB/topics/sensor_imu.h>
+#include <uORB/topics/vehicle_magnetometer.h>
 #include <uORB/topics/vehicle_attitude.h>
 #include <uORB/topics/vehicle_control_mode.h>
 #include <uORB/topics/parameter_update.h>
 #include <drivers/drv_hrt.h>
+#include <mathlib/math/fast_math.h>
 
 #include <systemlib/systemlib.h>
 #include <systemlib/perf_counter.h>
@@ -93,7 +95,6 @@ static int attitude_estimator_so3_task;				/**< Handle of deamon task / thread *
 
 //! Auxiliary variables to reduce number of repeated operations
 static float q0 = 1.0f, q1 = 0.0f, q2 = 0.0f, q3 = 0.0f;	/** quaternion of sensor frame relative to auxiliary frame */
-static float dq0 = 0.0f, dq1 = 0.0f, dq2 = 0.0f, dq3 = 0.0f;	/** quaternion of sensor frame relative to auxiliary frame */
 static float gyro_bias[3] = {0.0f, 0.0f, 0.0f}; /** bias estimation */
 static float q0q0, q0q1, q0q2, q0q3;
 static float q1q1, q1q2, q1q3;
@@ -112,7 +113,6 @@ int attitude_estimator_so3_thread_main(int argc, char *argv[]);
 static void usage(const char *reason);
 
 /* Function prototypes */
-float invSqrt(float number);
 void NonlinearSO3AHRSinit(float ax, float ay, float az, float mx, float my, float mz);
 void NonlinearSO3AHRSupdate(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz, float twoKp, float twoKi, float dt);
 
@@ -185,24 +185,6 @@ int attitude_estimator_so3_main(int argc, char *argv[])
 	exit(1);
 }
 
-//---------------------------------------------------------------------------------------------------
-// Fast inverse square-root
-// See: http://en.wikipedia.org/wiki/Fast_inverse_square_root
-float invSqrt(float number) 
-{
-    volatile long i;
-    volatile float x, y;
-    volatile const float f = 1.5F;
-
-    x = number * 0.5F;
-    y = number;
-    i = * (( long * ) &y);
-    i = 0x5f375a86 - ( i >> 1 );
-    y = * (( float * ) &i);
-    y = y * ( f - ( x * y * y ) );
-    return y;
-}
-
 //! Using accelerometer, sense the gravity vector.
 //! Using magnetometer, sense yaw.
 void NonlinearSO3AHRSinit(float ax, float ay, float az, float mx, float my, float mz)
@@ -212,28 +194,21 @@ void NonlinearSO3AHRSinit(float ax, float ay, float az, float mx, float my, floa
     float magX, magY;
     float initialHdg, cosHeading, sinHeading;
 
-    initialRoll = atan2(-ay, -az);
-    initialPitch = atan2(ax, -az);
+    initialRoll = fast_atan2f(-ay, -az);
+    initialPitch = fast_atan2f(ax, -az);
 
-    cosRoll = cosf(initialRoll);
-    sinRoll = sinf(initialRoll);
-    cosPitch = cosf(initialPitch);
-    sinPitch = sinf(initialPitch);
+    fast_sincosf(initialRoll, &sinRoll, &cosRoll);
+    fast_sincosf(initialPitch, &sinPitch, &cosPitch);
 
     magX = mx * cosPitch + my * sinRoll * sinPitch + mz * cosRoll * sinPitch;
 
     magY = my * cosRoll - mz * sinRoll;
 
-    initialHdg = atan2f(-magY, magX);
+    initialHdg = fast_atan2f(-magY, magX);
 
-    cosRoll = cosf(initialRoll * 0.5f);
-    sinRoll = sinf(initialRoll * 0.5f);
-
-    cosPitch = cosf(initialPitch * 0.5f);
-    sinPitch = sinf(initialPitch * 0.5f);
-
-    cosHeading = cosf(initialHdg * 0.5f);
-    sinHeading = sinf(initialHdg * 0.5f);
+    fast_sincosf(initialRoll * 0.5f, &sinRoll, &cosRoll);
+    fast_sincosf(initialPitch * 0.5f, &sinPitch, &cosPitch);
+    fast_sincosf(initialHdg * 0.5f, &sinHeading, &cosHeading);
 
     q0 = cosRoll * cosPitch * cosHeading + sinRoll * sinPitch * sinHeading;
     q1 = sinRoll * cosPitch * cosHeading - cosRoll * sinPitch * sinHeading;
@@ -272,8 +247,7 @@ void NonlinearSO3AHRSupdate(float gx, float gy, float gz, float ax, float ay, fl
 		float halfwx, halfwy, halfwz;
 	
 		// Normalise magnetometer measurement
-		// Will sqrt work better? PX4 system is powerful enough?
-    	recipNorm = invSqrt(mx * mx + my * my + mz * mz);
+    	recipNorm = 1.0f / fast_sqrtf(mx * mx + my * my + mz * mz);
     	mx *= recipNorm;
     	my *= recipNorm;
     	mz *= recipNorm;
@@ -282,7 +256,7 @@ void NonlinearSO3AHRSupdate(float gx, float gy, float gz, float ax, float ay, fl
     	hx = 2.0f * (mx * (0.5f - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
     	hy = 2.0f * (mx * (q1q2 + q0q3) + my * (0.5f - q1q1 - q3q3) + mz * (q2q3 - q0q1));
 		hz = 2.0f * mx * (q1q3 - q0q2) + 2.0f * my * (q2q3 + q0q1) + 2.0f * mz * (0.5f - q1q1 - q2q2);
-    	bx = sqrt(hx * hx + hy * hy);
+    	bx = fast_sqrtf(hx * hx + hy * hy);
     	bz = hz;
     
     	// Estimated direction of magnetic field
@@ -301,7 +275,7 @@ void NonlinearSO3AHRSupdate(float gx, float gy, float gz, float ax, float ay, fl
 		float halfvx, halfvy, halfvz;
 	
 		// Normalise accelerometer measurement
-		recipNorm = invSqrt(ax * ax + ay * ay + az * az);
+		recipNorm = 1.0f / fast_sqrtf(ax * ax + ay * ay + az * az);
 		ax *= recipNorm;
 		ay *= recipNorm;
 		az *= recipNorm;
@@ -343,27 +317,21 @@ void NonlinearSO3AHRSupdate(float gx, float gy, float gz, float ax, float ay, fl
 	}
 	
 	//! Integrate rate of change of quaternion
-#if 0
 	gx *= (0.5f * dt);		// pre-multiply common factors
 	gy *= (0.5f * dt);
 	gz *= (0.5f * dt);
-#endif 
 
 	// Time derivative of quaternion. q_dot = 0.5*q\otimes omega.
 	//! q_k = q_{k-1} + dt*\dot{q}
 	//! \dot{q} = 0.5*q \otimes P(\omega)
-	dq0 = 0.5f*(-q1 * gx - q2 * gy - q3 * gz);
-	dq1 = 0.5f*(q0 * gx + q2 * gz - q3 * gy);
-	dq2 = 0.5f*(q0 * gy - q1 * gz + q3 * gx);
-	dq3 = 0.5f*(q0 * gz + q1 * gy - q2 * gx); 
-
-	q0 += dt*dq0;
-	q1 += dt*dq1;
-	q2 += dt*dq2;
-	q3 += dt*dq3;
-	
+	float qa = q0, qb = q1, qc = q2;
+	q0 += -qb * gx - qc * gy - q3 * gz;
+	q1 += qa * gx + qc * gz - q3 * gy;
+	q2 += qa * gy - qb * gz + q3 * gx;
+	q3 += qa * gz + qb * gy - qc * gx;
+
 	// Normalise quaternion
-	recipNorm = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+	recipNorm = 1.0f / fast_sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
 	q0 *= recipNorm;
 	q1 *= recipNorm;
 	q2 *= recipNorm;
@@ -382,6 +350,15 @@ void NonlinearSO3AHRSupdate(float gx, float gy, float gz, float ax, float ay, fl
     q3q3 = q3 * q3;   
 }
 
+/**
+ * Apply the filter and publication rate parameters.
+ */
+static void update_rates(const struct attitude_estimator_so3_params *p, int sub_raw, uint64_t *pub_interval)
+{
+	orb_set_interval(sub_raw, (p->filt_rate > 0) ? 1000 / p->filt_rate : 0);
+	*pub_interval = (p->pub_rate > 0) ? 1000000 / p->pub_rate : 0;
+}
+
 /*
  * Nonliner complementary filter on SO(3), attitude estimator main function.
  *
@@ -399,16 +376,18 @@ int attitude_estimator_so3_thread_main(int argc, char *argv[])
 	float euler[3] = {0.0f, 0.0f, 0.0f};
 	
 	/* Initialization */
-	float Rot_matrix[9] = {1.f,  0.0f,  0.0f, 0.0f,  1.f,  0.0f, 0.0f,  0.0f,  1.f };		/**< init: identity matrix */
 	float acc[3] = {0.0f, 0.0f, 0.0f};
 	float gyro[3] = {0.0f, 0.0f, 0.0f};
 	float mag[3] = {0.0f, 0.0f, 0.0f};
 
 	warnx("main thread started");
 
-	struct sensor_combined_s raw;
+	struct sensor_imu_s raw;
 	memset(&raw, 0, sizeof(raw));
 
+	struct vehicle_magnetometer_s raw_mag;
+	memset(&raw_mag, 0, sizeof(raw_mag));
+
 	//! Initialize attitude vehicle uORB message.
 	struct vehicle_attitude_s att;
 	memset(&att, 0, sizeof(att));
@@ -418,11 +397,13 @@ int attitude_estimator_so3_thread_main(int argc, char *argv[])
 
 	uint64_t last_data = 0;
 	uint64_t last_measurement = 0;
+	uint64_t last_publish = 0;
+
+	/* subscribe to raw data, rate limited by SO3_FILT_RATE */
+	int sub_raw = orb_subscribe(ORB_ID(sensor_imu));
 
-	/* subscribe to raw data */
-	int sub_raw = orb_subscribe(ORB_ID(sensor_combined));
-	/* rate-limit raw data updates to 333 Hz (sensors app publishes at 200, so this is just paranoid) */
-	orb_set_interval(sub_raw, 3);
+	/* the magnetometer comes at its own, lower rate */
+	int sub_mag = orb_subscribe(ORB_ID(vehicle_magnetometer));
 
 	/* subscribe to param changes */
 	int sub_params = orb_subscribe(ORB_ID(parameter_update));
@@ -451,6 +432,9 @@ int attitude_estimator_so3_thread_main(int argc, char *argv[])
 	parameters_init(&so3_comp_param_handles);
 	parameters_update(&so3_comp_param_handles, &so3_comp_params);
 
+	uint64_t pub_interval = 0;
+	update_rates(&so3_comp_params, sub_raw, &pub_interval);
+
 	uint64_t start_time = hrt_absolute_time();
 	bool initialized = false;
 	bool state_initialized = false;
@@ -489,13 +473,21 @@ int attitude_estimator_so3_thread_main(int argc, char *argv[])
 
 				/* update parameters */
 				parameters_update(&so3_comp_param_handles, &so3_comp_params);
+				update_rates(&so3_comp_params, sub_raw, &pub_interval);
 			}
 
 			/* only run filter if sensor values changed */
 			if (fds[0].revents & POLLIN) {
 
 				/* get latest measurements */
-				orb_copy(ORB_ID(sensor_combined), sub_raw, &raw);
+				orb_copy(ORB_ID(sensor_imu), sub_raw, &raw);
+
+				bool mag_updated;
+				orb_check(sub_mag, &mag_updated);
+
+				if (mag_updated) {
+					orb_copy(ORB_ID(vehicle_magnetometer), sub_mag, &raw_mag);
+				}
 
 				if (!initialized) {
 
@@ -539,16 +531,16 @@ int attitude_estimator_so3_thread_main(int argc, char *argv[])
 					acc[2] = raw.accelerometer_m_s2[2];
 
 					/* update magnetometer measurements */
-					if (sensor_last_timestamp[2] != raw.magnetometer_timestamp) {
-						sensor_last_timestamp[2] = raw.magnetometer_timestamp;
+					if (sensor_last_timestamp[2] != raw_mag.timestamp) {
+						sensor_last_timestamp[2] = raw_mag.timestamp;
 					}
 
-					mag[0] = raw.magnetometer_ga[0];
-					mag[1] = raw.magnetometer_ga[1];
-					mag[2] = raw.magnetometer_ga[2];
+					mag[0] = raw_mag.magnetometer_ga[0];
+					mag[1] = raw_mag.magnetometer_ga[1];
+					mag[2] = raw_mag.magnetometer_ga[2];
 
 					/* initialize with good values once we have a reasonable dt estimate */
-					if (!state_initialized && dt < 0.05f && dt > 0.001f) {
+					if (!state_initialized && dt < 0.05f && dt > 0.0002f) {
 						state_initialized = true;
 						warnx("state initialized");
 					}
@@ -567,40 +559,73 @@ int attitude_estimator_so3_thread_main(int argc, char *argv[])
 										so3_comp_params.Ki, 
 										dt);
 
-					// Convert q->R, This R converts inertial frame to body frame.
-					Rot_matrix[0] = q0q0 + q1q1 - q2q2 - q3q3;// 11
-					Rot_matrix[1] = 2.f * (q1*q2 + q0*q3);	// 12
-					Rot_matrix[2] = 2.f * (q1*q3 - q0*q2);	// 13
-					Rot_matrix[3] = 2.f * (q1*q2 - q0*q3);	// 21
-					Rot_matrix[4] = q0q0 - q1q1 + q2q2 - q3q3;// 22
-					Rot_matrix[5] = 2.f * (q2*q3 + q0*q1);	// 23
-					Rot_matrix[6] = 2.f * (q1*q3 + q0*q2);	// 31
-					Rot_matrix[7] = 2.f * (q2*q3 - q0*q1);	// 32
-					Rot_matrix[8] = q0q0 - q1q1 - q2q2 + q3q3;// 33
-
-					//1-2-3 Representation.
-					//Equation (290) 
-					//Representing Attitude: Euler Angles, Unit Quaternions, and Rotation Vectors, James Diebel.
-					// Existing PX4 EKF code was generated by MATLAB which uses coloum major order matrix.
-					euler[0] = atan2f(Rot_matrix[5], Rot_matrix[8]);	//! Roll
-					euler[1] = -asinf(Rot_matrix[2]);	//! Pitch
-					euler[2] = atan2f(Rot_matrix[1], Rot_matrix[0]);		//! Yaw
-					
-					/* swap values for next iteration, check for fatal inputs */
-					if (isfinite(euler[0]) && isfinite(euler[1]) && isfinite(euler[2])) {
-						// Publish only finite euler angles
-						att.roll = euler[0] - so3_comp_params.roll_off;
-						att.pitch = euler[1] - so3_comp_params.pitch_off;
-						att.yaw = euler[2] - so3_comp_params.yaw_off;
-					} else {
-						/* due to inputs or numerical failure the output is invalid, skip it */
-						// Due to inputs or numerical failure the output is invalid
-						warnx("infinite euler angles, rotation matrix:");
-						warnx("%.3f %.3f %.3f", (double)Rot_matrix[0], (double)Rot_matrix[1], (double)Rot_matrix[2]);
-						warnx("%.3f %.3f %.3f", (double)Rot_matrix[3], (double)Rot_matrix[4], (double)Rot_matrix[5]);
-						warnx("%.3f %.3f %.3f", (double)Rot_matrix[6], (double)Rot_matrix[7], (double)Rot_matrix[8]);
-						// Don't publish anything
-						continue;
+					/* the filter runs on every sample, the outputs are only derived for a publication */
+					if (raw.timestamp >= last_publish + pub_interval) {
+						last_publish = raw.timestamp;
+
+						// Convert q->R, This R converts inertial frame to body frame.
+						att.R[0][0] = q0q0 + q1q1 - q2q2 - q3q3;	// 11
+						att.R[0][1] = 2.f * (q1q2 + q0q3);	// 12
+						att.R[0][2] = 2.f * (q1q3 - q0q2);	// 13
+						att.R[1][0] = 2.f * (q1q2 - q0q3);	// 21
+						att.R[1][1] = q0q0 - q1q1 + q2q2 - q3q3;	// 22
+						att.R[1][2] = 2.f * (q2q3 + q0q1);	// 23
+						att.R[2][0] = 2.f * (q1q3 + q0q2);	// 31
+						att.R[2][1] = 2.f * (q2q3 - q0q1);	// 32
+						att.R[2][2] = q0q0 - q1q1 - q2q2 + q3q3;	// 33
+						att.R_valid = true;
+
+						//1-2-3 Representation.
+						//Equation (290) 
+						//Representing Attitude: Euler Angles, Unit Quaternions, and Rotation Vectors, James Diebel.
+						// Existing PX4 EKF code was generated by MATLAB which uses coloum major order matrix.
+						euler[0] = fast_atan2f(att.R[1][2], att.R[2][2]);	//! Roll
+						euler[1] = -fast_asinf(att.R[0][2]);	//! Pitch
+						euler[2] = fast_atan2f(att.R[0][1], att.R[0][0]);	//! Yaw
+
+						/* check for fatal inputs */
+						if (isfinite(euler[0]) && isfinite(euler[1]) && isfinite(euler[2])) {
+							// Publish only finite euler angles
+							att.roll = euler[0] - so3_comp_params.roll_off;
+							att.pitch = euler[1] - so3_comp_params.pitch_off;
+							att.yaw = euler[2] - so3_comp_params.yaw_off;
+
+							/* send out */
+							att.timestamp = raw.timestamp;
+
+							// Quaternion
+							att.q[0] = q0;
+							att.q[1] = q1;
+							att.q[2] = q2;
+							att.q[3] = q3;
+							att.q_valid = true;
+
+							att.rollspeed = gyro[0];
+							att.pitchspeed = gyro[1];
+							att.yawspeed = gyro[2];
+
+							att.rollacc = 0;
+							att.pitchacc = 0;
+							att.yawacc = 0;
+
+							/* TODO: Bias estimation required */
+							memcpy(&att.rate_offsets, &(gyro_bias), sizeof(att.rate_offsets));
+
+							// Publish
+							if (att_pub > 0) {
+								orb_publish(ORB_ID(vehicle_attitude), att_pub, &att);
+							} else {
+								warnx("NaN in roll/pitch/yaw estimate!");
+								 orb_advertise(ORB_ID(vehicle_attitude), &att);
+							}
+
+						} else {
+							// Due to inputs or numerical failure the output is invalid, don't publish anything
+							warnx("infinite euler angles, rotation matrix:");
+							warnx("%.3f %.3f %.3f", (double)att.R[0][0], (double)att.R[0][1], (double)att.R[0][2]);
+							warnx("%.3f %.3f %.3f", (double)att.R[1][0], (double)att.R[1][1], (double)att.R[1][2]);
+							warnx("%.3f %.3f %.3f", (double)att.R[2][0], (double)att.R[2][1], (double)att.R[2][2]);
+						}
 					}
 
 					if (last_data > 0 && raw.timestamp > last_data + 12000) {
@@ -609,45 +634,6 @@ int attitude_estimator_so3_thread_main(int argc, char *argv[])
 
 					last_data = raw.timestamp;
 
-					/* send out */
-					att.timestamp = raw.timestamp;
-					
-					// Quaternion
-					att.q[0] = q0;
-					att.q[1] = q1;
-					att.q[2] = q2;
-					att.q[3] = q3;
-					att.q_valid = true;
-
-					// Euler angle rate. But it needs to be investigated again.
-					/*
-					att.rollspeed = 2.0f*(-q1*dq0 + q0*dq1 - q3*dq2 + q2*dq3);
-					att.pitchspeed = 2.0f*(-q2*dq0 + q3*dq1 + q0*dq2 - q1*dq3);
-					att.yawspeed = 2.0f*(-q3*dq0 -q2*dq1 + q1*dq2 + q0*dq3);
-					*/
-					att.rollspeed = gyro[0];
-					att.pitchspeed = gyro[1];
-					att.yawspeed = gyro[2];
-
-					att.rollacc = 0;
-					att.pitchacc = 0;
-					att.yawacc = 0;
-
-					/* TODO: Bias estimation required */
-					memcpy(&att.rate_offsets, &(gyro_bias), sizeof(att.rate_offsets));
-
-					/* copy rotation matrix */
-					memcpy(&att.R, Rot_matrix, sizeof(float)*9);
-					att.R_valid = true;
-					
-					// Publish
-					if (att_pub > 0) {
-						orb_publish(ORB_ID(vehicle_attitude), att_pub, &att);
-					} else {
-						warnx("NaN in roll/pitch/yaw estimate!");
-						 orb_advertise(ORB_ID(vehicle_attitude), &att);
-					}
-
 					perf_end(so3_comp_loop_perf);
 				}
 			}
@@ -57,6 +57,12 @@ PARAM_DEFINE_FLOAT(SO3_ROLL_OFFS, 0.0f);
 PARAM_DEFINE_FLOAT(SO3_PITCH_OFFS, 0.0f);
 PARAM_DEFINE_FLOAT(SO3_YAW_OFFS, 0.0f);
 
+/* highest filter update rate in Hz, 0 runs the filter on every IMU sample */
+PARAM_DEFINE_INT32(SO3_FILT_RATE, 333);
+
+/* attitude publication rate in Hz, 0 publishes every filter update */
+PARAM_DEFINE_INT32(SO3_PUB_RATE, 0);
+
 int parameters_init(struct attitude_estimator_so3_param_handles *h)
 {
 	/* Filter gain parameters */
@@ -68,6 +74,9 @@ int parameters_init(struct attitude_estimator_so3_param_handles *h)
 	h->pitch_off =	param_find("SO3_PITCH_OFFS");
 	h->yaw_off   =	param_find("SO3_YAW_OFFS");
 
+	h->filt_rate =	param_find("SO3_FILT_RATE");
+	h->pub_rate  =	param_find("SO3_PUB_RATE");
+
 	return OK;
 }
 
@@ -82,5 +91,9 @@ int parameters_update(const struct attitude_estimator_so3_param_handles *h, stru
 	param_get(h->pitch_off, &(p->pitch_off));
 	param_get(h->yaw_off, &(p->yaw_off));
 
+	/* Update loop rates */
+	param_get(h->filt_rate, &(p->filt_rate));
+	param_get(h->pub_rate, &(p->pub_rate));
+
 	return OK;
 }
@@ -47,11 +47,14 @@ struct attitude_estimator_so3_params {
 	float roll_off;
 	float pitch_off;
 	float yaw_off;
+	int32_t filt_rate;
+	int32_t pub_rate;
 };
 
 struct attitude_estimator_so3_param_handles {
 	param_t Kp, Ki;
 	param_t roll_off, pitch_off, yaw_off;
+	param_t filt_rate, pub_rate;
 };
 
 /**
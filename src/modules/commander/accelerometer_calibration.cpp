@@ -123,6 +123,7 @@
 #include "accelerometer_calibration.h"
 #include "calibration_messages.h"
 #include "commander_helper.h"
+#include "calibration_routines.h"
 
 #include <unistd.h>
 #include <stdio.h>
@@ -150,16 +151,14 @@ static const int ERROR = -1;
 
 static const char *sensor_name = "accel";
 
-int do_accel_calibration_measurements(int mavlink_fd, float accel_offs[3], float accel_T[3][3]);
+int do_accel_calibration_measurements(int mavlink_fd, float accel_offs[][3], float accel_T[][3][3], unsigned num_accels);
 int detect_orientation(int mavlink_fd, int sub_sensor_combined);
-int read_accelerometer_avg(int sensor_combined_sub, float accel_avg[3], int samples_num);
+int read_accelerometer_avg(int sensor_combined_sub, float accel_avg[][3], int samples_num, unsigned num_accels);
 int mat_invert3(float src[3][3], float dst[3][3]);
 int calculate_calibration_values(float accel_ref[6][3], float accel_T[3][3], float accel_offs[3], float g);
 
 int do_accel_calibration(int mavlink_fd)
 {
-	int fd;
-
 	mavlink_log_info(mavlink_fd, CAL_STARTED_MSG, sensor_name);
 
 	mavlink_log_info(mavlink_fd, "You need to put the system on all six sides");
@@ -167,32 +166,53 @@ int do_accel_calibration(int mavlink_fd)
 	mavlink_log_info(mavlink_fd, "Follow the instructions on the screen");
 	sleep(5);
 
-	struct accel_scale accel_scale = {
-		0.0f,
-		1.0f,
-		0.0f,
-		1.0f,
-		0.0f,
-		1.0f,
-	};
+	/* all accels are measured on the same six sides */
+	struct accel_scale accel_scale[CALIBRATION_MAX_INSTANCES];
+	unsigned num_accels = 0;
 
 	int res = OK;
 
-	/* reset all offsets to zero and all scales to one */
-	fd = open(ACCEL_DEVICE_PATH, 0);
-	res = ioctl(fd, ACCELIOCSSCALE, (long unsigned int)&accel_scale);
-	close(fd);
+	/* reset all offsets to zero and all scales to one, class instances are numbered without gaps */
+	for (unsigned s = 0; s < CALIBRATION_MAX_INSTANCES; s++) {
+		char path[16];
+		calibration_device_path(path, sizeof(path), ACCEL_DEVICE_PATH, s);
+
+		accel_scale[s].x_offset = 0.0f;
+		accel_scale[s].x_scale = 1.0f;
+		accel_scale[s].y_offset = 0.0f;
+		accel_scale[s].y_scale = 1.0f;
+		accel_scale[s].z_offset = 0.0f;
+		accel_scale[s].z_scale = 1.0f;
+
+		int fd = open(path, 0);
+
+		if (fd < 0) {
+			break;
+		}
+
+		num_accels++;
+
+		if (ioctl(fd, ACCELIOCSSCALE, (long unsigned int)&accel_scale[s]) != OK) {
+			res = ERROR;
+		}
+
+		close(fd);
+	}
+
+	if (num_accels == 0) {
+		res = ERROR;
+	}
 
 	if (res != OK) {
 		mavlink_log_critical(mavlink_fd, CAL_FAILED_RESET_CAL_MSG);
 	}
 
-	float accel_offs[3];
-	float accel_T[3][3];
+	float accel_offs[CALIBRATION_MAX_INSTANCES][3];
+	float accel_T[CALIBRATION_MAX_INSTANCES][3][3];
 
 	if (res == OK) {
 		/* measure and calculate offsets & scales */
-		res = do_accel_calibration_measurements(mavlink_fd, accel_offs, accel_T);
+		res = do_accel_calibration_measurements(mavlink_fd, accel_offs, accel_T, num_accels);
 	}
 
 	if (res == OK) {
@@ -204,34 +224,39 @@ int do_accel_calibration(int mavlink_fd)
 		math::Matrix<3, 3> board_rotation;
 		get_rot_matrix(board_rotation_id, &board_rotation);
 		math::Matrix<3, 3> board_rotation_t = board_rotation.transposed();
-		math::Vector<3> accel_offs_vec(&accel_offs[0]);
-		math::Vector<3> accel_offs_rotated = board_rotation_t *accel_offs_vec;
-		math::Matrix<3, 3> accel_T_mat(&accel_T[0][0]);
-		math::Matrix<3, 3> accel_T_rotated = board_rotation_t *accel_T_mat * board_rotation;
-
-		accel_scale.x_offset = accel_offs_rotated(0);
-		accel_scale.x_scale = accel_T_rotated(0, 0);
-		accel_scale.y_offset = accel_offs_rotated(1);
-		accel_scale.y_scale = accel_T_rotated(1, 1);
-		accel_scale.z_offset = accel_offs_rotated(2);
-		accel_scale.z_scale = accel_T_rotated(2, 2);
-
-		/* set parameters */
-		if (param_set(param_find("SENS_ACC_XOFF"), &(accel_scale.x_offset))
-		    || param_set(param_find("SENS_ACC_YOFF"), &(accel_scale.y_offset))
-		    || param_set(param_find("SENS_ACC_ZOFF"), &(accel_scale.z_offset))
-		    || param_set(param_find("SENS_ACC_XSCALE"), &(accel_scale.x_scale))
-		    || param_set(param_find("SENS_ACC_YSCALE"), &(accel_scale.y_scale))
-		    || param_set(param_find("SENS_ACC_ZSCALE"), &(accel_scale.z_scale))) {
-			mavlink_log_critical(mavlink_fd, CAL_FAILED_SET_PARAMS_MSG);
-			res = ERROR;
+
+		for (unsigned s = 0; s < num_accels; s++) {
+			math::Vector<3> accel_offs_vec(&accel_offs[s][0]);
+			math::Vector<3> accel_offs_rotated = board_rotation_t *accel_offs_vec;
+			math::Matrix<3, 3> accel_T_mat(&accel_T[s][0][0]);
+			math::Matrix<3, 3> accel_T_rotated = board_rotation_t *accel_T_mat * board_rotation;
+
+			accel_scale[s].x_offset = accel_offs_rotated(0);
+			accel_scale[s].x_scale = accel_T_rotated(0, 0);
+			accel_scale[s].y_offset = accel_offs_rotated(1);
+			accel_scale[s].y_scale = accel_T_rotated(1, 1);
+			accel_scale[s].z_offset = accel_offs_rotated(2);
+			accel_scale[s].z_scale = accel_T_rotated(2, 2);
+
+			/* set parameters */
+			float offset[3] = { accel_scale[s].x_offset, accel_scale[s].y_offset, accel_scale[s].z_offset };
+			float scale[3] = { accel_scale[s].x_scale, accel_scale[s].y_scale, accel_scale[s].z_scale };
+
+			if (calibration_set_params("ACC", s, offset, scale) != OK) {
+				mavlink_log_critical(mavlink_fd, CAL_FAILED_SET_PARAMS_MSG);
+				res = ERROR;
+				break;
+			}
 		}
 	}
 
-	if (res == OK) {
+	for (unsigned s = 0; s < num_accels && res == OK; s++) {
 		/* apply new scaling and offsets */
-		fd = open(ACCEL_DEVICE_PATH, 0);
-		res = ioctl(fd, ACCELIOCSSCALE, (long unsigned int)&accel_scale);
+		char path[16];
+		calibration_device_path(path, sizeof(path), ACCEL_DEVICE_PATH, s);
+
+		int fd = open(path, 0);
+		res = ioctl(fd, ACCELIOCSSCALE, (long unsigned int)&accel_scale[s]);
 		close(fd);
 
 		if (res != OK) {
@@ -258,10 +283,12 @@ int do_accel_calibration(int mavlink_fd)
 	return res;
 }
 
-int do_accel_calibration_measurements(int mavlink_fd, float accel_offs[3], float accel_T[3][3])
+int do_accel_calibration_measurements(int mavlink_fd, float accel_offs[][3], float accel_T[][3][3], unsigned num_accels)
 {
 	const int samples_num = 2500;
-	float accel_ref[6][3];
+	/* the primary accel detects the orientation, the side is measured on all of them */
+	float accel_ref[CALIBRATION_MAX_INSTANCES][6][3];
+	float accel_avg[CALIBRATION_MAX_INSTANCES][3];
 	bool data_collected[6] = { false, false, false, false, false, false };
 	const char *orientation_strs[6] = { "front", "back", "left", "right", "top", "bottom" };
 
@@ -321,11 +348,20 @@ int do_accel_calibration_measurements(int mavlink_fd, float accel_offs[3], float
 
 		mavlink_log_info(mavlink_fd, "Hold still, starting to measure %s side", orientation_strs[orient]);
 		sleep(1);
-		read_accelerometer_avg(sensor_combined_sub, &(accel_ref[orient][0]), samples_num);
+
+		if (read_accelerometer_avg(sensor_combined_sub, accel_avg, samples_num, num_accels) != OK) {
+			mavlink_log_info(mavlink_fd, "sensor error, hold still...");
+			continue;
+		}
+
+		for (unsigned s = 0; s < num_accels; s++) {
+			memcpy(accel_ref[s][orient], accel_avg[s], sizeof(accel_avg[s]));
+		}
+
 		mavlink_log_info(mavlink_fd, "result for %s side: [ %.2f %.2f %.2f ]", orientation_strs[orient],
-				 (double)accel_ref[orient][0],
-				 (double)accel_ref[orient][1],
-				 (double)accel_ref[orient][2]);
+				 (double)accel_ref[0][orient][0],
+				 (double)accel_ref[0][orient][1],
+				 (double)accel_ref[0][orient][2]);
 
 		data_collected[orient] = true;
 		tune_neutral(true);
@@ -333,9 +369,9 @@ int do_accel_calibration_measurements(int mavlink_fd, float accel_offs[3], float
 
 	close(sensor_combined_sub);
 
-	if (res == OK) {
+	for (unsigned s = 0; s < num_accels && res == OK; s++) {
 		/* calculate offsets and transform matrix */
-		res = calculate_calibration_values(accel_ref, accel_T, accel_offs, CONSTANTS_ONE_G);
+		res = calculate_calibration_values(accel_ref[s], accel_T[s], accel_offs[s], CONSTANTS_ONE_G);
 
 		if (res != OK) {
 			mavlink_log_info(mavlink_fd, "ERROR: calibration values calculation error");
@@ -492,30 +528,48 @@ int detect_orientation(int mavlink_fd, int sub_sensor_combined)
 }
 
 /*
- * Read specified number of accelerometer samples, calculate average and dispersion.
+ * Read specified number of samples of the primary accelerometer and average all accelerometers over that time.
  */
-int read_accelerometer_avg(int sensor_combined_sub, float accel_avg[3], int samples_num)
+int read_accelerometer_avg(int sensor_combined_sub, float accel_avg[][3], int samples_num, unsigned num_accels)
 {
 	struct pollfd fds[1];
 	fds[0].fd = sensor_combined_sub;
 	fds[0].events = POLLIN;
-	int count = 0;
-	float accel_sum[3] = { 0.0f, 0.0f, 0.0f };
+	int count[CALIBRATION_MAX_INSTANCES] = { 0 };
+	uint64_t timestamp[CALIBRATION_MAX_INSTANCES] = { 0 };
+	float accel_sum[CALIBRATION_MAX_INSTANCES][3];
+	memset(accel_sum, 0, sizeof(accel_sum));
 
 	int errcount = 0;
 
-	while (count < samples_num) {
+	while (count[0] < samples_num) {
 		int poll_ret = poll(fds, 1, 1000);
 
 		if (poll_ret == 1) {
 			struct sensor_combined_s sensor;
 			orb_copy(ORB_ID(sensor_combined), sensor_combined_sub, &sensor);
 
-			for (int i = 0; i < 3; i++) {
-				accel_sum[i] += sensor.accelerometer_m_s2[i];
-			}
+			/* the secondary accels are only sampled when they have new data */
+			const float *values[CALIBRATION_MAX_INSTANCES] = {
+				sensor.accelerometer_m_s2, sensor.accelerometer1_m_s2, sensor.accelerometer2_m_s2
+			};
+			const uint64_t timestamps[CALIBRATION_MAX_INSTANCES] = {
+				sensor.accelerometer_timestamp, sensor.accelerometer1_timestamp, sensor.accelerometer2_timestamp
+			};
+
+			for (unsigned s = 0; s < num_accels; s++) {
+				if (s > 0 && timestamps[s] == timestamp[s]) {
+					continue;
+				}
 
-			count++;
+				timestamp[s] = timestamps[s];
+
+				for (int i = 0; i < 3; i++) {
+					accel_sum[s][i] += values[s][i];
+				}
+
+				count[s]++;
+			}
 
 		} else {
 			errcount++;
@@ -527,8 +581,14 @@ int read_accelerometer_avg(int sensor_combined_sub, float accel_avg[3], int samp
 		}
 	}
 
-	for (int i = 0; i < 3; i++) {
-		accel_avg[i] = accel_sum[i] / count;
+	for (unsigned s = 0; s < num_accels; s++) {
+		if (count[s] == 0) {
+			return ERROR;
+		}
+
+		for (int i = 0; i < 3; i++) {
+			accel_avg[s][i] = accel_sum[s][i] / count[s];
+		}
 	}
 
 	return OK;
@@ -40,69 +40,118 @@
 
 #include <math.h>
 #include <float.h>
+#include <string.h>
+#include <stdio.h>
+#include <systemlib/param/param.h>
 
 #include "calibration_routines.h"
 
+void calibration_device_path(char *path, size_t len, const char *class_devname, unsigned instance)
+{
+	if (instance == 0) {
+		snprintf(path, len, "%s", class_devname);
 
-int sphere_fit_least_squares(const float x[], const float y[], const float z[],
-			     unsigned int size, unsigned int max_iterations, float delta, float *sphere_x, float *sphere_y, float *sphere_z, float *sphere_radius)
+	} else {
+		snprintf(path, len, "%s%u", class_devname, instance);
+	}
+}
+
+int calibration_set_params(const char *sensor, unsigned instance, const float offset[3], const float scale[3])
 {
+	static const char axes[3] = { 'X', 'Y', 'Z' };
+	int res = 0;
 
-	float x_sumplain = 0.0f;
-	float x_sumsq = 0.0f;
-	float x_sumcube = 0.0f;
+	for (unsigned i = 0; i < 3; i++) {
+		/* param names are at most 16 characters */
+		char name[17];
 
-	float y_sumplain = 0.0f;
-	float y_sumsq = 0.0f;
-	float y_sumcube = 0.0f;
+		if (instance == 0) {
+			snprintf(name, sizeof(name), "SENS_%s_%cOFF", sensor, axes[i]);
 
-	float z_sumplain = 0.0f;
-	float z_sumsq = 0.0f;
-	float z_sumcube = 0.0f;
+		} else {
+			snprintf(name, sizeof(name), "CAL_%s%u_%cOFF", sensor, instance, axes[i]);
+		}
 
-	float xy_sum = 0.0f;
-	float xz_sum = 0.0f;
-	float yz_sum = 0.0f;
+		if (param_set(param_find(name), &offset[i])) {
+			res = -1;
+		}
 
-	float x2y_sum = 0.0f;
-	float x2z_sum = 0.0f;
-	float y2x_sum = 0.0f;
-	float y2z_sum = 0.0f;
-	float z2x_sum = 0.0f;
-	float z2y_sum = 0.0f;
+		if (instance == 0) {
+			snprintf(name, sizeof(name), "SENS_%s_%cSCALE", sensor, axes[i]);
 
-	for (unsigned int i = 0; i < size; i++) {
+		} else {
+			snprintf(name, sizeof(name), "CAL_%s%u_%cSCALE", sensor, instance, axes[i]);
+		}
 
-		float x2 = x[i] * x[i];
-		float y2 = y[i] * y[i];
-		float z2 = z[i] * z[i];
+		if (param_set(param_find(name), &scale[i])) {
+			res = -1;
+		}
+	}
+
+	return res;
+}
+
+void sphere_fit_reset(struct sphere_fit_sums *sums)
+{
+	memset(sums, 0, sizeof(*sums));
+}
+
+void sphere_fit_add(struct sphere_fit_sums *sums, float x, float y, float z)
+{
+	float x2 = x * x;
+	float y2 = y * y;
+	float z2 = z * z;
 
-		x_sumplain += x[i];
-		x_sumsq += x2;
-		x_sumcube += x2 * x[i];
+	sums->x_sumplain += x;
+	sums->x_sumsq += x2;
+	sums->x_sumcube += x2 * x;
 
-		y_sumplain += y[i];
-		y_sumsq += y2;
-		y_sumcube += y2 * y[i];
+	sums->y_sumplain += y;
+	sums->y_sumsq += y2;
+	sums->y_sumcube += y2 * y;
 
-		z_sumplain += z[i];
-		z_sumsq += z2;
-		z_sumcube += z2 * z[i];
+	sums->z_sumplain += z;
+	sums->z_sumsq += z2;
+	sums->z_sumcube += z2 * z;
 
-		xy_sum += x[i] * y[i];
-		xz_sum += x[i] * z[i];
-		yz_sum += y[i] * z[i];
+	sums->xy_sum += x * y;
+	sums->xz_sum += x * z;
+	sums->yz_sum += y * z;
 
-		x2y_sum += x2 * y[i];
-		x2z_sum += x2 * z[i];
+	sums->x2y_sum += x2 * y;
+	sums->x2z_sum += x2 * z;
 
-		y2x_sum += y2 * x[i];
-		y2z_sum += y2 * z[i];
+	sums->y2x_sum += y2 * x;
+	sums->y2z_sum += y2 * z;
 
-		z2x_sum += z2 * x[i];
-		z2y_sum += z2 * y[i];
+	sums->z2x_sum += z2 * x;
+	sums->z2y_sum += z2 * y;
+
+	sums->size++;
+}
+
+int sphere_fit_least_squares(const float x[], const float y[], const float z[],
+			     unsigned int size, unsigned int max_iterations, float delta, float *sphere_x, float *sphere_y, float *sphere_z, float *sphere_radius)
+{
+	struct sphere_fit_sums sums;
+	sphere_fit_reset(&sums);
+
+	for (unsigned int i = 0; i < size; i++) {
+		sphere_fit_add(&sums, x[i], y[i], z[i]);
 	}
 
+	return sphere_fit_solve(&sums, max_iterations, delta, sphere_x, sphere_y, sphere_z, sphere_radius);
+}
+
+int sphere_fit_solve(const struct sphere_fit_sums *sums, unsigned int max_iterations, float delta,
+		     float *sphere_x, float *sphere_y, float *sphere_z, float *sphere_radius)
+{
+	if (sums->size == 0) {
+		return 1;
+	}
+
+	const unsigned int size = sums->size;
+
 	//
 	//Least Squares Fit a sphere A,B,C with radius squared Rsq to 3D data
 	//
@@ -121,25 +170,25 @@ int sphere_fit_least_squares(const float x[], const float y[], const float z[],
 	//
 	//This method should converge; maybe 5-100 iterations or more.
 	//
-	float x_sum = x_sumplain / size;        //sum( X[n] )
-	float x_sum2 = x_sumsq / size;    //sum( X[n]^2 )
-	float x_sum3 = x_sumcube / size;    //sum( X[n]^3 )
-	float y_sum = y_sumplain / size;        //sum( Y[n] )
-	float y_sum2 = y_sumsq / size;    //sum( Y[n]^2 )
-	float y_sum3 = y_sumcube / size;    //sum( Y[n]^3 )
-	float z_sum = z_sumplain / size;        //sum( Z[n] )
-	float z_sum2 = z_sumsq / size;    //sum( Z[n]^2 )
-	float z_sum3 = z_sumcube / size;    //sum( Z[n]^3 )
-
-	float XY = xy_sum / size;        //sum( X[n] * Y[n] )
-	float XZ = xz_sum / size;        //sum( X[n] * Z[n] )
-	float YZ = yz_sum / size;        //sum( Y[n] * Z[n] )
-	float X2Y = x2y_sum / size;    //sum( X[n]^2 * Y[n] )
-	float X2Z = x2z_sum / size;    //sum( X[n]^2 * Z[n] )
-	float Y2X = y2x_sum / size;    //sum( Y[n]^2 * X[n] )
-	float Y2Z = y2z_sum / size;    //sum( Y[n]^2 * Z[n] )
-	float Z2X = z2x_sum / size;    //sum( Z[n]^2 * X[n] )
-	float Z2Y = z2y_sum / size;    //sum( Z[n]^2 * Y[n] )
+	float x_sum = sums->x_sumplain / size;        //sum( X[n] )
+	float x_sum2 = sums->x_sumsq / size;    //sum( X[n]^2 )
+	float x_sum3 = sums->x_sumcube / size;    //sum( X[n]^3 )
+	float y_sum = sums->y_sumplain / size;        //sum( Y[n] )
+	float y_sum2 = sums->y_sumsq / size;    //sum( Y[n]^2 )
+	float y_sum3 = sums->y_sumcube / size;    //sum( Y[n]^3 )
+	float z_sum = sums->z_sumplain / size;        //sum( Z[n] )
+	float z_sum2 = sums->z_sumsq / size;    //sum( Z[n]^2 )
+	float z_sum3 = sums->z_sumcube / size;    //sum( Z[n]^3 )
+
+	float XY = sums->xy_sum / size;        //sum( X[n] * Y[n] )
+	float XZ = sums->xz_sum / size;        //sum( X[n] * Z[n] )
+	float YZ = sums->yz_sum / size;        //sum( Y[n] * Z[n] )
+	float X2Y = sums->x2y_sum / size;    //sum( X[n]^2 * Y[n] )
+	float X2Z = sums->x2z_sum / size;    //sum( X[n]^2 * Z[n] )
+	float Y2X = sums->y2x_sum / size;    //sum( Y[n]^2 * X[n] )
+	float Y2Z = sums->y2z_sum / size;    //sum( Y[n]^2 * Z[n] )
+	float Z2X = sums->z2x_sum / size;    //sum( Z[n]^2 * X[n] )
+	float Z2Y = sums->z2y_sum / size;    //sum( Z[n]^2 * Y[n] )
 
 	//Reduction of multiplications
 	float F0 = x_sum2 + y_sum2 + z_sum2;
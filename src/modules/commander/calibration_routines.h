@@ -38,6 +38,73 @@
  * @author Lorenz Meier <lm@inf.ethz.ch>
  */
 
+#include <stddef.h>
+
+/**
+ * Most instances of one sensor class calibrated in one pass.
+ */
+#define CALIBRATION_MAX_INSTANCES	3
+
+/**
+ * Device path of a sensor instance, as CDev::register_class_devname() names it.
+ *
+ * @param path buffer for the path
+ * @param len size of the buffer
+ * @param class_devname class device path, e.g. ACCEL_DEVICE_PATH
+ * @param instance class instance, 0 for the first sensor
+ */
+void calibration_device_path(char *path, size_t len, const char *class_devname, unsigned instance);
+
+/**
+ * Set the calibration parameters of a sensor instance.
+ *
+ * The first instance keeps the SENS_<sensor>_ names, the others are
+ * stored in CAL_<sensor><instance>_.
+ *
+ * @param sensor parameter name of the sensor class, "ACC", "GYRO" or "MAG"
+ * @param instance class instance
+ * @param offset x, y and z offsets
+ * @param scale x, y and z scales
+ *
+ * @return 0 on success, -1 if a parameter could not be set
+ */
+int calibration_set_params(const char *sensor, unsigned instance, const float offset[3], const float scale[3]);
+
+/**
+ * Running sums of a sphere fit, all the fit needs from the points.
+ *
+ * Points can be added one at a time as they come in, with fixed memory,
+ * and the fit solved from the sums at any point.
+ */
+struct sphere_fit_sums {
+	unsigned int size;
+	float x_sumplain, x_sumsq, x_sumcube;
+	float y_sumplain, y_sumsq, y_sumcube;
+	float z_sumplain, z_sumsq, z_sumcube;
+	float xy_sum, xz_sum, yz_sum;
+	float x2y_sum, x2z_sum;
+	float y2x_sum, y2z_sum;
+	float z2x_sum, z2y_sum;
+};
+
+void sphere_fit_reset(struct sphere_fit_sums *sums);
+
+/**
+ * Add a point on the sphere surface.
+ */
+void sphere_fit_add(struct sphere_fit_sums *sums, float x, float y, float z);
+
+/**
+ * Least-squares fit of a sphere to the points added so far.
+ *
+ * Takes the same parameters as sphere_fit_least_squares() and gives the
+ * same result for the same points.
+ *
+ * @return 0 on success, 1 if there are no points
+ */
+int sphere_fit_solve(const struct sphere_fit_sums *sums, unsigned int max_iterations, float delta,
+		     float *sphere_x, float *sphere_y, float *sphere_z, float *sphere_radius);
+
 /**
  * Least-squares fit of a sphere to a set of points.
  *
@@ -82,6 +82,8 @@
 #include <uORB/topics/mission.h>
 #include <uORB/topics/mission_result.h>
 #include <uORB/topics/telemetry_status.h>
+#include <uORB/topics/system_memory.h>
+#include <uORB/topics/deadline_status.h>
 
 #include <drivers/drv_led.h>
 #include <drivers/drv_hrt.h>
@@ -92,6 +94,7 @@
 #include <systemlib/systemlib.h>
 #include <systemlib/err.h>
 #include <systemlib/cpuload.h>
+#include <systemlib/deadline.h>
 #include <systemlib/rc_check.h>
 #include <geo/geo.h>
 #include <systemlib/state_table.h>
@@ -117,7 +120,7 @@ static const int ERROR = -1;
 extern struct system_load_s system_load;
 
 /* Decouple update interval and hysteris counters, all depends on intervals */
-#define COMMANDER_MONITORING_INTERVAL 50000
+#define COMMANDER_MONITORING_INTERVAL 50000	/**< monitoring period, mode switches and commands are handled on arrival */
 #define COMMANDER_MONITORING_LOOPSPERMSEC (1/(COMMANDER_MONITORING_INTERVAL/1000.0f))
 
 #define MAVLINK_OPEN_INTERVAL 50000
@@ -171,6 +174,8 @@ static struct actuator_armed_s armed;
 static struct safety_s safety;
 static struct vehicle_control_mode_s control_mode;
 static struct offboard_control_setpoint_s sp_offboard;
+static struct system_memory_s system_memory;
+static struct deadline_status_s deadline_report;
 
 /* tasks waiting for low prio thread */
 typedef enum {
@@ -305,6 +310,8 @@ int commander_main(int argc, char *argv[])
 
 	if (!strcmp(argv[1], "check")) {
 		int mavlink_fd_local = open(MAVLINK_LOG_DEVICE, 0);
+		/* an explicit check does not rely on the cached results */
+		prearm_check_invalidate();
 		int checkres = prearm_check(&status, mavlink_fd_local);
 		close(mavlink_fd_local);
 		warnx("FINAL RESULT: %s", (checkres == 0) ? "OK" : "FAILED");
@@ -842,6 +849,12 @@ int commander_thread_main(int argc, char *argv[])
 
 	/* home position */
 	orb_advert_t home_pub = -1;
+
+	/* memory use, published with the system load */
+	orb_advert_t system_memory_pub = -1;
+
+	/* deadline monitors of the periodic tasks, published with the system load */
+	orb_advert_t deadline_status_pub = -1;
 	struct home_position_s home;
 	memset(&home, 0, sizeof(home));
 
@@ -1034,6 +1047,16 @@ int commander_thread_main(int argc, char *argv[])
 	bool arming_state_changed = false;
 	bool main_state_changed = false;
 	bool failsafe_old = false;
+	bool nav_state_event = false;
+
+	/* mode switches and commands wake the commander up between the monitoring ticks */
+	struct pollfd event_fds[2];
+	event_fds[0].fd = cmd_sub;
+	event_fds[0].events = POLLIN;
+	event_fds[1].fd = sp_man_sub;
+	event_fds[1].events = POLLIN;
+
+	hrt_abstime next_monitoring = hrt_absolute_time();
 
 	while (!thread_should_exit) {
 
@@ -1406,6 +1429,29 @@ int commander_thread_main(int argc, char *argv[])
 
 			last_idle_time = system_load.tasks[0].total_runtime;
 
+			/* sample heap and stack use */
+			cpuload_memory(&system_memory);
+			system_memory.timestamp = hrt_absolute_time();
+
+			if (system_memory_pub > 0) {
+				orb_publish(ORB_ID(system_memory), system_memory_pub, &system_memory);
+
+			} else {
+				system_memory_pub = orb_advertise(ORB_ID(system_memory), &system_memory);
+			}
+
+			deadline_status(&deadline_report);
+			deadline_report.timestamp = hrt_absolute_time();
+
+			if (deadline_report.count > 0) {
+				if (deadline_status_pub > 0) {
+					orb_publish(ORB_ID(deadline_status), deadline_status_pub, &deadline_report);
+
+				} else {
+					deadline_status_pub = orb_advertise(ORB_ID(deadline_status), &deadline_report);
+				}
+			}
+
 			/* check if board is connected via USB */
 			struct stat statbuf;
 			on_usb_power = (stat("/dev/ttyACM0", &statbuf) == 0);
@@ -1730,13 +1776,9 @@ int commander_thread_main(int argc, char *argv[])
 
 
 		/* handle commands last, as the system needs to be updated to handle them */
-		orb_check(cmd_sub, &updated);
-
-		if (updated) {
-			/* got command */
-			orb_copy(ORB_ID(vehicle_command), cmd_sub, &cmd);
-
-			/* handle it */
+		/* the topic is queued, handle every command of a burst in order */
+		while (orb_check(cmd_sub, &updated) == OK && updated &&
+		       orb_copy_queued(ORB_ID(vehicle_command), cmd_sub, &cmd, nullptr) == OK) {
 			if (handle_command(&status, &safety, &cmd, &armed, &home, &global_position, &home_pub)) {
 				status_changed = true;
 			}
@@ -1838,6 +1880,12 @@ int commander_thread_main(int argc, char *argv[])
 						       mission_result.finished,
 						       mission_result.stay_in_failsafe);
 
+		if (nav_state_event) {
+			/* changed between the ticks and already published */
+			nav_state_changed = true;
+			nav_state_event = false;
+		}
+
 		// TODO handle mode changes by commands
 		if (main_state_changed) {
 			status_changed = true;
@@ -1914,7 +1962,79 @@ int commander_thread_main(int argc, char *argv[])
 
 		status_changed = false;
 
-		usleep(COMMANDER_MONITORING_INTERVAL);
+		next_monitoring += COMMANDER_MONITORING_INTERVAL;
+
+		if (next_monitoring < hrt_absolute_time()) {
+			/* don't try to catch up with missed ticks */
+			next_monitoring = hrt_absolute_time() + COMMANDER_MONITORING_INTERVAL;
+		}
+
+		/* until the next tick only handle the events which change the mode or arming state */
+		while (!thread_should_exit) {
+			hrt_abstime now = hrt_absolute_time();
+
+			if (now >= next_monitoring) {
+				break;
+			}
+
+			int event_ret = poll(event_fds, 2, (next_monitoring - now + 999) / 1000);
+
+			if (event_ret <= 0) {
+				continue;
+			}
+
+			bool event_changed = false;
+
+			if (event_fds[0].revents & POLLIN) {
+				bool cmd_updated;
+
+				while (orb_check(cmd_sub, &cmd_updated) == OK && cmd_updated &&
+				       orb_copy_queued(ORB_ID(vehicle_command), cmd_sub, &cmd, nullptr) == OK) {
+					if (handle_command(&status, &safety, &cmd, &armed, &home, &global_position, &home_pub)) {
+						event_changed = true;
+					}
+				}
+			}
+
+			if (event_fds[1].revents & POLLIN) {
+				orb_copy(ORB_ID(manual_control_setpoint), sp_man_sub, &sp_man);
+
+				/* the RC state itself is checked by the monitoring */
+				if (status.rc_signal_found_once && !status.rc_signal_lost && !status.rc_input_blocked) {
+					transition_result_t main_res = set_main_state_rc(&status, &sp_man);
+
+					if (main_res == TRANSITION_CHANGED) {
+						tune_positive(armed.armed);
+						/* announced on the next tick */
+						main_state_changed = true;
+						event_changed = true;
+					}
+				}
+			}
+
+			if (!event_changed) {
+				continue;
+			}
+
+			/* publish the new state right away instead of on the next tick */
+			if (set_nav_state(&status, (bool)datalink_loss_enabled, mission_result.finished, mission_result.stay_in_failsafe)) {
+				nav_state_event = true;
+			}
+
+			set_control_mode();
+
+			hrt_abstime t_event = hrt_absolute_time();
+			control_mode.timestamp = t_event;
+			orb_publish(ORB_ID(vehicle_control_mode), control_mode_pub, &control_mode);
+
+			status.timestamp = t_event;
+			orb_publish(ORB_ID(vehicle_status), status_pub, &status);
+
+			armed.timestamp = t_event;
+			orb_publish(ORB_ID(actuator_armed), armed_pub, &armed);
+
+			status_changed = true;
+		}
 	}
 
 	/* wait for threads to complete */
@@ -2441,8 +2561,13 @@ void *commander_low_prio_loop(void *arg)
 			continue;
 		}
 
-		/* if we reach here, we have a valid command */
-		orb_copy(ORB_ID(vehicle_command), cmd_sub, &cmd);
+		/*
+		 * If we reach here, we have a valid command. Take the oldest one of
+		 * the queue; poll returns right away again while more are queued.
+		 */
+		if (orb_copy_queued(ORB_ID(vehicle_command), cmd_sub, &cmd, nullptr) != OK) {
+			continue;
+		}
 
 		/* ignore commands the high-prio loop handles */
 		if (cmd.command == VEHICLE_CMD_DO_SET_MODE ||
@@ -40,6 +40,7 @@
 #include "gyro_calibration.h"
 #include "calibration_messages.h"
 #include "commander_helper.h"
+#include "calibration_routines.h"
 
 #include <stdio.h>
 #include <fcntl.h>
@@ -68,21 +69,42 @@ int do_gyro_calibration(int mavlink_fd)
 	/* wait for the user to respond */
 	sleep(2);
 
-	struct gyro_scale gyro_scale = {
-		0.0f,
-		1.0f,
-		0.0f,
-		1.0f,
-		0.0f,
-		1.0f,
-	};
+	/* all gyros are averaged from the same still period */
+	struct gyro_scale gyro_scale[CALIBRATION_MAX_INSTANCES];
+	unsigned num_present = 0;
 
 	int res = OK;
 
-	/* reset all offsets to zero and all scales to one */
-	int fd = open(GYRO_DEVICE_PATH, 0);
-	res = ioctl(fd, GYROIOCSSCALE, (long unsigned int)&gyro_scale);
-	close(fd);
+	/* reset all offsets to zero and all scales to one, class instances are numbered without gaps */
+	for (unsigned s = 0; s < CALIBRATION_MAX_INSTANCES; s++) {
+		char path[16];
+		calibration_device_path(path, sizeof(path), GYRO_DEVICE_PATH, s);
+
+		gyro_scale[s].x_offset = 0.0f;
+		gyro_scale[s].x_scale = 1.0f;
+		gyro_scale[s].y_offset = 0.0f;
+		gyro_scale[s].y_scale = 1.0f;
+		gyro_scale[s].z_offset = 0.0f;
+		gyro_scale[s].z_scale = 1.0f;
+
+		int fd = open(path, 0);
+
+		if (fd < 0) {
+			break;
+		}
+
+		num_present++;
+
+		if (ioctl(fd, GYROIOCSSCALE, (long unsigned int)&gyro_scale[s]) != OK) {
+			res = ERROR;
+		}
+
+		close(fd);
+	}
+
+	if (num_present == 0) {
+		res = ERROR;
+	}
 
 	if (res != OK) {
 		mavlink_log_critical(mavlink_fd, CAL_FAILED_RESET_CAL_MSG);
@@ -91,30 +113,44 @@ int do_gyro_calibration(int mavlink_fd)
 	if (res == OK) {
 		/* determine gyro mean values */
 		const unsigned calibration_count = 5000;
-		unsigned calibration_counter = 0;
+		unsigned calibration_counter[CALIBRATION_MAX_INSTANCES] = { 0 };
 		unsigned poll_errcount = 0;
 
-		/* subscribe to gyro sensor topic */
-		int sub_sensor_gyro = orb_subscribe(ORB_ID(sensor_gyro0));
+		/* subscribe to the topics of all gyros, the first one sets the pace */
+		int sub_sensor_gyro[CALIBRATION_MAX_INSTANCES];
+		struct pollfd fds[CALIBRATION_MAX_INSTANCES];
 		struct gyro_report gyro_report;
 
-		while (calibration_counter < calibration_count) {
-			/* wait blocking for new data */
-			struct pollfd fds[1];
-			fds[0].fd = sub_sensor_gyro;
-			fds[0].events = POLLIN;
+		for (unsigned s = 0; s < num_present; s++) {
+			sub_sensor_gyro[s] = orb_subscribe_multi(ORB_ID(sensor_gyro), s);
+			fds[s].fd = sub_sensor_gyro[s];
+			fds[s].events = POLLIN;
+		}
 
-			int poll_ret = poll(fds, 1, 1000);
+		bool done = false;
+
+		while (!done) {
+			/* wait blocking for new data */
+			int poll_ret = poll(fds, num_present, 1000);
 
 			if (poll_ret > 0) {
-				orb_copy(ORB_ID(sensor_gyro0), sub_sensor_gyro, &gyro_report);
-				gyro_scale.x_offset += gyro_report.x;
-				gyro_scale.y_offset += gyro_report.y;
-				gyro_scale.z_offset += gyro_report.z;
-				calibration_counter++;
-
-				if (calibration_counter % (calibration_count / 20) == 0) {
-					mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, (calibration_counter * 100) / calibration_count);
+				for (unsigned s = 0; s < num_present; s++) {
+					if (!(fds[s].revents & POLLIN)) {
+						continue;
+					}
+
+					orb_copy(ORB_ID(sensor_gyro), sub_sensor_gyro[s], &gyro_report);
+
+					if (calibration_counter[s] < calibration_count) {
+						gyro_scale[s].x_offset += gyro_report.x;
+						gyro_scale[s].y_offset += gyro_report.y;
+						gyro_scale[s].z_offset += gyro_report.z;
+						calibration_counter[s]++;
+					}
+				}
+
+				if ((fds[0].revents & POLLIN) && calibration_counter[0] % (calibration_count / 20) == 0) {
+					mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, (calibration_counter[0] * 100) / calibration_count);
 				}
 
 			} else {
@@ -126,33 +162,33 @@ int do_gyro_calibration(int mavlink_fd)
 				res = ERROR;
 				break;
 			}
+
+			done = true;
+
+			for (unsigned s = 0; s < num_present; s++) {
+				if (calibration_counter[s] < calibration_count) {
+					done = false;
+				}
+			}
 		}
 
-		close(sub_sensor_gyro);
+		for (unsigned s = 0; s < num_present; s++) {
+			close(sub_sensor_gyro[s]);
 
-		gyro_scale.x_offset /= calibration_count;
-		gyro_scale.y_offset /= calibration_count;
-		gyro_scale.z_offset /= calibration_count;
+			gyro_scale[s].x_offset /= calibration_count;
+			gyro_scale[s].y_offset /= calibration_count;
+			gyro_scale[s].z_offset /= calibration_count;
+		}
 	}
 
-	if (res == OK) {
+	for (unsigned s = 0; s < num_present && res == OK; s++) {
 		/* check offsets */
-		if (!isfinite(gyro_scale.x_offset) || !isfinite(gyro_scale.y_offset) || !isfinite(gyro_scale.z_offset)) {
+		if (!isfinite(gyro_scale[s].x_offset) || !isfinite(gyro_scale[s].y_offset) || !isfinite(gyro_scale[s].z_offset)) {
 			mavlink_log_critical(mavlink_fd, "ERROR: offset is NaN");
 			res = ERROR;
 		}
 	}
 
-	if (res == OK) {
-		/* set offset parameters to new values */
-		if (param_set(param_find("SENS_GYRO_XOFF"), &(gyro_scale.x_offset))
-		    || param_set(param_find("SENS_GYRO_YOFF"), &(gyro_scale.y_offset))
-		    || param_set(param_find("SENS_GYRO_ZOFF"), &(gyro_scale.z_offset))) {
-			mavlink_log_critical(mavlink_fd, "ERROR: failed to set offset params");
-			res = ERROR;
-		}
-	}
-
 #if 0
 	/* beep on offset calibration end */
 	mavlink_log_info(mavlink_fd, "gyro offset calibration done");
@@ -269,20 +305,24 @@ int do_gyro_calibration(int mavlink_fd)
 
 #endif
 
-	if (res == OK) {
-		/* set scale parameters to new values */
-		if (param_set(param_find("SENS_GYRO_XSCALE"), &(gyro_scale.x_scale))
-		    || param_set(param_find("SENS_GYRO_YSCALE"), &(gyro_scale.y_scale))
-		    || param_set(param_find("SENS_GYRO_ZSCALE"), &(gyro_scale.z_scale))) {
-			mavlink_log_critical(mavlink_fd, "ERROR: failed to set scale params");
+	for (unsigned s = 0; s < num_present && res == OK; s++) {
+		/* set offset and scale parameters to new values */
+		float offset[3] = { gyro_scale[s].x_offset, gyro_scale[s].y_offset, gyro_scale[s].z_offset };
+		float scale[3] = { gyro_scale[s].x_scale, gyro_scale[s].y_scale, gyro_scale[s].z_scale };
+
+		if (calibration_set_params("GYRO", s, offset, scale) != OK) {
+			mavlink_log_critical(mavlink_fd, CAL_FAILED_SET_PARAMS_MSG);
 			res = ERROR;
 		}
 	}
 
-	if (res == OK) {
+	for (unsigned s = 0; s < num_present && res == OK; s++) {
 		/* apply new scaling and offsets */
-		fd = open(GYRO_DEVICE_PATH, 0);
-		res = ioctl(fd, GYROIOCSSCALE, (long unsigned int)&gyro_scale);
+		char path[16];
+		calibration_device_path(path, sizeof(path), GYRO_DEVICE_PATH, s);
+
+		int fd = open(path, 0);
+		res = ioctl(fd, GYROIOCSSCALE, (long unsigned int)&gyro_scale[s]);
 		close(fd);
 
 		if (res != OK) {
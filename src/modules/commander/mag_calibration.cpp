@@ -73,7 +73,7 @@ int do_mag_calibration(int mavlink_fd)
 
 	/* maximum 500 values */
 	const unsigned int calibration_maxcount = 240;
-	unsigned int calibration_counter;
+	unsigned int calibration_counter[CALIBRATION_MAX_INSTANCES] = { 0 };
 
 	struct mag_scale mscale_null = {
 		0.0f,
@@ -84,72 +84,79 @@ int do_mag_calibration(int mavlink_fd)
 		1.0f,
 	};
 
-	int res = OK;
+	/* one topic per mag class instance */
+	const struct orb_metadata *mag_topics[CALIBRATION_MAX_INSTANCES] = {
+		ORB_ID(sensor_mag0), ORB_ID(sensor_mag1), ORB_ID(sensor_mag2)
+	};
 
-	/* erase old calibration */
-	int fd = open(MAG_DEVICE_PATH, O_RDONLY);
-	res = ioctl(fd, MAGIOCSSCALE, (long unsigned int)&mscale_null);
+	unsigned num_mags = 0;
+	int res = OK;
 
-	if (res != OK) {
-		mavlink_log_critical(mavlink_fd, CAL_FAILED_RESET_CAL_MSG);
-	}
+	/* erase old calibration of all mags, class instances are numbered without gaps */
+	for (unsigned s = 0; s < CALIBRATION_MAX_INSTANCES && res == OK; s++) {
+		char path[16];
+		calibration_device_path(path, sizeof(path), MAG_DEVICE_PATH, s);
 
-	if (res == OK) {
-		/* calibrate range */
-		res = ioctl(fd, MAGIOCCALIBRATE, fd);
+		int fd = open(path, O_RDONLY);
 
-		if (res != OK) {
-			mavlink_log_critical(mavlink_fd, "Skipped scale calibration");
-			/* this is non-fatal - mark it accordingly */
-			res = OK;
+		if (fd < 0) {
+			break;
 		}
-	}
-
-	close(fd);
 
-	float *x = NULL;
-	float *y = NULL;
-	float *z = NULL;
+		num_mags++;
+		res = ioctl(fd, MAGIOCSSCALE, (long unsigned int)&mscale_null);
 
-	if (res == OK) {
-		/* allocate memory */
-		mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 20);
-
-		x = reinterpret_cast<float *>(malloc(sizeof(float) * calibration_maxcount));
-		y = reinterpret_cast<float *>(malloc(sizeof(float) * calibration_maxcount));
-		z = reinterpret_cast<float *>(malloc(sizeof(float) * calibration_maxcount));
-
-		if (x == NULL || y == NULL || z == NULL) {
-			mavlink_log_critical(mavlink_fd, "ERROR: out of memory");
+		if (res != OK) {
+			mavlink_log_critical(mavlink_fd, CAL_FAILED_RESET_CAL_MSG);
+		}
 
-			/* clean up */
-			if (x != NULL) {
-				free(x);
-			}
+		if (res == OK) {
+			/* calibrate range */
+			res = ioctl(fd, MAGIOCCALIBRATE, fd);
 
-			if (y != NULL) {
-				free(y);
+			if (res != OK) {
+				mavlink_log_critical(mavlink_fd, "Skipped scale calibration");
+				/* this is non-fatal - mark it accordingly */
+				res = OK;
 			}
+		}
 
-			if (z != NULL) {
-				free(z);
-			}
+		close(fd);
+	}
 
-			res = ERROR;
-			return res;
-		}
+	if (num_mags == 0) {
+		mavlink_log_critical(mavlink_fd, CAL_FAILED_RESET_CAL_MSG);
+		res = ERROR;
+	}
 
-	} else {
-		/* exit */
+	if (res != OK) {
 		return ERROR;
 	}
 
+	/* the fit only needs running sums, not the samples */
+	struct sphere_fit_sums sums[CALIBRATION_MAX_INSTANCES];
+
+	for (unsigned s = 0; s < num_mags; s++) {
+		sphere_fit_reset(&sums[s]);
+	}
+
+	mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 20);
+
 	if (res == OK) {
-		int sub_mag = orb_subscribe(ORB_ID(sensor_mag0));
+		/* all mags are sampled during the same rotations */
+		int sub_mag[CALIBRATION_MAX_INSTANCES];
+		struct pollfd fds[CALIBRATION_MAX_INSTANCES];
 		struct mag_report mag;
 
-		/* limit update rate to get equally spaced measurements over time (in ms) */
-		orb_set_interval(sub_mag, (calibration_interval / 1000) / calibration_maxcount);
+		for (unsigned s = 0; s < num_mags; s++) {
+			sub_mag[s] = orb_subscribe(mag_topics[s]);
+
+			/* limit update rate to get equally spaced measurements over time (in ms) */
+			orb_set_interval(sub_mag[s], (calibration_interval / 1000) / calibration_maxcount);
+
+			fds[s].fd = sub_mag[s];
+			fds[s].events = POLLIN;
+		}
 
 		/* calibrate offsets */
 		uint64_t calibration_deadline = hrt_absolute_time() + calibration_interval;
@@ -157,29 +164,28 @@ int do_mag_calibration(int mavlink_fd)
 
 		mavlink_log_info(mavlink_fd, "Turn on all sides: front/back,left/right,up/down");
 
-		calibration_counter = 0;
-
 		while (hrt_absolute_time() < calibration_deadline &&
-		       calibration_counter < calibration_maxcount) {
+		       calibration_counter[0] < calibration_maxcount) {
 
 			/* wait blocking for new data */
-			struct pollfd fds[1];
-			fds[0].fd = sub_mag;
-			fds[0].events = POLLIN;
-
-			int poll_ret = poll(fds, 1, 1000);
+			int poll_ret = poll(fds, num_mags, 1000);
 
 			if (poll_ret > 0) {
-				orb_copy(ORB_ID(sensor_mag0), sub_mag, &mag);
+				for (unsigned s = 0; s < num_mags; s++) {
+					if (!(fds[s].revents & POLLIN)) {
+						continue;
+					}
 
-				x[calibration_counter] = mag.x;
-				y[calibration_counter] = mag.y;
-				z[calibration_counter] = mag.z;
+					orb_copy(mag_topics[s], sub_mag[s], &mag);
 
-				calibration_counter++;
+					if (calibration_counter[s] < calibration_maxcount) {
+						sphere_fit_add(&sums[s], mag.x, mag.y, mag.z);
+						calibration_counter[s]++;
+					}
+				}
 
-				if (calibration_counter % (calibration_maxcount / 20) == 0) {
-					mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 20 + (calibration_counter * 50) / calibration_maxcount);
+				if ((fds[0].revents & POLLIN) && calibration_counter[0] % (calibration_maxcount / 20) == 0) {
+					mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 20 + (calibration_counter[0] * 50) / calibration_maxcount);
 				}
 
 			} else {
@@ -193,97 +199,86 @@ int do_mag_calibration(int mavlink_fd)
 			}
 		}
 
-		close(sub_mag);
+		for (unsigned s = 0; s < num_mags; s++) {
+			close(sub_mag[s]);
+		}
 	}
 
-	float sphere_x;
-	float sphere_y;
-	float sphere_z;
-	float sphere_radius;
+	float sphere_x[CALIBRATION_MAX_INSTANCES];
+	float sphere_y[CALIBRATION_MAX_INSTANCES];
+	float sphere_z[CALIBRATION_MAX_INSTANCES];
+	float sphere_radius[CALIBRATION_MAX_INSTANCES];
 
 	if (res == OK) {
 
 		/* sphere fit */
 		mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 70);
-		sphere_fit_least_squares(x, y, z, calibration_counter, 100, 0.0f, &sphere_x, &sphere_y, &sphere_z, &sphere_radius);
-		mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 80);
 
-		if (!isfinite(sphere_x) || !isfinite(sphere_y) || !isfinite(sphere_z)) {
-			mavlink_log_critical(mavlink_fd, "ERROR: NaN in sphere fit");
-			res = ERROR;
-		}
-	}
-
-	if (x != NULL) {
-		free(x);
-	}
+		for (unsigned s = 0; s < num_mags && res == OK; s++) {
+			if (sphere_fit_solve(&sums[s], 100, 0.0f, &sphere_x[s], &sphere_y[s], &sphere_z[s], &sphere_radius[s]) != 0) {
+				mavlink_log_critical(mavlink_fd, CAL_FAILED_SENSOR_MSG);
+				res = ERROR;
 
-	if (y != NULL) {
-		free(y);
-	}
+			} else if (!isfinite(sphere_x[s]) || !isfinite(sphere_y[s]) || !isfinite(sphere_z[s])) {
+				mavlink_log_critical(mavlink_fd, "ERROR: NaN in sphere fit");
+				res = ERROR;
+			}
+		}
 
-	if (z != NULL) {
-		free(z);
+		mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 80);
 	}
 
 	if (res == OK) {
 		/* apply calibration and set parameters */
-		struct mag_scale mscale;
+		struct mag_scale mscale[CALIBRATION_MAX_INSTANCES];
 
-		fd = open(MAG_DEVICE_PATH, 0);
-		res = ioctl(fd, MAGIOCGSCALE, (long unsigned int)&mscale);
+		for (unsigned s = 0; s < num_mags && res == OK; s++) {
+			char path[16];
+			calibration_device_path(path, sizeof(path), MAG_DEVICE_PATH, s);
 
-		if (res != OK) {
-			mavlink_log_critical(mavlink_fd, "ERROR: failed to get current calibration");
-		}
-
-		if (res == OK) {
-			mscale.x_offset = sphere_x;
-			mscale.y_offset = sphere_y;
-			mscale.z_offset = sphere_z;
-
-			res = ioctl(fd, MAGIOCSSCALE, (long unsigned int)&mscale);
+			int fd = open(path, 0);
+			res = ioctl(fd, MAGIOCGSCALE, (long unsigned int)&mscale[s]);
 
 			if (res != OK) {
-				mavlink_log_critical(mavlink_fd, CAL_FAILED_APPLY_CAL_MSG);
+				mavlink_log_critical(mavlink_fd, "ERROR: failed to get current calibration");
 			}
-		}
 
-		close(fd);
+			if (res == OK) {
+				mscale[s].x_offset = sphere_x[s];
+				mscale[s].y_offset = sphere_y[s];
+				mscale[s].z_offset = sphere_z[s];
 
-		if (res == OK) {
-			/* set parameters */
-			if (param_set(param_find("SENS_MAG_XOFF"), &(mscale.x_offset))) {
-				res = ERROR;
-			}
+				res = ioctl(fd, MAGIOCSSCALE, (long unsigned int)&mscale[s]);
 
-			if (param_set(param_find("SENS_MAG_YOFF"), &(mscale.y_offset))) {
-				res = ERROR;
+				if (res != OK) {
+					mavlink_log_critical(mavlink_fd, CAL_FAILED_APPLY_CAL_MSG);
+				}
 			}
 
-			if (param_set(param_find("SENS_MAG_ZOFF"), &(mscale.z_offset))) {
-				res = ERROR;
-			}
+			close(fd);
 
-			if (param_set(param_find("SENS_MAG_XSCALE"), &(mscale.x_scale))) {
-				res = ERROR;
-			}
+			if (res == OK) {
+				/* set parameters */
+				float offset[3] = { mscale[s].x_offset, mscale[s].y_offset, mscale[s].z_offset };
+				float scale[3] = { mscale[s].x_scale, mscale[s].y_scale, mscale[s].z_scale };
 
-			if (param_set(param_find("SENS_MAG_YSCALE"), &(mscale.y_scale))) {
-				res = ERROR;
-			}
+				res = calibration_set_params("MAG", s, offset, scale);
 
-			if (param_set(param_find("SENS_MAG_ZSCALE"), &(mscale.z_scale))) {
-				res = ERROR;
+				if (res != OK) {
+					mavlink_log_critical(mavlink_fd, CAL_FAILED_SET_PARAMS_MSG);
+				}
 			}
 
-			if (res != OK) {
-				mavlink_log_critical(mavlink_fd, CAL_FAILED_SET_PARAMS_MSG);
+			if (res == OK) {
+				mavlink_log_info(mavlink_fd, "mag%u off: x:%.2f y:%.2f z:%.2f Ga", s, (double)mscale[s].x_offset,
+						 (double)mscale[s].y_offset, (double)mscale[s].z_offset);
+				mavlink_log_info(mavlink_fd, "mag%u scale: x:%.2f y:%.2f z:%.2f", s, (double)mscale[s].x_scale,
+						 (double)mscale[s].y_scale, (double)mscale[s].z_scale);
 			}
-
-			mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 90);
 		}
 
+		mavlink_log_info(mavlink_fd, CAL_PROGRESS_MSG, sensor_name, 90);
+
 		if (res == OK) {
 			/* auto-save to EEPROM */
 			res = param_save_default();
@@ -293,11 +288,6 @@ int do_mag_calibration(int mavlink_fd)
 			}
 		}
 
-		mavlink_log_info(mavlink_fd, "mag off: x:%.2f y:%.2f z:%.2f Ga", (double)mscale.x_offset,
-				 (double)mscale.y_offset, (double)mscale.z_offset);
-		mavlink_log_info(mavlink_fd, "mag scale: x:%.2f y:%.2f z:%.2f", (double)mscale.x_scale,
-				 (double)mscale.y_scale, (double)mscale.z_scale);
-
 		if (res == OK) {
 			mavlink_log_info(mavlink_fd, CAL_DONE_MSG, sensor_name);
 
@@ -53,9 +53,11 @@
 #include <uORB/topics/actuator_controls.h>
 #include <uORB/topics/differential_pressure.h>
 #include <uORB/topics/airspeed.h>
+#include <uORB/topics/sensor_imu.h>
 #include <systemlib/systemlib.h>
 #include <systemlib/param/param.h>
 #include <systemlib/err.h>
+#include <systemlib/deadline.h>
 #include <drivers/drv_hrt.h>
 #include <drivers/drv_accel.h>
 #include <drivers/drv_airspeed.h>
@@ -71,6 +73,12 @@
 #endif
 static const int ERROR = -1;
 
+/* deadline misses of the control tasks this recent refuse arming */
+#define PREARM_DEADLINE_WINDOW	2000000
+
+/* the IMU is published at the gyro rate, a stale sample means a sensor or sensors app problem */
+#define PREARM_SENSOR_TIMEOUT	50000
+
 // This array defines the arming state transitions. The rows are the new state, and the columns
 // are the current state. Using new state and current  state you can index into the array which
 // will be true for a valid transition or false for a invalid transition. In some cases even
@@ -644,34 +652,76 @@ bool set_nav_state(struct vehicle_status_s *status, const bool data_link_loss_en
 	return status->nav_state != nav_state_old;
 }
 
+/* accel calibration result, -1 until checked and again after calibration changes */
+static int prearm_accel_calibrated = -1;
+static unsigned prearm_accel_cal_changes;
+
+/* sum of the change counters of the accel calibration parameters */
+static unsigned
+accel_cal_change_count()
+{
+	static const char *names[6] = {
+		"SENS_ACC_XOFF", "SENS_ACC_YOFF", "SENS_ACC_ZOFF",
+		"SENS_ACC_XSCALE", "SENS_ACC_YSCALE", "SENS_ACC_ZSCALE"
+	};
+	unsigned changes = 0;
+
+	for (unsigned i = 0; i < 6; i++) {
+		changes += param_get_change_count(param_find(names[i]));
+	}
+
+	return changes;
+}
+
+void prearm_check_invalidate()
+{
+	prearm_accel_calibrated = -1;
+}
+
 int prearm_check(const struct vehicle_status_s *status, const int mavlink_fd)
 {
-	int ret;
 	bool failed = false;
 
-	int fd = open(ACCEL_DEVICE_PATH, O_RDONLY);
+	/* this runs from the commander and from the shell, so nothing is kept subscribed */
+	int imu_sub = orb_subscribe(ORB_ID(sensor_imu));
+	int airspeed_sub = -1;
 
-	if (fd < 0) {
-		mavlink_log_critical(mavlink_fd, "ARM FAIL: ACCEL SENSOR MISSING");
-		failed = true;
-		goto system_eval;
+	/* the calibration only changes with its parameters */
+	unsigned cal_changes = accel_cal_change_count();
+
+	if (cal_changes != prearm_accel_cal_changes) {
+		prearm_accel_cal_changes = cal_changes;
+		prearm_accel_calibrated = -1;
 	}
 
-	ret = ioctl(fd, ACCELIOCSELFTEST, 0);
+	if (prearm_accel_calibrated < 0) {
+		int fd = open(ACCEL_DEVICE_PATH, O_RDONLY);
+
+		if (fd < 0) {
+			mavlink_log_critical(mavlink_fd, "ARM FAIL: ACCEL SENSOR MISSING");
+			failed = true;
+			goto system_eval;
+		}
 
-	if (ret != OK) {
+		prearm_accel_calibrated = (ioctl(fd, ACCELIOCSELFTEST, 0) == OK) ? 1 : 0;
+		close(fd);
+	}
+
+	if (!prearm_accel_calibrated) {
 		mavlink_log_critical(mavlink_fd, "ARM FAIL: ACCEL CALIBRATION");
 		failed = true;
 		goto system_eval;
 	}
 
-	/* check measurement result range */
-	struct accel_report acc;
-	ret = read(fd, &acc, sizeof(acc));
+	/* check the latest measurement of the accel in use */
+	struct sensor_imu_s imu;
 
-	if (ret == sizeof(acc)) {
+	if (orb_copy(ORB_ID(sensor_imu), imu_sub, &imu) == OK &&
+	    imu.accelerometer_healthy != 0 &&
+	    hrt_elapsed_time(&imu.accelerometer_timestamp) < PREARM_SENSOR_TIMEOUT) {
 		/* evaluate values */
-		float accel_magnitude = sqrtf(acc.x * acc.x + acc.y * acc.y + acc.z * acc.z);
+		const float *acc = imu.accelerometer_m_s2;
+		float accel_magnitude = sqrtf(acc[0] * acc[0] + acc[1] * acc[1] + acc[2] * acc[2]);
 
 		if (accel_magnitude < 4.0f || accel_magnitude > 15.0f /* m/s^2 */) {
 			mavlink_log_critical(mavlink_fd, "ARM FAIL: ACCEL RANGE, hold still");
@@ -689,13 +739,10 @@ int prearm_check(const struct vehicle_status_s *status, const int mavlink_fd)
 	/* Perform airspeed check only if circuit breaker is not
 	 * engaged and it's not a rotary wing */
 	if (!status->circuit_breaker_engaged_airspd_check && !status->is_rotary_wing) {
-		/* accel done, close it */
-		close(fd);
-		fd = orb_subscribe(ORB_ID(airspeed));
-
 		struct airspeed_s airspeed;
+		airspeed_sub = orb_subscribe(ORB_ID(airspeed));
 
-		if ((ret = orb_copy(ORB_ID(airspeed), fd, &airspeed)) ||
+		if (orb_copy(ORB_ID(airspeed), airspeed_sub, &airspeed) ||
 			(hrt_elapsed_time(&airspeed.timestamp) > (50 * 1000))) {
 			mavlink_log_critical(mavlink_fd, "ARM FAIL: AIRSPEED SENSOR MISSING");
 			failed = true;
@@ -708,7 +755,30 @@ int prearm_check(const struct vehicle_status_s *status, const int mavlink_fd)
 		}
 	}
 
+	/* the control tasks have to keep up, budget overruns alone only warn */
+	if (hrt_absolute_time() > PREARM_DEADLINE_WINDOW) {
+		hrt_abstime since = hrt_absolute_time() - PREARM_DEADLINE_WINDOW;
+		const char *task = deadline_failing(since, true);
+
+		if (task != NULL) {
+			mavlink_log_critical(mavlink_fd, "ARM FAIL: %s MISSED DEADLINE", task);
+			failed = true;
+			goto system_eval;
+		}
+
+		task = deadline_failing(since, false);
+
+		if (task != NULL) {
+			mavlink_log_critical(mavlink_fd, "DEADLINE WARNING: %s OVER BUDGET", task);
+		}
+	}
+
 system_eval:
-	close(fd);
+	close(imu_sub);
+
+	if (airspeed_sub >= 0) {
+		close(airspeed_sub);
+	}
+
 	return (failed);
 }
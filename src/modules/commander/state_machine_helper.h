@@ -65,6 +65,19 @@ transition_result_t hil_state_transition(hil_state_t new_state, int status_pub,
 
 bool set_nav_state(struct vehicle_status_s *status, const bool data_link_loss_enabled, const bool mission_finished, const bool stay_in_failsafe);
 
+/**
+ * Check if the system is ready to arm.
+ *
+ * Reads the latest published sensor data. The accel calibration is only
+ * checked on the device again after its parameters changed.
+ *
+ * @return 0 if ready to arm
+ */
 int prearm_check(const struct vehicle_status_s *status, const int mavlink_fd);
 
+/**
+ * Check the calibration on the device again on the next prearm_check().
+ */
+void prearm_check_invalidate(void);
+
 #endif /* STATE_MACHINE_HELPER_H_ */
@@ -40,9 +40,11 @@
 #include <math.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <uORB/Subscription.hpp>
 #include <uORB/Publication.hpp>
+#include <systemlib/param/param.h>
 
 #include "Block.hpp"
 #include "BlockParam.hpp"
@@ -50,15 +52,129 @@
 namespace control
 {
 
+BlockPlan::BlockPlan() :
+	blocks(NULL),
+	params(NULL),
+	subs(NULL),
+	subsData(NULL),
+	pubs(NULL),
+	pubsData(NULL),
+	numBlocks(0),
+	numParams(0),
+	numSubs(0),
+	numPubs(0)
+{
+}
+
+BlockPlan::~BlockPlan()
+{
+	free(blocks);
+	free(params);
+	free(subs);
+	free(subsData);
+	free(pubs);
+	free(pubsData);
+}
+
+int BlockPlan::allocate()
+{
+	/* allocate at least one entry, so that allocated arrays are never NULL */
+	blocks = (Block **)malloc((numBlocks + 1) * sizeof(blocks[0]));
+	params = (BlockParamBase **)malloc((numParams + 1) * sizeof(params[0]));
+	subs = (uORB::SubscriptionBase **)malloc((numSubs + 1) * sizeof(subs[0]));
+	subsData = (void **)malloc((numSubs + 1) * sizeof(subsData[0]));
+	pubs = (uORB::PublicationBase **)malloc((numPubs + 1) * sizeof(pubs[0]));
+	pubsData = (void **)malloc((numPubs + 1) * sizeof(pubsData[0]));
+
+	numBlocks = 0;
+	numParams = 0;
+	numSubs = 0;
+	numPubs = 0;
+
+	if (blocks == NULL || params == NULL || subs == NULL || subsData == NULL ||
+	    pubs == NULL || pubsData == NULL) {
+		return -1;
+	}
+
+	return 0;
+}
+
+Block *Block::_roots = NULL;
+
 Block::Block(SuperBlock *parent, const char *name) :
 	_name(name),
 	_parent(parent),
 	_dt(0),
 	_subscriptions(),
-	_params()
+	_params(),
+	_perf(NULL),
+	_perfName(NULL)
 {
 	if (getParent() != NULL) {
 		getParent()->getChildren().add(this);
+
+	} else {
+		setSibling(_roots);
+		_roots = this;
+	}
+
+	/* per block timing, CTL_PERF is read at construction */
+	int32_t profile = 0;
+	param_get(param_find("CTL_PERF"), &profile);
+
+	if (profile != 0) {
+		char fullname[blockNameLengthMax];
+		getName(fullname, blockNameLengthMax);
+		_perfName = strdup(fullname);
+
+		if (_perfName != NULL) {
+			_perf = perf_alloc(PC_ELAPSED, _perfName);
+		}
+	}
+}
+
+Block::~Block()
+{
+	if (getParent() == NULL) {
+		/* unlink from the roots */
+		if (_roots == this) {
+			_roots = getSibling();
+
+		} else {
+			for (Block *root = _roots; root != NULL; root = root->getSibling()) {
+				if (root->getSibling() == this) {
+					root->setSibling(getSibling());
+					break;
+				}
+			}
+		}
+	}
+
+	if (_perf != NULL) {
+		perf_free(_perf);
+	}
+
+	free(_perfName);
+}
+
+void Block::printPerf(unsigned depth)
+{
+	printf("%*s", depth * 2, "");
+
+	if (_perf != NULL) {
+		perf_print_counter(_perf);
+
+	} else {
+		char name[blockNameLengthMax];
+		getName(name, blockNameLengthMax);
+		printf("%s: not profiled\n", name);
+	}
+}
+
+void Block::printPerfAll()
+{
+	for (Block *root = _roots; root != NULL; root = root->getSibling()) {
+		root->printPerf(0);
 	}
 }
 
@@ -80,6 +196,37 @@ void Block::getName(char *buf, size_t n)
 	}
 }
 
+void Block::planCollect(BlockPlan &plan)
+{
+	if (plan.blocks != NULL) plan.blocks[plan.numBlocks] = this;
+
+	plan.numBlocks++;
+
+	for (BlockParamBase *param = getParams().getHead(); param != NULL; param = param->getSibling()) {
+		if (plan.params != NULL) plan.params[plan.numParams] = param;
+
+		plan.numParams++;
+	}
+
+	for (uORB::SubscriptionBase *sub = getSubscriptions().getHead(); sub != NULL; sub = sub->getSibling()) {
+		if (plan.subs != NULL) {
+			plan.subs[plan.numSubs] = sub;
+			plan.subsData[plan.numSubs] = sub->getDataVoidPtr();
+		}
+
+		plan.numSubs++;
+	}
+
+	for (uORB::PublicationBase *pub = getPublications().getHead(); pub != NULL; pub = pub->getSibling()) {
+		if (plan.pubs != NULL) {
+			plan.pubs[plan.numPubs] = pub;
+			plan.pubsData[plan.numPubs] = pub->getDataVoidPtr();
+		}
+
+		plan.numPubs++;
+	}
+}
+
 void Block::updateParams()
 {
 	BlockParamBase *param = getParams().getHead();
@@ -135,8 +282,82 @@ void Block::updatePublications()
 	}
 }
 
+SuperBlock::~SuperBlock()
+{
+	delete _plan;
+}
+
+int SuperBlock::plan()
+{
+	BlockPlan *plan = new BlockPlan();
+
+	if (plan == NULL) return -1;
+
+	/* count, then fill */
+	planCollect(*plan);
+
+	if (plan->allocate() != 0) {
+		delete plan;
+		return -1;
+	}
+
+	planCollect(*plan);
+
+	delete _plan;
+	_plan = plan;
+	return 0;
+}
+
+void SuperBlock::planCollect(BlockPlan &plan)
+{
+	Block::planCollect(plan);
+
+	for (Block *child = getChildren().getHead(); child != NULL; child = child->getSibling()) {
+		child->planCollect(plan);
+	}
+}
+
+void SuperBlock::printPerf(unsigned depth)
+{
+	Block::printPerf(depth);
+
+	for (Block *child = getChildren().getHead(); child != NULL; child = child->getSibling()) {
+		child->printPerf(depth + 1);
+	}
+}
+
+void SuperBlock::updatePlanParams()
+{
+	for (uint16_t i = 0; i < _plan->numParams; i++) {
+		_plan->params[i]->update();
+	}
+}
+
+void SuperBlock::updatePlanSubscriptions()
+{
+	for (uint16_t i = 0; i < _plan->numSubs; i++) {
+		_plan->subs[i]->update(_plan->subsData[i]);
+	}
+}
+
+void SuperBlock::updatePlanPublications()
+{
+	for (uint16_t i = 0; i < _plan->numPubs; i++) {
+		_plan->pubs[i]->update(_plan->pubsData[i]);
+	}
+}
+
 void SuperBlock::setDt(float dt)
 {
+	if (_plan != NULL) {
+		/* blocks of the plan only keep dt, no need to recurse */
+		for (uint16_t i = 0; i < _plan->numBlocks; i++) {
+			_plan->blocks[i]->_dt = dt;
+		}
+
+		return;
+	}
+
 	Block::setDt(dt);
 	Block *child = getChildren().getHead();
 	int count = 0;
@@ -43,6 +43,7 @@
 #include <inttypes.h>
 
 #include <containers/List.hpp>
+#include <systemlib/perf_counter.h>
 
 // forward declaration
 namespace uORB {
@@ -62,6 +63,36 @@ static const uint8_t blockNameLengthMax = 80;
 // forward declaration
 class BlockParamBase;
 class SuperBlock;
+class Block;
+
+/**
+ * Flattened execution plan of a block tree, see SuperBlock::plan().
+ *
+ * Holds every block, parameter, subscription and publication of the
+ * tree in arrays, so that updates run as flat loops.
+ */
+struct __EXPORT BlockPlan {
+	BlockPlan();
+	~BlockPlan();
+	/**
+	 * Allocate the arrays for the entries counted by a first
+	 * collection pass and reset the counts for the second pass.
+	 */
+	int allocate();
+	Block **blocks;
+	BlockParamBase **params;
+	uORB::SubscriptionBase **subs;
+	void **subsData;
+	uORB::PublicationBase **pubs;
+	void **pubsData;
+	uint16_t numBlocks;
+	uint16_t numParams;
+	uint16_t numSubs;
+	uint16_t numPubs;
+private:
+	BlockPlan(const BlockPlan&);
+	BlockPlan operator=(const BlockPlan&);
+};
 
 /**
  */
@@ -70,17 +101,39 @@ class __EXPORT Block :
 {
 public:
 	friend class BlockParamBase;
+	friend class SuperBlock;
 // methods
 	Block(SuperBlock *parent, const char *name);
 	void getName(char *name, size_t n);
-	virtual ~Block() {};
+	virtual ~Block();
 	virtual void updateParams();
 	virtual void updateSubscriptions();
 	virtual void updatePublications();
 	virtual void setDt(float dt) { _dt = dt; }
+	/**
+	 * Time an update of this block, see BlockPerfScope.
+	 * Does nothing unless profiling was enabled with CTL_PERF
+	 * when the block was constructed.
+	 */
+	void perfBegin() { if (_perf != NULL) perf_begin(_perf); }
+	void perfEnd() { if (_perf != NULL) perf_end(_perf); }
+	/**
+	 * Print the update timing of this block and the blocks below it.
+	 */
+	virtual void printPerf(unsigned depth);
+	/**
+	 * Print the update timing of all block trees.
+	 */
+	static void printPerfAll();
 // accessors
 	float getDt() { return _dt; }
 protected:
+// methods
+	/**
+	 * Add this block and its lists to a plan, count only
+	 * while the plan arrays are not allocated yet.
+	 */
+	virtual void planCollect(BlockPlan &plan);
 // accessors
 	SuperBlock *getParent() { return _parent; }
 	List<uORB::SubscriptionBase *> & getSubscriptions() { return _subscriptions; }
@@ -93,8 +146,13 @@ protected:
 	List<uORB::SubscriptionBase *> _subscriptions;
 	List<uORB::PublicationBase *> _publications;
 	List<BlockParamBase *> _params;
+	perf_counter_t _perf;
+	char *_perfName;
 
 private:
+	/** root blocks, chained through their sibling pointers */
+	static Block *_roots;
+
 	/* this class has pointer data members and should not be copied (private constructor) */
 	Block(const control::Block&);
 	Block operator=(const control::Block&);
@@ -108,21 +166,48 @@ public:
 // methods
 	SuperBlock(SuperBlock *parent, const char *name) :
 		Block(parent, name),
-		_children() {
+		_children(),
+		_plan(NULL) {
 	}
-	virtual ~SuperBlock() {};
+	virtual ~SuperBlock();
+	/**
+	 * Flatten the tree below this block into an execution plan.
+	 *
+	 * Afterwards setDt() and the update functions run as flat loops
+	 * over the plan instead of walking the children recursively. Call
+	 * once, after all children have been constructed.
+	 *
+	 * @return 0 on success, -1 if out of memory (the tree is then
+	 * walked as before)
+	 */
+	int plan();
 	virtual void setDt(float dt);
 	virtual void updateParams() {
+		if (_plan != NULL) {
+			updatePlanParams();
+			return;
+		}
+
 		Block::updateParams();
 
 		if (getChildren().getHead() != NULL) updateChildParams();
 	}
 	virtual void updateSubscriptions() {
+		if (_plan != NULL) {
+			updatePlanSubscriptions();
+			return;
+		}
+
 		Block::updateSubscriptions();
 
 		if (getChildren().getHead() != NULL) updateChildSubscriptions();
 	}
 	virtual void updatePublications() {
+		if (_plan != NULL) {
+			updatePlanPublications();
+			return;
+		}
+
 		Block::updatePublications();
 
 		if (getChildren().getHead() != NULL) updateChildPublications();
@@ -130,11 +215,37 @@ public:
 protected:
 // methods
 	List<Block *> & getChildren() { return _children; }
+	virtual void planCollect(BlockPlan &plan);
+	virtual void printPerf(unsigned depth);
 	void updateChildParams();
 	void updateChildSubscriptions();
 	void updateChildPublications();
+	void updatePlanParams();
+	void updatePlanSubscriptions();
+	void updatePlanPublications();
 // attributes
 	List<Block *> _children;
+	BlockPlan *_plan;
+};
+
+/**
+ * Times the enclosing scope, usually a block's update(),
+ * with the perf counter of the block.
+ */
+class __EXPORT BlockPerfScope
+{
+public:
+	BlockPerfScope(Block *block) :
+		_block(block) {
+		_block->perfBegin();
+	}
+	~BlockPerfScope() {
+		_block->perfEnd();
+	}
+private:
+	Block *_block;
+	BlockPerfScope(const BlockPerfScope&);
+	BlockPerfScope operator=(const BlockPerfScope&);
 };
 
 } // namespace control
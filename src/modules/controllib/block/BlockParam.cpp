@@ -47,7 +47,9 @@ namespace control
 {
 
 BlockParamBase::BlockParamBase(Block *parent, const char *name, bool parent_prefix) :
-	_handle(PARAM_INVALID)
+	_handle(PARAM_INVALID),
+	_change_count(0),
+	_stale(true)
 {
 	char fullname[blockNameLengthMax];
 
@@ -76,6 +78,19 @@ BlockParamBase::BlockParamBase(Block *parent, const char *name, bool parent_pref
 		printf("error finding param: %s\n", fullname);
 };
 
+bool BlockParamBase::changed()
+{
+	unsigned count = param_get_change_count(_handle);
+
+	if (_stale || count != _change_count) {
+		_change_count = count;
+		_stale = false;
+		return true;
+	}
+
+	return false;
+}
+
 template <class T>
 BlockParam<T>::BlockParam(Block *block, const char *name,
 		bool parent_prefix) :
@@ -88,11 +103,18 @@ template <class T>
 T BlockParam<T>::get() { return _val; }
 
 template <class T>
-void BlockParam<T>::set(T val) { _val = val; }
+void BlockParam<T>::set(T val) {
+	_val = val;
+	/* a local override is replaced by the parameter on the next update */
+	_stale = true;
+}
 
 template <class T>
-void BlockParam<T>::update() {
-	if (_handle != PARAM_INVALID) param_get(_handle, &_val);
+bool BlockParam<T>::update() {
+	if (_handle == PARAM_INVALID || !changed()) return false;
+
+	param_get(_handle, &_val);
+	return true;
 }
 
 template <class T>
@@ -60,14 +60,31 @@ public:
 	 */
 	BlockParamBase(Block *parent, const char *name, bool parent_prefix=true);
 	virtual ~BlockParamBase() {};
-	virtual void update() = 0;
+	/**
+	 * Re-read the value if the parameter changed since the last read.
+	 *
+	 * @return true if the value was re-read
+	 */
+	virtual bool update() = 0;
 	const char *getName() { return param_name(_handle); }
 protected:
+	/**
+	 * Check the change counter of the parameter and take note of it.
+	 *
+	 * @return true if the parameter changed since the last call
+	 */
+	bool changed();
 	param_t _handle;
+	unsigned _change_count;
+	bool _stale;
 };
 
 /**
  * Parameters that are tied to blocks for updating and nameing.
+ *
+ * The value is cached and only re-read when the parameter itself changed,
+ * so a parameter_update caused by an unrelated parameter is cheap. The
+ * block may be NULL for a standalone cached handle.
  */
 
 template <class T>
@@ -78,7 +95,7 @@ public:
 			bool parent_prefix=true);
 	T get();
 	void set(T val);
-	void update();
+	bool update();
 	virtual ~BlockParam();
 protected:
 	T _val;
@@ -66,6 +66,8 @@ int basicBlocksTest()
 
 float BlockLimit::update(float input)
 {
+	BlockPerfScope perf(this);
+
 	if (input > getMax()) {
 		input = _max.get();
 
@@ -94,6 +96,8 @@ int blockLimitTest()
 
 float BlockLimitSym::update(float input)
 {
+	BlockPerfScope perf(this);
+
 	if (input > getMax()) {
 		input = _max.get();
 
@@ -121,6 +125,8 @@ int blockLimitSymTest()
 
 float BlockLowPass::update(float input)
 {
+	BlockPerfScope perf(this);
+
 	if (!isfinite(getState())) {
 		setState(input);
 	}
@@ -160,6 +166,8 @@ int blockLowPassTest()
 
 float BlockHighPass::update(float input)
 {
+	BlockPerfScope perf(this);
+
 	float b = 2 * float(M_PI) * getFCut() * getDt();
 	float a = 1 / (1 + b);
 	setY(a * (getY() + input - getU()));
@@ -200,6 +208,8 @@ int blockHighPassTest()
 
 float BlockIntegral::update(float input)
 {
+	BlockPerfScope perf(this);
+
 	// trapezoidal integration
 	setY(_limit.update(getY() + input * getDt()));
 	return getY();
@@ -244,6 +254,8 @@ int blockIntegralTest()
 
 float BlockIntegralTrap::update(float input)
 {
+	BlockPerfScope perf(this);
+
 	// trapezoidal integration
 	setY(_limit.update(getY() +
 			   (getU() + input) / 2.0f * getDt()));
@@ -296,6 +308,8 @@ int blockIntegralTrapTest()
 
 float BlockDerivative::update(float input)
 {
+	BlockPerfScope perf(this);
+
 	float output;
 	if (_initialized) {
 		output = _lowPass.update((input - getU()) / getDt());
@@ -285,6 +285,7 @@ public:
 	{};
 	virtual ~BlockP() {};
 	float update(float input) {
+		BlockPerfScope perf(this);
 		return getKP() * input;
 	}
 // accessors
@@ -311,6 +312,7 @@ public:
 	{};
 	virtual ~BlockPI() {};
 	float update(float input) {
+		BlockPerfScope perf(this);
 		return getKP() * input +
 		       getKI() * getIntegral().update(input);
 	}
@@ -342,6 +344,7 @@ public:
 	{};
 	virtual ~BlockPD() {};
 	float update(float input) {
+		BlockPerfScope perf(this);
 		return getKP() * input +
 		       getKD() * getDerivative().update(input);
 	}
@@ -375,6 +378,7 @@ public:
 	{};
 	virtual ~BlockPID() {};
 	float update(float input) {
+		BlockPerfScope perf(this);
 		return getKP() * input +
 		       getKI() * getIntegral().update(input) +
 		       getKD() * getDerivative().update(input);
@@ -412,6 +416,7 @@ public:
 	};
 	virtual ~BlockOutput() {};
 	void update(float input) {
+		BlockPerfScope perf(this);
 		_val = _limit.update(input + getTrim());
 	}
 // accessors
@@ -34,7 +34,11 @@
 #
 # Control library
 #
-SRCS		 = test_params.c \
+MODULE_COMMAND	 = controllib
+
+SRCS		 = controllib_main.cpp \
+		   controllib_params.c \
+		   test_params.c \
 		   block/Block.cpp \
 		   block/BlockParam.cpp \
 		   uorb/blocks.cpp \
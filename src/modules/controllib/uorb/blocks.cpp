@@ -57,6 +57,7 @@ void BlockWaypointGuidance::update(vehicle_global_position_s &pos,
 				   position_setpoint_s &missionCmd,
 				   position_setpoint_s &lastMissionCmd)
 {
+	BlockPerfScope perf(this);
 
 	// heading to waypoint
 	float psiTrack = get_bearing_to_next_waypoint(
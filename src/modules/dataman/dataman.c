@@ -48,6 +48,9 @@
 #include <systemlib/err.h>
 #include <queue.h>
 #include <string.h>
+#include <time.h>
+#include <semaphore.h>
+#include <drivers/drv_hrt.h>
 
 #include "dataman.h"
 #include <systemlib/param/param.h>
@@ -61,7 +64,9 @@
 __EXPORT int dataman_main(int argc, char *argv[]);
 __EXPORT ssize_t dm_read(dm_item_t item, unsigned char index, void *buffer, size_t buflen);
 __EXPORT ssize_t dm_write(dm_item_t  item, unsigned char index, dm_persitence_t persistence, const void *buffer, size_t buflen);
+__EXPORT ssize_t dm_write_batch(dm_item_t item, unsigned char index, unsigned char num, dm_persitence_t persistence, const void *buffer, size_t item_len);
 __EXPORT int dm_clear(dm_item_t item);
+__EXPORT int dm_flush(void);
 __EXPORT void dm_lock(dm_item_t item);
 __EXPORT void dm_unlock(dm_item_t item);
 __EXPORT int dm_restart(dm_reset_reason restart_type);
@@ -72,6 +77,8 @@ typedef enum {
 	dm_read_func,
 	dm_clear_func,
 	dm_restart_func,
+	dm_write_batch_func,
+	dm_flush_func,
 	dm_number_of_funcs
 } dm_function_t;
 
@@ -90,6 +97,14 @@ typedef struct {
 			const void *buf;
 			size_t count;
 		} write_params;
+		struct {
+			dm_item_t item;
+			unsigned char index;
+			unsigned char num;
+			dm_persitence_t persistence;
+			const void *buf;
+			size_t count;
+		} write_batch_params;
 		struct {
 			dm_item_t item;
 			unsigned char index;
@@ -123,6 +138,30 @@ static const unsigned g_per_item_max_index[DM_KEY_NUM_KEYS] = {
 /* Table of offset for index 0 of each item type */
 static unsigned int g_key_offsets[DM_KEY_NUM_KEYS];
 
+/*
+ * Item types that are kept on the device given with "dataman start -r", for
+ * example a FRAM partition set up by the mtd command. The whole file layout
+ * does not fit into the small partitions, so the waypoints stay on the SD
+ * card. The device holds a header sector followed by the sectors of these
+ * item types, in the same fixed order the file uses. The file layout does
+ * not change, the areas of these item types are just left unused in it.
+ */
+static const bool k_item_on_device[DM_KEY_NUM_KEYS] = {
+	true,	/* DM_KEY_SAFE_POINTS */
+	true,	/* DM_KEY_FENCE_POINTS */
+	false,	/* DM_KEY_WAYPOINTS_OFFBOARD_0 */
+	false,	/* DM_KEY_WAYPOINTS_OFFBOARD_1 */
+	false,	/* DM_KEY_WAYPOINTS_ONBOARD */
+	true	/* DM_KEY_MISSION_STATE */
+};
+
+/* Offsets on the device, valid for the item types with g_key_on_device set */
+static unsigned int g_dev_offsets[DM_KEY_NUM_KEYS];
+static bool g_key_on_device[DM_KEY_NUM_KEYS];
+
+/* Sizes of the file and the used part of the device */
+static unsigned g_max_offset, g_dev_max_offset;
+
 /* Item type lock mutexes */
 static sem_t *g_item_locks[DM_KEY_NUM_KEYS];
 static sem_t g_sys_state_mutex;
@@ -131,6 +170,11 @@ static sem_t g_sys_state_mutex;
 static int g_fd = -1, g_task_fd = -1;
 static const char *k_data_manager_device_path = "/fs/microsd/dataman";
 
+/* The optional device for some of the item types and its handle */
+static char g_dev_path[32];
+static int g_dev_fd = -1;
+static const unsigned char k_dev_magic[4] = {'D', 'M', 'R', '1'};
+
 /* The data manager work queues */
 
 typedef struct {
@@ -151,6 +195,43 @@ static bool g_task_should_exit;	/**< if true, dataman task should exit */
 #define DM_SECTOR_HDR_SIZE 4	/* data manager per item header overhead */
 static const unsigned k_sector_size = DM_MAX_DATA_SIZE + DM_SECTOR_HDR_SIZE; /* total item sorage space */
 
+/*
+ * Sector cache in front of the data manager file
+ *
+ * Reads are served from RAM once a sector has been loaded. Writes only go to
+ * the cache, dirty sectors are written back when they are evicted and all of
+ * them at once, with a single fsync, DM_FLUSH_INTERVAL after the first write
+ * that dirtied the cache or on dm_flush(). The waypoint items alone are three
+ * times NUM_MISSIONS_SUPPORTED sectors, so only a small LRU set is kept.
+ */
+#define DM_CACHE_SECTORS	16		/* number of cached sectors */
+#define DM_FLUSH_INTERVAL	1000000		/* longest time a write stays in RAM only, in us */
+
+typedef struct {
+	dm_item_t item;
+	unsigned char index;
+	bool valid;
+	bool dirty;
+	unsigned age;		/* value of g_cache_clock at the last use */
+	unsigned char data[DM_MAX_DATA_SIZE + DM_SECTOR_HDR_SIZE];	/* sector image, header first */
+} dm_cache_entry_t;
+
+static dm_cache_entry_t g_cache[DM_CACHE_SECTORS];
+static unsigned g_cache_clock;
+static bool g_cache_unsynced;		/**< sectors were written to the file since the last fsync */
+static hrt_abstime g_flush_deadline;	/**< when the dirty sectors must be written back, 0 if there are none */
+
+/* Cache statistics */
+static unsigned g_cache_hits, g_cache_misses, g_cache_write_backs, g_cache_flushes;
+
+/*
+ * The cache is shared between the worker task and callers of dm_read().
+ * The worker holds the lock while it handles a work item, a caller only
+ * while it copies a sector that is already cached, see dm_read().
+ */
+static sem_t g_cache_mutex;
+static unsigned g_fast_reads;	/**< reads served in the caller's context */
+
 static void init_q(work_q_t *q)
 {
 	sq_init(&(q->q));		/* Initialize the NuttX queue structure */
@@ -287,9 +368,51 @@ calculate_offset(dm_item_t item, unsigned char index)
 		return -1;
 
 	/* Calculate and return the item index based on type and index */
+	if (g_key_on_device[item])
+		return g_dev_offsets[item] + (index * k_sector_size);
+
 	return g_key_offsets[item] + (index * k_sector_size);
 }
 
+/* The handle of the file or device an item type is stored in */
+static inline int
+item_fd(dm_item_t item)
+{
+	return g_key_on_device[item] ? g_dev_fd : g_task_fd;
+}
+
+/* Make sure everything written to the device is on the physical media */
+static void
+sync_device(void)
+{
+	/* The block to character driver holds a partially written block until the device is closed */
+	if (g_dev_fd >= 0) {
+		close(g_dev_fd);
+		g_dev_fd = open(g_dev_path, O_RDWR | O_BINARY);
+
+		if (g_dev_fd < 0)
+			warnx("Could not reopen data manager device %s", g_dev_path);
+	}
+}
+
+/* Make sure everything written for an item type is on the physical media */
+static void
+sync_item(dm_item_t item)
+{
+	if (g_key_on_device[item])
+		sync_device();
+	else
+		fsync(g_task_fd);
+}
+
+/* Make sure everything written to the file and the device is on the physical media */
+static void
+sync_stores(void)
+{
+	fsync(g_task_fd);
+	sync_device();
+}
+
 /* Each data item is stored as follows
  *
  * byte 0: Length of user data item
@@ -301,81 +424,229 @@ calculate_offset(dm_item_t item, unsigned char index)
  * The total size must not exceed k_sector_size
  */
 
-/* write to the data manager file */
+/* Find the cache entry of an item, NULL if it is not cached */
+static dm_cache_entry_t *
+cache_find(dm_item_t item, unsigned char index)
+{
+	for (unsigned i = 0; i < DM_CACHE_SECTORS; i++) {
+		if (g_cache[i].valid && g_cache[i].item == item && g_cache[i].index == index)
+			return &g_cache[i];
+	}
+
+	return NULL;
+}
+
+/* Write a dirty cache entry to the data manager file, without fsync */
+static int
+cache_write_back(dm_cache_entry_t *entry)
+{
+	int offset = calculate_offset(entry->item, entry->index);
+	size_t count = entry->data[0] + DM_SECTOR_HDR_SIZE;
+
+	if (lseek(item_fd(entry->item), offset, SEEK_SET) != offset)
+		return -1;
+
+	if ((size_t)write(item_fd(entry->item), entry->data, count) != count)
+		return -1;
+
+	entry->dirty = false;
+	g_cache_unsynced = true;
+	g_cache_write_backs++;
+	return 0;
+}
+
+/* Get the cache entry of an item, evicting the least recently used one if needed */
+static dm_cache_entry_t *
+cache_get(dm_item_t item, unsigned char index, bool load)
+{
+	dm_cache_entry_t *entry = cache_find(item, index);
+
+	if (entry != NULL) {
+		g_cache_hits++;
+		entry->age = ++g_cache_clock;
+		return entry;
+	}
+
+	g_cache_misses++;
+
+	/* Take an unused entry, or the one unused for the longest time */
+	entry = &g_cache[0];
+
+	for (unsigned i = 0; i < DM_CACHE_SECTORS && entry->valid; i++) {
+		if (!g_cache[i].valid || g_cache[i].age < entry->age)
+			entry = &g_cache[i];
+	}
+
+	if (entry->valid && entry->dirty && cache_write_back(entry) != 0)
+		return NULL;
+
+	entry->valid = false;
+
+	if (load) {
+		int offset = calculate_offset(item, index);
+		int len = -1;
+
+		if (lseek(item_fd(item), offset, SEEK_SET) == offset)
+			len = read(item_fd(item), entry->data, k_sector_size);
+
+		/* Check for read error */
+		if (len < 0)
+			return NULL;
+
+		/* A zero length entry is a empty entry, the file ends before sectors never written */
+		if (len < DM_SECTOR_HDR_SIZE || entry->data[0] > len - DM_SECTOR_HDR_SIZE)
+			entry->data[0] = 0;
+	}
+
+	entry->item = item;
+	entry->index = index;
+	entry->valid = true;
+	entry->dirty = false;
+	entry->age = ++g_cache_clock;
+	return entry;
+}
+
+/* Drop the cached sectors of an item, dirty ones included */
+static void
+cache_invalidate(dm_item_t item, unsigned first, unsigned num)
+{
+	for (unsigned i = 0; i < DM_CACHE_SECTORS; i++) {
+		if (g_cache[i].valid && g_cache[i].item == item &&
+		    g_cache[i].index >= first && g_cache[i].index < first + num)
+			g_cache[i].valid = false;
+	}
+}
+
+/* Write back all dirty sectors and make sure they are on the physical media */
+static int
+_flush(void)
+{
+	int result = 0;
+
+	for (unsigned i = 0; i < DM_CACHE_SECTORS; i++) {
+		if (g_cache[i].valid && g_cache[i].dirty && cache_write_back(&g_cache[i]) != 0)
+			result = -1;
+	}
+
+	if (g_cache_unsynced) {
+		sync_stores();
+		g_cache_unsynced = false;
+		g_cache_flushes++;
+	}
+
+	/* A failed sector stays dirty and is retried with the next flush */
+	g_flush_deadline = (result == 0) ? 0 : hrt_absolute_time() + DM_FLUSH_INTERVAL;
+	return result;
+}
+
+/* write to the data manager cache */
 static ssize_t
 _write(dm_item_t item, unsigned char index, dm_persitence_t persistence, const void *buf, size_t count)
 {
-	unsigned char buffer[k_sector_size];
-	size_t len;
-	int offset;
-
-	/* Get the offset for this item */
-	offset = calculate_offset(item, index);
+	dm_cache_entry_t *entry;
 
 	/* If item type or index out of range, return error */
-	if (offset < 0)
+	if (calculate_offset(item, index) < 0)
 		return -1;
 
 	/* Make sure caller has not given us more data than we can handle */
 	if (count > DM_MAX_DATA_SIZE)
 		return -1;
 
-	/* Write out the data, prefixed with length and persistence level */
-	buffer[0] = count;
-	buffer[1] = persistence;
-	buffer[2] = 0;
-	buffer[3] = 0;
+	/* The whole sector is replaced, no need to load it */
+	if ((entry = cache_get(item, index, false)) == NULL)
+		return -1;
+
+	/* Store the data, prefixed with length and persistence level */
+	entry->data[0] = count;
+	entry->data[1] = persistence;
+	entry->data[2] = 0;
+	entry->data[3] = 0;
 	if (count > 0) {
-		memcpy(buffer + DM_SECTOR_HDR_SIZE, buf, count);
+		memcpy(entry->data + DM_SECTOR_HDR_SIZE, buf, count);
 	}
-	count += DM_SECTOR_HDR_SIZE;
+	entry->dirty = true;
 
-	len = -1;
+	/* Written back to the physical media with the next flush */
+	if (g_flush_deadline == 0)
+		g_flush_deadline = hrt_absolute_time() + DM_FLUSH_INTERVAL;
 
-	/* Seek to the right spot in the data manager file and write the data item */
-	if (lseek(g_task_fd, offset, SEEK_SET) == offset)
-		if ((len = write(g_task_fd, buffer, count)) == count)
-			fsync(g_task_fd); /* Make sure data is written to physical media */
+	/* All is well... return the number of user data written */
+	return count;
+}
+
+/* write consecutive items to the data manager file with a single fsync */
+static ssize_t
+_write_batch(dm_item_t item, unsigned char index, unsigned char num, dm_persitence_t persistence, const void *buf, size_t count)
+{
+	unsigned char buffer[k_sector_size];
+	const unsigned char *src = (const unsigned char *)buf;
 
-	/* Make sure the write succeeded */
-	if (len != count)
+	/* If item type or any index out of range, return error */
+	if (num == 0 || (unsigned)index + num > 256 ||
+	    calculate_offset(item, index) < 0 || calculate_offset(item, index + num - 1) < 0)
 		return -1;
 
+	/* Make sure caller has not given us more data than we can handle */
+	if (count > DM_MAX_DATA_SIZE)
+		return -1;
+
+	/* The batch goes straight to the file, cached copies would be stale */
+	cache_invalidate(item, index, num);
+
+	for (unsigned i = 0; i < num; i++) {
+		int offset = calculate_offset(item, index + i);
+
+		/* Write out the data, prefixed with length and persistence level */
+		buffer[0] = count;
+		buffer[1] = persistence;
+		buffer[2] = 0;
+		buffer[3] = 0;
+		if (count > 0) {
+			memcpy(buffer + DM_SECTOR_HDR_SIZE, src + i * count, count);
+		}
+
+		if (lseek(item_fd(item), offset, SEEK_SET) != offset)
+			return -1;
+
+		if ((size_t)write(item_fd(item), buffer, count + DM_SECTOR_HDR_SIZE) != count + DM_SECTOR_HDR_SIZE)
+			return -1;
+	}
+
+	/* Make sure data is written to physical media, once for all items */
+	sync_item(item);
+
 	/* All is well... return the number of user data written */
-	return count - DM_SECTOR_HDR_SIZE;
+	return num * count;
 }
 
-/* Retrieve from the data manager file */
+static ssize_t cache_copy(const dm_cache_entry_t *entry, void *buf, size_t count);
+
+/* Retrieve from the data manager cache, loading the sector on a miss */
 static ssize_t
 _read(dm_item_t item, unsigned char index, void *buf, size_t count)
 {
-	unsigned char buffer[k_sector_size];
-	int len, offset;
-
-	/* Get the offset for this item */
-	offset = calculate_offset(item, index);
+	dm_cache_entry_t *entry;
 
 	/* If item type or index out of range, return error */
-	if (offset < 0)
+	if (calculate_offset(item, index) < 0)
 		return -1;
 
 	/* Make sure the caller hasn't asked for more data than we can handle */
 	if (count > DM_MAX_DATA_SIZE)
 		return -1;
 
-	/* Read the prefix and data */
-	len = -1;
-
-	if (lseek(g_task_fd, offset, SEEK_SET) == offset)
-		len = read(g_task_fd, buffer, count + DM_SECTOR_HDR_SIZE);
-
-	/* Check for read error */
-	if (len < 0)
+	if ((entry = cache_get(item, index, true)) == NULL)
 		return -1;
 
-	/* A zero length entry is a empty entry */
-	if (len == 0)
-		buffer[0] = 0;
+	return cache_copy(entry, buf, count);
+}
+
+/* Copy the user data of a cache entry to the caller's buffer */
+static ssize_t
+cache_copy(const dm_cache_entry_t *entry, void *buf, size_t count)
+{
+	const unsigned char *buffer = entry->data;
 
 	/* See if we got data */
 	if (buffer[0] > 0) {
@@ -403,29 +674,32 @@ _clear(dm_item_t item)
 	if (offset < 0)
 		return -1;
 
+	/* Cached sectors, written back or not, are cleared as well */
+	cache_invalidate(item, 0, g_per_item_max_index[item]);
+
 	/* Clear all items of this type */
 	for (i = 0; (unsigned)i < g_per_item_max_index[item]; i++) {
 		char buf[1];
 
-		if (lseek(g_task_fd, offset, SEEK_SET) != offset) {
+		if (lseek(item_fd(item), offset, SEEK_SET) != offset) {
 			result = -1;
 			break;
 		}
 
 		/* Avoid SD flash wear by only doing writes where necessary */
-		if (read(g_task_fd, buf, 1) < 1)
+		if (read(item_fd(item), buf, 1) < 1)
 			break;
 
 		/* If item has length greater than 0 it needs to be overwritten */
 		if (buf[0]) {
-			if (lseek(g_task_fd, offset, SEEK_SET) != offset) {
+			if (lseek(item_fd(item), offset, SEEK_SET) != offset) {
 				result = -1;
 				break;
 			}
 
 			buf[0] = 0;
 
-			if (write(g_task_fd, buf, 1) != 1) {
+			if (write(item_fd(item), buf, 1) != 1) {
 				result = -1;
 				break;
 			}
@@ -435,30 +709,28 @@ _clear(dm_item_t item)
 	}
 
 	/* Make sure data is actually written to physical media */
-	fsync(g_task_fd);
+	sync_item(item);
 	return result;
 }
 
-/** Tell the data manager about the type of the last reset */
+/** Invalidate the data segments of a file or device that should not persist after the last reset */
 static int
-_restart(dm_reset_reason reason)
+restart_store(int fd, int offset, int end, dm_reset_reason reason)
 {
 	unsigned char buffer[2];
-	int offset = 0, result = 0;
-
-	/* We need to scan the entire file and invalidate and data that should not persist after the last reset */
+	int result = 0;
 
 	/* Loop through all of the data segments and delete those that are not persistent */
-	while (1) {
+	while (offset < end) {
 		size_t len;
 
 		/* Get data segment at current offset */
-		if (lseek(g_task_fd, offset, SEEK_SET) != offset) {
+		if (lseek(fd, offset, SEEK_SET) != offset) {
 			/* must be at eof */
 			break;
 		}
 
-		len = read(g_task_fd, buffer, sizeof(buffer));
+		len = read(fd, buffer, sizeof(buffer));
 
 		if (len != sizeof(buffer)) {
 			/* must be at eof */
@@ -483,14 +755,14 @@ _restart(dm_reset_reason reason)
 
 			/* Set segment to unused if data does not persist */
 			if (clear_entry) {
-				if (lseek(g_task_fd, offset, SEEK_SET) != offset) {
+				if (lseek(fd, offset, SEEK_SET) != offset) {
 					result = -1;
 					break;
 				}
 
 				buffer[0] = 0;
 
-				len = write(g_task_fd, buffer, 1);
+				len = write(fd, buffer, 1);
 
 				if (len != 1) {
 					result = -1;
@@ -502,7 +774,31 @@ _restart(dm_reset_reason reason)
 		offset += k_sector_size;
 	}
 
-	fsync(g_task_fd);
+	return result;
+}
+
+/** Tell the data manager about the type of the last reset */
+static int
+_restart(dm_reset_reason reason)
+{
+	int result = 0;
+
+	/* Write back and drop the cache, the scan below works on the stores */
+	if (_flush() != 0)
+		result = -1;
+
+	for (unsigned i = 0; i < DM_CACHE_SECTORS; i++)
+		g_cache[i].valid = false;
+
+	/* We need to scan the entire file and invalidate and data that should not persist after the last reset */
+	if (restart_store(g_task_fd, 0, g_max_offset, reason) != 0)
+		result = -1;
+
+	/* The same for the sectors after the header of the device */
+	if ((g_dev_fd >= 0) && (restart_store(g_dev_fd, k_sector_size, g_dev_max_offset, reason) != 0))
+		result = -1;
+
+	sync_stores();
 
 	/* tell the caller how it went */
 	return result;
@@ -533,6 +829,32 @@ dm_write(dm_item_t item, unsigned char index, dm_persitence_t persistence, const
 	return (ssize_t)enqueue_work_item_and_wait_for_result(work);
 }
 
+/** Write consecutive items to the data manager file */
+__EXPORT ssize_t
+dm_write_batch(dm_item_t item, unsigned char index, unsigned char num, dm_persitence_t persistence, const void *buf, size_t item_len)
+{
+	work_q_item_t *work;
+
+	/* Make sure data manager has been started and is not shutting down */
+	if ((g_fd < 0) || g_task_should_exit)
+		return -1;
+
+	/* get a work item and queue up a batch write request */
+	if ((work = create_work_item()) == NULL)
+		return -1;
+
+	work->func = dm_write_batch_func;
+	work->write_batch_params.item = item;
+	work->write_batch_params.index = index;
+	work->write_batch_params.num = num;
+	work->write_batch_params.persistence = persistence;
+	work->write_batch_params.buf = buf;
+	work->write_batch_params.count = item_len;
+
+	/* Enqueue the item on the work queue and wait for the worker thread to complete processing it */
+	return (ssize_t)enqueue_work_item_and_wait_for_result(work);
+}
+
 /** Retrieve from the data manager file */
 __EXPORT ssize_t
 dm_read(dm_item_t item, unsigned char index, void *buf, size_t count)
@@ -543,6 +865,28 @@ dm_read(dm_item_t item, unsigned char index, void *buf, size_t count)
 	if ((g_fd < 0) || g_task_should_exit)
 		return -1;
 
+	/* A cached sector is copied right here, without a round trip through the worker task */
+	if ((calculate_offset(item, index) >= 0) && (count <= DM_MAX_DATA_SIZE)) {
+		ssize_t result = -1;
+		bool hit = false;
+
+		sem_wait(&g_cache_mutex);
+		dm_cache_entry_t *entry = cache_find(item, index);
+
+		if (entry != NULL) {
+			hit = true;
+			entry->age = ++g_cache_clock;
+			g_cache_hits++;
+			g_fast_reads++;
+			result = cache_copy(entry, buf, count);
+		}
+
+		sem_post(&g_cache_mutex);
+
+		if (hit)
+			return result;
+	}
+
 	/* get a work item and queue up a read request */
 	if ((work = create_work_item()) == NULL)
 		return -1;
@@ -577,6 +921,26 @@ dm_clear(dm_item_t item)
 	return enqueue_work_item_and_wait_for_result(work);
 }
 
+/** Write all cached changes to the physical media */
+__EXPORT int
+dm_flush(void)
+{
+	work_q_item_t *work;
+
+	/* Make sure data manager has been started and is not shutting down */
+	if ((g_fd < 0) || g_task_should_exit)
+		return -1;
+
+	/* get a work item and queue up a flush request */
+	if ((work = create_work_item()) == NULL)
+		return -1;
+
+	work->func = dm_flush_func;
+
+	/* Enqueue the item on the work queue and wait for the worker thread to complete processing it */
+	return enqueue_work_item_and_wait_for_result(work);
+}
+
 __EXPORT void
 dm_lock(dm_item_t item)
 {
@@ -624,6 +988,81 @@ dm_restart(dm_reset_reason reason)
 	return enqueue_work_item_and_wait_for_result(work);
 }
 
+/* Open the device for the item types in k_item_on_device and check its layout */
+static int
+open_device(void)
+{
+	unsigned char header[k_sector_size], buffer[k_sector_size];
+	unsigned offset = k_sector_size;
+
+	/* The header sector describes the layout, the data sectors follow it */
+	memset(header, 0, sizeof(header));
+	memcpy(header, k_dev_magic, sizeof(k_dev_magic));
+	header[4] = k_sector_size & 0xff;
+	header[5] = k_sector_size >> 8;
+
+	for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++) {
+		if (k_item_on_device[i]) {
+			g_dev_offsets[i] = offset;
+			offset += g_per_item_max_index[i] * k_sector_size;
+			header[6 + 2 * i] = g_per_item_max_index[i] & 0xff;
+			header[7 + 2 * i] = g_per_item_max_index[i] >> 8;
+		}
+	}
+
+	g_dev_fd = open(g_dev_path, O_RDWR | O_BINARY);
+
+	if (g_dev_fd < 0) {
+		warnx("Could not open data manager device %s", g_dev_path);
+		return -1;
+	}
+
+	int dev_size = lseek(g_dev_fd, 0, SEEK_END);
+
+	if ((dev_size < 0) || ((unsigned)dev_size < offset)) {
+		warnx("Data manager device %s is too small, %u bytes needed", g_dev_path, offset);
+		close(g_dev_fd);
+		g_dev_fd = -1;
+		return -1;
+	}
+
+	g_dev_max_offset = offset;
+
+	/* Anything but our own layout is cleared, it might be left over from other use */
+	if ((lseek(g_dev_fd, 0, SEEK_SET) != 0) ||
+	    (read(g_dev_fd, buffer, k_sector_size) != (ssize_t)k_sector_size) ||
+	    memcmp(buffer, header, k_sector_size)) {
+
+		warnx("Incompatible data manager device %s, resetting it", g_dev_path);
+
+		memset(buffer, 0, sizeof(buffer));
+
+		for (offset = k_sector_size; offset < g_dev_max_offset; offset += k_sector_size) {
+			if ((lseek(g_dev_fd, offset, SEEK_SET) != (off_t)offset) ||
+			    (write(g_dev_fd, buffer, DM_SECTOR_HDR_SIZE) != DM_SECTOR_HDR_SIZE))
+				break;
+		}
+
+		if ((offset < g_dev_max_offset) || (lseek(g_dev_fd, 0, SEEK_SET) != 0) ||
+		    (write(g_dev_fd, header, k_sector_size) != (ssize_t)k_sector_size)) {
+			warnx("Could not reset data manager device %s", g_dev_path);
+			close(g_dev_fd);
+			g_dev_fd = -1;
+			return -1;
+		}
+
+		sync_device();
+
+		if (g_dev_fd < 0)
+			return -1;
+	}
+
+	for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++)
+		g_key_on_device[i] = k_item_on_device[i];
+
+	return 0;
+}
+
 static int
 task_main(int argc, char *argv[])
 {
@@ -639,10 +1078,24 @@ task_main(int argc, char *argv[])
 		g_key_offsets[i + 1] = g_key_offsets[i] + (g_per_item_max_index[i] * k_sector_size);
 
 	unsigned max_offset = g_key_offsets[DM_KEY_NUM_KEYS - 1] + (g_per_item_max_index[DM_KEY_NUM_KEYS - 1] * k_sector_size);
+	g_max_offset = max_offset;
+
+	for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++)
+		g_key_on_device[i] = false;
 
 	for (unsigned i = 0; i < dm_number_of_funcs; i++)
 		g_func_counts[i] = 0;
 
+	for (unsigned i = 0; i < DM_CACHE_SECTORS; i++)
+		g_cache[i].valid = false;
+
+	g_cache_clock = 0;
+	g_cache_unsynced = false;
+	g_flush_deadline = 0;
+	g_cache_hits = g_cache_misses = g_cache_write_backs = g_cache_flushes = 0;
+	g_fast_reads = 0;
+	sem_init(&g_cache_mutex, 1, 1); /* Initially unlocked */
+
 	/* Initialize the item type locks, for now only DM_KEY_MISSION_STATE supports locking */
 	sem_init(&g_sys_state_mutex, 1, 1); /* Initially unlocked */
 	for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++)
@@ -688,6 +1141,10 @@ task_main(int argc, char *argv[])
 
 	fsync(g_task_fd);
 
+	/* Without the device everything stays in the file */
+	if ((g_dev_path[0] != '\0') && (open_device() != 0))
+		warnx("Keeping all items in %s", k_data_manager_device_path);
+
 	/* see if we need to erase any items based on restart type */
 	int sys_restart_val;
 	if (param_get(param_find("SYS_RESTART_TYPE"), &sys_restart_val) == OK) {
@@ -712,6 +1169,9 @@ task_main(int argc, char *argv[])
 
 	warnx("Initialized, data manager file '%s' size is %d bytes", k_data_manager_device_path, max_offset);
 
+	if (g_dev_fd >= 0)
+		warnx("Safe points, fence and mission state on '%s', %d bytes used", g_dev_path, g_dev_max_offset);
+
 	/* Tell startup that the worker thread has completed its initialization */
 	sem_post(&g_init_sema);
 
@@ -725,13 +1185,37 @@ task_main(int argc, char *argv[])
 		}
 
 		if (!g_task_should_exit) {
-			/* wait for work */
-			sem_wait(&g_work_queued_sema);
+			if (g_flush_deadline != 0) {
+				/* wait for work, but not beyond the time the dirty sectors are due */
+				hrt_abstime now = hrt_absolute_time();
+
+				if (now < g_flush_deadline) {
+					struct timespec abstime;
+					hrt_abstime wait = g_flush_deadline - now;
+
+					clock_gettime(CLOCK_REALTIME, &abstime);
+					abstime.tv_sec += wait / 1000000;
+					abstime.tv_nsec += (wait % 1000000) * 1000;
+
+					if (abstime.tv_nsec >= 1000000000) {
+						abstime.tv_sec++;
+						abstime.tv_nsec -= 1000000000;
+					}
+
+					sem_timedwait(&g_work_queued_sema, &abstime);
+				}
+
+			} else {
+				/* wait for work */
+				sem_wait(&g_work_queued_sema);
+			}
 		}
 
 		/* Empty the work queue */
 		while ((work = dequeue_work_item())) {
 
+			sem_wait(&g_cache_mutex);
+
 			/* handle each work item with the appropriate handler */
 			switch (work->func) {
 			case dm_write_func:
@@ -740,6 +1224,13 @@ task_main(int argc, char *argv[])
 					_write(work->write_params.item, work->write_params.index, work->write_params.persistence, work->write_params.buf, work->write_params.count);
 				break;
 
+			case dm_write_batch_func:
+				g_func_counts[dm_write_batch_func]++;
+				work->result =
+					_write_batch(work->write_batch_params.item, work->write_batch_params.index, work->write_batch_params.num,
+						     work->write_batch_params.persistence, work->write_batch_params.buf, work->write_batch_params.count);
+				break;
+
 			case dm_read_func:
 				g_func_counts[dm_read_func]++;
 				work->result =
@@ -756,23 +1247,47 @@ task_main(int argc, char *argv[])
 				work->result = _restart(work->restart_params.reason);
 				break;
 
+			case dm_flush_func:
+				g_func_counts[dm_flush_func]++;
+				work->result = _flush();
+				break;
+
 			default: /* should never happen */
 				work->result = -1;
 				break;
 			}
 
+			sem_post(&g_cache_mutex);
+
 			/* Inform the caller that work is done */
 			sem_post(&work->wait_sem);
 		}
 
+		/* Write back the dirty sectors once they are due */
+		if ((g_flush_deadline != 0) && (hrt_absolute_time() >= g_flush_deadline)) {
+			sem_wait(&g_cache_mutex);
+			_flush();
+			sem_post(&g_cache_mutex);
+		}
+
 		/* time to go???? */
 		if ((g_task_should_exit) && (g_fd < 0))
 			break;
 	}
 
+	/* Nothing may stay in RAM only */
+	sem_wait(&g_cache_mutex);
+	_flush();
+	sem_post(&g_cache_mutex);
+
 	close(g_task_fd);
 	g_task_fd = -1;
 
+	if (g_dev_fd >= 0) {
+		close(g_dev_fd);
+		g_dev_fd = -1;
+	}
+
 	/* The work queue is now empty, empty the free queue */
 	for (;;) {
 		if ((work = (work_q_item_t *)sq_remfirst(&(g_free_q.q))) == NULL)
@@ -785,6 +1300,7 @@ task_main(int argc, char *argv[])
 	destroy_q(&g_free_q);
 	sem_destroy(&g_work_queued_sema);
 	sem_destroy(&g_sys_state_mutex);
+	sem_destroy(&g_cache_mutex);
 
 	return 0;
 }
@@ -814,10 +1330,17 @@ status(void)
 {
 	/* display usage statistics */
 	warnx("Writes   %d", g_func_counts[dm_write_func]);
-	warnx("Reads    %d", g_func_counts[dm_read_func]);
+	warnx("Batch writes %d", g_func_counts[dm_write_batch_func]);
+	warnx("Reads    %d, %d more from the cache directly", g_func_counts[dm_read_func], g_fast_reads);
 	warnx("Clears   %d", g_func_counts[dm_clear_func]);
 	warnx("Restarts %d", g_func_counts[dm_restart_func]);
+	warnx("Flushes  %d", g_func_counts[dm_flush_func]);
+	warnx("Cache hits %d, misses %d, write backs %d, syncs %d",
+	      g_cache_hits, g_cache_misses, g_cache_write_backs, g_cache_flushes);
 	warnx("Max Q lengths work %d, free %d", g_work_q.max_size, g_free_q.max_size);
+
+	if (g_dev_fd >= 0)
+		warnx("Device %s", g_dev_path);
 }
 
 static void
@@ -831,7 +1354,7 @@ stop(void)
 static void
 usage(void)
 {
-	errx(1, "usage: dataman {start|stop|status|poweronrestart|inflightrestart}");
+	errx(1, "usage: dataman {start [-r <device>]|stop|status|poweronrestart|inflightrestart}");
 }
 
 int
@@ -845,6 +1368,17 @@ dataman_main(int argc, char *argv[])
 		if (g_fd >= 0)
 			errx(1, "already running");
 
+		/* safe points, fence and mission state on a separate device, e.g. FRAM */
+		if (argc > 2) {
+			if ((argc != 4) || strcmp(argv[2], "-r") || (strlen(argv[3]) >= sizeof(g_dev_path)))
+				usage();
+
+			strcpy(g_dev_path, argv[3]);
+
+		} else {
+			g_dev_path[0] = '\0';
+		}
+
 		start();
 
 		if (g_fd < 0)
@@ -105,6 +105,21 @@ extern "C" {
 		size_t buflen			/* Length in bytes of data to retrieve */
 	);
 
+	/** write consecutive items to the data manager store, flushed to the media once */
+	__EXPORT ssize_t
+	dm_write_batch(
+		dm_item_t  item,		/* The item type to store */
+		unsigned char index,		/* The index of the first item */
+		unsigned char num,		/* The number of items */
+		dm_persitence_t persistence,	/* The persistence level of these items */
+		const void *buffer,		/* Pointer to caller data buffer, num items of item_len bytes */
+		size_t item_len			/* Length in bytes of one item */
+	);
+
+	/** Write all cached changes to the physical media, done periodically otherwise */
+	__EXPORT int
+	dm_flush(void);
+
 	/** Lock all items of this type */
 	__EXPORT void
 	dm_lock(
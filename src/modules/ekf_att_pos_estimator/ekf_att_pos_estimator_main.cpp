@@ -48,6 +48,7 @@
 #include <errno.h>
 #include <math.h>
 #include <poll.h>
+#include <semaphore.h>
 #include <time.h>
 #include <float.h>
 
@@ -102,6 +103,8 @@ __EXPORT uint64_t getMicros();
 static uint64_t IMUmsec = 0;
 static uint64_t IMUusec = 0;
 static const uint64_t FILTER_INIT_DELAY = 1 * 1000 * 1000;
+/** covariance prediction and fusion steps allowed per IMU update */
+static const unsigned FILTER_STEPS_PER_CYCLE = 2;
 
 uint32_t millis()
 {
@@ -133,9 +136,10 @@ public:
 	/**
 	 * Start the sensors task.
 	 *
+	 * @param	imu_callback Wake the task from a callback on the IMU topic instead of poll().
 	 * @return	OK on success.
 	 */
-	int		start();
+	int		start(bool imu_callback);
 
 	/**
 	 * Task status
@@ -173,6 +177,8 @@ private:
 	bool		_task_should_exit;		/**< if true, sensor task should exit */
 	bool		_task_running;			/**< if true, task is running in its mainloop */
 	int		_estimator_task;		/**< task handle for sensor task */
+	bool		_imu_callback;			/**< if true, an IMU topic callback wakes the task */
+	sem_t		_imu_sem;			/**< posted by the IMU topic callback */
 #ifndef SENSOR_COMBINED_SUB
 	int		_gyro_sub;			/**< gyro sensor subscription */
 	int		_accel_sub;			/**< accel sensor subscription */
@@ -190,6 +196,20 @@ private:
 	int		_mission_sub;
 	int		_home_sub;			/**< home position as defined by commander / user */
 
+	/** inputs copied in one go every IMU update, see _input_batch */
+	enum {
+		INPUT_AIRSPEED = 0,
+		INPUT_GPS,
+		INPUT_BARO,
+		INPUT_RANGE,
+#ifndef SENSOR_COMBINED_SUB
+		INPUT_MAG,
+#endif
+		INPUT_NUM
+	};
+
+	struct orb_batch_entry	_input_batch[INPUT_NUM];	/**< the non-IMU sensor subscriptions */
+
 	orb_advert_t	_att_pub;			/**< vehicle attitude */
 	orb_advert_t	_global_pos_pub;		/**< global position */
 	orb_advert_t	_local_pos_pub;			/**< position in local frame */
@@ -265,6 +285,8 @@ private:
 		float magb_pnoise;
 		float eas_noise;
 		float pos_stddev_threshold;
+		int32_t	imu_rate;
+		float fast_att_tc;
 	}		_parameters;			/**< local copies of interesting parameters */
 
 	struct {
@@ -286,9 +308,14 @@ private:
 		param_t magb_pnoise;
 		param_t eas_noise;
 		param_t pos_stddev_threshold;
+		param_t	imu_rate;
+		param_t fast_att_tc;
 	}		_parameter_handles;		/**< handles for interesting parameters */
 
 	AttPosEKF					*_ekf;
+	ImuPreintegrator				_imu_preint;		///< sums IMU samples up to the filter rate
+	FastAttitude					_fast_att;		///< attitude output between filter updates
+	bool						_fast_att_valid;	///< _fast_att has been set from the filter
 
 	float						_velocity_xy_filtered;
 	float						_velocity_z_filtered;
@@ -315,11 +342,23 @@ private:
 	 */
 	static void	task_main_trampoline(int argc, char *argv[]);
 
+	/**
+	 * IMU topic callback, wakes the task.
+	 */
+	static void	imu_callback_trampoline(void *arg);
+
 	/**
 	 * Main filter task.
 	 */
 	void		task_main();
 
+	/**
+	 * Publish the attitude, with the rates of the last IMU sample.
+	 *
+	 * @param q		Attitude quaternion, body to NED.
+	 */
+	void		publish_attitude(const float q[4]);
+
 	/**
 	 * Check filter sanity state
 	 *
@@ -345,6 +384,8 @@ FixedwingEstimator::FixedwingEstimator() :
 	_task_should_exit(false),
 	_task_running(false),
 	_estimator_task(-1),
+	_imu_callback(false),
+	_imu_sem{},
 
 /* subscriptions */
 #ifndef SENSOR_COMBINED_SUB
@@ -363,6 +404,7 @@ FixedwingEstimator::FixedwingEstimator() :
 	_manual_control_sub(-1),
 	_mission_sub(-1),
 	_home_sub(-1),
+	_input_batch{},
 
 /* publications */
 	_att_pub(-1),
@@ -423,6 +465,9 @@ FixedwingEstimator::FixedwingEstimator() :
 	_parameters{},
 	_parameter_handles{},
 	_ekf(nullptr),
+	_imu_preint(),
+	_fast_att(),
+	_fast_att_valid(false),
 	_velocity_xy_filtered(0.0f),
 	_velocity_z_filtered(0.0f),
 	_airspeed_filtered(0.0f)
@@ -448,6 +493,8 @@ FixedwingEstimator::FixedwingEstimator() :
 	_parameter_handles.magb_pnoise = param_find("PE_MAGB_PNOISE");
 	_parameter_handles.eas_noise = param_find("PE_EAS_NOISE");
 	_parameter_handles.pos_stddev_threshold = param_find("PE_POSDEV_INIT");
+	_parameter_handles.imu_rate = param_find("PE_IMU_RATE");
+	_parameter_handles.fast_att_tc = param_find("PE_FAST_ATT_TC");
 
 	/* fetch initial parameter values */
 	parameters_update();
@@ -547,6 +594,8 @@ FixedwingEstimator::parameters_update()
 	param_get(_parameter_handles.magb_pnoise, &(_parameters.magb_pnoise));
 	param_get(_parameter_handles.eas_noise, &(_parameters.eas_noise));
 	param_get(_parameter_handles.pos_stddev_threshold, &(_parameters.pos_stddev_threshold));
+	param_get(_parameter_handles.imu_rate, &(_parameters.imu_rate));
+	param_get(_parameter_handles.fast_att_tc, &(_parameters.fast_att_tc));
 
 	if (_ekf) {
 		// _ekf->yawVarScale = 1.0f;
@@ -698,12 +747,61 @@ FixedwingEstimator::check_filter_state()
 	return check;
 }
 
+void
+FixedwingEstimator::publish_attitude(const float q[4])
+{
+	math::Quaternion quat(q[0], q[1], q[2], q[3]);
+	math::Matrix<3, 3> R = quat.to_dcm();
+	math::Vector<3> euler = R.to_euler();
+
+	for (int i = 0; i < 3; i++) for (int j = 0; j < 3; j++)
+			_att.R[i][j] = R(i, j);
+
+	_att.timestamp = _last_sensor_timestamp;
+	_att.q[0] = q[0];
+	_att.q[1] = q[1];
+	_att.q[2] = q[2];
+	_att.q[3] = q[3];
+	_att.q_valid = true;
+	_att.R_valid = true;
+
+	_att.roll = euler(0);
+	_att.pitch = euler(1);
+	_att.yaw = euler(2);
+
+	_att.rollspeed = _ekf->angRate.x - _ekf->states[10];
+	_att.pitchspeed = _ekf->angRate.y - _ekf->states[11];
+	_att.yawspeed = _ekf->angRate.z - _ekf->states[12];
+	// gyro offsets
+	_att.rate_offsets[0] = _ekf->states[10];
+	_att.rate_offsets[1] = _ekf->states[11];
+	_att.rate_offsets[2] = _ekf->states[12];
+
+	/* lazily publish the attitude only once available */
+	if (_att_pub > 0) {
+		/* publish the attitude setpoint */
+		orb_publish(ORB_ID(vehicle_attitude), _att_pub, &_att);
+
+	} else {
+		/* advertise and publish */
+		_att_pub = orb_advertise(ORB_ID(vehicle_attitude), &_att);
+	}
+}
+
 void
 FixedwingEstimator::task_main_trampoline(int argc, char *argv[])
 {
 	estimator::g_estimator->task_main();
 }
 
+void
+FixedwingEstimator::imu_callback_trampoline(void *arg)
+{
+	FixedwingEstimator *dev = reinterpret_cast<FixedwingEstimator *>(arg);
+
+	sem_post(&dev->_imu_sem);
+}
+
 void
 FixedwingEstimator::task_main()
 {
@@ -746,6 +844,27 @@ FixedwingEstimator::task_main()
 	orb_set_interval(_sensor_combined_sub, 9);
 #endif
 
+	orb_batch_init(&_input_batch[INPUT_AIRSPEED], ORB_ID(airspeed), _airspeed_sub, &_airspeed);
+	orb_batch_init(&_input_batch[INPUT_GPS], ORB_ID(vehicle_gps_position), _gps_sub, &_gps);
+	orb_batch_init(&_input_batch[INPUT_BARO], ORB_ID(sensor_baro0), _baro_sub, &_baro);
+	orb_batch_init(&_input_batch[INPUT_RANGE], ORB_ID(sensor_range_finder), _distance_sub, &_distance);
+#ifndef SENSOR_COMBINED_SUB
+	orb_batch_init(&_input_batch[INPUT_MAG], ORB_ID(sensor_mag), _mag_sub, &_mag);
+
+	int imu_sub = _gyro_sub;
+#else
+	int imu_sub = _sensor_combined_sub;
+#endif
+
+	if (_imu_callback) {
+		sem_init(&_imu_sem, 0, 0);
+
+		if (orb_register_callback(imu_sub, &FixedwingEstimator::imu_callback_trampoline, this) != OK) {
+			warn("IMU callback failed, using poll");
+			_imu_callback = false;
+		}
+	}
+
 	/* sets also parameters in the EKF object */
 	parameters_update();
 
@@ -783,23 +902,50 @@ FixedwingEstimator::task_main()
 
 	while (!_task_should_exit) {
 
-		/* wait for up to 100ms for data */
-		int pret = poll(&fds[0], (sizeof(fds) / sizeof(fds[0])), 100);
+		bool params_updated;
+		bool imu_updated;
+
+		if (_imu_callback) {
+			/* wait for up to 100ms for the IMU callback */
+			struct timespec abstime;
+			clock_gettime(CLOCK_REALTIME, &abstime);
+			abstime.tv_nsec += 100 * 1000 * 1000;
 
-		/* timed out - periodic check for _task_should_exit, etc. */
-		if (pret == 0)
-			continue;
+			if (abstime.tv_nsec >= 1000 * 1000 * 1000) {
+				abstime.tv_sec++;
+				abstime.tv_nsec -= 1000 * 1000 * 1000;
+			}
+
+			/* timed out or interrupted - periodic check for _task_should_exit, etc. */
+			if (sem_timedwait(&_imu_sem, &abstime) != OK)
+				continue;
+
+			/* a wakeup can be left over from a sample the last cycle already took */
+			orb_check(_params_sub, &params_updated);
+			orb_check(imu_sub, &imu_updated);
+
+		} else {
+			/* wait for up to 100ms for data */
+			int pret = poll(&fds[0], (sizeof(fds) / sizeof(fds[0])), 100);
+
+			/* timed out - periodic check for _task_should_exit, etc. */
+			if (pret == 0)
+				continue;
+
+			/* this is undesirable but not much we can do - might want to flag unhappy status */
+			if (pret < 0) {
+				warn("POLL ERR %d, %d", pret, errno);
+				continue;
+			}
 
-		/* this is undesirable but not much we can do - might want to flag unhappy status */
-		if (pret < 0) {
-			warn("POLL ERR %d, %d", pret, errno);
-			continue;
+			params_updated = (fds[0].revents & POLLIN);
+			imu_updated = (fds[1].revents & POLLIN);
 		}
 
 		perf_begin(_loop_perf);
 
 		/* only update parameters if they changed */
-		if (fds[0].revents & POLLIN) {
+		if (params_updated) {
 			/* read from param to clear updated flag */
 			struct parameter_update_s update;
 			orb_copy(ORB_ID(parameter_update), _params_sub, &update);
@@ -809,14 +955,14 @@ FixedwingEstimator::task_main()
 		}
 
 		/* only run estimator if gyro updated */
-		if (fds[1].revents & POLLIN) {
+		if (imu_updated) {
 
 			/* check vehicle status for changes to publication state */
 			bool prev_hil = (_vstatus.hil_state == HIL_STATE_ON);
 			vehicle_status_poll();
 
 			bool accel_updated;
-			bool mag_updated;
+			bool mag_updated = false;
 
 			perf_count(_perf_gyro);
 
@@ -846,6 +992,8 @@ FixedwingEstimator::task_main()
 
 				_ekf->ZeroVariables();
 				_ekf->dtIMU = 0.01f;
+				_imu_preint.reset();
+				_fast_att_valid = false;
 				_filter_start_time = _last_sensor_timestamp;
 
 				/* now skip this loop and get data on the next one, which will also re-init the filter */
@@ -981,6 +1129,61 @@ FixedwingEstimator::task_main()
 			_ekf->dVelIMU = 0.5f * (_ekf->accel + lastAccel) * _ekf->dtIMU;
 			lastAccel = _ekf->accel;
 
+			/*
+			 * Prefer the driver integrals, they include every sample and
+			 * coning, as long as they cover this step and none was missed.
+			 */
+			float gyro_dt = _sensor_combined.gyro_integral_dt / 1e6f;
+
+			if (_sensor_combined.gyro_integral_dt != 0 && fabsf(gyro_dt - deltaT) < 0.2f * deltaT) {
+				_ekf->dtIMU = gyro_dt;
+				_ekf->dAngIMU.x = _sensor_combined.gyro_integral_rad[0];
+				_ekf->dAngIMU.y = _sensor_combined.gyro_integral_rad[1];
+				_ekf->dAngIMU.z = _sensor_combined.gyro_integral_rad[2];
+
+				float accel_dt = _sensor_combined.accelerometer_integral_dt / 1e6f;
+
+				if (accel_updated && _sensor_combined.accelerometer_integral_dt != 0 &&
+				    fabsf(accel_dt - gyro_dt) < 0.2f * gyro_dt) {
+					/* scale to the gyro interval the step is taken over */
+					_ekf->dVelIMU.x = _sensor_combined.accelerometer_integral_m_s[0] * gyro_dt / accel_dt;
+					_ekf->dVelIMU.y = _sensor_combined.accelerometer_integral_m_s[1] * gyro_dt / accel_dt;
+					_ekf->dVelIMU.z = _sensor_combined.accelerometer_integral_m_s[2] * gyro_dt / accel_dt;
+
+				} else {
+					_ekf->dVelIMU = _ekf->dVelIMU * (gyro_dt / deltaT);
+				}
+			}
+
+#endif
+
+			/*
+			 * The fast attitude follows every sample and goes out right away,
+			 * before the filter runs.
+			 */
+			if (_parameters.fast_att_tc > 0.0f && _fast_att_valid) {
+				/* the gyro bias states are per filter step */
+				float bias_scale = _ekf->dtIMU / _ekf->dtIMUfilt;
+				_fast_att.predict(_ekf->dAngIMU - Vector3f(_ekf->states[10], _ekf->states[11], _ekf->states[12]) * bias_scale);
+				publish_attitude(_fast_att.q);
+			}
+
+			/*
+			 * With a filter rate set, pre-integrate the IMU samples and only
+			 * go on once a full package is there. The other sensors stay
+			 * pending until then.
+			 */
+			if (_parameters.imu_rate > 0) {
+				if (!_imu_preint.update(_ekf->dAngIMU, _ekf->dVelIMU, _ekf->dtIMU, 1.0f / _parameters.imu_rate)) {
+					continue;
+				}
+
+				_ekf->dAngIMU = _imu_preint.delAng;
+				_ekf->dVelIMU = _imu_preint.delVel;
+				_ekf->dtIMU = _imu_preint.delT;
+			}
+
+#ifdef SENSOR_COMBINED_SUB
 			if (last_mag != _sensor_combined.magnetometer_timestamp) {
 				mag_updated = true;
 				newDataMag = true;
@@ -990,16 +1193,15 @@ FixedwingEstimator::task_main()
 			}
 
 			last_mag = _sensor_combined.magnetometer_timestamp;
-
 #endif
 
 			//warnx("dang: %8.4f %8.4f dvel: %8.4f %8.4f", _ekf->dAngIMU.x, _ekf->dAngIMU.z, _ekf->dVelIMU.x, _ekf->dVelIMU.z);
 
-			bool airspeed_updated;
-			orb_check(_airspeed_sub, &airspeed_updated);
+			/* all other sensors in one go */
+			hrt_abstime baro_last = _baro.timestamp;
+			uint32_t inputs_updated = orb_copy_batch(_input_batch, INPUT_NUM);
 
-			if (airspeed_updated) {
-				orb_copy(ORB_ID(airspeed), _airspeed_sub, &_airspeed);
+			if (inputs_updated & (1 << INPUT_AIRSPEED)) {
 				perf_count(_perf_airspeed);
 
 				_ekf->VtasMeas = _airspeed.true_airspeed_m_s;
@@ -1009,12 +1211,8 @@ FixedwingEstimator::task_main()
 				newAdsData = false;
 			}
 
-			bool gps_updated;
-			orb_check(_gps_sub, &gps_updated);
+			if (inputs_updated & (1 << INPUT_GPS)) {
 
-			if (gps_updated) {
-
-				orb_copy(ORB_ID(vehicle_gps_position), _gps_sub, &_gps);
 				perf_count(_perf_gps);
 
 				if (_gps.fix_type < 3) {
@@ -1074,14 +1272,7 @@ FixedwingEstimator::task_main()
 
 			}
 
-			bool baro_updated;
-			orb_check(_baro_sub, &baro_updated);
-
-			if (baro_updated) {
-
-				hrt_abstime baro_last = _baro.timestamp;
-
-				orb_copy(ORB_ID(sensor_baro0), _baro_sub, &_baro);
+			if (inputs_updated & (1 << INPUT_BARO)) {
 
 				float baro_elapsed = (_baro.timestamp - baro_last) / 1e6f;
 
@@ -1103,7 +1294,7 @@ FixedwingEstimator::task_main()
 			}
 
 #ifndef SENSOR_COMBINED_SUB
-			orb_check(_mag_sub, &mag_updated);
+			mag_updated = (inputs_updated & (1 << INPUT_MAG)) != 0;
 #endif
 
 			if (mag_updated) {
@@ -1113,8 +1304,6 @@ FixedwingEstimator::task_main()
 				perf_count(_perf_mag);
 
 #ifndef SENSOR_COMBINED_SUB
-				orb_copy(ORB_ID(sensor_mag), _mag_sub, &_mag);
-
 				// XXX we compensate the offsets upfront - should be close to zero.
 				// 0.001f
 				_ekf->magData.x = _mag.x;
@@ -1147,11 +1336,9 @@ FixedwingEstimator::task_main()
 				newDataMag = false;
 			}
 
-			orb_check(_distance_sub, &newRangeData);
+			newRangeData = (inputs_updated & (1 << INPUT_RANGE)) != 0;
 
 			if (newRangeData) {
-				orb_copy(ORB_ID(sensor_range_finder), _distance_sub, &_distance);
-
 				if (_distance.valid) {
 					_ekf->rngMea = _distance.distance;
 					_distance_last_valid = _distance.timestamp;
@@ -1248,6 +1435,7 @@ FixedwingEstimator::task_main()
 
 					if (check) {
 						// Let the system re-initialize itself
+						_fast_att_valid = false;
 						continue;
 					}
 
@@ -1263,16 +1451,11 @@ FixedwingEstimator::task_main()
 					_ekf->summedDelVel = _ekf->summedDelVel + _ekf->dVelIMU;
 					dt += _ekf->dtIMU;
 
-					// perform a covariance prediction if the total delta angle has exceeded the limit
-					// or the time limit will be exceeded at the next IMU update
-					if ((dt >= (_ekf->covTimeStepMax - _ekf->dtIMU)) || (_ekf->summedDelAng.length() > _ekf->covDelAngMax)) {
-						_ekf->CovariancePrediction(dt);
-						_ekf->summedDelAng.zero();
-						_ekf->summedDelVel.zero();
-						dt = 0.0f;
-					}
+					// New measurements only recall the delayed states and raise their
+					// fuse flag here. The flags stay set until the measurement has been
+					// fused below, which happens over as many IMU updates as needed.
 
-					// Fuse GPS Measurements
+					// GPS Measurements
 					if (newDataGps && _gps_initialized) {
 						// Convert GPS measurements to Pos NE, hgt and Vel NED
 
@@ -1301,8 +1484,6 @@ FixedwingEstimator::task_main()
 						// recall states stored at time of measurement after adjusting for delays
 						_ekf->RecallStates(_ekf->statesAtVelTime, (IMUmsec - _parameters.vel_delay_ms));
 						_ekf->RecallStates(_ekf->statesAtPosTime, (IMUmsec - _parameters.pos_delay_ms));
-						// run the fusion step
-						_ekf->FuseVelposNED();
 
 					} else if (!_gps_initialized) {
 
@@ -1322,12 +1503,6 @@ FixedwingEstimator::task_main()
 						// recall states stored at time of measurement after adjusting for delays
 						_ekf->RecallStates(_ekf->statesAtVelTime, (IMUmsec - _parameters.vel_delay_ms));
 						_ekf->RecallStates(_ekf->statesAtPosTime, (IMUmsec - _parameters.pos_delay_ms));
-						// run the fusion step
-						_ekf->FuseVelposNED();
-
-					} else {
-						_ekf->fuseVelData = false;
-						_ekf->fusePosData = false;
 					}
 
 					if (newHgtData) {
@@ -1336,35 +1511,61 @@ FixedwingEstimator::task_main()
 						_ekf->fuseHgtData = true;
 						// recall states stored at time of measurement after adjusting for delays
 						_ekf->RecallStates(_ekf->statesAtHgtTime, (IMUmsec - _parameters.height_delay_ms));
-						// run the fusion step
-						_ekf->FuseVelposNED();
-
-					} else {
-						_ekf->fuseHgtData = false;
 					}
 
-					// Fuse Magnetometer Measurements
+					// Magnetometer Measurements, a new sample restarts at the X axis
 					if (newDataMag) {
 						_ekf->fuseMagData = true;
 						_ekf->RecallStates(_ekf->statesAtMagMeasTime, (IMUmsec - _parameters.mag_delay_ms)); // Assume 50 msec avg delay for magnetometer data
 
 						_ekf->magstate.obsIndex = 0;
-						_ekf->FuseMagnetometer();
-						_ekf->FuseMagnetometer();
-						_ekf->FuseMagnetometer();
-
-					} else {
-						_ekf->fuseMagData = false;
 					}
 
-					// Fuse Airspeed Measurements
+					// Airspeed Measurements
 					if (newAdsData && _ekf->VtasMeas > 7.0f) {
 						_ekf->fuseVtasData = true;
 						_ekf->RecallStates(_ekf->statesAtVtasMeasTime, (IMUmsec - _parameters.tas_delay_ms)); // assume 100 msec avg delay for airspeed data
-						_ekf->FuseAirspeed();
+					}
 
-					} else {
+					// Run at most FILTER_STEPS_PER_CYCLE of the expensive steps per
+					// IMU update so they do not all land in the same cycle and delay
+					// the attitude output. Covariance prediction goes first as it
+					// cannot wait, each magnetometer axis is a step of its own.
+					unsigned steps = 0;
+
+					// perform a covariance prediction if the total delta angle has exceeded the limit
+					// or the time limit will be exceeded at the next IMU update
+					if ((dt >= (_ekf->covTimeStepMax - _ekf->dtIMU)) || (_ekf->summedDelAng.length() > _ekf->covDelAngMax)) {
+						_ekf->CovariancePrediction(dt);
+						_ekf->summedDelAng.zero();
+						_ekf->summedDelVel.zero();
+						dt = 0.0f;
+						steps++;
+					}
+
+					// GPS and height share one fusion step
+					if (steps < FILTER_STEPS_PER_CYCLE && (_ekf->fuseVelData || _ekf->fusePosData || _ekf->fuseHgtData)) {
+						_ekf->FuseVelposNED();
+						_ekf->fuseVelData = false;
+						_ekf->fusePosData = false;
+						_ekf->fuseHgtData = false;
+						steps++;
+					}
+
+					if (steps < FILTER_STEPS_PER_CYCLE && _ekf->fuseVtasData) {
+						_ekf->FuseAirspeed();
 						_ekf->fuseVtasData = false;
+						steps++;
+					}
+
+					while (steps < FILTER_STEPS_PER_CYCLE && _ekf->fuseMagData) {
+						_ekf->FuseMagnetometer();
+
+						if (_ekf->magstate.obsIndex >= 3) {
+							_ekf->fuseMagData = false;
+						}
+
+						steps++;
 					}
 
 					if (newRangeData) {
@@ -1376,42 +1577,19 @@ FixedwingEstimator::task_main()
 
 
 					// Output results
-					math::Quaternion q(_ekf->states[0], _ekf->states[1], _ekf->states[2], _ekf->states[3]);
-					math::Matrix<3, 3> R = q.to_dcm();
-					math::Vector<3> euler = R.to_euler();
-
-					for (int i = 0; i < 3; i++) for (int j = 0; j < 3; j++)
-							_att.R[i][j] = R(i, j);
-
-					_att.timestamp = _last_sensor_timestamp;
-					_att.q[0] = _ekf->states[0];
-					_att.q[1] = _ekf->states[1];
-					_att.q[2] = _ekf->states[2];
-					_att.q[3] = _ekf->states[3];
-					_att.q_valid = true;
-					_att.R_valid = true;
-
-					_att.timestamp = _last_sensor_timestamp;
-					_att.roll = euler(0);
-					_att.pitch = euler(1);
-					_att.yaw = euler(2);
-
-					_att.rollspeed = _ekf->angRate.x - _ekf->states[10];
-					_att.pitchspeed = _ekf->angRate.y - _ekf->states[11];
-					_att.yawspeed = _ekf->angRate.z - _ekf->states[12];
-					// gyro offsets
-					_att.rate_offsets[0] = _ekf->states[10];
-					_att.rate_offsets[1] = _ekf->states[11];
-					_att.rate_offsets[2] = _ekf->states[12];
-
-					/* lazily publish the attitude only once available */
-					if (_att_pub > 0) {
-						/* publish the attitude setpoint */
-						orb_publish(ORB_ID(vehicle_attitude), _att_pub, &_att);
+					if (_parameters.fast_att_tc > 0.0f) {
+						// the attitude went out with the IMU sample, only
+						// pull the fast attitude towards the filter
+						if (_fast_att_valid) {
+							_fast_att.correct(&_ekf->states[0], math::constrain(_ekf->dtIMU / _parameters.fast_att_tc, 0.0f, 1.0f));
+
+						} else {
+							_fast_att.reset(&_ekf->states[0]);
+							_fast_att_valid = true;
+						}
 
 					} else {
-						/* advertise and publish */
-						_att_pub = orb_advertise(ORB_ID(vehicle_attitude), &_att);
+						publish_attitude(&_ekf->states[0]);
 					}
 
 					if (_gps_initialized) {
@@ -1542,6 +1720,11 @@ FixedwingEstimator::task_main()
 
 	_task_running = false;
 
+	if (_imu_callback) {
+		orb_unregister_callback(imu_sub);
+		sem_destroy(&_imu_sem);
+	}
+
 	warnx("exiting.\n");
 
 	_estimator_task = -1;
@@ -1549,10 +1732,12 @@ FixedwingEstimator::task_main()
 }
 
 int
-FixedwingEstimator::start()
+FixedwingEstimator::start(bool imu_callback)
 {
 	ASSERT(_estimator_task == -1);
 
+	_imu_callback = imu_callback;
+
 	/* start the task */
 	_estimator_task = task_spawn_cmd("ekf_att_pos_estimator",
 					 SCHED_DEFAULT,
@@ -1646,14 +1831,10 @@ int FixedwingEstimator::trip_nan() {
 		usleep(100000);
 
 		warnx("tripping covariance #1 with NaN values");
-		_ekf->KH[2][2] = nan_val; //  intermediate result used for covariance updates
+		_ekf->HP[5] = nan_val; // intermediate result used for covariance updates
 		usleep(100000);
 
 		warnx("tripping covariance #2 with NaN values");
-		_ekf->KHP[5][5] = nan_val; // intermediate result used for covariance updates
-		usleep(100000);
-
-		warnx("tripping covariance #3 with NaN values");
 		_ekf->P[3][3] = nan_val; // covariance matrix
 		usleep(100000);
 
@@ -1676,10 +1857,25 @@ int FixedwingEstimator::trip_nan() {
 int ekf_att_pos_estimator_main(int argc, char *argv[])
 {
 	if (argc < 1)
-		errx(1, "usage: ekf_att_pos_estimator {start|stop|status|logging}");
+		errx(1, "usage: ekf_att_pos_estimator {start [-c]|stop|status|logging}");
 
 	if (!strcmp(argv[1], "start")) {
 
+		/* -c: run on every IMU publication through a topic callback instead of poll() */
+		bool imu_callback = false;
+		int ch;
+
+		while ((ch = getopt(argc - 1, argv + 1, "c")) != EOF) {
+			switch (ch) {
+			case 'c':
+				imu_callback = true;
+				break;
+
+			default:
+				errx(1, "usage: ekf_att_pos_estimator start [-c]");
+			}
+		}
+
 		if (estimator::g_estimator != nullptr)
 			errx(1, "already running");
 
@@ -1688,7 +1884,7 @@ int ekf_att_pos_estimator_main(int argc, char *argv[])
 		if (estimator::g_estimator == nullptr)
 			errx(1, "alloc failed");
 
-		if (OK != estimator::g_estimator->start()) {
+		if (OK != estimator::g_estimator->start(imu_callback)) {
 			delete estimator::g_estimator;
 			estimator::g_estimator = nullptr;
 			err(1, "start failed");
@@ -269,3 +269,32 @@ PARAM_DEFINE_FLOAT(PE_MAGB_PNOISE, 0.0003f);
  * @group Position Estimator
  */
 PARAM_DEFINE_FLOAT(PE_POSDEV_INIT, 5.0f);
+
+/**
+ * Filter prediction rate
+ *
+ * The rate in Hz IMU samples are pre-integrated to, with coning and sculling
+ * corrections, before the filter runs its strapdown and covariance
+ * prediction. This bounds the filter load for high rate sensors.
+ * Set to 0 to run the filter on every sample.
+ *
+ * @min 0
+ * @max 1000
+ * @group Position Estimator
+ */
+PARAM_DEFINE_INT32(PE_IMU_RATE, 0);
+
+/**
+ * Fast attitude time constant
+ *
+ * If set, vehicle_attitude is published from a gyro propagated attitude
+ * with every IMU sample, ahead of the filter, and the filter pulls that
+ * attitude towards its own with this time constant in seconds. This keeps
+ * the attitude latency low when the filter runs at a lower rate, see
+ * PE_IMU_RATE. Set to 0 to publish the filter attitude directly.
+ *
+ * @min 0.0
+ * @max 10.0
+ * @group Position Estimator
+ */
+PARAM_DEFINE_FLOAT(PE_FAST_ATT_TC, 0.0f);
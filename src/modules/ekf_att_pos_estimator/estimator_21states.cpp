@@ -1012,7 +1012,8 @@ void AttPosEKF::FuseVelposNED()
 
 void AttPosEKF::FuseMagnetometer()
 {
-    uint8_t obsIndex;
+    // the axis fused next, kept over the calls of one sequence
+    static uint8_t obsIndex = 0;
     uint8_t indexLimit;
     float DCM[3][3] =
     {
@@ -115,13 +115,12 @@ public:
 
 
     // Global variables
-    float KH[n_states][n_states]; //  intermediate result used for covariance updates
-    float KHP[n_states][n_states]; // intermediate result used for covariance updates
+    float HP[n_states]; // H*P of the observation being fused, shared by all covariance updates
     float P[n_states][n_states]; // covariance matrix
     float Kfusion[n_states]; // Kalman gains
     float states[n_states]; // state matrix
     float resetStates[n_states];
-    float storedStates[n_states][data_buffer_size]; // state vectors stored for the last 50 time steps
+    float storedStates[data_buffer_size][n_states]; // ring buffer of the state vectors of the last 50 time steps, oldest first from storeIndex
     uint32_t statetimeStamp[data_buffer_size]; // time stamp for each state vector stored
 
     // Times
@@ -230,7 +229,8 @@ public:
 
     bool numericalProtection;
 
-    unsigned storeIndex;
+    unsigned storeIndex; // next slot to be written in storedStates
+    unsigned storeCount; // number of valid slots in storedStates
 
     // Optical Flow error estimation
     float storedOmega[3][data_buffer_size]; // angular rate vector stored for the last 50 time steps used by optical flow eror estimators
@@ -273,6 +273,19 @@ void FuseOptFlow();
 
 void GroundEKF();
 
+/**
+ * Covariance update P = (I - K*H)*P of a scalar observation
+ *
+ * Applied as the rank-1 update P = P - K*(H*P), using only the
+ * non-zero elements of H and the Kalman gains in Kfusion.
+ *
+ * @param Hval the non-zero elements of H
+ * @param Hidx the state index of each element in Hval
+ * @param Hnum the number of non-zero elements
+ * @param indexLimit the highest state index to update
+ */
+void UpdateCovariance(const float *Hval, const uint8_t *Hidx, uint8_t Hnum, uint8_t indexLimit);
+
 void zeroRows(float (&covMat)[n_states][n_states], uint8_t first, uint8_t last);
 
 void zeroCols(float (&covMat)[n_states][n_states], uint8_t first, uint8_t last);
@@ -285,7 +298,8 @@ void StoreStates(uint64_t timestamp_ms);
 /**
  * Recall the state vector.
  *
- * Recalls the vector stored at closest time to the one specified by msec
+ * Recalls the vector stored at closest time to the one specified by msec.
+ * The history is kept in time order, so this is a binary search.
  *
  * @return zero on success, integer indicating the number of invalid states on failure.
  *         Does only copy valid states, if the statesForFusion vector was initialized
@@ -75,6 +75,131 @@ Mat3f Mat3f::transpose(void) const
     return ret;
 }
 
+ImuPreintegrator::ImuPreintegrator() :
+    delAng(),
+    delVel(),
+    delT(0.0f),
+    _alpha(),
+    _beta(),
+    _vel(),
+    _scul(),
+    _lastDelAng(),
+    _lastDelVel(),
+    _dt(0.0f)
+{
+}
+
+void ImuPreintegrator::reset()
+{
+    _alpha.zero();
+    _beta.zero();
+    _vel.zero();
+    _scul.zero();
+    _lastDelAng.zero();
+    _lastDelVel.zero();
+    _dt = 0.0f;
+}
+
+bool ImuPreintegrator::update(const Vector3f &dAng, const Vector3f &dVel, float dt, float period)
+{
+    // Coning and sculling corrections, second order in the sample deltas
+    // (Savage, Strapdown Inertial Navigation Integration Algorithm Design)
+    Vector3f alphaMid = _alpha + _lastDelAng * (1.0f / 6.0f);
+    Vector3f velMid = _vel + _lastDelVel * (1.0f / 6.0f);
+
+    _beta = _beta + 0.5f * (alphaMid % dAng);
+    _scul = _scul + 0.5f * ((alphaMid % dVel) + (velMid % dAng));
+
+    _alpha = _alpha + dAng;
+    _vel = _vel + dVel;
+    _lastDelAng = dAng;
+    _lastDelVel = dVel;
+    _dt += dt;
+
+    // Hand over as soon as the next sample would overshoot the period more
+    // than this one falls short of it
+    if (_dt + 0.5f * dt < period) {
+        return false;
+    }
+
+    delAng = _alpha + _beta;
+    // rotate the summed delta velocity back to the start of the package
+    delVel = _vel + 0.5f * (_alpha % _vel) + _scul;
+    delT = _dt;
+
+    // the sample history carries over into the next package
+    _alpha.zero();
+    _beta.zero();
+    _vel.zero();
+    _scul.zero();
+    _dt = 0.0f;
+
+    return true;
+}
+
+FastAttitude::FastAttitude() :
+    q{1.0f, 0.0f, 0.0f, 0.0f}
+{
+}
+
+void FastAttitude::reset(const float qIn[4])
+{
+    for (unsigned i = 0; i < 4; i++) {
+        q[i] = qIn[i];
+    }
+}
+
+void FastAttitude::predict(const Vector3f &dAng)
+{
+    float rotationMag = dAng.length();
+    float dq[4];
+
+    if (rotationMag < 1e-12f) {
+        dq[0] = 1.0f;
+        dq[1] = 0.0f;
+        dq[2] = 0.0f;
+        dq[3] = 0.0f;
+    } else {
+        float rotScaler = sinf(0.5f * rotationMag) / rotationMag;
+        dq[0] = cosf(0.5f * rotationMag);
+        dq[1] = dAng.x * rotScaler;
+        dq[2] = dAng.y * rotScaler;
+        dq[3] = dAng.z * rotScaler;
+    }
+
+    // q = q * dq, the delta angle is about the body axes
+    float qUpdated[4];
+    qUpdated[0] = q[0]*dq[0] - q[1]*dq[1] - q[2]*dq[2] - q[3]*dq[3];
+    qUpdated[1] = q[0]*dq[1] + q[1]*dq[0] + q[2]*dq[3] - q[3]*dq[2];
+    qUpdated[2] = q[0]*dq[2] + q[2]*dq[0] + q[3]*dq[1] - q[1]*dq[3];
+    qUpdated[3] = q[0]*dq[3] + q[3]*dq[0] + q[1]*dq[2] - q[2]*dq[1];
+
+    float quatMag = sqrtf(qUpdated[0]*qUpdated[0] + qUpdated[1]*qUpdated[1] + qUpdated[2]*qUpdated[2] + qUpdated[3]*qUpdated[3]);
+
+    if (quatMag > 1e-16f) {
+        float quatMagInv = 1.0f / quatMag;
+
+        for (unsigned i = 0; i < 4; i++) {
+            q[i] = qUpdated[i] * quatMagInv;
+        }
+    }
+}
+
+void FastAttitude::correct(const float qRef[4], float gain)
+{
+    // error rotation in the body frame, qErr = conj(q) * qRef
+    float qErr[4];
+    qErr[0] = q[0]*qRef[0] + q[1]*qRef[1] + q[2]*qRef[2] + q[3]*qRef[3];
+    qErr[1] = q[0]*qRef[1] - q[1]*qRef[0] - q[2]*qRef[3] + q[3]*qRef[2];
+    qErr[2] = q[0]*qRef[2] - q[2]*qRef[0] - q[3]*qRef[1] + q[1]*qRef[3];
+    qErr[3] = q[0]*qRef[3] - q[3]*qRef[0] - q[1]*qRef[2] + q[2]*qRef[1];
+
+    // take the short way round
+    float scaler = (qErr[0] < 0.0f) ? -2.0f * gain : 2.0f * gain;
+
+    predict(Vector3f(qErr[1] * scaler, qErr[2] * scaler, qErr[3] * scaler));
+}
+
 // overload + operator to provide a vector addition
 Vector3f operator+( Vector3f vecIn1, Vector3f vecIn2)
 {
@@ -53,6 +53,88 @@ Vector3f operator*(Vector3f vecIn1, float sclIn1);
 
 void swap_var(float &d1, float &d2);
 
+/**
+ * Pre-integration of high rate IMU samples
+ *
+ * Sums the delta angles and velocities of consecutive IMU samples into
+ * one package for the filter, with coning and sculling corrections, so
+ * the strapdown and covariance prediction can run at a lower rate than
+ * the sensors.
+ */
+class ImuPreintegrator
+{
+public:
+    ImuPreintegrator();
+
+    /**
+     * Start a new package and forget the sample history.
+     */
+    void reset();
+
+    /**
+     * Add one IMU sample.
+     *
+     * @param dAng delta angle of the sample (rad)
+     * @param dVel delta velocity of the sample (m/s)
+     * @param dt length of the sample (s)
+     * @param period package length to integrate to (s)
+     * @return true once the package is complete, it is then
+     *         available in delAng, delVel and delT until the
+     *         next call.
+     */
+    bool update(const Vector3f &dAng, const Vector3f &dVel, float dt, float period);
+
+    Vector3f delAng; ///< delta angle of the last complete package (rad)
+    Vector3f delVel; ///< delta velocity of the last complete package, in the body frame at its start (m/s)
+    float delT; ///< length of the last complete package (s)
+
+private:
+    Vector3f _alpha; ///< sum of the delta angles
+    Vector3f _beta; ///< coning correction
+    Vector3f _vel; ///< sum of the delta velocities
+    Vector3f _scul; ///< sculling correction
+    Vector3f _lastDelAng; ///< previous sample delta angle
+    Vector3f _lastDelVel; ///< previous sample delta velocity
+    float _dt; ///< time integrated so far
+};
+
+/**
+ * Gyro propagated attitude that follows the filter
+ *
+ * Costs one quaternion update per IMU sample, so the attitude can be
+ * output with every sample while the filter corrects it at its own,
+ * lower rate.
+ */
+class FastAttitude
+{
+public:
+    FastAttitude();
+
+    /**
+     * Set the attitude.
+     *
+     * @param qIn quaternion to start from
+     */
+    void reset(const float qIn[4]);
+
+    /**
+     * Rotate by one bias corrected IMU delta angle.
+     *
+     * @param dAng delta angle about the body axes (rad)
+     */
+    void predict(const Vector3f &dAng);
+
+    /**
+     * Move part of the way towards a reference attitude.
+     *
+     * @param qRef the reference attitude, usually the filter states
+     * @param gain fraction of the error to remove, 0 to 1
+     */
+    void correct(const float qRef[4], float gain);
+
+    float q[4]; ///< attitude quaternion, body to NED
+};
+
 enum GPS_FIX {
     GPS_FIX_NOFIX = 0,
     GPS_FIX_2D = 2,
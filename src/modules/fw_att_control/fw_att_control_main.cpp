@@ -69,6 +69,7 @@
 #include <systemlib/pid/pid.h>
 #include <geo/geo.h>
 #include <systemlib/perf_counter.h>
+#include <systemlib/deadline.h>
 #include <systemlib/systemlib.h>
 #include <mathlib/mathlib.h>
 
@@ -76,6 +77,9 @@
 #include <ecl/attitude_fw/ecl_roll_controller.h>
 #include <ecl/attitude_fw/ecl_yaw_controller.h>
 
+#define DEADLINE_PERIOD	50000	/**< longest interval between attitude updates */
+#define DEADLINE_BUDGET	2000	/**< time an iteration may take */
+
 /**
  * Fixedwing attitude control app start / stop handling function
  *
@@ -144,13 +148,14 @@ private:
 	struct vehicle_status_s				_vehicle_status;	/**< vehicle status */
 
 	perf_counter_t	_loop_perf;			/**< loop performance counter */
+	deadline_t	_deadline;			/**< overrun monitor of the controller */
 	perf_counter_t	_nonfinite_input_perf;		/**< performance counter for non finite input */
 	perf_counter_t	_nonfinite_output_perf;		/**< performance counter for non finite output */
 
 	bool		_setpoint_valid;		/**< flag if the position control setpoint is valid */
 	bool		_debug;				/**< if set to true, print debug output */
 
-	struct {
+	struct Parameters {
 		float tconst;
 		float p_p;
 		float p_d;
@@ -191,44 +196,7 @@ private:
 
 	}		_parameters;			/**< local copies of interesting parameters */
 
-	struct {
-
-		param_t tconst;
-		param_t p_p;
-		param_t p_d;
-		param_t p_i;
-		param_t p_ff;
-		param_t p_rmax_pos;
-		param_t p_rmax_neg;
-		param_t p_integrator_max;
-		param_t p_roll_feedforward;
-		param_t r_p;
-		param_t r_d;
-		param_t r_i;
-		param_t r_ff;
-		param_t r_integrator_max;
-		param_t r_rmax;
-		param_t y_p;
-		param_t y_i;
-		param_t y_d;
-		param_t y_ff;
-		param_t y_roll_feedforward;
-		param_t y_integrator_max;
-		param_t y_coordinated_min_speed;
-		param_t y_rmax;
-
-		param_t airspeed_min;
-		param_t airspeed_trim;
-		param_t airspeed_max;
-
-		param_t trim_roll;
-		param_t trim_pitch;
-		param_t trim_yaw;
-		param_t rollsp_offset_deg;
-		param_t pitchsp_offset_deg;
-		param_t man_roll_max;
-		param_t man_pitch_max;
-	}		_parameter_handles;		/**< handles for interesting parameters */
+	struct param_group_s	_param_group;		/**< parameters read into _parameters */
 
 
 	ECL_RollController				_roll_ctrl;
@@ -331,6 +299,7 @@ FixedwingAttitudeControl::FixedwingAttitudeControl() :
 
 /* performance counters */
 	_loop_perf(perf_alloc(PC_ELAPSED, "fw att control")),
+	_deadline(deadline_alloc("fw_att_control", DEADLINE_PERIOD, DEADLINE_BUDGET)),
 	_nonfinite_input_perf(perf_alloc(PC_COUNT, "fw att control nonfinite input")),
 	_nonfinite_output_perf(perf_alloc(PC_COUNT, "fw att control nonfinite output")),
 /* states */
@@ -350,41 +319,40 @@ FixedwingAttitudeControl::FixedwingAttitudeControl() :
 	_vehicle_status = {};
 
 
-	_parameter_handles.tconst = param_find("FW_ATT_TC");
-	_parameter_handles.p_p = param_find("FW_PR_P");
-	_parameter_handles.p_i = param_find("FW_PR_I");
-	_parameter_handles.p_ff = param_find("FW_PR_FF");
-	_parameter_handles.p_rmax_pos = param_find("FW_P_RMAX_POS");
-	_parameter_handles.p_rmax_neg = param_find("FW_P_RMAX_NEG");
-	_parameter_handles.p_integrator_max = param_find("FW_PR_IMAX");
-	_parameter_handles.p_roll_feedforward = param_find("FW_P_ROLLFF");
-
-	_parameter_handles.r_p = param_find("FW_RR_P");
-	_parameter_handles.r_i = param_find("FW_RR_I");
-	_parameter_handles.r_ff = param_find("FW_RR_FF");
-	_parameter_handles.r_integrator_max = param_find("FW_RR_IMAX");
-	_parameter_handles.r_rmax = param_find("FW_R_RMAX");
-
-	_parameter_handles.y_p = param_find("FW_YR_P");
-	_parameter_handles.y_i = param_find("FW_YR_I");
-	_parameter_handles.y_ff = param_find("FW_YR_FF");
-	_parameter_handles.y_integrator_max = param_find("FW_YR_IMAX");
-	_parameter_handles.y_rmax = param_find("FW_Y_RMAX");
-
-	_parameter_handles.airspeed_min = param_find("FW_AIRSPD_MIN");
-	_parameter_handles.airspeed_trim = param_find("FW_AIRSPD_TRIM");
-	_parameter_handles.airspeed_max = param_find("FW_AIRSPD_MAX");
-
-	_parameter_handles.y_coordinated_min_speed = param_find("FW_YCO_VMIN");
-
-	_parameter_handles.trim_roll = param_find("TRIM_ROLL");
-	_parameter_handles.trim_pitch = param_find("TRIM_PITCH");
-	_parameter_handles.trim_yaw = param_find("TRIM_YAW");
-	_parameter_handles.rollsp_offset_deg = param_find("FW_RSP_OFF");
-	_parameter_handles.pitchsp_offset_deg = param_find("FW_PSP_OFF");
-
-	_parameter_handles.man_roll_max = param_find("FW_MAN_R_MAX");
-	_parameter_handles.man_pitch_max = param_find("FW_MAN_P_MAX");
+	/* parameters read as one snapshot into _parameters */
+	static const struct param_group_item_s param_items[] = {
+		PARAM_GROUP_ITEM(Parameters, tconst, "FW_ATT_TC"),
+		PARAM_GROUP_ITEM(Parameters, p_p, "FW_PR_P"),
+		PARAM_GROUP_ITEM(Parameters, p_i, "FW_PR_I"),
+		PARAM_GROUP_ITEM(Parameters, p_ff, "FW_PR_FF"),
+		PARAM_GROUP_ITEM(Parameters, p_rmax_pos, "FW_P_RMAX_POS"),
+		PARAM_GROUP_ITEM(Parameters, p_rmax_neg, "FW_P_RMAX_NEG"),
+		PARAM_GROUP_ITEM(Parameters, p_integrator_max, "FW_PR_IMAX"),
+		PARAM_GROUP_ITEM(Parameters, p_roll_feedforward, "FW_P_ROLLFF"),
+		PARAM_GROUP_ITEM(Parameters, r_p, "FW_RR_P"),
+		PARAM_GROUP_ITEM(Parameters, r_i, "FW_RR_I"),
+		PARAM_GROUP_ITEM(Parameters, r_ff, "FW_RR_FF"),
+		PARAM_GROUP_ITEM(Parameters, r_integrator_max, "FW_RR_IMAX"),
+		PARAM_GROUP_ITEM(Parameters, r_rmax, "FW_R_RMAX"),
+		PARAM_GROUP_ITEM(Parameters, y_p, "FW_YR_P"),
+		PARAM_GROUP_ITEM(Parameters, y_i, "FW_YR_I"),
+		PARAM_GROUP_ITEM(Parameters, y_ff, "FW_YR_FF"),
+		PARAM_GROUP_ITEM(Parameters, y_integrator_max, "FW_YR_IMAX"),
+		PARAM_GROUP_ITEM(Parameters, y_rmax, "FW_Y_RMAX"),
+		PARAM_GROUP_ITEM(Parameters, airspeed_min, "FW_AIRSPD_MIN"),
+		PARAM_GROUP_ITEM(Parameters, airspeed_trim, "FW_AIRSPD_TRIM"),
+		PARAM_GROUP_ITEM(Parameters, airspeed_max, "FW_AIRSPD_MAX"),
+		PARAM_GROUP_ITEM(Parameters, y_coordinated_min_speed, "FW_YCO_VMIN"),
+		PARAM_GROUP_ITEM(Parameters, trim_roll, "TRIM_ROLL"),
+		PARAM_GROUP_ITEM(Parameters, trim_pitch, "TRIM_PITCH"),
+		PARAM_GROUP_ITEM(Parameters, trim_yaw, "TRIM_YAW"),
+		PARAM_GROUP_ITEM(Parameters, rollsp_offset_deg, "FW_RSP_OFF"),
+		PARAM_GROUP_ITEM(Parameters, pitchsp_offset_deg, "FW_PSP_OFF"),
+		PARAM_GROUP_ITEM(Parameters, man_roll_max, "FW_MAN_R_MAX"),
+		PARAM_GROUP_ITEM(Parameters, man_pitch_max, "FW_MAN_P_MAX"),
+	};
+
+	param_group_init(&_param_group, param_items, sizeof(param_items) / sizeof(param_items[0]));
 
 	/* fetch initial parameter values */
 	parameters_update();
@@ -413,9 +381,12 @@ FixedwingAttitudeControl::~FixedwingAttitudeControl()
 	}
 
 	perf_free(_loop_perf);
+	deadline_free(_deadline);
 	perf_free(_nonfinite_input_perf);
 	perf_free(_nonfinite_output_perf);
 
+	param_group_fini(&_param_group);
+
 	att_control::g_control = nullptr;
 }
 
@@ -423,42 +394,11 @@ int
 FixedwingAttitudeControl::parameters_update()
 {
 
-	param_get(_parameter_handles.tconst, &(_parameters.tconst));
-	param_get(_parameter_handles.p_p, &(_parameters.p_p));
-	param_get(_parameter_handles.p_i, &(_parameters.p_i));
-	param_get(_parameter_handles.p_ff, &(_parameters.p_ff));
-	param_get(_parameter_handles.p_rmax_pos, &(_parameters.p_rmax_pos));
-	param_get(_parameter_handles.p_rmax_neg, &(_parameters.p_rmax_neg));
-	param_get(_parameter_handles.p_integrator_max, &(_parameters.p_integrator_max));
-	param_get(_parameter_handles.p_roll_feedforward, &(_parameters.p_roll_feedforward));
-
-	param_get(_parameter_handles.r_p, &(_parameters.r_p));
-	param_get(_parameter_handles.r_i, &(_parameters.r_i));
-	param_get(_parameter_handles.r_ff, &(_parameters.r_ff));
-
-	param_get(_parameter_handles.r_integrator_max, &(_parameters.r_integrator_max));
-	param_get(_parameter_handles.r_rmax, &(_parameters.r_rmax));
-
-	param_get(_parameter_handles.y_p, &(_parameters.y_p));
-	param_get(_parameter_handles.y_i, &(_parameters.y_i));
-	param_get(_parameter_handles.y_ff, &(_parameters.y_ff));
-	param_get(_parameter_handles.y_integrator_max, &(_parameters.y_integrator_max));
-	param_get(_parameter_handles.y_coordinated_min_speed, &(_parameters.y_coordinated_min_speed));
-	param_get(_parameter_handles.y_rmax, &(_parameters.y_rmax));
-
-	param_get(_parameter_handles.airspeed_min, &(_parameters.airspeed_min));
-	param_get(_parameter_handles.airspeed_trim, &(_parameters.airspeed_trim));
-	param_get(_parameter_handles.airspeed_max, &(_parameters.airspeed_max));
-
-	param_get(_parameter_handles.trim_roll, &(_parameters.trim_roll));
-	param_get(_parameter_handles.trim_pitch, &(_parameters.trim_pitch));
-	param_get(_parameter_handles.trim_yaw, &(_parameters.trim_yaw));
-	param_get(_parameter_handles.rollsp_offset_deg, &(_parameters.rollsp_offset_deg));
-	param_get(_parameter_handles.pitchsp_offset_deg, &(_parameters.pitchsp_offset_deg));
+	/* take all values at once so that a change in between cannot mix old and new gains */
+	param_group_get(&_param_group, &_parameters);
+
 	_parameters.rollsp_offset_rad = math::radians(_parameters.rollsp_offset_deg);
 	_parameters.pitchsp_offset_rad = math::radians(_parameters.pitchsp_offset_deg);
-	param_get(_parameter_handles.man_roll_max, &(_parameters.man_roll_max));
-	param_get(_parameter_handles.man_pitch_max, &(_parameters.man_pitch_max));
 	_parameters.man_roll_max = math::radians(_parameters.man_roll_max);
 	_parameters.man_pitch_max = math::radians(_parameters.man_pitch_max);
 
@@ -472,6 +412,7 @@ FixedwingAttitudeControl::parameters_update()
 	_pitch_ctrl.set_max_rate_pos(math::radians(_parameters.p_rmax_pos));
 	_pitch_ctrl.set_max_rate_neg(math::radians(_parameters.p_rmax_neg));
 	_pitch_ctrl.set_roll_ff(_parameters.p_roll_feedforward);
+	_pitch_ctrl.set_airspeeds(_parameters.airspeed_min, _parameters.airspeed_trim, _parameters.airspeed_max);
 
 	/* roll control parameters */
 	_roll_ctrl.set_time_constant(_parameters.tconst);
@@ -480,6 +421,7 @@ FixedwingAttitudeControl::parameters_update()
 	_roll_ctrl.set_k_ff(_parameters.r_ff);
 	_roll_ctrl.set_integrator_max(_parameters.r_integrator_max);
 	_roll_ctrl.set_max_rate(math::radians(_parameters.r_rmax));
+	_roll_ctrl.set_airspeeds(_parameters.airspeed_min, _parameters.airspeed_trim, _parameters.airspeed_max);
 
 	/* yaw control parameters */
 	_yaw_ctrl.set_k_p(_parameters.y_p);
@@ -488,6 +430,7 @@ FixedwingAttitudeControl::parameters_update()
 	_yaw_ctrl.set_integrator_max(_parameters.y_integrator_max);
 	_yaw_ctrl.set_coordinated_min_speed(_parameters.y_coordinated_min_speed);
 	_yaw_ctrl.set_max_rate(math::radians(_parameters.y_rmax));
+	_yaw_ctrl.set_airspeeds(_parameters.airspeed_min, _parameters.airspeed_trim, _parameters.airspeed_max);
 
 	return OK;
 }
@@ -541,7 +484,7 @@ FixedwingAttitudeControl::vehicle_accel_poll()
 	orb_check(_accel_sub, &accel_updated);
 
 	if (accel_updated) {
-		orb_copy(ORB_ID(sensor_accel0), _accel_sub, &_accel);
+		orb_copy(ORB_ID(sensor_accel), _accel_sub, &_accel);
 	}
 }
 
@@ -601,7 +544,7 @@ FixedwingAttitudeControl::task_main()
 	 */
 	_att_sp_sub = orb_subscribe(ORB_ID(vehicle_attitude_setpoint));
 	_att_sub = orb_subscribe(ORB_ID(vehicle_attitude));
-	_accel_sub = orb_subscribe(ORB_ID(sensor_accel0));
+	_accel_sub = orb_subscribe(ORB_ID(sensor_accel));
 	_airspeed_sub = orb_subscribe(ORB_ID(airspeed));
 	_vcontrol_mode_sub = orb_subscribe(ORB_ID(vehicle_control_mode));
 	_params_sub = orb_subscribe(ORB_ID(parameter_update));
@@ -667,6 +610,7 @@ FixedwingAttitudeControl::task_main()
 		/* only run controller if attitude changed */
 		if (fds[1].revents & POLLIN) {
 
+			deadline_begin(_deadline);
 
 			static uint64_t last_run = 0;
 			float deltaT = (hrt_absolute_time() - last_run) / 1000000.0f;
@@ -733,15 +677,13 @@ FixedwingAttitudeControl::task_main()
 				}
 
 				/*
-				 * For scaling our actuators using anything less than the min (close to stall)
-				 * speed doesn't make any sense - its the strongest reasonable deflection we
-				 * want to do in flight and its the baseline a human pilot would choose.
-				 *
-				 * Forcing the scaling to this value allows reasonable handheld tests.
+				 * The rate controllers schedule their gains between min and max
+				 * airspeed. For scaling our actuators using anything less than the min
+				 * (close to stall) speed doesn't make any sense - its the strongest
+				 * reasonable deflection we want to do in flight and its the baseline a
+				 * human pilot would choose. This allows reasonable handheld tests.
 				 */
 
-				float airspeed_scaling = _parameters.airspeed_trim / ((airspeed < _parameters.airspeed_min) ? _parameters.airspeed_min : airspeed);
-
 				float roll_sp = _parameters.rollsp_offset_rad;
 				float pitch_sp = _parameters.pitchsp_offset_rad;
 				float throttle_sp = 0.0f;
@@ -845,7 +787,7 @@ FixedwingAttitudeControl::task_main()
 					float roll_u = _roll_ctrl.control_bodyrate(_att.pitch,
 							_att.rollspeed, _att.yawspeed,
 							_yaw_ctrl.get_desired_rate(),
-							_parameters.airspeed_min, _parameters.airspeed_max, airspeed, airspeed_scaling, lock_integrator);
+							airspeed, lock_integrator);
 					_actuators.control[0] = (isfinite(roll_u)) ? roll_u + _parameters.trim_roll : _parameters.trim_roll;
 					if (!isfinite(roll_u)) {
 						_roll_ctrl.reset_integrator();
@@ -859,20 +801,20 @@ FixedwingAttitudeControl::task_main()
 					float pitch_u = _pitch_ctrl.control_bodyrate(_att.roll, _att.pitch,
 							_att.pitchspeed, _att.yawspeed,
 							_yaw_ctrl.get_desired_rate(),
-							_parameters.airspeed_min, _parameters.airspeed_max, airspeed, airspeed_scaling, lock_integrator);
+							airspeed, lock_integrator);
 					_actuators.control[1] = (isfinite(pitch_u)) ? pitch_u + _parameters.trim_pitch : _parameters.trim_pitch;
 					if (!isfinite(pitch_u)) {
 						_pitch_ctrl.reset_integrator();
 						perf_count(_nonfinite_output_perf);
 						if (_debug && loop_counter % 10 == 0) {
 							warnx("pitch_u %.4f, _yaw_ctrl.get_desired_rate() %.4f,"
-								" airspeed %.4f, airspeed_scaling %.4f,"
+								" airspeed %.4f,"
 								" roll_sp %.4f, pitch_sp %.4f,"
 								" _roll_ctrl.get_desired_rate() %.4f,"
 								" _pitch_ctrl.get_desired_rate() %.4f"
 								" att_sp.roll_body %.4f",
 								(double)pitch_u, (double)_yaw_ctrl.get_desired_rate(),
-								(double)airspeed, (double)airspeed_scaling,
+								(double)airspeed,
 								(double)roll_sp, (double)pitch_sp,
 								(double)_roll_ctrl.get_desired_rate(),
 								(double)_pitch_ctrl.get_desired_rate(),
@@ -883,7 +825,7 @@ FixedwingAttitudeControl::task_main()
 					float yaw_u = _yaw_ctrl.control_bodyrate(_att.roll, _att.pitch,
 							_att.pitchspeed, _att.yawspeed,
 							_pitch_ctrl.get_desired_rate(),
-							_parameters.airspeed_min, _parameters.airspeed_max, airspeed, airspeed_scaling, lock_integrator);
+							airspeed, lock_integrator);
 					_actuators.control[2] = (isfinite(yaw_u)) ? yaw_u + _parameters.trim_yaw : _parameters.trim_yaw;
 					if (!isfinite(yaw_u)) {
 						_yaw_ctrl.reset_integrator();
@@ -946,6 +888,8 @@ FixedwingAttitudeControl::task_main()
 
 			/* lazily publish the setpoint only once available */
 			_actuators.timestamp = hrt_absolute_time();
+			_actuators.timestamp_sample = _att.timestamp;
+			_actuators.timestamp_attitude = last_run;
 			_actuators_airframe.timestamp = hrt_absolute_time();
 
 			if (_actuators_0_pub > 0) {
@@ -970,6 +914,7 @@ FixedwingAttitudeControl::task_main()
 				_actuators_1_pub = orb_advertise(ORB_ID(actuator_controls_1), &_actuators_airframe);
 			}
 
+			deadline_end(_deadline);
 		}
 
 		loop_counter++;
@@ -192,7 +192,14 @@ private:
 	uint64_t _airspeed_last_valid;			///< last time airspeed was valid. Used to detect sensor failures
 	float _groundspeed_undershoot;			///< ground speed error to min. speed in m/s
 	bool _global_pos_valid;				///< global position is valid
-	math::Matrix<3, 3> _R_nb;			///< current attitude
+
+	struct {
+		TECS::flight_state tecs;		///< attitude and acceleration shared with TECS
+		math::Vector<3> ground_speed;		///< NED ground speed
+		math::Vector<2> ground_speed_2d;	///< horizontal ground speed
+		math::Vector<2> yaw_vector;		///< unit vector of the nose direction on the ground
+		float flight_path_angle;		///< angle of the ground speed vector above the horizon
+	} _flight;					///< flight state of the current control cycle
 
 	ECL_L1_Pos_Controller				_l1_control;
 	TECS						_tecs;
@@ -336,6 +343,12 @@ private:
 	 */
 	void		vehicle_setpoint_poll();
 
+	/**
+	 * Compute the flight state of this cycle from the latest attitude,
+	 * sensor, airspeed and position data.
+	 */
+	void		update_flight_state();
+
 	/**
 	 * Publish navigation capabilities
 	 */
@@ -349,7 +362,7 @@ private:
 	/**
 	 * Control position.
 	 */
-	bool		control_position(const math::Vector<2> &global_pos, const math::Vector<3> &ground_speed,
+	bool		control_position(const math::Vector<2> &global_pos,
 					 const struct position_setpoint_triplet_s &_pos_sp_triplet);
 
 	float calculate_target_airspeed(float airspeed_demand);
@@ -379,12 +392,11 @@ private:
 	 * Call TECS : a wrapper function to call one of the TECS implementations (mTECS is called only if enabled via parameter)
 	 * XXX need to clean up/remove this function once mtecs fully replaces TECS
 	 */
-	void tecs_update_pitch_throttle(float alt_sp, float v_sp, float eas2tas,
+	void tecs_update_pitch_throttle(float alt_sp, float v_sp,
 			float pitch_min_rad, float pitch_max_rad,
 			float throttle_min, float throttle_max, float throttle_cruise,
 			bool climbout_mode, float climbout_pitch_min_rad,
 			float altitude,
-			const math::Vector<3> &ground_speed,
 			tecs_mode mode = TECS_MODE_NORMAL,
 			bool pitch_max_special = false);
 
@@ -456,6 +468,7 @@ FixedwingPositionControl::FixedwingPositionControl() :
 	_airspeed_last_valid(0),
 	_groundspeed_undershoot(0.0f),
 	_global_pos_valid(false),
+	_flight(),
 	_l1_control(),
 	_mTecs(),
 	_was_pos_control_mode(false)
@@ -701,10 +714,6 @@ FixedwingPositionControl::vehicle_attitude_poll()
 
 	if (att_updated) {
 		orb_copy(ORB_ID(vehicle_attitude), _att_sub, &_att);
-
-		/* set rotation matrix */
-		for (int i = 0; i < 3; i++) for (int j = 0; j < 3; j++)
-				_R_nb(i, j) = _att.R[i][j];
 	}
 }
 
@@ -779,16 +788,48 @@ FixedwingPositionControl::calculate_target_airspeed(float airspeed_demand)
 	return target_airspeed;
 }
 
+void
+FixedwingPositionControl::update_flight_state()
+{
+	TECS::flight_state &s = _flight.tecs;
+
+	for (int i = 0; i < 3; i++) for (int j = 0; j < 3; j++)
+			s.R(i, j) = _att.R[i][j];
+
+	s.pitch = _att.pitch;
+	s.sin_pitch = -s.R(2, 0);
+	s.cos_phi = sqrtf(s.R(0, 1) * s.R(0, 1) + s.R(1, 1) * s.R(1, 1));
+
+	/* published with the airspeed, not every source provides it */
+	s.EAS2TAS = (_airspeed.eas2tas > 0.0f) ? _airspeed.eas2tas : 1.0f;
+
+	s.accel_body = math::Vector<3>(_sensor_combined.accelerometer_m_s2);
+	s.accel_earth = s.R * s.accel_body;
+
+	_flight.ground_speed = math::Vector<3>(_global_pos.vel_n, _global_pos.vel_e, _global_pos.vel_d);
+	_flight.ground_speed_2d = math::Vector<2>(_global_pos.vel_n, _global_pos.vel_e);
+
+	/* rotate ground speed vector with current attitude */
+	_flight.yaw_vector = math::Vector<2>(s.R(0, 0), s.R(1, 0));
+	_flight.yaw_vector.normalize();
+
+	float ground_speed_length = _flight.ground_speed.length();
+
+	if (ground_speed_length > FLT_EPSILON) {
+		_flight.flight_path_angle = -asinf(_flight.ground_speed(2) / ground_speed_length);
+
+	} else {
+		_flight.flight_path_angle = 0.0f;
+	}
+}
+
 void
 FixedwingPositionControl::calculate_gndspeed_undershoot(const math::Vector<2> &current_position, const math::Vector<2> &ground_speed_2d, const struct position_setpoint_triplet_s &pos_sp_triplet)
 {
 
 	if (pos_sp_triplet.current.valid && !(pos_sp_triplet.current.type == SETPOINT_TYPE_LOITER)) {
 
-		/* rotate ground speed vector with current attitude */
-		math::Vector<2> yaw_vector(_R_nb(0, 0), _R_nb(1, 0));
-		yaw_vector.normalize();
-		float ground_speed_body = yaw_vector * ground_speed_2d;
+		float ground_speed_body = _flight.yaw_vector * ground_speed_2d;
 
 		/* The minimum desired ground speed is the minimum airspeed projected on to the ground using the altitude and horizontal difference between the waypoints if available*/
 		float distance = 0.0f;
@@ -849,22 +890,17 @@ float FixedwingPositionControl::get_terrain_altitude_landing(float land_setpoint
 }
 
 bool
-FixedwingPositionControl::control_position(const math::Vector<2> &current_position, const math::Vector<3> &ground_speed,
+FixedwingPositionControl::control_position(const math::Vector<2> &current_position,
 		const struct position_setpoint_triplet_s &pos_sp_triplet)
 {
 	bool setpoint = true;
 
-	math::Vector<2> ground_speed_2d = {ground_speed(0), ground_speed(1)};
+	const math::Vector<2> &ground_speed_2d = _flight.ground_speed_2d;
 	calculate_gndspeed_undershoot(current_position, ground_speed_2d, pos_sp_triplet);
 
-	float eas2tas = 1.0f; // XXX calculate actual number based on current measurements
-
 	/* filter speed and altitude for controller */
-	math::Vector<3> accel_body(_sensor_combined.accelerometer_m_s2);
-	math::Vector<3> accel_earth = _R_nb * accel_body;
-
 	if (!_mTecs.getEnabled()) {
-		_tecs.update_50hz(_global_pos.alt /* XXX might switch to alt err here */, _airspeed.indicated_airspeed_m_s, _R_nb, accel_body, accel_earth);
+		_tecs.update_50hz(_global_pos.alt /* XXX might switch to alt err here */, _airspeed.indicated_airspeed_m_s, _flight.tecs);
 	}
 
 	/* define altitude error */
@@ -929,10 +965,10 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 			_att_sp.roll_body = _l1_control.nav_roll();
 			_att_sp.yaw_body = _l1_control.nav_bearing();
 
-			tecs_update_pitch_throttle(_pos_sp_triplet.current.alt, calculate_target_airspeed(_parameters.airspeed_trim), eas2tas,
+			tecs_update_pitch_throttle(_pos_sp_triplet.current.alt, calculate_target_airspeed(_parameters.airspeed_trim),
 						math::radians(_parameters.pitch_limit_min), math::radians(_parameters.pitch_limit_max),
 						_parameters.throttle_min, _parameters.throttle_max, _parameters.throttle_cruise,
-						false, math::radians(_parameters.pitch_limit_min), _global_pos.alt, ground_speed);
+						false, math::radians(_parameters.pitch_limit_min), _global_pos.alt);
 
 		} else if (pos_sp_triplet.current.type == SETPOINT_TYPE_LOITER) {
 
@@ -942,10 +978,10 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 			_att_sp.roll_body = _l1_control.nav_roll();
 			_att_sp.yaw_body = _l1_control.nav_bearing();
 
-			tecs_update_pitch_throttle(_pos_sp_triplet.current.alt, calculate_target_airspeed(_parameters.airspeed_trim), eas2tas,
+			tecs_update_pitch_throttle(_pos_sp_triplet.current.alt, calculate_target_airspeed(_parameters.airspeed_trim),
 						math::radians(_parameters.pitch_limit_min), math::radians(_parameters.pitch_limit_max),
 						_parameters.throttle_min, _parameters.throttle_max, _parameters.throttle_cruise,
-						false, math::radians(_parameters.pitch_limit_min), _global_pos.alt, ground_speed);
+						false, math::radians(_parameters.pitch_limit_min), _global_pos.alt);
 
 		} else if (pos_sp_triplet.current.type == SETPOINT_TYPE_LAND) {
 
@@ -1047,12 +1083,12 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 				}
 
 				tecs_update_pitch_throttle(terrain_alt + flare_curve_alt_rel,
-						calculate_target_airspeed(airspeed_land), eas2tas,
+						calculate_target_airspeed(airspeed_land),
 						 math::radians(_parameters.land_flare_pitch_min_deg),
 						 math::radians(_parameters.land_flare_pitch_max_deg),
 						0.0f, throttle_max, throttle_land,
 						false,  land_motor_lim ? math::radians(_parameters.land_flare_pitch_min_deg) : math::radians(_parameters.pitch_limit_min),
-						_global_pos.alt, ground_speed,
+						_global_pos.alt,
 						land_motor_lim ? TECS_MODE_LAND_THROTTLELIM : TECS_MODE_LAND);
 
 				if (!land_noreturn_vertical) {
@@ -1088,7 +1124,7 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 				}
 
 				tecs_update_pitch_throttle(terrain_alt + altitude_desired_rel,
-						calculate_target_airspeed(airspeed_approach), eas2tas,
+						calculate_target_airspeed(airspeed_approach),
 						math::radians(_parameters.pitch_limit_min),
 						math::radians(_parameters.pitch_limit_max),
 						_parameters.throttle_min,
@@ -1096,8 +1132,7 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 						_parameters.throttle_cruise,
 						false,
 						math::radians(_parameters.pitch_limit_min),
-						_global_pos.alt,
-						ground_speed);
+						_global_pos.alt);
 			}
 
 		} else if (pos_sp_triplet.current.type == SETPOINT_TYPE_TAKEOFF) {
@@ -1148,7 +1183,6 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 					/* enforce a minimum of 10 degrees pitch up on takeoff, or take parameter */
 					tecs_update_pitch_throttle(_pos_sp_triplet.current.alt,
 							calculate_target_airspeed(1.3f * _parameters.airspeed_min),
-							eas2tas,
 							math::radians(_parameters.pitch_limit_min),
 							takeoff_pitch_max_rad,
 							_parameters.throttle_min, takeoff_throttle,
@@ -1157,7 +1191,6 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 							math::max(math::radians(pos_sp_triplet.current.pitch_min),
 							math::radians(10.0f)),
 							_global_pos.alt,
-							ground_speed,
 							TECS_MODE_TAKEOFF,
 							takeoff_pitch_max_deg != _parameters.pitch_limit_max);
 
@@ -1168,7 +1201,6 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 				} else {
 					tecs_update_pitch_throttle(_pos_sp_triplet.current.alt,
 							calculate_target_airspeed(_parameters.airspeed_trim),
-							eas2tas,
 								math::radians(_parameters.pitch_limit_min),
 								math::radians(_parameters.pitch_limit_max),
 								_parameters.throttle_min,
@@ -1176,8 +1208,7 @@ FixedwingPositionControl::control_position(const math::Vector<2> &current_positi
 								_parameters.throttle_cruise,
 								false,
 								math::radians(_parameters.pitch_limit_min),
-								_global_pos.alt,
-								ground_speed);
+								_global_pos.alt);
 				}
 			} else {
 				/* Tell the attitude controller to stop integrating while we are waiting
@@ -1352,14 +1383,15 @@ FixedwingPositionControl::task_main()
 			vehicle_airspeed_poll();
 			// vehicle_baro_poll();
 
-			math::Vector<3> ground_speed(_global_pos.vel_n, _global_pos.vel_e,  _global_pos.vel_d);
+			update_flight_state();
+
 			math::Vector<2> current_position((float)_global_pos.lat, (float)_global_pos.lon);
 
 			/*
 			 * Attempt to control position, on success (= sensors present and not in manual mode),
 			 * publish setpoint.
 			 */
-			if (control_position(current_position, ground_speed, _pos_sp_triplet)) {
+			if (control_position(current_position, _pos_sp_triplet)) {
 				_att_sp.timestamp = hrt_absolute_time();
 
 				/* lazily publish the setpoint only once available */
@@ -1416,21 +1448,15 @@ void FixedwingPositionControl::reset_landing_state()
 	land_useterrain = false;
 }
 
-void FixedwingPositionControl::tecs_update_pitch_throttle(float alt_sp, float v_sp, float eas2tas,
+void FixedwingPositionControl::tecs_update_pitch_throttle(float alt_sp, float v_sp,
 		float pitch_min_rad, float pitch_max_rad,
 		float throttle_min, float throttle_max, float throttle_cruise,
 		bool climbout_mode, float climbout_pitch_min_rad,
 		float altitude,
-		const math::Vector<3> &ground_speed,
 		tecs_mode mode, bool pitch_max_special)
 {
 	if (_mTecs.getEnabled()) {
 		/* Using mtecs library: prepare arguments for mtecs call */
-		float flightPathAngle = 0.0f;
-		float ground_speed_length = ground_speed.length();
-		if (ground_speed_length > FLT_EPSILON) {
-			flightPathAngle = -asinf(ground_speed(2)/ground_speed_length);
-		}
 		fwPosctrl::LimitOverride limitOverride;
 		if (_vehicle_status.engine_failure || _vehicle_status.engine_failure_cmd) {
 			/* Force the slow downwards spiral */
@@ -1450,7 +1476,7 @@ void FixedwingPositionControl::tecs_update_pitch_throttle(float alt_sp, float v_
 			/* use pitch max set by MT param */
 			limitOverride.disablePitchMaxOverride();
 		}
-		_mTecs.updateAltitudeSpeed(flightPathAngle, altitude, alt_sp, _airspeed.true_airspeed_m_s, v_sp, mode,
+		_mTecs.updateAltitudeSpeed(_flight.flight_path_angle, altitude, alt_sp, _airspeed.true_airspeed_m_s, v_sp, mode,
 				limitOverride);
 	} else {
 		if (_vehicle_status.engine_failure || _vehicle_status.engine_failure_cmd) {
@@ -1463,8 +1489,8 @@ void FixedwingPositionControl::tecs_update_pitch_throttle(float alt_sp, float v_
 		_tecs.set_detect_underspeed_enabled(!(mode == TECS_MODE_LAND || mode == TECS_MODE_LAND_THROTTLELIM));
 
 		/* Using tecs library */
-		_tecs.update_pitch_throttle(_R_nb, _att.pitch, altitude, alt_sp, v_sp,
-					    _airspeed.indicated_airspeed_m_s, eas2tas,
+		_tecs.update_pitch_throttle(_flight.tecs, altitude, alt_sp, v_sp,
+					    _airspeed.indicated_airspeed_m_s,
 					    climbout_mode, climbout_pitch_min_rad,
 					    throttle_min, throttle_max, throttle_cruise,
 					    pitch_min_rad, pitch_max_rad);
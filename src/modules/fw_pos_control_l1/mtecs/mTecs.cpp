@@ -76,6 +76,8 @@ mTecs::mTecs() :
 	_counter(0),
 	_debug(false)
 {
+	/* the block tree is complete, run updates as flat loops */
+	plan();
 }
 
 mTecs::~mTecs()
@@ -156,6 +158,8 @@ int mTecs::updateFlightPathAngleSpeed(float flightPathAngle, float flightPathAng
 int mTecs::updateFlightPathAngleAcceleration(float flightPathAngle, float flightPathAngleSp, float airspeedFiltered,
 		float accelerationLongitudinalSp, tecs_mode mode, LimitOverride limitOverride)
 {
+	control::BlockPerfScope perf(this);
+
 	/* check if all input arguments are numbers and abort if not so */
 	if (!isfinite(flightPathAngle) || !isfinite(flightPathAngleSp) ||
 			!isfinite(airspeedFiltered) || !isfinite(accelerationLongitudinalSp) || !isfinite(mode)) {
@@ -47,6 +47,7 @@
 #include <stdbool.h>
 #include <nuttx/wqueue.h>
 #include <nuttx/clock.h>
+#include <systemlib/work_profile.h>
 #include <systemlib/systemlib.h>
 #include <systemlib/err.h>
 #include <uORB/uORB.h>
@@ -173,7 +174,7 @@ int gpio_led_main(int argc, char *argv[])
 			memset(&gpio_led_data, 0, sizeof(gpio_led_data));
 			gpio_led_data.use_io = use_io;
 			gpio_led_data.pin = pin;
-			int ret = work_queue(LPWORK, &gpio_led_data.work, gpio_led_start, &gpio_led_data, 0);
+			int ret = work_queue_profiled(LPWORK, &gpio_led_data.work, gpio_led_start, &gpio_led_data, 0, "gpio_led");
 
 			if (ret != 0) {
 				errx(1, "failed to queue work: %d", ret);
@@ -232,7 +233,7 @@ void gpio_led_start(FAR void *arg)
 	priv->vehicle_status_sub = orb_subscribe(ORB_ID(vehicle_status));
 
 	/* add worker to queue */
-	int ret = work_queue(LPWORK, &priv->work, gpio_led_cycle, priv, 0);
+	int ret = work_queue_profiled(LPWORK, &priv->work, gpio_led_cycle, priv, 0, "gpio_led");
 
 	if (ret != 0) {
 		// TODO find way to print errors
@@ -298,7 +299,7 @@ void gpio_led_cycle(FAR void *arg)
 
 	/* repeat cycle at 5 Hz */
 	if (gpio_led_started) {
-		work_queue(LPWORK, &priv->work, gpio_led_cycle, priv, USEC2TICK(200000));
+		work_queue_profiled(LPWORK, &priv->work, gpio_led_cycle, priv, USEC2TICK(200000), "gpio_led");
 
 	} else {
 		/* switch off LED on stop */
@@ -58,6 +58,8 @@ MavlinkFTP::MavlinkFTP() :
 	_request_bufs{},
 	_request_queue{},
 	_request_queue_sem{},
+	_read_ahead{},
+	_session_burst{},
 	_utRcvMsgFunc{},
 	_ftp_test{}
 {
@@ -226,12 +228,31 @@ MavlinkFTP::_process_request(Request *req)
 		errorCode = _workCalcFileCRC32(payload);
 		break;
 
+	case kCmdBurstReadFile:
+		if (!_valid_session(payload->session)) {
+			errorCode = kErrInvalidSession;
+			break;
+		}
+
+		// the request stays with the burst until it is complete, replies are sent by _burstRead
+		_session_burst[payload->session] = req;
+#ifdef MAVLINK_FTP_UNIT_TEST
+		while (_burstRead(req)) {
+		}
+		_return_request(req);
+#else
+		work_queue(LPWORK, &req->work, &MavlinkFTP::_burst_trampoline, req, 0);
+#endif
+		return;
+
 	default:
 		errorCode = kErrUnknownCommand;
 		break;	
 	}
 
 out:
+	payload->burst_complete = 0;
+
 	// handle success vs. error
 	if (errorCode == kErrNone) {
 		payload->req_opcode = payload->opcode;
@@ -259,8 +280,143 @@ out:
 	_return_request(req);
 }
 
-/// @brief Sends the specified FTP reponse message out through mavlink
+/// @brief Queued work queue routine which continues a burst read
 void
+MavlinkFTP::_burst_trampoline(void *arg)
+{
+	Request* req = reinterpret_cast<Request *>(arg);
+	MavlinkFTP* server = MavlinkFTP::get_server();
+
+	if (server->_burstRead(req)) {
+		work_queue(LPWORK, &req->work, &MavlinkFTP::_burst_trampoline, req, USEC2TICK(kBurstIntervalUs));
+
+	} else {
+		server->_return_request(req);
+	}
+}
+
+/// @brief Sends the next chunks of a burst read
+///	@return true if the burst needs another cycle, false when it is complete or was stopped
+bool
+MavlinkFTP::_burstRead(Request *req)
+{
+	PayloadHeader *payload = reinterpret_cast<PayloadHeader *>(&req->message.payload[0]);
+	unsigned session = payload->session;
+
+	if (session >= kMaxSession || _session_burst[session] != req) {
+		// session was terminated
+		return false;
+	}
+
+	for (unsigned i = 0; i < kBurstChunksPerCycle; i++) {
+		int bytes_read = _readAhead(session, payload->offset, &payload->data[0], kMaxDataLength);
+
+		payload->req_opcode = kCmdBurstReadFile;
+
+		if (bytes_read <= 0) {
+			int r_errno = errno;
+			payload->opcode = kRspNak;
+			payload->burst_complete = 1;
+			payload->size = 1;
+			payload->data[0] = (bytes_read == 0) ? kErrEOF : kErrFailErrno;
+
+			if (bytes_read < 0) {
+				payload->size = 2;
+				payload->data[1] = r_errno;
+			}
+
+		} else {
+			payload->opcode = kRspAck;
+			payload->burst_complete = (bytes_read < kMaxDataLength) ? 1 : 0;
+			payload->size = bytes_read;
+		}
+
+		if (!_reply(req)) {
+			// message buffer is full, send the same chunk again next cycle
+			payload->seqNumber--;
+			return true;
+		}
+
+		if (payload->burst_complete) {
+			_session_burst[session] = nullptr;
+			return false;
+		}
+
+		payload->offset += bytes_read;
+	}
+
+	return true;
+}
+
+/// @brief Reads from a session through its read-ahead buffer
+///	@return bytes read, 0 at end of file, -1 with errno set on error
+int
+MavlinkFTP::_readAhead(unsigned session, uint32_t offset, uint8_t *dst, unsigned len)
+{
+	int fd = _session_fds[session];
+	ReadAhead *ra = &_read_ahead[session];
+
+	if (ra->data == nullptr) {
+		if (lseek(fd, offset, SEEK_SET) < 0) {
+			return -1;
+		}
+
+		return ::read(fd, dst, len);
+	}
+
+	bool short_fill = (ra->len < kReadAheadSize);	// buffer ends at end of file
+
+	if (offset < ra->offset || offset >= ra->offset + ra->len ||
+	    (offset + len > ra->offset + ra->len && !short_fill)) {
+		// refill, aligned so the card sees whole sector reads
+		uint32_t start = offset - (offset % kReadAheadAlign);
+
+		if (lseek(fd, start, SEEK_SET) < 0) {
+			return -1;
+		}
+
+		int bytes_read = ::read(fd, ra->data, kReadAheadSize);
+
+		if (bytes_read < 0) {
+			ra->len = 0;
+			return -1;
+		}
+
+		ra->offset = start;
+		ra->len = bytes_read;
+	}
+
+	if (offset >= ra->offset + ra->len) {
+		return 0;
+	}
+
+	unsigned n = ra->offset + ra->len - offset;
+
+	if (n > len) {
+		n = len;
+	}
+
+	memcpy(dst, &ra->data[offset - ra->offset], n);
+
+	return n;
+}
+
+/// @brief Closes a session, stops its burst and frees its read-ahead buffer
+void
+MavlinkFTP::_closeSession(unsigned session)
+{
+	::close(_session_fds[session]);
+	_session_fds[session] = -1;
+	_session_burst[session] = nullptr;
+
+	free(_read_ahead[session].data);
+	_read_ahead[session].data = nullptr;
+	_read_ahead[session].len = 0;
+}
+
+/// @brief Sends the specified FTP reponse message out through mavlink
+///	@return false if the message could not be queued
+bool
 MavlinkFTP::_reply(Request *req)
 {
 	PayloadHeader *payload = reinterpret_cast<PayloadHeader *>(&req->message.payload[0]);
@@ -294,7 +450,7 @@ MavlinkFTP::_reply(Request *req)
 		
 #endif
 
-	if (!success) {
+	if (!success && payload->req_opcode != kCmdBurstReadFile) {
 		warnx("FTP TX ERR");
 	}
 #ifdef MAVLINK_FTP_DEBUG
@@ -306,6 +462,8 @@ MavlinkFTP::_reply(Request *req)
 		      msg.checksum);
 	}
 #endif
+
+	return success;
 }
 
 /// @brief Responds to a List command
@@ -442,6 +600,12 @@ MavlinkFTP::_workOpen(PayloadHeader* payload, int oflag)
 	}
 	_session_fds[session_index] = fd;
 
+	// serve reads of read only sessions in large sequential blocks, plain reads if out of memory
+	if (oflag == O_RDONLY) {
+		_read_ahead[session_index].data = (uint8_t *)malloc(kReadAheadSize);
+		_read_ahead[session_index].len = 0;
+	}
+
 	payload->session = session_index;
 	payload->size = sizeof(uint32_t);
 	*((uint32_t*)payload->data) = fileSize;
@@ -459,17 +623,10 @@ MavlinkFTP::_workRead(PayloadHeader* payload)
 		return kErrInvalidSession;
 	}
 
-	// Seek to the specified position
 #ifdef MAVLINK_FTP_DEBUG
 	warnx("seek %d", payload->offset);
 #endif
-	if (lseek(_session_fds[session_index], payload->offset, SEEK_SET) < 0) {
-		// Unable to see to the specified location
-		warnx("seek fail");
-		return kErrEOF;
-	}
-
-	int bytes_read = ::read(_session_fds[session_index], &payload->data[0], kMaxDataLength);
+	int bytes_read = _readAhead(session_index, payload->offset, &payload->data[0], kMaxDataLength);
 	if (bytes_read < 0) {
 		// Negative return indicates error other than eof
 		warnx("read fail %d", bytes_read);
@@ -612,8 +769,7 @@ MavlinkFTP::_workTerminate(PayloadHeader* payload)
 		return kErrInvalidSession;
 	}
     
-	::close(_session_fds[payload->session]);
-	_session_fds[payload->session] = -1;
+	_closeSession(payload->session);
 	
 	payload->size = 0;
 
@@ -626,8 +782,7 @@ MavlinkFTP::_workReset(PayloadHeader* payload)
 {
 	for (size_t i=0; i<kMaxSession; i++) {
 		if (_session_fds[i] != -1) {
-			::close(_session_fds[i]);
-			_session_fds[i] = -1;
+			_closeSession(i);
 		}
 	}
 
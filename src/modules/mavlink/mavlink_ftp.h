@@ -77,7 +77,8 @@ public:
 		uint8_t		opcode;		///< Command opcode
 		uint8_t		size;		///< Size of data
 		uint8_t		req_opcode;	///< Request opcode returned in kRspAck, kRspNak message
-		uint8_t		padding[2];	///< 32 bit aligment padding
+		uint8_t		burst_complete;	///< Set in the last reply of a kCmdBurstReadFile
+		uint8_t		padding[1];	///< 32 bit aligment padding
 		uint32_t	offset;		///< Offsets for List and Read commands
 		uint8_t		data[];		///< command data, varies by Opcode
         };
@@ -100,11 +101,19 @@ public:
 		kCmdTruncateFile,	///< Truncate file at <path> to <offset> length
 		kCmdRename,		///< Rename <path1> to <path2>
 		kCmdCalcFileCRC32,	///< Calculate CRC32 for file at <path>
+		kCmdBurstReadFile,	///< Streams the file in <session> from <offset> to the end, see below
 		
 		kRspAck = 128,		///< Ack response
 		kRspNak			///< Nak response
 	};
 	
+	// A kCmdBurstReadFile request is answered with a stream of kRspAck replies, one per chunk, without
+	// further requests. Each reply carries the file offset of its data and an incremented seqNumber,
+	// the last one has burst_complete set. A read error ends the burst with a kRspNak, as does an
+	// offset at or past the end of file (kErrEOF). The client detects missing chunks from the offsets
+	// and fetches them again with kCmdReadFile or a new burst from the first missing offset. A
+	// kCmdTerminateSession or kCmdResetSessions stops a running burst.
+
 	/// @brief Error codes returned in Nak response PayloadHeader.data[0].
 	enum ErrorCode : uint8_t
         {
@@ -140,8 +149,12 @@ private:
 	char		*_data_as_cstring(PayloadHeader* payload);
 	
 	static void	_worker_trampoline(void *arg);
+	static void	_burst_trampoline(void *arg);
 	void		_process_request(Request *req);
-	void		_reply(Request *req);
+	bool		_reply(Request *req);
+	bool		_burstRead(Request *req);
+	int		_readAhead(unsigned session, uint32_t offset, uint8_t *dst, unsigned len);
+	void		_closeSession(unsigned session);
 	int		_copy_file(const char *src_path, const char *dst_path, ssize_t length);
 
 	ErrorCode	_workList(PayloadHeader *payload);
@@ -157,7 +170,7 @@ private:
 	ErrorCode	_workRename(PayloadHeader *payload);
 	ErrorCode	_workCalcFileCRC32(PayloadHeader *payload);
 
-	static const unsigned	kRequestQueueSize = 2;			///< Max number of queued requests
+	static const unsigned	kRequestQueueSize = 3;			///< Max number of queued requests, one more than sessions so a burst can always be stopped
 	Request			_request_bufs[kRequestQueueSize];	///< Request buffers which hold work
 	dq_queue_t		_request_queue;				///< Queue of available Request buffers
 	sem_t			_request_queue_sem;			///< Semaphore for locking access to _request_queue
@@ -174,6 +187,19 @@ private:
 	
 	static const unsigned kMaxSession = 2;	///< Max number of active sessions
 	int	_session_fds[kMaxSession];	///< Session file descriptors, 0 for empty slot
+
+	static const unsigned kReadAheadSize = 2048;	///< Read-ahead buffer per read only session
+	static const unsigned kReadAheadAlign = 512;	///< Read-ahead fills start on a sector boundary
+	struct ReadAhead {
+		uint8_t		*data;		///< buffer, nullptr if the session has none
+		uint32_t	offset;		///< file offset of data[0]
+		unsigned	len;		///< valid bytes in data
+	};
+	ReadAhead	_read_ahead[kMaxSession];
+
+	static const unsigned kBurstChunksPerCycle = 4;	///< Chunks queued per work queue cycle, the size of the message buffer
+	static const unsigned kBurstIntervalUs = 1000;	///< Delay between burst cycles
+	Request	*_session_burst[kMaxSession];	///< Request of the running burst read, nullptr if none
 	
 	ReceiveMessageFunc_t _utRcvMsgFunc;	///< Unit test override for mavlink message sending
 	MavlinkFtpTest *_ftp_test;		///< Additional parameter to _utRcvMsgFunc;
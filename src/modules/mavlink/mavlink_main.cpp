@@ -43,6 +43,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -72,6 +74,7 @@
 #include <mavlink/mavlink_log.h>
 
 #include <uORB/topics/parameter_update.h>
+#include <uORB/topics/actuator_controls.h>
 
 #include "mavlink_bridge_header.h"
 #include "mavlink_main.h"
@@ -95,6 +98,9 @@ static const int ERROR = -1;
 
 #define TX_BUFFER_GAP MAVLINK_MAX_PACKET_LEN
 
+#define MIN_RATE_MULT		0.01f	///< streams are never scaled below this
+#define TX_TOKENS_BURST		0.1f	///< token bucket depth in seconds of link budget
+
 static Mavlink *_mavlink_instances = nullptr;
 
 /* TODO: if this is a class member it crashes */
@@ -103,6 +109,43 @@ static struct file_operations fops;
 static const uint8_t mavlink_message_lengths[256] = MAVLINK_MESSAGE_LENGTHS;
 static const uint8_t mavlink_message_crcs[256] = MAVLINK_MESSAGE_CRCS;
 
+/**
+ * Payload offsets of the target fields of addressed messages, used for routing.
+ * Messages not listed are broadcasts.
+ */
+struct mavlink_target_s {
+	uint8_t	msgid;
+	uint8_t	sysid_offset;
+	uint8_t	compid_offset;		///< MAVLINK_TARGET_NO_COMPID if there is no component field
+};
+
+#define MAVLINK_TARGET_NO_COMPID	0xff
+#define MAVLINK_TARGET(id, type)	{ MAVLINK_MSG_ID_##id, offsetof(type, target_system), offsetof(type, target_component) }
+
+static const mavlink_target_s mavlink_targets[] = {
+	MAVLINK_TARGET(PARAM_REQUEST_READ, mavlink_param_request_read_t),
+	MAVLINK_TARGET(PARAM_REQUEST_LIST, mavlink_param_request_list_t),
+	MAVLINK_TARGET(PARAM_SET, mavlink_param_set_t),
+	MAVLINK_TARGET(MISSION_REQUEST_LIST, mavlink_mission_request_list_t),
+	MAVLINK_TARGET(MISSION_REQUEST, mavlink_mission_request_t),
+	MAVLINK_TARGET(MISSION_COUNT, mavlink_mission_count_t),
+	MAVLINK_TARGET(MISSION_ITEM, mavlink_mission_item_t),
+	MAVLINK_TARGET(MISSION_ACK, mavlink_mission_ack_t),
+	MAVLINK_TARGET(MISSION_SET_CURRENT, mavlink_mission_set_current_t),
+	MAVLINK_TARGET(MISSION_CLEAR_ALL, mavlink_mission_clear_all_t),
+	MAVLINK_TARGET(REQUEST_DATA_STREAM, mavlink_request_data_stream_t),
+	MAVLINK_TARGET(COMMAND_LONG, mavlink_command_long_t),
+	MAVLINK_TARGET(COMMAND_INT, mavlink_command_int_t),
+	MAVLINK_TARGET(SET_POSITION_TARGET_LOCAL_NED, mavlink_set_position_target_local_ned_t),
+	MAVLINK_TARGET(SET_ATTITUDE_TARGET, mavlink_set_attitude_target_t),
+	MAVLINK_TARGET(FILE_TRANSFER_PROTOCOL, mavlink_file_transfer_protocol_t),
+	{ MAVLINK_MSG_ID_SET_MODE, offsetof(mavlink_set_mode_t, target_system), MAVLINK_TARGET_NO_COMPID },
+};
+
+Mavlink::forward_slot_s Mavlink::_fwd_pool[MAVLINK_FWD_POOL_SIZE] = {};
+Mavlink::route_s Mavlink::_routes[MAVLINK_ROUTES_MAX] = {};
+pthread_mutex_t Mavlink::_fwd_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /**
  * mavlink app start / stop handling function
  *
@@ -130,6 +173,7 @@ Mavlink::Mavlink() :
 	_main_loop_delay(1000),
 	_subscriptions(nullptr),
 	_streams(nullptr),
+	_stream_schedule(),
 	_mission_manager(nullptr),
 	_parameters_manager(nullptr),
 	_mode(MAVLINK_MODE_NORMAL),
@@ -146,10 +190,14 @@ Mavlink::Mavlink() :
 	_datarate(1000),
 	_datarate_events(500),
 	_rate_mult(1.0f),
+	_link_budget(1000.0f),
+	_tx_tokens(0.0f),
+	_tx_tokens_time(0),
 	_mavlink_param_queue_index(0),
 	mavlink_link_termination_allowed(false),
 	_subscribe_to_stream(nullptr),
 	_subscribe_to_stream_rate(0.0f),
+	_subscribe_to_stream_on_change(false),
 	_flow_control_enabled(true),
 	_last_write_success_time(0),
 	_last_write_try_time(0),
@@ -160,10 +208,27 @@ Mavlink::Mavlink() :
 	_rate_tx(0.0f),
 	_rate_txerr(0.0f),
 	_rate_rx(0.0f),
+	_msgs_rx(0),
+	_errors_rx(0),
+	_rate_rx_msgs(0.0f),
+	_rate_rx_errors(0.0f),
+	_tx_queue_peak(0),
+	_tx_buf_free_min(UINT_MAX),
+	_setpoint_time(0),
+	_actuator_sub(nullptr),
+	_latency_sum(0),
+	_latency_count(0),
+	_latency_max(0),
+	_telemetry_status_pub(-1),
 	_rstatus {},
 	_message_buffer {},
 	_message_buffer_mutex {},
 	_send_mutex {},
+	_tx_buf {},
+	_tx_buf_len(0),
+	_fwd_queue {},
+	_fwd_queue_head(0),
+	_fwd_queue_len(0),
 	_param_initialized(false),
 	_param_system_id(0),
 	_param_component_id(0),
@@ -385,18 +450,157 @@ Mavlink::instance_exists(const char *device_name, Mavlink *self)
 void
 Mavlink::forward_message(const mavlink_message_t *msg, Mavlink *self)
 {
+	/* the sender is reachable over the link the message came in on */
+	route_update(msg->sysid, msg->compid, self);
+
+	/* find the target of addressed messages */
+	Mavlink *target = nullptr;
+
+	for (unsigned i = 0; i < sizeof(mavlink_targets) / sizeof(mavlink_targets[0]); i++) {
+		if (mavlink_targets[i].msgid == msg->msgid) {
+			const uint8_t *payload = (const uint8_t *)msg->payload64;
+			uint8_t sysid = payload[mavlink_targets[i].sysid_offset];
+			uint8_t compid = (mavlink_targets[i].compid_offset == MAVLINK_TARGET_NO_COMPID) ?
+					 0 : payload[mavlink_targets[i].compid_offset];
+
+			if (sysid == mavlink_system.sysid && compid == mavlink_system.compid) {
+				/* addressed to us only */
+				return;
+			}
+
+			if (sysid != 0) {
+				target = route_find(sysid, compid);
+			}
+
+			break;
+		}
+	}
+
+	if (target == self) {
+		/* target is on the link the message came from */
+		return;
+	}
+
+	/* one copy of the message, shared by all instances sending it */
+	forward_slot_s *slot = nullptr;
 
 	Mavlink *inst;
 	LL_FOREACH(_mavlink_instances, inst) {
-		if (inst != self) {
+		if (inst == self || !inst->_passing_on || (target != nullptr && inst != target)) {
+			continue;
+		}
+
+		/* if not in normal mode, we are an onboard link
+		 * onboard links should only pass on messages from the same system ID */
+		if (self->_mode != MAVLINK_MODE_NORMAL && msg->sysid != mavlink_system.sysid) {
+			continue;
+		}
+
+		if (slot == nullptr) {
+			slot = forward_slot_alloc(msg);
+
+			if (slot == nullptr) {
+				/* all slots in flight, drop */
+				return;
+			}
+		}
+
+		inst->pass_message(slot);
+	}
+
+	if (slot != nullptr) {
+		forward_slot_release(slot);
+	}
+}
+
+Mavlink::forward_slot_s *
+Mavlink::forward_slot_alloc(const mavlink_message_t *msg)
+{
+	forward_slot_s *slot = nullptr;
+
+	pthread_mutex_lock(&_fwd_mutex);
+
+	for (unsigned i = 0; i < MAVLINK_FWD_POOL_SIZE; i++) {
+		if (_fwd_pool[i].refcount == 0) {
+			slot = &_fwd_pool[i];
+			slot->refcount = 1;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&_fwd_mutex);
 
-			/* if not in normal mode, we are an onboard link
-			 * onboard links should only pass on messages from the same system ID */
-			if (!(self->_mode != MAVLINK_MODE_NORMAL && msg->sysid != mavlink_system.sysid)) {
-				inst->pass_message(msg);
+	if (slot != nullptr) {
+		/* header and payload, same as what resend_message() uses */
+		slot->msg.checksum = msg->checksum;
+		memcpy(&slot->msg.magic, &msg->magic, MAVLINK_NUM_HEADER_BYTES + msg->len);
+	}
+
+	return slot;
+}
+
+void
+Mavlink::forward_slot_release(forward_slot_s *slot)
+{
+	pthread_mutex_lock(&_fwd_mutex);
+	slot->refcount--;
+	pthread_mutex_unlock(&_fwd_mutex);
+}
+
+void
+Mavlink::route_update(uint8_t sysid, uint8_t compid, Mavlink *inst)
+{
+	hrt_abstime now = hrt_absolute_time();
+	route_s *route = &_routes[0];
+
+	pthread_mutex_lock(&_fwd_mutex);
+
+	/* a new sender replaces the oldest entry, unused entries have last_seen 0 */
+	for (unsigned i = 0; i < MAVLINK_ROUTES_MAX; i++) {
+		if (_routes[i].inst != nullptr && _routes[i].sysid == sysid && _routes[i].compid == compid) {
+			route = &_routes[i];
+			break;
+		}
+
+		if (_routes[i].last_seen < route->last_seen) {
+			route = &_routes[i];
+		}
+	}
+
+	route->sysid = sysid;
+	route->compid = compid;
+	route->inst = inst;
+	route->last_seen = now;
+
+	pthread_mutex_unlock(&_fwd_mutex);
+}
+
+Mavlink *
+Mavlink::route_find(uint8_t sysid, uint8_t compid)
+{
+	hrt_abstime now = hrt_absolute_time();
+	Mavlink *inst = nullptr;
+
+	pthread_mutex_lock(&_fwd_mutex);
+
+	for (unsigned i = 0; i < MAVLINK_ROUTES_MAX; i++) {
+		if (_routes[i].inst != nullptr && _routes[i].sysid == sysid &&
+		    (compid == 0 || _routes[i].compid == compid) &&
+		    now - _routes[i].last_seen < MAVLINK_ROUTE_TIMEOUT) {
+
+			if (inst != nullptr && inst != _routes[i].inst) {
+				/* components of the system on several links, send to all */
+				inst = nullptr;
+				break;
 			}
+
+			inst = _routes[i].inst;
 		}
 	}
+
+	pthread_mutex_unlock(&_fwd_mutex);
+
+	return inst;
 }
 
 int
@@ -746,6 +950,72 @@ Mavlink::get_free_tx_buf()
 	return buf_free;
 }
 
+uint8_t *
+Mavlink::tx_buf_reserve(unsigned packet_len)
+{
+	if (_tx_buf_len + packet_len > sizeof(_tx_buf)) {
+		flush_tx_buf();
+	}
+
+	return &_tx_buf[_tx_buf_len];
+}
+
+void
+Mavlink::flush_tx_buf()
+{
+	if (_tx_buf_len == 0) {
+		return;
+	}
+
+	unsigned buf_free = get_free_tx_buf();
+
+	_last_write_try_time = hrt_absolute_time();
+
+	if (_tx_buf_len > _tx_queue_peak) {
+		_tx_queue_peak = _tx_buf_len;
+	}
+
+	if (buf_free < _tx_buf_free_min) {
+		_tx_buf_free_min = buf_free;
+	}
+
+	/* take as many whole packets as there is space for, keeping the same gap as for single packets */
+	unsigned len = 0;
+
+	while (len < _tx_buf_len) {
+		unsigned packet_len = _tx_buf[len + 1] + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+
+		if ((buf_free < len + TX_BUFFER_GAP) || (buf_free < len + packet_len)) {
+			break;
+		}
+
+		len += packet_len;
+	}
+
+	/* let the rest overflow */
+	for (unsigned i = len; i < _tx_buf_len; i += _tx_buf[i + 1] + MAVLINK_NUM_NON_PAYLOAD_BYTES) {
+		count_txerr();
+	}
+
+	count_txerrbytes(_tx_buf_len - len);
+
+	if (len > 0) {
+		/* send messages to UART */
+		ssize_t ret = write(_uart_fd, _tx_buf, len);
+
+		if (ret != (int) len) {
+			count_txerr();
+			count_txerrbytes(len);
+
+		} else {
+			_last_write_success_time = _last_write_try_time;
+			count_txbytes(len);
+		}
+	}
+
+	_tx_buf_len = 0;
+}
+
 void
 Mavlink::send_message(const uint8_t msgid, const void *msg)
 {
@@ -757,23 +1027,10 @@ Mavlink::send_message(const uint8_t msgid, const void *msg)
 
 	pthread_mutex_lock(&_send_mutex);
 
-	unsigned buf_free = get_free_tx_buf();
-
 	uint8_t payload_len = mavlink_message_lengths[msgid];
 	unsigned packet_len = payload_len + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 
-	_last_write_try_time = hrt_absolute_time();
-
-	/* check if there is space in the buffer, let it overflow else */
-	if ((buf_free < TX_BUFFER_GAP) || (buf_free < packet_len)) {
-		/* no enough space in buffer to send */
-		count_txerr();
-		count_txerrbytes(packet_len);
-		pthread_mutex_unlock(&_send_mutex);
-		return;
-	}
-
-	uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+	uint8_t *buf = tx_buf_reserve(packet_len);
 
 	/* header */
 	buf[0] = MAVLINK_STX;
@@ -796,17 +1053,8 @@ Mavlink::send_message(const uint8_t msgid, const void *msg)
 	buf[MAVLINK_NUM_HEADER_BYTES + payload_len] = (uint8_t)(checksum & 0xFF);
 	buf[MAVLINK_NUM_HEADER_BYTES + payload_len + 1] = (uint8_t)(checksum >> 8);
 
-	/* send message to UART */
-	ssize_t ret = write(_uart_fd, buf, packet_len);
-
-	if (ret != (int) packet_len) {
-		count_txerr();
-		count_txerrbytes(packet_len);
-
-	} else {
-		_last_write_success_time = _last_write_try_time;
-		count_txbytes(packet_len);
-	}
+	/* sent with the next flush */
+	_tx_buf_len += packet_len;
 
 	pthread_mutex_unlock(&_send_mutex);
 }
@@ -822,22 +1070,9 @@ Mavlink::resend_message(mavlink_message_t *msg)
 
 	pthread_mutex_lock(&_send_mutex);
 
-	unsigned buf_free = get_free_tx_buf();
-
-	_last_write_try_time = hrt_absolute_time();
-
 	unsigned packet_len = msg->len + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 
-	/* check if there is space in the buffer, let it overflow else */
-	if ((buf_free < TX_BUFFER_GAP) || (buf_free < packet_len)) {
-		/* no enough space in buffer to send */
-		count_txerr();
-		count_txerrbytes(packet_len);
-		pthread_mutex_unlock(&_send_mutex);
-		return;
-	}
-
-	uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+	uint8_t *buf = tx_buf_reserve(packet_len);
 
 	/* header and payload */
 	memcpy(&buf[0], &msg->magic, MAVLINK_NUM_HEADER_BYTES + msg->len);
@@ -846,17 +1081,8 @@ Mavlink::resend_message(mavlink_message_t *msg)
 	buf[MAVLINK_NUM_HEADER_BYTES + msg->len] = (uint8_t)(msg->checksum & 0xFF);
 	buf[MAVLINK_NUM_HEADER_BYTES + msg->len + 1] = (uint8_t)(msg->checksum >> 8);
 
-	/* send message to UART */
-	ssize_t ret = write(_uart_fd, buf, packet_len);
-
-	if (ret != (int) packet_len) {
-		count_txerr();
-		count_txerrbytes(packet_len);
-
-	} else {
-		_last_write_success_time = _last_write_try_time;
-		count_txbytes(packet_len);
-	}
+	/* sent with the next flush */
+	_tx_buf_len += packet_len;
 
 	pthread_mutex_unlock(&_send_mutex);
 }
@@ -931,7 +1157,7 @@ Mavlink::interval_from_rate(float rate)
 }
 
 int
-Mavlink::configure_stream(const char *stream_name, const float rate)
+Mavlink::configure_stream(const char *stream_name, const float rate, const bool on_change)
 {
 	/* calculate interval in us, 0 means disabled stream */
 	unsigned int interval = interval_from_rate(rate);
@@ -943,12 +1169,14 @@ Mavlink::configure_stream(const char *stream_name, const float rate)
 			if (interval > 0) {
 				/* set new interval */
 				stream->set_interval(interval);
+				stream->set_on_change(on_change);
 
 			} else {
 				/* delete stream */
 				LL_DELETE(_streams, stream);
-				delete stream;
+				stream_schedule_rebuild();
 				warnx("deleted stream %s", stream->get_name());
+				delete stream;
 			}
 
 			return OK;
@@ -961,22 +1189,99 @@ Mavlink::configure_stream(const char *stream_name, const float rate)
 	}
 
 	/* search for stream with specified name in supported streams list */
-	for (unsigned int i = 0; streams_list[i] != nullptr; i++) {
+	int id = stream_id_for_name(stream_name);
 
-		if (strcmp(stream_name, streams_list[i]->get_name()) == 0) {
-			/* create new instance */
-			stream = streams_list[i]->new_instance(this);
-			stream->set_interval(interval);
-			LL_APPEND(_streams, stream);
+	if (id < 0) {
+		warnx("stream %s not found", stream_name);
+		return ERROR;
+	}
 
-			return OK;
+	if (_stream_schedule.full()) {
+		warnx("too many streams, %s not added", stream_name);
+		return ERROR;
+	}
+
+	/* create new instance */
+	stream = streams_list[id].new_instance(this);
+	stream->set_interval(interval);
+	stream->set_on_change(on_change);
+
+	/* keep the list sorted by priority so higher priorities take the tokens first */
+	MavlinkStream **prev = &_streams;
+
+	while (*prev != nullptr && (*prev)->get_priority() <= stream->get_priority()) {
+		prev = &(*prev)->next;
+	}
+
+	stream->next = *prev;
+	*prev = stream;
+
+	stream_schedule_rebuild();
+
+	return OK;
+}
+
+void
+Mavlink::stream_schedule_rebuild()
+{
+	_stream_schedule.clear();
+
+	MavlinkStream *stream;
+	LL_FOREACH(_streams, stream) {
+		_stream_schedule.push_back(stream);
+	}
+
+	stream_schedule_sort();
+}
+
+void
+Mavlink::stream_schedule_sort()
+{
+	/* insertion sort, the schedule is sorted except for the streams updated last */
+	for (unsigned i = 1; i < _stream_schedule.size(); i++) {
+		MavlinkStream *stream = _stream_schedule[i];
+		hrt_abstime due = stream->get_next_due();
+		unsigned j = i;
+
+		while (j > 0 && _stream_schedule[j - 1]->get_next_due() > due) {
+			_stream_schedule[j] = _stream_schedule[j - 1];
+			j--;
 		}
+
+		_stream_schedule[j] = stream;
 	}
+}
+
+void
+Mavlink::update_streams(const hrt_abstime t)
+{
+	/* due streams are at the front of the schedule */
+	unsigned due = 0;
 
-	/* if we reach here, the stream list does not contain the stream */
-	warnx("stream %s not found", stream_name);
+	while (due < _stream_schedule.size() && _stream_schedule[due]->get_next_due() <= t) {
+		due++;
+	}
+
+	/* update them in priority order so higher priorities take the tokens first */
+	for (unsigned i = 1; i < due; i++) {
+		MavlinkStream *stream = _stream_schedule[i];
+		unsigned priority = stream->get_priority();
+		unsigned j = i;
+
+		while (j > 0 && _stream_schedule[j - 1]->get_priority() > priority) {
+			_stream_schedule[j] = _stream_schedule[j - 1];
+			j--;
+		}
 
-	return ERROR;
+		_stream_schedule[j] = stream;
+	}
+
+	for (unsigned i = 0; i < due; i++) {
+		_stream_schedule[i]->update(t);
+	}
+
+	/* rate multipliers may have moved the others as well */
+	stream_schedule_sort();
 }
 
 void
@@ -1005,7 +1310,7 @@ Mavlink::adjust_stream_rates(const float multiplier)
 }
 
 void
-Mavlink::configure_stream_threadsafe(const char *stream_name, const float rate)
+Mavlink::configure_stream_threadsafe(const char *stream_name, const float rate, bool on_change)
 {
 	/* orb subscription must be done from the main thread,
 	 * set _subscribe_to_stream and _subscribe_to_stream_rate fields
@@ -1023,6 +1328,7 @@ Mavlink::configure_stream_threadsafe(const char *stream_name, const float rate)
 
 		/* set subscription task */
 		_subscribe_to_stream_rate = rate;
+		_subscribe_to_stream_on_change = on_change;
 		_subscribe_to_stream = s;
 
 		/* wait for subscription */
@@ -1149,18 +1455,78 @@ Mavlink::message_buffer_mark_read(int n)
 	_message_buffer.read_ptr = (_message_buffer.read_ptr + n) % _message_buffer.size;
 }
 
+bool
+Mavlink::pass_message(forward_slot_s *slot)
+{
+	bool queued = false;
+
+	pthread_mutex_lock(&_message_buffer_mutex);
+
+	if (_fwd_queue_len < MAVLINK_FWD_QUEUE_LEN) {
+		pthread_mutex_lock(&_fwd_mutex);
+		slot->refcount++;
+		pthread_mutex_unlock(&_fwd_mutex);
+
+		_fwd_queue[(_fwd_queue_head + _fwd_queue_len) % MAVLINK_FWD_QUEUE_LEN] = slot;
+		_fwd_queue_len++;
+		queued = true;
+	}
+
+	pthread_mutex_unlock(&_message_buffer_mutex);
+
+	return queued;
+}
+
 void
-Mavlink::pass_message(const mavlink_message_t *msg)
+Mavlink::send_forwarded()
 {
-	if (_passing_on) {
-		/* size is 8 bytes plus variable payload */
-		int size = MAVLINK_NUM_NON_PAYLOAD_BYTES + msg->len;
+	while (true) {
+		forward_slot_s *slot = nullptr;
+
 		pthread_mutex_lock(&_message_buffer_mutex);
-		message_buffer_write(msg, size);
+
+		if (_fwd_queue_len > 0) {
+			slot = _fwd_queue[_fwd_queue_head];
+			_fwd_queue_head = (_fwd_queue_head + 1) % MAVLINK_FWD_QUEUE_LEN;
+			_fwd_queue_len--;
+		}
+
 		pthread_mutex_unlock(&_message_buffer_mutex);
+
+		if (slot == nullptr) {
+			break;
+		}
+
+		resend_message(&slot->msg);
+		forward_slot_release(slot);
 	}
 }
 
+void
+Mavlink::forward_cleanup()
+{
+	pthread_mutex_lock(&_message_buffer_mutex);
+
+	while (_fwd_queue_len > 0) {
+		forward_slot_release(_fwd_queue[_fwd_queue_head]);
+		_fwd_queue_head = (_fwd_queue_head + 1) % MAVLINK_FWD_QUEUE_LEN;
+		_fwd_queue_len--;
+	}
+
+	pthread_mutex_unlock(&_message_buffer_mutex);
+
+	pthread_mutex_lock(&_fwd_mutex);
+
+	for (unsigned i = 0; i < MAVLINK_ROUTES_MAX; i++) {
+		if (_routes[i].inst == this) {
+			_routes[i].inst = nullptr;
+			_routes[i].last_seen = 0;
+		}
+	}
+
+	pthread_mutex_unlock(&_fwd_mutex);
+}
+
 float
 Mavlink::get_rate_mult()
 {
@@ -1171,7 +1537,7 @@ void
 Mavlink::update_rate_mult()
 {
 	float const_rate = 0.0f;
-	float rate = 0.0f;
+	float rate[MavlinkStream::PRIORITY_NUM] = {};
 
 	MavlinkStream *stream;
 	LL_FOREACH(_streams, stream) {
@@ -1179,12 +1545,76 @@ Mavlink::update_rate_mult()
 			const_rate += stream->get_size() * 1000000.0f / stream->get_interval();
 
 		} else {
-			rate += stream->get_size() * 1000000.0f / stream->get_interval();
+			rate[stream->get_priority()] += stream->get_size() * 1000000.0f / stream->get_interval();
 		}
 	}
 
-	/* don't scale up rates, only scale down if needed */
-	_rate_mult = fminf(1.0f, ((float)_datarate - const_rate) / rate);
+	/* fill the budget in priority order, don't scale up rates */
+	float budget = _link_budget - const_rate;
+	float rate_total = 0.0f;
+	float mult[MavlinkStream::PRIORITY_NUM];
+
+	for (unsigned i = 0; i < MavlinkStream::PRIORITY_NUM; i++) {
+		mult[i] = 1.0f;
+
+		if (rate[i] > 0.0f) {
+			mult[i] = math::constrain(budget / rate[i], MIN_RATE_MULT, 1.0f);
+			budget -= rate[i] * mult[i];
+			rate_total += rate[i];
+		}
+	}
+
+	LL_FOREACH(_streams, stream) {
+		stream->set_rate_mult(mult[stream->get_priority()]);
+	}
+
+	/* the overall multiplier, used by the mission protocol */
+	_rate_mult = (rate_total > 0.0f) ? math::constrain((_link_budget - const_rate) / rate_total, MIN_RATE_MULT, 1.0f) : 1.0f;
+}
+
+void
+Mavlink::update_link_budget()
+{
+	float budget = _link_budget;
+
+	/* SiK radios report the free space of their TX buffer in percent */
+	if (_rstatus.type == TELEMETRY_STATUS_RADIO_TYPE_3DR_RADIO && _rstatus.telem_time != 0 &&
+	    hrt_elapsed_time(&_rstatus.telem_time) < 5 * 1000 * 1000) {
+		if (_rstatus.txbuf < 25) {
+			budget *= 0.8f;
+
+		} else if (_rstatus.txbuf > 50) {
+			budget *= 1.05f;
+		}
+
+	} else {
+		budget *= 1.05f;
+	}
+
+	/* the OS buffer overflowed, what went out is what the link takes (rates are in kB/s) */
+	if (_rate_txerr > 0.0f) {
+		budget = fminf(budget, _rate_tx * 1000.0f * 0.9f);
+	}
+
+	_link_budget = math::constrain(budget, _datarate * 0.1f, (float)_datarate);
+}
+
+bool
+Mavlink::tx_tokens_take(hrt_abstime t, unsigned bytes, unsigned priority)
+{
+	float burst = fmaxf(_link_budget * TX_TOKENS_BURST, 2 * MAVLINK_MAX_PACKET_LEN);
+
+	if (t > _tx_tokens_time) {
+		_tx_tokens = fminf(_tx_tokens + _link_budget * (t - _tx_tokens_time) / 1e6f, burst);
+		_tx_tokens_time = t;
+	}
+
+	if (priority != MavlinkStream::PRIORITY_HIGH && _tx_tokens < bytes) {
+		return false;
+	}
+
+	_tx_tokens = fmaxf(_tx_tokens - bytes, -burst);
+	return true;
 }
 
 int
@@ -1286,6 +1716,8 @@ Mavlink::task_main(int argc, char *argv[])
 		_datarate = MAX_DATA_RATE;
 	}
 
+	_link_budget = _datarate;
+
 	if (Mavlink::instance_exists(_device_name, this)) {
 		warnx("mavlink instance for %s already running", _device_name);
 		return ERROR;
@@ -1333,11 +1765,12 @@ Mavlink::task_main(int argc, char *argv[])
 
 	/* if we are passing on mavlink messages, we need to prepare a buffer for this instance */
 	if (_passing_on || _ftp_on) {
-		/* initialize message buffer if multiplexing is on or its needed for FTP.
-		 * make space for two messages plus off-by-one space as we use the empty element
-		 * marker ring buffer approach.
+		/* initialize message buffer if multiplexing is on or its needed for FTP,
+		 * the mutex also protects the forward queue.
+		 * make space for four messages, one cycle of an FTP burst read, plus off-by-one
+		 * space as we use the empty element marker ring buffer approach.
 		 */
-		if (OK != message_buffer_init(2 * sizeof(mavlink_message_t) + 1)) {
+		if (OK != message_buffer_init(4 * sizeof(mavlink_message_t) + 1)) {
 			errx(1, "can't allocate message buffer, exiting");
 		}
 
@@ -1390,6 +1823,7 @@ Mavlink::task_main(int argc, char *argv[])
 	_mission_manager->set_interval(interval_from_rate(10.0f));
 	_mission_manager->set_verbose(_verbose);
 	LL_APPEND(_streams, _mission_manager);
+	stream_schedule_rebuild();
 
 	switch (_mode) {
 	case MAVLINK_MODE_NORMAL:
@@ -1450,10 +1884,10 @@ Mavlink::task_main(int argc, char *argv[])
 
 		/* check for requested subscriptions */
 		if (_subscribe_to_stream != nullptr) {
-			if (OK == configure_stream(_subscribe_to_stream, _subscribe_to_stream_rate)) {
+			if (OK == configure_stream(_subscribe_to_stream, _subscribe_to_stream_rate, _subscribe_to_stream_on_change)) {
 				if (_subscribe_to_stream_rate > 0.0f) {
-					warnx("stream %s on device %s enabled with rate %.1f Hz", _subscribe_to_stream, _device_name,
-					      (double)_subscribe_to_stream_rate);
+					warnx("stream %s on device %s enabled with rate %.1f Hz%s", _subscribe_to_stream, _device_name,
+					      (double)_subscribe_to_stream_rate, _subscribe_to_stream_on_change ? " on change" : "");
 
 				} else {
 					warnx("stream %s on device %s disabled", _subscribe_to_stream, _device_name);
@@ -1467,14 +1901,18 @@ Mavlink::task_main(int argc, char *argv[])
 			_subscribe_to_stream = nullptr;
 		}
 
-		/* update streams */
-		MavlinkStream *stream;
-		LL_FOREACH(_streams, stream) {
-			stream->update(t);
+		/* update streams which are due */
+		update_streams(t);
+
+		update_setpoint_latency();
+
+		/* pass messages from other UARTs */
+		if (_passing_on) {
+			send_forwarded();
 		}
 
-		/* pass messages from other UARTs or FTP worker */
-		if (_passing_on || _ftp_on) {
+		/* pass messages from FTP worker */
+		if (_ftp_on) {
 
 			bool is_part;
 			uint8_t *read_ptr;
@@ -1521,6 +1959,11 @@ Mavlink::task_main(int argc, char *argv[])
 			}
 		}
 
+		/* write out everything sent in this iteration at once */
+		pthread_mutex_lock(&_send_mutex);
+		flush_tx_buf();
+		pthread_mutex_unlock(&_send_mutex);
+
 		/* update TX/RX rates*/
 		if (t > _bytes_timestamp + 1000000) {
 			if (_bytes_timestamp != 0) {
@@ -1531,6 +1974,9 @@ Mavlink::task_main(int argc, char *argv[])
 				_bytes_tx = 0;
 				_bytes_txerr = 0;
 				_bytes_rx = 0;
+
+				update_link_budget();
+				update_statistics(dt / 1000.0f);
 			}
 
 			_bytes_timestamp = t;
@@ -1553,6 +1999,7 @@ Mavlink::task_main(int argc, char *argv[])
 	}
 
 	_streams = nullptr;
+	_stream_schedule.clear();
 
 	/* delete subscriptions */
 	MavlinkOrbSubscription *sub_to_del = nullptr;
@@ -1580,6 +2027,10 @@ Mavlink::task_main(int argc, char *argv[])
 	/* close mavlink logging device */
 	close(_mavlink_fd);
 
+	if (_passing_on) {
+		forward_cleanup();
+	}
+
 	if (_passing_on || _ftp_on) {
 		message_buffer_destroy();
 		pthread_mutex_destroy(&_message_buffer_mutex);
@@ -1663,6 +2114,79 @@ Mavlink::start(int argc, char *argv[])
 	return OK;
 }
 
+void
+Mavlink::update_setpoint_latency()
+{
+	hrt_abstime setpoint_time = _setpoint_time;
+
+	if (setpoint_time == 0) {
+		return;
+	}
+
+	if (_actuator_sub == nullptr) {
+		_actuator_sub = add_orb_subscription(ORB_ID(actuator_controls_0));
+	}
+
+	hrt_abstime pub_time = _actuator_sub->get_last_update();
+
+	if (pub_time >= setpoint_time) {
+		unsigned latency = pub_time - setpoint_time;
+
+		_latency_sum += latency;
+		_latency_count++;
+
+		if (latency > _latency_max) {
+			_latency_max = latency;
+		}
+
+		/* a newer setpoint may have arrived meanwhile, it is measured next time */
+		if (_setpoint_time == setpoint_time) {
+			_setpoint_time = 0;
+		}
+	}
+}
+
+void
+Mavlink::update_statistics(float dt)
+{
+	_rate_rx_msgs = _msgs_rx / dt;
+	_rate_rx_errors = _errors_rx / dt;
+	_msgs_rx = 0;
+	_errors_rx = 0;
+
+	MavlinkStream *stream;
+	LL_FOREACH(_streams, stream) {
+		stream->set_rate_achieved(stream->get_sent_count() / dt);
+	}
+
+	_rstatus.rate_rx = _rate_rx;
+	_rstatus.rate_tx = _rate_tx;
+	_rstatus.rate_rx_msgs = _rate_rx_msgs;
+	_rstatus.rate_rx_errors = _rate_rx_errors;
+	_rstatus.tx_queue = _tx_queue_peak;
+	_rstatus.tx_buf_free = (_tx_buf_free_min > UINT16_MAX) ? UINT16_MAX : _tx_buf_free_min;
+	_rstatus.tx_budget = _link_budget;
+	_rstatus.rate_mult = _rate_mult;
+	_rstatus.setpoint_latency = (_latency_count > 0) ? _latency_sum / _latency_count : 0;
+	_rstatus.setpoint_latency_max = _latency_max;
+
+	_tx_queue_peak = 0;
+	_tx_buf_free_min = UINT_MAX;
+	_latency_sum = 0;
+	_latency_count = 0;
+	_latency_max = 0;
+
+	/* telemetry status supported only on first TELEMETRY_STATUS_ORB_ID_NUM mavlink channels */
+	if (_channel < TELEMETRY_STATUS_ORB_ID_NUM) {
+		if (_telemetry_status_pub < 0) {
+			_telemetry_status_pub = orb_advertise(telemetry_status_orb_id[_channel], &_rstatus);
+
+		} else {
+			orb_publish(telemetry_status_orb_id[_channel], _telemetry_status_pub, &_rstatus);
+		}
+	}
+}
+
 void
 Mavlink::display_status()
 {
@@ -1703,7 +2227,24 @@ Mavlink::display_status()
 	printf("\ttx: %.3f kB/s\n", (double)_rate_tx);
 	printf("\ttxerr: %.3f kB/s\n", (double)_rate_txerr);
 	printf("\trx: %.3f kB/s\n", (double)_rate_rx);
+	printf("\trx msgs: %.1f /s, parse errors: %.1f /s\n", (double)_rate_rx_msgs, (double)_rate_rx_errors);
+	printf("\ttx queue: %u B peak, tx buf free: %u B min\n", _rstatus.tx_queue, _rstatus.tx_buf_free);
+
+	if (_rstatus.setpoint_latency_max > 0) {
+		printf("\tsetpoint latency: %u us mean, %u us max\n", _rstatus.setpoint_latency, _rstatus.setpoint_latency_max);
+	}
+
 	printf("\trate mult: %.3f\n", (double)_rate_mult);
+	printf("\tlink budget: %.0f of %d B/s\n", (double)_link_budget, _datarate);
+	printf("\tstreams:\n");
+
+	MavlinkStream *stream;
+	LL_FOREACH(_streams, stream) {
+		printf("\t%-28s prio %u rate %.1f Hz achieved %.1f Hz%s\n", stream->get_name(), stream->get_priority(),
+		       (double)(1000000.0f / stream->get_interval() * (stream->const_rate() ? 1.0f : stream->get_rate_mult())),
+		       (double)stream->get_rate_achieved(),
+		       stream->get_on_change() ? " on change" : "");
+	}
 }
 
 int
@@ -1712,6 +2253,7 @@ Mavlink::stream_command(int argc, char *argv[])
 	const char *device_name = DEFAULT_DEVICE_NAME;
 	float rate = -1.0f;
 	const char *stream_name = nullptr;
+	bool on_change = false;
 
 	argc -= 2;
 	argv += 2;
@@ -1741,6 +2283,9 @@ Mavlink::stream_command(int argc, char *argv[])
 			stream_name = argv[i + 1];
 			i++;
 
+		} else if (0 == strcmp(argv[i], "-c")) {
+			on_change = true;
+
 		} else {
 			err_flag = true;
 		}
@@ -1752,7 +2297,7 @@ Mavlink::stream_command(int argc, char *argv[])
 		Mavlink *inst = get_instance_for_device(device_name);
 
 		if (inst != nullptr) {
-			inst->configure_stream_threadsafe(stream_name, rate);
+			inst->configure_stream_threadsafe(stream_name, rate, on_change);
 
 		} else {
 
@@ -1762,7 +2307,7 @@ Mavlink::stream_command(int argc, char *argv[])
 		}
 
 	} else {
-		errx(1, "usage: mavlink stream [-d device] -s stream -r rate");
+		errx(1, "usage: mavlink stream [-d device] -s stream -r rate [-c]");
 	}
 
 	return OK;
@@ -47,6 +47,7 @@
 #include <systemlib/perf_counter.h>
 #include <pthread.h>
 #include <mavlink/mavlink_log.h>
+#include <containers/Array.hpp>
 
 #include <uORB/uORB.h>
 #include <uORB/topics/mission.h>
@@ -60,6 +61,13 @@
 #include "mavlink_mission.h"
 #include "mavlink_parameters.h"
 
+#define MAVLINK_TX_BUF_SIZE	(4 * MAVLINK_MAX_PACKET_LEN)	///< staged packets, written once per main loop iteration
+#define MAVLINK_STREAMS_MAX	40		///< enabled streams per instance
+#define MAVLINK_ROUTES_MAX	16		///< learned sysid/compid -> instance routes
+#define MAVLINK_ROUTE_TIMEOUT	10000000	///< route is dropped after this time without traffic from it, us
+#define MAVLINK_FWD_POOL_SIZE	8		///< forwarded messages in flight, shared by all instances
+#define MAVLINK_FWD_QUEUE_LEN	8		///< forwarded messages queued per instance
+
 class Mavlink
 {
 
@@ -184,7 +192,7 @@ public:
 
 	mavlink_channel_t	get_channel();
 
-	void			configure_stream_threadsafe(const char *stream_name, float rate);
+	void			configure_stream_threadsafe(const char *stream_name, float rate, bool on_change = false);
 
 	bool			_task_should_exit;	/**< if true, mavlink task should exit */
 
@@ -226,6 +234,17 @@ public:
 
 	float			get_rate_mult();
 
+	/**
+	 * Take link bandwidth for sending a stream message. High priority
+	 * streams always get it and may run the bucket into debt.
+	 *
+	 * @param t		current time
+	 * @param bytes		size of the message
+	 * @param priority	stream priority
+	 * @return		true if the message may be sent now
+	 */
+	bool			tx_tokens_take(hrt_abstime t, unsigned bytes, unsigned priority);
+
 	/* Functions for waiting to start transmission until message received. */
 	void			set_has_received_messages(bool received_messages) { _received_messages = received_messages; }
 	bool			get_has_received_messages() { return _received_messages; }
@@ -258,6 +277,19 @@ public:
 	 */
 	void			count_rxbytes(unsigned n) { _bytes_rx += n; };
 
+	/**
+	 * Count received messages and parser errors
+	 */
+	void			count_rxmsg() { _msgs_rx++; };
+
+	void			count_rxerr() { _errors_rx++; };
+
+	/**
+	 * Note the arrival of an offboard attitude setpoint, the latency to the
+	 * next actuator_controls_0 publication is measured by the main loop
+	 */
+	void			setpoint_received(hrt_abstime t) { _setpoint_time = t; };
+
 	/**
 	 * Get the receive status of this MAVLink link
 	 */
@@ -288,6 +320,7 @@ private:
 
 	MavlinkOrbSubscription	*_subscriptions;
 	MavlinkStream		*_streams;
+	Array<MavlinkStream *, MAVLINK_STREAMS_MAX> _stream_schedule;	///< enabled streams sorted by next due time
 
 	MavlinkMissionManager	*_mission_manager;
 	MavlinkParametersManager *_parameters_manager;
@@ -310,6 +343,9 @@ private:
 	int			_datarate;		///< data rate for normal streams (attitude, position, etc.)
 	int			_datarate_events;	///< data rate for params, waypoints, text messages
 	float		_rate_mult;
+	float		_link_budget;		///< measured link bandwidth for streams in bytes/s
+	float		_tx_tokens;		///< token bucket for stream messages in bytes
+	hrt_abstime	_tx_tokens_time;
 
 	/**
 	 * If the queue index is not at 0, the queue sending
@@ -322,6 +358,7 @@ private:
 
 	char 			*_subscribe_to_stream;
 	float			_subscribe_to_stream_rate;
+	bool			_subscribe_to_stream_on_change;
 
 	bool			_flow_control_enabled;
 	uint64_t		_last_write_success_time;
@@ -335,8 +372,54 @@ private:
 	float		_rate_txerr;
 	float		_rate_rx;
 
+	unsigned		_msgs_rx;
+	unsigned		_errors_rx;
+	float			_rate_rx_msgs;
+	float			_rate_rx_errors;
+	unsigned		_tx_queue_peak;			///< bytes staged for one write, peak in the current second
+	unsigned		_tx_buf_free_min;		///< UART TX buffer free space, minimum in the current second
+
+	volatile hrt_abstime	_setpoint_time;			///< last SET_ATTITUDE_TARGET not matched to a publication yet, 0 if none
+	MavlinkOrbSubscription	*_actuator_sub;
+	uint64_t		_latency_sum;
+	unsigned		_latency_count;
+	unsigned		_latency_max;
+	orb_advert_t		_telemetry_status_pub;
+
+	/**
+	 * Match the last offboard setpoint to the next actuator publication
+	 */
+	void			update_setpoint_latency();
+
+	/**
+	 * Update the once per second statistics and publish them on telemetry_status
+	 */
+	void			update_statistics(float dt);
+
 	struct telemetry_status_s	_rstatus;			///< receive status
 
+	/** forwarded message, shared by all instances sending it */
+	struct forward_slot_s {
+		mavlink_message_t	msg;
+		unsigned		refcount;	///< holders of the slot, 0 if free
+	};
+
+	/** sender seen on an instance */
+	struct route_s {
+		uint8_t		sysid;
+		uint8_t		compid;
+		Mavlink		*inst;		///< instance the sender is reachable over, nullptr if unused
+		hrt_abstime	last_seen;
+	};
+
+	static forward_slot_s	_fwd_pool[MAVLINK_FWD_POOL_SIZE];
+	static route_s		_routes[MAVLINK_ROUTES_MAX];
+	static pthread_mutex_t	_fwd_mutex;		///< protects _fwd_pool refcounts and _routes
+
+	forward_slot_s		*_fwd_queue[MAVLINK_FWD_QUEUE_LEN];	///< protected by _message_buffer_mutex
+	unsigned		_fwd_queue_head;
+	unsigned		_fwd_queue_len;
+
 	struct mavlink_message_buffer {
 		int write_ptr;
 		int read_ptr;
@@ -349,6 +432,9 @@ private:
 	pthread_mutex_t		_message_buffer_mutex;
 	pthread_mutex_t		_send_mutex;
 
+	uint8_t			_tx_buf[MAVLINK_TX_BUF_SIZE];	///< packets staged for the next write, protected by _send_mutex
+	unsigned		_tx_buf_len;
+
 	bool			_param_initialized;
 	param_t			_param_system_id;
 	param_t			_param_component_id;
@@ -372,9 +458,26 @@ private:
 	 */
 	unsigned			get_free_tx_buf();
 
+	/**
+	 * Get space for a packet in the TX staging buffer, flushing it first
+	 * if the packet does not fit. Call with _send_mutex held and add the
+	 * packet length to _tx_buf_len once the packet is complete.
+	 *
+	 * @param packet_len	length of the complete packet
+	 * @return		pointer to the space for the packet
+	 */
+	uint8_t			*tx_buf_reserve(unsigned packet_len);
+
+	/**
+	 * Write the staged packets to the UART with a single write(). Packets
+	 * that do not fit into the OS buffer are dropped and counted as TX
+	 * errors. Call with _send_mutex held.
+	 */
+	void			flush_tx_buf();
+
 	static unsigned int interval_from_rate(float rate);
 
-	int configure_stream(const char *stream_name, const float rate);
+	int configure_stream(const char *stream_name, const float rate, const bool on_change = false);
 
 	/**
 	 * Adjust the stream rates based on the current rate
@@ -383,6 +486,21 @@ private:
 	 */
 	void adjust_stream_rates(const float multiplier);
 
+	/**
+	 * Rebuild the stream schedule from the stream list, call after adding or removing streams
+	 */
+	void stream_schedule_rebuild();
+
+	/**
+	 * Sort the stream schedule by next due time, only streams which were updated move
+	 */
+	void stream_schedule_sort();
+
+	/**
+	 * Update the streams which are due in priority order
+	 */
+	void update_streams(const hrt_abstime t);
+
 	int message_buffer_init(int size);
 
 	void message_buffer_destroy();
@@ -395,13 +513,61 @@ private:
 
 	void message_buffer_mark_read(int n);
 
-	void pass_message(const mavlink_message_t *msg);
+	/**
+	 * Queue a forwarded message for sending, taking a reference on the slot.
+	 *
+	 * @return		true if queued, false if the queue is full
+	 */
+	bool pass_message(forward_slot_s *slot);
+
+	/**
+	 * Send all queued forwarded messages and release their slots.
+	 */
+	void send_forwarded();
+
+	/**
+	 * Drop the queued forwarded messages and the routes over this instance.
+	 */
+	void forward_cleanup();
+
+	/**
+	 * Get a free forward slot holding a copy of msg, with one reference.
+	 *
+	 * @return		slot, nullptr if the pool is exhausted
+	 */
+	static forward_slot_s *forward_slot_alloc(const mavlink_message_t *msg);
 
 	/**
-	 * Update rate mult so total bitrate will be equal to _datarate.
+	 * Drop one reference of a forward slot.
+	 */
+	static void forward_slot_release(forward_slot_s *slot);
+
+	/**
+	 * Learn that sysid/compid is reachable over inst.
+	 */
+	static void route_update(uint8_t sysid, uint8_t compid, Mavlink *inst);
+
+	/**
+	 * Look up the instance a target is reachable over.
+	 *
+	 * @param compid	target component, 0 for any component of the system
+	 * @return		instance, nullptr if no current route is known
+	 */
+	static Mavlink *route_find(uint8_t sysid, uint8_t compid);
+
+	/**
+	 * Hand out the link budget to the streams in priority order. Streams of
+	 * the first priority that does not fit completely are scaled down
+	 * together, lower priorities are reduced to the minimum rate.
 	 */
 	void update_rate_mult();
 
+	/**
+	 * Adjust the link budget to the radio TX buffer level and the TX
+	 * errors of the last second, called once per second.
+	 */
+	void update_link_budget();
+
 	static int	mavlink_dev_ioctl(struct file *filep, int cmd, unsigned long arg);
 
 	/**
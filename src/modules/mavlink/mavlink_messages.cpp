@@ -69,10 +69,12 @@
 #include <uORB/topics/airspeed.h>
 #include <uORB/topics/battery_status.h>
 #include <uORB/topics/navigation_capabilities.h>
+#include <uORB/topics/perf_report.h>
 #include <drivers/drv_rc_input.h>
 #include <drivers/drv_pwm_output.h>
 #include <drivers/drv_range_finder.h>
 #include <systemlib/err.h>
+#include <systemlib/perf_counter.h>
 #include <mavlink/mavlink_log.h>
 
 #include "mavlink_messages.h"
@@ -267,6 +269,11 @@ public:
 		return true;
 	}
 
+	unsigned get_priority()
+	{
+		return PRIORITY_HIGH;
+	}
+
 private:
 	MavlinkOrbSubscription *_status_sub;
 	MavlinkOrbSubscription *_pos_sp_triplet_sub;
@@ -277,8 +284,8 @@ private:
 
 protected:
 	explicit MavlinkStreamHeartbeat(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_status_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_status))),
-		_pos_sp_triplet_sub(_mavlink->add_orb_subscription(ORB_ID(position_setpoint_triplet)))
+		_status_sub(add_orb_subscription(ORB_ID(vehicle_status))),
+		_pos_sp_triplet_sub(add_orb_subscription(ORB_ID(position_setpoint_triplet)))
 	{}
 
 	void send(const hrt_abstime t)
@@ -337,6 +344,11 @@ public:
 		return mavlink_logbuffer_is_empty(_mavlink->get_logbuffer()) ? 0 : (MAVLINK_MSG_ID_STATUSTEXT_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES);
 	}
 
+	unsigned get_priority()
+	{
+		return PRIORITY_HIGH;
+	}
+
 private:
 	/* do not allow top copying this class */
 	MavlinkStreamStatustext(MavlinkStreamStatustext &);
@@ -423,6 +435,11 @@ public:
 		return 0;	// commands stream is not regular and not predictable
 	}
 
+	unsigned get_priority()
+	{
+		return PRIORITY_HIGH;
+	}
+
 private:
 	MavlinkOrbSubscription *_cmd_sub;
 	uint64_t _cmd_time;
@@ -433,7 +450,7 @@ private:
 
 protected:
 	explicit MavlinkStreamCommandLong(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_cmd_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_command))),
+		_cmd_sub(add_orb_subscription(ORB_ID(vehicle_command))),
 		_cmd_time(0)
 	{}
 
@@ -492,6 +509,11 @@ public:
 		return MAVLINK_MSG_ID_SYS_STATUS_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 	}
 
+	unsigned get_priority()
+	{
+		return PRIORITY_HIGH;
+	}
+
 private:
 	MavlinkOrbSubscription *_status_sub;
 
@@ -501,7 +523,7 @@ private:
 
 protected:
 	explicit MavlinkStreamSysStatus(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_status_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_status)))
+		_status_sub(add_orb_subscription(ORB_ID(vehicle_status)))
 	{}
 
 	void send(const hrt_abstime t)
@@ -559,6 +581,11 @@ public:
 		return MAVLINK_MSG_ID_HIGHRES_IMU_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 	}
 
+	unsigned get_priority()
+	{
+		return PRIORITY_LOW;
+	}
+
 private:
 	MavlinkOrbSubscription *_sensor_sub;
 	uint64_t _sensor_time;
@@ -574,7 +601,7 @@ private:
 
 protected:
 	explicit MavlinkStreamHighresIMU(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_sensor_sub(_mavlink->add_orb_subscription(ORB_ID(sensor_combined))),
+		_sensor_sub(add_orb_subscription(ORB_ID(sensor_combined))),
 		_sensor_time(0),
 		_accel_timestamp(0),
 		_gyro_timestamp(0),
@@ -676,7 +703,7 @@ private:
 
 protected:
 	explicit MavlinkStreamAttitude(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_att_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_attitude))),
+		_att_sub(add_orb_subscription(ORB_ID(vehicle_attitude))),
 		_att_time(0)
 	{}
 
@@ -739,7 +766,7 @@ private:
 
 protected:
 	explicit MavlinkStreamAttitudeQuaternion(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_att_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_attitude))),
+		_att_sub(add_orb_subscription(ORB_ID(vehicle_attitude))),
 		_att_time(0)
 	{}
 
@@ -819,17 +846,17 @@ private:
 
 protected:
 	explicit MavlinkStreamVFRHUD(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_att_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_attitude))),
+		_att_sub(add_orb_subscription(ORB_ID(vehicle_attitude))),
 		_att_time(0),
-		_pos_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_global_position))),
+		_pos_sub(add_orb_subscription(ORB_ID(vehicle_global_position))),
 		_pos_time(0),
-		_armed_sub(_mavlink->add_orb_subscription(ORB_ID(actuator_armed))),
+		_armed_sub(add_orb_subscription(ORB_ID(actuator_armed))),
 		_armed_time(0),
-		_act_sub(_mavlink->add_orb_subscription(ORB_ID(actuator_controls_0))),
+		_act_sub(add_orb_subscription(ORB_ID(actuator_controls_0))),
 		_act_time(0),
-		_airspeed_sub(_mavlink->add_orb_subscription(ORB_ID(airspeed))),
+		_airspeed_sub(add_orb_subscription(ORB_ID(airspeed))),
 		_airspeed_time(0),
-		_sensor_combined_sub(_mavlink->add_orb_subscription(ORB_ID(sensor_combined))),
+		_sensor_combined_sub(add_orb_subscription(ORB_ID(sensor_combined))),
 		_sensor_combined_time(0)
 	{}
 
@@ -903,7 +930,7 @@ private:
 
 protected:
 	explicit MavlinkStreamGPSRawInt(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_gps_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_gps_position))),
+		_gps_sub(add_orb_subscription(ORB_ID(vehicle_gps_position))),
 		_gps_time(0)
 	{}
 
@@ -972,9 +999,9 @@ private:
 
 protected:
 	explicit MavlinkStreamGlobalPositionInt(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_pos_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_global_position))),
+		_pos_sub(add_orb_subscription(ORB_ID(vehicle_global_position))),
 		_pos_time(0),
-		_home_sub(_mavlink->add_orb_subscription(ORB_ID(home_position))),
+		_home_sub(add_orb_subscription(ORB_ID(home_position))),
 		_home_time(0)
 	{}
 
@@ -1043,7 +1070,7 @@ private:
 
 protected:
 	explicit MavlinkStreamLocalPositionNED(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_pos_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_local_position))),
+		_pos_sub(add_orb_subscription(ORB_ID(vehicle_local_position))),
 		_pos_time(0)
 	{}
 
@@ -1096,6 +1123,11 @@ public:
 		return MAVLINK_MSG_ID_VICON_POSITION_ESTIMATE_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 	}
 
+	unsigned get_priority()
+	{
+		return PRIORITY_LOW;
+	}
+
 private:
 	MavlinkOrbSubscription *_pos_sub;
 	uint64_t _pos_time;
@@ -1106,7 +1138,7 @@ private:
 
 protected:
 	explicit MavlinkStreamViconPositionEstimate(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_pos_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_vicon_position))),
+		_pos_sub(add_orb_subscription(ORB_ID(vehicle_vicon_position))),
 		_pos_time(0)
 	{}
 
@@ -1168,7 +1200,7 @@ private:
 
 protected:
 	explicit MavlinkStreamGPSGlobalOrigin(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_home_sub(_mavlink->add_orb_subscription(ORB_ID(home_position)))
+		_home_sub(add_orb_subscription(ORB_ID(home_position)))
 	{}
 
 	void send(const hrt_abstime t)
@@ -1233,6 +1265,11 @@ public:
 		return MAVLINK_MSG_ID_SERVO_OUTPUT_RAW_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 	}
 
+	unsigned get_priority()
+	{
+		return PRIORITY_LOW;
+	}
+
 private:
 	MavlinkOrbSubscription *_act_sub;
 	uint64_t _act_time;
@@ -1253,7 +1290,7 @@ protected:
 			ORB_ID(actuator_outputs_3)
 		};
 
-		_act_sub = _mavlink->add_orb_subscription(act_topics[N]);
+		_act_sub = add_orb_subscription(act_topics[N]);
 	}
 
 	void send(const hrt_abstime t)
@@ -1308,6 +1345,11 @@ public:
 		return MAVLINK_MSG_ID_HIL_CONTROLS_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 	}
 
+	unsigned get_priority()
+	{
+		return PRIORITY_HIGH;
+	}
+
 private:
 	MavlinkOrbSubscription *_status_sub;
 	uint64_t _status_time;
@@ -1324,11 +1366,11 @@ private:
 
 protected:
 	explicit MavlinkStreamHILControls(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_status_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_status))),
+		_status_sub(add_orb_subscription(ORB_ID(vehicle_status))),
 		_status_time(0),
-		_pos_sp_triplet_sub(_mavlink->add_orb_subscription(ORB_ID(position_setpoint_triplet))),
+		_pos_sp_triplet_sub(add_orb_subscription(ORB_ID(position_setpoint_triplet))),
 		_pos_sp_triplet_time(0),
-		_act_sub(_mavlink->add_orb_subscription(ORB_ID(actuator_outputs_0))),
+		_act_sub(add_orb_subscription(ORB_ID(actuator_outputs_0))),
 		_act_time(0)
 	{}
 
@@ -1472,7 +1514,7 @@ private:
 
 protected:
 	explicit MavlinkStreamPositionTargetGlobalInt(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_pos_sp_triplet_sub(_mavlink->add_orb_subscription(ORB_ID(position_setpoint_triplet)))
+		_pos_sp_triplet_sub(add_orb_subscription(ORB_ID(position_setpoint_triplet)))
 	{}
 
 	void send(const hrt_abstime t)
@@ -1521,6 +1563,11 @@ public:
 		return MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 	}
 
+	unsigned get_priority()
+	{
+		return PRIORITY_LOW;
+	}
+
 private:
 	MavlinkOrbSubscription *_pos_sp_sub;
 	uint64_t _pos_sp_time;
@@ -1531,7 +1578,7 @@ private:
 
 protected:
 	explicit MavlinkStreamLocalPositionSetpoint(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_pos_sp_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_local_position_setpoint))),
+		_pos_sp_sub(add_orb_subscription(ORB_ID(vehicle_local_position_setpoint))),
 		_pos_sp_time(0)
 	{}
 
@@ -1594,8 +1641,8 @@ private:
 
 protected:
 	explicit MavlinkStreamAttitudeTarget(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_att_sp_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_attitude_setpoint))),
-		_att_rates_sp_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_rates_setpoint))),
+		_att_sp_sub(add_orb_subscription(ORB_ID(vehicle_attitude_setpoint))),
+		_att_rates_sp_sub(add_orb_subscription(ORB_ID(vehicle_rates_setpoint))),
 		_att_sp_time(0),
 		_att_rates_sp_time(0)
 	{}
@@ -1665,7 +1712,7 @@ private:
 
 protected:
 	explicit MavlinkStreamRCChannelsRaw(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_rc_sub(_mavlink->add_orb_subscription(ORB_ID(input_rc))),
+		_rc_sub(add_orb_subscription(ORB_ID(input_rc))),
 		_rc_time(0)
 	{}
 
@@ -1765,7 +1812,7 @@ private:
 
 protected:
 	explicit MavlinkStreamManualControl(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_manual_sub(_mavlink->add_orb_subscription(ORB_ID(manual_control_setpoint))),
+		_manual_sub(add_orb_subscription(ORB_ID(manual_control_setpoint))),
 		_manual_time(0)
 	{}
 
@@ -1817,6 +1864,11 @@ public:
 		return _flow_sub->is_published() ? (MAVLINK_MSG_ID_OPTICAL_FLOW_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES) : 0;
 	}
 
+	unsigned get_priority()
+	{
+		return PRIORITY_LOW;
+	}
+
 private:
 	MavlinkOrbSubscription *_flow_sub;
 	uint64_t _flow_time;
@@ -1827,7 +1879,7 @@ private:
 
 protected:
 	explicit MavlinkStreamOpticalFlow(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_flow_sub(_mavlink->add_orb_subscription(ORB_ID(optical_flow))),
+		_flow_sub(add_orb_subscription(ORB_ID(optical_flow))),
 		_flow_time(0)
 	{}
 
@@ -1880,6 +1932,11 @@ public:
 		return 4 * (MAVLINK_MSG_ID_NAMED_VALUE_FLOAT_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES);
 	}
 
+	unsigned get_priority()
+	{
+		return PRIORITY_LOW;
+	}
+
 private:
 	MavlinkOrbSubscription *_att_ctrl_sub;
 	uint64_t _att_ctrl_time;
@@ -1890,7 +1947,7 @@ private:
 
 protected:
 	explicit MavlinkStreamAttitudeControls(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_att_ctrl_sub(_mavlink->add_orb_subscription(ORB_ID_VEHICLE_ATTITUDE_CONTROLS)),
+		_att_ctrl_sub(add_orb_subscription(ORB_ID_VEHICLE_ATTITUDE_CONTROLS)),
 		_att_ctrl_time(0)
 	{}
 
@@ -1956,6 +2013,11 @@ public:
 		return MAVLINK_MSG_ID_NAMED_VALUE_FLOAT_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
 	}
 
+	unsigned get_priority()
+	{
+		return PRIORITY_LOW;
+	}
+
 private:
 	MavlinkOrbSubscription *_debug_sub;
 	uint64_t _debug_time;
@@ -1966,7 +2028,7 @@ private:
 
 protected:
 	explicit MavlinkStreamNamedValueFloat(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_debug_sub(_mavlink->add_orb_subscription(ORB_ID(debug_key_value))),
+		_debug_sub(add_orb_subscription(ORB_ID(debug_key_value))),
 		_debug_time(0)
 	{}
 
@@ -2026,7 +2088,7 @@ private:
 
 protected:
 	explicit MavlinkStreamCameraCapture(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_status_sub(_mavlink->add_orb_subscription(ORB_ID(vehicle_status)))
+		_status_sub(add_orb_subscription(ORB_ID(vehicle_status)))
 	{}
 
 	void send(const hrt_abstime t)
@@ -2092,7 +2154,7 @@ private:
 
 protected:
 	explicit MavlinkStreamDistanceSensor(Mavlink *mavlink) : MavlinkStream(mavlink),
-		_range_sub(_mavlink->add_orb_subscription(ORB_ID(sensor_range_finder))),
+		_range_sub(add_orb_subscription(ORB_ID(sensor_range_finder))),
 		_range_time(0)
 	{}
 
@@ -2128,35 +2190,134 @@ protected:
 	}
 };
 
+/**
+ * Performance counters selected with 'perf publish'. MAVLink has no message
+ * for them, so each counter goes out as a DEBUG_VECT carrying the
+ * average, maximum and 99th percentile in microseconds, or the event count
+ * in x for PC_COUNT counters.
+ */
+class MavlinkStreamPerfReport : public MavlinkStream
+{
+public:
+	const char *get_name() const
+	{
+		return MavlinkStreamPerfReport::get_name_static();
+	}
+
+	static const char *get_name_static()
+	{
+		return "PERF_REPORT";
+	}
+
+	uint8_t get_id()
+	{
+		return MAVLINK_MSG_ID_DEBUG_VECT;
+	}
+
+	static MavlinkStream *new_instance(Mavlink *mavlink)
+	{
+		return new MavlinkStreamPerfReport(mavlink);
+	}
+
+	unsigned get_size()
+	{
+		return _perf_sub->is_published() ? PERF_REPORT_MAX * (MAVLINK_MSG_ID_DEBUG_VECT_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES) : 0;
+	}
+
+	unsigned get_priority()
+	{
+		return PRIORITY_LOW;
+	}
+
+private:
+	MavlinkOrbSubscription *_perf_sub;
+	uint64_t _perf_time;
+
+	/* do not allow top copying this class */
+	MavlinkStreamPerfReport(MavlinkStreamPerfReport &);
+	MavlinkStreamPerfReport& operator = (const MavlinkStreamPerfReport &);
+
+protected:
+	explicit MavlinkStreamPerfReport(Mavlink *mavlink) : MavlinkStream(mavlink),
+		_perf_sub(add_orb_subscription(ORB_ID(perf_report))),
+		_perf_time(0)
+	{}
+
+	void send(const hrt_abstime t)
+	{
+		struct perf_report_s report;
+
+		if (_perf_sub->update(&_perf_time, &report)) {
+			for (unsigned i = 0; i < report.count && i < PERF_REPORT_MAX; i++) {
+				const struct perf_report_counter_s &counter = report.counters[i];
+				mavlink_debug_vect_t msg;
+
+				msg.time_usec = report.timestamp;
+				/* names longer than the message allows are cut off */
+				strncpy(msg.name, counter.name, sizeof(msg.name));
+
+				if (counter.type == PC_COUNT) {
+					msg.x = counter.count;
+					msg.y = 0.0f;
+					msg.z = 0.0f;
+
+				} else {
+					msg.x = counter.avg;
+					msg.y = counter.max;
+					msg.z = counter.p99;
+				}
+
+				_mavlink->send_message(MAVLINK_MSG_ID_DEBUG_VECT, &msg);
+			}
+		}
+	}
+};
+
 
-StreamListItem *streams_list[] = {
-	new StreamListItem(&MavlinkStreamHeartbeat::new_instance, &MavlinkStreamHeartbeat::get_name_static),
-	new StreamListItem(&MavlinkStreamStatustext::new_instance, &MavlinkStreamStatustext::get_name_static),
-	new StreamListItem(&MavlinkStreamCommandLong::new_instance, &MavlinkStreamCommandLong::get_name_static),
-	new StreamListItem(&MavlinkStreamSysStatus::new_instance, &MavlinkStreamSysStatus::get_name_static),
-	new StreamListItem(&MavlinkStreamHighresIMU::new_instance, &MavlinkStreamHighresIMU::get_name_static),
-	new StreamListItem(&MavlinkStreamAttitude::new_instance, &MavlinkStreamAttitude::get_name_static),
-	new StreamListItem(&MavlinkStreamAttitudeQuaternion::new_instance, &MavlinkStreamAttitudeQuaternion::get_name_static),
-	new StreamListItem(&MavlinkStreamVFRHUD::new_instance, &MavlinkStreamVFRHUD::get_name_static),
-	new StreamListItem(&MavlinkStreamGPSRawInt::new_instance, &MavlinkStreamGPSRawInt::get_name_static),
-	new StreamListItem(&MavlinkStreamGlobalPositionInt::new_instance, &MavlinkStreamGlobalPositionInt::get_name_static),
-	new StreamListItem(&MavlinkStreamLocalPositionNED::new_instance, &MavlinkStreamLocalPositionNED::get_name_static),
-	new StreamListItem(&MavlinkStreamViconPositionEstimate::new_instance, &MavlinkStreamViconPositionEstimate::get_name_static),
-	new StreamListItem(&MavlinkStreamGPSGlobalOrigin::new_instance, &MavlinkStreamGPSGlobalOrigin::get_name_static),
-	new StreamListItem(&MavlinkStreamServoOutputRaw<0>::new_instance, &MavlinkStreamServoOutputRaw<0>::get_name_static),
-	new StreamListItem(&MavlinkStreamServoOutputRaw<1>::new_instance, &MavlinkStreamServoOutputRaw<1>::get_name_static),
-	new StreamListItem(&MavlinkStreamServoOutputRaw<2>::new_instance, &MavlinkStreamServoOutputRaw<2>::get_name_static),
-	new StreamListItem(&MavlinkStreamServoOutputRaw<3>::new_instance, &MavlinkStreamServoOutputRaw<3>::get_name_static),
-	new StreamListItem(&MavlinkStreamHILControls::new_instance, &MavlinkStreamHILControls::get_name_static),
-	new StreamListItem(&MavlinkStreamPositionTargetGlobalInt::new_instance, &MavlinkStreamPositionTargetGlobalInt::get_name_static),
-	new StreamListItem(&MavlinkStreamLocalPositionSetpoint::new_instance, &MavlinkStreamLocalPositionSetpoint::get_name_static),
-	new StreamListItem(&MavlinkStreamAttitudeTarget::new_instance, &MavlinkStreamAttitudeTarget::get_name_static),
-	new StreamListItem(&MavlinkStreamRCChannelsRaw::new_instance, &MavlinkStreamRCChannelsRaw::get_name_static),
-	new StreamListItem(&MavlinkStreamManualControl::new_instance, &MavlinkStreamManualControl::get_name_static),
-	new StreamListItem(&MavlinkStreamOpticalFlow::new_instance, &MavlinkStreamOpticalFlow::get_name_static),
-	new StreamListItem(&MavlinkStreamAttitudeControls::new_instance, &MavlinkStreamAttitudeControls::get_name_static),
-	new StreamListItem(&MavlinkStreamNamedValueFloat::new_instance, &MavlinkStreamNamedValueFloat::get_name_static),
-	new StreamListItem(&MavlinkStreamCameraCapture::new_instance, &MavlinkStreamCameraCapture::get_name_static),
-	new StreamListItem(&MavlinkStreamDistanceSensor::new_instance, &MavlinkStreamDistanceSensor::get_name_static),
-	nullptr
+#define STREAM(_class)	{ &_class::new_instance, &_class::get_name_static }
+
+const StreamListItem streams_list[] = {
+	STREAM(MavlinkStreamHeartbeat),
+	STREAM(MavlinkStreamStatustext),
+	STREAM(MavlinkStreamCommandLong),
+	STREAM(MavlinkStreamSysStatus),
+	STREAM(MavlinkStreamHighresIMU),
+	STREAM(MavlinkStreamAttitude),
+	STREAM(MavlinkStreamAttitudeQuaternion),
+	STREAM(MavlinkStreamVFRHUD),
+	STREAM(MavlinkStreamGPSRawInt),
+	STREAM(MavlinkStreamGlobalPositionInt),
+	STREAM(MavlinkStreamLocalPositionNED),
+	STREAM(MavlinkStreamViconPositionEstimate),
+	STREAM(MavlinkStreamGPSGlobalOrigin),
+	STREAM(MavlinkStreamServoOutputRaw<0>),
+	STREAM(MavlinkStreamServoOutputRaw<1>),
+	STREAM(MavlinkStreamServoOutputRaw<2>),
+	STREAM(MavlinkStreamServoOutputRaw<3>),
+	STREAM(MavlinkStreamHILControls),
+	STREAM(MavlinkStreamPositionTargetGlobalInt),
+	STREAM(MavlinkStreamLocalPositionSetpoint),
+	STREAM(MavlinkStreamAttitudeTarget),
+	STREAM(MavlinkStreamRCChannelsRaw),
+	STREAM(MavlinkStreamManualControl),
+	STREAM(MavlinkStreamOpticalFlow),
+	STREAM(MavlinkStreamAttitudeControls),
+	STREAM(MavlinkStreamNamedValueFloat),
+	STREAM(MavlinkStreamCameraCapture),
+	STREAM(MavlinkStreamDistanceSensor),
+	STREAM(MavlinkStreamPerfReport)
 };
+
+const unsigned streams_list_count = sizeof(streams_list) / sizeof(streams_list[0]);
+
+int
+stream_id_for_name(const char *name)
+{
+	for (unsigned i = 0; i < streams_list_count; i++) {
+		if (strcmp(name, streams_list[i].get_name()) == 0) {
+			return i;
+		}
+	}
+
+	return -1;
+}
@@ -43,19 +43,20 @@
 
 #include "mavlink_stream.h"
 
-class StreamListItem {
-
-public:
+/**
+ * Supported stream, the index in streams_list is the stream id
+ */
+struct StreamListItem {
 	MavlinkStream* (*new_instance)(Mavlink *mavlink);
 	const char* (*get_name)();
-
-	StreamListItem(MavlinkStream* (*inst)(Mavlink *mavlink), const char* (*name)()) :
-		new_instance(inst),
-		get_name(name) {};
-
-	~StreamListItem() {};
 };
 
-extern StreamListItem *streams_list[];
+extern const StreamListItem streams_list[];
+extern const unsigned streams_list_count;
+
+/**
+ * @return stream id of the stream with given name, -1 if not supported
+ */
+int stream_id_for_name(const char *name);
 
 #endif /* MAVLINK_MESSAGES_H_ */
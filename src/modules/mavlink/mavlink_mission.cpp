@@ -79,6 +79,10 @@ MavlinkMissionManager::MavlinkMissionManager(Mavlink *mavlink) : MavlinkStream(m
 	_transfer_current_seq(0),
 	_transfer_partner_sysid(0),
 	_transfer_partner_compid(0),
+	_batch{},
+	_batch_seq(0),
+	_batch_len(0),
+	_batch_received(0),
 	_offboard_mission_sub(-1),
 	_mission_result_sub(-1),
 	_offboard_mission_pub(-1),
@@ -145,6 +149,11 @@ MavlinkMissionManager::update_active_mission(int dataman_id, unsigned count, int
 	/* update mission state in dataman */
 	int res = dm_write(DM_KEY_MISSION_STATE, 0, DM_PERSIST_POWER_ON_RESET, &mission, sizeof(mission_s));
 
+	/* the new mission is complete, make sure it survives a power loss right away */
+	if (res == sizeof(mission_s) && dm_flush() != 0) {
+		res = -1;
+	}
+
 	if (res == sizeof(mission_s)) {
 		/* update active mission state */
 		_dataman_id = dataman_id;
@@ -276,6 +285,32 @@ MavlinkMissionManager::send_mission_request(uint8_t sysid, uint8_t compid, uint1
 }
 
 
+void
+MavlinkMissionManager::batch_start(unsigned seq)
+{
+	_batch_seq = seq;
+	_batch_len = _transfer_count - seq;
+
+	if (_batch_len > MAVLINK_MISSION_BATCH_SIZE) {
+		_batch_len = MAVLINK_MISSION_BATCH_SIZE;
+	}
+
+	_batch_received = 0;
+	_transfer_seq = seq;
+}
+
+
+void
+MavlinkMissionManager::send_batch_requests()
+{
+	for (unsigned i = 0; i < _batch_len; i++) {
+		if (!(_batch_received & (1 << i))) {
+			send_mission_request(_transfer_partner_sysid, _transfer_partner_compid, _batch_seq + i);
+		}
+	}
+}
+
+
 void
 MavlinkMissionManager::send_mission_item_reached(uint16_t seq)
 {
@@ -327,8 +362,8 @@ MavlinkMissionManager::send(const hrt_abstime now)
 		_state = MAVLINK_WPM_STATE_IDLE;
 
 	} else if (_state == MAVLINK_WPM_STATE_GETLIST && hrt_elapsed_time(&_time_last_sent) > _retry_timeout) {
-		/* try to request item again after timeout */
-		send_mission_request(_transfer_partner_sysid, _transfer_partner_compid, _transfer_seq);
+		/* try to request missing items again after timeout */
+		send_batch_requests();
 
 	} else if (_state == MAVLINK_WPM_STATE_SENDLIST && hrt_elapsed_time(&_time_last_sent) > _retry_timeout) {
 		if (_transfer_seq == 0) {
@@ -592,6 +627,7 @@ MavlinkMissionManager::handle_mission_count(const mavlink_message_t *msg)
 			_transfer_count = wpc.count;
 			_transfer_dataman_id = _dataman_id == 0 ? 1 : 0;	// use inactive storage for transmission
 			_transfer_current_seq = -1;
+			batch_start(0);
 
 		} else if (_state == MAVLINK_WPM_STATE_GETLIST) {
 			_time_last_recv = hrt_absolute_time();
@@ -616,7 +652,7 @@ MavlinkMissionManager::handle_mission_count(const mavlink_message_t *msg)
 			return;
 		}
 
-		send_mission_request(_transfer_partner_sysid, _transfer_partner_compid, _transfer_seq);
+		send_batch_requests();
 	}
 }
 
@@ -631,8 +667,8 @@ MavlinkMissionManager::handle_mission_item(const mavlink_message_t *msg)
 		if (_state == MAVLINK_WPM_STATE_GETLIST) {
 			_time_last_recv = hrt_absolute_time();
 
-			if (wp.seq != _transfer_seq) {
-				if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: seq %u was not the expected %u", wp.seq, _transfer_seq); }
+			if (wp.seq < _batch_seq || wp.seq >= _batch_seq + _batch_len) {
+				if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: seq %u not in the expected %u..%u", wp.seq, _batch_seq, _batch_seq + _batch_len - 1); }
 
 				/* don't send request here, it will be performed in eventloop after timeout */
 				return;
@@ -664,16 +700,10 @@ MavlinkMissionManager::handle_mission_item(const mavlink_message_t *msg)
 			return;
 		}
 
-		dm_item_t dm_item = DM_KEY_WAYPOINTS_OFFBOARD(_transfer_dataman_id);
-
-		if (dm_write(dm_item, wp.seq, DM_PERSIST_POWER_ON_RESET, &mission_item, sizeof(struct mission_item_s)) != sizeof(struct mission_item_s)) {
-			if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: error writing seq %u to dataman ID %i", wp.seq, _transfer_dataman_id); }
-
-			send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, MAV_MISSION_ERROR);
-			_mavlink->send_statustext_critical("Unable to write on micro SD");
-			_state = MAVLINK_WPM_STATE_IDLE;
-			return;
-		}
+		/* collect the batch, written to dataman at once when complete */
+		unsigned i = wp.seq - _batch_seq;
+		memcpy(&_batch[i], &mission_item, sizeof(struct mission_item_s));
+		_batch_received |= (1 << i);
 
 		/* waypoint marked as current */
 		if (wp.current) {
@@ -682,7 +712,27 @@ MavlinkMissionManager::handle_mission_item(const mavlink_message_t *msg)
 
 		if (_verbose) { warnx("WPM: MISSION_ITEM seq %u received", wp.seq); }
 
-		_transfer_seq = wp.seq + 1;
+		/* first item still missing */
+		while (_transfer_seq < _batch_seq + _batch_len && (_batch_received & (1 << (_transfer_seq - _batch_seq)))) {
+			_transfer_seq++;
+		}
+
+		if (_transfer_seq < _batch_seq + _batch_len) {
+			/* the remaining items of the batch are already requested */
+			return;
+		}
+
+		dm_item_t dm_item = DM_KEY_WAYPOINTS_OFFBOARD(_transfer_dataman_id);
+
+		if (dm_write_batch(dm_item, _batch_seq, _batch_len, DM_PERSIST_POWER_ON_RESET, _batch, sizeof(struct mission_item_s)) !=
+		    (ssize_t)(_batch_len * sizeof(struct mission_item_s))) {
+			if (_verbose) { warnx("WPM: MISSION_ITEM ERROR: error writing seq %u..%u to dataman ID %i", _batch_seq, _batch_seq + _batch_len - 1, _transfer_dataman_id); }
+
+			send_mission_ack(_transfer_partner_sysid, _transfer_partner_compid, MAV_MISSION_ERROR);
+			_mavlink->send_statustext_critical("Unable to write on micro SD");
+			_state = MAVLINK_WPM_STATE_IDLE;
+			return;
+		}
 
 		if (_transfer_seq == _transfer_count) {
 			/* got all new mission items successfully */
@@ -700,8 +750,9 @@ MavlinkMissionManager::handle_mission_item(const mavlink_message_t *msg)
 			}
 
 		} else {
-			/* request next item */
-			send_mission_request(_transfer_partner_sysid, _transfer_partner_compid, _transfer_seq);
+			/* request next batch */
+			batch_start(_transfer_seq);
+			send_batch_requests();
 		}
 	}
 }
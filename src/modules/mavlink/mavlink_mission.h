@@ -43,6 +43,7 @@
 #pragma once
 
 #include <uORB/uORB.h>
+#include <uORB/topics/mission.h>
 
 #include "mavlink_bridge_header.h"
 #include "mavlink_rate_limiter.h"
@@ -66,6 +67,7 @@ enum MAVLINK_WPM_CODES {
 
 #define MAVLINK_MISSION_PROTOCOL_TIMEOUT_DEFAULT 5000000    ///< Protocol communication action timeout in useconds
 #define MAVLINK_MISSION_RETRY_TIMEOUT_DEFAULT 500000        ///< Protocol communication retry timeout in useconds
+#define MAVLINK_MISSION_BATCH_SIZE 4                        ///< Items requested ahead and written to dataman at once on upload
 
 class MavlinkMissionManager : public MavlinkStream {
 public:
@@ -118,6 +120,11 @@ private:
 	unsigned		_transfer_partner_sysid;		///< Partner system ID for current transmission
 	unsigned		_transfer_partner_compid;		///< Partner component ID for current transmission
 
+	struct mission_item_s	_batch[MAVLINK_MISSION_BATCH_SIZE];	///< Received items of the current upload batch
+	unsigned		_batch_seq;				///< Sequence of _batch[0]
+	unsigned		_batch_len;				///< Items in the current batch
+	unsigned		_batch_received;			///< Bitmask of received items in the current batch
+
 	int			_offboard_mission_sub;
 	int			_mission_result_sub;
 	orb_advert_t		_offboard_mission_pub;
@@ -156,6 +163,16 @@ private:
 
 	void send_mission_request(uint8_t sysid, uint8_t compid, uint16_t seq);
 
+	/**
+	 *  @brief Starts receiving the upload batch beginning at seq
+	 */
+	void batch_start(unsigned seq);
+
+	/**
+	 *  @brief Requests all items of the current upload batch not received yet
+	 */
+	void send_batch_requests();
+
 	/**
 	 *  @brief emits a message that a waypoint reached
 	 *
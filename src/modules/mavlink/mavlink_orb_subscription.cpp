@@ -44,8 +44,25 @@
 #include <uORB/uORB.h>
 #include <stdio.h>
 
+#include <systemlib/mem_pool.h>
+
 #include "mavlink_orb_subscription.h"
 
+static struct mem_pool_s subscription_pool = MEM_POOL_INITIALIZER("mavlink subscriptions",
+		sizeof(MavlinkOrbSubscription), 64);
+
+void *
+MavlinkOrbSubscription::operator new(size_t size)
+{
+	return mem_pool_alloc(&subscription_pool);
+}
+
+void
+MavlinkOrbSubscription::operator delete(void *p)
+{
+	mem_pool_free(&subscription_pool, p);
+}
+
 MavlinkOrbSubscription::MavlinkOrbSubscription(const orb_id_t topic) :
 	next(nullptr),
 	_topic(topic),
@@ -101,6 +118,18 @@ MavlinkOrbSubscription::update(void* data)
 	return !orb_copy(_topic, _fd, data);
 }
 
+uint64_t
+MavlinkOrbSubscription::get_last_update()
+{
+	uint64_t time_topic;
+
+	if (orb_stat(_fd, &time_topic)) {
+		return 0;
+	}
+
+	return time_topic;
+}
+
 bool
 MavlinkOrbSubscription::is_published()
 {
@@ -53,6 +53,12 @@ public:
 	MavlinkOrbSubscription(const orb_id_t topic);
 	~MavlinkOrbSubscription();
 
+	/**
+	 * Subscriptions are allocated from a pool, one per topic and instance
+	 */
+	static void *operator new(size_t size);
+	static void operator delete(void *p);
+
 	/**
 	 * Check if subscription updated and get data.
 	 *
@@ -78,6 +84,13 @@ public:
 	bool is_published();
 	orb_id_t get_topic() const;
 
+	/**
+	 * Get the time of the last publication of the topic, it does not mark the topic as read.
+	 *
+	 * @return publication time, 0 if never published
+	 */
+	uint64_t get_last_update();
+
 private:
 	const orb_id_t _topic;		///< topic metadata
 	int _fd;			///< subscription handle
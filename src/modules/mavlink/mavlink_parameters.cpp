@@ -39,15 +39,27 @@
  */
 
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
 
 #include "mavlink_parameters.h"
 #include "mavlink_main.h"
 
 MavlinkParametersManager::MavlinkParametersManager(Mavlink *mavlink) : MavlinkStream(mavlink),
-	_send_all_index(-1)
+	_send_all_index(-1),
+	_set_batch_open(false),
+	_set_batch_last(0)
 {
 }
 
+MavlinkParametersManager::~MavlinkParametersManager()
+{
+	if (_set_batch_open) {
+		param_end_batch();
+	}
+}
+
 unsigned
 MavlinkParametersManager::get_size()
 {
@@ -100,6 +112,14 @@ MavlinkParametersManager::handle_message(const mavlink_message_t *msg)
 						_mavlink->send_statustext_info(buf);
 
 					} else {
+						/* hold back the notification while a GCS uploads a burst of parameters */
+						if (!_set_batch_open) {
+							param_begin_batch();
+							_set_batch_open = true;
+						}
+
+						_set_batch_last = hrt_absolute_time();
+
 						/* set and send parameter */
 						param_set(param, &(set.param_value));
 						send_param(param);
@@ -124,8 +144,24 @@ MavlinkParametersManager::handle_message(const mavlink_message_t *msg)
 					strncpy(name, req_read.param_id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN);
 					/* enforce null termination */
 					name[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN] = '\0';
-					/* attempt to find parameter and send it */
-					send_param(param_find(name));
+
+					if (strcmp(name, PARAM_HASH_CHECK_ID) == 0) {
+						send_hash(PARAM_HASH_CHECK_ID, param_hash_check());
+
+					} else if (strcmp(name, PARAM_BULK_ID) == 0) {
+						uint32_t hash;
+
+						if (export_bulk(&hash) == OK) {
+							send_hash(PARAM_BULK_ID, hash);
+
+						} else {
+							_mavlink->send_statustext_critical("[pm] param export failed");
+						}
+
+					} else {
+						/* attempt to find parameter and send it */
+						send_param(param_find(name));
+					}
 
 				} else {
 					/* when index is >= 0, send this parameter again */
@@ -143,16 +179,100 @@ MavlinkParametersManager::handle_message(const mavlink_message_t *msg)
 void
 MavlinkParametersManager::send(const hrt_abstime t)
 {
-	/* send all parameters if requested */
+	/* notify once the burst of PARAM_SETs is over */
+	if (_set_batch_open && t > _set_batch_last + PARAM_SET_BATCH_TIMEOUT) {
+		_set_batch_open = false;
+		param_end_batch();
+	}
+
+	/* send all parameters if requested, followed by the hash of the set */
 	if (_send_all_index >= 0) {
-		send_param(param_for_index(_send_all_index));
-		_send_all_index++;
-		if (_send_all_index >= (int) param_count()) {
+		if (_send_all_index < (int) param_count()) {
+			send_param(param_for_index(_send_all_index));
+			_send_all_index++;
+
+		} else {
+			send_hash(PARAM_HASH_CHECK_ID, param_hash_check());
 			_send_all_index = -1;
 		}
 	}
 }
 
+void
+MavlinkParametersManager::send_hash(const char *id, uint32_t hash)
+{
+	mavlink_param_value_t msg;
+
+	/* hash is sent as raw bits, like int32 params */
+	memcpy(&msg.param_value, &hash, sizeof(hash));
+	msg.param_count = param_count();
+	msg.param_index = -1;
+	strncpy(msg.param_id, id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN);
+	msg.param_type = MAVLINK_TYPE_UINT32_T;
+
+	_mavlink->send_message(MAVLINK_MSG_ID_PARAM_VALUE, &msg);
+}
+
+int
+MavlinkParametersManager::export_bulk(uint32_t *hash)
+{
+	int fd = open(PARAM_BULK_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+	if (fd < 0) {
+		return -errno;
+	}
+
+	/* the hash is taken first, a value changing while exporting makes the ground station fetch again */
+	BulkHeader header;
+	header.hash = param_hash_check();
+	header.count = 0;
+	int ret = OK;
+
+	/* header is rewritten with the final count */
+	if (write(fd, &header, sizeof(header)) != sizeof(header)) {
+		ret = -errno;
+		goto out;
+	}
+
+	for (unsigned i = 0; i < param_count(); i++) {
+		param_t param = param_for_index(i);
+		param_type_t type = param_type(param);
+		BulkRecord rec;
+
+		if (type != PARAM_TYPE_INT32 && type != PARAM_TYPE_FLOAT) {
+			continue;
+		}
+
+		if (param_get(param, rec.value) != OK) {
+			continue;
+		}
+
+		rec.index = i;
+		strncpy(rec.id, param_name(param), sizeof(rec.id));
+		rec.type = (type == PARAM_TYPE_INT32) ? MAVLINK_TYPE_INT32_T : MAVLINK_TYPE_FLOAT;
+
+		if (write(fd, &rec, sizeof(rec)) != sizeof(rec)) {
+			ret = -errno;
+			goto out;
+		}
+
+		header.count++;
+	}
+
+	if (lseek(fd, 0, SEEK_SET) < 0 || write(fd, &header, sizeof(header)) != sizeof(header)) {
+		ret = -errno;
+	}
+
+out:
+	close(fd);
+
+	if (ret == OK) {
+		*hash = header.hash;
+	}
+
+	return ret;
+}
+
 void
 MavlinkParametersManager::send_param(param_t param)
 {
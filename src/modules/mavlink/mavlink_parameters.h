@@ -45,6 +45,29 @@
 #include "mavlink_bridge_header.h"
 #include "mavlink_stream.h"
 
+/**
+ * Pseudo parameter carrying the parameter set hash.
+ *
+ * Read with PARAM_REQUEST_READ, and sent after the last parameter of a list
+ * download. A ground station with a cached set of the same hash can skip the list.
+ */
+#define PARAM_HASH_CHECK_ID	"_HASH_CHECK"
+
+/**
+ * Pseudo parameter which requests a bulk export.
+ *
+ * Reading it writes all parameters to PARAM_BULK_FILE and replies with the hash
+ * of the exported set, the file can then be fetched with an FTP burst read.
+ */
+#define PARAM_BULK_ID		"_PARAM_FILE"
+#define PARAM_BULK_FILE		"/fs/microsd/.params.bin"
+
+/**
+ * PARAM_SETs arriving within this time of each other form one batch, which
+ * modules are notified of once (us).
+ */
+#define PARAM_SET_BATCH_TIMEOUT	100000
+
 class MavlinkParametersManager : public MavlinkStream
 {
 public:
@@ -63,6 +86,8 @@ public:
 		return MAVLINK_MSG_ID_PARAM_VALUE;
 	}
 
+	~MavlinkParametersManager();
+
 	static MavlinkStream *new_instance(Mavlink *mavlink)
 	{
 		return new MavlinkParametersManager(mavlink);
@@ -99,8 +124,24 @@ public:
 	 */
 	void		start_send_all();
 
+	/** Bulk file header, followed by count BulkRecord */
+	struct __attribute__((packed)) BulkHeader {
+		uint32_t	hash;		///< param_hash_check() of the exported set
+		uint16_t	count;		///< number of records
+	};
+
+	/** Bulk file record, one per int32 or float parameter */
+	struct __attribute__((packed)) BulkRecord {
+		uint16_t	index;		///< param_index as in PARAM_VALUE
+		char		id[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN];
+		uint8_t		type;		///< MAVLINK_TYPE_INT32_T or MAVLINK_TYPE_FLOAT
+		uint8_t		value[4];	///< little endian value
+	};
+
 private:
 	int		_send_all_index;
+	volatile bool	_set_batch_open;	///< a param_begin_batch() is held for a burst of PARAM_SETs
+	volatile hrt_abstime _set_batch_last;	///< time of the last PARAM_SET of the batch
 
 	/* do not allow top copying this class */
 	MavlinkParametersManager(MavlinkParametersManager &);
@@ -112,4 +153,20 @@ protected:
 	void send(const hrt_abstime t);
 
 	void send_param(param_t param);
+
+	/**
+	 * Send the parameter set hash as PARAM_VALUE with the given name.
+	 *
+	 * @param id		PARAM_HASH_CHECK_ID or PARAM_BULK_ID
+	 * @param hash		hash to send
+	 */
+	void send_hash(const char *id, uint32_t hash);
+
+	/**
+	 * Write all parameters to PARAM_BULK_FILE.
+	 *
+	 * @param hash		returns the hash of the exported set
+	 * @return		OK on success, -errno else.
+	 */
+	int export_bulk(uint32_t *hash);
 };
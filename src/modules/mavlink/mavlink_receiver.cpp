@@ -56,6 +56,7 @@
 #include <drivers/drv_mag.h>
 #include <drivers/drv_baro.h>
 #include <drivers/drv_range_finder.h>
+#include <drivers/drv_gps.h>
 #include <time.h>
 #include <float.h>
 #include <unistd.h>
@@ -86,6 +87,50 @@ __END_DECLS
 
 static const float mg2ms2 = CONSTANTS_ONE_G / 1000.0f;
 
+/* HIL_SENSOR fields_updated bits */
+#define HIL_SENSOR_ACCEL		((1 << 0) | (1 << 1) | (1 << 2))
+#define HIL_SENSOR_GYRO			((1 << 3) | (1 << 4) | (1 << 5))
+#define HIL_SENSOR_MAG			((1 << 6) | (1 << 7) | (1 << 8))
+#define HIL_SENSOR_BARO			((1 << 9) | (1 << 11) | (1 << 12))
+#define HIL_SENSOR_DIFF_PRESSURE	(1 << 10)
+#define HIL_SENSOR_ALL			0x1fff
+
+/* HIL battery status publication interval, microseconds */
+#define HIL_BATTERY_INTERVAL		100000
+
+static const uint8_t mavlink_message_crcs[256] = MAVLINK_MESSAGE_CRCS;
+
+const MavlinkReceiver::handler_entry_s MavlinkReceiver::_handlers[] = {
+	{MAVLINK_MSG_ID_COMMAND_LONG,			HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_command_long},
+	{MAVLINK_MSG_ID_COMMAND_INT,			HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_command_int},
+	{MAVLINK_MSG_ID_OPTICAL_FLOW,			HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_optical_flow},
+	{MAVLINK_MSG_ID_SET_MODE,			HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_set_mode},
+	{MAVLINK_MSG_ID_VICON_POSITION_ESTIMATE,	HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_vicon_position_estimate},
+	{MAVLINK_MSG_ID_SET_POSITION_TARGET_LOCAL_NED,	HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_set_position_target_local_ned},
+	{MAVLINK_MSG_ID_SET_ATTITUDE_TARGET,		HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_set_attitude_target},
+	{MAVLINK_MSG_ID_VISION_POSITION_ESTIMATE,	HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_vision_position_estimate},
+	{MAVLINK_MSG_ID_RADIO_STATUS,			HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_radio_status},
+	{MAVLINK_MSG_ID_GPS_INJECT_DATA,		HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_gps_inject_data},
+	{MAVLINK_MSG_ID_MANUAL_CONTROL,			HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_manual_control},
+	{MAVLINK_MSG_ID_HEARTBEAT,			HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_heartbeat},
+	{MAVLINK_MSG_ID_REQUEST_DATA_STREAM,		HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_request_data_stream},
+	{MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL,		HANDLER_ALWAYS,		&MavlinkReceiver::handle_message_file_transfer_protocol},
+	/*
+	 * Only decode hil messages in HIL mode.
+	 *
+	 * The HIL mode is enabled by the HIL bit flag
+	 * in the system mode. Either send a set mode
+	 * COMMAND_LONG message or a SET_MODE message
+	 *
+	 * Accept HIL GPS messages if use_hil_gps flag is true.
+	 * This allows to provide fake gps measurements to the system.
+	 */
+	{MAVLINK_MSG_ID_HIL_SENSOR,			HANDLER_HIL,		&MavlinkReceiver::handle_message_hil_sensor},
+	{MAVLINK_MSG_ID_HIL_STATE_QUATERNION,		HANDLER_HIL,		&MavlinkReceiver::handle_message_hil_state_quaternion},
+	{MAVLINK_MSG_ID_HIL_OPTICAL_FLOW,		HANDLER_HIL,		&MavlinkReceiver::handle_message_hil_optical_flow},
+	{MAVLINK_MSG_ID_HIL_GPS,			HANDLER_HIL_GPS,	&MavlinkReceiver::handle_message_hil_gps},
+};
+
 MavlinkReceiver::MavlinkReceiver(Mavlink *parent) :
 	_mavlink(parent),
 	status{},
@@ -116,13 +161,26 @@ MavlinkReceiver::MavlinkReceiver(Mavlink *parent) :
 	_telemetry_status_pub(-1),
 	_rc_pub(-1),
 	_manual_pub(-1),
+	_gps_inject_fd(-1),
 	_control_mode_sub(orb_subscribe(ORB_ID(vehicle_control_mode))),
 	_hil_frames(0),
 	_old_timestamp(0),
+	_hil_time_offset(0),
+	_hil_sim_last(0),
+	_hil_sensors{},
+	_hil_battery_last(0),
 	_hil_local_proj_inited(0),
 	_hil_local_alt0(0.0f),
-	_hil_local_proj_ref{}
+	_hil_local_proj_ref{},
+	_handler_index{},
+	_rx_frame{},
+	_rx_frame_len(0),
+	_rx_msg{}
 {
+	/* msgid lookup for the handler table */
+	for (unsigned i = 0; i < sizeof(_handlers) / sizeof(_handlers[0]); i++) {
+		_handler_index[_handlers[i].msgid] = i + 1;
+	}
 
 	// make sure the FTP server is started
 	(void)MavlinkFTP::get_server();
@@ -130,115 +188,51 @@ MavlinkReceiver::MavlinkReceiver(Mavlink *parent) :
 
 MavlinkReceiver::~MavlinkReceiver()
 {
+	if (_gps_inject_fd >= 0) {
+		close(_gps_inject_fd);
+	}
 }
 
 void
 MavlinkReceiver::handle_message(mavlink_message_t *msg)
 {
-	switch (msg->msgid) {
-	case MAVLINK_MSG_ID_COMMAND_LONG:
-		handle_message_command_long(msg);
-		break;
-
-	case MAVLINK_MSG_ID_COMMAND_INT:
-		handle_message_command_int(msg);
-		break;
-
-	case MAVLINK_MSG_ID_OPTICAL_FLOW:
-		handle_message_optical_flow(msg);
-		break;
-
-	case MAVLINK_MSG_ID_SET_MODE:
-		handle_message_set_mode(msg);
-		break;
-
-	case MAVLINK_MSG_ID_VICON_POSITION_ESTIMATE:
-		handle_message_vicon_position_estimate(msg);
-		break;
+	unsigned index = _handler_index[msg->msgid];
 
-	case MAVLINK_MSG_ID_SET_POSITION_TARGET_LOCAL_NED:
-		handle_message_set_position_target_local_ned(msg);
-		break;
-
-	case MAVLINK_MSG_ID_SET_ATTITUDE_TARGET:
-		handle_message_set_attitude_target(msg);
-		break;
-
-	case MAVLINK_MSG_ID_VISION_POSITION_ESTIMATE:
-		handle_message_vision_position_estimate(msg);
-		break;
-
-	case MAVLINK_MSG_ID_RADIO_STATUS:
-		handle_message_radio_status(msg);
-		break;
-
-	case MAVLINK_MSG_ID_MANUAL_CONTROL:
-		handle_message_manual_control(msg);
-		break;
-
-	case MAVLINK_MSG_ID_HEARTBEAT:
-		handle_message_heartbeat(msg);
-		break;
-
-	case MAVLINK_MSG_ID_REQUEST_DATA_STREAM:
-		handle_message_request_data_stream(msg);
-		break;
-
-	case MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL:
-		MavlinkFTP::get_server()->handle_message(_mavlink, msg);
-		break;
-
-	default:
-		break;
-	}
-
-	/*
-	 * Only decode hil messages in HIL mode.
-	 *
-	 * The HIL mode is enabled by the HIL bit flag
-	 * in the system mode. Either send a set mode
-	 * COMMAND_LONG message or a SET_MODE message
-	 *
-	 * Accept HIL GPS messages if use_hil_gps flag is true.
-	 * This allows to provide fake gps measurements to the system.
-	 */
-	if (_mavlink->get_hil_enabled()) {
-		switch (msg->msgid) {
-		case MAVLINK_MSG_ID_HIL_SENSOR:
-			handle_message_hil_sensor(msg);
-			break;
+	if (index > 0) {
+		const handler_entry_s *entry = &_handlers[index - 1];
+		bool enabled;
 
-		case MAVLINK_MSG_ID_HIL_STATE_QUATERNION:
-			handle_message_hil_state_quaternion(msg);
+		switch (entry->mode) {
+		case HANDLER_HIL:
+			enabled = _mavlink->get_hil_enabled();
 			break;
 
-		case MAVLINK_MSG_ID_HIL_OPTICAL_FLOW:
-			handle_message_hil_optical_flow(msg);
+		case HANDLER_HIL_GPS:
+			enabled = _mavlink->get_hil_enabled() ||
+				  (_mavlink->get_use_hil_gps() && msg->sysid == mavlink_system.sysid);
 			break;
 
 		default:
+			enabled = true;
 			break;
 		}
-	}
-
-
-   	if (_mavlink->get_hil_enabled() || (_mavlink->get_use_hil_gps() && msg->sysid == mavlink_system.sysid)) {
-		switch (msg->msgid) {
-		case MAVLINK_MSG_ID_HIL_GPS:
-			handle_message_hil_gps(msg);
-			break;
 
-		default:
-			break;
+		if (enabled) {
+			(this->*entry->handler)(msg);
 		}
-
 	}
 
-    /* If we've received a valid message, mark the flag indicating so.
+	/* If we've received a valid message, mark the flag indicating so.
 	   This is used in the '-w' command-line flag. */
 	_mavlink->set_has_received_messages(true);
 }
 
+void
+MavlinkReceiver::handle_message_file_transfer_protocol(mavlink_message_t *msg)
+{
+	MavlinkFTP::get_server()->handle_message(_mavlink, msg);
+}
+
 void
 MavlinkReceiver::handle_message_command_long(mavlink_message_t *msg)
 {
@@ -286,7 +280,7 @@ MavlinkReceiver::handle_message_command_long(mavlink_message_t *msg)
 			vcmd.confirmation =  cmd_mavlink.confirmation;
 
 			if (_cmd_pub < 0) {
-				_cmd_pub = orb_advertise(ORB_ID(vehicle_command), &vcmd);
+				_cmd_pub = orb_advertise_queue(ORB_ID(vehicle_command), &vcmd, VEHICLE_COMMAND_QUEUE_LENGTH);
 
 			} else {
 				orb_publish(ORB_ID(vehicle_command), _cmd_pub, &vcmd);
@@ -342,7 +336,7 @@ MavlinkReceiver::handle_message_command_int(mavlink_message_t *msg)
 			vcmd.source_component = msg->compid;
 
 			if (_cmd_pub < 0) {
-				_cmd_pub = orb_advertise(ORB_ID(vehicle_command), &vcmd);
+				_cmd_pub = orb_advertise_queue(ORB_ID(vehicle_command), &vcmd, VEHICLE_COMMAND_QUEUE_LENGTH);
 
 			} else {
 				orb_publish(ORB_ID(vehicle_command), _cmd_pub, &vcmd);
@@ -396,6 +390,10 @@ MavlinkReceiver::handle_message_hil_optical_flow(mavlink_message_t *msg)
 	f.ground_distance_m = flow.distance;
 	f.quality = flow.quality;
 	f.sensor_id = flow.sensor_id;
+	f.integration_timespan = flow.integration_time_us;
+	f.gyro_x_rate_integral = flow.integrated_xgyro;
+	f.gyro_y_rate_integral = flow.integrated_ygyro;
+	f.gyro_z_rate_integral = flow.integrated_zgyro;
 
 	if (_flow_pub < 0) {
 		_flow_pub = orb_advertise(ORB_ID(optical_flow), &f);
@@ -450,7 +448,7 @@ MavlinkReceiver::handle_message_set_mode(mavlink_message_t *msg)
 	vcmd.confirmation = 1;
 
 	if (_cmd_pub < 0) {
-		_cmd_pub = orb_advertise(ORB_ID(vehicle_command), &vcmd);
+		_cmd_pub = orb_advertise_queue(ORB_ID(vehicle_command), &vcmd, VEHICLE_COMMAND_QUEUE_LENGTH);
 
 	} else {
 		orb_publish(ORB_ID(vehicle_command), _cmd_pub, &vcmd);
@@ -710,6 +708,9 @@ MavlinkReceiver::handle_message_set_attitude_target(mavlink_message_t *msg)
 	mavlink_set_attitude_target_t set_attitude_target;
 	mavlink_msg_set_attitude_target_decode(msg, &set_attitude_target);
 
+	/* latency to the controller output is measured from here */
+	_mavlink->setpoint_received(hrt_absolute_time());
+
 	struct offboard_control_setpoint_s offboard_control_sp;
 	memset(&offboard_control_sp, 0, sizeof(offboard_control_sp)); //XXX breaks compatibility with multiple setpoints
 
@@ -834,6 +835,32 @@ MavlinkReceiver::handle_message_radio_status(mavlink_message_t *msg)
 	}
 }
 
+void
+MavlinkReceiver::handle_message_gps_inject_data(mavlink_message_t *msg)
+{
+	mavlink_gps_inject_data_t inject;
+	mavlink_msg_gps_inject_data_decode(msg, &inject);
+
+	if (inject.target_system != mavlink_system.sysid) {
+		return;
+	}
+
+	/* the gps driver takes the corrections as they are and forwards them to the receiver */
+	if (_gps_inject_fd < 0) {
+		_gps_inject_fd = open(GPS_DEVICE_PATH, O_WRONLY);
+
+		if (_gps_inject_fd < 0) {
+			return;
+		}
+	}
+
+	if (write(_gps_inject_fd, inject.data, (inject.len < sizeof(inject.data)) ? inject.len : sizeof(inject.data)) < 0) {
+		/* gps driver gone or started without injection, open again next time */
+		close(_gps_inject_fd);
+		_gps_inject_fd = -1;
+	}
+}
+
 void
 MavlinkReceiver::handle_message_manual_control(mavlink_message_t *msg)
 {
@@ -906,16 +933,47 @@ MavlinkReceiver::handle_message_request_data_stream(mavlink_message_t *msg)
 	}
 }
 
+uint64_t
+MavlinkReceiver::hil_timestamp(uint64_t sim_usec)
+{
+	/* how far the simulated time may trail before the sensor data counts as stale */
+	static const int64_t max_lag = 100000;
+
+	hrt_abstime now = hrt_absolute_time();
+
+	/* simulators that do not send their time */
+	if (sim_usec == 0) {
+		return now;
+	}
+
+	int64_t lag = (int64_t)now - (int64_t)(sim_usec + _hil_time_offset);
+
+	if (_hil_time_offset == 0 || sim_usec < _hil_sim_last || lag < 0 || lag > max_lag) {
+		_hil_time_offset = (int64_t)now - (int64_t)sim_usec;
+	}
+
+	_hil_sim_last = sim_usec;
+
+	return sim_usec + _hil_time_offset;
+}
+
 void
 MavlinkReceiver::handle_message_hil_sensor(mavlink_message_t *msg)
 {
 	mavlink_hil_sensor_t imu;
 	mavlink_msg_hil_sensor_decode(msg, &imu);
 
-	uint64_t timestamp = hrt_absolute_time();
+	uint64_t timestamp = hil_timestamp(imu.time_usec);
+
+	/*
+	 * Only publish the sensors the simulator updated, so an IMU rate
+	 * stream does not drag mag, baro and airspeed along with it. A
+	 * simulator that leaves fields_updated at 0 updates everything.
+	 */
+	uint32_t fields = (imu.fields_updated != 0) ? imu.fields_updated : HIL_SENSOR_ALL;
 
 	/* airspeed */
-	{
+	if (fields & HIL_SENSOR_DIFF_PRESSURE) {
 		struct airspeed_s airspeed;
 		memset(&airspeed, 0, sizeof(airspeed));
 
@@ -926,6 +984,7 @@ MavlinkReceiver::handle_message_hil_sensor(mavlink_message_t *msg)
 		airspeed.timestamp = timestamp;
 		airspeed.indicated_airspeed_m_s = ias;
 		airspeed.true_airspeed_m_s = tas;
+		airspeed.eas2tas = 1.0f;
 
 		if (_airspeed_pub < 0) {
 			_airspeed_pub = orb_advertise(ORB_ID(airspeed), &airspeed);
@@ -936,7 +995,7 @@ MavlinkReceiver::handle_message_hil_sensor(mavlink_message_t *msg)
 	}
 
 	/* gyro */
-	{
+	if (fields & HIL_SENSOR_GYRO) {
 		struct gyro_report gyro;
 		memset(&gyro, 0, sizeof(gyro));
 
@@ -950,15 +1009,15 @@ MavlinkReceiver::handle_message_hil_sensor(mavlink_message_t *msg)
 		gyro.temperature = imu.temperature;
 
 		if (_gyro_pub < 0) {
-			_gyro_pub = orb_advertise(ORB_ID(sensor_gyro0), &gyro);
+			_gyro_pub = orb_advertise(ORB_ID(sensor_gyro), &gyro);
 
 		} else {
-			orb_publish(ORB_ID(sensor_gyro0), _gyro_pub, &gyro);
+			orb_publish(ORB_ID(sensor_gyro), _gyro_pub, &gyro);
 		}
 	}
 
 	/* accelerometer */
-	{
+	if (fields & HIL_SENSOR_ACCEL) {
 		struct accel_report accel;
 		memset(&accel, 0, sizeof(accel));
 
@@ -972,15 +1031,15 @@ MavlinkReceiver::handle_message_hil_sensor(mavlink_message_t *msg)
 		accel.temperature = imu.temperature;
 
 		if (_accel_pub < 0) {
-			_accel_pub = orb_advertise(ORB_ID(sensor_accel0), &accel);
+			_accel_pub = orb_advertise(ORB_ID(sensor_accel), &accel);
 
 		} else {
-			orb_publish(ORB_ID(sensor_accel0), _accel_pub, &accel);
+			orb_publish(ORB_ID(sensor_accel), _accel_pub, &accel);
 		}
 	}
 
 	/* magnetometer */
-	{
+	if (fields & HIL_SENSOR_MAG) {
 		struct mag_report mag;
 		memset(&mag, 0, sizeof(mag));
 
@@ -1001,7 +1060,7 @@ MavlinkReceiver::handle_message_hil_sensor(mavlink_message_t *msg)
 	}
 
 	/* baro */
-	{
+	if (fields & HIL_SENSOR_BARO) {
 		struct baro_report baro;
 		memset(&baro, 0, sizeof(baro));
 
@@ -1018,52 +1077,57 @@ MavlinkReceiver::handle_message_hil_sensor(mavlink_message_t *msg)
 		}
 	}
 
-	/* sensor combined */
+	/* sensor combined, the sensors not updated keep their last values and timestamps */
 	{
-		struct sensor_combined_s hil_sensors;
-		memset(&hil_sensors, 0, sizeof(hil_sensors));
+		struct sensor_combined_s &hil_sensors = _hil_sensors;
 
 		hil_sensors.timestamp = timestamp;
 
-		hil_sensors.gyro_raw[0] = imu.xgyro * 1000.0f;
-		hil_sensors.gyro_raw[1] = imu.ygyro * 1000.0f;
-		hil_sensors.gyro_raw[2] = imu.zgyro * 1000.0f;
-		hil_sensors.gyro_rad_s[0] = imu.xgyro;
-		hil_sensors.gyro_rad_s[1] = imu.ygyro;
-		hil_sensors.gyro_rad_s[2] = imu.zgyro;
-
-		hil_sensors.accelerometer_raw[0] = imu.xacc / mg2ms2;
-		hil_sensors.accelerometer_raw[1] = imu.yacc / mg2ms2;
-		hil_sensors.accelerometer_raw[2] = imu.zacc / mg2ms2;
-		hil_sensors.accelerometer_m_s2[0] = imu.xacc;
-		hil_sensors.accelerometer_m_s2[1] = imu.yacc;
-		hil_sensors.accelerometer_m_s2[2] = imu.zacc;
-		hil_sensors.accelerometer_mode = 0; // TODO what is this?
-		hil_sensors.accelerometer_range_m_s2 = 32.7f; // int16
-		hil_sensors.accelerometer_timestamp = timestamp;
-
-		hil_sensors.adc_voltage_v[0] = 0.0f;
-		hil_sensors.adc_voltage_v[1] = 0.0f;
-		hil_sensors.adc_voltage_v[2] = 0.0f;
-
-		hil_sensors.magnetometer_raw[0] = imu.xmag * 1000.0f;
-		hil_sensors.magnetometer_raw[1] = imu.ymag * 1000.0f;
-		hil_sensors.magnetometer_raw[2] = imu.zmag * 1000.0f;
-		hil_sensors.magnetometer_ga[0] = imu.xmag;
-		hil_sensors.magnetometer_ga[1] = imu.ymag;
-		hil_sensors.magnetometer_ga[2] = imu.zmag;
-		hil_sensors.magnetometer_range_ga = 32.7f; // int16
-		hil_sensors.magnetometer_mode = 0; // TODO what is this
-		hil_sensors.magnetometer_cuttoff_freq_hz = 50.0f;
-		hil_sensors.magnetometer_timestamp = timestamp;
-
-		hil_sensors.baro_pres_mbar = imu.abs_pressure;
-		hil_sensors.baro_alt_meter = imu.pressure_alt;
-		hil_sensors.baro_temp_celcius = imu.temperature;
-		hil_sensors.baro_timestamp = timestamp;
-
-		hil_sensors.differential_pressure_pa = imu.diff_pressure * 1e2f; //from hPa to Pa
-		hil_sensors.differential_pressure_timestamp = timestamp;
+		if (fields & HIL_SENSOR_GYRO) {
+			hil_sensors.gyro_raw[0] = imu.xgyro * 1000.0f;
+			hil_sensors.gyro_raw[1] = imu.ygyro * 1000.0f;
+			hil_sensors.gyro_raw[2] = imu.zgyro * 1000.0f;
+			hil_sensors.gyro_rad_s[0] = imu.xgyro;
+			hil_sensors.gyro_rad_s[1] = imu.ygyro;
+			hil_sensors.gyro_rad_s[2] = imu.zgyro;
+		}
+
+		if (fields & HIL_SENSOR_ACCEL) {
+			hil_sensors.accelerometer_raw[0] = imu.xacc / mg2ms2;
+			hil_sensors.accelerometer_raw[1] = imu.yacc / mg2ms2;
+			hil_sensors.accelerometer_raw[2] = imu.zacc / mg2ms2;
+			hil_sensors.accelerometer_m_s2[0] = imu.xacc;
+			hil_sensors.accelerometer_m_s2[1] = imu.yacc;
+			hil_sensors.accelerometer_m_s2[2] = imu.zacc;
+			hil_sensors.accelerometer_mode = 0; // TODO what is this?
+			hil_sensors.accelerometer_range_m_s2 = 32.7f; // int16
+			hil_sensors.accelerometer_timestamp = timestamp;
+		}
+
+		if (fields & HIL_SENSOR_MAG) {
+			hil_sensors.magnetometer_raw[0] = imu.xmag * 1000.0f;
+			hil_sensors.magnetometer_raw[1] = imu.ymag * 1000.0f;
+			hil_sensors.magnetometer_raw[2] = imu.zmag * 1000.0f;
+			hil_sensors.magnetometer_ga[0] = imu.xmag;
+			hil_sensors.magnetometer_ga[1] = imu.ymag;
+			hil_sensors.magnetometer_ga[2] = imu.zmag;
+			hil_sensors.magnetometer_range_ga = 32.7f; // int16
+			hil_sensors.magnetometer_mode = 0; // TODO what is this
+			hil_sensors.magnetometer_cuttoff_freq_hz = 50.0f;
+			hil_sensors.magnetometer_timestamp = timestamp;
+		}
+
+		if (fields & HIL_SENSOR_BARO) {
+			hil_sensors.baro_pres_mbar = imu.abs_pressure;
+			hil_sensors.baro_alt_meter = imu.pressure_alt;
+			hil_sensors.baro_temp_celcius = imu.temperature;
+			hil_sensors.baro_timestamp = timestamp;
+		}
+
+		if (fields & HIL_SENSOR_DIFF_PRESSURE) {
+			hil_sensors.differential_pressure_pa = imu.diff_pressure * 1e2f; //from hPa to Pa
+			hil_sensors.differential_pressure_timestamp = timestamp;
+		}
 
 		/* publish combined sensor topic */
 		if (_sensors_pub < 0) {
@@ -1074,8 +1138,8 @@ MavlinkReceiver::handle_message_hil_sensor(mavlink_message_t *msg)
 		}
 	}
 
-	/* battery status */
-	{
+	/* battery status, constant, so it does not need the sensor rate */
+	if (timestamp - _hil_battery_last >= HIL_BATTERY_INTERVAL) {
 		struct battery_status_s hil_battery_status;
 		memset(&hil_battery_status, 0, sizeof(hil_battery_status));
 
@@ -1091,6 +1155,8 @@ MavlinkReceiver::handle_message_hil_sensor(mavlink_message_t *msg)
 		} else {
 			orb_publish(ORB_ID(battery_status), _battery_pub, &hil_battery_status);
 		}
+
+		_hil_battery_last = timestamp;
 	}
 
 	/* increment counters */
@@ -1163,6 +1229,7 @@ MavlinkReceiver::handle_message_hil_state_quaternion(mavlink_message_t *msg)
 		airspeed.timestamp = timestamp;
 		airspeed.indicated_airspeed_m_s = hil_state.ind_airspeed * 1e-2f;
 		airspeed.true_airspeed_m_s = hil_state.true_airspeed * 1e-2f;
+		airspeed.eas2tas = (airspeed.indicated_airspeed_m_s > 1.0f) ? airspeed.true_airspeed_m_s / airspeed.indicated_airspeed_m_s : 1.0f;
 
 		if (_airspeed_pub < 0) {
 			_airspeed_pub = orb_advertise(ORB_ID(airspeed), &airspeed);
@@ -1288,10 +1355,10 @@ MavlinkReceiver::handle_message_hil_state_quaternion(mavlink_message_t *msg)
 		accel.temperature = 25.0f;
 
 		if (_accel_pub < 0) {
-			_accel_pub = orb_advertise(ORB_ID(sensor_accel0), &accel);
+			_accel_pub = orb_advertise(ORB_ID(sensor_accel), &accel);
 
 		} else {
-			orb_publish(ORB_ID(sensor_accel0), _accel_pub, &accel);
+			orb_publish(ORB_ID(sensor_accel), _accel_pub, &accel);
 		}
 	}
 
@@ -1325,9 +1392,7 @@ MavlinkReceiver::receive_thread(void *arg)
 	int uart_fd = _mavlink->get_uart_fd();
 
 	const int timeout = 500;
-	uint8_t buf[32];
-
-	mavlink_message_t msg;
+	uint8_t buf[128];
 
 	/* set thread name */
 	char thread_name[24];
@@ -1349,25 +1414,102 @@ MavlinkReceiver::receive_thread(void *arg)
 				usleep(1000);
 			}
 
-			/* if read failed, this loop won't execute */
-			for (ssize_t i = 0; i < nread; i++) {
-				if (mavlink_parse_char(_mavlink->get_channel(), buf[i], &msg, &status)) {
-					/* handle generic messages and commands */
-					handle_message(&msg);
+			if (nread > 0) {
+				parse_buffer(buf, nread);
 
-					/* handle packet with parent object */
-					_mavlink->handle_message(&msg);
-				}
+				/* count received bytes */
+				_mavlink->count_rxbytes(nread);
 			}
-
-			/* count received bytes */
-			_mavlink->count_rxbytes(nread);
 		}
 	}
 
 	return NULL;
 }
 
+void
+MavlinkReceiver::parse_buffer(const uint8_t *buf, unsigned len)
+{
+	while (len > 0) {
+		if (_rx_frame_len == 0) {
+			/* skip to the next start of frame */
+			const uint8_t *stx = (const uint8_t *)memchr(buf, MAVLINK_STX, len);
+
+			if (stx == nullptr) {
+				return;
+			}
+
+			len -= stx - buf;
+			buf = stx;
+		}
+
+		/* the frame size is known once the length byte is in */
+		unsigned size = (_rx_frame_len < 2) ? 2 : _rx_frame[1] + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+		unsigned n = size - _rx_frame_len;
+
+		if (n > len) {
+			n = len;
+		}
+
+		memcpy(&_rx_frame[_rx_frame_len], buf, n);
+		_rx_frame_len += n;
+		buf += n;
+		len -= n;
+
+		/* a rejected frame can leave further complete frames in the buffer */
+		while (_rx_frame_len >= 2 && _rx_frame_len >= (unsigned)_rx_frame[1] + MAVLINK_NUM_NON_PAYLOAD_BYTES) {
+			parse_frame();
+		}
+	}
+}
+
+void
+MavlinkReceiver::parse_frame()
+{
+	uint8_t payload_len = _rx_frame[1];
+
+	uint16_t checksum;
+	crc_init(&checksum);
+	crc_accumulate_buffer(&checksum, (const char *) &_rx_frame[1], MAVLINK_CORE_HEADER_LEN + payload_len);
+	crc_accumulate(mavlink_message_crcs[_rx_frame[5]], &checksum);
+
+	unsigned consumed;
+
+	if (_rx_frame[MAVLINK_NUM_HEADER_BYTES + payload_len] == (uint8_t)(checksum & 0xFF) &&
+	    _rx_frame[MAVLINK_NUM_HEADER_BYTES + payload_len + 1] == (uint8_t)(checksum >> 8)) {
+
+		/* header and payload, same layout as in the frame */
+		memcpy(&_rx_msg.magic, &_rx_frame[0], MAVLINK_NUM_HEADER_BYTES + payload_len);
+		_rx_msg.checksum = checksum;
+		status.packet_rx_success_count++;
+		_mavlink->count_rxmsg();
+
+		/* handle generic messages and commands */
+		handle_message(&_rx_msg);
+
+		/* handle packet with parent object */
+		_mavlink->handle_message(&_rx_msg);
+
+		consumed = payload_len + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+
+	} else {
+		/* not a frame, resync after its start byte */
+		status.parse_error++;
+		_mavlink->count_rxerr();
+		consumed = 1;
+	}
+
+	/* keep the rest from the next start of frame on */
+	const uint8_t *stx = (const uint8_t *)memchr(&_rx_frame[consumed], MAVLINK_STX, _rx_frame_len - consumed);
+
+	if (stx != nullptr) {
+		_rx_frame_len -= stx - _rx_frame;
+		memmove(_rx_frame, stx, _rx_frame_len);
+
+	} else {
+		_rx_frame_len = 0;
+	}
+}
+
 void MavlinkReceiver::print_status()
 {
 
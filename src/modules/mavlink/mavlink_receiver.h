@@ -109,7 +109,21 @@ public:
 private:
 	Mavlink	*_mavlink;
 
+	/**
+	 * Frame all complete messages in a block of received bytes and handle them.
+	 *
+	 * Partial frames are kept until the next call.
+	 */
+	void parse_buffer(const uint8_t *buf, unsigned len);
+
+	/**
+	 * Check the complete frame at the start of the frame buffer, handle it if valid
+	 * and keep the remaining bytes from the next start of frame on.
+	 */
+	void parse_frame();
+
 	void handle_message(mavlink_message_t *msg);
+	void handle_message_file_transfer_protocol(mavlink_message_t *msg);
 	void handle_message_command_long(mavlink_message_t *msg);
 	void handle_message_command_int(mavlink_message_t *msg);
 	void handle_message_optical_flow(mavlink_message_t *msg);
@@ -121,6 +135,7 @@ private:
 	void handle_message_set_position_target_local_ned(mavlink_message_t *msg);
 	void handle_message_set_attitude_target(mavlink_message_t *msg);
 	void handle_message_radio_status(mavlink_message_t *msg);
+	void handle_message_gps_inject_data(mavlink_message_t *msg);
 	void handle_message_manual_control(mavlink_message_t *msg);
 	void handle_message_heartbeat(mavlink_message_t *msg);
 	void handle_message_request_data_stream(mavlink_message_t *msg);
@@ -128,8 +143,40 @@ private:
 	void handle_message_hil_gps(mavlink_message_t *msg);
 	void handle_message_hil_state_quaternion(mavlink_message_t *msg);
 
+	/**
+	 * Local time of a simulator timestamp.
+	 *
+	 * Sensor timestamps follow the simulator clock, so the estimators and
+	 * controllers see the simulated time steps instead of the jitter of
+	 * the link. The mapping is re-anchored to hrt_absolute_time() when
+	 * the simulator clock would run ahead of it, falls too far behind or
+	 * restarts.
+	 */
+	uint64_t hil_timestamp(uint64_t sim_usec);
+
 	void *receive_thread(void *arg);
 
+	typedef void (MavlinkReceiver::*handler_t)(mavlink_message_t *msg);
+
+	enum HANDLER_MODE {
+		HANDLER_ALWAYS = 0,	///< always handled
+		HANDLER_HIL,		///< handled in HIL mode only
+		HANDLER_HIL_GPS		///< handled in HIL mode or with HIL GPS enabled
+	};
+
+	struct handler_entry_s {
+		uint8_t		msgid;
+		uint8_t		mode;		///< HANDLER_MODE
+		handler_t	handler;
+	};
+
+	static const handler_entry_s _handlers[];	///< msgid to handler table
+	uint8_t	_handler_index[256];		///< _handlers index + 1 per msgid, 0 if not handled
+
+	uint8_t	_rx_frame[MAVLINK_MAX_PACKET_LEN];	///< frame being received, starts with MAVLINK_STX
+	unsigned _rx_frame_len;
+	mavlink_message_t _rx_msg;
+
 	mavlink_status_t status;
 	struct vehicle_local_position_s hil_local_pos;
 	struct vehicle_control_mode_s _control_mode;
@@ -158,9 +205,14 @@ private:
 	orb_advert_t _telemetry_status_pub;
 	orb_advert_t _rc_pub;
 	orb_advert_t _manual_pub;
+	int _gps_inject_fd;			///< gps driver device for correction injection, opened on first use
 	int _control_mode_sub;
 	int _hil_frames;
 	uint64_t _old_timestamp;
+	int64_t _hil_time_offset;		///< local time minus simulator time, 0 until the first HIL message
+	uint64_t _hil_sim_last;			///< last simulator time mapped
+	struct sensor_combined_s _hil_sensors;	///< combined HIL sensors, updated field by field
+	uint64_t _hil_battery_last;		///< last HIL battery status publication
 	bool _hil_local_proj_inited;
 	float _hil_local_alt0;
 	struct map_projection_reference_s _hil_local_proj_ref;
@@ -42,12 +42,41 @@
 
 #include "mavlink_stream.h"
 #include "mavlink_main.h"
+#include "mavlink_orb_subscription.h"
+
+#include <systemlib/mem_pool.h>
+
+/* stream objects, by size; the pointer and timestamp members of a stream fit the first class */
+static struct mem_pool_s stream_pools[] = {
+	MEM_POOL_INITIALIZER("mavlink streams", 128, 24),
+	MEM_POOL_INITIALIZER("mavlink streams", 256, 16),
+};
+
+void *
+MavlinkStream::operator new(size_t size)
+{
+	return mem_pool_alloc_sized(stream_pools, sizeof(stream_pools) / sizeof(stream_pools[0]), size);
+}
+
+void
+MavlinkStream::operator delete(void *p)
+{
+	mem_pool_free_sized(stream_pools, sizeof(stream_pools) / sizeof(stream_pools[0]), p);
+}
 
 MavlinkStream::MavlinkStream(Mavlink *mavlink) :
 	next(nullptr),
 	_mavlink(mavlink),
 	_interval(1000000),
-	_last_sent(0)
+	_last_sent(0),
+	_next_due(0),
+	_rate_mult(1.0f),
+	_sent_count(0),
+	_rate_achieved(0.0f),
+	_on_change(false),
+	_subs{},
+	_subs_num(0),
+	_topics_time(0)
 {
 }
 
@@ -62,6 +91,19 @@ void
 MavlinkStream::set_interval(const unsigned int interval)
 {
 	_interval = interval;
+	update_next_due();
+}
+
+void
+MavlinkStream::update_next_due()
+{
+	unsigned int interval = _interval;
+
+	if (!const_rate()) {
+		interval /= _rate_mult;
+	}
+
+	_next_due = _last_sent + interval;
 }
 
 /**
@@ -74,12 +116,31 @@ MavlinkStream::update(const hrt_abstime t)
 	unsigned int interval = _interval;
 
 	if (!const_rate()) {
-		interval /= _mavlink->get_rate_mult();
+		interval /= _rate_mult;
 	}
 
 	if (dt > 0 && dt >= interval) {
+		uint64_t topics_time = 0;
+
+		if (_on_change && _subs_num > 0) {
+			topics_time = get_topics_time();
+
+			/* nothing published since the last message */
+			if (topics_time <= _topics_time) {
+				return -1;
+			}
+		}
+
+		/* wait for link bandwidth, lower priority streams are held back first */
+		if (!const_rate() && !_mavlink->tx_tokens_take(t, get_size(), get_priority())) {
+			return -1;
+		}
+
 		/* interval expired, send message */
 		send(t);
+		_sent_count++;
+		_topics_time = topics_time;
+
 		if (const_rate()) {
 			_last_sent = (t / _interval) * _interval;
 
@@ -87,8 +148,38 @@ MavlinkStream::update(const hrt_abstime t)
 			_last_sent = t;
 		}
 
+		update_next_due();
+
 		return 0;
 	}
 
 	return -1;
 }
+
+MavlinkOrbSubscription *
+MavlinkStream::add_orb_subscription(const orb_id_t topic)
+{
+	MavlinkOrbSubscription *sub = _mavlink->add_orb_subscription(topic);
+
+	if (_subs_num < MAVLINK_STREAM_MAX_SUBS) {
+		_subs[_subs_num++] = sub;
+	}
+
+	return sub;
+}
+
+uint64_t
+MavlinkStream::get_topics_time()
+{
+	uint64_t time = 0;
+
+	for (unsigned i = 0; i < _subs_num; i++) {
+		uint64_t time_topic = _subs[i]->get_last_update();
+
+		if (time_topic > time) {
+			time = time_topic;
+		}
+	}
+
+	return time;
+}
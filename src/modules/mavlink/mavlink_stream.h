@@ -42,9 +42,13 @@
 #define MAVLINK_STREAM_H_
 
 #include <drivers/drv_hrt.h>
+#include <uORB/uORB.h>
 
 class Mavlink;
 class MavlinkStream;
+class MavlinkOrbSubscription;
+
+#define MAVLINK_STREAM_MAX_SUBS	8	///< subscriptions tracked per stream for the on-change mode
 
 class MavlinkStream
 {
@@ -52,9 +56,25 @@ class MavlinkStream
 public:
 	MavlinkStream *next;
 
+	/**
+	 * Stream priorities, the link bandwidth is handed out in this order
+	 */
+	enum {
+		PRIORITY_HIGH = 0,
+		PRIORITY_NORMAL,
+		PRIORITY_LOW,
+		PRIORITY_NUM
+	};
+
 	MavlinkStream(Mavlink *mavlink);
 	virtual ~MavlinkStream();
 
+	/**
+	 * Streams are allocated from size class pools, they come and go with configure_stream()
+	 */
+	static void *operator new(size_t size);
+	static void operator delete(void *p);
+
 	/**
 	 * Get the interval
 	 *
@@ -83,6 +103,45 @@ public:
 	 */
 	virtual bool const_rate() { return false; }
 
+	/**
+	 * @return priority of the stream, one of PRIORITY_HIGH ... PRIORITY_LOW
+	 */
+	virtual unsigned get_priority() { return PRIORITY_NORMAL; }
+
+	/**
+	 * Set the rate multiplier the scheduler assigned to this stream
+	 *
+	 * @param rate_mult multiplier for the configured rate, at most 1
+	 */
+	void set_rate_mult(const float rate_mult) { _rate_mult = rate_mult; update_next_due(); }
+
+	float get_rate_mult() { return _rate_mult; }
+
+	/**
+	 * Only send when one of the topics of the stream was published since the last message.
+	 * Streams without topics are not affected.
+	 */
+	void set_on_change(const bool on_change) { _on_change = on_change; }
+
+	bool get_on_change() { return _on_change; }
+
+	/**
+	 * @return time the next message is due, update() does nothing before
+	 */
+	hrt_abstime get_next_due() { return _next_due; }
+
+	/**
+	 * @return messages sent since the last call, for the achieved rate
+	 */
+	unsigned get_sent_count() { unsigned n = _sent_count; _sent_count = 0; return n; }
+
+	/**
+	 * Achieved rate as measured by the instance once per second
+	 */
+	void set_rate_achieved(const float rate) { _rate_achieved = rate; }
+
+	float get_rate_achieved() { return _rate_achieved; }
+
 	/**
 	 * Get maximal total messages size on update
 	 */
@@ -94,8 +153,31 @@ protected:
 
 	virtual void send(const hrt_abstime t) = 0;
 
+	/**
+	 * Subscribe to a topic of the mavlink instance and track it for the on-change mode
+	 */
+	MavlinkOrbSubscription *add_orb_subscription(const orb_id_t topic);
+
 private:
 	hrt_abstime _last_sent;
+	hrt_abstime _next_due;
+	float _rate_mult;
+	unsigned _sent_count;
+	float _rate_achieved;
+	bool _on_change;
+	MavlinkOrbSubscription *_subs[MAVLINK_STREAM_MAX_SUBS];
+	unsigned _subs_num;
+	uint64_t _topics_time;		///< latest publication of the stream topics when last sent
+
+	/**
+	 * @return latest publication time of the stream topics
+	 */
+	uint64_t get_topics_time();
+
+	/**
+	 * Recalculate the next due time from the last message, interval and rate multiplier
+	 */
+	void update_next_due();
 
 	/* do not allow top copying this class */
 	MavlinkStream(const MavlinkStream&);
@@ -55,7 +55,12 @@ const char MavlinkFtpTest::_unittest_microsd_file[] = "/fs/microsd/ftp_unit_test
 MavlinkFtpTest::MavlinkFtpTest() :
 	_ftp_server{},
 	_reply_msg{},
-	_lastOutgoingSeqNumber{}
+	_lastOutgoingSeqNumber{},
+	_burst_active(false),
+	_burst_complete(false),
+	_burst_error(false),
+	_burst_size(0),
+	_burst_data{}
 {
 }
 
@@ -649,6 +654,83 @@ bool MavlinkFtpTest::_removefile_test(void)
 	return true;
 }
 
+/// @brief Tests for correct reponse to a Burst Read command. The whole file must arrive in order
+/// on a single request.
+bool MavlinkFtpTest::_burst_test(void)
+{
+	MavlinkFTP::PayloadHeader		payload;
+	mavlink_file_transfer_protocol_t	ftp_msg;
+	MavlinkFTP::PayloadHeader		*reply;
+	
+	for (size_t i=0; i<sizeof(_rgReadTestCases)/sizeof(_rgReadTestCases[0]); i++) {
+		struct stat st;
+		const ReadTestCase *test = &_rgReadTestCases[i];
+		
+		// Read in the file so we can compare it to what we get back
+		ut_compare("stat failed", stat(test->file, &st), 0);
+		ut_assert("Test file too large", st.st_size <= (off_t)_burst_max_size);
+		uint8_t *bytes = new uint8_t[st.st_size];
+		ut_assert("new failed", bytes != nullptr);
+		int fd = ::open(test->file, O_RDONLY);
+		ut_assert("open failed", fd != -1);
+		int bytes_read = ::read(fd, bytes, st.st_size);
+		ut_compare("read failed", bytes_read, st.st_size);
+		::close(fd);
+		
+		payload.opcode = MavlinkFTP::kCmdOpenFileRO;
+		payload.offset = 0;
+		
+		bool success = _send_receive_msg(&payload,		// FTP payload header
+						 strlen(test->file)+1,	// size in bytes of data
+						 (uint8_t*)test->file,	// Data to start into FTP message payload
+						 &ftp_msg,		// Response from server
+						 &reply);		// Payload inside FTP message response
+		if (!success) {
+			delete[] bytes;
+			return false;
+		}
+		
+		ut_compare("Didn't get Ack back", reply->opcode, MavlinkFTP::kRspAck);
+		
+		payload.opcode = MavlinkFTP::kCmdBurstReadFile;
+		payload.session = reply->session;
+		payload.offset = 0;
+		
+		// Replies are checked and collected by _receive_message while the burst runs
+		mavlink_message_t msg;
+		_burst_active = true;
+		_burst_complete = false;
+		_burst_error = false;
+		_burst_size = 0;
+		_setup_ftp_msg(&payload, 0, nullptr, &msg);
+		_ftp_server->handle_message(nullptr /* mavlink */, &msg);
+		_burst_active = false;
+		
+		ut_assert("Burst reply out of sequence", !_burst_error);
+		ut_assert("Burst not completed", _burst_complete);
+		ut_compare("Burst size incorrect", _burst_size, (unsigned)st.st_size);
+		ut_compare("File contents differ", memcmp(_burst_data, bytes, st.st_size), 0);
+		delete[] bytes;
+		
+		payload.opcode = MavlinkFTP::kCmdTerminateSession;
+		payload.session = reply->session;
+		payload.size = 0;
+		
+		success = _send_receive_msg(&payload,	// FTP payload header
+					    0,		// size in bytes of data
+					    nullptr,	// Data to start into FTP message payload
+					    &ftp_msg,	// Response from server
+					    &reply);	// Payload inside FTP message response
+		if (!success) {
+			return false;
+		}
+		
+		ut_compare("Didn't get Ack back", reply->opcode, MavlinkFTP::kRspAck);
+	}
+	
+	return true;
+}
+
 /// @brief Static method used as callback from MavlinkFTP. This method will be called by MavlinkFTP when
 /// it needs to send a message out on Mavlink.
 void MavlinkFtpTest::receive_message(const mavlink_message_t *msg, MavlinkFtpTest *ftp_test)
@@ -661,6 +743,38 @@ void MavlinkFtpTest::_receive_message(const mavlink_message_t *msg)
 {
 	// Move the message into our own member variable
 	memcpy(&_reply_msg, msg, sizeof(mavlink_message_t));
+
+	if (!_burst_active) {
+		return;
+	}
+
+	mavlink_file_transfer_protocol_t ftp_msg;
+	mavlink_msg_file_transfer_protocol_decode(msg, &ftp_msg);
+	MavlinkFTP::PayloadHeader *payload = reinterpret_cast<MavlinkFTP::PayloadHeader *>(ftp_msg.payload);
+
+	if (_burst_complete ||
+	    payload->req_opcode != MavlinkFTP::kCmdBurstReadFile ||
+	    payload->seqNumber != (uint16_t)(_lastOutgoingSeqNumber + 1)) {
+		_burst_error = true;
+		return;
+	}
+	_lastOutgoingSeqNumber++;
+	_burst_complete = payload->burst_complete;
+
+	if (payload->opcode == MavlinkFTP::kRspNak) {
+		// end of file is a normal end of a burst which ends on a packet boundary
+		if (payload->data[0] != MavlinkFTP::kErrEOF) {
+			_burst_error = true;
+		}
+		return;
+	}
+
+	if (payload->offset != _burst_size || _burst_size + payload->size > _burst_max_size) {
+		_burst_error = true;
+		return;
+	}
+	memcpy(&_burst_data[_burst_size], payload->data, payload->size);
+	_burst_size += payload->size;
 }
 
 /// @brief Decode and validate the incoming message
@@ -703,8 +817,8 @@ void MavlinkFtpTest::_setup_ftp_msg(MavlinkFTP::PayloadHeader	*payload_header,	/
 		memcpy(payload->data, data, size);
 	}
     
+	payload->burst_complete = 0;
 	payload->padding[0] = 0;
-	payload->padding[1] = 0;
 	
 	msg->checksum = 0;
 	mavlink_msg_file_transfer_protocol_pack(clientSystemId,		// Sender system id
@@ -750,6 +864,7 @@ bool MavlinkFtpTest::run_tests(void)
 	ut_run_test(_terminate_badsession_test);
 	ut_run_test(_read_test);
 	ut_run_test(_read_badsession_test);
+	ut_run_test(_burst_test);
 	ut_run_test(_removedirectory_test);
 	ut_run_test(_createdirectory_test);
 	ut_run_test(_removefile_test);
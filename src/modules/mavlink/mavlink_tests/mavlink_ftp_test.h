@@ -75,6 +75,7 @@ private:
 	bool _terminate_badsession_test(void);
 	bool _read_test(void);
 	bool _read_badsession_test(void);
+	bool _burst_test(void);
 	bool _removedirectory_test(void);
 	bool _createdirectory_test(void);
 	bool _removefile_test(void);
@@ -95,6 +96,13 @@ private:
     
 	uint16_t _lastOutgoingSeqNumber;
 	
+	static const unsigned _burst_max_size = 1024;	///< Largest file _burst_test can collect
+	bool		_burst_active;			///< true: replies are collected into _burst_data
+	bool		_burst_complete;		///< true: reply with burst_complete set was received
+	bool		_burst_error;			///< true: reply out of sequence, bad offset or Nak other than EOF
+	unsigned	_burst_size;			///< Bytes collected into _burst_data
+	uint8_t		_burst_data[_burst_max_size];
+	
 	struct ReadTestCase {
 		const char	*file;
 		const uint16_t	length;
@@ -40,6 +40,7 @@
  * @author Anton Babushkin <anton.babushkin@me.com>
  *
  * The controller has two loops: P loop for angular error and PD loop for angular rate error.
+ * The rate loop runs on every gyro sample, the attitude loop on every attitude estimate.
  * Desired rotation calculated keeping in mind that yaw response is normally slower than roll/pitch.
  * For small deviations controller rotates copter to have shortest path of thrust vector and independently rotates around yaw,
  * so actual rotation axis is not constant. For large deviations controller rotates copter around fixed axis.
@@ -65,15 +66,18 @@
 #include <uORB/topics/actuator_controls.h>
 #include <uORB/topics/vehicle_rates_setpoint.h>
 #include <uORB/topics/vehicle_attitude.h>
+#include <uORB/topics/sensor_combined.h>
 #include <uORB/topics/vehicle_control_mode.h>
 #include <uORB/topics/actuator_armed.h>
 #include <uORB/topics/parameter_update.h>
 #include <systemlib/param/param.h>
 #include <systemlib/err.h>
 #include <systemlib/perf_counter.h>
+#include <systemlib/deadline.h>
 #include <systemlib/systemlib.h>
 #include <systemlib/circuit_breaker.h>
 #include <lib/mathlib/mathlib.h>
+#include <lib/mathlib/math/filter/LowPassFilter2p.hpp>
 #include <lib/geo/geo.h>
 
 /**
@@ -83,9 +87,40 @@
  */
 extern "C" __EXPORT int mc_att_control_main(int argc, char *argv[]);
 
+/* parameters defined in mc_att_control_params.c */
+PARAM_DECLARE(MC_ROLL_P);
+PARAM_DECLARE(MC_ROLLRATE_P);
+PARAM_DECLARE(MC_ROLLRATE_I);
+PARAM_DECLARE(MC_ROLLRATE_D);
+PARAM_DECLARE(MC_ROLLRATE_FF);
+PARAM_DECLARE(MC_PITCH_P);
+PARAM_DECLARE(MC_PITCHRATE_P);
+PARAM_DECLARE(MC_PITCHRATE_I);
+PARAM_DECLARE(MC_PITCHRATE_D);
+PARAM_DECLARE(MC_PITCHRATE_FF);
+PARAM_DECLARE(MC_YAW_P);
+PARAM_DECLARE(MC_YAWRATE_P);
+PARAM_DECLARE(MC_YAWRATE_I);
+PARAM_DECLARE(MC_YAWRATE_D);
+PARAM_DECLARE(MC_YAWRATE_FF);
+PARAM_DECLARE(MC_DTERM_CUTOFF);
+PARAM_DECLARE(MC_YAW_FF);
+PARAM_DECLARE(MC_YAWRATE_MAX);
+PARAM_DECLARE(MC_MAN_R_MAX);
+PARAM_DECLARE(MC_MAN_P_MAX);
+PARAM_DECLARE(MC_MAN_Y_MAX);
+PARAM_DECLARE(MC_ACRO_R_MAX);
+PARAM_DECLARE(MC_ACRO_P_MAX);
+PARAM_DECLARE(MC_ACRO_Y_MAX);
+
 #define YAW_DEADZONE	0.05f
 #define MIN_TAKEOFF_THRUST    0.2f
 #define RATES_I_LIMIT	0.3f
+#define DEADLINE_PERIOD	20000	/**< longest interval between iterations the controller handles, see the dt guard */
+#define DEADLINE_BUDGET	1000	/**< time an iteration may take, one gyro period */
+#define GYRO_TIMEOUT	20000	/**< gyro age after which the rate loop runs on the attitude rates */
+#define DTERM_RATE_INIT	1000.0f	/**< rate loop frequency assumed for the D term filter until measured */
+#define DTERM_RATE_TOL	0.1f	/**< relative change of the loop frequency that recomputes the D term filter */
 
 class MulticopterAttitudeControl
 {
@@ -113,6 +148,7 @@ private:
 	int		_control_task;			/**< task handle for sensor task */
 
 	int		_v_att_sub;				/**< vehicle attitude subscription */
+	int		_sensor_combined_sub;	/**< sensor data subscription, gyro samples drive the rate loop */
 	int		_v_att_sp_sub;			/**< vehicle attitude setpoint subscription */
 	int		_v_rates_sp_sub;		/**< vehicle rates setpoint subscription */
 	int		_v_control_mode_sub;	/**< vehicle control mode subscription */
@@ -127,6 +163,7 @@ private:
 	bool		_actuators_0_circuit_breaker_enabled;	/**< circuit breaker to suppress output */
 
 	struct vehicle_attitude_s			_v_att;				/**< vehicle attitude */
+	struct sensor_combined_s			_sensor_combined;	/**< sensor data, for the gyro */
 	struct vehicle_attitude_setpoint_s	_v_att_sp;			/**< vehicle attitude setpoint */
 	struct vehicle_rates_setpoint_s		_v_rates_sp;		/**< vehicle rates setpoint */
 	struct manual_control_setpoint_s	_manual_control_sp;	/**< manual control setpoint */
@@ -135,8 +172,13 @@ private:
 	struct actuator_armed_s				_armed;				/**< actuator arming status */
 
 	perf_counter_t	_loop_perf;			/**< loop performance counter */
+	deadline_t	_deadline;			/**< overrun monitor of the loop */
 
+	math::Vector<3>		_rates;			/**< measured angular rates */
 	math::Vector<3>		_rates_prev;	/**< angular rates on previous step */
+	math::LowPassFilter2pN<3>	_rates_d_filter;	/**< filter of the angular rates derivative */
+	float				_rates_d_filter_rate;	/**< loop frequency the D term filter is designed for */
+	float				_rates_loop_rate;	/**< smoothed rate loop frequency */
 	math::Vector<3>		_rates_sp;		/**< angular rates setpoint */
 	math::Vector<3>		_rates_int;		/**< angular rates integral error */
 	float				_thrust_sp;		/**< thrust setpoint */
@@ -146,19 +188,27 @@ private:
 
 	bool	_reset_yaw_sp;			/**< reset yaw setpoint flag */
 
+	hrt_abstime	_att_last_run;		/**< last run of the attitude loop */
+	hrt_abstime	_rates_last_run;	/**< last run of the rate loop */
+	hrt_abstime	_gyro_last;			/**< last gyro sample received */
+
 	struct {
 		param_t roll_p;
 		param_t roll_rate_p;
 		param_t roll_rate_i;
 		param_t roll_rate_d;
+		param_t roll_rate_ff;
 		param_t pitch_p;
 		param_t pitch_rate_p;
 		param_t pitch_rate_i;
 		param_t pitch_rate_d;
+		param_t pitch_rate_ff;
 		param_t yaw_p;
 		param_t yaw_rate_p;
 		param_t yaw_rate_i;
 		param_t yaw_rate_d;
+		param_t yaw_rate_ff;
+		param_t dterm_cutoff;
 		param_t yaw_ff;
 		param_t yaw_rate_max;
 
@@ -175,6 +225,8 @@ private:
 		math::Vector<3> rate_p;				/**< P gain for angular rate error */
 		math::Vector<3> rate_i;				/**< I gain for angular rate error */
 		math::Vector<3> rate_d;				/**< D gain for angular rate error */
+		math::Vector<3> rate_ff;			/**< feed forward gain for angular rate setpoint */
+		float dterm_cutoff;					/**< cutoff frequency of the D term filter, 0 disables it */
 		float yaw_ff;						/**< yaw control feed-forward */
 		float yaw_rate_max;					/**< max yaw rate */
 
@@ -225,7 +277,7 @@ private:
 	void		control_attitude(float dt);
 
 	/**
-	 * Attitude rates controller.
+	 * Attitude rates controller, on the rates in _rates.
 	 */
 	void		control_attitude_rates(float dt);
 
@@ -259,6 +311,7 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 
 /* subscriptions */
 	_v_att_sub(-1),
+	_sensor_combined_sub(-1),
 	_v_att_sp_sub(-1),
 	_v_control_mode_sub(-1),
 	_params_sub(-1),
@@ -273,10 +326,14 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 	_actuators_0_circuit_breaker_enabled(false),
 
 /* performance counters */
-	_loop_perf(perf_alloc(PC_ELAPSED, "mc_att_control"))
+	_loop_perf(perf_alloc(PC_ELAPSED, "mc_att_control")),
+	_deadline(deadline_alloc("mc_att_control", DEADLINE_PERIOD, DEADLINE_BUDGET)),
+
+	_rates_d_filter(DTERM_RATE_INIT, 0.0f)
 
 {
 	memset(&_v_att, 0, sizeof(_v_att));
+	memset(&_sensor_combined, 0, sizeof(_sensor_combined));
 	memset(&_v_att_sp, 0, sizeof(_v_att_sp));
 	memset(&_v_rates_sp, 0, sizeof(_v_rates_sp));
 	memset(&_manual_control_sp, 0, sizeof(_manual_control_sp));
@@ -288,6 +345,8 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 	_params.rate_p.zero();
 	_params.rate_i.zero();
 	_params.rate_d.zero();
+	_params.rate_ff.zero();
+	_params.dterm_cutoff = 0.0f;
 	_params.yaw_ff = 0.0f;
 	_params.yaw_rate_max = 0.0f;
 	_params.man_roll_max = 0.0f;
@@ -295,7 +354,10 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 	_params.man_yaw_max = 0.0f;
 	_params.acro_rate_max.zero();
 
+	_rates.zero();
 	_rates_prev.zero();
+	_rates_d_filter_rate = DTERM_RATE_INIT;
+	_rates_loop_rate = DTERM_RATE_INIT;
 	_rates_sp.zero();
 	_rates_int.zero();
 	_thrust_sp = 0.0f;
@@ -303,26 +365,34 @@ MulticopterAttitudeControl::MulticopterAttitudeControl() :
 
 	_I.identity();
 
-	_params_handles.roll_p			= 	param_find("MC_ROLL_P");
-	_params_handles.roll_rate_p		= 	param_find("MC_ROLLRATE_P");
-	_params_handles.roll_rate_i		= 	param_find("MC_ROLLRATE_I");
-	_params_handles.roll_rate_d		= 	param_find("MC_ROLLRATE_D");
-	_params_handles.pitch_p			= 	param_find("MC_PITCH_P");
-	_params_handles.pitch_rate_p	= 	param_find("MC_PITCHRATE_P");
-	_params_handles.pitch_rate_i	= 	param_find("MC_PITCHRATE_I");
-	_params_handles.pitch_rate_d	= 	param_find("MC_PITCHRATE_D");
-	_params_handles.yaw_p			=	param_find("MC_YAW_P");
-	_params_handles.yaw_rate_p		= 	param_find("MC_YAWRATE_P");
-	_params_handles.yaw_rate_i		= 	param_find("MC_YAWRATE_I");
-	_params_handles.yaw_rate_d		= 	param_find("MC_YAWRATE_D");
-	_params_handles.yaw_ff			= 	param_find("MC_YAW_FF");
-	_params_handles.yaw_rate_max	= 	param_find("MC_YAWRATE_MAX");
-	_params_handles.man_roll_max	= 	param_find("MC_MAN_R_MAX");
-	_params_handles.man_pitch_max	= 	param_find("MC_MAN_P_MAX");
-	_params_handles.man_yaw_max		= 	param_find("MC_MAN_Y_MAX");
-	_params_handles.acro_roll_max	= 	param_find("MC_ACRO_R_MAX");
-	_params_handles.acro_pitch_max	= 	param_find("MC_ACRO_P_MAX");
-	_params_handles.acro_yaw_max		= 	param_find("MC_ACRO_Y_MAX");
+	_att_last_run = 0;
+	_rates_last_run = 0;
+	_gyro_last = 0;
+
+	_params_handles.roll_p			= 	PARAM_HANDLE(MC_ROLL_P);
+	_params_handles.roll_rate_p		= 	PARAM_HANDLE(MC_ROLLRATE_P);
+	_params_handles.roll_rate_i		= 	PARAM_HANDLE(MC_ROLLRATE_I);
+	_params_handles.roll_rate_d		= 	PARAM_HANDLE(MC_ROLLRATE_D);
+	_params_handles.roll_rate_ff	= 	PARAM_HANDLE(MC_ROLLRATE_FF);
+	_params_handles.pitch_p			= 	PARAM_HANDLE(MC_PITCH_P);
+	_params_handles.pitch_rate_p	= 	PARAM_HANDLE(MC_PITCHRATE_P);
+	_params_handles.pitch_rate_i	= 	PARAM_HANDLE(MC_PITCHRATE_I);
+	_params_handles.pitch_rate_d	= 	PARAM_HANDLE(MC_PITCHRATE_D);
+	_params_handles.pitch_rate_ff	= 	PARAM_HANDLE(MC_PITCHRATE_FF);
+	_params_handles.yaw_p			=	PARAM_HANDLE(MC_YAW_P);
+	_params_handles.yaw_rate_p		= 	PARAM_HANDLE(MC_YAWRATE_P);
+	_params_handles.yaw_rate_i		= 	PARAM_HANDLE(MC_YAWRATE_I);
+	_params_handles.yaw_rate_d		= 	PARAM_HANDLE(MC_YAWRATE_D);
+	_params_handles.yaw_rate_ff		= 	PARAM_HANDLE(MC_YAWRATE_FF);
+	_params_handles.dterm_cutoff	= 	PARAM_HANDLE(MC_DTERM_CUTOFF);
+	_params_handles.yaw_ff			= 	PARAM_HANDLE(MC_YAW_FF);
+	_params_handles.yaw_rate_max	= 	PARAM_HANDLE(MC_YAWRATE_MAX);
+	_params_handles.man_roll_max	= 	PARAM_HANDLE(MC_MAN_R_MAX);
+	_params_handles.man_pitch_max	= 	PARAM_HANDLE(MC_MAN_P_MAX);
+	_params_handles.man_yaw_max		= 	PARAM_HANDLE(MC_MAN_Y_MAX);
+	_params_handles.acro_roll_max	= 	PARAM_HANDLE(MC_ACRO_R_MAX);
+	_params_handles.acro_pitch_max	= 	PARAM_HANDLE(MC_ACRO_P_MAX);
+	_params_handles.acro_yaw_max		= 	PARAM_HANDLE(MC_ACRO_Y_MAX);
 
 	/* fetch initial parameter values */
 	parameters_update();
@@ -349,6 +419,8 @@ MulticopterAttitudeControl::~MulticopterAttitudeControl()
 		} while (_control_task != -1);
 	}
 
+	deadline_free(_deadline);
+
 	mc_att_control::g_control = nullptr;
 }
 
@@ -366,6 +438,8 @@ MulticopterAttitudeControl::parameters_update()
 	_params.rate_i(0) = v;
 	param_get(_params_handles.roll_rate_d, &v);
 	_params.rate_d(0) = v;
+	param_get(_params_handles.roll_rate_ff, &v);
+	_params.rate_ff(0) = v;
 
 	/* pitch gains */
 	param_get(_params_handles.pitch_p, &v);
@@ -376,6 +450,8 @@ MulticopterAttitudeControl::parameters_update()
 	_params.rate_i(1) = v;
 	param_get(_params_handles.pitch_rate_d, &v);
 	_params.rate_d(1) = v;
+	param_get(_params_handles.pitch_rate_ff, &v);
+	_params.rate_ff(1) = v;
 
 	/* yaw gains */
 	param_get(_params_handles.yaw_p, &v);
@@ -386,6 +462,12 @@ MulticopterAttitudeControl::parameters_update()
 	_params.rate_i(2) = v;
 	param_get(_params_handles.yaw_rate_d, &v);
 	_params.rate_d(2) = v;
+	param_get(_params_handles.yaw_rate_ff, &v);
+	_params.rate_ff(2) = v;
+
+	/* D term filter */
+	param_get(_params_handles.dterm_cutoff, &_params.dterm_cutoff);
+	_rates_d_filter.set_cutoff_frequency(_rates_d_filter_rate, _params.dterm_cutoff);
 
 	param_get(_params_handles.yaw_ff, &_params.yaw_ff);
 	param_get(_params_handles.yaw_rate_max, &_params.yaw_rate_max);
@@ -686,16 +768,22 @@ MulticopterAttitudeControl::control_attitude_rates(float dt)
 		_rates_int.zero();
 	}
 
-	/* current body angular rates */
-	math::Vector<3> rates;
-	rates(0) = _v_att.rollspeed;
-	rates(1) = _v_att.pitchspeed;
-	rates(2) = _v_att.yawspeed;
+	/* follow the loop frequency, it drops when the rate loop falls back to the attitude rates */
+	_rates_loop_rate += 0.05f * (1.0f / dt - _rates_loop_rate);
+
+	if (fabsf(_rates_loop_rate - _rates_d_filter_rate) > DTERM_RATE_TOL * _rates_d_filter_rate) {
+		_rates_d_filter_rate = _rates_loop_rate;
+		_rates_d_filter.set_cutoff_frequency(_rates_d_filter_rate, _params.dterm_cutoff);
+	}
+
+	/* derivative of the measured rates, filtered so vibrations are not amplified into the outputs */
+	math::Vector<3> rates_d = (_rates_prev - _rates) / dt;
+	_rates_d_filter.apply(rates_d.data, rates_d.data);
+	_rates_prev = _rates;
 
 	/* angular rates error */
-	math::Vector<3> rates_err = _rates_sp - rates;
-	_att_control = _params.rate_p.emult(rates_err) + _params.rate_d.emult(_rates_prev - rates) / dt + _rates_int;
-	_rates_prev = rates;
+	math::Vector<3> rates_err = _rates_sp - _rates;
+	_att_control = rates_err.emult_add(_params.rate_p, rates_d.emult_add(_params.rate_d, _rates_int)) + _rates_sp.emult(_params.rate_ff);
 
 	/* update integral only if not saturated on low limit */
 	if (_thrust_sp > MIN_TAKEOFF_THRUST) {
@@ -730,6 +818,7 @@ MulticopterAttitudeControl::task_main()
 	_v_att_sp_sub = orb_subscribe(ORB_ID(vehicle_attitude_setpoint));
 	_v_rates_sp_sub = orb_subscribe(ORB_ID(vehicle_rates_setpoint));
 	_v_att_sub = orb_subscribe(ORB_ID(vehicle_attitude));
+	_sensor_combined_sub = orb_subscribe(ORB_ID(sensor_combined));
 	_v_control_mode_sub = orb_subscribe(ORB_ID(vehicle_control_mode));
 	_params_sub = orb_subscribe(ORB_ID(parameter_update));
 	_manual_control_sp_sub = orb_subscribe(ORB_ID(manual_control_setpoint));
@@ -738,11 +827,13 @@ MulticopterAttitudeControl::task_main()
 	/* initialize parameters cache */
 	parameters_update();
 
-	/* wakeup source: vehicle attitude */
-	struct pollfd fds[1];
+	/* wakeup source: gyro samples for the rate loop, vehicle attitude for the attitude loop */
+	struct pollfd fds[2];
 
-	fds[0].fd = _v_att_sub;
+	fds[0].fd = _sensor_combined_sub;
 	fds[0].events = POLLIN;
+	fds[1].fd = _v_att_sub;
+	fds[1].events = POLLIN;
 
 	while (!_task_should_exit) {
 
@@ -762,12 +853,12 @@ MulticopterAttitudeControl::task_main()
 		}
 
 		perf_begin(_loop_perf);
+		deadline_begin(_deadline);
 
-		/* run controller on attitude changes */
-		if (fds[0].revents & POLLIN) {
-			static uint64_t last_run = 0;
-			float dt = (hrt_absolute_time() - last_run) / 1000000.0f;
-			last_run = hrt_absolute_time();
+		/* run attitude controller on attitude changes */
+		if (fds[1].revents & POLLIN) {
+			float dt = (hrt_absolute_time() - _att_last_run) / 1000000.0f;
+			_att_last_run = hrt_absolute_time();
 
 			/* guard against too small (< 2ms) and too large (> 20ms) dt's */
 			if (dt < 0.002f) {
@@ -836,28 +927,68 @@ MulticopterAttitudeControl::task_main()
 					_thrust_sp = _v_rates_sp.thrust;
 				}
 			}
+		}
 
-			if (_v_control_mode.flag_control_rates_enabled) {
-				control_attitude_rates(dt);
+		/*
+		 * The rate loop runs on every gyro sample, so it reacts to disturbances
+		 * without waiting for the estimator. Without gyro data it falls back to
+		 * the rates of the attitude estimate, at the attitude rate.
+		 */
+		bool run_rates = false;
+		uint64_t timestamp_sample = 0;
 
-				/* publish actuator controls */
-				_actuators.control[0] = (isfinite(_att_control(0))) ? _att_control(0) : 0.0f;
-				_actuators.control[1] = (isfinite(_att_control(1))) ? _att_control(1) : 0.0f;
-				_actuators.control[2] = (isfinite(_att_control(2))) ? _att_control(2) : 0.0f;
-				_actuators.control[3] = (isfinite(_thrust_sp)) ? _thrust_sp : 0.0f;
-				_actuators.timestamp = hrt_absolute_time();
+		if (fds[0].revents & POLLIN) {
+			orb_copy(ORB_ID(sensor_combined), _sensor_combined_sub, &_sensor_combined);
+			_gyro_last = hrt_absolute_time();
+
+			_rates(0) = _sensor_combined.gyro_rad_s[0];
+			_rates(1) = _sensor_combined.gyro_rad_s[1];
+			_rates(2) = _sensor_combined.gyro_rad_s[2];
+			timestamp_sample = _sensor_combined.timestamp;
+			run_rates = true;
+
+		} else if ((fds[1].revents & POLLIN) && hrt_elapsed_time(&_gyro_last) > GYRO_TIMEOUT) {
+			_rates(0) = _v_att.rollspeed;
+			_rates(1) = _v_att.pitchspeed;
+			_rates(2) = _v_att.yawspeed;
+			timestamp_sample = _v_att.timestamp;
+			run_rates = true;
+		}
 
-				if (!_actuators_0_circuit_breaker_enabled) {
-					if (_actuators_0_pub > 0) {
-						orb_publish(ORB_ID(actuator_controls_0), _actuators_0_pub, &_actuators);
+		if (run_rates && _v_control_mode.flag_control_rates_enabled) {
+			float dt = (hrt_absolute_time() - _rates_last_run) / 1000000.0f;
+			_rates_last_run = hrt_absolute_time();
 
-					} else {
-						_actuators_0_pub = orb_advertise(ORB_ID(actuator_controls_0), &_actuators);
-					}
+			/* guard against too small (< 0.5ms) and too large (> 20ms) dt's */
+			if (dt < 0.0005f) {
+				dt = 0.0005f;
+
+			} else if (dt > 0.02f) {
+				dt = 0.02f;
+			}
+
+			control_attitude_rates(dt);
+
+			/* publish actuator controls */
+			_actuators.control[0] = (isfinite(_att_control(0))) ? _att_control(0) : 0.0f;
+			_actuators.control[1] = (isfinite(_att_control(1))) ? _att_control(1) : 0.0f;
+			_actuators.control[2] = (isfinite(_att_control(2))) ? _att_control(2) : 0.0f;
+			_actuators.control[3] = (isfinite(_thrust_sp)) ? _thrust_sp : 0.0f;
+			_actuators.timestamp = hrt_absolute_time();
+			_actuators.timestamp_sample = timestamp_sample;
+			_actuators.timestamp_attitude = _att_last_run;
+
+			if (!_actuators_0_circuit_breaker_enabled) {
+				if (_actuators_0_pub > 0) {
+					orb_publish(ORB_ID(actuator_controls_0), _actuators_0_pub, &_actuators);
+
+				} else {
+					_actuators_0_pub = orb_advertise(ORB_ID(actuator_controls_0), &_actuators);
 				}
 			}
 		}
 
+		deadline_end(_deadline);
 		perf_end(_loop_perf);
 	}
 
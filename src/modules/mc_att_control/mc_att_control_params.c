@@ -82,6 +82,16 @@ PARAM_DEFINE_FLOAT(MC_ROLLRATE_I, 0.0f);
  */
 PARAM_DEFINE_FLOAT(MC_ROLLRATE_D, 0.002f);
 
+/**
+ * Roll rate feed forward
+ *
+ * Control output per rad/s of roll rate setpoint, added to the PID output. Improves tracking of fast setpoint changes.
+ *
+ * @min 0.0
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_FLOAT(MC_ROLLRATE_FF, 0.0f);
+
 /**
  * Pitch P gain
  *
@@ -123,6 +133,16 @@ PARAM_DEFINE_FLOAT(MC_PITCHRATE_I, 0.0f);
  */
 PARAM_DEFINE_FLOAT(MC_PITCHRATE_D, 0.002f);
 
+/**
+ * Pitch rate feed forward
+ *
+ * Control output per rad/s of pitch rate setpoint, added to the PID output. Improves tracking of fast setpoint changes.
+ *
+ * @min 0.0
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_FLOAT(MC_PITCHRATE_FF, 0.0f);
+
 /**
  * Yaw P gain
  *
@@ -164,6 +184,27 @@ PARAM_DEFINE_FLOAT(MC_YAWRATE_I, 0.0f);
  */
 PARAM_DEFINE_FLOAT(MC_YAWRATE_D, 0.0f);
 
+/**
+ * Yaw rate feed forward
+ *
+ * Control output per rad/s of yaw rate setpoint, added to the PID output. Improves tracking of fast setpoint changes.
+ *
+ * @min 0.0
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_FLOAT(MC_YAWRATE_FF, 0.0f);
+
+/**
+ * Rate D term cutoff frequency
+ *
+ * Cutoff frequency of the second order low pass filter on the angular rate derivative of all axes. Lower values reject more vibration but delay the damping. 0 disables the filter.
+ *
+ * @unit Hz
+ * @min 0.0
+ * @group Multicopter Attitude Control
+ */
+PARAM_DEFINE_FLOAT(MC_DTERM_CUTOFF, 40.0f);
+
 /**
  * Yaw feed forward
  *
@@ -74,6 +74,8 @@
 #include <lib/geo/geo.h>
 #include <mavlink/mavlink_log.h>
 
+#include "trajectory.h"
+
 #define TILT_COS_MAX	0.7f
 #define SIGMA			0.000001f
 #define MIN_DIST		0.01f
@@ -123,6 +125,8 @@ private:
 	int		_local_pos_sp_sub;		/**< offboard local position setpoint */
 	int		_global_vel_sp_sub;		/**< offboard global velocity setpoint */
 
+	struct orb_batch_entry	_poll_batch[6];		/**< subscriptions updated by poll_subscriptions() */
+
 	orb_advert_t	_att_sp_pub;			/**< attitude setpoint publication */
 	orb_advert_t	_local_pos_sp_pub;		/**< vehicle local position setpoint publication */
 	orb_advert_t	_global_vel_sp_pub;		/**< vehicle global velocity setpoint publication */
@@ -156,6 +160,9 @@ private:
 		param_t tilt_max_air;
 		param_t land_speed;
 		param_t tilt_max_land;
+		param_t vel_rate;
+		param_t acc_max;
+		param_t jerk_max;
 	}		_params_handles;		/**< handles for interesting parameters */
 
 	struct {
@@ -189,6 +196,9 @@ private:
 	math::Vector<3> _vel_prev;			/**< velocity on previous step */
 	math::Vector<3> _vel_ff;
 	math::Vector<3> _sp_move_rate;
+	math::Vector<3> _sp_move_acc;			/**< setpoint acceleration */
+
+	TrajectoryGenerator _traj;			/**< jerk limited auto setpoint */
 
 	/**
 	 * Update our local parameter cache.
@@ -328,6 +338,7 @@ MulticopterPositionControl::MulticopterPositionControl() :
 	_vel_prev.zero();
 	_vel_ff.zero();
 	_sp_move_rate.zero();
+	_sp_move_acc.zero();
 
 	_params_handles.thr_min		= param_find("MPC_THR_MIN");
 	_params_handles.thr_max		= param_find("MPC_THR_MAX");
@@ -346,6 +357,9 @@ MulticopterPositionControl::MulticopterPositionControl() :
 	_params_handles.tilt_max_air	= param_find("MPC_TILTMAX_AIR");
 	_params_handles.land_speed	= param_find("MPC_LAND_SPEED");
 	_params_handles.tilt_max_land	= param_find("MPC_TILTMAX_LND");
+	_params_handles.vel_rate	= param_find("MPC_VEL_RATE");
+	_params_handles.acc_max		= param_find("MPC_ACC_MAX");
+	_params_handles.jerk_max	= param_find("MPC_JERK_MAX");
 
 	/* fetch initial parameter values */
 	parameters_update(true);
@@ -431,6 +445,19 @@ MulticopterPositionControl::parameters_update(bool force)
 		_params.vel_ff(2) = v;
 
 		_params.sp_offs_max = _params.vel_max.edivide(_params.pos_p) * 2.0f;
+
+		float acc_max;
+		float jerk_max;
+		param_get(_params_handles.acc_max, &acc_max);
+		param_get(_params_handles.jerk_max, &jerk_max);
+		_traj.set_limits(_params.vel_max(0), _params.vel_max(2), acc_max, jerk_max);
+
+		/* limit the controller rate by limiting the wakeup source */
+		param_get(_params_handles.vel_rate, &v);
+
+		if (_local_pos_sub >= 0) {
+			orb_set_interval(_local_pos_sub, v > 0.0f ? (unsigned)(1000.0f / v) : 0);
+		}
 	}
 
 	return OK;
@@ -439,43 +466,7 @@ MulticopterPositionControl::parameters_update(bool force)
 void
 MulticopterPositionControl::poll_subscriptions()
 {
-	bool updated;
-
-	orb_check(_att_sub, &updated);
-
-	if (updated) {
-		orb_copy(ORB_ID(vehicle_attitude), _att_sub, &_att);
-	}
-
-	orb_check(_att_sp_sub, &updated);
-
-	if (updated) {
-		orb_copy(ORB_ID(vehicle_attitude_setpoint), _att_sp_sub, &_att_sp);
-	}
-
-	orb_check(_control_mode_sub, &updated);
-
-	if (updated) {
-		orb_copy(ORB_ID(vehicle_control_mode), _control_mode_sub, &_control_mode);
-	}
-
-	orb_check(_manual_sub, &updated);
-
-	if (updated) {
-		orb_copy(ORB_ID(manual_control_setpoint), _manual_sub, &_manual);
-	}
-
-	orb_check(_arming_sub, &updated);
-
-	if (updated) {
-		orb_copy(ORB_ID(actuator_armed), _arming_sub, &_arming);
-	}
-
-	orb_check(_local_pos_sub, &updated);
-
-	if (updated) {
-		orb_copy(ORB_ID(vehicle_local_position), _local_pos_sub, &_local_pos);
-	}
+	orb_copy_batch(_poll_batch, sizeof(_poll_batch) / sizeof(_poll_batch[0]));
 }
 
 float
@@ -568,7 +559,7 @@ MulticopterPositionControl::limit_pos_sp_offset()
 
 	if (pos_sp_offs_norm > 1.0f) {
 		pos_sp_offs /= pos_sp_offs_norm;
-		_pos_sp = _pos + pos_sp_offs.emult(_params.sp_offs_max);
+		_pos_sp = pos_sp_offs.emult_add(_params.sp_offs_max, _pos);
 	}
 }
 
@@ -633,7 +624,7 @@ MulticopterPositionControl::control_manual(float dt)
 
 	if (pos_sp_offs_norm > 1.0f) {
 		pos_sp_offs /= pos_sp_offs_norm;
-		_pos_sp = _pos + pos_sp_offs.emult(_params.sp_offs_max);
+		_pos_sp = pos_sp_offs.emult_add(_params.sp_offs_max, _pos);
 	}
 }
 
@@ -723,6 +714,7 @@ MulticopterPositionControl::control_auto(float dt)
 		/* reset position setpoint on AUTO mode activation */
 		reset_pos_sp();
 		reset_alt_sp();
+		_traj.reset(_pos_sp, _vel);
 	}
 
 	bool updated;
@@ -737,6 +729,8 @@ MulticopterPositionControl::control_auto(float dt)
 		_reset_pos_sp = true;
 		_reset_alt_sp = true;
 
+		math::Vector<3> pos_sp_prev = _pos_sp;
+
 		/* project setpoint to local frame */
 		math::Vector<3> curr_sp;
 		map_projection_project(&_ref_pos,
@@ -831,18 +825,59 @@ MulticopterPositionControl::control_auto(float dt)
 			}
 		}
 
-		/* move setpoint not faster than max allowed speed */
-		math::Vector<3> pos_sp_old_s = _pos_sp.emult(scale);
+		if (_traj.enabled()) {
+			/* stop at the current waypoint, or only slow down for the turn if there is a next one */
+			math::Vector<3> curr_dist = curr_sp - _traj.get_pos();
+			float end_speed = 0.0f;
+
+			if (_pos_sp_triplet.current.type == SETPOINT_TYPE_POSITION && _pos_sp_triplet.next.valid) {
+				math::Vector<3> next_sp;
+				map_projection_project(&_ref_pos,
+						       _pos_sp_triplet.next.lat, _pos_sp_triplet.next.lon,
+						       &next_sp.data[0], &next_sp.data[1]);
+				next_sp(2) = -(_pos_sp_triplet.next.alt - _ref_alt);
+
+				math::Vector<3> curr_next = next_sp - curr_sp;
+				float len = curr_dist.length() * curr_next.length();
+
+				if (len > MIN_DIST * MIN_DIST) {
+					end_speed = _params.vel_max(0) * math::max((curr_dist * curr_next) / len, 0.0f);
+				}
+			}
+
+			/* the setpoint follows the L1 point with limited speed, acceleration and jerk */
+			_traj.update(dt, pos_sp_s.edivide(scale), curr_dist.length(), end_speed);
+
+			_pos_sp = _traj.get_pos();
+			_sp_move_rate = _traj.get_vel();
+			_sp_move_acc = _traj.get_acc();
 
-		/* difference between current and desired position setpoints, 1 = max speed */
-		math::Vector<3> d_pos_m = (pos_sp_s - pos_sp_old_s).edivide(_params.pos_p);
-		float d_pos_m_len = d_pos_m.length();
-		if (d_pos_m_len > dt) {
-			pos_sp_s = pos_sp_old_s + (d_pos_m / d_pos_m_len * dt).emult(_params.pos_p);
+		} else {
+			/* move setpoint not faster than max allowed speed */
+			math::Vector<3> pos_sp_old_s = _pos_sp.emult(scale);
+
+			/* difference between current and desired position setpoints, 1 = max speed */
+			math::Vector<3> d_pos_m = (pos_sp_s - pos_sp_old_s).edivide(_params.pos_p);
+			float d_pos_m_len = d_pos_m.length();
+			if (d_pos_m_len > dt) {
+				pos_sp_s = pos_sp_old_s + (d_pos_m / d_pos_m_len * dt).emult(_params.pos_p);
+			}
+
+			/* scale result back to normal space */
+			_pos_sp = pos_sp_s.edivide(scale);
+
+			/* feed forward the setpoint velocity, from the triplet if given, else the setpoint motion */
+			if (_pos_sp_triplet.current.velocity_valid) {
+				_sp_move_rate(0) = _pos_sp_triplet.current.vx;
+				_sp_move_rate(1) = _pos_sp_triplet.current.vy;
+				_sp_move_rate(2) = _pos_sp_triplet.current.vz;
+
+			} else if (dt > 0.0f) {
+				_sp_move_rate = (_pos_sp - pos_sp_prev) / dt;
+			}
 		}
 
-		/* scale result back to normal space */
-		_pos_sp = pos_sp_s.edivide(scale);
+		_vel_ff = _sp_move_rate.emult(_params.vel_ff);
 
 		/* update yaw setpoint if needed */
 		if (isfinite(_pos_sp_triplet.current.yaw)) {
@@ -851,6 +886,7 @@ MulticopterPositionControl::control_auto(float dt)
 
 	} else {
 		/* no waypoint, do nothing, setpoint was already reset */
+		_traj.reset(_pos_sp, _vel);
 	}
 }
 
@@ -876,6 +912,13 @@ MulticopterPositionControl::task_main()
 	_local_pos_sp_sub = orb_subscribe(ORB_ID(vehicle_local_position_setpoint));
 	_global_vel_sp_sub = orb_subscribe(ORB_ID(vehicle_global_velocity_setpoint));
 
+	orb_batch_init(&_poll_batch[0], ORB_ID(vehicle_attitude), _att_sub, &_att);
+	orb_batch_init(&_poll_batch[1], ORB_ID(vehicle_attitude_setpoint), _att_sp_sub, &_att_sp);
+	orb_batch_init(&_poll_batch[2], ORB_ID(vehicle_control_mode), _control_mode_sub, &_control_mode);
+	orb_batch_init(&_poll_batch[3], ORB_ID(manual_control_setpoint), _manual_sub, &_manual);
+	orb_batch_init(&_poll_batch[4], ORB_ID(actuator_armed), _arming_sub, &_arming);
+	orb_batch_init(&_poll_batch[5], ORB_ID(vehicle_local_position), _local_pos_sub, &_local_pos);
+
 
 	parameters_update(true);
 
@@ -952,6 +995,7 @@ MulticopterPositionControl::task_main()
 
 			_vel_ff.zero();
 			_sp_move_rate.zero();
+			_sp_move_acc.zero();
 
 			/* select control source */
 			if (_control_mode.flag_control_manual_enabled) {
@@ -975,6 +1019,12 @@ MulticopterPositionControl::task_main()
 			_local_pos_sp.y = _pos_sp(1);
 			_local_pos_sp.z = _pos_sp(2);
 			_local_pos_sp.yaw = _att_sp.yaw_body;
+			_local_pos_sp.vx = _sp_move_rate(0);
+			_local_pos_sp.vy = _sp_move_rate(1);
+			_local_pos_sp.vz = _sp_move_rate(2);
+			_local_pos_sp.acc_x = _sp_move_acc(0);
+			_local_pos_sp.acc_y = _sp_move_acc(1);
+			_local_pos_sp.acc_z = _sp_move_acc(2);
 
 			/* publish local position setpoint */
 			if (_local_pos_sp_pub > 0) {
@@ -1010,7 +1060,19 @@ MulticopterPositionControl::task_main()
 				/* run position & altitude controllers, calculate velocity setpoint */
 				math::Vector<3> pos_err = _pos_sp - _pos;
 
-				_vel_sp = pos_err.emult(_params.pos_p) + _vel_ff;
+				_vel_sp = pos_err.emult_add(_params.pos_p, _vel_ff);
+
+				if (_mode_auto) {
+					/* feed forward must not push the autonomous velocity beyond the limits */
+					float vel_sp_xy_len = math::Vector<2>(_vel_sp(0), _vel_sp(1)).length();
+
+					if (vel_sp_xy_len > _params.vel_max(0)) {
+						_vel_sp(0) *= _params.vel_max(0) / vel_sp_xy_len;
+						_vel_sp(1) *= _params.vel_max(0) / vel_sp_xy_len;
+					}
+
+					_vel_sp(2) = math::constrain(_vel_sp(2), -_params.vel_max(2), _params.vel_max(2));
+				}
 
 				if (!_control_mode.flag_control_altitude_enabled) {
 					_reset_alt_sp = true;
@@ -1079,12 +1141,13 @@ MulticopterPositionControl::task_main()
 					/* velocity error */
 					math::Vector<3> vel_err = _vel_sp - _vel;
 
-					/* derivative of velocity error, not includes setpoint acceleration */
-					math::Vector<3> vel_err_d = (_sp_move_rate - _vel).emult(_params.pos_p) - (_vel - _vel_prev) / dt;
+					/* derivative of velocity error, including the fed forward setpoint acceleration */
+					math::Vector<3> vel_err_d = (_sp_move_rate - _vel).emult(_params.pos_p) +
+								    _sp_move_acc.emult(_params.vel_ff) - (_vel - _vel_prev) / dt;
 					_vel_prev = _vel;
 
 					/* thrust vector in NED frame */
-					math::Vector<3> thrust_sp = vel_err.emult(_params.vel_p) + vel_err_d.emult(_params.vel_d) + thrust_int;
+					math::Vector<3> thrust_sp = vel_err.emult_add(_params.vel_p, vel_err_d.emult_add(_params.vel_d, thrust_int));
 
 					if (!_control_mode.flag_control_velocity_enabled) {
 						thrust_sp(0) = 0.0f;
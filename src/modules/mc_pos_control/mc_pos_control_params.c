@@ -208,3 +208,36 @@ PARAM_DEFINE_FLOAT(MPC_TILTMAX_LND, 15.0f);
  */
 PARAM_DEFINE_FLOAT(MPC_LAND_SPEED, 1.0f);
 
+
+/**
+ * Maximum controller rate
+ *
+ * The position and velocity loops run on every local position estimate. A non zero value limits them to this rate, the estimate is used at most this often.
+ *
+ * @unit Hz
+ * @min 0.0
+ * @group Multicopter Position Control
+ */
+PARAM_DEFINE_FLOAT(MPC_VEL_RATE, 0.0f);
+
+/**
+ * Maximum acceleration of the auto setpoint
+ *
+ * Limits the acceleration of the position setpoint in AUTO mode.
+ *
+ * @unit m/s^2
+ * @min 0.0
+ * @group Multicopter Position Control
+ */
+PARAM_DEFINE_FLOAT(MPC_ACC_MAX, 3.0f);
+
+/**
+ * Maximum jerk of the auto setpoint
+ *
+ * Limits how fast the acceleration of the position setpoint changes in AUTO mode, so it ramps up and down around waypoints. 0 disables the jerk limited setpoint, the setpoint then moves at the maximum velocity.
+ *
+ * @unit m/s^3
+ * @min 0.0
+ * @group Multicopter Position Control
+ */
+PARAM_DEFINE_FLOAT(MPC_JERK_MAX, 8.0f);
@@ -38,4 +38,5 @@
 MODULE_COMMAND	= mc_pos_control
 
 SRCS		= mc_pos_control_main.cpp \
-			  mc_pos_control_params.c
+			  mc_pos_control_params.c \
+			  trajectory.cpp
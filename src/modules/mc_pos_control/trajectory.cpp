@@ -0,0 +1,151 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2015 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file trajectory.cpp
+ *
+ * Jerk limited position setpoint generator.
+ */
+
+#include <float.h>
+
+#include "trajectory.h"
+
+/* velocity error to acceleration gain, in units of 1 / _t_jerk */
+#define TRAJ_VEL_GAIN	0.5f
+
+TrajectoryGenerator::TrajectoryGenerator() :
+	_vel_max_xy(0.0f),
+	_vel_max_z(0.0f),
+	_acc_max(0.0f),
+	_jerk_max(0.0f),
+	_t_jerk(0.0f)
+{
+	_pos.zero();
+	_vel.zero();
+	_acc.zero();
+}
+
+void
+TrajectoryGenerator::set_limits(float vel_max_xy, float vel_max_z, float acc_max, float jerk_max)
+{
+	_vel_max_xy = vel_max_xy;
+	_vel_max_z = vel_max_z;
+	_acc_max = acc_max;
+	_jerk_max = jerk_max;
+	_t_jerk = enabled() ? acc_max / jerk_max : 0.0f;
+}
+
+void
+TrajectoryGenerator::reset(const math::Vector<3> &pos, const math::Vector<3> &vel)
+{
+	_pos = pos;
+	_vel = vel;
+	_acc.zero();
+}
+
+float
+TrajectoryGenerator::braking_speed(float dist, float end_speed) const
+{
+	/*
+	 * the deceleration only reaches acc_max after about half the ramp time,
+	 * so dist = v * t_jerk / 2 + (v^2 - end_speed^2) / (2 * acc_max)
+	 */
+	float a_t = 0.5f * _acc_max * _t_jerk;
+	float d = (dist > 0.0f) ? dist : 0.0f;
+
+	return sqrtf(a_t * a_t + 2.0f * _acc_max * d + end_speed * end_speed) - a_t;
+}
+
+void
+TrajectoryGenerator::update(float dt, const math::Vector<3> &target, float stop_dist, float end_speed)
+{
+	if (!enabled() || !(dt > 0.0f)) {
+		return;
+	}
+
+	/* desired velocity: towards the target, as fast as the limits and the stop ahead allow */
+	math::Vector<3> vel_des;
+	math::Vector<3> acc_ff;
+	vel_des.zero();
+	acc_ff.zero();
+
+	math::Vector<3> err = target - _pos;
+	float err_len = err.length();
+
+	if (err_len > FLT_EPSILON) {
+		math::Vector<3> dir = err / err_len;
+		float speed = braking_speed(stop_dist, end_speed);
+		bool braking = true;
+
+		/* the speed limit in this direction, where it meets the horizontal / vertical limit ellipsoid */
+		float xy2 = dir(0) * dir(0) + dir(1) * dir(1);
+		float k2 = ((_vel_max_xy > 0.0f) ? xy2 / (_vel_max_xy * _vel_max_xy) : 0.0f) +
+			   ((_vel_max_z > 0.0f) ? dir(2) * dir(2) / (_vel_max_z * _vel_max_z) : 0.0f);
+
+		if (k2 > 0.0f && speed * speed * k2 > 1.0f) {
+			speed = 1.0f / sqrtf(k2);
+			braking = false;
+		}
+
+		vel_des = dir * speed;
+
+		/* on the braking curve, its slope times the speed is the deceleration to follow it */
+		float speed_along = _vel * dir;
+
+		if (braking && speed_along > 0.0f) {
+			acc_ff = dir * (-_acc_max * speed_along / (speed + 0.5f * _acc_max * _t_jerk));
+		}
+	}
+
+	/* acceleration to follow it, then the jerk limit on the change of acceleration */
+	math::Vector<3> acc_des = acc_ff + (vel_des - _vel) * (TRAJ_VEL_GAIN / _t_jerk);
+	float acc_len = acc_des.length();
+
+	if (acc_len > _acc_max) {
+		acc_des *= _acc_max / acc_len;
+	}
+
+	math::Vector<3> d_acc = acc_des - _acc;
+	float d_acc_len = d_acc.length();
+	float d_acc_max = _jerk_max * dt;
+
+	if (d_acc_len > d_acc_max) {
+		d_acc *= d_acc_max / d_acc_len;
+	}
+
+	_acc += d_acc;
+
+	_pos += _vel * dt + _acc * (0.5f * dt * dt);
+	_vel += _acc * dt;
+}
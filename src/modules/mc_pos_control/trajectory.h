@@ -0,0 +1,97 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2015 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file trajectory.h
+ *
+ * Jerk limited position setpoint generator for the auto modes.
+ *
+ * The setpoint is moved towards a target with limited velocity,
+ * acceleration and jerk, so its acceleration ramps up and down instead of
+ * stepping and the velocity profile is an S-curve. Its speed is limited
+ * so it can slow down to a given end speed at a given stop distance,
+ * taking the time to ramp the deceleration into account. Each update is a
+ * fixed amount of work.
+ */
+
+#pragma once
+
+#include <mathlib/mathlib.h>
+
+class TrajectoryGenerator
+{
+public:
+	TrajectoryGenerator();
+
+	/**
+	 * Set the limits, a jerk or acceleration limit of zero disables the generator.
+	 */
+	void set_limits(float vel_max_xy, float vel_max_z, float acc_max, float jerk_max);
+
+	bool enabled() const { return _acc_max > 0.0f && _jerk_max > 0.0f; }
+
+	/**
+	 * Restart from a position and velocity with zero acceleration.
+	 */
+	void reset(const math::Vector<3> &pos, const math::Vector<3> &vel);
+
+	/**
+	 * Advance the setpoint.
+	 *
+	 * @param dt		time step in s
+	 * @param target	point the setpoint moves towards
+	 * @param stop_dist	distance along the path at which the speed has to be end_speed
+	 * @param end_speed	speed at the stop distance in m/s
+	 */
+	void update(float dt, const math::Vector<3> &target, float stop_dist, float end_speed);
+
+	const math::Vector<3> &get_pos() const { return _pos; }
+	const math::Vector<3> &get_vel() const { return _vel; }
+	const math::Vector<3> &get_acc() const { return _acc; }
+
+private:
+	math::Vector<3> _pos;
+	math::Vector<3> _vel;
+	math::Vector<3> _acc;
+
+	float _vel_max_xy;
+	float _vel_max_z;
+	float _acc_max;
+	float _jerk_max;
+	float _t_jerk;		/**< time to ramp the acceleration to its limit, acc_max / jerk_max */
+
+	/**
+	 * Highest speed from which end_speed is reached within dist.
+	 */
+	float braking_speed(float dist, float end_speed) const;
+};
@@ -48,6 +48,8 @@
 #include <ctype.h>
 #include <nuttx/config.h>
 #include <unistd.h>
+#include <math.h>
+#include <geo/geo.h>
 #include <mavlink/mavlink_log.h>
 
 
@@ -57,12 +59,35 @@
 #endif
 static const int ERROR = -1;
 
+/* meters per degree of latitude */
+static const double LAT_SCALE = CONSTANTS_RADIUS_OF_EARTH * M_DEG_TO_RAD;
+
 Geofence::Geofence() :
 		SuperBlock(NULL, "GF"),
 		_fence_pub(-1),
 		_altitude_min(0),
 		_altitude_max(0),
 		_verticesCount(0),
+		_zones{},
+		_zonesCount(0),
+		_zoneVerticesCount(0),
+		_verticesLoaded(false),
+		_version(0),
+		_originSet(false),
+		_originLat(0.0),
+		_originLon(0.0),
+		_lonScale(0.0f),
+		_verticesX{},
+		_verticesY{},
+		_vertexZone{},
+		_gridValid(false),
+		_gridX(0.0f),
+		_gridY(0.0f),
+		_cellSizeX(0.0f),
+		_cellSizeY(0.0f),
+		_cellInside{},
+		_cellFirst{},
+		_cellEdges{},
 		_param_geofence_on(this, "ON"),
 		_param_altitude_mode(this, "ALTMODE"),
 		_param_source(this, "SOURCE"),
@@ -144,44 +169,313 @@ bool Geofence::inside_polygon(double lat, double lon, float altitude)
 				return false;
 			}
 
+			/* Unreadable fence --> accept all points */
+			if (!_verticesLoaded && loadVertices() != OK) {
+				return true;
+			}
+
 			/*Horizontal check */
-			/* Adaptation of algorithm originally presented as
-			 * PNPOLY - Point Inclusion in Polygon Test
-			 * W. Randolph Franklin (WRF) */
+			float x, y;
+			project(lat, lon, &x, &y);
 
-			bool c = false;
+			return insideZones(x, y);
+		} else {
+			/* Empty fence --> accept all points */
+			return true;
+		}
 
-			struct fence_vertex_s temp_vertex_i;
-			struct fence_vertex_s temp_vertex_j;
+	} else {
+		/* Invalid fence --> accept all points */
+		return true;
+	}
+}
 
-			/* Red until fence is finished */
-			for (unsigned i = 0, j = _verticesCount - 1; i < _verticesCount; j = i++) {
-				if (dm_read(DM_KEY_FENCE_POINTS, i, &temp_vertex_i, sizeof(struct fence_vertex_s)) != sizeof(struct fence_vertex_s)) {
-					break;
+/* orientation of c relative to the line through a and b */
+static float
+orientation(float ax, float ay, float bx, float by, float cx, float cy)
+{
+	return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+/* whether the segments p-q and a-b cross, an end point on the other line counts to one side */
+static bool
+segments_cross(float px, float py, float qx, float qy, float ax, float ay, float bx, float by)
+{
+	if ((orientation(px, py, qx, qy, ax, ay) >= 0.0f) == (orientation(px, py, qx, qy, bx, by) >= 0.0f)) {
+		return false;
+	}
+
+	return (orientation(ax, ay, bx, by, px, py) >= 0.0f) != (orientation(ax, ay, bx, by, qx, qy) >= 0.0f);
+}
+
+void
+Geofence::project(double lat, double lon, float *x, float *y)
+{
+	if (!_originSet) {
+		_originLat = lat;
+		_originLon = lon;
+		_lonScale = LAT_SCALE * cos(_originLat * M_DEG_TO_RAD);
+		_originSet = true;
+	}
+
+	*x = (lat - _originLat) * LAT_SCALE;
+	*y = (lon - _originLon) * (double)_lonScale;
+}
+
+int
+Geofence::loadVertices()
+{
+	if (_verticesCount > GEOFENCE_MAX_VERTICES) {
+		return ERROR;
+	}
+
+	for (unsigned i = 0; i < _verticesCount; i++) {
+		struct fence_vertex_s vertex;
+
+		if (dm_read(DM_KEY_FENCE_POINTS, i, &vertex, sizeof(vertex)) != sizeof(vertex)) {
+			return ERROR;
+		}
+
+		project((double)vertex.lat, (double)vertex.lon, &_verticesX[i], &_verticesY[i]);
+		_vertexZone[i] = 0;
+	}
+
+	_zones[0].circle = false;
+	_zones[0].exclude = false;
+	_zones[0].first = 0;
+	_zones[0].count = _verticesCount;
+
+	buildGrid();
+
+	_verticesLoaded = true;
+	_version++;
+	return OK;
+}
+
+int
+Geofence::addZone(const char *line)
+{
+	char shape[8];
+	char kind[8];
+	float lat, lon, radius;
+
+	if (_zonesCount >= GEOFENCE_MAX_ZONES) {
+		return ERROR;
+	}
+
+	int fields = sscanf(line, "%7s %7s %f %f %f", shape, kind, &lat, &lon, &radius);
+
+	if (fields < 2 || (strcmp(kind, "INCLUDE") != 0 && strcmp(kind, "EXCLUDE") != 0)) {
+		return ERROR;
+	}
+
+	Zone &zone = _zones[1 + _zonesCount];
+	zone.exclude = (strcmp(kind, "EXCLUDE") == 0);
+	zone.first = GEOFENCE_MAX_VERTICES + _zoneVerticesCount;
+	zone.count = 0;
+
+	if (strcmp(shape, "CIRCLE") == 0) {
+		if (fields != 5 || !(radius > 0.0f)) {
+			return ERROR;
+		}
+
+		zone.circle = true;
+		project((double)lat, (double)lon, &zone.x, &zone.y);
+		zone.radius = radius;
+
+	} else if (strcmp(shape, "POLYGON") == 0 && fields == 2) {
+		/* the vertices follow */
+		zone.circle = false;
+
+	} else {
+		return ERROR;
+	}
+
+	_zonesCount++;
+	return OK;
+}
+
+void
+Geofence::buildGrid()
+{
+	const unsigned cells = GEOFENCE_GRID_SIZE * GEOFENCE_GRID_SIZE;
+	bool first = true;
+	float x_min = 0.0f, x_max = 0.0f, y_min = 0.0f, y_max = 0.0f;
+
+	/* bounding box of all polygons */
+	for (unsigned z = 0; z <= _zonesCount; z++) {
+		const Zone &zone = _zones[z];
+
+		for (unsigned i = zone.first; !zone.circle && i < (unsigned)zone.first + zone.count; i++) {
+			if (first || _verticesX[i] < x_min) {
+				x_min = _verticesX[i];
+			}
+
+			if (first || _verticesX[i] > x_max) {
+				x_max = _verticesX[i];
+			}
+
+			if (first || _verticesY[i] < y_min) {
+				y_min = _verticesY[i];
+			}
+
+			if (first || _verticesY[i] > y_max) {
+				y_max = _verticesY[i];
+			}
+
+			first = false;
+		}
+	}
+
+	_gridX = x_min;
+	_gridY = y_min;
+	_cellSizeX = (x_max - x_min) / GEOFENCE_GRID_SIZE;
+	_cellSizeY = (y_max - y_min) / GEOFENCE_GRID_SIZE;
+
+	/* a degenerate box has no inside, checked edge by edge */
+	_gridValid = (_cellSizeX > 0.0f && _cellSizeY > 0.0f);
+
+	unsigned entries = 0;
+
+	for (unsigned cell = 0; _gridValid && cell < cells; cell++) {
+		float cx0 = _gridX + (cell % GEOFENCE_GRID_SIZE) * _cellSizeX;
+		float cy0 = _gridY + (cell / GEOFENCE_GRID_SIZE) * _cellSizeY;
+		float cx = cx0 + 0.5f * _cellSizeX;
+		float cy = cy0 + 0.5f * _cellSizeY;
+
+		_cellFirst[cell] = entries;
+		_cellInside[cell] = 0;
+
+		for (unsigned z = 0; _gridValid && z <= _zonesCount; z++) {
+			const Zone &zone = _zones[z];
+
+			if (zone.circle || zone.count == 0) {
+				continue;
+			}
+
+			if (insidePolygon(zone, cx, cy)) {
+				_cellInside[cell] |= (1 << z);
+			}
+
+			/* edges whose bounding box overlaps the cell */
+			for (unsigned i = zone.first; i < (unsigned)zone.first + zone.count; i++) {
+				unsigned j = nextVertex(zone, i);
+
+				if ((_verticesX[i] < cx0 && _verticesX[j] < cx0) ||
+				    (_verticesX[i] > cx0 + _cellSizeX && _verticesX[j] > cx0 + _cellSizeX) ||
+				    (_verticesY[i] < cy0 && _verticesY[j] < cy0) ||
+				    (_verticesY[i] > cy0 + _cellSizeY && _verticesY[j] > cy0 + _cellSizeY)) {
+					continue;
 				}
-				if (dm_read(DM_KEY_FENCE_POINTS, j, &temp_vertex_j, sizeof(struct fence_vertex_s)) != sizeof(struct fence_vertex_s)) {
+
+				if (entries >= GEOFENCE_GRID_ENTRIES) {
+					warnx("Geofence: too many edges for the index");
+					_gridValid = false;
 					break;
 				}
 
-				// skip vertex 0 (return point)
-				if (((double)temp_vertex_i.lon >= lon) != ((double)temp_vertex_j.lon >= lon) &&
-							(lat <= (double)(temp_vertex_j.lat - temp_vertex_i.lat) * (lon - (double)temp_vertex_i.lon) /
-							 (double)(temp_vertex_j.lon - temp_vertex_i.lon) + (double)temp_vertex_i.lat)) {
-							c = !c;
+				_cellEdges[entries++] = i;
+			}
+		}
+	}
+
+	_cellFirst[cells] = entries;
+}
+
+bool
+Geofence::insidePolygon(const Zone &zone, float x, float y)
+{
+	/* Adaptation of algorithm originally presented as
+	 * PNPOLY - Point Inclusion in Polygon Test
+	 * W. Randolph Franklin (WRF) */
+
+	bool c = false;
+
+	for (unsigned i = zone.first, j = zone.first + zone.count - 1; i < (unsigned)zone.first + zone.count; j = i++) {
+		if ((_verticesY[i] >= y) != (_verticesY[j] >= y) &&
+		    (x <= (_verticesX[j] - _verticesX[i]) * (y - _verticesY[i]) / (_verticesY[j] - _verticesY[i]) + _verticesX[i])) {
+			c = !c;
+		}
+	}
+
+	return c;
+}
+
+bool
+Geofence::insideZones(float x, float y)
+{
+	uint32_t inside = 0;
+
+	if (_gridValid) {
+		/* outside the grid is outside all polygons */
+		int col = floorf((x - _gridX) / _cellSizeX);
+		int row = floorf((y - _gridY) / _cellSizeY);
+
+		/* the far border belongs to the last cell */
+		if (col == GEOFENCE_GRID_SIZE && x <= _gridX + GEOFENCE_GRID_SIZE * _cellSizeX) {
+			col--;
+		}
+
+		if (row == GEOFENCE_GRID_SIZE && y <= _gridY + GEOFENCE_GRID_SIZE * _cellSizeY) {
+			row--;
+		}
+
+		if (col >= 0 && col < GEOFENCE_GRID_SIZE && row >= 0 && row < GEOFENCE_GRID_SIZE) {
+			unsigned cell = row * GEOFENCE_GRID_SIZE + col;
+			float cx = _gridX + (col + 0.5f) * _cellSizeX;
+			float cy = _gridY + (row + 0.5f) * _cellSizeY;
+
+			inside = _cellInside[cell];
+
+			for (unsigned k = _cellFirst[cell]; k < _cellFirst[cell + 1]; k++) {
+				unsigned i = _cellEdges[k];
+				unsigned j = nextVertex(_zones[_vertexZone[i]], i);
+
+				if (segments_cross(cx, cy, x, y, _verticesX[i], _verticesY[i], _verticesX[j], _verticesY[j])) {
+					inside ^= (1 << _vertexZone[i]);
 				}
+			}
+		}
+
+	} else {
+		for (unsigned z = 0; z <= _zonesCount; z++) {
+			if (!_zones[z].circle && _zones[z].count > 0 && insidePolygon(_zones[z], x, y)) {
+				inside |= (1 << z);
+			}
+		}
+	}
+
+	/* inside at least one inclusion zone, if there are any, and outside all exclusion zones */
+	bool inclusions = false;
+	bool included = false;
 
+	for (unsigned z = 0; z <= _zonesCount; z++) {
+		const Zone &zone = _zones[z];
+
+		if (zone.circle) {
+			float dx = x - zone.x;
+			float dy = y - zone.y;
+
+			if (dx * dx + dy * dy <= zone.radius * zone.radius) {
+				inside |= (1 << z);
 			}
 
-			return c;
-		} else {
-			/* Empty fence --> accept all points */
-			return true;
+		} else if (zone.count == 0) {
+			continue;
 		}
 
-	} else {
-		/* Invalid fence --> accept all points */
-		return true;
+		if (zone.exclude) {
+			if (inside & (1 << z)) {
+				return false;
+			}
+
+		} else {
+			inclusions = true;
+			included = included || (inside & (1 << z));
+		}
 	}
+
+	return !inclusions || included;
 }
 
 bool
@@ -191,8 +485,9 @@ Geofence::valid()
 	if (isEmpty())
 		return true;
 
-	// Otherwise
-	if ((_verticesCount < 4) || (_verticesCount > GEOFENCE_MAX_VERTICES)) {
+	// Otherwise, the zones of the fence file are checked when loaded
+	if ((_verticesCount != 0 || _zonesCount == 0) &&
+	    ((_verticesCount < 4) || (_verticesCount > GEOFENCE_MAX_VERTICES))) {
 		warnx("Fence must have at least 3 sides and not more than %d", GEOFENCE_MAX_VERTICES - 1);
 		return false;
 	}
@@ -200,6 +495,17 @@ Geofence::valid()
 	return true;
 }
 
+unsigned
+Geofence::version()
+{
+	/* a fence not loaded yet might differ from the last one loaded */
+	if (!_verticesLoaded && (isEmpty() || loadVertices() != OK)) {
+		_version++;
+	}
+
+	return (_version << 1) | (_param_geofence_on.get() == 1 ? 1 : 0);
+}
+
 void
 Geofence::addPoint(int argc, char *argv[])
 {
@@ -210,6 +516,8 @@ Geofence::addPoint(int argc, char *argv[])
 
 	if ((argc == 1) && (strcmp("-clear", argv[0]) == 0)) {
 		dm_clear(DM_KEY_FENCE_POINTS);
+		_verticesCount = 0;
+		_verticesLoaded = false;
 		publishFence(0);
 		return;
 	}
@@ -232,8 +540,17 @@ Geofence::addPoint(int argc, char *argv[])
 	vertex.lon = (float)lon;
 
 	if (dm_write(DM_KEY_FENCE_POINTS, ix, DM_PERSIST_POWER_ON_RESET, &vertex, sizeof(vertex)) == sizeof(vertex)) {
-		if (last)
-			publishFence((unsigned)ix + 1);
+		/* the published fence is what gets checked, reloaded on the next check */
+		_verticesLoaded = false;
+
+		if (_zonesCount == 0) {
+			_originSet = false;
+		}
+
+		if (last) {
+			_verticesCount = (unsigned)ix + 1;
+			publishFence(_verticesCount);
+		}
 		return;
 	}
 
@@ -260,6 +577,11 @@ Geofence::loadFromFile(const char *filename)
 
 	/* Make sure no data is left in the datamanager */
 	clearDm();
+	_verticesCount = 0;
+	_zonesCount = 0;
+	_zoneVerticesCount = 0;
+	_verticesLoaded = false;
+	_originSet = false;
 
 	/* open the mixer definition file */
 	fp = fopen(GEOFENCE_FILENAME, "r");
@@ -283,6 +605,19 @@ Geofence::loadFromFile(const char *filename)
 			continue;
 
 		if (gotVertical) {
+			/* POLYGON INCLUDE|EXCLUDE starts a zone with the points that follow, CIRCLE ... lat lon radius is one */
+			if (strncmp(&line[textStart], "POLYGON", 7) == 0 || strncmp(&line[textStart], "CIRCLE", 6) == 0) {
+				if (addZone(&line[textStart]) != OK) {
+					warnx("Geofence: invalid zone: %s", &line[textStart]);
+					fclose(fp);
+					_zonesCount = 0;
+					_zoneVerticesCount = 0;
+					return ERROR;
+				}
+
+				continue;
+			}
+
 			/* Parse the line as a geofence point */
 			struct fence_vertex_s vertex;
 
@@ -306,6 +641,25 @@ Geofence::loadFromFile(const char *filename)
 					return ERROR;
 			}
 
+			if (_zonesCount > 0) {
+				/* a point of the last zone */
+				Zone &zone = _zones[_zonesCount];
+
+				if (zone.circle || _zoneVerticesCount >= GEOFENCE_MAX_ZONE_VERTICES) {
+					warnx("Geofence: point outside a polygon zone or too many");
+					fclose(fp);
+					_zonesCount = 0;
+					_zoneVerticesCount = 0;
+					return ERROR;
+				}
+
+				unsigned ix = GEOFENCE_MAX_VERTICES + _zoneVerticesCount++;
+				project((double)vertex.lat, (double)vertex.lon, &_verticesX[ix], &_verticesY[ix]);
+				_vertexZone[ix] = _zonesCount;
+				zone.count++;
+				continue;
+			}
+
 			if (dm_write(DM_KEY_FENCE_POINTS, pointCounter, DM_PERSIST_POWER_ON_RESET, &vertex, sizeof(vertex)) != sizeof(vertex))
 								return ERROR;
 
@@ -327,8 +681,18 @@ Geofence::loadFromFile(const char *filename)
 
 	fclose(fp);
 
+	/* every polygon zone needs an area */
+	for (unsigned z = 1; z <= _zonesCount; z++) {
+		if (!_zones[z].circle && _zones[z].count < 3) {
+			warnx("Geofence: zone %u has less than 3 points", z);
+			_zonesCount = 0;
+			_zoneVerticesCount = 0;
+			gotVertical = false;
+		}
+	}
+
 	/* Check if import was successful */
-	if(gotVertical && pointCounter > 0)
+	if(gotVertical && (pointCounter > 0 || _zonesCount > 0))
 	{
 		_verticesCount = pointCounter;
 		warnx("Geofence: imported successfully");
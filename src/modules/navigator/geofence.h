@@ -50,6 +50,11 @@
 
 #define GEOFENCE_FILENAME "/fs/microsd/etc/geofence.txt"
 
+#define GEOFENCE_MAX_ZONES		16	/**< inclusion and exclusion zones of the fence file */
+#define GEOFENCE_MAX_ZONE_VERTICES	240	/**< polygon vertices of all zones together */
+#define GEOFENCE_GRID_SIZE		8	/**< cells per side of the polygon edge index */
+#define GEOFENCE_GRID_ENTRIES		512	/**< polygon edges listed in the index cells */
+
 class Geofence : public control::SuperBlock
 {
 public:
@@ -83,6 +88,12 @@ public:
 
 	bool valid();
 
+	/**
+	 * Number that changes whenever inside_polygon() may give a different
+	 * result for the same position, because the fence or GF_ON changed.
+	 */
+	unsigned version();
+
 	/**
 	 * Specify fence vertex position.
 	 */
@@ -92,7 +103,7 @@ public:
 
 	int loadFromFile(const char *filename);
 
-	bool isEmpty() {return _verticesCount == 0;}
+	bool isEmpty() {return _verticesCount == 0 && _zonesCount == 0;}
 
 	int getAltitudeMode() { return _param_altitude_mode.get(); }
 
@@ -108,6 +119,52 @@ private:
 
 	unsigned 			_verticesCount;
 
+	/**
+	 * An inclusion or exclusion area.
+	 *
+	 * Zone 0 is the polygon kept in the datamanager, the others come from
+	 * the fence file and only live in RAM.
+	 */
+	struct Zone {
+		bool		circle;
+		bool		exclude;
+		uint16_t	first;			/**< first vertex of a polygon */
+		uint16_t	count;			/**< vertices of a polygon, 0 for none */
+		float		x;			/**< center of a circle */
+		float		y;
+		float		radius;
+	};
+
+	Zone			_zones[1 + GEOFENCE_MAX_ZONES];
+	unsigned		_zonesCount;		/**< zones from the fence file */
+	unsigned		_zoneVerticesCount;	/**< vertices of the polygon zones from the fence file */
+
+	/* Vertices in RAM, projected to meters north and east of the origin */
+	bool			_verticesLoaded;
+	unsigned		_version;		/**< counts the loads of the vertices */
+	bool			_originSet;
+	double			_originLat;
+	double			_originLon;
+	float			_lonScale;		/**< meters per degree of longitude at the origin */
+	float			_verticesX[GEOFENCE_MAX_VERTICES + GEOFENCE_MAX_ZONE_VERTICES];
+	float			_verticesY[GEOFENCE_MAX_VERTICES + GEOFENCE_MAX_ZONE_VERTICES];
+	uint8_t			_vertexZone[GEOFENCE_MAX_VERTICES + GEOFENCE_MAX_ZONE_VERTICES];
+
+	/*
+	 * Uniform grid over the polygons. Each cell knows which polygons contain
+	 * its center and lists the edges overlapping it, a point is then inside
+	 * a polygon if the way from the cell center crosses its edges an odd
+	 * number of times.
+	 */
+	bool			_gridValid;		/**< false: too many edges, all are checked */
+	float			_gridX;			/**< corner of the grid */
+	float			_gridY;
+	float			_cellSizeX;
+	float			_cellSizeY;
+	uint32_t		_cellInside[GEOFENCE_GRID_SIZE * GEOFENCE_GRID_SIZE];	/**< bit per zone */
+	uint16_t		_cellFirst[GEOFENCE_GRID_SIZE * GEOFENCE_GRID_SIZE + 1];	/**< first entry of each cell */
+	uint16_t		_cellEdges[GEOFENCE_GRID_ENTRIES];	/**< first vertex of each edge */
+
 	/* Params */
 	control::BlockParamInt _param_geofence_on;
 	control::BlockParamInt _param_altitude_mode;
@@ -120,6 +177,53 @@ private:
 
 	bool inside(double lat, double lon, float altitude);
 	bool inside(const struct vehicle_global_position_s &global_position);
+
+	/**
+	 * Read the fence vertices from the datamanager into RAM and index the
+	 * polygon edges.
+	 *
+	 * @return OK if all vertices could be read
+	 */
+	int loadVertices();
+
+	/**
+	 * Project a position to meters north and east of the origin.
+	 *
+	 * The projection is linear in latitude and longitude, so the polygon
+	 * test gives the same result as on the coordinates themselves. The
+	 * first position projected becomes the origin.
+	 */
+	void project(double lat, double lon, float *x, float *y);
+
+	/**
+	 * Add a zone from a POLYGON or CIRCLE line of the fence file.
+	 *
+	 * @return OK if the line is valid and the zone fits
+	 */
+	int addZone(const char *line);
+
+	/**
+	 * Build the edge index of all polygons.
+	 */
+	void buildGrid();
+
+	/**
+	 * Index of the vertex an edge of a polygon zone ends at.
+	 */
+	unsigned nextVertex(const Zone &zone, unsigned i)
+	{
+		return (i + 1 < (unsigned)zone.first + zone.count) ? i + 1 : zone.first;
+	}
+
+	/**
+	 * Polygon test over all edges of a zone.
+	 */
+	bool insidePolygon(const Zone &zone, float x, float y);
+
+	/**
+	 * Check a projected position against all zones.
+	 */
+	bool insideZones(float x, float y);
 	bool inside(const struct vehicle_global_position_s &global_position, float baro_altitude_amsl);
 };
 
@@ -79,8 +79,11 @@ Mission::Mission(Navigator *navigator, const char *name) :
 	_missionFeasiblityChecker(),
 	_min_current_sp_distance_xy(FLT_MAX),
 	_mission_item_previous_alt(NAN),
-	_distance_current_previous(0.0f)
+	_distance_current_previous(0.0f),
+	_lookahead_next(0)
 {
+	reset_lookahead();
+
 	/* load initial params */
 	updateParams();
 }
@@ -118,11 +121,17 @@ Mission::on_inactive()
 	if (!_navigator->get_can_loiter_at_sp() || _navigator->get_vstatus()->condition_landed) {
 		_need_takeoff = true;
 	}
+
+	/* continue a feasibility check in progress */
+	_missionFeasiblityChecker.update(FEASIBILITY_CHECK_ITEMS);
 }
 
 void
 Mission::on_activation()
 {
+	/* the items might have been changed while another mode was active */
+	reset_lookahead();
+
 	set_mission_items();
 }
 
@@ -171,11 +180,19 @@ Mission::on_active()
 			_navigator->set_can_loiter_at_sp(true);
 		}
 	}
+
+	/* the items ahead are read while flying to the current one, so a transition does not wait for the dataman */
+	prefetch_mission_items();
+
+	/* continue a feasibility check in progress */
+	_missionFeasiblityChecker.update(FEASIBILITY_CHECK_ITEMS);
 }
 
 void
 Mission::update_onboard_mission()
 {
+	reset_lookahead();
+
 	if (orb_copy(ORB_ID(onboard_mission), _navigator->get_onboard_mission_sub(), &_onboard_mission) == OK) {
 		/* accept the current index set by the onboard mission if it is within bounds */
 		if (_onboard_mission.current_seq >=0
@@ -202,6 +219,8 @@ Mission::update_onboard_mission()
 void
 Mission::update_offboard_mission()
 {
+	reset_lookahead();
+
 	if (orb_copy(ORB_ID(offboard_mission), _navigator->get_offboard_mission_sub(), &_offboard_mission) == OK) {
 		warnx("offboard mission updated: dataman_id=%d, count=%d, current_seq=%d", _offboard_mission.dataman_id, _offboard_mission.count, _offboard_mission.current_seq);
 		/* determine current index */
@@ -219,11 +238,12 @@ Mission::update_offboard_mission()
 			/* otherwise, just leave it */
 		}
 
-		/* Check mission feasibility, for now do not handle the return value,
-		 * however warnings are issued to the gcs via mavlink from inside the MissionFeasiblityChecker */
+		/* Check mission feasibility, for now do not handle the result,
+		 * however warnings are issued to the gcs via mavlink from inside the MissionFeasiblityChecker.
+		 * The items are checked a few per cycle, see on_active() and on_inactive() */
 		dm_item_t dm_current = DM_KEY_WAYPOINTS_OFFBOARD(_offboard_mission.dataman_id);
 
-		_missionFeasiblityChecker.checkMissionFeasible(_navigator->get_vstatus()->is_rotary_wing,
+		_missionFeasiblityChecker.startCheck(_navigator->get_vstatus()->is_rotary_wing,
 				dm_current, (size_t) _offboard_mission.count, _navigator->get_geofence(),
 				_navigator->get_home_position()->alt);
 
@@ -607,8 +627,8 @@ Mission::read_mission_item(bool onboard, bool is_current, struct mission_item_s
 		/* read mission item to temp storage first to not overwrite current mission item if data damaged */
 		struct mission_item_s mission_item_tmp;
 
-		/* read mission item from datamanager */
-		if (dm_read(dm_item, *mission_index_ptr, &mission_item_tmp, len) != len) {
+		/* read mission item from the lookahead buffer or the datamanager */
+		if (!read_item_buffered(dm_item, *mission_index_ptr, &mission_item_tmp)) {
 			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 			mavlink_log_critical(_navigator->get_mavlink_fd(),
 			                     "ERROR waypoint could not be read");
@@ -633,6 +653,9 @@ Mission::read_mission_item(bool onboard, bool is_current, struct mission_item_s
 								"ERROR DO JUMP waypoint could not be written");
 						return false;
 					}
+
+					/* keep the buffered copy in line with the dataman */
+					store_lookahead(dm_item, *mission_index_ptr, &mission_item_tmp);
 				}
 				/* set new mission item index and repeat
 				* we don't have to validate here, if it's invalid, we should realize this later .*/
@@ -658,6 +681,103 @@ Mission::read_mission_item(bool onboard, bool is_current, struct mission_item_s
 	return false;
 }
 
+bool
+Mission::read_item_buffered(dm_item_t dm_item, int index, struct mission_item_s *mission_item)
+{
+	for (unsigned i = 0; i < sizeof(_lookahead) / sizeof(_lookahead[0]); i++) {
+		if (_lookahead[i].valid && _lookahead[i].dm_item == dm_item && _lookahead[i].index == index) {
+			memcpy(mission_item, &_lookahead[i].item, sizeof(struct mission_item_s));
+			return true;
+		}
+	}
+
+	const ssize_t len = sizeof(struct mission_item_s);
+
+	if (dm_read(dm_item, index, mission_item, len) != len) {
+		return false;
+	}
+
+	store_lookahead(dm_item, index, mission_item);
+	return true;
+}
+
+void
+Mission::store_lookahead(dm_item_t dm_item, int index, const struct mission_item_s *mission_item)
+{
+	unsigned slot = _lookahead_next;
+
+	/* an item that is buffered already is updated in place */
+	for (unsigned i = 0; i < sizeof(_lookahead) / sizeof(_lookahead[0]); i++) {
+		if (_lookahead[i].valid && _lookahead[i].dm_item == dm_item && _lookahead[i].index == index) {
+			slot = i;
+			break;
+		}
+	}
+
+	if (slot == _lookahead_next) {
+		_lookahead_next = (_lookahead_next + 1) % (sizeof(_lookahead) / sizeof(_lookahead[0]));
+	}
+
+	_lookahead[slot].valid = true;
+	_lookahead[slot].dm_item = dm_item;
+	_lookahead[slot].index = index;
+	memcpy(&_lookahead[slot].item, mission_item, sizeof(struct mission_item_s));
+}
+
+void
+Mission::reset_lookahead()
+{
+	for (unsigned i = 0; i < sizeof(_lookahead) / sizeof(_lookahead[0]); i++) {
+		_lookahead[i].valid = false;
+	}
+
+	_lookahead_next = 0;
+}
+
+void
+Mission::prefetch_mission_items()
+{
+	dm_item_t dm_item;
+	int current;
+	int count;
+
+	switch (_mission_type) {
+	case MISSION_TYPE_ONBOARD:
+		dm_item = DM_KEY_WAYPOINTS_ONBOARD;
+		current = _current_onboard_mission_index;
+		count = _onboard_mission.count;
+		break;
+
+	case MISSION_TYPE_OFFBOARD:
+		dm_item = DM_KEY_WAYPOINTS_OFFBOARD(_offboard_mission.dataman_id);
+		current = _current_offboard_mission_index;
+		count = _offboard_mission.count;
+		break;
+
+	case MISSION_TYPE_NONE:
+	default:
+		return;
+	}
+
+	/* one read per cycle keeps the navigator loop time even */
+	for (int index = current + 1; index <= current + (int)MISSION_LOOKAHEAD_ITEMS && index < count; index++) {
+		bool buffered = false;
+
+		for (unsigned i = 0; i < sizeof(_lookahead) / sizeof(_lookahead[0]); i++) {
+			if (_lookahead[i].valid && _lookahead[i].dm_item == dm_item && _lookahead[i].index == index) {
+				buffered = true;
+				break;
+			}
+		}
+
+		if (!buffered) {
+			struct mission_item_s mission_item;
+			read_item_buffered(dm_item, index, &mission_item);
+			return;
+		}
+	}
+}
+
 void
 Mission::save_offboard_mission_state()
 {
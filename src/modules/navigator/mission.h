@@ -125,6 +125,27 @@ private:
 	 */
 	bool read_mission_item(bool onboard, bool is_current, struct mission_item_s *mission_item);
 
+	/**
+	 * Read a raw mission item, from the lookahead buffer if it holds it
+	 * @return true if successful
+	 */
+	bool read_item_buffered(dm_item_t dm_item, int index, struct mission_item_s *mission_item);
+
+	/**
+	 * Put a raw mission item into the lookahead buffer, replacing the oldest one
+	 */
+	void store_lookahead(dm_item_t dm_item, int index, const struct mission_item_s *mission_item);
+
+	/**
+	 * Drop the lookahead buffer, the missions in the dataman changed
+	 */
+	void reset_lookahead();
+
+	/**
+	 * Read at most one of the items following the current one into the lookahead buffer
+	 */
+	void prefetch_mission_items();
+
 	/**
 	 * Save current offboard mission state to dataman
 	 */
@@ -174,6 +195,20 @@ private:
 					    can be replaced by a full copy of the previous mission item if needed*/
 	float _distance_current_previous; /**< distance from previous to current sp in pos_sp_triplet,
 					    only use if current and previous are valid */
+
+	static const unsigned MISSION_LOOKAHEAD_ITEMS = 4;	/**< items after the current one kept in RAM */
+	static const unsigned FEASIBILITY_CHECK_ITEMS = 16;	/**< mission items checked per navigator cycle */
+
+	struct lookahead_item {
+		bool valid;
+		dm_item_t dm_item;
+		int index;
+		struct mission_item_s item;
+	};
+
+	/* the current item, the ones ahead of it and one spare, filled in order of the mission */
+	struct lookahead_item _lookahead[MISSION_LOOKAHEAD_ITEMS + 2];
+	unsigned _lookahead_next;	/**< slot replaced by the next store */
 };
 
 #endif
@@ -49,6 +49,8 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <string.h>
+#include <crc32.h>
 #include <uORB/topics/fence.h>
 
 /* oddly, ERROR is not defined for c++ */
@@ -57,13 +59,33 @@
 #endif
 static const int ERROR = -1;
 
-MissionFeasibilityChecker::MissionFeasibilityChecker() : _mavlink_fd(-1), _capabilities_sub(-1), _initDone(false)
+/* bits of _itemFlags */
+#define ITEM_FENCE_CHECKED	(1 << 0)
+#define ITEM_FENCE_INSIDE	(1 << 1)
+
+MissionFeasibilityChecker::MissionFeasibilityChecker() : _mavlink_fd(-1), _capabilities_sub(-1), _initDone(false),
+	_checking(false), _isRotarywing(false), _dmCurrent(DM_KEY_WAYPOINTS_OFFBOARD_0), _nMissionItems(0), _nextItem(0),
+	_geofence(nullptr), _homeAlt(0.0f), _fenceValid(false), _resGeofence(true), _resLanding(true),
+	_landingDone(false), _homeAltitudeDone(false), _fenceVersion(0)
 {
 	_nav_caps = {0};
+	memset(&_previousItem, 0, sizeof(_previousItem));
+	memset(_itemCrc, 0, sizeof(_itemCrc));
+	memset(_itemFlags, 0, sizeof(_itemFlags));
 }
 
 
 bool MissionFeasibilityChecker::checkMissionFeasible(bool isRotarywing, dm_item_t dm_current, size_t nMissionItems, Geofence &geofence, float home_alt)
+{
+	startCheck(isRotarywing, dm_current, nMissionItems, geofence, home_alt);
+
+	/* all items at once */
+	update(nMissionItems);
+
+	return feasible();
+}
+
+void MissionFeasibilityChecker::startCheck(bool isRotarywing, dm_item_t dm_current, size_t nMissionItems, Geofence &geofence, float home_alt)
 {
 	/* Init if not done yet */
 	init();
@@ -74,161 +96,175 @@ bool MissionFeasibilityChecker::checkMissionFeasible(bool isRotarywing, dm_item_
 		_mavlink_fd = open(MAVLINK_LOG_DEVICE, 0);
 	}
 
+	if (!isRotarywing) {
+		/* Update fixed wing navigation capabilites */
+		updateNavigationCapabilities();
+	}
 
-	if (isRotarywing)
-		return checkMissionFeasibleRotarywing(dm_current, nMissionItems, geofence, home_alt);
-	else
-		return checkMissionFeasibleFixedwing(dm_current, nMissionItems, geofence, home_alt);
-}
-
-bool MissionFeasibilityChecker::checkMissionFeasibleRotarywing(dm_item_t dm_current, size_t nMissionItems, Geofence &geofence, float home_alt)
-{
-
-	/* Perform checks and issue feedback to the user for all checks */
-	bool resGeofence = checkGeofence(dm_current, nMissionItems, geofence);
-	bool resHomeAltitude = checkHomePositionAltitude(dm_current, nMissionItems, home_alt);
+	_checking = true;
+	_isRotarywing = isRotarywing;
+	_dmCurrent = dm_current;
+	_nMissionItems = nMissionItems;
+	_nextItem = 0;
+	_geofence = &geofence;
+	_homeAlt = home_alt;
 
-	/* Mission is only marked as feasible if all checks return true */
-	return (resGeofence && resHomeAltitude);
+	/* Check if all mission items are inside the geofence (if we have a valid geofence) */
+	_fenceValid = geofence.valid();
+	_resGeofence = true;
+	_resLanding = true;
+	_landingDone = isRotarywing;
+	_homeAltitudeDone = false;
+
+	/* the results of earlier checks only hold for the same fence */
+	unsigned version = geofence.version();
+
+	if (version != _fenceVersion) {
+		memset(_itemFlags, 0, sizeof(_itemFlags));
+		_fenceVersion = version;
+	}
 }
 
-bool MissionFeasibilityChecker::checkMissionFeasibleFixedwing(dm_item_t dm_current, size_t nMissionItems, Geofence &geofence, float home_alt)
+bool MissionFeasibilityChecker::pending()
 {
-	/* Update fixed wing navigation capabilites */
-	updateNavigationCapabilities();
-//	warnx("_nav_caps.landing_slope_angle_rad %.4f, _nav_caps.landing_horizontal_slope_displacement %.4f", _nav_caps.landing_slope_angle_rad, _nav_caps.landing_horizontal_slope_displacement);
-
-	/* Perform checks and issue feedback to the user for all checks */
-	bool resLanding = checkFixedWingLanding(dm_current, nMissionItems);
-	bool resGeofence = checkGeofence(dm_current, nMissionItems, geofence);
-	bool resHomeAltitude = checkHomePositionAltitude(dm_current, nMissionItems, home_alt);
-
-	/* Mission is only marked as feasible if all checks return true */
-	return (resLanding && resGeofence && resHomeAltitude);
+	return (_fenceValid && _resGeofence) || !_homeAltitudeDone || !_landingDone;
 }
 
-bool MissionFeasibilityChecker::checkGeofence(dm_item_t dm_current, size_t nMissionItems, Geofence &geofence)
+bool MissionFeasibilityChecker::update(size_t maxItems)
 {
-	/* Check if all mission items are inside the geofence (if we have a valid geofence) */
-	if (geofence.valid()) {
-		for (size_t i = 0; i < nMissionItems; i++) {
-			struct mission_item_s missionitem;
-			const ssize_t len = sizeof(missionitem);
+	if (!_checking) {
+		return true;
+	}
 
-			if (dm_read(dm_current, i, &missionitem, len) != len) {
-				/* not supposed to happen unless the datamanager can't access the SD card, etc. */
-				return false;
+	/* Perform checks and issue feedback to the user for all checks, every item is read once */
+	for (size_t n = 0; n < maxItems && _nextItem < _nMissionItems && pending(); n++, _nextItem++) {
+		struct mission_item_s missionitem;
+		const ssize_t len = sizeof(missionitem);
+
+		if (dm_read(_dmCurrent, _nextItem, &missionitem, len) != len) {
+			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
+			if (_fenceValid) {
+				_resGeofence = false;
 			}
 
-			if (!geofence.inside_polygon(missionitem.lat, missionitem.lon, missionitem.altitude)) {
-				mavlink_log_info(_mavlink_fd, "#audio: Geofence violation waypoint %d", i);
-				return false;
+			if (!_landingDone) {
+				_resLanding = false;
 			}
+
+			_nextItem = _nMissionItems;
+			break;
 		}
+
+		if (_fenceValid && _resGeofence) {
+			_resGeofence = checkGeofence(_nextItem, missionitem);
+		}
+
+		if (!_homeAltitudeDone) {
+			checkHomePositionAltitude(_nextItem, missionitem);
+		}
+
+		if (!_landingDone) {
+			_resLanding = checkFixedWingLanding(_nextItem, missionitem);
+		}
+
+		memcpy(&_previousItem, &missionitem, sizeof(_previousItem));
 	}
 
+	if (_nextItem < _nMissionItems && pending()) {
+		return false;
+	}
+
+	_checking = false;
 	return true;
 }
 
-bool MissionFeasibilityChecker::checkHomePositionAltitude(dm_item_t dm_current, size_t nMissionItems, float home_alt, bool throw_error)
+bool MissionFeasibilityChecker::checkGeofence(size_t index, const struct mission_item_s &missionitem)
 {
-	/* Check if all all waypoints are above the home altitude, only return false if bool throw_error = true */
-	for (size_t i = 0; i < nMissionItems; i++) {
-		static struct mission_item_s missionitem;
-		const ssize_t len = sizeof(struct mission_item_s);
+	uint32_t crc = crc32((const uint8_t *)&missionitem, sizeof(missionitem));
+	bool inside;
 
-		if (dm_read(dm_current, i, &missionitem, len) != len) {
-			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
-			if (throw_error) {
-				return false;
-			} else	{
-				return true;
-			}
-		}
+	if (index < NUM_MISSIONS_SUPPORTED && (_itemFlags[index] & ITEM_FENCE_CHECKED) && _itemCrc[index] == crc) {
+		/* unchanged item, unchanged fence */
+		inside = (_itemFlags[index] & ITEM_FENCE_INSIDE);
 
-		/* calculate the global waypoint altitude */
-		float wp_alt = (missionitem.altitude_is_relative) ? missionitem.altitude + home_alt : missionitem.altitude;
+	} else {
+		inside = _geofence->inside_polygon(missionitem.lat, missionitem.lon, missionitem.altitude);
 
-		if (home_alt > wp_alt) {
-			if (throw_error) {
-				mavlink_log_critical(_mavlink_fd, "Rejecting Mission: Waypoint %d below home", i);
-				return false;
-			} else	{
-				mavlink_log_critical(_mavlink_fd, "Warning: Waypoint %d below home", i);
-				return true;
-			}
+		if (index < NUM_MISSIONS_SUPPORTED) {
+			_itemCrc[index] = crc;
+			_itemFlags[index] = ITEM_FENCE_CHECKED | (inside ? ITEM_FENCE_INSIDE : 0);
 		}
 	}
 
+	if (!inside) {
+		mavlink_log_info(_mavlink_fd, "#audio: Geofence violation waypoint %d", index);
+		return false;
+	}
+
 	return true;
 }
 
-bool MissionFeasibilityChecker::checkFixedWingLanding(dm_item_t dm_current, size_t nMissionItems)
+void MissionFeasibilityChecker::checkHomePositionAltitude(size_t index, const struct mission_item_s &missionitem)
+{
+	/* calculate the global waypoint altitude */
+	float wp_alt = (missionitem.altitude_is_relative) ? missionitem.altitude + _homeAlt : missionitem.altitude;
+
+	/* Warn about the first waypoint below the home altitude, the mission is not rejected */
+	if (_homeAlt > wp_alt) {
+		mavlink_log_critical(_mavlink_fd, "Warning: Waypoint %d below home", index);
+		_homeAltitudeDone = true;
+	}
+}
+
+bool MissionFeasibilityChecker::checkFixedWingLanding(size_t index, const struct mission_item_s &missionitem)
 {
-	/* Go through all mission items and search for a landing waypoint
+	/* Search for the first landing waypoint
 	 * if landing waypoint is found: the previous waypoint is checked to be at a feasible distance and altitude given the landing slope */
 
+	if (missionitem.nav_cmd != NAV_CMD_LAND) {
+		return true;
+	}
 
-	for (size_t i = 0; i < nMissionItems; i++) {
-		struct mission_item_s missionitem;
-		const ssize_t len = sizeof(missionitem);
-		if (dm_read(dm_current, i, &missionitem, len) != len) {
-			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
-			return false;
-		}
+	_landingDone = true;
+
+	if (index == 0) {
+		mavlink_log_info(_mavlink_fd, "#audio: Warning: starting with land waypoint");
+		return false;
+	}
 
-		if (missionitem.nav_cmd == NAV_CMD_LAND) {
-			struct mission_item_s missionitem_previous;
-			if (i != 0) {
-				if (dm_read(dm_current, i-1, &missionitem_previous, len) != len) {
-					/* not supposed to happen unless the datamanager can't access the SD card, etc. */
-					return false;
-				}
-
-				float wp_distance = get_distance_to_next_waypoint(missionitem_previous.lat , missionitem_previous.lon, missionitem.lat, missionitem.lon);
-				float slope_alt_req = Landingslope::getLandingSlopeAbsoluteAltitude(wp_distance, missionitem.altitude, _nav_caps.landing_horizontal_slope_displacement, _nav_caps.landing_slope_angle_rad);
-				float wp_distance_req = Landingslope::getLandingSlopeWPDistance(missionitem_previous.altitude, missionitem.altitude, _nav_caps.landing_horizontal_slope_displacement, _nav_caps.landing_slope_angle_rad);
-				float delta_altitude = missionitem.altitude - missionitem_previous.altitude;
-//				warnx("wp_distance %.2f, delta_altitude %.2f, missionitem_previous.altitude %.2f, missionitem.altitude %.2f, slope_alt_req %.2f, wp_distance_req %.2f",
-//						wp_distance, delta_altitude, missionitem_previous.altitude, missionitem.altitude, slope_alt_req, wp_distance_req);
-//				warnx("_nav_caps.landing_horizontal_slope_displacement %.4f, _nav_caps.landing_slope_angle_rad %.4f, _nav_caps.landing_flare_length %.4f",
-//						_nav_caps.landing_horizontal_slope_displacement, _nav_caps.landing_slope_angle_rad, _nav_caps.landing_flare_length);
-
-				if (wp_distance > _nav_caps.landing_flare_length) {
-					/* Last wp is before flare region */
-
-					if (delta_altitude < 0) {
-						if (missionitem_previous.altitude <= slope_alt_req) {
-							/* Landing waypoint is at or below altitude of slope at the given waypoint distance: this is ok, aircraft will intersect the slope */
-							return true;
-						} else {
-							/* Landing waypoint is above altitude of slope at the given waypoint distance */
-							mavlink_log_info(_mavlink_fd, "#audio: Landing: last waypoint too high/too close");
-							mavlink_log_info(_mavlink_fd, "Move down to %.1fm or move further away by %.1fm",
-									(double)(slope_alt_req),
-									(double)(wp_distance_req - wp_distance));
-							return false;
-						}
-					} else {
-						/* Landing waypoint is above last waypoint */
-						mavlink_log_info(_mavlink_fd, "#audio: Landing waypoint above last nav waypoint");
-						return false;
-					}
-				} else {
-					/* Last wp is in flare region */
-					//xxx give recommendations
-					mavlink_log_info(_mavlink_fd, "#audio: Warning: Landing: last waypoint in flare region");
-					return false;
-				}
+	const struct mission_item_s &missionitem_previous = _previousItem;
+
+	float wp_distance = get_distance_to_next_waypoint(missionitem_previous.lat , missionitem_previous.lon, missionitem.lat, missionitem.lon);
+	float slope_alt_req = Landingslope::getLandingSlopeAbsoluteAltitude(wp_distance, missionitem.altitude, _nav_caps.landing_horizontal_slope_displacement, _nav_caps.landing_slope_angle_rad);
+	float wp_distance_req = Landingslope::getLandingSlopeWPDistance(missionitem_previous.altitude, missionitem.altitude, _nav_caps.landing_horizontal_slope_displacement, _nav_caps.landing_slope_angle_rad);
+	float delta_altitude = missionitem.altitude - missionitem_previous.altitude;
+
+	if (wp_distance > _nav_caps.landing_flare_length) {
+		/* Last wp is before flare region */
+
+		if (delta_altitude < 0) {
+			if (missionitem_previous.altitude <= slope_alt_req) {
+				/* Landing waypoint is at or below altitude of slope at the given waypoint distance: this is ok, aircraft will intersect the slope */
+				return true;
 			} else {
-				mavlink_log_info(_mavlink_fd, "#audio: Warning: starting with land waypoint");
+				/* Landing waypoint is above altitude of slope at the given waypoint distance */
+				mavlink_log_info(_mavlink_fd, "#audio: Landing: last waypoint too high/too close");
+				mavlink_log_info(_mavlink_fd, "Move down to %.1fm or move further away by %.1fm",
+						(double)(slope_alt_req),
+						(double)(wp_distance_req - wp_distance));
 				return false;
 			}
+		} else {
+			/* Landing waypoint is above last waypoint */
+			mavlink_log_info(_mavlink_fd, "#audio: Landing waypoint above last nav waypoint");
+			return false;
 		}
+	} else {
+		/* Last wp is in flare region */
+		//xxx give recommendations
+		mavlink_log_info(_mavlink_fd, "#audio: Warning: Landing: last waypoint in flare region");
+		return false;
 	}
-
-	/* No landing waypoints or no waypoints */
-	return true;
 }
 
 void MissionFeasibilityChecker::updateNavigationCapabilities()
@@ -59,27 +59,74 @@ private:
 	bool _initDone;
 	void init();
 
-	/* Checks for all airframes */
-	bool checkGeofence(dm_item_t dm_current, size_t nMissionItems, Geofence &geofence);
-	bool checkHomePositionAltitude(dm_item_t dm_current, size_t nMissionItems, float home_alt, bool throw_error = false);
+	/* The check in progress, the items are read and checked in order */
+	bool _checking;
+	bool _isRotarywing;
+	dm_item_t _dmCurrent;
+	size_t _nMissionItems;
+	size_t _nextItem;
+	Geofence *_geofence;
+	float _homeAlt;
+
+	/* Results of the check in progress */
+	bool _fenceValid;		/**< the fence is checked, see Geofence::valid() */
+	bool _resGeofence;
+	bool _resLanding;
+	bool _landingDone;		/**< the first landing waypoint has been checked */
+	bool _homeAltitudeDone;		/**< a waypoint below home has been reported */
+	struct mission_item_s _previousItem;
+
+	/*
+	 * Geofence results of the last checks, by item index. An item whose
+	 * contents and fence did not change since is not tested again.
+	 */
+	unsigned _fenceVersion;
+	uint32_t _itemCrc[NUM_MISSIONS_SUPPORTED];
+	uint8_t _itemFlags[NUM_MISSIONS_SUPPORTED];
+
+	/* Checks of a single mission item, for all airframes */
+	bool checkGeofence(size_t index, const struct mission_item_s &missionitem);
+	void checkHomePositionAltitude(size_t index, const struct mission_item_s &missionitem);
 
 	/* Checks specific to fixedwing airframes */
-	bool checkMissionFeasibleFixedwing(dm_item_t dm_current, size_t nMissionItems, Geofence &geofence, float home_alt);
-	bool checkFixedWingLanding(dm_item_t dm_current, size_t nMissionItems);
+	bool checkFixedWingLanding(size_t index, const struct mission_item_s &missionitem);
 	void updateNavigationCapabilities();
 
-	/* Checks specific to rotarywing airframes */
-	bool checkMissionFeasibleRotarywing(dm_item_t dm_current, size_t nMissionItems, Geofence &geofence, float home_alt);
+	/* Returns true while a check can still find a problem in the items left */
+	bool pending();
+
 public:
 
 	MissionFeasibilityChecker();
 	~MissionFeasibilityChecker() {}
 
 	/*
-	 * Returns true if mission is feasible and false otherwise
+	 * Returns true if mission is feasible and false otherwise, checks all items at once
 	 */
 	bool checkMissionFeasible(bool isRotarywing, dm_item_t dm_current, size_t nMissionItems, Geofence &geofence, float home_alt);
 
+	/*
+	 * Start checking a mission, a check in progress is abandoned
+	 */
+	void startCheck(bool isRotarywing, dm_item_t dm_current, size_t nMissionItems, Geofence &geofence, float home_alt);
+
+	/*
+	 * Check up to maxItems more items of the mission, feedback is given to the user as problems are found
+	 *
+	 * Returns true once the check is complete
+	 */
+	bool update(size_t maxItems);
+
+	/*
+	 * Returns true if a check is in progress
+	 */
+	bool checking() { return _checking; }
+
+	/*
+	 * Returns false if the last check, or the one in progress so far, found the mission infeasible
+	 */
+	bool feasible() { return _resGeofence && _resLanding; }
+
 };
 
 
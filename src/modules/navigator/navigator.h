@@ -56,6 +56,8 @@
 #include <uORB/topics/mission_result.h>
 #include <uORB/topics/vehicle_attitude_setpoint.h>
 
+#include <terrain/terrain.h>
+
 #include "navigator_mode.h"
 #include "mission.h"
 #include "loiter.h"
@@ -144,6 +146,12 @@ public:
 	float		get_acceptance_radius() { return _param_acceptance_radius.get(); }
 	int		get_mavlink_fd() { return _mavlink_fd; }
 
+	/**
+	 * Ground height above MSL from the terrain tiles in RAM, never waits for the SD card.
+	 * Returns false until the tile around the position has been read.
+	 */
+	bool		get_terrain_height(double lat, double lon, float *height) { return terrain_height(&_terrain, lat, lon, height); }
+
 private:
 
 	bool		_task_should_exit;		/**< if true, sensor task should exit */
@@ -190,6 +198,8 @@ private:
 
 	bool		_inside_fence;			/**< vehicle is inside fence */
 
+	struct terrain_s _terrain;			/**< terrain tiles around the vehicle and the mission legs */
+
 	NavigatorMode	*_navigation_mode;		/**< abstract pointer to current navigation mode class */
 	Mission		_mission;			/**< class that handles the missions */
 	Loiter		_loiter;			/**< class that handles loiter */
@@ -151,6 +151,9 @@ Navigator::Navigator() :
 	_navigation_mode_array[5] = &_gpsFailure;
 	_navigation_mode_array[6] = &_rcLoss;
 
+	/* opened by the task */
+	_terrain.fd = -1;
+
 	updateParams();
 }
 
@@ -267,6 +270,11 @@ Navigator::task_main()
 			warnx("Could not clear geofence");
 	}
 
+	/* optional, without it there is just no terrain height */
+	if (terrain_open(&_terrain, TERRAIN_FILENAME) == 0) {
+		warnx("terrain: %ux%u tiles", _terrain.header.tiles_lat, _terrain.header.tiles_lon);
+	}
+
 	/* do subscriptions */
 	_global_pos_sub = orb_subscribe(ORB_ID(vehicle_global_position));
 	_gps_pos_sub = orb_subscribe(ORB_ID(vehicle_gps_position));
@@ -479,10 +487,31 @@ Navigator::task_main()
 		if (_pos_sp_triplet_updated) {
 			publish_position_setpoint_triplet();
 			_pos_sp_triplet_updated = false;
+
+			/* the legs ahead, so their tiles are in RAM before they are flown */
+			if (_pos_sp_triplet.current.valid) {
+				if (_pos_sp_triplet.previous.valid) {
+					terrain_prefetch_leg(&_terrain, _pos_sp_triplet.previous.lat, _pos_sp_triplet.previous.lon,
+							     _pos_sp_triplet.current.lat, _pos_sp_triplet.current.lon);
+				}
+
+				if (_pos_sp_triplet.next.valid) {
+					terrain_prefetch_leg(&_terrain, _pos_sp_triplet.current.lat, _pos_sp_triplet.current.lon,
+							     _pos_sp_triplet.next.lat, _pos_sp_triplet.next.lon);
+				}
+			}
 		}
 
+		if (_global_pos.timestamp != 0) {
+			terrain_prefetch(&_terrain, _global_pos.lat, _global_pos.lon);
+		}
+
+		/* at most one tile read per cycle, the only place the SD card is touched */
+		terrain_update(&_terrain);
+
 		perf_end(_loop_perf);
 	}
+	terrain_close(&_terrain);
 	warnx("exiting.");
 
 	_navigator_task = -1;
@@ -535,6 +564,13 @@ Navigator::status()
 	} else {
 		warnx("Geofence not set (no /etc/geofence.txt on microsd) or not valid");
 	}
+
+	if (terrain_valid(&_terrain)) {
+		warnx("terrain: %u hits, %u misses, %u tiles read", _terrain.hits, _terrain.misses, _terrain.loads);
+
+	} else {
+		warnx("terrain: no %s", TERRAIN_FILENAME);
+	}
 }
 
 void
@@ -0,0 +1,170 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2015 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file est_buffer.c
+ *
+ * History of the position estimate for delayed measurements.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "est_buffer.h"
+
+/* rotation matrix to quaternion, on the largest of the four diagonal sums */
+static void
+dcm_to_q(float R[3][3], float q[4])
+{
+	float tr = R[0][0] + R[1][1] + R[2][2];
+
+	if (tr > 0.0f) {
+		float s = sqrtf(tr + 1.0f) * 2.0f;
+		q[0] = 0.25f * s;
+		q[1] = (R[2][1] - R[1][2]) / s;
+		q[2] = (R[0][2] - R[2][0]) / s;
+		q[3] = (R[1][0] - R[0][1]) / s;
+
+	} else if (R[0][0] > R[1][1] && R[0][0] > R[2][2]) {
+		float s = sqrtf(1.0f + R[0][0] - R[1][1] - R[2][2]) * 2.0f;
+		q[0] = (R[2][1] - R[1][2]) / s;
+		q[1] = 0.25f * s;
+		q[2] = (R[0][1] + R[1][0]) / s;
+		q[3] = (R[0][2] + R[2][0]) / s;
+
+	} else if (R[1][1] > R[2][2]) {
+		float s = sqrtf(1.0f + R[1][1] - R[0][0] - R[2][2]) * 2.0f;
+		q[0] = (R[0][2] - R[2][0]) / s;
+		q[1] = (R[0][1] + R[1][0]) / s;
+		q[2] = 0.25f * s;
+		q[3] = (R[1][2] + R[2][1]) / s;
+
+	} else {
+		float s = sqrtf(1.0f + R[2][2] - R[0][0] - R[1][1]) * 2.0f;
+		q[0] = (R[1][0] - R[0][1]) / s;
+		q[1] = (R[0][2] + R[2][0]) / s;
+		q[2] = (R[1][2] + R[2][1]) / s;
+		q[3] = 0.25f * s;
+	}
+}
+
+static void
+q_to_dcm(const float q[4], float R[3][3])
+{
+	float aa = q[0] * q[0];
+	float bb = q[1] * q[1];
+	float cc = q[2] * q[2];
+	float dd = q[3] * q[3];
+
+	R[0][0] = aa + bb - cc - dd;
+	R[0][1] = 2.0f * (q[1] * q[2] - q[0] * q[3]);
+	R[0][2] = 2.0f * (q[0] * q[2] + q[1] * q[3]);
+	R[1][0] = 2.0f * (q[1] * q[2] + q[0] * q[3]);
+	R[1][1] = aa - bb + cc - dd;
+	R[1][2] = 2.0f * (q[2] * q[3] - q[0] * q[1]);
+	R[2][0] = 2.0f * (q[1] * q[3] - q[0] * q[2]);
+	R[2][1] = 2.0f * (q[0] * q[1] + q[2] * q[3]);
+	R[2][2] = aa - bb - cc + dd;
+}
+
+/* entry i, counted from the oldest */
+static const struct est_buffer_entry_s *
+entry(const struct est_buffer_s *buf, unsigned i)
+{
+	return &buf->entries[(buf->next + EST_BUF_SIZE - buf->count + i) % EST_BUF_SIZE];
+}
+
+void
+est_buffer_init(struct est_buffer_s *buf)
+{
+	memset(buf, 0, sizeof(*buf));
+}
+
+bool
+est_buffer_push(struct est_buffer_s *buf, hrt_abstime t, float est[3][2], float R[3][3])
+{
+	if (buf->count > 0 && t < entry(buf, buf->count - 1)->timestamp + EST_BUF_INTERVAL) {
+		return false;
+	}
+
+	struct est_buffer_entry_s *e = &buf->entries[buf->next];
+
+	e->timestamp = t;
+	memcpy(e->est, est, sizeof(e->est));
+	dcm_to_q(R, e->q);
+
+	buf->next = (buf->next + 1) % EST_BUF_SIZE;
+
+	if (buf->count < EST_BUF_SIZE) {
+		buf->count++;
+	}
+
+	return true;
+}
+
+bool
+est_buffer_get(const struct est_buffer_s *buf, hrt_abstime t, float est[3][2], float R[3][3])
+{
+	if (buf->count == 0) {
+		return false;
+	}
+
+	/* first entry newer than t */
+	unsigned i = 0;
+
+	while (i < buf->count && entry(buf, i)->timestamp <= t) {
+		i++;
+	}
+
+	if (i == 0 || i == buf->count) {
+		/* outside the history */
+		const struct est_buffer_entry_s *e = entry(buf, i == 0 ? 0 : buf->count - 1);
+		memcpy(est, e->est, sizeof(e->est));
+		q_to_dcm(e->q, R);
+		return true;
+	}
+
+	const struct est_buffer_entry_s *e0 = entry(buf, i - 1);
+	const struct est_buffer_entry_s *e1 = entry(buf, i);
+	float k = (float)(t - e0->timestamp) / (float)(e1->timestamp - e0->timestamp);
+
+	for (int axis = 0; axis < 3; axis++) {
+		for (int j = 0; j < 2; j++) {
+			est[axis][j] = e0->est[axis][j] + (e1->est[axis][j] - e0->est[axis][j]) * k;
+		}
+	}
+
+	q_to_dcm(k < 0.5f ? e0->q : e1->q, R);
+
+	return true;
+}
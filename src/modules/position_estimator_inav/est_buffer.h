@@ -0,0 +1,96 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2015 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file est_buffer.h
+ *
+ * History of the position estimate for delayed measurements.
+ *
+ * A ring of timestamped estimates with the attitude as a quaternion,
+ * stored at most every EST_BUF_INTERVAL. A measurement that was taken at
+ * some time in the past is compared to the estimate of that time, so the
+ * delay may vary from one measurement to the next.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <drivers/drv_hrt.h>
+
+__BEGIN_DECLS
+
+#define EST_BUF_INTERVAL	20000	/**< minimum time between two entries */
+#define EST_BUF_SIZE		25	/**< entries, EST_BUF_SIZE * EST_BUF_INTERVAL is the longest delay */
+
+struct est_buffer_entry_s {
+	hrt_abstime	timestamp;
+	float		est[3][2];	/**< x, y, z position and velocity */
+	float		q[4];		/**< attitude, w x y z */
+};
+
+struct est_buffer_s {
+	struct est_buffer_entry_s	entries[EST_BUF_SIZE];
+	unsigned			next;	/**< entry written next */
+	unsigned			count;	/**< valid entries */
+};
+
+/**
+ * Clear the history.
+ */
+void est_buffer_init(struct est_buffer_s *buf);
+
+/**
+ * Store the estimate, unless the last entry is more recent than EST_BUF_INTERVAL.
+ *
+ * @param t		Time of the estimate.
+ * @param est		x, y, z position and velocity.
+ * @param R		Rotation matrix body to world.
+ * @return		true if the estimate was stored.
+ */
+bool est_buffer_push(struct est_buffer_s *buf, hrt_abstime t, float est[3][2], float R[3][3]);
+
+/**
+ * Look up the estimate at a time in the past.
+ *
+ * Position and velocity are interpolated between the two entries around t,
+ * the attitude is the one of the closer entry. Times outside the history
+ * give the oldest or the newest entry.
+ *
+ * @param t		Time of the measurement.
+ * @param est		Filled with the position and velocity at that time.
+ * @param R		Filled with the rotation matrix at that time.
+ * @return		false if the history is empty.
+ */
+bool est_buffer_get(const struct est_buffer_s *buf, hrt_abstime t, float est[3][2], float R[3][3]);
+
+__END_DECLS
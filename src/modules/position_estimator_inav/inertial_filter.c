@@ -31,3 +31,39 @@ void inertial_filter_correct(float e, float dt, float x[2], int i, float w)
 		}
 	}
 }
+
+void inertial_filter_predict_axes(float dt, float x[][2], const float acc[], int axes)
+{
+	if (!isfinite(dt)) {
+		return;
+	}
+
+	for (int i = 0; i < axes; i++) {
+		float a = isfinite(acc[i]) ? acc[i] : 0.0f;
+		x[i][0] += x[i][1] * dt + a * dt * dt / 2.0f;
+		x[i][1] += a * dt;
+	}
+}
+
+void inertial_filter_correct_axes(float e[][2], float dt, float x[][2], float w[][2], int axes)
+{
+	if (!isfinite(dt)) {
+		return;
+	}
+
+	for (int i = 0; i < axes; i++) {
+		/* a non finite error or weight gives a non finite step, which is dropped */
+		float ewdt = e[i][0] * w[i][0] * dt;
+
+		if (isfinite(ewdt)) {
+			x[i][0] += ewdt;
+			x[i][1] += w[i][0] * ewdt;
+		}
+
+		ewdt = e[i][1] * w[i][1] * dt;
+
+		if (isfinite(ewdt)) {
+			x[i][1] += ewdt;
+		}
+	}
+}
@@ -11,3 +11,25 @@
 void inertial_filter_predict(float dt, float x[3], float acc);
 
 void inertial_filter_correct(float e, float dt, float x[3], int i, float w);
+
+/**
+ * Prediction of several axes at once.
+ *
+ * @param x	State of each axis, position and velocity.
+ * @param acc	Acceleration of each axis.
+ * @param axes	Number of axes in x and acc.
+ */
+void inertial_filter_predict_axes(float dt, float x[][2], const float acc[], int axes);
+
+/**
+ * Correction of several axes from one source.
+ *
+ * Applies the position then the velocity error of each axis, as
+ * inertial_filter_correct() does. A weight of 0 leaves that state alone.
+ *
+ * @param e	Position and velocity error of each axis.
+ * @param x	State of each axis, position and velocity.
+ * @param w	Position and velocity weight of each axis.
+ * @param axes	Number of axes in e, x and w.
+ */
+void inertial_filter_correct_axes(float e[][2], float dt, float x[][2], float w[][2], int axes);
@@ -38,6 +38,7 @@
 MODULE_COMMAND	 	= position_estimator_inav
 SRCS		 	= position_estimator_inav_main.c \
 			position_estimator_inav_params.c \
-			inertial_filter.c
+			inertial_filter.c \
+			est_buffer.c
 
 MODULE_STACKSIZE = 1200
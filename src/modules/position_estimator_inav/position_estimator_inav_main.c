@@ -71,10 +71,10 @@
 
 #include "position_estimator_inav_params.h"
 #include "inertial_filter.h"
+#include "est_buffer.h"
 
 #define MIN_VALID_W 0.00001f
 #define PUB_INTERVAL 10000	// limit publish rate to 100 Hz
-#define EST_BUF_SIZE 250000 / PUB_INTERVAL		// buffer size is 0.5s
 
 static bool thread_should_exit = false; /**< Deamon exit flag */
 static bool thread_running = false; /**< Deamon status flag */
@@ -90,22 +90,14 @@ static const hrt_abstime xy_src_timeout = 2000000;	// estimate position during t
 static const uint32_t updates_counter_len = 1000000;
 static const float max_flow = 1.0f;	// max flow value that can be used, rad/s
 
+static struct est_buffer_s est_buf;	// estimate history for GPS delay compensation, kept off the stack
+
 __EXPORT int position_estimator_inav_main(int argc, char *argv[]);
 
 int position_estimator_inav_thread_main(int argc, char *argv[]);
 
 static void usage(const char *reason);
 
-static inline int min(int val1, int val2)
-{
-	return (val1 < val2) ? val1 : val2;
-}
-
-static inline int max(int val1, int val2)
-{
-	return (val1 > val2) ? val1 : val2;
-}
-
 /**
  * Print the correct usage.
  */
@@ -149,7 +141,7 @@ int position_estimator_inav_main(int argc, char *argv[])
 
 		thread_should_exit = false;
 		position_estimator_inav_task = task_spawn_cmd("position_estimator_inav",
-					       SCHED_DEFAULT, SCHED_PRIORITY_MAX - 5, 5000,
+					       SCHED_DEFAULT, SCHED_PRIORITY_MAX - 5, 4000,
 					       position_estimator_inav_thread_main,
 					       (argv) ? (const char **) &argv[2] : (const char **) NULL);
 		exit(0);
@@ -215,17 +207,15 @@ int position_estimator_inav_thread_main(int argc, char *argv[])
 	mavlink_fd = open(MAVLINK_LOG_DEVICE, 0);
 	mavlink_log_info(mavlink_fd, "[inav] started");
 
-	float x_est[2] = { 0.0f, 0.0f };	// pos, vel
-	float y_est[2] = { 0.0f, 0.0f };	// pos, vel
-	float z_est[2] = { 0.0f, 0.0f };	// pos, vel
+	float est[3][2];		// x, y, z: pos, vel
+	memset(est, 0, sizeof(est));
+	float *x_est = est[0];
+	float *y_est = est[1];
+	float *z_est = est[2];
 
-	float est_buf[EST_BUF_SIZE][3][2];	// estimated position buffer
-	float R_buf[EST_BUF_SIZE][3][3];	// rotation matrix buffer
 	float R_gps[3][3];					// rotation matrix for GPS correction moment
-	memset(est_buf, 0, sizeof(est_buf));
-	memset(R_buf, 0, sizeof(R_buf));
 	memset(R_gps, 0, sizeof(R_gps));
-	int buf_ptr = 0;
+	est_buffer_init(&est_buf);
 
 	static const float min_eph_epv = 2.0f;	// min EPH/EPV, used for weight calculation
 	static const float max_eph_epv = 20.0f;	// max EPH/EPV acceptable for estimation
@@ -238,10 +228,11 @@ int position_estimator_inav_thread_main(int argc, char *argv[])
 	float eph_vision = 0.5f;
 	float epv_vision = 0.5f;
 
-	float x_est_prev[2], y_est_prev[2], z_est_prev[2];
-	memset(x_est_prev, 0, sizeof(x_est_prev));
-	memset(y_est_prev, 0, sizeof(y_est_prev));
-	memset(z_est_prev, 0, sizeof(z_est_prev));
+	float est_prev[3][2];
+	memset(est_prev, 0, sizeof(est_prev));
+	float *x_est_prev = est_prev[0];
+	float *y_est_prev = est_prev[1];
+	float *z_est_prev = est_prev[2];
 
 	int baro_init_cnt = 0;
 	int baro_init_num = 200;
@@ -550,8 +541,17 @@ int position_estimator_inav_thread_main(int argc, char *argv[])
 
 					/* convert raw flow to angular flow (rad/s) */
 					float flow_ang[2];
-					flow_ang[0] = flow.flow_raw_x * params.flow_k / 1000.0f / flow_dt;
-					flow_ang[1] = flow.flow_raw_y * params.flow_k / 1000.0f / flow_dt;
+
+					if (flow.integration_timespan > 0) {
+						/* take out the body rotation, integrated over the same window as the flow */
+						float flow_window = flow.integration_timespan * 1e-6f;
+						flow_ang[0] = (flow.flow_raw_x * params.flow_k / 1000.0f + flow.gyro_y_rate_integral) / flow_window;
+						flow_ang[1] = (flow.flow_raw_y * params.flow_k / 1000.0f - flow.gyro_x_rate_integral) / flow_window;
+
+					} else {
+						flow_ang[0] = flow.flow_raw_x * params.flow_k / 1000.0f / flow_dt;
+						flow_ang[1] = flow.flow_raw_y * params.flow_k / 1000.0f / flow_dt;
+					}
 					/* flow measurements vector */
 					float flow_m[3];
 					flow_m[0] = -flow_ang[0] * flow_dist;
@@ -739,22 +739,30 @@ int position_estimator_inav_thread_main(int argc, char *argv[])
 							y_est[1] = gps.vel_e_m_s;
 						}
 
-						/* calculate index of estimated values in buffer */
-						int est_i = buf_ptr - 1 - min(EST_BUF_SIZE - 1, max(0, (int)(params.delay_gps * 1000000.0f / PUB_INTERVAL)));
-						if (est_i < 0) {
-							est_i += EST_BUF_SIZE;
+						/* estimate and rotation matrix at the time the fix was taken */
+						float est_gps[3][2];
+						hrt_abstime t_fix = gps.timestamp_position - (hrt_abstime)(fmaxf(params.delay_gps, 0.0f) * 1000000.0f);
+
+						if (!est_buffer_get(&est_buf, t_fix, est_gps, R_gps)) {
+							est_gps[0][0] = x_est[0];
+							est_gps[0][1] = x_est[1];
+							est_gps[1][0] = y_est[0];
+							est_gps[1][1] = y_est[1];
+							est_gps[2][0] = z_est[0];
+							est_gps[2][1] = z_est[1];
+							memcpy(R_gps, att.R, sizeof(R_gps));
 						}
 
 						/* calculate correction for position */
-						corr_gps[0][0] = gps_proj[0] - est_buf[est_i][0][0];
-						corr_gps[1][0] = gps_proj[1] - est_buf[est_i][1][0];
-						corr_gps[2][0] = local_pos.ref_alt - alt - est_buf[est_i][2][0];
+						corr_gps[0][0] = gps_proj[0] - est_gps[0][0];
+						corr_gps[1][0] = gps_proj[1] - est_gps[1][0];
+						corr_gps[2][0] = local_pos.ref_alt - alt - est_gps[2][0];
 
 						/* calculate correction for velocity */
 						if (gps.vel_ned_valid) {
-							corr_gps[0][1] = gps.vel_n_m_s - est_buf[est_i][0][1];
-							corr_gps[1][1] = gps.vel_e_m_s - est_buf[est_i][1][1];
-							corr_gps[2][1] = gps.vel_d_m_s - est_buf[est_i][2][1];
+							corr_gps[0][1] = gps.vel_n_m_s - est_gps[0][1];
+							corr_gps[1][1] = gps.vel_e_m_s - est_gps[1][1];
+							corr_gps[2][1] = gps.vel_d_m_s - est_gps[2][1];
 
 						} else {
 							corr_gps[0][1] = 0.0f;
@@ -762,9 +770,6 @@ int position_estimator_inav_thread_main(int argc, char *argv[])
 							corr_gps[2][1] = 0.0f;
 						}
 
-						/* save rotation matrix at this moment */
-						memcpy(R_gps, R_buf[est_i], sizeof(R_gps));
-
 						w_gps_xy = min_eph_epv / fmaxf(min_eph_epv, gps.eph);
 						w_gps_z = min_eph_epv / fmaxf(min_eph_epv, gps.epv);
 					}
@@ -945,98 +950,123 @@ int position_estimator_inav_thread_main(int argc, char *argv[])
 			}
 		}
 
-		/* inertial filter prediction for altitude */
-		inertial_filter_predict(dt, z_est, acc[2]);
+		/* inertial filter prediction, for xy only while it can be estimated */
+		if (can_estimate_xy) {
+			inertial_filter_predict_axes(dt, est, acc, 3);
+
+		} else {
+			inertial_filter_predict_axes(dt, &est[2], &acc[2], 1);
+		}
 
 		if (!(isfinite(z_est[0]) && isfinite(z_est[1]))) {
 			write_debug_log("BAD ESTIMATE AFTER Z PREDICTION", dt, x_est, y_est, z_est, x_est_prev, y_est_prev, z_est_prev, acc, corr_gps, w_xy_gps_p, w_xy_gps_v);
-			memcpy(z_est, z_est_prev, sizeof(z_est));
+			memcpy(z_est, z_est_prev, sizeof(est[0]));
 		}
 
-		/* inertial filter correction for altitude */
+		if (can_estimate_xy && !(isfinite(x_est[0]) && isfinite(x_est[1]) && isfinite(y_est[0]) && isfinite(y_est[1]))) {
+			write_debug_log("BAD ESTIMATE AFTER PREDICTION", dt, x_est, y_est, z_est, x_est_prev, y_est_prev, z_est_prev, acc, corr_gps, w_xy_gps_p, w_xy_gps_v);
+			memcpy(x_est, x_est_prev, sizeof(est[0]));
+			memcpy(y_est, y_est_prev, sizeof(est[0]));
+		}
+
+		/*
+		 * Inertial filter corrections, one call per source for all axes. The
+		 * weights of the axes and states a source does not correct are 0. The
+		 * axes are independent, each one still sees its sources in the same order.
+		 */
+		float w_src[3][2];
+
+		/* altitude from baro */
 		inertial_filter_correct(corr_baro, dt, z_est, 0, params.w_z_baro);
 
+		if (can_estimate_xy) {
+			if (use_flow) {
+				eph = fminf(eph, eph_flow);
+
+				float e_flow[2][2] = {{ 0.0f, corr_flow[0] }, { 0.0f, corr_flow[1] }};
+				float w = params.w_xy_flow * w_flow;
+				w_src[0][0] = 0.0f;
+				w_src[0][1] = w;
+				w_src[1][0] = 0.0f;
+				w_src[1][1] = w;
+				inertial_filter_correct_axes(e_flow, dt, est, w_src, 2);
+			}
+
+		} else {
+			/* gradually reset xy velocity estimates */
+			float e_res[2][2] = {{ 0.0f, -x_est[1] }, { 0.0f, -y_est[1] }};
+			w_src[0][0] = 0.0f;
+			w_src[0][1] = params.w_xy_res_v;
+			w_src[1][0] = 0.0f;
+			w_src[1][1] = params.w_xy_res_v;
+			inertial_filter_correct_axes(e_res, dt, est, w_src, 2);
+		}
+
 		if (use_gps_z) {
 			epv = fminf(epv, gps.epv);
+		}
+
+		bool gps_xy = can_estimate_xy && use_gps_xy;
+
+		if (gps_xy) {
+			eph = fminf(eph, gps.eph);
+		}
 
-			inertial_filter_correct(corr_gps[2][0], dt, z_est, 0, w_z_gps_p);
+		if (gps_xy || use_gps_z) {
+			bool gps_v = gps.vel_ned_valid && t < gps.timestamp_velocity + gps_topic_timeout;
+			w_src[0][0] = gps_xy ? w_xy_gps_p : 0.0f;
+			w_src[0][1] = gps_xy && gps_v ? w_xy_gps_v : 0.0f;
+			w_src[1][0] = w_src[0][0];
+			w_src[1][1] = w_src[0][1];
+			w_src[2][0] = use_gps_z ? w_z_gps_p : 0.0f;
+			w_src[2][1] = 0.0f;
+			inertial_filter_correct_axes(corr_gps, dt, est, w_src, 3);
 		}
 
 		if (use_vision_z) {
 			epv = fminf(epv, epv_vision);
-			inertial_filter_correct(corr_vision[2][0], dt, z_est, 0, w_z_vision_p);
+		}
+
+		bool vision_xy = can_estimate_xy && use_vision_xy;
+
+		if (vision_xy) {
+			eph = fminf(eph, eph_vision);
+		}
+
+		if (vision_xy || use_vision_z) {
+			w_src[0][0] = vision_xy ? w_xy_vision_p : 0.0f;
+			w_src[0][1] = vision_xy && w_xy_vision_v > MIN_VALID_W ? w_xy_vision_v : 0.0f;
+			w_src[1][0] = w_src[0][0];
+			w_src[1][1] = w_src[0][1];
+			w_src[2][0] = use_vision_z ? w_z_vision_p : 0.0f;
+			w_src[2][1] = 0.0f;
+			inertial_filter_correct_axes(corr_vision, dt, est, w_src, 3);
 		}
 
 		if (!(isfinite(z_est[0]) && isfinite(z_est[1]))) {
 			write_debug_log("BAD ESTIMATE AFTER Z CORRECTION", dt, x_est, y_est, z_est, x_est_prev, y_est_prev, z_est_prev, acc, corr_gps, w_xy_gps_p, w_xy_gps_v);
-			memcpy(z_est, z_est_prev, sizeof(z_est));
+			memcpy(z_est, z_est_prev, sizeof(est[0]));
 			memset(corr_gps, 0, sizeof(corr_gps));
 			memset(corr_vision, 0, sizeof(corr_vision));
 			corr_baro = 0;
 
 		} else {
-			memcpy(z_est_prev, z_est, sizeof(z_est));
+			memcpy(z_est_prev, z_est, sizeof(est[0]));
 		}
 
 		if (can_estimate_xy) {
-			/* inertial filter prediction for position */
-			inertial_filter_predict(dt, x_est, acc[0]);
-			inertial_filter_predict(dt, y_est, acc[1]);
-
-			if (!(isfinite(x_est[0]) && isfinite(x_est[1]) && isfinite(y_est[0]) && isfinite(y_est[1]))) {
-				write_debug_log("BAD ESTIMATE AFTER PREDICTION", dt, x_est, y_est, z_est, x_est_prev, y_est_prev, z_est_prev, acc, corr_gps, w_xy_gps_p, w_xy_gps_v);
-				memcpy(x_est, x_est_prev, sizeof(x_est));
-				memcpy(y_est, y_est_prev, sizeof(y_est));
-			}
-
-			/* inertial filter correction for position */
-			if (use_flow) {
-				eph = fminf(eph, eph_flow);
-
-				inertial_filter_correct(corr_flow[0], dt, x_est, 1, params.w_xy_flow * w_flow);
-				inertial_filter_correct(corr_flow[1], dt, y_est, 1, params.w_xy_flow * w_flow);
-			}
-
-			if (use_gps_xy) {
-				eph = fminf(eph, gps.eph);
-
-				inertial_filter_correct(corr_gps[0][0], dt, x_est, 0, w_xy_gps_p);
-				inertial_filter_correct(corr_gps[1][0], dt, y_est, 0, w_xy_gps_p);
-
-				if (gps.vel_ned_valid && t < gps.timestamp_velocity + gps_topic_timeout) {
-					inertial_filter_correct(corr_gps[0][1], dt, x_est, 1, w_xy_gps_v);
-					inertial_filter_correct(corr_gps[1][1], dt, y_est, 1, w_xy_gps_v);
-				}
-			}
-
-			if (use_vision_xy) {
-				eph = fminf(eph, eph_vision);
-
-				inertial_filter_correct(corr_vision[0][0], dt, x_est, 0, w_xy_vision_p);
-				inertial_filter_correct(corr_vision[1][0], dt, y_est, 0, w_xy_vision_p);
-
-				if (w_xy_vision_v > MIN_VALID_W) {
-					inertial_filter_correct(corr_vision[0][1], dt, x_est, 1, w_xy_vision_v);
-					inertial_filter_correct(corr_vision[1][1], dt, y_est, 1, w_xy_vision_v);
-				}
-			}
-
 			if (!(isfinite(x_est[0]) && isfinite(x_est[1]) && isfinite(y_est[0]) && isfinite(y_est[1]))) {
 				write_debug_log("BAD ESTIMATE AFTER CORRECTION", dt, x_est, y_est, z_est, x_est_prev, y_est_prev, z_est_prev, acc, corr_gps, w_xy_gps_p, w_xy_gps_v);
-				memcpy(x_est, x_est_prev, sizeof(x_est));
-				memcpy(y_est, y_est_prev, sizeof(y_est));
+				memcpy(x_est, x_est_prev, sizeof(est[0]));
+				memcpy(y_est, y_est_prev, sizeof(est[0]));
 				memset(corr_gps, 0, sizeof(corr_gps));
 				memset(corr_vision, 0, sizeof(corr_vision));
 				memset(corr_flow, 0, sizeof(corr_flow));
 
 			} else {
-				memcpy(x_est_prev, x_est, sizeof(x_est));
-				memcpy(y_est_prev, y_est, sizeof(y_est));
+				memcpy(x_est_prev, x_est, sizeof(est[0]));
+				memcpy(y_est_prev, y_est, sizeof(est[0]));
 			}
-		} else {
-			/* gradually reset xy velocity estimates */
-			inertial_filter_correct(-x_est[1], dt, x_est, 1, params.w_xy_res_v);
-			inertial_filter_correct(-y_est[1], dt, y_est, 1, params.w_xy_res_v);
 		}
 
 		/* detect land */
@@ -1093,25 +1123,12 @@ int position_estimator_inav_thread_main(int argc, char *argv[])
 			}
 		}
 
+		/* remember the estimate for delayed GPS fixes, decimated by the buffer */
+		est_buffer_push(&est_buf, t, est, att.R);
+
 		if (t > pub_last + PUB_INTERVAL) {
 			pub_last = t;
 
-			/* push current estimate to buffer */
-			est_buf[buf_ptr][0][0] = x_est[0];
-			est_buf[buf_ptr][0][1] = x_est[1];
-			est_buf[buf_ptr][1][0] = y_est[0];
-			est_buf[buf_ptr][1][1] = y_est[1];
-			est_buf[buf_ptr][2][0] = z_est[0];
-			est_buf[buf_ptr][2][1] = z_est[1];
-
-			/* push current rotation matrix to buffer */
-			memcpy(R_buf[buf_ptr], att.R, sizeof(att.R));
-
-			buf_ptr++;
-			if (buf_ptr >= EST_BUF_SIZE) {
-				buf_ptr = 0;
-			}
-
 			/* publish local position */
 			local_pos.xy_valid = can_estimate_xy;
 			local_pos.v_xy_valid = can_estimate_xy;
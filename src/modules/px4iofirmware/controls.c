@@ -239,6 +239,10 @@ controls_tick() {
 		/* update RC-received timestamp */
 		system_state.rc_channels_timestamp_received = hrt_absolute_time();
 
+		/* tell the FMU there is a new frame to fetch */
+		r_status_rc_frames++;
+		r_page_raw_rc_input[PX4IO_P_RAW_FRAME_COUNT] = r_status_rc_frames;
+
 		/* update RC-received timestamp */
 		system_state.rc_channels_timestamp_valid = system_state.rc_channels_timestamp_received;
 
@@ -50,8 +50,13 @@
 
 #include "px4io.h"
 
+#ifdef PX4IO_DSM_RX_DMA_COUNT
+# include <up_arch.h>
+#endif
+
 #define DSM_FRAME_SIZE		16		/**<DSM frame size in bytes*/
 #define DSM_FRAME_CHANNELS	7		/**<Max supported DSM channels*/
+#define DSM_BYTE_TIME		86		/**<10 bit times at 115200 bps, rounded down*/
 
 static int dsm_fd = -1;						/**< File handle to the DSM UART */
 static hrt_abstime dsm_last_rx_time;		/**< Timestamp when we last received */
@@ -60,6 +65,7 @@ static uint8_t dsm_frame[DSM_FRAME_SIZE];	/**< DSM dsm frame receive buffer */
 static unsigned dsm_partial_frame_count;	/**< Count of bytes received for current dsm frame */
 static unsigned dsm_channel_shift;			/**< Channel resolution, 0=unknown, 1=10 bit, 2=11 bit */
 static unsigned dsm_frame_drops;			/**< Count of incomplete DSM frames */
+static struct rc_rx_state dsm_rx_state;		/**< Idle detection from the RX DMA counter */
 
 /**
  * Attempt to decode a single channel raw channel datum
@@ -226,6 +232,7 @@ dsm_init(const char *device)
 		/* initialise the decoder */
 		dsm_partial_frame_count = 0;
 		dsm_last_rx_time = hrt_absolute_time();
+		dsm_rx_state.drained = false;
 
 		/* reset the format detector */
 		dsm_guess_format(true);
@@ -462,10 +469,16 @@ dsm_input(uint16_t *values, uint16_t *num_values, uint8_t *n_bytes, uint8_t **by
 	ssize_t		ret;
 	hrt_abstime	now;
 
-	/*
-	 */
 	now = hrt_absolute_time();
 
+#ifdef PX4IO_DSM_RX_DMA_COUNT
+
+	/* skip the read while the receive DMA shows nothing new */
+	if (rc_rx_idle(&dsm_rx_state, getreg32(PX4IO_DSM_RX_DMA_COUNT), now, DSM_BYTE_TIME))
+		return false;
+
+#endif
+
 	if ((now - dsm_last_rx_time) > 5000) {
 		if (dsm_partial_frame_count > 0) {
 			dsm_frame_drops++;
@@ -479,6 +492,9 @@ dsm_input(uint16_t *values, uint16_t *num_values, uint8_t *n_bytes, uint8_t **by
 	 */
 	ret = read(dsm_fd, &dsm_frame[dsm_partial_frame_count], DSM_FRAME_SIZE - dsm_partial_frame_count);
 
+	/* a short read left nothing behind in the driver */
+	dsm_rx_state.drained = (ret < (ssize_t)(DSM_FRAME_SIZE - dsm_partial_frame_count));
+
 	/* if the read failed for any reason, just give up here */
 	if (ret < 1) {
 		return false;
@@ -371,8 +371,9 @@ mixer_handle_text(const void *buffer, size_t length)
 		return 0;
 
 	unsigned	text_length = length - sizeof(px4io_mixdata);
+	bool		binary = (msg->action & F2I_MIXER_ACTION_BINARY);
 
-	switch (msg->action) {
+	switch (msg->action & ~F2I_MIXER_ACTION_BINARY) {
 	case F2I_MIXER_ACTION_RESET:
 		isr_debug(2, "reset");
 
@@ -403,7 +404,13 @@ mixer_handle_text(const void *buffer, size_t length)
 
 		/* process the text buffer, adding new mixers as their descriptions can be parsed */
 		unsigned resid = mixer_text_length;
-		mixer_group.load_from_buf(&mixer_text[0], resid);
+
+		if (binary) {
+			mixer_group.load_from_bin(&mixer_text[0], resid);
+
+		} else {
+			mixer_group.load_from_buf(&mixer_text[0], resid);
+		}
 
 		/* if anything was parsed */
 		if (resid != mixer_text_length) {
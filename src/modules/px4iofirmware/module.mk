@@ -15,7 +15,8 @@ SRCS		= adc.c \
 		  ../systemlib/mixer/mixer_multirotor.cpp \
 		  ../systemlib/mixer/mixer_simple.cpp \
 		  ../systemlib/pwm_limit/pwm_limit.c \
-		  ../../lib/rc/st24.c
+		  ../../lib/rc/st24.c \
+		  ../../lib/rc/rc_decode.c
 
 ifeq ($(BOARD),px4io-v1)
 SRCS		+= i2c.c
@@ -74,7 +74,7 @@
 #define REG_TO_FLOAT(_reg)	((float)REG_TO_SIGNED(_reg) / 10000.0f)
 #define FLOAT_TO_REG(_float)	SIGNED_TO_REG((int16_t)((_float) * 10000.0f))
 
-#define PX4IO_PROTOCOL_VERSION		4
+#define PX4IO_PROTOCOL_VERSION		7
 
 /* maximum allowable sizes on this protocol version */
 #define PX4IO_PROTOCOL_MAX_CONTROL_COUNT	8	/**< The protocol does not support more than set here, individual units might support less - see PX4IO_P_CONFIG_CONTROL_COUNT */
@@ -129,6 +129,8 @@
 #define PX4IO_P_STATUS_VSERVO			6	/* [2] servo rail voltage in mV */
 #define PX4IO_P_STATUS_VRSSI			7	/* [2] RSSI voltage */
 #define PX4IO_P_STATUS_PRSSI			8	/* [2] RSSI PWM value */
+#define PX4IO_P_STATUS_RC_FRAMES		9	/* R/C frames decoded (wrapping counter), fetch the R/C pages when it changes */
+#define PX4IO_P_STATUS_RC_AGE			10	/* time since the last R/C frame was decoded in us, 0xffff if longer */
 
 /* array of post-mix actuator outputs, -10000..10000 */
 #define PX4IO_PAGE_ACTUATORS		2		/* 0..CONFIG_ACTUATOR_COUNT-1 */
@@ -263,6 +265,23 @@ enum {							/* DSM bind states */
 #define PX4IO_PAGE_SENSORS			56		/**< Sensors connected to PX4IO */
 #define PX4IO_P_SENSORS_ALTITUDE		0		/**< Altitude of an external sensor (HoTT or S.BUS2) */
 
+/*
+ * Combined transaction of one output cycle, serial interface only.
+ *
+ * A write sets the control groups from group 0 on, as a write to
+ * PX4IO_PAGE_CONTROLS at offset 0 would. The reply to it carries the
+ * registers below instead of an empty acknowledgement, so one exchange
+ * sends the controls and returns status, R/C input and servo outputs.
+ */
+#define PX4IO_PAGE_CYCLE			57
+#define PX4IO_P_CYCLE_STATUS			0		/**< PX4IO_P_STATUS_FLAGS..PX4IO_P_STATUS_RC_AGE */
+#define PX4IO_CYCLE_STATUS_COUNT		9
+#define PX4IO_P_CYCLE_RAW_RC			(PX4IO_P_CYCLE_STATUS + PX4IO_CYCLE_STATUS_COUNT)	/**< PX4IO_P_RAW_RC_COUNT and on */
+#define PX4IO_CYCLE_RC_CHANNELS			18		/**< all channels PX4IO decodes */
+#define PX4IO_P_CYCLE_SERVOS			(PX4IO_P_CYCLE_RAW_RC + PX4IO_P_RAW_RC_BASE + PX4IO_CYCLE_RC_CHANNELS)
+#define PX4IO_CYCLE_SERVO_COUNT			8
+#define PX4IO_CYCLE_COUNT			(PX4IO_P_CYCLE_SERVOS + PX4IO_CYCLE_SERVO_COUNT)	/**< registers in the reply */
+
 /* Debug and test page - not used in normal operation */
 #define PX4IO_PAGE_TEST				127
 #define PX4IO_P_TEST_LED			0		/**< set the amber LED on/off */
@@ -290,16 +309,19 @@ struct px4io_mixdata {
 	uint8_t		action;
 #define F2I_MIXER_ACTION_RESET			0
 #define F2I_MIXER_ACTION_APPEND			1
+#define F2I_MIXER_ACTION_BINARY			(1 << 7)	/**< or'ed in, text holds binary mixer records */
 
 	char		text[0];	/* actual text size may vary */
 };
 #pragma pack(pop)
 
+#define F2I_MIXER_MAX_FRAME	62	/**< IO buffers the rest of one mixer plus one frame of at most this size */
+
 /**
  * Serial protocol encapsulation.
  */
 
-#define PKT_MAX_REGS	32 // by agreement w/FMU
+#define PKT_MAX_REGS	63 // as many as PKT_COUNT_MASK can express, IO advertises what it takes in PX4IO_P_CONFIG_MAX_TRANSFER
 
 #pragma pack(push, 1)
 struct IOPacket {
@@ -0,0 +1,98 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+/**
+ * @file protocol_crc.h
+ *
+ * IOPacket check byte computed by the STM32 CRC unit.
+ *
+ * The unit computes CRC-32 (polynomial 0x04C11DB7) a 32-bit word at a
+ * time. The packet is fed as little endian words with the crc byte zeroed
+ * and the last word zero padded, and the result is folded into the 8 bit
+ * crc field. The F1 on PX4IO and the F4 on the FMU have the same unit at
+ * the same address, so both ends agree on the value.
+ *
+ * The unit holds state while a packet is fed. On IO it is only used from
+ * the serial interrupt, on the FMU only with the bus semaphore held.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <up_arch.h>
+#include <chip.h>
+
+#include "protocol.h"
+
+#define PX4IO_CRC_DR		(STM32_CRC_BASE + 0x00)
+#define PX4IO_CRC_CR		(STM32_CRC_BASE + 0x08)
+#define PX4IO_CRC_CR_RESET	(1 << 0)
+
+static void crc_packet_hw_init(void) __attribute__((unused));
+static void
+crc_packet_hw_init(void)
+{
+#ifdef CONFIG_STM32_STM32F10XX
+	modifyreg32(STM32_RCC_AHBENR, 0, RCC_AHBENR_CRCEN);
+#else
+	modifyreg32(STM32_RCC_AHB1ENR, 0, RCC_AHB1ENR_CRCEN);
+#endif
+}
+
+static uint8_t crc_packet_hw(struct IOPacket *pkt) __attribute__((unused));
+static uint8_t
+crc_packet_hw(struct IOPacket *pkt)
+{
+	const uint8_t *p = (const uint8_t *)pkt;
+	const unsigned length = PKT_SIZE(*pkt);
+	unsigned i;
+
+	putreg32(PX4IO_CRC_CR_RESET, PX4IO_CRC_CR);
+
+	for (i = 0; i + 4 <= length; i += 4) {
+		uint32_t word;
+
+		memcpy(&word, &p[i], sizeof(word));
+		putreg32(word, PX4IO_CRC_DR);
+	}
+
+	/* a packet is a header and whole registers, at most one register is left */
+	if (i < length)
+		putreg32(p[i] | (p[i + 1] << 8), PX4IO_CRC_DR);
+
+	uint32_t c = getreg32(PX4IO_CRC_DR);
+
+	return c ^ (c >> 8) ^ (c >> 16) ^ (c >> 24);
+}
@@ -44,6 +44,8 @@
 
 #include <board_config.h>
 
+#include <drivers/drv_hrt.h>
+
 #include "protocol.h"
 
 #include <systemlib/pwm_limit/pwm_limit.h>
@@ -93,6 +95,7 @@ extern uint16_t			r_page_servo_disarmed[];	/* PX4IO_PAGE_DISARMED_PWM */
  */
 #define r_status_flags		r_page_status[PX4IO_P_STATUS_FLAGS]
 #define r_status_alarms		r_page_status[PX4IO_P_STATUS_ALARMS]
+#define r_status_rc_frames	r_page_status[PX4IO_P_STATUS_RC_FRAMES]
 
 #define r_raw_rc_count		r_page_raw_rc_input[PX4IO_P_RAW_RC_COUNT]
 #define r_raw_rc_values		(&r_page_raw_rc_input[PX4IO_P_RAW_RC_BASE])
@@ -223,6 +226,45 @@ extern bool	sbus_input(uint16_t *values, uint16_t *num_values, bool *sbus_failsa
 extern void	sbus1_output(uint16_t *values, uint16_t num_values);
 extern void	sbus2_output(uint16_t *values, uint16_t num_values);
 
+/** size of the circular buffer the serial driver receives with DMA */
+#define RC_RX_DMA_BUFFER	32
+
+/**
+ * What rc_rx_idle() compares against.
+ */
+struct rc_rx_state {
+	uint32_t	dma_count;	/**< DMA transfer counter when last sampled */
+	hrt_abstime	sample_time;	/**< time dma_count was sampled */
+	bool		drained;	/**< the read after sampling emptied the port */
+};
+
+/**
+ * Check whether an RC input port can be skipped because nothing arrived
+ * since the last read emptied it.
+ *
+ * The transfer counter wraps every RC_RX_DMA_BUFFER bytes, so an unchanged
+ * value only means no new bytes for less time than it takes to receive
+ * that many. Past that the port is read regardless. Set rx->drained after
+ * every read that follows a false return.
+ *
+ * @param rx		Idle state of the port.
+ * @param dma_count	Current transfer counter of its RX DMA channel.
+ * @param now		Current time.
+ * @param byte_time	Transmission time of one byte at the port's rate, us.
+ * @return		True if the port has nothing to read.
+ */
+static inline bool
+rc_rx_idle(struct rc_rx_state *rx, uint32_t dma_count, hrt_abstime now, unsigned byte_time)
+{
+	if (rx->drained && (dma_count == rx->dma_count) &&
+	    (now - rx->sample_time) < RC_RX_DMA_BUFFER * byte_time)
+		return true;
+
+	rx->dma_count = dma_count;
+	rx->sample_time = now;
+	return false;
+}
+
 /** global debug level for isr_debug() */
 extern volatile uint8_t debug_level;
 
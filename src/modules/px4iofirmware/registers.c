@@ -67,7 +67,11 @@ static const uint16_t	r_page_config[] = {
 	[PX4IO_P_CONFIG_HARDWARE_VERSION]	= 1,
 #endif
 	[PX4IO_P_CONFIG_BOOTLOADER_VERSION]	= 3,	/* XXX hardcoded magic number */
+#ifdef CONFIG_ARCH_BOARD_PX4IO_V2
+	[PX4IO_P_CONFIG_MAX_TRANSFER]		= 2 + 2 * PKT_MAX_REGS,	/* a full serial packet, counted as an I2C transfer */
+#else
 	[PX4IO_P_CONFIG_MAX_TRANSFER]		= 64,	/* XXX hardcoded magic number */
+#endif
 	[PX4IO_P_CONFIG_CONTROL_COUNT]		= PX4IO_CONTROL_CHANNELS,
 	[PX4IO_P_CONFIG_ACTUATOR_COUNT]		= PX4IO_SERVO_COUNT,
 	[PX4IO_P_CONFIG_RC_INPUT_COUNT]		= PX4IO_RC_INPUT_CHANNELS,
@@ -90,6 +94,8 @@ uint16_t		r_page_status[] = {
 	[PX4IO_P_STATUS_VSERVO]			= 0,
 	[PX4IO_P_STATUS_VRSSI]			= 0,
 	[PX4IO_P_STATUS_PRSSI]			= 0,
+	[PX4IO_P_STATUS_RC_FRAMES]		= 0,
+	[PX4IO_P_STATUS_RC_AGE]			= 0xffff,
 };
 
 /**
@@ -138,7 +144,7 @@ uint16_t		r_page_rc_input[] = {
  * PAGE 6 Raw ADC input.
  * PAGE 7 PWM rate maps.
  */
-uint16_t		r_page_scratch[32];
+uint16_t		r_page_scratch[PKT_MAX_REGS];
 
 /**
  * PAGE 100
@@ -259,6 +265,12 @@ registers_set(uint8_t page, uint8_t offset, const uint16_t *values, unsigned num
 
 	switch (page) {
 
+		/* controls of a combined cycle, always from group 0 */
+	case PX4IO_PAGE_CYCLE:
+		offset = 0;
+
+		/* FALLTHROUGH */
+
 		/* handle bulk controls input */
 	case PX4IO_PAGE_CONTROLS:
 
@@ -412,6 +424,17 @@ registers_set(uint8_t page, uint8_t offset, const uint16_t *values, unsigned num
 		}
 		break;
 
+	case PX4IO_PAGE_RC_CONFIG:
+
+		/*
+		 * The channels of one write are checked together, any of them
+		 * failing clears the flag again. Writes are ignored while armed.
+		 */
+		if (!(r_status_flags & (PX4IO_P_STATUS_FLAGS_SAFETY_OFF | PX4IO_P_STATUS_FLAGS_OUTPUTS_ARMED)))
+			r_status_flags |= PX4IO_P_STATUS_FLAGS_INIT_OK;
+
+		/* FALLTHROUGH */
+
 	default:
 		/* avoid offset wrap */
 		if ((offset + num_values) > 255)
@@ -658,7 +681,6 @@ registers_set_one(uint8_t page, uint8_t offset, uint16_t value)
 
 		case PX4IO_P_RC_CONFIG_OPTIONS:
 			value &= PX4IO_P_RC_CONFIG_OPTIONS_VALID;
-			r_status_flags |= PX4IO_P_STATUS_FLAGS_INIT_OK;
 
 			/* clear any existing RC disabled flag */
 			r_setup_arming &= ~(PX4IO_P_SETUP_ARMING_RC_HANDLING_DISABLED);
@@ -727,6 +749,83 @@ registers_set_one(uint8_t page, uint8_t offset, uint16_t value)
 	return 0;
 }
 
+/*
+ * Refresh the measured values of the status page.
+ */
+static void
+registers_measure_status(void)
+{
+#ifdef ADC_VBATT
+	/* PX4IO_P_STATUS_VBATT */
+	{
+		/*
+		 * Coefficients here derived by measurement of the 5-16V
+		 * range on one unit, validated on sample points of another unit
+		 *
+		 * Data in Tools/tests-host/data folder.
+		 *
+		 * measured slope = 0.004585267878277 (int: 4585)
+		 * nominal theoretic slope: 0.00459340659 (int: 4593)
+		 * intercept = 0.016646394188076 (int: 16646)
+		 * nominal theoretic intercept: 0.00 (int: 0)
+		 *
+		 */
+		unsigned counts = adc_measure(ADC_VBATT);
+		if (counts != 0xffff) {
+			unsigned mV = (166460 + (counts * 45934)) / 10000;
+			unsigned corrected = (mV * r_page_setup[PX4IO_P_SETUP_VBATT_SCALE]) / 10000;
+
+			r_page_status[PX4IO_P_STATUS_VBATT] = corrected;
+		}
+	}
+#endif
+#ifdef ADC_IBATT
+	/* PX4IO_P_STATUS_IBATT */
+	{
+		/*
+		  note that we have no idea what sort of
+		  current sensor is attached, so we just
+		  return the raw 12 bit ADC value and let the
+		  FMU sort it out, with user selectable
+		  configuration for their sensor
+		 */
+		unsigned counts = adc_measure(ADC_IBATT);
+		if (counts != 0xffff) {
+			r_page_status[PX4IO_P_STATUS_IBATT] = counts;
+		}
+	}
+#endif
+#ifdef ADC_VSERVO
+	/* PX4IO_P_STATUS_VSERVO */
+	{
+		unsigned counts = adc_measure(ADC_VSERVO);
+		if (counts != 0xffff) {
+			// use 3:1 scaling on 3.3V ADC input
+			unsigned mV = counts * 9900 / 4096;
+			r_page_status[PX4IO_P_STATUS_VSERVO] = mV;
+		}
+	}
+#endif
+#ifdef ADC_RSSI
+	/* PX4IO_P_STATUS_VRSSI */
+	{
+		unsigned counts = adc_measure(ADC_RSSI);
+		if (counts != 0xffff) {
+			// use 1:1 scaling on 3.3V ADC input
+			unsigned mV = counts * 3300 / 4096;
+			r_page_status[PX4IO_P_STATUS_VRSSI] = mV;
+		}
+	}
+#endif
+	/* XXX PX4IO_P_STATUS_PRSSI */
+
+	/* PX4IO_P_STATUS_RC_AGE */
+	{
+		hrt_abstime age = hrt_elapsed_time(&system_state.rc_channels_timestamp_received);
+		r_page_status[PX4IO_P_STATUS_RC_AGE] = (age < 0xffff) ? age : 0xffff;
+	}
+}
+
 uint8_t last_page;
 uint8_t last_offset;
 
@@ -757,73 +856,26 @@ registers_get(uint8_t page, uint8_t offset, uint16_t **values, unsigned *num_val
 
 		/* PX4IO_P_STATUS_ALARMS maintained externally */
 
-#ifdef ADC_VBATT
-		/* PX4IO_P_STATUS_VBATT */
-		{
-			/*
-			 * Coefficients here derived by measurement of the 5-16V
-			 * range on one unit, validated on sample points of another unit
-			 *
-			 * Data in Tools/tests-host/data folder.
-			 *
-			 * measured slope = 0.004585267878277 (int: 4585)
-			 * nominal theoretic slope: 0.00459340659 (int: 4593)
-			 * intercept = 0.016646394188076 (int: 16646)
-			 * nominal theoretic intercept: 0.00 (int: 0)
-			 *
-			 */
-			unsigned counts = adc_measure(ADC_VBATT);
-			if (counts != 0xffff) {
-				unsigned mV = (166460 + (counts * 45934)) / 10000;
-				unsigned corrected = (mV * r_page_setup[PX4IO_P_SETUP_VBATT_SCALE]) / 10000;
-
-				r_page_status[PX4IO_P_STATUS_VBATT] = corrected;
-			}
-		}
-#endif
-#ifdef ADC_IBATT
-		/* PX4IO_P_STATUS_IBATT */
-		{
-			/*
-			  note that we have no idea what sort of
-			  current sensor is attached, so we just
-			  return the raw 12 bit ADC value and let the
-			  FMU sort it out, with user selectable
-			  configuration for their sensor
-			 */
-			unsigned counts = adc_measure(ADC_IBATT);
-			if (counts != 0xffff) {
-				r_page_status[PX4IO_P_STATUS_IBATT] = counts;
-			}
-		}
-#endif
-#ifdef ADC_VSERVO
-		/* PX4IO_P_STATUS_VSERVO */
-		{
-			unsigned counts = adc_measure(ADC_VSERVO);
-			if (counts != 0xffff) {
-				// use 3:1 scaling on 3.3V ADC input
-				unsigned mV = counts * 9900 / 4096;
-				r_page_status[PX4IO_P_STATUS_VSERVO] = mV;
-			}
-		}
-#endif
-#ifdef ADC_RSSI
-		/* PX4IO_P_STATUS_VRSSI */
-		{
-			unsigned counts = adc_measure(ADC_RSSI);
-			if (counts != 0xffff) {
-				// use 1:1 scaling on 3.3V ADC input
-				unsigned mV = counts * 3300 / 4096;
-				r_page_status[PX4IO_P_STATUS_VRSSI] = mV;
-			}
-		}
-#endif
-		/* XXX PX4IO_P_STATUS_PRSSI */
+		registers_measure_status();
 
 		SELECT_PAGE(r_page_status);
 		break;
 
+	case PX4IO_PAGE_CYCLE:
+		/* the reply to a cycle write, a snapshot of the pages the FMU polls */
+		registers_measure_status();
+
+		memcpy(&r_page_scratch[PX4IO_P_CYCLE_STATUS], &r_page_status[PX4IO_P_STATUS_FLAGS],
+		       PX4IO_CYCLE_STATUS_COUNT * sizeof(r_page_scratch[0]));
+		memcpy(&r_page_scratch[PX4IO_P_CYCLE_RAW_RC], &r_page_raw_rc_input[PX4IO_P_RAW_RC_COUNT],
+		       (PX4IO_P_RAW_RC_BASE + PX4IO_CYCLE_RC_CHANNELS) * sizeof(r_page_scratch[0]));
+		memcpy(&r_page_scratch[PX4IO_P_CYCLE_SERVOS], &r_page_servos[0],
+		       PX4IO_CYCLE_SERVO_COUNT * sizeof(r_page_scratch[0]));
+
+		*values = &r_page_scratch[0];
+		*num_values = PX4IO_CYCLE_COUNT;
+		break;
+
 	case PX4IO_PAGE_RAW_ADC_INPUT:
 		memset(r_page_scratch, 0, sizeof(r_page_scratch));
 #ifdef ADC_VBATT
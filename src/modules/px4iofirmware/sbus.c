@@ -47,9 +47,15 @@
 
 #include <drivers/drv_hrt.h>
 
+#include <rc/rc_decode.h>
+
 #define DEBUG
 #include "px4io.h"
 #include "protocol.h"
+
+#ifdef PX4IO_SBUS_RX_DMA_COUNT
+# include <up_arch.h>
+#endif
 #include "debug.h"
 
 #define SBUS_FRAME_SIZE		25
@@ -59,6 +65,9 @@
 #define SBUS_FRAMELOST_BIT	2
 #define SBUS1_FRAME_DELAY	14000
 
+/* 12 bit times at 100000 bps */
+#define SBUS_BYTE_TIME		120
+
 /*
   Measured values with Futaba FX-30/R6108SB:
     -+100% on TX:  PCM 1.100/1.520/1.950ms -> SBus raw values: 350/1024/1700  (100% ATV)
@@ -77,6 +86,10 @@
 #define SBUS_SCALE_FACTOR ((SBUS_TARGET_MAX - SBUS_TARGET_MIN) / (SBUS_RANGE_MAX - SBUS_RANGE_MIN))
 #define SBUS_SCALE_OFFSET (int)(SBUS_TARGET_MIN - (SBUS_SCALE_FACTOR * SBUS_RANGE_MIN + 0.5f))
 
+/* SBUS_SCALE_FACTOR as a fixed point fraction, for decoding without floating point */
+#define SBUS_SCALE_MUL		5
+#define SBUS_SCALE_SHIFT	3
+
 static int sbus_fd = -1;
 
 static hrt_abstime last_rx_time;
@@ -87,6 +100,8 @@ static uint8_t	frame[SBUS_FRAME_SIZE];
 
 static unsigned partial_frame_count;
 
+static struct rc_rx_state rx_state;
+
 unsigned sbus_frame_drops;
 
 static bool sbus_decode(hrt_abstime frame_time, uint16_t *values, uint16_t *num_values, bool *sbus_failsafe,
@@ -111,6 +126,7 @@ sbus_init(const char *device)
 		/* initialise the decoder */
 		partial_frame_count = 0;
 		last_rx_time = hrt_absolute_time();
+		rx_state.drained = false;
 
 		debug("S.Bus: ready");
 
@@ -190,6 +206,15 @@ sbus_input(uint16_t *values, uint16_t *num_values, bool *sbus_failsafe, bool *sb
 	 */
 	now = hrt_absolute_time();
 
+#ifdef PX4IO_SBUS_RX_DMA_COUNT
+
+	/* skip the read while the receive DMA shows nothing new */
+	if (rc_rx_idle(&rx_state, getreg32(PX4IO_SBUS_RX_DMA_COUNT), now, SBUS_BYTE_TIME)) {
+		return false;
+	}
+
+#endif
+
 	if ((now - last_rx_time) > 3000) {
 		if (partial_frame_count > 0) {
 			sbus_frame_drops++;
@@ -203,6 +228,9 @@ sbus_input(uint16_t *values, uint16_t *num_values, bool *sbus_failsafe, bool *sb
 	 */
 	ret = read(sbus_fd, &frame[partial_frame_count], SBUS_FRAME_SIZE - partial_frame_count);
 
+	/* a short read left nothing behind in the driver */
+	rx_state.drained = (ret < (ssize_t)(SBUS_FRAME_SIZE - partial_frame_count));
+
 	/* if the read failed for any reason, just give up here */
 	if (ret < 1) {
 		return false;
@@ -230,42 +258,6 @@ sbus_input(uint16_t *values, uint16_t *num_values, bool *sbus_failsafe, bool *sb
 	return sbus_decode(now, values, num_values, sbus_failsafe, sbus_frame_drop, max_channels);
 }
 
-/*
- * S.bus decoder matrix.
- *
- * Each channel value can come from up to 3 input bytes. Each row in the
- * matrix describes up to three bytes, and each entry gives:
- *
- * - byte offset in the data portion of the frame
- * - right shift applied to the data byte
- * - mask for the data byte
- * - left shift applied to the result into the channel value
- */
-struct sbus_bit_pick {
-	uint8_t byte;
-	uint8_t rshift;
-	uint8_t mask;
-	uint8_t lshift;
-};
-static const struct sbus_bit_pick sbus_decoder[SBUS_INPUT_CHANNELS][3] = {
-	/*  0 */ { { 0, 0, 0xff, 0}, { 1, 0, 0x07, 8}, { 0, 0, 0x00,  0} },
-	/*  1 */ { { 1, 3, 0x1f, 0}, { 2, 0, 0x3f, 5}, { 0, 0, 0x00,  0} },
-	/*  2 */ { { 2, 6, 0x03, 0}, { 3, 0, 0xff, 2}, { 4, 0, 0x01, 10} },
-	/*  3 */ { { 4, 1, 0x7f, 0}, { 5, 0, 0x0f, 7}, { 0, 0, 0x00,  0} },
-	/*  4 */ { { 5, 4, 0x0f, 0}, { 6, 0, 0x7f, 4}, { 0, 0, 0x00,  0} },
-	/*  5 */ { { 6, 7, 0x01, 0}, { 7, 0, 0xff, 1}, { 8, 0, 0x03,  9} },
-	/*  6 */ { { 8, 2, 0x3f, 0}, { 9, 0, 0x1f, 6}, { 0, 0, 0x00,  0} },
-	/*  7 */ { { 9, 5, 0x07, 0}, {10, 0, 0xff, 3}, { 0, 0, 0x00,  0} },
-	/*  8 */ { {11, 0, 0xff, 0}, {12, 0, 0x07, 8}, { 0, 0, 0x00,  0} },
-	/*  9 */ { {12, 3, 0x1f, 0}, {13, 0, 0x3f, 5}, { 0, 0, 0x00,  0} },
-	/* 10 */ { {13, 6, 0x03, 0}, {14, 0, 0xff, 2}, {15, 0, 0x01, 10} },
-	/* 11 */ { {15, 1, 0x7f, 0}, {16, 0, 0x0f, 7}, { 0, 0, 0x00,  0} },
-	/* 12 */ { {16, 4, 0x0f, 0}, {17, 0, 0x7f, 4}, { 0, 0, 0x00,  0} },
-	/* 13 */ { {17, 7, 0x01, 0}, {18, 0, 0xff, 1}, {19, 0, 0x03,  9} },
-	/* 14 */ { {19, 2, 0x3f, 0}, {20, 0, 0x1f, 6}, { 0, 0, 0x00,  0} },
-	/* 15 */ { {20, 5, 0x07, 0}, {21, 0, 0xff, 3}, { 0, 0, 0x00,  0} }
-};
-
 static bool
 sbus_decode(hrt_abstime frame_time, uint16_t *values, uint16_t *num_values, bool *sbus_failsafe, bool *sbus_frame_drop,
 	    uint16_t max_values)
@@ -308,27 +300,11 @@ sbus_decode(hrt_abstime frame_time, uint16_t *values, uint16_t *num_values, bool
 	unsigned chancount = (max_values > SBUS_INPUT_CHANNELS) ?
 			     SBUS_INPUT_CHANNELS : max_values;
 
-	/* use the decoder matrix to extract channel data */
-	for (unsigned channel = 0; channel < chancount; channel++) {
-		unsigned value = 0;
-
-		for (unsigned pick = 0; pick < 3; pick++) {
-			const struct sbus_bit_pick *decode = &sbus_decoder[channel][pick];
-
-			if (decode->mask != 0) {
-				unsigned piece = frame[1 + decode->byte];
-				piece >>= decode->rshift;
-				piece &= decode->mask;
-				piece <<= decode->lshift;
+	/* extract the channel data */
+	rc_unpack_sbus(&frame[1], values, chancount);
 
-				value |= piece;
-			}
-		}
-
-
-		/* convert 0-2048 values to 1000-2000 ppm encoding in a not too sloppy fashion */
-		values[channel] = (uint16_t)(value * SBUS_SCALE_FACTOR + .5f) + SBUS_SCALE_OFFSET;
-	}
+	/* convert 0-2048 values to 1000-2000 ppm encoding in a not too sloppy fashion */
+	rc_scale_channels(values, chancount, SBUS_SCALE_MUL, SBUS_SCALE_SHIFT, SBUS_SCALE_OFFSET);
 
 	/* decode switch channels if data fields are wide enough */
 	if (PX4IO_RC_INPUT_CHANNELS > 17 && chancount > 15) {
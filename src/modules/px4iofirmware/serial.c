@@ -55,6 +55,7 @@
 
 //#define DEBUG
 #include "px4io.h"
+#include "protocol_crc.h"
 
 static perf_counter_t	pc_txns;
 static perf_counter_t	pc_errors;
@@ -76,6 +77,9 @@ static void		dma_reset(void);
 
 static struct IOPacket	dma_packet;
 
+/* the FMU checks packets with the CRC unit, going by the last packet accepted */
+static bool		crc_hw;
+
 /* serial register accessors */
 #define REG(_x)		(*(volatile uint32_t *)(PX4FMU_SERIAL_BASE + _x))
 #define rSR		REG(STM32_USART_SR_OFFSET)
@@ -99,6 +103,9 @@ interface_init(void)
 	pc_regerr = perf_alloc(PC_COUNT, "regerr");
 	pc_crcerr = perf_alloc(PC_COUNT, "crcerr");
 
+	/* clock the CRC unit */
+	crc_packet_hw_init();
+
 	/* allocate DMA */
 	tx_dma = stm32_dmachannel(PX4FMU_SERIAL_TX_DMA);
 	rx_dma = stm32_dmachannel(PX4FMU_SERIAL_RX_DMA);
@@ -150,10 +157,20 @@ interface_init(void)
 static void
 rx_handle_packet(void)
 {
-	/* check packet CRC */
+	/*
+	 * Check packet CRC, in the kind the FMU used last and otherwise in
+	 * the other one it may use.
+	 */
 	uint8_t crc = dma_packet.crc;
 	dma_packet.crc = 0;
-	if (crc != crc_packet(&dma_packet)) {
+	bool valid = (crc == (crc_hw ? crc_packet_hw(&dma_packet) : crc_packet(&dma_packet)));
+
+	if (!valid && (crc == (crc_hw ? crc_packet(&dma_packet) : crc_packet_hw(&dma_packet)))) {
+		crc_hw = !crc_hw;
+		valid = true;
+	}
+
+	if (!valid) {
 		perf_count(pc_crcerr);
 
 		/* send a CRC error reply */
@@ -170,6 +187,17 @@ rx_handle_packet(void)
 		if (registers_set(dma_packet.page, dma_packet.offset, &dma_packet.regs[0], PKT_COUNT(dma_packet))) {
 			perf_count(pc_regerr);
 			dma_packet.count_code = PKT_CODE_ERROR;
+
+		} else if (dma_packet.page == PX4IO_PAGE_CYCLE) {
+
+			/* a cycle write is answered with the cycle registers, saving the FMU the reads */
+			unsigned count;
+			uint16_t *registers;
+
+			registers_get(PX4IO_PAGE_CYCLE, 0, &registers, &count);
+			memcpy((void *)&dma_packet.regs[0], registers, count * 2);
+			dma_packet.count_code = count | PKT_CODE_SUCCESS;
+
 		} else {
 			dma_packet.count_code = PKT_CODE_SUCCESS;
 		}
@@ -225,7 +253,7 @@ rx_dma_callback(DMA_HANDLE handle, uint8_t status, void *arg)
 
 	/* send the reply to the just-processed request */
 	dma_packet.crc = 0;
-	dma_packet.crc = crc_packet(&dma_packet);
+	dma_packet.crc = crc_hw ? crc_packet_hw(&dma_packet) : crc_packet(&dma_packet);
 	stm32_dmasetup(
 		tx_dma,
 		(uint32_t)&rDR,
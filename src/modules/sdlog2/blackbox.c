@@ -0,0 +1,131 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file blackbox.c
+ *
+ * Pre-trigger ring of log messages, see blackbox.h.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "blackbox.h"
+#include "sdlog2_format.h"
+
+int blackbox_init(struct blackbox_s *bb, int size)
+{
+	memset(bb, 0, sizeof(*bb));
+	bb->data = malloc(size);
+
+	if (bb->data == 0) {
+		return ERROR;
+	}
+
+	bb->size = size;
+	return OK;
+}
+
+void blackbox_free(struct blackbox_s *bb)
+{
+	free(bb->data);
+	bb->data = 0;
+	bb->size = 0;
+}
+
+void blackbox_set_type(struct blackbox_s *bb, uint8_t type, unsigned length)
+{
+	bb->msg_len[type] = length;
+}
+
+void blackbox_write(struct blackbox_s *bb, const void *msg, int n)
+{
+	if (n > bb->size) {
+		return;
+	}
+
+	// drop the oldest messages until the new one fits
+	while (bb->size - bb->fill < n) {
+		int len = bb->msg_len[bb->data[(bb->tail + 2) % bb->size]];
+
+		if (len == 0) {
+			// can't happen with registered types, start over
+			blackbox_reset(bb);
+			break;
+		}
+
+		bb->tail = (bb->tail + len) % bb->size;
+		bb->fill -= len;
+	}
+
+	int n1 = bb->size - bb->head;
+
+	if (n1 >= n) {
+		memcpy(&bb->data[bb->head], msg, n);
+
+	} else {
+		memcpy(&bb->data[bb->head], msg, n1);
+		memcpy(bb->data, (const uint8_t *)msg + n1, n - n1);
+	}
+
+	bb->head = (bb->head + n) % bb->size;
+	bb->fill += n;
+}
+
+int blackbox_dump(struct blackbox_s *bb, int fd)
+{
+	int n1 = bb->size - bb->tail;
+
+	if (n1 > bb->fill) {
+		n1 = bb->fill;
+	}
+
+	if (write(fd, &bb->data[bb->tail], n1) != n1) {
+		return -1;
+	}
+
+	if (bb->fill > n1 && write(fd, bb->data, bb->fill - n1) != bb->fill - n1) {
+		return -1;
+	}
+
+	return bb->fill;
+}
+
+void blackbox_reset(struct blackbox_s *bb)
+{
+	bb->head = 0;
+	bb->tail = 0;
+	bb->fill = 0;
+}
@@ -0,0 +1,85 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file blackbox.h
+ *
+ * Pre-trigger ring of log messages.
+ *
+ * Messages are kept in a RAM ring that always holds the most recent data:
+ * when the ring is full, whole messages are dropped from the old end to
+ * make room. The contents are a plain log stream that can be written out
+ * behind a log header.
+ */
+
+#ifndef SDLOG2_BLACKBOX_H_
+#define SDLOG2_BLACKBOX_H_
+
+#include <stdint.h>
+
+struct blackbox_s {
+	uint8_t *data;
+	int size;
+	int head;			// end of the newest message
+	int tail;			// start of the oldest message
+	int fill;
+	uint16_t msg_len[256];		// full packet length by message type
+};
+
+int blackbox_init(struct blackbox_s *bb, int size);
+
+void blackbox_free(struct blackbox_s *bb);
+
+/**
+ * Register the packet length of a message type.
+ */
+void blackbox_set_type(struct blackbox_s *bb, uint8_t type, unsigned length);
+
+/**
+ * Append a message, dropping the oldest messages if needed.
+ *
+ * The message type must have been registered.
+ */
+void blackbox_write(struct blackbox_s *bb, const void *msg, int n);
+
+/**
+ * Write the ring contents, oldest message first, to a file.
+ *
+ * @return bytes written, -1 on error
+ */
+int blackbox_dump(struct blackbox_s *bb, int fd);
+
+void blackbox_reset(struct blackbox_s *bb);
+
+#endif
@@ -36,6 +36,10 @@
  *
  * Ring FIFO buffer for binary log data.
  *
+ * The buffer is safe for one writer and one reader running concurrently
+ * without a lock: the writer only moves write_ptr, the reader only moves
+ * read_ptr, and each publishes its pointer after finishing with the data.
+ *
  * @author Anton Babushkin <anton.babushkin@me.com>
  */
 
@@ -55,7 +59,8 @@ int logbuffer_init(struct logbuffer_s *lb, int size)
 
 int logbuffer_count(struct logbuffer_s *lb)
 {
-	int n = lb->write_ptr - lb->read_ptr;
+	int n = lb->write_ptr;
+	n -= lb->read_ptr;
 
 	if (n < 0) {
 		n += lb->size;
@@ -71,8 +76,9 @@ int logbuffer_is_empty(struct logbuffer_s *lb)
 
 bool logbuffer_write(struct logbuffer_s *lb, void *ptr, int size)
 {
-	// bytes available to write
-	int available = lb->read_ptr - lb->write_ptr - 1;
+	// bytes available to write, the reader may only make this larger meanwhile
+	int write_ptr = lb->write_ptr;
+	int available = lb->read_ptr - write_ptr - 1;
 
 	if (available < 0) {
 		available += lb->size;
@@ -84,12 +90,12 @@ bool logbuffer_write(struct logbuffer_s *lb, void *ptr, int size)
 	}
 
 	char *c = (char *) ptr;
-	int n = lb->size - lb->write_ptr;	// bytes to end of the buffer
+	int n = lb->size - write_ptr;	// bytes to end of the buffer
 
 	if (n < size) {
 		// message goes over end of the buffer
-		memcpy(&(lb->data[lb->write_ptr]), c, n);
-		lb->write_ptr = 0;
+		memcpy(&(lb->data[write_ptr]), c, n);
+		write_ptr = 0;
 
 	} else {
 		n = 0;
@@ -97,15 +103,22 @@ bool logbuffer_write(struct logbuffer_s *lb, void *ptr, int size)
 
 	// now: n = bytes already written
 	int p = size - n;	// number of bytes to write
-	memcpy(&(lb->data[lb->write_ptr]), &(c[n]), p);
-	lb->write_ptr = (lb->write_ptr + p) % lb->size;
+	memcpy(&(lb->data[write_ptr]), &(c[n]), p);
+
+	// data must be in place before the reader can see the new pointer
+	__sync_synchronize();
+	lb->write_ptr = (write_ptr + p) % lb->size;
 	return true;
 }
 
 int logbuffer_get_ptr(struct logbuffer_s *lb, void **ptr, bool *is_part)
 {
-	// bytes available to read
-	int available = lb->write_ptr - lb->read_ptr;
+	// bytes available to read, the writer may only make this larger meanwhile
+	int write_ptr = lb->write_ptr;
+	int available = write_ptr - lb->read_ptr;
+
+	// read the data only after the pointer that published it
+	__sync_synchronize();
 
 	if (available == 0) {
 		return 0;	// buffer is empty
@@ -121,7 +134,7 @@ int logbuffer_get_ptr(struct logbuffer_s *lb, void **ptr, bool *is_part)
 	} else {
 		// read pointer is after write pointer, read bytes from read_ptr to end of the buffer
 		n = lb->size - lb->read_ptr;
-		*is_part = lb->write_ptr > 0;
+		*is_part = write_ptr > 0;
 	}
 
 	*ptr = &(lb->data[lb->read_ptr]);
@@ -130,5 +143,7 @@ int logbuffer_get_ptr(struct logbuffer_s *lb, void **ptr, bool *is_part)
 
 void logbuffer_mark_read(struct logbuffer_s *lb, int n)
 {
+	// finish with the data before handing the space back to the writer
+	__sync_synchronize();
 	lb->read_ptr = (lb->read_ptr + n) % lb->size;
 }
@@ -47,8 +47,8 @@
 
 struct logbuffer_s {
 	// pointers and size are in bytes
-	int write_ptr;
-	int read_ptr;
+	volatile int write_ptr;		// only changed by the writer
+	volatile int read_ptr;		// only changed by the reader
 	int size;
 	char *data;
 };
@@ -0,0 +1,302 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file logcompress.c
+ *
+ * Block compression for the binary log stream, see logcompress.h.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "logcompress.h"
+
+#define HASH_BITS	10
+#define MIN_MATCH	4
+
+int logcompress_init(struct logcompress_s *lc, const struct log_format_s *formats, unsigned count)
+{
+	memset(lc, 0, sizeof(*lc));
+
+	for (unsigned i = 0; i < count; i++) {
+		lc->msg_len[formats[i].type] = formats[i].length;
+		lc->prev_offset[formats[i].type] = lc->prev_size;
+		lc->prev_size += formats[i].length - LOG_PACKET_HEADER_LEN;
+	}
+
+	lc->raw = malloc(LOG_COMPRESS_BLOCK);
+	// worst case: incompressible data is stored as is
+	lc->out = malloc(LOG_COMPRESS_HEADER_LEN + LOG_COMPRESS_BLOCK);
+	lc->prev = malloc(lc->prev_size);
+	lc->hash = malloc(sizeof(uint16_t) << HASH_BITS);
+
+	if (lc->raw == 0 || lc->out == 0 || lc->prev == 0 || lc->hash == 0) {
+		logcompress_free(lc);
+		return ERROR;
+	}
+
+	return OK;
+}
+
+int logcompress_add_type(struct logcompress_s *lc, uint8_t type, unsigned length)
+{
+	uint8_t *prev = realloc(lc->prev, lc->prev_size + length - LOG_PACKET_HEADER_LEN);
+
+	if (prev == 0) {
+		return ERROR;
+	}
+
+	lc->prev = prev;
+	lc->msg_len[type] = length;
+	lc->prev_offset[type] = lc->prev_size;
+	lc->prev_size += length - LOG_PACKET_HEADER_LEN;
+	return OK;
+}
+
+void logcompress_free(struct logcompress_s *lc)
+{
+	free(lc->raw);
+	free(lc->out);
+	free(lc->prev);
+	free(lc->hash);
+	lc->raw = 0;
+	lc->out = 0;
+	lc->prev = 0;
+	lc->hash = 0;
+}
+
+int logcompress_space(struct logcompress_s *lc)
+{
+	return LOG_COMPRESS_BLOCK - lc->raw_fill;
+}
+
+void logcompress_put(struct logcompress_s *lc, const void *data, int n)
+{
+	memcpy(&lc->raw[lc->raw_fill], data, n);
+	lc->raw_fill += n;
+}
+
+/**
+ * Find the end of the whole messages at the start of the block.
+ *
+ * @param partial	set if the scan stopped at an incomplete message
+ */
+static int complete_length(struct logcompress_s *lc, const uint8_t *data, int len, bool *partial)
+{
+	int pos = 0;
+	*partial = false;
+
+	while (pos + LOG_PACKET_HEADER_LEN <= len) {
+		int msg_len = lc->msg_len[data[pos + 2]];
+
+		if (data[pos] != HEAD_BYTE1 || data[pos + 1] != HEAD_BYTE2 || msg_len == 0) {
+			// not a message we know, leave the rest alone
+			return pos;
+		}
+
+		if (pos + msg_len > len) {
+			break;
+		}
+
+		pos += msg_len;
+	}
+
+	*partial = (pos < len);
+	return pos;
+}
+
+/**
+ * XOR each message body with the previous body of the same type.
+ */
+static void delta_encode(struct logcompress_s *lc, uint8_t *data, int len)
+{
+	// every block starts from zero so it can be decoded on its own
+	memset(lc->prev, 0, lc->prev_size);
+
+	int pos = 0;
+
+	while (pos < len) {
+		uint8_t type = data[pos + 2];
+		int body_len = lc->msg_len[type] - LOG_PACKET_HEADER_LEN;
+		uint8_t *body = &data[pos + LOG_PACKET_HEADER_LEN];
+		uint8_t *prev = &lc->prev[lc->prev_offset[type]];
+
+		for (int i = 0; i < body_len; i++) {
+			uint8_t b = body[i];
+			body[i] ^= prev[i];
+			prev[i] = b;
+		}
+
+		pos += lc->msg_len[type];
+	}
+}
+
+/**
+ * Append a literal run and a match to the LZ77 output.
+ *
+ * @return new output length, or -1 if the output would not fit
+ */
+static int lz_emit(uint8_t *out, int op, int out_max, const uint8_t *lit, int lit_len, int offset, int match_len)
+{
+	// token, literals, offset and length extensions
+	if (op + 1 + lit_len + lit_len / 255 + 1 + 2 + match_len / 255 + 1 > out_max) {
+		return -1;
+	}
+
+	uint8_t *token = &out[op++];
+	int l = lit_len;
+	*token = (l >= 15 ? 15 : l) << 4;
+
+	if (l >= 15) {
+		for (l -= 15; l >= 255; l -= 255) {
+			out[op++] = 255;
+		}
+
+		out[op++] = l;
+	}
+
+	memcpy(&out[op], lit, lit_len);
+	op += lit_len;
+
+	if (match_len > 0) {
+		out[op++] = offset & 0xff;
+		out[op++] = offset >> 8;
+
+		int m = match_len - MIN_MATCH;
+		*token |= (m >= 15 ? 15 : m);
+
+		if (m >= 15) {
+			for (m -= 15; m >= 255; m -= 255) {
+				out[op++] = 255;
+			}
+
+			out[op++] = m;
+		}
+	}
+
+	return op;
+}
+
+static uint32_t read32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * Compress a block with LZ77.
+ *
+ * @return compressed length, or -1 if it would not be smaller than out_max
+ */
+static int lz_compress(struct logcompress_s *lc, const uint8_t *in, int len, uint8_t *out, int out_max)
+{
+	memset(lc->hash, 0, sizeof(uint16_t) << HASH_BITS);
+
+	int ip = 0;
+	int anchor = 0;
+	int op = 0;
+
+	while (ip + MIN_MATCH <= len) {
+		uint32_t seq = read32(&in[ip]);
+		unsigned h = (seq * 2654435761u) >> (32 - HASH_BITS);
+		int ref = lc->hash[h] - 1;
+		lc->hash[h] = ip + 1;
+
+		if (ref >= 0 && read32(&in[ref]) == seq) {
+			int match_len = MIN_MATCH;
+
+			while (ip + match_len < len && in[ref + match_len] == in[ip + match_len]) {
+				match_len++;
+			}
+
+			op = lz_emit(out, op, out_max, &in[anchor], ip - anchor, ip - ref, match_len);
+
+			if (op < 0) {
+				return -1;
+			}
+
+			ip += match_len;
+			anchor = ip;
+
+		} else {
+			ip++;
+		}
+	}
+
+	if (anchor < len) {
+		op = lz_emit(out, op, out_max, &in[anchor], len - anchor, 0, 0);
+	}
+
+	return op;
+}
+
+int logcompress_encode(struct logcompress_s *lc, bool final, const uint8_t **block)
+{
+	bool partial;
+	int len = complete_length(lc, lc->raw, lc->raw_fill, &partial);
+
+	delta_encode(lc, lc->raw, len);
+
+	if (!partial || final) {
+		// unknown data is passed on without delta, as is a torn message at the very end
+		len = lc->raw_fill;
+	}
+
+	if (len == 0) {
+		return 0;
+	}
+
+	uint8_t *data = &lc->out[LOG_COMPRESS_HEADER_LEN];
+	int data_len = lz_compress(lc, lc->raw, len, data, len - 1);
+
+	if (data_len < 0) {
+		// store blocks that do not compress
+		memcpy(data, lc->raw, len);
+		data_len = len;
+	}
+
+	lc->out[0] = HEAD_BYTE1;
+	lc->out[1] = HEAD_BYTE2;
+	lc->out[2] = LOG_BLOCK_MSG;
+	lc->out[3] = len & 0xff;
+	lc->out[4] = len >> 8;
+	lc->out[5] = data_len & 0xff;
+	lc->out[6] = data_len >> 8;
+
+	// keep the partial message for the next block
+	memmove(lc->raw, &lc->raw[len], lc->raw_fill - len);
+	lc->raw_fill -= len;
+
+	*block = lc->out;
+	return LOG_COMPRESS_HEADER_LEN + data_len;
+}
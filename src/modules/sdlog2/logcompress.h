@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file logcompress.h
+ *
+ * Block compression for the binary log stream.
+ *
+ * The log stream is cut into blocks of whole messages. Within a block the
+ * body of each message is XORed with the previous message of the same type,
+ * which turns slowly changing fields into runs of zeroes, and the result is
+ * packed with a small LZ77 codec. Each block is written as a LOG_BLOCK_MSG
+ * packet that decoders expand back into plain messages; the delta state is
+ * reset for every block so a damaged block does not affect the next one.
+ *
+ * Block packet layout, little endian:
+ *
+ *	head1, head2, LOG_BLOCK_MSG	packet header
+ *	uint16 raw_len			length of the decoded block
+ *	uint16 data_len			length of the data that follows; equal to
+ *					raw_len if the block is stored uncompressed
+ *	data
+ *
+ * The LZ77 data is a sequence of tokens. The high nibble of a token is the
+ * literal count and the low nibble the match length minus 4; a nibble of 15
+ * is extended by following bytes, added up until one is not 255. The literals
+ * follow the token, then a uint16 match offset if the block is not complete
+ * yet.
+ */
+
+#ifndef SDLOG2_LOGCOMPRESS_H_
+#define SDLOG2_LOGCOMPRESS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdlog2_format.h"
+
+#define LOG_COMPRESS_BLOCK	2048	/**< raw bytes per block */
+#define LOG_COMPRESS_HEADER_LEN	7	/**< length of the block packet header */
+
+struct logcompress_s {
+	uint8_t *raw;			// raw log data of the current block
+	int raw_fill;
+	uint8_t *out;			// encoded block packet
+	uint8_t *prev;			// previous body of every message type
+	int prev_size;
+	uint16_t *hash;			// LZ77 match finder, position + 1 of recent sequences
+	uint16_t msg_len[256];		// full packet length by message type, 0 if unknown
+	uint16_t prev_offset[256];	// offset of the previous body in prev by message type
+};
+
+int logcompress_init(struct logcompress_s *lc, const struct log_format_s *formats, unsigned count);
+
+/**
+ * Register a message type that is not in the format table, e.g. a raw topic.
+ */
+int logcompress_add_type(struct logcompress_s *lc, uint8_t type, unsigned length);
+
+void logcompress_free(struct logcompress_s *lc);
+
+int logcompress_space(struct logcompress_s *lc);
+
+void logcompress_put(struct logcompress_s *lc, const void *data, int n);
+
+/**
+ * Encode the buffered data into a block packet.
+ *
+ * Unless final is set a trailing partial message is kept for the next block.
+ *
+ * @return length of the packet at *block, 0 if there is nothing to write
+ */
+int logcompress_encode(struct logcompress_s *lc, bool final, const uint8_t **block);
+
+#endif
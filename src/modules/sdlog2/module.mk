@@ -40,6 +40,8 @@ MODULE_COMMAND  = sdlog2
 MODULE_PRIORITY = "SCHED_PRIORITY_MAX-30"
 
 SRCS = sdlog2.c \
-       logbuffer.c
+       logbuffer.c \
+       logcompress.c \
+       blackbox.c
 
 MODULE_STACKSIZE = 1200
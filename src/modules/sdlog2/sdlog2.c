@@ -50,6 +50,7 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <poll.h>
+#include <semaphore.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -91,6 +92,8 @@
 #include <uORB/topics/servorail_status.h>
 #include <uORB/topics/wind_estimate.h>
 #include <uORB/topics/encoders.h>
+#include <uORB/topics/perf_report.h>
+#include <uORB/topics/io_link_status.h>
 
 #include <systemlib/systemlib.h>
 #include <systemlib/param/param.h>
@@ -100,8 +103,11 @@
 #include <mavlink/mavlink_log.h>
 
 #include "logbuffer.h"
+#include "logcompress.h"
+#include "blackbox.h"
 #include "sdlog2_format.h"
 #include "sdlog2_messages.h"
+#include "sdlog2_topics.h"
 
 /**
  * Logging rate.
@@ -135,8 +141,14 @@ PARAM_DEFINE_INT32(SDLOG_EXT, -1);
 
 #define LOGBUFFER_WRITE_AND_COUNT(_msg) if (logbuffer_write(&lb, &log_msg, LOG_PACKET_SIZE(_msg))) { \
 		log_msgs_written++; \
+		perf_count(perf_written); \
+		log_msg_counts[log_msg.msg_type]++; \
+		log_msg_bytes[log_msg.msg_type] += LOG_PACKET_SIZE(_msg); \
+		log_bytes_queued += LOG_PACKET_SIZE(_msg); \
 	} else { \
 		log_msgs_skipped++; \
+		perf_count(perf_dropped); \
+		log_msg_drops[log_msg.msg_type]++; \
 	}
 
 #define LOG_ORB_SUBSCRIBE(_var, _topic) subs.##_var##_sub = orb_subscribe(ORB_ID(##_topic##)); \
@@ -155,28 +167,110 @@ static const unsigned MAX_NO_LOGFILE = 999;		/**< Maximum number of log files */
 static const int LOG_BUFFER_SIZE_DEFAULT = 8192;
 static const int MAX_WRITE_CHUNK = 512;
 static const int MIN_BYTES_TO_WRITE = 512;
+static const int ALIGNED_WRITE_CHUNK = 4096;		/**< Write size in aligned mode, a multiple of the SD sector size */
+static const unsigned LOG_POLL_FDS_MAX = 48;		/**< Maximum number of topics waited on in event-driven mode */
 
 static bool _extended_logging = false;
 
+/* write whole, aligned chunks only (-s option) */
+static bool log_aligned_writes = false;
+
+/* compress the log stream (-z option) */
+static bool log_compress = false;
+
+/* log every raw accel and gyro sample in batches (-i option) */
+static bool log_imu_batches = false;
+
+/*
+ * Pre-trigger black box (-k option): topics flagged in sdlog2_topics.h are
+ * recorded at full rate into a RAM ring, whether logging or not. When a
+ * trigger fires, recording goes on for BLACKBOX_POST_TRIGGER and the ring
+ * is then written to its own file by a separate thread.
+ */
+static struct blackbox_s blackbox;
+static bool blackbox_enabled = false;
+static hrt_abstime blackbox_trigger_time = 0;		/**< time of the pending trigger, 0 if none */
+static volatile bool blackbox_busy = false;		/**< ring is being written, recording is paused */
+static unsigned blackbox_dumps = 0;
+static const hrt_abstime BLACKBOX_POST_TRIGGER = 1000000;
+
+/**
+ * Log file output state, see log_output().
+ */
+struct log_output_s {
+	int fd;
+	char *chunk;			/**< chunk buffer in aligned mode, NULL otherwise */
+	int chunk_fill;			/**< bytes in chunk */
+	int chunk_len;			/**< bytes in chunk at which it is written */
+};
+
 static const char *log_root = "/fs/microsd/log";
 static int mavlink_fd = -1;
 struct logbuffer_s lb;
 
-/* mutex / condition to synchronize threads */
-static pthread_mutex_t logbuffer_mutex;
-static pthread_cond_t logbuffer_cond;
+/*
+ * The log buffer is a single producer / single consumer ring and needs no
+ * lock; the semaphore only wakes the writer thread once it has gone idle.
+ */
+static sem_t logwriter_sem;
+static volatile bool logwriter_waiting = false;	/**< Logwriter thread is (about to be) blocked on logwriter_sem */
 
 static char log_dir[32];
 
 /* statistics counters */
 static uint64_t start_time = 0;
 static unsigned long log_bytes_written = 0;
+static unsigned long log_bytes_raw = 0;		/**< log data before compression */
+static unsigned long log_bytes_queued = 0;	/**< log data put into the log buffer */
+
+/*
+ * Index written when the log is closed: the file offsets of sync markers,
+ * which the main thread passes to the writer thread through a FIFO
+ * (positions in the log stream), and message counts by type.
+ */
+static uint32_t log_msg_counts[256];
+
+/* bandwidth by message type, in the status and once per second in the log as LSTA messages */
+static uint32_t log_msg_bytes[256];
+static uint32_t log_msg_drops[256];
+
+struct log_sync_pos_s {
+	uint64_t t;
+	unsigned long pos;		/**< position of the marker in the log stream */
+};
+
+#define LOG_SYNC_FIFO_SIZE	16
+static struct log_sync_pos_s log_sync_fifo[LOG_SYNC_FIFO_SIZE];
+static volatile unsigned log_sync_head = 0;	/**< only changed by the main thread */
+static volatile unsigned log_sync_tail = 0;	/**< only changed by the writer thread */
+
+#define LOG_INDEX_MAX		256
+static struct log_IDX_s log_index[LOG_INDEX_MAX];
+static unsigned log_index_count = 0;
+static unsigned log_index_stride = 1;		/**< keep every n-th marker, doubled when the index fills up */
+static unsigned log_index_skip = 0;		/**< markers to drop before keeping the next one */
 static unsigned long log_msgs_written = 0;
 static unsigned long log_msgs_skipped = 0;
 
+/* the same counts for sysperf, which can not see the ones above */
+static perf_counter_t perf_written = NULL;
+static perf_counter_t perf_dropped = NULL;
+
+/* histogram of log file write() latencies, bucket i counts writes faster than write_latency_bounds[i] */
+static const unsigned write_latency_bounds[] = { 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000 };
+#define WRITE_LATENCY_BUCKETS	(sizeof(write_latency_bounds) / sizeof(write_latency_bounds[0]) + 1)
+static unsigned long write_latency_hist[WRITE_LATENCY_BUCKETS];
+static hrt_abstime write_latency_max = 0;
+
 /* GPS time, used for log files naming */
 static uint64_t gps_time = 0;
 
+/* raw topics, see sdlog2_topics.h */
+#define LOG_TOPIC_SIZE_MAX	256
+static bool log_topic_valid[sizeof(log_topics) / sizeof(log_topics[0])];	/**< format matches the topic size */
+static int log_topic_subs[sizeof(log_topics) / sizeof(log_topics[0])];	/**< subscriptions, -1 if the topic is not logged */
+static int blackbox_subs[sizeof(log_topics) / sizeof(log_topics[0])];	/**< subscriptions, -1 if the topic is not recorded */
+
 /* current state of logging */
 static bool logging_enabled = false;
 /* use date/time for naming directories and files (-t option) */
@@ -193,6 +287,43 @@ static pthread_attr_t logwriter_attr;
  */
 static void *logwriter_thread(void *arg);
 
+/**
+ * Write to the log file and account the time taken in the latency histogram.
+ */
+static int log_write_timed(int fd, const void *buf, size_t count);
+
+/**
+ * Write log data to the file, in whole aligned chunks if enabled.
+ *
+ * @return 0 on success, -1 on a write error
+ */
+static int log_output(struct log_output_s *out, const void *data, int len);
+
+/**
+ * Write the buffered part of the last aligned chunk.
+ */
+static void log_output_flush(struct log_output_s *out);
+
+/**
+ * File offset the next log_output() call writes at.
+ */
+static unsigned long log_output_offset(struct log_output_s *out);
+
+/**
+ * Move the sync markers that are written out from the FIFO into the index.
+ *
+ * @param stream_end	Markers before this log stream position have been written.
+ * @param offset	File offset to record for them; if exact is set, the file
+ *			offset of the log stream start instead.
+ * @param exact		The log stream is written as is, not compressed.
+ */
+static void log_index_update(unsigned long stream_end, unsigned long offset, bool exact);
+
+/**
+ * Write the index and its trailer, the last data in the file.
+ */
+static int write_index(struct log_output_s *out);
+
 /**
  * SD log management function.
  */
@@ -200,6 +331,16 @@ __EXPORT int sdlog2_main(int argc, char *argv[]);
 
 static bool copy_if_updated(orb_id_t topic, int handle, void *buffer);
 
+/**
+ * Add a subscription to the set the main loop waits on in event-driven mode.
+ *
+ * @param fds		The poll set.
+ * @param count		Number of entries in fds, incremented.
+ * @param handle	The subscription to add.
+ * @param interval	Minimum interval between logged samples in ms, 0 to log every publication.
+ */
+static void log_poll_add(struct pollfd *fds, unsigned *count, int handle, unsigned interval);
+
 /**
  * Mainloop of sd log deamon.
  */
@@ -215,6 +356,11 @@ static void sdlog2_usage(const char *reason);
  */
 static void sdlog2_status(void);
 
+/**
+ * Get the name of a message type for the status output.
+ */
+static void log_msg_name(unsigned type, char *name, size_t len);
+
 /**
  * Start logging: create new file and start log writer thread.
  */
@@ -230,6 +376,52 @@ static void sdlog2_stop_log(void);
  */
 static int write_formats(int fd);
 
+/**
+ * Write a header to log file: layouts of the raw topics and long messages.
+ */
+static int write_topic_formats(int fd);
+
+/**
+ * Get the topic size a raw topic format string describes.
+ *
+ * @return size in bytes, -1 if the format is invalid
+ */
+static int log_topic_format_size(const char *format);
+
+/**
+ * Subscribe to the raw topics whose format matches the topic size.
+ */
+static void log_topics_subscribe(void);
+
+/**
+ * Add a raw IMU sample to a batch.
+ *
+ * A batch is complete when it is full, or when the sample is too far from
+ * the first one to be stored as a delta; then the sample starts the next
+ * batch.
+ *
+ * @param lost		samples lost before this one
+ * @param out		receives the completed batch
+ * @return		true if out holds a batch to write
+ */
+static bool log_imu_batch_add(struct log_IMUB_s *batch, uint64_t t, int16_t x, int16_t y, int16_t z,
+			      float scale, unsigned lost, struct log_IMUB_s *out);
+
+/**
+ * Request a black box dump, ignored while one is pending.
+ */
+static void blackbox_trigger(const char *reason);
+
+/**
+ * Write the black box ring to a new file, runs in its own thread.
+ */
+static void *blackbox_thread(void *arg);
+
+/**
+ * Select first free black box file name and open it.
+ */
+static int open_blackbox_file(void);
+
 /**
  * Write version message to log file.
  */
@@ -267,13 +459,18 @@ sdlog2_usage(const char *reason)
 		fprintf(stderr, "%s\n", reason);
 	}
 
-	errx(1, "usage: sdlog2 {start|stop|status} [-r <log rate>] [-b <buffer size>] -e -a -t -x\n"
+	errx(1, "usage: sdlog2 {start|stop|status} [-r <log rate>] [-b <buffer size>] [-k <black box size>] -e -a -t -x -p -s -z -i\n"
 		 "\t-r\tLog rate in Hz, 0 means unlimited rate\n"
+		 "\t-p\tLog on publication, with a separate rate for each topic (-r is ignored)\n"
 		 "\t-b\tLog buffer size in KiB, default is 8\n"
 		 "\t-e\tEnable logging by default (if not, can be started by command)\n"
 		 "\t-a\tLog only when armed (can be still overriden by command)\n"
 		 "\t-t\tUse date/time for naming log directories and files\n"
-		 "\t-x\tExtended logging");
+		 "\t-x\tExtended logging\n"
+		 "\t-s\tOnly write whole, sector aligned 4 KiB chunks\n"
+		 "\t-z\tCompress the log\n"
+		 "\t-i\tLog every raw accel and gyro sample, in batches\n"
+		 "\t-k\tBlack box ring size in KiB, records chosen topics at full rate for crash capture (implies -p)");
 }
 
 /**
@@ -491,6 +688,167 @@ int open_perf_file(const char* str)
 	return fd;
 }
 
+int log_write_timed(int fd, const void *buf, size_t count)
+{
+	hrt_abstime t = hrt_absolute_time();
+	int n = write(fd, buf, count);
+	hrt_abstime dt = hrt_absolute_time() - t;
+
+	unsigned i = 0;
+
+	while (i < WRITE_LATENCY_BUCKETS - 1 && dt >= write_latency_bounds[i]) {
+		i++;
+	}
+
+	write_latency_hist[i]++;
+
+	if (dt > write_latency_max) {
+		write_latency_max = dt;
+	}
+
+	return n;
+}
+
+int log_output(struct log_output_s *out, const void *data, int len)
+{
+	const char *c = (const char *)data;
+
+	if (out->chunk == NULL) {
+		int n = log_write_timed(out->fd, c, len);
+
+		if (n > 0) {
+			log_bytes_written += n;
+		}
+
+		return (n == len) ? 0 : -1;
+	}
+
+	while (len > 0) {
+		/* take what fits into the chunk, write it once complete */
+		int n = MIN(len, out->chunk_len - out->chunk_fill);
+		memcpy(&out->chunk[out->chunk_fill], c, n);
+		out->chunk_fill += n;
+		c += n;
+		len -= n;
+
+		if (out->chunk_fill == out->chunk_len) {
+			if (log_write_timed(out->fd, out->chunk, out->chunk_len) != out->chunk_len) {
+				return -1;
+			}
+
+			log_bytes_written += out->chunk_len;
+			out->chunk_fill = 0;
+			out->chunk_len = ALIGNED_WRITE_CHUNK;
+		}
+	}
+
+	return 0;
+}
+
+void log_output_flush(struct log_output_s *out)
+{
+	if (out->chunk != NULL && out->chunk_fill > 0) {
+		if (log_write_timed(out->fd, out->chunk, out->chunk_fill) == out->chunk_fill) {
+			log_bytes_written += out->chunk_fill;
+		}
+
+		out->chunk_fill = 0;
+	}
+}
+
+unsigned long log_output_offset(struct log_output_s *out)
+{
+	return log_bytes_written + ((out->chunk != NULL) ? out->chunk_fill : 0);
+}
+
+static void log_index_add(uint64_t t, unsigned long offset)
+{
+	if (log_index_skip > 0) {
+		log_index_skip--;
+		return;
+	}
+
+	/* the index is full: keep every other entry, and from now on every other marker */
+	if (log_index_count == LOG_INDEX_MAX) {
+		for (unsigned i = 0; i < LOG_INDEX_MAX / 2; i++) {
+			log_index[i] = log_index[2 * i];
+		}
+
+		log_index_count = LOG_INDEX_MAX / 2;
+		log_index_stride *= 2;
+	}
+
+	log_index[log_index_count].t = t;
+	log_index[log_index_count].offset = offset;
+	log_index_count++;
+	log_index_skip = log_index_stride - 1;
+}
+
+void log_index_update(unsigned long stream_end, unsigned long offset, bool exact)
+{
+	while (log_sync_tail != log_sync_head) {
+		/* read the entry only after the head that published it */
+		__sync_synchronize();
+		struct log_sync_pos_s *sync = &log_sync_fifo[log_sync_tail % LOG_SYNC_FIFO_SIZE];
+
+		if (sync->pos >= stream_end) {
+			break;
+		}
+
+		log_index_add(sync->t, exact ? offset + sync->pos : offset);
+		log_sync_tail++;
+	}
+}
+
+int write_index(struct log_output_s *out)
+{
+	struct {
+		LOG_PACKET_HEADER;
+		struct log_IDX_s body;
+	} log_msg_IDX = {
+		LOG_PACKET_HEADER_INIT(LOG_IDX_MSG),
+	};
+
+	struct {
+		LOG_PACKET_HEADER;
+		struct log_CNT_s body;
+	} log_msg_CNT = {
+		LOG_PACKET_HEADER_INIT(LOG_CNT_MSG),
+	};
+
+	struct {
+		LOG_PACKET_HEADER;
+		struct log_IDXT_s body;
+	} log_msg_IDXT = {
+		LOG_PACKET_HEADER_INIT(LOG_IDXT_MSG),
+	};
+
+	memcpy(log_msg_IDXT.body.magic, LOG_IDXT_MAGIC, sizeof(log_msg_IDXT.body.magic));
+	log_msg_IDXT.body.start = log_output_offset(out);
+	log_msg_IDXT.body.entries = log_index_count;
+	log_msg_IDXT.body.types = 0;
+
+	int ret = 0;
+
+	for (unsigned i = 0; i < log_index_count; i++) {
+		log_msg_IDX.body = log_index[i];
+		ret |= log_output(out, &log_msg_IDX, sizeof(log_msg_IDX));
+	}
+
+	for (unsigned i = 0; i < 256; i++) {
+		if (log_msg_counts[i] > 0) {
+			log_msg_CNT.body.type = i;
+			log_msg_CNT.body.count = log_msg_counts[i];
+			ret |= log_output(out, &log_msg_CNT, sizeof(log_msg_CNT));
+			log_msg_IDXT.body.types++;
+		}
+	}
+
+	ret |= log_output(out, &log_msg_IDXT, sizeof(log_msg_IDXT));
+
+	return ret;
+}
+
 static void *logwriter_thread(void *arg)
 {
 	/* set name */
@@ -507,6 +865,8 @@ static void *logwriter_thread(void *arg)
 	/* write log messages formats, version and parameters */
 	log_bytes_written += write_formats(log_fd);
 
+	log_bytes_written += write_topic_formats(log_fd);
+
 	log_bytes_written += write_version(log_fd);
 
 	log_bytes_written += write_parameters(log_fd);
@@ -523,10 +883,60 @@ static void *logwriter_thread(void *arg)
 
 	bool is_part = false;
 
-	while (true) {
-		/* make sure threads are synchronized */
-		pthread_mutex_lock(&logbuffer_mutex);
+	/*
+	 * In aligned mode data is gathered into a chunk buffer and only written
+	 * once a whole chunk is complete, so the FAT driver never has to
+	 * read-modify-write a sector. The first chunk is shortened to bring the
+	 * file offset to a chunk boundary after the header.
+	 */
+	struct log_output_s out = {
+		.fd = log_fd,
+		.chunk = NULL,
+		.chunk_fill = 0,
+		.chunk_len = ALIGNED_WRITE_CHUNK - (log_bytes_written % ALIGNED_WRITE_CHUNK)
+	};
+
+	if (log_aligned_writes) {
+		out.chunk = malloc(ALIGNED_WRITE_CHUNK);
+
+		if (out.chunk == NULL) {
+			warnx("no memory for aligned writes");
+		}
+	}
 
+	/* in compressed mode the stream is written as compressed blocks of whole messages */
+	/* static, the tables are too big for the writer thread stack */
+	static struct logcompress_s lc;
+	bool compress = false;
+
+	if (log_compress) {
+		compress = (logcompress_init(&lc, log_formats, log_formats_num) == OK);
+
+		for (unsigned i = 0; compress && i < log_topics_num; i++) {
+			if (log_topic_valid[i]) {
+				compress = (logcompress_add_type(&lc, LOG_TOPIC_MSG_BASE + i,
+								 LOG_PACKET_HEADER_LEN + log_topics[i].meta->o_size) == OK);
+			}
+		}
+
+		for (unsigned i = 0; compress && i < log_long_formats_num; i++) {
+			compress = (logcompress_add_type(&lc, log_long_formats[i].type,
+							 LOG_PACKET_HEADER_LEN + log_long_formats[i].size) == OK);
+		}
+
+		if (!compress) {
+			logcompress_free(&lc);
+			warnx("no memory for compression");
+		}
+	}
+
+	const uint8_t *block;
+	int block_len;
+
+	/* file offset of the log stream start, for the index */
+	unsigned long stream_offset = log_bytes_written;
+
+	while (true) {
 		/* update read pointer if needed */
 		if (n > 0) {
 			logbuffer_mark_read(&lb, n);
@@ -534,16 +944,21 @@ static void *logwriter_thread(void *arg)
 
 		/* only wait if no data is available to process */
 		if (should_wait && !logwriter_should_exit) {
-			/* blocking wait for new data at this line */
-			pthread_cond_wait(&logbuffer_cond, &logbuffer_mutex);
+			/* announce the wait before re-checking, so a producer crossing the threshold now posts */
+			logwriter_waiting = true;
+			__sync_synchronize();
+
+			if (logbuffer_count(logbuf) <= MIN_BYTES_TO_WRITE && !logwriter_should_exit) {
+				/* blocking wait for new data at this line */
+				sem_wait(&logwriter_sem);
+			}
+
+			logwriter_waiting = false;
 		}
 
-		/* only get pointer to thread-safe data, do heavy I/O a few lines down */
+		/* only the main thread moves the write pointer, the data up to it is stable */
 		int available = logbuffer_get_ptr(logbuf, &read_ptr, &is_part);
 
-		/* continue */
-		pthread_mutex_unlock(&logbuffer_mutex);
-
 		if (available > 0) {
 			/* do heavy IO here */
 			if (available > MAX_WRITE_CHUNK) {
@@ -553,18 +968,34 @@ static void *logwriter_thread(void *arg)
 				n = available;
 			}
 
-			n = write(log_fd, read_ptr, n);
+			int ret = 0;
 
-			should_wait = (n == available) && !is_part;
+			if (compress) {
+				/* fill up the current block, compress and write it once full */
+				n = MIN(n, logcompress_space(&lc));
+				logcompress_put(&lc, read_ptr, n);
+				log_bytes_raw += n;
+
+				if (logcompress_space(&lc) == 0) {
+					/* index entries point at the block holding the marker */
+					unsigned long block_offset = log_output_offset(&out);
+					block_len = logcompress_encode(&lc, false, &block);
+					ret = log_output(&out, block, block_len);
+					log_index_update(log_bytes_raw - lc.raw_fill, block_offset, false);
+				}
 
-			if (n < 0) {
+			} else {
+				ret = log_output(&out, read_ptr, n);
+				log_bytes_raw += n;
+				log_index_update(log_bytes_raw, stream_offset, true);
+			}
+
+			if (ret < 0) {
 				main_thread_should_exit = true;
 				err(1, "error writing log file");
 			}
 
-			if (n > 0) {
-				log_bytes_written += n;
-			}
+			should_wait = (n == available) && !is_part;
 
 		} else {
 			n = 0;
@@ -583,6 +1014,24 @@ static void *logwriter_thread(void *arg)
 		}
 	}
 
+	/* write the last, incomplete block, then the index and the last chunk */
+	if (compress) {
+		unsigned long block_offset = log_output_offset(&out);
+		block_len = logcompress_encode(&lc, true, &block);
+
+		if (block_len > 0) {
+			log_output(&out, block, block_len);
+		}
+
+		log_index_update(log_bytes_raw, block_offset, false);
+		logcompress_free(&lc);
+	}
+
+	write_index(&out);
+
+	log_output_flush(&out);
+	free(out.chunk);
+
 	fsync(log_fd);
 	close(log_fd);
 
@@ -602,9 +1051,21 @@ void sdlog2_start_log()
 
 	/* initialize statistics counter */
 	log_bytes_written = 0;
+	log_bytes_raw = 0;
+	log_bytes_queued = 0;
+	memset(log_msg_counts, 0, sizeof(log_msg_counts));
+	memset(log_msg_bytes, 0, sizeof(log_msg_bytes));
+	memset(log_msg_drops, 0, sizeof(log_msg_drops));
+	log_sync_head = 0;
+	log_sync_tail = 0;
+	log_index_count = 0;
+	log_index_stride = 1;
+	log_index_skip = 0;
 	start_time = hrt_absolute_time();
 	log_msgs_written = 0;
 	log_msgs_skipped = 0;
+	memset(write_latency_hist, 0, sizeof(write_latency_hist));
+	write_latency_max = 0;
 
 	/* initialize log buffer emptying thread */
 	pthread_attr_init(&logwriter_attr);
@@ -643,11 +1104,8 @@ void sdlog2_stop_log()
 	logging_enabled = false;
 
 	/* wake up write thread one last time */
-	pthread_mutex_lock(&logbuffer_mutex);
 	logwriter_should_exit = true;
-	pthread_cond_signal(&logbuffer_cond);
-	/* unlock, now the writer thread may return */
-	pthread_mutex_unlock(&logbuffer_mutex);
+	sem_post(&logwriter_sem);
 
 	/* wait for write thread to return */
 	int ret;
@@ -689,6 +1147,248 @@ int write_formats(int fd)
 	return written;
 }
 
+int write_topic_formats(int fd)
+{
+	struct {
+		LOG_PACKET_HEADER;
+		struct log_topic_format_s body;
+	} __attribute__((packed)) log_msg_format = {
+		LOG_PACKET_HEADER_INIT(LOG_TOPIC_FORMAT_MSG),
+	};
+
+	int written = 0;
+
+	for (unsigned i = 0; i < log_long_formats_num; i++) {
+		log_msg_format.body = log_long_formats[i];
+		written += write(fd, &log_msg_format, sizeof(log_msg_format));
+	}
+
+	for (unsigned i = 0; i < log_topics_num; i++) {
+		if (!log_topic_valid[i]) {
+			continue;
+		}
+
+		memset(&log_msg_format.body, 0, sizeof(log_msg_format.body));
+		log_msg_format.body.type = LOG_TOPIC_MSG_BASE + i;
+		log_msg_format.body.size = log_topics[i].meta->o_size;
+		strncpy(log_msg_format.body.name, log_topics[i].name, sizeof(log_msg_format.body.name));
+		strncpy(log_msg_format.body.format, log_topics[i].format, sizeof(log_msg_format.body.format));
+		strncpy(log_msg_format.body.labels, log_topics[i].labels, sizeof(log_msg_format.body.labels));
+		written += write(fd, &log_msg_format, sizeof(log_msg_format));
+	}
+
+	return written;
+}
+
+int log_topic_format_size(const char *format)
+{
+	int size = 0;
+
+	while (*format) {
+		int count = 0;
+
+		while (isdigit(*format)) {
+			count = count * 10 + (*format++ - '0');
+		}
+
+		if (count == 0) {
+			count = 1;
+		}
+
+		int field;
+
+		switch (*format++) {
+		case 'b':
+		case 'B':
+		case 'M':
+		case 'x':
+			field = 1;
+			break;
+
+		case 'h':
+		case 'H':
+		case 'c':
+		case 'C':
+			field = 2;
+			break;
+
+		case 'i':
+		case 'I':
+		case 'f':
+		case 'e':
+		case 'E':
+		case 'L':
+		case 'n':
+			field = 4;
+			break;
+
+		case 'q':
+		case 'Q':
+			field = 8;
+			break;
+
+		case 'N':
+			field = 16;
+			break;
+
+		case 'Z':
+			field = 64;
+			break;
+
+		default:
+			return -1;
+		}
+
+		size += count * field;
+	}
+
+	return size;
+}
+
+void log_topics_subscribe(void)
+{
+	if (log_topics_num > LOG_TOPIC_MSG_MAX) {
+		warnx("too many raw topics");
+	}
+
+	for (unsigned i = 0; i < log_topics_num; i++) {
+		log_topic_valid[i] = false;
+		log_topic_subs[i] = -1;
+		blackbox_subs[i] = -1;
+
+		if (i >= LOG_TOPIC_MSG_MAX) {
+			continue;
+		}
+
+		int size = log_topic_format_size(log_topics[i].format);
+
+		if (size != (int)log_topics[i].meta->o_size || size > LOG_TOPIC_SIZE_MAX) {
+			warnx("%s: format does not match topic size %u", log_topics[i].name, (unsigned)log_topics[i].meta->o_size);
+			continue;
+		}
+
+		log_topic_valid[i] = true;
+
+		if (log_topics[i].flags & LOG_TOPIC_LOG) {
+			log_topic_subs[i] = orb_subscribe(log_topics[i].meta);
+		}
+
+		if (blackbox_enabled && (log_topics[i].flags & LOG_TOPIC_BLACKBOX)) {
+			/* no interval, the black box wants every sample */
+			blackbox_subs[i] = orb_subscribe(log_topics[i].meta);
+			blackbox_set_type(&blackbox, LOG_TOPIC_MSG_BASE + i, LOG_PACKET_HEADER_LEN + size);
+		}
+	}
+
+	blackbox_set_type(&blackbox, LOG_TIME_MSG, LOG_PACKET_SIZE(TIME));
+}
+
+bool log_imu_batch_add(struct log_IMUB_s *batch, uint64_t t, int16_t x, int16_t y, int16_t z,
+		       float scale, unsigned lost, struct log_IMUB_s *out)
+{
+	bool complete = false;
+
+	if (batch->count > 0 && t - batch->t > UINT16_MAX) {
+		*out = *batch;
+		batch->count = 0;
+		batch->lost = 0;
+		complete = true;
+	}
+
+	if (batch->count == 0) {
+		batch->t = t;
+	}
+
+	unsigned n = batch->count++;
+	batch->dt[n] = t - batch->t;
+	batch->x[n] = x;
+	batch->y[n] = y;
+	batch->z[n] = z;
+	batch->scale = scale;
+	batch->lost = (batch->lost + lost > UINT8_MAX) ? UINT8_MAX : batch->lost + lost;
+
+	if (batch->count == LOG_IMUB_SAMPLES) {
+		/* can't complete twice, a previous batch was emptied above */
+		*out = *batch;
+		batch->count = 0;
+		batch->lost = 0;
+		complete = true;
+	}
+
+	return complete;
+}
+
+void blackbox_trigger(const char *reason)
+{
+	if (!blackbox_enabled || blackbox_busy || blackbox_trigger_time != 0) {
+		return;
+	}
+
+	blackbox_trigger_time = hrt_absolute_time();
+	warnx("black box triggered: %s", reason);
+	mavlink_log_info(mavlink_fd, "[sdlog2] black box triggered: %s", reason);
+}
+
+int open_blackbox_file()
+{
+	char path[64] = "";
+	unsigned file_number = 1;
+
+	/* look for the next file that does not exist, e.g. /fs/microsd/log/bbox001.bin */
+	while (file_number <= MAX_NO_LOGFILE) {
+		snprintf(path, sizeof(path), "%s/bbox%03u.bin", log_root, file_number);
+
+		if (!file_exist(path)) {
+			break;
+		}
+
+		file_number++;
+	}
+
+	if (file_number > MAX_NO_LOGFILE) {
+		mavlink_log_critical(mavlink_fd, "[sdlog2] ERR: max black box files %d", MAX_NO_LOGFILE);
+		return -1;
+	}
+
+	int fd = open(path, O_CREAT | O_WRONLY | O_DSYNC);
+
+	if (fd < 0) {
+		warn("failed opening black box file: %s", path);
+		return -1;
+	}
+
+	warnx("black box file: %s", path);
+	mavlink_log_info(mavlink_fd, "[sdlog2] black box file: %s", path);
+	return fd;
+}
+
+void *blackbox_thread(void *arg)
+{
+	prctl(PR_SET_NAME, "sdlog2_blackbox", 0);
+
+	int fd = open_blackbox_file();
+
+	if (fd >= 0) {
+		/* same header as a log, so the usual tools can read the file */
+		write_formats(fd);
+		write_topic_formats(fd);
+		write_version(fd);
+		write_parameters(fd);
+
+		if (blackbox_dump(&blackbox, fd) < 0) {
+			warn("black box write failed");
+		}
+
+		fsync(fd);
+		close(fd);
+		blackbox_dumps++;
+	}
+
+	blackbox_reset(&blackbox);
+	blackbox_busy = false;
+	return NULL;
+}
+
 int write_version(int fd)
 {
 	/* construct version message */
@@ -759,6 +1459,22 @@ bool copy_if_updated(orb_id_t topic, int handle, void *buffer)
 	return updated;
 }
 
+void log_poll_add(struct pollfd *fds, unsigned *count, int handle, unsigned interval)
+{
+	if (*count >= LOG_POLL_FDS_MAX) {
+		warnx("too many topics to poll");
+		return;
+	}
+
+	if (interval > 0) {
+		orb_set_interval(handle, interval);
+	}
+
+	fds[*count].fd = handle;
+	fds[*count].events = POLLIN;
+	(*count)++;
+}
+
 int sdlog2_thread_main(int argc, char *argv[])
 {
 	mavlink_fd = open(MAVLINK_LOG_DEVICE, 0);
@@ -776,6 +1492,10 @@ int sdlog2_thread_main(int argc, char *argv[])
 	/* enable logging when armed (-a option) */
 	bool log_when_armed = false;
 	log_name_timestamp = false;
+	/* wake on publication instead of sampling at a fixed rate (-p option) */
+	bool log_on_publication = false;
+	/* black box ring size (-k option), 0 to disable */
+	int blackbox_size = 0;
 
 	flag_system_armed = false;
 
@@ -788,7 +1508,7 @@ int sdlog2_thread_main(int argc, char *argv[])
 	 * set error flag instead */
 	bool err_flag = false;
 
-	while ((ch = getopt(argc, argv, "r:b:eatx")) != EOF) {
+	while ((ch = getopt(argc, argv, "r:b:eatxpszk:i")) != EOF) {
 		switch (ch) {
 		case 'r': {
 				unsigned long r = strtoul(optarg, NULL, 10);
@@ -828,6 +1548,31 @@ int sdlog2_thread_main(int argc, char *argv[])
 			_extended_logging = true;
 			break;
 
+		case 'i':
+			log_imu_batches = true;
+			break;
+
+		case 'p':
+			log_on_publication = true;
+			break;
+
+		case 's':
+			log_aligned_writes = true;
+			break;
+
+		case 'z':
+			log_compress = true;
+			break;
+
+		case 'k': {
+				unsigned long s = strtoul(optarg, NULL, 10);
+
+				if (s > 0) {
+					blackbox_size = 1024 * s;
+				}
+			}
+			break;
+
 		case '?':
 			if (optopt == 'c') {
 				warnx("option -%c requires an argument", optopt);
@@ -852,6 +1597,18 @@ int sdlog2_thread_main(int argc, char *argv[])
 		sdlog2_usage(NULL);
 	}
 
+	if (blackbox_size > 0) {
+		if (blackbox_init(&blackbox, blackbox_size) == OK) {
+			blackbox_enabled = true;
+			/* recording at full rate needs to wake on every publication */
+			log_on_publication = true;
+			warnx("black box size: %i bytes", blackbox_size);
+
+		} else {
+			warnx("can't allocate black box, disabled");
+		}
+	}
+
 	gps_time = 0;
 
 	/* interpret logging params */
@@ -956,6 +1713,10 @@ int sdlog2_thread_main(int argc, char *argv[])
 		struct satellite_info_s sat_info;
 		struct wind_estimate_s wind_estimate;
 		struct encoders_s encoders;
+		struct perf_report_s perf_report;
+		struct io_link_status_s io_link_status;
+		struct accel_report accel;
+		struct gyro_report gyro;
 	} buf;
 
 	memset(&buf, 0, sizeof(buf));
@@ -966,6 +1727,8 @@ int sdlog2_thread_main(int argc, char *argv[])
 		LOG_PACKET_HEADER;
 		union {
 			struct log_TIME_s log_TIME;
+			struct log_SYNC_s log_SYNC;
+			struct log_LSTA_s log_LSTA;
 			struct log_ATT_s log_ATT;
 			struct log_ATSP_s log_ATSP;
 			struct log_IMU_s log_IMU;
@@ -999,6 +1762,9 @@ int sdlog2_thread_main(int argc, char *argv[])
 			struct log_TECS_s log_TECS;
 			struct log_WIND_s log_WIND;
 			struct log_ENCD_s log_ENCD;
+			struct log_PERF_s log_PERF;
+			struct log_IMUB_s log_IMUB;
+			struct log_IOLK_s log_IOLK;
 		} body;
 	} log_msg = {
 		LOG_PACKET_HEADER_INIT(0)
@@ -1006,6 +1772,19 @@ int sdlog2_thread_main(int argc, char *argv[])
 #pragma pack(pop)
 	memset(&log_msg.body, 0, sizeof(log_msg.body));
 
+	/* raw topic message buffer: header + topic struct */
+	static uint8_t log_topic_msg[LOG_PACKET_HEADER_LEN + LOG_TOPIC_SIZE_MAX] = { HEAD_BYTE1, HEAD_BYTE2 };
+
+	/* time stamp message for the black box, the main log_msg is only used while logging */
+#pragma pack(push, 1)
+	struct {
+		LOG_PACKET_HEADER;
+		struct log_TIME_s body;
+	} log_msg_TIME = {
+		LOG_PACKET_HEADER_INIT(LOG_TIME_MSG)
+	};
+#pragma pack(pop)
+
 	struct {
 		int cmd_sub;
 		int status_sub;
@@ -1037,6 +1816,10 @@ int sdlog2_thread_main(int argc, char *argv[])
 		int servorail_status_sub;
 		int wind_sub;
 		int encoders_sub;
+		int perf_report_sub;
+		int io_link_status_sub;
+		int accel_raw_sub;
+		int gyro_raw_sub;
 	} subs;
 
 	subs.cmd_sub = orb_subscribe(ORB_ID(vehicle_command));
@@ -1069,9 +1852,29 @@ int sdlog2_thread_main(int argc, char *argv[])
 	/* we need to rate-limit wind, as we do not need the full update rate */
 	orb_set_interval(subs.wind_sub, 90);
 	subs.encoders_sub = orb_subscribe(ORB_ID(encoders));
-
-	/* add new topics HERE */
-
+	subs.perf_report_sub = orb_subscribe(ORB_ID(perf_report));
+	subs.io_link_status_sub = orb_subscribe(ORB_ID(io_link_status));
+
+	/* the raw IMU topics are queued, the samples are drained on every pass, no need to poll them */
+	subs.accel_raw_sub = log_imu_batches ? orb_subscribe(ORB_ID(sensor_accel)) : -1;
+	subs.gyro_raw_sub = log_imu_batches ? orb_subscribe(ORB_ID(sensor_gyro)) : -1;
+	struct log_IMUB_s accel_batch;
+	struct log_IMUB_s gyro_batch;
+	memset(&accel_batch, 0, sizeof(accel_batch));
+	memset(&gyro_batch, 0, sizeof(gyro_batch));
+
+	/* add new topics HERE, or to sdlog2_topics.h to log them as raw structs */
+	log_topics_subscribe();
+
+	/* black box triggers */
+	int blackbox_estimator_sub = -1;
+	uint8_t blackbox_estimator_flags = 0;
+	bool blackbox_armed = false;
+	bool blackbox_arming_error = false;
+
+	if (blackbox_enabled) {
+		blackbox_estimator_sub = orb_subscribe(ORB_ID(estimator_status));
+	}
 
 	for (int i = 0; i < TELEMETRY_STATUS_ORB_ID_NUM; i++) {
 		subs.telemetry_subs[i] = orb_subscribe(telemetry_status_orb_id[i]);
@@ -1081,6 +1884,81 @@ int sdlog2_thread_main(int argc, char *argv[])
 		subs.sat_info_sub = orb_subscribe(ORB_ID(satellite_info));
 	}
 
+	/*
+	 * In event-driven mode the loop wakes whenever a topic is published,
+	 * and each topic is rate-limited on its own so fast topics are logged
+	 * at full rate while slow ones cost almost nothing. The management
+	 * and black box topics come first, they are the only ones waited on
+	 * while not logging.
+	 */
+	struct pollfd fds[LOG_POLL_FDS_MAX];
+	unsigned fds_count = 0;
+	unsigned fds_idle_count = 0;
+
+	if (log_on_publication) {
+		log_poll_add(fds, &fds_count, subs.cmd_sub, 0);
+		log_poll_add(fds, &fds_count, subs.status_sub, 0);
+		log_poll_add(fds, &fds_count, subs.gps_pos_sub, 0);
+
+		/* the black box records while not logging too */
+		for (unsigned i = 0; i < log_topics_num; i++) {
+			if (blackbox_subs[i] >= 0) {
+				log_poll_add(fds, &fds_count, blackbox_subs[i], 0);
+			}
+		}
+
+		fds_idle_count = fds_count;
+
+		log_poll_add(fds, &fds_count, subs.sensor_sub, 0);
+		log_poll_add(fds, &fds_count, subs.att_sub, 0);
+		log_poll_add(fds, &fds_count, subs.att_sp_sub, 0);
+		log_poll_add(fds, &fds_count, subs.rates_sp_sub, 0);
+		log_poll_add(fds, &fds_count, subs.act_outputs_sub, 0);
+		log_poll_add(fds, &fds_count, subs.act_controls_sub, 0);
+		log_poll_add(fds, &fds_count, subs.local_pos_sub, 0);
+		log_poll_add(fds, &fds_count, subs.local_pos_sp_sub, 20);
+		log_poll_add(fds, &fds_count, subs.global_pos_sub, 20);
+		log_poll_add(fds, &fds_count, subs.triplet_sub, 100);
+		log_poll_add(fds, &fds_count, subs.vicon_pos_sub, 0);
+		log_poll_add(fds, &fds_count, subs.vision_pos_sub, 0);
+		log_poll_add(fds, &fds_count, subs.flow_sub, 0);
+		log_poll_add(fds, &fds_count, subs.rc_sub, 20);
+		log_poll_add(fds, &fds_count, subs.airspeed_sub, 20);
+		log_poll_add(fds, &fds_count, subs.esc_sub, 50);
+		log_poll_add(fds, &fds_count, subs.global_vel_sp_sub, 20);
+		log_poll_add(fds, &fds_count, subs.battery_sub, 100);
+		log_poll_add(fds, &fds_count, subs.range_finder_sub, 0);
+		log_poll_add(fds, &fds_count, subs.estimator_status_sub, 50);
+		log_poll_add(fds, &fds_count, subs.tecs_status_sub, 20);
+		log_poll_add(fds, &fds_count, subs.system_power_sub, 100);
+		log_poll_add(fds, &fds_count, subs.servorail_status_sub, 100);
+		log_poll_add(fds, &fds_count, subs.wind_sub, 90);
+		log_poll_add(fds, &fds_count, subs.encoders_sub, 0);
+		log_poll_add(fds, &fds_count, subs.perf_report_sub, 0);
+		log_poll_add(fds, &fds_count, subs.io_link_status_sub, 0);
+
+		for (int i = 0; i < TELEMETRY_STATUS_ORB_ID_NUM; i++) {
+			log_poll_add(fds, &fds_count, subs.telemetry_subs[i], 500);
+		}
+
+		if (_extended_logging) {
+			log_poll_add(fds, &fds_count, subs.sat_info_sub, 500);
+		}
+
+		for (unsigned i = 0; i < log_topics_num; i++) {
+			if (log_topic_subs[i] >= 0) {
+				log_poll_add(fds, &fds_count, log_topic_subs[i], log_topics[i].interval);
+			}
+		}
+
+	} else {
+		for (unsigned i = 0; i < log_topics_num; i++) {
+			if (log_topic_subs[i] >= 0 && log_topics[i].interval > 0) {
+				orb_set_interval(log_topic_subs[i], log_topics[i].interval);
+			}
+		}
+	}
+
 	/* close non-needed fd's */
 
 	/* close stdin */
@@ -1088,11 +1966,13 @@ int sdlog2_thread_main(int argc, char *argv[])
 	/* close stdout */
 	close(1);
 
+	perf_written = perf_alloc(PC_COUNT, "sdlog2_written");
+	perf_dropped = perf_alloc(PC_COUNT, "sdlog2_dropped");
+
 	thread_running = true;
 
 	/* initialize thread synchronization */
-	pthread_mutex_init(&logbuffer_mutex, NULL);
-	pthread_cond_init(&logbuffer_cond, NULL);
+	sem_init(&logwriter_sem, 0, 0);
 
 	/* track changes in sensor_combined topic */
 	hrt_abstime gyro_timestamp = 0;
@@ -1107,6 +1987,9 @@ int sdlog2_thread_main(int argc, char *argv[])
 	hrt_abstime accelerometer2_timestamp = 0;
 	hrt_abstime magnetometer2_timestamp = 0;
 
+	/* time the last sync marker was written */
+	hrt_abstime last_sync_time = 0;
+
 	/* initialize calculated mean SNR */
 	float snr_mean = 0.0f;
 
@@ -1123,10 +2006,20 @@ int sdlog2_thread_main(int argc, char *argv[])
 	}
 
 	while (!main_thread_should_exit) {
-		usleep(sleep_delay);
+		if (log_on_publication) {
+			/* wait for the next publication, but come back regularly to check for exit */
+			poll(fds, logging_enabled ? fds_count : fds_idle_count, 100);
+
+		} else {
+			usleep(sleep_delay);
+		}
 
 		/* --- VEHICLE COMMAND - LOG MANAGEMENT --- */
-		if (copy_if_updated(ORB_ID(vehicle_command), subs.cmd_sub, &buf.cmd)) {
+		/* commands are queued, handle every one received since the last cycle */
+		bool cmd_updated;
+
+		while (orb_check(subs.cmd_sub, &cmd_updated) == 0 && cmd_updated) {
+			orb_copy_queued(ORB_ID(vehicle_command), subs.cmd_sub, &buf.cmd, NULL);
 			handle_command(&buf.cmd);
 		}
 
@@ -1137,6 +2030,17 @@ int sdlog2_thread_main(int argc, char *argv[])
 			if (log_when_armed) {
 				handle_status(&buf_status);
 			}
+
+			/* disarming with a failure is worth a black box dump */
+			bool armed = buf_status.arming_state == ARMING_STATE_ARMED || buf_status.arming_state == ARMING_STATE_ARMED_ERROR;
+
+			if (blackbox_armed && !armed && (buf_status.failsafe || blackbox_arming_error ||
+							 buf_status.arming_state == ARMING_STATE_STANDBY_ERROR)) {
+				blackbox_trigger("disarmed with failure");
+			}
+
+			blackbox_armed = armed;
+			blackbox_arming_error = (buf_status.arming_state == ARMING_STATE_ARMED_ERROR);
 		}
 
 		/* --- GPS POSITION - LOG MANAGEMENT --- */
@@ -1146,17 +2050,103 @@ int sdlog2_thread_main(int argc, char *argv[])
 			gps_time = buf_gps_pos.time_gps_usec;
 		}
 
+		/* --- BLACK BOX --- */
+		if (blackbox_enabled && !blackbox_busy) {
+			bool time_written = false;
+
+			for (unsigned i = 0; i < log_topics_num; i++) {
+				if (blackbox_subs[i] >= 0 &&
+				    copy_if_updated(log_topics[i].meta, blackbox_subs[i], &log_topic_msg[LOG_PACKET_HEADER_LEN])) {
+					if (!time_written) {
+						/* group the samples like in the log */
+						log_msg_TIME.body.t = hrt_absolute_time();
+						blackbox_write(&blackbox, &log_msg_TIME, sizeof(log_msg_TIME));
+						time_written = true;
+					}
+
+					log_topic_msg[2] = LOG_TOPIC_MSG_BASE + i;
+					blackbox_write(&blackbox, log_topic_msg, LOG_PACKET_HEADER_LEN + log_topics[i].meta->o_size);
+				}
+			}
+
+			/* estimator resets show up as NaN states or timeouts */
+			if (copy_if_updated(ORB_ID(estimator_status), blackbox_estimator_sub, &buf.estimator_status)) {
+				uint8_t flags = buf.estimator_status.nan_flags | buf.estimator_status.timeout_flags;
+
+				if (flags != 0 && blackbox_estimator_flags == 0) {
+					blackbox_trigger("estimator reset");
+				}
+
+				blackbox_estimator_flags = flags;
+			}
+
+			if (blackbox_trigger_time != 0 && hrt_elapsed_time(&blackbox_trigger_time) > BLACKBOX_POST_TRIGGER) {
+				blackbox_trigger_time = 0;
+				blackbox_busy = true;
+
+				pthread_t blackbox_pthread;
+				pthread_attr_t blackbox_attr;
+				pthread_attr_init(&blackbox_attr);
+
+				struct sched_param param;
+				/* low priority, as this is expensive disk I/O */
+				param.sched_priority = SCHED_PRIORITY_DEFAULT - 40;
+				(void)pthread_attr_setschedparam(&blackbox_attr, &param);
+
+				pthread_attr_setstacksize(&blackbox_attr, 2048);
+
+				if (pthread_create(&blackbox_pthread, &blackbox_attr, blackbox_thread, NULL) == 0) {
+					pthread_detach(blackbox_pthread);
+
+				} else {
+					warnx("error creating black box thread");
+					blackbox_busy = false;
+				}
+
+				pthread_attr_destroy(&blackbox_attr);
+			}
+		}
+
 		if (!logging_enabled) {
 			continue;
 		}
 
-		pthread_mutex_lock(&logbuffer_mutex);
-
 		/* write time stamp message */
 		log_msg.msg_type = LOG_TIME_MSG;
 		log_msg.body.log_TIME.t = hrt_absolute_time();
 		LOGBUFFER_WRITE_AND_COUNT(TIME);
 
+		/* write a sync marker once per second, the writer thread puts its file offset into the index */
+		if (log_msg.body.log_TIME.t >= last_sync_time + 1000000) {
+			unsigned long pos = log_bytes_queued;
+			last_sync_time = log_msg.body.log_TIME.t;
+
+			log_msg.msg_type = LOG_SYNC_MSG;
+			memcpy(log_msg.body.log_SYNC.magic, LOG_SYNC_MAGIC, sizeof(log_msg.body.log_SYNC.magic));
+			log_msg.body.log_SYNC.t = last_sync_time;
+			LOGBUFFER_WRITE_AND_COUNT(SYNC);
+
+			if (log_bytes_queued != pos && log_sync_head - log_sync_tail < LOG_SYNC_FIFO_SIZE) {
+				log_sync_fifo[log_sync_head % LOG_SYNC_FIFO_SIZE].t = last_sync_time;
+				log_sync_fifo[log_sync_head % LOG_SYNC_FIFO_SIZE].pos = pos;
+				/* entry must be complete before the writer can see it */
+				__sync_synchronize();
+				log_sync_head++;
+			}
+
+			/* running totals by message type, rates are the difference between two of them */
+			for (unsigned i = 0; i < 256; i++) {
+				if (log_msg_counts[i] > 0 || log_msg_drops[i] > 0) {
+					log_msg.msg_type = LOG_LSTA_MSG;
+					log_msg.body.log_LSTA.type = i;
+					log_msg.body.log_LSTA.msgs = log_msg_counts[i];
+					log_msg.body.log_LSTA.bytes = log_msg_bytes[i];
+					log_msg.body.log_LSTA.drops = log_msg_drops[i];
+					LOGBUFFER_WRITE_AND_COUNT(LSTA);
+				}
+			}
+		}
+
 		/* --- VEHICLE STATUS --- */
 		if (status_updated) {
 			log_msg.msg_type = LOG_STAT_MSG;
@@ -1681,25 +2671,109 @@ int sdlog2_thread_main(int argc, char *argv[])
 			LOGBUFFER_WRITE_AND_COUNT(ENCD);
 		}
 
-		/* signal the other thread new data, but not yet unlock */
-		if (logbuffer_count(&lb) > MIN_BYTES_TO_WRITE) {
-			/* only request write if several packets can be written at once */
-			pthread_cond_signal(&logbuffer_cond);
+		/* --- PERF COUNTERS --- */
+		if (copy_if_updated(ORB_ID(perf_report), subs.perf_report_sub, &buf.perf_report)) {
+			log_msg.msg_type = LOG_PERF_MSG;
+
+			for (unsigned i = 0; i < buf.perf_report.count && i < PERF_REPORT_MAX; i++) {
+				const struct perf_report_counter_s *counter = &buf.perf_report.counters[i];
+				memcpy(log_msg.body.log_PERF.name, counter->name, sizeof(log_msg.body.log_PERF.name));
+				log_msg.body.log_PERF.type = counter->type;
+				log_msg.body.log_PERF.count = counter->count;
+				log_msg.body.log_PERF.avg = counter->avg;
+				log_msg.body.log_PERF.min = counter->min;
+				log_msg.body.log_PERF.max = counter->max;
+				log_msg.body.log_PERF.p99 = counter->p99;
+				LOGBUFFER_WRITE_AND_COUNT(PERF);
+			}
+		}
+
+		/* --- IO LINK STATISTICS --- */
+		if (copy_if_updated(ORB_ID(io_link_status), subs.io_link_status_sub, &buf.io_link_status)) {
+			log_msg.msg_type = LOG_IOLK_MSG;
+			log_msg.body.log_IOLK.txns = buf.io_link_status.transactions;
+			log_msg.body.log_IOLK.retries = buf.io_link_status.retries;
+			log_msg.body.log_IOLK.crc_errors = buf.io_link_status.crc_errors;
+			log_msg.body.log_IOLK.timeouts = buf.io_link_status.timeouts;
+			log_msg.body.log_IOLK.short_packets = buf.io_link_status.short_packets;
+			log_msg.body.log_IOLK.uart_errors = buf.io_link_status.uart_errors;
+			log_msg.body.log_IOLK.dma_errors = buf.io_link_status.dma_errors;
+			log_msg.body.log_IOLK.protocol_errors = buf.io_link_status.protocol_errors;
+			memcpy(log_msg.body.log_IOLK.latency, buf.io_link_status.latency, sizeof(log_msg.body.log_IOLK.latency));
+			log_msg.body.log_IOLK.latency_max = buf.io_link_status.latency_max_us;
+			log_msg.body.log_IOLK.utilization = buf.io_link_status.utilization;
+			LOGBUFFER_WRITE_AND_COUNT(IOLK);
 		}
 
-		/* unlock, now the writer thread may run */
-		pthread_mutex_unlock(&logbuffer_mutex);
+		/* --- RAW IMU BATCHES --- */
+		if (log_imu_batches) {
+			bool raw_updated;
+			unsigned dropped;
+
+			while (orb_check(subs.accel_raw_sub, &raw_updated) == 0 && raw_updated &&
+			       orb_copy_queued(ORB_ID(sensor_accel), subs.accel_raw_sub, &buf.accel, &dropped) == OK) {
+				if (log_imu_batch_add(&accel_batch, buf.accel.timestamp, buf.accel.x_raw, buf.accel.y_raw,
+						      buf.accel.z_raw, buf.accel.scaling, dropped, &log_msg.body.log_IMUB)) {
+					log_msg.msg_type = LOG_ACCB_MSG;
+					LOGBUFFER_WRITE_AND_COUNT(IMUB);
+				}
+			}
+
+			while (orb_check(subs.gyro_raw_sub, &raw_updated) == 0 && raw_updated &&
+			       orb_copy_queued(ORB_ID(sensor_gyro), subs.gyro_raw_sub, &buf.gyro, &dropped) == OK) {
+				if (log_imu_batch_add(&gyro_batch, buf.gyro.timestamp, buf.gyro.x_raw, buf.gyro.y_raw,
+						      buf.gyro.z_raw, buf.gyro.scaling, dropped, &log_msg.body.log_IMUB)) {
+					log_msg.msg_type = LOG_GYRB_MSG;
+					LOGBUFFER_WRITE_AND_COUNT(IMUB);
+				}
+			}
+		}
+
+		/* --- RAW TOPICS --- */
+		/* copied straight behind the packet header, no per-field work */
+		for (unsigned i = 0; i < log_topics_num; i++) {
+			if (log_topic_subs[i] >= 0 &&
+			    copy_if_updated(log_topics[i].meta, log_topic_subs[i], &log_topic_msg[LOG_PACKET_HEADER_LEN])) {
+				unsigned size = LOG_PACKET_HEADER_LEN + log_topics[i].meta->o_size;
+				log_topic_msg[2] = LOG_TOPIC_MSG_BASE + i;
+
+				if (logbuffer_write(&lb, log_topic_msg, size)) {
+					log_msgs_written++;
+					perf_count(perf_written);
+					log_msg_counts[log_topic_msg[2]]++;
+					log_msg_bytes[log_topic_msg[2]] += size;
+					log_bytes_queued += size;
+
+				} else {
+					log_msgs_skipped++;
+					perf_count(perf_dropped);
+					log_msg_drops[log_topic_msg[2]]++;
+				}
+			}
+		}
+
+		/* only wake the writer if it is idle and several packets can be written at once */
+		__sync_synchronize();
+
+		if (logwriter_waiting && logbuffer_count(&lb) > MIN_BYTES_TO_WRITE) {
+			logwriter_waiting = false;
+			sem_post(&logwriter_sem);
+		}
 	}
 
 	if (logging_enabled) {
 		sdlog2_stop_log();
 	}
 
-	pthread_mutex_destroy(&logbuffer_mutex);
-	pthread_cond_destroy(&logbuffer_cond);
+	sem_destroy(&logwriter_sem);
 
 	free(lb.data);
 
+	perf_free(perf_written);
+	perf_free(perf_dropped);
+	perf_written = NULL;
+	perf_dropped = NULL;
+
 	warnx("exiting");
 
 	thread_running = false;
@@ -1707,6 +2781,41 @@ int sdlog2_thread_main(int argc, char *argv[])
 	return 0;
 }
 
+void log_msg_name(unsigned type, char *name, size_t len)
+{
+	const char *src = "?";
+	size_t src_len = 1;
+
+	for (unsigned i = 0; i < log_formats_num; i++) {
+		if (log_formats[i].type == type) {
+			/* not terminated if all 4 chars are used */
+			src = log_formats[i].name;
+			src_len = sizeof(log_formats[i].name);
+		}
+	}
+
+	for (unsigned i = 0; i < log_long_formats_num; i++) {
+		if (log_long_formats[i].type == type) {
+			src = log_long_formats[i].name;
+			src_len = sizeof(log_long_formats[i].name);
+		}
+	}
+
+	if (type >= LOG_TOPIC_MSG_BASE && type < LOG_TOPIC_MSG_BASE + log_topics_num) {
+		src = log_topics[type - LOG_TOPIC_MSG_BASE].name;
+		src_len = strlen(src);
+	}
+
+	size_t n = 0;
+
+	while (n < src_len && n < len - 1 && src[n] != '\0') {
+		name[n] = src[n];
+		n++;
+	}
+
+	name[n] = '\0';
+}
+
 void sdlog2_status()
 {
 	float kibibytes = log_bytes_written / 1024.0f;
@@ -1715,6 +2824,40 @@ void sdlog2_status()
 
 	warnx("wrote %lu msgs, %4.2f MiB (average %5.3f KiB/s), skipped %lu msgs", log_msgs_written, (double)mebibytes, (double)(kibibytes / seconds), log_msgs_skipped);
 	warnx("extended logging: %s", (_extended_logging) ? "ON" : "OFF");
+	if (log_compress && log_bytes_written > 0) {
+		warnx("compression: ON, ratio %4.2f", (double)log_bytes_raw / (double)log_bytes_written);
+	}
+
+	warnx("aligned writes: %s, write latency max %llu us", (log_aligned_writes) ? "ON" : "OFF",
+	      (unsigned long long)write_latency_max);
+
+	for (unsigned i = 0; i < WRITE_LATENCY_BUCKETS; i++) {
+		if (i < WRITE_LATENCY_BUCKETS - 1) {
+			warnx("  < %6u us: %lu", write_latency_bounds[i], write_latency_hist[i]);
+
+		} else {
+			warnx(" >= %6u us: %lu", write_latency_bounds[i - 1], write_latency_hist[i]);
+		}
+	}
+
+	if (seconds > 0.0f) {
+		warnx("type name              msg/s      B/s    drops");
+
+		for (unsigned i = 0; i < 256; i++) {
+			if (log_msg_counts[i] > 0 || log_msg_drops[i] > 0) {
+				char name[17];
+				log_msg_name(i, name, sizeof(name));
+				warnx("%4u %-16s %7.1f %8.1f %8lu", i, name, (double)(log_msg_counts[i] / seconds),
+				      (double)(log_msg_bytes[i] / seconds), (unsigned long)log_msg_drops[i]);
+			}
+		}
+	}
+
+	if (blackbox_enabled) {
+		warnx("black box: %i of %i bytes, %u dumps%s", blackbox.fill, blackbox.size, blackbox_dumps,
+		      blackbox_busy ? ", writing" : "");
+	}
+
 	mavlink_log_info(mavlink_fd, "[sdlog2] wrote %lu msgs, skipped %lu msgs", log_msgs_written, log_msgs_skipped);
 }
 
@@ -1782,6 +2925,9 @@ void handle_command(struct vehicle_command_s *cmd)
 
 		} else if (param == 0)	{
 			sdlog2_stop_log();
+
+		} else if (param == 2) {
+			blackbox_trigger("command");
 		}
 
 		break;
@@ -61,6 +61,12 @@ Format characters in the format string for binary log messages
 
   q   : int64_t
   Q   : uint64_t
+
+Raw topic messages (see struct log_topic_format_s) carry a uORB topic
+struct as is. Their format string may also use
+  x   : padding byte
+and every character may be preceded by a repeat count, e.g. "Q8f". A
+repeated field has a single label, readers number it Label0, Label1, ...
  */
 
 #ifndef SDLOG2_FORMAT_H_
@@ -100,6 +106,21 @@ struct log_format_s {
 	}
 
 #define LOG_FORMAT_MSG	  0x80
+#define LOG_BLOCK_MSG	  0xF0	// compressed block of messages, see logcompress.h
+#define LOG_TOPIC_FORMAT_MSG 0xF1	// layout of a raw topic message
+
+#define LOG_TOPIC_MSG_BASE 0xC0	// message type of the first raw topic
+#define LOG_TOPIC_MSG_MAX  48	// number of message types for raw topics
+
+#pragma pack(push, 1)
+struct log_topic_format_s {
+	uint8_t type;
+	uint16_t size;		// topic size, without header
+	char name[16];
+	char format[32];
+	char labels[128];
+};
+#pragma pack(pop)
 
 #define LOG_PACKET_SIZE(_name)	LOG_PACKET_HEADER_LEN + sizeof(struct log_##_name##_s)
 
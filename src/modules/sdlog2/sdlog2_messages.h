@@ -416,6 +416,52 @@ struct log_ENCD_s {
 	float vel1;
 };
 
+/* --- ACCB, GYRB - BATCH OF RAW ACCEL / GYRO SAMPLES --- */
+/* described by a TOPIC_FORMAT message, the layout does not fit into a FORMAT message */
+#define LOG_ACCB_MSG 40
+#define LOG_GYRB_MSG 41
+#define LOG_IMUB_SAMPLES 8
+struct log_IMUB_s {
+	uint64_t t;		// timestamp of the first sample
+	uint8_t count;		// number of valid samples
+	uint8_t lost;		// samples lost before this batch, saturated
+	uint16_t dt[LOG_IMUB_SAMPLES];	// sample time relative to t in us
+	int16_t x[LOG_IMUB_SAMPLES];	// raw sensor values, multiply by scale for SI units
+	int16_t y[LOG_IMUB_SAMPLES];
+	int16_t z[LOG_IMUB_SAMPLES];
+	float scale;
+};
+
+/* --- PERF - PERFORMANCE COUNTER SELECTED WITH 'perf publish' --- */
+#define LOG_PERF_MSG 42
+struct log_PERF_s {
+	char name[16];
+	uint8_t type;
+	uint32_t count;
+	uint32_t avg;
+	uint32_t min;
+	uint32_t max;
+	uint32_t p99;
+};
+
+/* --- IOLK - FMU TO PX4IO LINK STATISTICS, TOTALS SINCE BOOT --- */
+/* described by a TOPIC_FORMAT message, the layout does not fit into a FORMAT message */
+#define LOG_IOLK_MSG 43
+#define LOG_IOLK_BUCKETS 8
+struct log_IOLK_s {
+	uint32_t txns;
+	uint32_t retries;
+	uint32_t crc_errors;
+	uint32_t timeouts;
+	uint32_t short_packets;
+	uint32_t uart_errors;
+	uint32_t dma_errors;
+	uint32_t protocol_errors;
+	uint32_t latency[LOG_IOLK_BUCKETS];	// transactions up to 250, 500, 750, 1000, 1500, 2000, 5000 us and longer
+	uint16_t latency_max;	// us
+	float utilization;	// percent since the previous message
+};
+
 
 /********** SYSTEM MESSAGES, ID > 0x80 **********/
 
@@ -439,6 +485,47 @@ struct log_PARM_s {
 	float value;
 };
 
+/* --- SYNC - SYNC MARKER, WRITTEN ONCE PER SECOND --- */
+#define LOG_SYNC_MSG 132
+#define LOG_SYNC_MAGIC "SYNC"
+struct log_SYNC_s {
+	char magic[4];
+	uint64_t t;
+};
+
+/* --- IDX - INDEX ENTRY, FILE OFFSET OF A SYNC MARKER --- */
+#define LOG_IDX_MSG 133
+struct log_IDX_s {
+	uint64_t t;
+	uint32_t offset;
+};
+
+/* --- CNT - INDEX, NUMBER OF MESSAGES OF A TYPE --- */
+#define LOG_CNT_MSG 134
+struct log_CNT_s {
+	uint8_t type;
+	uint32_t count;
+};
+
+/* --- IDXT - INDEX TRAILER, LAST MESSAGE OF A CLEANLY CLOSED LOG --- */
+#define LOG_IDXT_MSG 135
+#define LOG_IDXT_MAGIC "IDXT"
+struct log_IDXT_s {
+	char magic[4];
+	uint32_t start;		// file offset of the first IDX message
+	uint16_t entries;	// number of IDX messages
+	uint16_t types;		// number of CNT messages following them
+};
+
+/* --- LSTA - LOG BANDWIDTH OF A MESSAGE TYPE, TOTALS SINCE LOG START --- */
+#define LOG_LSTA_MSG 136
+struct log_LSTA_s {
+	uint8_t type;
+	uint32_t msgs;
+	uint32_t bytes;
+	uint32_t drops;		// messages that did not fit into the log buffer
+};
+
 #pragma pack(pop)
 
 /* construct list of all message formats */
@@ -482,14 +569,29 @@ static const struct log_format_s log_formats[] = {
 	LOG_FORMAT(TECS, "fffffffffffffB",	"ASP,AF,FSP,F,FF,AsSP,AsF,AsDSP,AsD,TERSP,TER,EDRSP,EDR,M"),
 	LOG_FORMAT(WIND, "ffff",	"X,Y,CovX,CovY"),
 	LOG_FORMAT(ENCD, "qfqf",	"cnt0,vel0,cnt1,vel1"),
+	LOG_FORMAT(PERF, "NBIIIII",	"Name,Type,Count,Avg,Min,Max,P99"),
 
 	/* system-level messages, ID >= 0x80 */
 	/* FMT: don't write format of format message, it's useless */
 	LOG_FORMAT(TIME, "Q", "StartTime"),
 	LOG_FORMAT(VER, "NZ", "Arch,FwGit"),
-	LOG_FORMAT(PARM, "Nf", "Name,Value")
+	LOG_FORMAT(PARM, "Nf", "Name,Value"),
+	LOG_FORMAT(SYNC, "nQ", "Magic,Time"),
+	LOG_FORMAT(IDX, "QI", "Time,Offset"),
+	LOG_FORMAT(CNT, "BI", "Type,Count"),
+	LOG_FORMAT(IDXT, "nIHH", "Magic,Start,Entries,Types"),
+	LOG_FORMAT(LSTA, "BIII", "Type,Msgs,Bytes,Drops")
 };
 
 static const unsigned log_formats_num = sizeof(log_formats) / sizeof(log_formats[0]);
 
+/* messages with a layout too long for a FORMAT message, written as TOPIC_FORMAT messages */
+static const struct log_topic_format_s log_long_formats[] = {
+	{ LOG_ACCB_MSG, sizeof(struct log_IMUB_s), "ACCB", "QBB8H8h8h8hf", "Time,Count,Lost,Dt,X,Y,Z,Scale" },
+	{ LOG_GYRB_MSG, sizeof(struct log_IMUB_s), "GYRB", "QBB8H8h8h8hf", "Time,Count,Lost,Dt,X,Y,Z,Scale" },
+	{ LOG_IOLK_MSG, sizeof(struct log_IOLK_s), "IOLK", "IIIIIIII8IHf", "Txn,Retry,CRC,Timeout,Short,UART,DMA,Proto,Lat,LatMax,Util" },
+};
+
+static const unsigned log_long_formats_num = sizeof(log_long_formats) / sizeof(log_long_formats[0]);
+
 #endif /* SDLOG2_MESSAGES_H_ */
@@ -0,0 +1,99 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+
+/**
+ * @file sdlog2_topics.h
+ *
+ * Topics logged as raw uORB structs.
+ *
+ * Adding a topic here is all that is needed to log it: the struct is copied
+ * into the log as is and its layout is described once in the log header.
+ * The format string has to match the struct including padding, topics
+ * whose format does not add up to the topic size are not logged.
+ *
+ * Topics flagged LOG_TOPIC_BLACKBOX are recorded at full rate into the
+ * pre-trigger ring when the black box is enabled.
+ */
+
+#ifndef SDLOG2_TOPICS_H_
+#define SDLOG2_TOPICS_H_
+
+#include <uORB/uORB.h>
+#include <drivers/drv_accel.h>
+#include <drivers/drv_gyro.h>
+#include <uORB/topics/actuator_armed.h>
+#include <uORB/topics/actuator_controls.h>
+#include <uORB/topics/actuator_outputs.h>
+#include <uORB/topics/manual_control_setpoint.h>
+#include <uORB/topics/vehicle_control_mode.h>
+
+#include "sdlog2_format.h"
+
+#define LOG_TOPIC_LOG		(1 << 0)	// write to the log
+#define LOG_TOPIC_BLACKBOX	(1 << 1)	// record into the black box
+
+struct log_topic_s {
+	orb_id_t meta;
+	const char *name;
+	unsigned flags;
+	unsigned interval;		// minimum interval between samples in the log in ms, 0 for every update
+	const char *format;
+	const char *labels;
+};
+
+#define LOG_TOPIC(_topic, _name, _flags, _interval, _format, _labels) { \
+		.meta = ORB_ID(_topic), \
+			.name = _name, \
+				.flags = _flags, \
+					.interval = _interval, \
+						.format = _format, \
+							.labels = _labels \
+	}
+
+static const struct log_topic_s log_topics[] = {
+	LOG_TOPIC(actuator_armed, "ARMD", LOG_TOPIC_LOG, 0, "QBBBB4x", "Time,Armed,Ready,Lockdown,Failsafe"),
+	LOG_TOPIC(vehicle_control_mode, "CTLM", LOG_TOPIC_LOG, 0, "QBBBBBBBBBBBBBB2x",
+		  "Time,Armed,ExtOvr,HIL,Manual,Auto,Offb,Rates,Att,Force,Vel,Pos,Alt,Climb,Term"),
+	LOG_TOPIC(manual_control_setpoint, "MANC", LOG_TOPIC_LOG, 20, "Qffffffffffiiiiii",
+		  "Time,X,Y,Z,R,Flaps,Aux1,Aux2,Aux3,Aux4,Aux5,Mode,Return,Posctl,Loiter,Acro,Offb"),
+	LOG_TOPIC(actuator_controls_1, "ATC1", LOG_TOPIC_LOG, 0, "Q8f", "Time,Ctrl"),
+	LOG_TOPIC(sensor_accel, "ACC", LOG_TOPIC_BLACKBOX, 0, "QQffffffhhhh",
+		  "Time,Err,X,Y,Z,Temp,Range,Scale,XRaw,YRaw,ZRaw,TempRaw"),
+	LOG_TOPIC(sensor_gyro, "GYR", LOG_TOPIC_BLACKBOX, 0, "QQffffffhhhh",
+		  "Time,Err,X,Y,Z,Temp,Range,Scale,XRaw,YRaw,ZRaw,TempRaw"),
+	LOG_TOPIC(actuator_controls_0, "ATC0", LOG_TOPIC_BLACKBOX, 0, "Q8f", "Time,Ctrl"),
+	LOG_TOPIC(actuator_outputs_0, "OUT", LOG_TOPIC_BLACKBOX, 0, "Q16fI4x", "Time,Out,Num"),
+};
+
+static const unsigned log_topics_num = sizeof(log_topics) / sizeof(log_topics[0]);
+
+#endif /* SDLOG2_TOPICS_H_ */
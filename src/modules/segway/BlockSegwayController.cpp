@@ -4,6 +4,9 @@ void BlockSegwayController::update() {
 	// wait for a sensor update, check for exit condition every 100 ms
 	if (poll(&_attPoll, 1, 100) < 0) return; // poll error
 
+	// time the controller, not the wait
+	control::BlockPerfScope perf(this);
+
 	uint64_t newTimeStamp = hrt_absolute_time();
 	float dt = (newTimeStamp - _timeStamp) / 1.0e6f;
 	_timeStamp = newTimeStamp;
@@ -15,6 +15,9 @@ public:
 	{
 		_attPoll.fd = _att.getHandle();
 		_attPoll.events = POLLIN;
+
+		// the block tree is complete, run updates as flat loops
+		plan();
 	}
 	void update();
 private:
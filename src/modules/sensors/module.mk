@@ -39,6 +39,7 @@ MODULE_COMMAND	= sensors
 MODULE_PRIORITY	= "SCHED_PRIORITY_MAX-5"
 
 SRCS		= sensors.cpp \
+		  sensor_voter.cpp \
 		  sensor_params.c
 
 MODULE_STACKSIZE = 1200
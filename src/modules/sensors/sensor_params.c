@@ -190,6 +190,330 @@ PARAM_DEFINE_FLOAT(SENS_ACC_YSCALE, 1.0f);
  */
 PARAM_DEFINE_FLOAT(SENS_ACC_ZSCALE, 1.0f);
 
+/**
+ * Gyro 1 X-axis offset
+ *
+ * Calibration of the second instance, see SENS_GYRO_XOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_GYRO1_XOFF, 0.0f);
+
+/**
+ * Gyro 1 Y-axis offset
+ *
+ * Calibration of the second instance, see SENS_GYRO_YOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_GYRO1_YOFF, 0.0f);
+
+/**
+ * Gyro 1 Z-axis offset
+ *
+ * Calibration of the second instance, see SENS_GYRO_ZOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_GYRO1_ZOFF, 0.0f);
+
+/**
+ * Gyro 1 X-axis scaling factor
+ *
+ * Calibration of the second instance, see SENS_GYRO_XSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_GYRO1_XSCALE, 1.0f);
+
+/**
+ * Gyro 1 Y-axis scaling factor
+ *
+ * Calibration of the second instance, see SENS_GYRO_YSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_GYRO1_YSCALE, 1.0f);
+
+/**
+ * Gyro 1 Z-axis scaling factor
+ *
+ * Calibration of the second instance, see SENS_GYRO_ZSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_GYRO1_ZSCALE, 1.0f);
+
+/**
+ * Gyro 2 X-axis offset
+ *
+ * Calibration of the third instance, see SENS_GYRO_XOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_GYRO2_XOFF, 0.0f);
+
+/**
+ * Gyro 2 Y-axis offset
+ *
+ * Calibration of the third instance, see SENS_GYRO_YOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_GYRO2_YOFF, 0.0f);
+
+/**
+ * Gyro 2 Z-axis offset
+ *
+ * Calibration of the third instance, see SENS_GYRO_ZOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_GYRO2_ZOFF, 0.0f);
+
+/**
+ * Gyro 2 X-axis scaling factor
+ *
+ * Calibration of the third instance, see SENS_GYRO_XSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_GYRO2_XSCALE, 1.0f);
+
+/**
+ * Gyro 2 Y-axis scaling factor
+ *
+ * Calibration of the third instance, see SENS_GYRO_YSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_GYRO2_YSCALE, 1.0f);
+
+/**
+ * Gyro 2 Z-axis scaling factor
+ *
+ * Calibration of the third instance, see SENS_GYRO_ZSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_GYRO2_ZSCALE, 1.0f);
+
+/**
+ * Accelerometer 1 X-axis offset
+ *
+ * Calibration of the second instance, see SENS_ACC_XOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_ACC1_XOFF, 0.0f);
+
+/**
+ * Accelerometer 1 Y-axis offset
+ *
+ * Calibration of the second instance, see SENS_ACC_YOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_ACC1_YOFF, 0.0f);
+
+/**
+ * Accelerometer 1 Z-axis offset
+ *
+ * Calibration of the second instance, see SENS_ACC_ZOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_ACC1_ZOFF, 0.0f);
+
+/**
+ * Accelerometer 1 X-axis scaling factor
+ *
+ * Calibration of the second instance, see SENS_ACC_XSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_ACC1_XSCALE, 1.0f);
+
+/**
+ * Accelerometer 1 Y-axis scaling factor
+ *
+ * Calibration of the second instance, see SENS_ACC_YSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_ACC1_YSCALE, 1.0f);
+
+/**
+ * Accelerometer 1 Z-axis scaling factor
+ *
+ * Calibration of the second instance, see SENS_ACC_ZSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_ACC1_ZSCALE, 1.0f);
+
+/**
+ * Accelerometer 2 X-axis offset
+ *
+ * Calibration of the third instance, see SENS_ACC_XOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_ACC2_XOFF, 0.0f);
+
+/**
+ * Accelerometer 2 Y-axis offset
+ *
+ * Calibration of the third instance, see SENS_ACC_YOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_ACC2_YOFF, 0.0f);
+
+/**
+ * Accelerometer 2 Z-axis offset
+ *
+ * Calibration of the third instance, see SENS_ACC_ZOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_ACC2_ZOFF, 0.0f);
+
+/**
+ * Accelerometer 2 X-axis scaling factor
+ *
+ * Calibration of the third instance, see SENS_ACC_XSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_ACC2_XSCALE, 1.0f);
+
+/**
+ * Accelerometer 2 Y-axis scaling factor
+ *
+ * Calibration of the third instance, see SENS_ACC_YSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_ACC2_YSCALE, 1.0f);
+
+/**
+ * Accelerometer 2 Z-axis scaling factor
+ *
+ * Calibration of the third instance, see SENS_ACC_ZSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_ACC2_ZSCALE, 1.0f);
+
+/**
+ * Magnetometer 1 X-axis offset
+ *
+ * Calibration of the second instance, see SENS_MAG_XOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_MAG1_XOFF, 0.0f);
+
+/**
+ * Magnetometer 1 Y-axis offset
+ *
+ * Calibration of the second instance, see SENS_MAG_YOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_MAG1_YOFF, 0.0f);
+
+/**
+ * Magnetometer 1 Z-axis offset
+ *
+ * Calibration of the second instance, see SENS_MAG_ZOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_MAG1_ZOFF, 0.0f);
+
+/**
+ * Magnetometer 1 X-axis scaling factor
+ *
+ * Calibration of the second instance, see SENS_MAG_XSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_MAG1_XSCALE, 1.0f);
+
+/**
+ * Magnetometer 1 Y-axis scaling factor
+ *
+ * Calibration of the second instance, see SENS_MAG_YSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_MAG1_YSCALE, 1.0f);
+
+/**
+ * Magnetometer 1 Z-axis scaling factor
+ *
+ * Calibration of the second instance, see SENS_MAG_ZSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_MAG1_ZSCALE, 1.0f);
+
+/**
+ * Magnetometer 2 X-axis offset
+ *
+ * Calibration of the third instance, see SENS_MAG_XOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_MAG2_XOFF, 0.0f);
+
+/**
+ * Magnetometer 2 Y-axis offset
+ *
+ * Calibration of the third instance, see SENS_MAG_YOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_MAG2_YOFF, 0.0f);
+
+/**
+ * Magnetometer 2 Z-axis offset
+ *
+ * Calibration of the third instance, see SENS_MAG_ZOFF.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_MAG2_ZOFF, 0.0f);
+
+/**
+ * Magnetometer 2 X-axis scaling factor
+ *
+ * Calibration of the third instance, see SENS_MAG_XSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_MAG2_XSCALE, 1.0f);
+
+/**
+ * Magnetometer 2 Y-axis scaling factor
+ *
+ * Calibration of the third instance, see SENS_MAG_YSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_MAG2_YSCALE, 1.0f);
+
+/**
+ * Magnetometer 2 Z-axis scaling factor
+ *
+ * Calibration of the third instance, see SENS_MAG_ZSCALE.
+ *
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(CAL_MAG2_ZSCALE, 1.0f);
+
 
 /**
  * Differential pressure sensor offset
@@ -214,6 +538,20 @@ PARAM_DEFINE_FLOAT(SENS_DPRES_OFF, 0.0f);
  */
 PARAM_DEFINE_FLOAT(SENS_DPRES_ANSC, 0);
 
+/**
+ * Differential pressure low pass cutoff
+ *
+ * Cutoff frequency of the filter the sensors app applies to the
+ * differential pressure before the airspeed is computed, on top of the
+ * filtering in the driver. Set to 0 to use the driver output directly.
+ *
+ * @unit Hz
+ * @min 0.0
+ * @max 50.0
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_FLOAT(SENS_DPRES_LPF, 0.0f);
+
 /**
  * QNH for barometer
  *
@@ -302,6 +640,35 @@ PARAM_DEFINE_FLOAT(SENS_BOARD_Z_OFF, 0.0f);
  */
 PARAM_DEFINE_INT32(SENS_EXT_MAG_ROT, 0);
 
+/**
+ * IMU integration interval
+ *
+ * The accel and gyro drivers publish the delta velocity and delta angle
+ * integrated over this interval, and only once per interval. 0 publishes
+ * every sample.
+ *
+ * @min 0
+ * @max 20000
+ * @unit microseconds
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_INT32(SENS_IMU_INTV, 0);
+
+/**
+ * Publish sensor_combined
+ *
+ * The sensors app publishes the selected IMU, magnetometer and barometer
+ * as sensor_imu, vehicle_magnetometer and vehicle_air_data, each at the rate
+ * of its sensor. sensor_combined holds all instances of all sensors and is
+ * published at gyro rate, it is kept for the apps that still read it. Set
+ * to 0 if none of the running apps does.
+ *
+ * @min 0
+ * @max 1
+ * @group Sensor Calibration
+ */
+PARAM_DEFINE_INT32(SENS_CMB_PUB, 1);
+
 /**
 * Set usage of external magnetometer
 *
@@ -0,0 +1,220 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2015 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file sensor_voter.cpp
+ *
+ * Selection of a redundant sensor instance, see sensor_voter.h.
+ */
+
+#include <string.h>
+#include <math.h>
+#include <systemlib/err.h>
+
+#include "sensor_voter.h"
+
+/* low pass constant of the mean, the scatter and the error rate, per sample */
+#define FILTER_GAIN		0.02f
+
+/* to replace a healthy selection, a score this much lower is needed */
+#define SWITCH_RATIO		0.3f
+
+/* weight of one driver error per sample in the score, against the scatter */
+#define ERROR_WEIGHT		10.0f
+
+SensorVoter::SensorVoter(uint64_t timeout, float max_deviation) :
+	_timeout(timeout),
+	_max_deviation(max_deviation),
+	_selected(-1),
+	_healthy(0),
+	_failovers(0)
+{
+	memset(_instances, 0, sizeof(_instances));
+}
+
+void
+SensorVoter::put(unsigned instance, uint64_t timestamp, const float value[3], uint64_t error_count)
+{
+	if (instance >= MAX_INSTANCES) {
+		return;
+	}
+
+	Instance &inst = _instances[instance];
+
+	if (!inst.reported) {
+		memcpy(inst.mean, value, sizeof(inst.mean));
+		inst.error_count = error_count;
+		inst.reported = true;
+	}
+
+	if (memcmp(inst.value, value, sizeof(inst.value)) == 0) {
+		inst.same_samples++;
+
+	} else {
+		inst.same_samples = 0;
+	}
+
+	float d2 = 0.0f;
+
+	for (unsigned i = 0; i < 3; i++) {
+		inst.mean[i] += FILTER_GAIN * (value[i] - inst.mean[i]);
+		float d = value[i] - inst.mean[i];
+		d2 += d * d;
+	}
+
+	inst.scatter += FILTER_GAIN * (d2 - inst.scatter);
+
+	float errors = (error_count > inst.error_count) ? (float)(error_count - inst.error_count) : 0.0f;
+	inst.error_rate += FILTER_GAIN * (errors - inst.error_rate);
+	inst.error_count = error_count;
+
+	memcpy(inst.value, value, sizeof(inst.value));
+	inst.timestamp = timestamp;
+}
+
+float
+SensorVoter::score(unsigned instance) const
+{
+	const Instance &inst = _instances[instance];
+
+	return inst.scatter * (1.0f + ERROR_WEIGHT * inst.error_rate);
+}
+
+bool
+SensorVoter::is_healthy(const Instance &inst, uint64_t now) const
+{
+	return inst.reported &&
+	       now < inst.timestamp + _timeout &&
+	       inst.same_samples < STUCK_SAMPLES &&
+	       inst.outlier_updates < OUTLIER_UPDATES;
+}
+
+void
+SensorVoter::check_outliers(uint64_t now)
+{
+	/* a median needs all three, and current ones */
+	for (unsigned n = 0; n < MAX_INSTANCES; n++) {
+		if (!_instances[n].reported || now >= _instances[n].timestamp + _timeout) {
+			return;
+		}
+	}
+
+	for (unsigned n = 0; n < MAX_INSTANCES; n++) {
+		Instance &inst = _instances[n];
+		bool outside = false;
+
+		for (unsigned i = 0; i < 3; i++) {
+			/* the means, vibration differs between the mounting points of the sensors */
+			float a = _instances[0].mean[i];
+			float b = _instances[1].mean[i];
+			float c = _instances[2].mean[i];
+			float median = fmaxf(fminf(a, b), fminf(fmaxf(a, b), c));
+
+			if (fabsf(inst.mean[i] - median) > _max_deviation) {
+				outside = true;
+			}
+		}
+
+		/* counts up to twice the limit, so a sensor that was out stays out for a while */
+		if (outside) {
+			if (inst.outlier_updates < 2 * OUTLIER_UPDATES) {
+				inst.outlier_updates++;
+			}
+
+		} else if (inst.outlier_updates > 0) {
+			inst.outlier_updates--;
+		}
+	}
+}
+
+int
+SensorVoter::update(uint64_t now)
+{
+	check_outliers(now);
+
+	_healthy = 0;
+	int best = -1;
+
+	for (unsigned n = 0; n < MAX_INSTANCES; n++) {
+		if (is_healthy(_instances[n], now)) {
+			_healthy |= (1 << n);
+
+			if (best < 0 || score(n) < score(best)) {
+				best = n;
+			}
+		}
+	}
+
+	if (best < 0) {
+		/* nothing healthy, stay with what there was, or take whatever reported */
+		if (_selected < 0) {
+			for (unsigned n = 0; n < MAX_INSTANCES; n++) {
+				if (_instances[n].reported) {
+					_selected = n;
+					break;
+				}
+			}
+		}
+
+		return _selected;
+	}
+
+	bool selected_healthy = (_selected >= 0) && (_healthy & (1 << _selected));
+
+	if (!selected_healthy || score(best) < SWITCH_RATIO * score(_selected)) {
+		if (_selected >= 0 && best != _selected) {
+			_failovers++;
+		}
+
+		_selected = best;
+	}
+
+	return _selected;
+}
+
+void
+SensorVoter::print_status(const char *name) const
+{
+	warnx("%s: using %d, %u failovers", name, _selected, _failovers);
+
+	for (unsigned n = 0; n < MAX_INSTANCES; n++) {
+		const Instance &inst = _instances[n];
+
+		if (inst.reported) {
+			warnx("  %u: %s, scatter %.4f, errors %.3f/sample%s%s", n, (_healthy & (1 << n)) ? "healthy" : "UNHEALTHY",
+			      (double)inst.scatter, (double)inst.error_rate,
+			      (inst.same_samples >= STUCK_SAMPLES) ? ", stuck" : "",
+			      (inst.outlier_updates >= OUTLIER_UPDATES) ? ", outlier" : "");
+		}
+	}
+}
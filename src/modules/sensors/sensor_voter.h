@@ -0,0 +1,112 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2015 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file sensor_voter.h
+ *
+ * Picks one of up to three redundant sensor instances.
+ *
+ * Each instance gets a health state from its own samples:
+ * - timeout: no sample for longer than the configured timeout
+ * - stuck: the same value many samples in a row, as a hung sensor repeats its last reading
+ * - outlier: with three instances reporting, one whose mean stays away from the median of the
+ *   three means
+ * and a score from the driver error count and how much the samples scatter around their
+ * mean, which is where vibration shows. Of the healthy instances the one with the lowest
+ * score is used. The selection only moves away from a healthy instance if another one
+ * scores much better, so two similar sensors do not make it flip back and forth.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+class SensorVoter
+{
+public:
+	static const unsigned MAX_INSTANCES = 3;
+
+	/**
+	 * @param timeout		microseconds without a sample before an instance is unhealthy
+	 * @param max_deviation		largest distance of an axis from the median, in sensor units
+	 */
+	SensorVoter(uint64_t timeout, float max_deviation);
+
+	/**
+	 * Feed a new sample of an instance.
+	 */
+	void		put(unsigned instance, uint64_t timestamp, const float value[3], uint64_t error_count);
+
+	/**
+	 * Re-evaluate the health of all instances and the selection.
+	 *
+	 * @return the selected instance, -1 if none ever reported
+	 */
+	int		update(uint64_t now);
+
+	int		selected() const { return _selected; }
+	unsigned	healthy() const { return _healthy; }
+	unsigned	failovers() const { return _failovers; }
+	float		score(unsigned instance) const;
+
+	void		print_status(const char *name) const;
+
+private:
+	/* samples of the same value before an instance counts as stuck */
+	static const unsigned STUCK_SAMPLES = 50;
+
+	/* updates out of the median before an instance counts as outlier, and back */
+	static const unsigned OUTLIER_UPDATES = 20;
+
+	struct Instance {
+		uint64_t	timestamp;
+		float		value[3];
+		float		mean[3];		/**< low passed value */
+		float		scatter;		/**< low passed squared distance from the mean */
+		float		error_rate;		/**< low passed driver errors per sample */
+		uint64_t	error_count;
+		unsigned	same_samples;
+		unsigned	outlier_updates;
+		bool		reported;
+	};
+
+	Instance	_instances[MAX_INSTANCES];
+	uint64_t	_timeout;
+	float		_max_deviation;
+	int		_selected;
+	unsigned	_healthy;		/**< bitmask */
+	unsigned	_failovers;
+
+	void		check_outliers(uint64_t now);
+	bool		is_healthy(const Instance &inst, uint64_t now) const;
+};
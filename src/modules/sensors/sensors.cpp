@@ -69,11 +69,15 @@
 #include <systemlib/err.h>
 #include <systemlib/perf_counter.h>
 #include <conversion/rotation.h>
+#include <geo/geo.h>
 
 #include <systemlib/airspeed.h>
 
 #include <uORB/uORB.h>
 #include <uORB/topics/sensor_combined.h>
+#include <uORB/topics/sensor_imu.h>
+#include <uORB/topics/vehicle_magnetometer.h>
+#include <uORB/topics/vehicle_air_data.h>
 #include <uORB/topics/rc_channels.h>
 #include <uORB/topics/manual_control_setpoint.h>
 #include <uORB/topics/actuator_controls.h>
@@ -83,6 +87,8 @@
 #include <uORB/topics/differential_pressure.h>
 #include <uORB/topics/airspeed.h>
 
+#include "sensor_voter.h"
+
 #define GYRO_HEALTH_COUNTER_LIMIT_ERROR 20   /* 40 ms downtime at 500 Hz update rate   */
 #define ACC_HEALTH_COUNTER_LIMIT_ERROR  20   /* 40 ms downtime at 500 Hz update rate   */
 #define MAGN_HEALTH_COUNTER_LIMIT_ERROR 100  /* 1000 ms downtime at 100 Hz update rate  */
@@ -143,6 +149,28 @@
 
 #define STICK_ON_OFF_LIMIT 0.75f
 
+/* IMU instance voting: no samples for this long is a failure, in microseconds */
+#define IMU_GYRO_TIMEOUT		20000
+#define IMU_ACCEL_TIMEOUT		20000
+
+/* largest distance of a mean from the median of the three instances */
+#define IMU_GYRO_MAX_DEVIATION		0.3f	/* rad/s */
+#define IMU_ACCEL_MAX_DEVIATION		2.5f	/* m/s^2 */
+
+/**
+ * Changes of the static pressure and the air temperature which make the
+ * sensors app recompute the air density. 50 Pa and 0.5 degrees are each
+ * less than 0.1% of density.
+ */
+#define AIR_DATA_PRESSURE_STEP		50.0f	/* Pa */
+#define AIR_DATA_TEMPERATURE_STEP	0.5f	/* deg C */
+
+/**
+ * Secondary instances of each sensor class with their own calibration
+ * parameters, the first instance uses SENS_*.
+ */
+#define CAL_SECONDARY_INSTANCES		2
+
 /* oddly, ERROR is not defined for c++ */
 #ifdef ERROR
 # undef ERROR
@@ -176,6 +204,11 @@ public:
 	 */
 	int		start();
 
+	/**
+	 * Print the state of the IMU selection.
+	 */
+	void		print_status();
+
 private:
 	static const unsigned _rc_max_chan_count = RC_INPUT_MAX_CHANNELS;	/**< maximum number of r/c channels we handle */
 
@@ -191,10 +224,16 @@ private:
 	switch_pos_t	get_rc_sw2pos_position(enum RC_CHANNELS_FUNCTION func, float on_th, bool on_inv);
 
 	/**
-	 * Gather and publish RC input data.
+	 * Scale and publish an RC input update. Only called when input_rc has
+	 * been published, not on the IMU loop.
 	 */
 	void		rc_poll();
 
+	/**
+	 * Precompute the channel scaling from the RC parameters.
+	 */
+	void		rc_scaling_update();
+
 	/* XXX should not be here - should be own driver */
 	int 		_fd_adc;			/**< ADC driver handle */
 	hrt_abstime	_last_adc;			/**< last time we took input from the ADC */
@@ -229,6 +268,9 @@ private:
 	orb_advert_t	_battery_pub;			/**< battery status */
 	orb_advert_t	_airspeed_pub;			/**< airspeed */
 	orb_advert_t	_diff_pres_pub;			/**< differential_pressure */
+	orb_advert_t	_imu_pub;			/**< selected gyro and accel */
+	orb_advert_t	_mag_pub;			/**< mag in the board frame */
+	orb_advert_t	_air_data_pub;			/**< baro */
 
 	perf_counter_t	_loop_perf;			/**< loop performance counter */
 
@@ -238,6 +280,12 @@ private:
 	struct differential_pressure_s _diff_pres;
 	struct airspeed_s _airspeed;
 
+	float		_diff_pres_lpf;			/**< differential pressure low passed with SENS_DPRES_LPF */
+	uint64_t	_diff_pres_lpf_timestamp;
+	float		_eas2tas;			/**< true / equivalent airspeed for the cached density */
+	float		_eas2tas_pressure;		/**< static pressure of the cached density, Pa */
+	float		_eas2tas_temperature;		/**< air temperature of the cached density */
+
 	math::Matrix<3, 3>	_board_rotation;		/**< rotation matrix for the orientation that the board is mounted */
 	math::Matrix<3, 3>	_external_mag_rotation;		/**< rotation matrix for the orientation that an external mag is mounted */
 	bool		_mag_is_external;		/**< true if the active mag is on an external board */
@@ -245,6 +293,20 @@ private:
 	uint64_t _battery_discharged;			/**< battery discharged current in mA*ms */
 	hrt_abstime _battery_current_timestamp;	/**< timestamp of last battery current reading */
 
+	/* latest sample of every IMU instance, rotated to the board frame */
+	struct imu_sample {
+		uint64_t	timestamp;
+		float		value[3];
+		float		integral[3];
+		uint64_t	integral_dt;
+	};
+
+	struct imu_sample _gyro_samples[SensorVoter::MAX_INSTANCES];
+	struct imu_sample _accel_samples[SensorVoter::MAX_INSTANCES];
+	SensorVoter	_gyro_voter;
+	SensorVoter	_accel_voter;
+	struct sensor_imu_s _imu;
+
 	struct {
 		float min[_rc_max_chan_count];
 		float trim[_rc_max_chan_count];
@@ -259,11 +321,18 @@ private:
 		float mag_scale[3];
 		float accel_offset[3];
 		float accel_scale[3];
+		/* x offset, x scale, y offset, ... of the secondary sensors, as in struct gyro_scale */
+		float gyro_cal[CAL_SECONDARY_INSTANCES][6];
+		float accel_cal[CAL_SECONDARY_INSTANCES][6];
+		float mag_cal[CAL_SECONDARY_INSTANCES][6];
 		float diff_pres_offset_pa;
 		float diff_pres_analog_scale;
+		float diff_pres_lpf;
 
 		int board_rotation;
 		int external_mag_rotation;
+		int imu_integration_interval;
+		int combined_publish;
 
 		float board_offset[3];
 
@@ -324,8 +393,12 @@ private:
 		param_t accel_scale[3];
 		param_t mag_offset[3];
 		param_t mag_scale[3];
+		param_t gyro_cal[CAL_SECONDARY_INSTANCES][6];
+		param_t accel_cal[CAL_SECONDARY_INSTANCES][6];
+		param_t mag_cal[CAL_SECONDARY_INSTANCES][6];
 		param_t diff_pres_offset_pa;
 		param_t diff_pres_analog_scale;
+		param_t diff_pres_lpf;
 
 		param_t rc_map_roll;
 		param_t rc_map_pitch;
@@ -362,6 +435,8 @@ private:
 
 		param_t board_rotation;
 		param_t external_mag_rotation;
+		param_t imu_integration_interval;
+		param_t combined_publish;
 
 		param_t board_offset[3];
 
@@ -369,6 +444,17 @@ private:
 
 	}		_parameter_handles;		/**< handles for interesting parameters */
 
+	/* per channel scaling, derived from the RC parameters once per update */
+	struct rc_scaling {
+		float	min;
+		float	max;
+		float	upper;			/**< trim + dead zone, where the upper range starts */
+		float	lower;			/**< trim - dead zone */
+		float	upper_scale;		/**< reverse / (max - upper) */
+		float	lower_scale;		/**< reverse / (lower - min) */
+	}		_rc_scaling[_rc_max_chan_count];
+
+	int		_rc_failsafe_channel;		/**< channel checked against RC_FAILS_THR, -1 if none */
 
 	/**
 	 * Update our local parameter cache.
@@ -416,6 +502,17 @@ private:
 	 */
 	void		gyro_poll(struct sensor_combined_s &raw);
 
+	/**
+	 * Keep the sample of an IMU instance for the voting.
+	 */
+	void		imu_store(struct imu_sample &sample, uint64_t timestamp, const math::Vector<3> &vect,
+				  float x_integral, float y_integral, float z_integral, uint64_t integral_dt);
+
+	/**
+	 * Select the gyro and accel instances and publish them, on every new gyro sample.
+	 */
+	void		imu_publish();
+
 	/**
 	 * Poll the magnetometer for updated data.
 	 *
@@ -508,16 +605,32 @@ Sensors::Sensors() :
 	_battery_pub(-1),
 	_airspeed_pub(-1),
 	_diff_pres_pub(-1),
+	_imu_pub(-1),
+	_mag_pub(-1),
+	_air_data_pub(-1),
 
 /* performance counters */
 	_loop_perf(perf_alloc(PC_ELAPSED, "sensor task update")),
 
 	_mag_is_external(false),
 	_battery_discharged(0),
-	_battery_current_timestamp(0)
+	_battery_current_timestamp(0),
+
+	_gyro_voter(IMU_GYRO_TIMEOUT, IMU_GYRO_MAX_DEVIATION),
+	_accel_voter(IMU_ACCEL_TIMEOUT, IMU_ACCEL_MAX_DEVIATION)
 {
 	memset(&_rc, 0, sizeof(_rc));
 	memset(&_diff_pres, 0, sizeof(_diff_pres));
+	memset(&_gyro_samples, 0, sizeof(_gyro_samples));
+	memset(&_accel_samples, 0, sizeof(_accel_samples));
+	memset(&_imu, 0, sizeof(_imu));
+
+	_diff_pres_lpf = 0.0f;
+	_diff_pres_lpf_timestamp = 0;
+	_eas2tas = 1.0f;
+	/* force a density update on the first sample */
+	_eas2tas_pressure = -1.0e6f;
+	_eas2tas_temperature = 0.0f;
 
 	/* basic r/c parameters */
 	for (unsigned i = 0; i < _rc_max_chan_count; i++) {
@@ -605,9 +718,26 @@ Sensors::Sensors() :
 	_parameter_handles.mag_scale[1] = param_find("SENS_MAG_YSCALE");
 	_parameter_handles.mag_scale[2] = param_find("SENS_MAG_ZSCALE");
 
+	/* calibration of the secondary sensors, CAL_GYRO1_XOFF, CAL_GYRO1_XSCALE, ... */
+	for (unsigned s = 0; s < CAL_SECONDARY_INSTANCES; s++) {
+		for (unsigned i = 0; i < 6; i++) {
+			char name[17];
+			const char axis = 'X' + i / 2;
+			const char *kind = (i % 2 == 0) ? "OFF" : "SCALE";
+
+			snprintf(name, sizeof(name), "CAL_GYRO%u_%c%s", s + 1, axis, kind);
+			_parameter_handles.gyro_cal[s][i] = param_find(name);
+			snprintf(name, sizeof(name), "CAL_ACC%u_%c%s", s + 1, axis, kind);
+			_parameter_handles.accel_cal[s][i] = param_find(name);
+			snprintf(name, sizeof(name), "CAL_MAG%u_%c%s", s + 1, axis, kind);
+			_parameter_handles.mag_cal[s][i] = param_find(name);
+		}
+	}
+
 	/* Differential pressure offset */
 	_parameter_handles.diff_pres_offset_pa = param_find("SENS_DPRES_OFF");
 	_parameter_handles.diff_pres_analog_scale = param_find("SENS_DPRES_ANSC");
+	_parameter_handles.diff_pres_lpf = param_find("SENS_DPRES_LPF");
 
 	_parameter_handles.battery_voltage_scaling = param_find("BAT_V_SCALING");
 	_parameter_handles.battery_current_scaling = param_find("BAT_C_SCALING");
@@ -615,6 +745,8 @@ Sensors::Sensors() :
 	/* rotations */
 	_parameter_handles.board_rotation = param_find("SENS_BOARD_ROT");
 	_parameter_handles.external_mag_rotation = param_find("SENS_EXT_MAG_ROT");
+	_parameter_handles.imu_integration_interval = param_find("SENS_IMU_INTV");
+	_parameter_handles.combined_publish = param_find("SENS_CMB_PUB");
 
 	/* rotation offsets */
 	_parameter_handles.board_offset[0] = param_find("SENS_BOARD_X_OFF");
@@ -791,6 +923,8 @@ Sensors::parameters_update()
 	_rc.function[AUX_4] = _parameters.rc_map_aux4 - 1;
 	_rc.function[AUX_5] = _parameters.rc_map_aux5 - 1;
 
+	rc_scaling_update();
+
 	/* gyro offsets */
 	param_get(_parameter_handles.gyro_offset[0], &(_parameters.gyro_offset[0]));
 	param_get(_parameter_handles.gyro_offset[1], &(_parameters.gyro_offset[1]));
@@ -816,9 +950,19 @@ Sensors::parameters_update()
 	param_get(_parameter_handles.mag_scale[1], &(_parameters.mag_scale[1]));
 	param_get(_parameter_handles.mag_scale[2], &(_parameters.mag_scale[2]));
 
+	/* secondary sensors */
+	for (unsigned s = 0; s < CAL_SECONDARY_INSTANCES; s++) {
+		for (unsigned i = 0; i < 6; i++) {
+			param_get(_parameter_handles.gyro_cal[s][i], &(_parameters.gyro_cal[s][i]));
+			param_get(_parameter_handles.accel_cal[s][i], &(_parameters.accel_cal[s][i]));
+			param_get(_parameter_handles.mag_cal[s][i], &(_parameters.mag_cal[s][i]));
+		}
+	}
+
 	/* Airspeed offset */
 	param_get(_parameter_handles.diff_pres_offset_pa, &(_parameters.diff_pres_offset_pa));
 	param_get(_parameter_handles.diff_pres_analog_scale, &(_parameters.diff_pres_analog_scale));
+	param_get(_parameter_handles.diff_pres_lpf, &(_parameters.diff_pres_lpf));
 
 	/* scaling of ADC ticks to battery voltage */
 	if (param_get(_parameter_handles.battery_voltage_scaling, &(_parameters.battery_voltage_scaling)) != OK) {
@@ -832,6 +976,8 @@ Sensors::parameters_update()
 
 	param_get(_parameter_handles.board_rotation, &(_parameters.board_rotation));
 	param_get(_parameter_handles.external_mag_rotation, &(_parameters.external_mag_rotation));
+	param_get(_parameter_handles.imu_integration_interval, &(_parameters.imu_integration_interval));
+	param_get(_parameter_handles.combined_publish, &(_parameters.combined_publish));
 
 	get_rot_matrix((enum Rotation)_parameters.board_rotation, &_board_rotation);
 	get_rot_matrix((enum Rotation)_parameters.external_mag_rotation, &_external_mag_rotation);
@@ -1041,7 +1187,7 @@ Sensors::accel_poll(struct sensor_combined_s &raw)
 	if (accel_updated) {
 		struct accel_report	accel_report;
 
-		orb_copy(ORB_ID(sensor_accel0), _accel_sub, &accel_report);
+		orb_copy(ORB_ID(sensor_accel), _accel_sub, &accel_report);
 
 		math::Vector<3> vect(accel_report.x, accel_report.y, accel_report.z);
 		vect = _board_rotation * vect;
@@ -1054,7 +1200,19 @@ Sensors::accel_poll(struct sensor_combined_s &raw)
 		raw.accelerometer_raw[1] = accel_report.y_raw;
 		raw.accelerometer_raw[2] = accel_report.z_raw;
 
+		math::Vector<3> vect_int(accel_report.x_integral, accel_report.y_integral, accel_report.z_integral);
+		vect_int = _board_rotation * vect_int;
+
+		raw.accelerometer_integral_m_s[0] = vect_int(0);
+		raw.accelerometer_integral_m_s[1] = vect_int(1);
+		raw.accelerometer_integral_m_s[2] = vect_int(2);
+		raw.accelerometer_integral_dt = accel_report.integral_dt;
+
 		raw.accelerometer_timestamp = accel_report.timestamp;
+
+		imu_store(_accel_samples[0], accel_report.timestamp, vect, accel_report.x_integral,
+			  accel_report.y_integral, accel_report.z_integral, accel_report.integral_dt);
+		_accel_voter.put(0, accel_report.timestamp, _accel_samples[0].value, accel_report.error_count);
 	}
 
 	orb_check(_accel1_sub, &accel_updated);
@@ -1062,7 +1220,7 @@ Sensors::accel_poll(struct sensor_combined_s &raw)
 	if (accel_updated) {
 		struct accel_report	accel_report;
 
-		orb_copy(ORB_ID(sensor_accel1), _accel_sub, &accel_report);
+		orb_copy(ORB_ID(sensor_accel), _accel1_sub, &accel_report);
 
 		math::Vector<3> vect(accel_report.x, accel_report.y, accel_report.z);
 		vect = _board_rotation * vect;
@@ -1076,6 +1234,10 @@ Sensors::accel_poll(struct sensor_combined_s &raw)
 		raw.accelerometer1_raw[2] = accel_report.z_raw;
 
 		raw.accelerometer1_timestamp = accel_report.timestamp;
+
+		imu_store(_accel_samples[1], accel_report.timestamp, vect, accel_report.x_integral,
+			  accel_report.y_integral, accel_report.z_integral, accel_report.integral_dt);
+		_accel_voter.put(1, accel_report.timestamp, _accel_samples[1].value, accel_report.error_count);
 	}
 
 	orb_check(_accel2_sub, &accel_updated);
@@ -1083,7 +1245,7 @@ Sensors::accel_poll(struct sensor_combined_s &raw)
 	if (accel_updated) {
 		struct accel_report	accel_report;
 
-		orb_copy(ORB_ID(sensor_accel2), _accel_sub, &accel_report);
+		orb_copy(ORB_ID(sensor_accel), _accel2_sub, &accel_report);
 
 		math::Vector<3> vect(accel_report.x, accel_report.y, accel_report.z);
 		vect = _board_rotation * vect;
@@ -1097,6 +1259,10 @@ Sensors::accel_poll(struct sensor_combined_s &raw)
 		raw.accelerometer2_raw[2] = accel_report.z_raw;
 
 		raw.accelerometer2_timestamp = accel_report.timestamp;
+
+		imu_store(_accel_samples[2], accel_report.timestamp, vect, accel_report.x_integral,
+			  accel_report.y_integral, accel_report.z_integral, accel_report.integral_dt);
+		_accel_voter.put(2, accel_report.timestamp, _accel_samples[2].value, accel_report.error_count);
 	}
 }
 
@@ -1109,7 +1275,7 @@ Sensors::gyro_poll(struct sensor_combined_s &raw)
 	if (gyro_updated) {
 		struct gyro_report	gyro_report;
 
-		orb_copy(ORB_ID(sensor_gyro0), _gyro_sub, &gyro_report);
+		orb_copy(ORB_ID(sensor_gyro), _gyro_sub, &gyro_report);
 
 		math::Vector<3> vect(gyro_report.x, gyro_report.y, gyro_report.z);
 		vect = _board_rotation * vect;
@@ -1122,7 +1288,19 @@ Sensors::gyro_poll(struct sensor_combined_s &raw)
 		raw.gyro_raw[1] = gyro_report.y_raw;
 		raw.gyro_raw[2] = gyro_report.z_raw;
 
+		math::Vector<3> vect_int(gyro_report.x_integral, gyro_report.y_integral, gyro_report.z_integral);
+		vect_int = _board_rotation * vect_int;
+
+		raw.gyro_integral_rad[0] = vect_int(0);
+		raw.gyro_integral_rad[1] = vect_int(1);
+		raw.gyro_integral_rad[2] = vect_int(2);
+		raw.gyro_integral_dt = gyro_report.integral_dt;
+
 		raw.timestamp = gyro_report.timestamp;
+
+		imu_store(_gyro_samples[0], gyro_report.timestamp, vect, gyro_report.x_integral,
+			  gyro_report.y_integral, gyro_report.z_integral, gyro_report.integral_dt);
+		_gyro_voter.put(0, gyro_report.timestamp, _gyro_samples[0].value, gyro_report.error_count);
 	}
 
 	orb_check(_gyro1_sub, &gyro_updated);
@@ -1130,7 +1308,7 @@ Sensors::gyro_poll(struct sensor_combined_s &raw)
 	if (gyro_updated) {
 		struct gyro_report	gyro_report;
 
-		orb_copy(ORB_ID(sensor_gyro1), _gyro1_sub, &gyro_report);
+		orb_copy(ORB_ID(sensor_gyro), _gyro1_sub, &gyro_report);
 
 		math::Vector<3> vect(gyro_report.x, gyro_report.y, gyro_report.z);
 		vect = _board_rotation * vect;
@@ -1144,6 +1322,10 @@ Sensors::gyro_poll(struct sensor_combined_s &raw)
 		raw.gyro1_raw[2] = gyro_report.z_raw;
 
 		raw.gyro1_timestamp = gyro_report.timestamp;
+
+		imu_store(_gyro_samples[1], gyro_report.timestamp, vect, gyro_report.x_integral,
+			  gyro_report.y_integral, gyro_report.z_integral, gyro_report.integral_dt);
+		_gyro_voter.put(1, gyro_report.timestamp, _gyro_samples[1].value, gyro_report.error_count);
 	}
 
 	orb_check(_gyro2_sub, &gyro_updated);
@@ -1151,7 +1333,7 @@ Sensors::gyro_poll(struct sensor_combined_s &raw)
 	if (gyro_updated) {
 		struct gyro_report	gyro_report;
 
-		orb_copy(ORB_ID(sensor_gyro2), _gyro_sub, &gyro_report);
+		orb_copy(ORB_ID(sensor_gyro), _gyro2_sub, &gyro_report);
 
 		math::Vector<3> vect(gyro_report.x, gyro_report.y, gyro_report.z);
 		vect = _board_rotation * vect;
@@ -1165,9 +1347,81 @@ Sensors::gyro_poll(struct sensor_combined_s &raw)
 		raw.gyro2_raw[2] = gyro_report.z_raw;
 
 		raw.gyro2_timestamp = gyro_report.timestamp;
+
+		imu_store(_gyro_samples[2], gyro_report.timestamp, vect, gyro_report.x_integral,
+			  gyro_report.y_integral, gyro_report.z_integral, gyro_report.integral_dt);
+		_gyro_voter.put(2, gyro_report.timestamp, _gyro_samples[2].value, gyro_report.error_count);
 	}
 }
 
+void
+Sensors::imu_store(struct imu_sample &sample, uint64_t timestamp, const math::Vector<3> &vect,
+		   float x_integral, float y_integral, float z_integral, uint64_t integral_dt)
+{
+	math::Vector<3> vect_int(x_integral, y_integral, z_integral);
+	vect_int = _board_rotation * vect_int;
+
+	for (unsigned i = 0; i < 3; i++) {
+		sample.value[i] = vect(i);
+		sample.integral[i] = vect_int(i);
+	}
+
+	sample.integral_dt = integral_dt;
+	sample.timestamp = timestamp;
+}
+
+void
+Sensors::imu_publish()
+{
+	hrt_abstime now = hrt_absolute_time();
+	int gyro = _gyro_voter.update(now);
+	int accel = _accel_voter.update(now);
+
+	if (gyro < 0 || accel < 0 || _gyro_samples[gyro].timestamp == _imu.timestamp) {
+		return;
+	}
+
+	const struct imu_sample &g = _gyro_samples[gyro];
+	const struct imu_sample &a = _accel_samples[accel];
+
+	_imu.timestamp = g.timestamp;
+	_imu.accelerometer_timestamp = a.timestamp;
+
+	for (unsigned i = 0; i < 3; i++) {
+		_imu.gyro_rad_s[i] = g.value[i];
+		_imu.gyro_integral_rad[i] = g.integral[i];
+		_imu.accelerometer_m_s2[i] = a.value[i];
+		_imu.accelerometer_integral_m_s[i] = a.integral[i];
+	}
+
+	_imu.gyro_integral_dt = g.integral_dt;
+	_imu.accelerometer_integral_dt = a.integral_dt;
+	_imu.gyro_index = gyro;
+	_imu.accelerometer_index = accel;
+	_imu.gyro_healthy = _gyro_voter.healthy();
+	_imu.accelerometer_healthy = _accel_voter.healthy();
+	_imu.gyro_failovers = _gyro_voter.failovers();
+	_imu.accelerometer_failovers = _accel_voter.failovers();
+
+	if (!_publishing) {
+		return;
+	}
+
+	if (_imu_pub > 0) {
+		orb_publish(ORB_ID(sensor_imu), _imu_pub, &_imu);
+
+	} else {
+		_imu_pub = orb_advertise(ORB_ID(sensor_imu), &_imu);
+	}
+}
+
+void
+Sensors::print_status()
+{
+	_gyro_voter.print_status("gyro");
+	_accel_voter.print_status("accel");
+}
+
 void
 Sensors::mag_poll(struct sensor_combined_s &raw)
 {
@@ -1199,6 +1453,21 @@ Sensors::mag_poll(struct sensor_combined_s &raw)
 		raw.magnetometer_raw[2] = mag_report.z_raw;
 
 		raw.magnetometer_timestamp = mag_report.timestamp;
+
+		struct vehicle_magnetometer_s mag;
+		mag.timestamp = mag_report.timestamp;
+		mag.magnetometer_ga[0] = vect(0);
+		mag.magnetometer_ga[1] = vect(1);
+		mag.magnetometer_ga[2] = vect(2);
+
+		if (_publishing) {
+			if (_mag_pub > 0) {
+				orb_publish(ORB_ID(vehicle_magnetometer), _mag_pub, &mag);
+
+			} else {
+				_mag_pub = orb_advertise(ORB_ID(vehicle_magnetometer), &mag);
+			}
+		}
 	}
 }
 
@@ -1217,6 +1486,21 @@ Sensors::baro_poll(struct sensor_combined_s &raw)
 		raw.baro_temp_celcius = _barometer.temperature; // Temperature in degrees celcius
 
 		raw.baro_timestamp = _barometer.timestamp;
+
+		struct vehicle_air_data_s air_data;
+		air_data.timestamp = _barometer.timestamp;
+		air_data.baro_pres_mbar = _barometer.pressure;
+		air_data.baro_alt_meter = _barometer.altitude;
+		air_data.baro_temp_celcius = _barometer.temperature;
+
+		if (_publishing) {
+			if (_air_data_pub > 0) {
+				orb_publish(ORB_ID(vehicle_air_data), _air_data_pub, &air_data);
+
+			} else {
+				_air_data_pub = orb_advertise(ORB_ID(vehicle_air_data), &air_data);
+			}
+		}
 	}
 }
 
@@ -1235,12 +1519,44 @@ Sensors::diff_pres_poll(struct sensor_combined_s &raw)
 
 		float air_temperature_celsius = (_diff_pres.temperature > -300.0f) ? _diff_pres.temperature : (raw.baro_temp_celcius - PCB_TEMP_ESTIMATE_DEG);
 
+		/* optional low pass on top of the driver filter, so the controllers don't need their own */
+		float diff_pres_pa = _diff_pres.differential_pressure_filtered_pa;
+
+		if (_parameters.diff_pres_lpf > 0.0f && _diff_pres_lpf_timestamp != 0 &&
+		    _diff_pres.timestamp > _diff_pres_lpf_timestamp) {
+			float dt = (_diff_pres.timestamp - _diff_pres_lpf_timestamp) * 1e-6f;
+			float alpha = dt / (dt + 1.0f / (2.0f * M_PI_F * _parameters.diff_pres_lpf));
+			_diff_pres_lpf += alpha * (diff_pres_pa - _diff_pres_lpf);
+
+		} else {
+			_diff_pres_lpf = diff_pres_pa;
+		}
+
+		_diff_pres_lpf_timestamp = _diff_pres.timestamp;
+		raw.differential_pressure_filtered_pa = _diff_pres_lpf;
+
+		/* the density only needs an update when the static pressure or the temperature moved */
+		float static_pressure_pa = raw.baro_pres_mbar * 1e2f;
+
+		if (fabsf(static_pressure_pa - _eas2tas_pressure) > AIR_DATA_PRESSURE_STEP ||
+		    fabsf(air_temperature_celsius - _eas2tas_temperature) > AIR_DATA_TEMPERATURE_STEP) {
+			float density = get_air_density(static_pressure_pa, air_temperature_celsius);
+
+			if (density < 0.0001f || !isfinite(density)) {
+				density = CONSTANTS_AIR_DENSITY_SEA_LEVEL_15C;
+			}
+
+			_eas2tas = sqrtf(CONSTANTS_AIR_DENSITY_SEA_LEVEL_15C / density);
+			_eas2tas_pressure = static_pressure_pa;
+			_eas2tas_temperature = air_temperature_celsius;
+		}
+
 		_airspeed.timestamp = _diff_pres.timestamp;
 
 		/* don't risk to feed negative airspeed into the system */
-		_airspeed.indicated_airspeed_m_s = math::max(0.0f, calc_indicated_airspeed(_diff_pres.differential_pressure_filtered_pa));
-		_airspeed.true_airspeed_m_s = math::max(0.0f, calc_true_airspeed(_diff_pres.differential_pressure_filtered_pa + raw.baro_pres_mbar * 1e2f,
-					      raw.baro_pres_mbar * 1e2f, air_temperature_celsius));
+		_airspeed.indicated_airspeed_m_s = math::max(0.0f, calc_indicated_airspeed(_diff_pres_lpf));
+		_airspeed.true_airspeed_m_s = _airspeed.indicated_airspeed_m_s * _eas2tas;
+		_airspeed.eas2tas = _eas2tas;
 		_airspeed.air_temperature_celsius = air_temperature_celsius;
 
 		/* announce the airspeed if needed, just publish else */
@@ -1312,6 +1628,9 @@ Sensors::parameter_update_poll(bool forced)
 			warn("WARNING: failed to set scale / offsets for gyro");
 		}
 
+		/* not every driver integrates */
+		ioctl(fd, SENSORIOCSINTEGRATION, _parameters.imu_integration_interval);
+
 		close(fd);
 
 		fd = open(ACCEL_DEVICE_PATH, 0);
@@ -1328,6 +1647,8 @@ Sensors::parameter_update_poll(bool forced)
 			warn("WARNING: failed to set scale / offsets for accel");
 		}
 
+		ioctl(fd, SENSORIOCSINTEGRATION, _parameters.imu_integration_interval);
+
 		close(fd);
 
 		fd = open(MAG_DEVICE_PATH, 0);
@@ -1346,6 +1667,58 @@ Sensors::parameter_update_poll(bool forced)
 
 		close(fd);
 
+		/* the secondary sensors are optional */
+		for (unsigned s = 0; s < CAL_SECONDARY_INSTANCES; s++) {
+			char path[16];
+			const float *cal;
+
+			snprintf(path, sizeof(path), "%s%u", GYRO_DEVICE_PATH, s + 1);
+			fd = open(path, 0);
+
+			if (fd >= 0) {
+				cal = _parameters.gyro_cal[s];
+				struct gyro_scale gscale1 = { cal[0], cal[1], cal[2], cal[3], cal[4], cal[5] };
+
+				if (OK != ioctl(fd, GYROIOCSSCALE, (long unsigned int)&gscale1)) {
+					warn("WARNING: failed to set scale / offsets for %s", path);
+				}
+
+				ioctl(fd, SENSORIOCSINTEGRATION, _parameters.imu_integration_interval);
+
+				close(fd);
+			}
+
+			snprintf(path, sizeof(path), "%s%u", ACCEL_DEVICE_PATH, s + 1);
+			fd = open(path, 0);
+
+			if (fd >= 0) {
+				cal = _parameters.accel_cal[s];
+				struct accel_scale ascale1 = { cal[0], cal[1], cal[2], cal[3], cal[4], cal[5] };
+
+				if (OK != ioctl(fd, ACCELIOCSSCALE, (long unsigned int)&ascale1)) {
+					warn("WARNING: failed to set scale / offsets for %s", path);
+				}
+
+				ioctl(fd, SENSORIOCSINTEGRATION, _parameters.imu_integration_interval);
+
+				close(fd);
+			}
+
+			snprintf(path, sizeof(path), "%s%u", MAG_DEVICE_PATH, s + 1);
+			fd = open(path, 0);
+
+			if (fd >= 0) {
+				cal = _parameters.mag_cal[s];
+				struct mag_scale mscale1 = { cal[0], cal[1], cal[2], cal[3], cal[4], cal[5] };
+
+				if (OK != ioctl(fd, MAGIOCSSCALE, (long unsigned int)&mscale1)) {
+					warn("WARNING: failed to set scale / offsets for %s", path);
+				}
+
+				close(fd);
+			}
+		}
+
 		fd = open(AIRSPEED_DEVICE_PATH, 0);
 
 		/* this sensor is optional, abort without error */
@@ -1552,171 +1925,190 @@ Sensors::get_rc_sw2pos_position(enum RC_CHANNELS_FUNCTION func, float on_th, boo
 }
 
 void
-Sensors::rc_poll()
+Sensors::rc_scaling_update()
 {
-	bool rc_updated;
-	orb_check(_rc_sub, &rc_updated);
-
-	if (rc_updated) {
-		/* read low-level values from FMU or IO RC inputs (PPM, Spektrum, S.Bus) */
-		struct rc_input_values rc_input;
+	for (unsigned i = 0; i < _rc_max_chan_count; i++) {
+		struct rc_scaling &s = _rc_scaling[i];
+
+		s.min = _parameters.min[i];
+		s.max = _parameters.max[i];
+		s.upper = _parameters.trim[i] + _parameters.dz[i];
+		s.lower = _parameters.trim[i] - _parameters.dz[i];
+
+		/*
+		 * Infinite where trim sits on an end point, but then the values
+		 * constrained to min/max never get into that range.
+		 */
+		s.upper_scale = _parameters.rev[i] / (s.max - s.upper);
+		s.lower_scale = _parameters.rev[i] / (s.lower - s.min);
+	}
 
-		orb_copy(ORB_ID(input_rc), _rc_sub, &rc_input);
+	/* RC_MAP_FAILSAFE of 0 checks the throttle channel */
+	if (_parameters.rc_fails_thr > 0) {
+		_rc_failsafe_channel = (_parameters.rc_map_failsafe > 0) ? _parameters.rc_map_failsafe - 1 : _rc.function[THROTTLE];
 
-		/* detect RC signal loss */
-		bool signal_lost;
+	} else {
+		_rc_failsafe_channel = -1;
+	}
+}
 
-		/* check flags and require at least four channels to consider the signal valid */
-		if (rc_input.rc_lost || rc_input.rc_failsafe || rc_input.channel_count < 4) {
-			/* signal is lost or no enough channels */
-			signal_lost = true;
+void
+Sensors::rc_poll()
+{
+	/* read low-level values from FMU or IO RC inputs (PPM, Spektrum, S.Bus) */
+	struct rc_input_values rc_input;
 
-		} else {
-			/* signal looks good */
-			signal_lost = false;
+	orb_copy(ORB_ID(input_rc), _rc_sub, &rc_input);
 
-			/* check failsafe */
-			int8_t fs_ch = _rc.function[_parameters.rc_map_failsafe]; // get channel mapped to throttle
+	/* detect RC signal loss */
+	bool signal_lost;
 
-			if (_parameters.rc_map_failsafe > 0) { // if not 0, use channel number instead of rc.function mapping
-				fs_ch = _parameters.rc_map_failsafe - 1;
-			}
+	/* check flags and require at least four channels to consider the signal valid */
+	if (rc_input.rc_lost || rc_input.rc_failsafe || rc_input.channel_count < 4) {
+		/* signal is lost or no enough channels */
+		signal_lost = true;
 
-			if (_parameters.rc_fails_thr > 0 && fs_ch >= 0) {
-				/* failsafe configured */
-				if ((_parameters.rc_fails_thr < _parameters.min[fs_ch] && rc_input.values[fs_ch] < _parameters.rc_fails_thr) ||
-				    (_parameters.rc_fails_thr > _parameters.max[fs_ch] && rc_input.values[fs_ch] > _parameters.rc_fails_thr)) {
-					/* failsafe triggered, signal is lost by receiver */
-					signal_lost = true;
-				}
+	} else {
+		/* signal looks good */
+		signal_lost = false;
+
+		/* check failsafe */
+		int fs_ch = _rc_failsafe_channel;
+
+		if (fs_ch >= 0 && fs_ch < (int)_rc_max_chan_count) {
+			/* failsafe configured */
+			if ((_parameters.rc_fails_thr < _rc_scaling[fs_ch].min && rc_input.values[fs_ch] < _parameters.rc_fails_thr) ||
+			    (_parameters.rc_fails_thr > _rc_scaling[fs_ch].max && rc_input.values[fs_ch] > _parameters.rc_fails_thr)) {
+				/* failsafe triggered, signal is lost by receiver */
+				signal_lost = true;
 			}
 		}
+	}
 
-		unsigned channel_limit = rc_input.channel_count;
+	unsigned channel_limit = rc_input.channel_count;
 
-		if (channel_limit > _rc_max_chan_count) {
-			channel_limit = _rc_max_chan_count;
-		}
+	if (channel_limit > _rc_max_chan_count) {
+		channel_limit = _rc_max_chan_count;
+	}
 
-		/* read out and scale values from raw message even if signal is invalid */
-		for (unsigned int i = 0; i < channel_limit; i++) {
+	/* read out and scale values from raw message even if signal is invalid */
+	for (unsigned int i = 0; i < channel_limit; i++) {
 
-			/*
-			 * 1) Constrain to min/max values, as later processing depends on bounds.
-			 */
-			if (rc_input.values[i] < _parameters.min[i]) {
-				rc_input.values[i] = _parameters.min[i];
-			}
+		const struct rc_scaling &s = _rc_scaling[i];
 
-			if (rc_input.values[i] > _parameters.max[i]) {
-				rc_input.values[i] = _parameters.max[i];
-			}
+		/*
+		 * 1) Constrain to min/max values, as later processing depends on bounds.
+		 */
+		if (rc_input.values[i] < s.min) {
+			rc_input.values[i] = s.min;
+		}
 
-			/*
-			 * 2) Scale around the mid point differently for lower and upper range.
-			 *
-			 * This is necessary as they don't share the same endpoints and slope.
-			 *
-			 * First normalize to 0..1 range with correct sign (below or above center),
-			 * the total range is 2 (-1..1).
-			 * If center (trim) == min, scale to 0..1, if center (trim) == max,
-			 * scale to -1..0.
-			 *
-			 * As the min and max bounds were enforced in step 1), division by zero
-			 * cannot occur, as for the case of center == min or center == max the if
-			 * statement is mutually exclusive with the arithmetic NaN case.
-			 *
-			 * DO NOT REMOVE OR ALTER STEP 1!
-			 */
-			if (rc_input.values[i] > (_parameters.trim[i] + _parameters.dz[i])) {
-				_rc.channels[i] = (rc_input.values[i] - _parameters.trim[i] - _parameters.dz[i]) / (float)(_parameters.max[i] - _parameters.trim[i] - _parameters.dz[i]);
-
-			} else if (rc_input.values[i] < (_parameters.trim[i] - _parameters.dz[i])) {
-				_rc.channels[i] = (rc_input.values[i] - _parameters.trim[i] + _parameters.dz[i]) / (float)(_parameters.trim[i] - _parameters.min[i] - _parameters.dz[i]);
+		if (rc_input.values[i] > s.max) {
+			rc_input.values[i] = s.max;
+		}
 
-			} else {
-				/* in the configured dead zone, output zero */
-				_rc.channels[i] = 0.0f;
-			}
+		/*
+		 * 2) Scale around the mid point differently for lower and upper range.
+		 *
+		 * This is necessary as they don't share the same endpoints and slope.
+		 *
+		 * First normalize to 0..1 range with correct sign (below or above center),
+		 * the total range is 2 (-1..1).
+		 * If center (trim) == min, scale to 0..1, if center (trim) == max,
+		 * scale to -1..0.
+		 *
+		 * As the min and max bounds were enforced in step 1), division by zero
+		 * cannot occur, as for the case of center == min or center == max the if
+		 * statement is mutually exclusive with the arithmetic NaN case.
+		 *
+		 * DO NOT REMOVE OR ALTER STEP 1!
+		 */
+		if (rc_input.values[i] > s.upper) {
+			_rc.channels[i] = (rc_input.values[i] - s.upper) * s.upper_scale;
+
+		} else if (rc_input.values[i] < s.lower) {
+			_rc.channels[i] = (rc_input.values[i] - s.lower) * s.lower_scale;
 
-			_rc.channels[i] *= _parameters.rev[i];
+		} else {
+			/* in the configured dead zone, output zero */
+			_rc.channels[i] = 0.0f;
+		}
 
-			/* handle any parameter-induced blowups */
-			if (!isfinite(_rc.channels[i])) {
-				_rc.channels[i] = 0.0f;
-			}
+		/* handle any parameter-induced blowups */
+		if (!isfinite(_rc.channels[i])) {
+			_rc.channels[i] = 0.0f;
 		}
+	}
 
-		_rc.channel_count = rc_input.channel_count;
-		_rc.rssi = rc_input.rssi;
-		_rc.signal_lost = signal_lost;
-		_rc.timestamp = rc_input.timestamp_last_signal;
+	_rc.channel_count = rc_input.channel_count;
+	_rc.rssi = rc_input.rssi;
+	_rc.signal_lost = signal_lost;
+	_rc.timestamp = rc_input.timestamp_last_signal;
 
-		/* publish rc_channels topic even if signal is invalid, for debug */
-		if (_rc_pub > 0) {
-			orb_publish(ORB_ID(rc_channels), _rc_pub, &_rc);
+	/* publish rc_channels topic even if signal is invalid, for debug */
+	if (_rc_pub > 0) {
+		orb_publish(ORB_ID(rc_channels), _rc_pub, &_rc);
 
-		} else {
-			_rc_pub = orb_advertise(ORB_ID(rc_channels), &_rc);
-		}
+	} else {
+		_rc_pub = orb_advertise(ORB_ID(rc_channels), &_rc);
+	}
 
-		if (!signal_lost) {
-			struct manual_control_setpoint_s manual;
-			memset(&manual, 0 , sizeof(manual));
-
-			/* fill values in manual_control_setpoint topic only if signal is valid */
-			manual.timestamp = rc_input.timestamp_last_signal;
-
-			/* limit controls */
-			manual.y = get_rc_value(ROLL, -1.0, 1.0);
-			manual.x = get_rc_value(PITCH, -1.0, 1.0);
-			manual.r = get_rc_value(YAW, -1.0, 1.0);
-			manual.z = get_rc_value(THROTTLE, 0.0, 1.0);
-			manual.flaps = get_rc_value(FLAPS, -1.0, 1.0);
-			manual.aux1 = get_rc_value(AUX_1, -1.0, 1.0);
-			manual.aux2 = get_rc_value(AUX_2, -1.0, 1.0);
-			manual.aux3 = get_rc_value(AUX_3, -1.0, 1.0);
-			manual.aux4 = get_rc_value(AUX_4, -1.0, 1.0);
-			manual.aux5 = get_rc_value(AUX_5, -1.0, 1.0);
-
-			/* mode switches */
-			manual.mode_switch = get_rc_sw3pos_position(MODE, _parameters.rc_auto_th, _parameters.rc_auto_inv, _parameters.rc_assist_th, _parameters.rc_assist_inv);
-			manual.posctl_switch = get_rc_sw2pos_position(POSCTL, _parameters.rc_posctl_th, _parameters.rc_posctl_inv);
-			manual.return_switch = get_rc_sw2pos_position(RETURN, _parameters.rc_return_th, _parameters.rc_return_inv);
-			manual.loiter_switch = get_rc_sw2pos_position(LOITER, _parameters.rc_loiter_th, _parameters.rc_loiter_inv);
-			manual.acro_switch = get_rc_sw2pos_position(ACRO, _parameters.rc_acro_th, _parameters.rc_acro_inv);
-			manual.offboard_switch = get_rc_sw2pos_position(OFFBOARD, _parameters.rc_offboard_th, _parameters.rc_offboard_inv);
-
-			/* publish manual_control_setpoint topic */
-			if (_manual_control_pub > 0) {
-				orb_publish(ORB_ID(manual_control_setpoint), _manual_control_pub, &manual);
+	if (!signal_lost) {
+		struct manual_control_setpoint_s manual;
+		memset(&manual, 0 , sizeof(manual));
+
+		/* fill values in manual_control_setpoint topic only if signal is valid */
+		manual.timestamp = rc_input.timestamp_last_signal;
+
+		/* limit controls */
+		manual.y = get_rc_value(ROLL, -1.0, 1.0);
+		manual.x = get_rc_value(PITCH, -1.0, 1.0);
+		manual.r = get_rc_value(YAW, -1.0, 1.0);
+		manual.z = get_rc_value(THROTTLE, 0.0, 1.0);
+		manual.flaps = get_rc_value(FLAPS, -1.0, 1.0);
+		manual.aux1 = get_rc_value(AUX_1, -1.0, 1.0);
+		manual.aux2 = get_rc_value(AUX_2, -1.0, 1.0);
+		manual.aux3 = get_rc_value(AUX_3, -1.0, 1.0);
+		manual.aux4 = get_rc_value(AUX_4, -1.0, 1.0);
+		manual.aux5 = get_rc_value(AUX_5, -1.0, 1.0);
+
+		/* mode switches */
+		manual.mode_switch = get_rc_sw3pos_position(MODE, _parameters.rc_auto_th, _parameters.rc_auto_inv, _parameters.rc_assist_th, _parameters.rc_assist_inv);
+		manual.posctl_switch = get_rc_sw2pos_position(POSCTL, _parameters.rc_posctl_th, _parameters.rc_posctl_inv);
+		manual.return_switch = get_rc_sw2pos_position(RETURN, _parameters.rc_return_th, _parameters.rc_return_inv);
+		manual.loiter_switch = get_rc_sw2pos_position(LOITER, _parameters.rc_loiter_th, _parameters.rc_loiter_inv);
+		manual.acro_switch = get_rc_sw2pos_position(ACRO, _parameters.rc_acro_th, _parameters.rc_acro_inv);
+		manual.offboard_switch = get_rc_sw2pos_position(OFFBOARD, _parameters.rc_offboard_th, _parameters.rc_offboard_inv);
+
+		/* publish manual_control_setpoint topic */
+		if (_manual_control_pub > 0) {
+			orb_publish(ORB_ID(manual_control_setpoint), _manual_control_pub, &manual);
 
-			} else {
-				_manual_control_pub = orb_advertise(ORB_ID(manual_control_setpoint), &manual);
-			}
+		} else {
+			_manual_control_pub = orb_advertise(ORB_ID(manual_control_setpoint), &manual);
+		}
 
-			/* copy from mapped manual control to control group 3 */
-			struct actuator_controls_s actuator_group_3;
-			memset(&actuator_group_3, 0 , sizeof(actuator_group_3));
+		/* copy from mapped manual control to control group 3 */
+		struct actuator_controls_s actuator_group_3;
+		memset(&actuator_group_3, 0 , sizeof(actuator_group_3));
 
-			actuator_group_3.timestamp = rc_input.timestamp_last_signal;
+		actuator_group_3.timestamp = rc_input.timestamp_last_signal;
 
-			actuator_group_3.control[0] = manual.y;
-			actuator_group_3.control[1] = manual.x;
-			actuator_group_3.control[2] = manual.r;
-			actuator_group_3.control[3] = manual.z;
-			actuator_group_3.control[4] = manual.flaps;
-			actuator_group_3.control[5] = manual.aux1;
-			actuator_group_3.control[6] = manual.aux2;
-			actuator_group_3.control[7] = manual.aux3;
+		actuator_group_3.control[0] = manual.y;
+		actuator_group_3.control[1] = manual.x;
+		actuator_group_3.control[2] = manual.r;
+		actuator_group_3.control[3] = manual.z;
+		actuator_group_3.control[4] = manual.flaps;
+		actuator_group_3.control[5] = manual.aux1;
+		actuator_group_3.control[6] = manual.aux2;
+		actuator_group_3.control[7] = manual.aux3;
 
-			/* publish actuator_controls_3 topic */
-			if (_actuator_group_3_pub > 0) {
-				orb_publish(ORB_ID(actuator_controls_3), _actuator_group_3_pub, &actuator_group_3);
+		/* publish actuator_controls_3 topic */
+		if (_actuator_group_3_pub > 0) {
+			orb_publish(ORB_ID(actuator_controls_3), _actuator_group_3_pub, &actuator_group_3);
 
-			} else {
-				_actuator_group_3_pub = orb_advertise(ORB_ID(actuator_controls_3), &actuator_group_3);
-			}
+		} else {
+			_actuator_group_3_pub = orb_advertise(ORB_ID(actuator_controls_3), &actuator_group_3);
 		}
 	}
 }
@@ -1741,14 +2133,14 @@ Sensors::task_main()
 	/*
 	 * do subscriptions
 	 */
-	_gyro_sub = orb_subscribe(ORB_ID(sensor_gyro0));
-	_accel_sub = orb_subscribe(ORB_ID(sensor_accel0));
+	_gyro_sub = orb_subscribe_multi(ORB_ID(sensor_gyro), 0);
+	_accel_sub = orb_subscribe_multi(ORB_ID(sensor_accel), 0);
 	_mag_sub = orb_subscribe(ORB_ID(sensor_mag0));
-	_gyro1_sub = orb_subscribe(ORB_ID(sensor_gyro1));
-	_accel1_sub = orb_subscribe(ORB_ID(sensor_accel1));
+	_gyro1_sub = orb_subscribe_multi(ORB_ID(sensor_gyro), 1);
+	_accel1_sub = orb_subscribe_multi(ORB_ID(sensor_accel), 1);
 	_mag1_sub = orb_subscribe(ORB_ID(sensor_mag1));
-	_gyro2_sub = orb_subscribe(ORB_ID(sensor_gyro2));
-	_accel2_sub = orb_subscribe(ORB_ID(sensor_accel2));
+	_gyro2_sub = orb_subscribe_multi(ORB_ID(sensor_gyro), 2);
+	_accel2_sub = orb_subscribe_multi(ORB_ID(sensor_accel), 2);
 	_mag2_sub = orb_subscribe(ORB_ID(sensor_mag2));
 	_rc_sub = orb_subscribe(ORB_ID(input_rc));
 	_baro_sub = orb_subscribe(ORB_ID(sensor_baro0));
@@ -1793,12 +2185,16 @@ Sensors::task_main()
 	_sensor_pub = orb_advertise(ORB_ID(sensor_combined), &raw);
 
 	/* wakeup source(s) */
-	struct pollfd fds[1];
+	struct pollfd fds[2];
 
 	/* use the gyro to pace output - XXX BROKEN if we are using the L3GD20 */
 	fds[0].fd = _gyro_sub;
 	fds[0].events = POLLIN;
 
+	/* RC is handled when it comes in, at its own rate */
+	fds[1].fd = _rc_sub;
+	fds[1].events = POLLIN;
+
 	while (!_task_should_exit) {
 
 		/* wait for up to 50ms for data */
@@ -1812,6 +2208,16 @@ Sensors::task_main()
 			continue;
 		}
 
+		/* Look for new r/c input data */
+		if (pret > 0 && (fds[1].revents & POLLIN)) {
+			rc_poll();
+
+			/* woken for RC only, the sensors have nothing new */
+			if (!(fds[0].revents & POLLIN)) {
+				continue;
+			}
+		}
+
 		perf_begin(_loop_perf);
 
 		/* check vehicle status for changes to publication state */
@@ -1828,19 +2234,18 @@ Sensors::task_main()
 		mag_poll(raw);
 		baro_poll(raw);
 
+		imu_publish();
+
 		/* check battery voltage */
 		adc_poll(raw);
 
 		diff_pres_poll(raw);
 
 		/* Inform other processes that new data is available to copy */
-		if (_publishing) {
+		if (_publishing && _parameters.combined_publish != 0) {
 			orb_publish(ORB_ID(sensor_combined), _sensor_pub, &raw);
 		}
 
-		/* Look for new r/c input data */
-		rc_poll();
-
 		perf_end(_loop_perf);
 	}
 
@@ -1910,6 +2315,7 @@ int sensors_main(int argc, char *argv[])
 
 	if (!strcmp(argv[1], "status")) {
 		if (sensors::g_sensors) {
+			sensors::g_sensors->print_status();
 			errx(0, "is running");
 
 		} else {
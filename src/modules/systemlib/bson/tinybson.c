@@ -58,9 +58,38 @@ read_x(bson_decoder_t decoder, void *p, size_t s)
 {
 	CODER_CHECK(decoder);
 
-	if (decoder->fd > -1)
+	if (decoder->fd > -1 && decoder->buf == NULL)
 		return (read(decoder->fd, p, s) == (int)s) ? 0 : -1;
 
+	if (decoder->fd > -1) {
+		uint8_t *dst = (uint8_t *)p;
+
+		/* copy out of the read buffer, refilling it a block at a time */
+		while (s > 0) {
+			if (decoder->bufpos == decoder->buflen) {
+				int ret = read(decoder->fd, decoder->buf, decoder->bufsize);
+
+				if (ret <= 0)
+					return -1;
+
+				decoder->buflen = ret;
+				decoder->bufpos = 0;
+			}
+
+			size_t n = decoder->buflen - decoder->bufpos;
+
+			if (n > s)
+				n = s;
+
+			memcpy(dst, decoder->buf + decoder->bufpos, n);
+			decoder->bufpos += n;
+			dst += n;
+			s -= n;
+		}
+
+		return 0;
+	}
+
 	if (decoder->buf != NULL) {
 		/* staged operations to avoid integer overflow for corrupt data */
 		if (s >= decoder->bufsize)
@@ -121,6 +150,52 @@ bson_decoder_init_file(bson_decoder_t decoder, int fd, bson_decoder_callback cal
 	return 0;
 }
 
+int
+bson_decoder_init_file_buffered(bson_decoder_t decoder, int fd, void *buf, unsigned bufsize,
+		bson_decoder_callback callback, void *private)
+{
+	int32_t	junk;
+
+	/* argument sanity */
+	if ((buf == NULL) || (bufsize == 0))
+		return -1;
+
+	decoder->fd = fd;
+	decoder->buf = (uint8_t *)buf;
+	decoder->bufsize = bufsize;
+	decoder->bufpos = 0;
+	decoder->buflen = 0;
+	decoder->dead = false;
+	decoder->callback = callback;
+	decoder->private = private;
+	decoder->nesting = 1;
+	decoder->pending = 0;
+	decoder->node.type = BSON_UNDEFINED;
+
+	/* read and discard document size */
+	if (read_int32(decoder, &junk))
+		CODER_KILL(decoder, "failed discarding length");
+
+	/* ready for decoding */
+	return 0;
+}
+
+int
+bson_decoder_fini(bson_decoder_t decoder)
+{
+	/* give back what was read ahead */
+	if (decoder->fd > -1 && decoder->buf != NULL && decoder->bufpos < decoder->buflen) {
+		off_t ahead = decoder->buflen - decoder->bufpos;
+
+		decoder->buflen = decoder->bufpos;
+
+		if (lseek(decoder->fd, -ahead, SEEK_CUR) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
 int
 bson_decoder_init_buf(bson_decoder_t decoder, void *buf, unsigned bufsize, bson_decoder_callback callback, void *private)
 {
@@ -140,6 +215,7 @@ bson_decoder_init_buf(bson_decoder_t decoder, void *buf, unsigned bufsize, bson_
 		decoder->bufsize = bufsize;
 	}
 	decoder->bufpos = 0;
+	decoder->buflen = decoder->bufsize;
 	decoder->callback = callback;
 	decoder->private = private;
 	decoder->nesting = 1;
@@ -295,26 +371,56 @@ bson_decoder_data_pending(bson_decoder_t decoder)
 	return decoder->pending;
 }
 
+static int
+flush_x(bson_encoder_t encoder)
+{
+	if ((encoder->bufpos > 0) &&
+	    (write(encoder->fd, encoder->buf, encoder->bufpos) != (int)encoder->bufpos))
+		return -1;
+
+	encoder->bufpos = 0;
+	return 0;
+}
+
 static int
 write_x(bson_encoder_t encoder, const void *p, size_t s)
 {
 	CODER_CHECK(encoder);
 
-	if (encoder->fd > -1)
-		return (write(encoder->fd, p, s) == (int)s) ? 0 : -1;
+	if (encoder->fd > -1) {
+		if (encoder->buf == NULL)
+			return (write(encoder->fd, p, s) == (int)s) ? 0 : -1;
+
+		/* buffered file writer, write out a full buffer */
+		if ((encoder->bufpos + s) > encoder->bufsize) {
+			if (flush_x(encoder))
+				return -1;
+
+			/* too big to be worth buffering */
+			if (s > encoder->bufsize)
+				return (write(encoder->fd, p, s) == (int)s) ? 0 : -1;
+		}
+
+		memcpy(encoder->buf + encoder->bufpos, p, s);
+		encoder->bufpos += s;
+		return 0;
+	}
 
 	/* do we need to extend the buffer? */
 	while ((encoder->bufpos + s) > encoder->bufsize) {
 		if (!encoder->realloc_ok)
 			CODER_KILL(encoder, "fixed-size buffer overflow");
 
-		uint8_t *newbuf = realloc(encoder->buf, encoder->bufsize + BSON_BUF_INCREMENT);
+		/* grow in proportion to the size, so that large documents are not copied over and over */
+		unsigned increment = (encoder->bufsize > BSON_BUF_INCREMENT) ? encoder->bufsize : BSON_BUF_INCREMENT;
+
+		uint8_t *newbuf = realloc(encoder->buf, encoder->bufsize + increment);
 		if (newbuf == NULL)
 			CODER_KILL(encoder, "could not grow buffer");
 
 		encoder->buf = newbuf;
-		encoder->bufsize += BSON_BUF_INCREMENT;
-		debug("allocated %d bytes", BSON_BUF_INCREMENT);
+		encoder->bufsize += increment;
+		debug("allocated %d bytes", increment);
 	}
 
 	memcpy(encoder->buf + encoder->bufpos, p, s);
@@ -364,6 +470,24 @@ bson_encoder_init_file(bson_encoder_t encoder, int fd)
 {
 	encoder->fd = fd;
 	encoder->buf = NULL;
+	encoder->bufsize = 0;
+	encoder->bufpos = 0;
+	encoder->dead = false;
+
+	if (write_int32(encoder, 0))
+		CODER_KILL(encoder, "write error on document length");
+
+	return 0;
+}
+
+int
+bson_encoder_init_file_buffered(bson_encoder_t encoder, int fd, void *buf, unsigned bufsize)
+{
+	encoder->fd = fd;
+	encoder->buf = (uint8_t *)buf;
+	encoder->bufsize = bufsize;
+	encoder->bufpos = 0;
+	encoder->realloc_ok = false;
 	encoder->dead = false;
 
 	if (write_int32(encoder, 0))
@@ -402,11 +526,16 @@ bson_encoder_fini(bson_encoder_t encoder)
 		CODER_KILL(encoder, "write error on document terminator");
 
 	/* hack to fix up length for in-buffer documents */
-	if (encoder->buf != NULL) {
+	if (encoder->fd < 0) {
 		int32_t len = bson_encoder_buf_size(encoder);
 		memcpy(encoder->buf, &len, sizeof(len));
+		return 0;
 	}
 
+	/* write out what is left of a buffered file writer */
+	if ((encoder->buf != NULL) && flush_x(encoder))
+		CODER_KILL(encoder, "write error on buffer flush");
+
 	/* sync file */
 	fsync(encoder->fd);
 
@@ -74,7 +74,8 @@ typedef enum bson_binary_subtype {
 #define BSON_MAXNAME		32
 
 /**
- * Buffer growth increment when writing to a buffer.
+ * Minimum buffer growth increment when writing to a buffer, larger buffers
+ * grow by their current size.
  */
 #define BSON_BUF_INCREMENT	128
 
@@ -105,10 +106,11 @@ struct bson_decoder_s {
 	/* file reader state */
 	int			fd;
 
-	/* buffer reader state */
+	/* buffer reader state, also the read buffer of a buffered file reader */
 	uint8_t			*buf;
 	size_t			bufsize;
 	unsigned		bufpos;
+	unsigned		buflen;		/**< valid bytes in the read buffer of a file reader */
 
 	bool			dead;
 	bson_decoder_callback	callback;
@@ -129,6 +131,35 @@ struct bson_decoder_s {
  */
 __EXPORT int bson_decoder_init_file(bson_decoder_t decoder, int fd, bson_decoder_callback callback, void *private);
 
+/**
+ * Initialise the decoder to read from a file in blocks.
+ *
+ * The file is read in blocks of bufsize bytes instead of one read per field.
+ * Call bson_decoder_fini when done to return the file position to the end
+ * of the document.
+ *
+ * @param decoder		Decoder state structure to be initialised.
+ * @param fd			File to read BSON data from.
+ * @param buf			Read buffer.
+ * @param bufsize		Size of the read buffer.
+ * @param callback		Callback to be invoked by bson_decoder_next
+ * @param private		Callback private data, stored in node.
+ * @return			Zero on success.
+ */
+__EXPORT int bson_decoder_init_file_buffered(bson_decoder_t decoder, int fd, void *buf, unsigned bufsize,
+		bson_decoder_callback callback, void *private);
+
+/**
+ * Finish decoding from a file.
+ *
+ * For a buffered file reader this seeks back over data which was read ahead,
+ * leaving the file positioned right after the decoded document.
+ *
+ * @param decoder		Decoder state.
+ * @return			Zero on success.
+ */
+__EXPORT int bson_decoder_fini(bson_decoder_t decoder);
+
 /**
  * Initialise the decoder to read from a buffer in memory.
  *
@@ -173,7 +204,7 @@ typedef struct bson_encoder_s {
 	/* file writer state */
 	int		fd;
 
-	/* buffer writer state */
+	/* buffer writer state, also the write buffer of a buffered file writer */
 	uint8_t		*buf;
 	unsigned	bufsize;
 	unsigned	bufpos;
@@ -192,6 +223,21 @@ typedef struct bson_encoder_s {
  */
 __EXPORT int bson_encoder_init_file(bson_encoder_t encoder, int fd);
 
+/**
+ * Initialise the encoder for writing to a file in blocks.
+ *
+ * Nodes are collected in the buffer and written bufsize bytes at a time
+ * instead of several writes per node. The rest is written by
+ * bson_encoder_fini, which must be called for the file to be complete.
+ *
+ * @param encoder		Encoder state structure to be initialised.
+ * @param fd			File to write to.
+ * @param buf			Write buffer.
+ * @param bufsize		Size of the write buffer.
+ * @return			Zero on success.
+ */
+__EXPORT int bson_encoder_init_file_buffered(bson_encoder_t encoder, int fd, void *buf, unsigned bufsize);
+
 /**
  * Initialze the encoder for writing to a buffer.
  *
@@ -0,0 +1,63 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file control_latency.c
+ *
+ * Sensor to actuator latency of the attitude control chain.
+ */
+
+#include <nuttx/config.h>
+
+#include "control_latency.h"
+
+bool control_latency_update(const struct actuator_controls_s *controls, hrt_abstime now,
+			    struct control_latency_s *latency)
+{
+	/* not every publisher of controls fills in the sample times */
+	if ((controls->timestamp_sample == 0) ||
+	    (controls->timestamp_attitude < controls->timestamp_sample) ||
+	    (controls->timestamp < controls->timestamp_attitude) ||
+	    (now < controls->timestamp) ||
+	    (now - controls->timestamp_sample > CONTROL_LATENCY_MAX))
+		return false;
+
+	latency->timestamp = now;
+	latency->timestamp_sample = controls->timestamp_sample;
+	latency->estimator = controls->timestamp_attitude - controls->timestamp_sample;
+	latency->controller = controls->timestamp - controls->timestamp_attitude;
+	latency->output = now - controls->timestamp;
+	latency->total = now - controls->timestamp_sample;
+
+	return true;
+}
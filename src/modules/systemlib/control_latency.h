@@ -0,0 +1,68 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file control_latency.h
+ *
+ * Sensor to actuator latency of the attitude control chain, for the
+ * output drivers.
+ */
+
+#ifndef CONTROL_LATENCY_H_
+#define CONTROL_LATENCY_H_
+
+#include <stdbool.h>
+#include <drivers/drv_hrt.h>
+#include <uORB/topics/actuator_controls.h>
+#include <uORB/topics/control_latency.h>
+
+/** longer than this the timestamps cannot belong together */
+#define CONTROL_LATENCY_MAX	500000
+
+__BEGIN_DECLS
+
+/**
+ * Work out the latency of outputs set from attitude controls.
+ *
+ * @param controls		The actuator controls the outputs were computed from.
+ * @param now			When the outputs were set.
+ * @param latency		Filled in on success.
+ * @return			true if the controls carry a sample time and it is
+ *				consistent with their other timestamps.
+ */
+__EXPORT bool control_latency_update(const struct actuator_controls_s *controls, hrt_abstime now,
+				     struct control_latency_s *latency);
+
+__END_DECLS
+
+#endif /* CONTROL_LATENCY_H_ */
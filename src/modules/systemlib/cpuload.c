@@ -43,10 +43,14 @@
  */
 #include <nuttx/config.h>
 #include <nuttx/sched.h>
+#include <nuttx/irq.h>
 
 #include <sys/types.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 
 #include <arch/arch.h>
 
@@ -56,6 +60,7 @@
 
 #include <arch/board/board.h>
 #include <drivers/drv_hrt.h>
+#include <uORB/topics/system_memory.h>
 
 #include "cpuload.h"
 
@@ -67,6 +72,11 @@ __EXPORT void sched_note_switch(FAR struct tcb_s *pFromTcb, FAR struct tcb_s *pT
 
 __EXPORT struct system_load_s system_load;
 
+__EXPORT struct sched_trace_s sched_trace;
+
+/** most heap in use at any cpuload_memory() call */
+static uint32_t heap_peak;
+
 extern FAR struct tcb_s *sched_gettcb(pid_t pid);
 
 void cpuload_initialize_once()
@@ -102,8 +112,128 @@ void cpuload_initialize_once()
 	}
 }
 
+/**
+ * Add an event to the trace ring; callable from any context.
+ */
+static void sched_trace_add(uint8_t type, int16_t a, int16_t b)
+{
+	irqstate_t flags = irqsave();
+
+	if (sched_trace.enabled) {
+		struct sched_trace_event_s *e = &sched_trace.events[sched_trace.next];
+
+		e->timestamp = hrt_absolute_time();
+		e->a = a;
+		e->b = b;
+		e->type = type;
+
+		if (++sched_trace.next >= sched_trace.size) {
+			sched_trace.next = 0;
+			sched_trace.wrapped = true;
+		}
+	}
+
+	irqrestore(flags);
+}
+
+int sched_trace_start(unsigned size)
+{
+	sched_trace.enabled = false;
+
+	if ((sched_trace.events == NULL) || (sched_trace.size != size)) {
+		free(sched_trace.events);
+		sched_trace.size = 0;
+		sched_trace.events = (struct sched_trace_event_s *)malloc(size * sizeof(struct sched_trace_event_s));
+
+		if (sched_trace.events == NULL)
+			return -ENOMEM;
+
+		sched_trace.size = size;
+	}
+
+	sched_trace.next = 0;
+	sched_trace.wrapped = false;
+	sched_trace.enabled = (size > 0);
+
+	return OK;
+}
+
+void sched_trace_stop(void)
+{
+	sched_trace.enabled = false;
+}
+
+void sched_trace_irq(int irq, bool enter)
+{
+	/* cheap enough to leave in interrupt handlers when not tracing */
+	if (sched_trace.enabled)
+		sched_trace_add(enter ? SCHED_TRACE_IRQ_ENTER : SCHED_TRACE_IRQ_EXIT, irq, 0);
+}
+
+unsigned cpuload_stack_used(FAR struct tcb_s *tcb, unsigned *size)
+{
+	unsigned stack_size = (uintptr_t)tcb->adj_stack_ptr - (uintptr_t)tcb->stack_alloc_ptr;
+	const uint8_t *stack = (const uint8_t *)tcb->stack_alloc_ptr;
+	unsigned stack_free = 0;
+
+	/* the stack grows down, so the untouched fill is at the bottom; sweep it a word at a time */
+	while ((stack_free + sizeof(uint32_t) <= stack_size) && (*(const uint32_t *)&stack[stack_free] == 0xffffffff))
+		stack_free += sizeof(uint32_t);
+
+	while ((stack_free < stack_size) && (stack[stack_free] == 0xff))
+		stack_free++;
+
+	*size = stack_size;
+	return stack_size - stack_free;
+}
+
+uint32_t cpuload_heap_sample(struct mallinfo *minfo)
+{
+	*minfo = mallinfo();
+
+	if ((uint32_t)minfo->uordblks > heap_peak)
+		heap_peak = minfo->uordblks;
+
+	return heap_peak;
+}
+
+void cpuload_memory(struct system_memory_s *mem)
+{
+	struct mallinfo minfo;
+
+	mem->heap_peak = cpuload_heap_sample(&minfo);
+	mem->heap_total = minfo.arena;
+	mem->heap_used = minfo.uordblks;
+	mem->heap_largest_free = minfo.mxordblk;
+	mem->task_count = 0;
+
+	/* tasks may come and go while we look at them */
+	sched_lock();
+
+	for (int i = 0; (i < CONFIG_MAX_TASKS) && (mem->task_count < SYSTEM_MEMORY_MAX_TASKS); i++) {
+		if (!system_load.tasks[i].valid)
+			continue;
+
+		struct system_memory_task_s *task = &mem->tasks[mem->task_count++];
+		unsigned stack_size;
+
+		task->pid = system_load.tasks[i].tcb->pid;
+		task->stack_used = cpuload_stack_used(system_load.tasks[i].tcb, &stack_size);
+		task->stack_size = stack_size;
+		memset(task->name, 0, sizeof(task->name));
+#if CONFIG_TASK_NAME_SIZE > 0
+		strncpy(task->name, system_load.tasks[i].tcb->name, sizeof(task->name) - 1);
+#endif
+	}
+
+	sched_unlock();
+}
+
 void sched_note_start(FAR struct tcb_s *tcb)
 {
+	if (sched_trace.enabled)
+		sched_trace_add(SCHED_TRACE_TASK_START, tcb->pid, 0);
+
 	/* search first free slot */
 	int i;
 
@@ -125,6 +255,9 @@ void sched_note_stop(FAR struct tcb_s *tcb)
 {
 	int i;
 
+	if (sched_trace.enabled)
+		sched_trace_add(SCHED_TRACE_TASK_STOP, tcb->pid, 0);
+
 	for (i = 1; i < CONFIG_MAX_TASKS; i++) {
 		if (system_load.tasks[i].tcb->pid == tcb->pid) {
 			/* mark slot as fee */
@@ -142,6 +275,9 @@ void sched_note_switch(FAR struct tcb_s *pFromTcb, FAR struct tcb_s *pToTcb)
 {
 	uint64_t new_time = hrt_absolute_time();
 
+	if (sched_trace.enabled)
+		sched_trace_add(SCHED_TRACE_SWITCH, pFromTcb->pid, pToTcb->pid);
+
 	/* Kind of inefficient: find both tasks and update times */
 	uint8_t both_found = 0;
 
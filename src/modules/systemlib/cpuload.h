@@ -38,6 +38,7 @@
 __BEGIN_DECLS
 
 #include <nuttx/sched.h>
+#include <stdlib.h>
 
 struct system_load_taskinfo_s {
 	uint64_t total_runtime;			///< Runtime since start (start_time - total_runtime)/(start_time - current_time) = load
@@ -60,6 +61,91 @@ __EXPORT extern struct system_load_s system_load;
 
 __EXPORT void cpuload_initialize_once(void);
 
+/**
+ * Stack use of a task, from the 0xff fill of its stack at creation.
+ *
+ * @param tcb		The task.
+ * @param size		Set to the stack size.
+ * @return		Bytes of the stack used at some point.
+ */
+__EXPORT unsigned cpuload_stack_used(FAR struct tcb_s *tcb, unsigned *size);
+
+/**
+ * Sample heap use.
+ *
+ * @param minfo		Set to the heap state.
+ * @return		The most heap in use at any sample since boot.
+ */
+__EXPORT uint32_t cpuload_heap_sample(struct mallinfo *minfo);
+
+struct system_memory_s;
+
+/**
+ * Take a sample of heap use and of the stack use of all tasks.
+ *
+ * The heap peak is the most seen by any caller, so it is only as good
+ * as the sampling rate.
+ *
+ * @param mem		Filled in, except for the timestamp.
+ */
+__EXPORT void cpuload_memory(struct system_memory_s *mem);
+
+/**
+ * Scheduler trace event types.
+ */
+enum sched_trace_type {
+	SCHED_TRACE_SWITCH = 0,		///< context switch, a: pid switched from, b: pid switched to
+	SCHED_TRACE_IRQ_ENTER,		///< interrupt handler entered, a: irq number
+	SCHED_TRACE_IRQ_EXIT,		///< interrupt handler left, a: irq number
+	SCHED_TRACE_TASK_START,		///< task started, a: pid
+	SCHED_TRACE_TASK_STOP		///< task stopped, a: pid
+};
+
+struct sched_trace_event_s {
+	uint64_t timestamp;			///< hrt time of the event
+	int16_t a;				///< first argument, see sched_trace_type
+	int16_t b;				///< second argument, see sched_trace_type
+	uint8_t type;				///< sched_trace_type
+};
+
+/**
+ * Ring of the most recent scheduler events, only filled while enabled.
+ */
+struct sched_trace_s {
+	struct sched_trace_event_s *events;	///< the ring, allocated by sched_trace_start()
+	unsigned size;				///< number of events the ring holds
+	unsigned next;				///< index the next event goes to
+	bool wrapped;				///< older events have been overwritten
+	volatile bool enabled;			///< events are being recorded
+};
+
+__EXPORT extern struct sched_trace_s sched_trace;
+
+/**
+ * Start recording scheduler events, from thread context.
+ *
+ * Any previous trace is discarded.
+ *
+ * @param size		Number of events the ring holds.
+ * @return		OK, or -ENOMEM if the ring could not be allocated.
+ */
+__EXPORT int sched_trace_start(unsigned size);
+
+/**
+ * Stop recording scheduler events, keeping the trace for reading.
+ */
+__EXPORT void sched_trace_stop(void);
+
+/**
+ * Record an interrupt handler entry or exit.
+ *
+ * For handlers whose timing matters, call at their start and end.
+ *
+ * @param irq		The irq number.
+ * @param enter		true on entry, false on exit.
+ */
+__EXPORT void sched_trace_irq(int irq, bool enter);
+
 __END_DECLS
 
 #endif
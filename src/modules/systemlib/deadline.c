@@ -0,0 +1,181 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file deadline.c
+ *
+ * Deadline monitoring of periodic tasks.
+ */
+
+#include <nuttx/config.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/queue.h>
+
+#include "deadline.h"
+
+struct deadline_s {
+	sq_entry_t		link;		/**< list linkage */
+	const char		*name;
+	uint32_t		period;
+	uint32_t		budget;
+	hrt_abstime		time_begin;	/**< start of the current iteration */
+	hrt_abstime		time_last;	/**< start of the previous iteration */
+	hrt_abstime		time_overrun;	/**< last iteration over budget */
+	hrt_abstime		time_miss;	/**< last iteration started late */
+	uint32_t		iterations;
+	uint32_t		overruns;
+	uint32_t		misses;
+	uint32_t		exec_max;
+};
+
+/**
+ * List of all monitors.
+ */
+static sq_queue_t	deadlines;
+
+deadline_t
+deadline_alloc(const char *name, uint32_t period, uint32_t budget)
+{
+	deadline_t handle = (deadline_t)calloc(sizeof(struct deadline_s), 1);
+
+	if (handle == NULL)
+		return NULL;
+
+	handle->name = name;
+	handle->period = period;
+	handle->budget = budget;
+
+	sched_lock();
+	sq_addfirst(&handle->link, &deadlines);
+	sched_unlock();
+
+	return handle;
+}
+
+void
+deadline_free(deadline_t handle)
+{
+	if (handle == NULL)
+		return;
+
+	sched_lock();
+	sq_rem(&handle->link, &deadlines);
+	sched_unlock();
+
+	free(handle);
+}
+
+void
+deadline_begin(deadline_t handle)
+{
+	if (handle == NULL)
+		return;
+
+	hrt_abstime now = hrt_absolute_time();
+
+	if ((handle->time_last != 0) && (now - handle->time_last > handle->period)) {
+		handle->misses++;
+		handle->time_miss = now;
+	}
+
+	handle->time_last = now;
+	handle->time_begin = now;
+}
+
+void
+deadline_end(deadline_t handle)
+{
+	if ((handle == NULL) || (handle->time_begin == 0))
+		return;
+
+	hrt_abstime elapsed = hrt_absolute_time() - handle->time_begin;
+
+	if (elapsed > handle->budget) {
+		handle->overruns++;
+		handle->time_overrun = handle->time_begin + elapsed;
+	}
+
+	if (elapsed > handle->exec_max)
+		handle->exec_max = elapsed;
+
+	handle->iterations++;
+	handle->time_begin = 0;
+}
+
+const char *
+deadline_failing(hrt_abstime since, bool misses_only)
+{
+	const char *name = NULL;
+
+	sched_lock();
+
+	for (deadline_t handle = (deadline_t)sq_peek(&deadlines); handle != NULL;
+	     handle = (deadline_t)sq_next(&handle->link)) {
+		if ((handle->time_miss > since) || (!misses_only && (handle->time_overrun > since))) {
+			name = handle->name;
+			break;
+		}
+	}
+
+	sched_unlock();
+
+	return name;
+}
+
+void
+deadline_status(struct deadline_status_s *status)
+{
+	status->count = 0;
+
+	sched_lock();
+
+	for (deadline_t handle = (deadline_t)sq_peek(&deadlines);
+	     (handle != NULL) && (status->count < DEADLINE_STATUS_MAX);
+	     handle = (deadline_t)sq_next(&handle->link)) {
+		struct deadline_monitor_s *monitor = &status->monitors[status->count++];
+
+		strncpy(monitor->name, handle->name, sizeof(monitor->name));
+		monitor->period = handle->period;
+		monitor->budget = handle->budget;
+		monitor->iterations = handle->iterations;
+		monitor->overruns = handle->overruns;
+		monitor->misses = handle->misses;
+		monitor->exec_max = handle->exec_max;
+		monitor->last_fault = (handle->time_miss > handle->time_overrun) ? handle->time_miss : handle->time_overrun;
+	}
+
+	sched_unlock();
+}
@@ -0,0 +1,108 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file deadline.h
+ *
+ * Deadline monitoring of periodic tasks.
+ *
+ * A task declares the longest acceptable time between two iterations and
+ * the time an iteration may take, then brackets every iteration with
+ * deadline_begin and deadline_end. Iterations that take longer than the
+ * budget count as overruns, iterations that start late count as misses.
+ */
+
+#ifndef DEADLINE_H_
+#define DEADLINE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <drivers/drv_hrt.h>
+#include <uORB/topics/deadline_status.h>
+
+__BEGIN_DECLS
+
+struct deadline_s;
+typedef struct deadline_s	*deadline_t;
+
+/**
+ * Create a new deadline monitor.
+ *
+ * @param name			Name reported for the monitor, not copied.
+ * @param period		Longest acceptable time between two iterations in microseconds.
+ * @param budget		Longest acceptable duration of an iteration in microseconds.
+ * @return			Handle for the monitor, or NULL if no memory.
+ */
+__EXPORT extern deadline_t	deadline_alloc(const char *name, uint32_t period, uint32_t budget);
+
+/**
+ * Free a deadline monitor.
+ *
+ * @param handle		The handle returned from deadline_alloc.
+ */
+__EXPORT extern void		deadline_free(deadline_t handle);
+
+/**
+ * Mark the start of an iteration.
+ *
+ * @param handle		The handle returned from deadline_alloc.
+ */
+__EXPORT extern void		deadline_begin(deadline_t handle);
+
+/**
+ * Mark the end of an iteration.
+ *
+ * @param handle		The handle returned from deadline_alloc.
+ */
+__EXPORT extern void		deadline_end(deadline_t handle);
+
+/**
+ * Find a monitor that overran or missed its period recently.
+ *
+ * @param since			Only consider events after this time.
+ * @param misses_only		Ignore budget overruns.
+ * @return			The name of the first such monitor, or NULL if all kept their deadlines.
+ */
+__EXPORT extern const char	*deadline_failing(hrt_abstime since, bool misses_only);
+
+/**
+ * Fill a status report with all monitors.
+ *
+ * @param status		The report, the timestamp is left to the caller.
+ */
+__EXPORT extern void		deadline_status(struct deadline_status_s *status);
+
+__END_DECLS
+
+#endif /* DEADLINE_H_ */
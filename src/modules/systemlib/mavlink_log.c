@@ -46,75 +46,162 @@
 
 #include <mavlink/mavlink_log.h>
 
+/*
+ * The buffer is a bounded multi-producer queue after Dmitry Vyukov. Each
+ * slot carries the position it is ready for: a slot at position p can be
+ * written when its seq is p, and read when its seq is p + 1. Writers claim
+ * a position by advancing head with a compare and swap, fill the slot and
+ * then publish it through seq; the reader releases the slot for the
+ * position one lap later. A writer that is preempted between claiming and
+ * publishing only delays the reader, messages behind it stay queued.
+ */
+
 __EXPORT void mavlink_logbuffer_init(struct mavlink_logbuffer *lb, int size)
 {
-	lb->size  = size;
-	lb->start = 0;
-	lb->count = 0;
-	lb->elems = calloc(lb->size, sizeof(struct mavlink_logmessage));
+	unsigned n = 1;
+
+	while (n < (unsigned)size) {
+		n <<= 1;
+	}
+
+	lb->size    = n;
+	lb->head    = 0;
+	lb->tail    = 0;
+	lb->dropped = 0;
+	lb->elems   = (struct mavlink_logslot *)calloc(lb->size, sizeof(struct mavlink_logslot));
+
+	if (lb->elems == NULL) {
+		lb->size = 0;
+		return;
+	}
+
+	for (unsigned i = 0; i < lb->size; i++) {
+		lb->elems[i].seq = i;
+	}
 }
 
 __EXPORT void mavlink_logbuffer_destroy(struct mavlink_logbuffer *lb)
 {
 	lb->size  = 0;
-	lb->start = 0;
-	lb->count = 0;
+	lb->head  = 0;
+	lb->tail  = 0;
 	free(lb->elems);
+	lb->elems = NULL;
 }
 
 __EXPORT int mavlink_logbuffer_is_full(struct mavlink_logbuffer *lb)
 {
-	return lb->count == (int)lb->size;
+	return (lb->head - lb->tail) >= lb->size;
 }
 
 __EXPORT int mavlink_logbuffer_is_empty(struct mavlink_logbuffer *lb)
 {
-	return lb->count == 0;
+	if (lb->size == 0) {
+		return 1;
+	}
+
+	unsigned pos = lb->tail;
+	return (int)(lb->elems[pos & (lb->size - 1)].seq - (pos + 1)) < 0;
 }
 
-__EXPORT void mavlink_logbuffer_write(struct mavlink_logbuffer *lb, const struct mavlink_logmessage *elem)
+/**
+ * Claim a slot for a message of the given severity.
+ *
+ * @return		The slot, or NULL if the message has to be dropped.
+ */
+static struct mavlink_logslot *mavlink_logbuffer_claim(struct mavlink_logbuffer *lb, int severity, unsigned *pos_out)
 {
-	int end = (lb->start + lb->count) % lb->size;
-	memcpy(&(lb->elems[end]), elem, sizeof(struct mavlink_logmessage));
+	if (lb->size == 0) {
+		return NULL;
+	}
 
-	if (mavlink_logbuffer_is_full(lb)) {
-		lb->start = (lb->start + 1) % lb->size; /* full, overwrite */
+	/* less severe messages leave the last quarter to critical ones */
+	unsigned limit = (severity > MAVLINK_LOG_RESERVED_SEVERITY) ? lb->size - (lb->size + 3) / 4 : lb->size;
+	unsigned pos = lb->head;
 
-	} else {
-		++lb->count;
+	for (;;) {
+		struct mavlink_logslot *slot = &lb->elems[pos & (lb->size - 1)];
+		int dif = (int)(slot->seq - pos);
+
+		if (dif == 0) {
+			if ((pos - lb->tail) >= limit) {
+				break;
+			}
+
+			if (__sync_bool_compare_and_swap(&lb->head, pos, pos + 1)) {
+				*pos_out = pos;
+				return slot;
+			}
+
+		} else if (dif < 0) {
+			/* the slot still holds the message from the previous lap, full */
+			break;
+		}
+
+		pos = lb->head;
 	}
+
+	__sync_fetch_and_add(&lb->dropped, 1);
+	return NULL;
 }
 
-__EXPORT int mavlink_logbuffer_read(struct mavlink_logbuffer *lb, struct mavlink_logmessage *elem)
+static void mavlink_logbuffer_publish(struct mavlink_logslot *slot, unsigned pos)
 {
-	if (!mavlink_logbuffer_is_empty(lb)) {
-		memcpy(elem, &(lb->elems[lb->start]), sizeof(struct mavlink_logmessage));
-		lb->start = (lb->start + 1) % lb->size;
-		--lb->count;
+	__sync_synchronize();
+	slot->seq = pos + 1;
+}
+
+__EXPORT int mavlink_logbuffer_write(struct mavlink_logbuffer *lb, const struct mavlink_logmessage *elem)
+{
+	unsigned pos;
+	struct mavlink_logslot *slot = mavlink_logbuffer_claim(lb, elem->severity, &pos);
+
+	if (slot == NULL) {
+		return 1;
+	}
 
-		return 0;
+	memcpy(&slot->msg, elem, sizeof(struct mavlink_logmessage));
+	mavlink_logbuffer_publish(slot, pos);
 
-	} else {
+	return 0;
+}
+
+__EXPORT int mavlink_logbuffer_read(struct mavlink_logbuffer *lb, struct mavlink_logmessage *elem)
+{
+	if (mavlink_logbuffer_is_empty(lb)) {
 		return 1;
 	}
+
+	unsigned pos = lb->tail;
+	struct mavlink_logslot *slot = &lb->elems[pos & (lb->size - 1)];
+
+	__sync_synchronize();
+	memcpy(elem, &slot->msg, sizeof(struct mavlink_logmessage));
+	__sync_synchronize();
+
+	/* hand the slot back to the writers for the next lap */
+	slot->seq = pos + lb->size;
+	lb->tail = pos + 1;
+
+	return 0;
 }
 
 __EXPORT void mavlink_logbuffer_vasprintf(struct mavlink_logbuffer *lb, int severity, const char *fmt, ...)
 {
+	unsigned pos;
+	struct mavlink_logslot *slot = mavlink_logbuffer_claim(lb, severity, &pos);
+
+	if (slot == NULL) {
+		return;
+	}
+
 	va_list ap;
 	va_start(ap, fmt);
-	int end = (lb->start + lb->count) % lb->size;
-	lb->elems[end].severity = severity;
-	vsnprintf(lb->elems[end].text, sizeof(lb->elems[0].text), fmt, ap);
+	slot->msg.severity = severity;
+	vsnprintf(slot->msg.text, sizeof(slot->msg.text), fmt, ap);
 	va_end(ap);
 
-	/* increase count */
-	if (mavlink_logbuffer_is_full(lb)) {
-		lb->start = (lb->start + 1) % lb->size; /* full, overwrite */
-
-	} else {
-		++lb->count;
-	}
+	mavlink_logbuffer_publish(slot, pos);
 }
 
 __EXPORT void mavlink_vasprintf(int _fd, int severity, const char *fmt, ...)
@@ -0,0 +1,191 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mem_pool.c
+ *
+ * Fixed-block memory pools.
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/irq.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem_pool.h"
+
+/**
+ * List of all pools that have been used.
+ */
+static struct mem_pool_s	*mem_pools;
+
+/**
+ * Allocate the chunk of a pool and thread its free list.
+ */
+static bool
+mem_pool_setup(struct mem_pool_s *pool)
+{
+	/* blocks carry the free list link and must stay aligned for any object */
+	size_t size = (pool->block_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+	if (size < sizeof(void *))
+		size = sizeof(void *);
+
+	uint8_t *blocks = (uint8_t *)malloc(size * pool->block_count);
+
+	if (blocks == NULL)
+		return false;
+
+	irqstate_t flags = irqsave();
+
+	/* another thread may have set it up in the meantime */
+	if (pool->blocks != NULL) {
+		irqrestore(flags);
+		free(blocks);
+		return true;
+	}
+
+	pool->block_size = size;
+
+	for (unsigned i = pool->block_count; i > 0; i--) {
+		void *block = blocks + (i - 1) * size;
+		*(void **)block = pool->free_list;
+		pool->free_list = block;
+	}
+
+	pool->blocks = blocks;
+	pool->next = mem_pools;
+	mem_pools = pool;
+
+	irqrestore(flags);
+
+	return true;
+}
+
+static bool
+mem_pool_owns(const struct mem_pool_s *pool, const void *block)
+{
+	return (pool->blocks != NULL) &&
+	       ((const uint8_t *)block >= pool->blocks) &&
+	       ((const uint8_t *)block < pool->blocks + pool->block_size * pool->block_count);
+}
+
+void *
+mem_pool_alloc(struct mem_pool_s *pool)
+{
+	if ((pool->blocks == NULL) && !mem_pool_setup(pool))
+		return malloc(pool->block_size);
+
+	irqstate_t flags = irqsave();
+
+	void *block = pool->free_list;
+
+	if (block != NULL) {
+		pool->free_list = *(void **)block;
+		pool->in_use++;
+
+		if (pool->in_use > pool->max_in_use)
+			pool->max_in_use = pool->in_use;
+
+	} else {
+		pool->fallbacks++;
+	}
+
+	irqrestore(flags);
+
+	if (block == NULL)
+		block = malloc(pool->block_size);
+
+	return block;
+}
+
+void
+mem_pool_free(struct mem_pool_s *pool, void *block)
+{
+	if (block == NULL)
+		return;
+
+	if (!mem_pool_owns(pool, block)) {
+		free(block);
+		return;
+	}
+
+	irqstate_t flags = irqsave();
+	*(void **)block = pool->free_list;
+	pool->free_list = block;
+	pool->in_use--;
+	irqrestore(flags);
+}
+
+void *
+mem_pool_alloc_sized(struct mem_pool_s *pools, unsigned count, size_t size)
+{
+	for (unsigned i = 0; i < count; i++) {
+		if (size <= pools[i].block_size)
+			return mem_pool_alloc(&pools[i]);
+	}
+
+	return malloc(size);
+}
+
+void
+mem_pool_free_sized(struct mem_pool_s *pools, unsigned count, void *block)
+{
+	if (block == NULL)
+		return;
+
+	for (unsigned i = 0; i < count; i++) {
+		if (mem_pool_owns(&pools[i], block)) {
+			mem_pool_free(&pools[i], block);
+			return;
+		}
+	}
+
+	free(block);
+}
+
+void
+mem_pool_print_all(int fd)
+{
+	for (struct mem_pool_s *pool = mem_pools; pool != NULL; pool = pool->next) {
+		dprintf(fd, "%s: %u byte blocks, %u of %u used, max %u, %u from heap\n",
+			pool->name,
+			(unsigned)pool->block_size,
+			pool->in_use,
+			pool->block_count,
+			pool->max_in_use,
+			pool->fallbacks);
+	}
+}
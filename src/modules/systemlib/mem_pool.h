@@ -0,0 +1,128 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file mem_pool.h
+ *
+ * Fixed-block memory pools.
+ *
+ * A pool hands out blocks of one size from a single chunk that is
+ * allocated on first use and never given back, so allocation takes
+ * constant time and repeated allocation and release does not fragment the
+ * heap. When a pool is exhausted, allocations fall back to the heap and
+ * are counted, so its size can be tuned from the statistics.
+ *
+ * Pools for different sizes can be grouped into size classes, ordered by
+ * block size, for objects whose size varies such as derived classes.
+ */
+
+#ifndef MEM_POOL_H_
+#define MEM_POOL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+__BEGIN_DECLS
+
+struct mem_pool_s {
+	struct mem_pool_s	*next;		/**< list of all pools that have been used */
+	const char		*name;		/**< owner reported in the statistics, not copied */
+	size_t			block_size;
+	unsigned		block_count;
+	uint8_t			*blocks;	/**< the chunk, NULL until the first allocation */
+	void			*free_list;	/**< free blocks, linked through their first word */
+	unsigned		in_use;		/**< blocks handed out */
+	unsigned		max_in_use;	/**< most blocks handed out at once */
+	unsigned		fallbacks;	/**< allocations served by the heap because the pool was full */
+};
+
+/**
+ * Static initialiser for a pool.
+ *
+ * @param _name			Owner reported in the statistics.
+ * @param _size			Size of a block in bytes.
+ * @param _count		Number of blocks.
+ */
+#define MEM_POOL_INITIALIZER(_name, _size, _count) \
+	{ NULL, (_name), (_size), (_count), NULL, NULL, 0, 0, 0 }
+
+/**
+ * Allocate a block.
+ *
+ * Safe to call from any thread, but not from interrupt context, as it may
+ * allocate from the heap.
+ *
+ * @param pool			The pool.
+ * @return			A block of at least pool->block_size bytes, or NULL if no memory.
+ */
+__EXPORT extern void		*mem_pool_alloc(struct mem_pool_s *pool);
+
+/**
+ * Release a block allocated with mem_pool_alloc.
+ *
+ * @param pool			The pool it was allocated from.
+ * @param block			The block, may be NULL.
+ */
+__EXPORT extern void		mem_pool_free(struct mem_pool_s *pool, void *block);
+
+/**
+ * Allocate from the smallest size class that fits.
+ *
+ * @param pools			Pools ordered by increasing block size.
+ * @param count			Number of pools.
+ * @param size			Bytes needed, larger than all classes goes to the heap.
+ * @return			The allocation, or NULL if no memory.
+ */
+__EXPORT extern void		*mem_pool_alloc_sized(struct mem_pool_s *pools, unsigned count, size_t size);
+
+/**
+ * Release an allocation from mem_pool_alloc_sized.
+ *
+ * @param pools			The pools it was allocated from.
+ * @param count			Number of pools.
+ * @param block			The allocation, may be NULL.
+ */
+__EXPORT extern void		mem_pool_free_sized(struct mem_pool_s *pools, unsigned count, void *block);
+
+/**
+ * Print the statistics of all pools that have been used.
+ *
+ * @param fd			File descriptor to print to.
+ */
+__EXPORT extern void		mem_pool_print_all(int fd);
+
+__END_DECLS
+
+#endif /* MEM_POOL_H_ */
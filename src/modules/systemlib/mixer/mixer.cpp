@@ -55,6 +55,83 @@
 
 #include "mixer.h"
 
+MixerArena::MixerArena(size_t size) :
+	_buf((uint8_t *)malloc(size)),
+	_size((_buf != nullptr) ? size : 0),
+	_used(0)
+{
+}
+
+MixerArena::~MixerArena()
+{
+	free(_buf);
+}
+
+void *
+MixerArena::alloc(size_t size)
+{
+	/* keep every allocation aligned for any member type */
+	size = (size + 7) & ~(size_t)7;
+
+	if (size > _size - _used)
+		return nullptr;
+
+	void *ptr = _buf + _used;
+	_used += size;
+
+	return ptr;
+}
+
+void
+MixerArena::release(void *ptr)
+{
+	uint8_t *p = (uint8_t *)ptr;
+
+	if ((p >= _buf) && (p < _buf + _used))
+		_used = p - _buf;
+}
+
+void *
+Mixer::operator new(size_t size) throw()
+{
+	return malloc(size);
+}
+
+void *
+Mixer::operator new(size_t size, MixerArena *arena) throw()
+{
+	return alloc(arena, size);
+}
+
+void
+Mixer::operator delete(void *ptr)
+{
+	free(ptr);
+}
+
+void
+Mixer::operator delete(void *ptr, MixerArena *arena)
+{
+	release(arena, ptr);
+}
+
+void *
+Mixer::alloc(MixerArena *arena, size_t size)
+{
+	return (arena != nullptr) ? arena->alloc(size) : malloc(size);
+}
+
+void
+Mixer::release(MixerArena *arena, void *ptr)
+{
+	if (arena != nullptr) {
+		arena->release(ptr);
+
+	} else {
+		free(ptr);
+	}
+}
+
 Mixer::Mixer(ControlCallback control_cb, uintptr_t cb_handle) :
 	_next(nullptr),
 	_control_cb(control_cb),
@@ -143,6 +220,16 @@ Mixer::skipline(const char *buf, unsigned &buflen)
 	return nullptr;
 }
 
+void
+Mixer::scaler_from_binary(const mixer_bin_scaler_s &bin, mixer_scaler_s &scaler)
+{
+	scaler.negative_scale	= bin.negative_scale / 10000.0f;
+	scaler.positive_scale	= bin.positive_scale / 10000.0f;
+	scaler.offset		= bin.offset / 10000.0f;
+	scaler.min_output	= bin.min_output / 10000.0f;
+	scaler.max_output	= bin.max_output / 10000.0f;
+}
+
 /****************************************************************************/
 
 NullMixer::NullMixer() :
@@ -168,7 +255,7 @@ NullMixer::groups_required(uint32_t &groups)
 }
 
 NullMixer *
-NullMixer::from_text(const char *buf, unsigned &buflen)
+NullMixer::from_text(const char *buf, unsigned &buflen, MixerArena *arena)
 {
 	NullMixer *nm = nullptr;
 
@@ -188,9 +275,22 @@ NullMixer::from_text(const char *buf, unsigned &buflen)
 	}
 
 	if ((buflen >= 2) && (buf[0] == 'Z') && (buf[1] == ':')) {
-		nm = new NullMixer;
+		nm = new (arena) NullMixer;
 		buflen -= 2;
 	}
 
 	return nm;
 }
+
+NullMixer *
+NullMixer::from_binary(const uint8_t *buf, unsigned &buflen, MixerArena *arena)
+{
+	NullMixer *nm = nullptr;
+
+	if ((buflen >= 1) && (buf[0] == MIXER_BIN_NULL)) {
+		nm = new (arena) NullMixer;
+		buflen -= 1;
+	}
+
+	return nm;
+}
@@ -133,6 +133,60 @@
 
 #include <uORB/topics/multirotor_motor_limits.h>
 
+/**
+ * Fixed memory that mixers are built in instead of on the heap.
+ *
+ * Allocations are taken in order and given back all at once with reset(),
+ * so reloading the mixers in an arena neither allocates nor fragments the
+ * heap. Mixers built in an arena are never destroyed one by one; they must
+ * not hold anything that would have to be released.
+ */
+class __EXPORT MixerArena
+{
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param size			Size of the arena in bytes, allocated once.
+	 */
+	MixerArena(size_t size);
+	~MixerArena();
+
+	/**
+	 * Allocate from the arena.
+	 *
+	 * @param size			Number of bytes needed.
+	 * @return			The memory, or nullptr if the arena is full.
+	 */
+	void				*alloc(size_t size);
+
+	/**
+	 * Give back an allocation and everything allocated after it.
+	 *
+	 * @param ptr			Memory returned by alloc.
+	 */
+	void				release(void *ptr);
+
+	/**
+	 * Give back all allocations.
+	 */
+	void				reset() { _used = 0; }
+
+	/**
+	 * Number of bytes in use.
+	 */
+	size_t				used() const { return _used; }
+
+private:
+	uint8_t				*_buf;
+	size_t				_size;
+	size_t				_used;
+
+	/* do not allow to copy due to pointer data members */
+	MixerArena(const MixerArena&);
+	MixerArena& operator=(const MixerArena&);
+};
+
 #include "mixer_load.h"
 
 /**
@@ -184,6 +238,19 @@ public:
 	 */
 	virtual void			groups_required(uint32_t &groups) = 0;
 
+	/**
+	 * Allocate a mixer from the heap, as plain new does.
+	 */
+	static void			*operator new(size_t size) throw();
+
+	/**
+	 * Allocate a mixer from an arena, or from the heap if arena is nullptr.
+	 */
+	static void			*operator new(size_t size, MixerArena *arena) throw();
+
+	static void			operator delete(void *ptr);
+	static void			operator delete(void *ptr, MixerArena *arena);
+
 protected:
 	/** client-supplied callback used when fetching control values */
 	ControlCallback			_control_cb;
@@ -233,6 +300,24 @@ protected:
 	 */
 	static const char *		skipline(const char *buf, unsigned &buflen);
 
+	/**
+	 * Convert a scaler from its binary description.
+	 *
+	 * @param bin			The binary scaler.
+	 * @param scaler		Filled in from bin.
+	 */
+	static void			scaler_from_binary(const mixer_bin_scaler_s &bin, mixer_scaler_s &scaler);
+
+	/**
+	 * Allocate mixer data from an arena, or from the heap if arena is nullptr.
+	 */
+	static void			*alloc(MixerArena *arena, size_t size);
+
+	/**
+	 * Give back mixer data obtained with alloc.
+	 */
+	static void			release(MixerArena *arena, void *ptr);
+
 private:
 
 	/* do not allow to copy due to prt data members */
@@ -247,7 +332,16 @@ private:
 class __EXPORT MixerGroup : public Mixer
 {
 public:
-	MixerGroup(ControlCallback control_cb, uintptr_t cb_handle);
+	/**
+	 * Constructor.
+	 *
+	 * @param control_cb		Callback invoked when reading controls.
+	 * @param cb_handle		Passed to control_cb.
+	 * @param arena_size		If nonzero, the mixers loaded into the group
+	 *				are built in an arena of this many bytes
+	 *				rather than on the heap.
+	 */
+	MixerGroup(ControlCallback control_cb, uintptr_t cb_handle, size_t arena_size = 0);
 	~MixerGroup();
 
 	virtual unsigned		mix(float *outputs, unsigned space);
@@ -265,6 +359,11 @@ public:
 	 */
 	void				reset();
 
+	/**
+	 * The arena the mixers of the group are built in, nullptr for the heap.
+	 */
+	MixerArena			*arena() { return _arena; }
+
 	/**
 	 * Count the mixers in the group.
 	 */
@@ -312,8 +411,23 @@ public:
 	 */
 	int				load_from_buf(const char *buf, unsigned &buflen);
 
+	/**
+	 * Adds mixers to the group based on a binary description in a buffer.
+	 *
+	 * The records are described in drivers/drv_mixer.h; Tools/px_mixer_bin.py
+	 * generates them from the text format above.
+	 *
+	 * @param buf			The binary mixer records.
+	 * @param buflen		The length of the buffer, updated to reflect
+	 *				bytes as they are consumed. A record not yet
+	 *				complete is left in the buffer.
+	 * @return			Zero if any mixer was loaded, nonzero otherwise.
+	 */
+	int				load_from_bin(const void *buf, unsigned &buflen);
+
 private:
 	Mixer				*_first;	/**< linked list of mixers */
+	MixerArena			*_arena;	/**< where the mixers are built, nullptr for the heap */
 
 	/* do not allow to copy due to pointer data members */
 	MixerGroup(const MixerGroup&);
@@ -341,10 +455,23 @@ public:
 	 *				the mixer.
 	 * @param buflen		Length of the buffer in bytes, adjusted
 	 *				to reflect the bytes consumed.
+	 * @param arena			Arena to build the mixer in, nullptr for the heap.
 	 * @return			A new NullMixer instance, or nullptr
 	 *				if the text format is bad.
 	 */
-	static NullMixer		*from_text(const char *buf, unsigned &buflen);
+	static NullMixer		*from_text(const char *buf, unsigned &buflen, MixerArena *arena = nullptr);
+
+	/**
+	 * Factory method for binary descriptions.
+	 *
+	 * @param buf			Buffer starting with a MIXER_BIN_NULL record.
+	 * @param buflen		Length of the buffer in bytes, adjusted
+	 *				to reflect the bytes consumed.
+	 * @param arena			Arena to build the mixer in, nullptr for the heap.
+	 * @return			A new NullMixer instance, or nullptr
+	 *				if the record is incomplete.
+	 */
+	static NullMixer		*from_binary(const uint8_t *buf, unsigned &buflen, MixerArena *arena = nullptr);
 
 	virtual unsigned		mix(float *outputs, unsigned space);
 	virtual void			groups_required(uint32_t &groups);
@@ -383,13 +510,50 @@ public:
 	 *				the mixer.
 	 * @param buflen		Length of the buffer in bytes, adjusted
 	 *				to reflect the bytes consumed.
+	 * @param arena			Arena to build the mixer in, nullptr for the heap.
 	 * @return			A new SimpleMixer instance, or nullptr
 	 *				if the text format is bad.
 	 */
 	static SimpleMixer		*from_text(Mixer::ControlCallback control_cb,
 			uintptr_t cb_handle,
 			const char *buf,
-			unsigned &buflen);
+			unsigned &buflen,
+			MixerArena *arena = nullptr);
+
+	/**
+	 * Factory method for binary descriptions.
+	 *
+	 * @param control_cb		The callback to invoke when fetching a
+	 *				control value.
+	 * @param cb_handle		Handle passed to the control callback.
+	 * @param buf			Buffer starting with a MIXER_BIN_SIMPLE record.
+	 * @param buflen		Length of the buffer in bytes, adjusted
+	 *				to reflect the bytes consumed.
+	 * @param arena			Arena to build the mixer in, nullptr for the heap.
+	 * @return			A new SimpleMixer instance, or nullptr
+	 *				if the record is incomplete.
+	 */
+	static SimpleMixer		*from_binary(Mixer::ControlCallback control_cb,
+			uintptr_t cb_handle,
+			const uint8_t *buf,
+			unsigned &buflen,
+			MixerArena *arena = nullptr);
+
+	/**
+	 * Factory method for a configuration given as a structure.
+	 *
+	 * @param control_cb		The callback to invoke when fetching a
+	 *				control value.
+	 * @param cb_handle		Handle passed to the control callback.
+	 * @param mixinfo		Mixer configuration, copied.
+	 * @param arena			Arena to build the mixer in, nullptr for the heap.
+	 * @return			A new SimpleMixer instance, or nullptr if the
+	 *				configuration fails check() or there is no memory.
+	 */
+	static SimpleMixer		*from_info(Mixer::ControlCallback control_cb,
+			uintptr_t cb_handle,
+			const mixer_simple_s *mixinfo,
+			MixerArena *arena = nullptr);
 
 	/**
 	 * Factory method for PWM/PPM input to internal float representation.
@@ -470,6 +634,17 @@ public:
 		MAX_GEOMETRY
 	};
 
+	/**
+	 * Ways of bringing saturated outputs back into range.
+	 */
+	enum Desaturation {
+		DESAT_LEGACY = 0,	/**< roll/pitch scaled down at low thrust, yaw clipped, all outputs scaled down at the top */
+		DESAT_PRIORITIZED,	/**< roll/pitch before yaw before thrust, thrust is only ever reduced */
+		DESAT_AIRMODE,		/**< as DESAT_PRIORITIZED, but thrust is raised as well to keep authority at low thrust */
+
+		MAX_DESATURATION
+	};
+
 	/**
 	 * Precalculated rotor mix.
 	 */
@@ -494,6 +669,7 @@ public:
 	 * @param deadband		Minumum rotor control output value; usually
 	 *				tuned to ensure that rotors never stall at the
 	 * 				low end of their control range.
+	 * @param desaturation		How outputs out of range are brought back.
 	 */
 	MultirotorMixer(ControlCallback control_cb,
 			uintptr_t cb_handle,
@@ -501,7 +677,8 @@ public:
 			float roll_scale,
 			float pitch_scale,
 			float yaw_scale,
-			float deadband);
+			float deadband,
+			Desaturation desaturation = DESAT_LEGACY);
 	~MultirotorMixer();
 
 	/**
@@ -517,13 +694,34 @@ public:
 	 *				the mixer.
 	 * @param buflen		Length of the buffer in bytes, adjusted
 	 *				to reflect the bytes consumed.
+	 * @param arena			Arena to build the mixer in, nullptr for the heap.
 	 * @return			A new MultirotorMixer instance, or nullptr
 	 *				if the text format is bad.
 	 */
 	static MultirotorMixer		*from_text(Mixer::ControlCallback control_cb,
 			uintptr_t cb_handle,
 			const char *buf,
-			unsigned &buflen);
+			unsigned &buflen,
+			MixerArena *arena = nullptr);
+
+	/**
+	 * Factory method for binary descriptions.
+	 *
+	 * @param control_cb		The callback to invoke when fetching a
+	 *				control value.
+	 * @param cb_handle		Handle passed to the control callback.
+	 * @param buf			Buffer starting with a MIXER_BIN_MULTIROTOR record.
+	 * @param buflen		Length of the buffer in bytes, adjusted
+	 *				to reflect the bytes consumed.
+	 * @param arena			Arena to build the mixer in, nullptr for the heap.
+	 * @return			A new MultirotorMixer instance, or nullptr
+	 *				if the record is incomplete or invalid.
+	 */
+	static MultirotorMixer		*from_binary(Mixer::ControlCallback control_cb,
+			uintptr_t cb_handle,
+			const uint8_t *buf,
+			unsigned &buflen,
+			MixerArena *arena = nullptr);
 
 	virtual unsigned		mix(float *outputs, unsigned space);
 	virtual void			groups_required(uint32_t &groups);
@@ -533,6 +731,7 @@ private:
 	float				_pitch_scale;
 	float				_yaw_scale;
 	float				_idle_speed;
+	Desaturation			_desaturation;
 
 	orb_advert_t			_limits_pub;
 	multirotor_motor_limits_s 	_limits;
@@ -540,6 +739,25 @@ private:
 	unsigned			_rotor_count;
 	const Rotor			*_rotors;
 
+	/**
+	 * Mix and desaturate as DESAT_LEGACY does, setting _limits.
+	 *
+	 * @param roll, pitch, yaw	Scaled and limited controls.
+	 * @param thrust		Limited thrust control.
+	 * @param outputs		The _rotor_count outputs, idle speed to 1.
+	 */
+	void				mix_legacy(float roll, float pitch, float yaw, float thrust, float *outputs);
+
+	/**
+	 * Mix and desaturate as DESAT_PRIORITIZED or DESAT_AIRMODE do,
+	 * setting _limits.
+	 *
+	 * @param roll, pitch, yaw	Scaled and limited controls.
+	 * @param thrust		Limited thrust control.
+	 * @param outputs		The _rotor_count outputs, idle speed to 1.
+	 */
+	void				mix_prioritized(float roll, float pitch, float yaw, float thrust, float *outputs);
+
 	/* do not allow to copy due to ptr data members */
 	MultirotorMixer(const MultirotorMixer&);
 	MultirotorMixer operator=(const MultirotorMixer&);
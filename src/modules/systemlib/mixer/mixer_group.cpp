@@ -58,15 +58,19 @@
 //#include <debug.h>
 //#define debug(fmt, args...)	lowsyslog(fmt "\n", ##args)
 
-MixerGroup::MixerGroup(ControlCallback control_cb, uintptr_t cb_handle) :
+MixerGroup::MixerGroup(ControlCallback control_cb, uintptr_t cb_handle, size_t arena_size) :
 	Mixer(control_cb, cb_handle),
-	_first(nullptr)
+	_first(nullptr),
+	_arena((arena_size > 0) ? new MixerArena(arena_size) : nullptr)
 {
 }
 
 MixerGroup::~MixerGroup()
 {
 	reset();
+
+	if (_arena != nullptr)
+		delete _arena;
 }
 
 void
@@ -88,6 +92,13 @@ MixerGroup::reset()
 {
 	Mixer *mixer;
 
+	/* mixers built in the arena are discarded with it, not destroyed */
+	if (_arena != nullptr) {
+		_first = nullptr;
+		_arena->reset();
+		return;
+	}
+
 	/* discard sub-mixers */
 	while (_first != nullptr) {
 		mixer = _first;
@@ -156,15 +167,15 @@ MixerGroup::load_from_buf(const char *buf, unsigned &buflen)
 		 */
 		switch (*p) {
 		case 'Z':
-			m = NullMixer::from_text(p, resid);
+			m = NullMixer::from_text(p, resid, _arena);
 			break;
 
 		case 'M':
-			m = SimpleMixer::from_text(_control_cb, _cb_handle, p, resid);
+			m = SimpleMixer::from_text(_control_cb, _cb_handle, p, resid, _arena);
 			break;
 
 		case 'R':
-			m = MultirotorMixer::from_text(_control_cb, _cb_handle, p, resid);
+			m = MultirotorMixer::from_text(_control_cb, _cb_handle, p, resid, _arena);
 			break;
 
 		default:
@@ -198,3 +209,49 @@ MixerGroup::load_from_buf(const char *buf, unsigned &buflen)
 	/* nothing more in the buffer for us now */
 	return ret;
 }
+
+int
+MixerGroup::load_from_bin(const void *buf, unsigned &buflen)
+{
+	int ret = -1;
+	const uint8_t *end = (const uint8_t *)buf + buflen;
+
+	while (buflen > 0) {
+		Mixer *m = nullptr;
+		const uint8_t *p = end - buflen;
+		unsigned resid = buflen;
+
+		switch (*p) {
+		case MIXER_BIN_PAD:
+			buflen--;
+			continue;
+
+		case MIXER_BIN_NULL:
+			m = NullMixer::from_binary(p, resid, _arena);
+			break;
+
+		case MIXER_BIN_SIMPLE:
+			m = SimpleMixer::from_binary(_control_cb, _cb_handle, p, resid, _arena);
+			break;
+
+		case MIXER_BIN_MULTIROTOR:
+			m = MultirotorMixer::from_binary(_control_cb, _cb_handle, p, resid, _arena);
+			break;
+
+		default:
+			debug("unknown binary mixer record 0x%02x", *p);
+			break;
+		}
+
+		if (m == nullptr) {
+			/* incomplete or bad, either way there is nothing more to load now */
+			break;
+		}
+
+		add_mixer(m);
+		ret = 0;
+		buflen = resid;
+	}
+
+	return ret;
+}
@@ -38,11 +38,17 @@
  */
 
 #include <nuttx/config.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
 #include <systemlib/err.h>
 
+#include <drivers/drv_mixer.h>
+
 #include "mixer_load.h"
 
 int load_mixer_file(const char *fname, char *buf, unsigned maxlen)
@@ -91,6 +97,7 @@ int load_mixer_file(const char *fname, char *buf, unsigned maxlen)
 		/* if the line is too long to fit in the buffer, bail */
 		if ((strlen(line) + strlen(buf) + 1) >= maxlen) {
 			warnx("line too long");
+			fclose(fp);
 			return -1;
 		}
 
@@ -98,6 +105,69 @@ int load_mixer_file(const char *fname, char *buf, unsigned maxlen)
 		strcat(buf, line);
 	}
 
+	fclose(fp);
 	return 0;
 }
 
+
+int load_mixer_bin_file(const char *fname, void *buf, unsigned maxlen)
+{
+	FILE		*fp;
+	char		magic[MIXER_BIN_MAGIC_LEN];
+	int		len;
+
+	fp = fopen(fname, "r");
+	if (fp == NULL)
+		return -1;
+
+	if ((fread(magic, 1, sizeof(magic), fp) != sizeof(magic)) ||
+	    memcmp(magic, MIXER_BIN_MAGIC, sizeof(magic))) {
+		warnx("not a binary mixer file");
+		fclose(fp);
+		return -1;
+	}
+
+	len = fread(buf, 1, maxlen, fp);
+
+	/* if the records do not fit the buffer, bail */
+	if (((unsigned)len == maxlen) && (fgetc(fp) != EOF)) {
+		warnx("binary mixer too long");
+		len = -1;
+	}
+
+	fclose(fp);
+	return len;
+}
+
+int map_mixer_bin_file(const char *fname, const void **records)
+{
+#ifdef FIOC_MMAP
+	const uint8_t	*addr = NULL;
+	int		fd;
+	off_t		len;
+
+	fd = open(fname, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	/* only files on a memory mapped file system such as the ROMFS can be read in place */
+	if ((ioctl(fd, FIOC_MMAP, (unsigned long)&addr) != OK) || (addr == NULL)) {
+		close(fd);
+		return -1;
+	}
+
+	len = lseek(fd, 0, SEEK_END);
+	close(fd);
+
+	if ((len < (off_t)MIXER_BIN_MAGIC_LEN) || memcmp(addr, MIXER_BIN_MAGIC, MIXER_BIN_MAGIC_LEN)) {
+		warnx("not a binary mixer file");
+		return -1;
+	}
+
+	/* the mapping is the file system image itself and stays valid after the close */
+	*records = addr + MIXER_BIN_MAGIC_LEN;
+	return len - MIXER_BIN_MAGIC_LEN;
+#else
+	return -1;
+#endif
+}
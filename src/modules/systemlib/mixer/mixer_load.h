@@ -46,6 +46,30 @@ __BEGIN_DECLS
 
 __EXPORT int load_mixer_file(const char *fname, char *buf, unsigned maxlen);
 
+/**
+ * Read a binary mixer file, as written by Tools/px_mixer_bin.py.
+ *
+ * @param fname		The file to read.
+ * @param buf		Filled with the mixer records, without the file magic.
+ * @param maxlen	The size of buf.
+ * @return		The length of the records, or -1 if the file is missing,
+ *			not a binary mixer file or too large.
+ */
+__EXPORT int load_mixer_bin_file(const char *fname, void *buf, unsigned maxlen);
+
+/**
+ * Map a binary mixer file in place, without copying it.
+ *
+ * Works for files on a memory mapped file system such as the ROMFS, which
+ * is read straight from flash.
+ *
+ * @param fname		The file to map.
+ * @param records	Set to the mixer records, without the file magic.
+ * @return		The length of the records, or -1 if the file is missing,
+ *			not a binary mixer file or cannot be mapped.
+ */
+__EXPORT int map_mixer_bin_file(const char *fname, const void **records);
+
 __END_DECLS
 
 #endif
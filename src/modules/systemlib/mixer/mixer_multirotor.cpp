@@ -154,7 +154,7 @@ const MultirotorMixer::Rotor _config_octa_cox[] = {
 	{ -0.707107, -0.707107,  1.00 },
 	{  0.707107, -0.707107, -1.00 },
 };
-const MultirotorMixer::Rotor *_config_index[MultirotorMixer::MAX_GEOMETRY] = {
+const MultirotorMixer::Rotor *const _config_index[MultirotorMixer::MAX_GEOMETRY] = {
 	&_config_quad_x[0],
 	&_config_quad_plus[0],
 	&_config_quad_v[0],
@@ -187,12 +187,16 @@ MultirotorMixer::MultirotorMixer(ControlCallback control_cb,
 				 float roll_scale,
 				 float pitch_scale,
 				 float yaw_scale,
-				 float idle_speed) :
+				 float idle_speed,
+				 Desaturation desaturation) :
 	Mixer(control_cb, cb_handle),
 	_roll_scale(roll_scale),
 	_pitch_scale(pitch_scale),
 	_yaw_scale(yaw_scale),
 	_idle_speed(-1.0f + idle_speed * 2.0f),	/* shift to output range here to avoid runtime calculation */
+	_desaturation(desaturation),
+	_limits_pub(-1),
+	_limits(),
 	_rotor_count(_config_rotor_count[geometry]),
 	_rotors(_config_index[geometry])
 {
@@ -203,7 +207,8 @@ MultirotorMixer::~MultirotorMixer()
 }
 
 MultirotorMixer *
-MultirotorMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handle, const char *buf, unsigned &buflen)
+MultirotorMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handle, const char *buf, unsigned &buflen,
+			   MixerArena *arena)
 {
 	MultirotorMixer::Geometry geometry;
 	char geomname[8];
@@ -236,6 +241,22 @@ MultirotorMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handl
 		return nullptr;
 	}
 
+	/* optional desaturation mode, only from the rest of this line */
+	int desaturation = DESAT_LEGACY;
+
+	while (used < (int)buflen && (buf[used] == ' ' || buf[used] == '\t')) {
+		used++;
+	}
+
+	if (used < (int)buflen && buf[used] >= '0' && buf[used] <= '9') {
+		desaturation = buf[used] - '0';
+
+		if (desaturation >= MAX_DESATURATION) {
+			debug("unknown desaturation mode %d", desaturation);
+			return nullptr;
+		}
+	}
+
 	buf = skipline(buf, buflen);
 	if (buf == nullptr) {
 		debug("no line ending, line is incomplete");
@@ -281,14 +302,50 @@ MultirotorMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handl
 
 	debug("adding multirotor mixer '%s'", geomname);
 
-	return new MultirotorMixer(
+	return new (arena) MultirotorMixer(
 		       control_cb,
 		       cb_handle,
 		       geometry,
 		       s[0] / 10000.0f,
 		       s[1] / 10000.0f,
 		       s[2] / 10000.0f,
-		       s[3] / 10000.0f);
+		       s[3] / 10000.0f,
+		       (MultirotorMixer::Desaturation)desaturation);
+}
+
+MultirotorMixer *
+MultirotorMixer::from_binary(Mixer::ControlCallback control_cb, uintptr_t cb_handle, const uint8_t *buf, unsigned &buflen,
+			     MixerArena *arena)
+{
+	mixer_bin_multirotor_s bin;
+
+	if (buflen < sizeof(bin)) {
+		debug("multirotor record incomplete");
+		return nullptr;
+	}
+
+	memcpy(&bin, buf, sizeof(bin));
+
+	if (bin.geometry >= MAX_GEOMETRY || bin.desaturation >= MAX_DESATURATION) {
+		debug("bad multirotor record, geometry %u desaturation %u", bin.geometry, bin.desaturation);
+		return nullptr;
+	}
+
+	MultirotorMixer *mm = new (arena) MultirotorMixer(
+				      control_cb,
+				      cb_handle,
+				      (MultirotorMixer::Geometry)bin.geometry,
+				      bin.roll_scale / 10000.0f,
+				      bin.pitch_scale / 10000.0f,
+				      bin.yaw_scale / 10000.0f,
+				      bin.idle_speed / 10000.0f,
+				      (MultirotorMixer::Desaturation)bin.desaturation);
+
+	if (mm != nullptr) {
+		buflen -= sizeof(bin);
+	}
+
+	return mm;
 }
 
 unsigned
@@ -300,19 +357,44 @@ MultirotorMixer::mix(float *outputs, unsigned space)
 	float		yaw     = constrain(get_control(0, 2) * _yaw_scale, -1.0f, 1.0f);
 	float		thrust  = constrain(get_control(0, 3), 0.0f, 1.0f);
 	//lowsyslog("thrust: %d, get_control3: %d\n", (int)(thrust), (int)(get_control(0, 3)));
-	float		min_out = 0.0f;
-	float		max_out = 0.0f;
 
 	_limits.roll_pitch = false;
 	_limits.yaw = false;
 	_limits.throttle_upper = false;
 	_limits.throttle_lower = false;
 
-	/* perform initial mix pass yielding unbounded outputs, ignore yaw */
+	if (_desaturation == DESAT_LEGACY) {
+		mix_legacy(roll, pitch, yaw, thrust, outputs);
+
+	} else {
+		mix_prioritized(roll, pitch, yaw, thrust, outputs);
+	}
+
+#if defined(CONFIG_ARCH_BOARD_PX4FMU_V1) || defined(CONFIG_ARCH_BOARD_PX4FMU_V2)
+        /* publish/advertise motor limits if running on FMU */
+        if (_limits_pub > 0) {
+            orb_publish(ORB_ID(multirotor_motor_limits), _limits_pub, &_limits);
+        } else {
+            _limits_pub = orb_advertise(ORB_ID(multirotor_motor_limits), &_limits);
+        }
+#endif
+	return _rotor_count;
+}
+
+void
+MultirotorMixer::mix_legacy(float roll, float pitch, float yaw, float thrust, float *outputs)
+{
+	float		min_out = 0.0f;
+	float		max_out = 0.0f;
+
+	/*
+	 * Mix roll and pitch, keeping only their part in the outputs, and
+	 * find the yaw limit and the output range from it in the same pass.
+	 */
 	for (unsigned i = 0; i < _rotor_count; i++) {
-		float out = roll * _rotors[i].roll_scale +
-			    pitch * _rotors[i].pitch_scale +
-			    thrust;
+		float roll_pitch = roll * _rotors[i].roll_scale +
+				   pitch * _rotors[i].pitch_scale;
+		float out = roll_pitch + thrust;
 
 		/* limit yaw if it causes outputs clipping */
 		if (out >= 0.0f && out < -yaw * _rotors[i].yaw_scale) {
@@ -328,24 +410,19 @@ MultirotorMixer::mix(float *outputs, unsigned space)
 			max_out = out;
 		}
 
-		outputs[i] = out;
+		outputs[i] = roll_pitch;
 	}
 
-	/* scale down roll/pitch controls if some outputs are negative, don't add yaw, keep total thrust */
-	if (min_out < 0.0f) {
-		float scale_in = thrust / (thrust - min_out);
+	/*
+	 * Scale down roll/pitch controls if some outputs are negative, don't add yaw,
+	 * keep total thrust. Otherwise roll/pitch is used without limiting, with yaw.
+	 */
+	bool roll_pitch_limited = (min_out < 0.0f);
+	float scale_in = 1.0f;
 
-		/* mix again with adjusted controls */
-		for (unsigned i = 0; i < _rotor_count; i++) {
-			outputs[i] = scale_in * (roll * _rotors[i].roll_scale + pitch * _rotors[i].pitch_scale) + thrust;
-		}
+	if (roll_pitch_limited) {
+		scale_in = thrust / (thrust - min_out);
 		_limits.roll_pitch = true;
-
-	} else {
-		/* roll/pitch mixed without limiting, add yaw control */
-		for (unsigned i = 0; i < _rotor_count; i++) {
-			outputs[i] += yaw * _rotors[i].yaw_scale;
-		}
 	}
 
 	/* scale down all outputs if some outputs are too large, reduce total thrust */
@@ -358,23 +435,135 @@ MultirotorMixer::mix(float *outputs, unsigned space)
 		scale_out = 1.0f;
 	}
 
-	/* scale outputs to range _idle_speed..1, and do final limiting */
+	/* finish the outputs, scale them to range _idle_speed..1, and do final limiting */
 	for (unsigned i = 0; i < _rotor_count; i++) {
-		if (outputs[i] < _idle_speed) {
+		float out;
+
+		if (roll_pitch_limited) {
+			out = scale_in * outputs[i] + thrust;
+
+		} else {
+			out = (outputs[i] + thrust) + yaw * _rotors[i].yaw_scale;
+		}
+
+		if (out < _idle_speed) {
 			_limits.throttle_lower = true;
 		}
-		outputs[i] = constrain(_idle_speed + (outputs[i] * (1.0f - _idle_speed) * scale_out), _idle_speed, 1.0f);
+		outputs[i] = constrain(_idle_speed + (out * (1.0f - _idle_speed) * scale_out), _idle_speed, 1.0f);
 	}
+}
 
-#if defined(CONFIG_ARCH_BOARD_PX4FMU_V1) || defined(CONFIG_ARCH_BOARD_PX4FMU_V2)
-        /* publish/advertise motor limits if running on FMU */
-        if (_limits_pub > 0) {
-            orb_publish(ORB_ID(multirotor_motor_limits), _limits_pub, &_limits);
-        } else {
-            _limits_pub = orb_advertise(ORB_ID(multirotor_motor_limits), &_limits);
-        }
-#endif
-	return _rotor_count;
+void
+MultirotorMixer::mix_prioritized(float roll, float pitch, float yaw, float thrust, float *outputs)
+{
+	/*
+	 * Work in the output range 0..1, keeping the roll/pitch part of each
+	 * output in outputs[] until the very end.
+	 */
+	float rp_min = 0.0f;
+	float rp_max = 0.0f;
+
+	for (unsigned i = 0; i < _rotor_count; i++) {
+		float roll_pitch = roll * _rotors[i].roll_scale +
+				   pitch * _rotors[i].pitch_scale;
+
+		if (roll_pitch < rp_min) {
+			rp_min = roll_pitch;
+		}
+		if (roll_pitch > rp_max) {
+			rp_max = roll_pitch;
+		}
+
+		outputs[i] = roll_pitch;
+	}
+
+	/*
+	 * Roll/pitch first: scale them down only if no thrust can fit them,
+	 * or if thrust may not be raised to fit them.
+	 */
+	float rp_scale = 1.0f;
+
+	if (rp_max - rp_min > 1.0f) {
+		rp_scale = 1.0f / (rp_max - rp_min);
+	}
+
+	if (_desaturation != DESAT_AIRMODE && thrust < -rp_min * rp_scale) {
+		rp_scale = thrust / -rp_min;
+	}
+
+	if (rp_scale < 1.0f) {
+		_limits.roll_pitch = true;
+
+		for (unsigned i = 0; i < _rotor_count; i++) {
+			outputs[i] *= rp_scale;
+		}
+	}
+
+	/*
+	 * Then yaw: the largest share of it for which the output spread
+	 * still fits into 0..1. The spread is convex in the yaw share, so
+	 * each pair of rotors gives an upper bound and the tightest one wins.
+	 * Without airmode the outputs may not go below zero at this thrust,
+	 * which gives another bound for each rotor.
+	 */
+	float yaw_share = 1.0f;
+
+	for (unsigned i = 0; i < _rotor_count; i++) {
+		float yaw_i = yaw * _rotors[i].yaw_scale;
+
+		if (_desaturation != DESAT_AIRMODE && yaw_i < 0.0f && thrust + outputs[i] + yaw_i < 0.0f) {
+			yaw_share = fminf(yaw_share, (thrust + outputs[i]) / -yaw_i);
+		}
+
+		for (unsigned j = 0; j < _rotor_count; j++) {
+			float yaw_spread = yaw_i - yaw * _rotors[j].yaw_scale;
+			float rp_spread = outputs[i] - outputs[j];
+
+			if (yaw_spread > 0.0f && rp_spread + yaw_spread > 1.0f) {
+				yaw_share = fminf(yaw_share, (1.0f - rp_spread) / yaw_spread);
+			}
+		}
+	}
+
+	yaw_share = constrain(yaw_share, 0.0f, 1.0f);
+
+	if (yaw_share < 1.0f) {
+		_limits.yaw = true;
+	}
+
+	/* last thrust: shift it so that all outputs fit */
+	float out_min = 0.0f;
+	float out_max = 0.0f;
+
+	for (unsigned i = 0; i < _rotor_count; i++) {
+		outputs[i] += yaw * yaw_share * _rotors[i].yaw_scale;
+
+		if (i == 0 || outputs[i] < out_min) {
+			out_min = outputs[i];
+		}
+		if (i == 0 || outputs[i] > out_max) {
+			out_max = outputs[i];
+		}
+	}
+
+	float thrust_out = thrust;
+
+	if (thrust_out > 1.0f - out_max) {
+		thrust_out = 1.0f - out_max;
+		_limits.throttle_upper = true;
+	}
+
+	if (_desaturation == DESAT_AIRMODE && thrust_out < -out_min) {
+		thrust_out = -out_min;
+		_limits.throttle_lower = true;
+	}
+
+	/* scale to range _idle_speed..1, rounding can still need the final limiting */
+	for (unsigned i = 0; i < _rotor_count; i++) {
+		float out = outputs[i] + thrust_out;
+
+		outputs[i] = constrain(_idle_speed + out * (1.0f - _idle_speed), _idle_speed, 1.0f);
+	}
 }
 
 void
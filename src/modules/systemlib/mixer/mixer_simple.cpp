@@ -141,7 +141,8 @@ SimpleMixer::parse_control_scaler(const char *buf, unsigned &buflen, mixer_scale
 }
 
 SimpleMixer *
-SimpleMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handle, const char *buf, unsigned &buflen)
+SimpleMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handle, const char *buf, unsigned &buflen,
+		       MixerArena *arena)
 {
 	SimpleMixer *sm = nullptr;
 	mixer_simple_s *mixinfo = nullptr;
@@ -161,7 +162,7 @@ SimpleMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handle, c
 		goto out;
 	}
 
-	mixinfo = (mixer_simple_s *)malloc(MIXER_SIMPLE_SIZE(inputs));
+	mixinfo = (mixer_simple_s *)alloc(arena, MIXER_SIMPLE_SIZE(inputs));
 
 	if (mixinfo == nullptr) {
 		debug("could not allocate memory for mixer info");
@@ -186,7 +187,7 @@ SimpleMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handle, c
 
 	}
 
-	sm = new SimpleMixer(control_cb, cb_handle, mixinfo);
+	sm = new (arena) SimpleMixer(control_cb, cb_handle, mixinfo);
 
 	if (sm != nullptr) {
 		mixinfo = nullptr;
@@ -199,7 +200,107 @@ SimpleMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handle, c
 out:
 
 	if (mixinfo != nullptr)
-		free(mixinfo);
+		release(arena, mixinfo);
+
+	return sm;
+}
+
+SimpleMixer *
+SimpleMixer::from_binary(Mixer::ControlCallback control_cb, uintptr_t cb_handle, const uint8_t *buf, unsigned &buflen,
+			 MixerArena *arena)
+{
+	SimpleMixer *sm = nullptr;
+	mixer_simple_s *mixinfo = nullptr;
+	mixer_bin_simple_s bin;
+	unsigned size;
+
+	if (buflen < sizeof(bin)) {
+		debug("simple mixer record incomplete");
+		goto out;
+	}
+
+	/* the records are packed, copy them out rather than pointing into the buffer */
+	memcpy(&bin, buf, sizeof(bin));
+	size = sizeof(bin) + bin.control_count * sizeof(mixer_bin_control_s);
+
+	if (buflen < size) {
+		debug("simple mixer controls incomplete");
+		goto out;
+	}
+
+	mixinfo = (mixer_simple_s *)alloc(arena, MIXER_SIMPLE_SIZE(bin.control_count));
+
+	if (mixinfo == nullptr) {
+		debug("could not allocate memory for mixer info");
+		goto out;
+	}
+
+	mixinfo->control_count = bin.control_count;
+	scaler_from_binary(bin.output_scaler, mixinfo->output_scaler);
+
+	for (unsigned i = 0; i < bin.control_count; i++) {
+		mixer_bin_control_s control;
+
+		memcpy(&control, buf + sizeof(bin) + i * sizeof(control), sizeof(control));
+
+		mixinfo->controls[i].control_group = control.control_group;
+		mixinfo->controls[i].control_index = control.control_index;
+		scaler_from_binary(control.scaler, mixinfo->controls[i].scaler);
+	}
+
+	sm = new (arena) SimpleMixer(control_cb, cb_handle, mixinfo);
+
+	if (sm != nullptr) {
+		mixinfo = nullptr;
+		buflen -= size;
+		debug("loaded mixer with %d input(s)", bin.control_count);
+
+	} else {
+		debug("could not allocate memory for mixer");
+	}
+
+out:
+
+	if (mixinfo != nullptr)
+		release(arena, mixinfo);
+
+	return sm;
+}
+
+SimpleMixer *
+SimpleMixer::from_info(Mixer::ControlCallback control_cb, uintptr_t cb_handle, const mixer_simple_s *mixinfo,
+		       MixerArena *arena)
+{
+	mixer_simple_s *info = (mixer_simple_s *)alloc(arena, MIXER_SIMPLE_SIZE(mixinfo->control_count));
+
+	if (info == nullptr) {
+		debug("could not allocate memory for mixer info");
+		return nullptr;
+	}
+
+	memcpy(info, mixinfo, MIXER_SIMPLE_SIZE(mixinfo->control_count));
+
+	SimpleMixer *sm = new (arena) SimpleMixer(control_cb, cb_handle, info);
+
+	if (sm == nullptr) {
+		debug("could not allocate memory for mixer");
+		release(arena, info);
+		return nullptr;
+	}
+
+	if (sm->check()) {
+		debug("mixer failed check");
+
+		if (arena != nullptr) {
+			/* built in the arena, give back the mixer and its info */
+			release(arena, info);
+
+		} else {
+			delete sm;
+		}
+
+		return nullptr;
+	}
 
 	return sm;
 }
@@ -53,5 +53,10 @@ SRCS		 = err.c \
 		   otp.c \
 		   board_serial.c \
 		   pwm_limit/pwm_limit.c \
-		   circuit_breaker.c
+		   rpm_control/rpm_control.c \
+		   circuit_breaker.c \
+		   control_latency.c \
+		   deadline.c \
+		   work_profile.c \
+		   mem_pool.c
 
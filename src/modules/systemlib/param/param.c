@@ -49,6 +49,10 @@
 #include <systemlib/err.h>
 #include <errno.h>
 #include <semaphore.h>
+#include <crc32.h>
+
+#include <nuttx/irq.h>
+#include <sched.h>
 
 #include <sys/stat.h>
 
@@ -75,6 +79,14 @@ static const struct param_info_s	*param_info_base = (struct param_info_s *) &__p
 static const struct param_info_s	*param_info_limit = (struct param_info_s *) &__param_end;
 #define	param_info_count		((unsigned)(param_info_limit - param_info_base))
 
+/**
+ * Whether the table is sorted by name; -1 until checked.
+ *
+ * The linker script sorts the table, this guards against one that
+ * does not.
+ */
+static int param_info_sorted = -1;
+
 /**
  * Storage for modified parameters.
  */
@@ -87,15 +99,52 @@ struct param_wbuf_s {
 /** flexible array holding modified parameter values */
 UT_array	*param_values;
 
+/**
+ * Per parameter change counters, indexed by handle.
+ *
+ * Allocated on the first change; until then every counter reads as zero.
+ */
+static uint16_t	*param_change_counts;
+
 /** array info for the modified parameters array */
 const UT_icd	param_icd = {sizeof(struct param_wbuf_s), NULL, NULL, NULL};
 
+/**
+ * Incremented before and after every change of the modified values, so it
+ * is odd while a change is in progress; see param_group_get().
+ */
+static volatile unsigned param_values_seq = 0;
+
 /** parameter update topic */
 ORB_DEFINE(parameter_update, struct parameter_update_s);
 
 /** parameter update topic handle */
 static orb_advert_t param_topic = -1;
 
+/** nesting depth of param_begin_batch(), notifications are held back while non-zero */
+static unsigned param_batch_depth = 0;
+
+/** a notification was held back by a batch */
+static bool param_batch_pending = false;
+
+/*
+ * The default file holds a full parameter document followed by a journal
+ * of records, each a PARAM_JOURNAL_MAGIC word and a document with the values
+ * changed since the previous save. A PARAM_JOURNAL_END word closes the file,
+ * so that stale data after it on fixed size devices like FRAM is ignored.
+ */
+#define PARAM_JOURNAL_MAGIC	0x4c4e524aU
+#define PARAM_JOURNAL_END	0xffffffffU
+
+/** journal records appended before the file is compacted into one document */
+#define PARAM_JOURNAL_MAX	32
+
+/** offset of the end marker in the default file, -1 if unknown and the next save rewrites it */
+static off_t param_journal_end = -1;
+
+/** number of journal records in the default file */
+static unsigned param_journal_records = 0;
+
 /** lock the parameter store */
 static void
 param_lock(void)
@@ -130,23 +179,30 @@ handle_in_range(param_t param)
 }
 
 /**
- * Compare two modifid parameter structures to determine ordering.
+ * Binary search the modified parameters array, which is kept sorted by handle.
  *
- * This function is suitable for passing to qsort or bsearch.
+ * @param param			The parameter being searched.
+ * @return			The index of the first entry with a handle not less
+ *				than param, which is where a new entry is inserted.
  */
-static int
-param_compare_values(const void *a, const void *b)
+static unsigned
+param_values_lower_bound(param_t param)
 {
-	struct param_wbuf_s *pa = (struct param_wbuf_s *)a;
-	struct param_wbuf_s *pb = (struct param_wbuf_s *)b;
+	unsigned low = 0;
+	unsigned high = utarray_len(param_values);
 
-	if (pa->param < pb->param)
-		return -1;
+	while (low < high) {
+		unsigned mid = low + (high - low) / 2;
 
-	if (pa->param > pb->param)
-		return 1;
+		if (((struct param_wbuf_s *)_utarray_eltptr(param_values, mid))->param < param) {
+			low = mid + 1;
 
-	return 0;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low;
 }
 
 /**
@@ -163,26 +219,52 @@ param_find_changed(param_t param) {
 	param_assert_locked();
 
 	if (param_values != NULL) {
-#if 0	/* utarray_find requires bsearch, not available */
-		struct param_wbuf_s key;
-		key.param = param;
-		s = utarray_find(param_values, &key, param_compare_values);
-#else
-
-		while ((s = (struct param_wbuf_s *)utarray_next(param_values, s)) != NULL) {
-			if (s->param == param)
-				break;
-		}
+		s = (struct param_wbuf_s *)utarray_eltptr(param_values, param_values_lower_bound(param));
 
-#endif
+		if (s != NULL && s->param != param)
+			s = NULL;
 	}
 
 	return s;
 }
 
+/**
+ * Advance the change counter of a parameter, or of all of them for PARAM_INVALID.
+ */
+static void
+param_count_change(param_t param)
+{
+	if (param_change_counts == NULL) {
+		param_change_counts = calloc(param_info_count, sizeof(param_change_counts[0]));
+
+		if (param_change_counts == NULL) {
+			debug("failed to allocate change counters");
+			return;
+		}
+	}
+
+	if (param == PARAM_INVALID) {
+		for (unsigned i = 0; i < param_info_count; i++)
+			param_change_counts[i]++;
+
+	} else {
+		param_change_counts[param]++;
+	}
+}
+
 static void
 param_notify_changes(void)
 {
+	irqstate_t flags = irqsave();
+
+	if (param_batch_depth > 0) {
+		param_batch_pending = true;
+		irqrestore(flags);
+		return;
+	}
+
+	irqrestore(flags);
+
 	struct parameter_update_s pup = { .timestamp = hrt_absolute_time() };
 
 	/*
@@ -197,11 +279,86 @@ param_notify_changes(void)
 	}
 }
 
+/**
+ * Check once that the parameter table is sorted by name.
+ *
+ * @return			True if param_find() may use a binary search.
+ */
+static bool
+param_check_sorted(void)
+{
+	if (param_info_sorted < 0) {
+		param_info_sorted = 1;
+
+		for (unsigned i = 1; i < param_info_count; i++) {
+			if (strcmp(param_info_base[i - 1].name, param_info_base[i].name) >= 0) {
+				warnx("param table not sorted, using linear search");
+				param_info_sorted = 0;
+				break;
+			}
+		}
+	}
+
+	return param_info_sorted > 0;
+}
+
+void
+param_begin_batch(void)
+{
+	irqstate_t flags = irqsave();
+	param_batch_depth++;
+	irqrestore(flags);
+}
+
+void
+param_end_batch(void)
+{
+	bool notify = false;
+	irqstate_t flags = irqsave();
+
+	if (param_batch_depth > 0)
+		param_batch_depth--;
+
+	if (param_batch_depth == 0 && param_batch_pending) {
+		param_batch_pending = false;
+		notify = true;
+	}
+
+	irqrestore(flags);
+
+	if (notify)
+		param_notify_changes();
+}
+
 param_t
 param_find(const char *name)
 {
 	param_t param;
 
+	if (param_check_sorted()) {
+		/* binary search of the known parameters */
+		unsigned low = 0;
+		unsigned high = param_info_count;
+
+		while (low < high) {
+			unsigned mid = low + (high - low) / 2;
+			int cmp = strcmp(name, param_info_base[mid].name);
+
+			if (cmp == 0)
+				return (param_t)mid;
+
+			if (cmp < 0) {
+				high = mid;
+
+			} else {
+				low = mid + 1;
+			}
+		}
+
+		/* not found */
+		return PARAM_INVALID;
+	}
+
 	/* perform a linear search of the known parameters */
 	for (param = 0; handle_in_range(param); param++) {
 		if (!strcmp(param_info_base[param].name, name))
@@ -212,6 +369,15 @@ param_find(const char *name)
 	return PARAM_INVALID;
 }
 
+param_t
+param_for_info(const struct param_info_s *info)
+{
+	if (info >= param_info_base && info < param_info_limit)
+		return (param_t)(info - param_info_base);
+
+	return PARAM_INVALID;
+}
+
 unsigned
 param_count(void)
 {
@@ -353,6 +519,106 @@ param_get(param_t param, void *val)
 	return result;
 }
 
+float
+param_get_float(param_t param)
+{
+	float f = 0.0f;
+
+	if (param_type(param) == PARAM_TYPE_FLOAT)
+		param_get(param, &f);
+
+	return f;
+}
+
+int32_t
+param_get_int32(param_t param)
+{
+	int32_t i = 0;
+
+	if (param_type(param) == PARAM_TYPE_INT32)
+		param_get(param, &i);
+
+	return i;
+}
+
+/** attempts of param_group_get() while a change is in progress */
+#define PARAM_GROUP_TRIES		10
+
+/** wait between attempts, us */
+#define PARAM_GROUP_RETRY_INTERVAL	1000
+
+int
+param_group_init(struct param_group_s *group, const struct param_group_item_s *items, unsigned count)
+{
+	group->items = items;
+	group->count = count;
+	group->handles = malloc(count * sizeof(param_t));
+
+	if (group->handles == NULL) {
+		group->count = 0;
+		return -1;
+	}
+
+	for (unsigned i = 0; i < count; i++) {
+		group->handles[i] = param_find(items[i].name);
+
+		if (group->handles[i] == PARAM_INVALID)
+			warnx("param group: unknown param %s", items[i].name);
+	}
+
+	return 0;
+}
+
+void
+param_group_fini(struct param_group_s *group)
+{
+	free(group->handles);
+	group->handles = NULL;
+	group->count = 0;
+}
+
+int
+param_group_get(const struct param_group_s *group, void *data)
+{
+	for (unsigned tries = 0; tries < PARAM_GROUP_TRIES; tries++) {
+		bool done = false;
+
+		/* no other task can change a value while the group is copied */
+		sched_lock();
+
+		/* unless one was preempted halfway through a change, wait for it */
+		if ((param_values_seq & 1) == 0) {
+			for (unsigned i = 0; i < group->count; i++) {
+				param_t param = group->handles[i];
+				const void *v = param_get_value_ptr(param);
+
+				if (v != NULL)
+					memcpy((uint8_t *)data + group->items[i].offset, v, param_size(param));
+			}
+
+			done = true;
+		}
+
+		sched_unlock();
+
+		if (done)
+			return 0;
+
+		usleep(PARAM_GROUP_RETRY_INTERVAL);
+	}
+
+	return -1;
+}
+
+unsigned
+param_get_change_count(param_t param)
+{
+	if (param_change_counts == NULL || !handle_in_range(param))
+		return 0;
+
+	return param_change_counts[param];
+}
+
 static int
 param_set_internal(param_t param, const void *val, bool mark_saved)
 {
@@ -360,6 +626,7 @@ param_set_internal(param_t param, const void *val, bool mark_saved)
 	bool params_changed = false;
 
 	param_lock();
+	param_values_seq++;
 
 	if (param_values == NULL)
 		utarray_new(param_values, &param_icd);
@@ -372,6 +639,8 @@ param_set_internal(param_t param, const void *val, bool mark_saved)
 	if (handle_in_range(param)) {
 
 		struct param_wbuf_s *s = param_find_changed(param);
+		/* a new entry always counts as a change, it may differ from the default */
+		bool value_changed = (s == NULL);
 
 		if (s == NULL) {
 
@@ -382,21 +651,21 @@ param_set_internal(param_t param, const void *val, bool mark_saved)
 				.unsaved = false
 			};
 
-			/* add it to the array and sort */
-			utarray_push_back(param_values, &buf);
-			utarray_sort(param_values, param_compare_values);
-
-			/* find it after sorting */
-			s = param_find_changed(param);
+			/* insert it in sorted position */
+			unsigned pos = param_values_lower_bound(param);
+			utarray_insert(param_values, &buf, pos);
+			s = (struct param_wbuf_s *)utarray_eltptr(param_values, pos);
 		}
 
 		/* update the changed value */
 		switch (param_type(param)) {
 		case PARAM_TYPE_INT32:
+			value_changed = value_changed || s->val.i != *(int32_t *)val;
 			s->val.i = *(int32_t *)val;
 			break;
 
 		case PARAM_TYPE_FLOAT:
+			value_changed = value_changed || s->val.f != *(float *)val;
 			s->val.f = *(float *)val;
 			break;
 
@@ -410,6 +679,7 @@ param_set_internal(param_t param, const void *val, bool mark_saved)
 				}
 			}
 
+			value_changed = value_changed || memcmp(s->val.p, val, param_size(param)) != 0;
 			memcpy(s->val.p, val, param_size(param));
 			break;
 
@@ -417,12 +687,16 @@ param_set_internal(param_t param, const void *val, bool mark_saved)
 			goto out;
 		}
 
+		if (value_changed)
+			param_count_change(param);
+
 		s->unsaved = !mark_saved;
 		params_changed = true;
 		result = 0;
 	}
 
 out:
+	param_values_seq++;
 	param_unlock();
 
 	/*
@@ -447,6 +721,7 @@ param_reset(param_t param)
 	struct param_wbuf_s *s = NULL;
 
 	param_lock();
+	param_values_seq++;
 
 	if (handle_in_range(param)) {
 
@@ -457,9 +732,14 @@ param_reset(param_t param)
 		if (s != NULL) {
 			int pos = utarray_eltidx(param_values, s);
 			utarray_erase(param_values, pos, 1);
+			param_count_change(param);
+
+			/* a journal record cannot express a reset */
+			param_journal_end = -1;
 		}
 	}
 
+	param_values_seq++;
 	param_unlock();
 
 	if (s != NULL)
@@ -470,6 +750,7 @@ void
 param_reset_all(void)
 {
 	param_lock();
+	param_values_seq++;
 
 	if (param_values != NULL) {
 		utarray_free(param_values);
@@ -478,11 +759,18 @@ param_reset_all(void)
 	/* mark as reset / deleted */
 	param_values = NULL;
 
+	param_count_change(PARAM_INVALID);
+	param_journal_end = -1;
+
+	param_values_seq++;
+
 	param_unlock();
 
 	param_notify_changes();
 }
 
+static int param_import_internal(int fd, bool mark_saved);
+
 static const char *param_default_file = "/eeprom/parameters";
 static char *param_user_file = NULL;
 
@@ -495,6 +783,8 @@ param_set_default_file(const char* filename)
 	}
 	if (filename)
 		param_user_file = strdup(filename);
+
+	param_journal_end = -1;
 	return 0;
 }
 
@@ -504,10 +794,102 @@ param_get_default_file(void)
 	return (param_user_file != NULL) ? param_user_file : param_default_file;
 }
 
+/**
+ * Close the default file with an end marker at the current position.
+ */
+static int
+param_journal_finish(int fd, unsigned records)
+{
+	uint32_t marker = PARAM_JOURNAL_END;
+	off_t end = lseek(fd, 0, SEEK_CUR);
+
+	if (end < 0 || write(fd, &marker, sizeof(marker)) != sizeof(marker)) {
+		param_journal_end = -1;
+		return ERROR;
+	}
+
+	param_journal_end = end;
+	param_journal_records = records;
+	return OK;
+}
+
+/**
+ * Append the values changed since the last save as a journal record.
+ */
+static int
+param_journal_append(int fd)
+{
+	struct param_wbuf_s *s = NULL;
+	bool unsaved = false;
+	uint32_t marker = PARAM_JOURNAL_MAGIC;
+
+	param_lock();
+
+	if (param_values != NULL) {
+		while ((s = (struct param_wbuf_s *)utarray_next(param_values, s)) != NULL) {
+			if (s->unsaved) {
+				unsaved = true;
+				break;
+			}
+		}
+	}
+
+	param_unlock();
+
+	/* nothing changed since the last save */
+	if (!unsaved)
+		return OK;
+
+	if (lseek(fd, param_journal_end, SEEK_SET) != param_journal_end)
+		return ERROR;
+
+	if (write(fd, &marker, sizeof(marker)) != sizeof(marker))
+		return ERROR;
+
+	if (param_export(fd, true) != OK)
+		return ERROR;
+
+	return param_journal_finish(fd, param_journal_records + 1);
+}
+
+/**
+ * Replay the journal records following the parameter document.
+ */
+static void
+param_journal_replay(int fd)
+{
+	unsigned records = 0;
+
+	param_journal_end = -1;
+
+	for (;;) {
+		uint32_t marker = 0;
+		off_t pos = lseek(fd, 0, SEEK_CUR);
+
+		if (read(fd, &marker, sizeof(marker)) != sizeof(marker) || marker != PARAM_JOURNAL_MAGIC) {
+			/* without an end marker (e.g. a file written by an older version) the next save rewrites the file */
+			if (marker == PARAM_JOURNAL_END)
+				param_journal_end = pos;
+
+			break;
+		}
+
+		if (param_import_internal(fd, true) != 0) {
+			/* interrupted append, keep what was read */
+			warnx("param journal record %u corrupt", records);
+			break;
+		}
+
+		records++;
+	}
+
+	param_journal_records = records;
+}
+
 int
 param_save_default(void)
 {
-	int res;
+	int res = ERROR;
 	int fd;
 
 	const char *filename = param_get_default_file();
@@ -520,7 +902,16 @@ param_save_default(void)
 		return ERROR;
 	}
 
-	res = param_export(fd, false);
+	/* append the changes while the journal is short, otherwise compact */
+	if (param_journal_end >= 0 && param_journal_records < PARAM_JOURNAL_MAX)
+		res = param_journal_append(fd);
+
+	if (res != OK) {
+		res = ERROR;
+
+		if (lseek(fd, 0, SEEK_SET) == 0 && param_export(fd, false) == OK)
+			res = param_journal_finish(fd, 0);
+	}
 
 	if (res != OK) {
 		warnx("failed to write parameters to file: %s", filename);
@@ -548,7 +939,15 @@ param_load_default(void)
 		return 1;
 	}
 
+	param_begin_batch();
+
 	int result = param_load(fd_load);
+
+	if (result == 0)
+		param_journal_replay(fd_load);
+
+	param_end_batch();
+
 	close(fd_load);
 
 	if (result != 0) {
@@ -559,6 +958,33 @@ param_load_default(void)
 	return 0;
 }
 
+uint32_t
+param_hash_check(void)
+{
+	uint32_t hash = 0;
+
+	param_lock();
+
+	for (param_t param = 0; handle_in_range(param); param++) {
+		const char *name = param_name(param);
+		uint8_t type = param_type(param);
+		const void *val = param_get_value_ptr(param);
+
+		hash = crc32part((const uint8_t *)name, strlen(name) + 1, hash);
+		hash = crc32part(&type, sizeof(type), hash);
+
+		if (val != NULL) {
+			hash = crc32part((const uint8_t *)val, param_size(param), hash);
+		}
+	}
+
+	param_unlock();
+
+	return hash;
+}
+
+#define PARAM_EXPORT_BLOCK	512
+
 int
 param_export(int fd, bool only_unsaved)
 {
@@ -566,9 +992,17 @@ param_export(int fd, bool only_unsaved)
 	struct bson_encoder_s encoder;
 	int	result = -1;
 
+	/* write the file in blocks rather than several writes per parameter, unbuffered if out of memory */
+	uint8_t *block = malloc(PARAM_EXPORT_BLOCK);
+
 	param_lock();
 
-	bson_encoder_init_file(&encoder, fd);
+	if (block != NULL) {
+		bson_encoder_init_file_buffered(&encoder, fd, block, PARAM_EXPORT_BLOCK);
+
+	} else {
+		bson_encoder_init_file(&encoder, fd);
+	}
 
 	/* no modified parameters -> we are done */
 	if (param_values == NULL) {
@@ -638,6 +1072,8 @@ out:
 	if (result == 0)
 		result = bson_encoder_fini(&encoder);
 
+	free(block);
+
 	return result;
 }
 
@@ -752,6 +1188,9 @@ out:
 	return result;
 }
 
+/** read block size for decoding parameter files */
+#define PARAM_IMPORT_BLOCK	512
+
 static int
 param_import_internal(int fd, bool mark_saved)
 {
@@ -759,23 +1198,44 @@ param_import_internal(int fd, bool mark_saved)
 	int result = -1;
 	struct param_import_state state;
 
-	if (bson_decoder_init_file(&decoder, fd, param_import_callback, &state)) {
+	/* read the file in blocks rather than a read per field, unbuffered if out of memory */
+	uint8_t *block = malloc(PARAM_IMPORT_BLOCK);
+
+	if (block != NULL) {
+		if (bson_decoder_init_file_buffered(&decoder, fd, block, PARAM_IMPORT_BLOCK, param_import_callback, &state)) {
+			debug("decoder init failed");
+			goto out;
+		}
+
+	} else if (bson_decoder_init_file(&decoder, fd, param_import_callback, &state)) {
 		debug("decoder init failed");
 		goto out;
 	}
 
 	state.mark_saved = mark_saved;
 
+	/* one notification for the whole document */
+	param_begin_batch();
+
 	do {
 		result = bson_decoder_next(&decoder);
 
 	} while (result > 0);
 
+	param_end_batch();
+
+	/* leave the file right after the document */
+	if (bson_decoder_fini(&decoder) != 0)
+		result = -1;
+
 out:
 
 	if (result < 0)
 		debug("BSON error decoding parameters");
 
+	if (block != NULL)
+		free(block);
+
 	return result;
 }
 
@@ -788,8 +1248,12 @@ param_import(int fd)
 int
 param_load(int fd)
 {
+	param_begin_batch();
 	param_reset_all();
-	return param_import_internal(fd, true);
+	int result = param_import_internal(fd, true);
+	param_end_batch();
+
+	return result;
 }
 
 void
@@ -47,6 +47,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <sys/types.h>
 
 /** Maximum size of the parameter backing file */
@@ -82,6 +83,24 @@ typedef uintptr_t	param_t;
  */
 #define PARAM_INVALID	((uintptr_t)0xffffffff)
 
+/** static parameter definition, see PARAM_DEFINE_* */
+struct param_info_s;
+
+/**
+ * Hold back parameter_update notifications.
+ *
+ * Changes made until the matching param_end_batch() are announced with a
+ * single notification, so that subscribers reload once for a burst of sets.
+ * Calls nest.
+ */
+__EXPORT void		param_begin_batch(void);
+
+/**
+ * End a batch started with param_begin_batch(), notifying of any changes made
+ * during it once the outermost batch ends.
+ */
+__EXPORT void		param_end_batch(void);
+
 /**
  * Look up a parameter by name.
  *
@@ -90,6 +109,16 @@ typedef uintptr_t	param_t;
  */
 __EXPORT param_t	param_find(const char *name);
 
+/**
+ * Look up the handle of a parameter from its definition.
+ *
+ * This is normally not used by user code; see PARAM_HANDLE instead.
+ *
+ * @param info		The parameter definition.
+ * @return		A handle to the parameter, or PARAM_INVALID if it is not in the table.
+ */
+__EXPORT param_t	param_for_info(const struct param_info_s *info);
+
 /**
  * Return the total number of parameters.
  *
@@ -161,6 +190,87 @@ __EXPORT size_t		param_size(param_t param);
  */
 __EXPORT int		param_get(param_t param, void *val);
 
+/**
+ * Obtain the value of a float parameter.
+ *
+ * @param param		A handle returned by param_find or PARAM_HANDLE.
+ * @return		The value, or zero if the handle is invalid or not a float.
+ */
+__EXPORT float		param_get_float(param_t param);
+
+/**
+ * Obtain the value of an int32 parameter.
+ *
+ * @param param		A handle returned by param_find or PARAM_HANDLE.
+ * @return		The value, or zero if the handle is invalid or not an int32.
+ */
+__EXPORT int32_t	param_get_int32(param_t param);
+
+/**
+ * Member of a parameter group: a parameter and where its value goes in the
+ * group structure.
+ */
+struct param_group_item_s {
+	const char	*name;
+	size_t		offset;
+};
+
+/** describe a member of a parameter group for a field of the group structure */
+#define PARAM_GROUP_ITEM(_struct, _field, _name)	{ _name, offsetof(_struct, _field) }
+
+/**
+ * Parameter group, a set of parameters read together as one snapshot.
+ */
+struct param_group_s {
+	const struct param_group_item_s	*items;
+	unsigned			count;
+	param_t				*handles;	/**< looked up by param_group_init */
+};
+
+/**
+ * Register a parameter group.
+ *
+ * Looks up the handles of all members once. Unknown parameters are reported
+ * and left out of snapshots.
+ *
+ * @param group		The group to initialise.
+ * @param items		Members of the group, must stay valid while the group is used.
+ * @param count		Number of members.
+ * @return		Zero on success, nonzero if out of memory.
+ */
+__EXPORT int		param_group_init(struct param_group_s *group, const struct param_group_item_s *items, unsigned count);
+
+/**
+ * Release a parameter group.
+ *
+ * @param group		A group initialised with param_group_init.
+ */
+__EXPORT void		param_group_fini(struct param_group_s *group);
+
+/**
+ * Copy the values of all members of a group as one consistent snapshot.
+ *
+ * No other task can change a parameter while the group is copied, so the
+ * snapshot never mixes values from before and after a change.
+ *
+ * @param group		A group initialised with param_group_init.
+ * @param data		The group structure to copy the values into.
+ * @return		Zero on success, nonzero if changes kept the snapshot from being taken.
+ */
+__EXPORT int		param_group_get(const struct param_group_s *group, void *data);
+
+/**
+ * Obtain the change counter of a parameter.
+ *
+ * The counter advances every time the value of the parameter changes, so a
+ * cached copy only needs to be refreshed when it has moved. It is read
+ * without taking the parameter lock.
+ *
+ * @param param		A handle returned by param_find or passed by param_foreach.
+ * @return		The change counter, zero if the parameter was never changed.
+ */
+__EXPORT unsigned	param_get_change_count(param_t param);
+
 /**
  * Set the value of a parameter.
  *
@@ -188,6 +298,17 @@ __EXPORT void		param_reset(param_t param);
  */
 __EXPORT void		param_reset_all(void);
 
+/**
+ * Compute a hash over the parameter table and the current values.
+ *
+ * The hash covers name, type and value of every parameter, so it changes
+ * with any value change as well as with a firmware that has a different
+ * parameter set. Ground stations compare it against their cached copy.
+ *
+ * @return		CRC32 of the parameter set.
+ */
+__EXPORT uint32_t	param_hash_check(void);
+
 /**
  * Export changed parameters to a file.
  *
@@ -255,14 +376,16 @@ __EXPORT const char*	param_get_default_file(void);
 /**
  * Save parameters to the default file.
  *
- * This function saves all parameters with non-default values.
+ * This function saves all parameters with non-default values. Values changed
+ * since the last load or save are appended to the file as a journal record,
+ * the whole file is rewritten after a reset or once the journal grew long.
  *
  * @return		Zero on success.
  */
 __EXPORT int 		param_save_default(void);
 
 /**
- * Load parameters from the default parameter file.
+ * Load parameters from the default parameter file, replaying its journal.
  *
  * @return		Zero on success.
  */
@@ -273,7 +396,13 @@ __EXPORT int 		param_load_default(void);
  *
  * Note that these structures are not known by name; they are
  * collected into a section that is iterated by the parameter
- * code.
+ * code. Each one is placed in a section named after the parameter
+ * so that the linker script can emit the table sorted by name.
+ *
+ * The definitions are global symbols named __param__<name>, code that uses
+ * a parameter can declare it with PARAM_DECLARE and get its handle with
+ * PARAM_HANDLE without a search by name. Using a parameter which is not
+ * part of the build then fails at link time.
  *
  * Note that these macros cannot be used in C++ code due to
  * their use of designated initializers.  They should probably
@@ -282,8 +411,8 @@ __EXPORT int 		param_load_default(void);
 
 /** define an int32 parameter */
 #define PARAM_DEFINE_INT32(_name, _default)		\
-	static const					\
-	__attribute__((used, section("__param")))	\
+	const						\
+	__attribute__((used, section("__param." #_name)))	\
 	struct param_info_s __param__##_name = {	\
 		#_name,					\
 		PARAM_TYPE_INT32,			\
@@ -292,8 +421,8 @@ __EXPORT int 		param_load_default(void);
 
 /** define a float parameter */
 #define PARAM_DEFINE_FLOAT(_name, _default)		\
-	static const					\
-	__attribute__((used, section("__param")))	\
+	const						\
+	__attribute__((used, section("__param." #_name)))	\
 	struct param_info_s __param__##_name = {	\
 		#_name,					\
 		PARAM_TYPE_FLOAT,			\
@@ -302,14 +431,26 @@ __EXPORT int 		param_load_default(void);
 
 /** define a parameter that points to a structure */
 #define PARAM_DEFINE_STRUCT(_name, _default)		\
-	static const					\
-	__attribute__((used, section("__param")))	\
+	const						\
+	__attribute__((used, section("__param." #_name)))	\
 	struct param_info_s __param__##_name = {	\
 		#_name,					\
 		PARAM_TYPE_STRUCT + sizeof(_default),	\
 		.val.p = &_default			\
 	}
 
+/** declare a parameter defined in another file, at file scope */
+#ifdef __cplusplus
+#define PARAM_DECLARE(_name)				\
+	extern "C" const struct param_info_s __param__##_name
+#else
+#define PARAM_DECLARE(_name)				\
+	extern const struct param_info_s __param__##_name
+#endif
+
+/** handle of a declared parameter */
+#define PARAM_HANDLE(_name)	param_for_info(&__param__##_name)
+
 /**
  * Parameter value union.
  */
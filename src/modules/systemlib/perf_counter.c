@@ -37,13 +37,38 @@
  * @brief Performance measuring tools.
  */
 
+#include <nuttx/arch.h>
+#include <nuttx/irq.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/queue.h>
 #include <drivers/drv_hrt.h>
 
 #include "perf_counter.h"
 
+/*
+ * Every counter keeps its state twice: one shard is only updated from
+ * thread context, the other only from interrupt context. An interrupt
+ * therefore never lands in the middle of an update of the state it
+ * changes itself, and updates need neither locks nor irqsave.
+ *
+ * Each shard carries a sequence number, odd while an update is in
+ * progress, so readers can take a consistent copy. A reader that
+ * preempted an update in progress gives up after a few tries and uses
+ * what it got, so that readers never block either.
+ *
+ * perf_begin / perf_end pairs work per shard, so they must be called
+ * from the same context. Updates from several threads, or from nested
+ * interrupts, to one counter are not serialised, as before.
+ */
+#define PERF_SHARD_THREAD	0
+#define PERF_SHARD_INTERRUPT	1
+#define PERF_SHARDS		2
+
+/** reads of a shard that is being updated before the copy is used anyway */
+#define PERF_READ_RETRIES	3
+
 /**
  * Header common to all counters.
  */
@@ -53,19 +78,27 @@ struct perf_ctr_header {
 	const char		*name;	/**< counter name */
 };
 
+/**
+ * PC_EVENT counter state.
+ */
+struct perf_shard_count {
+	volatile uint32_t	seq;
+	uint64_t		event_count;
+};
+
 /**
  * PC_EVENT counter.
  */
 struct perf_ctr_count {
 	struct perf_ctr_header	hdr;
-	uint64_t		event_count;
+	struct perf_shard_count	shard[PERF_SHARDS];
 };
 
 /**
- * PC_ELAPSED counter.
+ * PC_ELAPSED counter state.
  */
-struct perf_ctr_elapsed {
-	struct perf_ctr_header	hdr;
+struct perf_shard_elapsed {
+	volatile uint32_t	seq;
 	uint64_t		event_count;
 	uint64_t		time_start;
 	uint64_t		time_total;
@@ -74,17 +107,44 @@ struct perf_ctr_elapsed {
 };
 
 /**
- * PC_INTERVAL counter.
+ * PC_ELAPSED counter.
  */
-struct perf_ctr_interval {
+struct perf_ctr_elapsed {
 	struct perf_ctr_header	hdr;
+	struct perf_shard_elapsed shard[PERF_SHARDS];
+};
+
+/**
+ * PC_HISTOGRAM counter.
+ *
+ * The buckets are shared by both contexts and incremented atomically.
+ */
+struct perf_ctr_histogram {
+	struct perf_ctr_elapsed	elapsed;
+	uint32_t		buckets[PERF_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * PC_INTERVAL counter state.
+ */
+struct perf_shard_interval {
+	volatile uint32_t	seq;
 	uint64_t		event_count;
 	uint64_t		time_event;
 	uint64_t		time_first;
 	uint64_t		time_last;
 	uint64_t		time_least;
 	uint64_t		time_most;
+};
 
+/**
+ * PC_INTERVAL counter.
+ *
+ * Intervals are measured between events in the same context.
+ */
+struct perf_ctr_interval {
+	struct perf_ctr_header	hdr;
+	struct perf_shard_interval shard[PERF_SHARDS];
 };
 
 /**
@@ -92,6 +152,95 @@ struct perf_ctr_interval {
  */
 static sq_queue_t	perf_counters;
 
+/**
+ * The shard the caller may update.
+ */
+static inline unsigned
+perf_shard(void)
+{
+	return up_interrupt_context() ? PERF_SHARD_INTERRUPT : PERF_SHARD_THREAD;
+}
+
+static inline void
+perf_update_begin(volatile uint32_t *seq)
+{
+	(*seq)++;
+	__sync_synchronize();
+}
+
+static inline void
+perf_update_end(volatile uint32_t *seq)
+{
+	__sync_synchronize();
+	(*seq)++;
+}
+
+/**
+ * Take a consistent copy of a shard.
+ *
+ * @param shard			The shard, starting with its sequence number.
+ * @param copy			Buffer for the copy.
+ * @param size			Size of the shard.
+ */
+static void
+perf_read_shard(const void *shard, void *copy, size_t size)
+{
+	const volatile uint32_t *seq = (const volatile uint32_t *)shard;
+
+	for (unsigned i = 0; i < PERF_READ_RETRIES; i++) {
+		uint32_t before = *seq;
+		__sync_synchronize();
+		memcpy(copy, shard, size);
+		__sync_synchronize();
+
+		if (((before & 1) == 0) && (before == *seq))
+			break;
+	}
+}
+
+/**
+ * Sum of the event counts of all shards of a counter.
+ */
+static uint64_t
+perf_count_total(struct perf_ctr_count *pcc)
+{
+	uint64_t total = 0;
+
+	for (unsigned i = 0; i < PERF_SHARDS; i++) {
+		struct perf_shard_count s;
+		perf_read_shard(&pcc->shard[i], &s, sizeof(s));
+		total += s.event_count;
+	}
+
+	return total;
+}
+
+/**
+ * The elapsed times of all shards of a counter in one.
+ */
+static void
+perf_elapsed_total(struct perf_ctr_elapsed *pce, struct perf_shard_elapsed *total)
+{
+	memset(total, 0, sizeof(*total));
+
+	for (unsigned i = 0; i < PERF_SHARDS; i++) {
+		struct perf_shard_elapsed s;
+		perf_read_shard(&pce->shard[i], &s, sizeof(s));
+
+		if (s.event_count == 0)
+			continue;
+
+		if ((total->event_count == 0) || (s.time_least < total->time_least))
+			total->time_least = s.time_least;
+
+		if (s.time_most > total->time_most)
+			total->time_most = s.time_most;
+
+		total->event_count += s.event_count;
+		total->time_total += s.time_total;
+	}
+}
+
 
 perf_counter_t
 perf_alloc(enum perf_counter_type type, const char *name)
@@ -111,6 +260,10 @@ perf_alloc(enum perf_counter_type type, const char *name)
 		ctr = (perf_counter_t)calloc(sizeof(struct perf_ctr_interval), 1);
 		break;
 
+	case PC_HISTOGRAM:
+		ctr = (perf_counter_t)calloc(sizeof(struct perf_ctr_histogram), 1);
+		break;
+
 	default:
 		break;
 	}
@@ -141,33 +294,42 @@ perf_count(perf_counter_t handle)
 		return;
 
 	switch (handle->type) {
-	case PC_COUNT:
-		((struct perf_ctr_count *)handle)->event_count++;
+	case PC_COUNT: {
+		struct perf_shard_count *s = &((struct perf_ctr_count *)handle)->shard[perf_shard()];
+
+		perf_update_begin(&s->seq);
+		s->event_count++;
+		perf_update_end(&s->seq);
 		break;
+	}
 
 	case PC_INTERVAL: {
-		struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
+		struct perf_shard_interval *s = &((struct perf_ctr_interval *)handle)->shard[perf_shard()];
 		hrt_abstime now = hrt_absolute_time();
 
-		switch (pci->event_count) {
+		perf_update_begin(&s->seq);
+
+		switch (s->event_count) {
 		case 0:
-			pci->time_first = now;
+			s->time_first = now;
 			break;
 		case 1:
-			pci->time_least = now - pci->time_last;
-			pci->time_most = now - pci->time_last;
+			s->time_least = now - s->time_last;
+			s->time_most = now - s->time_last;
 			break;
 		default: {
-			hrt_abstime interval = now - pci->time_last;
-			if (interval < pci->time_least)
-				pci->time_least = interval;
-			if (interval > pci->time_most)
-				pci->time_most = interval;
+			hrt_abstime interval = now - s->time_last;
+			if (interval < s->time_least)
+				s->time_least = interval;
+			if (interval > s->time_most)
+				s->time_most = interval;
 			break;
 		}
 		}
-		pci->time_last = now;
-		pci->event_count++;
+		s->time_last = now;
+		s->event_count++;
+
+		perf_update_end(&s->seq);
 		break;
 	}
 
@@ -176,6 +338,117 @@ perf_count(perf_counter_t handle)
 	}
 }
 
+void
+perf_add_count(perf_counter_t handle, uint64_t count)
+{
+	if (handle == NULL)
+		return;
+
+	if (handle->type == PC_COUNT) {
+		struct perf_shard_count *s = &((struct perf_ctr_count *)handle)->shard[perf_shard()];
+
+		perf_update_begin(&s->seq);
+		s->event_count += count;
+		perf_update_end(&s->seq);
+	}
+}
+
+/**
+ * Index of the PC_HISTOGRAM bucket for an elapsed time.
+ *
+ * Times below 2^(PERF_HISTOGRAM_SUB_BITS + 1) have a bucket each, above
+ * that the top PERF_HISTOGRAM_SUB_BITS bits below the highest set bit
+ * select the bucket within its power of two.
+ */
+static unsigned
+perf_histogram_bucket(uint64_t elapsed)
+{
+	if (elapsed < (2 << PERF_HISTOGRAM_SUB_BITS))
+		return elapsed;
+
+	if (elapsed >= (1ULL << PERF_HISTOGRAM_MAX_BITS))
+		return PERF_HISTOGRAM_BUCKETS - 1;
+
+	unsigned msb = 31 - __builtin_clz((uint32_t)elapsed);
+
+	return ((msb - PERF_HISTOGRAM_SUB_BITS) << PERF_HISTOGRAM_SUB_BITS) +
+	       (unsigned)(elapsed >> (msb - PERF_HISTOGRAM_SUB_BITS));
+}
+
+/**
+ * Upper end of the time range of a PC_HISTOGRAM bucket.
+ */
+static uint64_t
+perf_histogram_limit(unsigned bucket)
+{
+	if (bucket < (2 << PERF_HISTOGRAM_SUB_BITS))
+		return bucket + 1;
+
+	unsigned msb = (bucket >> PERF_HISTOGRAM_SUB_BITS) + PERF_HISTOGRAM_SUB_BITS - 1;
+	uint64_t mantissa = (bucket & ((1 << PERF_HISTOGRAM_SUB_BITS) - 1)) + (1 << PERF_HISTOGRAM_SUB_BITS);
+
+	return (mantissa + 1) << (msb - PERF_HISTOGRAM_SUB_BITS);
+}
+
+
+/**
+ * Elapsed time below which a fraction of the events of a PC_HISTOGRAM
+ * counter fall, to the resolution of its buckets.
+ *
+ * @param pch			The counter.
+ * @param total			Its elapsed times, from perf_elapsed_total().
+ * @param fraction		The fraction in units of 0.01%.
+ */
+static uint64_t
+perf_histogram_percentile(struct perf_ctr_histogram *pch, const struct perf_shard_elapsed *total,
+			  unsigned fraction)
+{
+	uint64_t wanted = (total->event_count * fraction + 9999) / 10000;
+	uint64_t seen = 0;
+
+	for (unsigned i = 0; i < PERF_HISTOGRAM_BUCKETS; i++) {
+		seen += pch->buckets[i];
+
+		if (seen >= wanted) {
+			uint64_t limit = perf_histogram_limit(i);
+
+			/* the last bucket is open ended, and no bucket goes beyond the slowest event */
+			if ((i == PERF_HISTOGRAM_BUCKETS - 1) || (limit > total->time_most))
+				return total->time_most;
+
+			return limit;
+		}
+	}
+
+	return total->time_most;
+}
+
+/**
+ * Add one event to a shard of an elapsed time counter.
+ */
+static void
+perf_add_elapsed(perf_counter_t handle, struct perf_shard_elapsed *s, uint64_t elapsed)
+{
+	perf_update_begin(&s->seq);
+
+	s->event_count++;
+	s->time_total += elapsed;
+
+	if ((s->time_least > elapsed) || (s->time_least == 0))
+		s->time_least = elapsed;
+
+	if (s->time_most < elapsed)
+		s->time_most = elapsed;
+
+	perf_update_end(&s->seq);
+
+	if (handle->type == PC_HISTOGRAM) {
+		struct perf_ctr_histogram *pch = (struct perf_ctr_histogram *)handle;
+
+		__sync_fetch_and_add(&pch->buckets[perf_histogram_bucket(elapsed)], 1);
+	}
+}
+
 void
 perf_begin(perf_counter_t handle)
 {
@@ -184,7 +457,8 @@ perf_begin(perf_counter_t handle)
 
 	switch (handle->type) {
 	case PC_ELAPSED:
-		((struct perf_ctr_elapsed *)handle)->time_start = hrt_absolute_time();
+	case PC_HISTOGRAM:
+		((struct perf_ctr_elapsed *)handle)->shard[perf_shard()].time_start = hrt_absolute_time();
 		break;
 
 	default:
@@ -199,22 +473,13 @@ perf_end(perf_counter_t handle)
 		return;
 
 	switch (handle->type) {
-	case PC_ELAPSED: {
-			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
-
-			if (pce->time_start != 0) {
-				hrt_abstime elapsed = hrt_absolute_time() - pce->time_start;
-
-				pce->event_count++;
-				pce->time_total += elapsed;
-
-				if ((pce->time_least > elapsed) || (pce->time_least == 0))
-					pce->time_least = elapsed;
-
-				if (pce->time_most < elapsed)
-					pce->time_most = elapsed;
+	case PC_ELAPSED:
+	case PC_HISTOGRAM: {
+			struct perf_shard_elapsed *s = &((struct perf_ctr_elapsed *)handle)->shard[perf_shard()];
 
-				pce->time_start = 0;
+			if (s->time_start != 0) {
+				perf_add_elapsed(handle, s, hrt_absolute_time() - s->time_start);
+				s->time_start = 0;
 			}
 		}
 		break;
@@ -231,11 +496,26 @@ perf_cancel(perf_counter_t handle)
 		return;
 
 	switch (handle->type) {
-	case PC_ELAPSED: {
-			struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
+	case PC_ELAPSED:
+	case PC_HISTOGRAM:
+		((struct perf_ctr_elapsed *)handle)->shard[perf_shard()].time_start = 0;
+		break;
 
-			pce->time_start = 0;
-		}
+	default:
+		break;
+	}
+}
+
+void
+perf_set_elapsed(perf_counter_t handle, uint64_t elapsed)
+{
+	if (handle == NULL)
+		return;
+
+	switch (handle->type) {
+	case PC_ELAPSED:
+	case PC_HISTOGRAM:
+		perf_add_elapsed(handle, &((struct perf_ctr_elapsed *)handle)->shard[perf_shard()], elapsed);
 		break;
 
 	default:
@@ -251,32 +531,37 @@ perf_reset(perf_counter_t handle)
 	if (handle == NULL)
 		return;
 
+	/* the interrupt shard must not change under our feet */
+	irqstate_t state = irqsave();
+
 	switch (handle->type) {
-	case PC_COUNT:
-		((struct perf_ctr_count *)handle)->event_count = 0;
+	case PC_COUNT: {
+		struct perf_ctr_count *pcc = (struct perf_ctr_count *)handle;
+		memset(pcc->shard, 0, sizeof(pcc->shard));
 		break;
+	}
 
 	case PC_ELAPSED: {
 		struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
-		pce->event_count = 0;
-		pce->time_start = 0;
-		pce->time_total = 0;
-		pce->time_least = 0;
-		pce->time_most = 0;
+		memset(pce->shard, 0, sizeof(pce->shard));
 		break;
 	}
 
 	case PC_INTERVAL: {
 		struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
-		pci->event_count = 0;
-		pci->time_event = 0;
-		pci->time_first = 0;
-		pci->time_last = 0;
-		pci->time_least = 0;
-		pci->time_most = 0;
+		memset(pci->shard, 0, sizeof(pci->shard));
+		break;
+	}
+
+	case PC_HISTOGRAM: {
+		struct perf_ctr_histogram *pch = (struct perf_ctr_histogram *)handle;
+		memset(pch->elapsed.shard, 0, sizeof(pch->elapsed.shard));
+		memset(pch->buckets, 0, sizeof(pch->buckets));
 		break;
 	}
 	}
+
+	irqrestore(state);
 }
 
 void
@@ -295,31 +580,58 @@ perf_print_counter_fd(int fd, perf_counter_t handle)
 	case PC_COUNT:
 		dprintf(fd, "%s: %llu events\n",
 		       handle->name,
-		       ((struct perf_ctr_count *)handle)->event_count);
+		       perf_count_total((struct perf_ctr_count *)handle));
 		break;
 
 	case PC_ELAPSED: {
-		struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
+		struct perf_shard_elapsed total;
+		perf_elapsed_total((struct perf_ctr_elapsed *)handle, &total);
+
+		dprintf(fd, "%s: %llu events, %lluus elapsed, %lluus avg, min %lluus max %lluus\n",
+		       handle->name,
+		       total.event_count,
+		       total.time_total,
+		       (total.event_count != 0) ? total.time_total / total.event_count : 0,
+		       total.time_least,
+		       total.time_most);
+		break;
+	}
+
+	case PC_HISTOGRAM: {
+		struct perf_ctr_histogram *pch = (struct perf_ctr_histogram *)handle;
+		struct perf_shard_elapsed total;
+		perf_elapsed_total(&pch->elapsed, &total);
 
 		dprintf(fd, "%s: %llu events, %lluus elapsed, %lluus avg, min %lluus max %lluus\n",
 		       handle->name,
-		       pce->event_count,
-		       pce->time_total,
-		       pce->time_total / pce->event_count,
-		       pce->time_least,
-		       pce->time_most);
+		       total.event_count,
+		       total.time_total,
+		       (total.event_count != 0) ? total.time_total / total.event_count : 0,
+		       total.time_least,
+		       total.time_most);
+
+		if (total.event_count != 0) {
+			dprintf(fd, "%s: p50 %lluus p90 %lluus p99 %lluus p99.9 %lluus\n",
+			       handle->name,
+			       perf_histogram_percentile(pch, &total, 5000),
+			       perf_histogram_percentile(pch, &total, 9000),
+			       perf_histogram_percentile(pch, &total, 9900),
+			       perf_histogram_percentile(pch, &total, 9990));
+		}
+
 		break;
 	}
 
 	case PC_INTERVAL: {
-		struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
+		struct perf_summary_s summary;
+		perf_summary(handle, &summary);
 
 		dprintf(fd, "%s: %llu events, %lluus avg, min %lluus max %lluus\n",
 		       handle->name,
-		       pci->event_count,
-		       (pci->time_last - pci->time_first) / pci->event_count,
-		       pci->time_least,
-		       pci->time_most);
+		       summary.event_count,
+		       summary.time_avg,
+		       summary.time_least,
+		       summary.time_most);
 		break;
 	}
 
@@ -336,16 +648,26 @@ perf_event_count(perf_counter_t handle)
 
 	switch (handle->type) {
 	case PC_COUNT:
-		return ((struct perf_ctr_count *)handle)->event_count;
+		return perf_count_total((struct perf_ctr_count *)handle);
 
-	case PC_ELAPSED: {
-		struct perf_ctr_elapsed *pce = (struct perf_ctr_elapsed *)handle;
-		return pce->event_count;
+	case PC_ELAPSED:
+	case PC_HISTOGRAM: {
+		struct perf_shard_elapsed total;
+		perf_elapsed_total((struct perf_ctr_elapsed *)handle, &total);
+		return total.event_count;
 	}
 
 	case PC_INTERVAL: {
 		struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
-		return pci->event_count;
+		uint64_t event_count = 0;
+
+		for (unsigned i = 0; i < PERF_SHARDS; i++) {
+			struct perf_shard_interval s;
+			perf_read_shard(&pci->shard[i], &s, sizeof(s));
+			event_count += s.event_count;
+		}
+
+		return event_count;
 	}
 
 	default:
@@ -354,6 +676,94 @@ perf_event_count(perf_counter_t handle)
 	return 0;
 }
 
+perf_counter_t
+perf_next(perf_counter_t handle)
+{
+	if (handle == NULL)
+		return (perf_counter_t)sq_peek(&perf_counters);
+
+	return (perf_counter_t)sq_next(&handle->link);
+}
+
+const char *
+perf_name(perf_counter_t handle)
+{
+	return (handle != NULL) ? handle->name : NULL;
+}
+
+enum perf_counter_type
+perf_type(perf_counter_t handle)
+{
+	return (handle != NULL) ? handle->type : PC_COUNT;
+}
+
+void
+perf_summary(perf_counter_t handle, struct perf_summary_s *summary)
+{
+	memset(summary, 0, sizeof(*summary));
+
+	if (handle == NULL)
+		return;
+
+	switch (handle->type) {
+	case PC_COUNT:
+		summary->event_count = perf_count_total((struct perf_ctr_count *)handle);
+		break;
+
+	case PC_ELAPSED:
+	case PC_HISTOGRAM: {
+		struct perf_shard_elapsed total;
+		perf_elapsed_total((struct perf_ctr_elapsed *)handle, &total);
+
+		summary->event_count = total.event_count;
+		summary->time_least = total.time_least;
+		summary->time_most = total.time_most;
+
+		if (total.event_count != 0) {
+			summary->time_avg = total.time_total / total.event_count;
+
+			if (handle->type == PC_HISTOGRAM)
+				summary->time_p99 = perf_histogram_percentile((struct perf_ctr_histogram *)handle,
+						    &total, 9900);
+		}
+
+		break;
+	}
+
+	case PC_INTERVAL: {
+		struct perf_ctr_interval *pci = (struct perf_ctr_interval *)handle;
+		uint64_t time_span = 0;
+
+		for (unsigned i = 0; i < PERF_SHARDS; i++) {
+			struct perf_shard_interval s;
+			perf_read_shard(&pci->shard[i], &s, sizeof(s));
+
+			if (s.event_count == 0)
+				continue;
+
+			if (s.event_count > 1) {
+				if ((summary->time_least == 0) || (s.time_least < summary->time_least))
+					summary->time_least = s.time_least;
+
+				if (s.time_most > summary->time_most)
+					summary->time_most = s.time_most;
+			}
+
+			summary->event_count += s.event_count;
+			time_span += s.time_last - s.time_first;
+		}
+
+		if (summary->event_count != 0)
+			summary->time_avg = time_span / summary->event_count;
+
+		break;
+	}
+
+	default:
+		break;
+	}
+}
+
 void
 perf_print_all(int fd)
 {
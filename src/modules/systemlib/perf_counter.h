@@ -47,12 +47,38 @@
 enum perf_counter_type {
 	PC_COUNT,		/**< count the number of times an event occurs */
 	PC_ELAPSED,		/**< measure the time elapsed performing an event */
-	PC_INTERVAL		/**< measure the interval between instances of an event */
+	PC_INTERVAL,		/**< measure the interval between instances of an event */
+	PC_HISTOGRAM		/**< as PC_ELAPSED, also report percentiles of the elapsed time */
 };
 
+/**
+ * PC_HISTOGRAM ranges: 2^PERF_HISTOGRAM_SUB_BITS buckets for each power
+ * of two microseconds, so a bucket is at most 25% wide, up to
+ * 2^PERF_HISTOGRAM_MAX_BITS microseconds. The last bucket collects
+ * everything above.
+ */
+#define PERF_HISTOGRAM_SUB_BITS	2
+#define PERF_HISTOGRAM_MAX_BITS	18
+#define PERF_HISTOGRAM_BUCKETS	((PERF_HISTOGRAM_MAX_BITS - PERF_HISTOGRAM_SUB_BITS + 1) << PERF_HISTOGRAM_SUB_BITS)
+
 struct perf_ctr_header;
 typedef struct perf_ctr_header	*perf_counter_t;
 
+/**
+ * Snapshot of a counter, as reported by perf_summary.
+ *
+ * Times are in microseconds; for PC_COUNT only event_count is used, for
+ * PC_INTERVAL the times describe the interval between events and p99 is
+ * left zero, as it is for PC_ELAPSED.
+ */
+struct perf_summary_s {
+	uint64_t		event_count;
+	uint64_t		time_avg;
+	uint64_t		time_least;
+	uint64_t		time_most;
+	uint64_t		time_p99;
+};
+
 __BEGIN_DECLS
 
 /**
@@ -111,6 +137,28 @@ __EXPORT extern void		perf_end(perf_counter_t handle);
  */
 __EXPORT extern void		perf_cancel(perf_counter_t handle);
 
+/**
+ * Record a performance event with a known elapsed time.
+ *
+ * This call applies to counters that operate over ranges of time; PC_ELAPSED etc.
+ * It is the same as a perf_begin / perf_end pair elapsed microseconds apart,
+ * for events timed by the caller.
+ *
+ * @param handle		The handle returned from perf_alloc.
+ * @param elapsed		The time elapsed in microseconds.
+ */
+__EXPORT extern void		perf_set_elapsed(perf_counter_t handle, uint64_t elapsed);
+
+/**
+ * Count a number of events at once.
+ *
+ * This call only affects PC_COUNT counters, e.g. to count bytes moved.
+ *
+ * @param handle		The handle returned from perf_alloc.
+ * @param count			The number of events to add.
+ */
+__EXPORT extern void		perf_add_count(perf_counter_t handle, uint64_t count);
+
 /**
  * Reset a performance counter.
  *
@@ -155,6 +203,38 @@ __EXPORT extern void		perf_reset_all(void);
  */
 __EXPORT extern uint64_t	perf_event_count(perf_counter_t handle);
 
+/**
+ * Walk the list of counters.
+ *
+ * Counters freed while walking the list must not be passed back in.
+ *
+ * @param handle		The previous counter, or NULL for the first one.
+ * @return			The next counter, or NULL at the end of the list.
+ */
+__EXPORT extern perf_counter_t	perf_next(perf_counter_t handle);
+
+/**
+ * Return the name a counter was allocated with.
+ *
+ * @param handle		The counter returned from perf_alloc.
+ */
+__EXPORT extern const char	*perf_name(perf_counter_t handle);
+
+/**
+ * Return the type a counter was allocated with.
+ *
+ * @param handle		The counter returned from perf_alloc.
+ */
+__EXPORT extern enum perf_counter_type perf_type(perf_counter_t handle);
+
+/**
+ * Take a snapshot of a counter without printing it.
+ *
+ * @param handle		The counter returned from perf_alloc.
+ * @param summary		Filled in with the current state of the counter.
+ */
+__EXPORT extern void		perf_summary(perf_counter_t handle, struct perf_summary_s *summary);
+
 __END_DECLS
 
 #endif
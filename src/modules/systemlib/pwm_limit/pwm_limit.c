@@ -45,14 +45,30 @@
 #include <stdbool.h>
 #include <drivers/drv_hrt.h>
 #include <stdio.h>
+#include <string.h>
 
 void pwm_limit_init(pwm_limit_t *limit)
 {
+	/* zero limits with zero scaling are a consistent cache */
+	memset(limit, 0, sizeof(*limit));
 	limit->state = PWM_LIMIT_STATE_INIT;
 	limit->time_armed = 0;
 	return;
 }
 
+static inline uint16_t pwm_limit_scale(float output, float scale, float offset, uint16_t min_pwm, uint16_t max_pwm)
+{
+	float pwm = output * scale + offset;
+	float lower = min_pwm;
+	float upper = max_pwm;
+
+	/* last line of defense against invalid inputs, clamped before the conversion so NaN ends up at min_pwm */
+	pwm = (pwm > lower) ? pwm : lower;
+	pwm = (pwm < upper) ? pwm : upper;
+
+	return (uint16_t)pwm;
+}
+
 void pwm_limit_calc(const bool armed, const unsigned num_channels, const uint16_t *disarmed_pwm, const uint16_t *min_pwm, const uint16_t *max_pwm, const float *output, uint16_t *effective_pwm, pwm_limit_t *limit)
 {
 
@@ -146,14 +162,25 @@ void pwm_limit_calc(const bool armed, const unsigned num_channels, const uint16_
 			}
 			break;
 		case PWM_LIMIT_STATE_ON:
-			for (unsigned i=0; i<num_channels; i++) {
-				effective_pwm[i] = output[i] * (max_pwm[i] - min_pwm[i])/2 + (max_pwm[i] + min_pwm[i])/2;
+			{
+				unsigned cached = (num_channels < PWM_LIMIT_MAX_CHANNELS) ? num_channels : PWM_LIMIT_MAX_CHANNELS;
+
+				/* the limits rarely change, redo the scaling only for channels where they did */
+				for (unsigned i=0; i<cached; i++) {
+					if (limit->min_pwm[i] != min_pwm[i] || limit->max_pwm[i] != max_pwm[i]) {
+						limit->min_pwm[i] = min_pwm[i];
+						limit->max_pwm[i] = max_pwm[i];
+						limit->scale[i] = (max_pwm[i] - min_pwm[i]) * 0.5f;
+						limit->offset[i] = (max_pwm[i] + min_pwm[i])/2;
+					}
+				}
+
+				for (unsigned i=0; i<cached; i++) {
+					effective_pwm[i] = pwm_limit_scale(output[i], limit->scale[i], limit->offset[i], limit->min_pwm[i], limit->max_pwm[i]);
+				}
 
-				/* last line of defense against invalid inputs */
-				if (effective_pwm[i] < min_pwm[i]) {
-					effective_pwm[i] = min_pwm[i];
-				} else if (effective_pwm[i] > max_pwm[i]) {
-					effective_pwm[i] = max_pwm[i];
+				for (unsigned i=cached; i<num_channels; i++) {
+					effective_pwm[i] = pwm_limit_scale(output[i], (max_pwm[i] - min_pwm[i]) * 0.5f, (max_pwm[i] + min_pwm[i])/2, min_pwm[i], max_pwm[i]);
 				}
 			}
 			break;
@@ -57,6 +57,10 @@ __BEGIN_DECLS
  * time to slowly ramp up the ESCs
  */
 #define RAMP_TIME_US 2500000
+/*
+ * number of channels whose output scaling is kept precomputed
+ */
+#define PWM_LIMIT_MAX_CHANNELS 8
 
 enum pwm_limit_state {
 	PWM_LIMIT_STATE_OFF = 0,
@@ -68,6 +72,12 @@ enum pwm_limit_state {
 typedef struct {
 	enum pwm_limit_state state;
 	uint64_t time_armed;
+	/* limits the scaling below was computed for */
+	uint16_t min_pwm[PWM_LIMIT_MAX_CHANNELS];
+	uint16_t max_pwm[PWM_LIMIT_MAX_CHANNELS];
+	/* maps an output of -1..1 onto min_pwm..max_pwm */
+	float scale[PWM_LIMIT_MAX_CHANNELS];
+	float offset[PWM_LIMIT_MAX_CHANNELS];
 } pwm_limit_t;
 
 __EXPORT void pwm_limit_init(pwm_limit_t *limit);
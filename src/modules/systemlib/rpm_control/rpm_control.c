@@ -0,0 +1,135 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2015 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file rpm_control.c
+ *
+ * Per-motor speed loop between the mixer and the ESC outputs.
+ */
+
+#include "rpm_control.h"
+#include <math.h>
+#include <string.h>
+
+void rpm_control_init(rpm_control_t *rc, uint32_t motors, float rpm_max, float p, float i)
+{
+	memset(rc, 0, sizeof(*rc));
+	rc->motors = motors;
+	rc->rpm_max = rpm_max;
+	rc->p = p;
+	rc->i = i;
+}
+
+void rpm_control_reset(rpm_control_t *rc)
+{
+	memset(rc->integral, 0, sizeof(rc->integral));
+	rc->sample_time = 0;
+}
+
+void rpm_control_update(rpm_control_t *rc, float *output, unsigned num_outputs, const int32_t *rpm,
+			unsigned num_rpm, uint64_t sample_time, uint64_t now)
+{
+	if (!(rc->rpm_max > 0.0f)) {
+		return;
+	}
+
+	bool fresh = (sample_time != 0) && (now >= sample_time) && (now - sample_time < RPM_CONTROL_TIMEOUT_US);
+
+	/* the integral only advances once per telemetry sample, by the time between samples */
+	float dt = 0.0f;
+
+	if (fresh && (sample_time != rc->sample_time)) {
+		if ((rc->sample_time != 0) && (sample_time > rc->sample_time)) {
+			dt = (sample_time - rc->sample_time) * 1e-6f;
+
+			if (dt > RPM_CONTROL_TIMEOUT_US * 1e-6f) {
+				dt = RPM_CONTROL_TIMEOUT_US * 1e-6f;
+			}
+		}
+
+		rc->sample_time = sample_time;
+	}
+
+	if (num_outputs > RPM_CONTROL_MAX_MOTORS) {
+		num_outputs = RPM_CONTROL_MAX_MOTORS;
+	}
+
+	for (unsigned n = 0; n < num_outputs; n++) {
+		if (!(rc->motors & (1 << n)) || !isfinite(output[n])) {
+			continue;
+		}
+
+		float thrust = (output[n] + 1.0f) * 0.5f;
+
+		if (thrust < 0.0f) {
+			thrust = 0.0f;
+
+		} else if (thrust > 1.0f) {
+			thrust = 1.0f;
+		}
+
+		/* roughly speed per throttle, so this linearizes thrust */
+		float throttle = sqrtf(thrust);
+
+		if (fresh && (n < num_rpm)) {
+			float error = throttle - fabsf((float)rpm[n]) / rc->rpm_max;
+
+			/* nothing to integrate while the motor idles */
+			if (thrust > 0.0f) {
+				rc->integral[n] += rc->i * error * dt;
+
+				if (rc->integral[n] > RPM_CONTROL_INTEGRAL_MAX) {
+					rc->integral[n] = RPM_CONTROL_INTEGRAL_MAX;
+
+				} else if (rc->integral[n] < -RPM_CONTROL_INTEGRAL_MAX) {
+					rc->integral[n] = -RPM_CONTROL_INTEGRAL_MAX;
+				}
+
+				throttle += rc->p * error + rc->integral[n];
+			}
+
+		} else {
+			rc->integral[n] = 0.0f;
+		}
+
+		if (throttle < 0.0f) {
+			throttle = 0.0f;
+
+		} else if (throttle > 1.0f) {
+			throttle = 1.0f;
+		}
+
+		output[n] = throttle * 2.0f - 1.0f;
+	}
+}
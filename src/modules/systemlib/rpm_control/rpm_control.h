@@ -0,0 +1,105 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2015 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file rpm_control.h
+ *
+ * Per-motor speed loop between the mixer and the ESC outputs.
+ *
+ * The mixer asks for thrust, but an ESC commanded with a throttle produces
+ * a speed that depends on the battery voltage and the load, and thrust
+ * grows with the square of the speed.  With ESC telemetry this stage turns
+ * each motor output into a speed setpoint proportional to the square root
+ * of the demanded thrust and closes a PI loop on the reported RPM.  Without
+ * fresh telemetry it keeps the square root feed-forward only.
+ */
+
+#ifndef RPM_CONTROL_H_
+#define RPM_CONTROL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+__BEGIN_DECLS
+
+/*
+ * number of motors with a speed loop
+ */
+#define RPM_CONTROL_MAX_MOTORS 8
+/*
+ * telemetry older than this is not used for feedback
+ */
+#define RPM_CONTROL_TIMEOUT_US 100000
+/*
+ * limit of the integral, as a fraction of full throttle
+ */
+#define RPM_CONTROL_INTEGRAL_MAX 0.3f
+
+typedef struct {
+	/* speed at full throttle, zero disables the stage */
+	float rpm_max;
+	/* throttle per error, both relative to rpm_max */
+	float p;
+	float i;
+	/* outputs driving motors, one bit per output */
+	uint32_t motors;
+	float integral[RPM_CONTROL_MAX_MOTORS];
+	/* time of the telemetry the integral was last advanced with */
+	uint64_t sample_time;
+} rpm_control_t;
+
+__EXPORT void rpm_control_init(rpm_control_t *rc, uint32_t motors, float rpm_max, float p, float i);
+
+__EXPORT void rpm_control_reset(rpm_control_t *rc);
+
+/**
+ * Adjust mixed motor outputs of -1..1 in place.
+ *
+ * Outputs not selected as motors are left alone. The telemetry of a motor
+ * is expected at the index of its output.
+ *
+ * @param rc		Loop state.
+ * @param output	Motor outputs, -1 for idle and 1 for full thrust.
+ * @param num_outputs	Number of outputs.
+ * @param rpm		Measured speed of each motor, the sign is ignored.
+ * @param num_rpm	Number of motors with telemetry.
+ * @param sample_time	Time the speeds were measured, 0 if unknown.
+ * @param now		Current time.
+ */
+__EXPORT void rpm_control_update(rpm_control_t *rc, float *output, unsigned num_outputs, const int32_t *rpm,
+				 unsigned num_rpm, uint64_t sample_time, uint64_t now);
+
+__END_DECLS
+
+#endif /* RPM_CONTROL_H_ */
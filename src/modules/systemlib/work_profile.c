@@ -0,0 +1,170 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file work_profile.c
+ *
+ * Latency and run time accounting of work queue items.
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/clock.h>
+#include <nuttx/irq.h>
+#include <string.h>
+
+#include "work_profile.h"
+
+static struct work_profile_s	work_profiles[WORK_PROFILE_MAX];
+static uint32_t			work_profile_overflow;
+static hrt_abstime		work_profile_start;
+
+/**
+ * Find the slot of a work item, taking a free one if it has none.
+ */
+static struct work_profile_s *
+work_profile_slot(struct work_s *work)
+{
+	struct work_profile_s *slot = NULL;
+	irqstate_t flags = irqsave();
+
+	for (unsigned i = 0; i < WORK_PROFILE_MAX; i++) {
+		if (work_profiles[i].work == work) {
+			slot = &work_profiles[i];
+			break;
+		}
+
+		if ((slot == NULL) && (work_profiles[i].work == NULL))
+			slot = &work_profiles[i];
+	}
+
+	if (slot != NULL) {
+		slot->work = work;
+
+	} else {
+		work_profile_overflow++;
+	}
+
+	irqrestore(flags);
+
+	return slot;
+}
+
+/**
+ * Worker wrapper, runs the real worker and accounts it.
+ */
+static void
+work_profile_run(void *arg)
+{
+	struct work_profile_s *slot = (struct work_profile_s *)arg;
+
+	/* the worker may queue itself again, take what we need first */
+	worker_t worker = slot->worker;
+	void *worker_arg = slot->arg;
+	hrt_abstime start = hrt_absolute_time();
+	uint32_t latency = (start > slot->due) ? start - slot->due : 0;
+
+	worker(worker_arg);
+
+	uint32_t run = hrt_absolute_time() - start;
+
+	slot->count++;
+	slot->latency_total += latency;
+	slot->run_total += run;
+
+	if (latency > slot->latency_max)
+		slot->latency_max = latency;
+
+	if (run > slot->run_max)
+		slot->run_max = run;
+}
+
+int
+work_queue_profiled(int qid, struct work_s *work, worker_t worker, void *arg, uint32_t delay, const char *name)
+{
+	struct work_profile_s *slot = work_profile_slot(work);
+
+	if (slot == NULL)
+		return work_queue(qid, work, worker, arg, delay);
+
+	slot->worker = worker;
+	slot->arg = arg;
+	slot->name = name;
+	slot->qid = qid;
+	slot->due = hrt_absolute_time() + (hrt_abstime)delay * USEC_PER_TICK;
+
+	return work_queue(qid, work, work_profile_run, slot, delay);
+}
+
+bool
+work_profile_get(unsigned index, struct work_profile_s *profile)
+{
+	if ((index >= WORK_PROFILE_MAX) || (work_profiles[index].work == NULL))
+		return false;
+
+	irqstate_t flags = irqsave();
+	memcpy(profile, &work_profiles[index], sizeof(*profile));
+	irqrestore(flags);
+
+	return true;
+}
+
+void
+work_profile_reset(void)
+{
+	irqstate_t flags = irqsave();
+
+	for (unsigned i = 0; i < WORK_PROFILE_MAX; i++) {
+		work_profiles[i].count = 0;
+		work_profiles[i].latency_total = 0;
+		work_profiles[i].latency_max = 0;
+		work_profiles[i].run_total = 0;
+		work_profiles[i].run_max = 0;
+	}
+
+	work_profile_overflow = 0;
+	work_profile_start = hrt_absolute_time();
+	irqrestore(flags);
+}
+
+hrt_abstime
+work_profile_since(void)
+{
+	return work_profile_start;
+}
+
+uint32_t
+work_profile_overflows(void)
+{
+	return work_profile_overflow;
+}
@@ -0,0 +1,117 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file work_profile.h
+ *
+ * Latency and run time accounting of work queue items.
+ *
+ * Items queued with work_queue_profiled instead of work_queue are run
+ * through a wrapper that records how long after their due time they
+ * started and how long they ran. 'work_queue status' shows the result.
+ */
+
+#ifndef WORK_PROFILE_H_
+#define WORK_PROFILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <nuttx/wqueue.h>
+#include <drivers/drv_hrt.h>
+
+/** number of work items that can be accounted */
+#define WORK_PROFILE_MAX	32
+
+/**
+ * Accounting of one work item, times in microseconds.
+ */
+struct work_profile_s {
+	struct work_s	*work;		/**< the work item, NULL if the slot is free */
+	worker_t	worker;		/**< worker of the pending call */
+	void		*arg;		/**< argument of the pending call */
+	const char	*name;		/**< reported name, from the last queue call */
+	uint8_t		qid;		/**< HPWORK or LPWORK */
+	hrt_abstime	due;		/**< time the pending call should run */
+	uint32_t	count;		/**< calls run */
+	uint64_t	latency_total;	/**< sum of start delays past the due time */
+	uint32_t	latency_max;
+	uint64_t	run_total;	/**< sum of run times */
+	uint32_t	run_max;
+};
+
+__BEGIN_DECLS
+
+/**
+ * Queue work like work_queue, accounting it.
+ *
+ * When all slots are taken the work is queued without accounting.
+ *
+ * @param qid			HPWORK or LPWORK.
+ * @param work			The work item, identifies the slot.
+ * @param worker		Function to run.
+ * @param arg			Argument of the worker.
+ * @param delay			Delay in ticks.
+ * @param name			Name to report the item with, not copied.
+ * @return			The result of work_queue.
+ */
+__EXPORT extern int	work_queue_profiled(int qid, struct work_s *work, worker_t worker, void *arg,
+					    uint32_t delay, const char *name);
+
+/**
+ * Take a copy of the accounting of one slot.
+ *
+ * @param index			Slot, 0 to WORK_PROFILE_MAX - 1.
+ * @param profile		Filled in.
+ * @return			false if the slot is not in use.
+ */
+__EXPORT extern bool	work_profile_get(unsigned index, struct work_profile_s *profile);
+
+/**
+ * Clear the accounting of all slots.
+ */
+__EXPORT extern void	work_profile_reset(void);
+
+/**
+ * Return the time accounting started, at boot or the last reset.
+ */
+__EXPORT extern hrt_abstime	work_profile_since(void);
+
+/**
+ * Return the number of queue calls that found all slots taken.
+ */
+__EXPORT extern uint32_t work_profile_overflows(void);
+
+__END_DECLS
+
+#endif /* WORK_PROFILE_H_ */
@@ -61,10 +61,17 @@ public:
 		if (list != NULL) list->add(this);
 	}
 	void update() {
+		update(getDataVoidPtr());
+	}
+	/**
+	 * Update with the data pointer already known,
+	 * see control::SuperBlock::plan()
+	 */
+	void update(void *data) {
 		if (_handle > 0) {
-			orb_publish(getMeta(), getHandle(), getDataVoidPtr());
+			orb_publish(getMeta(), getHandle(), data);
 		} else {
-			setHandle(orb_advertise(getMeta(), getDataVoidPtr()));
+			setHandle(orb_advertise(getMeta(), data));
 		}
 	}
 	virtual void *getDataVoidPtr() = 0;
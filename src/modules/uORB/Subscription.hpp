@@ -70,8 +70,15 @@ public:
 	}
 	bool updated();
 	void update() {
+		update(getDataVoidPtr());
+	}
+	/**
+	 * Update with the data pointer already known,
+	 * see control::SuperBlock::plan()
+	 */
+	void update(void *data) {
 		if (updated()) {
-			orb_copy(_meta, _handle, getDataVoidPtr());
+			orb_copy(_meta, _handle, data);
 		}
 	}
 	virtual void *getDataVoidPtr() = 0;
@@ -44,3 +44,10 @@ SRCS			= uORB.cpp \
 			  objects_common.cpp \
 			  Publication.cpp \
 			  Subscription.cpp
+
+# Take topic buffers and subscriber records from static storage instead of
+# the heap. The arena is sized from the topics in objects_common.cpp,
+# UORB_SUBSCRIBER_POOL_SIZE sets the number of subscriber records.
+ifeq ($(CONFIG),px4fmu-v2_default)
+EXTRACXXFLAGS		= -DUORB_STATIC_ALLOCATION
+endif
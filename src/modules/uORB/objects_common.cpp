@@ -45,20 +45,50 @@
 
 #include <drivers/drv_orb_dev.h>
 
+#include "uORB.h"
+
+#ifdef UORB_STATIC_ALLOCATION
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Size the topic buffer arena from the definitions below. Every ORB_DEFINE
+ * in this file adds a link to a chain of specialisations numbered by
+ * __COUNTER__, each holding the sum of the topic sizes up to it, rounded
+ * the way topic_alloc() rounds them.
+ */
+template <int N> struct orb_arena_sum;
+
+#define ORB_ARENA_ROUND(_size)		(((_size) + 7) & ~(size_t)7)
+#define ORB_ARENA_BASE(_n)		template <> struct orb_arena_sum<_n + 1> { static const size_t value = 0; }
+#define ORB_ARENA_LINK(_n, _struct)	template <> struct orb_arena_sum<_n + 1> {			\
+						static const size_t value = orb_arena_sum<_n>::value +	\
+							ORB_ARENA_ROUND(sizeof(_struct)); };
+#define ORB_ARENA_TOTAL(_n)		orb_arena_sum<_n>::value
+
+ORB_ARENA_BASE(__COUNTER__);
+
+#undef ORB_DEFINE
+#define ORB_DEFINE(_name, _struct)			\
+	ORB_ARENA_LINK(__COUNTER__, _struct)		\
+	const struct orb_metadata __orb_##_name = {	\
+		#_name,					\
+		sizeof(_struct)				\
+	}; struct hack
+
+#endif
+
 #include <drivers/drv_mag.h>
 ORB_DEFINE(sensor_mag0, struct mag_report);
 ORB_DEFINE(sensor_mag1, struct mag_report);
 ORB_DEFINE(sensor_mag2, struct mag_report);
 
 #include <drivers/drv_accel.h>
-ORB_DEFINE(sensor_accel0, struct accel_report);
-ORB_DEFINE(sensor_accel1, struct accel_report);
-ORB_DEFINE(sensor_accel2, struct accel_report);
+ORB_DEFINE(sensor_accel, struct accel_report);
 
 #include <drivers/drv_gyro.h>
-ORB_DEFINE(sensor_gyro0, struct gyro_report);
-ORB_DEFINE(sensor_gyro1, struct gyro_report);
-ORB_DEFINE(sensor_gyro2, struct gyro_report);
+ORB_DEFINE(sensor_gyro, struct gyro_report);
 
 #include <drivers/drv_baro.h>
 ORB_DEFINE(sensor_baro0, struct baro_report);
@@ -81,6 +111,7 @@ ORB_DEFINE(sensor_combined, struct sensor_combined_s);
 
 #include "topics/vehicle_gps_position.h"
 ORB_DEFINE(vehicle_gps_position, struct vehicle_gps_position_s);
+ORB_DEFINE(sensor_gps, struct vehicle_gps_position_s);
 
 #include "topics/satellite_info.h"
 ORB_DEFINE(satellite_info, struct satellite_info_s);
@@ -230,3 +261,45 @@ ORB_DEFINE(tecs_status, struct tecs_status_s);
 
 #include "topics/wind_estimate.h"
 ORB_DEFINE(wind_estimate, struct wind_estimate_s);
+
+#include "topics/bus_stats.h"
+ORB_DEFINE(bus_stats, struct bus_stats_s);
+
+#include "topics/io_link_status.h"
+ORB_DEFINE(io_link_status, struct io_link_status_s);
+
+#include "topics/control_latency.h"
+ORB_DEFINE(control_latency, struct control_latency_s);
+
+#include "topics/system_memory.h"
+ORB_DEFINE(system_memory, struct system_memory_s);
+
+#include "topics/perf_report.h"
+ORB_DEFINE(perf_report, struct perf_report_s);
+
+#include "topics/system_resources.h"
+ORB_DEFINE(system_resources, struct system_resources_s);
+
+#include "topics/deadline_status.h"
+ORB_DEFINE(deadline_status, struct deadline_status_s);
+
+#include "topics/sensor_imu.h"
+ORB_DEFINE(sensor_imu, struct sensor_imu_s);
+
+#include "topics/vehicle_magnetometer.h"
+ORB_DEFINE(vehicle_magnetometer, struct vehicle_magnetometer_s);
+
+#include "topics/vehicle_air_data.h"
+ORB_DEFINE(vehicle_air_data, struct vehicle_air_data_s);
+
+#ifdef UORB_STATIC_ALLOCATION
+
+#ifndef UORB_ARENA_SIZE
+# define UORB_ARENA_SIZE	ORB_ARENA_TOTAL(__COUNTER__)
+#endif
+
+/* uint64_t for alignment */
+uint64_t	orb_arena[(UORB_ARENA_SIZE + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+extern const size_t orb_arena_size = sizeof(orb_arena);
+
+#endif
@@ -62,6 +62,8 @@
 
 struct actuator_controls_s {
 	uint64_t timestamp;
+	uint64_t timestamp_sample;	/**< IMU sample the controls are based on, 0 if none */
+	uint64_t timestamp_attitude;	/**< when the controller received the attitude */
 	float	control[NUM_ACTUATOR_CONTROLS];
 };
 
@@ -55,6 +55,7 @@ struct airspeed_s {
 	uint64_t	timestamp;			/**< microseconds since system boot, needed to integrate */
 	float		indicated_airspeed_m_s;		/**< indicated airspeed in meters per second, -1 if unknown	 */
 	float		true_airspeed_m_s;		/**< true airspeed in meters per second, -1 if unknown */
+	float		eas2tas;			/**< true airspeed / indicated (equivalent) airspeed, 0 if unknown */
 	float		air_temperature_celsius;	/**< air temperature in degrees celsius, -1000 if unknown */
 };
 
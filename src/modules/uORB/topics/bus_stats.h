@@ -0,0 +1,77 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file bus_stats.h
+ *
+ * Load of the SPI and I2C buses, as measured by the device drivers.
+ */
+
+#ifndef BUS_STATS_H_
+#define BUS_STATS_H_
+
+#include "../uORB.h"
+#include <stdint.h>
+
+/**
+ * @addtogroup topics
+ * @{
+ */
+
+/** maximum number of buses reported */
+#define BUS_STATS_MAX	8
+
+/**
+ * Cumulative transfer statistics per bus since boot.
+ */
+struct bus_stats_s {
+	uint64_t	timestamp;			/**< microseconds since system boot */
+	uint8_t		count;				/**< number of valid entries */
+	uint8_t		bus_type[BUS_STATS_MAX];	/**< device::Device::DeviceBusType, 1 I2C, 2 SPI */
+	uint8_t		bus[BUS_STATS_MAX];		/**< bus number */
+	uint32_t	transfers[BUS_STATS_MAX];	/**< transfers completed */
+	uint32_t	waits[BUS_STATS_MAX];		/**< transfers that had to wait for the bus */
+	uint64_t	bytes[BUS_STATS_MAX];		/**< bytes moved */
+	uint64_t	busy_us[BUS_STATS_MAX];		/**< time the bus was transferring */
+	uint64_t	wait_us[BUS_STATS_MAX];		/**< time transfers waited for the bus */
+};
+
+/**
+ * @}
+ */
+
+/* register this as object request broker structure */
+ORB_DECLARE(bus_stats);
+
+#endif
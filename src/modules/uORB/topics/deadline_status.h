@@ -0,0 +1,86 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file deadline_status.h
+ *
+ * Deadline monitors of the periodic tasks, see systemlib/deadline.h.
+ */
+
+#ifndef TOPIC_DEADLINE_STATUS_H_
+#define TOPIC_DEADLINE_STATUS_H_
+
+#include "../uORB.h"
+#include <stdint.h>
+
+/**
+ * @addtogroup topics
+ * @{
+ */
+
+/** maximum number of monitors reported */
+#define DEADLINE_STATUS_MAX		12
+
+/** monitor name length, names are not terminated if they fill it */
+#define DEADLINE_STATUS_NAME_LEN	16
+
+/**
+ * One monitor, times in microseconds, counts since the monitor was created.
+ */
+struct deadline_monitor_s {
+	char		name[DEADLINE_STATUS_NAME_LEN];	/**< task name, possibly truncated */
+	uint32_t	period;				/**< longest acceptable time between iterations */
+	uint32_t	budget;				/**< longest acceptable iteration */
+	uint32_t	iterations;			/**< iterations completed */
+	uint32_t	overruns;			/**< iterations that took longer than the budget */
+	uint32_t	misses;				/**< iterations that started more than a period after the previous one */
+	uint32_t	exec_max;			/**< longest iteration */
+	uint64_t	last_fault;			/**< time of the last overrun or miss, 0 if none */
+};
+
+/**
+ * All deadline monitors.
+ */
+struct deadline_status_s {
+	uint64_t	timestamp;			/**< microseconds since system boot */
+	uint8_t		count;				/**< number of valid entries */
+	struct deadline_monitor_s monitors[DEADLINE_STATUS_MAX];
+};
+
+/**
+ * @}
+ */
+
+/* register this as object request broker structure */
+ORB_DECLARE(deadline_status);
+
+#endif
@@ -0,0 +1,84 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file io_link_status.h
+ *
+ * Quality of the serial link between FMU and PX4IO, as seen by the FMU.
+ */
+
+#ifndef IO_LINK_STATUS_H_
+#define IO_LINK_STATUS_H_
+
+#include "../uORB.h"
+#include <stdint.h>
+
+/**
+ * @addtogroup topics
+ * @{
+ */
+
+/** number of transaction latency buckets */
+#define IO_LINK_LATENCY_BUCKETS	8
+
+/**
+ * Cumulative link statistics since the driver started.
+ *
+ * The latency buckets end at 250, 500, 750, 1000, 1500, 2000 and 5000
+ * microseconds, the last one takes everything longer.
+ */
+struct io_link_status_s {
+	uint64_t	timestamp;		/**< microseconds since system boot */
+	uint64_t	busy_us;		/**< time spent in transactions */
+	uint32_t	transactions;		/**< transactions completed, errors included */
+	uint32_t	retries;		/**< transactions repeated after an error */
+	uint32_t	crc_errors;		/**< replies with a bad check byte, or IO reporting one */
+	uint32_t	timeouts;		/**< transactions without a reply */
+	uint32_t	short_packets;		/**< replies shorter than their header said */
+	uint32_t	uart_errors;		/**< overrun, noise and framing errors during a reply */
+	uint32_t	dma_errors;		/**< DMA transfer errors */
+	uint32_t	protocol_errors;	/**< replies rejecting the request or with the wrong size */
+	uint32_t	latency[IO_LINK_LATENCY_BUCKETS];	/**< completed transactions by duration */
+	uint16_t	latency_max_us;		/**< longest completed transaction */
+	float		utilization;		/**< percentage of time in transactions since the last publication */
+};
+
+/**
+ * @}
+ */
+
+/* register this as object request broker structure */
+ORB_DECLARE(io_link_status);
+
+#endif
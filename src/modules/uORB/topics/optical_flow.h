@@ -66,6 +66,11 @@ struct optical_flow_s {
 	uint8_t	quality;		/**< Quality of the measurement, 0: bad quality, 255: maximum quality */
 	uint8_t sensor_id;		/**< id of the sensor emitting the flow value */
 
+	uint32_t integration_timespan;	/**< time in microseconds the raw flow and the gyro integrals cover, 0 if no gyro integrals */
+	float gyro_x_rate_integral;	/**< body rotation about the X axis over integration_timespan, in radians */
+	float gyro_y_rate_integral;	/**< body rotation about the Y axis over integration_timespan, in radians */
+	float gyro_z_rate_integral;	/**< body rotation about the Z axis over integration_timespan, in radians */
+
 };
 
 /**
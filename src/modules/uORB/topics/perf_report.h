@@ -0,0 +1,89 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file perf_report.h
+ *
+ * Selected performance counters, published by the perf command for
+ * monitoring in flight.
+ */
+
+#ifndef TOPIC_PERF_REPORT_H_
+#define TOPIC_PERF_REPORT_H_
+
+#include "../uORB.h"
+#include <stdint.h>
+
+/**
+ * @addtogroup topics
+ * @{
+ */
+
+/** maximum number of counters in one report */
+#define PERF_REPORT_MAX		8
+
+/** counter name length, names are not terminated if they fill it */
+#define PERF_REPORT_NAME_LEN	16
+
+/**
+ * One counter, times in microseconds.
+ */
+struct perf_report_counter_s {
+	char		name[PERF_REPORT_NAME_LEN];	/**< counter name, possibly truncated */
+	uint32_t	count;				/**< events since boot or the last reset */
+	uint32_t	avg;				/**< average elapsed time or interval */
+	uint32_t	min;				/**< shortest elapsed time or interval */
+	uint32_t	max;				/**< longest elapsed time or interval */
+	uint32_t	p99;				/**< 99th percentile, PC_HISTOGRAM only */
+	uint8_t		type;				/**< enum perf_counter_type */
+};
+
+/**
+ * A batch of counters. When more counters are selected than fit in one
+ * report they are published in turn over consecutive reports.
+ */
+struct perf_report_s {
+	uint64_t	timestamp;			/**< microseconds since system boot */
+	uint8_t		count;				/**< number of valid entries */
+	uint8_t		first;				/**< index of counters[0] among the selected counters */
+	uint8_t		total;				/**< number of selected counters */
+	struct perf_report_counter_s counters[PERF_REPORT_MAX];
+};
+
+/**
+ * @}
+ */
+
+/* register this as object request broker structure */
+ORB_DECLARE(perf_report);
+
+#endif
@@ -88,6 +88,11 @@ struct sensor_combined_s {
 	float accelerometer_range_m_s2;		/**< Accelerometer measurement range in m/s^2 */
 	uint64_t accelerometer_timestamp;	/**< Accelerometer timestamp        */
 
+	float gyro_integral_rad[3];		/**< Coning corrected delta angle over gyro_integral_dt */
+	uint64_t gyro_integral_dt;		/**< Gyro integration time in microseconds, 0 if none */
+	float accelerometer_integral_m_s[3];	/**< Delta velocity over accelerometer_integral_dt */
+	uint64_t accelerometer_integral_dt;	/**< Accelerometer integration time in microseconds, 0 if none */
+
 	int16_t	magnetometer_raw[3];		/**< Raw magnetic field in NED body frame         */
 	float magnetometer_ga[3];		/**< Magnetic field in NED body frame, in Gauss   */
 	int magnetometer_mode;			/**< Magnetometer measurement mode */
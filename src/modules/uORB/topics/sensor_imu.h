@@ -0,0 +1,77 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2015 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file sensor_imu.h
+ *
+ * The gyro and accelerometer picked by the sensors app from the redundant
+ * instances, in the board frame. Much smaller than sensor_combined, for
+ * consumers that only want the one IMU to use.
+ */
+
+#ifndef TOPIC_SENSOR_IMU_H_
+#define TOPIC_SENSOR_IMU_H_
+
+#include <stdint.h>
+#include "../uORB.h"
+
+/**
+ * @addtogroup topics
+ * @{
+ */
+
+struct sensor_imu_s {
+	uint64_t timestamp;			/**< of the selected gyro sample */
+	float gyro_rad_s[3];			/**< angular velocity */
+	float gyro_integral_rad[3];		/**< delta angle over gyro_integral_dt */
+	uint32_t gyro_integral_dt;		/**< microseconds, 0 if the driver does not integrate */
+	uint64_t accelerometer_timestamp;
+	float accelerometer_m_s2[3];		/**< acceleration */
+	float accelerometer_integral_m_s[3];	/**< delta velocity over accelerometer_integral_dt */
+	uint32_t accelerometer_integral_dt;	/**< microseconds, 0 if the driver does not integrate */
+	uint8_t gyro_index;			/**< instance in use, 0..2 */
+	uint8_t accelerometer_index;		/**< instance in use, 0..2 */
+	uint8_t gyro_healthy;			/**< bitmask of the healthy gyro instances */
+	uint8_t accelerometer_healthy;		/**< bitmask of the healthy accelerometer instances */
+	uint16_t gyro_failovers;		/**< selection changes since boot */
+	uint16_t accelerometer_failovers;
+};
+
+/**
+ * @}
+ */
+
+/* register this as object request broker structure */
+ORB_DECLARE(sensor_imu);
+
+#endif
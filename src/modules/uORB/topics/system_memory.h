@@ -0,0 +1,78 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file system_memory.h
+ *
+ * Heap use and stack high-water marks of the running tasks.
+ */
+
+#ifndef TOPIC_SYSTEM_MEMORY_H_
+#define TOPIC_SYSTEM_MEMORY_H_
+
+#include "../uORB.h"
+#include <stdint.h>
+
+/**
+ * @addtogroup topics
+ * @{
+ */
+
+#define SYSTEM_MEMORY_MAX_TASKS	32
+#define SYSTEM_MEMORY_NAME_LEN	16
+
+struct system_memory_task_s {
+	int16_t pid;
+	uint16_t stack_size;		/**< bytes */
+	uint16_t stack_used;		/**< bytes ever used, from the stack fill pattern */
+	char name[SYSTEM_MEMORY_NAME_LEN];
+};
+
+struct system_memory_s {
+	uint64_t timestamp;
+	uint32_t heap_total;		/**< size of the heap */
+	uint32_t heap_used;		/**< bytes allocated */
+	uint32_t heap_peak;		/**< most bytes allocated when sampled since boot */
+	uint32_t heap_largest_free;	/**< largest free block */
+	uint8_t task_count;		/**< valid entries in tasks */
+	struct system_memory_task_s tasks[SYSTEM_MEMORY_MAX_TASKS];
+};
+
+/**
+ * @}
+ */
+
+/* register this as object request broker structure */
+ORB_DECLARE(system_memory);
+
+#endif
@@ -0,0 +1,114 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file system_resources.h
+ *
+ * One snapshot of where the CPU, memory and bandwidth go, published by
+ * the sysperf command. Rates, loads and losses cover the interval since
+ * the previous snapshot.
+ */
+
+#ifndef TOPIC_SYSTEM_RESOURCES_H_
+#define TOPIC_SYSTEM_RESOURCES_H_
+
+#include "../uORB.h"
+#include <stdint.h>
+
+/**
+ * @addtogroup topics
+ * @{
+ */
+
+#define SYSTEM_RESOURCES_MAX_TASKS	32
+#define SYSTEM_RESOURCES_MAX_PERF	4
+#define SYSTEM_RESOURCES_MAX_LINKS	4
+#define SYSTEM_RESOURCES_NAME_LEN	16
+
+struct system_resources_task_s {
+	int16_t pid;
+	uint16_t load;			/**< CPU time, 1/1000 of the interval */
+	uint16_t stack_free;		/**< bytes of stack never used */
+	char name[SYSTEM_RESOURCES_NAME_LEN];
+};
+
+/**
+ * A PC_HISTOGRAM counter, times in microseconds since boot or the last reset.
+ */
+struct system_resources_perf_s {
+	char name[SYSTEM_RESOURCES_NAME_LEN];	/**< counter name, not terminated if it fills the field */
+	uint32_t count;
+	uint32_t avg;
+	uint32_t max;
+	uint32_t p99;
+};
+
+/**
+ * A mavlink instance, from its telemetry_status.
+ */
+struct system_resources_link_s {
+	uint32_t tx_budget;		/**< bytes/s the streams are allowed to send */
+	float rate_tx;			/**< bytes/s sent */
+	float rate_mult;		/**< factor applied to the stream rates */
+	uint16_t tx_buf_free;		/**< minimum free space of the UART TX buffer */
+};
+
+struct system_resources_s {
+	uint64_t timestamp;
+	uint32_t interval;		/**< microseconds covered by the rates and loads */
+	uint16_t load;			/**< CPU time outside the idle task, 1/1000 */
+	uint32_t heap_free;		/**< bytes */
+	uint32_t heap_largest_free;	/**< largest free block */
+	uint32_t heap_peak;		/**< most bytes allocated when sampled since boot */
+	uint16_t orb_topics;		/**< number of topics */
+	float orb_rate;			/**< publications/s of all topics */
+	uint32_t orb_lost;		/**< publications subscribers never copied */
+	uint32_t orb_latency_max;	/**< worst publish to copy latency of any topic since boot, us */
+	float log_rate;			/**< messages/s the logger buffered */
+	float log_drop_rate;		/**< messages/s the logger dropped for a full buffer */
+	uint8_t link_count;		/**< valid entries in links */
+	uint8_t perf_count;		/**< valid entries in perf */
+	uint8_t task_count;		/**< valid entries in tasks */
+	struct system_resources_link_s links[SYSTEM_RESOURCES_MAX_LINKS];
+	struct system_resources_perf_s perf[SYSTEM_RESOURCES_MAX_PERF];	/**< the counters with the highest p99 */
+	struct system_resources_task_s tasks[SYSTEM_RESOURCES_MAX_TASKS];
+};
+
+/**
+ * @}
+ */
+
+/* register this as object request broker structure */
+ORB_DECLARE(system_resources);
+
+#endif
@@ -69,6 +69,16 @@ struct telemetry_status_s {
 	uint8_t txbuf;				/**< how full the tx buffer is as a percentage  */
 	uint8_t system_id;			/**< system id of the remote system */
 	uint8_t component_id;			/**< component id of the remote system */
+	float rate_rx;				/**< received bytes, kB/s */
+	float rate_tx;				/**< transmitted bytes, kB/s */
+	float rate_rx_msgs;			/**< received messages per second */
+	float rate_rx_errors;			/**< receive parser errors per second */
+	uint16_t tx_queue;			/**< peak bytes staged for one UART write in the last second */
+	uint16_t tx_buf_free;			/**< minimum free space of the UART TX buffer in the last second */
+	uint32_t tx_budget;			/**< bytes/s the streams are allowed to send */
+	float rate_mult;			/**< factor applied to the configured stream rates to fit the budget */
+	uint32_t setpoint_latency;		/**< mean time from SET_ATTITUDE_TARGET to the next actuator_controls_0 publication in the last second, us */
+	uint32_t setpoint_latency_max;		/**< maximum of the above, us */
 };
 
 /**
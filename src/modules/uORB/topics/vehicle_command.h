@@ -141,6 +141,9 @@ struct vehicle_command_s {
 /* register this as object request broker structure */
 ORB_DECLARE(vehicle_command);
 
+/* number of commands retained for queued subscribers, see orb_advertise_queue() */
+#define VEHICLE_COMMAND_QUEUE_LENGTH	4
+
 
 
 #endif
@@ -91,4 +91,7 @@ struct vehicle_gps_position_s {
 /* register this as object request broker structure */
 ORB_DECLARE(vehicle_gps_position);
 
+/* each receiver on its own, one instance per receiver */
+ORB_DECLARE(sensor_gps);
+
 #endif
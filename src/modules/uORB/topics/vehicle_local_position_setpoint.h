@@ -55,6 +55,12 @@ struct vehicle_local_position_setpoint_s {
 	float y;		/**< in meters NED			  		*/
 	float z;		/**< in meters NED			  		*/
 	float yaw;		/**< in radians NED -PI..+PI  		*/
+	float vx;		/**< velocity feed forward in m/s NED	*/
+	float vy;
+	float vz;
+	float acc_x;		/**< acceleration feed forward in m/s^2 NED */
+	float acc_y;
+	float acc_z;
 }; /**< Local position in NED frame */
 
 /**
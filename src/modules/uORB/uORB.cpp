@@ -51,6 +51,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <unistd.h>
+#include <sched.h>
 
 #include <nuttx/arch.h>
 #include <nuttx/wqueue.h>
@@ -70,6 +71,15 @@ namespace
 
 static const unsigned orb_maxpath = 64;
 
+/**
+ * Keep the compiler from moving topic data accesses across the sequence
+ * counter accesses of the lock-free read path.
+ */
+inline void orb_barrier()
+{
+	__asm__ __volatile__("" ::: "memory");
+}
+
 /* oddly, ERROR is not defined for c++ */
 #ifdef ERROR
 # undef ERROR
@@ -81,14 +91,99 @@ enum Flavor {
 	PARAM
 };
 
+#ifdef UORB_STATIC_ALLOCATION
+
+/*
+ * Topic buffers are carved out of a static arena instead of the heap, so
+ * the heap does not fragment as topics are published for the first time.
+ * The arena is defined with the topics in objects_common.cpp and holds one
+ * buffer of every topic defined there. Queues, loan buffers and further
+ * instances take what is left, then come from the heap again; 'uorb status'
+ * reports the arena use.
+ */
+extern uint64_t		orb_arena[];
+extern const size_t	orb_arena_size;
+
+size_t		arena_used;
+
+#endif
+
+/**
+ * Allocate a topic buffer.
+ *
+ * @param size		Buffer size in bytes.
+ * @return		The buffer, or nullptr if out of memory.
+ */
+uint8_t *
+topic_alloc(size_t size)
+{
+#ifdef UORB_STATIC_ALLOCATION
+	/* keep every buffer 8-byte aligned */
+	size_t rounded = (size + 7) & ~(size_t)7;
+	uint8_t *buf = nullptr;
+
+	irqstate_t flags = irqsave();
+
+	if (arena_used + rounded <= orb_arena_size) {
+		buf = (uint8_t *)orb_arena + arena_used;
+		arena_used += rounded;
+	}
+
+	irqrestore(flags);
+
+	if (buf != nullptr)
+		return buf;
+
+#endif
+	return new uint8_t[size];
+}
+
+/**
+ * Free a buffer obtained from topic_alloc.
+ *
+ * Arena memory is never reused; topic buffers live as long as the topic.
+ */
+void
+topic_free(uint8_t *buf)
+{
+#ifdef UORB_STATIC_ALLOCATION
+
+	if ((buf >= (uint8_t *)orb_arena) && (buf < (uint8_t *)orb_arena + orb_arena_size))
+		return;
+
+#endif
+	delete[] buf;
+}
+
+/**
+ * Arguments for ORBIOCADVERTISE.
+ */
+struct orb_advertdata {
+	const struct orb_metadata *meta;
+	int instance;
+};
+
+/**
+ * Build the path of a topic node.
+ *
+ * Instance zero is /obj/<name>, further instances of a multi-instance
+ * topic append the instance number.
+ */
 int
-node_mkpath(char *buf, Flavor f, const struct orb_metadata *meta)
+node_mkpath(char *buf, Flavor f, const struct orb_metadata *meta, int instance = 0)
 {
 	unsigned len;
 
-	len = snprintf(buf, orb_maxpath, "/%s/%s",
-		       (f == PUBSUB) ? "obj" : "param",
-		       meta->o_name);
+	if (instance == 0) {
+		len = snprintf(buf, orb_maxpath, "/%s/%s",
+			       (f == PUBSUB) ? "obj" : "param",
+			       meta->o_name);
+
+	} else {
+		len = snprintf(buf, orb_maxpath, "/%s/%s%d",
+			       (f == PUBSUB) ? "obj" : "param",
+			       meta->o_name, instance);
+	}
 
 	if (len >= orb_maxpath)
 		return -ENAMETOOLONG;
@@ -104,7 +199,7 @@ node_mkpath(char *buf, Flavor f, const struct orb_metadata *meta)
 class ORBDevNode : public device::CDev
 {
 public:
-	ORBDevNode(const struct orb_metadata *meta, const char *name, const char *path);
+	ORBDevNode(const struct orb_metadata *meta, const char *name, const char *path, int instance = 0);
 	~ORBDevNode();
 
 	virtual int		open(struct file *filp);
@@ -114,25 +209,145 @@ public:
 	virtual int		ioctl(struct file *filp, int cmd, unsigned long arg);
 
 	static ssize_t		publish(const orb_metadata *meta, orb_advert_t handle, const void *data);
+	static void		*loan(const orb_metadata *meta, orb_advert_t handle);
+	static int		commit(const orb_metadata *meta, orb_advert_t handle);
+	static int		peek(const orb_metadata *meta, orb_reader_t reader, const void **data, unsigned *generation);
+	static bool		peek_valid(orb_reader_t reader, unsigned generation);
+	static uint32_t		copy_batch(struct orb_batch_entry *entries, unsigned count);
+
+	/**
+	 * Print the statistics of the topic.
+	 *
+	 * @param last_generation	Generation count at the start of the
+	 *				measurement interval.
+	 * @param interval		Length of the measurement interval, or zero
+	 *				to print the publication count instead of a rate.
+	 */
+	void			print_info(unsigned last_generation, hrt_abstime interval);
+
+	unsigned		generation() { return _generation; }
+	unsigned		lost() { return _lost; }
+	hrt_abstime		latency_max() { return _latency_max; }
+	ORBDevNode		*next() { return _next; }
+	void			set_next(ORBDevNode *next) { _next = next; }
 
 protected:
 	virtual pollevent_t	poll_state(struct file *filp);
+	virtual void		poll_notify(pollevent_t events);
 	virtual void		poll_notify_one(struct pollfd *fds, pollevent_t events);
 
 private:
 	struct SubscriberData {
+		ORBDevNode	*node;		/**< node the subscription belongs to */
 		unsigned	generation;	/**< last generation the subscriber has seen */
 		unsigned	update_interval; /**< if nonzero minimum interval between updates */
 		struct hrt_call	update_call;	/**< deferred wakeup call if update_period is nonzero */
 		void		*poll_priv;	/**< saved copy of fds->f_priv while poll is active */
 		bool		update_reported; /**< true if we have reported the update via poll/check */
+		orb_callback_t	callback;	/**< if nonzero, called on the work queue when updated */
+		void		*callback_arg;	/**< argument passed to callback */
+		struct work_s	callback_work;	/**< work item used to run callback */
+		volatile bool	callback_pending; /**< true while callback_work is queued */
+		volatile bool	callback_running; /**< true while the work queue runs the callback */
+		bool		free_deferred;	/**< freed by the work queue once the running callback returns */
+		SubscriberData	*callback_next;	/**< next subscriber in _callbacks */
+		unsigned	lost;		/**< number of publications this subscriber never copied */
 	};
 
 	const struct orb_metadata *_meta;	/**< object metadata information */
 	uint8_t			*_data;		/**< allocated object buffer */
+	uint8_t			*_loan_data;	/**< spare buffer handed out by loan() */
+	hrt_abstime		*_stamps;	/**< publication time of each slot, queued topics only */
+	unsigned		_queue_size;	/**< number of publications held in _data, power of two */
+	bool			_loaned;	/**< true while _loan_data is held by a publisher */
 	hrt_abstime		_last_update;	/**< time the object was last updated */
 	volatile unsigned 	_generation;	/**< object generation count */
+	volatile unsigned	_reserved;	/**< generation count including publications still being copied */
+	volatile unsigned	_seq;		/**< incremented whenever a publication completes */
+	volatile unsigned	_writers;	/**< number of publications currently being copied */
 	pid_t			_publisher;	/**< if nonzero, current publisher */
+	bool			_advertised;	/**< true once an advertiser handle has been handed out */
+	SubscriberData		*_callbacks;	/**< subscribers with a registered callback */
+	int			_instance;	/**< instance of a multi-instance topic */
+	ORBDevNode		*_next;		/**< next node in the master's list */
+
+	/* statistics, see print_info() */
+	unsigned		_subscriber_count; /**< number of open subscriptions */
+	unsigned		_lost;		/**< publications lost by all subscribers */
+	unsigned		_copy_count;	/**< copies of new data */
+	uint64_t		_latency_sum;	/**< sum of publish to copy latencies */
+	hrt_abstime		_latency_max;	/**< worst publish to copy latency */
+
+	/**
+	 * Find the buffer slot a generation is stored in.
+	 *
+	 * @param generation	The generation count of the publication.
+	 * @return		Pointer into _data.
+	 */
+	uint8_t			*slot(unsigned generation) {
+		return _data + (generation & (_queue_size - 1)) * _meta->o_size;
+	}
+
+	/**
+	 * Copy the oldest publication a subscriber has not seen yet.
+	 *
+	 * @param sd		The subscriber.
+	 * @param qc		Destination buffer and drop counter.
+	 * @return		OK, or -errno on error.
+	 */
+	int			copy_queued(SubscriberData *sd, struct orb_queued_copy *qc);
+
+	/**
+	 * Copy the retained publication made closest to a given time.
+	 *
+	 * @param nc		Destination buffer, time to look up and returned sample time.
+	 * @return		OK, or -errno on error.
+	 */
+	int			copy_nearest(struct orb_nearest_copy *nc);
+
+	/**
+	 * Copy the latest publication for a subscriber and mark it as seen.
+	 *
+	 * @param sd		The subscriber.
+	 * @param buffer	Destination of o_size bytes, or nullptr.
+	 */
+	void			copy_data(SubscriberData *sd, void *buffer);
+
+	/**
+	 * Check whether a lock-free read raced with a publication.
+	 *
+	 * Readers sample _seq before copying and call this afterwards; if a
+	 * publication completed or is still in progress the copy must be retried.
+	 *
+	 * @param seq		The value of _seq sampled before the copy.
+	 * @return		True if the copy is consistent.
+	 */
+	bool			read_consistent(unsigned seq) {
+		orb_barrier();
+		return (_writers == 0) && (_seq == seq);
+	}
+
+#ifdef UORB_STATIC_ALLOCATION
+#ifndef UORB_SUBSCRIBER_POOL_SIZE
+# define UORB_SUBSCRIBER_POOL_SIZE	160
+#endif
+	static SubscriberData	_subscriber_pool[UORB_SUBSCRIBER_POOL_SIZE];	/**< preallocated subscriber records */
+	static SubscriberData	*_subscriber_free;	/**< free list threaded through callback_next */
+	static bool		_subscriber_pool_init;	/**< true once the free list has been built */
+#endif
+	static pid_t		_callback_worker;	/**< the work queue thread that runs the callbacks */
+
+	/**
+	 * Allocate a subscriber record, from the pool if enabled.
+	 *
+	 * @return		The record, or nullptr if out of memory.
+	 */
+	static SubscriberData	*alloc_subscriber();
+
+	/**
+	 * Return a subscriber record obtained from alloc_subscriber.
+	 */
+	static void		free_subscriber(SubscriberData *sd);
 
 	SubscriberData		*filp_to_sd(struct file *filp) {
 		SubscriberData *sd = (SubscriberData *)(filp->f_priv);
@@ -158,15 +373,52 @@ private:
 	 * @return		True if the topic should appear updated to the subscriber
 	 */
 	bool			appears_updated(SubscriberData *sd);
+
+	/**
+	 * Register or remove the work queue callback of a subscriber.
+	 *
+	 * Returns only once a previous callback that the work queue has already
+	 * started is done, so the caller may free sd or the previous argument.
+	 * A callback changing its own registration is the exception, it cannot
+	 * wait for itself.
+	 *
+	 * @param sd		The subscriber.
+	 * @param callback	The callback, or nullptr to remove it.
+	 * @param arg		Argument passed to the callback.
+	 */
+	void			set_callback(SubscriberData *sd, orb_callback_t callback, void *arg);
+
+	/**
+	 * Bridge from the work queue to a subscriber callback.
+	 *
+	 * void *arg		SubscriberData pointer whose callback is run.
+	 */
+	static void		callback_trampoline(void *arg);
 };
 
-ORBDevNode::ORBDevNode(const struct orb_metadata *meta, const char *name, const char *path) :
+ORBDevNode::ORBDevNode(const struct orb_metadata *meta, const char *name, const char *path, int instance) :
 	CDev(name, path),
 	_meta(meta),
 	_data(nullptr),
+	_loan_data(nullptr),
+	_stamps(nullptr),
+	_queue_size(1),
+	_loaned(false),
 	_last_update(0),
 	_generation(0),
-	_publisher(0)
+	_reserved(0),
+	_seq(0),
+	_writers(0),
+	_publisher(0),
+	_advertised(false),
+	_callbacks(nullptr),
+	_instance(instance),
+	_next(nullptr),
+	_subscriber_count(0),
+	_lost(0),
+	_copy_count(0),
+	_latency_sum(0),
+	_latency_max(0)
 {
 	// enable debug() calls
 	_debug_enabled = true;
@@ -175,7 +427,68 @@ ORBDevNode::ORBDevNode(const struct orb_metadata *meta, const char *name, const
 ORBDevNode::~ORBDevNode()
 {
 	if (_data != nullptr)
-		delete[] _data;
+		topic_free(_data);
+
+	if (_loan_data != nullptr)
+		topic_free(_loan_data);
+
+	if (_stamps != nullptr)
+		topic_free((uint8_t *)_stamps);
+}
+
+#ifdef UORB_STATIC_ALLOCATION
+ORBDevNode::SubscriberData ORBDevNode::_subscriber_pool[UORB_SUBSCRIBER_POOL_SIZE];
+ORBDevNode::SubscriberData *ORBDevNode::_subscriber_free;
+bool ORBDevNode::_subscriber_pool_init;
+#endif
+pid_t ORBDevNode::_callback_worker;
+
+ORBDevNode::SubscriberData *
+ORBDevNode::alloc_subscriber()
+{
+#ifdef UORB_STATIC_ALLOCATION
+	SubscriberData *sd = nullptr;
+
+	irqstate_t flags = irqsave();
+
+	if (!_subscriber_pool_init) {
+		for (unsigned i = 0; i < UORB_SUBSCRIBER_POOL_SIZE; i++) {
+			_subscriber_pool[i].callback_next = _subscriber_free;
+			_subscriber_free = &_subscriber_pool[i];
+		}
+
+		_subscriber_pool_init = true;
+	}
+
+	if (_subscriber_free != nullptr) {
+		sd = _subscriber_free;
+		_subscriber_free = sd->callback_next;
+	}
+
+	irqrestore(flags);
+
+	if (sd != nullptr)
+		return sd;
+
+#endif
+	return new SubscriberData;
+}
+
+void
+ORBDevNode::free_subscriber(SubscriberData *sd)
+{
+#ifdef UORB_STATIC_ALLOCATION
+
+	if ((sd >= &_subscriber_pool[0]) && (sd < &_subscriber_pool[UORB_SUBSCRIBER_POOL_SIZE])) {
+		irqstate_t flags = irqsave();
+		sd->callback_next = _subscriber_free;
+		_subscriber_free = sd;
+		irqrestore(flags);
+		return;
+	}
+
+#endif
+	delete sd;
 }
 
 int
@@ -215,13 +528,15 @@ ORBDevNode::open(struct file *filp)
 	if (filp->f_oflags == O_RDONLY) {
 
 		/* allocate subscriber data */
-		SubscriberData *sd = new SubscriberData;
+		SubscriberData *sd = alloc_subscriber();
 
 		if (nullptr == sd)
 			return -ENOMEM;
 
 		memset(sd, 0, sizeof(*sd));
 
+		sd->node = this;
+
 		/* default to no pending update */
 		sd->generation = _generation;
 
@@ -229,8 +544,12 @@ ORBDevNode::open(struct file *filp)
 
 		ret = CDev::open(filp);
 
-		if (ret != OK)
-			free(sd);
+		if (ret != OK) {
+			free_subscriber(sd);
+
+		} else {
+			_subscriber_count++;
+		}
 
 		return ret;
 	}
@@ -251,7 +570,20 @@ ORBDevNode::close(struct file *filp)
 
 		if (sd != nullptr) {
 			hrt_cancel(&sd->update_call);
-			delete sd;
+			set_callback(sd, nullptr, nullptr);
+			_subscriber_count--;
+
+			/*
+			 * Still running only if the callback closes its own
+			 * subscription; the work queue frees sd once it returns.
+			 */
+			irqstate_t flags = irqsave();
+			bool running = sd->callback_running;
+			sd->free_deferred = running;
+			irqrestore(flags);
+
+			if (!running)
+				free_subscriber(sd);
 		}
 	}
 
@@ -271,17 +603,51 @@ ORBDevNode::read(struct file *filp, char *buffer, size_t buflen)
 	if (buflen != _meta->o_size)
 		return -EIO;
 
+	copy_data(sd, buffer);
+
+	return _meta->o_size;
+}
+
+void
+ORBDevNode::copy_data(SubscriberData *sd, void *buffer)
+{
+	unsigned seq, generation;
+
 	/*
-	 * Perform an atomic copy & state update
+	 * Copy without blocking interrupts; if a publication happened while
+	 * we were copying, the data may be torn and we go again.  Publishers
+	 * in thread context hold the scheduler lock while copying, so this
+	 * only retries when interrupted by an interrupt-context publisher.
 	 */
+	do {
+		seq = _seq;
+		orb_barrier();
+		generation = _generation;
+
+		/* if the caller doesn't want the data, don't give it to them */
+		if (nullptr != buffer)
+			memcpy(buffer, slot(generation - 1), _meta->o_size);
+
+	} while (!read_consistent(seq));
+
 	irqstate_t flags = irqsave();
 
-	/* if the caller doesn't want the data, don't give it to them */
-	if (nullptr != buffer)
-		memcpy(buffer, _data, _meta->o_size);
+	/* account for publications the subscriber skipped and for how stale this one is */
+	if (sd->generation != generation) {
+		unsigned skipped = generation - sd->generation - 1;
+		sd->lost += skipped;
+		_lost += skipped;
+
+		hrt_abstime latency = hrt_absolute_time() - _last_update;
+		_copy_count++;
+		_latency_sum += latency;
+
+		if (latency > _latency_max)
+			_latency_max = latency;
+	}
 
 	/* track the last generation that the file has seen */
-	sd->generation = _generation;
+	sd->generation = generation;
 
 	/*
 	 * Clear the flag that indicates that an update has been reported, as
@@ -290,8 +656,37 @@ ORBDevNode::read(struct file *filp, char *buffer, size_t buflen)
 	sd->update_reported = false;
 
 	irqrestore(flags);
+}
 
-	return _meta->o_size;
+uint32_t
+ORBDevNode::copy_batch(struct orb_batch_entry *entries, unsigned count)
+{
+	uint32_t updated = 0;
+
+	for (unsigned i = 0; (i < count) && (i < 32); i++) {
+		struct orb_batch_entry *e = &entries[i];
+
+		/* resolve the subscription once, through the file layer */
+		if (e->reader == 0) {
+			if (OK != ::ioctl(e->handle, ORBIOCGREADER, (unsigned long)(uintptr_t)&e->reader)) {
+				e->reader = 0;
+				continue;
+			}
+		}
+
+		SubscriberData *sd = (SubscriberData *)e->reader;
+		ORBDevNode *devnode = sd->node;
+
+		if ((devnode->_meta != e->meta) || (devnode->_data == nullptr))
+			continue;
+
+		if (devnode->appears_updated(sd)) {
+			devnode->copy_data(sd, e->buffer);
+			updated |= (1U << i);
+		}
+	}
+
+	return updated;
 }
 
 ssize_t
@@ -312,8 +707,13 @@ ORBDevNode::write(struct file *filp, const char *buffer, size_t buflen)
 			lock();
 
 			/* re-check size */
-			if (nullptr == _data)
-				_data = new uint8_t[_meta->o_size];
+			if (nullptr == _data) {
+				/* queued topics also remember when each slot was published */
+				if (_queue_size > 1)
+					_stamps = (hrt_abstime *)topic_alloc(sizeof(hrt_abstime) * _queue_size);
+
+				_data = topic_alloc(_meta->o_size * _queue_size);
+			}
 
 			unlock();
 		}
@@ -327,14 +727,47 @@ ORBDevNode::write(struct file *filp, const char *buffer, size_t buflen)
 	if (_meta->o_size != buflen)
 		return -EIO;
 
-	/* Perform an atomic copy. */
+	/*
+	 * Keep other threads from publishing while we copy, but leave
+	 * interrupts enabled; readers detect the publication via _seq.
+	 */
+	bool in_isr = up_interrupt_context();
+
+	if (!in_isr)
+		sched_lock();
+
+	/* reserve the slot we are going to write */
 	irqstate_t flags = irqsave();
-	memcpy(_data, buffer, _meta->o_size);
+	unsigned generation = _reserved++;
+	_writers++;
+	irqrestore(flags);
+
+	memcpy(slot(generation), buffer, _meta->o_size);
+	orb_barrier();
+
+	flags = irqsave();
+
+	/*
+	 * An interrupt-context publisher used the same slot while we were
+	 * copying, so it may be torn; copy again with interrupts disabled.
+	 */
+	if ((_reserved != generation + 1) && (slot(generation) == slot(_reserved - 1)))
+		memcpy(slot(generation), buffer, _meta->o_size);
+
+	if (_stamps != nullptr)
+		_stamps[generation & (_queue_size - 1)] = hrt_absolute_time();
+
+	/* the last publisher out makes all reserved slots visible */
+	if (--_writers == 0) {
+		_last_update = hrt_absolute_time();
+		_generation = _reserved;
+	}
+
+	_seq++;
 	irqrestore(flags);
 
-	/* update the timestamp and generation count */
-	_last_update = hrt_absolute_time();
-	_generation++;
+	if (!in_isr)
+		sched_unlock();
 
 	/* notify any poll waiters */
 	poll_notify(POLLIN);
@@ -361,9 +794,80 @@ ORBDevNode::ioctl(struct file *filp, int cmd, unsigned long arg)
 		return OK;
 
 	case ORBIOCGADVERTISER:
+		_advertised = true;
 		*(uintptr_t *)arg = (uintptr_t)this;
 		return OK;
 
+	case ORBIOCCLAIM: {
+			int ret = OK;
+
+			lock();
+
+			if (_advertised) {
+				ret = -EBUSY;
+
+			} else {
+				_advertised = true;
+			}
+
+			unlock();
+
+			return ret;
+		}
+
+	case ORBIOCGREADER:
+		if (sd == nullptr)
+			return -EINVAL;
+
+		*(uintptr_t *)arg = (uintptr_t)sd;
+		return OK;
+
+	case ORBIOCSETQUEUESIZE: {
+			unsigned queue_size = 1;
+
+			if ((arg < 1) || (arg > ORB_MAX_QUEUE_SIZE))
+				return -EINVAL;
+
+			/* round up to a power of two so the slot index survives generation wrap */
+			while (queue_size < arg)
+				queue_size <<= 1;
+
+			int ret = OK;
+
+			lock();
+
+			/* the depth cannot change once the buffer exists */
+			if (_data == nullptr) {
+				_queue_size = queue_size;
+
+			} else if (_queue_size != queue_size) {
+				ret = -EBUSY;
+			}
+
+			unlock();
+
+			return ret;
+		}
+
+	case ORBIOCSETCALLBACK: {
+			const struct orb_callback_reg *reg = (const struct orb_callback_reg *)arg;
+
+			if (sd == nullptr)
+				return -EINVAL;
+
+			set_callback(sd, reg->callback, reg->arg);
+			return OK;
+		}
+
+	case ORBIOCCOPYQUEUED:
+		if (sd == nullptr)
+			return -EINVAL;
+
+		return copy_queued(sd, (struct orb_queued_copy *)arg);
+
+	case ORBIOCCOPYNEAREST:
+		return copy_nearest((struct orb_nearest_copy *)arg);
+
 	default:
 		/* give it to the superclass */
 		return CDev::ioctl(filp, cmd, arg);
@@ -396,58 +900,397 @@ ORBDevNode::publish(const orb_metadata *meta, orb_advert_t handle, const void *d
 	return OK;
 }
 
-pollevent_t
-ORBDevNode::poll_state(struct file *filp)
+int
+ORBDevNode::copy_queued(SubscriberData *sd, struct orb_queued_copy *qc)
 {
-	SubscriberData *sd = filp_to_sd(filp);
+	unsigned seq, generation, next;
 
-	/*
-	 * If the topic appears updated to the subscriber, say so.
-	 */
-	if (appears_updated(sd))
-		return POLLIN;
+	/* if the object has not been written yet, there is nothing to copy */
+	if (_data == nullptr)
+		return -EAGAIN;
 
-	return 0;
-}
+	do {
+		seq = _seq;
+		orb_barrier();
+		generation = _generation;
+		qc->dropped = 0;
+
+		/* nothing new, behave like read() and hand out the latest */
+		next = (sd->generation == generation) ? (generation - 1) : sd->generation;
+
+		/* publications older than the queue depth have been overwritten */
+		if ((generation - next) > _queue_size) {
+			qc->dropped = (generation - next) - _queue_size;
+			next = generation - _queue_size;
+		}
 
-void
-ORBDevNode::poll_notify_one(struct pollfd *fds, pollevent_t events)
-{
-	SubscriberData *sd = filp_to_sd((struct file *)fds->priv);
+		if (nullptr != qc->buffer)
+			memcpy(qc->buffer, slot(next), _meta->o_size);
 
-	/*
-	 * If the topic looks updated to the subscriber, go ahead and notify them.
-	 */
-	if (appears_updated(sd))
-		CDev::poll_notify_one(fds, events);
+	} while (!read_consistent(seq));
+
+	irqstate_t flags = irqsave();
+	sd->generation = next + 1;
+	sd->update_reported = false;
+	irqrestore(flags);
+
+	return OK;
 }
 
-bool
-ORBDevNode::appears_updated(SubscriberData *sd)
+int
+ORBDevNode::copy_nearest(struct orb_nearest_copy *nc)
 {
-	/* assume it doesn't look updated */
-	bool ret = false;
+	unsigned seq, generation, best;
 
-	/* avoid racing between interrupt and non-interrupt context calls */
-	irqstate_t state = irqsave();
+	/* if the object has not been written yet, there is nothing to copy */
+	if ((_data == nullptr) || (_generation == 0))
+		return -EAGAIN;
 
-	/* check if this topic has been published yet, if not bail out */
-	if (_data == nullptr) {
-		ret = false;
-		goto out;
-	}
+	do {
+		seq = _seq;
+		orb_barrier();
+		generation = _generation;
+		best = generation - 1;
 
-	/*
-	 * If the subscriber's generation count matches the update generation
-	 * count, there has been no update from their perspective; if they
-	 * don't match then we might have a visible update.
-	 */
-	while (sd->generation != _generation) {
+		if (_stamps != nullptr) {
+			unsigned retained = (generation < _queue_size) ? generation : _queue_size;
+			hrt_abstime best_diff = ~(hrt_abstime)0;
 
-		/*
-		 * Handle non-rate-limited subscribers.
-		 */
-		if (sd->update_interval == 0) {
+			/* newest to oldest; stamps only increase, so stop once we move away */
+			for (unsigned i = 1; i <= retained; i++) {
+				hrt_abstime stamp = _stamps[(generation - i) & (_queue_size - 1)];
+				hrt_abstime diff = (stamp > nc->time) ? (stamp - nc->time) : (nc->time - stamp);
+
+				if (diff > best_diff)
+					break;
+
+				best_diff = diff;
+				best = generation - i;
+			}
+
+			nc->sample_time = _stamps[best & (_queue_size - 1)];
+
+		} else {
+			nc->sample_time = _last_update;
+		}
+
+		memcpy(nc->buffer, slot(best), _meta->o_size);
+
+	} while (!read_consistent(seq));
+
+	return OK;
+}
+
+void *
+ORBDevNode::loan(const orb_metadata *meta, orb_advert_t handle)
+{
+	ORBDevNode *devnode = (ORBDevNode *)handle;
+
+	if (devnode->_meta != meta) {
+		errno = EINVAL;
+		return nullptr;
+	}
+
+	/* the spare buffer is allocated on first use, like _data in write() */
+	if (nullptr == devnode->_loan_data) {
+		if (!up_interrupt_context()) {
+
+			devnode->lock();
+
+			if (nullptr == devnode->_loan_data)
+				devnode->_loan_data = topic_alloc(meta->o_size);
+
+			devnode->unlock();
+		}
+
+		if (nullptr == devnode->_loan_data) {
+			errno = ENOMEM;
+			return nullptr;
+		}
+	}
+
+	irqstate_t flags = irqsave();
+
+	if (devnode->_loaned) {
+		irqrestore(flags);
+		errno = EBUSY;
+		return nullptr;
+	}
+
+	devnode->_loaned = true;
+	irqrestore(flags);
+
+	return devnode->_loan_data;
+}
+
+int
+ORBDevNode::commit(const orb_metadata *meta, orb_advert_t handle)
+{
+	ORBDevNode *devnode = (ORBDevNode *)handle;
+
+	if (devnode->_meta != meta) {
+		errno = EINVAL;
+		return ERROR;
+	}
+
+	irqstate_t flags = irqsave();
+
+	if (!devnode->_loaned) {
+		irqrestore(flags);
+		errno = EINVAL;
+		return ERROR;
+	}
+
+	/*
+	 * Swap the loaned buffer in as the current data; the previous
+	 * buffer becomes the spare for the next loan.
+	 */
+	if ((devnode->_queue_size == 1) && (devnode->_writers == 0) && (devnode->_data != nullptr)) {
+		uint8_t *published = devnode->_loan_data;
+		devnode->_loan_data = devnode->_data;
+		devnode->_data = published;
+		devnode->_loaned = false;
+
+		devnode->_last_update = hrt_absolute_time();
+		devnode->_generation = ++devnode->_reserved;
+		devnode->_seq++;
+
+		irqrestore(flags);
+
+		/* notify any poll waiters */
+		devnode->poll_notify(POLLIN);
+
+		return OK;
+	}
+
+	irqrestore(flags);
+
+	/*
+	 * Queued topics, or a publication in progress on the buffer we would
+	 * swap out: publish the loaned buffer by copying it instead.
+	 */
+	ssize_t ret = devnode->write(nullptr, (const char *)devnode->_loan_data, meta->o_size);
+	devnode->_loaned = false;
+
+	if (ret < 0) {
+		errno = -ret;
+		return ERROR;
+	}
+
+	return OK;
+}
+
+int
+ORBDevNode::peek(const orb_metadata *meta, orb_reader_t reader, const void **data, unsigned *generation)
+{
+	SubscriberData *sd = (SubscriberData *)reader;
+	ORBDevNode *devnode = sd->node;
+
+	if (devnode->_meta != meta) {
+		errno = EINVAL;
+		return ERROR;
+	}
+
+	/* nothing to look at until the first publication */
+	if (devnode->_data == nullptr) {
+		errno = EAGAIN;
+		return ERROR;
+	}
+
+	irqstate_t flags = irqsave();
+
+	/* the sequence count identifies the data, see peek_valid() */
+	*generation = devnode->_seq;
+	*data = devnode->slot(devnode->_generation - 1);
+
+	/* same subscriber bookkeeping as read() */
+	sd->generation = devnode->_generation;
+	sd->update_reported = false;
+
+	irqrestore(flags);
+
+	return OK;
+}
+
+bool
+ORBDevNode::peek_valid(orb_reader_t reader, unsigned generation)
+{
+	SubscriberData *sd = (SubscriberData *)reader;
+
+	return sd->node->read_consistent(generation);
+}
+
+void
+ORBDevNode::print_info(unsigned last_generation, hrt_abstime interval)
+{
+	char name[ORB_MAXNAME + 4];
+
+	if (_instance == 0) {
+		snprintf(name, sizeof(name), "%s", _meta->o_name);
+
+	} else {
+		snprintf(name, sizeof(name), "%s%d", _meta->o_name, _instance);
+	}
+
+	unsigned published = _generation - last_generation;
+	unsigned avg_latency = (_copy_count > 0) ? (unsigned)(_latency_sum / _copy_count) : 0;
+
+	if (interval > 0) {
+		printf("%-32s %5u %2u %4u %7.1f %8u %8u %8u\n", name, (unsigned)_meta->o_size, _queue_size,
+		       _subscriber_count, (double)(published * 1e6f / interval), _lost, avg_latency,
+		       (unsigned)_latency_max);
+
+	} else {
+		printf("%-32s %5u %2u %4u %7u %8u %8u %8u\n", name, (unsigned)_meta->o_size, _queue_size,
+		       _subscriber_count, published, _lost, avg_latency, (unsigned)_latency_max);
+	}
+}
+
+pollevent_t
+ORBDevNode::poll_state(struct file *filp)
+{
+	SubscriberData *sd = filp_to_sd(filp);
+
+	/*
+	 * If the topic appears updated to the subscriber, say so.
+	 */
+	if (appears_updated(sd))
+		return POLLIN;
+
+	return 0;
+}
+
+void
+ORBDevNode::poll_notify(pollevent_t events)
+{
+	/* wake poll() waiters first */
+	CDev::poll_notify(events);
+
+	/*
+	 * Then schedule callbacks for subscribers that see the update; this
+	 * goes through appears_updated() so update intervals are honoured.
+	 */
+	irqstate_t flags = irqsave();
+
+	for (SubscriberData *sd = _callbacks; sd != nullptr; sd = sd->callback_next) {
+		if (!sd->callback_pending && appears_updated(sd)) {
+			sd->callback_pending = true;
+			work_queue(HPWORK, &sd->callback_work, &ORBDevNode::callback_trampoline, sd, 0);
+		}
+	}
+
+	irqrestore(flags);
+}
+
+void
+ORBDevNode::set_callback(SubscriberData *sd, orb_callback_t callback, void *arg)
+{
+	irqstate_t flags = irqsave();
+
+	/* unlink a previous registration */
+	for (SubscriberData **p = &_callbacks; *p != nullptr; p = &(*p)->callback_next) {
+		if (*p == sd) {
+			*p = sd->callback_next;
+			break;
+		}
+	}
+
+	/* a queued callback that has not been taken by the work queue never runs */
+	if (sd->callback_pending && sd->callback_work.worker != nullptr) {
+		work_cancel(HPWORK, &sd->callback_work);
+		sd->callback_pending = false;
+	}
+
+	/*
+	 * Otherwise the work queue has taken it and is about to run it, or is
+	 * running it; wait until it returns. sd is unlinked, so it is not
+	 * queued again meanwhile.
+	 */
+	while ((sd->callback_pending || sd->callback_running) && getpid() != _callback_worker) {
+		irqrestore(flags);
+		usleep(1000);
+		flags = irqsave();
+	}
+
+	sd->callback = callback;
+	sd->callback_arg = arg;
+	sd->callback_next = nullptr;
+
+	if (callback != nullptr) {
+		sd->callback_next = _callbacks;
+		_callbacks = sd;
+	}
+
+	irqrestore(flags);
+}
+
+void
+ORBDevNode::callback_trampoline(void *arg)
+{
+	SubscriberData *sd = (SubscriberData *)arg;
+
+	/* allow the next publication to queue us again while we run */
+	irqstate_t flags = irqsave();
+	_callback_worker = getpid();
+	orb_callback_t callback = sd->callback;
+	void *callback_arg = sd->callback_arg;
+	sd->callback_pending = false;
+	sd->callback_running = (callback != nullptr);
+	irqrestore(flags);
+
+	if (callback == nullptr)
+		return;
+
+	callback(callback_arg);
+
+	/* sd must not be touched after a deferred free */
+	flags = irqsave();
+	sd->callback_running = false;
+	bool deferred = sd->free_deferred;
+	irqrestore(flags);
+
+	if (deferred)
+		free_subscriber(sd);
+}
+
+void
+ORBDevNode::poll_notify_one(struct pollfd *fds, pollevent_t events)
+{
+	SubscriberData *sd = filp_to_sd((struct file *)fds->priv);
+
+	/*
+	 * If the topic looks updated to the subscriber, go ahead and notify them.
+	 */
+	if (appears_updated(sd))
+		CDev::poll_notify_one(fds, events);
+}
+
+bool
+ORBDevNode::appears_updated(SubscriberData *sd)
+{
+	/* assume it doesn't look updated */
+	bool ret = false;
+
+	/* avoid racing between interrupt and non-interrupt context calls */
+	irqstate_t state = irqsave();
+
+	/* check if this topic has been published yet, if not bail out */
+	if (_data == nullptr) {
+		ret = false;
+		goto out;
+	}
+
+	/*
+	 * If the subscriber's generation count matches the update generation
+	 * count, there has been no update from their perspective; if they
+	 * don't match then we might have a visible update.
+	 */
+	while (sd->generation != _generation) {
+
+		/*
+		 * Handle non-rate-limited subscribers.
+		 */
+		if (sd->update_interval == 0) {
 			ret = true;
 			break;
 		}
@@ -531,14 +1374,21 @@ public:
 	~ORBDevMaster();
 
 	virtual int		ioctl(struct file *filp, int cmd, unsigned long arg);
+
+	/**
+	 * First node of the list of all nodes created by the master.
+	 */
+	ORBDevNode		*nodes() { return _nodes; }
 private:
 	Flavor			_flavor;
+	ORBDevNode		*_nodes;	/**< all nodes, most recently created first */
 };
 
 ORBDevMaster::ORBDevMaster(Flavor f) :
 	CDev((f == PUBSUB) ? "obj_master" : "param_master",
 	     (f == PUBSUB) ? TOPIC_MASTER_DEVICE_PATH : PARAM_MASTER_DEVICE_PATH),
-	_flavor(f)
+	_flavor(f),
+	_nodes(nullptr)
 {
 	// enable debug() calls
 	_debug_enabled = true;
@@ -556,13 +1406,14 @@ ORBDevMaster::ioctl(struct file *filp, int cmd, unsigned long arg)
 
 	switch (cmd) {
 	case ORBIOCADVERTISE: {
-			const struct orb_metadata *meta = (const struct orb_metadata *)arg;
+			const struct orb_advertdata *adv = (const struct orb_advertdata *)arg;
+			const struct orb_metadata *meta = adv->meta;
 			const char *objname;
 			char nodepath[orb_maxpath];
 			ORBDevNode *node;
 
 			/* construct a path to the node - this also checks the node name */
-			ret = node_mkpath(nodepath, _flavor, meta);
+			ret = node_mkpath(nodepath, _flavor, meta, adv->instance);
 
 			if (ret != OK)
 				return ret;
@@ -574,7 +1425,7 @@ ORBDevMaster::ioctl(struct file *filp, int cmd, unsigned long arg)
 				return -ENOMEM;
 
 			/* construct the new node */
-			node = new ORBDevNode(meta, objname, nodepath);
+			node = new ORBDevNode(meta, objname, nodepath, adv->instance);
 
 			/* initialise the node - this may fail if e.g. a node with this name already exists */
 			if (node != nullptr)
@@ -588,117 +1439,411 @@ ORBDevMaster::ioctl(struct file *filp, int cmd, unsigned long arg)
 			if (ret != OK) {
 				delete node;
 				free((void *)objname);
+
+			} else {
+				/* remember it for the status commands */
+				lock();
+				node->set_next(_nodes);
+				_nodes = node;
+				unlock();
 			}
 
-			return ret;
-		}
+			return ret;
+		}
+
+	default:
+		/* give it to the superclass */
+		return CDev::ioctl(filp, cmd, arg);
+	}
+}
+
+
+/**
+ * Local functions in support of the shell command.
+ */
+
+namespace
+{
+
+ORBDevMaster	*g_dev;
+
+struct orb_test {
+	int val;
+};
+
+ORB_DEFINE(orb_test, struct orb_test);
+ORB_DEFINE(orb_test_queue, struct orb_test);
+ORB_DEFINE(orb_test_multi, struct orb_test);
+
+int
+test_fail(const char *fmt, ...)
+{
+	va_list ap;
+
+	fprintf(stderr, "FAIL: ");
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fprintf(stderr, "\n");
+	fflush(stderr);
+	return ERROR;
+}
+
+int
+test_note(const char *fmt, ...)
+{
+	va_list ap;
+
+	fprintf(stderr, "note: ");
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fprintf(stderr, "\n");
+	fflush(stderr);
+	return OK;
+}
+
+ORB_DECLARE(sensor_combined);
+
+volatile int test_callback_count;
+
+void
+test_callback(void *arg)
+{
+	(*(volatile int *)arg)++;
+}
+
+void
+test_slow_callback(void *arg)
+{
+	usleep(20000);
+	(*(volatile int *)arg)++;
+}
+
+int
+test()
+{
+	struct orb_test t, u;
+	int pfd, sfd;
+	bool updated;
+
+	t.val = 0;
+	pfd = orb_advertise(ORB_ID(orb_test), &t);
+
+	if (pfd < 0)
+		return test_fail("advertise failed: %d", errno);
+
+	test_note("publish handle 0x%08x", pfd);
+	sfd = orb_subscribe(ORB_ID(orb_test));
+
+	if (sfd < 0)
+		return test_fail("subscribe failed: %d", errno);
+
+	test_note("subscribe fd %d", sfd);
+	u.val = 1;
+
+	if (OK != orb_copy(ORB_ID(orb_test), sfd, &u))
+		return test_fail("copy(1) failed: %d", errno);
+
+	if (u.val != t.val)
+		return test_fail("copy(1) mismatch: %d expected %d", u.val, t.val);
+
+	if (OK != orb_check(sfd, &updated))
+		return test_fail("check(1) failed");
+
+	if (updated)
+		return test_fail("spurious updated flag");
+
+	t.val = 2;
+	test_note("try publish");
+
+	if (OK != orb_publish(ORB_ID(orb_test), pfd, &t))
+		return test_fail("publish failed");
+
+	if (OK != orb_check(sfd, &updated))
+		return test_fail("check(2) failed");
+
+	if (!updated)
+		return test_fail("missing updated flag");
+
+	if (OK != orb_copy(ORB_ID(orb_test), sfd, &u))
+		return test_fail("copy(2) failed: %d", errno);
+
+	if (u.val != t.val)
+		return test_fail("copy(2) mismatch: %d expected %d", u.val, t.val);
+
+	orb_reader_t reader = orb_reader(ORB_ID(orb_test), sfd);
+
+	if (reader == ERROR)
+		return test_fail("reader failed: %d", errno);
+
+	struct orb_test *l = (struct orb_test *)orb_loan(ORB_ID(orb_test), pfd);
+
+	if (l == nullptr)
+		return test_fail("loan failed: %d", errno);
+
+	l->val = 3;
+
+	if (OK != orb_commit(ORB_ID(orb_test), pfd))
+		return test_fail("commit failed: %d", errno);
+
+	if (OK != orb_check(sfd, &updated))
+		return test_fail("check(3) failed");
+
+	if (!updated)
+		return test_fail("missing updated flag after commit");
+
+	const struct orb_test *p;
+	unsigned generation;
+
+	if (OK != orb_peek(ORB_ID(orb_test), reader, (const void **)&p, &generation))
+		return test_fail("peek failed: %d", errno);
+
+	if (p->val != 3)
+		return test_fail("peek mismatch: %d expected %d", p->val, 3);
+
+	if (!orb_peek_valid(reader, generation))
+		return test_fail("peek invalidated without publish");
+
+	if (OK != orb_check(sfd, &updated))
+		return test_fail("check(4) failed");
+
+	if (updated)
+		return test_fail("spurious updated flag after peek");
+
+	t.val = 4;
+
+	if (OK != orb_publish(ORB_ID(orb_test), pfd, &t))
+		return test_fail("publish(2) failed");
+
+	if (orb_peek_valid(reader, generation))
+		return test_fail("stale peek still valid");
+
+	if (OK != orb_copy(ORB_ID(orb_test), sfd, &u))
+		return test_fail("copy(3) failed: %d", errno);
+
+	if (u.val != t.val)
+		return test_fail("copy(3) mismatch: %d expected %d", u.val, t.val);
+
+	orb_unsubscribe(sfd);
+	close(pfd);
+
+	/* queued topic: drain in order, detect overruns */
+	t.val = 0;
+	pfd = orb_advertise_queue(ORB_ID(orb_test_queue), &t, 4);
+
+	if (pfd < 0)
+		return test_fail("advertise(queue) failed: %d", errno);
+
+	sfd = orb_subscribe(ORB_ID(orb_test_queue));
+
+	if (sfd < 0)
+		return test_fail("subscribe(queue) failed: %d", errno);
+
+	for (int i = 1; i <= 3; i++) {
+		t.val = i;
+
+		if (OK != orb_publish(ORB_ID(orb_test_queue), pfd, &t))
+			return test_fail("publish(queue) failed");
+	}
+
+	unsigned dropped;
+
+	for (int i = 1; i <= 3; i++) {
+		if (OK != orb_copy_queued(ORB_ID(orb_test_queue), sfd, &u, &dropped))
+			return test_fail("copy(queue) failed: %d", errno);
+
+		if ((u.val != i) || (dropped != 0))
+			return test_fail("copy(queue) mismatch: %d expected %d, dropped %u", u.val, i, dropped);
+	}
+
+	if (OK != orb_check(sfd, &updated))
+		return test_fail("check(queue) failed");
+
+	if (updated)
+		return test_fail("spurious updated flag on drained queue");
+
+	for (int i = 4; i <= 9; i++) {
+		t.val = i;
+
+		if (OK != orb_publish(ORB_ID(orb_test_queue), pfd, &t))
+			return test_fail("publish(queue) failed");
+	}
+
+	if (OK != orb_copy_queued(ORB_ID(orb_test_queue), sfd, &u, &dropped))
+		return test_fail("copy(queue) failed: %d", errno);
+
+	if ((u.val != 6) || (dropped != 2))
+		return test_fail("overrun mismatch: %d expected 6, dropped %u expected 2", u.val, dropped);
+
+	if (OK != orb_copy(ORB_ID(orb_test_queue), sfd, &u))
+		return test_fail("copy(queue latest) failed: %d", errno);
+
+	if (u.val != 9)
+		return test_fail("copy(queue latest) mismatch: %d expected 9", u.val);
+
+	/* queued topic as a history: look publications up by time */
+	hrt_abstime stamps[3];
+
+	for (int i = 0; i < 3; i++) {
+		usleep(2000);
+		t.val = 10 + i;
+
+		if (OK != orb_publish(ORB_ID(orb_test_queue), pfd, &t))
+			return test_fail("publish(queue) failed");
+
+		stamps[i] = hrt_absolute_time();
+	}
+
+	for (int i = 0; i < 3; i++) {
+		hrt_abstime sample_time;
+
+		if (OK != orb_copy_nearest(ORB_ID(orb_test_queue), sfd, stamps[i], &u, &sample_time))
+			return test_fail("copy(nearest) failed: %d", errno);
+
+		if ((u.val != 10 + i) || (sample_time > stamps[i]))
+			return test_fail("copy(nearest) mismatch: %d expected %d", u.val, 10 + i);
+	}
+
+	orb_unsubscribe(sfd);
+	close(pfd);
+
+	/* multi-instance topic: each advertiser gets its own node */
+	int instance0, instance1;
+	t.val = 10;
+	orb_advert_t pfd0 = orb_advertise_multi(ORB_ID(orb_test_multi), &t, &instance0);
+
+	t.val = 11;
+	orb_advert_t pfd1 = orb_advertise_multi(ORB_ID(orb_test_multi), &t, &instance1);
+
+	if ((pfd0 < 0) || (pfd1 < 0))
+		return test_fail("advertise(multi) failed: %d", errno);
+
+	if (instance1 != instance0 + 1)
+		return test_fail("advertise(multi) instances %d %d not consecutive", instance0, instance1);
+
+	int sfd0 = orb_subscribe_multi(ORB_ID(orb_test_multi), instance0);
+	int sfd1 = orb_subscribe_multi(ORB_ID(orb_test_multi), instance1);
+
+	if ((sfd0 < 0) || (sfd1 < 0))
+		return test_fail("subscribe(multi) failed: %d", errno);
+
+	if (OK != orb_copy(ORB_ID(orb_test_multi), sfd0, &u) || (u.val != 10))
+		return test_fail("copy(multi 0) mismatch: %d expected 10", u.val);
+
+	if (OK != orb_copy(ORB_ID(orb_test_multi), sfd1, &u) || (u.val != 11))
+		return test_fail("copy(multi 1) mismatch: %d expected 11", u.val);
+
+	orb_unsubscribe(sfd0);
+	orb_unsubscribe(sfd1);
+
+	/* queued multi-instance topic */
+	int instance2;
+	t.val = 0;
+	orb_advert_t pfd2 = orb_advertise_multi_queue(ORB_ID(orb_test_multi), &t, &instance2, 4);
+
+	if ((pfd2 < 0) || (instance2 != instance1 + 1))
+		return test_fail("advertise(multi queue) failed: %d", errno);
 
-	default:
-		/* give it to the superclass */
-		return CDev::ioctl(filp, cmd, arg);
+	sfd = orb_subscribe_multi(ORB_ID(orb_test_multi), instance2);
+
+	if (sfd < 0)
+		return test_fail("subscribe(multi queue) failed: %d", errno);
+
+	for (int i = 1; i <= 3; i++) {
+		t.val = i;
+
+		if (OK != orb_publish(ORB_ID(orb_test_multi), pfd2, &t))
+			return test_fail("publish(multi queue) failed");
 	}
-}
 
+	for (int i = 1; i <= 3; i++) {
+		if (OK != orb_copy_queued(ORB_ID(orb_test_multi), sfd, &u, &dropped) || (u.val != i))
+			return test_fail("copy(multi queue) mismatch: %d expected %d", u.val, i);
+	}
 
-/**
- * Local functions in support of the shell command.
- */
+	orb_unsubscribe(sfd);
+	close(pfd2);
 
-namespace
-{
+	/* batch check and copy */
+	struct orb_test w;
+	struct orb_batch_entry batch[2];
+	int sfd_a = orb_subscribe(ORB_ID(orb_test));
+	int sfd_b = orb_subscribe(ORB_ID(orb_test_multi));
 
-ORBDevMaster	*g_dev;
+	orb_batch_init(&batch[0], ORB_ID(orb_test), sfd_a, &u);
+	orb_batch_init(&batch[1], ORB_ID(orb_test_multi), sfd_b, &w);
 
-struct orb_test {
-	int val;
-};
+	/* both have data from earlier publications */
+	if (orb_copy_batch(batch, 2) != 0x3)
+		return test_fail("batch(1) did not report both topics");
 
-ORB_DEFINE(orb_test, struct orb_test);
+	if (orb_copy_batch(batch, 2) != 0)
+		return test_fail("batch(2) spurious update");
 
-int
-test_fail(const char *fmt, ...)
-{
-	va_list ap;
+	t.val = 12;
 
-	fprintf(stderr, "FAIL: ");
-	va_start(ap, fmt);
-	vfprintf(stderr, fmt, ap);
-	va_end(ap);
-	fprintf(stderr, "\n");
-	fflush(stderr);
-	return ERROR;
-}
+	if (OK != orb_publish(ORB_ID(orb_test_multi), pfd0, &t))
+		return test_fail("publish(batch) failed");
 
-int
-test_note(const char *fmt, ...)
-{
-	va_list ap;
+	if ((orb_copy_batch(batch, 2) != 0x2) || (w.val != 12))
+		return test_fail("batch(3) mismatch: %d expected 12", w.val);
 
-	fprintf(stderr, "note: ");
-	va_start(ap, fmt);
-	vfprintf(stderr, fmt, ap);
-	va_end(ap);
-	fprintf(stderr, "\n");
-	fflush(stderr);
-	return OK;
-}
+	orb_unsubscribe(sfd_a);
+	orb_unsubscribe(sfd_b);
 
-ORB_DECLARE(sensor_combined);
+	/* work queue callback */
+	sfd = orb_subscribe(ORB_ID(orb_test));
 
-int
-test()
-{
-	struct orb_test t, u;
-	int pfd, sfd;
-	bool updated;
+	if (sfd < 0)
+		return test_fail("subscribe(callback) failed: %d", errno);
 
-	t.val = 0;
 	pfd = orb_advertise(ORB_ID(orb_test), &t);
 
 	if (pfd < 0)
-		return test_fail("advertise failed: %d", errno);
+		return test_fail("advertise(callback) failed: %d", errno);
 
-	test_note("publish handle 0x%08x", pfd);
-	sfd = orb_subscribe(ORB_ID(orb_test));
+	orb_copy(ORB_ID(orb_test), sfd, &u);
+	test_callback_count = 0;
 
-	if (sfd < 0)
-		return test_fail("subscribe failed: %d", errno);
+	if (OK != orb_register_callback(sfd, test_callback, (void *)&test_callback_count))
+		return test_fail("register callback failed: %d", errno);
 
-	test_note("subscribe fd %d", sfd);
-	u.val = 1;
+	t.val = 5;
 
-	if (OK != orb_copy(ORB_ID(orb_test), sfd, &u))
-		return test_fail("copy(1) failed: %d", errno);
+	if (OK != orb_publish(ORB_ID(orb_test), pfd, &t))
+		return test_fail("publish(callback) failed");
 
-	if (u.val != t.val)
-		return test_fail("copy(1) mismatch: %d expected %d", u.val, t.val);
+	usleep(20000);
 
-	if (OK != orb_check(sfd, &updated))
-		return test_fail("check(1) failed");
+	if (test_callback_count != 1)
+		return test_fail("callback ran %d times, expected 1", test_callback_count);
 
-	if (updated)
-		return test_fail("spurious updated flag");
+	if (OK != orb_copy(ORB_ID(orb_test), sfd, &u) || (u.val != t.val))
+		return test_fail("copy(callback) mismatch: %d expected %d", u.val, t.val);
 
-	t.val = 2;
-	test_note("try publish");
+	orb_unregister_callback(sfd);
 
 	if (OK != orb_publish(ORB_ID(orb_test), pfd, &t))
-		return test_fail("publish failed");
+		return test_fail("publish(callback) failed");
 
-	if (OK != orb_check(sfd, &updated))
-		return test_fail("check(2) failed");
+	usleep(20000);
 
-	if (!updated)
-		return test_fail("missing updated flag");
+	if (test_callback_count != 1)
+		return test_fail("callback ran after unregister");
 
-	if (OK != orb_copy(ORB_ID(orb_test), sfd, &u))
-		return test_fail("copy(2) failed: %d", errno);
+	/* unsubscribe waits for a callback that is running */
+	if (OK != orb_register_callback(sfd, test_slow_callback, (void *)&test_callback_count))
+		return test_fail("register callback failed: %d", errno);
 
-	if (u.val != t.val)
-		return test_fail("copy(2) mismatch: %d expected %d", u.val, t.val);
+	if (OK != orb_publish(ORB_ID(orb_test), pfd, &t))
+		return test_fail("publish(callback) failed");
 
+	usleep(5000);
 	orb_unsubscribe(sfd);
-	close(pfd);
+
+	if (test_callback_count != 2)
+		return test_fail("unsubscribe returned while the callback ran");
 
 #if 0
 	/* this is a hacky test that exploits the sensors app to test rate-limiting */
@@ -746,9 +1891,74 @@ test()
 	return test_note("PASS");
 }
 
+void
+info_header(bool rates)
+{
+	printf("%-32s %5s %2s %4s %7s %8s %8s %8s\n", "TOPIC", "SIZE", "Q", "SUBS",
+	       rates ? "RATE" : "PUBS", "LOST", "LAT(us)", "MAX(us)");
+}
+
 int
 info()
 {
+	if (g_dev == nullptr) {
+		fprintf(stderr, "[uorb] not running\n");
+		return ERROR;
+	}
+
+	info_header(false);
+
+	for (ORBDevNode *node = g_dev->nodes(); node != nullptr; node = node->next())
+		node->print_info(0, 0);
+
+#ifdef UORB_STATIC_ALLOCATION
+	printf("topic arena: %u of %u bytes used\n", (unsigned)arena_used, (unsigned)orb_arena_size);
+#endif
+
+	return OK;
+}
+
+/**
+ * Print the publication rates of all topics, measured over one second.
+ */
+int
+top()
+{
+	if (g_dev == nullptr) {
+		fprintf(stderr, "[uorb] not running\n");
+		return ERROR;
+	}
+
+	unsigned count = 0;
+
+	for (ORBDevNode *node = g_dev->nodes(); node != nullptr; node = node->next())
+		count++;
+
+	unsigned *generations = new unsigned[count];
+
+	if (generations == nullptr)
+		return -ENOMEM;
+
+	/* nodes are only ever added at the head, so the first count entries stay the same */
+	ORBDevNode *first = g_dev->nodes();
+	unsigned i = 0;
+
+	for (ORBDevNode *node = first; i < count; node = node->next())
+		generations[i++] = node->generation();
+
+	hrt_abstime start = hrt_absolute_time();
+	usleep(1000000);
+	hrt_abstime interval = hrt_absolute_time() - start;
+
+	info_header(true);
+
+	i = 0;
+
+	for (ORBDevNode *node = first; i < count; node = node->next())
+		node->print_info(generations[i++], interval);
+
+	delete[] generations;
+
 	return OK;
 }
 
@@ -807,7 +2017,13 @@ uorb_main(int argc, char *argv[])
 	if (!strcmp(argv[1], "status"))
 		return info();
 
-	fprintf(stderr, "unrecognised command, try 'start', 'test' or 'status'\n");
+	/*
+	 * Print publication rates.
+	 */
+	if (!strcmp(argv[1], "top"))
+		return top();
+
+	fprintf(stderr, "unrecognised command, try 'start', 'test', 'status' or 'top'\n");
 	return -EINVAL;
 }
 
@@ -837,10 +2053,14 @@ void debug(const char *fmt, ...)
  *       we tried to advertise.
  */
 int
-node_advertise(const struct orb_metadata *meta)
+node_advertise(const struct orb_metadata *meta, int instance)
 {
 	int fd = -1;
 	int ret = ERROR;
+	struct orb_advertdata adv;
+
+	adv.meta = meta;
+	adv.instance = instance;
 
 	/* open the control device */
 	fd = open(TOPIC_MASTER_DEVICE_PATH, 0);
@@ -849,7 +2069,7 @@ node_advertise(const struct orb_metadata *meta)
 		goto out;
 
 	/* advertise the object */
-	ret = ioctl(fd, ORBIOCADVERTISE, (unsigned long)(uintptr_t)meta);
+	ret = ioctl(fd, ORBIOCADVERTISE, (unsigned long)(uintptr_t)&adv);
 
 	/* it's OK if it already exists */
 	if ((OK != ret) && (EEXIST == errno))
@@ -870,7 +2090,7 @@ out:
  * advertisers.
  */
 int
-node_open(Flavor f, const struct orb_metadata *meta, const void *data, bool advertiser)
+node_open(Flavor f, const struct orb_metadata *meta, const void *data, bool advertiser, int instance = 0)
 {
 	char path[orb_maxpath];
 	int fd, ret;
@@ -895,7 +2115,7 @@ node_open(Flavor f, const struct orb_metadata *meta, const void *data, bool adve
 	/*
 	 * Generate the path to the node and try to open it.
 	 */
-	ret = node_mkpath(path, f, meta);
+	ret = node_mkpath(path, f, meta, instance);
 
 	if (ret != OK) {
 		errno = -ret;
@@ -909,7 +2129,7 @@ node_open(Flavor f, const struct orb_metadata *meta, const void *data, bool adve
 	if (fd < 0) {
 
 		/* try to create the node */
-		ret = node_advertise(meta);
+		ret = node_advertise(meta, instance);
 
 		/* on success, try the open again */
 		if (ret == OK)
@@ -925,18 +2145,26 @@ node_open(Flavor f, const struct orb_metadata *meta, const void *data, bool adve
 	return fd;
 }
 
-} // namespace
-
+/**
+ * Finish advertising a node opened with node_open.
+ *
+ * Configures the queue depth, fetches the advertiser handle and performs
+ * the initial publication.  The file descriptor is always closed.
+ */
 orb_advert_t
-orb_advertise(const struct orb_metadata *meta, const void *data)
+node_advertise_fd(int fd, const struct orb_metadata *meta, const void *data, unsigned queue_size)
 {
-	int result, fd;
+	int result;
 	orb_advert_t advertiser;
 
-	/* open the node as an advertiser */
-	fd = node_open(PUBSUB, meta, data, true);
-	if (fd == ERROR)
-		return ERROR;
+	/* set the queue depth before the first publication allocates the buffer */
+	if (queue_size > 1) {
+		result = ioctl(fd, ORBIOCSETQUEUESIZE, (unsigned long)queue_size);
+		if (result == ERROR) {
+			close(fd);
+			return ERROR;
+		}
+	}
 
 	/* get the advertiser handle and close the node */
 	result = ioctl(fd, ORBIOCGADVERTISER, (unsigned long)&advertiser);
@@ -952,12 +2180,87 @@ orb_advertise(const struct orb_metadata *meta, const void *data)
 	return advertiser;
 }
 
+} // namespace
+
+orb_advert_t
+orb_advertise(const struct orb_metadata *meta, const void *data)
+{
+	return orb_advertise_queue(meta, data, 1);
+}
+
+orb_advert_t
+orb_advertise_queue(const struct orb_metadata *meta, const void *data, unsigned queue_size)
+{
+	int fd;
+
+	/* open the node as an advertiser */
+	fd = node_open(PUBSUB, meta, data, true);
+	if (fd == ERROR)
+		return ERROR;
+
+	return node_advertise_fd(fd, meta, data, queue_size);
+}
+
+orb_advert_t
+orb_advertise_multi(const struct orb_metadata *meta, const void *data, int *instance)
+{
+	return orb_advertise_multi_queue(meta, data, instance, 1);
+}
+
+orb_advert_t
+orb_advertise_multi_queue(const struct orb_metadata *meta, const void *data, int *instance, unsigned queue_size)
+{
+	int fd = ERROR;
+
+	/* claim the first instance that nobody has advertised yet */
+	for (int i = 0; i < ORB_MULTI_MAX_INSTANCES; i++) {
+
+		fd = node_open(PUBSUB, meta, data, true, i);
+
+		/* another publisher holds the node open, try the next one */
+		if (fd == ERROR) {
+			if (errno == ENOENT || errno == EINVAL)
+				return ERROR;
+
+			continue;
+		}
+
+		if (OK == ioctl(fd, ORBIOCCLAIM, 0)) {
+			if (instance != nullptr)
+				*instance = i;
+
+			break;
+		}
+
+		close(fd);
+		fd = ERROR;
+	}
+
+	if (fd == ERROR) {
+		errno = EBUSY;
+		return ERROR;
+	}
+
+	return node_advertise_fd(fd, meta, data, queue_size);
+}
+
 int
 orb_subscribe(const struct orb_metadata *meta)
 {
 	return node_open(PUBSUB, meta, nullptr, false);
 }
 
+int
+orb_subscribe_multi(const struct orb_metadata *meta, unsigned instance)
+{
+	if (instance >= ORB_MULTI_MAX_INSTANCES) {
+		errno = EINVAL;
+		return ERROR;
+	}
+
+	return node_open(PUBSUB, meta, nullptr, false, instance);
+}
+
 int
 orb_unsubscribe(int handle)
 {
@@ -988,12 +2291,111 @@ orb_copy(const struct orb_metadata *meta, int handle, void *buffer)
 	return OK;
 }
 
+uint32_t
+orb_copy_batch(struct orb_batch_entry *entries, unsigned count)
+{
+	return ORBDevNode::copy_batch(entries, count);
+}
+
+int
+orb_copy_nearest(const struct orb_metadata *meta, int handle, uint64_t time, void *buffer, uint64_t *sample_time)
+{
+	struct orb_nearest_copy nc;
+	int ret;
+
+	nc.buffer = buffer;
+	nc.time = time;
+	nc.sample_time = 0;
+
+	ret = ioctl(handle, ORBIOCCOPYNEAREST, (unsigned long)(uintptr_t)&nc);
+
+	if (ret < 0)
+		return ERROR;
+
+	if (sample_time != nullptr)
+		*sample_time = nc.sample_time;
+
+	return OK;
+}
+
+int
+orb_copy_queued(const struct orb_metadata *meta, int handle, void *buffer, unsigned *dropped)
+{
+	struct orb_queued_copy qc;
+	int ret;
+
+	qc.buffer = buffer;
+	qc.dropped = 0;
+
+	ret = ioctl(handle, ORBIOCCOPYQUEUED, (unsigned long)(uintptr_t)&qc);
+
+	if (ret < 0)
+		return ERROR;
+
+	if (dropped != nullptr)
+		*dropped = qc.dropped;
+
+	return OK;
+}
+
 int
 orb_check(int handle, bool *updated)
 {
 	return ioctl(handle, ORBIOCUPDATED, (unsigned long)(uintptr_t)updated);
 }
 
+void *
+orb_loan(const struct orb_metadata *meta, orb_advert_t handle)
+{
+	return ORBDevNode::loan(meta, handle);
+}
+
+int
+orb_commit(const struct orb_metadata *meta, orb_advert_t handle)
+{
+	return ORBDevNode::commit(meta, handle);
+}
+
+orb_reader_t
+orb_reader(const struct orb_metadata *meta, int handle)
+{
+	orb_reader_t reader;
+
+	if (OK != ioctl(handle, ORBIOCGREADER, (unsigned long)(uintptr_t)&reader))
+		return ERROR;
+
+	return reader;
+}
+
+int
+orb_peek(const struct orb_metadata *meta, orb_reader_t reader, const void **data, unsigned *generation)
+{
+	return ORBDevNode::peek(meta, reader, data, generation);
+}
+
+bool
+orb_peek_valid(orb_reader_t reader, unsigned generation)
+{
+	return ORBDevNode::peek_valid(reader, generation);
+}
+
+int
+orb_register_callback(int handle, orb_callback_t callback, void *arg)
+{
+	struct orb_callback_reg reg;
+
+	reg.callback = callback;
+	reg.arg = arg;
+
+	return ioctl(handle, ORBIOCSETCALLBACK, (unsigned long)(uintptr_t)&reg);
+}
+
+int
+orb_unregister_callback(int handle)
+{
+	return orb_register_callback(handle, nullptr, nullptr);
+}
+
 int
 orb_stat(int handle, uint64_t *time)
 {
@@ -1006,3 +2408,26 @@ orb_set_interval(int handle, unsigned interval)
 	return ioctl(handle, ORBIOCSETINTERVAL, interval * 1000);
 }
 
+int
+orb_totals(struct orb_totals_s *totals)
+{
+	memset(totals, 0, sizeof(*totals));
+
+	if (g_dev == nullptr) {
+		errno = ENXIO;
+		return ERROR;
+	}
+
+	/* nodes are only ever added at the head, so the list can be walked unlocked */
+	for (ORBDevNode *node = g_dev->nodes(); node != nullptr; node = node->next()) {
+		totals->topics++;
+		totals->publications += node->generation();
+		totals->lost += node->lost();
+
+		if (node->latency_max() > totals->latency_max)
+			totals->latency_max = node->latency_max();
+	}
+
+	return OK;
+}
+
@@ -118,6 +118,24 @@ __BEGIN_DECLS
  */
 typedef intptr_t	orb_advert_t;
 
+/**
+ * ORB topic in-place reader handle.
+ *
+ * Reader handles are bound to the subscription they were obtained from and
+ * remain valid until that subscription is closed with orb_unsubscribe.
+ */
+typedef intptr_t	orb_reader_t;
+
+/**
+ * Maximum number of publications a queued topic can retain.
+ */
+#define ORB_MAX_QUEUE_SIZE	32
+
+/**
+ * Maximum number of instances of a multi-instance topic.
+ */
+#define ORB_MULTI_MAX_INSTANCES	4
+
 /**
  * Advertise as the publisher of a topic.
  *
@@ -140,6 +158,68 @@ typedef intptr_t	orb_advert_t;
  */
 extern orb_advert_t orb_advertise(const struct orb_metadata *meta, const void *data) __EXPORT;
 
+/**
+ * Advertise as the publisher of a queued topic.
+ *
+ * This behaves like orb_advertise, but the topic keeps the last queue_size
+ * publications rather than only the most recent one.  Subscribers using
+ * orb_copy still see only the latest data; subscribers using orb_copy_queued
+ * drain the publications in order.
+ *
+ * The queue depth is fixed by the first publication of the topic; all
+ * advertisers of a queued topic must request the same depth.  The depth is
+ * rounded up to a power of two.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param data		A pointer to the initial data to be published.
+ * @param queue_size	Number of publications to retain, at most ORB_MAX_QUEUE_SIZE.
+ * @return		ERROR on error, otherwise returns a handle
+ *			that can be used to publish to the topic.
+ *			If the topic has already been published with a
+ *			different depth, errno is set to EBUSY.
+ */
+extern orb_advert_t orb_advertise_queue(const struct orb_metadata *meta, const void *data,
+					unsigned queue_size) __EXPORT;
+
+/**
+ * Advertise as the publisher of one instance of a multi-instance topic.
+ *
+ * Redundant sensors publish the same topic type; each publisher is given
+ * its own instance, which subscribers select with orb_subscribe_multi.
+ * Instance 0 is the same node that orb_advertise and orb_subscribe use,
+ * so single-sensor consumers keep working unchanged.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param data		A pointer to the initial data to be published.
+ * @param instance	If not NULL, set to the instance that was claimed.
+ * @return		ERROR on error, otherwise returns a handle
+ *			that can be used to publish to the topic.
+ *			If all ORB_MULTI_MAX_INSTANCES instances are taken,
+ *			errno is set to EBUSY.
+ */
+extern orb_advert_t orb_advertise_multi(const struct orb_metadata *meta, const void *data,
+					int *instance) __EXPORT;
+
+/**
+ * Advertise as the publisher of one instance of a queued multi-instance topic.
+ *
+ * This combines orb_advertise_multi and orb_advertise_queue: the claimed
+ * instance keeps the last queue_size publications.  Each instance has its
+ * own depth.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param data		A pointer to the initial data to be published.
+ * @param instance	If not NULL, set to the instance that was claimed.
+ * @param queue_size	Number of publications to retain, at most ORB_MAX_QUEUE_SIZE.
+ * @return		ERROR on error, otherwise returns a handle
+ *			that can be used to publish to the topic.
+ */
+extern orb_advert_t orb_advertise_multi_queue(const struct orb_metadata *meta, const void *data,
+					      int *instance, unsigned queue_size) __EXPORT;
+
 /**
  * Publish new data to a topic.
  *
@@ -183,6 +263,19 @@ extern int	orb_publish(const struct orb_metadata *meta, orb_advert_t handle, con
  */
 extern int	orb_subscribe(const struct orb_metadata *meta) __EXPORT;
 
+/**
+ * Subscribe to one instance of a multi-instance topic.
+ *
+ * Behaves exactly like orb_subscribe, which is equivalent to instance 0.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param instance	The instance to subscribe to, less than ORB_MULTI_MAX_INSTANCES.
+ * @return		ERROR on error, otherwise returns a handle
+ *			that can be used to read and update the topic.
+ */
+extern int	orb_subscribe_multi(const struct orb_metadata *meta, unsigned instance) __EXPORT;
+
 /**
  * Unsubscribe from a topic.
  *
@@ -209,6 +302,86 @@ extern int	orb_unsubscribe(int handle) __EXPORT;
  */
 extern int	orb_copy(const struct orb_metadata *meta, int handle, void *buffer) __EXPORT;
 
+/**
+ * One subscription handled by orb_copy_batch.
+ */
+struct orb_batch_entry {
+	const struct orb_metadata *meta;	/**< topic metadata */
+	int		handle;			/**< handle returned from orb_subscribe */
+	void		*buffer;		/**< destination, or NULL to only clear the update */
+	orb_reader_t	reader;			/**< resolved by orb_copy_batch, initialise to zero */
+};
+
+/**
+ * Initialise an orb_batch_entry.
+ */
+static inline void orb_batch_init(struct orb_batch_entry *entry, const struct orb_metadata *meta,
+				  int handle, void *buffer)
+{
+	entry->meta = meta;
+	entry->handle = handle;
+	entry->buffer = buffer;
+	entry->reader = 0;
+}
+
+/**
+ * Check a set of subscriptions and copy the ones that have been updated.
+ *
+ * This is equivalent to calling orb_check followed by orb_copy on every
+ * entry, but after the first call the subscriptions are accessed directly
+ * instead of through the file layer.
+ *
+ * @param entries	Array of subscriptions to process.
+ * @param count		Number of entries, at most 32.
+ * @return		Bitmask with bit i set if entries[i] was updated and copied.
+ */
+extern uint32_t	orb_copy_batch(struct orb_batch_entry *entries, unsigned count) __EXPORT;
+
+/**
+ * Fetch the retained publication made closest to a given time.
+ *
+ * A queued topic (see orb_advertise_queue) remembers when each of its
+ * retained publications was made, so it doubles as a short history that
+ * delayed measurements can be matched against.  This returns whichever
+ * retained publication is nearest to time, before or after.  It does not
+ * mark anything as read; orb_check and orb_copy_queued are unaffected.
+ *
+ * On a topic without a queue only the latest publication is retained, and
+ * it is always the one returned.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param handle	A handle returned from orb_subscribe.
+ * @param time		The time to look up, as returned by hrt_absolute_time().
+ * @param buffer	Pointer to the buffer receiving the data.
+ * @param sample_time	If not NULL, set to the time the returned publication was made.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ *			If the topic has not been published yet, errno is set to EAGAIN.
+ */
+extern int	orb_copy_nearest(const struct orb_metadata *meta, int handle, uint64_t time,
+				 void *buffer, uint64_t *sample_time) __EXPORT;
+
+/**
+ * Fetch the oldest unread publication from a queued topic.
+ *
+ * Each call returns the next publication the subscriber has not seen yet,
+ * so calling this while orb_check reports an update drains the queue in
+ * order.  If the subscriber fell so far behind that publications were
+ * overwritten before they could be read, the number lost is reported in
+ * dropped.  On a topic without a queue this behaves like orb_copy.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param handle	A handle returned from orb_subscribe.
+ * @param buffer	Pointer to the buffer receiving the data, or NULL
+ *			if the caller only wants to advance past one publication.
+ * @param dropped	If not NULL, set to the number of publications lost
+ *			since the previous call.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ */
+extern int	orb_copy_queued(const struct orb_metadata *meta, int handle, void *buffer,
+				unsigned *dropped) __EXPORT;
+
 /**
  * Check whether a topic has been published to since the last orb_copy.
  *
@@ -259,6 +432,140 @@ extern int	orb_stat(int handle, uint64_t *time) __EXPORT;
  */
 extern int	orb_set_interval(int handle, unsigned interval) __EXPORT;
 
+/**
+ * Subscription callback, see orb_register_callback.
+ */
+typedef void	(*orb_callback_t)(void *arg);
+
+/**
+ * Run a function on the high-priority work queue whenever a subscription
+ * sees an update.
+ *
+ * This lets a module react to a topic without a task of its own blocking in
+ * poll().  The callback is scheduled under the same conditions that would
+ * wake a poll() on the handle, so an interval set with orb_set_interval is
+ * honoured.  The callback should fetch the data with orb_copy or orb_peek
+ * to clear the update; it is queued at most once however many publications
+ * arrive before it runs.
+ *
+ * The callback runs on HPWORK and must not block.
+ *
+ * @param handle	A handle returned from orb_subscribe.
+ * @param callback	The function to call.
+ * @param arg		Argument passed to callback.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ */
+extern int	orb_register_callback(int handle, orb_callback_t callback, void *arg) __EXPORT;
+
+/**
+ * Remove the callback registered with orb_register_callback.
+ *
+ * Closing the subscription with orb_unsubscribe also removes the callback.
+ *
+ * @param handle	A handle returned from orb_subscribe.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ */
+extern int	orb_unregister_callback(int handle) __EXPORT;
+
+/**
+ * Borrow the topic buffer for an in-place publication.
+ *
+ * Instead of filling a local structure and having orb_publish copy it into
+ * the topic, the publisher writes directly into the buffer returned here and
+ * then calls orb_commit to make it visible to subscribers.  The buffer does
+ * not contain the previously published data; the publisher must fill in the
+ * complete structure before committing.
+ *
+ * Only one loan may be outstanding per topic, and the first loan must be
+ * taken from non-interrupt context.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param handle	The handle returned from orb_advertise.
+ * @return		Pointer to a buffer of meta->o_size bytes, or NULL on
+ *			error with errno set accordingly.
+ */
+extern void	*orb_loan(const struct orb_metadata *meta, orb_advert_t handle) __EXPORT;
+
+/**
+ * Publish the buffer previously obtained with orb_loan.
+ *
+ * The loaned buffer becomes the current topic data without being copied and
+ * any waiting subscribers are notified, exactly as for orb_publish.  The
+ * pointer returned by orb_loan must not be used after this call.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param handle	The handle returned from orb_advertise.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ */
+extern int	orb_commit(const struct orb_metadata *meta, orb_advert_t handle) __EXPORT;
+
+/**
+ * Obtain an in-place reader handle for a subscription.
+ *
+ * The reader handle allows orb_peek to access the topic without going through
+ * the file layer.  It only needs to be obtained once per subscription.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param handle	A handle returned from orb_subscribe.
+ * @return		ERROR on error, otherwise a reader handle.
+ */
+extern orb_reader_t orb_reader(const struct orb_metadata *meta, int handle) __EXPORT;
+
+/**
+ * Access the current topic data in place.
+ *
+ * This has the same effect on the subscription as orb_copy (the updated flag
+ * is cleared), but returns a pointer to the topic buffer instead of copying
+ * it.  The data may be replaced by the publisher at any time; once the caller
+ * has finished reading it must confirm with orb_peek_valid that no publication
+ * happened in the meantime, and otherwise discard what it read and peek again.
+ *
+ * @param meta		The uORB metadata (usually from the ORB_ID() macro)
+ *			for the topic.
+ * @param reader	A handle returned from orb_reader.
+ * @param data		Set to point at the topic data.
+ * @param generation	Set to a token identifying the data pointed to.
+ * @return		OK on success, ERROR otherwise with errno set accordingly.
+ *			If the topic has not been published yet errno is EAGAIN.
+ */
+extern int	orb_peek(const struct orb_metadata *meta, orb_reader_t reader, const void **data,
+			 unsigned *generation) __EXPORT;
+
+/**
+ * Check whether data obtained with orb_peek is still intact.
+ *
+ * @param reader	A handle returned from orb_reader.
+ * @param generation	The token returned by orb_peek.
+ * @return		True if the data has not been replaced since it was peeked.
+ */
+extern bool	orb_peek_valid(orb_reader_t reader, unsigned generation) __EXPORT;
+
+/**
+ * Counters summed over all topics, as shown per topic by 'uorb status'.
+ *
+ * The counts only increase (and wrap), rates are taken from the difference
+ * between two calls.
+ */
+struct orb_totals_s {
+	unsigned	topics;			/**< number of topic nodes */
+	unsigned	publications;		/**< publications since the topics were created */
+	unsigned	lost;			/**< publications subscribers never copied */
+	uint64_t	latency_max;		/**< worst publish to copy latency of any topic, us */
+};
+
+/**
+ * Sum the statistics of all topics.
+ *
+ * This only walks the topic list, it does not open any topic.
+ *
+ * @param totals	Filled in with the sums.
+ * @return		OK on success, ERROR if uORB is not running.
+ */
+extern int	orb_totals(struct orb_totals_s *totals) __EXPORT;
+
 __END_DECLS
 
 #endif /* _UORB_UORB_H */
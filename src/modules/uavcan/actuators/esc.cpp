@@ -40,6 +40,17 @@
 #include "esc.hpp"
 #include <systemlib/err.h>
 
+/**
+ * Number of CAN frames of a RawCommand transfer with the given number of commands.
+ * A multi-frame transfer carries a 2 byte CRC, every frame carries 7 payload bytes.
+ */
+static unsigned raw_cmd_frame_count(unsigned num_cmds)
+{
+	typedef uavcan::equipment::esc::RawCommand::FieldTypes::cmd::RawValueType CmdType;
+	const unsigned payload_bytes = (num_cmds * CmdType::BitLen + 7) / 8;
+	return (payload_bytes <= 7) ? 1 : (payload_bytes + 2 + 6) / 7;
+}
+
 UavcanEscController::UavcanEscController(uavcan::INode &node) :
 	_node(node),
 	_uavcan_pub_raw_cmd(node),
@@ -56,6 +67,9 @@ UavcanEscController::~UavcanEscController()
 
 int UavcanEscController::init()
 {
+	// A command still queued when the next one is due is stale, never send it after the newer one
+	_uavcan_pub_raw_cmd.setTxTimeout(uavcan::MonotonicDuration::fromUSec(1000000 / MAX_RATE_HZ));
+
 	// ESC status subscription
 	int res = _uavcan_sub_status.start(StatusCbBinder(this, &UavcanEscController::esc_status_sub_cb));
 	if (res < 0)
@@ -71,11 +85,11 @@ int UavcanEscController::init()
 	return res;
 }
 
-void UavcanEscController::update_outputs(float *outputs, unsigned num_outputs)
+unsigned UavcanEscController::update_outputs(float *outputs, unsigned num_outputs)
 {
 	if ((outputs == nullptr) || (num_outputs > uavcan::equipment::esc::RawCommand::FieldTypes::cmd::MaxSize)) {
 		perf_count(_perfcnt_invalid_input);
-		return;
+		return 0;
 	}
 
 	/*
@@ -83,10 +97,29 @@ void UavcanEscController::update_outputs(float *outputs, unsigned num_outputs)
 	 */
 	const auto timestamp = _node.getMonotonicTime();
 	if ((timestamp - _prev_cmd_pub).toUSec() < (1000000 / MAX_RATE_HZ)) {
-		return;
+		return 0;
 	}
 	_prev_cmd_pub = timestamp;
 
+	/*
+	 * Speed loop, straight on the ESC status this node collects
+	 */
+	if (_rpm_control.motors != 0) {
+		if (_armed) {
+			int32_t rpm[CONNECTED_ESC_MAX];
+
+			for (unsigned i = 0; i < _esc_status.esc_count; i++) {
+				rpm[i] = _esc_status.esc[i].esc_rpm;
+			}
+
+			rpm_control_update(&_rpm_control, outputs, num_outputs, rpm, _esc_status.esc_count,
+					   _esc_status.timestamp, timestamp.toUSec());
+
+		} else {
+			rpm_control_reset(&_rpm_control);
+		}
+	}
+
 	/*
 	 * Fill the command message
 	 * If unarmed, we publish an empty message anyway
@@ -118,7 +151,11 @@ void UavcanEscController::update_outputs(float *outputs, unsigned num_outputs)
 	 * Publish the command message to the bus
 	 * Note that for a quadrotor it takes one CAN frame
 	 */
-	(void)_uavcan_pub_raw_cmd.broadcast(msg);
+	if (_uavcan_pub_raw_cmd.broadcast(msg) < 0) {
+		return 0;
+	}
+
+	return raw_cmd_frame_count(msg.cmd.size());
 }
 
 void UavcanEscController::arm_esc(bool arm)
@@ -126,6 +163,11 @@ void UavcanEscController::arm_esc(bool arm)
 	_armed = arm;
 }
 
+void UavcanEscController::set_rpm_control(uint32_t motors, float rpm_max, float p, float i)
+{
+	rpm_control_init(&_rpm_control, motors, rpm_max, p, i);
+}
+
 void UavcanEscController::esc_status_sub_cb(const uavcan::ReceivedDataStructure<uavcan::equipment::esc::Status> &msg)
 {
 	if (msg.esc_index < CONNECTED_ESC_MAX) {
@@ -142,11 +184,32 @@ void UavcanEscController::esc_status_sub_cb(const uavcan::ReceivedDataStructure<
 		ref.esc_setpoint    = msg.power_rating_pct;
 		ref.esc_rpm         = msg.rpm;
 		ref.esc_errorcount  = msg.error_count;
+
+		/*
+		 * Publish as soon as every ESC has reported, so the telemetry keeps up
+		 * with the ESCs rather than the timer
+		 */
+		_esc_reported |= 1 << msg.esc_index;
+
+		if (_esc_reported == (1U << _esc_status.esc_count) - 1) {
+			const auto timestamp = _node.getMonotonicTime();
+
+			if ((timestamp - _prev_status_pub).toUSec() >= (1000000 / MAX_RATE_HZ)) {
+				_prev_status_pub = timestamp;
+				publish_esc_status();
+			}
+		}
 	}
 }
 
 void UavcanEscController::orb_pub_timer_cb(const uavcan::TimerEvent&)
 {
+	publish_esc_status();
+}
+
+void UavcanEscController::publish_esc_status()
+{
+	_esc_reported = 0;
 	_esc_status.counter += 1;
 	_esc_status.esc_connectiontype = ESC_CONNECTION_TYPE_CAN;
 
@@ -49,6 +49,7 @@
 #include <uavcan/equipment/esc/Status.hpp>
 #include <systemlib/perf_counter.h>
 #include <uORB/topics/esc_status.h>
+#include <systemlib/rpm_control/rpm_control.h>
 
 
 class UavcanEscController
@@ -59,10 +60,21 @@ public:
 
 	int init();
 
-	void update_outputs(float *outputs, unsigned num_outputs);
+	/**
+	 * Broadcasts the outputs as one RawCommand, rate limited to MAX_RATE_HZ.
+	 *
+	 * @return Number of CAN frames of the command, 0 if none was broadcast.
+	 */
+	unsigned update_outputs(float *outputs, unsigned num_outputs);
 
 	void arm_esc(bool arm);
 
+	/**
+	 * Close a speed loop on the motor outputs from the ESC status, see rpm_control.h.
+	 * No motors switch the loop off.
+	 */
+	void set_rpm_control(uint32_t motors, float rpm_max, float p, float i);
+
 private:
 	/**
 	 * ESC status message reception will be reported via this callback.
@@ -70,10 +82,13 @@ private:
 	void esc_status_sub_cb(const uavcan::ReceivedDataStructure<uavcan::equipment::esc::Status> &msg);
 
 	/**
-	 * ESC status will be published to ORB from this callback (fixed rate).
+	 * ESC status will be published to ORB from this callback (fixed rate), in case
+	 * some ESCs stop reporting.
 	 */
 	void orb_pub_timer_cb(const uavcan::TimerEvent &event);
 
+	void publish_esc_status();
+
 
 	static constexpr unsigned MAX_RATE_HZ = 200;			///< XXX make this configurable
 	static constexpr unsigned ESC_STATUS_UPDATE_RATE_HZ = 10;
@@ -88,11 +103,14 @@ private:
 	bool		_armed = false;
 	esc_status_s	_esc_status = {};
 	orb_advert_t	_esc_status_pub = -1;
+	uint32_t	_esc_reported = 0;		///< ESCs heard from since the last publication
+	rpm_control_t	_rpm_control = {};
 
 	/*
 	 * libuavcan related things
 	 */
 	uavcan::MonotonicTime							_prev_cmd_pub;   ///< rate limiting
+	uavcan::MonotonicTime							_prev_status_pub;
 	uavcan::INode								&_node;
 	uavcan::Publisher<uavcan::equipment::esc::RawCommand>			_uavcan_pub_raw_cmd;
 	uavcan::Subscriber<uavcan::equipment::esc::Status, StatusCbBinder>	_uavcan_sub_status;
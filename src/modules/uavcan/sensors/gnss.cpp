@@ -65,34 +65,53 @@ int UavcanGnssBridge::init()
 
 unsigned UavcanGnssBridge::get_num_redundant_channels() const
 {
-	return (_receiver_node_id < 0) ? 0 : 1;
+	unsigned out = 0;
+	for (unsigned i = 0; i < MAX_RECEIVERS; i++) {
+		if (_receivers[i].node_id >= 0) {
+			out += 1;
+		}
+	}
+	return out;
 }
 
 void UavcanGnssBridge::print_status() const
 {
-	printf("RX errors: %d, receiver node id: ", _sub_fix.getFailureCount());
-	if (_receiver_node_id < 0) {
-		printf("N/A\n");
-	} else {
-		printf("%d\n", _receiver_node_id);
+	printf("RX errors: %d\n", _sub_fix.getFailureCount());
+
+	for (unsigned i = 0; i < MAX_RECEIVERS; i++) {
+		if (_receivers[i].node_id >= 0) {
+			printf("receiver %d: node id %d%s\n", i, _receivers[i].node_id, (i == 0) ? " (primary)" : "");
+		} else {
+			printf("receiver %d: N/A\n", i);
+		}
 	}
 }
 
 void UavcanGnssBridge::gnss_fix_sub_cb(const uavcan::ReceivedDataStructure<uavcan::equipment::gnss::Fix> &msg)
 {
-	// This bridge does not support redundant GNSS receivers yet.
-	if (_receiver_node_id < 0) {
-		_receiver_node_id = msg.getSrcNodeID().get();
-		warnx("GNSS receiver node ID: %d", _receiver_node_id);
-	} else {
-		if (_receiver_node_id != msg.getSrcNodeID().get()) {
-			return;  // This GNSS receiver is the redundant one, ignore it.
+	const int node_id = msg.getSrcNodeID().get();
+
+	// Map the node to its receiver slot, the first free one for a new node
+	Receiver *receiver = nullptr;
+	for (unsigned i = 0; i < MAX_RECEIVERS; i++) {
+		if (_receivers[i].node_id == node_id || _receivers[i].node_id < 0) {
+			receiver = _receivers + i;
+			break;
 		}
 	}
 
+	if (receiver == nullptr) {
+		return;  // More receivers than we have slots for, ignore this one.
+	}
+
+	if (receiver->node_id < 0) {
+		receiver->node_id = node_id;
+		warnx("GNSS receiver %d node ID: %d", int(receiver - _receivers), node_id);
+	}
+
 	auto report = ::vehicle_gps_position_s();
 
-	report.timestamp_position = hrt_absolute_time();
+	report.timestamp_position = sample_time(msg.timestamp, msg.getMonotonicTimestamp());
 	report.lat = msg.latitude_deg_1e8 / 10;
 	report.lon = msg.longitude_deg_1e8 / 10;
 	report.alt = msg.height_msl_mm;
@@ -163,6 +182,21 @@ void UavcanGnssBridge::gnss_fix_sub_cb(const uavcan::ReceivedDataStructure<uavca
 
 	report.satellites_used = msg.sats_used;
 
+	/*
+	 * Every receiver has its own sensor_gps instance, the primary one also feeds
+	 * vehicle_gps_position. Both are published straight from this report.
+	 */
+	if (receiver->sensor_pub > 0) {
+		orb_publish(ORB_ID(sensor_gps), receiver->sensor_pub, &report);
+
+	} else {
+		receiver->sensor_pub = orb_advertise_multi(ORB_ID(sensor_gps), &report, nullptr);
+	}
+
+	if (receiver != _receivers) {
+		return;
+	}
+
 	if (_report_pub > 0) {
 		orb_publish(ORB_ID(vehicle_gps_position), _report_pub, &report);
 
@@ -78,9 +78,17 @@ private:
 		void (UavcanGnssBridge::*)(const uavcan::ReceivedDataStructure<uavcan::equipment::gnss::Fix>&)>
 		FixCbBinder;
 
+	static constexpr unsigned MAX_RECEIVERS = 2;
+
+	struct Receiver
+	{
+		int node_id              = -1;
+		orb_advert_t sensor_pub  = -1;	///< this receiver's instance of sensor_gps
+	};
+
 	uavcan::INode &_node;
 	uavcan::Subscriber<uavcan::equipment::gnss::Fix, FixCbBinder> _sub_fix;
-	int _receiver_node_id = -1;
+	Receiver _receivers[MAX_RECEIVERS];	///< the first one heard from is also published as vehicle_gps_position
 
 	orb_advert_t _report_pub;                ///< uORB pub for gnss position
 
@@ -110,10 +110,7 @@ void UavcanMagnetometerBridge::mag_sub_cb(const uavcan::ReceivedDataStructure<ua
 
 	report.range_ga = 1.3F;   // Arbitrary number, doesn't really mean anything
 
-	report.timestamp = msg.getUtcTimestamp().toUSec();
-	if (report.timestamp == 0) {
-		report.timestamp = msg.getMonotonicTimestamp().toUSec();
-	}
+	report.timestamp = sample_time(msg.timestamp, msg.getMonotonicTimestamp());
 
 	report.x = (msg.magnetic_field[0] - _scale.x_offset) * _scale.x_scale;
 	report.y = (msg.magnetic_field[1] - _scale.y_offset) * _scale.y_scale;
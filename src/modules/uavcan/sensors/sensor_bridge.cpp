@@ -52,6 +52,20 @@ void IUavcanSensorBridge::make_all(uavcan::INode &node, List<IUavcanSensorBridge
 	list.add(new UavcanGnssBridge(node));
 }
 
+uint64_t IUavcanSensorBridge::sample_time(const uavcan::Timestamp &stamp, const uavcan::MonotonicTime &rx_time)
+{
+	// Longest plausible delay between the sample and its reception
+	static constexpr uint64_t MaxLatencyUSec = 500000;
+
+	const uint64_t sample = uavcan::UtcTime(stamp).toUSec();
+	const uint64_t rx = rx_time.toUSec();
+
+	if (sample == 0 || sample > rx || (rx - sample) > MaxLatencyUSec) {
+		return rx;
+	}
+	return sample;
+}
+
 /*
  * UavcanCDevSensorBridgeBase
  */
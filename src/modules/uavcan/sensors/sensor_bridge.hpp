@@ -79,6 +79,17 @@ public:
 	 * @return nullptr if such bridge can't be created.
 	 */
 	static void make_all(uavcan::INode &node, List<IUavcanSensorBridge*> &list);
+
+protected:
+	/**
+	 * Sample time of a measurement in FMU time.
+	 * A node synchronized to our time sync master stamps the sample in our time. An unsynchronized
+	 * node sends zero, and a stamp that is in the future or too old is not trusted either; those
+	 * fall back to the frame reception time.
+	 * @param stamp   Timestamp field of the message
+	 * @param rx_time Monotonic reception time of the message
+	 */
+	static uint64_t sample_time(const uavcan::Timestamp &stamp, const uavcan::MonotonicTime &rx_time);
 };
 
 /**
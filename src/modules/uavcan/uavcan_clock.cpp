@@ -39,6 +39,10 @@
  *
  * Implements a clock for the CAN node.
  *
+ * The FMU is the time sync master of the bus, and the time it distributes is
+ * its own hrt time. UTC is therefore the hrt time as well, so that every node
+ * synchronized to us stamps its samples in the time base the estimators use.
+ *
  * @author Pavel Kirienko <pavel.kirienko@gmail.com>
  */
 
@@ -54,19 +58,19 @@ uavcan::MonotonicTime getMonotonic()
 
 uavcan::UtcTime getUtc()
 {
-	return uavcan::UtcTime();
+	return uavcan::UtcTime::fromUSec(hrt_absolute_time());
 }
 
 void adjustUtc(uavcan::UtcDuration adjustment)
 {
-	(void)adjustment;
+	(void)adjustment;	// the master never adjusts its own time
 }
 
 uavcan::uint64_t getUtcUSecFromCanInterrupt();
 
 uavcan::uint64_t getUtcUSecFromCanInterrupt()
 {
-	return 0;
+	return hrt_absolute_time();
 }
 
 } // namespace clock
@@ -68,7 +68,9 @@ UavcanNode::UavcanNode(uavcan::ICanDriver &can_driver, uavcan::ISystemClock &sys
 	CDev("uavcan", UAVCAN_DEVICE_PATH),
 	_node(can_driver, system_clock),
 	_node_mutex(),
-	_esc_controller(_node)
+	_esc_controller(_node),
+	_time_sync_master(_node),
+	_time_sync_timer(_node)
 {
 	_control_topics[0] = ORB_ID(actuator_controls_0);
 	_control_topics[1] = ORB_ID(actuator_controls_1);
@@ -163,6 +165,8 @@ int UavcanNode::start(uavcan::NodeID node_id, uint32_t bitrate)
 		return -1;
 	}
 
+	_instance->_frame_time_us = (CanFrameMaxBits * 1000000 + bitrate - 1) / bitrate;
+
 	const int node_init_res = _instance->init(node_id);
 
 	if (node_init_res < 0) {
@@ -258,7 +262,28 @@ int UavcanNode::init(uavcan::NodeID node_id)
 		br = br->getSibling();
 	}
 
-	return _node.start();
+	ret = _node.start();
+	if (ret < 0) {
+		return ret;
+	}
+
+	// Time sync master
+	ret = _time_sync_master.init();
+	if (ret < 0) {
+		warnx("time sync master init failed %i", ret);
+		return ret;
+	}
+
+	_time_sync_timer.setCallback(TimerCbBinder(this, &UavcanNode::time_sync_timer_cb));
+	_time_sync_timer.startPeriodic(uavcan::MonotonicDuration::fromMSec(TimeSyncPeriodMs));
+
+	return OK;
+}
+
+void UavcanNode::time_sync_timer_cb(const uavcan::TimerEvent&)
+{
+	// Stays silent while a master with a lower node ID is active on the bus
+	(void)_time_sync_master.publish();
 }
 
 void UavcanNode::node_spin_once()
@@ -269,6 +294,24 @@ void UavcanNode::node_spin_once()
 	}
 }
 
+void UavcanNode::node_flush_tx(unsigned frames)
+{
+	if (frames == 0) {
+		return;
+	}
+
+	/*
+	 * The frames that did not fit into the TX mailboxes wait on the libuavcan TX queue.
+	 * The spin moves them into the mailboxes as these drain, so keep spinning for as long
+	 * as all frames of the command take on the wire; received frames are handled meanwhile.
+	 */
+	const auto deadline = _node.getMonotonicTime() + uavcan::MonotonicDuration::fromUSec(frames * _frame_time_us);
+	const int spin_res = _node.spin(deadline);
+	if (spin_res < 0) {
+		warnx("node spin error %i", spin_res);
+	}
+}
+
 int UavcanNode::run()
 {
 	(void)pthread_mutex_lock(&_node_mutex);
@@ -323,6 +366,7 @@ int UavcanNode::run()
 
 		(void)pthread_mutex_lock(&_node_mutex);
 
+		// Handle the frames that woke us up first, so the mix sees the latest ESC status
 		node_spin_once();  // Non-blocking
 
 		// this would be bad...
@@ -380,7 +424,10 @@ int UavcanNode::run()
 				}
 
 				// Output to the bus
-				_esc_controller.update_outputs(outputs.output, outputs.noutputs);
+				const unsigned frames = _esc_controller.update_outputs(outputs.output, outputs.noutputs);
+
+				// Send all frames of the command in this iteration, not on the next bus event
+				node_flush_tx(frames);
 			}
 		}
 
@@ -482,6 +529,18 @@ UavcanNode::ioctl(file *filp, int cmd, unsigned long arg)
 		arm_actuators(false);
 		break;
 
+	case PWM_SERVO_SET_RPM_CONTROL: {
+			const struct pwm_rpm_control *config = (const struct pwm_rpm_control *)arg;
+
+			if ((config->motors != 0) && !(config->rpm_max > 0.0f)) {
+				ret = -EINVAL;
+				break;
+			}
+
+			_esc_controller.set_rpm_control(config->motors, config->rpm_max, config->p, config->i);
+			break;
+		}
+
 	case MIXERIOCGETOUTPUTCOUNT:
 		*(unsigned *)arg = _output_count;
 		break;
@@ -495,10 +554,8 @@ UavcanNode::ioctl(file *filp, int cmd, unsigned long arg)
 
 		break;
 
-	case MIXERIOCLOADBUF: {
-			const char *buf = (const char *)arg;
-			unsigned buflen = strnlen(buf, 1024);
-
+	case MIXERIOCLOADBUF:
+	case MIXERIOCLOADBIN: {
 			if (_mixers == nullptr)
 				_mixers = new MixerGroup(control_callback, (uintptr_t)_controls);
 
@@ -508,7 +565,16 @@ UavcanNode::ioctl(file *filp, int cmd, unsigned long arg)
 
 			} else {
 
-				ret = _mixers->load_from_buf(buf, buflen);
+				if (cmd == MIXERIOCLOADBIN) {
+					const mixer_bin_buf_s *bin = (const mixer_bin_buf_s *)arg;
+					unsigned buflen = bin->length;
+					ret = _mixers->load_from_bin(bin->data, buflen);
+
+				} else {
+					const char *buf = (const char *)arg;
+					unsigned buflen = strnlen(buf, 1024);
+					ret = _mixers->load_from_buf(buf, buflen);
+				}
 
 				if (ret != 0) {
 					warnx("mixer load failed with %d", ret);
@@ -36,6 +36,7 @@
 #include <nuttx/config.h>
 
 #include <uavcan_stm32/uavcan_stm32.hpp>
+#include <uavcan/protocol/global_time_sync_master.hpp>
 #include <drivers/device/device.h>
 
 #include <uORB/topics/actuator_controls.h>
@@ -95,8 +96,23 @@ private:
 	void		fill_node_info();
 	int		init(uavcan::NodeID node_id);
 	void		node_spin_once();
+
+	/**
+	 * Spins until the given number of just queued frames can have left, see run().
+	 */
+	void		node_flush_tx(unsigned frames);
 	int		run();
 
+	/**
+	 * Broadcasts our time to the bus, see uavcan_clock.cpp.
+	 */
+	void		time_sync_timer_cb(const uavcan::TimerEvent &event);
+
+	static constexpr unsigned TimeSyncPeriodMs = 1000;
+	static constexpr unsigned CanFrameMaxBits = 160;	///< extended 8 byte data frame with worst case stuffing
+
+	typedef uavcan::MethodBinder<UavcanNode*, void (UavcanNode::*)(const uavcan::TimerEvent&)> TimerCbBinder;
+
 	int			_task = -1;			///< handle to the OS task
 	bool			_task_should_exit = false;	///< flag to indicate to tear down the CAN driver
 	int			_armed_sub = -1;		///< uORB subscription of the arming status
@@ -104,6 +120,7 @@ private:
 	bool			_is_armed = false;		///< the arming status of the actuators on the bus
 
 	unsigned		_output_count = 0;		///< number of actuators currently available
+	unsigned		_frame_time_us = 0;		///< wire time of the longest CAN frame at the bus bitrate
 
 	static UavcanNode	*_instance;			///< singleton pointer
 	Node			_node;				///< library instance
@@ -111,6 +128,9 @@ private:
 
 	UavcanEscController	_esc_controller;
 
+	uavcan::GlobalTimeSyncMaster			_time_sync_master;
+	uavcan::TimerEventForwarder<TimerCbBinder>	_time_sync_timer;
+
 	List<IUavcanSensorBridge*> _sensor_bridges;		///< List of active sensor bridges
 
 	MixerGroup		*_mixers = nullptr;
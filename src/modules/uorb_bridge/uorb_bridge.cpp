@@ -0,0 +1,530 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file uorb_bridge.cpp
+ *
+ * Mirrors a set of uORB topics to a companion computer over a serial link.
+ *
+ * Every topic publication is sent as a frame:
+ *
+ *	sync (2)	0x55 0x42
+ *	topic (1)	index into the topic table, or BRIDGE_DESCRIPTION
+ *	seq (1)		per-topic sequence number, to detect lost frames
+ *	length (2)	payload length, little endian
+ *	payload		the raw topic structure
+ *	crc (4)		crc32 over topic, seq, length and payload
+ *
+ * Once per second a description frame is sent for each topic, carrying the
+ * topic index, structure size and name, so the host can decode the stream
+ * no matter when it connects.
+ */
+
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <termios.h>
+#include <crc32.h>
+#include <drivers/drv_hrt.h>
+#include <uORB/uORB.h>
+#include <uORB/topics/vehicle_attitude.h>
+#include <uORB/topics/vehicle_local_position.h>
+#include <uORB/topics/vehicle_global_position.h>
+#include <uORB/topics/vehicle_gps_position.h>
+#include <uORB/topics/vehicle_status.h>
+#include <uORB/topics/sensor_combined.h>
+#include <uORB/topics/actuator_controls.h>
+#include <uORB/topics/battery_status.h>
+#include <systemlib/systemlib.h>
+#include <systemlib/err.h>
+
+/**
+ * uorb_bridge app start / stop handling function
+ *
+ * @ingroup apps
+ */
+extern "C" __EXPORT int uorb_bridge_main(int argc, char *argv[]);
+
+#define BRIDGE_SYNC1		0x55
+#define BRIDGE_SYNC2		0x42
+#define BRIDGE_DESCRIPTION	0xff	/**< topic index of description frames */
+#define BRIDGE_HEADER_LEN	6
+#define BRIDGE_CRC_LEN		4
+#define BRIDGE_NAME_MAX		32
+
+namespace
+{
+
+/**
+ * A topic to mirror and the rate at which to send it.
+ */
+struct bridge_topic {
+	const struct orb_metadata *meta;
+	unsigned	rate;		/**< maximum rate in Hz */
+};
+
+const bridge_topic topic_table[] = {
+	{ ORB_ID(vehicle_attitude),		50 },
+	{ ORB_ID(vehicle_local_position),	20 },
+	{ ORB_ID(vehicle_global_position),	10 },
+	{ ORB_ID(vehicle_gps_position),		5 },
+	{ ORB_ID(sensor_combined),		50 },
+	{ ORB_ID(actuator_controls_0),		50 },
+	{ ORB_ID(vehicle_status),		2 },
+	{ ORB_ID(battery_status),		2 },
+};
+
+const unsigned topic_count = sizeof(topic_table) / sizeof(topic_table[0]);
+
+}
+
+class UorbBridge
+{
+public:
+	/**
+	 * Constructor
+	 *
+	 * @param device	Serial device to send on.
+	 * @param baudrate	Baud rate to configure the device for.
+	 */
+	UorbBridge(const char *device, unsigned baudrate);
+
+	/**
+	 * Destructor, also kills task.
+	 */
+	~UorbBridge();
+
+	/**
+	 * Start the task.
+	 *
+	 * @return		OK on success.
+	 */
+	int		start();
+
+	/**
+	 * Display status.
+	 */
+	void		status();
+
+private:
+	/**
+	 * Per-topic bridge state.
+	 */
+	struct channel {
+		int		sub;		/**< subscription handle */
+		orb_reader_t	reader;		/**< in-place reader for sub */
+		uint8_t		seq;		/**< sequence number of the next frame */
+		unsigned	frames;		/**< frames sent */
+		unsigned	retries;	/**< copies redone because of a concurrent publication */
+	};
+
+	bool		_task_should_exit;	/**< if true, task should exit */
+	int		_main_task;		/**< handle for task */
+	char		_device[20];		/**< serial device name */
+	unsigned	_baudrate;		/**< serial baud rate */
+	int		_fd;			/**< serial device handle */
+	unsigned	_write_errors;		/**< frames the serial driver did not accept completely */
+
+	channel		_channels[topic_count];
+	uint8_t		*_frame;		/**< transmit frame buffer */
+
+	/**
+	 * Open and configure the serial device.
+	 *
+	 * @return		OK, or -errno on error.
+	 */
+	int		open_serial();
+
+	/**
+	 * Finish a frame with its header and crc and write it out.
+	 *
+	 * @param topic		Topic index for the header.
+	 * @param seq		Sequence number for the header.
+	 * @param length	Payload length, the payload must already be in place.
+	 */
+	void		send_frame(uint8_t topic, uint8_t seq, unsigned length);
+
+	/**
+	 * Send the latest publication of a topic.
+	 *
+	 * The payload is copied straight from the topic buffer into the frame.
+	 *
+	 * @param index		Index into topic_table.
+	 */
+	void		send_topic(unsigned index);
+
+	/**
+	 * Send the description frames for all topics.
+	 */
+	void		send_descriptions();
+
+	void		task_main();
+
+	static int	task_main_trampoline(int argc, char *argv[]);
+};
+
+namespace uorb_bridge
+{
+UorbBridge	*g_bridge;
+}
+
+UorbBridge::UorbBridge(const char *device, unsigned baudrate) :
+	_task_should_exit(false),
+	_main_task(-1),
+	_baudrate(baudrate),
+	_fd(-1),
+	_write_errors(0),
+	_frame(nullptr)
+{
+	strncpy(_device, device, sizeof(_device));
+	_device[sizeof(_device) - 1] = '\0';
+	memset(_channels, 0, sizeof(_channels));
+
+	for (unsigned i = 0; i < topic_count; i++)
+		_channels[i].sub = -1;
+}
+
+UorbBridge::~UorbBridge()
+{
+	if (_main_task != -1) {
+
+		/* task wakes up every 100ms or so at the longest */
+		_task_should_exit = true;
+
+		/* wait for a second for the task to quit at our request */
+		unsigned i = 0;
+
+		do {
+			/* wait 20ms */
+			usleep(20000);
+
+			/* if we have given up, kill it */
+			if (++i > 50) {
+				task_delete(_main_task);
+				break;
+			}
+		} while (_main_task != -1);
+	}
+
+	uorb_bridge::g_bridge = nullptr;
+}
+
+int
+UorbBridge::start()
+{
+	ASSERT(_main_task == -1);
+
+	/* start the task */
+	_main_task = task_spawn_cmd("uorb_bridge",
+				    SCHED_DEFAULT,
+				    SCHED_PRIORITY_DEFAULT,
+				    1800,
+				    &UorbBridge::task_main_trampoline,
+				    nullptr);
+
+	if (_main_task < 0) {
+		warn("task start failed");
+		return -errno;
+	}
+
+	return OK;
+}
+
+void
+UorbBridge::status()
+{
+	warnx("%s at %u baud, %u write errors", _device, _baudrate, _write_errors);
+
+	for (unsigned i = 0; i < topic_count; i++) {
+		warnx("%-24s %3uHz %8u frames %4u retries", topic_table[i].meta->o_name,
+		      topic_table[i].rate, _channels[i].frames, _channels[i].retries);
+	}
+}
+
+int
+UorbBridge::open_serial()
+{
+	speed_t speed;
+
+	switch (_baudrate) {
+	case 57600:	speed = B57600;		break;
+
+	case 115200:	speed = B115200;	break;
+
+	case 230400:	speed = B230400;	break;
+
+	case 460800:	speed = B460800;	break;
+
+	case 921600:	speed = B921600;	break;
+
+	default:
+		warnx("unsupported baudrate %u", _baudrate);
+		return -EINVAL;
+	}
+
+	_fd = open(_device, O_WRONLY | O_NOCTTY);
+
+	if (_fd < 0) {
+		warn("open %s", _device);
+		return -errno;
+	}
+
+	struct termios uart_config;
+	tcgetattr(_fd, &uart_config);
+
+	/* raw binary output */
+	uart_config.c_oflag &= ~OPOST;
+
+	if ((cfsetispeed(&uart_config, speed) < 0) || (cfsetospeed(&uart_config, speed) < 0) ||
+	    (tcsetattr(_fd, TCSANOW, &uart_config) < 0)) {
+		warnx("failed to configure %s", _device);
+		close(_fd);
+		_fd = -1;
+		return -EIO;
+	}
+
+	return OK;
+}
+
+void
+UorbBridge::send_frame(uint8_t topic, uint8_t seq, unsigned length)
+{
+	_frame[0] = BRIDGE_SYNC1;
+	_frame[1] = BRIDGE_SYNC2;
+	_frame[2] = topic;
+	_frame[3] = seq;
+	_frame[4] = length & 0xff;
+	_frame[5] = length >> 8;
+
+	uint32_t crc = crc32(&_frame[2], BRIDGE_HEADER_LEN - 2 + length);
+
+	for (unsigned i = 0; i < BRIDGE_CRC_LEN; i++)
+		_frame[BRIDGE_HEADER_LEN + length + i] = (crc >> (8 * i)) & 0xff;
+
+	ssize_t total = BRIDGE_HEADER_LEN + length + BRIDGE_CRC_LEN;
+
+	if (write(_fd, _frame, total) != total)
+		_write_errors++;
+}
+
+void
+UorbBridge::send_topic(unsigned index)
+{
+	const struct orb_metadata *meta = topic_table[index].meta;
+	channel &ch = _channels[index];
+	const void *data;
+	unsigned generation;
+
+	/* copy from the topic buffer, again if a publication raced with us */
+	for (unsigned attempt = 0; attempt < 3; attempt++) {
+		if (OK != orb_peek(meta, ch.reader, &data, &generation))
+			return;
+
+		memcpy(&_frame[BRIDGE_HEADER_LEN], data, meta->o_size);
+
+		if (orb_peek_valid(ch.reader, generation)) {
+			send_frame(index, ch.seq++, meta->o_size);
+			ch.frames++;
+			return;
+		}
+
+		ch.retries++;
+	}
+}
+
+void
+UorbBridge::send_descriptions()
+{
+	for (unsigned i = 0; i < topic_count; i++) {
+		const struct orb_metadata *meta = topic_table[i].meta;
+		uint8_t *payload = &_frame[BRIDGE_HEADER_LEN];
+		unsigned namelen = strnlen(meta->o_name, BRIDGE_NAME_MAX);
+
+		payload[0] = i;
+		payload[1] = meta->o_size & 0xff;
+		payload[2] = meta->o_size >> 8;
+		memcpy(&payload[3], meta->o_name, namelen);
+
+		send_frame(BRIDGE_DESCRIPTION, 0, 3 + namelen);
+	}
+}
+
+void
+UorbBridge::task_main()
+{
+	struct pollfd fds[topic_count];
+	unsigned max_size = 3 + BRIDGE_NAME_MAX;
+
+	if (OK != open_serial())
+		goto out;
+
+	for (unsigned i = 0; i < topic_count; i++) {
+		channel &ch = _channels[i];
+
+		ch.sub = orb_subscribe(topic_table[i].meta);
+		ch.reader = orb_reader(topic_table[i].meta, ch.sub);
+
+		/* the subscription interval is the rate limit */
+		orb_set_interval(ch.sub, 1000 / topic_table[i].rate);
+
+		fds[i].fd = ch.sub;
+		fds[i].events = POLLIN;
+
+		if (topic_table[i].meta->o_size > max_size)
+			max_size = topic_table[i].meta->o_size;
+	}
+
+	_frame = new uint8_t[BRIDGE_HEADER_LEN + max_size + BRIDGE_CRC_LEN];
+
+	if (_frame == nullptr) {
+		warnx("alloc failed");
+		goto out;
+	}
+
+	{
+		hrt_abstime last_description = 0;
+
+		while (!_task_should_exit) {
+
+			/* let the host (re-)learn the topic layout */
+			if (hrt_elapsed_time(&last_description) > 1000000) {
+				send_descriptions();
+				last_description = hrt_absolute_time();
+			}
+
+			int ret = poll(fds, topic_count, 100);
+
+			if (ret <= 0)
+				continue;
+
+			for (unsigned i = 0; i < topic_count; i++) {
+				if (fds[i].revents & POLLIN)
+					send_topic(i);
+			}
+		}
+	}
+
+out:
+
+	for (unsigned i = 0; i < topic_count; i++) {
+		if (_channels[i].sub >= 0)
+			orb_unsubscribe(_channels[i].sub);
+	}
+
+	if (_fd >= 0)
+		close(_fd);
+
+	delete[] _frame;
+	_frame = nullptr;
+
+	_main_task = -1;
+	_exit(0);
+}
+
+int
+UorbBridge::task_main_trampoline(int argc, char *argv[])
+{
+	uorb_bridge::g_bridge->task_main();
+	return 0;
+}
+
+static void usage()
+{
+	errx(1, "usage: uorb_bridge {start [-d <device>] [-b <baudrate>]|stop|status}");
+}
+
+int uorb_bridge_main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		usage();
+	}
+
+	if (!strcmp(argv[1], "start")) {
+
+		if (uorb_bridge::g_bridge != nullptr) {
+			errx(1, "already running");
+		}
+
+		const char *device = "/dev/ttyS2";
+		unsigned baudrate = 921600;
+
+		for (int i = 2; i < argc; i++) {
+			if (!strcmp(argv[i], "-d") && (i + 1 < argc)) {
+				device = argv[++i];
+
+			} else if (!strcmp(argv[i], "-b") && (i + 1 < argc)) {
+				baudrate = strtoul(argv[++i], nullptr, 10);
+
+			} else {
+				usage();
+			}
+		}
+
+		uorb_bridge::g_bridge = new UorbBridge(device, baudrate);
+
+		if (uorb_bridge::g_bridge == nullptr) {
+			errx(1, "alloc failed");
+		}
+
+		if (OK != uorb_bridge::g_bridge->start()) {
+			delete uorb_bridge::g_bridge;
+			uorb_bridge::g_bridge = nullptr;
+			err(1, "start failed");
+		}
+
+		return 0;
+	}
+
+	if (uorb_bridge::g_bridge == nullptr) {
+		errx(1, "not running");
+	}
+
+	if (!strcmp(argv[1], "stop")) {
+		delete uorb_bridge::g_bridge;
+		uorb_bridge::g_bridge = nullptr;
+
+	} else if (!strcmp(argv[1], "status")) {
+		uorb_bridge::g_bridge->status();
+
+	} else {
+		usage();
+	}
+
+	return 0;
+}
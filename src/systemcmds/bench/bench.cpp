@@ -0,0 +1,517 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file bench.cpp
+ *
+ * Timing benchmarks of the kernels on the hot path of the flight code.
+ *
+ * Every call is timed on its own with the DWT cycle counter. The minimum
+ * is the cost of the kernel without interference, the average includes
+ * interrupts and cache effects. The call overhead of the harness is
+ * measured first and subtracted, so the figures of different builds can
+ * be compared directly.
+ */
+
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <drivers/drv_hrt.h>
+#include <drivers/drv_accel.h>
+#include <drivers/device/ringbuffer.h>
+#include <mathlib/mathlib.h>
+#include <mathlib/math/filter/LowPassFilter2p.hpp>
+#include <systemlib/err.h>
+#include <systemlib/mixer/mixer.h>
+#include <lib/geo/geo.h>
+#include <uORB/uORB.h>
+#include <ekf_att_pos_estimator/estimator_23states.h>
+
+extern "C" {
+#include <sdlog2/logbuffer.h>
+}
+
+extern "C" __EXPORT int bench_main(int argc, char *argv[]);
+
+/* DWT cycle counter, see the ARMv7-M architecture reference manual */
+#define DEMCR			(*(volatile uint32_t *)0xe000edfc)
+#define DEMCR_TRCENA		(1 << 24)
+#define DWT_CTRL		(*(volatile uint32_t *)0xe0001000)
+#define DWT_CTRL_CYCCNTENA	(1 << 0)
+#define DWT_CYCCNT		(*(volatile uint32_t *)0xe0001004)
+
+/* keep the compiler from moving work across the cycle counter reads */
+#define BENCH_BARRIER()		__asm__ __volatile__("" ::: "memory")
+
+#define BENCH_ITERATIONS_DEFAULT	1000
+#define BENCH_LOGBUFFER_SIZE		4096
+
+struct bench_s {
+	const char	*name;
+	void		(*run)(void);
+	void		(*prepare)(void);	/**< untimed, before every run, may be NULL */
+};
+
+struct bench_result_s {
+	uint32_t	min;
+	uint32_t	max;
+	uint64_t	total;
+	hrt_abstime	elapsed;
+};
+
+struct bench_orb_s {
+	uint64_t	timestamp;
+	float		values[8];
+};
+
+ORB_DEFINE(bench, struct bench_orb_s);
+
+namespace
+{
+
+/* inputs and outputs of the kernels, at file scope so they cannot be optimised away */
+math::Matrix<3, 3>	mat_a;
+math::Matrix<3, 3>	mat_b;
+math::Matrix<3, 3>	mat_inv_src;
+math::Matrix<3, 3>	mat_r;
+math::Matrix<4, 4>	mat4_a;
+math::Matrix<4, 4>	mat4_b;
+math::Matrix<4, 4>	mat4_r;
+math::Matrix<6, 6>	mat6_spd;
+math::Vector<6>		vec6_b;
+math::Vector<6>		vec6_x;
+math::Matrix<10, 10>	mat10_a;
+math::Matrix<10, 10>	mat10_b;
+math::Matrix<10, 10>	mat10_r;
+math::Quaternion	quat_a;
+math::Quaternion	quat_b;
+math::Quaternion	quat_r;
+math::Vector<3>		vec_a(1.0f, -2.0f, 0.5f);
+math::Vector<3>		vec_r;
+
+/* covariance sized like the 23 state EKF */
+#define BENCH_COV_N	23
+float			cov_full[BENCH_COV_N][BENCH_COV_N];
+math::SymmetricMatrix<BENCH_COV_N>	cov_sym;
+math::Vector<BENCH_COV_N>	cov_h;
+math::Vector<BENCH_COV_N>	cov_ph;
+
+MultirotorMixer		*mixer;
+float			mixer_controls[4] = { 0.1f, -0.2f, 0.05f, 0.6f };
+float			mixer_outputs[4];
+
+math::LowPassFilter2p	lpf(1000.0f, 30.0f);
+float			lpf_sample;
+float			lpf_out;
+math::LowPassFilter2p	lpf_y(1000.0f, 30.0f);
+math::LowPassFilter2p	lpf_z(1000.0f, 30.0f);
+math::LowPassFilter2pN<3>	lpf3(1000.0f, 30.0f);
+float			lpf3_in[8 * 3];
+float			lpf3_out[8 * 3];
+
+AttPosEKF		*ekf;
+
+struct map_projection_reference_s map_ref;
+double			map_lat;
+double			map_lon;
+float			map_x;
+float			map_y;
+
+orb_advert_t		orb_pub = -1;
+int			orb_sub = -1;
+struct bench_orb_s	orb_data;
+
+RingBuffer		*ring;
+struct accel_report	ring_report;
+
+struct logbuffer_s	lb;
+uint8_t			lb_msg[64];
+
+int
+mixer_callback(uintptr_t handle, uint8_t control_group, uint8_t control_index, float &control)
+{
+	if (control_group != 0 || control_index >= sizeof(mixer_controls) / sizeof(mixer_controls[0]))
+		return -1;
+
+	control = mixer_controls[control_index];
+	return 0;
+}
+
+void bench_nop(void) {}
+
+void bench_matrix_mul(void) { mat_r = mat_a * mat_b; }
+void bench_matrix_inv(void) { mat_r = mat_inv_src.inversed(); }
+void bench_matrix6_inv_mul(void) { vec6_x = mat6_spd.inversed() * vec6_b; }
+void bench_matrix6_solve(void) { mat6_spd.solve(vec6_b, vec6_x); }
+/* the CMSIS inverse runs in place on its source */
+void bench_matrix_inv_prepare(void) { mat_inv_src = mat_a; }
+void bench_matrix_mul_cmsis(void)
+{
+	arm_matrix_instance_f32 a = mat_a.arm_mat(), b = mat_b.arm_mat(), r = mat_r.arm_mat();
+	arm_mat_mult_f32(&a, &b, &r);
+}
+void bench_matrix_inv_cmsis(void)
+{
+	arm_matrix_instance_f32 a = mat_inv_src.arm_mat(), r = mat_r.arm_mat();
+	arm_mat_inverse_f32(&a, &r);
+}
+void bench_matrix4_mul(void) { mat4_r = mat4_a * mat4_b; }
+void bench_matrix4_mul_cmsis(void)
+{
+	arm_matrix_instance_f32 a = mat4_a.arm_mat(), b = mat4_b.arm_mat(), r = mat4_r.arm_mat();
+	arm_mat_mult_f32(&a, &b, &r);
+}
+void bench_matrix10_mul(void) { mat10_r = mat10_a * mat10_b; }
+void bench_quat_mul(void) { quat_r = quat_a * quat_b; }
+void bench_quat_to_dcm(void) { mat_r = quat_a.to_dcm(); }
+void bench_quat_from_dcm(void) { quat_r.from_dcm(mat_a); }
+void bench_quat_rotate(void) { vec_r = quat_a.rotate(vec_a); }
+void bench_quat_dcm_rotate(void) { vec_r = quat_a.to_dcm() * vec_a; }
+void bench_quat_slerp(void) { quat_r = quat_a.slerp(quat_b, 0.3f); }
+void bench_cov_full_mult(void)
+{
+	for (unsigned i = 0; i < BENCH_COV_N; i++) {
+		float sum = 0.0f;
+
+		for (unsigned j = 0; j < BENCH_COV_N; j++)
+			sum += cov_full[i][j] * cov_h(j);
+
+		cov_ph(i) = sum;
+	}
+}
+void bench_cov_sym_mult(void) { cov_ph = cov_sym * cov_h; }
+void bench_cov_full_rank1(void)
+{
+	for (unsigned i = 0; i < BENCH_COV_N; i++)
+		for (unsigned j = 0; j < BENCH_COV_N; j++)
+			cov_full[i][j] -= 1e-6f * cov_ph(i) * cov_ph(j);
+}
+void bench_cov_sym_rank1(void) { cov_sym.rank1_update(cov_ph, -1e-6f); }
+void bench_mixer(void) { mixer->mix(mixer_outputs, 4); }
+void bench_lpf(void) { lpf_sample = -lpf_sample; lpf_out = lpf.apply(lpf_sample); }
+void bench_lpf_3x(void)
+{
+	lpf3_out[0] = lpf.apply(lpf3_in[0]);
+	lpf3_out[1] = lpf_y.apply(lpf3_in[1]);
+	lpf3_out[2] = lpf_z.apply(lpf3_in[2]);
+}
+void bench_lpf3(void) { lpf3.apply(lpf3_in, lpf3_out); }
+void bench_lpf3_block(void) { lpf3.apply(lpf3_in, lpf3_out, 8); }
+void bench_ekf_cov(void) { ekf->CovariancePrediction(0.01f); }
+void bench_map_project(void) { map_projection_project(&map_ref, map_lat, map_lon, &map_x, &map_y); }
+void bench_orb_publish(void) { orb_publish(ORB_ID(bench), orb_pub, &orb_data); }
+void bench_orb_copy(void) { orb_copy(ORB_ID(bench), orb_sub, &orb_data); }
+void bench_ring_put(void) { ring->put(&ring_report, sizeof(ring_report)); }
+void bench_ring_put_prepare(void) { ring->flush(); }
+void bench_ring_get(void) { ring->get(&ring_report, sizeof(ring_report)); }
+void bench_ring_get_prepare(void) { ring->put(&ring_report, sizeof(ring_report)); }
+void bench_logbuffer_write(void) { logbuffer_write(&lb, lb_msg, sizeof(lb_msg)); }
+void bench_logbuffer_prepare(void) { lb.read_ptr = lb.write_ptr; }
+
+const struct bench_s benches[] = {
+	{ "matrix3_mul",	bench_matrix_mul,	nullptr },
+	{ "matrix3_mul_cmsis",	bench_matrix_mul_cmsis,	nullptr },
+	{ "matrix3_inv",	bench_matrix_inv,	bench_matrix_inv_prepare },
+	{ "matrix3_inv_cmsis",	bench_matrix_inv_cmsis,	bench_matrix_inv_prepare },
+	{ "matrix6_inv_mul",	bench_matrix6_inv_mul,	nullptr },
+	{ "matrix6_solve",	bench_matrix6_solve,	nullptr },
+	{ "matrix4_mul",	bench_matrix4_mul,	nullptr },
+	{ "matrix4_mul_cmsis",	bench_matrix4_mul_cmsis, nullptr },
+	{ "matrix10_mul",	bench_matrix10_mul,	nullptr },
+	{ "quat_mul",		bench_quat_mul,		nullptr },
+	{ "quat_to_dcm",	bench_quat_to_dcm,	nullptr },
+	{ "quat_from_dcm",	bench_quat_from_dcm,	nullptr },
+	{ "quat_rotate",	bench_quat_rotate,	nullptr },
+	{ "quat_dcm_rotate",	bench_quat_dcm_rotate,	nullptr },
+	{ "quat_slerp",		bench_quat_slerp,	nullptr },
+	{ "cov23_full_mult",	bench_cov_full_mult,	nullptr },
+	{ "cov23_sym_mult",	bench_cov_sym_mult,	nullptr },
+	{ "cov23_full_rank1",	bench_cov_full_rank1,	nullptr },
+	{ "cov23_sym_rank1",	bench_cov_sym_rank1,	nullptr },
+	{ "mixer_quad_x",	bench_mixer,		nullptr },
+	{ "lpf2p_apply",	bench_lpf,		nullptr },
+	{ "lpf2p_apply_3x",	bench_lpf_3x,		nullptr },
+	{ "lpf2pN3_apply",	bench_lpf3,		nullptr },
+	{ "lpf2pN3_block8",	bench_lpf3_block,	nullptr },
+	{ "ekf_cov_predict",	bench_ekf_cov,		nullptr },
+	{ "map_project",	bench_map_project,	nullptr },
+	{ "orb_publish",	bench_orb_publish,	nullptr },
+	{ "orb_copy",		bench_orb_copy,		nullptr },
+	{ "ring_put",		bench_ring_put,		bench_ring_put_prepare },
+	{ "ring_get",		bench_ring_get,		bench_ring_get_prepare },
+	{ "logbuffer_write",	bench_logbuffer_write,	bench_logbuffer_prepare },
+};
+
+#define BENCH_COUNT	(sizeof(benches) / sizeof(benches[0]))
+
+int
+setup(void)
+{
+	mat_a.from_euler(0.1f, -0.2f, 0.3f);
+	mat_a(0, 0) += 0.5f;
+	mat_b.from_euler(-0.3f, 0.2f, 0.1f);
+
+	for (unsigned i = 0; i < 4; i++) {
+		for (unsigned j = 0; j < 4; j++) {
+			mat4_a(i, j) = 0.1f * i - 0.05f * j;
+			mat4_b(i, j) = 0.02f * i * j + 0.5f;
+		}
+	}
+
+	/* symmetric positive definite, like an innovation covariance */
+	for (unsigned i = 0; i < 6; i++) {
+		for (unsigned j = 0; j < 6; j++)
+			mat6_spd(i, j) = 1.0f / (1.0f + i + j) + ((i == j) ? 1.0f : 0.0f);
+
+		vec6_b(i) = 0.5f * i - 1.0f;
+	}
+
+	for (unsigned i = 0; i < 10; i++) {
+		for (unsigned j = 0; j < 10; j++) {
+			mat10_a(i, j) = 0.1f * i - 0.05f * j;
+			mat10_b(i, j) = 0.02f * i * j;
+		}
+	}
+
+	quat_a.from_euler(0.1f, -0.2f, 0.3f);
+	quat_b.from_euler(-0.3f, 0.2f, 0.1f);
+
+	mixer = new MultirotorMixer(mixer_callback, 0, MultirotorMixer::QUAD_X, 1.0f, 1.0f, 1.0f, 0.0f);
+
+	lpf_sample = 1.0f;
+
+	for (unsigned i = 0; i < BENCH_COV_N; i++) {
+		for (unsigned j = 0; j < BENCH_COV_N; j++)
+			cov_full[i][j] = (i == j) ? 1.0f : 0.01f;
+
+		cov_h(i) = (i < 4) ? 0.5f : 0.0f;
+	}
+
+	cov_sym.set(cov_full);
+
+	for (unsigned i = 0; i < sizeof(lpf3_in) / sizeof(lpf3_in[0]); i++)
+		lpf3_in[i] = (i & 1) ? 1.0f : -1.0f;
+
+	ekf = new AttPosEKF();
+
+	map_projection_init(&map_ref, 47.3977, 8.5456);
+	map_lat = 47.3980;
+	map_lon = 8.5460;
+
+	orb_pub = orb_advertise(ORB_ID(bench), &orb_data);
+	orb_sub = orb_subscribe(ORB_ID(bench));
+
+	ring = new RingBuffer(8, sizeof(ring_report));
+
+	for (unsigned i = 0; i < sizeof(lb_msg); i++)
+		lb_msg[i] = i;
+
+	if (mixer == nullptr || ekf == nullptr || ring == nullptr ||
+	    orb_pub <= 0 || orb_sub < 0 || logbuffer_init(&lb, BENCH_LOGBUFFER_SIZE) != 0) {
+		return -1;
+	}
+
+	float vel[3] = { 0.0f, 0.0f, 0.0f };
+	ekf->InitialiseFilter(vel, 0.0, 0.0, 0.0f, 0.0f);
+
+	return 0;
+}
+
+void
+teardown(void)
+{
+	delete mixer;
+	mixer = nullptr;
+	delete ekf;
+	ekf = nullptr;
+	delete ring;
+	ring = nullptr;
+
+	if (orb_sub >= 0) {
+		close(orb_sub);
+		orb_sub = -1;
+	}
+
+	/* the advertised topic stays, publishing to it again later is fine */
+	if (orb_pub > 0) {
+		close(orb_pub);
+		orb_pub = -1;
+	}
+
+	free(lb.data);
+	lb.data = nullptr;
+}
+
+void
+run(const struct bench_s *bench, unsigned iterations, struct bench_result_s *result)
+{
+	result->min = UINT32_MAX;
+	result->max = 0;
+	result->total = 0;
+	result->elapsed = 0;
+
+	for (unsigned i = 0; i < iterations; i++) {
+		if (bench->prepare != nullptr)
+			bench->prepare();
+
+		BENCH_BARRIER();
+		hrt_abstime start = hrt_absolute_time();
+		uint32_t cycles = DWT_CYCCNT;
+		BENCH_BARRIER();
+
+		bench->run();
+
+		BENCH_BARRIER();
+		cycles = DWT_CYCCNT - cycles;
+		result->elapsed += hrt_absolute_time() - start;
+		BENCH_BARRIER();
+
+		if (cycles < result->min)
+			result->min = cycles;
+
+		if (cycles > result->max)
+			result->max = cycles;
+
+		result->total += cycles;
+	}
+}
+
+bool
+selected(const char *name, int argc, char *argv[])
+{
+	if (argc == 0)
+		return true;
+
+	for (int i = 0; i < argc; i++) {
+		if (strcmp(argv[i], name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+void
+usage()
+{
+	warnx("usage: bench [-n <iterations>] [<name> ...]");
+
+	for (unsigned i = 0; i < BENCH_COUNT; i++)
+		warnx("  %s", benches[i].name);
+}
+
+} // namespace
+
+int
+bench_main(int argc, char *argv[])
+{
+	unsigned iterations = BENCH_ITERATIONS_DEFAULT;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "n:h")) != EOF) {
+		switch (ch) {
+		case 'n':
+			iterations = strtoul(optarg, nullptr, 0);
+			break;
+
+		default:
+			usage();
+			return 1;
+		}
+	}
+
+	argc -= optind;
+	argv += optind;
+
+	if (iterations == 0) {
+		usage();
+		return 1;
+	}
+
+	for (int i = 0; i < argc; i++) {
+		bool known = false;
+
+		for (unsigned j = 0; j < BENCH_COUNT; j++)
+			known = known || (strcmp(argv[i], benches[j].name) == 0);
+
+		if (!known) {
+			warnx("unknown benchmark: %s", argv[i]);
+			usage();
+			return 1;
+		}
+	}
+
+	/* enable the cycle counter */
+	DEMCR |= DEMCR_TRCENA;
+	DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+	if (setup() != 0) {
+		warnx("setup failed");
+		teardown();
+		return 1;
+	}
+
+	/* cost of reading the counters around an empty call */
+	const struct bench_s nop = { "nop", bench_nop, nullptr };
+	struct bench_result_s result;
+	run(&nop, iterations, &result);
+	uint32_t overhead = result.min;
+	hrt_abstime overhead_us = result.elapsed;
+
+	printf("%u iterations, overhead %u cycles subtracted\n", iterations, overhead);
+	printf("%-18s %10s %10s %10s %10s\n", "name", "min cyc", "avg cyc", "max cyc", "avg us");
+
+	for (unsigned i = 0; i < BENCH_COUNT; i++) {
+		if (!selected(benches[i].name, argc, argv))
+			continue;
+
+		run(&benches[i], iterations, &result);
+
+		uint32_t avg = result.total / iterations;
+		hrt_abstime elapsed = (result.elapsed > overhead_us) ? result.elapsed - overhead_us : 0;
+
+		printf("%-18s %10u %10u %10u %10.2f\n",
+		       benches[i].name,
+		       (result.min > overhead) ? result.min - overhead : 0,
+		       (avg > overhead) ? avg - overhead : 0,
+		       (result.max > overhead) ? result.max - overhead : 0,
+		       (double)elapsed / iterations);
+	}
+
+	teardown();
+	return 0;
+}
@@ -84,6 +84,7 @@ usage(const char *reason)
 
 	fprintf(stderr, "usage:\n");
 	fprintf(stderr, "  mixer load <device> <filename>\n");
+	fprintf(stderr, "    loads <filename>.bin instead if it exists and the device takes it\n");
 	/* XXX other useful commands? */
 	exit(1);
 }
@@ -102,6 +103,32 @@ load(const char *devname, const char *fname)
 	if (ioctl(dev, MIXERIOCRESET, 0))
 		err(1, "can't reset mixers on %s", devname);
 
+	/* prefer the binary description generated alongside the text, it needs no parsing */
+	char		binname[64];
+	snprintf(binname, sizeof(binname), "%s.bin", fname);
+
+	/* read the records in place when they are in the ROMFS, copy them otherwise */
+	const void	*records = &buf[0];
+	int binlen = map_mixer_bin_file(binname, &records);
+
+	if (binlen <= 0) {
+		records = &buf[0];
+		binlen = load_mixer_bin_file(binname, &buf[0], sizeof(buf));
+	}
+
+	if (binlen > 0) {
+		mixer_bin_buf_s bin = { records, (unsigned)binlen };
+
+		if (ioctl(dev, MIXERIOCLOADBIN, (unsigned long)&bin) == 0)
+			exit(0);
+
+		/* fall back to the text, older firmware on IO does not know the binary records */
+		warnx("binary mixer %s not taken, loading text", binname);
+
+		if (ioctl(dev, MIXERIOCRESET, 0))
+			err(1, "can't reset mixers on %s", devname);
+	}
+
 	if (load_mixer_file(fname, &buf[0], sizeof(buf)) < 0)
 		err(1, "can't load mixer: %s", fname);
 
@@ -37,21 +37,203 @@
 
 
 #include <nuttx/config.h>
+#include <nuttx/clock.h>
+#include <nuttx/wqueue.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
+#include <drivers/drv_hrt.h>
+#include <uORB/uORB.h>
+#include <uORB/topics/perf_report.h>
+
 #include "systemlib/perf_counter.h"
+#include "systemlib/work_profile.h"
+#include "systemlib/mem_pool.h"
 
 
 /****************************************************************************
  * Definitions
  ****************************************************************************/
 
+/** time between two perf_report publications */
+#define PERF_PUBLISH_INTERVAL		250000
+
+/** name patterns that can be selected at once */
+#define PERF_PUBLISH_PATTERNS		4
+#define PERF_PUBLISH_PATTERN_LEN	24
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
+static struct work_s		publish_work;
+static volatile bool		publish_running;
+static char			publish_patterns[PERF_PUBLISH_PATTERNS][PERF_PUBLISH_PATTERN_LEN];
+static unsigned			publish_pattern_count;
+static unsigned			publish_next;
+static orb_advert_t		publish_pub = -1;
+static struct perf_report_s	publish_report;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/**
+ * Match a counter name against a pattern, '*' matches any run of
+ * characters and '?' any single one.
+ */
+static bool
+perf_match(const char *pattern, const char *name)
+{
+	for (;;) {
+		switch (*pattern) {
+		case '\0':
+			return *name == '\0';
+
+		case '*':
+			do {
+				if (perf_match(pattern + 1, name))
+					return true;
+			} while (*name++ != '\0');
+
+			return false;
+
+		case '?':
+			if (*name == '\0')
+				return false;
+
+			break;
+
+		default:
+			if (*pattern != *name)
+				return false;
+
+			break;
+		}
+
+		pattern++;
+		name++;
+	}
+}
+
+static bool
+perf_selected(const char *name)
+{
+	for (unsigned i = 0; i < publish_pattern_count; i++) {
+		if (perf_match(publish_patterns[i], name))
+			return true;
+	}
+
+	return false;
+}
+
+static uint32_t
+perf_clamp(uint64_t value)
+{
+	return (value > UINT32_MAX) ? UINT32_MAX : (uint32_t)value;
+}
+
+/**
+ * Publish the next batch of selected counters and reschedule.
+ */
+static void
+perf_publish_cycle(void *arg)
+{
+	struct perf_report_s *report = &publish_report;
+	unsigned index = 0;
+
+	memset(report, 0, sizeof(*report));
+
+	for (perf_counter_t handle = perf_next(NULL); handle != NULL; handle = perf_next(handle)) {
+		if (!perf_selected(perf_name(handle)))
+			continue;
+
+		if ((index >= publish_next) && (report->count < PERF_REPORT_MAX)) {
+			struct perf_report_counter_s *counter = &report->counters[report->count++];
+			struct perf_summary_s summary;
+
+			perf_summary(handle, &summary);
+			strncpy(counter->name, perf_name(handle), sizeof(counter->name));
+			counter->type = perf_type(handle);
+			counter->count = perf_clamp(summary.event_count);
+			counter->avg = perf_clamp(summary.time_avg);
+			counter->min = perf_clamp(summary.time_least);
+			counter->max = perf_clamp(summary.time_most);
+			counter->p99 = perf_clamp(summary.time_p99);
+		}
+
+		index++;
+	}
+
+	report->first = publish_next;
+	report->total = (index > UINT8_MAX) ? UINT8_MAX : index;
+
+	/* carry on with the counters that did not fit, or start over */
+	publish_next += report->count;
+
+	if (publish_next >= index)
+		publish_next = 0;
+
+	if (report->count > 0) {
+		report->timestamp = hrt_absolute_time();
+
+		if (publish_pub > 0) {
+			orb_publish(ORB_ID(perf_report), publish_pub, report);
+
+		} else {
+			publish_pub = orb_advertise(ORB_ID(perf_report), report);
+		}
+	}
+
+	if (publish_running)
+		work_queue_profiled(LPWORK, &publish_work, perf_publish_cycle, NULL, USEC2TICK(PERF_PUBLISH_INTERVAL),
+				    "perf publish");
+}
+
+static int
+perf_publish(int argc, char *argv[])
+{
+	if ((argc > 0) && (strcmp(argv[0], "stop") == 0)) {
+		if (publish_running) {
+			publish_running = false;
+			work_cancel(LPWORK, &publish_work);
+		}
+
+		return 0;
+	}
+
+	if (publish_running) {
+		printf("perf: already publishing, stop first\n");
+		return -1;
+	}
+
+	if (argc > PERF_PUBLISH_PATTERNS) {
+		printf("perf: at most %d patterns\n", PERF_PUBLISH_PATTERNS);
+		return -1;
+	}
+
+	publish_pattern_count = 0;
+
+	if (argc == 0) {
+		strcpy(publish_patterns[publish_pattern_count++], "*");
+	}
+
+	for (int i = 0; i < argc; i++) {
+		strncpy(publish_patterns[publish_pattern_count], argv[i], PERF_PUBLISH_PATTERN_LEN - 1);
+		publish_patterns[publish_pattern_count][PERF_PUBLISH_PATTERN_LEN - 1] = '\0';
+		publish_pattern_count++;
+	}
+
+	publish_next = 0;
+	publish_running = true;
+	memset(&publish_work, 0, sizeof(publish_work));
+	work_queue_profiled(LPWORK, &publish_work, perf_publish_cycle, NULL, 0, "perf publish");
+	return 0;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -69,11 +251,16 @@ int perf_main(int argc, char *argv[])
 			perf_reset_all();
 			return 0;
 		}
-		printf("Usage: perf <reset>\n");
+
+		if (strcmp(argv[1], "publish") == 0)
+			return perf_publish(argc - 2, argv + 2);
+
+		printf("Usage: perf [reset | publish [<pattern> ...] | publish stop]\n");
 		return -1;
 	}
 
 	perf_print_all(0 /* stdout */);
+	mem_pool_print_all(0 /* stdout */);
 	fflush(stdout);
 	return 0;
 }
@@ -72,7 +72,7 @@ usage(const char *reason)
 		warnx("%s", reason);
 	errx(1,
 		"usage:\n"
-		"pwm arm|disarm|rate|failsafe|disarmed|min|max|test|info  ...\n"
+		"pwm arm|disarm|rate|schedule|rpm|failsafe|disarmed|min|max|test|info  ...\n"
 		"\n"
 		"  arm                      Arm output\n"
 		"  disarm                   Disarm output\n"
@@ -81,7 +81,19 @@ usage(const char *reason)
 		"    [-g <channel group>]   Channel group that should update at the alternate rate\n"
 		"    [-m <chanmask> ]       Directly supply channel mask\n"
 		"    [-a]                   Configure all outputs\n"
-		"    -r <alt_rate>          PWM rate (50 to 400 Hz)\n"
+		"    -r <alt_rate>          PWM rate (50 to 400 Hz, 0 for OneShot125 on FMU outputs,\n"
+		"                           150000, 300000 or 600000 for DShot on FMU outputs with DMA)\n"
+		"\n"
+		"  schedule ...             Send outputs at a fixed rate (FMU only)\n"
+		"    -r <rate>              Output rate (50 to 2000 Hz, 0 to send on every control update)\n"
+		"    [-x]                   Extrapolate the attitude controls to the output time\n"
+		"\n"
+		"  rpm ...                  Close a speed loop on motor outputs from ESC telemetry (FMU, UAVCAN)\n"
+		"    [-c <channels>]        Motor channels (e.g. 1234), none to switch the loop off\n"
+		"    [-m <chanmask> ]       Directly supply channel mask (e.g. 0xF)\n"
+		"    -r <rpm>               Motor speed at full throttle\n"
+		"    [-P <gain>]            Proportional gain (default 0.5)\n"
+		"    [-I <gain>]            Integral gain (default 2.0)\n"
 		"\n"
 		"  failsafe ...      	    Configure failsafe PWM values\n"
 		"  disarmed ...      	    Configure disarmed PWM values\n"
@@ -111,9 +123,13 @@ pwm_main(int argc, char *argv[])
 {
 	const char *dev = PWM_OUTPUT_DEVICE_PATH;
 	unsigned alt_rate = 0;
+	bool alt_rate_set = false;
 	uint32_t alt_channel_groups = 0;
 	bool alt_channels_set = false;
 	bool print_verbose = false;
+	bool extrapolate = false;
+	float rpm_p = 0.5f;
+	float rpm_i = 2.0f;
 	int ch;
 	int ret;
 	char *ep;
@@ -126,7 +142,7 @@ pwm_main(int argc, char *argv[])
 	if (argc < 1)
 		usage(NULL);
 
-	while ((ch = getopt(argc-1, &argv[1], "d:vc:g:m:ap:r:")) != EOF) {
+	while ((ch = getopt(argc-1, &argv[1], "d:vc:g:m:ap:r:xP:I:")) != EOF) {
 		switch (ch) {
 
 		case 'd':
@@ -182,6 +198,20 @@ pwm_main(int argc, char *argv[])
 			alt_rate = strtoul(optarg, &ep, 0);
 			if (*ep != '\0')
 				usage("bad alternative rate provided");
+			alt_rate_set = true;
+			break;
+		case 'x':
+			extrapolate = true;
+			break;
+		case 'P':
+			rpm_p = strtod(optarg, &ep);
+			if (*ep != '\0')
+				usage("bad proportional gain provided");
+			break;
+		case 'I':
+			rpm_i = strtod(optarg, &ep);
+			if (*ep != '\0')
+				usage("bad integral gain provided");
 			break;
 		default:
 			break;
@@ -235,8 +265,8 @@ pwm_main(int argc, char *argv[])
 
 	} else if (!strcmp(argv[1], "rate")) {
 
-		/* change alternate PWM rate */
-		if (alt_rate > 0) {
+		/* change alternate PWM rate, 0 is PWM_RATE_ONESHOT */
+		if (alt_rate_set) {
 			ret = ioctl(fd, PWM_SERVO_SET_UPDATE_RATE, alt_rate);
 			if (ret != OK)
 				err(1, "PWM_SERVO_SET_UPDATE_RATE (check rate for sanity)");
@@ -271,6 +301,39 @@ pwm_main(int argc, char *argv[])
 		}
 		exit(0);
 
+	} else if (!strcmp(argv[1], "schedule")) {
+
+		if (!alt_rate_set)
+			usage("no output rate provided");
+
+		ret = ioctl(fd, PWM_SERVO_SET_EXTRAPOLATION, extrapolate);
+		if (ret != OK)
+			err(1, "PWM_SERVO_SET_EXTRAPOLATION");
+
+		ret = ioctl(fd, PWM_SERVO_SET_OUTPUT_RATE, alt_rate);
+		if (ret != OK)
+			err(1, "PWM_SERVO_SET_OUTPUT_RATE (check rate for sanity)");
+
+		exit(0);
+
+	} else if (!strcmp(argv[1], "rpm")) {
+
+		if ((set_mask != 0) && !alt_rate_set)
+			usage("no motor speed provided");
+
+		struct pwm_rpm_control rpm_control = {
+			.motors = set_mask,
+			.rpm_max = (float)alt_rate,
+			.p = rpm_p,
+			.i = rpm_i
+		};
+
+		ret = ioctl(fd, PWM_SERVO_SET_RPM_CONTROL, (unsigned long)&rpm_control);
+		if (ret != OK)
+			err(1, "PWM_SERVO_SET_RPM_CONTROL");
+
+		exit(0);
+
 	} else if (!strcmp(argv[1], "min")) {
 
 		if (set_mask == 0) {
@@ -605,10 +668,14 @@ pwm_main(int argc, char *argv[])
 			if (ret == OK) {
 				printf("channel %u: %u us", i+1, spos);
 
-				if (info_alt_rate_mask & (1<<i))
-					printf(" (alternative rate: %d Hz", info_alt_rate);
+				unsigned rate = (info_alt_rate_mask & (1<<i)) ? info_alt_rate : info_default_rate;
+
+				if (rate == PWM_RATE_ONESHOT)
+					printf(" (%s rate: OneShot", (info_alt_rate_mask & (1<<i)) ? "alternative" : "default");
+				else if (PWM_RATE_IS_DSHOT(rate))
+					printf(" (%s rate: DShot%u", (info_alt_rate_mask & (1<<i)) ? "alternative" : "default", rate / 1000);
 				else
-					printf(" (default rate: %d Hz", info_default_rate);
+					printf(" (%s rate: %u Hz", (info_alt_rate_mask & (1<<i)) ? "alternative" : "default", rate);
 
 
 				printf(" failsafe: %d, disarmed: %d us, min: %d us, max: %d us)",
@@ -0,0 +1,184 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file schedtrace.c
+ *
+ * Control the scheduler trace of cpuload and dump it to a file, to be
+ * converted for a timeline viewer by Tools/sched_trace_to_json.py.
+ *
+ * File format, little endian: the header, then a struct
+ * schedtrace_task for each task known at dump time, then the events
+ * as struct sched_trace_event_s, oldest first.
+ */
+
+#include <nuttx/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <systemlib/err.h>
+#include <systemlib/cpuload.h>
+
+#define SCHEDTRACE_DEFAULT_EVENTS	1000
+#define SCHEDTRACE_DEFAULT_FILE		"/fs/microsd/sched.trc"
+#define SCHEDTRACE_MAGIC		"PXST"
+#define SCHEDTRACE_VERSION		1
+#define SCHEDTRACE_NAME_LEN		24
+
+struct schedtrace_header {
+	char magic[4];
+	uint16_t version;
+	uint16_t task_count;
+	uint32_t event_count;
+	uint32_t event_size;
+};
+
+struct schedtrace_task {
+	int16_t pid;
+	char name[SCHEDTRACE_NAME_LEN];
+};
+
+__EXPORT int schedtrace_main(int argc, char *argv[]);
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION
+
+static unsigned
+schedtrace_count(void)
+{
+	return sched_trace.wrapped ? sched_trace.size : sched_trace.next;
+}
+
+static void
+schedtrace_dump(const char *path)
+{
+	/* the ring must not move while it is written out */
+	sched_trace_stop();
+
+	FILE *f = fopen(path, "w");
+
+	if (f == NULL)
+		err(1, "%s", path);
+
+	struct schedtrace_header header;
+	memcpy(header.magic, SCHEDTRACE_MAGIC, sizeof(header.magic));
+	header.version = SCHEDTRACE_VERSION;
+	header.task_count = 0;
+	header.event_count = schedtrace_count();
+	header.event_size = sizeof(struct sched_trace_event_s);
+
+	for (int i = 0; i < CONFIG_MAX_TASKS; i++) {
+		if (system_load.tasks[i].valid)
+			header.task_count++;
+	}
+
+	fwrite(&header, sizeof(header), 1, f);
+
+	for (int i = 0; i < CONFIG_MAX_TASKS; i++) {
+		if (!system_load.tasks[i].valid)
+			continue;
+
+		struct schedtrace_task task;
+		memset(&task, 0, sizeof(task));
+		task.pid = system_load.tasks[i].tcb->pid;
+#if CONFIG_TASK_NAME_SIZE > 0
+		strncpy(task.name, system_load.tasks[i].tcb->name, sizeof(task.name) - 1);
+#endif
+		fwrite(&task, sizeof(task), 1, f);
+	}
+
+	/* oldest first: after a wrap the oldest event is the one to be overwritten next */
+	if (sched_trace.wrapped)
+		fwrite(&sched_trace.events[sched_trace.next], sizeof(struct sched_trace_event_s),
+		       sched_trace.size - sched_trace.next, f);
+
+	fwrite(&sched_trace.events[0], sizeof(struct sched_trace_event_s), sched_trace.next, f);
+
+	if (fclose(f) != 0)
+		err(1, "%s", path);
+
+	printf("wrote %u events to %s\n", (unsigned)header.event_count, path);
+}
+
+int
+schedtrace_main(int argc, char *argv[])
+{
+	if (argc < 2)
+		errx(1, "usage: schedtrace {start [events]|stop|status|dump [file]}");
+
+	if (!strcmp(argv[1], "start")) {
+		unsigned events = (argc > 2) ? strtoul(argv[2], NULL, 0) : SCHEDTRACE_DEFAULT_EVENTS;
+
+		if (events == 0)
+			errx(1, "need at least one event");
+
+		if (sched_trace_start(events) != OK)
+			errx(1, "no memory for %u events", events);
+
+		exit(0);
+	}
+
+	if (!strcmp(argv[1], "stop")) {
+		sched_trace_stop();
+		exit(0);
+	}
+
+	if (!strcmp(argv[1], "status")) {
+		printf("%s, %u of %u events%s\n",
+		       sched_trace.enabled ? "tracing" : "stopped",
+		       schedtrace_count(), sched_trace.size,
+		       sched_trace.wrapped ? ", wrapped" : "");
+		exit(0);
+	}
+
+	if (!strcmp(argv[1], "dump")) {
+		if (sched_trace.events == NULL)
+			errx(1, "no trace, use schedtrace start");
+
+		schedtrace_dump((argc > 2) ? argv[2] : SCHEDTRACE_DEFAULT_FILE);
+		exit(0);
+	}
+
+	errx(1, "unrecognized command, try 'start', 'stop', 'status' or 'dump'");
+}
+
+#else
+
+int
+schedtrace_main(int argc, char *argv[])
+{
+	errx(1, "needs CONFIG_SCHED_INSTRUMENTATION");
+}
+
+#endif /* CONFIG_SCHED_INSTRUMENTATION */
@@ -0,0 +1,460 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file sysperf.c
+ *
+ * Snapshot of CPU, memory, uORB, logger and mavlink resource use, taken
+ * in a single pass so the numbers belong together.
+ *
+ * 'sysperf' prints one snapshot over a second, 'sysperf start' publishes
+ * system_resources periodically from the low priority work queue.
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/clock.h>
+#include <nuttx/sched.h>
+#include <nuttx/wqueue.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <drivers/drv_hrt.h>
+#include <uORB/uORB.h>
+#include <uORB/topics/system_resources.h>
+#include <uORB/topics/telemetry_status.h>
+
+#include <systemlib/cpuload.h>
+#include <systemlib/perf_counter.h>
+#include <systemlib/work_profile.h>
+
+/** time between two system_resources publications by default, ms */
+#define SYSPERF_PUBLISH_INTERVAL	1000
+
+/** length of the snapshot printed by the command, us */
+#define SYSPERF_PRINT_INTERVAL		1000000
+
+/** telemetry_status older than this is from a mavlink instance that has stopped */
+#define SYSPERF_LINK_TIMEOUT		3000000
+
+/** counters sdlog2 keeps for us */
+#define SYSPERF_LOG_WRITTEN		"sdlog2_written"
+#define SYSPERF_LOG_DROPPED		"sdlog2_dropped"
+
+#define SYSPERF_LINKS	((SYSTEM_RESOURCES_MAX_LINKS < TELEMETRY_STATUS_ORB_ID_NUM) ? \
+			 SYSTEM_RESOURCES_MAX_LINKS : TELEMETRY_STATUS_ORB_ID_NUM)
+
+/**
+ * What a snapshot is compared against to get rates and loads.
+ */
+struct sysperf_state_s {
+	hrt_abstime	time;				/**< time of the last snapshot, 0 before the first */
+	uint64_t	runtime[CONFIG_MAX_TASKS];	/**< total_runtime of each load slot */
+	FAR struct tcb_s *tcb[CONFIG_MAX_TASKS];	/**< task in each load slot, to notice reuse */
+	unsigned	orb_publications;
+	unsigned	orb_lost;
+	uint64_t	log_written;
+	uint64_t	log_dropped;
+	int		link_sub[SYSPERF_LINKS];
+};
+
+__EXPORT int sysperf_main(int argc, char *argv[]);
+
+static struct work_s			publish_work;
+static volatile bool			publish_running;	/**< publishing has been asked for */
+static volatile bool			publish_active;		/**< the work item is still scheduled */
+static unsigned				publish_interval;
+static orb_advert_t			publish_pub = -1;
+static struct sysperf_state_s		publish_state;
+static struct system_resources_s	publish_report;
+
+static void
+sysperf_open(struct sysperf_state_s *state)
+{
+	memset(state, 0, sizeof(*state));
+
+	for (unsigned i = 0; i < SYSPERF_LINKS; i++)
+		state->link_sub[i] = orb_subscribe(telemetry_status_orb_id[i]);
+}
+
+static void
+sysperf_close(struct sysperf_state_s *state)
+{
+	for (unsigned i = 0; i < SYSPERF_LINKS; i++) {
+		if (state->link_sub[i] >= 0)
+			orb_unsubscribe(state->link_sub[i]);
+
+		state->link_sub[i] = -1;
+	}
+}
+
+/**
+ * Change of a counter since the last snapshot, a counter that went
+ * backwards has been reset in between.
+ */
+static uint64_t
+sysperf_delta(uint64_t now, uint64_t *last)
+{
+	uint64_t delta = (now >= *last) ? now - *last : now;
+
+	*last = now;
+	return delta;
+}
+
+static float
+sysperf_rate(uint64_t delta, uint32_t interval)
+{
+	return (interval > 0) ? delta * 1e6f / interval : 0.0f;
+}
+
+static void
+sysperf_tasks(struct sysperf_state_s *state, struct system_resources_s *res, bool first)
+{
+	uint64_t idle = 0;
+	bool idle_valid = false;
+
+	res->task_count = 0;
+
+	/* tasks may come and go while we look at them */
+	sched_lock();
+
+	for (int i = 0; i < CONFIG_MAX_TASKS; i++) {
+		if (!system_load.tasks[i].valid) {
+			state->tcb[i] = NULL;
+			continue;
+		}
+
+		FAR struct tcb_s *tcb = system_load.tasks[i].tcb;
+		uint64_t runtime = system_load.tasks[i].total_runtime;
+
+		/* a task new in its slot has no runtime to compare against yet */
+		uint64_t delta = (!first && state->tcb[i] == tcb && runtime > state->runtime[i]) ?
+				 runtime - state->runtime[i] : 0;
+		uint32_t load = (res->interval > 0) ? (delta * 1000) / res->interval : 0;
+
+		state->tcb[i] = tcb;
+		state->runtime[i] = runtime;
+
+		if (load > 1000)
+			load = 1000;
+
+		if (tcb->pid == 0) {
+			idle = load;
+			idle_valid = !first;
+		}
+
+		if (res->task_count < SYSTEM_RESOURCES_MAX_TASKS) {
+			struct system_resources_task_s *task = &res->tasks[res->task_count++];
+			unsigned stack_size;
+			unsigned stack_used = cpuload_stack_used(tcb, &stack_size);
+
+			task->pid = tcb->pid;
+			task->load = load;
+			task->stack_free = stack_size - stack_used;
+			memset(task->name, 0, sizeof(task->name));
+#if CONFIG_TASK_NAME_SIZE > 0
+			strncpy(task->name, tcb->name, sizeof(task->name) - 1);
+#endif
+		}
+	}
+
+	sched_unlock();
+
+	res->load = idle_valid ? 1000 - idle : 0;
+}
+
+/**
+ * Walk the counters once: keep the histograms with the highest p99 and
+ * pick up the logger counts on the way.
+ */
+static void
+sysperf_counters(struct sysperf_state_s *state, struct system_resources_s *res)
+{
+	uint64_t log_written = 0;
+	uint64_t log_dropped = 0;
+
+	res->perf_count = 0;
+
+	for (perf_counter_t handle = perf_next(NULL); handle != NULL; handle = perf_next(handle)) {
+		const char *name = perf_name(handle);
+
+		switch (perf_type(handle)) {
+		case PC_COUNT:
+			if (strcmp(name, SYSPERF_LOG_WRITTEN) == 0) {
+				log_written = perf_event_count(handle);
+
+			} else if (strcmp(name, SYSPERF_LOG_DROPPED) == 0) {
+				log_dropped = perf_event_count(handle);
+			}
+
+			break;
+
+		case PC_HISTOGRAM: {
+				struct perf_summary_s summary;
+				perf_summary(handle, &summary);
+
+				uint32_t p99 = (summary.time_p99 > UINT32_MAX) ? UINT32_MAX : summary.time_p99;
+				unsigned n = res->perf_count;
+
+				/* insert sorted by p99, dropping the lowest once full */
+				while (n > 0 && res->perf[n - 1].p99 < p99) {
+					if (n < SYSTEM_RESOURCES_MAX_PERF)
+						res->perf[n] = res->perf[n - 1];
+
+					n--;
+				}
+
+				if (n >= SYSTEM_RESOURCES_MAX_PERF)
+					break;
+
+				if (res->perf_count < SYSTEM_RESOURCES_MAX_PERF)
+					res->perf_count++;
+
+				struct system_resources_perf_s *perf = &res->perf[n];
+				strncpy(perf->name, name, sizeof(perf->name));
+				perf->count = (summary.event_count > UINT32_MAX) ? UINT32_MAX : summary.event_count;
+				perf->avg = (summary.time_avg > UINT32_MAX) ? UINT32_MAX : summary.time_avg;
+				perf->max = (summary.time_most > UINT32_MAX) ? UINT32_MAX : summary.time_most;
+				perf->p99 = p99;
+				break;
+			}
+
+		default:
+			break;
+		}
+	}
+
+	res->log_rate = sysperf_rate(sysperf_delta(log_written, &state->log_written), res->interval);
+	res->log_drop_rate = sysperf_rate(sysperf_delta(log_dropped, &state->log_dropped), res->interval);
+}
+
+static void
+sysperf_links(struct sysperf_state_s *state, struct system_resources_s *res)
+{
+	res->link_count = 0;
+
+	for (unsigned i = 0; i < SYSPERF_LINKS; i++) {
+		struct telemetry_status_s status;
+		uint64_t updated;
+
+		if (state->link_sub[i] < 0 ||
+		    orb_stat(state->link_sub[i], &updated) != OK ||
+		    updated == 0 || hrt_elapsed_time(&updated) > SYSPERF_LINK_TIMEOUT ||
+		    orb_copy(telemetry_status_orb_id[i], state->link_sub[i], &status) != OK)
+			continue;
+
+		struct system_resources_link_s *link = &res->links[res->link_count++];
+		link->tx_budget = status.tx_budget;
+		link->rate_tx = status.rate_tx * 1000.0f;
+		link->rate_mult = status.rate_mult;
+		link->tx_buf_free = status.tx_buf_free;
+	}
+}
+
+/**
+ * Take a snapshot, comparing against the previous one.
+ *
+ * The first snapshot after sysperf_open has no rates or loads.
+ */
+static void
+sysperf_sample(struct sysperf_state_s *state, struct system_resources_s *res)
+{
+	hrt_abstime now = hrt_absolute_time();
+	bool first = (state->time == 0);
+
+	memset(res, 0, sizeof(*res));
+	res->timestamp = now;
+	res->interval = first ? 0 : now - state->time;
+	state->time = now;
+
+	sysperf_tasks(state, res, first);
+
+	struct mallinfo minfo;
+	res->heap_peak = cpuload_heap_sample(&minfo);
+	res->heap_free = minfo.fordblks;
+	res->heap_largest_free = minfo.mxordblk;
+
+	struct orb_totals_s totals;
+
+	if (orb_totals(&totals) == OK) {
+		/* the sums wrap, unsigned differences do the right thing */
+		unsigned published = totals.publications - state->orb_publications;
+		unsigned lost = totals.lost - state->orb_lost;
+
+		res->orb_topics = totals.topics;
+		res->orb_rate = first ? 0.0f : sysperf_rate(published, res->interval);
+		res->orb_lost = first ? 0 : lost;
+		res->orb_latency_max = (totals.latency_max > UINT32_MAX) ? UINT32_MAX : totals.latency_max;
+		state->orb_publications = totals.publications;
+		state->orb_lost = totals.lost;
+	}
+
+	sysperf_counters(state, res);
+	sysperf_links(state, res);
+}
+
+static void
+sysperf_print(const struct system_resources_s *res)
+{
+	printf("interval %u ms, CPU %u.%u%%\n", (unsigned)(res->interval / 1000),
+	       res->load / 10, res->load % 10);
+	printf("heap: %u free, %u largest, %u peak used\n", (unsigned)res->heap_free,
+	       (unsigned)res->heap_largest_free, (unsigned)res->heap_peak);
+	printf("uorb: %u topics, %.1f pub/s, %u lost, %u us worst latency\n", res->orb_topics,
+	       (double)res->orb_rate, (unsigned)res->orb_lost, (unsigned)res->orb_latency_max);
+	printf("sdlog2: %.1f msg/s, %.1f dropped/s\n", (double)res->log_rate, (double)res->log_drop_rate);
+
+	for (unsigned i = 0; i < res->link_count; i++) {
+		const struct system_resources_link_s *link = &res->links[i];
+		printf("mavlink: %.0f of %u B/s, rate x%.2f, %u TX buffer free\n", (double)link->rate_tx,
+		       (unsigned)link->tx_budget, (double)link->rate_mult, link->tx_buf_free);
+	}
+
+	if (res->perf_count > 0) {
+		printf("\n%-*s %8s %8s %8s %8s\n", SYSTEM_RESOURCES_NAME_LEN, "COUNTER", "EVENTS", "AVG(us)",
+		       "P99(us)", "MAX(us)");
+
+		for (unsigned i = 0; i < res->perf_count; i++) {
+			const struct system_resources_perf_s *perf = &res->perf[i];
+			printf("%-*.*s %8u %8u %8u %8u\n", SYSTEM_RESOURCES_NAME_LEN, SYSTEM_RESOURCES_NAME_LEN,
+			       perf->name, (unsigned)perf->count, (unsigned)perf->avg, (unsigned)perf->p99,
+			       (unsigned)perf->max);
+		}
+	}
+
+	printf("\n%4s %-*s %6s %10s\n", "PID", SYSTEM_RESOURCES_NAME_LEN, "COMMAND", "CPU(%)", "STACK FREE");
+
+	for (unsigned i = 0; i < res->task_count; i++) {
+		const struct system_resources_task_s *task = &res->tasks[i];
+		printf("%4d %-*s %4u.%u %10u\n", task->pid, SYSTEM_RESOURCES_NAME_LEN, task->name,
+		       task->load / 10, task->load % 10, task->stack_free);
+	}
+}
+
+/**
+ * Publish a snapshot and reschedule, or clean up once stopped.
+ */
+static void
+sysperf_publish_cycle(void *arg)
+{
+	/* the subscriptions belong to the work queue, so they are opened and closed here */
+	if (!publish_running) {
+		sysperf_close(&publish_state);
+		publish_active = false;
+		return;
+	}
+
+	if (publish_state.time == 0)
+		sysperf_open(&publish_state);
+
+	sysperf_sample(&publish_state, &publish_report);
+
+	/* the first snapshot only primes the rates */
+	if (publish_report.interval == 0) {
+
+	} else if (publish_pub > 0) {
+		orb_publish(ORB_ID(system_resources), publish_pub, &publish_report);
+
+	} else {
+		publish_pub = orb_advertise(ORB_ID(system_resources), &publish_report);
+	}
+
+	work_queue_profiled(LPWORK, &publish_work, sysperf_publish_cycle, NULL, USEC2TICK(publish_interval * 1000),
+			    "sysperf publish");
+}
+
+static int
+sysperf_start(int argc, char *argv[])
+{
+	if (publish_active) {
+		printf(publish_running ? "sysperf: already publishing, stop first\n" : "sysperf: still stopping\n");
+		return -1;
+	}
+
+	publish_interval = SYSPERF_PUBLISH_INTERVAL;
+
+	if (argc > 0) {
+		char *end;
+		unsigned long interval = strtoul(argv[0], &end, 10);
+
+		if (*end != '\0' || interval < 100) {
+			printf("sysperf: interval is in ms, at least 100\n");
+			return -1;
+		}
+
+		publish_interval = interval;
+	}
+
+	memset(&publish_state, 0, sizeof(publish_state));
+	publish_running = true;
+	publish_active = true;
+	memset(&publish_work, 0, sizeof(publish_work));
+	work_queue_profiled(LPWORK, &publish_work, sysperf_publish_cycle, NULL, 0, "sysperf publish");
+	return 0;
+}
+
+int
+sysperf_main(int argc, char *argv[])
+{
+	if (argc > 1) {
+		if (strcmp(argv[1], "start") == 0)
+			return sysperf_start(argc - 2, argv + 2);
+
+		if (strcmp(argv[1], "stop") == 0) {
+			/* the work item cleans up on its next run */
+			publish_running = false;
+			return 0;
+		}
+
+		printf("Usage: sysperf [start [<interval ms>] | stop]\n");
+		return -1;
+	}
+
+	/* the command runs on a small stack */
+	static struct sysperf_state_s state;
+	static struct system_resources_s report;
+
+	sysperf_open(&state);
+	sysperf_sample(&state, &report);
+	usleep(SYSPERF_PRINT_INTERVAL);
+	sysperf_sample(&state, &report);
+	sysperf_close(&state);
+
+	sysperf_print(&report);
+	fflush(stdout);
+	return 0;
+}
@@ -41,6 +41,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <systemlib/err.h>
 #include <systemlib/bson/tinybson.h>
@@ -53,7 +55,7 @@ static const int64_t sample_big_int = (int64_t)INT_MAX + 123LL;
 static const double sample_double = 2.5f;
 static const char *sample_string = "this is a test";
 static const uint8_t sample_data[256] = {0};
-//static const char *sample_filename = "/fs/microsd/bson.test";
+static const char *sample_filename = "/fs/microsd/bson.test";
 
 static int
 encode(bson_encoder_t encoder)
@@ -241,5 +243,54 @@ test_bson(int argc, char *argv[])
 	decode(&decoder);
 	free(buf);
 
+	/* encode to a file, followed by a marker */
+	int fd = open(sample_filename, O_CREAT | O_TRUNC | O_WRONLY);
+	if (fd < 0)
+		errx(1, "FAIL: open %s", sample_filename);
+	if (bson_encoder_init_file(&encoder, fd))
+		errx(1, "FAIL: bson_encoder_init_file");
+	encode(&encoder);
+	const int32_t marker = 0x55aa55aa;
+	if (write(fd, &marker, sizeof(marker)) != sizeof(marker))
+		errx(1, "FAIL: marker write");
+	close(fd);
+
+	/* test-decode it with a read buffer smaller than the nodes */
+	uint8_t block[16];
+	fd = open(sample_filename, O_RDONLY);
+	if (fd < 0)
+		errx(1, "FAIL: open %s", sample_filename);
+	if (bson_decoder_init_file_buffered(&decoder, fd, block, sizeof(block), decode_callback, NULL))
+		errx(1, "FAIL: bson_decoder_init_file_buffered");
+	decode(&decoder);
+	if (bson_decoder_fini(&decoder))
+		errx(1, "FAIL: bson_decoder_fini");
+
+	/* the file must be left right after the document */
+	int32_t check = 0;
+	if (read(fd, &check, sizeof(check)) != sizeof(check) || check != marker)
+		errx(1, "FAIL: decoder: file position after document");
+	warnx("PASS: decoder: buffered file");
+	close(fd);
+
+	/* encode to a file through a write buffer smaller than the nodes */
+	fd = open(sample_filename, O_CREAT | O_TRUNC | O_WRONLY);
+	if (fd < 0)
+		errx(1, "FAIL: open %s", sample_filename);
+	if (bson_encoder_init_file_buffered(&encoder, fd, block, sizeof(block)))
+		errx(1, "FAIL: bson_encoder_init_file_buffered");
+	encode(&encoder);
+	close(fd);
+
+	fd = open(sample_filename, O_RDONLY);
+	if (fd < 0)
+		errx(1, "FAIL: open %s", sample_filename);
+	if (bson_decoder_init_file(&decoder, fd, decode_callback, NULL))
+		errx(1, "FAIL: bson_decoder_init_file");
+	decode(&decoder);
+	warnx("PASS: encoder: buffered file");
+	close(fd);
+	unlink(sample_filename);
+
 	return OK;
 }
\ No newline at end of file
@@ -97,6 +97,10 @@ task_main(int argc, char *argv[])
 		}
 		usleep(rand() & ((64 * 1024) - 1));
 	}
+	if (dm_flush() != 0) {
+		warnx("%d flush failed", my_id);
+		goto fail;
+	}
 	rstart = hrt_absolute_time();
 	wend = rstart;
 
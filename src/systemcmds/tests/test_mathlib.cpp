@@ -94,6 +94,14 @@ int test_mathlib(int argc, char *argv[])
 		TEST_OP("Vector<3> /= float", v1 /= 2.0f);
 		TEST_OP("Vector<3> * Vector<3>", v * v1);
 		TEST_OP("Vector<3> %% Vector<3>", v1 % v2);
+		TEST_OP("Vector<3> emult + Vector<3>", v1.emult(v2) + v);
+		TEST_OP("Vector<3> emult_add", v1.emult_add(v2, v));
+
+		if ((v1.emult_add(v2, v) - (v1.emult(v2) + v)).length() > 1e-6f) {
+			warnx("Vector<3> emult_add differs from emult + add");
+			return 1;
+		}
+
 		TEST_OP("Vector<3> length", v1.length());
 		TEST_OP("Vector<3> length squared", v1.length_squared());
 #pragma GCC diagnostic push
@@ -156,5 +164,252 @@ int test_mathlib(int argc, char *argv[])
 		TEST_OP("Matrix<10, 10> * Matrix<10, 10>", m1 * m2);
 	}
 
+	{
+		/* the inline small matrix paths have to agree with CMSIS */
+		Matrix<3, 3> m1;
+		m1.from_euler(0.1f, -0.2f, 0.3f);
+		m1(0, 0) += 0.5f;
+		Matrix<3, 3> m2;
+		m2.from_euler(-0.3f, 0.2f, 0.1f);
+		Matrix<3, 3> m3 = m1;
+		Matrix<3, 3> ref;
+		TEST_OP("Matrix<3, 3> inversed", m1.inversed());
+		TEST_OP("Matrix<3, 3> transposed", m1.transposed());
+
+		Matrix<3, 3> prod = m1 * m2;
+		arm_matrix_instance_f32 arm_a = m1.arm_mat();
+		arm_matrix_instance_f32 arm_b = m2.arm_mat();
+		arm_matrix_instance_f32 arm_ref = ref.arm_mat();
+		arm_mat_mult_f32(&arm_a, &arm_b, &arm_ref);
+
+		for (unsigned i = 0; i < 3; i++) {
+			for (unsigned j = 0; j < 3; j++) {
+				if (fabsf(prod(i, j) - ref(i, j)) > 1e-6f) {
+					warnx("Matrix<3, 3> * Matrix<3, 3> differs from CMSIS at %u, %u", i, j);
+					return 1;
+				}
+			}
+		}
+
+		Matrix<3, 3> inv = m1.inversed();
+		/* CMSIS inverts in place, m3 is a copy */
+		arm_a = m3.arm_mat();
+		arm_mat_inverse_f32(&arm_a, &arm_ref);
+
+		for (unsigned i = 0; i < 3; i++) {
+			for (unsigned j = 0; j < 3; j++) {
+				if (fabsf(inv(i, j) - ref(i, j)) > 1e-5f) {
+					warnx("Matrix<3, 3> inversed differs from CMSIS at %u, %u", i, j);
+					return 1;
+				}
+			}
+		}
+
+		/* nearly singular: the third row is the sum of the others up to rounding */
+		float near_singular[3][3] = {{1.0f, 2.0f, 3.0f}, {4.0f, 5.0f, 6.0f}, {5.0f, 7.0f, 9.000001f}};
+		Matrix<3, 3> ns(near_singular);
+		inv = ns.inversed();
+
+		for (unsigned i = 0; i < 3; i++) {
+			for (unsigned j = 0; j < 3; j++) {
+				if (inv(i, j) != 0.0f) {
+					warnx("Matrix<3, 3> inversed of a nearly singular matrix not zero");
+					return 1;
+				}
+			}
+		}
+	}
+
+	{
+		Quaternion q;
+		q.from_euler(0.3f, -0.5f, 2.0f);
+		Quaternion p;
+		p.from_euler(-1.0f, 0.2f, -2.5f);
+		Vector<3> v(1.0f, -2.0f, 0.5f);
+		Matrix<3, 3> R = q.to_dcm();
+		TEST_OP("Quaternion rotate", q.rotate(v));
+		TEST_OP("Quaternion to_dcm * Vector<3>", q.to_dcm() * v);
+		TEST_OP("Quaternion slerp", q.slerp(p, 0.3f));
+
+		if ((q.rotate(v) - R * v).length() > 1e-5f ||
+		    (q.conjugate_rotate(v) - R.transposed() * v).length() > 1e-5f) {
+			warnx("Quaternion rotate differs from to_dcm");
+			return 1;
+		}
+
+		Quaternion s0 = q.slerp(p, 0.0f);
+		Quaternion s1 = q.slerp(p, 1.0f);
+		Quaternion sh = q.slerp(p, 0.5f);
+
+		/* the end points are exact up to the sign of p, the middle stays unit length and halfway */
+		if ((s0 - q).length() > 1e-5f || fminf((s1 - p).length(), (s1 + p).length()) > 1e-5f ||
+		    fabsf(sh.length() - 1.0f) > 1e-5f ||
+		    fabsf(fabsf(static_cast<const Vector<4> &>(sh) * q) - fabsf(static_cast<const Vector<4> &>(sh) * p)) > 1e-5f) {
+			warnx("Quaternion slerp wrong");
+			return 1;
+		}
+	}
+
+	{
+		/* decompositions and solve of a symmetric positive definite matrix */
+		Matrix<4, 4> A;
+
+		for (unsigned i = 0; i < 4; i++)
+			for (unsigned j = 0; j < 4; j++)
+				A(i, j) = 1.0f / (1.0f + i + j) + ((i == j) ? 1.0f : 0.0f);
+
+		Vector<4> b(1.0f, 2.0f, 3.0f, 4.0f);
+		Vector<4> x;
+		Matrix<4, 4> L;
+		Vector<4> d;
+		TEST_OP("Matrix<4, 4> cholesky", A.cholesky(L));
+		TEST_OP("Matrix<4, 4> ldlt", A.ldlt(L, d));
+		TEST_OP("Matrix<4, 4> solve", A.solve(b, x));
+		TEST_OP("Matrix<4, 4> inversed * Vector<4>", A.inversed() * b);
+
+		if (!A.cholesky(L) || !A.solve(b, x)) {
+			warnx("Matrix<4, 4> cholesky failed on a positive definite matrix");
+			return 1;
+		}
+
+		Matrix<4, 4> LLt = L * L.transposed();
+		Matrix<4, 4> D;
+
+		if (!A.ldlt(L, d)) {
+			warnx("Matrix<4, 4> ldlt failed");
+			return 1;
+		}
+
+		for (unsigned i = 0; i < 4; i++)
+			D(i, i) = d(i);
+
+		Matrix<4, 4> LDLt = L * D * L.transposed();
+
+		for (unsigned i = 0; i < 4; i++) {
+			for (unsigned j = 0; j < 4; j++) {
+				if (fabsf(LLt(i, j) - A(i, j)) > 1e-5f || fabsf(LDLt(i, j) - A(i, j)) > 1e-5f) {
+					warnx("Matrix<4, 4> decomposition wrong at %u, %u", i, j);
+					return 1;
+				}
+			}
+		}
+
+		if ((A * x - b).length() > 1e-5f) {
+			warnx("Matrix<4, 4> solve residual too large");
+			return 1;
+		}
+
+		/* indefinite: Cholesky has to refuse, LDL' still works */
+		A(3, 3) = -5.0f;
+
+		if (A.cholesky(L) || A.solve(b, x) || !A.ldlt(L, d)) {
+			warnx("Matrix<4, 4> indefinite matrix not detected");
+			return 1;
+		}
+
+		/* rank one, the later pivots are rounding noise */
+		for (unsigned i = 0; i < 4; i++)
+			for (unsigned j = 0; j < 4; j++)
+				A(i, j) = (i + 1.1f) * (j + 1.1f) / 3.0f;
+
+		if (A.ldlt(L, d)) {
+			warnx("Matrix<4, 4> singular matrix not detected by ldlt");
+			return 1;
+		}
+	}
+
+	{
+		/* packed symmetric matrix against the same full matrix */
+		Matrix<5, 5> F;
+		Vector<5> h;
+
+		for (unsigned i = 0; i < 5; i++) {
+			for (unsigned j = 0; j < 5; j++)
+				F(i, j) = 1.0f / (1.0f + i + j);
+
+			h(i) = 0.3f * i - 0.5f;
+		}
+
+		SymmetricMatrix<5> P;
+		P.set(F.data);
+		TEST_OP("SymmetricMatrix<5> * Vector<5>", P * h);
+		TEST_OP("Matrix<5, 5> * Vector<5>", F * h);
+
+		Vector<5> ph = P * h;
+
+		if ((ph - F * h).length() > 1e-5f || fabsf(P.quadratic(h) - h * (F * h)) > 1e-5f) {
+			warnx("SymmetricMatrix<5> product differs from Matrix<5, 5>");
+			return 1;
+		}
+
+		P.rank1_update(ph, -0.1f);
+		float G[5][5];
+		P.get(G);
+
+		for (unsigned i = 0; i < 5; i++) {
+			for (unsigned j = 0; j < 5; j++) {
+				if (fabsf(G[i][j] - (F(i, j) - 0.1f * ph(i) * ph(j))) > 1e-5f || G[i][j] != G[j][i]) {
+					warnx("SymmetricMatrix<5> rank1_update wrong at %u, %u", i, j);
+					return 1;
+				}
+			}
+		}
+	}
+
+	{
+		/* fast_math.h: timing against libm and the documented error bounds */
+		volatile float x = 0.3f;
+		volatile float y = -0.7f;
+		volatile float r;
+		float s, c;
+		TEST_OP("atan2f", r = atan2f(y, x));
+		TEST_OP("fast_atan2f", r = fast_atan2f(y, x));
+		TEST_OP("asinf", r = asinf(x));
+		TEST_OP("fast_asinf", r = fast_asinf(x));
+		TEST_OP("sinf + cosf", { s = sinf(x); c = cosf(x); });
+		TEST_OP("fast_sincosf", fast_sincosf(x, &s, &c));
+		TEST_OP("sqrtf", r = sqrtf(x));
+		TEST_OP("fast_sqrtf", r = fast_sqrtf(x));
+
+		float err_atan2 = 0.0f;
+		float err_asin = 0.0f;
+		float err_sincos = 0.0f;
+		float err_sqrt = 0.0f;
+
+		/* double references, the rounding of a float libm result would add up to one ulp */
+		for (int i = -5000; i <= 5000; i++) {
+			float a = M_PI_F * i / 5000.0f;
+			float ya = sinf(a) * 3.0f;
+			float xa = cosf(a) * 3.0f;
+			float e = (float)fabs((double)fast_atan2f(ya, xa) - atan2((double)ya, (double)xa));
+
+			/* +-pi are the same angle */
+			if (e > M_PI_F)
+				e = fabsf(e - 2.0f * M_PI_F);
+
+			err_atan2 = fmaxf(err_atan2, e);
+
+			float u = i / 5000.0f;
+			err_asin = fmaxf(err_asin, (float)fabs((double)fast_asinf(u) - asin((double)u)));
+
+			float w = FAST_SINCOSF_MAX_ARG * i / 5000.0f;
+			fast_sincosf(w, &s, &c);
+			err_sincos = fmaxf(err_sincos, (float)fmax(fabs((double)s - sin((double)w)),
+					   fabs((double)c - cos((double)w))));
+
+			float q = 100.0f * (i + 5000) / 10000.0f;
+			err_sqrt = fmaxf(err_sqrt, fabsf(fast_sqrtf(q) - sqrtf(q)));
+		}
+
+		warnx("fast_atan2f max error %.3e, fast_asinf %.3e, fast_sincosf %.3e, fast_sqrtf %.3e",
+		      (double)err_atan2, (double)err_asin, (double)err_sincos, (double)err_sqrt);
+
+		if (err_atan2 > FAST_ATAN2F_MAX_ERROR || err_asin > FAST_ATAN2F_MAX_ERROR ||
+		    err_sincos > FAST_SINCOSF_MAX_ERROR || err_sqrt > 0.0f) {
+			warnx("fast_math error bound exceeded");
+			return 1;
+		}
+	}
+
 	return 0;
 }
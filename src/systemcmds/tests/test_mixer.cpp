@@ -121,6 +121,43 @@ int test_mixer(int argc, char *argv[])
 	if (empty_load != 0)
 		return 1;
 
+	/* the binary description generated from the same file must give the same mixers */
+	char binname[64];
+	uint8_t bin[512];
+	snprintf(binname, sizeof(binname), "%s.bin", filename);
+	int binlen = load_mixer_bin_file(binname, &bin[0], sizeof(bin));
+
+	if (binlen > 0) {
+		MixerGroup bin_group(mixer_callback, 0);
+		unsigned bin_left = binlen;
+		bin_group.load_from_bin(&bin[0], bin_left);
+		warnx("binary load: loaded %u mixers from %d bytes", bin_group.count(), binlen);
+
+		if (bin_group.count() != 8 || bin_left != 0)
+			return 1;
+
+	} else {
+		warnx("no binary mixer %s", binname);
+	}
+
+	/* a group reloaded into its arena must not need more room each time */
+	MixerGroup arena_group(mixer_callback, 0, 2048);
+	size_t arena_used = 0;
+
+	for (unsigned i = 0; i < 10; i++) {
+		arena_group.reset();
+		unsigned arena_left = loaded;
+		arena_group.load_from_buf(&buf[0], arena_left);
+
+		if (i == 0)
+			arena_used = arena_group.arena()->used();
+
+		if (arena_group.count() != 8 || arena_group.arena()->used() != arena_used)
+			return 1;
+	}
+
+	warnx("arena load: loaded %u mixers into %u bytes", arena_group.count(), (unsigned)arena_used);
+
 	/* FIRST mark the mixer as invalid */
 	/* THEN actually delete it */
 	mixer_group.reset();
@@ -358,6 +395,23 @@ int test_mixer(int argc, char *argv[])
 		return 1;
 	}
 
+	/* time the mix, this runs on every actuator update */
+	const unsigned bench_runs = 10000;
+	hrt_abstime bench_start = hrt_absolute_time();
+
+	for (unsigned n = 0; n < bench_runs; n++) {
+		/* sweep roll/pitch/yaw through and past saturation */
+		actuator_controls[0] = ((int)(n % 21) - 10) / 10.0f;
+		actuator_controls[1] = ((int)(n % 17) - 8) / 8.0f;
+		actuator_controls[2] = ((int)(n % 13) - 6) / 6.0f;
+		actuator_controls[3] = (n % 11) / 10.0f;
+
+		mixed = mixer_group.mix(&outputs[0], output_max);
+	}
+
+	hrt_abstime bench_time = hrt_elapsed_time(&bench_start);
+	warnx("Quad W mix: %u outputs, %.2f us per mix", mixed, (double)bench_time / bench_runs);
+
 	warnx("SUCCESS: No errors in mixer test");
 	return 0;
 }
@@ -197,10 +197,20 @@ top_main(void)
 						   (double)(task_load * 100.f),
 						   (double)(sched_load * 100.f),
 						   (double)(idle * 100.f));
-					printf(CL "Uptime: %.3fs total, %.3fs idle\n\n",
+					printf(CL "Uptime: %.3fs total, %.3fs idle\n",
 						   (double)curr_time_us / 1000000.d,
 						   (double)idle_time_us / 1000000.d);
 
+					struct mallinfo minfo;
+					uint32_t heap_peak = cpuload_heap_sample(&minfo);
+
+					printf(CL "Memory: %u used, %u peak, %u free (%u largest) of %u\n\n",
+						   (unsigned)minfo.uordblks,
+						   (unsigned)heap_peak,
+						   (unsigned)minfo.fordblks,
+						   (unsigned)minfo.mxordblk,
+						   (unsigned)minfo.arena);
+
 					/* header for task list */
 					printf(CL "%4s %*-s %8s %6s %11s %10s %-6s\n",
 						   "PID",
@@ -217,17 +227,8 @@ top_main(void)
 						   );
 				}
 
-				unsigned stack_size = (uintptr_t)system_load.tasks[i].tcb->adj_stack_ptr -
-					(uintptr_t)system_load.tasks[i].tcb->stack_alloc_ptr;
-				unsigned stack_free = 0;
-				uint8_t *stack_sweeper = (uint8_t *)system_load.tasks[i].tcb->stack_alloc_ptr;
-
-				while (stack_free < stack_size) {
-					if (*stack_sweeper++ != 0xff)
-						break;
-
-					stack_free++;
-				}
+				unsigned stack_size;
+				unsigned stack_used = cpuload_stack_used(system_load.tasks[i].tcb, &stack_size);
 
 				printf(CL "%4d %*-s %8lld %2d.%03d %5u/%5u %3u (%3u) ",
 					   system_load.tasks[i].tcb->pid,
@@ -235,7 +236,7 @@ top_main(void)
 					   (system_load.tasks[i].total_runtime / 1000),
 					   (int)(curr_loads[i] * 100.0f),
 					   (int)((curr_loads[i] * 100.0f - (int)(curr_loads[i] * 100.0f)) * 1000),
-					   stack_size - stack_free,
+					   stack_used,
 					   stack_size,
 					   system_load.tasks[i].tcb->sched_priority,
 					   system_load.tasks[i].tcb->base_priority);
@@ -0,0 +1,104 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2014 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file work_queue.c
+ *
+ * Report of the work items queued with work_queue_profiled.
+ */
+
+#include <nuttx/config.h>
+#include <nuttx/wqueue.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <drivers/drv_hrt.h>
+#include <systemlib/work_profile.h>
+
+__EXPORT int work_queue_main(int argc, char *argv[]);
+
+static void
+work_queue_status(void)
+{
+	uint64_t busy[2] = { 0, 0 };
+	hrt_abstime span = hrt_absolute_time() - work_profile_since();
+	struct work_profile_s profile;
+
+	printf("queue name             calls  lat avg  lat max  run avg  run max\n");
+
+	for (unsigned i = 0; i < WORK_PROFILE_MAX; i++) {
+		if (!work_profile_get(i, &profile))
+			continue;
+
+		printf("%-5s %-16s %6u %6uus %6uus %6uus %6uus\n",
+		       (profile.qid == HPWORK) ? "HP" : "LP",
+		       (profile.name != NULL) ? profile.name : "?",
+		       (unsigned)profile.count,
+		       (unsigned)((profile.count > 0) ? profile.latency_total / profile.count : 0),
+		       (unsigned)profile.latency_max,
+		       (unsigned)((profile.count > 0) ? profile.run_total / profile.count : 0),
+		       (unsigned)profile.run_max);
+
+		busy[(profile.qid == HPWORK) ? 0 : 1] += profile.run_total;
+	}
+
+	if (span > 0) {
+		printf("busy: HP %.1f%%, LP %.1f%% over %.1fs\n",
+		       (double)busy[0] * 100.0 / span,
+		       (double)busy[1] * 100.0 / span,
+		       (double)span / 1e6);
+	}
+
+	if (work_profile_overflows() > 0)
+		printf("%u calls not accounted, increase WORK_PROFILE_MAX\n", (unsigned)work_profile_overflows());
+}
+
+int
+work_queue_main(int argc, char *argv[])
+{
+	if (argc > 1) {
+		if (strcmp(argv[1], "status") == 0) {
+			work_queue_status();
+			return 0;
+		}
+
+		if (strcmp(argv[1], "reset") == 0) {
+			work_profile_reset();
+			return 0;
+		}
+	}
+
+	printf("Usage: work_queue <status|reset>\n");
+	return 1;
+}